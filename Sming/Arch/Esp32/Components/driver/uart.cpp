@@ -433,6 +433,14 @@ size_t smg_uart_write(smg_uart_t* uart, const void* buffer, size_t size)
 	return written;
 }
 
+bool smg_uart_write_desc(smg_uart_t* uart, smg_uart_tx_desc_t* desc)
+{
+	// Not implemented: HardwareSerial falls back to smg_uart_write()
+	(void)uart;
+	(void)desc;
+	return false;
+}
+
 size_t smg_uart_tx_free(smg_uart_t* uart)
 {
 	if(!smg_uart_tx_enabled(uart)) {
@@ -734,6 +742,19 @@ bool smg_uart_intr_config(smg_uart_t* uart, const smg_uart_intr_config_t* config
 	return true;
 }
 
+bool smg_uart_set_rx_timeout(smg_uart_t* uart, uint8_t chars)
+{
+	uart = get_physical(uart);
+	if(uart == nullptr || !smg_uart_rx_enabled(uart)) {
+		return false;
+	}
+
+	// Threshold is in bit times
+	auto dev = getDevice(uart->uart_nr);
+	uart_ll_set_rx_tout(dev, TRange(10, UART_RX_TOUT_THRHD).clip(chars * 10));
+	return true;
+}
+
 void smg_uart_swap(smg_uart_t* uart, int tx_pin)
 {
 	// Not implemented
@@ -10,6 +10,18 @@ CACHE_VARS += SDK_CUSTOM_CONFIG
 
 COMPONENT_RELINK_VARS += DISABLE_NETWORK DISABLE_WIFI
 
+# Optional second Sming task on the other CPU core
+COMPONENT_VARS += ENABLE_WORKER_TASK
+ENABLE_WORKER_TASK ?= 0
+ifeq ($(ENABLE_WORKER_TASK),1)
+COMPONENT_CXXFLAGS += -DENABLE_WORKER_TASK=1
+endif
+
+# Maximum number of queued tasks run each time the Sming task is woken
+COMPONENT_VARS += TASK_BATCH_SIZE
+TASK_BATCH_SIZE ?= 16
+COMPONENT_CXXFLAGS += -DTASK_BATCH_SIZE=$(TASK_BATCH_SIZE)
+
 SDK_BUILD_BASE := $(COMPONENT_BUILD_BASE)/sdk
 SDK_COMPONENT_LIBDIR := $(COMPONENT_BUILD_BASE)/lib
 
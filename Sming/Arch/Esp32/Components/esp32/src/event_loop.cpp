@@ -30,6 +30,11 @@ esp_event_loop_handle_t sming_create_event_loop()
 	return sming_event_loop;
 }
 
+esp_event_loop_handle_t sming_get_event_loop()
+{
+	return sming_event_loop;
+}
+
 namespace
 {
 #define WRAP(name) esp_err_t __wrap_##name
@@ -14,14 +14,41 @@ typedef struct {
 } os_event_t;
 
 enum {
+	USER_TASK_PRIO_0,
 	USER_TASK_PRIO_1,
+	USER_TASK_PRIO_2,
+	USER_TASK_PRIO_MAX,
 };
 
 typedef void (*os_task_t)(os_event_t* e);
 
+/**
+ * @brief Task queue statistics
+ */
+typedef struct {
+	uint32_t wakeups;	///< Number of times the Sming task has been woken to run queued tasks
+	uint32_t dispatched; ///< Total number of tasks run
+	uint32_t maxLatency; ///< Longest delay between wakeup being requested and serviced, in microseconds
+	uint16_t maxBatch;   ///< Most tasks run for a single wakeup
+	uint16_t maxDepth;   ///< Most tasks queued at once, over all priorities
+} os_task_stats_t;
+
 bool system_os_task(os_task_t task, uint8_t prio, os_event_t* queue, uint8_t qlen);
 bool system_os_post(uint8_t prio, os_signal_t sig, os_param_t par);
 
+/**
+ * @brief Run any queued tasks for which a wakeup event could not be posted
+ * @note Called periodically from the main Sming task loop
+ */
+void system_service_tasks(void);
+
+/**
+ * @brief Obtain task queue statistics
+ * @param stats Optional, returns current values
+ * @param reset Set to clear statistics
+ */
+void system_os_get_stats(os_task_stats_t* stats, bool reset);
+
 #ifdef __cplusplus
 }
 #endif
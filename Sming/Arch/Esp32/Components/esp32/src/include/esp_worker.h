@@ -0,0 +1,61 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/SmingHub/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * esp_worker.h - Optional worker task running on the second CPU core
+ *
+ * When ENABLE_WORKER_TASK=1 on a dual-core device, a second task is created on the
+ * core not used by the main Sming task. It runs its own event loop and services
+ * callbacks queued for it.
+ *
+ * Worker callbacks run concurrently with the main application. Most framework code,
+ * including networking, timers and the regular task queue, is not thread-safe and must
+ * only be used from the main task. Heap allocation is thread-safe on the ESP32.
+ *
+ * A typical use is to perform sensor acquisition or rendering on the worker,
+ * then pass the results back to the main task via `esp_queue_callback(eTC_Main, ...)`.
+ *
+ ****/
+
+#pragma once
+
+#include <Platform/System.h>
+
+/**
+ * @brief Identifies task to receive a queued callback
+ */
+enum esp_task_target_t {
+	eTC_Main,   ///< Main Sming task
+	eTC_Worker, ///< Worker task, if enabled
+};
+
+/**
+ * @brief Determine if worker task is available
+ */
+bool esp_worker_is_running();
+
+/**
+ * @brief Queue a callback for execution by a specific task
+ * @param target Task to execute the callback
+ * @param callback
+ * @param param
+ * @retval bool false if target is not available or queue is full
+ * @note May be called from any task, core or interrupt context.
+ */
+bool esp_queue_callback(esp_task_target_t target, TaskCallback32 callback, uint32_t param = 0);
+
+/**
+ * @brief Queue a callback with void* parameter for execution by a specific task
+ */
+__forceinline bool esp_queue_callback(esp_task_target_t target, TaskCallback callback, void* param = nullptr)
+{
+	return esp_queue_callback(target, reinterpret_cast<TaskCallback32>(callback), reinterpret_cast<uint32_t>(param));
+}
+
+/**
+ * @brief Queue a Delegate callback for execution by a specific task
+ * @note Not for use in interrupt context.
+ */
+bool esp_queue_callback(esp_task_target_t target, TaskDelegate callback);
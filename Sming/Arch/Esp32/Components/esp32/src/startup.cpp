@@ -18,10 +18,12 @@
 #include <driver/hw_timer.h>
 #include <driver/uart.h>
 #include <Storage.h>
+#include <Services/Profiling/BootTimeline.h>
 
 extern void init();
 extern esp_event_loop_handle_t sming_create_event_loop();
 extern void esp_network_initialise();
+extern bool esp_worker_init();
 
 namespace
 {
@@ -47,13 +49,17 @@ void main(void*)
 #endif
 
 	System.initialize();
+	esp_worker_init();
 	Storage::initialize();
+	BOOT_PHASE_BEGIN(userInit);
 	init();
+	BOOT_PHASE_END(userInit);
 
 	constexpr unsigned maxEventLoopInterval{1000 / portTICK_PERIOD_MS};
 	while(true) {
 		esp_task_wdt_reset();
 		esp_event_loop_run(loop, maxEventLoopInterval);
+		system_service_tasks();
 	}
 }
 
@@ -1,66 +1,237 @@
 #include "include/esp_tasks.h"
 #include <esp_event.h>
+#include <esp_timer.h>
+#include <freertos/FreeRTOS.h>
 #include <debug_progmem.h>
 
+/*
+ * Tasks are held in a ring buffer for each priority, using storage provided by the caller.
+ *
+ * A single IDF event is posted to wake the Sming task when the first item is queued.
+ * Further posts are just added to the queue until that event has been serviced.
+ * The handler then runs up to TASK_BATCH_SIZE tasks, highest priority first,
+ * before re-posting the wakeup event so that any IDF events (WiFi, IP, etc.) get a look-in.
+ */
+
+#ifndef TASK_BATCH_SIZE
+#define TASK_BATCH_SIZE 16
+#endif
+
 namespace
 {
 ESP_EVENT_DEFINE_BASE(TaskEvt);
 
-os_task_t taskCallback;
+class TaskQueue
+{
+public:
+	TaskQueue(os_task_t callback, os_event_t* events, uint8_t length)
+		: callback(callback), events(events), length(length)
+	{
+	}
 
-} // namespace
+	// Caller must hold lock
+	bool IRAM_ATTR push(os_signal_t sig, os_param_t par)
+	{
+		if(count == length) {
+			return false;
+		}
+		events[(read + count) % length] = os_event_t{sig, par};
+		++count;
+		return true;
+	}
 
-bool system_os_task(os_task_t callback, uint8_t prio, os_event_t* events, uint8_t qlen)
+	// Caller must hold lock
+	os_event_t pop()
+	{
+		auto evt = events[read];
+		read = (read + 1) % length;
+		--count;
+		return evt;
+	}
+
+	bool isEmpty() const
+	{
+		return count == 0;
+	}
+
+	os_task_t callback;
+
+private:
+	os_event_t* events;
+	uint8_t read{0};
+	uint8_t count{0};
+	uint8_t length;
+};
+
+TaskQueue* taskQueues[USER_TASK_PRIO_MAX];
+bool handlerRegistered;
+
+portMUX_TYPE taskLock = portMUX_INITIALIZER_UNLOCKED;
+uint16_t pendingCount; ///< Total tasks queued across all priorities
+bool wakePending;	  ///< Set whilst a wakeup event is queued or being serviced
+uint32_t wakeTime;	 ///< When wakeup event was posted (microseconds)
+os_task_stats_t stats;
+
+bool IRAM_ATTR postWakeup()
 {
-	auto handler = [](void* arg, esp_event_base_t event_base, int32_t event_id, void* event_data) {
-		assert(taskCallback != nullptr);
+	return esp_event_isr_post(TaskEvt, 0, nullptr, 0, nullptr) == ESP_OK;
+}
+
+/*
+ * Run a batch of tasks, highest priority first.
+ * Each task is removed from its queue before the callback is invoked, with the lock released,
+ * so new tasks may be queued (from any context) in the meantime.
+ */
+void serviceTasks()
+{
+	portENTER_CRITICAL(&taskLock);
+
+	auto latency = uint32_t(esp_timer_get_time()) - wakeTime;
+	if(latency > stats.maxLatency) {
+		stats.maxLatency = latency;
+	}
+	++stats.wakeups;
 
-		os_event_t ev{os_signal_t(event_id), 0};
-		if(event_data != nullptr) {
-			ev.par = *static_cast<os_param_t*>(event_data);
+	unsigned batch{0};
+	while(batch < TASK_BATCH_SIZE && pendingCount != 0) {
+		int prio = USER_TASK_PRIO_MAX - 1;
+		while(taskQueues[prio] == nullptr || taskQueues[prio]->isEmpty()) {
+			--prio;
 		}
+		auto queue = taskQueues[prio];
+		auto evt = queue->pop();
+		--pendingCount;
+		portEXIT_CRITICAL(&taskLock);
+
+		queue->callback(&evt);
+		++batch;
+
+		portENTER_CRITICAL(&taskLock);
+	}
 
-		taskCallback(&ev);
-	};
+	stats.dispatched += batch;
+	if(batch > stats.maxBatch) {
+		stats.maxBatch = batch;
+	}
+
+	bool more = (pendingCount != 0);
+	wakePending = more;
+	if(more) {
+		wakeTime = esp_timer_get_time();
+	}
+
+	portEXIT_CRITICAL(&taskLock);
+
+	if(more && !postWakeup()) {
+		// IDF queue full: next post or system_service_tasks() will retry
+		portENTER_CRITICAL(&taskLock);
+		wakePending = false;
+		portEXIT_CRITICAL(&taskLock);
+	}
+}
 
+} // namespace
+
+bool system_os_task(os_task_t callback, uint8_t prio, os_event_t* events, uint8_t qlen)
+{
 	if(callback == nullptr) {
 		debug_e("TQ: Callback missing");
 		return false;
 	}
 
-	if(prio != USER_TASK_PRIO_1) {
+	if(prio >= USER_TASK_PRIO_MAX) {
 		debug_e("TQ: Invalid priority %u", prio);
 		return false;
 	}
 
-	if(taskCallback != nullptr) {
-		debug_w("TQ: Queue %u already initialised", prio);
+	if(events == nullptr || qlen == 0) {
+		debug_e("TQ: Queue %u has no storage", prio);
 		return false;
 	}
 
-	auto err = esp_event_handler_instance_register(TaskEvt, ESP_EVENT_ANY_ID, handler, nullptr, nullptr);
-	if(err != ESP_OK) {
-		debug_e("TQ: Failed to register handler");
+	auto& queue = taskQueues[prio];
+	if(queue != nullptr) {
+		debug_w("TQ: Queue %u already initialised", prio);
 		return false;
 	}
 
-	taskCallback = callback;
+	if(!handlerRegistered) {
+		auto handler = [](void*, esp_event_base_t, int32_t, void*) { serviceTasks(); };
+		auto err = esp_event_handler_instance_register(TaskEvt, ESP_EVENT_ANY_ID, handler, nullptr, nullptr);
+		if(err != ESP_OK) {
+			debug_e("TQ: Failed to register handler");
+			return false;
+		}
+		handlerRegistered = true;
+	}
 
-	debug_i("TQ: Registered %s", TaskEvt);
+	queue = new TaskQueue(callback, events, qlen);
+	if(queue == nullptr) {
+		return false;
+	}
+
+	debug_i("TQ: Registered queue %u, length %u", prio, qlen);
 
 	return true;
 }
 
 bool IRAM_ATTR system_os_post(uint8_t prio, os_signal_t sig, os_param_t par)
 {
-	if(prio != USER_TASK_PRIO_1) {
+	if(prio >= USER_TASK_PRIO_MAX) {
 		return false;
 	}
-	esp_err_t err;
-	if(par == 0) {
-		err = esp_event_isr_post(TaskEvt, sig, nullptr, 0, nullptr);
-	} else {
-		err = esp_event_isr_post(TaskEvt, sig, &par, sizeof(par), nullptr);
+	auto queue = taskQueues[prio];
+	if(queue == nullptr) {
+		return false;
+	}
+
+	portENTER_CRITICAL_SAFE(&taskLock);
+	bool ok = queue->push(sig, par);
+	bool wake{false};
+	if(ok) {
+		++pendingCount;
+		if(pendingCount > stats.maxDepth) {
+			stats.maxDepth = pendingCount;
+		}
+		if(!wakePending) {
+			wakePending = wake = true;
+			wakeTime = esp_timer_get_time();
+		}
+	}
+	portEXIT_CRITICAL_SAFE(&taskLock);
+
+	if(wake && !postWakeup()) {
+		// Task remains queued, wakeup will be attempted again on next post
+		portENTER_CRITICAL_SAFE(&taskLock);
+		wakePending = false;
+		portEXIT_CRITICAL_SAFE(&taskLock);
+	}
+
+	return ok;
+}
+
+void system_service_tasks()
+{
+	portENTER_CRITICAL(&taskLock);
+	bool stalled = (pendingCount != 0 && !wakePending);
+	if(stalled) {
+		wakePending = true;
+	}
+	portEXIT_CRITICAL(&taskLock);
+
+	if(stalled) {
+		serviceTasks();
+	}
+}
+
+void system_os_get_stats(os_task_stats_t* result, bool reset)
+{
+	portENTER_CRITICAL(&taskLock);
+	if(result != nullptr) {
+		*result = stats;
+	}
+	if(reset) {
+		stats = os_task_stats_t{};
 	}
-	return (err == ESP_OK);
+	portEXIT_CRITICAL(&taskLock);
 }
@@ -0,0 +1,137 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/SmingHub/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * worker.cpp
+ *
+ ****/
+
+#include "include/esp_worker.h"
+#include <esp_event.h>
+#include <esp_task_wdt.h>
+#include <esp_task.h>
+#include <debug_progmem.h>
+
+extern esp_event_loop_handle_t sming_get_event_loop();
+
+namespace
+{
+ESP_EVENT_DEFINE_BASE(CallbackEvt);
+
+esp_event_loop_handle_t worker_event_loop;
+
+void callbackHandler(void*, esp_event_base_t, int32_t event_id, void* event_data)
+{
+	auto callback = TaskCallback32(event_id);
+	uint32_t param = (event_data == nullptr) ? 0 : *static_cast<uint32_t*>(event_data);
+	callback(param);
+}
+
+esp_event_loop_handle_t getLoop(esp_task_target_t target)
+{
+	return (target == eTC_Worker) ? worker_event_loop : sming_get_event_loop();
+}
+
+#if defined(ENABLE_WORKER_TASK) && !CONFIG_FREERTOS_UNICORE
+void worker_main(void*)
+{
+	esp_task_wdt_add(nullptr);
+
+	constexpr unsigned maxEventLoopInterval{1000 / portTICK_PERIOD_MS};
+	while(true) {
+		esp_task_wdt_reset();
+		esp_event_loop_run(worker_event_loop, maxEventLoopInterval);
+	}
+}
+#endif
+
+} // namespace
+
+bool esp_worker_init()
+{
+	if(esp_event_handler_instance_register_with(sming_get_event_loop(), CallbackEvt, ESP_EVENT_ANY_ID, callbackHandler,
+												nullptr, nullptr) != ESP_OK) {
+		return false;
+	}
+
+#if defined(ENABLE_WORKER_TASK) && !CONFIG_FREERTOS_UNICORE
+	esp_event_loop_args_t loop_args = {
+		.queue_size = CONFIG_ESP_SYSTEM_EVENT_QUEUE_SIZE,
+		.task_name = nullptr,
+	};
+	if(esp_event_loop_create(&loop_args, &worker_event_loop) != ESP_OK) {
+		return false;
+	}
+
+	esp_event_handler_instance_register_with(worker_event_loop, CallbackEvt, ESP_EVENT_ANY_ID, callbackHandler,
+											 nullptr, nullptr);
+
+	// Called from main task, so use the other core
+	unsigned core_id = 1 - xPortGetCoreID();
+	if(xTaskCreatePinnedToCore(worker_main, "Sming-worker", ESP_TASKD_EVENT_STACK, nullptr, ESP_TASKD_EVENT_PRIO,
+							   nullptr, core_id) != pdPASS) {
+		debug_e("[WORKER] Failed to create task");
+		esp_event_loop_delete(worker_event_loop);
+		worker_event_loop = nullptr;
+		return false;
+	}
+
+	debug_i("[WORKER] Started on core %u", core_id);
+#endif
+
+	return true;
+}
+
+bool esp_worker_is_running()
+{
+	return worker_event_loop != nullptr;
+}
+
+bool IRAM_ATTR esp_queue_callback(esp_task_target_t target, TaskCallback32 callback, uint32_t param)
+{
+	if(callback == nullptr) {
+		return false;
+	}
+
+	auto loop = getLoop(target);
+	if(loop == nullptr) {
+		return false;
+	}
+
+	auto data = (param == 0) ? nullptr : &param;
+	auto size = (param == 0) ? 0 : sizeof(param);
+	esp_err_t err;
+	if(xPortInIsrContext()) {
+		err = esp_event_isr_post_to(loop, CallbackEvt, int32_t(callback), data, size, nullptr);
+	} else {
+		err = esp_event_post_to(loop, CallbackEvt, int32_t(callback), data, size, 0);
+	}
+	return err == ESP_OK;
+}
+
+bool esp_queue_callback(esp_task_target_t target, TaskDelegate callback)
+{
+	if(!callback) {
+		return false;
+	}
+
+	auto delegate = new TaskDelegate(std::move(callback));
+	if(delegate == nullptr) {
+		return false;
+	}
+
+	auto handler = [](void* param) {
+		auto delegate = static_cast<TaskDelegate*>(param);
+		(*delegate)();
+		delete delegate;
+	};
+
+	if(!esp_queue_callback(target, handler, delegate)) {
+		delete delegate;
+		return false;
+	}
+
+	return true;
+}
@@ -37,6 +37,78 @@ uint32_t flashmem_read(void* to, uint32_t fromaddr, uint32_t size)
 	return size;
 }
 
+namespace
+{
+// Mappings created by flashmem_get_pointer(), released when reference count drops to zero
+struct MmapWindow {
+	spi_flash_mmap_handle_t handle;
+	uint32_t addr;
+	uint32_t size;
+	const uint8_t* ptr;
+	unsigned refs;
+};
+
+constexpr unsigned maxMmapWindows{8};
+MmapWindow mmapWindows[maxMmapWindows];
+
+} // namespace
+
+const void* flashmem_get_pointer(uint32_t addr, uint32_t size)
+{
+	if(size == 0 || addr + size < addr || addr + size > flashmem_get_size_bytes()) {
+		return nullptr;
+	}
+
+	// Re-use one of our own mappings if it covers the request
+	MmapWindow* freeWindow{nullptr};
+	for(auto& w : mmapWindows) {
+		if(w.refs == 0) {
+			freeWindow = freeWindow ?: &w;
+		} else if(addr >= w.addr && addr + size <= w.addr + w.size) {
+			++w.refs;
+			return w.ptr + addr - w.addr;
+		}
+	}
+
+	// Check for existing contiguous mapping, e.g. application data
+	auto ptr = static_cast<const uint8_t*>(spi_flash_phys2cache(addr, SPI_FLASH_MMAP_DATA));
+	if(ptr != nullptr && spi_flash_phys2cache(addr + size - 1, SPI_FLASH_MMAP_DATA) == ptr + size - 1) {
+		return ptr;
+	}
+
+	if(freeWindow == nullptr) {
+		debug_w("[FLSH] No free mmap window for 0x%08x", addr);
+		return nullptr;
+	}
+
+	// Mapping is page-based
+	uint32_t offset = addr % SPI_FLASH_MMU_PAGE_SIZE;
+	const void* mapped;
+	esp_err_t err = spi_flash_mmap(addr - offset, offset + size, SPI_FLASH_MMAP_DATA, &mapped, &freeWindow->handle);
+	if(err != ESP_OK) {
+		debug_w("[FLSH] mmap(0x%08x, 0x%08x) failed, err %d", addr, size, err);
+		return nullptr;
+	}
+	freeWindow->addr = addr - offset;
+	freeWindow->size = offset + size;
+	freeWindow->ptr = static_cast<const uint8_t*>(mapped);
+	freeWindow->refs = 1;
+	return freeWindow->ptr + offset;
+}
+
+void flashmem_release_pointer(const void* ptr)
+{
+	auto p = static_cast<const uint8_t*>(ptr);
+	for(auto& w : mmapWindows) {
+		if(w.refs != 0 && p >= w.ptr && p < w.ptr + w.size) {
+			if(--w.refs == 0) {
+				spi_flash_munmap(w.handle);
+			}
+			return;
+		}
+	}
+}
+
 bool flashmem_erase_sector(uint32_t sector_id)
 {
 	debug_d("flashmem_erase_sector(0x%08x)", sector_id);
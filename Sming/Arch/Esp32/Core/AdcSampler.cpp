@@ -0,0 +1,153 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/SmingHub/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * AdcSampler.cpp - DMA sampling for the ESP32
+ *
+ * Uses the I2S peripheral in built-in ADC mode, which only exists on the original ESP32
+ * and only supports ADC1. The I2S driver manages the DMA descriptors, and a reader task
+ * assembles full blocks from them.
+ *
+ ****/
+
+#include <AdcSampler.h>
+#include <Digital.h>
+#include <esp_task.h>
+
+#if CONFIG_IDF_TARGET_ESP32
+
+#include <driver/adc.h>
+#include <driver/i2s.h>
+#include <soc/adc_periph.h>
+#include <algorithm>
+
+namespace
+{
+constexpr i2s_port_t i2sPort{I2S_NUM_0};
+constexpr unsigned readTimeoutMs{100};
+volatile TaskHandle_t readerTask;
+volatile bool stopping;
+
+bool lookupChannel(uint16_t pin, adc1_channel_t& channel)
+{
+	for(unsigned ch = 0; ch < SOC_ADC_MAX_CHANNEL_NUM; ++ch) {
+		if(adc_channel_io_map[0][ch] == pin) {
+			channel = adc1_channel_t(ch);
+			return true;
+		}
+	}
+	return false;
+}
+
+} // namespace
+
+bool AdcSampler::hardwareBegin(uint16_t pin)
+{
+	// Samples arrive in pairs
+	if(blockSize & 1) {
+		return false;
+	}
+
+	adc1_channel_t channel;
+	if(!lookupChannel(pin, channel)) {
+		return false;
+	}
+
+	pinMode(pin, ANALOG);
+
+	i2s_config_t config{};
+	config.mode = i2s_mode_t(I2S_MODE_MASTER | I2S_MODE_RX | I2S_MODE_ADC_BUILT_IN);
+	config.sample_rate = sampleRate;
+	config.bits_per_sample = I2S_BITS_PER_SAMPLE_16BIT;
+	config.channel_format = I2S_CHANNEL_FMT_ONLY_LEFT;
+	config.communication_format = I2S_COMM_FORMAT_STAND_I2S;
+	config.dma_buf_count = 4;
+	config.dma_buf_len = std::min(blockSize, size_t(1024));
+	if(i2s_driver_install(i2sPort, &config, 0, nullptr) != ESP_OK) {
+		return false;
+	}
+
+	adc1_config_width(ADC_WIDTH_BIT_12);
+	adc1_config_channel_atten(channel, ADC_ATTEN_DB_0);
+	i2s_set_adc_mode(ADC_UNIT_1, channel);
+	i2s_adc_enable(i2sPort);
+	sampleRate = i2s_get_clk(i2sPort);
+
+	stopping = false;
+	TaskHandle_t task;
+	if(xTaskCreate(hardwareInterrupt, "adc-sampler", 2048, this, ESP_TASKD_EVENT_PRIO, &task) != pdPASS) {
+		i2s_adc_disable(i2sPort);
+		i2s_driver_uninstall(i2sPort);
+		return false;
+	}
+	readerTask = task;
+
+	return true;
+}
+
+void AdcSampler::hardwareEnd()
+{
+	stopping = true;
+	while(readerTask != nullptr) {
+		vTaskDelay(1);
+	}
+	i2s_adc_disable(i2sPort);
+	i2s_driver_uninstall(i2sPort);
+}
+
+/*
+ * Reader task: blocks until the DMA buffers hold a full block
+ */
+void AdcSampler::hardwareInterrupt(void* param)
+{
+	auto sampler = static_cast<AdcSampler*>(param);
+	const size_t blockBytes = sampler->blockSize * sizeof(Sample);
+	uint8_t blockIndex{0};
+	while(!stopping) {
+		auto block = sampler->getBlock(blockIndex);
+		size_t offset{0};
+		while(offset < blockBytes && !stopping) {
+			size_t bytesRead{0};
+			i2s_read(i2sPort, reinterpret_cast<uint8_t*>(block) + offset, blockBytes - offset, &bytesRead,
+					 pdMS_TO_TICKS(readTimeoutMs));
+			offset += bytesRead;
+		}
+		if(stopping) {
+			break;
+		}
+
+		// Samples arrive in swapped pairs, with the channel number in the top 4 bits
+		for(unsigned i = 0; i + 1 < sampler->blockSize; i += 2) {
+			auto tmp = block[i];
+			block[i] = block[i + 1] & 0x0fff;
+			block[i + 1] = tmp & 0x0fff;
+		}
+
+		sampler->blockComplete(blockIndex);
+		blockIndex ^= 1;
+	}
+
+	readerTask = nullptr;
+	vTaskDelete(nullptr);
+}
+
+#else
+
+bool AdcSampler::hardwareBegin(uint16_t pin)
+{
+	// ADC DMA on other variants is not yet supported
+	(void)pin;
+	return false;
+}
+
+void AdcSampler::hardwareEnd()
+{
+}
+
+void AdcSampler::hardwareInterrupt(void*)
+{
+}
+
+#endif
@@ -12,6 +12,7 @@
 #include <Digital.h>
 #include <Platform/System.h>
 #include <BitManipulations.h>
+#include <Services/Profiling/InterruptTiming.h>
 #include <esp_intr_alloc.h>
 #include <hal/gpio_ll.h>
 
@@ -38,7 +39,7 @@ static inline void IRAM_ATTR interruptProcessor(uint32_t status, const uint32_t
 		status &= ~(1 << nbit);
 		int pin = gpio_num_start + nbit;
 		if(gpioInterruptsList[pin]) {
-			gpioInterruptsList[pin]();
+			Profiling::InterruptTiming::callHandler(pin, gpioInterruptsList[pin]);
 		} else if(delegateFunctionList[pin]) {
 			System.queueCallback(interruptDelegateCallback, pin);
 		}
@@ -0,0 +1,160 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/SmingHub/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * PulseCapture.cpp - Edge capture for the ESP32
+ *
+ * The RMT peripheral measures pulse durations in hardware at 1us resolution.
+ * Each capture uses one receive channel, allocated from the top down to leave the lower ones
+ * for transmit. The driver delivers a frame of pulses once the input has been idle for
+ * `idleThresholdUs`, and a reader task converts these into timestamped edges.
+ *
+ * The length of the idle period preceding each frame isn't measured, so it's estimated
+ * from the time at which the frame was received.
+ *
+ ****/
+
+#include <PulseCapture.h>
+#include <Digital.h>
+#include <esp_task.h>
+#include <esp_timer.h>
+#include <driver/rmt.h>
+
+namespace
+{
+constexpr uint8_t clockDivider{80}; // 1us ticks from 80MHz APB clock
+constexpr uint16_t idleThresholdUs{20000};
+constexpr uint8_t filterTicks{100}; // Ignore glitches shorter than this many APB clock cycles
+constexpr size_t ringBufferSize{1024};
+constexpr unsigned readTimeoutMs{100};
+
+struct Reader {
+	RingbufHandle_t ringbuf;
+	volatile TaskHandle_t task;
+	volatile bool stopping;
+};
+
+Reader readers[PulseCapture::maxCaptures];
+
+rmt_channel_t getChannel(unsigned slot)
+{
+	return rmt_channel_t(SOC_RMT_CHANNELS_PER_GROUP - 1 - slot);
+}
+
+} // namespace
+
+bool PulseCapture::hardwareBegin()
+{
+	if(slot >= SOC_RMT_RX_CANDIDATES_PER_GROUP || !GPIO_IS_VALID_GPIO(pin)) {
+		return false;
+	}
+
+	auto channel = getChannel(slot);
+	rmt_config_t config = RMT_DEFAULT_CONFIG_RX(gpio_num_t(pin), channel);
+	config.clk_div = clockDivider;
+	config.rx_config.idle_threshold = idleThresholdUs;
+	config.rx_config.filter_en = true;
+	config.rx_config.filter_ticks_thresh = filterTicks;
+	if(rmt_config(&config) != ESP_OK) {
+		return false;
+	}
+	if(rmt_driver_install(channel, ringBufferSize, 0) != ESP_OK) {
+		return false;
+	}
+
+	auto& reader = readers[slot];
+	rmt_get_ringbuf_handle(channel, &reader.ringbuf);
+
+	ticksPerUs = 1;
+	lastLevel = digitalRead(pin);
+	lastTime = esp_timer_get_time();
+
+	reader.stopping = false;
+	auto readerTask = [](void* param) {
+		auto capture = static_cast<PulseCapture*>(param);
+		auto& reader = readers[capture->slot];
+		while(!reader.stopping) {
+			hardwareInterrupt(*capture);
+		}
+		reader.task = nullptr;
+		vTaskDelete(nullptr);
+	};
+	TaskHandle_t task;
+	if(xTaskCreate(readerTask, "pulse-capture", 2048, this, ESP_TASKD_EVENT_PRIO, &task) != pdPASS) {
+		rmt_driver_uninstall(channel);
+		return false;
+	}
+	reader.task = task;
+
+	rmt_rx_start(channel, true);
+	return true;
+}
+
+void PulseCapture::hardwareEnd()
+{
+	auto channel = getChannel(slot);
+	rmt_rx_stop(channel);
+
+	auto& reader = readers[slot];
+	reader.stopping = true;
+	while(reader.task != nullptr) {
+		vTaskDelay(1);
+	}
+	rmt_driver_uninstall(channel);
+}
+
+/*
+ * Called repeatedly from reader task: waits for a frame and queues its edges
+ */
+void PulseCapture::hardwareInterrupt(PulseCapture& capture)
+{
+	auto& reader = readers[capture.slot];
+	size_t length{0};
+	auto items = static_cast<rmt_item32_t*>(xRingbufferReceive(reader.ringbuf, &length, pdMS_TO_TICKS(readTimeoutMs)));
+	if(items == nullptr) {
+		return;
+	}
+	uint32_t receiveTime = esp_timer_get_time();
+
+	// Frame ends with a zero duration, or at the end of the buffer
+	auto count = length / sizeof(rmt_item32_t);
+	uint32_t frameDuration{0};
+	uint8_t startLevel{0};
+	for(unsigned i = 0; i < count; ++i) {
+		auto& item = items[i];
+		if(i == 0) {
+			startLevel = item.level0;
+		}
+		frameDuration += item.duration0;
+		if(item.duration0 == 0) {
+			break;
+		}
+		frameDuration += item.duration1;
+		if(item.duration1 == 0) {
+			break;
+		}
+	}
+
+	// Frame was delivered once input had been idle for the threshold period
+	uint32_t time = receiveTime - idleThresholdUs - frameDuration;
+	capture.edgeCaptured(time, startLevel);
+
+	auto addPulse = [&](uint16_t duration, uint8_t level) {
+		if(duration == 0) {
+			return false;
+		}
+		time += duration;
+		capture.edgeCaptured(time, !level);
+		return true;
+	};
+	for(unsigned i = 0; i < count; ++i) {
+		auto& item = items[i];
+		if(!addPulse(item.duration0, item.level0) || !addPulse(item.duration1, item.level1)) {
+			break;
+		}
+	}
+
+	vRingbufferReturnItem(reader.ringbuf, items);
+}
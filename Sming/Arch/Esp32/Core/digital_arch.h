@@ -0,0 +1,41 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/SmingHub/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * digital_arch.h - Port-level GPIO access
+ *
+ * Applies to the first GPIO bank (GPIO0-31). There is no toggle register.
+ *
+ ****/
+
+#pragma once
+
+#include <soc/gpio_reg.h>
+#include <soc/soc.h>
+
+__forceinline void IRAM_ATTR digitalSetMask(uint32_t mask)
+{
+	REG_WRITE(GPIO_OUT_W1TS_REG, mask);
+}
+
+__forceinline void IRAM_ATTR digitalClearMask(uint32_t mask)
+{
+	REG_WRITE(GPIO_OUT_W1TC_REG, mask);
+}
+
+__forceinline void IRAM_ATTR digitalToggleMask(uint32_t mask)
+{
+	REG_WRITE(GPIO_OUT_REG, REG_READ(GPIO_OUT_REG) ^ mask);
+}
+
+__forceinline void IRAM_ATTR digitalWriteMask(uint32_t mask, uint32_t value)
+{
+	REG_WRITE(GPIO_OUT_REG, (REG_READ(GPIO_OUT_REG) & ~mask) | (value & mask));
+}
+
+__forceinline uint32_t IRAM_ATTR digitalReadPort()
+{
+	return REG_READ(GPIO_IN_REG);
+}
@@ -0,0 +1,38 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/SmingHub/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * CrashLog.cpp
+ *
+ */
+
+#include <Services/Profiling/CrashLog.h>
+
+namespace Profiling
+{
+namespace CrashLog
+{
+bool readRecord(Record&)
+{
+	return false;
+}
+
+bool writeRecord(const Record&)
+{
+	return false;
+}
+
+String getReasonName(uint32_t reason)
+{
+	return String(reason);
+}
+
+String getCauseName(uint32_t cause)
+{
+	return String(cause);
+}
+
+} // namespace CrashLog
+} // namespace Profiling
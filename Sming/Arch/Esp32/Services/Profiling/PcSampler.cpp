@@ -0,0 +1,67 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/SmingHub/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * PcSampler.cpp
+ *
+ */
+
+#include <Services/Profiling/PcSampler.h>
+#include <driver/hw_timer.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#ifdef __XTENSA__
+#include <freertos/xtensa_context.h>
+#define FRAME_PC_OFFSET XT_STK_PC
+#else
+#include <riscv/rvruntime-frames.h>
+#define FRAME_PC_OFFSET RV_STK_MEPC
+#endif
+#include <algorithm>
+
+/*
+ * On entry to the first level of interrupt, the FreeRTOS port saves the task context on the
+ * task stack and stores the stack pointer in the first member (pxTopOfStack) of the current TCB.
+ */
+extern "C" void* volatile pxCurrentTCB[];
+
+namespace Profiling
+{
+namespace PcSampler
+{
+namespace
+{
+constexpr uint32_t ticksPerUs{HW_TIMER_BASE_CLK / 16 / 1000000};
+
+void IRAM_ATTR sampleHandler(void*)
+{
+	auto tcb = static_cast<uint8_t**>(pxCurrentTCB[xPortGetCoreID()]);
+	if(tcb == nullptr) {
+		return;
+	}
+	auto frame = *tcb;
+	record(*reinterpret_cast<uint32_t*>(frame + FRAME_PC_OFFSET));
+}
+
+} // namespace
+
+bool startTimer(unsigned intervalUs)
+{
+	uint32_t ticks = std::max(intervalUs, MIN_HW_TIMER1_INTERVAL_US) * ticksPerUs;
+	ticks = std::min(ticks, uint32_t(MAX_HW_TIMER1_INTERVAL));
+	hw_timer1_attach_interrupt(TIMER_FRC1_SOURCE, sampleHandler, nullptr);
+	hw_timer1_enable(TIMER_CLKDIV_16, TIMER_EDGE_INT, true);
+	hw_timer1_write(ticks);
+	return true;
+}
+
+void stopTimer()
+{
+	hw_timer1_disable();
+	hw_timer1_detach_interrupt();
+}
+
+} // namespace PcSampler
+} // namespace Profiling
@@ -0,0 +1,35 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/SmingHub/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * StackUsage.cpp
+ *
+ */
+
+#include <Services/Profiling/StackUsage.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <esp_task.h>
+
+namespace Profiling
+{
+namespace StackUsage
+{
+/*
+ * Must be called from the Sming task, which is created with ESP_TASKD_EVENT_STACK bytes of stack
+ */
+bool getBounds(Bounds& bounds)
+{
+	auto start = pxTaskGetStackStart(xTaskGetCurrentTaskHandle());
+	if(start == nullptr) {
+		return false;
+	}
+	bounds.bottom = uintptr_t(start);
+	bounds.top = bounds.bottom + ESP_TASKD_EVENT_STACK;
+	return true;
+}
+
+} // namespace StackUsage
+} // namespace Profiling
@@ -21,6 +21,7 @@ ENABLE_CUSTOM_PWM			?= 1
 ifeq ($(ENABLE_CUSTOM_PWM), 1)
 	COMPONENT_SRCDIRS		+= new-pwm
 	COMPONENT_CFLAGS		+= -DSDK_PWM_PERIOD_COMPAT_MODE=1
+	GLOBAL_CFLAGS			+= -DENABLE_CUSTOM_PWM=1
 else
 	LIBS					+= pwm
 endif
@@ -133,6 +133,7 @@ struct i2s_state_t {
 	uint8_t buffer_count = 0;		   ///< Number of buffers
 	uint8_t callback_threshold = 0;	///< TX: callback when available buffers > threshold
 									   ///< RX: Callback when buffers_used > threshold
+	volatile uint16_t overflows = 0;   ///< TX: Buffers sent with no data, RX: Buffers discarded
 
 	~i2s_state_t();
 
@@ -240,6 +241,7 @@ bool i2s_stat_tx(i2s_buffer_stat_t* stat)
 
 	stat->size = i2s_obj->tx_state->user_size();
 	stat->used = i2s_obj->tx_state->tx_used();
+	stat->overflows = i2s_obj->tx_state->overflows;
 	return true;
 }
 
@@ -253,6 +255,7 @@ bool i2s_stat_rx(i2s_buffer_stat_t* stat)
 
 	stat->size = i2s_obj->rx_state->user_size();
 	stat->used = i2s_obj->rx_state->rx_available();
+	stat->overflows = i2s_obj->rx_state->overflows;
 	return true;
 }
 
@@ -266,6 +269,7 @@ bool i2s_state_t::tx_done(dma_descriptor_t* desc)
 		// All buffers are empty. This means we have an underflow
 		unsigned buf_index = desc - slc_items;
 		buffer_index = buf_index;
+		++overflows;
 	} else {
 		--buffers_used;
 	}
@@ -279,6 +283,8 @@ bool i2s_state_t::rx_done(dma_descriptor_t* desc)
 	desc->owner = 1;
 	if(buffers_used < (buffer_count - 1)) {
 		++buffers_used;
+	} else {
+		++overflows;
 	}
 
 	return buffers_used > callback_threshold;
@@ -407,7 +413,7 @@ size_t i2s_state_t::write(const void* src, size_t size, TickType_t ticks_to_wait
 	auto buf = static_cast<const uint8_t*>(src);
 	while(size > 0) {
 		if(dma_write(info, size)) {
-			memcpy(info.buffer, src, info.size);
+			memcpy(info.buffer, buf, info.size);
 			buf += info.size;
 			size -= info.size;
 			count += info.size;
@@ -5,6 +5,7 @@ extern "C" {
 #endif
 
 #include <pwm.h>
+#include <stdbool.h>
 
 /**
  * @defgroup pwm_driver PWM driver
@@ -79,6 +80,40 @@ extern "C" {
  * @retval uint32 PWM version
  */
 
+#if ENABLE_CUSTOM_PWM
+
+/**
+ * @brief Play back a precomputed sequence of duty values
+ * @param duty Array of duty values, `steps` rows each containing a value for every channel
+ * @param steps Number of rows in the duty array
+ * @param periods_per_step Number of PWM periods for which each step is output
+ * @param loop true to repeat the sequence, false to stop at the final step
+ * @retval bool false on error, e.g. out of memory
+ *
+ * Phase tables for every step are prepared in advance, so the interrupt routine
+ * selects the next one at a period boundary, without further calculation.
+ * Each step therefore occupies (PWM_MAX_CHANNELS + 2) * 8 bytes of RAM.
+ *
+ * The duty array is not referenced after this call returns.
+ * On return, pwm_get_duty() reports values for the final step.
+ * Calling pwm_start() cancels the sequence.
+ *
+ * @note Available only with the New PWM driver
+ */
+bool pwm_set_sequence(const uint32_t* duty, uint16_t steps, uint16_t periods_per_step, bool loop);
+
+/**
+ * @brief Stop playing a sequence, holding the current step
+ */
+void pwm_stop_sequence(void);
+
+/**
+ * @brief Determine whether a sequence is being played
+ */
+bool pwm_sequence_running(void);
+
+#endif
+
 /** @} */
 
 #if defined(__cplusplus)
@@ -49,6 +49,8 @@
 #include <espinc/gpio_register.h>
 #include <espinc/timer_register.h>
 #include <ets_sys.h>
+#include <stdlib.h>
+#include <stdbool.h>
 
 // from SDK hw_timer.c
 #define TIMER1_DIVIDE_BY_16             0x0004
@@ -75,6 +77,20 @@ static struct {
 	uint8_t current_phase;
 } pwm_state;
 
+/* Sequence playback. Each step is a complete phase set, prepared in advance
+ * by pwm_set_sequence. The interrupt routine just selects the next set at the
+ * start of a period, so steps change without glitches or extra processing.
+ */
+static struct {
+	pwm_phase_array* sets;
+	uint16_t count;
+	uint16_t periods_per_step;
+	volatile uint16_t index;
+	volatile uint16_t period_count;
+	volatile uint8_t loop;
+	volatile uint8_t active;
+} pwm_seq;
+
 static uint32_t pwm_period;
 static uint32_t pwm_period_ticks;
 static uint32_t pwm_duty[PWM_MAX_CHANNELS];
@@ -117,6 +133,21 @@ pwm_intr_handler(void* param)
 {
 	if ((pwm_state.current_set[pwm_state.current_phase].off_mask == 0) &&
 	    (pwm_state.current_set[pwm_state.current_phase].on_mask == 0)) {
+		if (pwm_seq.active && ++pwm_seq.period_count >= pwm_seq.periods_per_step) {
+			pwm_seq.period_count = 0;
+			uint16_t index = pwm_seq.index + 1;
+			if (index >= pwm_seq.count) {
+				if (pwm_seq.loop) {
+					index = 0;
+				} else {
+					// Hold final step
+					index = pwm_seq.count - 1;
+					pwm_seq.active = 0;
+				}
+			}
+			pwm_seq.index = index;
+			pwm_state.next_set = pwm_seq.sets[index];
+		}
 		pwm_state.current_set = pwm_state.next_set;
 		pwm_state.current_phase = 0;
 	}
@@ -353,11 +384,56 @@ _pwm_phases_prep(struct pwm_phase* pwm)
 	return phases;
 }
 
+// Make a prepared set current from the next period, starting the timer if required
+static void ICACHE_FLASH_ATTR
+_pwm_set_next(struct pwm_phase* set, uint8_t phases)
+{
+	// start if not running
+	if (!pwm_state.next_set) {
+#if PWM_DEBUG
+		ets_printf("PWM start\n");
+#endif
+		pwm_state.current_set = pwm_state.next_set = set;
+		pwm_state.current_phase = phases - 1;
+		ETS_FRC1_INTR_ENABLE();
+		WRITE_PERI_REG(FRC1_LOAD_ADDRESS, 0);
+		timer->frc1_ctrl = TIMER1_DIVIDE_BY_16 | TIMER1_ENABLE_TIMER;
+		return;
+	}
+
+	pwm_state.next_set = set;
+}
+
+/* Release a sequence buffer once the interrupt routine has stopped using it.
+ * pwm_state.next_set must already point elsewhere; the handler switches to it
+ * at the start of the next period.
+ */
+static void ICACHE_FLASH_ATTR
+_pwm_sequence_free(pwm_phase_array* sets, uint16_t count)
+{
+	if (sets == NULL)
+		return;
+
+	while (pwm_state.next_set) {
+		__asm__ volatile ("" : : : "memory");
+		struct pwm_phase* current = pwm_state.current_set;
+		if (current < sets[0] || current >= sets[count])
+			break;
+	}
+
+	free(sets);
+}
+
 void ICACHE_FLASH_ATTR
 pwm_start(void)
 {
 	pwm_phase_array* pwm = &pwm_phases[0];
 
+	// Regular updates cancel any sequence
+	pwm_seq.active = 0;
+	pwm_phase_array* seq_sets = pwm_seq.sets;
+	pwm_seq.sets = NULL;
+
 	if ((*pwm == pwm_state.next_set) ||
 	    (*pwm == pwm_state.current_set))
 		pwm++;
@@ -381,23 +457,65 @@ pwm_start(void)
 		GPIO_REG_WRITE(GPIO_OUT_W1TS_ADDRESS, (*pwm)[0].on_mask);
 		GPIO_REG_WRITE(GPIO_OUT_W1TC_ADDRESS, (*pwm)[0].off_mask);
 
+		_pwm_sequence_free(seq_sets, pwm_seq.count);
 		return;
 	}
 
-	// start if not running
-	if (!pwm_state.next_set) {
-#if PWM_DEBUG
-		ets_printf("PWM start\n");
-#endif
-		pwm_state.current_set = pwm_state.next_set = *pwm;
-		pwm_state.current_phase = phases - 1;
-		ETS_FRC1_INTR_ENABLE();
-		WRITE_PERI_REG(FRC1_LOAD_ADDRESS, 0);
-		timer->frc1_ctrl = TIMER1_DIVIDE_BY_16 | TIMER1_ENABLE_TIMER;
-		return;
+	_pwm_set_next(*pwm, phases);
+	_pwm_sequence_free(seq_sets, pwm_seq.count);
+}
+
+bool ICACHE_FLASH_ATTR
+pwm_set_sequence(const uint32_t* duty, uint16_t steps, uint16_t periods_per_step, bool loop)
+{
+	if (duty == NULL || steps == 0 || pwm_channels == 0)
+		return false;
+
+	pwm_phase_array* sets = (pwm_phase_array*)malloc(steps * sizeof(pwm_phase_array));
+	if (sets == NULL)
+		return false;
+
+	uint8_t first_phases = 0;
+	for (uint16_t step = 0; step < steps; step++) {
+		for (uint8_t n = 0; n < pwm_channels; n++)
+			pwm_set_duty(duty[step * pwm_channels + n], n);
+		uint8_t phases = _pwm_phases_prep(sets[step]);
+		if (step == 0)
+			first_phases = phases;
 	}
+	// pwm_duty[] now holds values for the final step
+
+	pwm_seq.active = 0;
+	pwm_phase_array* old_sets = pwm_seq.sets;
+	uint16_t old_count = pwm_seq.count;
+
+	pwm_seq.sets = sets;
+	pwm_seq.count = steps;
+	pwm_seq.periods_per_step = periods_per_step ? periods_per_step : 1;
+	pwm_seq.index = 0;
+	pwm_seq.period_count = 0;
+	pwm_seq.loop = loop;
+
+	/* The handler treats a phase with empty masks as the end of a period,
+	 * so a step with all outputs at 0% or 100% still takes one full period.
+	 */
+	_pwm_set_next(sets[0], first_phases);
+	pwm_seq.active = (steps > 1 || loop);
+
+	_pwm_sequence_free(old_sets, old_count);
+	return true;
+}
+
+void ICACHE_FLASH_ATTR
+pwm_stop_sequence(void)
+{
+	pwm_seq.active = 0;
+}
 
-	pwm_state.next_set = *pwm;
+bool ICACHE_FLASH_ATTR
+pwm_sequence_running(void)
+{
+	return pwm_seq.active;
 }
 
 void ICACHE_FLASH_ATTR
@@ -212,15 +212,35 @@ void IRAM_ATTR handle_uart_interrupt(uint8_t uart_nr, smg_uart_t* uart)
 		// Unless we replenish TX FIFO, disable after handling interrupt
 		if(usis & UART_TXFIFO_EMPTY_INT_ST) {
 			// Dump as much data as we can from buffer into the TX FIFO
+			size_t space = uart_txfifo_free(uart_nr);
 			if(uart->tx_buffer != nullptr) {
-				size_t space = uart_txfifo_free(uart_nr);
 				size_t avail = uart->tx_buffer->available();
 				size_t count = (avail <= space) ? avail : space;
+				space -= count;
 				while(count-- != 0) {
 					WRITE_PERI_REG(UART_FIFO(uart_nr), uart->tx_buffer->readChar());
 				}
 			}
 
+			// Then from caller-owned blocks
+			while(space != 0 && uart->tx_queue != nullptr) {
+				auto desc = uart->tx_queue;
+				size_t avail = desc->length - desc->sent;
+				size_t count = (avail <= space) ? avail : space;
+				space -= count;
+				auto data = &desc->data[desc->sent];
+				desc->sent += count;
+				while(count-- != 0) {
+					WRITE_PERI_REG(UART_FIFO(uart_nr), *data++);
+				}
+				if(desc->sent == desc->length) {
+					uart->tx_queue = desc->next;
+					if(desc->callback != nullptr) {
+						desc->callback(uart, desc);
+					}
+				}
+			}
+
 			// If TX FIFO remains empty then we must disable TX FIFO EMPTY interrupt to stop it recurring.
 			if(uart_txfifo_count(uart_nr) == 0) {
 				// The interrupt gets re-enabled by uart_write()
@@ -496,6 +516,33 @@ size_t smg_uart_write(smg_uart_t* uart, const void* buffer, size_t size)
 	return written;
 }
 
+bool smg_uart_write_desc(smg_uart_t* uart, smg_uart_tx_desc_t* desc)
+{
+	if(!smg_uart_tx_enabled(uart) || !is_physical(uart) || desc == nullptr || desc->data == nullptr ||
+	   desc->length == 0) {
+		return false;
+	}
+
+	desc->sent = 0;
+	desc->next = nullptr;
+
+	smg_uart_disable_interrupts();
+
+	auto tail = &uart->tx_queue;
+	while(*tail != nullptr) {
+		tail = &(*tail)->next;
+	}
+	*tail = desc;
+
+	// ISR fills TX FIFO
+	WRITE_PERI_REG(UART_INT_CLR(uart->uart_nr), UART_TXFIFO_EMPTY_INT_CLR);
+	SET_PERI_REG_MASK(UART_INT_ENA(uart->uart_nr), UART_TXFIFO_EMPTY_INT_ENA);
+
+	smg_uart_restore_interrupts();
+
+	return true;
+}
+
 size_t smg_uart_tx_free(smg_uart_t* uart)
 {
 	if(!smg_uart_tx_enabled(uart)) {
@@ -528,6 +575,10 @@ void smg_uart_wait_tx_empty(smg_uart_t* uart)
 		}
 	}
 
+	while(uart->tx_queue != nullptr) {
+		system_soft_wdt_feed();
+	}
+
 	if(is_physical(uart)) {
 		while(uart_txfifo_count(uart->uart_nr) != 0)
 			system_soft_wdt_feed();
@@ -586,6 +637,12 @@ void smg_uart_flush(smg_uart_t* uart, smg_uart_mode_t mode)
 		uart->tx_buffer->clear();
 	}
 
+	smg_uart_tx_desc_t* discarded{nullptr};
+	if(flushTx) {
+		discarded = uart->tx_queue;
+		uart->tx_queue = nullptr;
+	}
+
 	if(is_physical(uart)) {
 		// Clear the hardware FIFOs
 		uint32_t flushBits = 0;
@@ -612,6 +669,14 @@ void smg_uart_flush(smg_uart_t* uart, smg_uart_mode_t mode)
 	}
 
 	smg_uart_restore_interrupts();
+
+	while(discarded != nullptr) {
+		auto desc = discarded;
+		discarded = desc->next;
+		if(desc->callback != nullptr) {
+			desc->callback(uart, desc);
+		}
+	}
 }
 
 uint32_t smg_uart_set_baudrate_reg(int uart_nr, uint32_t baud_rate)
@@ -756,6 +821,11 @@ void smg_uart_uninit(smg_uart_t* uart)
 
 	notify(uart, UART_NOTIFY_BEFORE_CLOSE);
 
+	// Return any queued blocks to their owners
+	if(uart->tx_queue != nullptr) {
+		smg_uart_flush(uart, UART_TX_ONLY);
+	}
+
 	smg_uart_stop_isr(uart);
 	// If debug output being sent to this UART, disable it
 	if(uart->uart_nr == s_uart_debug_nr) {
@@ -815,6 +885,20 @@ bool smg_uart_intr_config(smg_uart_t* uart, const smg_uart_intr_config_t* config
 	return true;
 }
 
+bool smg_uart_set_rx_timeout(smg_uart_t* uart, uint8_t chars)
+{
+	uart = get_physical(uart);
+	if(uart == nullptr || !smg_uart_rx_enabled(uart)) {
+		return false;
+	}
+
+	uint32_t conf1 = READ_PERI_REG(UART_CONF1(uart->uart_nr));
+	conf1 &= ~(UART_RX_TOUT_THRHD << UART_RX_TOUT_THRHD_S);
+	conf1 |= (TRange(1, UART_RX_TOUT_THRHD).clip(chars) << UART_RX_TOUT_THRHD_S) | UART_RX_TOUT_EN;
+	WRITE_PERI_REG(UART_CONF1(uart->uart_nr), conf1);
+	return true;
+}
+
 void smg_uart_swap(smg_uart_t* uart, int tx_pin)
 {
 	if(uart == nullptr) {
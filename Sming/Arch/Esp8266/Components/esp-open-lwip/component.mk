@@ -22,6 +22,18 @@ ifeq ($(ENABLE_LWIPDEBUG), 1)
 	COMPONENT_CFLAGS	+= -DLWIP_DEBUG
 endif
 
+# Buffer sizes. Pools are allocated from the heap so only TCP settings are affected.
+# TCP_WND and TCP_SND_BUF default to 4 and 2 segments respectively.
+COMPONENT_VARS			+= LWIP_PROFILE
+LWIP_PROFILE			?= balanced
+ifeq ($(LWIP_PROFILE),small)
+	GLOBAL_CFLAGS		+= -DTCP_MSS=536
+else ifeq ($(LWIP_PROFILE),throughput)
+	GLOBAL_CFLAGS		+= -DTCP_SND_BUF=5560
+else ifneq ($(LWIP_PROFILE),balanced)
+$(error LWIP_PROFILE must be one of: small balanced throughput)
+endif
+
 COMPONENT_SUBMODULES	:= esp-open-lwip
 COMPONENT_SRCDIRS		:=
 COMPONENT_SRCFILES		:= \
@@ -43,6 +43,24 @@ EXTRA_LIBS := \
 
 LIBDIRS += $(COMPONENT_PATH)/ld $(SDK_LIBDIR)
 
+# Linker fragment placing selected functions into IRAM, generated by `make iram-profile`
+COMPONENT_RELINK_VARS += IRAM_PROFILE
+IRAM_PROFILE ?=
+ifneq (,$(IRAM_PROFILE))
+IRAM_PROFILE_DIR := $(BUILD_BASE)/iram-profile
+IRAM_PROFILE_SRC := $(call AbsoluteSourcePath,$(PROJECT_DIR),$(IRAM_PROFILE))
+ifeq (,$(wildcard $(IRAM_PROFILE_SRC)))
+$(warning IRAM_PROFILE '$(IRAM_PROFILE)' not found)
+else
+$(shell mkdir -p $(IRAM_PROFILE_DIR) && cp -f $(IRAM_PROFILE_SRC) $(IRAM_PROFILE_DIR)/iram_profile.ld)
+LIBDIRS := $(IRAM_PROFILE_DIR) $(LIBDIRS)
+endif
+endif
+
+CACHE_VARS += IRAM_PROFILE_CAPTURE IRAM_PROFILE_BUDGET
+IRAM_PROFILE_CAPTURE ?=
+IRAM_PROFILE_BUDGET ?= 2048
+
 # SDK-provided crypto library
 # Some routines are available in ROM so strip them out
 LIBCRYPTO := $(SDK_LIBDIR)/libcrypto.a
@@ -0,0 +1,39 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/SmingHub/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * esp_rtc_map.h - Allocation of RTC user memory
+ *
+ * All addresses and sizes are in 32-bit blocks, as used by system_rtc_mem_read/write.
+ * Any new user of RTC memory must be added here.
+ *
+ ****/
+
+#pragma once
+
+#define RTC_USER_MEM_START 64
+#define RTC_USER_MEM_END 192
+
+// rBoot boot mode (rboot_rtc_data)
+#define RTC_MAP_RBOOT_ADDR RTC_USER_MEM_START
+#define RTC_MAP_RBOOT_SIZE 3
+
+// RtcClass time keeping
+#define RTC_MAP_CLOCK_ADDR (RTC_MAP_RBOOT_ADDR + RTC_MAP_RBOOT_SIZE)
+#define RTC_MAP_CLOCK_SIZE 4
+
+// Station fast connect details
+#define RTC_MAP_FAST_CONNECT_ADDR (RTC_MAP_CLOCK_ADDR + RTC_MAP_CLOCK_SIZE)
+#define RTC_MAP_FAST_CONNECT_SIZE 10
+
+// Ssl::RtcSessionStore slots, up to start of crash log (if enabled)
+#define RTC_MAP_SSL_SESSION_ADDR (RTC_MAP_FAST_CONNECT_ADDR + RTC_MAP_FAST_CONNECT_SIZE)
+#if defined(ENABLE_CRASH_LOG) && ENABLE_CRASH_LOG
+#define RTC_MAP_SSL_SESSION_END CRASH_LOG_RTC_ADDR
+#else
+#define RTC_MAP_SSL_SESSION_END RTC_USER_MEM_END
+#endif
+
+// Profiling::CrashLog record is at CRASH_LOG_RTC_ADDR (default 128) and occupies 62 blocks
@@ -31,6 +31,30 @@
 
 #define SYSTEM_ERROR(fmt, ...) debug_e("ERROR: " fmt "\r\n", ##__VA_ARGS__)
 
+#if ENABLE_INTERRUPT_TIMING
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Instrumented versions record time spent with interrupts disabled.
+ * See Profiling::InterruptTiming.
+ */
+uint32_t irq_timing_disable(void);
+void irq_timing_enable(void);
+void irq_timing_restore(uint32_t level);
+
+#ifdef __cplusplus
+}
+#endif
+
+#define noInterrupts() irq_timing_disable()
+#define interrupts() irq_timing_enable()
+#define restoreInterrupts(level) irq_timing_restore(level)
+
+#else
+
 /** @brief  Disable interrupts
  *  @retval Current interrupt level
  *  @note Hardware timer is unaffected if operating in non-maskable mode
@@ -44,3 +68,5 @@
 /** @brief Restore interrupts to level saved from previous noInterrupts() call
  */
 #define restoreInterrupts(level) XTOS_RESTORE_INTLEVEL(level)
+
+#endif
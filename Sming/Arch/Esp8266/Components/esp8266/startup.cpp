@@ -14,6 +14,7 @@
 #include <gdb/gdb_hooks.h>
 #include <Storage.h>
 #include <spi_flash.h>
+#include <Services/Profiling/BootTimeline.h>
 
 extern void init();
 extern void cpp_core_initialize();
@@ -41,7 +42,9 @@ extern "C" void user_init(void)
 
 	Storage::initialize();
 
+	BOOT_PHASE_BEGIN(userInit);
 	init(); // User code init
+	BOOT_PHASE_END(userInit);
 }
 
 extern "C" void ICACHE_FLASH_ATTR WEAK_ATTR user_pre_init(void)
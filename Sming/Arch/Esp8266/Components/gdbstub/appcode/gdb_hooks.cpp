@@ -15,6 +15,7 @@
 #include "gdbstub/gdbstub-entry.h"
 #include "gdbstub/exceptions.h"
 #include <driver/uart.h>
+#include <Services/Profiling/CrashLog.h>
 
 extern "C" void Cache_Read_Enable_New();
 
@@ -65,6 +66,18 @@ void debug_print_stack(uint32_t start, uint32_t end)
 
 void debug_crash_callback(const rst_info* rst_info, uint32_t stack, uint32_t stack_end)
 {
+#if ENABLE_CRASH_LOG
+	Profiling::CrashLog::Record rec{};
+	rec.reason = rst_info->reason;
+	rec.cause = rst_info->exccause;
+	rec.epc[0] = rst_info->epc1;
+	rec.epc[1] = rst_info->epc2;
+	rec.epc[2] = rst_info->epc3;
+	rec.excvaddr = rst_info->excvaddr;
+	rec.depc = rst_info->depc;
+	Profiling::CrashLog::capture(rec, stack, stack_end);
+#endif
+
 #ifdef ENABLE_GDB
 	gdbFlushUserData();
 	if(gdb_state.attached) {
@@ -105,6 +118,26 @@ void debug_crash_callback(const rst_info* rst_info, uint32_t stack, uint32_t sta
 
 #ifdef HOOK_SYSTEM_EXCEPTIONS
 
+#if ENABLE_CRASH_LOG
+/*
+ * The system is left to the hardware watchdog after an exception, so the reset handler
+ * won't get called: save the record here instead, whilst all registers are available
+ */
+static void captureException()
+{
+	auto& reg = gdbstub_savedRegs;
+	Profiling::CrashLog::Record rec{};
+	rec.reason = REASON_EXCEPTION_RST;
+	rec.cause = reg.cause;
+	rec.epc[0] = reg.pc;
+	rec.excvaddr = reg.excvaddr;
+	rec.ps = reg.ps;
+	memcpy(rec.regs, reg.a, sizeof(rec.regs));
+	rec.regsValid = 1;
+	Profiling::CrashLog::capture(rec, reg.a[1], 0x3fffffb0);
+}
+#endif
+
 void dumpExceptionInfo()
 {
 	auto& reg = gdbstub_savedRegs;
@@ -173,6 +206,10 @@ static void __noinline gdbstub_exception_handler_flash(UserFrame* frame)
 
 #else
 
+#if ENABLE_CRASH_LOG
+	captureException();
+#endif
+
 	dumpExceptionInfo();
 
 #if defined(ENABLE_GDB)
@@ -7,8 +7,9 @@ COMPONENT_RELINK_VARS	:= ENABLE_CUSTOM_HEAP
 ENABLE_CUSTOM_HEAP		?= 0
 ifeq ($(ENABLE_CUSTOM_HEAP), 1)
 COMPONENT_SUBMODULES	:= umm_malloc
-COMPONENT_SRCFILES		+= custom_heap.c umm_malloc/src/umm_malloc.c
-COMPONENT_INCDIRS		+= umm_malloc/src umm_malloc/includes/c-helper-macros
+COMPONENT_SRCFILES		+= custom_heap.c heap_region.c heap_caps.c umm_malloc/src/umm_malloc.c
+COMPONENT_INCDIRS		+= include umm_malloc/src umm_malloc/includes/c-helper-macros
+GLOBAL_CFLAGS			+= -DENABLE_HEAP_REGIONS=1
 
 #
 COMPONENT_RELINK_VARS	+= UMM_POISON_CHECK
@@ -22,6 +23,12 @@ ifeq ($(UMM_FUNC_IRAM),1)
 COMPONENT_CFLAGS		+= -DUMM_FUNC_IRAM=1
 endif
 
+COMPONENT_RELINK_VARS	+= UMM_IRAM_HEAP
+UMM_IRAM_HEAP			?= 0
+ifeq ($(UMM_IRAM_HEAP),1)
+COMPONENT_CFLAGS		+= -DUMM_IRAM_HEAP=1
+endif
+
 COMPONENT_CFLAGS		+= -Wno-array-bounds
 
 # remove mem_manager.o module from libmain of SDK
@@ -7,6 +7,7 @@
 #include <c_types.h>
 #include "umm_malloc_cfg.h"
 #include "umm_malloc.h"
+#include "include/heap_region.h"
 
 #undef IRAM_ATTR
 #define IRAM_ATTR __attribute__((section(".iram.text")))
@@ -18,49 +19,95 @@
 #endif
 
 
+static void* IRAM_ATTR heap_malloc(size_t size)
+{
+	heap_region_t* region = heap_region_selected();
+	if(region != NULL) {
+		void* ptr = heap_region_malloc(region, size);
+		if(ptr != NULL || (heap_region_get_flags(region) & HEAP_REGION_FLAG_FALLBACK) == 0) {
+			return ptr;
+		}
+	}
+	return UMM_FUNC(malloc)(size);
+}
+
+static void* IRAM_ATTR heap_calloc(size_t num, size_t size)
+{
+	heap_region_t* region = heap_region_selected();
+	if(region != NULL) {
+		void* ptr = heap_region_calloc(region, num, size);
+		if(ptr != NULL || (heap_region_get_flags(region) & HEAP_REGION_FLAG_FALLBACK) == 0) {
+			return ptr;
+		}
+	}
+	return UMM_FUNC(calloc)(num, size);
+}
+
+static void* IRAM_ATTR heap_realloc(void* ptr, size_t size)
+{
+	if(ptr == NULL) {
+		return heap_malloc(size);
+	}
+	heap_region_t* region = heap_region_from_ptr(ptr);
+	if(region != NULL) {
+		return heap_region_realloc(region, ptr, size);
+	}
+	return UMM_FUNC(realloc)(ptr, size);
+}
+
+static void IRAM_ATTR heap_free(void* ptr)
+{
+	heap_region_t* region = heap_region_from_ptr(ptr);
+	if(region != NULL) {
+		heap_region_free(region, ptr);
+	} else {
+		UMM_FUNC(free)(ptr);
+	}
+}
+
 void* IRAM_ATTR pvPortMalloc(size_t size, const char* file, int line)
 {
-    return UMM_FUNC(malloc)(size);
+	return heap_malloc(size);
 }
 
 void IRAM_ATTR vPortFree(void *ptr, const char* file, int line)
 {
-	UMM_FUNC(free)(ptr);
+	heap_free(ptr);
 }
 
 void* IRAM_ATTR malloc(size_t size)
 {
-	return UMM_FUNC(malloc)(size);
+	return heap_malloc(size);
 }
 
 void* IRAM_ATTR calloc(size_t num, size_t size)
 {
-	return UMM_FUNC(calloc)(num, size);
+	return heap_calloc(num, size);
 }
 
 void* IRAM_ATTR realloc(void* ptr, size_t size)
 {
-	return UMM_FUNC(realloc)(ptr, size);
+	return heap_realloc(ptr, size);
 }
 
 void IRAM_ATTR free(void *ptr)
 {
-	UMM_FUNC(free)(ptr);
+	heap_free(ptr);
 }
 
 void* IRAM_ATTR pvPortCalloc(size_t count, size_t size, const char* file, int line)
 {
-    return UMM_FUNC(calloc)(count, size);
+	return heap_calloc(count, size);
 }
 
 void* IRAM_ATTR pvPortRealloc(void *ptr, size_t size, const char* file, int line)
 {
-    return UMM_FUNC(realloc)(ptr, size);
+	return heap_realloc(ptr, size);
 }
 
 void* IRAM_ATTR pvPortZalloc(size_t size, const char* file, int line)
 {
-    return UMM_FUNC(calloc)(1, size);
+	return heap_calloc(1, size);
 }
 
 void* IRAM_ATTR pvPortZallocIram(size_t size, const char* file, int line) __attribute__ ((weak, alias("pvPortZalloc")));
@@ -0,0 +1,90 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/SmingHub/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * heap_caps.c
+ *
+ ****/
+
+#include "include/esp_heap_caps.h"
+#include <stdlib.h>
+#include "umm_malloc_cfg.h"
+#include "umm_malloc.h"
+
+#define UMM_BLOCK_SIZE 8
+
+static heap_region_t* get_caps_region(uint32_t caps)
+{
+	if((caps & MALLOC_CAP_32BIT) && !(caps & (MALLOC_CAP_8BIT | MALLOC_CAP_DEFAULT))) {
+		return heap_region_iram();
+	}
+	return NULL;
+}
+
+void* heap_caps_malloc(size_t size, uint32_t caps)
+{
+	heap_region_t* region = get_caps_region(caps);
+	if(region != NULL) {
+		void* ptr = heap_region_malloc(region, size);
+		if(ptr != NULL) {
+			return ptr;
+		}
+	}
+
+	heap_region_t* prev = heap_region_select(NULL);
+	void* ptr = malloc(size);
+	heap_region_select(prev);
+	return ptr;
+}
+
+void* heap_caps_calloc(size_t count, size_t size, uint32_t caps)
+{
+	heap_region_t* region = get_caps_region(caps);
+	if(region != NULL) {
+		void* ptr = heap_region_calloc(region, count, size);
+		if(ptr != NULL) {
+			return ptr;
+		}
+	}
+
+	heap_region_t* prev = heap_region_select(NULL);
+	void* ptr = calloc(count, size);
+	heap_region_select(prev);
+	return ptr;
+}
+
+void* heap_caps_realloc(void* ptr, size_t size, uint32_t caps)
+{
+	if(ptr == NULL) {
+		return heap_caps_malloc(size, caps);
+	}
+	return realloc(ptr, size);
+}
+
+void heap_caps_free(void* ptr)
+{
+	free(ptr);
+}
+
+size_t heap_caps_get_free_size(uint32_t caps)
+{
+	heap_region_t* region = get_caps_region(caps);
+	heap_region_info_t info;
+	size_t size = heap_region_get_info(region, &info) ? info.free : 0;
+	return size + umm_free_heap_size();
+}
+
+size_t heap_caps_get_largest_free_block(uint32_t caps)
+{
+	umm_info(NULL, 0);
+	size_t largest = ummHeapInfo.maxFreeContiguousBlocks * UMM_BLOCK_SIZE;
+
+	heap_region_t* region = get_caps_region(caps);
+	heap_region_info_t info;
+	if(heap_region_get_info(region, &info) && info.largest_free > largest) {
+		largest = info.largest_free;
+	}
+	return largest;
+}
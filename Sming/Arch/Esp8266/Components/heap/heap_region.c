@@ -0,0 +1,328 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/SmingHub/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * heap_region.c
+ *
+ * Simple first-fit allocator for additional heap regions.
+ *
+ * Each block starts with a 32-bit header containing its size in words (including the header)
+ * shifted left by one, with bit 0 set if the block is in use. Adjacent free blocks are merged
+ * as they are encountered during allocation. Only aligned 32-bit accesses are made so regions
+ * may be located in IRAM.
+ *
+ ****/
+
+#include "include/heap_region.h"
+#include <string.h>
+#include <xtensa/xtruntime.h>
+
+#ifdef UMM_FUNC_IRAM
+#define HEAP_FUNC_ATTR __attribute__((section(".iram.text")))
+#else
+#define HEAP_FUNC_ATTR
+#endif
+
+#define BLOCK_USED 0x01U
+#define BLOCK_WORDS(hdr) ((hdr) >> 1)
+#define MIN_BLOCK_WORDS 2U
+
+#define IRAM_HEAP_END 0x40108000U
+
+struct heap_region {
+	const char* name;
+	uint32_t flags;
+	uint32_t* start;
+	uint32_t* end;
+	size_t free;
+	size_t min_free;
+	unsigned alloc_count;
+	unsigned fail_count;
+};
+
+static struct heap_region regions[HEAP_REGION_MAX];
+static unsigned region_count;
+static heap_region_t* selected_region;
+static heap_region_t* policy[HEAP_CLIENT_MAX];
+
+heap_region_t* heap_region_create(const char* name, void* buffer, size_t size, uint32_t flags)
+{
+	uintptr_t start = ((uintptr_t)buffer + 3) & ~(uintptr_t)3;
+	uintptr_t end = ((uintptr_t)buffer + size) & ~(uintptr_t)3;
+	if(end < start + MIN_BLOCK_WORDS * 4) {
+		return NULL;
+	}
+
+	uint32_t level = XTOS_SET_INTLEVEL(15);
+	heap_region_t* region = NULL;
+	if(region_count < HEAP_REGION_MAX) {
+		region = &regions[region_count];
+		region->name = name;
+		region->flags = flags;
+		region->start = (uint32_t*)start;
+		region->end = (uint32_t*)end;
+		region->free = region->min_free = end - start;
+		region->alloc_count = 0;
+		region->fail_count = 0;
+		*region->start = ((end - start) / 4) << 1;
+		++region_count;
+	}
+	XTOS_RESTORE_INTLEVEL(level);
+
+	return region;
+}
+
+heap_region_t* heap_region_iram(void)
+{
+#ifdef UMM_IRAM_HEAP
+	static heap_region_t* iram_region;
+	if(iram_region == NULL) {
+		extern uint32_t _lit4_end;
+		uintptr_t start = (uintptr_t)&_lit4_end;
+		iram_region = heap_region_create("iram", (void*)start, IRAM_HEAP_END - start, HEAP_REGION_FLAG_32BIT);
+	}
+	return iram_region;
+#else
+	return NULL;
+#endif
+}
+
+heap_region_t* heap_region_find(const char* name)
+{
+	for(unsigned i = 0; i < region_count; ++i) {
+		if(strcmp(regions[i].name, name) == 0) {
+			return &regions[i];
+		}
+	}
+	return NULL;
+}
+
+heap_region_t* heap_region_get(unsigned index)
+{
+	return (index < region_count) ? &regions[index] : NULL;
+}
+
+heap_region_t* HEAP_FUNC_ATTR heap_region_from_ptr(const void* ptr)
+{
+	for(unsigned i = 0; i < region_count; ++i) {
+		heap_region_t* region = &regions[i];
+		if((const uint32_t*)ptr > region->start && (const uint32_t*)ptr < region->end) {
+			return region;
+		}
+	}
+	return NULL;
+}
+
+/*
+ * Merge any free blocks following the given free block
+ */
+static uint32_t HEAP_FUNC_ATTR merge_free(heap_region_t* region, uint32_t* block)
+{
+	uint32_t words = BLOCK_WORDS(*block);
+	uint32_t* next = block + words;
+	while(next < region->end && (*next & BLOCK_USED) == 0) {
+		words += BLOCK_WORDS(*next);
+		next = block + words;
+	}
+	*block = words << 1;
+	return words;
+}
+
+static uint32_t* HEAP_FUNC_ATTR alloc_block(heap_region_t* region, uint32_t words)
+{
+	uint32_t* block = region->start;
+	while(block < region->end) {
+		uint32_t hdr = *block;
+		uint32_t blockWords = BLOCK_WORDS(hdr);
+		if((hdr & BLOCK_USED) == 0) {
+			blockWords = merge_free(region, block);
+			if(blockWords >= words) {
+				if(blockWords - words >= MIN_BLOCK_WORDS) {
+					block[words] = (blockWords - words) << 1;
+					blockWords = words;
+				}
+				*block = (blockWords << 1) | BLOCK_USED;
+				region->free -= blockWords * 4;
+				if(region->free < region->min_free) {
+					region->min_free = region->free;
+				}
+				++region->alloc_count;
+				return block;
+			}
+		}
+		block += blockWords;
+	}
+
+	++region->fail_count;
+	return NULL;
+}
+
+static inline uint32_t required_words(size_t size)
+{
+	uint32_t words = 1 + (size + 3) / 4;
+	return (words < MIN_BLOCK_WORDS) ? MIN_BLOCK_WORDS : words;
+}
+
+void* HEAP_FUNC_ATTR heap_region_malloc(heap_region_t* region, size_t size)
+{
+	if(region == NULL || size == 0) {
+		return NULL;
+	}
+
+	uint32_t level = XTOS_SET_INTLEVEL(15);
+	uint32_t* block = alloc_block(region, required_words(size));
+	XTOS_RESTORE_INTLEVEL(level);
+
+	return block ? block + 1 : NULL;
+}
+
+void* HEAP_FUNC_ATTR heap_region_calloc(heap_region_t* region, size_t count, size_t size)
+{
+	size_t total = count * size;
+	if(size != 0 && total / size != count) {
+		return NULL;
+	}
+
+	uint32_t* ptr = heap_region_malloc(region, total);
+	if(ptr != NULL) {
+		for(unsigned i = 0; i < (total + 3) / 4; ++i) {
+			ptr[i] = 0;
+		}
+	}
+	return ptr;
+}
+
+void* HEAP_FUNC_ATTR heap_region_realloc(heap_region_t* region, void* ptr, size_t size)
+{
+	if(ptr == NULL) {
+		return heap_region_malloc(region, size);
+	}
+	if(size == 0) {
+		heap_region_free(region, ptr);
+		return NULL;
+	}
+
+	uint32_t words = required_words(size);
+	uint32_t* block = (uint32_t*)ptr - 1;
+
+	uint32_t level = XTOS_SET_INTLEVEL(15);
+
+	// Try to resize in place
+	uint32_t blockWords = BLOCK_WORDS(*block);
+	uint32_t* next = block + blockWords;
+	if(blockWords < words && next < region->end && (*next & BLOCK_USED) == 0) {
+		uint32_t extra = merge_free(region, next);
+		if(blockWords + extra >= words) {
+			region->free -= extra * 4;
+			blockWords += extra;
+			if(region->free < region->min_free) {
+				region->min_free = region->free;
+			}
+		}
+	}
+	if(blockWords >= words) {
+		if(blockWords - words >= MIN_BLOCK_WORDS) {
+			block[words] = (blockWords - words) << 1;
+			region->free += (blockWords - words) * 4;
+			blockWords = words;
+		}
+		*block = (blockWords << 1) | BLOCK_USED;
+		XTOS_RESTORE_INTLEVEL(level);
+		return ptr;
+	}
+
+	uint32_t* newBlock = alloc_block(region, words);
+	XTOS_RESTORE_INTLEVEL(level);
+	if(newBlock == NULL) {
+		return NULL;
+	}
+
+	for(unsigned i = 1; i < blockWords; ++i) {
+		newBlock[i] = block[i];
+	}
+	heap_region_free(region, ptr);
+	return newBlock + 1;
+}
+
+void HEAP_FUNC_ATTR heap_region_free(heap_region_t* region, void* ptr)
+{
+	if(region == NULL || ptr == NULL) {
+		return;
+	}
+
+	uint32_t* block = (uint32_t*)ptr - 1;
+	uint32_t level = XTOS_SET_INTLEVEL(15);
+	uint32_t hdr = *block;
+	if(hdr & BLOCK_USED) {
+		*block = hdr & ~BLOCK_USED;
+		region->free += BLOCK_WORDS(hdr) * 4;
+		--region->alloc_count;
+	}
+	XTOS_RESTORE_INTLEVEL(level);
+}
+
+bool heap_region_get_info(heap_region_t* region, heap_region_info_t* info)
+{
+	if(region == NULL || info == NULL) {
+		return false;
+	}
+
+	uint32_t level = XTOS_SET_INTLEVEL(15);
+	size_t largest = 0;
+	uint32_t* block = region->start;
+	while(block < region->end) {
+		uint32_t words;
+		if(*block & BLOCK_USED) {
+			words = BLOCK_WORDS(*block);
+		} else {
+			words = merge_free(region, block);
+			if(words > largest) {
+				largest = words;
+			}
+		}
+		block += words;
+	}
+
+	info->name = region->name;
+	info->flags = region->flags;
+	info->size = (region->end - region->start) * 4;
+	info->free = region->free;
+	info->min_free = region->min_free;
+	info->largest_free = largest ? (largest - 1) * 4 : 0;
+	info->alloc_count = region->alloc_count;
+	info->fail_count = region->fail_count;
+	XTOS_RESTORE_INTLEVEL(level);
+
+	return true;
+}
+
+heap_region_t* HEAP_FUNC_ATTR heap_region_select(heap_region_t* region)
+{
+	heap_region_t* previous = selected_region;
+	selected_region = region;
+	return previous;
+}
+
+heap_region_t* HEAP_FUNC_ATTR heap_region_selected(void)
+{
+	return selected_region;
+}
+
+void heap_region_set_policy(heap_client_t client, heap_region_t* region)
+{
+	if(client < HEAP_CLIENT_MAX) {
+		policy[client] = region;
+	}
+}
+
+heap_region_t* heap_region_get_policy(heap_client_t client)
+{
+	return (client < HEAP_CLIENT_MAX) ? policy[client] : NULL;
+}
+
+uint32_t heap_region_get_flags(heap_region_t* region)
+{
+	return region ? region->flags : 0;
+}
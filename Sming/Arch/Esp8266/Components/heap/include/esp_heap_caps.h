@@ -0,0 +1,47 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/SmingHub/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * esp_heap_caps.h - Capability-based allocation, compatible with ESP-IDF
+ *
+ ****/
+
+#pragma once
+
+#include "heap_region.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define MALLOC_CAP_32BIT (1 << 1)	 ///< Memory must allow 32-bit access, may be IRAM
+#define MALLOC_CAP_8BIT (1 << 2)	  ///< Memory must allow 8/16/32-bit access
+#define MALLOC_CAP_INTERNAL (1 << 11) ///< Internal memory (all ESP8266 memory is internal)
+#define MALLOC_CAP_DEFAULT (1 << 12)  ///< Memory used by malloc()
+
+/**
+ * @brief Allocate memory with the requested capabilities
+ *
+ * Requests for MALLOC_CAP_32BIT without MALLOC_CAP_8BIT are satisfied from the IRAM region
+ * if available, otherwise from the main heap.
+ */
+void* heap_caps_malloc(size_t size, uint32_t caps);
+void* heap_caps_calloc(size_t count, size_t size, uint32_t caps);
+void* heap_caps_realloc(void* ptr, size_t size, uint32_t caps);
+void heap_caps_free(void* ptr);
+
+/**
+ * @brief Get total free memory with the requested capabilities
+ */
+size_t heap_caps_get_free_size(uint32_t caps);
+
+/**
+ * @brief Get largest block which can be allocated with the requested capabilities
+ */
+size_t heap_caps_get_largest_free_block(uint32_t caps);
+
+#ifdef __cplusplus
+}
+#endif
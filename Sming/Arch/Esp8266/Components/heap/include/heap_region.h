@@ -0,0 +1,154 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/SmingHub/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * heap_region.h - Additional heap regions for custom heap
+ *
+ ****/
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Maximum number of additional heap regions
+ */
+#ifndef HEAP_REGION_MAX
+#define HEAP_REGION_MAX 4
+#endif
+
+/**
+ * @brief Region flags
+ */
+#define HEAP_REGION_FLAG_32BIT 0x01	///< Region only supports 32-bit access (IRAM)
+#define HEAP_REGION_FLAG_FALLBACK 0x02 ///< Use main heap if region is exhausted
+
+/**
+ * @brief Subsystems which may be directed to a specific region
+ */
+typedef enum {
+	HEAP_CLIENT_SSL, ///< SSL contexts, connections and buffers
+	HEAP_CLIENT_MAX,
+} heap_client_t;
+
+typedef struct heap_region heap_region_t;
+
+typedef struct {
+	const char* name;	///< Name given when region was created
+	uint32_t flags;		 ///< HEAP_REGION_FLAG_xxx
+	size_t size;		 ///< Usable size, excluding management overhead
+	size_t free;		 ///< Bytes available, including block headers
+	size_t min_free;	 ///< Lowest value of `free`
+	size_t largest_free; ///< Largest block which can be allocated
+	unsigned alloc_count; ///< Number of live allocations
+	unsigned fail_count; ///< Number of failed allocation requests
+} heap_region_info_t;
+
+/**
+ * @brief Create a heap region
+ * @param name Region name, must remain valid for the lifetime of the region
+ * @param buffer Memory to use for the region, including space for management
+ * @param size Size of buffer in bytes
+ * @param flags Combination of HEAP_REGION_FLAG_xxx values
+ * @retval heap_region_t* The new region, or NULL if table is full or buffer too small
+ *
+ * Regions cannot be destroyed.
+ */
+heap_region_t* heap_region_create(const char* name, void* buffer, size_t size, uint32_t flags);
+
+/**
+ * @brief Get region created from the unused portion of IRAM
+ * @retval heap_region_t* NULL if UMM_IRAM_HEAP is not enabled
+ * @note Memory must only be accessed using aligned 32-bit reads and writes
+ */
+heap_region_t* heap_region_iram(void);
+
+/**
+ * @brief Find region by name
+ */
+heap_region_t* heap_region_find(const char* name);
+
+/**
+ * @brief Get region by index
+ * @retval heap_region_t* NULL if index is out of range
+ */
+heap_region_t* heap_region_get(unsigned index);
+
+/**
+ * @brief Find region containing a pointer
+ * @retval heap_region_t* NULL if pointer belongs to main heap
+ */
+heap_region_t* heap_region_from_ptr(const void* ptr);
+
+void* heap_region_malloc(heap_region_t* region, size_t size);
+void* heap_region_calloc(heap_region_t* region, size_t count, size_t size);
+void* heap_region_realloc(heap_region_t* region, void* ptr, size_t size);
+
+/**
+ * @brief Free memory allocated from a region
+ * @note `free()` calls this automatically for region memory
+ */
+void heap_region_free(heap_region_t* region, void* ptr);
+
+bool heap_region_get_info(heap_region_t* region, heap_region_info_t* info);
+
+/**
+ * @brief Direct subsequent `malloc()` calls to a region
+ * @param region NULL to use main heap
+ * @retval heap_region_t* The previous selection, to be restored afterwards
+ * @note Selection is global, so applies to any allocations made by interrupt handlers.
+ * Do not select a region created with HEAP_REGION_FLAG_32BIT.
+ */
+heap_region_t* heap_region_select(heap_region_t* region);
+
+/**
+ * @brief Set the region used by a subsystem
+ * @param client
+ * @param region NULL for main heap
+ */
+void heap_region_set_policy(heap_client_t client, heap_region_t* region);
+
+heap_region_t* heap_region_get_policy(heap_client_t client);
+
+/**
+ * @brief Get region currently selected for `malloc()`
+ */
+heap_region_t* heap_region_selected(void);
+
+uint32_t heap_region_get_flags(heap_region_t* region);
+
+#ifdef __cplusplus
+}
+
+/**
+ * @brief Direct allocations to a region whilst in scope
+ */
+class HeapRegionScope
+{
+public:
+	HeapRegionScope(heap_region_t* region) : previous(heap_region_select(region))
+	{
+	}
+
+	HeapRegionScope(heap_client_t client) : HeapRegionScope(heap_region_get_policy(client))
+	{
+	}
+
+	~HeapRegionScope()
+	{
+		heap_region_select(previous);
+	}
+
+private:
+	heap_region_t* previous;
+};
+
+#endif
@@ -54,6 +54,21 @@ uint32_t flashmem_get_address(const void* memptr)
 	return addr;
 }
 
+const void* flashmem_get_pointer(uint32_t addr, uint32_t size)
+{
+	// One 1MB bank is mapped, starting at INTERNAL_FLASH_START_ADDRESS
+	uint32_t base = flashmem_get_address((const void*)INTERNAL_FLASH_START_ADDRESS);
+	if(addr < base || addr + size < addr || addr + size > base + 0x100000U) {
+		return NULL;
+	}
+	return (const void*)(INTERNAL_FLASH_START_ADDRESS + addr - base);
+}
+
+void flashmem_release_pointer(const void* ptr)
+{
+	(void)ptr;
+}
+
 uint32_t flashmem_write(const void* from, uint32_t toaddr, uint32_t size)
 {
 	if(IS_ALIGNED(from) && IS_ALIGNED(toaddr) && IS_ALIGNED(size))
@@ -0,0 +1,62 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/SmingHub/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * AdcSampler.cpp - Timer-driven sampling for the ESP8266
+ *
+ * There is no DMA path to the SAR ADC, so one sample is taken per timer interrupt.
+ * Timer1 is shared with HardwareTimer, PWM, Servo, etc. so these cannot be used at the same time.
+ *
+ ****/
+
+#include <AdcSampler.h>
+#include <Digital.h>
+#include <driver/hw_timer.h>
+
+namespace
+{
+unsigned sampleIndex;
+uint8_t blockIndex;
+} // namespace
+
+bool AdcSampler::hardwareBegin(uint16_t pin)
+{
+	if(pin != A0) {
+		return false;
+	}
+
+	uint32_t interval = HW_TIMER_BASE_CLK / sampleRate;
+	if(interval < MIN_HW_TIMER1_INTERVAL_US * (HW_TIMER_BASE_CLK / 1000000U)) {
+		return false;
+	}
+	sampleRate = HW_TIMER_BASE_CLK / interval;
+
+	sampleIndex = 0;
+	blockIndex = 0;
+	hw_timer1_attach_interrupt(TIMER_FRC1_SOURCE, hardwareInterrupt, this);
+	hw_timer1_enable(TIMER_CLKDIV_1, TIMER_EDGE_INT, true);
+	hw_timer1_write(interval);
+	return true;
+}
+
+void AdcSampler::hardwareEnd()
+{
+	hw_timer1_disable();
+	hw_timer1_detach_interrupt();
+}
+
+void AdcSampler::hardwareInterrupt(void* param)
+{
+	auto sampler = static_cast<AdcSampler*>(param);
+	auto block = sampler->getBlock(blockIndex);
+	block[sampleIndex++] = system_adc_read();
+	if(sampleIndex < sampler->blockSize) {
+		return;
+	}
+
+	sampler->blockComplete(blockIndex);
+	sampleIndex = 0;
+	blockIndex ^= 1;
+}
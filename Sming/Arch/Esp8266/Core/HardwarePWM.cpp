@@ -107,6 +107,72 @@ bool HardwarePWM::setDutyChan(uint8_t chan, uint32_t duty, bool update)
 	}
 }
 
+/* Function Name: setDuties
+ * Description: This function is used to set the pwm duty cycle for several channels with a single update
+ * Parameters: duties - array of duty cycle values, starting at channel 0
+ *             count - number of values
+ */
+bool HardwarePWM::setDuties(const uint32_t* duties, uint8_t count)
+{
+	if(duties == nullptr || count > channel_count) {
+		return false;
+	}
+	for(uint8_t i = 0; i < count; i++) {
+		if(duties[i] > maxduty) {
+			debugf("Duty cycle value too high for current period.");
+			return false;
+		}
+	}
+	for(uint8_t i = 0; i < count; i++) {
+		pwm_set_duty(duties[i], i);
+	}
+	update();
+	return true;
+}
+
+/* Function Name: playSequence
+ * Description: This function is used to play back a precomputed sequence of duty cycles for all channels.
+ *              Each step is converted to a phase table up front, the driver switches tables at period boundaries.
+ */
+bool HardwarePWM::playSequence(const uint32_t* duties, uint16_t steps, uint16_t periodsPerStep, bool loop)
+{
+#if ENABLE_CUSTOM_PWM
+	if(duties == nullptr || steps == 0 || channel_count == 0) {
+		return false;
+	}
+	unsigned count = unsigned(steps) * channel_count;
+	for(unsigned i = 0; i < count; i++) {
+		if(duties[i] > maxduty) {
+			debugf("Duty cycle value too high for current period.");
+			return false;
+		}
+	}
+	return pwm_set_sequence(duties, steps, periodsPerStep, loop);
+#else
+	(void)duties;
+	(void)steps;
+	(void)periodsPerStep;
+	(void)loop;
+	return false;
+#endif
+}
+
+void HardwarePWM::stopSequence()
+{
+#if ENABLE_CUSTOM_PWM
+	pwm_stop_sequence();
+#endif
+}
+
+bool HardwarePWM::isSequenceRunning()
+{
+#if ENABLE_CUSTOM_PWM
+	return pwm_sequence_running();
+#else
+	return false;
+#endif
+}
+
 /* Function Name: getPeriod
  * Description: This function is used to get Period of PWM.
  *				Period / frequency will remain same for all pins.
@@ -12,6 +12,7 @@
 #include <Digital.h>
 #include <Platform/System.h>
 #include <BitManipulations.h>
+#include <Services/Profiling/InterruptTiming.h>
 
 constexpr unsigned MAX_INTERRUPTS = 16;
 
@@ -47,7 +48,7 @@ static void IRAM_ATTR interruptHandler(uint32 intr_mask, void* arg)
 			GPIO_REG_WRITE(GPIO_STATUS_W1TC_ADDRESS, _BV(i));
 
 			if(gpioInterruptsList[i]) {
-				gpioInterruptsList[i]();
+				Profiling::InterruptTiming::callHandler(i, gpioInterruptsList[i]);
 			} else if(delegateFunctionList[i]) {
 				System.queueCallback(interruptDelegateCallback, i);
 			}
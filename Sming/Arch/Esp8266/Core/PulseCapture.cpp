@@ -0,0 +1,44 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/SmingHub/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * PulseCapture.cpp - Edge capture for the ESP8266
+ *
+ * Edges are timestamped by a GPIO interrupt using the CPU cycle counter, which is read in a single instruction.
+ * Conversion to microseconds happens in task context. Pulses longer than 2^32 CPU cycles
+ * (26 seconds at 160MHz) wrap around, and the CPU frequency must not be changed whilst capturing.
+ *
+ ****/
+
+#include <PulseCapture.h>
+#include <Digital.h>
+#include <esp_clk.h>
+#include <espinc/eagle_soc.h>
+#include <espinc/gpio_register.h>
+
+bool PulseCapture::hardwareBegin()
+{
+	// GPIO16 doesn't support interrupts
+	if(pin >= 16) {
+		return false;
+	}
+
+	ticksPerUs = system_get_cpu_freq();
+	lastLevel = digitalRead(pin);
+	lastTime = esp_get_ccount();
+	return attachEdgeInterrupt();
+}
+
+void PulseCapture::hardwareEnd()
+{
+	detachEdgeInterrupt();
+}
+
+void PulseCapture::hardwareInterrupt(PulseCapture& capture)
+{
+	auto time = esp_get_ccount();
+	uint8_t level = (GPIO_REG_READ(GPIO_IN_ADDRESS) >> capture.pin) & 1;
+	capture.edgeCaptured(time, level);
+}
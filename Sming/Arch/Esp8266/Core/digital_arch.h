@@ -0,0 +1,53 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/SmingHub/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * digital_arch.h - Port-level GPIO access
+ *
+ * GPIO0-15 use the set/clear registers. GPIO16 is in the RTC block with its own output register.
+ *
+ ****/
+
+#pragma once
+
+#include "esp8266_peri.h"
+
+__forceinline void IRAM_ATTR digitalSetMask(uint32_t mask)
+{
+	GPOS = mask & 0xffff;
+	if(mask & BIT(16)) {
+		GP16O |= 1;
+	}
+}
+
+__forceinline void IRAM_ATTR digitalClearMask(uint32_t mask)
+{
+	GPOC = mask & 0xffff;
+	if(mask & BIT(16)) {
+		GP16O &= ~1;
+	}
+}
+
+__forceinline void IRAM_ATTR digitalToggleMask(uint32_t mask)
+{
+	// No toggle register, so this is read-modify-write
+	GPO ^= mask & 0xffff;
+	if(mask & BIT(16)) {
+		GP16O ^= 1;
+	}
+}
+
+__forceinline void IRAM_ATTR digitalWriteMask(uint32_t mask, uint32_t value)
+{
+	GPO = (GPO & ~mask) | (value & mask & 0xffff);
+	if(mask & BIT(16)) {
+		GP16O = (GP16O & ~1) | ((value >> 16) & 1);
+	}
+}
+
+__forceinline uint32_t IRAM_ATTR digitalReadPort()
+{
+	return (GPI & 0xffff) | ((GP16I & 1) << 16);
+}
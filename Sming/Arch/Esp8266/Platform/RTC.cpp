@@ -10,11 +10,12 @@
 
 #include <Platform/RTC.h>
 #include <esp_systemapi.h>
+#include <esp_rtc_map.h>
 
 RtcClass RTC;
 
 #define RTC_MAGIC 0x55aaaa55
-#define RTC_DES_ADDR 64 + 3 ///< rBoot may require 3 words at start
+#define RTC_DES_ADDR RTC_MAP_CLOCK_ADDR
 #define NS_PER_SECOND 1000000000
 
 /** @brief  Structure to hold RTC data
@@ -26,6 +27,8 @@ struct RtcData {
 	uint32_t cycles; ///< Quantity of RTC cycles since last update
 };
 
+static_assert(sizeof(RtcData) <= RTC_MAP_CLOCK_SIZE * 4, "RtcData too large for RTC map");
+
 static bool hardwareReset;
 static bool saveTime(RtcData& data);
 static void updateTime(RtcData& data);
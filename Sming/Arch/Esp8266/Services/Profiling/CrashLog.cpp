@@ -0,0 +1,70 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/SmingHub/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * CrashLog.cpp
+ *
+ */
+
+#include <Services/Profiling/CrashLog.h>
+#include <gdbstub/exceptions.h>
+#include <FlashString/Vector.hpp>
+#include <esp_rtc_map.h>
+
+static_assert(CRASH_LOG_RTC_ADDR >= RTC_MAP_SSL_SESSION_ADDR &&
+				  CRASH_LOG_RTC_ADDR + sizeof(Profiling::CrashLog::Record) / 4 <= RTC_USER_MEM_END,
+			  "CRASH_LOG_RTC_ADDR out of range");
+
+namespace Profiling
+{
+namespace CrashLog
+{
+namespace
+{
+#define XX(ex, sig, desc) DEFINE_FSTR_LOCAL(cause_##ex, desc)
+SYSTEM_EXCEPTION_MAP(XX)
+#undef XX
+
+#define XX(ex, sig, desc) &cause_##ex,
+DEFINE_FSTR_VECTOR_LOCAL(causeNames, FlashString, SYSTEM_EXCEPTION_MAP(XX))
+#undef XX
+
+} // namespace
+
+bool readRecord(Record& rec)
+{
+	return system_rtc_mem_read(CRASH_LOG_RTC_ADDR, &rec, sizeof(rec));
+}
+
+bool writeRecord(const Record& rec)
+{
+	return system_rtc_mem_write(CRASH_LOG_RTC_ADDR, &rec, sizeof(rec));
+}
+
+String getReasonName(uint32_t reason)
+{
+	switch(reason) {
+	case REASON_WDT_RST:
+		return F("Hardware Watchdog Reset");
+	case REASON_EXCEPTION_RST:
+		return F("Exception Reset");
+	case REASON_SOFT_WDT_RST:
+		return F("Software Watchdog Reset");
+	default:
+		return String(F("Reset ")) + reason;
+	}
+}
+
+String getCauseName(uint32_t cause)
+{
+	String s = causeNames[cause];
+	if(s.length() == 0) {
+		s = F("Unknown");
+	}
+	return s;
+}
+
+} // namespace CrashLog
+} // namespace Profiling
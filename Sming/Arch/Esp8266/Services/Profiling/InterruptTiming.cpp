@@ -0,0 +1,68 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/SmingHub/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * InterruptTiming.cpp
+ *
+ */
+
+#include <Services/Profiling/InterruptTiming.h>
+#include <esp_clk.h>
+
+#if ENABLE_INTERRUPT_TIMING
+
+namespace
+{
+uint32_t maskStart;
+uint32_t maskAddress; ///< Zero when not timing
+
+// Interrupts were enabled at this level
+__forceinline bool isEnabledLevel(uint32_t level)
+{
+	return (level & 0x0f) == 0;
+}
+
+/*
+ * Must be called with interrupts disabled
+ */
+void IRAM_ATTR endMasked()
+{
+	if(maskAddress != 0) {
+		Profiling::InterruptTiming::recordMasked(maskAddress, esp_get_ccount() - maskStart);
+		maskAddress = 0;
+	}
+}
+
+} // namespace
+
+/*
+ * Not inlined, so the return address identifies the caller of noInterrupts()
+ */
+extern "C" uint32_t IRAM_ATTR __noinline irq_timing_disable()
+{
+	uint32_t level = XTOS_SET_INTLEVEL(15);
+	if(isEnabledLevel(level)) {
+		maskAddress = uint32_t(__builtin_return_address(0));
+		maskStart = esp_get_ccount();
+	}
+	return level;
+}
+
+extern "C" void IRAM_ATTR irq_timing_enable()
+{
+	XTOS_SET_INTLEVEL(15);
+	endMasked();
+	XTOS_SET_INTLEVEL(0);
+}
+
+extern "C" void IRAM_ATTR irq_timing_restore(uint32_t level)
+{
+	if(isEnabledLevel(level)) {
+		endMasked();
+	}
+	XTOS_RESTORE_INTLEVEL(level);
+}
+
+#endif
@@ -0,0 +1,51 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/SmingHub/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * PcSampler.cpp
+ *
+ */
+
+#include <Services/Profiling/PcSampler.h>
+#include <driver/hw_timer.h>
+#include <algorithm>
+
+namespace Profiling
+{
+namespace PcSampler
+{
+namespace
+{
+constexpr uint32_t ticksPerUs{HW_TIMER_BASE_CLK / 16 / 1000000};
+
+/*
+ * The NMI is taken at level 3, so EPC3 holds the interrupted program counter.
+ */
+void IRAM_ATTR sampleHandler(void*)
+{
+	uint32_t pc;
+	__asm__ volatile("rsr %0, epc3" : "=a"(pc));
+	record(pc);
+}
+
+} // namespace
+
+bool startTimer(unsigned intervalUs)
+{
+	uint32_t ticks = std::max(intervalUs, MIN_HW_TIMER1_INTERVAL_US) * ticksPerUs;
+	ticks = std::min(ticks, uint32_t(MAX_HW_TIMER1_INTERVAL));
+	hw_timer1_attach_interrupt(TIMER_NMI_SOURCE, sampleHandler, nullptr);
+	hw_timer1_enable(TIMER_CLKDIV_16, TIMER_EDGE_INT, true);
+	hw_timer1_write(ticks);
+	return true;
+}
+
+void stopTimer()
+{
+	hw_timer1_detach_interrupt();
+}
+
+} // namespace PcSampler
+} // namespace Profiling
@@ -0,0 +1,31 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/SmingHub/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * StackUsage.cpp
+ *
+ */
+
+#include <Services/Profiling/StackUsage.h>
+
+/*
+ * The system stack occupies the top of the ETS system data area, above data used by the ROM
+ */
+#define SYS_STACK_BOTTOM 0x3FFFEB30
+#define SYS_STACK_TOP 0x3FFFFFB0
+
+namespace Profiling
+{
+namespace StackUsage
+{
+bool getBounds(Bounds& bounds)
+{
+	bounds.bottom = SYS_STACK_BOTTOM;
+	bounds.top = SYS_STACK_TOP;
+	return true;
+}
+
+} // namespace StackUsage
+} // namespace Profiling
@@ -9,6 +9,8 @@
  */
 
 #include <Services/Profiling/TaskStat.h>
+#include <Services/Profiling/CallbackTiming.h>
+#include <Services/Profiling/StackUsage.h>
 
 namespace Profiling
 {
@@ -25,8 +27,18 @@ TaskStat::~TaskStat()
 
 bool TaskStat::update()
 {
+#if ENABLE_TASK_TIMING
+	// The Sming task queue is the only 'task', so report time spent in each callback
+	CallbackTiming::printTo(out);
+	CallbackTiming::startWindow();
+#if ENABLE_STACK_USAGE
+	StackUsage::printTo(out);
+#endif
+	return true;
+#else
 	out.println("[TaskStat] Not Implemented");
 	return false;
+#endif
 }
 
 } // namespace Profiling
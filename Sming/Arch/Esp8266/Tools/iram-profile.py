@@ -0,0 +1,129 @@
+#!/usr/bin/env python3
+#
+# Generate a linker fragment placing the most frequently sampled flash functions into IRAM
+#
+# Input is a serial log containing output from Profiling::PcSampler::printReport().
+# Sample addresses are mapped to functions using the symbol table from the application ELF file.
+#
+# Functions are selected in order of sample count until the byte budget is used.
+# The fragment is included by common.ld within the IRAM .text output section,
+# so takes effect the next time the application is linked.
+#
+
+import argparse
+import re
+import subprocess
+import sys
+from bisect import bisect_right
+
+FLASH_START = 0x40200000
+FLASH_END = 0x40300000
+
+BEGIN_MARKER = '--- PC SAMPLES BEGIN ---'
+END_MARKER = '--- PC SAMPLES END ---'
+
+
+def read_samples(filename):
+    """Return dictionary of {pc: count} from the last complete report in a log"""
+    samples = None
+    current = None
+    with open(filename, 'r', errors='replace') as f:
+        for line in f:
+            line = line.strip()
+            if BEGIN_MARKER in line:
+                current = {}
+                continue
+            if END_MARKER in line:
+                if current is not None:
+                    samples = current
+                current = None
+                continue
+            if current is None:
+                continue
+            m = re.match(r'0x([0-9a-fA-F]+)\s+(\d+)', line)
+            if m:
+                pc = int(m[1], 16)
+                current[pc] = current.get(pc, 0) + int(m[2])
+    return samples
+
+
+def read_functions(nm, elf_file):
+    """Return list of (address, size, name) for functions located in flash, sorted by address"""
+    output = subprocess.check_output([nm, '-S', '-n', '--defined-only', elf_file]).decode()
+    functions = []
+    for line in output.splitlines():
+        fields = line.split()
+        if len(fields) != 4 or fields[2] not in 'tTwW':
+            continue
+        addr, size = int(fields[0], 16), int(fields[1], 16)
+        if FLASH_START <= addr < FLASH_END and size != 0:
+            functions.append((addr, size, fields[3]))
+    return functions
+
+
+def map_samples(samples, functions):
+    """Return list of [name, size, count] sorted by descending count, and the number of unmatched samples"""
+    addresses = [f[0] for f in functions]
+    counts = {}
+    unmatched = 0
+    for pc, count in samples.items():
+        i = bisect_right(addresses, pc) - 1
+        if i < 0 or pc >= functions[i][0] + functions[i][1]:
+            unmatched += count
+            continue
+        addr, size, name = functions[i]
+        entry = counts.setdefault(name, [name, size, 0])
+        entry[2] += count
+    return sorted(counts.values(), key=lambda e: e[2], reverse=True), unmatched
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Sming IRAM profile generator')
+    parser.add_argument('--nm', default='xtensa-lx106-elf-nm', help='Path to nm tool')
+    parser.add_argument('--budget', type=int, default=2048, help='Maximum bytes of code to move into IRAM')
+    parser.add_argument('--max-functions', type=int, default=0, help='Maximum number of functions to move')
+    parser.add_argument('--min-samples', type=int, default=2, help='Ignore functions with fewer samples')
+    parser.add_argument('elf', help='Application ELF file')
+    parser.add_argument('capture', help='Log file containing sampler report')
+    parser.add_argument('output', help='Linker fragment to write')
+    args = parser.parse_args()
+
+    samples = read_samples(args.capture)
+    if samples is None:
+        sys.exit("No complete sample report found in '%s'" % args.capture)
+
+    functions = read_functions(args.nm, args.elf)
+    ranked, unmatched = map_samples(samples, functions)
+    total = sum(samples.values())
+
+    selected = []
+    used = 0
+    for name, size, count in ranked:
+        if count < args.min_samples:
+            break
+        if args.max_functions and len(selected) >= args.max_functions:
+            break
+        # Allow for alignment padding
+        size = (size + 3) & ~3
+        if used + size > args.budget:
+            continue
+        selected.append((name, size, count))
+        used += size
+
+    with open(args.output, 'w') as f:
+        f.write('/*\n')
+        f.write(' * Generated by iram-profile.py from %s\n' % args.capture)
+        f.write(' * %u flash samples, %u functions selected using %u of %u bytes\n' %
+                (total, len(selected), used, args.budget))
+        f.write(' */\n')
+        for name, size, count in selected:
+            f.write('*(.literal.%s .text.%s) /* %u samples, %u bytes */\n' % (name, name, count, size))
+
+    print('%u flash samples (%u unmatched), %u functions selected using %u of %u bytes' %
+          (total, unmatched, len(selected), used, args.budget))
+    for name, size, count in selected:
+        print('  %6u %5.1f%% %6u %s' % (count, 100 * count / total if total else 0, size, name))
+
+
+if __name__ == '__main__':
+    main()
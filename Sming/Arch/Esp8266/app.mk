@@ -51,6 +51,24 @@ $(TARGET_OUT_0): $(COMPONENTS_AR) $(LIBMAIN_DST)
 $(TARGET_OUT_1): $(COMPONENTS_AR) $(LIBMAIN_DST)
 	$(call LinkTarget,$(RBOOT_LD_1))
 
+# Relink when IRAM profile is regenerated
+ifneq (,$(IRAM_PROFILE_DIR))
+$(TARGET_OUT_0) $(TARGET_OUT_1): $(IRAM_PROFILE_SRC)
+endif
+
+
+##@Tools
+
+.PHONY: iram-profile
+iram-profile: ##Generate IRAM linker fragment from sampler output in IRAM_PROFILE_CAPTURE and write to IRAM_PROFILE
+	$(Q) if [ -z "$(IRAM_PROFILE_CAPTURE)" ] || [ -z "$(IRAM_PROFILE)" ]; then \
+		echo "Please set IRAM_PROFILE_CAPTURE and IRAM_PROFILE"; \
+		exit 1; \
+	fi
+	$(Q) $(PYTHON) $(ARCH_TOOLS)/iram-profile.py --nm $(NM)$(TOOL_EXT) --budget $(IRAM_PROFILE_BUDGET) \
+		$(TARGET_OUT_0) $(call AbsoluteSourcePath,$(PROJECT_DIR),$(IRAM_PROFILE_CAPTURE)) \
+		$(call AbsoluteSourcePath,$(PROJECT_DIR),$(IRAM_PROFILE))
+
 
 ##@Flashing
 
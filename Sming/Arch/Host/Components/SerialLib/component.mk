@@ -2,3 +2,5 @@ COMPONENT_SUBMODULES	+= seriallib
 
 COMPONENT_SRCDIRS := seriallib/lib
 COMPONENT_INCDIRS := .
+
+COMPONENT_CPPFLAGS	+= $(HOST_CYCLE_MODEL_EXCLUDE)
@@ -29,3 +29,5 @@ override CLI_TARGET_OPTIONS += $(HOST_UART_OPTIONS)
 define RunHostTerminal
 $(call DetachCommand,telnet localhost $$(($(HOST_UART_PORTBASE) + $1)))
 endef
+
+COMPONENT_CPPFLAGS	+= $(HOST_CYCLE_MODEL_EXCLUDE)
@@ -99,6 +99,22 @@ public:
 		}
 	}
 
+	int64_t due()
+	{
+		if(state != running) {
+			return -1;
+		}
+		auto elapsed = now() - start_time;
+		return (elapsed >= interval) ? 0 : interval - elapsed;
+	}
+
+	void clock_changed()
+	{
+		if(state == running) {
+			sem.post();
+		}
+	}
+
 	uint32_t read()
 	{
 		auto elapsed = now() - start_time;
@@ -157,9 +173,11 @@ void* CTimerThread::thread_routine()
 		 * @todo Determine this value by asking OS
 		 */
 		const unsigned SCHED_MIN = 1500;
-		if(interval > SCHED_MIN) {
-			if(sem.timedwait(interval - SCHED_MIN)) {
-				continue; // state changed
+		auto remaining = due();
+		auto wait = (remaining > 0) ? host_clock_get_real_interval(remaining * 1000) / 1000 : 0;
+		if(wait > SCHED_MIN) {
+			if(sem.timedwait(wait - SCHED_MIN)) {
+				continue; // state or clock changed
 			}
 			if(errno != ETIMEDOUT) {
 				host_debug_w("Timer thread errno = %u", errno);
@@ -174,7 +192,7 @@ void* CTimerThread::thread_routine()
 			//
 		}
 
-		if(state != running) {
+		if(state != running || due() != 0) {
 			continue;
 		}
 
@@ -246,6 +264,18 @@ uint32_t hw_timer1_read()
 	return timer1->read();
 }
 
+int64_t host_hw_timer1_due()
+{
+	return timer1 ? timer1->due() : -1;
+}
+
+void host_hw_timer1_clock_changed()
+{
+	if(timer1) {
+		timer1->clock_changed();
+	}
+}
+
 uint32_t hw_timer2_read()
 {
 	using R = std::ratio<HW_TIMER2_CLK, 1000000000ULL>;
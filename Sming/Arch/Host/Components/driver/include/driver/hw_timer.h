@@ -83,6 +83,17 @@ void hw_timer_init(void);
 
 void hw_timer_cleanup();
 
+/**
+ * @brief Get time until timer 1 is next due
+ * @retval int64_t Microseconds, -1 if timer isn't running
+ */
+int64_t host_hw_timer1_due(void);
+
+/**
+ * @brief Notify timer thread that the clock has been advanced
+ */
+void host_hw_timer1_clock_changed(void);
+
 #ifdef __cplusplus
 }
 #endif
@@ -187,6 +187,14 @@ size_t smg_uart_write(smg_uart_t* uart, const void* buffer, size_t size)
 	return written;
 }
 
+bool smg_uart_write_desc(smg_uart_t* uart, smg_uart_tx_desc_t* desc)
+{
+	// Not implemented: HardwareSerial falls back to smg_uart_write()
+	(void)uart;
+	(void)desc;
+	return false;
+}
+
 size_t smg_uart_tx_free(smg_uart_t* uart)
 {
 	if(!smg_uart_tx_enabled(uart)) {
@@ -367,6 +375,14 @@ bool smg_uart_intr_config(smg_uart_t* uart, const smg_uart_intr_config_t* config
 	return false;
 }
 
+bool smg_uart_set_rx_timeout(smg_uart_t* uart, uint8_t chars)
+{
+	// Timeout is signalled whenever received data has been handled
+	(void)uart;
+	(void)chars;
+	return false;
+}
+
 void smg_uart_swap(smg_uart_t* uart, int tx_pin)
 {
 	(void)uart;
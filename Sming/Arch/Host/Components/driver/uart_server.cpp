@@ -174,7 +174,7 @@ void startup(const Config& config)
 		} else {
 			server.reset(new CUartDevice(i, devname, config.baud[i]));
 		}
-		server->execute();
+		server->start();
 	}
 
 	// Redirect port 0 to console if not otherwise enabled
@@ -201,13 +201,12 @@ void shutdown()
 
 /* CUart */
 
-CUart::CUart(unsigned uart_nr) : CThread("uart", 1), uart_nr(uart_nr)
+CUart::CUart(unsigned uart_nr) : uart_nr(uart_nr)
 {
 }
 
 void CUart::terminate()
 {
-	join();
 	host_debug_i("UART%u server destroyed", uart_nr);
 }
 
@@ -225,7 +224,7 @@ void CUart::onNotify(smg_uart_t* uart, smg_uart_notify_code_t code)
 	case UART_NOTIFY_AFTER_WRITE: {
 		if(this->uart != nullptr) {
 			// Kick the thread to send now
-			txsem.post();
+			kick();
 		} else {
 			// Not connected, discard data
 			uart->tx_buffer->clear();
@@ -250,7 +249,8 @@ int CUart::serviceRead()
 		return avail;
 	}
 
-	interrupt_begin();
+	auto& thread = this->thread();
+	thread.interrupt_begin();
 
 	int space = uart->rx_buffer->getFreeSpace();
 	if(space < avail) {
@@ -273,7 +273,7 @@ int CUart::serviceRead()
 		}
 	}
 
-	interrupt_end();
+	thread.interrupt_end();
 
 	return read;
 }
@@ -292,7 +292,8 @@ int CUart::serviceWrite()
 		return 0;
 	}
 
-	interrupt_begin();
+	auto& thread = this->thread();
+	thread.interrupt_begin();
 
 	do {
 		int sent = writeBytes(data, avail);
@@ -308,26 +309,80 @@ int CUart::serviceWrite()
 	if(txbuf->isEmpty()) {
 		uart->status |= UART_TXFIFO_EMPTY_INT_ST;
 	} else {
-		txsem.post();
+		kick();
 	}
 
-	interrupt_end();
+	thread.interrupt_end();
 
 	return result;
 }
 
+void CUart::serviceInterrupt()
+{
+	if(uart == nullptr) {
+		return;
+	}
+
+	auto& thread = this->thread();
+	thread.interrupt_begin();
+
+	auto status = uart->status;
+	uart->status = 0;
+	if(status != 0 && uart->callback != nullptr) {
+		uart->callback(uart, status);
+	}
+
+	thread.interrupt_end();
+}
+
 /* CUartPort */
 
 CUartPort::CUartPort(unsigned uart_nr) : CUart(uart_nr)
 {
 }
 
+bool CUartPort::start()
+{
+	auto port = portBase + uart_nr;
+	CSockAddr addr(nullptr, port);
+	if(!listen(addr, 1)) {
+		host_debug_e("Listen %s failed", addr.text().c_str());
+		return false;
+	}
+
+	if(!host_poller().add(m_fd, POLL_EVENT_READ, this)) {
+		return false;
+	}
+
+	host_debug_i("UART%u server listening on port %u", uart_nr, port);
+	return true;
+}
+
 void CUartPort::terminate()
 {
+	auto& poller = host_poller();
+	if(socket != nullptr) {
+		poller.remove(socket->fd());
+		socket = nullptr;
+	}
+	poller.remove(m_fd);
 	close();
 	CUart::terminate();
 }
 
+void CUartPort::onNotify(smg_uart_t* uart, smg_uart_notify_code_t code)
+{
+	CUart::onNotify(uart, code);
+	if(code == UART_NOTIFY_BEFORE_READ && rxPaused) {
+		kick();
+	}
+}
+
+void CUartPort::kick()
+{
+	host_poller().kick(this);
+}
+
 int CUartPort::available()
 {
 	return socket ? socket->available() : 0;
@@ -343,61 +398,81 @@ int CUartPort::writeBytes(const void* data, size_t size)
 	return socket ? socket->send(data, size) : 0;
 }
 
-void* CUartPort::thread_routine()
+void CUartPort::closeClient(CPoller& poller)
 {
-	auto port = portBase + uart_nr;
-	CSockAddr addr(nullptr, port);
-	if(!listen(addr, 1)) {
-		host_debug_e("Listen %s failed", addr.text().c_str());
-		return nullptr;
-	}
-
-	host_debug_i("UART%u server listening on port %u", uart_nr, port);
+	poller.remove(socket->fd());
+	socket->close();
+	socket = nullptr;
+	rxPaused = false;
+	host_debug_i("Uart #%u socket closed", uart_nr);
+
+	// Accept next connection
+	poller.modify(m_fd, POLL_EVENT_READ);
+}
 
-	while(active()) {
+void CUartPort::onPoll(CPoller& poller, int fd, unsigned events)
+{
+	if(fd == m_fd) {
 		socket = try_connect();
 		if(socket == nullptr) {
-			msleep(300);
-			continue;
+			return;
 		}
 
 		host_debug_i("Uart #%u socket open", uart_nr);
 
-		while(socket->active()) {
-			if(txsem.timedwait(IDLE_SLEEP_MS * 1000)) {
-				if(serviceWrite() < 0) {
-					break;
-				}
-			}
-
-			if(serviceRead() < 0) {
-				break;
-			}
+		// One client at a time
+		poller.modify(m_fd, 0);
+		poller.add(socket->fd(), POLL_EVENT_READ, this);
 
-			if(uart != nullptr) {
-				interrupt_begin();
+		// Send anything output before client connected
+		if(serviceWrite() < 0) {
+			closeClient(poller);
+			return;
+		}
+		serviceInterrupt();
+		return;
+	}
 
-				auto status = uart->status;
-				uart->status = 0;
-				if(status != 0 && uart->callback != nullptr) {
-					uart->callback(uart, status);
-				}
+	if(socket == nullptr) {
+		return;
+	}
 
-				interrupt_end();
-			}
+	if(fd < 0) {
+		if(rxPaused) {
+			rxPaused = false;
+			poller.modify(socket->fd(), POLL_EVENT_READ);
+		}
+		if(serviceWrite() < 0) {
+			closeClient(poller);
+			return;
 		}
+	}
 
-		socket->close();
-		host_debug_i("Uart #%u socket closed", uart_nr);
+	if(events & POLL_EVENT_READ) {
+		// Readable with no data means client has disconnected
+		if(socket->available() <= 0) {
+			closeClient(poller);
+			return;
+		}
+		int res = serviceRead();
+		if(res < 0) {
+			closeClient(poller);
+			return;
+		}
+		if(res == 0) {
+			// Application isn't reading, stop polling until it does
+			rxPaused = true;
+			poller.modify(socket->fd(), 0);
+		}
 	}
 
-	return nullptr;
+	serviceInterrupt();
 }
 
 /* CUartDevice */
 
 CUartDevice::CUartDevice(unsigned uart_nr, const char* deviceName, unsigned baud_rate)
-	: CUart(uart_nr), deviceName(deviceName), baud_rate(baud_rate)
+	: CUart(uart_nr), CThread("uart", 1), deviceName(deviceName), baud_rate(baud_rate)
 {
 }
 
@@ -405,6 +480,7 @@ void CUartDevice::terminate()
 {
 	done = true;
 	txsem.post();
+	join();
 	CUart::terminate();
 }
 
@@ -474,17 +550,7 @@ void* CUartDevice::thread_routine()
 			break;
 		}
 
-		if(uart != nullptr) {
-			interrupt_begin();
-
-			auto status = uart->status;
-			uart->status = 0;
-			if(status != 0 && uart->callback != nullptr) {
-				uart->callback(uart, status);
-			}
-
-			interrupt_end();
-		}
+		serviceInterrupt();
 	}
 
 	device.reset();
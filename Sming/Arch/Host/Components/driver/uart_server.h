@@ -22,6 +22,7 @@
 #include <driver/uart.h>
 #include <hostlib/sockets.h>
 #include <hostlib/threads.h>
+#include <hostlib/poller.h>
 #include <memory>
 
 class SerialDevice;
@@ -51,72 +52,119 @@ void shutdown();
 /*
  * Base class for a UART
  *
- * Each server allocates a thread to handle one device.
  * If no client (i.e. application `uart`) is connected any output is discarded.
  *
  */
-class CUart : public CThread
+class CUart
 {
 public:
 	CUart(unsigned uart_nr);
 
+	virtual ~CUart()
+	{
+	}
+
+	virtual bool start() = 0;
+
 	virtual void terminate();
 
 	virtual void onNotify(smg_uart_t* uart, smg_uart_notify_code_t code);
 
 protected:
-	static const unsigned IDLE_SLEEP_MS{100};
+	/**
+	 * @brief Thread which services this UART and so raises its interrupts
+	 */
+	virtual CThread& thread() = 0;
+
+	/**
+	 * @brief Request servicing because there's data to be sent out
+	 */
+	virtual void kick() = 0;
 
 	virtual int available() = 0;
 	virtual int readBytes(void* buffer, size_t size) = 0;
 	virtual int writeBytes(const void* data, size_t size) = 0;
 	int serviceRead();
 	int serviceWrite();
+	void serviceInterrupt();
 
-	CSemaphore txsem;			///< Signals when there's data to be sent out
 	unsigned uart_nr;			///< Which port we represent
 	smg_uart_t* uart = nullptr; ///< On set if port is open by application
 };
 
 /*
  * UART implementation using TCP socket for communication, so we can use telnet as a terminal application.
+ *
+ * All ports are serviced by the shared poller thread.
  */
-class CUartPort : public CUart, public CServerSocket
+class CUartPort : public CUart, public CServerSocket, public CPollHandler
 {
 public:
 	CUartPort(unsigned uart_nr);
 
+	bool start() override;
 	void terminate() override;
 
+	void onNotify(smg_uart_t* uart, smg_uart_notify_code_t code) override;
+
 protected:
+	CThread& thread() override
+	{
+		return host_poller();
+	}
+
+	void kick() override;
 	int available() override;
 	int readBytes(void* buffer, size_t size) override;
 	int writeBytes(const void* data, size_t size) override;
-	void* thread_routine() override;
+	void onPoll(CPoller& poller, int fd, unsigned events) override;
+
+	void closeClient(CPoller& poller);
 
 	CSocket* socket{nullptr}; ///< Connected client
+	bool rxPaused{false};	  ///< Waiting for application to make space in receive buffer
 };
 
 /*
  * UART implementation using physical serial device on local machine
+ *
+ * Serial devices can't be waited on portably, so each has its own thread.
  */
-class CUartDevice : public CUart
+class CUartDevice : public CUart, public CThread
 {
 public:
 	static constexpr unsigned DEFAULT_BAUD{115200};
 
 	CUartDevice(unsigned uart_nr, const char* deviceName, unsigned baud);
 
+	bool start() override
+	{
+		return execute();
+	}
+
 	void terminate() override;
 
 	void onNotify(smg_uart_t* uart, smg_uart_notify_code_t code) override;
 
 protected:
+	static const unsigned IDLE_SLEEP_MS{100};
+
+	CThread& thread() override
+	{
+		return *this;
+	}
+
+	void kick() override
+	{
+		txsem.post();
+	}
+
 	int available() override;
 	int readBytes(void* buffer, size_t size) override;
 	int writeBytes(const void* data, size_t size) override;
 	void* thread_routine() override;
 
+	CSemaphore txsem;					  ///< Signals when there's data to be sent out
 	std::unique_ptr<SerialDevice> device; ///< Physical device
 	const char* deviceName{nullptr};	  ///< Physical device name
 	unsigned baud_rate{0};				  ///< Command-line override for baud rate
@@ -1,5 +1,6 @@
 #include "include/esp_clk.h"
 #include "include/esp_system.h"
+#include "include/host_cycle_model.h"
 
 // The current CPU frequency in MHz (ticks per us)
 static uint8_t cpu_frequency = SYS_CPU_80MHZ;
@@ -53,5 +54,9 @@ uint8 system_get_cpu_freq(void)
 
 uint32_t esp_get_ccount()
 {
+#if ENABLE_HOST_CYCLE_MODEL
+	return host_cycle_model_get_cycles();
+#else
 	return get_ccount(os_get_nanoseconds());
+#endif
 }
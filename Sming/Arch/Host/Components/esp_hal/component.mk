@@ -1,3 +1,25 @@
 COMPONENT_INCDIRS := include $(ESP8266_COMPONENTS)/esp8266/include
 
 COMPONENT_DEPENDS	:= hostlib
+
+COMPONENT_CPPFLAGS	+= $(HOST_CYCLE_MODEL_EXCLUDE)
+
+# Estimate target cycle counts
+COMPONENT_VARS			+= ENABLE_HOST_CYCLE_MODEL
+ENABLE_HOST_CYCLE_MODEL	?= 0
+
+# Cost model to apply
+COMPONENT_VARS			+= HOST_CYCLE_MODEL
+HOST_CYCLE_MODEL		?= esp8266
+
+ifeq ($(ENABLE_HOST_CYCLE_MODEL),1)
+GLOBAL_CFLAGS += \
+	-DENABLE_HOST_CYCLE_MODEL=1 \
+	-DHOST_CYCLE_MODEL=\"$(HOST_CYCLE_MODEL)\" \
+	-fsanitize-coverage=trace-pc \
+	-finstrument-functions
+ifneq ($(UNAME),Windows)
+# Function names are resolved using dladdr()
+EXTRA_LDFLAGS := -rdynamic
+endif
+endif
@@ -0,0 +1,327 @@
+/**
+ * cycle_model.cpp - Estimate target cycle counts from instrumented Host code
+ *
+ * This file is part of the Sming Framework Project
+ *
+ * This library is free software: you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation, version 3 or later.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this library.
+ * If not, see <https://www.gnu.org/licenses/>.
+ *
+ ****/
+
+#include "include/host_cycle_model.h"
+#include "include/esp_clk.h"
+#include <hostlib/threads.h>
+#include <atomic>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#if defined(__linux__)
+#include <dlfcn.h>
+#include <cxxabi.h>
+#endif
+
+#ifndef ENABLE_HOST_CYCLE_MODEL
+#define ENABLE_HOST_CYCLE_MODEL 0
+#endif
+
+#ifndef HOST_CYCLE_MODEL
+#define HOST_CYCLE_MODEL "esp8266"
+#endif
+
+#define NO_INSTRUMENT __attribute__((no_instrument_function))
+
+namespace
+{
+/*
+ * These are coarse averages intended to rank code paths, not predict exact timings.
+ * Flash penalty is in nanoseconds as flash speed doesn't change with CPU frequency.
+ */
+struct CostModel {
+	const char* name;
+	uint8_t blockCycles; ///< Average cost of a basic block
+	uint8_t callCycles;	 ///< Call, prologue, epilogue and return
+	uint8_t flashWaitNs; ///< Average cache refill penalty per block executed from flash
+};
+
+constexpr CostModel models[]{
+	{"esp8266", 5, 10, 25},
+	{"esp32", 4, 8, 12},
+	{"rp2040", 5, 8, 16},
+};
+
+constexpr bool matches(const char* a, const char* b)
+{
+	while(*a != '\0' && *a == *b) {
+		++a;
+		++b;
+	}
+	return *a == *b;
+}
+
+constexpr int findModel(const char* name)
+{
+	for(unsigned i = 0; i < ARRAY_SIZE(models); ++i) {
+		if(matches(models[i].name, name)) {
+			return i;
+		}
+	}
+	return -1;
+}
+
+static_assert(findModel(HOST_CYCLE_MODEL) >= 0, "Unknown HOST_CYCLE_MODEL");
+
+// Must be usable before static initialisation, instrumented constructors may run first
+constexpr const CostModel& model = models[findModel(HOST_CYCLE_MODEL)];
+
+struct FunctionStats {
+	uint64_t calls;
+	uint64_t cycles; ///< Excluding called functions
+	bool interrupt;	 ///< Called from interrupt context
+};
+
+using StatsMap = std::unordered_map<void*, FunctionStats>;
+
+struct ThreadState {
+	static constexpr unsigned maxDepth{256};
+
+	ThreadState();
+
+	StatsMap stats;
+	void* fn[maxDepth];
+	FunctionStats* entry[maxDepth]; ///< Map nodes are stable, so cache entry for each stack frame
+	unsigned depth{0};
+	bool busy{false}; ///< Guard against re-entry from code called by this module
+};
+
+std::atomic<uint64_t> totalCycles;
+std::atomic<uint64_t> idleCycles;
+CBasicMutex threadsMutex;
+std::vector<ThreadState*>* threads;
+thread_local ThreadState* state;
+
+/*
+ * Thread state is never freed so statistics remain available after threads have exited
+ */
+ThreadState::ThreadState()
+{
+	threadsMutex.lock();
+	if(threads == nullptr) {
+		threads = new std::vector<ThreadState*>;
+	}
+	threads->push_back(this);
+	threadsMutex.unlock();
+}
+
+NO_INSTRUMENT ThreadState& getState()
+{
+	if(state == nullptr) {
+		state = new ThreadState;
+	}
+	return *state;
+}
+
+#if defined(__linux__) && ENABLE_HOST_CYCLE_MODEL
+// Provided by linker for IRAM_ATTR section
+extern "C" char __start_host_iram[] __attribute__((weak));
+extern "C" char __stop_host_iram[] __attribute__((weak));
+
+NO_INSTRUMENT bool isIram(const void* addr)
+{
+	return addr >= __start_host_iram && addr < __stop_host_iram;
+}
+#else
+NO_INSTRUMENT bool isIram(const void*)
+{
+	return false;
+}
+#endif
+
+#if ENABLE_HOST_CYCLE_MODEL
+
+NO_INSTRUMENT unsigned flashWaitCycles()
+{
+	static uint8_t mhz;
+	static unsigned cycles;
+	auto freq = ets_get_cpu_frequency();
+	if(freq != mhz) {
+		mhz = freq;
+		cycles = (model.flashWaitNs * mhz + 500) / 1000;
+	}
+	return cycles;
+}
+
+NO_INSTRUMENT void addCycles(FunctionStats* stats, unsigned cycles)
+{
+	totalCycles.fetch_add(cycles, std::memory_order_relaxed);
+	if(stats != nullptr) {
+		stats->cycles += cycles;
+	}
+}
+
+#endif
+
+std::string getName(void* fn)
+{
+#if defined(__linux__)
+	Dl_info info;
+	if(dladdr(fn, &info) != 0 && info.dli_sname != nullptr) {
+		int status;
+		auto demangled = abi::__cxa_demangle(info.dli_sname, nullptr, nullptr, &status);
+		std::string name = (status == 0) ? demangled : info.dli_sname;
+		free(demangled);
+		return name;
+	}
+#endif
+	char buf[32];
+	sprintf(buf, "%p", fn);
+	return buf;
+}
+
+} // namespace
+
+extern "C" {
+
+#if ENABLE_HOST_CYCLE_MODEL
+
+NO_INSTRUMENT void __cyg_profile_func_enter(void* fn, void*)
+{
+	auto& st = getState();
+	if(st.busy) {
+		return;
+	}
+	st.busy = true;
+	auto& stats = st.stats[fn];
+	++stats.calls;
+	bool iram = isIram(fn);
+	if(!iram && CThread::is_interrupt_context()) {
+		stats.interrupt = true;
+	}
+	addCycles(&stats, model.callCycles + (iram ? 0 : flashWaitCycles()));
+	if(st.depth < ThreadState::maxDepth) {
+		st.fn[st.depth] = fn;
+		st.entry[st.depth] = &stats;
+	}
+	++st.depth;
+	st.busy = false;
+}
+
+NO_INSTRUMENT void __cyg_profile_func_exit(void* fn, void*)
+{
+	auto& st = getState();
+	if(st.busy || st.depth == 0) {
+		return;
+	}
+	if(st.depth > ThreadState::maxDepth) {
+		--st.depth;
+		return;
+	}
+	// Frames may be skipped by exceptions or longjmp
+	unsigned i = st.depth;
+	while(i > 0 && st.fn[i - 1] != fn) {
+		--i;
+	}
+	if(i != 0) {
+		st.depth = i - 1;
+	}
+}
+
+NO_INSTRUMENT void __sanitizer_cov_trace_pc()
+{
+	auto& st = getState();
+	if(st.busy) {
+		return;
+	}
+	auto pc = __builtin_return_address(0);
+	auto stats = (st.depth != 0 && st.depth <= ThreadState::maxDepth) ? st.entry[st.depth - 1] : nullptr;
+	addCycles(stats, model.blockCycles + (isIram(pc) ? 0 : flashWaitCycles()));
+}
+
+#endif // ENABLE_HOST_CYCLE_MODEL
+
+bool host_cycle_model_enabled()
+{
+	return ENABLE_HOST_CYCLE_MODEL;
+}
+
+const char* host_cycle_model_name()
+{
+	return model.name;
+}
+
+uint64_t host_cycle_model_get_cycles()
+{
+	return totalCycles + idleCycles;
+}
+
+void host_cycle_model_idle(uint64_t nanoseconds)
+{
+	idleCycles += nanoseconds * ets_get_cpu_frequency() / 1000;
+}
+
+void host_cycle_model_report()
+{
+	if(!ENABLE_HOST_CYCLE_MODEL) {
+		return;
+	}
+
+	auto& st = getState();
+	st.busy = true;
+
+	StatsMap all;
+	threadsMutex.lock();
+	for(auto thread : *threads) {
+		for(auto& e : thread->stats) {
+			auto& s = all[e.first];
+			s.calls += e.second.calls;
+			s.cycles += e.second.cycles;
+			s.interrupt |= e.second.interrupt;
+		}
+	}
+	threadsMutex.unlock();
+
+	std::vector<std::pair<void*, FunctionStats>> list(all.begin(), all.end());
+	std::sort(list.begin(), list.end(),
+			  [](const auto& a, const auto& b) { return a.second.cycles > b.second.cycles; });
+
+	uint64_t total = totalCycles;
+	auto mhz = ets_get_cpu_frequency();
+	host_printf("\r\nCycle model '%s' @ %u MHz: %llu cycles active (%llu us), %llu idle\r\n", model.name, mhz,
+				(unsigned long long)total, (unsigned long long)(total / mhz), (unsigned long long)idleCycles.load());
+
+	constexpr unsigned maxListed{20};
+	host_printf("%12s %14s %6s  %s\r\n", "Calls", "Cycles", "%", "Function");
+	for(unsigned i = 0; i < list.size() && i < maxListed; ++i) {
+		auto& e = list[i];
+		unsigned percent = total ? (e.second.cycles * 1000 / total) : 0;
+		host_printf("%12llu %14llu %4u.%u  %s%s\r\n", (unsigned long long)e.second.calls,
+					(unsigned long long)e.second.cycles, percent / 10, percent % 10, getName(e.first).c_str(),
+					isIram(e.first) ? " [IRAM]" : "");
+	}
+
+	bool header{false};
+	for(auto& e : list) {
+		if(!e.second.interrupt) {
+			continue;
+		}
+		if(!header) {
+			host_printf("\r\nFlash functions called from interrupt context, consider IRAM_ATTR:\r\n");
+			header = true;
+		}
+		host_printf("  %s\r\n", getName(e.first).c_str());
+	}
+
+	st.busy = false;
+}
+
+} // extern "C"
@@ -51,6 +51,29 @@ uint32_t system_get_time(void);
 /* Use nanosecond count as base for hardware and CPU cycle counting */
 uint64_t os_get_nanoseconds(void);
 
+/* Real time at startup, in microseconds since the epoch */
+extern uint64_t host_system_start_time;
+
+/**
+ * @brief Run emulated clock independently of real time
+ * @param speed Factor applied to real time elapsed
+ * @note The clock may also be advanced directly using `host_clock_advance()`
+ */
+void host_clock_enable_virtual(unsigned speed);
+
+bool host_clock_is_virtual(void);
+
+/**
+ * @brief Move virtual clock forward
+ * @note Does nothing if virtual clock isn't enabled
+ */
+void host_clock_advance(uint64_t nanos);
+
+/**
+ * @brief Get the real time corresponding to an interval of emulated time
+ */
+uint64_t host_clock_get_real_interval(uint64_t nanos);
+
 #define APB_CLK_FREQ 80000000U
 
 void os_delay_us(uint32_t us);
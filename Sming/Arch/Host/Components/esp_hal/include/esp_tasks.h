@@ -32,6 +32,9 @@ void host_init_tasks();
 // Hook function to process task queues
 void host_service_tasks();
 
+// Determine if any task queue has events waiting
+bool host_have_pending_tasks();
+
 typedef void (*host_task_callback_t)(uint32_t param);
 
 bool host_queue_callback(host_task_callback_t callback, uint32_t param);
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <c_types.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Estimated target cycle counting for Host builds with ENABLE_HOST_CYCLE_MODEL=1.
+ *
+ * Instrumented code reports every function call and basic block executed.
+ * Costs are applied according to the model selected by HOST_CYCLE_MODEL,
+ * with an additional flash wait state penalty for code not marked IRAM_ATTR.
+ */
+
+/**
+ * @brief Determine if the application was built with cycle model instrumentation
+ */
+bool host_cycle_model_enabled(void);
+
+/**
+ * @brief Get name of active cost model
+ */
+const char* host_cycle_model_name(void);
+
+/**
+ * @brief Get estimated target cycles executed, including idle time
+ *
+ * When the model is enabled, `esp_get_ccount()` returns the lower 32 bits of this value.
+ */
+uint64_t host_cycle_model_get_cycles(void);
+
+/**
+ * @brief Account for time the main thread spent waiting for work
+ *
+ * On the target this time would be spent idling, so it's counted at the current CPU frequency.
+ */
+void host_cycle_model_idle(uint64_t nanoseconds);
+
+/**
+ * @brief Print estimated cost of the most expensive functions, and
+ * list flash-resident functions which were called from interrupt context
+ */
+void host_cycle_model_report(void);
+
+#ifdef __cplusplus
+}
+#endif
@@ -3,6 +3,7 @@
 #include <hostlib/threads.h>
 #include <sys/time.h>
 #include <Platform/Timers.h>
+#include <atomic>
 
 /* System time */
 
@@ -15,6 +16,27 @@ static struct {
 #endif
 } timeref;
 
+/* Virtual clock */
+
+static struct {
+	std::atomic<int64_t> offset; ///< Nanoseconds added to scaled real time
+	unsigned speed{1};
+	bool enabled;
+} vclock;
+
+static uint64_t get_real_nanoseconds()
+{
+#ifdef __WIN32
+	LARGE_INTEGER count;
+	QueryPerformanceCounter(&count);
+	return timeref.countsPerNanosecond * uint64_t(count.QuadPart - timeref.startCount.QuadPart);
+#else
+	timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (1000000000ULL * ts.tv_sec) + ts.tv_nsec - timeref.startTicks;
+#endif
+}
+
 // Return base time in us
 static uint64_t initTime()
 {
@@ -24,7 +46,7 @@ static uint64_t initTime()
 	timeref.countsPerNanosecond.set(1000000000ULL, cps.QuadPart);
 	QueryPerformanceCounter(&timeref.startCount);
 #else
-	timeref.startTicks = os_get_nanoseconds();
+	timeref.startTicks = get_real_nanoseconds();
 #endif
 
 	timeval tv;
@@ -36,15 +58,40 @@ uint64_t host_system_start_time = initTime();
 
 uint64_t os_get_nanoseconds()
 {
-#ifdef __WIN32
-	LARGE_INTEGER count;
-	QueryPerformanceCounter(&count);
-	return timeref.countsPerNanosecond * uint64_t(count.QuadPart - timeref.startCount.QuadPart);
-#else
-	timespec ts;
-	clock_gettime(CLOCK_MONOTONIC, &ts);
-	return (1000000000ULL * ts.tv_sec) + ts.tv_nsec - timeref.startTicks;
-#endif
+	auto nanos = get_real_nanoseconds();
+	if(!vclock.enabled) {
+		return nanos;
+	}
+	return nanos * vclock.speed + vclock.offset;
+}
+
+void host_clock_enable_virtual(unsigned speed)
+{
+	if(speed == 0) {
+		speed = 1;
+	}
+	// Continue from the current time so the clock doesn't step
+	auto nanos = get_real_nanoseconds();
+	vclock.offset = int64_t(os_get_nanoseconds()) - int64_t(nanos * speed);
+	vclock.speed = speed;
+	vclock.enabled = true;
+}
+
+bool host_clock_is_virtual()
+{
+	return vclock.enabled;
+}
+
+void host_clock_advance(uint64_t nanos)
+{
+	if(vclock.enabled) {
+		vclock.offset += nanos;
+	}
+}
+
+uint64_t host_clock_get_real_interval(uint64_t nanos)
+{
+	return vclock.enabled ? nanos / vclock.speed : nanos;
 }
 
 uint32_t system_get_time()
@@ -28,6 +28,11 @@ public:
 		return !full;
 	}
 
+	bool isEmpty() const
+	{
+		return count == 0;
+	}
+
 	void process()
 	{
 		// Don't service any newly queued events
@@ -117,6 +122,16 @@ void host_service_tasks()
 	}
 }
 
+bool host_have_pending_tasks()
+{
+	for(auto queue : task_queues) {
+		if(queue != nullptr && !queue->isEmpty()) {
+			return true;
+		}
+	}
+	return false;
+}
+
 bool host_queue_callback(host_task_callback_t callback, uint32_t param)
 {
 	return task_queues[HOST_TASK_PRIO]->post(os_signal_t(callback), param);
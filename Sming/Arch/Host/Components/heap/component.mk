@@ -7,3 +7,5 @@ ifeq ($(ENABLE_MALLOC_COUNT),1)
 GLOBAL_CFLAGS			+= -DENABLE_MALLOC_COUNT
 COMPONENT_DEPENDS		:= malloc_count
 endif
+
+COMPONENT_CPPFLAGS	+= $(HOST_CYCLE_MODEL_EXCLUDE)
@@ -25,3 +25,5 @@ COMPONENT_DOXYGEN_INPUT := include/hostlib
 
 # Optional command line parameters passed to host application
 CACHE_VARS				+= HOST_PARAMETERS
+
+COMPONENT_CPPFLAGS	+= $(HOST_CYCLE_MODEL_EXCLUDE)
@@ -18,10 +18,13 @@
  ****/
 
 #include "include/hostlib/init.h"
+#include <Services/Profiling/BootTimeline.h>
 
 extern void init();
 
 void host_init()
 {
+	BOOT_PHASE_BEGIN(userInit);
 	init();
+	BOOT_PHASE_END(userInit);
 }
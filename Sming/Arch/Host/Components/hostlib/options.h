@@ -53,13 +53,23 @@
 	   nullptr)                                                                                                        \
 	XX(flashsize, required_argument, "Change default flash size if file doesn't exist", "SIZE",                        \
 	   "Size of flash in bytes (e.g. 512K, 524288, 0x80000)", nullptr)                                                 \
+	XX(flashmap, no_argument, "Memory-map flash backing file", nullptr, nullptr,                                       \
+	   "Faster, and writes can only clear bits as for real NOR flash\0")                                               \
+	XX(flashendurance, required_argument, "Fail flash sector erase after a number of cycles", "COUNT",                 \
+	   "Erase cycles per sector", nullptr)                                                                             \
+	XX(flashtiming, required_argument, "Simulate flash operation times", "READ,WRITE,ERASE",                           \
+	   "Microseconds per read, per 256-byte page write and per sector erase", "e.g. --flashtiming=20,700,45000\0")     \
 	XX(initonly, no_argument, "Initialise only, do not start Sming", nullptr, nullptr, nullptr)                        \
 	XX(loopcount, required_argument, "Run Sming loop a fixed number of times then exit", nullptr, nullptr,             \
 	   "Useful for running samples in CI\0")                                                                           \
 	XX(nonet, no_argument, "Skip network initialisation", nullptr, nullptr, nullptr)                                   \
 	XX(debug, required_argument, "Set debug verbosity", "LEVEL", "Maximum debug message level to print",               \
 	   "0 = errors only, 1 = +warnings, 2 = +info\0")                                                                  \
-	XX(cpulimit, required_argument, "Set CPU limit", "COUNT", "0 = no limit", nullptr)
+	XX(cpulimit, required_argument, "Set CPU limit", "COUNT", "0 = no limit", nullptr)                                 \
+	XX(virtualtime, optional_argument, "Run on a simulated clock", "SPEED",                                            \
+	   "Factor applied to time spent running, default 1",                                                              \
+	   "When idle, the clock jumps straight to the next timer deadline\0"                                              \
+	   "e.g. --virtualtime=10 also runs 10x faster when busy\0")
 
 enum option_tag_t {
 #define XX(tag, has_arg, desc, argname, arghelp, examples) opt_##tag,
@@ -0,0 +1,373 @@
+/**
+ * poller.cpp
+ *
+ * This file is part of the Sming Framework Project
+ *
+ * This library is free software: you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation, version 3 or later.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with SHEM.
+ * If not, see <https://www.gnu.org/licenses/>.
+ *
+ ****/
+
+#include "poller.h"
+#include "sockets.h"
+#include <vector>
+#include <algorithm>
+#include <cstring>
+#include <errno.h>
+
+#ifdef __linux__
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+#elif !defined(__WIN32)
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+#ifdef __linux__
+
+uint32_t getEpollEvents(unsigned events)
+{
+	uint32_t res{0};
+	if(events & POLL_EVENT_READ) {
+		res |= EPOLLIN;
+	}
+	if(events & POLL_EVENT_WRITE) {
+		res |= EPOLLOUT;
+	}
+	return res;
+}
+
+#else
+
+void closeSocket(int fd)
+{
+#ifdef __WIN32
+	::closesocket(fd);
+#else
+	::close(fd);
+#endif
+}
+
+/*
+ * select() on Windows only works with sockets, so use a loopback UDP socket connected to itself
+ */
+int createWakeSocket()
+{
+	int fd = ::socket(AF_INET, SOCK_DGRAM, 0);
+	if(fd < 0) {
+		return -1;
+	}
+	CSockAddr addr("127.0.0.1", 0);
+	CSockAddr bound;
+	if(::bind(fd, &addr.addr(), sizeof(struct sockaddr)) != 0 || !bound.get_host(fd) ||
+	   ::connect(fd, &bound.addr(), sizeof(struct sockaddr)) != 0) {
+		closeSocket(fd);
+		return -1;
+	}
+#ifdef __WIN32
+	u_long mode = 1;
+	ioctlsocket(fd, FIONBIO, &mode);
+#else
+	fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+#endif
+	return fd;
+}
+
+#endif
+
+} // namespace
+
+CPoller::CPoller() : CThread("poller", 1)
+{
+}
+
+CPoller::~CPoller()
+{
+	terminate();
+#ifdef __linux__
+	if(wakefd >= 0) {
+		::close(wakefd);
+	}
+	if(pollfd >= 0) {
+		::close(pollfd);
+	}
+#else
+	if(wakefd >= 0) {
+		closeSocket(wakefd);
+	}
+#endif
+}
+
+bool CPoller::start()
+{
+	if(running) {
+		return true;
+	}
+
+#ifdef __linux__
+	pollfd = epoll_create1(EPOLL_CLOEXEC);
+	wakefd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+	struct epoll_event evt {
+	};
+	evt.events = EPOLLIN;
+	evt.data.fd = wakefd;
+	if(pollfd < 0 || wakefd < 0 || epoll_ctl(pollfd, EPOLL_CTL_ADD, wakefd, &evt) != 0) {
+		host_debug_e("Poller init failed: %s", strerror(errno));
+		return false;
+	}
+#else
+	wakefd = createWakeSocket();
+	if(wakefd < 0) {
+		host_debug_e("Poller init failed: %s", socket_strerror().c_str());
+		return false;
+	}
+#endif
+
+	running = execute();
+	return running;
+}
+
+void CPoller::terminate()
+{
+	if(!running) {
+		return;
+	}
+	done = true;
+	wake();
+	join();
+	running = false;
+}
+
+bool CPoller::add(int fd, unsigned events, CPollHandler* handler)
+{
+	mutex.lock();
+	bool ok = (entries.find(fd) == entries.end());
+	if(ok) {
+		entries[fd] = Entry{handler, 0};
+		ok = update(fd, 0, events);
+		if(ok) {
+			entries[fd].events = events;
+		} else {
+			entries.erase(fd);
+		}
+	}
+	mutex.unlock();
+	return ok;
+}
+
+bool CPoller::modify(int fd, unsigned events)
+{
+	mutex.lock();
+	auto it = entries.find(fd);
+	bool ok = (it != entries.end());
+	if(ok && it->second.events != events) {
+		ok = update(fd, it->second.events, events);
+		if(ok) {
+			it->second.events = events;
+		}
+	}
+	mutex.unlock();
+	return ok;
+}
+
+void CPoller::remove(int fd)
+{
+	mutex.lock();
+	auto it = entries.find(fd);
+	if(it != entries.end()) {
+		update(fd, it->second.events, 0);
+		kicked.erase(it->second.handler);
+		entries.erase(it);
+	}
+	mutex.unlock();
+}
+
+void CPoller::kick(CPollHandler* handler)
+{
+	mutex.lock();
+	bool wasEmpty = kicked.empty();
+	kicked.insert(handler);
+	mutex.unlock();
+	if(wasEmpty) {
+		wake();
+	}
+}
+
+/*
+ * Kernel registration only exists whilst events are required, so a descriptor
+ * which has hung up won't keep waking us when the handler has disabled it.
+ */
+bool CPoller::update(int fd, unsigned oldEvents, unsigned newEvents)
+{
+#ifdef __linux__
+	struct epoll_event evt {
+	};
+	evt.events = getEpollEvents(newEvents);
+	evt.data.fd = fd;
+	int op;
+	if(oldEvents == 0) {
+		if(newEvents == 0) {
+			return true;
+		}
+		op = EPOLL_CTL_ADD;
+	} else {
+		op = (newEvents == 0) ? EPOLL_CTL_DEL : EPOLL_CTL_MOD;
+	}
+	if(epoll_ctl(pollfd, op, fd, &evt) != 0) {
+		host_debug_e("epoll_ctl(%d, %d): %s", op, fd, strerror(errno));
+		return false;
+	}
+	return true;
+#else
+	(void)fd;
+	(void)oldEvents;
+	(void)newEvents;
+	// Descriptor sets are rebuilt on every pass
+	if(!isCurrent()) {
+		wake();
+	}
+	return true;
+#endif
+}
+
+void CPoller::wake()
+{
+#ifdef __linux__
+	uint64_t value{1};
+	(void)::write(wakefd, &value, sizeof(value));
+#else
+	char c{0};
+	::send(wakefd, &c, 1, 0);
+#endif
+}
+
+void CPoller::dispatch(int fd, unsigned events)
+{
+	mutex.lock();
+	auto it = entries.find(fd);
+	CPollHandler* handler{nullptr};
+	if(it != entries.end() && it->second.events != 0) {
+		handler = it->second.handler;
+	}
+	mutex.unlock();
+
+	if(handler != nullptr) {
+		handler->onPoll(*this, fd, events);
+	}
+}
+
+void CPoller::dispatchKicks()
+{
+	mutex.lock();
+	auto handlers = std::move(kicked);
+	kicked.clear();
+	mutex.unlock();
+
+	for(auto handler : handlers) {
+		handler->onPoll(*this, -1, 0);
+	}
+}
+
+void* CPoller::thread_routine()
+{
+	while(!done) {
+#ifdef __linux__
+		struct epoll_event events[16];
+		int n = epoll_wait(pollfd, events, ARRAY_SIZE(events), -1);
+		if(n < 0) {
+			if(errno == EINTR) {
+				continue;
+			}
+			host_debug_e("epoll_wait: %s", strerror(errno));
+			break;
+		}
+		for(int i = 0; i < n; ++i) {
+			int fd = events[i].data.fd;
+			if(fd == wakefd) {
+				uint64_t value;
+				(void)::read(wakefd, &value, sizeof(value));
+				continue;
+			}
+			auto evt = events[i].events;
+			unsigned flags{0};
+			if(evt & (EPOLLIN | EPOLLERR | EPOLLHUP | EPOLLRDHUP)) {
+				flags |= POLL_EVENT_READ;
+			}
+			if(evt & EPOLLOUT) {
+				flags |= POLL_EVENT_WRITE;
+			}
+			dispatch(fd, flags);
+		}
+#else
+		fd_set rdSet;
+		fd_set wrSet;
+		FD_ZERO(&rdSet);
+		FD_ZERO(&wrSet);
+		FD_SET(wakefd, &rdSet);
+		int maxfd = wakefd;
+		std::vector<int> fds;
+		mutex.lock();
+		for(auto& e : entries) {
+			int fd = e.first;
+			if(e.second.events & POLL_EVENT_READ) {
+				FD_SET(fd, &rdSet);
+			}
+			if(e.second.events & POLL_EVENT_WRITE) {
+				FD_SET(fd, &wrSet);
+			}
+			if(e.second.events != 0) {
+				fds.push_back(fd);
+				maxfd = std::max(maxfd, fd);
+			}
+		}
+		mutex.unlock();
+
+		int n = select(maxfd + 1, &rdSet, &wrSet, nullptr, nullptr);
+		if(n < 0) {
+			if(errno == EINTR) {
+				continue;
+			}
+			host_debug_e("select: %s", socket_strerror().c_str());
+			break;
+		}
+		if(FD_ISSET(wakefd, &rdSet)) {
+			char buf[16];
+			while(::recv(wakefd, buf, sizeof(buf), 0) > 0) {
+			}
+		}
+		for(int fd : fds) {
+			unsigned flags{0};
+			if(FD_ISSET(fd, &rdSet)) {
+				flags |= POLL_EVENT_READ;
+			}
+			if(FD_ISSET(fd, &wrSet)) {
+				flags |= POLL_EVENT_WRITE;
+			}
+			if(flags != 0) {
+				dispatch(fd, flags);
+			}
+		}
+#endif
+
+		dispatchKicks();
+	}
+
+	return nullptr;
+}
+
+CPoller& host_poller()
+{
+	// Never destroyed so remains valid for exit handlers
+	static auto poller = new CPoller;
+	return *poller;
+}
@@ -0,0 +1,119 @@
+/**
+ * poller.h - Single thread to service host I/O
+ *
+ * This file is part of the Sming Framework Project
+ *
+ * This library is free software: you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation, version 3 or later.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with SHEM.
+ * If not, see <https://www.gnu.org/licenses/>.
+ *
+ ****/
+
+#pragma once
+
+#include "threads.h"
+#include <map>
+#include <set>
+
+// CPoller event flags
+#define POLL_EVENT_READ 0x01
+#define POLL_EVENT_WRITE 0x02
+
+class CPoller;
+
+/**
+ * @brief Interface for objects serviced by the poller
+ */
+class CPollHandler
+{
+public:
+	virtual ~CPollHandler()
+	{
+	}
+
+	/**
+	 * @brief Called from poller thread when a registered descriptor is ready, or handler has been kicked
+	 * @param poller Use this to issue interrupts or change registrations
+	 * @param fd Descriptor which is ready, -1 for a kick
+	 * @param events POLL_EVENT_xxx flags. Errors and hangups are reported as POLL_EVENT_READ.
+	 */
+	virtual void onPoll(CPoller& poller, int fd, unsigned events) = 0;
+};
+
+/**
+ * @brief Waits on all registered descriptors in a single thread
+ *
+ * Uses epoll on Linux, select() elsewhere. The thread sleeps until a descriptor becomes ready
+ * or a handler is kicked, so idle I/O costs nothing.
+ *
+ * Descriptors are level-triggered: a handler which cannot consume data immediately
+ * should call `modify(fd, 0)` until it's ready to do so.
+ */
+class CPoller : public CThread
+{
+public:
+	CPoller();
+	~CPoller();
+
+	/**
+	 * @brief Register a descriptor
+	 * @param events POLL_EVENT_xxx flags, may be 0 to register without yet polling
+	 * @note Handler must remain valid until removed, or the poller has been terminated
+	 */
+	bool add(int fd, unsigned events, CPollHandler* handler);
+
+	/**
+	 * @brief Change events of interest for a registered descriptor
+	 */
+	bool modify(int fd, unsigned events);
+
+	void remove(int fd);
+
+	/**
+	 * @brief Request a call to `handler->onPoll()` from the poller thread
+	 *
+	 * Multiple kicks before the handler runs result in a single call.
+	 */
+	void kick(CPollHandler* handler);
+
+	/**
+	 * @brief Start the poller thread
+	 * @note Call after `CThread::startup()` and `sockets_initialise()`, before adding any descriptors
+	 */
+	bool start();
+
+	void terminate();
+
+protected:
+	void* thread_routine() override;
+
+private:
+	struct Entry {
+		CPollHandler* handler;
+		unsigned events;
+	};
+
+	bool update(int fd, unsigned oldEvents, unsigned newEvents);
+	void wake();
+	void dispatch(int fd, unsigned events);
+	void dispatchKicks();
+
+	CMutex mutex;
+	std::map<int, Entry> entries;
+	std::set<CPollHandler*> kicked;
+	int pollfd{-1}; ///< epoll instance (Linux only)
+	int wakefd{-1}; ///< Written to wake thread
+	volatile bool done{false};
+	bool running{false};
+};
+
+/**
+ * @brief Get the poller shared by all host I/O
+ */
+CPoller& host_poller();
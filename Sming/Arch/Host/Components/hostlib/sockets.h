@@ -128,6 +128,11 @@ public:
 		return m_fd > 0;
 	}
 
+	int fd() const
+	{
+		return m_fd;
+	}
+
 	void assign(int fd, const CSockAddr& addr)
 	{
 		if(fd != m_fd) {
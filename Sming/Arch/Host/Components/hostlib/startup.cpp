@@ -22,6 +22,7 @@
 
 #include "sockets.h"
 #include "threads.h"
+#include "poller.h"
 #include "except.h"
 #include "options.h"
 #include <host_rboot.h>
@@ -31,6 +32,8 @@
 #include <driver/os_timer.h>
 #include <driver/hw_timer.h>
 #include <esp_tasks.h>
+#include <esp_system.h>
+#include <host_cycle_model.h>
 #include <stdlib.h>
 #include "include/hostlib/init.h"
 #include "include/hostlib/emu.h"
@@ -52,11 +55,13 @@ void cleanup()
 {
 	hw_timer_cleanup();
 	host_flashmem_cleanup();
+	host_poller().terminate();
 	UartServer::shutdown();
 	sockets_finalise();
 #ifndef DISABLE_NETWORK
 	host_lwip_shutdown();
 #endif
+	host_cycle_model_report();
 	host_debug_i("Goodbye!");
 }
 
@@ -102,6 +107,27 @@ static size_t parse_flash_size(const char* str)
 	}
 }
 
+/*
+ * Comma-separated list of microsecond values, for read, write and erase
+ */
+static bool parse_flash_timing(const char* str, FlashmemConfig::Timing& timing)
+{
+	unsigned values[3]{};
+	for(unsigned i = 0; i < 3; ++i) {
+		char* tail;
+		values[i] = strtoul(str, &tail, 0);
+		if(tail == str || (*tail != ',' && *tail != '\0')) {
+			return false;
+		}
+		if(*tail == '\0') {
+			break;
+		}
+		str = tail + 1;
+	}
+	timing = FlashmemConfig::Timing{values[0], values[1], values[2]};
+	return true;
+}
+
 static void pause(int secs)
 {
 	if(secs == 0) {
@@ -125,6 +151,37 @@ int host_main_loop()
 	return host_service_timers();
 }
 
+/*
+ * With a virtual clock there's no need to wait for timers: if nothing else is
+ * happening, move the clock forward and service them straight away.
+ *
+ * Returns time to wait, in milliseconds.
+ */
+static int host_idle(int due)
+{
+	if(!host_clock_is_virtual() || due <= 0) {
+		return due;
+	}
+
+	if(host_have_pending_tasks()) {
+		return 0;
+	}
+
+	uint64_t nanos = due * 1000000ULL;
+	auto hw_due = host_hw_timer1_due();
+	if(hw_due == 0) {
+		// Interrupt pending
+		return 0;
+	}
+	if(hw_due > 0 && uint64_t(hw_due) * 1000 < nanos) {
+		nanos = hw_due * 1000;
+	}
+
+	host_clock_advance(nanos);
+	host_hw_timer1_clock_changed();
+	return 0;
+}
+
 int main(int argc, char* argv[])
 {
 	trap_exceptions();
@@ -134,6 +191,7 @@ int main(int argc, char* argv[])
 		int exitpause{-1};
 		int loopcount;
 		uint8_t cpulimit;
+		int virtualtime{-1};
 		bool initonly;
 		bool enable_network{true};
 		UartServer::Config uart;
@@ -219,6 +277,21 @@ int main(int argc, char* argv[])
 			config.flash.createSize = parse_flash_size(arg);
 			break;
 
+		case opt_flashmap:
+			config.flash.mapped = true;
+			break;
+
+		case opt_flashendurance:
+			config.flash.endurance = atoi(arg);
+			break;
+
+		case opt_flashtiming:
+			if(!parse_flash_timing(arg, config.flash.timing)) {
+				host_printf("Invalid flash timing '%s'\r\n", arg);
+				return 0;
+			}
+			break;
+
 		case opt_initonly:
 			config.initonly = true;
 			break;
@@ -239,6 +312,10 @@ int main(int argc, char* argv[])
 			config.cpulimit = atoi(arg);
 			break;
 
+		case opt_virtualtime:
+			config.virtualtime = arg ? atoi(arg) : 1;
+			break;
+
 		case opt_none:
 			break;
 		}
@@ -257,6 +334,15 @@ int main(int argc, char* argv[])
 
 	atexit(cleanup);
 
+	if(config.virtualtime > 0) {
+		host_debug_i("Using virtual clock, speed x%d", config.virtualtime);
+		host_clock_enable_virtual(config.virtualtime);
+	}
+
+	if(host_cycle_model_enabled()) {
+		host_debug_i("Estimating cycles using '%s' model", host_cycle_model_name());
+	}
+
 	if(config.initonly) {
 		host_debug_i("Initialise-only requested");
 	} else {
@@ -269,6 +355,7 @@ int main(int argc, char* argv[])
 		host_init_tasks();
 
 		sockets_initialise();
+		host_poller().start();
 		UartServer::startup(config.uart);
 
 #ifndef DISABLE_NETWORK
@@ -298,7 +385,13 @@ int main(int argc, char* argv[])
 				}
 			}
 
-			host_thread_wait(due);
+			if(host_cycle_model_enabled()) {
+				auto waitStart = os_get_nanoseconds();
+				host_thread_wait(host_idle(due));
+				host_cycle_model_idle(os_get_nanoseconds() - waitStart);
+			} else {
+				host_thread_wait(host_idle(due));
+			}
 		}
 
 		host_debug_i(">> Normal Exit <<\n");
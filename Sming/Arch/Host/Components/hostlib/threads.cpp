@@ -196,6 +196,11 @@ void CThread::interrupt_unlock()
 	interrupt->unlock();
 }
 
+bool CThread::is_interrupt_context()
+{
+	return interrupt_mask != 0 && !isMainThread();
+}
+
 void CThread::interrupt_begin()
 {
 	assert(isCurrent());
@@ -205,6 +205,11 @@ public:
 	 */
 	static void interrupt_unlock();
 
+	/**
+	 * @brief Determine if caller is interrupt code running in a CThread
+	 */
+	static bool is_interrupt_context();
+
 	bool operator==(pthread_t other) const
 	{
 		return pthread_equal(other, m_thread);
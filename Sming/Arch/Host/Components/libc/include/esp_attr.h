@@ -9,7 +9,12 @@ extern "C" {
 #define ICACHE_RODATA_SECTION ".rodata"
 #define ICACHE_RAM_SECTION ".data"
 
+#if ENABLE_HOST_CYCLE_MODEL && defined(__linux__)
+// Allows cycle model to identify code which runs from RAM on the target
+#define IRAM_ATTR __attribute__((section("host_iram")))
+#else
 #define IRAM_ATTR
+#endif
 #define STORE_TYPEDEF_ATTR __attribute__((aligned(4), packed))
 #define STORE_ATTR __attribute__((aligned(4)))
 #define ICACHE_FLASH_ATTR
@@ -1 +1,3 @@
 COMPONENT_INCDIRS += $(ESP8266_COMPONENTS)/spi_flash/include
+
+COMPONENT_CPPFLAGS	+= $(HOST_CYCLE_MODEL_EXCLUDE)
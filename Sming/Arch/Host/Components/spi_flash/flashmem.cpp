@@ -23,6 +23,15 @@
 #include <esp_spi_flash.h>
 #include <IFS/File.h>
 #include <hostlib/hostmsg.h>
+#include <esp_system.h>
+#include <algorithm>
+#include <memory>
+
+#ifndef __WIN32
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
 
 namespace
 {
@@ -31,6 +40,14 @@ size_t flashFileSize{0x400000U};
 char flashFileName[256];
 const char defaultFlashFileName[]{"flash.bin"};
 
+uint8_t* flashMap;		///< Mapped backing file, nullptr if using file I/O
+unsigned sectorEndurance; ///< 0 for no limit
+FlashmemConfig::Timing timing;
+std::unique_ptr<uint32_t[]> eraseCounts;
+uint32_t totalEraseCount;
+
+constexpr size_t pageSize{256};
+
 // Top bit of flash address is set to indicate it's actually program memory
 constexpr uint32_t FLASHMEM_REAL_BIT{0x80000000U};
 constexpr uint32_t FLASHMEM_REAL_MASK{~FLASHMEM_REAL_BIT};
@@ -45,6 +62,40 @@ constexpr uint32_t FLASHMEM_REAL_MASK{~FLASHMEM_REAL_BIT};
 		return false;                                                                                                  \
 	}
 
+static bool mapFlashFile()
+{
+#ifdef __WIN32
+	host_debug_w("Flash memory-mapping not supported, using file I/O");
+	return false;
+#else
+	int fd = ::open(flashFileName, O_RDWR);
+	if(fd < 0) {
+		host_debug_e("Error opening \"%s\" for mapping", flashFileName);
+		return false;
+	}
+	void* ptr = mmap(nullptr, flashFileSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	// Mapping remains valid after descriptor is closed
+	::close(fd);
+	if(ptr == MAP_FAILED) {
+		host_debug_e("Error mapping \"%s\"", flashFileName);
+		return false;
+	}
+	flashMap = static_cast<uint8_t*>(ptr);
+	host_debug_i("Mapped \"%s\"", flashFileName);
+	return true;
+#endif
+}
+
+static void unmapFlashFile()
+{
+#ifndef __WIN32
+	if(flashMap != nullptr) {
+		munmap(flashMap, flashFileSize);
+		flashMap = nullptr;
+	}
+#endif
+}
+
 bool host_flashmem_init(FlashmemConfig& config)
 {
 	if(config.filename != nullptr) {
@@ -88,17 +139,59 @@ bool host_flashmem_init(FlashmemConfig& config)
 	flashFileSize = res;
 	config.createSize = flashFileSize;
 
+	eraseCounts.reset(new uint32_t[flashFileSize / INTERNAL_FLASH_SECTOR_SIZE]{});
+	totalEraseCount = 0;
+	sectorEndurance = config.endurance;
+	timing = config.timing;
+
+	if(config.mapped && !mapFlashFile()) {
+		config.mapped = false;
+	}
+
 	return true;
 }
 
 void host_flashmem_cleanup()
 {
+	if(eraseCounts) {
+		uint32_t maxCount{0};
+		for(unsigned i = 0; i < flashFileSize / INTERNAL_FLASH_SECTOR_SIZE; ++i) {
+			maxCount = std::max(maxCount, eraseCounts[i]);
+		}
+		host_debug_i("Flash erased %u sectors, max. %u for a single sector", totalEraseCount, maxCount);
+	}
+
+	unmapFlashFile();
 	flashFile.close();
 	host_debug_i("Closed \"%s\"", flashFileName);
 }
 
+uint32_t host_flashmem_get_erase_count(uint32_t sector)
+{
+	return (eraseCounts && sector < flashFileSize / INTERNAL_FLASH_SECTOR_SIZE) ? eraseCounts[sector] : 0;
+}
+
+uint32_t host_flashmem_get_total_erase_count()
+{
+	return totalEraseCount;
+}
+
+static void simulateDelay(unsigned us)
+{
+	if(us != 0) {
+		os_delay_us(us);
+	}
+}
+
 static int readFlashFile(uint32_t offset, void* buffer, size_t count)
 {
+	simulateDelay(timing.read);
+
+	if(flashMap != nullptr) {
+		memcpy(buffer, &flashMap[offset], count);
+		return count;
+	}
+
 	if(!flashFile) {
 		return -1;
 	}
@@ -112,6 +205,25 @@ static int readFlashFile(uint32_t offset, void* buffer, size_t count)
 	return res;
 }
 
+/*
+ * NOR flash programming can only clear bits
+ */
+static void programMappedFlash(uint32_t offset, const void* data, size_t count)
+{
+	auto src = static_cast<const uint8_t*>(data);
+	auto dst = &flashMap[offset];
+	bool conflict{false};
+	for(size_t i = 0; i < count; ++i) {
+		if(src[i] & ~dst[i]) {
+			conflict = true;
+		}
+		dst[i] &= src[i];
+	}
+	if(conflict) {
+		host_debug_w("Flash write to 0x%08x, %u bytes: Area not erased", offset, count);
+	}
+}
+
 static int writeFlashFile(uint32_t offset, const void* data, size_t count)
 {
 	if(!flashFile) {
@@ -127,6 +239,18 @@ static int writeFlashFile(uint32_t offset, const void* data, size_t count)
 	return res;
 }
 
+static int programFlash(uint32_t offset, const void* data, size_t count)
+{
+	simulateDelay(timing.write * ((count + pageSize - 1) / pageSize));
+
+	if(flashMap != nullptr) {
+		programMappedFlash(offset, data, count);
+		return count;
+	}
+
+	return writeFlashFile(offset, data, count);
+}
+
 SPIFlashInfo flashmem_get_info()
 {
 	SPIFlashInfo info{};
@@ -193,7 +317,7 @@ uint32_t flashmem_read_internal(void* to, uint32_t fromaddr, uint32_t size)
 uint32_t flashmem_write(const void* from, uint32_t toaddr, uint32_t size)
 {
 	CHECK_RANGE(toaddr, size);
-	int res = writeFlashFile(toaddr, from, size);
+	int res = programFlash(toaddr, from, size);
 	return (res < 0) ? 0 : res;
 }
 
@@ -217,6 +341,22 @@ bool flashmem_erase_sector(uint32_t sector_id)
 {
 	uint32_t addr = sector_id * INTERNAL_FLASH_SECTOR_SIZE;
 	CHECK_RANGE(addr, INTERNAL_FLASH_SECTOR_SIZE);
+
+	auto& count = eraseCounts[sector_id];
+	if(sectorEndurance != 0 && count >= sectorEndurance) {
+		host_debug_w("Flash sector #%u worn out after %u erases", sector_id, count);
+		return false;
+	}
+	++count;
+	++totalEraseCount;
+
+	simulateDelay(timing.erase);
+
+	if(flashMap != nullptr) {
+		memset(&flashMap[addr], 0xFF, INTERNAL_FLASH_SECTOR_SIZE);
+		return true;
+	}
+
 	uint8_t tmp[INTERNAL_FLASH_SECTOR_SIZE];
 	memset(tmp, 0xFF, sizeof(tmp));
 	return writeFlashFile(addr, tmp, sizeof(tmp)) == sizeof(tmp);
@@ -226,3 +366,15 @@ uint32_t flashmem_get_address(const void* memptr)
 {
 	return reinterpret_cast<uint32_t>(memptr) | FLASHMEM_REAL_BIT;
 }
+
+const void* flashmem_get_pointer(uint32_t addr, uint32_t size)
+{
+	if(flashMap == nullptr || addr + size > flashFileSize) {
+		return nullptr;
+	}
+	return &flashMap[addr];
+}
+
+void flashmem_release_pointer(const void*)
+{
+}
@@ -20,10 +20,29 @@
 #pragma once
 
 #include <cstddef>
+#include <cstdint>
 
 struct FlashmemConfig {
+	/**
+	 * @brief Simulated operation times, in microseconds
+	 */
+	struct Timing {
+		unsigned read;	///< Per read operation
+		unsigned write; ///< Per 256-byte page, or part thereof
+		unsigned erase; ///< Per sector
+	};
+
 	const char* filename; ///< Path to flash backing file
 	size_t createSize;	///< If file doesn't exist, created with this size
+	/**
+	 * @brief Memory-map backing file
+	 *
+	 * Reads and writes are done directly in memory rather than via file I/O.
+	 * Programming behaves as NOR flash: bits can only be cleared, so data must be erased before being rewritten.
+	 */
+	bool mapped;
+	unsigned endurance; ///< Number of erases after which a sector fails, 0 for no limit
+	Timing timing;
 };
 
 /**
@@ -38,3 +57,13 @@ struct FlashmemConfig {
 bool host_flashmem_init(FlashmemConfig& config);
 
 void host_flashmem_cleanup();
+
+/**
+ * @brief Get number of times a flash sector has been erased since startup
+ */
+uint32_t host_flashmem_get_erase_count(uint32_t sector);
+
+/**
+ * @brief Get total number of sector erase operations since startup
+ */
+uint32_t host_flashmem_get_total_erase_count();
@@ -0,0 +1,53 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/SmingHub/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * AdcSampler.cpp - Simulated sampling for Host
+ *
+ * Blocks are filled all at once from a software timer, at the average rate of the real hardware.
+ *
+ ****/
+
+#include <AdcSampler.h>
+#include <Digital.h>
+#include <SimpleTimer.h>
+
+namespace
+{
+SimpleTimer blockTimer;
+uint8_t blockIndex;
+} // namespace
+
+bool AdcSampler::hardwareBegin(uint16_t pin)
+{
+	if(pin != A0) {
+		return false;
+	}
+
+	uint64_t blockTime = uint64_t(blockSize) * 1000000U / sampleRate;
+	if(blockTime == 0) {
+		return false;
+	}
+
+	blockIndex = 0;
+	blockTimer.initializeUs(blockTime, hardwareInterrupt, this);
+	return blockTimer.start();
+}
+
+void AdcSampler::hardwareEnd()
+{
+	blockTimer.stop();
+}
+
+void AdcSampler::hardwareInterrupt(void* param)
+{
+	auto sampler = static_cast<AdcSampler*>(param);
+	auto block = sampler->getBlock(blockIndex);
+	for(unsigned i = 0; i < sampler->blockSize; ++i) {
+		block[i] = system_adc_read();
+	}
+	sampler->blockComplete(blockIndex);
+	blockIndex ^= 1;
+}
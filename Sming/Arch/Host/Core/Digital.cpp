@@ -14,6 +14,10 @@
 // Wemos D1 mini has pin 16
 #define PIN_MAX 16
 static uint8 pinModes[PIN_MAX + 1];
+static uint32_t outputState;
+
+// Interrupts.cpp
+void checkPinInterrupt(uint16_t pin, uint8_t oldValue, uint8_t newValue);
 
 DigitalHooks defaultHooks;
 static DigitalHooks* activeHooks = &defaultHooks;
@@ -67,8 +71,17 @@ bool isInputPin(uint16_t pin)
 
 void digitalWrite(uint16_t pin, uint8_t val)
 {
-	if(checkPin(__FUNCTION__, pin) && activeHooks != nullptr) {
-		activeHooks->digitalWrite(pin, val);
+	if(checkPin(__FUNCTION__, pin)) {
+		uint8_t oldValue = (outputState >> pin) & 1;
+		if(val) {
+			outputState |= BIT(pin);
+		} else {
+			outputState &= ~BIT(pin);
+		}
+		if(activeHooks != nullptr) {
+			activeHooks->digitalWrite(pin, val);
+		}
+		checkPinInterrupt(pin, oldValue, val ? 1 : 0);
 	}
 }
 
@@ -104,6 +117,41 @@ unsigned long pulseIn(uint16_t pin, uint8_t state, unsigned long timeout)
 	}
 }
 
+void digitalWriteMask(uint32_t mask, uint32_t value)
+{
+	for(unsigned pin = 0; pin <= PIN_MAX; ++pin) {
+		if(mask & BIT(pin)) {
+			digitalWrite(pin, (value >> pin) & 1);
+		}
+	}
+}
+
+void digitalSetMask(uint32_t mask)
+{
+	digitalWriteMask(mask, 0xffffffff);
+}
+
+void digitalClearMask(uint32_t mask)
+{
+	digitalWriteMask(mask, 0);
+}
+
+void digitalToggleMask(uint32_t mask)
+{
+	digitalWriteMask(mask, ~outputState);
+}
+
+uint32_t digitalReadPort()
+{
+	uint32_t value{0};
+	for(unsigned pin = 0; pin <= PIN_MAX; ++pin) {
+		if(digitalRead(pin)) {
+			value |= BIT(pin);
+		}
+	}
+	return value;
+}
+
 uint16_t analogRead(uint16_t pin)
 {
 	return (activeHooks == nullptr) ? 0 : activeHooks->analogRead(pin);
@@ -48,6 +48,25 @@ bool HardwarePWM::setDutyChan(uint8_t chan, uint32_t duty, bool update)
 	return false;
 }
 
+bool HardwarePWM::setDuties(const uint32_t* duties, uint8_t count)
+{
+	return false;
+}
+
+bool HardwarePWM::playSequence(const uint32_t* duties, uint16_t steps, uint16_t periodsPerStep, bool loop)
+{
+	return false;
+}
+
+void HardwarePWM::stopSequence()
+{
+}
+
+bool HardwarePWM::isSequenceRunning()
+{
+	return false;
+}
+
 uint32_t HardwarePWM::getPeriod()
 {
 	return 0;
@@ -6,28 +6,103 @@
  *
  * Interrupts.cpp
  *
+ * There is no real GPIO, so pins are looped back: changing an output with digitalWrite()
+ * triggers any interrupt attached to the same pin. This allows input handling to be tested.
+ *
  ****/
 
 #include <Interrupts.h>
 #include <Digital.h>
 #include <Platform/System.h>
 
+namespace
+{
+constexpr unsigned MAX_INTERRUPTS = 17;
+
+struct PinInterrupt {
+	InterruptCallback callback;
+	InterruptDelegate delegate;
+	GPIO_INT_TYPE type;
+};
+
+PinInterrupt pinInterrupts[MAX_INTERRUPTS];
+
+} // namespace
+
+/*
+ * Called by digitalWrite()
+ */
+void checkPinInterrupt(uint16_t pin, uint8_t oldValue, uint8_t newValue)
+{
+	if(pin >= MAX_INTERRUPTS) {
+		return;
+	}
+
+	auto& intr = pinInterrupts[pin];
+	bool trigger;
+	switch(intr.type) {
+	case GPIO_PIN_INTR_POSEDGE:
+		trigger = !oldValue && newValue;
+		break;
+	case GPIO_PIN_INTR_NEGEDGE:
+		trigger = oldValue && !newValue;
+		break;
+	case GPIO_PIN_INTR_ANYEDGE:
+		trigger = oldValue != newValue;
+		break;
+	case GPIO_PIN_INTR_LOLEVEL:
+		trigger = !newValue;
+		break;
+	case GPIO_PIN_INTR_HILEVEL:
+		trigger = newValue;
+		break;
+	default:
+		trigger = false;
+	}
+	if(!trigger) {
+		return;
+	}
+
+	if(intr.callback) {
+		intr.callback();
+	} else if(intr.delegate) {
+		System.queueCallback(intr.delegate);
+	}
+}
+
 void attachInterrupt(uint8_t pin, InterruptCallback callback, GPIO_INT_TYPE type)
 {
+	if(pin >= MAX_INTERRUPTS) {
+		return;
+	}
+	pinInterrupts[pin] = PinInterrupt{callback, nullptr, type};
 }
 
 void attachInterrupt(uint8_t pin, InterruptDelegate delegateFunction, GPIO_INT_TYPE type)
 {
+	if(pin >= MAX_INTERRUPTS) {
+		return;
+	}
+	pinInterrupts[pin] = PinInterrupt{nullptr, delegateFunction, type};
 }
 
 void attachInterruptHandler(uint8_t pin, GPIO_INT_TYPE type)
 {
+	interruptMode(pin, type);
 }
 
 void detachInterrupt(uint8_t pin)
 {
+	if(pin >= MAX_INTERRUPTS) {
+		return;
+	}
+	pinInterrupts[pin] = PinInterrupt{};
 }
 
 void interruptMode(uint8_t pin, GPIO_INT_TYPE type)
 {
+	if(pin >= MAX_INTERRUPTS) {
+		return;
+	}
+	pinInterrupts[pin].type = type;
 }
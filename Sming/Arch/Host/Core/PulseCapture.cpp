@@ -0,0 +1,39 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/SmingHub/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * PulseCapture.cpp - Simulated edge capture for Host
+ *
+ * Pins are looped back, so edges are generated by calling digitalWrite() on the captured pin.
+ * Input levels cannot be read back so are tracked here, starting low.
+ *
+ ****/
+
+#include <PulseCapture.h>
+#include <Digital.h>
+
+namespace
+{
+uint8_t levels[PulseCapture::maxCaptures];
+}
+
+bool PulseCapture::hardwareBegin()
+{
+	lastLevel = levels[slot] = 0;
+	lastTime = micros();
+	return attachEdgeInterrupt();
+}
+
+void PulseCapture::hardwareEnd()
+{
+	detachEdgeInterrupt();
+}
+
+void PulseCapture::hardwareInterrupt(PulseCapture& capture)
+{
+	auto& level = levels[capture.slot];
+	level ^= 1;
+	capture.edgeCaptured(micros(), level);
+}
@@ -0,0 +1,13 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/SmingHub/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * digital_arch.h - Port-level GPIO access
+ *
+ * Port functions are implemented in Digital.cpp, via DigitalHooks.
+ *
+ ****/
+
+#pragma once
@@ -9,8 +9,7 @@
  ****/
 
 #include <Platform/RTC.h>
-
-#include <sys/time.h>
+#include <esp_system.h>
 
 RtcClass RTC;
 
@@ -23,19 +22,17 @@ RtcClass::RtcClass()
 {
 }
 
+/*
+ * Derive from system clock so time follows the emulator's virtual clock, if enabled
+ */
 uint64_t RtcClass::getRtcNanoseconds()
 {
-	struct timeval tv;
-	gettimeofday(&tv, nullptr);
-	uint64_t usecs = (tv.tv_sec * 1000000ULL) + (uint32_t)tv.tv_usec;
-	return usecs * 1000;
+	return (host_system_start_time * 1000ULL) + os_get_nanoseconds();
 }
 
 uint32_t RtcClass::getRtcSeconds()
 {
-	struct timeval tv;
-	gettimeofday(&tv, nullptr);
-	return tv.tv_sec + timeDiff;
+	return (getRtcNanoseconds() / 1000000000ULL) + timeDiff;
 }
 
 bool RtcClass::setRtcNanoseconds(uint64_t nanoseconds)
@@ -0,0 +1,27 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/SmingHub/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * PcSampler.cpp
+ *
+ */
+
+#include <Services/Profiling/PcSampler.h>
+
+namespace Profiling
+{
+namespace PcSampler
+{
+bool startTimer(unsigned)
+{
+	return false;
+}
+
+void stopTimer()
+{
+}
+
+} // namespace PcSampler
+} // namespace Profiling
@@ -0,0 +1,23 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/SmingHub/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * StackUsage.cpp
+ *
+ */
+
+#include <Services/Profiling/StackUsage.h>
+
+namespace Profiling
+{
+namespace StackUsage
+{
+bool getBounds(Bounds&)
+{
+	return false;
+}
+
+} // namespace StackUsage
+} // namespace Profiling
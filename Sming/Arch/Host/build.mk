@@ -25,6 +25,9 @@ CPPFLAGS += \
 	-Wno-deprecated-declarations \
 	-D_FILE_OFFSET_BITS=64
 
+# Emulator code isn't part of the target so is excluded from cycle model instrumentation
+HOST_CYCLE_MODEL_EXCLUDE = $(if $(filter 1,$(ENABLE_HOST_CYCLE_MODEL)),-fno-sanitize-coverage=trace-pc -fno-instrument-functions)
+
 # => Tools
 MEMANALYZER = size
 
@@ -377,6 +377,14 @@ size_t smg_uart_write(smg_uart_t* uart, const void* buffer, size_t size)
 	return written;
 }
 
+bool smg_uart_write_desc(smg_uart_t* uart, smg_uart_tx_desc_t* desc)
+{
+	// Not implemented: HardwareSerial falls back to smg_uart_write()
+	(void)uart;
+	(void)desc;
+	return false;
+}
+
 size_t smg_uart_tx_free(smg_uart_t* uart)
 {
 	return uart->tx_buffer ? uart->tx_buffer->getFreeSpace() : 0;
@@ -682,6 +690,14 @@ bool smg_uart_intr_config(smg_uart_t* uart, const smg_uart_intr_config_t* config
 	return false;
 }
 
+bool smg_uart_set_rx_timeout(smg_uart_t* uart, uint8_t chars)
+{
+	// Hardware timeout is fixed at 32 bit periods
+	(void)uart;
+	(void)chars;
+	return false;
+}
+
 void smg_uart_swap(smg_uart_t* uart, int tx_pin)
 {
 	// Not implemented
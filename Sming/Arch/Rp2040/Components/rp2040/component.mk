@@ -44,6 +44,7 @@ SDK_INTERFACES := \
 	rp2040/hardware_structs \
 	rp2_common/hardware_gpio \
 	rp2_common/pico_platform \
+	rp2_common/hardware_adc \
 	rp2_common/hardware_base \
 	rp2_common/hardware_sync \
 	rp2_common/hardware_divider \
@@ -52,6 +53,7 @@ SDK_INTERFACES := \
 	rp2_common/hardware_dma \
 	rp2_common/hardware_exception \
 	rp2_common/hardware_flash \
+	rp2_common/hardware_i2c \
 	rp2_common/hardware_irq \
 	rp2_common/hardware_pio \
 	rp2_common/hardware_resets \
@@ -66,6 +68,7 @@ SDK_INTERFACES := \
 	rp2_common/pico_double \
 	rp2_common/pico_int64_ops \
 	rp2_common/pico_float \
+	rp2_common/pico_multicore \
 	rp2_common/pico_runtime \
 	rp2_common/pico_unique_id
 
@@ -0,0 +1,164 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/SmingHub/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * core1_worker.cpp
+ *
+ ****/
+
+#include "include/core1_worker.h"
+#include <Platform/System.h>
+#include <pico/multicore.h>
+#include <hardware/sync.h>
+#include <atomic>
+
+#ifndef CORE1_WORKER_QUEUE_LENGTH
+#define CORE1_WORKER_QUEUE_LENGTH 8
+#endif
+
+namespace
+{
+struct Job {
+	core1_job_t execute;
+	core1_job_t complete;
+	void* param;
+};
+
+/*
+ * Lock-free single-producer, single-consumer queue.
+ *
+ * Each index is only written by one core, so plain atomic loads and stores suffice.
+ * The Cortex-M0+ has no atomic read-modify-write instructions but doesn't need them here.
+ */
+template <typename T, unsigned size> class SpscQueue
+{
+public:
+	static_assert((size & (size - 1)) == 0, "Queue size must be power of 2");
+
+	bool push(const T& item)
+	{
+		auto w = writeIndex.load(std::memory_order_relaxed);
+		if(w - readIndex.load(std::memory_order_acquire) == size) {
+			return false;
+		}
+		items[w % size] = item;
+		writeIndex.store(w + 1, std::memory_order_release);
+		return true;
+	}
+
+	T* peek()
+	{
+		auto r = readIndex.load(std::memory_order_relaxed);
+		if(r == writeIndex.load(std::memory_order_acquire)) {
+			return nullptr;
+		}
+		return &items[r % size];
+	}
+
+	void pop()
+	{
+		readIndex.store(readIndex.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+	}
+
+private:
+	T items[size];
+	std::atomic<uint32_t> readIndex{0};
+	std::atomic<uint32_t> writeIndex{0};
+};
+
+SpscQueue<Job, CORE1_WORKER_QUEUE_LENGTH> jobQueue;  // core0 -> core1
+SpscQueue<Job, CORE1_WORKER_QUEUE_LENGTH> doneQueue; // core1 -> core0
+uint32_t submitCount; // Accessed only by core0
+uint32_t completeCount;
+volatile bool running;
+
+void __noreturn core1_main()
+{
+	// Allow core0 to pause us during flash operations
+	multicore_lockout_victim_init();
+
+	while(true) {
+		auto job = jobQueue.peek();
+		if(job == nullptr) {
+			__wfe();
+			continue;
+		}
+		auto item = *job;
+		jobQueue.pop();
+		item.execute(item.param);
+		// Completion queue is same size as job queue so cannot overflow
+		doneQueue.push(item);
+		__sev();
+	}
+}
+
+} // namespace
+
+bool core1_worker_start()
+{
+	if(running) {
+		return false;
+	}
+	multicore_launch_core1(core1_main);
+	running = true;
+	return true;
+}
+
+bool core1_worker_is_running()
+{
+	return running;
+}
+
+bool core1_worker_submit(core1_job_t job, core1_job_t complete, void* param)
+{
+	if(!running || job == nullptr) {
+		return false;
+	}
+	// Ensure completion queue always has room
+	if(submitCount - completeCount >= CORE1_WORKER_QUEUE_LENGTH) {
+		return false;
+	}
+	if(!jobQueue.push(Job{job, complete, param})) {
+		return false;
+	}
+	++submitCount;
+	__sev();
+	return true;
+}
+
+unsigned core1_worker_pending()
+{
+	return submitCount - completeCount;
+}
+
+void core1_worker_service()
+{
+	if(!running) {
+		return;
+	}
+	Job* job;
+	while((job = doneQueue.peek()) != nullptr) {
+		if(job->complete != nullptr && !System.queueCallback(job->complete, job->param)) {
+			// Task queue full, try again later
+			break;
+		}
+		doneQueue.pop();
+		++completeCount;
+	}
+}
+
+void core1_worker_pause()
+{
+	if(running) {
+		multicore_lockout_start_blocking();
+	}
+}
+
+void core1_worker_resume()
+{
+	if(running) {
+		multicore_lockout_end_blocking();
+	}
+}
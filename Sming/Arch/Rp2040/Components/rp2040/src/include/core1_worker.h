@@ -0,0 +1,75 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/SmingHub/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * core1_worker.h - Run CPU-intensive jobs on the second RP2040 core
+ *
+ * Jobs are submitted from core0 and executed in order on core1.
+ * On completion, the job's completion callback is posted to the regular task queue
+ * so it runs on core0 like any other deferred callback.
+ *
+ * Job functions run concurrently with the main application so must only access
+ * data owned by the job. In particular they must not:
+ *
+ * 	- use the heap (the newlib allocator is not thread-safe)
+ * 	- call into the network stack, timers, task queue or other framework code
+ * 	- produce debug output
+ *
+ * Suitable work includes hashing, encryption and decoding into pre-allocated buffers.
+ *
+ * Flash write/erase operations automatically pause core1 while they are in progress.
+ *
+ ****/
+
+#pragma once
+
+#include <esp_systemapi.h>
+
+/**
+ * @brief Job function, called on core1
+ */
+typedef void (*core1_job_t)(void* param);
+
+/**
+ * @brief Start core1 worker
+ * @retval bool true on success, false if already running
+ */
+bool core1_worker_start();
+
+/**
+ * @brief Determine if core1 worker has been started
+ */
+bool core1_worker_is_running();
+
+/**
+ * @brief Submit a job to core1
+ * @param job Function to execute on core1
+ * @param complete Function queued on core0 after job has completed (optional)
+ * @param param Parameter passed to both functions
+ * @retval bool false if worker not running or job queue is full
+ * @note Must be called from core0, not from interrupt context.
+ */
+bool core1_worker_submit(core1_job_t job, core1_job_t complete, void* param);
+
+/**
+ * @brief Get number of jobs submitted but not yet completed
+ */
+unsigned core1_worker_pending();
+
+/**
+ * @brief Called from main loop to post job completions to the task queue
+ */
+void core1_worker_service();
+
+/**
+ * @brief Pause core1 so that flash may be safely written or erased
+ * @note Does nothing if worker is not running. Calls must be paired with `core1_worker_resume()`.
+ */
+void core1_worker_pause();
+
+/**
+ * @brief Resume core1 after a call to `core1_worker_pause()`
+ */
+void core1_worker_resume();
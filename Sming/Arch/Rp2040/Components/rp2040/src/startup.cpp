@@ -12,10 +12,12 @@
 #include <driver/uart.h>
 #include <driver/hw_timer.h>
 #include "include/esp_tasks_ll.h"
+#include "include/core1_worker.h"
 #include <gdb/gdb_hooks.h>
 #include <Storage.h>
 #include <hardware/structs/ioqspi.h>
 #include <pico/bootrom.h>
+#include <Services/Profiling/BootTimeline.h>
 
 extern void init();
 extern void hw_timer_init();
@@ -110,12 +112,15 @@ extern "C" int main(void)
 
 	Storage::initialize();
 
+	BOOT_PHASE_BEGIN(userInit);
 	init(); // User code init
+	BOOT_PHASE_END(userInit);
 
 	while(true) {
 		system_soft_wdt_feed();
 		system_service_tasks();
 		system_service_timers();
+		core1_worker_service();
 #ifdef ENABLE_BOOTSEL
 		check_bootsel();
 #endif
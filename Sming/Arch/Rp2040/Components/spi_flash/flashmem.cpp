@@ -11,11 +11,13 @@
 #include <esp_spi_flash.h>
 #include <hardware/flash.h>
 #include <hardware/dma.h>
+#include <hardware/irq.h>
 #include <hardware/regs/addressmap.h>
 #include <hardware/structs/xip_ctrl.h>
 #include <hardware/structs/ssi.h>
 #include <hardware/regs/ssi.h>
 #include <debug_progmem.h>
+#include <core1_worker.h>
 
 #define FLASHCMD_READ_SFDP 0x5a
 #define FLASHCMD_READ_JEDEC_ID 0x9f
@@ -87,6 +89,21 @@ void initFlashInfo()
 	sfdp_flash_size_bytes = sfdp_read_size();
 }
 
+// Channel used for background read, -1 if idle
+volatile int asyncChannel{-1};
+flashmem_read_callback_t asyncCallback;
+void* asyncParam;
+
+/*
+ * Only one streaming transfer may be active, and flash must not be written whilst one is in progress.
+ */
+void waitAsyncRead()
+{
+	while(asyncChannel >= 0) {
+		tight_loop_contents();
+	}
+}
+
 uint32_t writeAligned(const void* from, uint32_t toaddr, uint32_t size)
 {
 	auto flashaddr = XIP_BASE + toaddr;
@@ -97,23 +114,16 @@ uint32_t writeAligned(const void* from, uint32_t toaddr, uint32_t size)
 
 	debug_d("[FLSH] write(%p, 0x%08x, 0x%08x)", from, toaddr, size);
 
+	waitAsyncRead();
+	core1_worker_pause();
 	flash_range_program(toaddr, static_cast<const uint8_t*>(from), size);
+	core1_worker_resume();
 
 	return size;
 }
 
-uint32_t readAligned(void* to, uint32_t fromaddr, uint32_t size)
+int startStreamRead(void* to, uint32_t flashaddr, uint32_t transfer_count)
 {
-	auto flashaddr = XIP_BASE + fromaddr;
-	if(!isFlashPtr(flashaddr)) {
-		debug_e("[FLSH] read fromaddr not in flash 0x%08x", fromaddr);
-		return 0;
-	}
-
-	debug_d("[FLSH] read(%p, 0x%08x, 0x%08x)", to, fromaddr, size);
-
-	auto transfer_count = size >> dmaTransferSize;
-
 	/*
 	 * https://github.com/raspberrypi/pico-examples/tree/master/flash/xip_stream
 	 *
@@ -140,6 +150,8 @@ uint32_t readAligned(void* to, uint32_t fromaddr, uint32_t size)
 	 * the DMA against general XIP traffic.
 	 */
 	auto dma_chan = dma_claim_unused_channel(true);
+	// Clear any completion status left by a previous user of this channel
+	dma_channel_acknowledge_irq0(dma_chan);
 	dma_channel_config cfg = dma_channel_get_default_config(dma_chan);
 	channel_config_set_transfer_data_size(&cfg, dmaTransferSize);
 	channel_config_set_read_increment(&cfg, false);
@@ -152,6 +164,36 @@ uint32_t readAligned(void* to, uint32_t fromaddr, uint32_t size)
 						  true										   // Start immediately!
 	);
 
+	return dma_chan;
+}
+
+void IRAM_ATTR asyncReadIsr()
+{
+	int chan = asyncChannel;
+	if(chan < 0 || !dma_channel_get_irq0_status(chan)) {
+		return;
+	}
+
+	dma_channel_acknowledge_irq0(chan);
+	dma_channel_set_irq0_enabled(chan, false);
+	dma_channel_unclaim(chan);
+	asyncChannel = -1;
+	asyncCallback(asyncParam, true);
+}
+
+uint32_t readAligned(void* to, uint32_t fromaddr, uint32_t size)
+{
+	auto flashaddr = XIP_BASE + fromaddr;
+	if(!isFlashPtr(flashaddr)) {
+		debug_e("[FLSH] read fromaddr not in flash 0x%08x", fromaddr);
+		return 0;
+	}
+
+	debug_d("[FLSH] read(%p, 0x%08x, 0x%08x)", to, fromaddr, size);
+
+	waitAsyncRead();
+
+	auto dma_chan = startStreamRead(to, flashaddr, size >> dmaTransferSize);
 	dma_channel_wait_for_finish_blocking(dma_chan);
 	dma_channel_unclaim(dma_chan);
 
@@ -297,10 +339,55 @@ uint32_t flashmem_read(void* to, uint32_t fromaddr, uint32_t size)
 	return size;
 }
 
+bool flashmem_read_async(void* to, uint32_t fromaddr, uint32_t size, flashmem_read_callback_t callback, void* param)
+{
+	if(callback == nullptr || size == 0 || !IS_ALIGNED(to) || !IS_ALIGNED(fromaddr) || !IS_ALIGNED(size)) {
+		return false;
+	}
+	if(!isFlashPtr(XIP_BASE + fromaddr + size - 1)) {
+		return false;
+	}
+	if(asyncChannel >= 0) {
+		return false;
+	}
+
+	static bool irqInitialised;
+	if(!irqInitialised) {
+		irq_add_shared_handler(DMA_IRQ_0, asyncReadIsr, PICO_SHARED_IRQ_HANDLER_DEFAULT_ORDER_PRIORITY);
+		irq_set_enabled(DMA_IRQ_0, true);
+		irqInitialised = true;
+	}
+
+	debug_d("[FLSH] readAsync(%p, 0x%08x, 0x%08x)", to, fromaddr, size);
+
+	asyncCallback = callback;
+	asyncParam = param;
+	auto dma_chan = startStreamRead(to, XIP_BASE + fromaddr, size >> dmaTransferSize);
+	// Interrupt is raised on enable if transfer has already completed
+	asyncChannel = dma_chan;
+	dma_channel_set_irq0_enabled(dma_chan, true);
+	return true;
+}
+
+const void* flashmem_get_pointer(uint32_t addr, uint32_t size)
+{
+	if(addr + size < addr || addr + size > flashmem_get_size_bytes()) {
+		return nullptr;
+	}
+	return reinterpret_cast<const void*>(XIP_BASE + addr);
+}
+
+void flashmem_release_pointer(const void*)
+{
+}
+
 bool flashmem_erase_sector(uint32_t sector_id)
 {
 	debug_d("flashmem_erase_sector(0x%08x)", sector_id);
+	waitAsyncRead();
+	core1_worker_pause();
 	flash_range_erase(sector_id * FLASH_SECTOR_SIZE, FLASH_SECTOR_SIZE);
+	core1_worker_resume();
 	return true;
 }
 
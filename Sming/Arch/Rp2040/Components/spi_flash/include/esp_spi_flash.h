@@ -88,9 +88,25 @@ static inline uint32_t flashmem_get_address(const void* memptr)
 	if(addr < XIP_BASE || addr >= XIP_NOALLOC_BASE) {
 		return 0;
 	}
+
 	return addr - XIP_BASE;
 }
 
+/** @brief Obtain a pointer to memory-mapped flash
+ *  @param addr Offset from start of flash memory
+ *  @param size Number of bytes to be accessed
+ *  @retval const void* Location in memory-mapped flash, or nullptr if region is not mapped
+ *  @note Contents reflect the flash cache so must not be used for regions which are being written.
+ *  @note The entire flash is mapped so this only fails for invalid ranges
+ */
+const void* flashmem_get_pointer(uint32_t addr, uint32_t size);
+
+/** @brief Release a pointer obtained via `flashmem_get_pointer()`
+ *  @param ptr Value returned from `flashmem_get_pointer()`, may be null
+ *  @note Flash is permanently mapped on this architecture so this does nothing
+ */
+void flashmem_release_pointer(const void* ptr);
+
 /** @brief Write a block of data to flash
  *  @param from Buffer to obtain data from
  *  @param toaddr Flash location to start writing
@@ -109,6 +125,26 @@ uint32_t flashmem_write(const void* from, uint32_t toaddr, uint32_t size);
  */
 uint32_t flashmem_read(void* to, uint32_t fromaddr, uint32_t size);
 
+/** @brief Completion callback for `flashmem_read_async`
+ *  @param param Value passed to `flashmem_read_async`
+ *  @param success true if transfer completed successfully
+ *  @note Called in interrupt context
+ */
+typedef void (*flashmem_read_callback_t)(void* param, bool success);
+
+/** @brief Start a background read from flash
+ *  @param to Buffer to store data, must remain valid until transfer has completed
+ *  @param fromaddr Flash location to start reading
+ *  @param size Number of bytes to read
+ *  @param callback Invoked on completion
+ *  @param param Parameter passed to callback
+ *  @retval bool true if transfer started, false if unsupported or hardware busy
+ *  @note Caller should fall back to `flashmem_read` on failure
+ *  @note Uses DMA from the XIP streaming interface. Parameters must be word-aligned.
+ *  Only one transfer may be in progress; other flash operations wait for it to complete.
+ */
+bool flashmem_read_async(void* to, uint32_t fromaddr, uint32_t size, flashmem_read_callback_t callback, void* param);
+
 /** @brief Erase a single flash sector
  *  @param sector_id the sector to erase
  *  @retval true on success
@@ -0,0 +1,122 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/SmingHub/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * AdcSampler.cpp - DMA sampling for the RP2040
+ *
+ * The ADC free-runs at the requested rate, paced by its clock divider, and pushes results into its FIFO.
+ * Two DMA channels move samples from the FIFO into the blocks, each chained to the other
+ * so there is no gap between blocks. On completion a channel's write address is reset,
+ * ready for its next turn.
+ *
+ ****/
+
+#include <AdcSampler.h>
+#include <Digital.h>
+#include <hardware/adc.h>
+#include <hardware/dma.h>
+#include <hardware/irq.h>
+#include <debug_progmem.h>
+
+namespace
+{
+constexpr uint32_t adcClock{48000000};
+constexpr unsigned cyclesPerConversion{96};
+constexpr unsigned firstAdcPin{26};
+constexpr unsigned adcPinCount{4};
+
+AdcSampler* activeSampler;
+int dmaChannels[2]{-1, -1};
+bool irqInitialised;
+
+} // namespace
+
+bool AdcSampler::hardwareBegin(uint16_t pin)
+{
+	if(pin < firstAdcPin || pin >= firstAdcPin + adcPinCount) {
+		return false;
+	}
+
+	uint32_t div = adcClock / sampleRate;
+	if(div < cyclesPerConversion) {
+		return false;
+	}
+	sampleRate = adcClock / div;
+
+	for(auto& ch : dmaChannels) {
+		ch = dma_claim_unused_channel(false);
+		if(ch < 0) {
+			debug_e("[ADC] No free DMA channel");
+			hardwareEnd();
+			return false;
+		}
+	}
+
+	adc_init();
+	adc_gpio_init(pin);
+	adc_select_input(pin - firstAdcPin);
+	adc_fifo_setup(true, true, 1, false, false);
+	adc_set_clkdiv(div - 1);
+
+	for(unsigned i = 0; i < 2; ++i) {
+		auto dc = dma_channel_get_default_config(dmaChannels[i]);
+		channel_config_set_transfer_data_size(&dc, DMA_SIZE_16);
+		channel_config_set_read_increment(&dc, false);
+		channel_config_set_write_increment(&dc, true);
+		channel_config_set_dreq(&dc, DREQ_ADC);
+		channel_config_set_chain_to(&dc, dmaChannels[i ^ 1]);
+		dma_channel_configure(dmaChannels[i], &dc, getBlock(i), &adc_hw->fifo, blockSize, false);
+		dma_channel_acknowledge_irq0(dmaChannels[i]);
+		dma_channel_set_irq0_enabled(dmaChannels[i], true);
+	}
+
+	if(!irqInitialised) {
+		irq_add_shared_handler(
+			DMA_IRQ_0, []() { hardwareInterrupt(activeSampler); }, PICO_SHARED_IRQ_HANDLER_DEFAULT_ORDER_PRIORITY);
+		irq_set_enabled(DMA_IRQ_0, true);
+		irqInitialised = true;
+	}
+
+	activeSampler = this;
+	dma_channel_start(dmaChannels[0]);
+	adc_run(true);
+	return true;
+}
+
+void AdcSampler::hardwareEnd()
+{
+	adc_run(false);
+	activeSampler = nullptr;
+	for(auto& ch : dmaChannels) {
+		if(ch < 0) {
+			continue;
+		}
+		dma_channel_set_irq0_enabled(ch, false);
+		dma_channel_abort(ch);
+		dma_channel_acknowledge_irq0(ch);
+		dma_channel_unclaim(ch);
+		ch = -1;
+	}
+	adc_fifo_drain();
+}
+
+void AdcSampler::hardwareInterrupt(void* param)
+{
+	auto sampler = static_cast<AdcSampler*>(param);
+	if(sampler == nullptr) {
+		return;
+	}
+
+	for(unsigned i = 0; i < 2; ++i) {
+		auto ch = dmaChannels[i];
+		if(!dma_channel_get_irq0_status(ch)) {
+			continue;
+		}
+		dma_channel_acknowledge_irq0(ch);
+		// Transfer count is reloaded automatically when chained, but the address is not
+		dma_channel_set_write_addr(ch, sampler->getBlock(i), false);
+		sampler->blockComplete(i);
+	}
+}
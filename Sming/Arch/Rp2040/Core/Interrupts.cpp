@@ -12,6 +12,7 @@
 #include <Digital.h>
 #include <Platform/System.h>
 #include <BitManipulations.h>
+#include <Services/Profiling/InterruptTiming.h>
 
 namespace
 {
@@ -73,7 +74,7 @@ void IRAM_ATTR interruptHandler(uint gpio, uint32_t events)
 {
 	auto& handler = handlers[gpio];
 	if(handler.type == Handler::Type::interrupt) {
-		handler.interrupt();
+		Profiling::InterruptTiming::callHandler(gpio, handler.interrupt);
 	} else if(handler.type == Handler::Type::delegate) {
 		System.queueCallback(interruptDelegateCallback, gpio);
 	}
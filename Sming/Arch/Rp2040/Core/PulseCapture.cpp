@@ -0,0 +1,38 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/SmingHub/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * PulseCapture.cpp - Edge capture for the RP2040
+ *
+ * Edges are timestamped by a GPIO interrupt using the 1MHz system timer.
+ *
+ ****/
+
+#include <PulseCapture.h>
+#include <Digital.h>
+#include <hardware/gpio.h>
+#include <hardware/timer.h>
+
+bool PulseCapture::hardwareBegin()
+{
+	if(pin >= NUM_BANK0_GPIOS) {
+		return false;
+	}
+
+	lastLevel = gpio_get(pin);
+	lastTime = time_us_32();
+	return attachEdgeInterrupt();
+}
+
+void PulseCapture::hardwareEnd()
+{
+	detachEdgeInterrupt();
+}
+
+void PulseCapture::hardwareInterrupt(PulseCapture& capture)
+{
+	auto time = time_us_32();
+	capture.edgeCaptured(time, gpio_get(capture.pin));
+}
@@ -0,0 +1,41 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/SmingHub/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * digital_arch.h - Port-level GPIO access
+ *
+ * SIO provides set, clear and toggle registers, so all operations are a single write.
+ *
+ ****/
+
+#pragma once
+
+#include <hardware/structs/sio.h>
+
+__forceinline void IRAM_ATTR digitalSetMask(uint32_t mask)
+{
+	sio_hw->gpio_set = mask;
+}
+
+__forceinline void IRAM_ATTR digitalClearMask(uint32_t mask)
+{
+	sio_hw->gpio_clr = mask;
+}
+
+__forceinline void IRAM_ATTR digitalToggleMask(uint32_t mask)
+{
+	sio_hw->gpio_togl = mask;
+}
+
+__forceinline void IRAM_ATTR digitalWriteMask(uint32_t mask, uint32_t value)
+{
+	// Toggle only those bits which differ
+	sio_hw->gpio_togl = (sio_hw->gpio_out ^ value) & mask;
+}
+
+__forceinline uint32_t IRAM_ATTR digitalReadPort()
+{
+	return sio_hw->gpio_in;
+}
@@ -0,0 +1,202 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/SmingHub/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * twi_arch.cpp - Interrupt-driven I2C using the RP2040 controllers
+ *
+ * Each GPIO may be assigned to one I2C block: even pins carry SDA, odd pins SCL,
+ * and bit 1 of the pin number selects the block. Other pin combinations use the
+ * software state machine in Sming/Core/Wire.cpp.
+ *
+ ****/
+
+#include <Wire.h>
+#include <hardware/i2c.h>
+#include <hardware/irq.h>
+#include <debug_progmem.h>
+
+namespace
+{
+constexpr unsigned fifoDepth{16};
+
+TwoWire* hardwareInstance[NUM_I2CS];
+
+__forceinline i2c_hw_t* getHw(unsigned bus)
+{
+	return bus ? i2c1_hw : i2c0_hw;
+}
+
+} // namespace
+
+bool TwoWire::hardwareBegin()
+{
+	hardwareEnd();
+
+	if(twi_sda >= NUM_BANK0_GPIOS || twi_scl >= NUM_BANK0_GPIOS) {
+		return false;
+	}
+	if((twi_sda & 1) != 0 || (twi_scl & 1) == 0) {
+		return false;
+	}
+	unsigned bus = (twi_sda >> 1) & 1;
+	if(((twi_scl >> 1) & 1) != bus || hardwareInstance[bus] != nullptr) {
+		return false;
+	}
+
+	auto i2c = bus ? i2c1 : i2c0;
+	auto baud = i2c_init(i2c, frequency);
+	debug_d("[TWI] I2C%u %u baud", bus, baud);
+	(void)baud;
+	gpio_set_function(twi_sda, GPIO_FUNC_I2C);
+	gpio_set_function(twi_scl, GPIO_FUNC_I2C);
+	getHw(bus)->intr_mask = 0;
+
+	unsigned irq = bus ? I2C1_IRQ : I2C0_IRQ;
+	irq_set_exclusive_handler(irq, hardwareInterruptHandler);
+	irq_set_enabled(irq, true);
+
+	hardwareInstance[bus] = this;
+	hardwareBus = bus;
+	return true;
+}
+
+void TwoWire::hardwareEnd()
+{
+	if(hardwareBus < 0) {
+		return;
+	}
+
+	irq_set_enabled(hardwareBus ? I2C1_IRQ : I2C0_IRQ, false);
+	i2c_deinit(hardwareBus ? i2c1 : i2c0);
+	gpio_set_function(twi_sda, GPIO_FUNC_SIO);
+	gpio_set_function(twi_scl, GPIO_FUNC_SIO);
+	hardwareInstance[hardwareBus] = nullptr;
+	hardwareBus = -1;
+	busHeld = false;
+}
+
+void IRAM_ATTR TwoWire::hardwareStart()
+{
+	auto& trans = *queueHead;
+	active = &trans;
+	trans.error = I2C_ERR_SUCCESS;
+	cmdIndex = 0;
+	dataIndex = 0;
+
+	auto hw = getHw(hardwareBus);
+	hw->enable = 0;
+	hw->tar = trans.address;
+	hw->enable = 1;
+	(void)hw->clr_intr;
+	hw->intr_mask = I2C_IC_INTR_MASK_M_TX_EMPTY_BITS | I2C_IC_INTR_MASK_M_RX_FULL_BITS |
+					I2C_IC_INTR_MASK_M_STOP_DET_BITS | I2C_IC_INTR_MASK_M_TX_ABRT_BITS;
+}
+
+/*
+ * The controller cannot send an address on its own, so a probe reads one byte which is discarded
+ */
+void IRAM_ATTR TwoWire::hardwareService()
+{
+	auto hw = getHw(hardwareBus);
+	uint32_t stat = hw->intr_stat;
+	if(stat == 0) {
+		return;
+	}
+
+	auto& trans = *active;
+	unsigned rxCount = trans.rxLength;
+	unsigned cmdCount = trans.txLength + rxCount;
+	if(cmdCount == 0) {
+		rxCount = cmdCount = 1;
+	}
+
+	bool complete{false};
+	if(stat & I2C_IC_INTR_STAT_R_TX_ABRT_BITS) {
+		uint32_t source = hw->tx_abrt_source;
+		(void)hw->clr_tx_abrt;
+		if(source & I2C_IC_TX_ABRT_SOURCE_ABRT_7B_ADDR_NOACK_BITS) {
+			trans.error = I2C_ERR_ADDR_NACK;
+		} else if(source & I2C_IC_TX_ABRT_SOURCE_ABRT_TXDATA_NOACK_BITS) {
+			trans.error = I2C_ERR_DATA_NACK;
+		} else {
+			trans.error = I2C_ERR_LINE_BUSY;
+		}
+		// Controller always issues a STOP on abort
+		busHeld = false;
+		complete = true;
+	} else {
+		while(hw->rxflr != 0) {
+			uint8_t c = hw->data_cmd;
+			if(dataIndex < trans.rxLength) {
+				trans.rxData[dataIndex] = c;
+			}
+			++dataIndex;
+		}
+
+		// Don't issue more reads than the receive FIFO can hold
+		while(cmdIndex < cmdCount && hw->txflr < fifoDepth) {
+			uint32_t cmd;
+			if(cmdIndex < trans.txLength) {
+				cmd = trans.txData[cmdIndex];
+			} else if(cmdIndex - trans.txLength - dataIndex < fifoDepth) {
+				cmd = I2C_IC_DATA_CMD_CMD_BITS;
+			} else {
+				break;
+			}
+			if(cmdIndex == 0 ? busHeld : (cmdIndex == trans.txLength)) {
+				cmd |= I2C_IC_DATA_CMD_RESTART_BITS;
+			}
+			if(cmdIndex + 1 == cmdCount && trans.sendStop) {
+				cmd |= I2C_IC_DATA_CMD_STOP_BITS;
+			}
+			hw->data_cmd = cmd;
+			++cmdIndex;
+		}
+
+		if(stat & I2C_IC_INTR_STAT_R_STOP_DET_BITS) {
+			(void)hw->clr_stop_det;
+		}
+
+		if(cmdIndex == cmdCount && dataIndex >= rxCount) {
+			if(trans.sendStop) {
+				// Stop condition follows the final byte
+				hw->intr_mask &= ~I2C_IC_INTR_MASK_M_TX_EMPTY_BITS;
+				complete = (stat & I2C_IC_INTR_STAT_R_STOP_DET_BITS);
+			} else {
+				complete = (hw->raw_intr_stat & I2C_IC_RAW_INTR_STAT_TX_EMPTY_BITS);
+			}
+			if(complete) {
+				busHeld = !trans.sendStop;
+			}
+		} else if(cmdIndex == cmdCount) {
+			hw->intr_mask &= ~I2C_IC_INTR_MASK_M_TX_EMPTY_BITS;
+		}
+	}
+
+	if(!complete) {
+		return;
+	}
+
+	hw->intr_mask = 0;
+	auto next = dequeue();
+	if(next == nullptr) {
+		active = nullptr;
+	} else {
+		hardwareStart();
+	}
+
+	if(trans.callback != nullptr) {
+		trans.callback(trans);
+	}
+}
+
+void IRAM_ATTR TwoWire::hardwareInterruptHandler()
+{
+	for(auto wire : hardwareInstance) {
+		if(wire != nullptr && wire->active != nullptr) {
+			wire->hardwareService();
+		}
+	}
+}
@@ -21,3 +21,6 @@
 
 #define DEFAULT_SDA_PIN PICO_DEFAULT_I2C_SDA_PIN
 #define DEFAULT_SCL_PIN PICO_DEFAULT_I2C_SCL_PIN
+
+// Use I2C controller where pins allow, see twi_arch.cpp
+#define TWI_HARDWARE 1
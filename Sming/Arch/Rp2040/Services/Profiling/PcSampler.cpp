@@ -0,0 +1,91 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/SmingHub/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * PcSampler.cpp
+ *
+ */
+
+#include <Services/Profiling/PcSampler.h>
+#include <algorithm>
+#include <hardware/timer.h>
+#include <hardware/irq.h>
+
+namespace
+{
+int alarmNum{-1};
+uint32_t intervalTicks;
+} // namespace
+
+/*
+ * Called from sampleIsr with the interrupted program counter.
+ * Timer runs at 1MHz so ticks are microseconds.
+ */
+extern "C" void IRAM_ATTR pc_sampler_handler(uint32_t pc)
+{
+	hw_clear_bits(&timer_hw->intr, 1U << alarmNum);
+	timer_hw->alarm[alarmNum] = timer_hw->timerawl + intervalTicks;
+	Profiling::PcSampler::record(pc);
+}
+
+/*
+ * On exception entry the hardware stacks r0-r3, r12, lr, pc and xpsr, so the interrupted
+ * program counter is at offset 24. Bit 2 of EXC_RETURN indicates which stack was in use.
+ * The handler is entered directly from the vector table, so the frame is at the top of stack.
+ */
+extern "C" __attribute__((naked)) void IRAM_ATTR pc_sampler_isr()
+{
+	__asm__ volatile("movs r0, #4 \n"
+					 "mov r1, lr \n"
+					 "tst r0, r1 \n"
+					 "beq 1f \n"
+					 "mrs r0, psp \n"
+					 "b 2f \n"
+					 "1: \n"
+					 "mrs r0, msp \n"
+					 "2: \n"
+					 "ldr r0, [r0, #24] \n"
+					 "ldr r1, =pc_sampler_handler \n"
+					 "bx r1 \n"
+					 ".ltorg \n");
+}
+
+namespace Profiling
+{
+namespace PcSampler
+{
+bool startTimer(unsigned intervalUs)
+{
+	alarmNum = hardware_alarm_claim_unused(false);
+	if(alarmNum < 0) {
+		return false;
+	}
+
+	intervalTicks = std::max(intervalUs, 10U);
+	auto irq = TIMER_IRQ_0 + alarmNum;
+	irq_set_exclusive_handler(irq, pc_sampler_isr);
+	hw_set_bits(&timer_hw->inte, 1U << alarmNum);
+	irq_set_enabled(irq, true);
+	timer_hw->alarm[alarmNum] = timer_hw->timerawl + intervalTicks;
+	return true;
+}
+
+void stopTimer()
+{
+	if(alarmNum < 0) {
+		return;
+	}
+
+	auto irq = TIMER_IRQ_0 + alarmNum;
+	hw_clear_bits(&timer_hw->inte, 1U << alarmNum);
+	irq_set_enabled(irq, false);
+	irq_remove_handler(irq, pc_sampler_isr);
+	timer_hw->armed = 1U << alarmNum;
+	hardware_alarm_unclaim(alarmNum);
+	alarmNum = -1;
+}
+
+} // namespace PcSampler
+} // namespace Profiling
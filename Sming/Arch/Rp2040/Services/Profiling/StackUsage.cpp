@@ -0,0 +1,29 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/SmingHub/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * StackUsage.cpp
+ *
+ */
+
+#include <Services/Profiling/StackUsage.h>
+
+// Core 0 stack, set by linker
+extern char __StackBottom;
+extern char __StackTop;
+
+namespace Profiling
+{
+namespace StackUsage
+{
+bool getBounds(Bounds& bounds)
+{
+	bounds.bottom = uintptr_t(&__StackBottom);
+	bounds.top = uintptr_t(&__StackTop);
+	return true;
+}
+
+} // namespace StackUsage
+} // namespace Profiling
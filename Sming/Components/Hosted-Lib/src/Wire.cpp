@@ -19,6 +19,33 @@
 
 extern Hosted::Client* hostedClient;
 
+namespace
+{
+// Names as reported by __PRETTY_FUNCTION__ within the single-byte methods
+constexpr const char* writeByteFunction = "virtual size_t TwoWire::write(uint8_t)";
+constexpr const char* readFunction = "virtual int TwoWire::read()";
+
+// Bulk writes are sent in batches of this many bytes
+constexpr size_t writeBlockSize{32};
+
+/*
+ * Data received by requestFrom() is fetched in a single exchange and served from here
+ */
+struct RxCache {
+	uint8_t data[256];
+	unsigned length;
+	unsigned index;
+
+	unsigned available() const
+	{
+		return length - index;
+	}
+};
+
+RxCache rxCache;
+
+} // namespace
+
 void TwoWire::begin(uint8_t sda, uint8_t scl)
 {
 	hostedClient->send(__PRETTY_FUNCTION__, sda, scl);
@@ -58,7 +85,27 @@ void TwoWire::setClockStretchLimit(uint32_t limit)
 uint8_t TwoWire::requestFrom(uint8_t address, uint8_t size, bool sendStop)
 {
 	hostedClient->send(__PRETTY_FUNCTION__, address, size, sendStop);
-	return hostedClient->wait<uint8_t>();
+	auto count = hostedClient->wait<uint8_t>();
+
+	Hosted::RequestId ids[256];
+	{
+		Hosted::Client::Batch batch(*hostedClient);
+		for(unsigned i = 0; i < count; ++i) {
+			ids[i] = hostedClient->sendAsync<int>(readFunction);
+		}
+	}
+
+	rxCache.length = 0;
+	rxCache.index = 0;
+	for(unsigned i = 0; i < count && ids[i] != 0; ++i) {
+		int c = hostedClient->wait<int>(ids[i]);
+		if(c < 0) {
+			break;
+		}
+		rxCache.data[rxCache.length++] = c;
+	}
+
+	return count;
 }
 
 void TwoWire::beginTransmission(uint8_t address)
@@ -78,26 +125,61 @@ size_t TwoWire::write(uint8_t data)
 	return hostedClient->wait<size_t>();
 }
 
+/*
+ * The remote function can't accept a buffer, so send individual bytes in batches
+ * with responses pipelined to avoid a round trip for each one
+ */
 size_t TwoWire::write(const uint8_t* data, size_t quantity)
 {
-	hostedClient->send(__PRETTY_FUNCTION__, data, quantity);
-	return hostedClient->wait<size_t>();
+	size_t written{0};
+	while(quantity != 0) {
+		auto blockSize = std::min(quantity, writeBlockSize);
+		Hosted::RequestId ids[writeBlockSize];
+		{
+			Hosted::Client::Batch batch(*hostedClient);
+			for(unsigned i = 0; i < blockSize; ++i) {
+				ids[i] = hostedClient->sendAsync<size_t>(writeByteFunction, data[i]);
+			}
+		}
+		for(unsigned i = 0; i < blockSize; ++i) {
+			if(ids[i] == 0) {
+				return written;
+			}
+			written += hostedClient->wait<size_t>(ids[i]);
+		}
+		data += blockSize;
+		quantity -= blockSize;
+	}
+
+	return written;
 }
 
 int TwoWire::available()
 {
+	if(rxCache.available() != 0) {
+		return rxCache.available();
+	}
+
 	hostedClient->send(__PRETTY_FUNCTION__);
 	return hostedClient->wait<int>();
 }
 
 int TwoWire::read()
 {
+	if(rxCache.available() != 0) {
+		return rxCache.data[rxCache.index++];
+	}
+
 	hostedClient->send(__PRETTY_FUNCTION__);
 	return hostedClient->wait<int>();
 }
 
 int TwoWire::peek()
 {
+	if(rxCache.available() != 0) {
+		return rxCache.data[rxCache.index];
+	}
+
 	hostedClient->send(__PRETTY_FUNCTION__);
 	return hostedClient->wait<int>();
 }
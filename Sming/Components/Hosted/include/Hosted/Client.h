@@ -22,9 +22,11 @@
 #include <WString.h>
 #include <simpleRPC.h>
 #include <simpleRPC/parser.h>
+#include <Data/Stream/MemoryDataStream.h>
 #include <hostlib/emu.h>
 #include <hostlib/hostmsg.h>
 #include "Util.h"
+#include <deque>
 
 using namespace simpleRPC;
 
@@ -32,11 +34,45 @@ namespace Hosted
 {
 constexpr int COMMAND_NOT_FOUND = -1;
 
+/**
+ * @brief Identifies a pipelined request, 0 is never used
+ */
+using RequestId = uint32_t;
+
 class Client
 {
 public:
 	using RemoteCommands = HashMap<String, uint8_t>;
 
+	/**
+	 * @brief Queue all calls made during lifetime of this object and send them together
+	 *
+	 * Example:
+	 *
+	 * 		{
+	 * 			Hosted::Client::Batch batch(*hostedClient);
+	 * 			for(auto pin : pins) {
+	 * 				digitalWrite(pin, HIGH);
+	 * 			}
+	 * 		} // Calls are sent here
+	 */
+	class Batch
+	{
+	public:
+		Batch(Client& client) : client(client)
+		{
+			client.beginBatch();
+		}
+
+		~Batch()
+		{
+			client.endBatch();
+		}
+
+	private:
+		Client& client;
+	};
+
 	Client(Stream& stream, char methodEndsWith = ':') : stream(stream), methodEndsWith(methodEndsWith)
 	{
 	}
@@ -64,28 +100,135 @@ public:
 			return false;
 		}
 
-		rpcPrint(stream, uint8_t(functionId), args...);
-		stream.flush();
+		// Encode into buffer so transport sees a single write
+		rpcPrint(txBuffer, uint8_t(functionId), args...);
+		if(batchDepth == 0) {
+			commit();
+		}
 
 		return true;
 	}
 
+	/**
+	 * @brief Send a command without waiting for its result
+	 * @tparam R Return type of the remote function
+	 * @param functionName See `send()`
+	 * @param variable arguments
+	 * @retval RequestId Use to retrieve the response via `wait(RequestId)` or `poll()`, 0 on error
+	 *
+	 * Any number of requests may be outstanding. The server responds in order, so responses
+	 * are matched to requests using the sequence ID.
+	 */
+	template <typename R, typename... Args> RequestId sendAsync(const String& functionName, Args... args)
+	{
+		if(!send(functionName, args...)) {
+			return 0;
+		}
+
+		if(++lastRequestId == 0) {
+			++lastRequestId;
+		}
+		pending.push_back(PendingRequest{lastRequestId, sizeof(R)});
+		return lastRequestId;
+	}
+
 	/**
 	 * @brief This method will block the execution until a message is detected
 	 * @retval HostedCommand
+	 * @note Responses to any outstanding pipelined requests are read and retained first
 	 */
 	template <typename R> R wait()
 	{
-		size_t neededBytes = sizeof(R);
+		while(!pending.empty()) {
+			auto& req = pending.front();
+			readResponse(req.size, completed[req.id], true);
+			pending.pop_front();
+		}
+
+		String data;
+		readResponse(sizeof(R), data, true);
+		return getResult<R>(data);
+	}
+
+	/**
+	 * @brief Block until the response to a pipelined request is available
+	 * @param id Value returned from `sendAsync()`
+	 */
+	template <typename R> R wait(RequestId id)
+	{
+		String data;
+		fetchResponse(id, data, true);
+		return getResult<R>(data);
+	}
+
+	/**
+	 * @brief Check for the response to a pipelined request without blocking
+	 * @param id Value returned from `sendAsync()`
+	 * @param result On success, the returned value
+	 * @retval bool true if response was available, false if not yet received or id is unknown
+	 */
+	template <typename R> bool poll(RequestId id, R& result)
+	{
+		String data;
+		if(!fetchResponse(id, data, false)) {
+			return false;
+		}
+		result = getResult<R>(data);
+		return true;
+	}
+
+	/**
+	 * @brief Start queuing commands instead of sending them immediately
+	 *
+	 * Calls may be nested, with commands sent when the outermost batch ends.
+	 * Prefer the `Batch` helper class which ensures this is done correctly.
+	 */
+	void beginBatch()
+	{
+		++batchDepth;
+	}
 
-		while(stream.available() < int(neededBytes)) {
+	/**
+	 * @brief End a batch started by `beginBatch()`
+	 */
+	void endBatch()
+	{
+		if(batchDepth == 0) {
+			return;
+		}
+		--batchDepth;
+		if(batchDepth == 0) {
+			commit();
+		}
+	}
+
+	/**
+	 * @brief Send any queued commands as a single block
+	 *
+	 * This is done automatically by `endBatch()` and before waiting for a response.
+	 */
+	void commit()
+	{
+		auto length = txBuffer.available();
+		if(length > 0) {
+			stream.write(reinterpret_cast<const uint8_t*>(txBuffer.getStreamPointer()), length);
 			stream.flush();
-			host_main_loop();
 		}
+		txBuffer.clear();
+	}
 
-		R result{};
-		stream.readBytes(reinterpret_cast<char*>(&result), sizeof(result));
-		return result;
+	/**
+	 * @brief Discard any queued commands and outstanding responses
+	 *
+	 * Call this when the transport has reconnected. The remote command table is retained
+	 * so calls may continue without repeating the negotiation.
+	 * Use `getRemoteCommands()` if the server firmware may have changed.
+	 */
+	void reset()
+	{
+		txBuffer.clear();
+		pending.clear();
+		completed.clear();
 	}
 
 	/**
@@ -93,23 +236,32 @@ public:
 	 * @param name command name to query
 	 * @retval -1 if not found. Otherwise the id of the function
 	 */
-	int getFunctionId(String name)
+	int getFunctionId(const String& name)
 	{
 		if(fetchCommands) {
 			getRemoteCommands();
 		}
 
+		// Avoid converting signatures on every call
+		int i = functionIds.indexOf(name);
+		if(i >= 0) {
+			return functionIds.valueAt(i);
+		}
+
+		String key = name;
 		if(name.indexOf('(') != -1 && name.indexOf(')') != -1) {
 			// most probably we have a name with a signature
-			name = convertFQN(name);
+			key = convertFQN(name);
 		}
 
-		int id = commands.indexOf(name);
-		if(id < 0) {
+		i = commands.indexOf(key);
+		if(i < 0) {
 			return COMMAND_NOT_FOUND;
 		}
 
-		return commands[name];
+		uint8_t id = commands.valueAt(i);
+		functionIds[name] = id;
+		return id;
 	}
 
 	/**
@@ -164,9 +316,77 @@ public:
 	}
 
 private:
+	struct PendingRequest {
+		RequestId id;
+		size_t size;
+	};
+
+	template <typename R> static R getResult(const String& data)
+	{
+		R result{};
+		memcpy(&result, data.c_str(), std::min(sizeof(result), size_t(data.length())));
+		return result;
+	}
+
+	bool readResponse(size_t size, String& data, bool block)
+	{
+		commit();
+
+		while(stream.available() < int(size)) {
+			if(!block) {
+				return false;
+			}
+			stream.flush();
+			host_main_loop();
+		}
+
+		data.setLength(size);
+		stream.readBytes(data.begin(), size);
+		return true;
+	}
+
+	bool fetchResponse(RequestId id, String& data, bool block)
+	{
+		int i = completed.indexOf(id);
+		if(i >= 0) {
+			data = completed.valueAt(i);
+			completed.removeAt(i);
+			return true;
+		}
+
+		auto isRequest = [id](const PendingRequest& req) { return req.id == id; };
+		if(std::find_if(pending.begin(), pending.end(), isRequest) == pending.end()) {
+			host_debug_w("Unknown request #%u", id);
+			return false;
+		}
+
+		// Responses arrive in order, so retain any for earlier requests
+		while(!pending.empty()) {
+			auto req = pending.front();
+			String response;
+			if(!readResponse(req.size, response, block)) {
+				return false;
+			}
+			pending.pop_front();
+			if(req.id == id) {
+				data = std::move(response);
+				return true;
+			}
+			completed[req.id] = std::move(response);
+		}
+
+		return false;
+	}
+
 	Stream& stream;
+	MemoryDataStream txBuffer;
+	std::deque<PendingRequest> pending;
+	HashMap<RequestId, String> completed;
+	RequestId lastRequestId{0};
+	unsigned batchDepth{0};
 	bool fetchCommands{true};
 	RemoteCommands commands;
+	RemoteCommands functionIds; ///< Resolved names as passed to `getFunctionId()`
 	uint8_t methodPosition = 0;
 	String name;
 	String signature;
@@ -176,6 +396,7 @@ private:
 	{
 		methodPosition = 0;
 		commands.clear();
+		functionIds.clear();
 	}
 
 	void startMethod()
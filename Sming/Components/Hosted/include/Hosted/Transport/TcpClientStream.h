@@ -15,18 +15,54 @@
 
 #include <Network/TcpServer.h>
 #include <Data/Buffer/CircularBuffer.h>
+#include <Data/Stream/MemoryDataStream.h>
+#include <SimpleTimer.h>
+#include <Clock.h>
 
 namespace Hosted
 {
 namespace Transport
 {
+/**
+ * @brief Stream adapter for a TCP connection
+ *
+ * Nagle's algorithm is always disabled by `TcpConnection`, so frames are not held back waiting
+ * for acknowledgements. Outgoing data is buffered here and handed to TCP according to the selected `Mode`.
+ */
 class TcpClientStream : public Stream
 {
 public:
+	enum class Mode {
+		latency,	///< Send each frame as soon as it's flushed
+		throughput, ///< Coalesce frames flushed within a short window into fewer segments
+	};
+
+	struct Stats {
+		uint32_t framesOut;	  ///< Number of flush() calls, typically one per RPC frame
+		uint32_t segmentsOut; ///< Writes handed to TCP
+		uint32_t bytesOut;
+		uint32_t bytesIn;
+		uint32_t stalls; ///< Times sending was deferred by the flow-control window
+		uint32_t rttCount;
+		uint32_t rttLast; ///< Time in microseconds from sending data until a response arrived
+		uint32_t rttMin;
+		uint32_t rttMax;
+		uint64_t rttTotal;
+
+		uint32_t rttAverage() const
+		{
+			return rttCount ? rttTotal / rttCount : 0;
+		}
+	};
+
+	static constexpr unsigned defaultCoalesceWindow{200}; ///< Microseconds
+
 	TcpClientStream(TcpClient& client, size_t cbufferSize = 1024, size_t threshold = 400)
-		: cBuffer(cbufferSize), client(client), pendingBytes(0), threshold(threshold)
+		: cBuffer(cbufferSize), client(client), threshold(threshold)
 	{
 		client.setReceiveDelegate(TcpClientDataDelegate(&TcpClientStream::store, this));
+		timer.initializeUs(
+			defaultCoalesceWindow, [](void* arg) { static_cast<TcpClientStream*>(arg)->send(); }, this);
 	}
 
 	void setClient(TcpClient& client)
@@ -34,8 +70,62 @@ public:
 		this->client = client;
 	}
 
+	/**
+	 * @brief Select how outgoing frames are sent
+	 * @param mode
+	 * @param coalesceWindow For throughput mode, maximum time in microseconds a frame is held back
+	 */
+	void setMode(Mode mode, unsigned coalesceWindow = defaultCoalesceWindow)
+	{
+		this->mode = mode;
+		timer.setIntervalUs(coalesceWindow);
+	}
+
+	Mode getMode() const
+	{
+		return mode;
+	}
+
+	/**
+	 * @brief Set flow-control window
+	 * @param bytes Maximum unacknowledged data passed to TCP, 0 for no limit other than the TCP send buffer
+	 *
+	 * Each write consumes credit which is returned as the peer acknowledges data.
+	 * When no credit remains, outgoing data is held here and retried once per coalescing window.
+	 * This prevents a burst of calls filling the TCP send queue and delaying later, urgent requests.
+	 */
+	void setWindow(size_t bytes)
+	{
+		window = bytes;
+	}
+
+	const Stats& getStats() const
+	{
+		return stats;
+	}
+
+	void resetStats()
+	{
+		stats = Stats{};
+	}
+
 	bool push(const uint8_t* buffer, size_t size)
 	{
+		stats.bytesIn += size;
+		if(rttPending) {
+			uint32_t rtt = micros() - rttStart;
+			rttPending = false;
+			stats.rttLast = rtt;
+			if(stats.rttCount == 0 || rtt < stats.rttMin) {
+				stats.rttMin = rtt;
+			}
+			if(rtt > stats.rttMax) {
+				stats.rttMax = rtt;
+			}
+			stats.rttTotal += rtt;
+			++stats.rttCount;
+		}
+
 		size_t written = cBuffer.write(buffer, size);
 		return (written == size);
 	}
@@ -47,21 +137,17 @@ public:
 
 	size_t write(const uint8_t* buffer, size_t size) override
 	{
-		if(client.send(reinterpret_cast<const char*>(buffer), size)) {
-			pendingBytes += size;
-			if(pendingBytes > threshold) {
-				pendingBytes = 0;
-				client.commit();
-			}
-			return size;
+		size_t written = txBuffer.write(buffer, size);
+		stats.bytesOut += written;
+		if(size_t(txBuffer.available()) >= threshold) {
+			send();
 		}
-
-		return 0;
+		return written;
 	}
 
 	size_t write(uint8_t c) override
 	{
-		return cBuffer.write(c);
+		return write(&c, 1);
 	}
 
 	int available() override
@@ -79,21 +165,75 @@ public:
 		return cBuffer.read();
 	}
 
+	/**
+	 * @brief Marks the end of a frame
+	 */
 	void flush() override
 	{
-		client.commit();
+		++stats.framesOut;
+		if(mode == Mode::latency) {
+			send();
+		} else if(!timer.isStarted()) {
+			timer.startOnce();
+		}
 	}
 
 private:
 	CircularBuffer cBuffer;
+	MemoryDataStream txBuffer;
 	TcpClient& client;
-	size_t pendingBytes;
+	SimpleTimer timer;
+	Stats stats{};
 	size_t threshold;
+	size_t window{0};
+	uint32_t rttStart{0};
+	Mode mode{Mode::latency};
+	bool rttPending{false};
 
 	bool store(TcpClient& client, char* data, int size)
 	{
 		return push(reinterpret_cast<const uint8_t*>(data), size);
 	}
+
+	/*
+	 * Pass as much buffered data to TCP as the window permits
+	 */
+	void send()
+	{
+		timer.stop();
+
+		while(txBuffer.available() > 0) {
+			size_t space = client.getAvailableWriteSize();
+			if(window != 0) {
+				size_t inFlight = TCP_SND_BUF - space;
+				space = (inFlight < window) ? std::min(space, window - inFlight) : 0;
+			}
+			if(space == 0) {
+				++stats.stalls;
+				timer.startOnce();
+				break;
+			}
+
+			size_t len = std::min(size_t(txBuffer.available()), space);
+			int written = client.write(txBuffer.getStreamPointer(), len);
+			if(written <= 0) {
+				timer.startOnce();
+				break;
+			}
+			txBuffer.seek(written);
+			++stats.segmentsOut;
+			if(!rttPending) {
+				rttStart = micros();
+				rttPending = true;
+			}
+		}
+
+		if(txBuffer.available() == 0) {
+			txBuffer.clear();
+		}
+
+		client.flush();
+	}
 };
 
 } // namespace Transport
@@ -35,10 +35,15 @@ public:
 		delete stream;
 	}
 
+	TcpClientStream& getStream()
+	{
+		return *stream;
+	}
+
 protected:
 	bool process(TcpClient& client, char* data, int size) override
 	{
-		if(!stream.push(data, size)) {
+		if(!stream->push(reinterpret_cast<const uint8_t*>(data), size)) {
 			return false;
 		}
 
@@ -32,6 +32,28 @@ public:
 		server.setClientReceiveHandler(TcpClientDataDelegate(&TcpServerTransport::process, this));
 	}
 
+	/**
+	 * @brief Set transmission mode for client connections
+	 * @see See `TcpClientStream::setMode()` and `TcpClientStream::setWindow()`
+	 * @note Applies to clients which connect after this call
+	 */
+	void setMode(TcpClientStream::Mode mode, unsigned coalesceWindow = TcpClientStream::defaultCoalesceWindow,
+				 size_t window = 0)
+	{
+		this->mode = mode;
+		this->coalesceWindow = coalesceWindow;
+		this->window = window;
+	}
+
+	/**
+	 * @brief Get stream for a connected client, e.g. to obtain statistics
+	 * @retval TcpClientStream* nullptr if client has not sent any data
+	 */
+	TcpClientStream* getStream(TcpClient& client)
+	{
+		return map.find(&client);
+	}
+
 protected:
 	bool process(TcpClient& client, char* data, int size) override
 	{
@@ -40,6 +62,8 @@ protected:
 		TcpClientStream* stream = map.find(key);
 		if(stream == nullptr) {
 			map[key] = stream = new TcpClientStream(client);
+			stream->setMode(mode, coalesceWindow);
+			stream->setWindow(window);
 			client.setReceiveDelegate(TcpClientDataDelegate(&TcpServerTransport::process, this));
 			stream = map[key];
 		}
@@ -53,6 +77,9 @@ protected:
 
 private:
 	ClientMap map;
+	TcpClientStream::Mode mode{TcpClientStream::Mode::latency};
+	unsigned coalesceWindow{TcpClientStream::defaultCoalesceWindow};
+	size_t window{0};
 };
 
 } // namespace Transport
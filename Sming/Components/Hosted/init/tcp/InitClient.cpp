@@ -39,8 +39,21 @@ extern void init();
 
 namespace
 {
+constexpr uint16_t port{4031};
+
 TcpClient* tcpClient = nullptr;
 Hosted::Transport::TcpClientStream* stream = nullptr;
+IpAddress remoteIp;
+
+/*
+ * The command table is kept so calls can resume as soon as the connection is restored
+ */
+void connectionClosed(TcpClient& client, bool successful)
+{
+	host_debug_w("Hosted connection closed, reconnecting");
+	hostedClient->reset();
+	client.connect(remoteIp, port);
+}
 
 static void ready(IpAddress ip, IpAddress mask, IpAddress gateway)
 {
@@ -48,13 +61,14 @@ static void ready(IpAddress ip, IpAddress mask, IpAddress gateway)
 		return;
 	}
 
-	IpAddress remoteIp(REMOTE_IP);
+	remoteIp = IpAddress(REMOTE_IP);
 	if(gateway == IpAddress("192.168.4.1")) {
 		remoteIp = gateway;
 	}
 
 	tcpClient = new TcpClient(false);
-	tcpClient->connect(remoteIp, 4031);
+	tcpClient->setCompleteDelegate(connectionClosed);
+	tcpClient->connect(remoteIp, port);
 	stream = new Hosted::Transport::TcpClientStream(*tcpClient);
 
 	hostedClient = new Hosted::Client(*stream, '>');
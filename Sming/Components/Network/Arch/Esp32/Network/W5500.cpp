@@ -71,6 +71,7 @@ bool W5500Service::begin(const Config& config)
 
 	netif_glue = esp_eth_new_netif_glue(handle);
 	CHECK_RET(esp_netif_attach(netif, netif_glue));
+	enableInputHandler();
 	CHECK_RET(esp_eth_start(handle));
 
 	return true;
@@ -13,6 +13,9 @@
 #include <esp_netif.h>
 #include <esp_event.h>
 #include <debug_progmem.h>
+#if CONFIG_ETH_USE_ESP32_EMAC
+#include <soc/emac_dma_struct.h>
+#endif
 
 using namespace Ethernet;
 
@@ -43,6 +46,12 @@ bool EmbeddedEthernet::begin(const Config& config)
 	if(config.smiMdioPin != PIN_DEFAULT) {
 		mac_config.smi_mdio_gpio_num = config.smiMdioPin;
 	}
+	if(config.rxTaskStackSize != 0) {
+		mac_config.rx_task_stack_size = config.rxTaskStackSize;
+	}
+	if(config.rxTaskPriority != 0) {
+		mac_config.rx_task_prio = config.rxTaskPriority;
+	}
 	mac = esp_eth_mac_new_esp32(&mac_config);
 	if(mac == nullptr) {
 		debug_e("[ETH] Failed to construct MAC");
@@ -59,8 +68,27 @@ bool EmbeddedEthernet::begin(const Config& config)
 	ESP_ERROR_CHECK(esp_eth_driver_install(&eth_config, &handle));
 	netif_glue = esp_eth_new_netif_glue(handle);
 	ESP_ERROR_CHECK(esp_netif_attach(netif, netif_glue));
+	enableInputHandler();
 	ESP_ERROR_CHECK(esp_eth_start(handle));
 
 	return true;
 #endif
 }
+
+Statistics EmbeddedEthernet::getStatistics()
+{
+#if CONFIG_ETH_USE_ESP32_EMAC
+	if(mac != nullptr) {
+		/*
+		 * Missed frame counters clear on read.
+		 * Bits 0-15: frames missed because no receive descriptor was available
+		 * Bits 17-27: frames missed because of a receive FIFO overflow
+		 */
+		uint32_t missed = EMAC_DMA.dmamissedfr.val;
+		stats.rxMissed += missed & 0xffff;
+		stats.rxOverflow += (missed >> 17) & 0x07ff;
+	}
+#endif
+
+	return stats;
+}
@@ -61,6 +61,33 @@ void IdfService::enableEventCallback(bool enable)
 	}
 }
 
+void IdfService::enableInputHandler()
+{
+	/*
+	 * Received frames are passed to lwIP by reference (PBUF_REF) so there is no further copying here.
+	 * Counters are updated from the MAC receive task only.
+	 */
+	auto handler = [](esp_eth_handle_t eth_handle, uint8_t* buffer, uint32_t length, void* priv) -> esp_err_t {
+		auto service = static_cast<IdfService*>(priv);
+		auto err = esp_netif_receive(service->netif, buffer, length, nullptr);
+		if(err == ESP_OK) {
+			++service->stats.rxFrames;
+			service->stats.rxBytes += length;
+		} else {
+			++service->stats.rxDropped;
+		}
+		return err;
+	};
+
+	stats = {};
+	ESP_ERROR_CHECK(esp_eth_update_input_path(handle, handler, this));
+}
+
+Statistics IdfService::getStatistics()
+{
+	return stats;
+}
+
 void IdfService::enableGotIpCallback(bool enable)
 {
 	auto handler = [](void* arg, esp_event_base_t event_base, int32_t event_id, void* event_data) {
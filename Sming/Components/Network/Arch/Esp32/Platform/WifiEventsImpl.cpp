@@ -10,6 +10,7 @@
 #include "WifiEventsImpl.h"
 #include "StationImpl.h"
 #include <debug_progmem.h>
+#include <Services/Profiling/BootTimeline.h>
 
 WifiEventsClass& WifiEvents{SmingInternal::Network::events};
 
@@ -30,8 +31,10 @@ void WifiEventsImpl::eventHandler(esp_event_base_t base, int32_t id, void* data)
 	if(base == WIFI_EVENT) {
 		switch(id) {
 		case WIFI_EVENT_STA_START:
+			BOOT_PHASE_MARK(wifiStart);
 			break;
 		case WIFI_EVENT_STA_CONNECTED: {
+			BOOT_PHASE_MARK(wifiConnected);
 			wifi_event_sta_connected_t* event = reinterpret_cast<wifi_event_sta_connected_t*>(data);
 			debugf("connect to ssid %s, channel %d\n", event->ssid, event->channel);
 			if(onSTAConnect) {
@@ -101,6 +104,7 @@ void WifiEventsImpl::eventHandler(esp_event_base_t base, int32_t id, void* data)
 	} else if(base == IP_EVENT) {
 		switch(id) {
 		case IP_EVENT_STA_GOT_IP: {
+			BOOT_PHASE_MARK(wifiGotIp);
 			ip_event_got_ip_t* event = reinterpret_cast<ip_event_got_ip_t*>(data);
 			debugf("ip:" IPSTR ",mask:" IPSTR ",gw:" IPSTR "\n", IP2STR(&event->ip_info.ip),
 				   IP2STR(&event->ip_info.netmask), IP2STR(&event->ip_info.gw));
@@ -42,6 +42,15 @@ struct esp_netif_obj;
  * Note: Configuring clock options must be done via SDK (make sdk-menuconfig).
  * ESP-IDF v4.4 will add the ability to override these in software.
  *
+ * The number and size of DMA buffers are also SDK settings:
+ *
+ * 		CONFIG_ETH_DMA_RX_BUFFER_NUM	Default 10
+ * 		CONFIG_ETH_DMA_TX_BUFFER_NUM	Default 10
+ * 		CONFIG_ETH_DMA_BUFFER_SIZE		Default 512 bytes
+ *
+ * If `getStatistics()` reports missed frames, increase the number of receive buffers
+ * or the priority of the receive task.
+ *
  * The following connections are optional:
  *
  * 		PHY_RESET -     OUT (set via PhyConfig)
@@ -53,10 +62,14 @@ public:
 		Ethernet::PhyConfig phy;
 		int8_t smiMdcPin = Ethernet::PIN_DEFAULT;  //< SMI MDC GPIO number
 		int8_t smiMdioPin = Ethernet::PIN_DEFAULT; //< SMI MDIO GPIO number
+		uint16_t rxTaskStackSize = 0;			   //< Stack size for MAC receive task, 0 for default
+		uint8_t rxTaskPriority = 0;				   //< Priority of MAC receive task, 0 for default
 	};
 
 	using IdfService::IdfService;
 
+	Ethernet::Statistics getStatistics() override;
+
 	/**
 	 * @brief Configure and start the ethernet service
 	 * @param config Configuration options
@@ -41,11 +41,18 @@ public:
 	bool setIP(IpAddress address, IpAddress netmask, IpAddress gateway) override;
 	bool isEnabledDHCP() const override;
 	bool enableDHCP(bool enable) override;
+	Statistics getStatistics() override;
 
 protected:
 	void enableEventCallback(bool enable);
 	void enableGotIpCallback(bool enable);
 
+	/**
+	 * @brief Route received frames via our handler so they can be counted
+	 * @note Call after attaching the driver to netif
+	 */
+	void enableInputHandler();
+
 	PhyFactory& phyFactory;
 	void* handle{nullptr};
 	esp_netif_obj* netif{nullptr};
@@ -53,6 +60,7 @@ protected:
 	esp_eth_mac_s* mac{nullptr};
 	esp_eth_phy_s* phy{nullptr};
 	Event state{Event::Disconnected};
+	Statistics stats{};
 };
 
 } // namespace Ethernet
@@ -10,10 +10,90 @@
 
 #include "StationImpl.h"
 #include <Interrupts.h>
+#include <Platform/RTC.h>
+#include <Services/Profiling/BootTimeline.h>
+#include <lwip/init.h>
+#include <lwip/dns.h>
+#include <esp_rtc_map.h>
 
 static StationImpl station;
 StationClass& WifiStation = station;
 
+namespace
+{
+/*
+ * Connection details kept in RTC memory for fast connect.
+ */
+struct FastConnectRecord {
+	uint32_t magic;
+	uint32_t ssidHash;
+	uint32_t timestamp; ///< RTC seconds when lease was obtained
+	uint8_t bssid[6];
+	uint8_t channel;
+	uint8_t reserved;
+	uint32_t ip;
+	uint32_t netmask;
+	uint32_t gateway;
+	uint32_t dns;
+	uint32_t checksum;
+};
+
+static_assert(sizeof(FastConnectRecord) % 4 == 0, "FastConnectRecord must be word-aligned");
+static_assert(sizeof(FastConnectRecord) <= RTC_MAP_FAST_CONNECT_SIZE * 4, "FastConnectRecord too large for RTC map");
+
+constexpr uint8_t fastConnectRtcAddress{RTC_MAP_FAST_CONNECT_ADDR};
+constexpr uint32_t fastConnectMagic{0x46434e31}; // "FCN1"
+
+uint32_t fnv1a(const void* data, size_t length)
+{
+	uint32_t hash{2166136261U};
+	auto p = static_cast<const uint8_t*>(data);
+	while(length-- != 0) {
+		hash = (hash ^ *p++) * 16777619U;
+	}
+	return hash;
+}
+
+uint32_t getSsidHash(const station_config& config)
+{
+	return fnv1a(config.ssid, strnlen(reinterpret_cast<const char*>(config.ssid), sizeof(config.ssid)));
+}
+
+bool readFastConnect(FastConnectRecord& rec)
+{
+	return system_rtc_mem_read(fastConnectRtcAddress, &rec, sizeof(rec)) && rec.magic == fastConnectMagic &&
+		   rec.checksum == fnv1a(&rec, offsetof(FastConnectRecord, checksum));
+}
+
+void writeFastConnect(FastConnectRecord& rec)
+{
+	rec.magic = fastConnectMagic;
+	rec.checksum = fnv1a(&rec, offsetof(FastConnectRecord, checksum));
+	system_rtc_mem_write(fastConnectRtcAddress, &rec, sizeof(rec));
+}
+
+void clearFastConnect()
+{
+	FastConnectRecord rec{};
+	system_rtc_mem_write(fastConnectRtcAddress, &rec, sizeof(rec));
+}
+
+void restartDhcp()
+{
+	wifi_station_dhcpc_start();
+}
+
+IpAddress getDnsServer()
+{
+#if LWIP_VERSION_MAJOR == 1
+	return dns_getserver(0);
+#else
+	return *dns_getserver(0);
+#endif
+}
+
+} // namespace
+
 class BssInfoImpl : public BssInfo
 {
 public:
@@ -38,6 +118,7 @@ void StationImpl::enable(bool enabled, bool save)
 	}
 	if(enabled) {
 		mode |= STATION_MODE;
+		BOOT_PHASE_MARK(wifiStart);
 	}
 	if(save) {
 		wifi_set_opmode(mode);
@@ -320,6 +401,117 @@ void StationImpl::staticScanCompleted(void* arg, STATUS status)
 	}
 }
 
+bool StationImpl::setFastConnect(bool enable, uint32_t maxAge)
+{
+	if(!enable) {
+		fastConnectMaxAge = 0;
+		fastConnecting = false;
+		clearFastConnect();
+		return true;
+	}
+
+	fastConnectMaxAge = (maxAge != 0) ? maxAge : 1;
+
+	// Saved details can only be applied before the station starts connecting
+	if(System.isReady() || !isEnabled() || !isEnabledDHCP()) {
+		return true;
+	}
+
+	FastConnectRecord rec;
+	if(!readFastConnect(rec)) {
+		return true;
+	}
+
+	station_config config{};
+	if(!wifi_station_get_config(&config) || rec.ssidHash != getSsidHash(config) ||
+	   RTC.getRtcSeconds() - rec.timestamp > fastConnectMaxAge) {
+		clearFastConnect();
+		return true;
+	}
+
+	config.bssid_set = true;
+	memcpy(config.bssid, rec.bssid, sizeof(config.bssid));
+	if(!wifi_station_set_config_current(&config)) {
+		return true;
+	}
+	wifi_set_channel(rec.channel);
+
+	wifi_station_dhcpc_stop();
+	ip_info info{};
+	info.ip.addr = rec.ip;
+	info.netmask.addr = rec.netmask;
+	info.gw.addr = rec.gateway;
+	wifi_set_ip_info(STATION_IF, &info);
+	ip_addr_t dns = IpAddress(rec.dns);
+	dns_setserver(0, &dns);
+
+	fastConnecting = true;
+	debug_i("[WIFI] Fast connect to " MACSTR " on channel %u", MAC2STR(rec.bssid), rec.channel);
+	return true;
+}
+
+void StationImpl::onWifiEvent(const System_Event_t& evt)
+{
+	if(fastConnectMaxAge == 0) {
+		return;
+	}
+
+	switch(evt.event) {
+	case EVENT_STAMODE_CONNECTED:
+		memcpy(connectedBssid, evt.event_info.connected.bssid, sizeof(connectedBssid));
+		connectedChannel = evt.event_info.connected.channel;
+		break;
+
+	case EVENT_STAMODE_GOT_IP: {
+		if(fastConnecting) {
+			/*
+			 * Connected using saved address. Now hand over to DHCP so the lease gets renewed,
+			 * which normally re-binds to the same address. Saved details are refreshed
+			 * by the resulting GOT_IP event.
+			 */
+			fastConnecting = false;
+			System.queueCallback(restartDhcp);
+			break;
+		}
+		if(!isEnabledDHCP()) {
+			break;
+		}
+		station_config config{};
+		if(!wifi_station_get_config(&config)) {
+			break;
+		}
+		FastConnectRecord rec{};
+		rec.ssidHash = getSsidHash(config);
+		rec.timestamp = RTC.getRtcSeconds();
+		memcpy(rec.bssid, connectedBssid, sizeof(rec.bssid));
+		rec.channel = connectedChannel;
+		rec.ip = evt.event_info.got_ip.ip.addr;
+		rec.netmask = evt.event_info.got_ip.mask.addr;
+		rec.gateway = evt.event_info.got_ip.gw.addr;
+		rec.dns = getDnsServer();
+		writeFastConnect(rec);
+		break;
+	}
+
+	case EVENT_STAMODE_DISCONNECTED:
+		if(fastConnecting) {
+			// Revert to normal configuration; SDK will retry connection
+			debug_w("[WIFI] Fast connect failed, reason %u", evt.event_info.disconnected.reason);
+			fastConnecting = false;
+			clearFastConnect();
+			station_config config{};
+			if(wifi_station_get_config_default(&config)) {
+				wifi_station_set_config_current(&config);
+			}
+			wifi_station_dhcpc_start();
+		}
+		break;
+
+	default:
+		break;
+	}
+}
+
 void StationImpl::onSystemReady()
 {
 	if(runScan) {
@@ -49,6 +49,12 @@ public:
 	int8_t getRssi() const override;
 	uint8_t getChannel() const override;
 	bool startScan(ScanCompletedDelegate scanCompleted) override;
+	bool setFastConnect(bool enable, uint32_t maxAge) override;
+
+	/**
+	 * @brief Called by WifiEventsImpl to keep fast connect details up to date
+	 */
+	void onWifiEvent(const System_Event_t& evt);
 
 #ifdef ENABLE_SMART_CONFIG
 	bool smartConfigStart(SmartConfigType sctype, SmartConfigDelegate callback) override;
@@ -74,6 +80,10 @@ private:
 
 private:
 	bool runScan = false;
+	bool fastConnecting = false;	 ///< Using saved details, not yet got IP
+	uint32_t fastConnectMaxAge = 0; ///< 0 if fast connect disabled
+	uint8_t connectedBssid[6]{};	 ///< From last EVENT_STAMODE_CONNECTED
+	uint8_t connectedChannel = 0;
 #ifdef ENABLE_SMART_CONFIG
 	SmartConfigEventInfo* smartConfigEventInfo = nullptr; ///< Set during smart handling
 #endif
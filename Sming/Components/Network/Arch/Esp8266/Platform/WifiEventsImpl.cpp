@@ -11,8 +11,9 @@
  */
 
 #include "WifiEventsImpl.h"
-#include <Platform/Station.h>
+#include "StationImpl.h"
 #include <esp_wifi.h>
+#include <Services/Profiling/BootTimeline.h>
 
 static WifiEventsImpl events;
 WifiEventsClass& WifiEvents = events;
@@ -26,8 +27,11 @@ void WifiEventsImpl::WifiEventHandler(System_Event_t* evt)
 {
 	//	debugf("event %x\n", evt->event);
 
+	static_cast<StationImpl&>(WifiStation).onWifiEvent(*evt);
+
 	switch(evt->event) {
 	case EVENT_STAMODE_CONNECTED:
+		BOOT_PHASE_MARK(wifiConnected);
 		debugf("connect to ssid %s, channel %d\n", evt->event_info.connected.ssid, evt->event_info.connected.channel);
 		if(onSTAConnect) {
 			String ssid(reinterpret_cast<const char*>(evt->event_info.connected.ssid),
@@ -65,6 +69,7 @@ void WifiEventsImpl::WifiEventHandler(System_Event_t* evt)
 		break;
 	}
 	case EVENT_STAMODE_GOT_IP:
+		BOOT_PHASE_MARK(wifiGotIp);
 		debugf("ip:" IPSTR ",mask:" IPSTR ",gw:" IPSTR "\n", IP2STR(&evt->event_info.got_ip.ip),
 			   IP2STR(&evt->event_info.got_ip.mask), IP2STR(&evt->event_info.got_ip.gw));
 		if(onSTAGotIP) {
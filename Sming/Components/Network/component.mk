@@ -20,7 +20,8 @@ COMPONENT_DEPENDS := \
 	libb64 \
 	ws_parser \
 	mqtt-codec \
-	libyuarel
+	libyuarel \
+	ObjectPool
 
 # WiFi settings may be provide via Environment variables
 CONFIG_VARS				+= WIFI_SSID WIFI_PWD
@@ -50,6 +51,80 @@ COMPONENT_VARS			+= HTTP_SERVER_EXPOSE_VERSION
 HTTP_SERVER_EXPOSE_VERSION ?= 0
 GLOBAL_CFLAGS			+= -DHTTP_SERVER_EXPOSE_VERSION=$(HTTP_SERVER_EXPOSE_VERSION)
 
+COMPONENT_VARS			+= HTTP_FAST_PARSER
+HTTP_FAST_PARSER ?= 1
+GLOBAL_CFLAGS			+= -DHTTP_FAST_PARSER=$(HTTP_FAST_PARSER)
+
+COMPONENT_VARS			+= HTTP_MAX_PATH_PARAMETERS
+HTTP_MAX_PATH_PARAMETERS ?= 4
+GLOBAL_CFLAGS			+= -DHTTP_MAX_PATH_PARAMETERS=$(HTTP_MAX_PATH_PARAMETERS)
+
+# => HTTP client
+COMPONENT_VARS			+= HTTP_DOWNLOAD_BLOCK_SIZE HTTP_DOWNLOAD_BLOCK_COUNT
+HTTP_DOWNLOAD_BLOCK_SIZE ?= 1024
+HTTP_DOWNLOAD_BLOCK_COUNT ?= 4
+COMPONENT_CXXFLAGS		+= \
+	-DHTTP_DOWNLOAD_BLOCK_SIZE=$(HTTP_DOWNLOAD_BLOCK_SIZE) \
+	-DHTTP_DOWNLOAD_BLOCK_COUNT=$(HTTP_DOWNLOAD_BLOCK_COUNT)
+
+# => Pre-compressed HTTP assets
+CONFIG_VARS				+= HTTP_ASSET_DIRS HTTP_ASSET_ENCODINGS HTTP_ASSET_EXTENSIONS
+HTTP_ASSET_ENCODINGS	?= gzip
+HTTP_ASSET_EXTENSIONS	?= html htm css js json svg txt xml
+ifdef HTTP_ASSET_DIRS
+HTTP_ASSET_FILES		:= $(call ListAllFiles,$(HTTP_ASSET_DIRS),$(addprefix *.,$(HTTP_ASSET_EXTENSIONS)))
+HTTP_ASSET_TARGETS		:= $(foreach e,$(filter gzip,$(HTTP_ASSET_ENCODINGS)),$(HTTP_ASSET_FILES:=.gz))
+HTTP_ASSET_TARGETS		+= $(foreach e,$(filter br,$(HTTP_ASSET_ENCODINGS)),$(HTTP_ASSET_FILES:=.br))
+CUSTOM_TARGETS			+= http-assets
+
+.PHONY: http-assets
+http-assets: $(HTTP_ASSET_TARGETS) ##Compress HTTP assets
+
+$(filter %.gz,$(HTTP_ASSET_TARGETS)): %.gz: %
+	@echo "GZIP $<"
+	$(Q) gzip -9 -n -k -f $<
+
+$(filter %.br,$(HTTP_ASSET_TARGETS)): %.br: %
+	@echo "BROTLI $<"
+	$(Q) brotli -q 11 -k -f $<
+endif
+
+# => DNS resolver
+COMPONENT_VARS			+= DNS_CACHE_SIZE
+DNS_CACHE_SIZE			?= 8
+GLOBAL_CFLAGS			+= -DDNS_CACHE_SIZE=$(DNS_CACHE_SIZE)
+
+COMPONENT_VARS			+= DNS_CACHE_TTL
+DNS_CACHE_TTL			?= 300
+GLOBAL_CFLAGS			+= -DDNS_CACHE_TTL=$(DNS_CACHE_TTL)
+
+COMPONENT_VARS			+= DNS_CACHE_NEGATIVE_TTL
+DNS_CACHE_NEGATIVE_TTL	?= 15
+GLOBAL_CFLAGS			+= -DDNS_CACHE_NEGATIVE_TTL=$(DNS_CACHE_NEGATIVE_TTL)
+
+COMPONENT_VARS			+= DNS_CACHE_PREFETCH
+DNS_CACHE_PREFETCH		?= 30
+GLOBAL_CFLAGS			+= -DDNS_CACHE_PREFETCH=$(DNS_CACHE_PREFETCH)
+
+# => SMTP client
+COMPONENT_VARS			+= SMTP_QUEUE_SIZE
+SMTP_QUEUE_SIZE			?= 5
+GLOBAL_CFLAGS			+= -DSMTP_QUEUE_SIZE=$(SMTP_QUEUE_SIZE)
+
+# => Transmit scheduler
+COMPONENT_VARS			+= TX_SCHEDULER_QUEUE_SIZE
+TX_SCHEDULER_QUEUE_SIZE	?= 8
+GLOBAL_CFLAGS			+= -DTX_SCHEDULER_QUEUE_SIZE=$(TX_SCHEDULER_QUEUE_SIZE)
+
+# => Coroutines
+COMPONENT_VARS			+= COROUTINE_FRAME_COUNT
+COROUTINE_FRAME_COUNT	?= 4
+GLOBAL_CFLAGS			+= -DCOROUTINE_FRAME_COUNT=$(COROUTINE_FRAME_COUNT)
+
+COMPONENT_VARS			+= COROUTINE_FRAME_SIZE
+COROUTINE_FRAME_SIZE	?= 1024
+GLOBAL_CFLAGS			+= -DCOROUTINE_FRAME_SIZE=$(COROUTINE_FRAME_SIZE)
+
 # => LWIP
 COMPONENT_VARS			+= ENABLE_CUSTOM_LWIP
 ifeq ($(SMING_ARCH),Esp8266)
@@ -16,19 +16,16 @@
 const unsigned CHARS_PER_LINE = 72;
 
 Base64OutputStream::Base64OutputStream(IDataSourceStream* stream, size_t resultSize)
-	: StreamTransformer(stream, resultSize, (resultSize / 4))
+	: StreamTransformer(stream, resultSize, (resultSize / 4)), encoder(CHARS_PER_LINE), savedEncoder(CHARS_PER_LINE)
 {
-	base64_init_encodestate(&state, CHARS_PER_LINE);
 }
 
 size_t Base64OutputStream::transform(const uint8_t* source, size_t sourceLength, uint8_t* target, size_t targetLength)
 {
-	size_t count;
+	auto out = reinterpret_cast<char*>(target);
 	if(sourceLength == 0) {
-		count = base64_encode_blockend((char*)target, &state);
-	} else {
-		count = base64_encode_block((const char*)source, sourceLength, (char*)target, &state);
+		return encoder.finish(out);
 	}
 
-	return count;
+	return encoder.update(source, sourceLength, out);
 }
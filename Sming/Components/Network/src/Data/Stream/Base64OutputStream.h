@@ -13,7 +13,7 @@
 #pragma once
 
 #include <Core/Data/StreamTransformer.h>
-#include <libb64/cencode.h>
+#include <Data/WebHelpers/base64.h>
 
 /**
  * @brief    Read-only stream to emit base64-encoded content from source stream
@@ -33,15 +33,15 @@ public:
 
 	void saveState() override
 	{
-		savedState = state;
+		savedEncoder = encoder;
 	}
 
 	void restoreState() override
 	{
-		state = savedState;
+		encoder = savedEncoder;
 	}
 
 private:
-	base64_encodestate state{};
-	base64_encodestate savedState{};
+	Base64Encoder encoder;
+	Base64Encoder savedEncoder;
 };
@@ -0,0 +1,301 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/SmingHub/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * ByteRangeStream.cpp
+ *
+ ****/
+
+#include "ByteRangeStream.h"
+#include <Network/Http/HttpHeaderFields.h>
+#include <esp_system.h>
+#include <debug_progmem.h>
+
+namespace
+{
+const char* skipSpace(const char* p)
+{
+	while(*p == ' ' || *p == '\t') {
+		++p;
+	}
+	return p;
+}
+
+} // namespace
+
+int ByteRangeStream::parse(const String& spec)
+{
+	rangeCount = 0;
+	totalLength = -1;
+
+	auto p = skipSpace(spec.c_str());
+	if(strncasecmp(p, "bytes=", 6) != 0) {
+		return -1;
+	}
+	p += 6;
+
+	unsigned count{0};
+	for(;;) {
+		p = skipSpace(p);
+		if(*p == ',') {
+			// Empty list elements are permitted
+			++p;
+			continue;
+		}
+		if(*p == '\0') {
+			break;
+		}
+
+		// First position is omitted for a suffix range, e.g. "-500" for the last 500 bytes
+		bool suffix = (*p == '-');
+		char* end;
+		uint32_t first{0};
+		if(!suffix) {
+			if(!isdigit(*p)) {
+				return -1;
+			}
+			first = strtoul(p, &end, 10);
+			p = skipSpace(end);
+			if(*p != '-') {
+				return -1;
+			}
+		}
+		p = skipSpace(p + 1);
+
+		// Last position is omitted for an open range, e.g. "9500-"
+		uint32_t last;
+		if(isdigit(*p)) {
+			last = strtoul(p, &end, 10);
+			p = skipSpace(end);
+		} else if(suffix) {
+			return -1;
+		} else {
+			last = sourceSize - 1;
+		}
+		if(*p != ',' && *p != '\0') {
+			return -1;
+		}
+
+		if(++count > HTTP_RANGE_MAX_COUNT) {
+			return -1;
+		}
+
+		if(suffix) {
+			if(last == 0 || sourceSize == 0) {
+				continue;
+			}
+			first = (last >= sourceSize) ? 0 : sourceSize - last;
+			last = sourceSize - 1;
+		} else {
+			if(last < first) {
+				return -1;
+			}
+			if(first >= sourceSize) {
+				continue;
+			}
+			last = std::min(last, sourceSize - 1);
+		}
+
+		ranges[rangeCount++] = Range{first, last};
+	}
+
+	return (count == 0) ? -1 : int(rangeCount);
+}
+
+String ByteRangeStream::getContentRange(unsigned index) const
+{
+	auto& range = ranges[index];
+	String s = F("bytes ");
+	s += range.start;
+	s += '-';
+	s += range.end;
+	s += '/';
+	s += sourceSize;
+	return s;
+}
+
+const char* ByteRangeStream::getBoundary()
+{
+	if(boundary[0] == 0) {
+		PSTR_ARRAY(pool, "0123456789"
+						 "ABCDEFGHIJKLMNOPQRSTUVWXYZ"
+						 "abcdefghijklmnopqrstuvwxyz");
+
+		for(unsigned i = 0; i < sizeof(boundary) - 1; ++i) {
+			boundary[i] = pool[os_random() % (sizeof(__pstr__pool) - 1)];
+		}
+	}
+
+	return boundary;
+}
+
+String ByteRangeStream::getPartHeader(unsigned index)
+{
+	String s;
+	s += "\r\n--";
+	s += getBoundary();
+	s += "\r\n";
+	if(contentType) {
+		s += HttpHeaderFields::toString(F("Content-Type"), contentType);
+	}
+	s += HttpHeaderFields::toString(F("Content-Range"), getContentRange(index));
+	s += "\r\n";
+	return s;
+}
+
+String ByteRangeStream::getTrailer()
+{
+	String s;
+	s += "\r\n--";
+	s += getBoundary();
+	s += "--\r\n";
+	return s;
+}
+
+void ByteRangeStream::begin()
+{
+	rangeIndex = 0;
+	position = 0;
+	if(rangeCount == 0) {
+		state = State::done;
+	} else {
+		beginRange();
+	}
+}
+
+void ByteRangeStream::beginRange()
+{
+	if(isMultipart()) {
+		part = getPartHeader(rangeIndex);
+		partPos = 0;
+		state = State::header;
+	} else {
+		beginContent();
+	}
+}
+
+void ByteRangeStream::beginContent()
+{
+	part = nullptr;
+	auto& range = ranges[rangeIndex];
+	if(source == nullptr || source->seekFrom(range.start, SeekOrigin::Start) != int(range.start)) {
+		debug_e("[RANGE] Seek to %u failed", range.start);
+		state = State::done;
+		return;
+	}
+	remaining = range.length();
+	state = State::content;
+}
+
+void ByteRangeStream::endRange()
+{
+	++rangeIndex;
+	if(rangeIndex < rangeCount) {
+		beginRange();
+	} else if(isMultipart()) {
+		part = getTrailer();
+		partPos = 0;
+		state = State::trailer;
+	} else {
+		state = State::done;
+	}
+}
+
+uint16_t ByteRangeStream::readMemoryBlock(char* data, int bufSize)
+{
+	if(state == State::idle) {
+		begin();
+	}
+
+	if(bufSize <= 0) {
+		return 0;
+	}
+
+	switch(state) {
+	case State::header:
+	case State::trailer: {
+		auto len = std::min(size_t(bufSize), part.length() - partPos);
+		memcpy(data, part.c_str() + partPos, len);
+		return len;
+	}
+
+	case State::content:
+		return source->readMemoryBlock(data, std::min(uint32_t(bufSize), remaining));
+
+	default:
+		return 0;
+	}
+}
+
+bool ByteRangeStream::seek(int len)
+{
+	if(len < 0) {
+		return false;
+	}
+
+	if(state == State::idle) {
+		begin();
+	}
+
+	switch(state) {
+	case State::header:
+	case State::trailer:
+		if(size_t(len) > part.length() - partPos) {
+			return false;
+		}
+		partPos += len;
+		position += len;
+		if(partPos == part.length()) {
+			if(state == State::trailer) {
+				part = nullptr;
+				state = State::done;
+			} else {
+				beginContent();
+			}
+		}
+		return true;
+
+	case State::content:
+		if(uint32_t(len) > remaining || !source->seek(len)) {
+			return false;
+		}
+		remaining -= len;
+		position += len;
+		if(remaining == 0) {
+			endRange();
+		}
+		return true;
+
+	default:
+		return len == 0;
+	}
+}
+
+bool ByteRangeStream::isFinished()
+{
+	if(state == State::idle) {
+		begin();
+	}
+	return state == State::done;
+}
+
+int ByteRangeStream::available()
+{
+	if(totalLength < 0) {
+		uint32_t total{0};
+		for(unsigned i = 0; i < rangeCount; ++i) {
+			total += ranges[i].length();
+			if(isMultipart()) {
+				total += getPartHeader(i).length();
+			}
+		}
+		if(isMultipart()) {
+			total += getTrailer().length();
+		}
+		totalLength = total;
+	}
+
+	return totalLength - position;
+}
@@ -0,0 +1,164 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/SmingHub/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * ByteRangeStream.h
+ *
+ ****/
+
+#pragma once
+
+#include <Data/Stream/DataSourceStream.h>
+
+/**
+ * @brief Maximum number of ranges accepted in a single request
+ *
+ * Requests for more ranges than this are answered with the complete content.
+ */
+#ifndef HTTP_RANGE_MAX_COUNT
+#define HTTP_RANGE_MAX_COUNT 8
+#endif
+
+/**
+ * @brief Read-only stream producing selected byte ranges of a seekable source stream
+ *
+ * Used to answer HTTP `Range` requests. A single range produces just the selected content.
+ * Multiple ranges are produced as `multipart/byteranges` content, with a header for each part.
+ *
+ * The source is re-positioned using `seekFrom()` at the start of each range,
+ * so skipped content is never read.
+ *
+ * @see See https://tools.ietf.org/html/rfc7233
+ * @ingroup stream data
+ */
+class ByteRangeStream : public IDataSourceStream
+{
+public:
+	struct Range {
+		uint32_t start;
+		uint32_t end; ///< Position of last byte in range
+
+		size_t length() const
+		{
+			return end - start + 1;
+		}
+	};
+
+	/**
+	 * @brief Construct a range stream
+	 * @param sourceSize Total length of source content
+	 * @param contentType MIME type of source content, included in multipart headers
+	 */
+	ByteRangeStream(uint32_t sourceSize, const String& contentType = nullptr)
+		: contentType(contentType), sourceSize(sourceSize)
+	{
+	}
+
+	~ByteRangeStream()
+	{
+		delete source;
+	}
+
+	/**
+	 * @brief Set the ranges to produce from the value of a `Range` header
+	 * @param spec For example, "bytes=0-499,1000-,-200"
+	 * @retval int Number of satisfiable ranges, or -1 if the specification is invalid
+	 *
+	 * Ranges which start beyond the end of the content are discarded.
+	 * If the specification is invalid, or contains more than `HTTP_RANGE_MAX_COUNT` ranges,
+	 * it should be ignored and the complete content sent.
+	 */
+	int parse(const String& spec);
+
+	/**
+	 * @brief Set the stream to take the ranges from
+	 * @param source A seekable stream, of the size given in the constructor. Will be destroyed with this stream.
+	 */
+	void setSource(IDataSourceStream* source)
+	{
+		delete this->source;
+		this->source = source;
+	}
+
+	unsigned getRangeCount() const
+	{
+		return rangeCount;
+	}
+
+	const Range& getRange(unsigned index) const
+	{
+		return ranges[index];
+	}
+
+	/**
+	 * @brief Get the `Content-Range` value for a range
+	 * @param index
+	 * @retval String For example, "bytes 0-499/1234"
+	 */
+	String getContentRange(unsigned index) const;
+
+	/**
+	 * @brief Returns the boundary separating parts when there is more than one range
+	 */
+	const char* getBoundary();
+
+	bool isValid() const override
+	{
+		return source != nullptr && source->isValid();
+	}
+
+	uint16_t readMemoryBlock(char* data, int bufSize) override;
+
+	bool seek(int len) override;
+
+	bool isFinished() override;
+
+	int available() override;
+
+	String id() const override
+	{
+		return source ? source->id() : nullptr;
+	}
+
+	String getName() const override
+	{
+		return source ? source->getName() : nullptr;
+	}
+
+private:
+	enum class State {
+		idle,
+		header,
+		content,
+		trailer,
+		done,
+	};
+
+	bool isMultipart() const
+	{
+		return rangeCount > 1;
+	}
+
+	String getPartHeader(unsigned index);
+	String getTrailer();
+	void begin();
+	void beginRange();
+	void beginContent();
+	void endRange();
+
+	IDataSourceStream* source{nullptr};
+	String contentType;
+	String part;	   ///< Header or trailer being sent
+	size_t partPos{0}; ///< Read position within part
+	uint32_t sourceSize;
+	uint32_t remaining{0}; ///< Content still to be sent for current range
+	uint32_t position{0};  ///< Total number of bytes sent
+	int totalLength{-1};
+	Range ranges[HTTP_RANGE_MAX_COUNT];
+	unsigned rangeCount{0};
+	unsigned rangeIndex{0};
+	State state{State::idle};
+	char boundary[16]{};
+};
@@ -11,29 +11,139 @@
  ****/
 
 #include "ChunkedStream.h"
+#include <stringutil.h>
 
-ChunkedStream::ChunkedStream(IDataSourceStream* stream, size_t resultSize)
-	: StreamTransformer(stream, resultSize, resultSize - 12)
+namespace
 {
+constexpr char lineEnd[]{'\r', '\n'};
+
+size_t hexLength(size_t value)
+{
+	size_t len{1};
+	while((value >>= 4) != 0) {
+		++len;
+	}
+	return len;
+}
+
+} // namespace
+
+void ChunkedStream::setChunkLength(size_t length)
+{
+	auto digits = hexLength(length);
+	auto value = length;
+	for(unsigned i = digits; i != 0; value >>= 4) {
+		header[--i] = hexchar(value & 0x0f);
+	}
+	header[digits] = '\r';
+	header[digits + 1] = '\n';
+	headerLength = digits + 2;
+	chunkLength = length;
+	chunkPos = 0;
+}
+
+uint16_t ChunkedStream::startChunk(char* data, size_t bufSize)
+{
+	if(bufSize > maxOverhead) {
+		// Read content directly into place, leaving room for the largest header
+		size_t maxLength = std::min(bufSize - maxOverhead, size_t(maxChunkSize));
+		size_t reserve = hexLength(maxLength) + 2;
+		size_t length = sourceStream->readMemoryBlock(data + reserve, maxLength);
+		if(length != 0) {
+			setChunkLength(length);
+			if(headerLength != reserve) {
+				memmove(data + headerLength, data + reserve, length);
+			}
+			memcpy(data, header, headerLength);
+			memcpy(data + headerLength + length, lineEnd, 2);
+			return chunkSize();
+		}
+	} else {
+		// Buffer too small to hold a chunk so just determine the content length
+		char buffer[maxOverhead];
+		size_t length = sourceStream->readMemoryBlock(buffer, sizeof(buffer));
+		if(length != 0) {
+			setChunkLength(length);
+			return 0;
+		}
+	}
+
+	if(!sourceStream->isFinished()) {
+		// Waiting for more content
+		return 0;
+	}
+
+	setChunkLength(0);
+	lastChunk = true;
+	return 0;
+}
+
+uint16_t ChunkedStream::readMemoryBlock(char* data, int bufSize)
+{
+	if(finished || !isValid() || bufSize <= 0) {
+		return 0;
+	}
+
+	if(headerLength == 0) {
+		auto len = startChunk(data, bufSize);
+		if(len != 0 || headerLength == 0) {
+			return len;
+		}
+	}
+
+	// Continue a partially consumed chunk
+	size_t pos = chunkPos;
+	size_t count{0};
+	auto copy = [&](const char* src, size_t srcPos, size_t srcLen) {
+		auto n = std::min(srcLen - srcPos, size_t(bufSize) - count);
+		memcpy(data + count, src + srcPos, n);
+		count += n;
+		pos += n;
+	};
+
+	if(pos < headerLength) {
+		copy(header, pos, headerLength);
+	}
+	size_t contentEnd = headerLength + chunkLength;
+	if(pos >= headerLength && pos < contentEnd && count < size_t(bufSize)) {
+		auto n = std::min(contentEnd - pos, size_t(bufSize) - count);
+		n = sourceStream->readMemoryBlock(data + count, n);
+		count += n;
+		pos += n;
+		if(pos < contentEnd) {
+			return count;
+		}
+	}
+	if(pos >= contentEnd && count < size_t(bufSize)) {
+		copy(lineEnd, pos - contentEnd, 2);
+	}
+
+	return count;
 }
 
-size_t ChunkedStream::transform(const uint8_t* source, size_t sourceLength, uint8_t* target, size_t targetLength)
+bool ChunkedStream::seek(int len)
 {
-	if(sourceLength == 0) {
-		memcpy(target, _F("0\r\n\r\n"), 5);
-		return 5;
+	if(len < 0) {
+		return false;
 	}
 
-	// Header
-	unsigned offset = m_snprintf(reinterpret_cast<char*>(target), targetLength, "%X\r\n", sourceLength);
+	while(len != 0 && headerLength != 0) {
+		size_t n = std::min(size_t(len), chunkSize() - chunkPos);
 
-	// Content
-	memcpy(target + offset, source, sourceLength);
-	offset += sourceLength;
+		// Advance source past any content consumed
+		size_t contentStart = std::max(size_t(chunkPos), size_t(headerLength));
+		size_t contentEnd = std::min(size_t(chunkPos + n), size_t(headerLength + chunkLength));
+		if(contentEnd > contentStart && !sourceStream->seek(contentEnd - contentStart)) {
+			return false;
+		}
 
-	// Footer
-	memcpy(target + offset, "\r\n", 2);
-	offset += 2;
+		chunkPos += n;
+		len -= n;
+		if(chunkPos == chunkSize()) {
+			headerLength = 0;
+			finished = lastChunk;
+		}
+	}
 
-	return offset;
+	return len == 0;
 }
@@ -12,20 +12,78 @@
 
 #pragma once
 
-#include <Data/StreamTransformer.h>
+#include <Data/Stream/DataSourceStream.h>
 
 /**
  * @brief Read-only stream to obtain data using HTTP chunked encoding
  *
  * Used where total length of stream is not known in advance
  *
+ * Each chunk is sized to fill the buffer passed to `readMemoryBlock()`, which for network
+ * connections corresponds to the available TCP send window. Content is read from the
+ * source directly into that buffer, so no intermediate buffers are required.
+ *
  * @ingroup  stream data
  */
-class ChunkedStream : public StreamTransformer
+class ChunkedStream : public IDataSourceStream
 {
 public:
-	ChunkedStream(IDataSourceStream* stream, size_t resultSize = 512);
+	/**
+	 * @brief Constructor
+	 * @param stream Source content, owned by this stream
+	 * @param maxChunkSize Limits size of content in each chunk
+	 */
+	ChunkedStream(IDataSourceStream* stream, size_t maxChunkSize = 0xffff)
+		: sourceStream(stream), maxChunkSize(std::min(maxChunkSize, size_t(0xffff - maxOverhead)))
+	{
+	}
+
+	~ChunkedStream()
+	{
+		delete sourceStream;
+	}
+
+	StreamType getStreamType() const override
+	{
+		return eSST_Transform;
+	}
+
+	bool isValid() const override
+	{
+		return sourceStream != nullptr && sourceStream->isValid();
+	}
+
+	uint16_t readMemoryBlock(char* data, int bufSize) override;
+
+	bool seek(int len) override;
+
+	bool isFinished() override
+	{
+		return finished;
+	}
+
+	String getName() const override
+	{
+		return (sourceStream == nullptr) ? nullptr : sourceStream->getName();
+	}
+
+private:
+	static constexpr size_t maxOverhead{8}; ///< Chunk header "FFFF\r\n" plus trailing "\r\n"
+
+	uint16_t startChunk(char* data, size_t bufSize);
+	void setChunkLength(size_t length);
+
+	size_t chunkSize() const
+	{
+		return headerLength + chunkLength + 2;
+	}
 
-protected:
-	size_t transform(const uint8_t* source, size_t sourceLength, uint8_t* target, size_t targetLength) override;
+	IDataSourceStream* sourceStream;
+	uint16_t maxChunkSize;
+	uint16_t chunkLength{0}; ///< Content length of current chunk
+	uint16_t chunkPos{0};	///< Number of bytes of current chunk consumed
+	uint8_t headerLength{0}; ///< 0 if no chunk is in progress
+	char header[6];			 ///< Content length in hex with line ending
+	bool lastChunk{false};
+	bool finished{false};
 };
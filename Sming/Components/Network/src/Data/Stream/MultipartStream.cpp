@@ -11,71 +11,167 @@
  ****/
 
 #include <Data/Stream/MultipartStream.h>
-#include <Data/Stream/MemoryDataStream.h>
 #include <esp_system.h>
+#include <debug_progmem.h>
+#include <stringconversion.h>
 
-IDataSourceStream* MultipartStream::getNextStream()
+namespace
 {
-	if(footerSent) {
-		return nullptr;
+constexpr char lineEnd[]{'\r', '\n'};
+}
+
+MultipartStream::~MultipartStream()
+{
+	delete content;
+	for(unsigned i = partIndex; i < partCount; ++i) {
+		delete parts[i].stream;
 	}
+}
 
-	// Return content, if available
-	if(bodyPart.stream != nullptr) {
-		auto stream = bodyPart.stream;
-		bodyPart.stream = nullptr;
-		return stream;
+uint16_t MultipartStream::readMemoryBlock(char* data, int bufSize)
+{
+	if(bufSize <= 0) {
+		return 0;
 	}
 
-	// Fetch next part to send
-	bodyPart = producer();
-
-	// Generate header fragment
-	auto stream = new MemoryDataStream();
-	stream->ensureCapacity(4 + 16 + 4);
-	stream->print("\r\n");
-	stream->print("--");
-	stream->print(getBoundary());
-	if(!bodyPart) {
-		stream->print("--");
-		footerSent = true;
+	if(headerPos >= header.length()) {
+		if(content != nullptr && !content->isFinished()) {
+			return content->readMemoryBlock(data, bufSize);
+		}
+		if(footerSent) {
+			return 0;
+		}
+		nextPart();
+	}
+
+	// Send remaining header text and as much content as will fit
+	size_t count = std::min(size_t(bufSize), header.length() - headerPos);
+	memcpy(data, header.c_str() + headerPos, count);
+	if(count < size_t(bufSize) && content != nullptr) {
+		count += content->readMemoryBlock(data + count, bufSize - count);
+	}
+	return count;
+}
+
+bool MultipartStream::seek(int len)
+{
+	if(len < 0) {
+		return false;
+	}
+
+	size_t n = std::min(size_t(len), header.length() - headerPos);
+	headerPos += n;
+	len -= n;
+	if(len == 0) {
+		return true;
 	}
-	stream->print("\r\n");
 
-	if(bodyPart) {
-		if(bodyPart.stream != nullptr && !bodyPart.headers->contains(HTTP_HEADER_CONTENT_LENGTH)) {
-			auto avail = bodyPart.stream->available();
-			if(avail >= 0) {
-				(*bodyPart.headers)[HTTP_HEADER_CONTENT_LENGTH] = avail;
+	return content != nullptr && content->seek(len);
+}
+
+void MultipartStream::nextPart()
+{
+	delete content;
+	content = nullptr;
+
+	if(parts != nullptr) {
+		if(partIndex < partCount) {
+			auto& part = parts[partIndex++];
+			content = part.stream;
+			if(part.headers != nullptr) {
+				renderHeader(part.headers);
+			} else {
+				HttpHeaders headers;
+				renderHeader(&headers);
 			}
+		} else {
+			renderHeader(nullptr);
 		}
+		return;
+	}
+
+	auto part = producer ? producer() : BodyPart{};
+	if(part) {
+		content = part.stream;
+		renderHeader(part.headers);
+		delete part.headers;
+	} else {
+		delete part.stream;
+		renderHeader(nullptr);
+	}
+}
 
-		for(unsigned i = 0; i < bodyPart.headers->count(); i++) {
-			stream->print((*bodyPart.headers)[i]);
+void MultipartStream::renderHeader(const HttpHeaders* headers)
+{
+	getBoundary();
+	constexpr size_t delimiterLength{sizeof(delimiter) - 1};
+	headerPos = 0;
+
+	if(headers == nullptr) {
+		// Closing delimiter
+		if(header.setLength(delimiterLength + 4)) {
+			auto p = header.begin();
+			memcpy(p, delimiter, delimiterLength);
+			memcpy(p + delimiterLength, "--\r\n", 4);
 		}
+		footerSent = true;
+		return;
+	}
 
-		delete bodyPart.headers;
-		bodyPart.headers = nullptr;
+	// Add content length if known
+	char lengthText[12];
+	size_t lengthTextLength{0};
+	size_t lengthNameLength{0};
+	if(content != nullptr && !headers->contains(HTTP_HEADER_CONTENT_LENGTH)) {
+		auto avail = content->available();
+		if(avail >= 0) {
+			ultoa(avail, lengthText, 10);
+			lengthTextLength = strlen(lengthText);
+			lengthNameLength = headers->getNameLength(HTTP_HEADER_CONTENT_LENGTH);
+		}
+	}
 
-		stream->print("\r\n");
+	size_t length = delimiterLength + 2 + headers->getOutputLength() + 2;
+	if(lengthTextLength != 0) {
+		length += lengthNameLength + 2 + lengthTextLength + 2;
+	}
+	if(!header.setLength(length)) {
+		debug_e("[MPS] Out of memory");
+		header = nullptr;
+		return;
 	}
 
-	return stream;
+	auto p = header.begin();
+	memcpy(p, delimiter, delimiterLength);
+	p += delimiterLength;
+	memcpy(p, lineEnd, 2);
+	p += 2;
+	p = headers->write(p);
+	if(lengthTextLength != 0) {
+		p = headers->writeName(HTTP_HEADER_CONTENT_LENGTH, p);
+		*p++ = ':';
+		*p++ = ' ';
+		memcpy(p, lengthText, lengthTextLength);
+		p += lengthTextLength;
+		memcpy(p, lineEnd, 2);
+		p += 2;
+	}
+	memcpy(p, lineEnd, 2);
 }
 
 const char* MultipartStream::getBoundary()
 {
+	auto boundary = &delimiter[4];
 	if(boundary[0] == 0) {
 		PSTR_ARRAY(pool, "0123456789"
 						 "ABCDEFGHIJKLMNOPQRSTUVWXYZ"
 						 "abcdefghijklmnopqrstuvwxyz");
 
-		int len = sizeof(boundary);
-		memset(boundary, 0, len);
-		for(int i = 0; i < len - 1; ++i) {
+		memcpy(delimiter, "\r\n--", 4);
+		for(unsigned i = 0; i < boundaryLength; ++i) {
 			boundary[i] = pool[os_random() % (sizeof(__pstr__pool) - 1)];
 		}
-		boundary[len - 1] = 0;
+		boundary[boundaryLength] = 0;
 	}
 
 	return boundary;
@@ -12,15 +12,21 @@
 
 #pragma once
 
-#include <Data/Stream/MultiStream.h>
+#include <Data/Stream/DataSourceStream.h>
 #include <Network/Http/HttpHeaders.h>
+#include <Delegate.h>
 
 /**
  * @brief Read-only stream for creating HTTP multi-part content
+ *
+ * Parts may be obtained from a callback as the stream is read, or from a fixed array of part descriptors.
+ * The boundary delimiter is rendered once, and each part's delimiter and headers are written into a
+ * re-usable buffer. Headers are sent together with the start of each part's content.
+ *
  * @see See https://www.w3.org/Protocols/rfc1341/7_2_Multipart.html
  * @ingroup stream data
 */
-class MultipartStream : public MultiStream
+class MultipartStream : public IDataSourceStream
 {
 public:
 	/**
@@ -37,19 +43,47 @@ public:
 		}
 	};
 
+	/**
+	 * @brief Describes one part of a fixed set
+	 */
+	struct Part {
+		const HttpHeaders* headers; ///< Optional. Not owned, so may be shared between parts or streams.
+		IDataSourceStream* stream;  ///< Optional. Owned by MultipartStream.
+	};
+
 	/**
 	 * @brief Callback used to produce each result
 	 */
 	using Producer = Delegate<BodyPart()>;
 
+	/**
+	 * @brief Obtain parts from a callback
+	 * @param delegate Called to obtain each part, returning an empty BodyPart when there are no more
+	 */
 	MultipartStream(Producer delegate) : producer(delegate)
 	{
 	}
 
-	~MultipartStream()
+	/**
+	 * @brief Send a fixed set of parts
+	 * @param parts Array of descriptors, must remain valid until this stream is destroyed
+	 * @param count Number of parts
+	 *
+	 * No heap allocation is required for each part, other than that made by the content streams.
+	 */
+	MultipartStream(const Part* parts, unsigned count) : parts(parts), partCount(count)
+	{
+	}
+
+	~MultipartStream();
+
+	uint16_t readMemoryBlock(char* data, int bufSize) override;
+
+	bool seek(int len) override;
+
+	bool isFinished() override
 	{
-		delete bodyPart.headers;
-		delete bodyPart.stream;
+		return footerSent && headerPos >= header.length();
 	}
 
 	/**
@@ -59,12 +93,19 @@ public:
 	 */
 	const char* getBoundary();
 
-protected:
-	IDataSourceStream* getNextStream() override;
-
 private:
+	void nextPart();
+	void renderHeader(const HttpHeaders* headers);
+
+	static constexpr size_t boundaryLength{15};
+
 	Producer producer;
-	BodyPart bodyPart;
-	char boundary[16]{};
+	const Part* parts{nullptr};
+	unsigned partCount{0};
+	unsigned partIndex{0};
+	IDataSourceStream* content{nullptr};
+	String header;		  ///< Delimiter and headers for current part, buffer is re-used
+	uint16_t headerPos{0}; ///< Number of characters of header consumed
+	char delimiter[4 + boundaryLength + 1]{}; ///< "\r\n--" followed by boundary
 	bool footerSent{false};
 };
@@ -0,0 +1,162 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/SmingHub/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * Coroutine.cpp
+ *
+ ****/
+
+#include "Coroutine.h"
+
+#ifdef __cpp_impl_coroutine
+
+#include <Platform/System.h>
+#include <debug_progmem.h>
+
+static_assert(COROUTINE_FRAME_COUNT > 0 && COROUTINE_FRAME_COUNT <= 32, "COROUTINE_FRAME_COUNT must be 1 to 32");
+
+namespace Coroutine
+{
+namespace
+{
+struct Frame {
+	alignas(__BIGGEST_ALIGNMENT__) uint8_t data[COROUTINE_FRAME_SIZE];
+};
+
+Frame frames[COROUTINE_FRAME_COUNT];
+uint32_t usedMask;
+Stats stats;
+
+} // namespace
+
+void* allocateFrame(size_t size) noexcept
+{
+	if(size > stats.largestFrame) {
+		stats.largestFrame = size;
+	}
+
+	if(size <= COROUTINE_FRAME_SIZE) {
+		for(unsigned i = 0; i < COROUTINE_FRAME_COUNT; ++i) {
+			uint32_t mask = BIT(i);
+			if((usedMask & mask) == 0) {
+				usedMask |= mask;
+				++stats.started;
+				++stats.active;
+				if(stats.active > stats.maxActive) {
+					stats.maxActive = stats.active;
+				}
+				return frames[i].data;
+			}
+		}
+		debug_e("[CO] No free frame");
+	} else {
+		debug_e("[CO] Frame size %u exceeds COROUTINE_FRAME_SIZE", size);
+	}
+
+	++stats.failed;
+	return nullptr;
+}
+
+void releaseFrame(void* frame) noexcept
+{
+	for(unsigned i = 0; i < COROUTINE_FRAME_COUNT; ++i) {
+		if(frame == frames[i].data) {
+			usedMask &= ~BIT(i);
+			--stats.active;
+			return;
+		}
+	}
+}
+
+const Stats& getStats()
+{
+	return stats;
+}
+
+void schedule(std::coroutine_handle<> handle)
+{
+	auto resume = [](void* param) { std::coroutine_handle<>::from_address(param).resume(); };
+	if(!System.queueCallback(TaskPriority::Normal, resume, handle.address())) {
+		// Better to resume on this stack than never
+		debug_w("[CO] Task queue full");
+		handle.resume();
+	}
+}
+
+/* TcpClient */
+
+bool TcpClient::isReady(Event event)
+{
+	switch(event) {
+	case Event::connected:
+		return getConnectionState() != eTCS_Connecting;
+	case Event::received:
+		return rxBuffer.length() != 0 || !isProcessing();
+	case Event::sent:
+		if(!isProcessing()) {
+			return true;
+		}
+		if(getConnectionState() != eTCS_Connected) {
+			return false;
+		}
+		return stream == nullptr && (tcp == nullptr || tcp_sndqueuelen(tcp) == 0);
+	}
+	return true;
+}
+
+void TcpClient::notify()
+{
+	if(waiter && isReady(waitEvent)) {
+		auto handle = waiter;
+		waiter = nullptr;
+		schedule(handle);
+	}
+}
+
+err_t TcpClient::onConnected(err_t err)
+{
+	err_t res = ::TcpClient::onConnected(err);
+	notify();
+	return res;
+}
+
+err_t TcpClient::onSent(uint16_t len)
+{
+	err_t res = ::TcpClient::onSent(len);
+	notify();
+	return res;
+}
+
+void TcpClient::onFinished(TcpClientState finishState)
+{
+	::TcpClient::onFinished(finishState);
+	notify();
+}
+
+bool TcpClient::handleReceive(::TcpClient&, char* data, int size)
+{
+	if(!rxBuffer.concat(data, size)) {
+		debug_e("[CO] Receive buffer full");
+		return false;
+	}
+	notify();
+	return true;
+}
+
+/* HttpFetch */
+
+int HttpFetch::complete(HttpConnection& connection, bool successful)
+{
+	auto response = connection.getResponse();
+	result.code = response->code;
+	result.success = successful && response->isSuccess();
+	result.body = response->getBody();
+	schedule(handle);
+	return 0;
+}
+
+} // namespace Coroutine
+
+#endif
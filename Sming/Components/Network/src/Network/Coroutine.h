@@ -0,0 +1,446 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/SmingHub/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * Coroutine.h - Sequential network code using C++20 coroutines
+ *
+ ****/
+
+/** @defgroup   coroutine Coroutines
+ *  @brief      Awaitable timers, DNS lookups, TCP and HTTP operations
+ *  @ingroup    networking
+ *  @{
+ */
+
+#pragma once
+
+#if defined(__cpp_impl_coroutine) && __has_include(<coroutine>)
+
+#include <coroutine>
+#include <SimpleTimer.h>
+#include "DnsResolver.h"
+#include "TcpClient.h"
+#include "HttpClient.h"
+
+/**
+ * @brief Number of coroutines which may be active at the same time
+ */
+#ifndef COROUTINE_FRAME_COUNT
+#define COROUTINE_FRAME_COUNT 4
+#endif
+
+/**
+ * @brief Maximum size of a coroutine frame, in bytes
+ *
+ * The frame holds the coroutine's parameters, local variables and awaiters.
+ */
+#ifndef COROUTINE_FRAME_SIZE
+#define COROUTINE_FRAME_SIZE 1024
+#endif
+
+namespace Coroutine
+{
+/**
+ * @brief Coroutine frame pool statistics
+ */
+struct Stats {
+	unsigned active;	 ///< Frames currently in use
+	unsigned maxActive;	 ///< Highest number of frames in use at once
+	unsigned started;	 ///< Coroutines started
+	unsigned failed;	 ///< Coroutines which could not be started as no frame was available
+	size_t largestFrame; ///< Largest frame size requested
+};
+
+/**
+ * @brief Allocate storage for a coroutine frame from the fixed pool
+ * @retval void* nullptr if the frame is too large or the pool is exhausted
+ */
+void* allocateFrame(size_t size) noexcept;
+
+/**
+ * @brief Return a frame to the pool
+ */
+void releaseFrame(void* frame) noexcept;
+
+const Stats& getStats();
+
+/**
+ * @brief Resume a suspended coroutine from the system task queue
+ *
+ * All awaitables resume their coroutine this way, so the coroutine always continues
+ * in task context with a fresh stack, never from within the network stack callback
+ * which completed the operation.
+ */
+void schedule(std::coroutine_handle<> handle);
+
+/**
+ * @brief Return type for a coroutine
+ *
+ * Coroutines start running immediately and release their frame on completion.
+ * The caller does not wait for the result. For example::
+ *
+ *    Coroutine::Task blink()
+ *    {
+ *       for(;;) {
+ *          digitalWrite(LED_PIN, HIGH);
+ *          co_await Coroutine::delay(100);
+ *          digitalWrite(LED_PIN, LOW);
+ *          co_await Coroutine::delay(900);
+ *       }
+ *    }
+ *
+ * Frames are taken from a fixed pool of `COROUTINE_FRAME_COUNT` entries, each of `COROUTINE_FRAME_SIZE` bytes,
+ * so the heap is not used. If no frame is available the coroutine does not run and the returned
+ * Task evaluates as `false`.
+ */
+class Task
+{
+public:
+	struct promise_type {
+		Task get_return_object() noexcept
+		{
+			return Task(true);
+		}
+
+		static Task get_return_object_on_allocation_failure() noexcept
+		{
+			return Task(false);
+		}
+
+		std::suspend_never initial_suspend() noexcept
+		{
+			return {};
+		}
+
+		std::suspend_never final_suspend() noexcept
+		{
+			return {};
+		}
+
+		void return_void() noexcept
+		{
+		}
+
+		void unhandled_exception()
+		{
+			abort();
+		}
+
+		static void* operator new(size_t size) noexcept
+		{
+			return allocateFrame(size);
+		}
+
+		static void operator delete(void* frame) noexcept
+		{
+			releaseFrame(frame);
+		}
+	};
+
+	explicit operator bool() const
+	{
+		return started;
+	}
+
+private:
+	explicit Task(bool started) : started(started)
+	{
+	}
+
+	bool started;
+};
+
+/**
+ * @brief Awaitable which suspends a coroutine for a fixed time
+ */
+class Delay
+{
+public:
+	explicit Delay(uint32_t milliseconds) : milliseconds(milliseconds)
+	{
+	}
+
+	bool await_ready() const noexcept
+	{
+		return milliseconds == 0;
+	}
+
+	void await_suspend(std::coroutine_handle<> handle)
+	{
+		this->handle = handle;
+		timer.initializeMs(
+			milliseconds, [](void* arg) { schedule(static_cast<Delay*>(arg)->handle); }, this);
+		timer.startOnce();
+	}
+
+	void await_resume() const noexcept
+	{
+	}
+
+private:
+	SimpleTimer timer;
+	std::coroutine_handle<> handle;
+	uint32_t milliseconds;
+};
+
+/**
+ * @brief Suspend the calling coroutine
+ * @param milliseconds Time to wait
+ */
+inline Delay delay(uint32_t milliseconds)
+{
+	return Delay(milliseconds);
+}
+
+/**
+ * @brief Awaitable host name lookup using the global DnsResolver
+ *
+ * Evaluates to the resolved address, which is null if the lookup failed.
+ */
+class Resolve
+{
+public:
+	explicit Resolve(const String& name) : name(name)
+	{
+	}
+
+	bool await_ready()
+	{
+		err_t err = Dns.resolve(name, addr, DnsResolver::Callback(&Resolve::found, this), this);
+		return err != ERR_INPROGRESS;
+	}
+
+	void await_suspend(std::coroutine_handle<> handle)
+	{
+		this->handle = handle;
+	}
+
+	IpAddress await_resume() const
+	{
+		return addr;
+	}
+
+private:
+	void found(const String&, IpAddress addr)
+	{
+		this->addr = addr;
+		schedule(handle);
+	}
+
+	String name;
+	IpAddress addr;
+	std::coroutine_handle<> handle;
+};
+
+/**
+ * @brief Resolve a host name
+ * @param name Host name or address in dotted decimal form
+ */
+inline Resolve resolve(const String& name)
+{
+	return Resolve(name);
+}
+
+/**
+ * @brief TCP client with awaitable connection, receive and send completion
+ *
+ * Only one operation may be awaited at a time. For example::
+ *
+ *    Coroutine::TcpClient client;
+ *    client.connect(F("example.com"), 7);
+ *    if(!co_await client.connected()) {
+ *       co_return;
+ *    }
+ *    client.sendString(F("hello\r\n"));
+ *    String reply = co_await client.received();
+ *    client.close();
+ *
+ * Received data is buffered until requested. The object must not be destroyed whilst a coroutine
+ * is waiting on it, so typically it is a local variable of the coroutine itself.
+ */
+class TcpClient : public ::TcpClient
+{
+public:
+	enum class Event {
+		connected,
+		received,
+		sent,
+	};
+
+	/**
+	 * @brief Awaitable for a TcpClient event
+	 */
+	class Wait
+	{
+	public:
+		Wait(TcpClient& client, Event event) : client(client), event(event)
+		{
+		}
+
+		bool await_ready() const
+		{
+			return client.isReady(event);
+		}
+
+		void await_suspend(std::coroutine_handle<> handle)
+		{
+			client.waiter = handle;
+			client.waitEvent = event;
+		}
+
+		bool await_resume() const
+		{
+			return client.getConnectionState() == eTCS_Connected;
+		}
+
+	protected:
+		TcpClient& client;
+		Event event;
+	};
+
+	/**
+	 * @brief Awaitable for received data
+	 */
+	class Receive : public Wait
+	{
+	public:
+		using Wait::Wait;
+
+		String await_resume() const
+		{
+			return client.takeData();
+		}
+	};
+
+	TcpClient() : ::TcpClient(false)
+	{
+		setReceiveDelegate(TcpClientDataDelegate(&TcpClient::handleReceive, this));
+	}
+
+	/**
+	 * @brief Wait for connection to complete
+	 * @retval bool true if connected
+	 *
+	 * Call `connect()` first.
+	 */
+	Wait connected()
+	{
+		return Wait(*this, Event::connected);
+	}
+
+	/**
+	 * @brief Wait for data
+	 * @retval String All data received since the last call, empty if the connection was closed
+	 */
+	Receive received()
+	{
+		return Receive(*this, Event::received);
+	}
+
+	/**
+	 * @brief Wait until all queued data has been sent and acknowledged
+	 * @retval bool true if the connection remains open
+	 */
+	Wait sent()
+	{
+		return Wait(*this, Event::sent);
+	}
+
+protected:
+	err_t onConnected(err_t err) override;
+	err_t onSent(uint16_t len) override;
+	void onFinished(TcpClientState finishState) override;
+
+private:
+	friend Wait;
+	friend Receive;
+
+	bool isReady(Event event);
+	void notify();
+	bool handleReceive(::TcpClient& client, char* data, int size);
+
+	String takeData()
+	{
+		return std::move(rxBuffer);
+	}
+
+	String rxBuffer;
+	std::coroutine_handle<> waiter;
+	Event waitEvent{};
+};
+
+/**
+ * @brief Outcome of an HTTP request
+ */
+struct HttpResult {
+	bool success{false}; ///< Request completed and response status indicates success
+	HttpStatus code{};	 ///< Response status code
+	String body;		 ///< Response content, if a memory stream was used to receive it
+};
+
+/**
+ * @brief Awaitable HTTP request
+ */
+class HttpFetch
+{
+public:
+	HttpFetch(HttpClient& client, HttpRequest* request) : client(client), request(request)
+	{
+	}
+
+	bool await_ready() const noexcept
+	{
+		return false;
+	}
+
+	bool await_suspend(std::coroutine_handle<> handle)
+	{
+		this->handle = handle;
+		request->onRequestComplete(RequestCompletedDelegate(&HttpFetch::complete, this));
+		// If the request is rejected it has been deleted, so continue immediately
+		return client.send(request);
+	}
+
+	HttpResult await_resume()
+	{
+		return std::move(result);
+	}
+
+private:
+	int complete(HttpConnection& connection, bool successful);
+
+	HttpClient& client;
+	HttpRequest* request;
+	HttpResult result;
+	std::coroutine_handle<> handle;
+};
+
+/**
+ * @brief Send an HTTP request and wait for the response
+ * @param client
+ * @param request Ownership is passed to the client
+ */
+inline HttpFetch fetch(HttpClient& client, HttpRequest* request)
+{
+	return HttpFetch(client, request);
+}
+
+/**
+ * @brief Fetch a URL and wait for the response
+ * @param client
+ * @param url
+ * @param maxLength Maximum number of bytes of content to return
+ */
+inline HttpFetch fetch(HttpClient& client, const Url& url, size_t maxLength = NETWORK_SEND_BUFFER_SIZE)
+{
+	return fetch(client, client.createRequest(url)->setMethod(HTTP_GET)->setResponseStream(
+							 new LimitedMemoryStream(maxLength)));
+}
+
+} // namespace Coroutine
+
+#endif
+
+/** @} */
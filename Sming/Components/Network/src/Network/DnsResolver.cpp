@@ -0,0 +1,309 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/SmingHub/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * DnsResolver.cpp
+ *
+ ****/
+
+#include "DnsResolver.h"
+#include <Clock.h>
+#include <debug_progmem.h>
+
+#define DNS_CACHE_CHECK_INTERVAL 5000 ///< Milliseconds between cache maintenance checks
+
+DnsResolver Dns;
+
+DnsResolver::Entry* DnsResolver::find(const String& name)
+{
+	for(auto& entry : entries) {
+		if(entry.state != State::empty && entry.name.equalsIgnoreCase(name)) {
+			return &entry;
+		}
+	}
+	return nullptr;
+}
+
+DnsResolver::Entry* DnsResolver::allocate(const String& name)
+{
+	// Use an empty slot, or replace the least-recently used entry which isn't awaiting a result
+	Entry* slot{nullptr};
+	for(auto& entry : entries) {
+		if(entry.state == State::empty) {
+			slot = &entry;
+			break;
+		}
+		if(entry.state == State::pending || entry.refreshing) {
+			continue;
+		}
+		if(slot == nullptr || int32_t(entry.lastUsed - slot->lastUsed) < 0) {
+			slot = &entry;
+		}
+	}
+
+	if(slot != nullptr) {
+		*slot = Entry{};
+		slot->name = name;
+		slot->lastUsed = millis();
+	}
+	return slot;
+}
+
+err_t DnsResolver::lookup(const String& name, IpAddress& addr)
+{
+	++stats.lookups;
+	ip_addr_t ipaddr;
+	err_t err = dns_gethostbyname(name.c_str(), &ipaddr, staticOnFound, this);
+	if(err == ERR_OK) {
+		// Found in lwIP table
+		addr = ipaddr;
+	}
+	debug_d("[DNS] lookup '%s': %d", name.c_str(), err);
+	return err;
+}
+
+err_t DnsResolver::resolve(const String& name, IpAddress& addr, Callback callback, const void* owner)
+{
+	if(!name) {
+		return ERR_VAL;
+	}
+
+	// No need to cache addresses
+	ip_addr_t ipaddr;
+	if(ipaddr_aton(name.c_str(), &ipaddr)) {
+		addr = ipaddr;
+		return ERR_OK;
+	}
+
+	auto now = millis();
+	auto entry = find(name);
+	if(entry != nullptr) {
+		switch(entry->state) {
+		case State::valid:
+			// Stale entry is used whilst being refreshed
+			if(entry->refreshing || !isDue(entry->expires, now)) {
+				++stats.hits;
+				entry->lastUsed = now;
+				entry->used = true;
+				if(isDue(entry->expires - DNS_CACHE_PREFETCH * 1000U, now)) {
+					refresh(*entry);
+				}
+				addr = entry->addr;
+				return ERR_OK;
+			}
+			break;
+
+		case State::failed:
+			if(!isDue(entry->expires, now)) {
+				++stats.negativeHits;
+				return ERR_VAL;
+			}
+			break;
+
+		case State::pending:
+			++stats.joined;
+			entry->lastUsed = now;
+			if(!requests.add(Request{name, callback, owner})) {
+				return ERR_MEM;
+			}
+			return ERR_INPROGRESS;
+
+		case State::empty:
+			break;
+		}
+	}
+
+	++stats.misses;
+	if(entry == nullptr) {
+		// If the cache is full of pending lookups then the result won't be cached
+		entry = allocate(name);
+	}
+
+	err_t err = lookup(name, addr);
+	if(err == ERR_OK) {
+		update(name, addr);
+		return ERR_OK;
+	}
+
+	if(err != ERR_INPROGRESS) {
+		// Local failure (e.g. out of memory) says nothing about the name, so don't cache it
+		++stats.failures;
+		return err;
+	}
+
+	if(!requests.add(Request{name, callback, owner})) {
+		return ERR_MEM;
+	}
+	if(entry != nullptr) {
+		entry->state = State::pending;
+	}
+	checkTimer();
+	return ERR_INPROGRESS;
+}
+
+void DnsResolver::cancel(const void* owner)
+{
+	if(owner == nullptr) {
+		return;
+	}
+
+	for(int i = requests.count() - 1; i >= 0; --i) {
+		if(requests[i].owner == owner) {
+			requests.removeElementAt(i);
+		}
+	}
+}
+
+void DnsResolver::flush(const String& name)
+{
+	auto entry = find(name);
+	if(entry != nullptr && entry->state != State::pending) {
+		*entry = Entry{};
+	}
+}
+
+void DnsResolver::flush()
+{
+	for(auto& entry : entries) {
+		if(entry.state != State::pending) {
+			entry = Entry{};
+		}
+	}
+}
+
+void DnsResolver::refresh(Entry& entry)
+{
+	if(entry.refreshing) {
+		return;
+	}
+
+	++stats.prefetches;
+	entry.refreshing = true;
+	entry.used = false;
+	IpAddress addr;
+	err_t err = lookup(entry.name, addr);
+	if(err == ERR_OK) {
+		update(entry.name, addr);
+	} else if(err == ERR_INPROGRESS) {
+		checkTimer();
+	} else {
+		// Keep existing address until it expires
+		++stats.failures;
+		entry.refreshing = false;
+	}
+}
+
+void DnsResolver::update(const String& name, IpAddress addr)
+{
+	auto entry = find(name);
+	if(entry == nullptr) {
+		entry = allocate(name);
+		if(entry == nullptr) {
+			return;
+		}
+	}
+
+	auto now = millis();
+	if(addr.isNull()) {
+		if(entry->refreshing && entry->state == State::valid) {
+			// Network may be temporarily unavailable so continue using existing address
+			entry->refreshing = false;
+			return;
+		}
+		entry->state = State::failed;
+		entry->expires = now + DNS_CACHE_NEGATIVE_TTL * 1000U;
+	} else {
+		entry->state = State::valid;
+		entry->addr = addr;
+		entry->expires = now + DNS_CACHE_TTL * 1000U;
+	}
+	entry->refreshing = false;
+	checkTimer();
+}
+
+void DnsResolver::dispatch(const String& name, IpAddress addr)
+{
+	// Callbacks may make further requests, so detach all matching ones first
+	Vector<Request> matched;
+	for(int i = requests.count() - 1; i >= 0; --i) {
+		if(requests[i].name.equalsIgnoreCase(name)) {
+			matched.add(requests[i]);
+			requests.removeElementAt(i);
+		}
+	}
+
+	for(int i = matched.count() - 1; i >= 0; --i) {
+		auto& req = matched[i];
+		if(req.callback) {
+			req.callback(req.name, addr);
+		}
+	}
+}
+
+void DnsResolver::staticOnFound(const char* name, LWIP_IP_ADDR_T* ipaddr, void* arg)
+{
+	auto resolver = static_cast<DnsResolver*>(arg);
+	IpAddress addr;
+	if(ipaddr != nullptr) {
+		addr = *ipaddr;
+	} else {
+		++resolver->stats.failures;
+	}
+	debug_d("[DNS] '%s' = %s", name, addr.toString().c_str());
+
+	String s(name);
+	resolver->update(s, addr);
+	resolver->dispatch(s, addr);
+}
+
+void DnsResolver::checkTimer()
+{
+	if(!timer.isStarted()) {
+		timer.initializeMs<DNS_CACHE_CHECK_INTERVAL>([](void* arg) { static_cast<DnsResolver*>(arg)->maintain(); },
+													 this);
+		timer.start();
+	}
+}
+
+void DnsResolver::maintain()
+{
+	auto now = millis();
+	bool active{false};
+	for(auto& entry : entries) {
+		switch(entry.state) {
+		case State::valid:
+			if(entry.refreshing) {
+				break;
+			}
+			if(isDue(entry.expires, now)) {
+				entry = Entry{};
+				continue;
+			}
+			if(entry.used && isDue(entry.expires - DNS_CACHE_PREFETCH * 1000U, now)) {
+				refresh(entry);
+			}
+			break;
+
+		case State::failed:
+			if(isDue(entry.expires, now)) {
+				entry = Entry{};
+				continue;
+			}
+			break;
+
+		case State::pending:
+		case State::empty:
+			break;
+		}
+
+		if(entry.state != State::empty) {
+			active = true;
+		}
+	}
+
+	if(!active) {
+		timer.stop();
+	}
+}
@@ -0,0 +1,180 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/SmingHub/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * DnsResolver.h
+ *
+ ****/
+
+#pragma once
+
+#include <IpAddress.h>
+#include <WVector.h>
+#include <SimpleTimer.h>
+#include <lwip/dns.h>
+
+/** @defgroup   dns DNS resolver
+ *  @brief      Caching host name resolution
+ *  @ingroup    networking
+ *  @{
+ */
+
+/**
+ * @brief Number of host names held by the resolver cache
+ */
+#ifndef DNS_CACHE_SIZE
+#define DNS_CACHE_SIZE 8
+#endif
+
+/**
+ * @brief Seconds a successful lookup is cached for
+ */
+#ifndef DNS_CACHE_TTL
+#define DNS_CACHE_TTL 300
+#endif
+
+/**
+ * @brief Seconds a failed lookup is cached for
+ */
+#ifndef DNS_CACHE_NEGATIVE_TTL
+#define DNS_CACHE_NEGATIVE_TTL 15
+#endif
+
+/**
+ * @brief Entries in use are refreshed when they have fewer than this number of seconds remaining
+ */
+#ifndef DNS_CACHE_PREFETCH
+#define DNS_CACHE_PREFETCH 30
+#endif
+
+/**
+ * @brief Caching front-end for lwIP host name lookups
+ *
+ * Requests for a name which is already being looked up are attached to that lookup,
+ * so a large number of simultaneous connections to the same host produce a single query.
+ * Results are cached, including failures. Entries which have been used recently are
+ * refreshed in the background before they expire.
+ *
+ * lwIP keeps its own table which honours the TTL given by the server, but does not report it,
+ * so entries here are held for a fixed time. A refresh is answered from the lwIP table
+ * until its record expires, which then results in a new query.
+ *
+ * Use the global `Dns` instance.
+ */
+class DnsResolver
+{
+public:
+	/**
+	 * @brief Invoked when an asynchronous lookup completes
+	 * @param name Host name requested
+	 * @param addr Resolved address, null if lookup failed
+	 */
+	using Callback = Delegate<void(const String& name, IpAddress addr)>;
+
+	/**
+	 * @brief Resolver statistics
+	 */
+	struct Stats {
+		unsigned hits;		   ///< Requests answered from cache
+		unsigned negativeHits; ///< Requests answered by a cached failure
+		unsigned misses;	   ///< Requests requiring a lookup
+		unsigned joined;	   ///< Requests attached to a lookup already in progress
+		unsigned lookups;	   ///< Queries passed to lwIP
+		unsigned prefetches;   ///< Lookups made to refresh an entry before it expired
+		unsigned failures;	   ///< Lookups which failed
+	};
+
+	/**
+	 * @brief Resolve a host name
+	 * @param name Host name or address in dotted decimal form
+	 * @param addr On success, the address
+	 * @param callback Invoked when a lookup in progress completes
+	 * @param owner Identifies the caller so the request can be cancelled
+	 * @retval err_t
+	 * - ERR_OK Address returned immediately, callback is not invoked
+	 * - ERR_INPROGRESS Callback will be invoked when lookup completes
+	 * - ERR_VAL Name is invalid or a recent lookup failed
+	 * - Any other error returned by lwIP
+	 */
+	err_t resolve(const String& name, IpAddress& addr, Callback callback, const void* owner = nullptr);
+
+	/**
+	 * @brief Cancel all outstanding requests made by an owner
+	 * @param owner As passed to `resolve()`
+	 *
+	 * Must be called before the owner is destroyed.
+	 */
+	void cancel(const void* owner);
+
+	/**
+	 * @brief Remove a host name from the cache
+	 */
+	void flush(const String& name);
+
+	/**
+	 * @brief Empty the cache
+	 *
+	 * Outstanding requests are unaffected.
+	 */
+	void flush();
+
+	const Stats& getStats() const
+	{
+		return stats;
+	}
+
+	void resetStats()
+	{
+		stats = Stats{};
+	}
+
+private:
+	enum class State : uint8_t {
+		empty,
+		pending,
+		valid,
+		failed,
+	};
+
+	struct Entry {
+		String name;
+		IpAddress addr;
+		uint32_t expires{0};  ///< Time in milliseconds
+		uint32_t lastUsed{0}; ///< For least-recently-used replacement
+		State state{State::empty};
+		bool refreshing{false};
+		bool used{false}; ///< Requested since last refresh
+	};
+
+	struct Request {
+		String name;
+		Callback callback;
+		const void* owner;
+	};
+
+	static bool isDue(uint32_t time, uint32_t now)
+	{
+		return int32_t(time - now) <= 0;
+	}
+
+	Entry* find(const String& name);
+	Entry* allocate(const String& name);
+	err_t lookup(const String& name, IpAddress& addr);
+	void refresh(Entry& entry);
+	void update(const String& name, IpAddress addr);
+	void dispatch(const String& name, IpAddress addr);
+	void checkTimer();
+	void maintain();
+	static void staticOnFound(const char* name, LWIP_IP_ADDR_T* ipaddr, void* arg);
+
+	Entry entries[DNS_CACHE_SIZE];
+	Vector<Request> requests;
+	SimpleTimer timer;
+	Stats stats{};
+};
+
+extern DnsResolver Dns;
+
+/** @} */
@@ -21,21 +21,91 @@
 #include <lwip_includes.h>
 #include <debug_progmem.h>
 
+namespace
+{
+constexpr unsigned DNS_MAX_MESSAGE_SIZE{512}; // Without EDNS
+constexpr unsigned DNS_MAX_NAME_LENGTH{255};  // In wire format
+constexpr unsigned DNS_ANSWER_SIZE{16};
+
+// Compare names in wire format, ignoring case
+bool namesMatch(const char* name1, const char* name2, unsigned length)
+{
+	for(unsigned i = 0; i < length; ++i) {
+		if(tolower(name1[i]) != tolower(name2[i])) {
+			return false;
+		}
+	}
+	return true;
+}
+
+} // namespace
+
 bool DnsServer::start(uint16_t port, const String& domainName, const IpAddress& resolvedIP)
+{
+	String name = domainName;
+	downcaseAndRemoveWwwPrefix(name);
+	zoneTable = nullptr;
+	if(!compileRecord(zoneTable, name, resolvedIP)) {
+		return false;
+	}
+	if(name != "*") {
+		compileRecord(zoneTable, F("www.") + name, resolvedIP);
+	}
+	return start(port, zoneTable.c_str());
+}
+
+bool DnsServer::start(uint16_t port, const char* zone)
 {
 	this->port = port;
-	buffer = nullptr;
-	this->domainName = domainName;
-	this->resolvedIP = resolvedIP;
-	downcaseAndRemoveWwwPrefix(this->domainName);
+	this->zone = zone;
+	setReceiveQueueSize(DNS_SERVER_QUEUE_SIZE);
 	return listen(this->port) == 1;
 }
 
 void DnsServer::stop()
 {
 	close();
-	delete[] buffer;
-	buffer = nullptr;
+	zone = nullptr;
+	zoneTable = nullptr;
+}
+
+bool DnsServer::compileRecord(String& zone, const String& name, const IpAddress& ip)
+{
+	// Each label is preceded by its length, so the result is one longer than the name plus a terminating zero
+	unsigned length = name.length() + 2;
+	if(name.length() == 0 || length > DNS_MAX_NAME_LENGTH) {
+		return false;
+	}
+
+	char record[1 + DNS_MAX_NAME_LENGTH + 4];
+	record[0] = length;
+	char* label = &record[1];
+	*label = 0;
+	for(unsigned i = 0; i < name.length(); ++i) {
+		char c = name[i];
+		if(c == '.') {
+			if(*label == 0) {
+				return false;
+			}
+			label += 1 + *label;
+			*label = 0;
+			continue;
+		}
+		if(*label == 63) {
+			return false;
+		}
+		++*label;
+		label[*label] = tolower(c);
+	}
+	if(*label == 0) {
+		return false;
+	}
+	record[length] = 0;
+	for(unsigned i = 0; i < 4; ++i) {
+		record[1 + length + i] = ip[i];
+	}
+
+	return zone.concat(record, 1 + length + 4);
 }
 
 void DnsServer::downcaseAndRemoveWwwPrefix(String& domainName)
@@ -44,31 +114,96 @@ void DnsServer::downcaseAndRemoveWwwPrefix(String& domainName)
 	domainName.replace(F("www."), String::empty);
 }
 
-bool DnsServer::requestIncludesOnlyOneQuestion()
+bool DnsServer::requestIncludesOnlyOneQuestion(const DnsHeader& header)
 {
-	return ntohs(dnsHeader->QDCount) == 1 && dnsHeader->ANCount == 0 && dnsHeader->NSCount == 0 &&
-		   dnsHeader->ARCount == 0;
+	return ntohs(header.QDCount) == 1 && header.ANCount == 0 && header.NSCount == 0 && header.ARCount == 0;
+}
+
+bool DnsServer::lookup(const char* name, unsigned length, IpAddress& addr) const
+{
+	if(zone == nullptr) {
+		return false;
+	}
+
+	// Records are read individually as the table may be in flash
+	uint8_t record[DNS_MAX_NAME_LENGTH + 4];
+	for(auto p = zone;;) {
+		uint8_t recordLength = pgm_read_byte(p);
+		if(recordLength == 0) {
+			return false;
+		}
+		memcpy_P(record, p + 1, recordLength + 4);
+		p += 1 + recordLength + 4;
+
+		auto recordName = reinterpret_cast<const char*>(record);
+		if(record[0] == 1 && record[1] == '*') {
+			// Wildcard matches one or more labels followed by the given suffix
+			unsigned suffixLength = recordLength - 2;
+			if(length <= suffixLength) {
+				continue;
+			}
+			unsigned offset = 0;
+			while(offset < length - suffixLength) {
+				offset += 1 + uint8_t(name[offset]);
+			}
+			if(offset != length - suffixLength || !namesMatch(&name[offset], &recordName[2], suffixLength)) {
+				continue;
+			}
+		} else if(recordLength != length || !namesMatch(name, recordName, length)) {
+			continue;
+		}
+
+		auto ip = &record[recordLength];
+		addr = IpAddress(ip[0], ip[1], ip[2], ip[3]);
+		return true;
+	}
 }
 
 void DnsServer::onReceive(pbuf* buf, IpAddress remoteIP, uint16_t remotePort)
 {
-	delete[] buffer;
-	buffer = new char[buf->tot_len];
-	if(buffer == nullptr) {
+	reply(buf, remoteIP, remotePort);
+	UdpConnection::onReceive(buf, remoteIP, remotePort);
+}
+
+void DnsServer::reply(pbuf* buf, IpAddress remoteIP, uint16_t remotePort)
+{
+	// Response is built in place over a copy of the request
+	char response[DNS_MAX_MESSAGE_SIZE + DNS_ANSWER_SIZE];
+	unsigned length = buf->tot_len;
+	if(length < sizeof(DnsHeader) || length > DNS_MAX_MESSAGE_SIZE) {
 		return;
 	}
+	pbuf_copy_partial(buf, response, length, 0);
+
+	auto dnsHeader = reinterpret_cast<DnsHeader*>(response);
+	if(dnsHeader->QR != DNS_QR_QUERY) {
+		return;
+	}
+
+	// Locate end of question
+	const char* name = &response[sizeof(DnsHeader)];
+	unsigned nameLength = 0;
+	unsigned idx = sizeof(DnsHeader);
+	while(idx < length && response[idx] != 0 && uint8_t(response[idx]) <= 63) {
+		idx += 1 + uint8_t(response[idx]);
+	}
+	bool valid = idx < length && response[idx] == 0;
+	if(valid) {
+		++idx;
+		nameLength = idx - sizeof(DnsHeader);
+		idx += 4; // Type and class
+		valid = idx <= length;
+	}
+
+	IpAddress resolvedIP;
+	if(valid && dnsHeader->OPCode == DNS_OPCODE_QUERY && requestIncludesOnlyOneQuestion(*dnsHeader) &&
+	   lookup(name, nameLength, resolvedIP)) {
+		debug_d("DNS REQ from %s:%d answered with %s", remoteIP.toString().c_str(), remotePort,
+				resolvedIP.toString().c_str());
 
-	pbuf_copy_partial(buf, buffer, buf->tot_len, 0);
-	debug_d("DNS REQ for %s from %s:%d", getDomainNameWithoutWwwPrefix().c_str(), remoteIP.toString().c_str(),
-			remotePort);
-	dnsHeader = reinterpret_cast<DnsHeader*>(buffer);
-	if(dnsHeader->QR == DNS_QR_QUERY && dnsHeader->OPCode == DNS_OPCODE_QUERY && requestIncludesOnlyOneQuestion() &&
-	   (domainName == "*" || getDomainNameWithoutWwwPrefix() == domainName)) {
-		char response[buf->tot_len + 16];
-		int idx = buf->tot_len;
 		dnsHeader->QR = DNS_QR_RESPONSE;
 		dnsHeader->ANCount = dnsHeader->QDCount;
-		memcpy(response, buffer, idx);
+
 		//Set a pointer to the domain name in the question section
 		response[idx] = 0xC0;
 		response[idx + 1] = 0x0C;
@@ -82,11 +217,10 @@ void DnsServer::onReceive(pbuf* buf, IpAddress remoteIP, uint16_t remotePort)
 		response[idx + 5] = 0x01;
 
 		//TTL
-		auto ttln = htonl(ttl);
-		response[idx + 6] = ttln >> 24;
-		response[idx + 7] = ttln >> 16;
-		response[idx + 8] = ttln >> 8;
-		response[idx + 9] = ttln;
+		response[idx + 6] = ttl >> 24;
+		response[idx + 7] = ttl >> 16;
+		response[idx + 8] = ttl >> 8;
+		response[idx + 9] = ttl;
 
 		//RDATA length
 		response[idx + 10] = 0x00;
@@ -97,44 +231,13 @@ void DnsServer::onReceive(pbuf* buf, IpAddress remoteIP, uint16_t remotePort)
 			response[idx + 12 + i] = resolvedIP[i];
 		}
 
-		sendTo(remoteIP, remotePort, response, idx + 16);
-	} else if(dnsHeader->QR == DNS_QR_QUERY) {
+		sendTo(remoteIP, remotePort, response, idx + DNS_ANSWER_SIZE);
+	} else {
+		debug_d("DNS REQ from %s:%d not answered", remoteIP.toString().c_str(), remotePort);
+
 		dnsHeader->QR = DNS_QR_RESPONSE;
 		dnsHeader->RCode = char(errorReplyCode);
 		dnsHeader->QDCount = 0;
-		sendTo(remoteIP, remotePort, buffer, sizeof(DnsHeader));
-	}
-
-	delete[] buffer;
-	buffer = nullptr;
-
-	UdpConnection::onReceive(buf, remoteIP, remotePort);
-}
-
-String DnsServer::getDomainNameWithoutWwwPrefix()
-{
-	String parsedDomainName;
-	if(buffer == nullptr) {
-		return parsedDomainName;
-	}
-	char* start = buffer + 12;
-	if(*start == 0) {
-		return parsedDomainName;
-	}
-
-	unsigned pos = 0;
-	while(true) {
-		unsigned labelLength = *(start + pos);
-		for(unsigned i = 0; i < labelLength; i++) {
-			pos++;
-			parsedDomainName += start[pos];
-		}
-		pos++;
-		if(start[pos] == 0) {
-			downcaseAndRemoveWwwPrefix(parsedDomainName);
-			return parsedDomainName;
-		} else {
-			parsedDomainName += '.';
-		}
+		sendTo(remoteIP, remotePort, response, sizeof(DnsHeader));
 	}
 }
@@ -30,6 +30,13 @@
 #define DNS_QR_RESPONSE 1
 #define DNS_OPCODE_QUERY 0
 
+/**
+ * @brief Maximum number of queries held for processing together
+ */
+#ifndef DNS_SERVER_QUEUE_SIZE
+#define DNS_SERVER_QUEUE_SIZE 8
+#endif
+
 enum class DnsReplyCode {
 	NoError = 0,
 	FormError = 1,
@@ -93,26 +100,49 @@ public:
 	 */
 	bool start(uint16_t port, const String& domainName, const IpAddress& resolvedIP);
 
+	/**
+	 * @brief Start the DNS server using a compiled zone table
+	 * @param port
+	 * @param zone Table built using `compileRecord()`, may be stored in flash.
+	 * Must remain valid until `stop()` is called.
+	 * @retval bool true if successful, false if there are no sockets available.
+	 *
+	 * The table ends with a zero byte, which is provided by the NUL terminator for a String.
+	 * If the table is copied to flash, include this terminator.
+	 */
+	bool start(uint16_t port, const char* zone);
+
 	/**
 	 * @brief Stop the DNS server
 	 */
 	void stop();
 
+	/**
+	 * @brief Add a record to a zone table
+	 * @param zone Table to append to
+	 * @param name Host name. Use "*" to match any name, or a "*." prefix to match all sub-domains.
+	 * @param ip Address to return
+	 * @retval bool false if the name is invalid
+	 *
+	 * Names are held in DNS wire format, so queries are matched without being decoded.
+	 * The first matching record is used.
+	 */
+	static bool compileRecord(String& zone, const String& name, const IpAddress& ip);
+
 protected:
 	void onReceive(pbuf* buf, IpAddress remoteIP, uint16_t remotePort) override;
 
 private:
 	uint16_t port = 0;
-	String domainName;
-	IpAddress resolvedIP;
-	char* buffer = nullptr;
-	DnsHeader* dnsHeader = nullptr;
+	String zoneTable; ///< Compiled from domain name passed to start()
+	const char* zone = nullptr;
 	uint32_t ttl = 60;
 	DnsReplyCode errorReplyCode = DnsReplyCode::NonExistentDomain;
 
 	static void downcaseAndRemoveWwwPrefix(String& domainName);
-	String getDomainNameWithoutWwwPrefix();
-	bool requestIncludesOnlyOneQuestion();
+	static bool requestIncludesOnlyOneQuestion(const DnsHeader& header);
+	bool lookup(const char* name, unsigned length, IpAddress& addr) const;
+	void reply(pbuf* buf, IpAddress remoteIP, uint16_t remotePort);
 };
 
 /** @} */
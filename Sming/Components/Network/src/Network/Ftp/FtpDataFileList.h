@@ -60,6 +60,7 @@ public:
 			if(written < 0) {
 				return;
 			}
+			transferred += written;
 			statValid = dir.next();
 		}
 
@@ -11,35 +11,35 @@
 #pragma once
 
 #include "FtpDataStream.h"
-#include "FileSystem.h"
+#include <Data/Stream/IFS/FileStream.h>
 
+/**
+ * @brief Sends file content
+ *
+ * Data is passed to the TCP stack directly from the file stream's read-ahead buffer,
+ * filling the available send window on each call.
+ */
 class FtpDataRetrieve : public FtpDataStream
 {
 public:
 	FtpDataRetrieve(FtpServerConnection& connection, const String& fileName)
-		: FtpDataStream(connection), file(fileOpen(fileName, File::ReadOnly))
-	{
-	}
-
-	~FtpDataRetrieve()
+		: FtpDataStream(connection), file(connection.getFileSystem())
 	{
-		fileClose(file);
+		file.open(fileName);
 	}
 
 	void transferData(TcpConnectionEvent sourceEvent) override
 	{
-		if(completed) {
+		if(completed || tcp == nullptr) {
 			return;
 		}
-		char buf[1024];
-		int len = fileRead(file, buf, sizeof(buf));
-		write(buf, len, TCP_WRITE_FLAG_COPY);
-		if(fileIsEOF(file)) {
+		transferred += write(&file);
+		if(file.isFinished()) {
 			completed = true;
 			finishTransfer();
 		}
 	}
 
 private:
-	FileHandle file;
+	IFS::FileStream file;
 };
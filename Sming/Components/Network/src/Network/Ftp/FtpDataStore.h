@@ -34,13 +34,14 @@ public:
 
 		if(buf == nullptr) {
 			completed = true;
-			response(226, "Transfer completed");
+			response(226, getTransferStatus());
 			return TcpConnection::onReceive(buf);
 		}
 
 		pbuf* cur = buf;
 		while(cur != nullptr && cur->len > 0) {
 			fileWrite(file, (uint8_t*)cur->payload, cur->len);
+			transferred += cur->len;
 			cur = cur->next;
 		}
 
@@ -49,16 +49,29 @@ public:
 		control.dataStreamDestroyed(this);
 	}
 
+	/**
+	 * @brief Take over a connection accepted in passive mode
+	 */
+	void attach(tcp_pcb* pcb)
+	{
+		initialize(pcb);
+		onConnected(ERR_OK);
+	}
+
 	err_t onConnected(err_t err) override
 	{
 		setTimeOut(300);
+		startTime = millis();
 		return TcpConnection::onConnected(err);
 	}
 
 	void finishTransfer()
 	{
+		// close() may destroy this object
+		auto& ctrl = control;
+		auto status = getTransferStatus();
 		close();
-		control.dataTransferFinished(this);
+		ctrl.dataTransferFinished(this, status);
 	}
 
 	void response(int code, String text = nullptr)
@@ -79,7 +92,27 @@ public:
 	{
 	}
 
+	/**
+	 * @brief Get text describing the transfer size and rate, logging the result
+	 */
+	String getTransferStatus()
+	{
+		auto elapsed = millis() - startTime;
+		auto rate = (elapsed == 0) ? 0 : uint32_t(uint64_t(transferred) * 1000 / 1024 / elapsed);
+		String s = F("Transfer complete, ");
+		s += transferred;
+		s += F(" bytes in ");
+		s += elapsed;
+		s += F(" ms (");
+		s += rate;
+		s += F(" KB/s)");
+		debug_i("[FTP] %s", s.c_str());
+		return s;
+	}
+
 protected:
 	FtpServerConnection& control;
+	uint32_t startTime{0};
+	size_t transferred{0};
 	bool completed{false};
 };
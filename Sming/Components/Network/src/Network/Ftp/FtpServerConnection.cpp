@@ -97,6 +97,13 @@ FtpServerConnection::FtpServerConnection(CustomFtpServer& parentServer, tcp_pcb*
 	writeString(_F("220 Welcome to Sming FTP\r\n"));
 }
 
+FtpServerConnection::~FtpServerConnection()
+{
+	closePassive();
+	// Data connection cannot outlive the control connection
+	delete dataConnection;
+}
+
 err_t FtpServerConnection::onReceive(pbuf* buf)
 {
 	if(buf == nullptr) {
@@ -144,9 +151,128 @@ void FtpServerConnection::cmdPort(const String& data)
 	int p2 = ps2.toInt();
 	port = (p1 << 8) | p2;
 	debug_d("connection to: %s, %d", ip.toString().c_str(), port);
+	closePassive();
+	passive = false;
 	response(200);
 }
 
+void FtpServerConnection::cmdPasv()
+{
+	closePassive();
+	passive = true;
+
+	auto pcb = tcp_new();
+	if(pcb == nullptr) {
+		response(425, F("Can't open data connection"));
+		return;
+	}
+
+	// Let the stack choose a free port, so each session gets its own
+	if(tcp_bind(pcb, IP_ADDR_ANY, 0) != ERR_OK) {
+		tcp_close(pcb);
+		response(425, F("Can't open data connection"));
+		return;
+	}
+
+	auto listener = tcp_listen(pcb);
+	if(listener == nullptr) {
+		tcp_close(pcb);
+		response(425, F("Can't open data connection"));
+		return;
+	}
+
+	passiveListener = listener;
+	tcp_arg(listener, this);
+	tcp_accept(listener, [](void* arg, tcp_pcb* pcb, err_t err) -> err_t {
+		auto connection = static_cast<FtpServerConnection*>(arg);
+		if(connection == nullptr || err != ERR_OK) {
+			tcp_abort(pcb);
+			return ERR_ABRT;
+		}
+		return connection->onPassiveAccept(pcb);
+	});
+
+	IpAddress localIp(tcp->local_ip);
+	auto localPort = listener->local_port;
+	char buf[64];
+	m_snprintf(buf, sizeof(buf), _F("Entering Passive Mode (%u,%u,%u,%u,%u,%u)"), localIp[0], localIp[1], localIp[2],
+			   localIp[3], localPort >> 8, localPort & 0xff);
+	response(227, buf);
+}
+
+err_t FtpServerConnection::onPassiveAccept(tcp_pcb* pcb)
+{
+	// Only the client at the other end of the control connection may connect
+	if(tcp == nullptr || IpAddress(pcb->remote_ip) != getRemoteIp()) {
+		debug_w("[FTP] Rejected passive connection from %s", IpAddress(pcb->remote_ip).toString().c_str());
+		tcp_abort(pcb);
+		return ERR_ABRT;
+	}
+
+	// One connection per PASV command
+	closePassiveListener();
+
+	if(dataConnection != nullptr) {
+		dataConnection->attach(pcb);
+		return ERR_OK;
+	}
+
+	// Hold connection until we get a command to service
+	passiveConnection = pcb;
+	tcp_arg(pcb, this);
+	tcp_recv(pcb, [](void* arg, tcp_pcb* pcb, pbuf* p, err_t err) -> err_t {
+		if(p != nullptr) {
+			// Refuse data for now: the stack passes it on again once a data stream is attached
+			return ERR_MEM;
+		}
+		// Closed by client
+		auto connection = static_cast<FtpServerConnection*>(arg);
+		tcp_abort(connection->releasePassiveConnection());
+		return ERR_ABRT;
+	});
+	tcp_err(pcb, [](void* arg, err_t err) {
+		// pcb has already been freed
+		auto connection = static_cast<FtpServerConnection*>(arg);
+		connection->passiveConnection = nullptr;
+	});
+
+	return ERR_OK;
+}
+
+void FtpServerConnection::closePassiveListener()
+{
+	if(passiveListener == nullptr) {
+		return;
+	}
+
+	tcp_arg(passiveListener, nullptr);
+	tcp_accept(passiveListener, nullptr);
+	tcp_close(passiveListener);
+	passiveListener = nullptr;
+}
+
+tcp_pcb* FtpServerConnection::releasePassiveConnection()
+{
+	auto pcb = passiveConnection;
+	if(pcb != nullptr) {
+		tcp_arg(pcb, nullptr);
+		tcp_recv(pcb, nullptr);
+		tcp_err(pcb, nullptr);
+		passiveConnection = nullptr;
+	}
+	return pcb;
+}
+
+void FtpServerConnection::closePassive()
+{
+	closePassiveListener();
+
+	auto pcb = releasePassiveConnection();
+	if(pcb != nullptr) {
+		tcp_abort(pcb);
+	}
+}
+
 IFS::FileSystem* FtpServerConnection::getFileSystem()
 {
 	auto fs = server.getFileSystem();
@@ -371,10 +497,9 @@ void FtpServerConnection::onCommand(String cmd, String data)
 		break;
 	}
 
-	case Command::PASV: {
-		response(500, F("Passive mode not supported"));
+	case Command::PASV:
+		cmdPasv();
 		break;
-	}
 
 	case Command::NOOP: {
 		response(200);
@@ -413,11 +538,33 @@ err_t FtpServerConnection::onSent(uint16_t len)
 void FtpServerConnection::setDataConnection(FtpDataStream* connection)
 {
 	if(dataConnection != nullptr) {
-		SYSTEM_ERROR("[FTP] Data connection already exists!");
+		debug_e("[FTP] Data connection already exists!");
+		delete connection;
+		response(425, F("Transfer in progress"));
+		return;
+	}
+
+	if(!passive) {
+		dataConnection = connection;
+		dataConnection->connect(ip, port);
+		response(150, F("Connecting"));
+		return;
+	}
+
+	if(passiveListener == nullptr && passiveConnection == nullptr) {
+		delete connection;
+		response(425, F("Use PASV first"));
+		return;
 	}
+
 	dataConnection = connection;
-	dataConnection->connect(ip, port);
-	response(150, F("Connecting"));
+	response(150, F("Opening data connection"));
+
+	// Otherwise connection is attached when the client connects
+	auto pcb = releasePassiveConnection();
+	if(pcb != nullptr) {
+		connection->attach(pcb);
+	}
 }
 
 void FtpServerConnection::dataStreamDestroyed(TcpConnection* connection)
@@ -429,7 +576,7 @@ void FtpServerConnection::dataStreamDestroyed(TcpConnection* connection)
 	dataConnection = nullptr;
 }
 
-void FtpServerConnection::dataTransferFinished(TcpConnection* connection)
+void FtpServerConnection::dataTransferFinished(TcpConnection* connection, const String& status)
 {
 	if(dataConnection != nullptr) {
 		if(connection != dataConnection) {
@@ -438,7 +585,11 @@ void FtpServerConnection::dataTransferFinished(TcpConnection* connection)
 		dataConnection = nullptr;
 	}
 
-	response(226, F("Transfer Complete."));
+	if(status) {
+		response(226, status);
+	} else {
+		response(226, F("Transfer Complete."));
+	}
 }
 
 void FtpServerConnection::response(int code, String text, char sep)
@@ -43,11 +43,12 @@ public:
 	static constexpr size_t MAX_FTP_CMD{255};
 
 	FtpServerConnection(CustomFtpServer& parentServer, tcp_pcb* clientTcp);
+	~FtpServerConnection();
 
 	err_t onReceive(pbuf* buf) override;
 	err_t onSent(uint16_t len) override;
 
-	void dataTransferFinished(TcpConnection* connection);
+	void dataTransferFinished(TcpConnection* connection, const String& status = nullptr);
 	void dataStreamDestroyed(TcpConnection* connection);
 
 	const User& getUser() const
@@ -64,6 +65,7 @@ protected:
 	virtual void onCommand(String cmd, String data);
 
 	void cmdPort(const String& data);
+	void cmdPasv();
 	void setDataConnection(FtpDataStream* connection);
 	String resolvePath(const char* name);
 	bool checkFileAccess(const char* filename, IFS::OpenFlags flags);
@@ -78,6 +80,14 @@ private:
 	bool readyForData{false};
 	CString cwd;
 	FtpDataStream* dataConnection{nullptr};
+	tcp_pcb* passiveListener{nullptr};   ///< Waiting for client to connect in passive mode
+	tcp_pcb* passiveConnection{nullptr}; ///< Accepted before data command received
+	bool passive{false};
+
+	void closePassive();
+	void closePassiveListener();
+	tcp_pcb* releasePassiveConnection();
+	err_t onPassiveAccept(tcp_pcb* pcb);
 };
 
 /** @} */
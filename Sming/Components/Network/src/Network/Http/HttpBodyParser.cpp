@@ -16,6 +16,8 @@
 
 #include "HttpBodyParser.h"
 #include <Data/WebHelpers/escape.h>
+#include <stringutil.h>
+#include <new>
 
 /*
  * Content is received in chunks which we need to reassemble into name=value pairs.
@@ -130,3 +132,170 @@ size_t bodyToStringParser(HttpRequest& request, const char* at, int length)
 
 	return length;
 }
+
+size_t JsonBodyParser::parse(HttpRequest& request, const char* at, int length)
+{
+	auto parser = static_cast<JsonStreamParser*>(request.args);
+
+	if(length == PARSE_DATASTART) {
+		delete parser;
+		request.args = new JsonStreamParser([this, &request](const JsonStreamParser::Element& element) {
+			return !callback || callback(request, element);
+		});
+		return 0;
+	}
+
+	if(parser == nullptr) {
+		debug_e("Invalid request argument");
+		return 0;
+	}
+
+	if(length == PARSE_DATAEND || length < 0) {
+		if(!parser->finish()) {
+			debug_w("[JSON] Request body invalid or incomplete");
+		}
+		delete parser;
+		request.args = nullptr;
+		return 0;
+	}
+
+	return parser->parse(at, length) ? length : 0;
+}
+
+/*
+ * The arena follows this structure in the same allocation.
+ * Whilst reading the value, the decoded name is held at the start of the arena, NUL-terminated.
+ */
+struct FormBodyParser::State {
+	uint16_t length;	 ///< Bytes used in arena
+	uint16_t nameLength; ///< Decoded length of name
+	bool inValue;
+	bool failed; ///< Remaining data is ignored
+
+	char* arena()
+	{
+		return reinterpret_cast<char*>(this + 1);
+	}
+
+	static State* create(uint16_t arenaSize)
+	{
+		auto mem = ::operator new(sizeof(State) + arenaSize, std::nothrow);
+		return (mem == nullptr) ? nullptr : new(mem) State{};
+	}
+
+	static void release(void*& state)
+	{
+		::operator delete(state);
+		state = nullptr;
+	}
+
+	/*
+	 * Decode in place, including '+' as space. Invalid escapes are left as-is.
+	 */
+	static uint16_t unescape(char* str, uint16_t length)
+	{
+		auto out = str;
+		auto in = str;
+		auto end = str + length;
+		while(in < end) {
+			char c = *in++;
+			if(c == '+') {
+				c = ' ';
+			} else if(c == '%' && end - in >= 2) {
+				auto hi = unhex(in[0]);
+				auto lo = unhex(in[1]);
+				if(hi >= 0 && lo >= 0) {
+					c = (hi << 4) | lo;
+					in += 2;
+				}
+			}
+			*out++ = c;
+		}
+		return out - str;
+	}
+};
+
+bool FormBodyParser::completeField(HttpRequest& request, State& state)
+{
+	auto arena = state.arena();
+
+	if(!state.inValue) {
+		// Name without a value
+		state.nameLength = State::unescape(arena, state.length);
+		arena[state.nameLength] = '\0';
+		state.length = state.nameLength + 1;
+	}
+
+	unsigned valueStart = state.nameLength + 1;
+	auto value = &arena[valueStart];
+	auto valueLength = State::unescape(value, state.length - valueStart);
+	value[valueLength] = '\0';
+
+	bool ok{true};
+	// Skip empty fields, as in "a=1&&b=2"
+	if(state.nameLength != 0 || state.inValue) {
+		ok = !callback || callback(request, Field{arena, value, state.nameLength, valueLength});
+	}
+
+	state.length = 0;
+	state.nameLength = 0;
+	state.inValue = false;
+	return ok;
+}
+
+size_t FormBodyParser::parse(HttpRequest& request, const char* at, int length)
+{
+	auto state = static_cast<State*>(request.args);
+
+	if(length == PARSE_DATASTART) {
+		State::release(request.args);
+		request.args = State::create(arenaSize);
+		return 0;
+	}
+
+	if(state == nullptr) {
+		debug_e("Invalid request argument");
+		return 0;
+	}
+
+	if(length == PARSE_DATAEND || length < 0) {
+		if(!state->failed && (state->length != 0 || state->inValue)) {
+			completeField(request, *state);
+		}
+		State::release(request.args);
+		return 0;
+	}
+
+	if(state->failed) {
+		return 0;
+	}
+
+	// Two bytes are reserved for the NUL terminators
+	const unsigned maxLength = arenaSize - 2;
+	auto arena = state->arena();
+	for(int i = 0; i < length; ++i) {
+		char c = at[i];
+		if(c == '&') {
+			if(!completeField(request, *state)) {
+				state->failed = true;
+				return 0;
+			}
+			continue;
+		}
+		if(c == '=' && !state->inValue) {
+			state->nameLength = State::unescape(arena, state->length);
+			arena[state->nameLength] = '\0';
+			state->length = state->nameLength + 1;
+			state->inValue = true;
+			continue;
+		}
+		if(state->length >= maxLength) {
+			debug_w("[FORM] Field exceeds %u bytes", maxLength);
+			state->failed = true;
+			return 0;
+		}
+		arena[state->length++] = c;
+	}
+
+	return length;
+}
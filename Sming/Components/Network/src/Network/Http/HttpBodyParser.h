@@ -14,12 +14,22 @@
 
 #include "HttpCommon.h"
 #include "HttpRequest.h"
+#include <Data/JsonStreamParser.h>
 
 /**
  * @ingroup http
  * {
  */
 
+#ifndef FORM_BODY_ARENA_SIZE
+/**
+ * @brief Default buffer size for `FormBodyParser`
+ *
+ * Must accommodate the longest encoded name plus value, plus two bytes.
+ */
+#define FORM_BODY_ARENA_SIZE 256
+#endif
+
 /** @brief special length values passed to parse functions */
 const int PARSE_DATASTART = -1; ///< Start of incoming data
 const int PARSE_DATAEND = -2;   ///< End of incoming data
@@ -53,4 +63,133 @@ size_t formUrlParser(HttpRequest& request, const char* at, int length);
  */
 size_t bodyToStringParser(HttpRequest& request, const char* at, int length);
 
+/**
+ * @brief Parses application/json body data incrementally as it arrives
+ *
+ * The body is not stored. Instead, the callback is invoked for each element
+ * as described for `JsonStreamParser`. A malformed document, or one exceeding the
+ * nesting or token length limits, causes the request to fail with 400 Bad Request.
+ *
+ * For example:
+ *
+ * ```
+ * JsonBodyParser jsonParser([](HttpRequest& request, const JsonStreamParser::Element& element) {
+ *     if(strcmp(element.path, "/wifi/ssid") == 0) {
+ *         ssid = element.toString();
+ *     }
+ *     return true;
+ * });
+ *
+ * server.setBodyParser(MIME_JSON, jsonParser);
+ * ```
+ *
+ * The parser object must remain valid for as long as it is registered.
+ *
+ * @note Errors detected at PARSE_DATAEND, such as a truncated document, cannot fail the request.
+ * Applications should check that the root element end event has been received before acting on the data.
+ */
+class JsonBodyParser
+{
+public:
+	/**
+	 * @brief Callback invoked for each element
+	 * @retval bool Return false to stop parsing and fail the request
+	 */
+	using Callback = Delegate<bool(HttpRequest& request, const JsonStreamParser::Element& element)>;
+
+	JsonBodyParser(Callback callback) : callback(callback)
+	{
+	}
+
+	/**
+	 * @see `HttpBodyParserDelegate`
+	 */
+	size_t parse(HttpRequest& request, const char* at, int length);
+
+	operator HttpBodyParserDelegate()
+	{
+		return HttpBodyParserDelegate(&JsonBodyParser::parse, this);
+	}
+
+private:
+	Callback callback;
+};
+
+/**
+ * @brief Parses application/x-www-form-urlencoded body data as it arrives
+ *
+ * Unlike `formUrlParser`, nothing is stored in `HttpRequest::postParams`.
+ * Each request is given a single buffer (arena) of fixed size which receives the current name and value.
+ * These are percent-decoded in place once complete and passed to the callback.
+ * A field which does not fit in the arena fails the request with 400 Bad Request as soon as it is detected.
+ *
+ * For example:
+ *
+ * ```
+ * FormBodyParser formParser([](HttpRequest& request, const FormBodyParser::Field& field) {
+ *     if(strcmp(field.name, "ssid") == 0) {
+ *         ssid = field.getValue();
+ *     }
+ *     return true;
+ * });
+ *
+ * server.setBodyParser(MIME_FORM_URL_ENCODED, formParser);
+ * ```
+ *
+ * The parser object must remain valid for as long as it is registered.
+ */
+class FormBodyParser
+{
+public:
+	/**
+	 * @brief A decoded name/value pair
+	 * @note Both strings are NUL-terminated. They are only valid during the callback.
+	 */
+	struct Field {
+		const char* name;
+		const char* value;
+		uint16_t nameLength;
+		uint16_t valueLength;
+
+		String getValue() const
+		{
+			return String(value, valueLength);
+		}
+	};
+
+	/**
+	 * @brief Callback invoked for each field
+	 * @retval bool Return false to stop parsing and fail the request
+	 */
+	using Callback = Delegate<bool(HttpRequest& request, const Field& field)>;
+
+	/**
+	 * @brief Constructor
+	 * @param callback
+	 * @param arenaSize Buffer to allocate per request, see `FORM_BODY_ARENA_SIZE`
+	 */
+	FormBodyParser(Callback callback, uint16_t arenaSize = FORM_BODY_ARENA_SIZE)
+		: callback(callback), arenaSize(arenaSize)
+	{
+	}
+
+	/**
+	 * @see `HttpBodyParserDelegate`
+	 */
+	size_t parse(HttpRequest& request, const char* at, int length);
+
+	operator HttpBodyParserDelegate()
+	{
+		return HttpBodyParserDelegate(&FormBodyParser::parse, this);
+	}
+
+private:
+	struct State;
+
+	bool completeField(HttpRequest& request, State& state);
+
+	Callback callback;
+	uint16_t arenaSize;
+};
+
 /** @} */
@@ -41,17 +41,43 @@ bool HttpClientConnection::connect(const String& host, int port, bool useSsl)
 
 bool HttpClientConnection::send(HttpRequest* request)
 {
-	if(!waitingQueue.enqueue(request)) {
+	if(!queueRequest(request)) {
 		// the queue is full and we cannot add more requests at the time.
 		debug_e("HCC::send: The request queue is full at the moment");
 		delete request;
 		return false;
 	}
 
+	lastActivity = millis();
+
 	bool useSsl = (request->uri.Scheme == URI_SCHEME_HTTP_SECURE);
 	return connect(request->uri.Host, request->uri.getPort(), useSsl);
 }
 
+bool HttpClientConnection::queueRequest(HttpRequest* request)
+{
+	if(waitingQueue.full()) {
+		return false;
+	}
+
+	// Keep queue ordered by priority, placing request after any others of the same or higher priority
+	unsigned count = waitingQueue.count();
+	bool queued = false;
+	for(unsigned i = 0; i < count; ++i) {
+		auto req = waitingQueue.dequeue();
+		if(!queued && req->priority < request->priority) {
+			waitingQueue.enqueue(request);
+			queued = true;
+		}
+		waitingQueue.enqueue(req);
+	}
+	if(!queued) {
+		waitingQueue.enqueue(request);
+	}
+
+	return true;
+}
+
 void HttpClientConnection::reset()
 {
 	incomingRequest = nullptr;
@@ -115,6 +141,11 @@ int HttpClientConnection::onMessageComplete(http_parser* parser)
 	debug_d("HCC::onMessageComplete: executionQueue: %d, %s", executionQueue.count(),
 			incomingRequest->uri.toString().c_str());
 
+	// Make sure any buffered content has been written out before reporting completion
+	if(response.buffer != nullptr) {
+		response.buffer->flush();
+	}
+
 	// we are finished with this request
 	int hasError = 0;
 	if(incomingRequest->requestCompletedDelegate) {
@@ -132,6 +163,7 @@ int HttpClientConnection::onMessageComplete(http_parser* parser)
 
 	delete incomingRequest;
 	incomingRequest = nullptr;
+	lastActivity = millis();
 
 	state = eHCS_Ready;
 
@@ -158,7 +190,7 @@ int HttpClientConnection::onMessageComplete(http_parser* parser)
 	return hasError;
 }
 
-int HttpClientConnection::onHeadersComplete(const HttpHeaders& headers)
+int HttpClientConnection::onHeadersComplete(const HttpHeaderBuilder& headers)
 {
 	/* Callbacks should return non-zero to indicate an error. The parser will
 	 * then halt execution.
@@ -180,7 +212,7 @@ int HttpClientConnection::onHeadersComplete(const HttpHeaders& headers)
 		return 1;
 	}
 
-	response.headers.setMultiple(headers);
+	headers.copyTo(response.headers);
 	response.code = HttpStatus(parser.status_code);
 
 	if(incomingRequest->auth != nullptr) {
@@ -249,6 +281,11 @@ REENTER:
 
 		// if the executionQueue is not empty then we have to check if we can pipeline that request
 		if(executionQueue.count() != 0) {
+			if(executionQueue.count() >= pipelineDepth) {
+				// wait for outstanding responses
+				break;
+			}
+
 			if(!(allowPipe && (request->method == HTTP_GET || request->method == HTTP_HEAD))) {
 				// if the current request cannot be pipelined -> break;
 				break;
@@ -409,10 +446,56 @@ bool HttpClientConnection::sendRequestBody(HttpRequest* request)
 
 void HttpClientConnection::cleanup()
 {
+	auto activeRequest = incomingRequest;
 	reset();
+	outgoingRequest = nullptr;
 
-	// if there are requests in the executionQueue -> move them back to the waiting queue
+	requeueRequests(activeRequest);
+}
+
+void HttpClientConnection::requeueRequests(HttpRequest* activeRequest)
+{
+	/*
+	 * Requests in the executionQueue have been sent but not answered, so may be replayed
+	 * if it's safe to do so. They go back to the head of the waiting queue in their original order.
+	 * A request whose response was partially received is not replayed as its data
+	 * may already have been consumed.
+	 */
+	HttpRequest* failed[HTTP_REQUEST_POOL_SIZE];
+	unsigned failedCount = 0;
+	unsigned waitingCount = waitingQueue.count();
 	while(executionQueue.count() != 0) {
-		waitingQueue.enqueue(executionQueue.dequeue());
+		auto request = executionQueue.dequeue();
+		if(request != activeRequest && request->isIdempotent() && request->replayCount < HTTP_CLIENT_MAX_REPLAYS &&
+		   waitingQueue.enqueue(request)) {
+			++request->replayCount;
+			continue;
+		}
+		debug_w("HCC::requeueRequests: Cannot replay %s", request->uri.toString().c_str());
+		failed[failedCount++] = request;
+	}
+
+	for(unsigned i = 0; i < waitingCount; ++i) {
+		waitingQueue.enqueue(waitingQueue.dequeue());
+	}
+
+	// Callbacks may queue further requests so notify only once queues are consistent
+	for(unsigned i = 0; i < failedCount; ++i) {
+		failRequest(failed[i]);
+	}
+}
+
+void HttpClientConnection::failRequest(HttpRequest* request)
+{
+	if(request->requestCompletedDelegate) {
+		request->requestCompletedDelegate(*this, false);
+	}
+	delete request;
+}
+
+void HttpClientConnection::freeRequests(RequestQueue& queue)
+{
+	while(queue.count() != 0) {
+		delete queue.dequeue();
 	}
 }
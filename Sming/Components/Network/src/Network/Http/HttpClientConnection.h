@@ -16,6 +16,7 @@
 #include "DateTime.h"
 #include "Data/ObjectQueue.h"
 #include <Data/Stream/MultipartStream.h>
+#include <Clock.h>
 
 /**
  *  @brief      Provides http client connection
@@ -34,12 +35,11 @@ public:
 
 	~HttpClientConnection()
 	{
-		cleanup();
+		reset();
 
 		// Free any outstanding queued requests
-		while(waitingQueue.count() != 0) {
-			delete waitingQueue.dequeue();
-		}
+		freeRequests(executionQueue);
+		freeRequests(waitingQueue);
 	}
 
 	bool connect(const String& host, int port, bool useSsl = false) override;
@@ -58,11 +58,44 @@ public:
 		return (waitingQueue.count() + executionQueue.count() == 0);
 	}
 
+	/**
+	 * @brief Get number of requests waiting or in flight
+	 */
+	unsigned getPendingCount() const
+	{
+		return waitingQueue.count() + executionQueue.count();
+	}
+
+	/**
+	 * @brief Get time since a request was last queued or completed
+	 * @retval uint32_t Milliseconds
+	 */
+	uint32_t getIdleTime() const
+	{
+		return millis() - lastActivity;
+	}
+
+	/**
+	 * @brief Set maximum number of requests which may be in flight at once
+	 * @param depth Use 1 to disable pipelining
+	 * @note Only GET and HEAD requests are pipelined. Others are sent only once all
+	 * previous responses have been received.
+	 */
+	void setPipelineDepth(uint8_t depth)
+	{
+		pipelineDepth = depth ?: 1;
+	}
+
+	uint8_t getPipelineDepth() const
+	{
+		return pipelineDepth;
+	}
+
 protected:
 	// HTTP parser methods
 
 	int onMessageBegin(http_parser* parser) override;
-	int onHeadersComplete(const HttpHeaders& headers) override;
+	int onHeadersComplete(const HttpHeaderBuilder& headers) override;
 	int onBody(const char* at, size_t length) override;
 	int onMessageComplete(http_parser* parser) override;
 
@@ -93,6 +126,10 @@ protected:
 	}
 
 private:
+	bool queueRequest(HttpRequest* request);
+	void requeueRequests(HttpRequest* activeRequest);
+	void failRequest(HttpRequest* request);
+	static void freeRequests(RequestQueue& queue);
 	void sendRequestHeaders(HttpRequest* request);
 	bool sendRequestBody(HttpRequest* request);
 	MultipartStream::BodyPart multipartProducer();
@@ -105,6 +142,8 @@ private:
 	HttpRequest* outgoingRequest = nullptr;
 
 	bool allowPipe = false; /// < Flag to specify if HTTP pipelining is allowed for this connection
+	uint8_t pipelineDepth = HTTP_CLIENT_PIPELINE_DEPTH;
+	uint32_t lastActivity = 0; ///< millis() when last used
 };
 
 /** @} */
@@ -29,6 +29,16 @@
 #define HTTP_REQUEST_POOL_SIZE 20
 #endif
 
+/* Default maximum number of requests a client connection may have in flight */
+#ifndef HTTP_CLIENT_PIPELINE_DEPTH
+#define HTTP_CLIENT_PIPELINE_DEPTH 4
+#endif
+
+/* Number of times a client request may be re-sent after the connection is lost */
+#ifndef HTTP_CLIENT_MAX_REPLAYS
+#define HTTP_CLIENT_MAX_REPLAYS 2
+#endif
+
 #include "http-parser/http_parser.h"
 
 /**
@@ -64,8 +64,7 @@ void HttpConnection::setDefaultParser()
 
 void HttpConnection::resetHeaders()
 {
-	header.reset();
-	incomingHeaders.clear();
+	incomingHeaders.reset();
 }
 
 int HttpConnection::staticOnMessageBegin(http_parser* parser)
@@ -80,7 +79,7 @@ int HttpConnection::staticOnPath(http_parser* parser, const char* at, size_t len
 {
 	GET_CONNECTION()
 
-	return connection->onPath(String(at, length));
+	return connection->onPath(UrlView(at, length));
 }
 
 #ifndef COMPACT_MODE
@@ -110,14 +109,14 @@ int HttpConnection::staticOnHeaderField(http_parser* parser, const char* at, siz
 {
 	GET_CONNECTION()
 
-	return connection->header.onHeaderField(at, length);
+	return connection->incomingHeaders.onHeaderField(at, length);
 }
 
 int HttpConnection::staticOnHeaderValue(http_parser* parser, const char* at, size_t length)
 {
 	GET_CONNECTION()
 
-	return connection->header.onHeaderValue(connection->incomingHeaders, at, length);
+	return connection->incomingHeaders.onHeaderValue(at, length);
 }
 
 int HttpConnection::staticOnHeadersComplete(http_parser* parser)
@@ -104,11 +104,21 @@ protected:
 		return 0;
 	}
 
+	/** @brief Called when the URL path is known, before conversion to a Url
+	 * 	@param uri View of the URL within the receive buffer, only valid during this call
+	 * 	@retval int 0 on success, non-0 on error
+	 * 	@note Default implementation converts to a Url and calls `onPath(const Url&)`
+	 */
+	virtual int onPath(const UrlView& uri)
+	{
+		return onPath(Url(uri));
+	}
+
 	/** @brief Called when all headers are received
 	 * 	@param headers The processed headers
 	 * 	@retval int 0 on success, non-0 on error
 	 */
-	virtual int onHeadersComplete(const HttpHeaders& headers) = 0;
+	virtual int onHeadersComplete(const HttpHeaderBuilder& headers) = 0;
 
 #ifndef COMPACT_MODE
 	virtual int onStatus(http_parser* parser)
@@ -182,8 +192,7 @@ private:
 protected:
 	http_parser parser;
 	static const http_parser_settings parserSettings; ///< Callback table for parser
-	HttpHeaderBuilder header;						  ///< Header construction
-	HttpHeaders incomingHeaders;					  ///< Full set of incoming headers
+	HttpHeaderBuilder incomingHeaders;				  ///< Full set of incoming headers
 	HttpConnectionState state = eHCS_Ready;
 
 	HttpResponse response;
@@ -0,0 +1,60 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/SmingHub/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * HttpConnectionRecycler.cpp
+ *
+ ****/
+
+#include "HttpConnectionRecycler.h"
+#include "HttpServerConnection.h"
+
+void HttpConnectionRecycler::setCapacity(uint8_t capacity)
+{
+	slots.reset();
+	used = 0;
+	this->capacity = 0;
+	if(capacity == 0) {
+		return;
+	}
+
+	slots.reset(new(std::nothrow) Storage[capacity]);
+	if(slots) {
+		this->capacity = capacity;
+	}
+}
+
+void HttpConnectionRecycler::exchange(Storage& storage, HttpServerConnection& connection)
+{
+	storage.requestHeaders.swap(connection.request.headers);
+	storage.responseHeaders.swap(connection.response.headers);
+	storage.incomingHeaders.swap(connection.incomingHeaders);
+}
+
+void HttpConnectionRecycler::put(HttpServerConnection& connection)
+{
+	if(used >= capacity) {
+		++stats.discarded;
+		return;
+	}
+
+	auto& storage = slots[used++];
+	exchange(storage, connection);
+	storage.requestHeaders.reset();
+	storage.responseHeaders.reset();
+	storage.incomingHeaders.reset();
+	++stats.recycled;
+}
+
+void HttpConnectionRecycler::take(HttpServerConnection& connection)
+{
+	if(used == 0) {
+		return;
+	}
+
+	// Connection is new so slot receives empty storage in exchange
+	exchange(slots[--used], connection);
+	++stats.reused;
+}
@@ -0,0 +1,87 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/SmingHub/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * HttpConnectionRecycler.h
+ *
+ ****/
+
+#pragma once
+
+#include "HttpHeaders.h"
+#include "HttpHeaderBuilder.h"
+#include <memory>
+
+class HttpServerConnection;
+
+/**
+ * @brief Retains header storage from closed server connections for use by new ones
+ * @ingroup httpserver
+ *
+ * Connection objects themselves come from an ObjectPool, but the header maps and
+ * receive buffer they contain grow on the heap one entry at a time during each connection.
+ * Recycling that storage means a new connection starts with it already allocated.
+ *
+ * At most `capacity` sets of storage are held. Header maps which grew beyond
+ * `HttpHeaders::maxRetainedFields` are released rather than retained.
+ */
+class HttpConnectionRecycler
+{
+public:
+	struct Stats {
+		uint32_t recycled;  ///< Storage retained from a closed connection
+		uint32_t reused;	///< Storage passed to a new connection
+		uint32_t discarded; ///< Storage released because recycler was full
+	};
+
+	/**
+	 * @brief Set maximum number of storage sets to retain
+	 * @param capacity 0 to disable recycling
+	 * @note Any storage currently held is released
+	 */
+	void setCapacity(uint8_t capacity);
+
+	uint8_t getCapacity() const
+	{
+		return capacity;
+	}
+
+	/**
+	 * @brief Get number of storage sets currently held
+	 */
+	uint8_t count() const
+	{
+		return used;
+	}
+
+	/**
+	 * @brief Retain storage from a connection which is closing
+	 */
+	void put(HttpServerConnection& connection);
+
+	/**
+	 * @brief Give previously retained storage, if any, to a new connection
+	 */
+	void take(HttpServerConnection& connection);
+
+	const Stats& getStats() const
+	{
+		return stats;
+	}
+
+private:
+	struct Storage {
+		HttpHeaders requestHeaders;
+		HttpHeaders responseHeaders;
+		HttpHeaderBuilder incomingHeaders;
+	};
+
+	void exchange(Storage& storage, HttpServerConnection& connection);
+
+	std::unique_ptr<Storage[]> slots;
+	uint8_t capacity{0};
+	uint8_t used{0};
+	Stats stats{};
+};
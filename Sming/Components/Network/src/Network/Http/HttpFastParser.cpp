@@ -0,0 +1,227 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/SmingHub/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * HttpFastParser.cpp
+ *
+ ****/
+
+#include "HttpFastParser.h"
+#include <stringutil.h>
+
+namespace
+{
+// Content-Length values with more digits are left to http_parser
+constexpr size_t maxLengthDigits{9};
+
+bool isTokenChar(char c)
+{
+	// RFC 7230 tchar
+	if((c >= '0' && c <= '9') || (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z')) {
+		return true;
+	}
+	switch(c) {
+	case '!':
+	case '#':
+	case '$':
+	case '%':
+	case '&':
+	case '\'':
+	case '*':
+	case '+':
+	case '-':
+	case '.':
+	case '^':
+	case '_':
+	case '`':
+	case '|':
+	case '~':
+		return true;
+	default:
+		return false;
+	}
+}
+
+bool isTargetChar(char c)
+{
+	return c > ' ' && c < 0x7f;
+}
+
+bool isValueChar(char c)
+{
+	// Visible characters, space, tab and obs-text
+	auto u = uint8_t(c);
+	return (u >= ' ' && u != 0x7f) || u == '\t';
+}
+
+bool parseLength(const char* value, size_t length, size_t& result)
+{
+	if(length == 0 || length > maxLengthDigits) {
+		return false;
+	}
+	size_t n{0};
+	for(unsigned i = 0; i < length; ++i) {
+		if(value[i] < '0' || value[i] > '9') {
+			return false;
+		}
+		n = n * 10 + (value[i] - '0');
+	}
+	result = n;
+	return true;
+}
+
+const char* findNewline(const char* ptr, const char* end)
+{
+	// Align to word boundary
+	for(; ptr < end && (uintptr_t(ptr) & 3) != 0; ++ptr) {
+		if(*ptr == '\n') {
+			return ptr;
+		}
+	}
+
+	// Check four bytes at once: a zero byte in (word ^ pattern) indicates a match
+	constexpr uint32_t pattern{0x0a0a0a0aU};
+	for(; ptr + 4 <= end; ptr += 4) {
+		uint32_t word;
+		memcpy(&word, ptr, sizeof(word));
+		word ^= pattern;
+		if(((word - 0x01010101U) & ~word & 0x80808080U) != 0) {
+			break;
+		}
+	}
+
+	for(; ptr < end; ++ptr) {
+		if(*ptr == '\n') {
+			return ptr;
+		}
+	}
+
+	return nullptr;
+}
+
+} // namespace
+
+const char* HttpFastParser::findLineEnd(const char* ptr, const char* end)
+{
+	auto lf = findNewline(ptr, end);
+	if(lf == nullptr || lf == ptr || lf[-1] != '\r') {
+		return nullptr;
+	}
+	return lf - 1;
+}
+
+bool HttpFastParser::parse(const char* data, size_t size, Request& request, HttpHeaderBuilder& headers)
+{
+	auto end = data + size;
+	auto ptr = data;
+
+	// Request line
+	HttpMethod method;
+	if(size > 4 && memcmp(ptr, "GET ", 4) == 0) {
+		method = HTTP_GET;
+		ptr += 4;
+	} else if(size > 5 && memcmp(ptr, "POST ", 5) == 0) {
+		method = HTTP_POST;
+		ptr += 5;
+	} else {
+		return false;
+	}
+
+	auto lineEnd = findLineEnd(ptr, end);
+	if(lineEnd == nullptr || *ptr != '/') {
+		return false;
+	}
+	auto path = ptr;
+	while(ptr < lineEnd && *ptr != ' ') {
+		if(!isTargetChar(*ptr)) {
+			return false;
+		}
+		++ptr;
+	}
+	auto pathLength = ptr - path;
+
+	static constexpr char version[]{" HTTP/1.1"};
+	constexpr size_t versionLength{sizeof(version) - 1};
+	if(size_t(lineEnd - ptr) != versionLength || memcmp(ptr, version, versionLength) != 0) {
+		return false;
+	}
+	ptr = lineEnd + 2;
+
+	// Header fields
+	bool haveLength{false};
+	size_t contentLength{0};
+	for(;;) {
+		lineEnd = findLineEnd(ptr, end);
+		if(lineEnd == nullptr) {
+			return false;
+		}
+		if(lineEnd == ptr) {
+			ptr += 2;
+			break;
+		}
+
+		// Leading whitespace indicates obsolete line folding
+		auto name = ptr;
+		while(ptr < lineEnd && isTokenChar(*ptr)) {
+			++ptr;
+		}
+		if(ptr == name || ptr == lineEnd || *ptr != ':') {
+			return false;
+		}
+		size_t nameLength = ptr - name;
+		++ptr;
+
+		// Trim optional whitespace around value
+		while(ptr < lineEnd && (*ptr == ' ' || *ptr == '\t')) {
+			++ptr;
+		}
+		auto value = ptr;
+		auto valueEnd = lineEnd;
+		while(valueEnd > value && (valueEnd[-1] == ' ' || valueEnd[-1] == '\t')) {
+			--valueEnd;
+		}
+		for(ptr = value; ptr < valueEnd; ++ptr) {
+			if(!isValueChar(*ptr)) {
+				return false;
+			}
+		}
+		size_t valueLength = valueEnd - value;
+
+		switch(HttpHeaderFields::fromStandardName(name, nameLength)) {
+		case HTTP_HEADER_CONTENT_LENGTH:
+			if(haveLength || !parseLength(value, valueLength, contentLength)) {
+				return false;
+			}
+			haveLength = true;
+			break;
+		case HTTP_HEADER_TRANSFER_ENCODING:
+		case HTTP_HEADER_UPGRADE:
+			return false;
+		case HTTP_HEADER_CONNECTION:
+			if(valueLength != 10 || memicmp(value, "keep-alive", 10) != 0) {
+				return false;
+			}
+			break;
+		default:;
+		}
+
+		if(!headers.add(name, nameLength, value, valueLength)) {
+			return false;
+		}
+		ptr = lineEnd + 2;
+	}
+
+	size_t headLength = ptr - data;
+	if(contentLength > size - headLength) {
+		return false;
+	}
+
+	request.method = method;
+	request.path = path;
+	request.pathLength = pathLength;
+	request.headLength = headLength;
+	request.contentLength = contentLength;
+	return true;
+}
@@ -0,0 +1,63 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/SmingHub/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * HttpFastParser.h
+ *
+ ****/
+
+#pragma once
+
+#include "HttpCommon.h"
+#include "HttpHeaderBuilder.h"
+
+/**
+ * @brief Single-pass parser for simple HTTP requests
+ * @ingroup http
+ *
+ * Handles the common case of a complete GET or POST request, including any body, contained in one buffer.
+ * Line ends are located a word at a time, header names are matched against the standard field table
+ * and each header is added to the builder in one step rather than fragment by fragment.
+ *
+ * Anything unusual is rejected without side-effects so it can be passed to http_parser instead,
+ * including:
+ *
+ * - Incomplete request head or body
+ * - Other methods, or HTTP versions other than 1.1
+ * - Absolute URLs
+ * - Obsolete line folding, bare LF line endings or invalid characters
+ * - Transfer-Encoding, Upgrade, or any Connection value other than `keep-alive`
+ * - Invalid or repeated Content-Length
+ */
+class HttpFastParser
+{
+public:
+	struct Request {
+		HttpMethod method;
+		const char* path;	 ///< Request target, within the parsed data
+		size_t pathLength;	///< Length of request target
+		size_t headLength;	///< Length of request line and headers, including terminating blank line
+		size_t contentLength; ///< Length of body, which follows the head
+	};
+
+	/**
+	 * @brief Parse a request
+	 * @param data Received data
+	 * @param size Number of bytes available
+	 * @param request On success, details of the request
+	 * @param headers Builder to receive headers. Must be empty.
+	 * @retval bool true on success, false if request must be handled by http_parser
+	 * @note On failure, `headers` may contain partial data and should be reset
+	 */
+	static bool parse(const char* data, size_t size, Request& request, HttpHeaderBuilder& headers);
+
+	/**
+	 * @brief Locate the next CRLF line ending
+	 * @param ptr Start of search
+	 * @param end End of data
+	 * @retval const char* Position of CR, nullptr if not found or if a bare LF was encountered
+	 */
+	static const char* findLineEnd(const char* ptr, const char* end);
+};
@@ -0,0 +1,50 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/SmingHub/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * HttpHeaderBlock.h
+ *
+ ****/
+
+#pragma once
+
+#include "HttpHeaders.h"
+
+/**
+ * @brief A fixed set of header fields, pre-rendered for output
+ *
+ * Intended for fields which are identical in every message, such as `Server`, CORS or caching policy.
+ * The text is generated once when the fields are set so it can be copied directly into each message.
+ *
+ * @ingroup http
+ */
+class HttpHeaderBlock
+{
+public:
+	void set(const HttpHeaders& headers)
+	{
+		this->headers = headers;
+		if(text.setLength(headers.getOutputLength())) {
+			headers.write(text.begin());
+		}
+	}
+
+	const HttpHeaders& getHeaders() const
+	{
+		return headers;
+	}
+
+	/**
+	 * @brief Get the rendered fields, with line endings
+	 */
+	const String& getText() const
+	{
+		return text;
+	}
+
+private:
+	HttpHeaders headers;
+	String text;
+};
@@ -0,0 +1,53 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/SmingHub/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * HttpHeaderBuilder.cpp
+ *
+ ****/
+
+#include "HttpHeaderBuilder.h"
+
+bool HttpHeaderBuilder::next(Header& hdr) const
+{
+	auto end = buffer.c_str() + buffer.length();
+	auto ptr = (hdr.name == nullptr) ? buffer.c_str() : hdr.value + strlen(hdr.value) + 1;
+	if(headerCount == 0 || ptr >= end) {
+		return false;
+	}
+
+	hdr.name = ptr;
+	hdr.value = ptr + strlen(ptr) + 1;
+	if(hdr.value > end) {
+		// Field has no value yet
+		hdr.value = end;
+	}
+	return true;
+}
+
+const char* HttpHeaderBuilder::find(const char* name) const
+{
+	Header hdr{};
+	while(next(hdr)) {
+		if(strcasecmp(hdr.name, name) == 0) {
+			return hdr.value;
+		}
+	}
+	return nullptr;
+}
+
+void HttpHeaderBuilder::copyTo(HttpHeaders& headers) const
+{
+	Header hdr{};
+	while(next(hdr)) {
+		auto field = headers.findOrCreate(hdr.name);
+		auto length = strlen(hdr.value);
+		if(headers.getFlags(field)[HttpHeaderFields::Flag::Multi]) {
+			headers.append(field, hdr.value, length);
+		} else {
+			headers[field].setString(hdr.value, length);
+		}
+	}
+}
@@ -15,42 +15,160 @@
 /**
  * @brief Re-assembles headers from fragments via onHeaderField / onHeaderValue callbacks
  * @ingroup http
+ *
+ * All names and values are packed into a single buffer as NUL-terminated pairs,
+ * so parsing a message requires no per-header allocation. The buffer is retained
+ * between messages to avoid heap churn on persistent connections.
+ *
+ * Once headers are complete they may be inspected in-place, or copied into a
+ * HttpHeaders object using `copyTo()`.
+ *
+ * @note HttpRequest and HttpResponse expose headers as a String-valued HttpHeaders map,
+ * and the connections copy every received header into it. That copy still creates one
+ * String per header; values of up to `String::SSO_CAPACITY` characters are held within
+ * the String object and do not use the heap, but longer ones do.
  */
 class HttpHeaderBuilder
 {
 public:
+	/**
+	 * @brief Reference to a name/value pair within the buffer
+	 * @note Only valid until the builder is next modified
+	 */
+	struct Header {
+		const char* name;
+		const char* value;
+
+		String getName() const
+		{
+			return name;
+		}
+
+		String getValue() const
+		{
+			return value;
+		}
+	};
+
 	int onHeaderField(const char* at, size_t length)
 	{
-		if(lastWasValue) {
-			// we are starting to process new header - setLength keeps allocated memory
-			lastData.setLength(0);
-			lastWasValue = false;
+		if(state != State::field) {
+			if(state == State::value) {
+				buffer += '\0';
+			}
+			++headerCount;
+			state = State::field;
 		}
-		lastData.concat(at, length);
+		return buffer.concat(at, length) ? 0 : -1;
+	}
 
-		return 0;
+	int onHeaderValue(const char* at, size_t length)
+	{
+		if(state == State::field) {
+			buffer += '\0';
+			state = State::value;
+		}
+		return buffer.concat(at, length) ? 0 : -1;
 	}
 
-	int onHeaderValue(HttpHeaders& headers, const char* at, size_t length)
+	/**
+	 * @brief Add a complete header in one step
+	 * @param name
+	 * @param nameLength
+	 * @param value
+	 * @param valueLength
+	 * @retval bool false if out of memory
+	 * @note Must not be mixed with fragment callbacks for the same message
+	 */
+	bool add(const char* name, size_t nameLength, const char* value, size_t valueLength)
 	{
-		if(!lastWasValue) {
-			currentField = lastData;
-			headers[currentField] = nullptr;
-			lastWasValue = true;
+		auto offset = buffer.length();
+		if(!buffer.setLength(offset + nameLength + valueLength + 2)) {
+			return false;
 		}
-		headers[currentField].concat(at, length);
-		return 0;
+		auto ptr = buffer.begin() + offset;
+		memcpy(ptr, name, nameLength);
+		ptr += nameLength;
+		*ptr++ = '\0';
+		memcpy(ptr, value, valueLength);
+		ptr[valueLength] = '\0';
+		++headerCount;
+		state = State::idle;
+		return true;
 	}
 
+	/**
+	 * @brief Get number of headers received
+	 */
+	unsigned count() const
+	{
+		return headerCount;
+	}
+
+	/**
+	 * @brief Get a header by index
+	 * @note As the buffer is scanned this is O(n), use `next()` to iterate
+	 */
+	Header operator[](unsigned index) const
+	{
+		Header hdr{};
+		while(next(hdr)) {
+			if(index-- == 0) {
+				return hdr;
+			}
+		}
+		return Header{};
+	}
+
+	/**
+	 * @brief Step through headers
+	 * @param hdr Pass zero-initialised Header to get the first one
+	 * @retval bool false if there are no more headers
+	 */
+	bool next(Header& hdr) const;
+
+	/**
+	 * @brief Find a header value by name
+	 * @param name Case-insensitive
+	 * @retval const char* The value, or nullptr if not found
+	 */
+	const char* find(const char* name) const;
+
+	/**
+	 * @brief Add all received headers to a header map
+	 * @note Each value longer than `String::SSO_CAPACITY` requires a heap allocation
+	 */
+	void copyTo(HttpHeaders& headers) const;
+
+	/**
+	 * @brief Discard content ready for next message
+	 * @note Allocated buffer memory is retained
+	 */
 	void reset()
 	{
-		lastWasValue = true;
-		lastData = nullptr;
-		currentField = nullptr;
+		buffer.setLength(0);
+		headerCount = 0;
+		state = State::idle;
+	}
+
+	/**
+	 * @brief Exchange content and buffer with another builder
+	 */
+	void swap(HttpHeaderBuilder& other)
+	{
+		std::swap(buffer, other.buffer);
+		std::swap(headerCount, other.headerCount);
+		std::swap(state, other.state);
 	}
 
 private:
-	bool lastWasValue = true; ///< Indicates whether last callback was Field or Value
-	String lastData;		  ///< Content of field or value, may be constructed over several callbacks
-	String currentField;	  ///< Header field name
+	enum class State {
+		idle,
+		field,
+		value,
+	};
+
+	String buffer;
+	uint16_t headerCount{0};
+	State state{State::idle};
 };
@@ -11,6 +11,7 @@
  ****/
 
 #include "HttpHeaderFields.h"
+#include <Data/StringIndex.h>
 #include <FlashString/Vector.hpp>
 
 // Define field name strings and a lookup table
@@ -22,6 +23,14 @@ HTTP_HEADER_FIELDNAME_MAP(XX)
 DEFINE_FSTR_VECTOR_LOCAL(fieldNameStrings, FlashString, HTTP_HEADER_FIELDNAME_MAP(XX));
 #undef XX
 
+namespace
+{
+#define XX(tag, str, flags, comment) str,
+constexpr const char* fieldNameList[]{HTTP_HEADER_FIELDNAME_MAP(XX)};
+#undef XX
+constexpr StringIndex<ARRAY_SIZE(fieldNameList)> fieldNameIndex PROGMEM{fieldNameList};
+} // namespace
+
 HttpHeaderFields::Flags HttpHeaderFields::getFlags(HttpHeaderFieldName name) const
 {
 	switch(name) {
@@ -49,6 +58,40 @@ String HttpHeaderFields::toString(HttpHeaderFieldName name) const
 	return customFieldNames[unsigned(name) - unsigned(HTTP_HEADER_CUSTOM)];
 }
 
+size_t HttpHeaderFields::getNameLength(HttpHeaderFieldName name) const
+{
+	if(name == HTTP_HEADER_UNKNOWN) {
+		return 0;
+	}
+
+	if(name < HTTP_HEADER_CUSTOM) {
+		return fieldNameStrings[unsigned(name) - 1].length();
+	}
+
+	auto s = customFieldNames[unsigned(name) - unsigned(HTTP_HEADER_CUSTOM)];
+	return s ? strlen(s) : 0;
+}
+
+char* HttpHeaderFields::writeName(HttpHeaderFieldName name, char* buffer) const
+{
+	if(name == HTTP_HEADER_UNKNOWN) {
+		return buffer;
+	}
+
+	if(name < HTTP_HEADER_CUSTOM) {
+		auto& str = fieldNameStrings[unsigned(name) - 1];
+		return buffer + str.read(0, buffer, str.length());
+	}
+
+	auto s = customFieldNames[unsigned(name) - unsigned(HTTP_HEADER_CUSTOM)];
+	if(s == nullptr) {
+		return buffer;
+	}
+	auto len = strlen(s);
+	memcpy(buffer, s, len);
+	return buffer + len;
+}
+
 String HttpHeaderFields::toString(HttpHeaderFieldName name, const String& value) const
 {
 	String tag = toString(name);
@@ -80,9 +123,9 @@ String HttpHeaderFields::toString(const String& name, const String& value)
 	return s;
 }
 
-HttpHeaderFieldName HttpHeaderFields::fromString(const String& name) const
+HttpHeaderFieldName HttpHeaderFields::fromString(const char* name) const
 {
-	auto index = fieldNameStrings.indexOf(name);
+	auto index = fieldNameIndex.indexOf(fieldNameStrings, name);
 	if(index >= 0) {
 		return static_cast<HttpHeaderFieldName>(index + 1);
 	}
@@ -90,7 +133,13 @@ HttpHeaderFieldName HttpHeaderFields::fromString(const String& name) const
 	return findCustomFieldName(name);
 }
 
-HttpHeaderFieldName HttpHeaderFields::findCustomFieldName(const String& name) const
+HttpHeaderFieldName HttpHeaderFields::fromStandardName(const char* name, size_t length)
+{
+	auto index = fieldNameIndex.indexOf(fieldNameStrings, name, length);
+	return (index >= 0) ? static_cast<HttpHeaderFieldName>(index + 1) : HTTP_HEADER_UNKNOWN;
+}
+
+HttpHeaderFieldName HttpHeaderFields::findCustomFieldName(const char* name) const
 {
 	auto index = customFieldNames.indexOf(name);
 	if(index >= 0) {
@@ -35,6 +35,7 @@
 #define HTTP_HEADER_FIELDNAME_MAP(XX)                                                                                  \
 	XX(ACCEPT, "Accept", 0, "Limit acceptable response types")                                                         \
 	XX(ACCEPT_ENCODING, "Accept-Encoding", 0, "Limit acceptable content encoding types")                               \
+	XX(ACCEPT_RANGES, "Accept-Ranges", 0, "Range units supported by the server, e.g. bytes")                           \
 	XX(ACCESS_CONTROL_ALLOW_ORIGIN, "Access-Control-Allow-Origin", 0, "")                                              \
 	XX(AUTHORIZATION, "Authorization", 0, "Basic user agent authentication")                                           \
 	XX(CC, "Cc", 0, "email field")                                                                                     \
@@ -42,6 +43,7 @@
 	XX(CONTENT_DISPOSITION, "Content-Disposition", 0, "Additional information about how to process response payload")  \
 	XX(CONTENT_ENCODING, "Content-Encoding", 0, "Applied encodings in addition to content type")                       \
 	XX(CONTENT_LENGTH, "Content-Length", 0, "Anticipated size for payload when not using transfer encoding")           \
+	XX(CONTENT_RANGE, "Content-Range", 0, "Position of a partial response within the complete content")                \
 	XX(CONTENT_TYPE, "Content-Type", 0,                                                                                \
 	   "Payload media type indicating both data format and intended manner of processing by recipient")                \
 	XX(CONTENT_TRANSFER_ENCODING, "Content-Transfer-Encoding", 0, "Coding method used in a MIME message body part")    \
@@ -59,14 +61,20 @@
 	   "Precondition check using ETag to avoid accidental overwrites when servicing multiple user requests. Ensures "  \
 	   "resource entity tag matches before proceeding.")                                                               \
 	XX(IF_MODIFIED_SINCE, "If-Modified-Since", 0, "Precondition check using Date")                                     \
+	XX(IF_NONE_MATCH, "If-None-Match", 0, "Conditional request using ETag, to avoid resending cached content")         \
+	XX(IF_RANGE, "If-Range", 0, "Only apply Range if content matches the given ETag or date")                          \
 	XX(LAST_MODIFIED, "Last-Modified", 0, "Server timestamp indicating date and time resource was last modified")      \
 	XX(LOCATION, "Location", 0, "Used in redirect responses, amongst other places")                                    \
+	XX(RANGE, "Range", 0, "Request only part of the content")                                                          \
+	XX(RETRY_AFTER, "Retry-After", 0, "How long to wait before making a follow-up request")                            \
 	XX(SEC_WEBSOCKET_ACCEPT, "Sec-WebSocket-Accept", 0, "Server response to opening Websocket handshake")              \
 	XX(SEC_WEBSOCKET_VERSION, "Sec-WebSocket-Version", 0,                                                              \
 	   "Websocket opening request indicates acceptable protocol version. Can appear more than once.")                  \
 	XX(SEC_WEBSOCKET_KEY, "Sec-WebSocket-Key", 0, "Websocket opening request validation key")                          \
 	XX(SEC_WEBSOCKET_PROTOCOL, "Sec-WebSocket-Protocol", 0,                                                            \
 	   "Websocket opening request indicates supported protocol(s), response contains negotiated protocol(s)")          \
+	XX(SEC_WEBSOCKET_EXTENSIONS, "Sec-WebSocket-Extensions", 0,                                                        \
+	   "Websocket extension offers (request) and accepted extension parameters (response)")                            \
 	XX(SERVER, "Server", 0, "Identifies software handling requests")                                                   \
 	XX(SET_COOKIE, "Set-Cookie", Flag::Multi,                                                                          \
 	   "Server may pass name/value pairs and associated metadata to user agent (client)")                              \
@@ -76,6 +84,7 @@
 	XX(UPGRADE, "Upgrade", 0,                                                                                          \
 	   "Used to transition from HTTP to some other protocol on the same connection. e.g. Websocket")                   \
 	XX(USER_AGENT, "User-Agent", 0, "Information about the user agent originating the request")                        \
+	XX(VARY, "Vary", 0, "Request headers used to select the response, so caches can store variants separately")        \
 	XX(WWW_AUTHENTICATE, "WWW-Authenticate", Flag::Multi,                                                              \
 	   "Indicates HTTP authentication scheme(s) and applicable parameters")                                            \
 	XX(PROXY_AUTHENTICATE, "Proxy-Authenticate", Flag::Multi,                                                          \
@@ -114,6 +123,21 @@ public:
 
 	String toString(HttpHeaderFieldName name) const;
 
+	/**
+	 * @brief Get length of field name text
+	 * @param name
+	 * @retval size_t 0 if name is not valid
+	 */
+	size_t getNameLength(HttpHeaderFieldName name) const;
+
+	/**
+	 * @brief Copy field name text into a buffer, without NUL terminator
+	 * @param name
+	 * @param buffer Must have at least `getNameLength()` characters available
+	 * @retval char* Points to end of copied text
+	 */
+	char* writeName(HttpHeaderFieldName name, char* buffer) const;
+
 	/** @brief Produce a string for output in the HTTP header, with line ending
 	 *  @param name
 	 *  @param value
@@ -128,14 +152,27 @@ public:
 	 *  @retval HttpHeaderFieldName field name code, HTTP_HEADER_UNKNOWN if not recognised
 	 *  @note comparison is not case-sensitive
 	 */
-	HttpHeaderFieldName fromString(const String& name) const;
+	HttpHeaderFieldName fromString(const char* name) const;
+
+	HttpHeaderFieldName fromString(const String& name) const
+	{
+		return fromString(name.c_str());
+	}
+
+	/** @brief Find the enumerated value for a standard field name
+	 *  @param name Need not be NUL-terminated
+	 *  @param length
+	 *  @retval HttpHeaderFieldName HTTP_HEADER_UNKNOWN if not a standard field
+	 *  @note comparison is not case-sensitive; custom field names are not searched
+	 */
+	static HttpHeaderFieldName fromStandardName(const char* name, size_t length);
 
 	/** @brief Find the enumerated value for the given field name string, create a custom entry if not found
 	 *  @param name
 	 *  @retval HttpHeaderFieldName field name code
 	 *  @note comparison is not case-sensitive
 	 */
-	HttpHeaderFieldName findOrCreate(const String& name)
+	HttpHeaderFieldName findOrCreate(const char* name)
 	{
 		auto field = fromString(name);
 		if(field == HTTP_HEADER_UNKNOWN) {
@@ -145,17 +182,27 @@ public:
 		return field;
 	}
 
+	HttpHeaderFieldName findOrCreate(const String& name)
+	{
+		return findOrCreate(name.c_str());
+	}
+
 	void clear()
 	{
 		customFieldNames.clear();
 	}
 
+	void swap(HttpHeaderFields& other)
+	{
+		std::swap(customFieldNames, other.customFieldNames);
+	}
+
 private:
 	/** @brief Try to match a string against the list of custom field names
 	 *  @param name
 	 *  @retval HttpHeaderFieldName HTTP_HEADER_UNKNOWN if not found
 	 */
-	HttpHeaderFieldName findCustomFieldName(const String& name) const;
+	HttpHeaderFieldName findCustomFieldName(const char* name) const;
 
 	CStringArray customFieldNames;
 };
@@ -20,11 +20,11 @@ const String& HttpHeaders::operator[](const String& name) const
 	return operator[](field);
 }
 
-bool HttpHeaders::append(const HttpHeaderFieldName& name, const String& value)
+bool HttpHeaders::append(const HttpHeaderFieldName& name, const char* value, size_t length)
 {
 	int i = indexOf(name);
 	if(i < 0) {
-		operator[](name) = value;
+		operator[](name).setString(value, length);
 		return true;
 	}
 
@@ -33,7 +33,9 @@ bool HttpHeaders::append(const HttpHeaderFieldName& name, const String& value)
 		return false;
 	}
 
-	valueAt(i) += '\0' + value;
+	auto& s = valueAt(i);
+	s += '\0';
+	s.concat(value, length);
 
 	return true;
 }
@@ -46,3 +48,76 @@ void HttpHeaders::setMultiple(const HttpHeaders& headers)
 		operator[](fieldNameString) = headers.valueAt(i);
 	}
 }
+
+void HttpHeaders::setDefaults(const HttpHeaders& headers)
+{
+	for(unsigned i = 0; i < headers.count(); i++) {
+		auto fieldNameString = headers.toString(headers.keyAt(i));
+		if(!contains(fieldNameString)) {
+			operator[](fieldNameString) = headers.valueAt(i);
+		}
+	}
+}
+
+bool HttpHeaders::containsAny(const HttpHeaders& headers) const
+{
+	for(unsigned i = 0; i < headers.count(); i++) {
+		auto name = headers.keyAt(i);
+		// Custom field tags are specific to each set of headers so must be compared by name
+		if(name < HTTP_HEADER_CUSTOM ? contains(name) : contains(headers.toString(name))) {
+			return true;
+		}
+	}
+	return false;
+}
+
+size_t HttpHeaders::getOutputLength() const
+{
+	size_t length{0};
+	for(unsigned i = 0; i < count(); i++) {
+		auto name = keyAt(i);
+		auto& value = valueAt(i);
+		// Each line is "name: value\r\n"
+		size_t lineLength = getNameLength(name) + 4;
+		if(getFlags(name)[Flag::Multi]) {
+			// One line per NUL-separated value
+			for(auto p = value.c_str(), end = p + value.length(); p < end;) {
+				auto len = strlen(p);
+				length += lineLength + len;
+				p += len + 1;
+			}
+		} else {
+			length += lineLength + value.length();
+		}
+	}
+	return length;
+}
+
+char* HttpHeaders::write(char* buffer) const
+{
+	auto writeLine = [&](HttpHeaderFieldName name, const char* value, size_t length) {
+		buffer = writeName(name, buffer);
+		*buffer++ = ':';
+		*buffer++ = ' ';
+		memcpy(buffer, value, length);
+		buffer += length;
+		*buffer++ = '\r';
+		*buffer++ = '\n';
+	};
+
+	for(unsigned i = 0; i < count(); i++) {
+		auto name = keyAt(i);
+		auto& value = valueAt(i);
+		if(getFlags(name)[Flag::Multi]) {
+			for(auto p = value.c_str(), end = p + value.length(); p < end;) {
+				auto len = strlen(p);
+				writeLine(name, p, len);
+				p += len + 1;
+			}
+		} else {
+			writeLine(name, value.c_str(), value.length());
+		}
+	}
+
+	return buffer;
+}
@@ -70,8 +70,27 @@ public:
 		return toString(keyAt(index), valueAt(index));
 	}
 
+	/**
+	 * @brief Get number of characters required to output all fields
+	 * @retval size_t Includes line endings, but not the blank line which ends the header
+	 */
+	size_t getOutputLength() const;
+
+	/**
+	 * @brief Write all fields into a buffer for output
+	 * @param buffer Must have at least `getOutputLength()` characters available
+	 * @retval char* Points to end of written text. No NUL terminator is written.
+	 * @note Avoids the intermediate String created for each field by `operator[](unsigned)`
+	 */
+	char* write(char* buffer) const;
+
 	using HashMap::contains;
 
+	/**
+	 * @brief Determine if any of the given fields are present
+	 */
+	bool containsAny(const HttpHeaders& headers) const;
+
 	/**
 	 * @brief Determine if given header field is present
 	 */
@@ -88,7 +107,19 @@ public:
 	 * @param value
 	 * @retval bool false if value exists and field does not permit multiple values
 	 */
-	bool append(const HttpHeaderFieldName& name, const String& value);
+	bool append(const HttpHeaderFieldName& name, const String& value)
+	{
+		return append(name, value.c_str(), value.length());
+	}
+
+	/**
+	 * @brief Append value to multi-value field
+	 * @param name
+	 * @param value
+	 * @param length Length of value
+	 * @retval bool false if value exists and field does not permit multiple values
+	 */
+	bool append(const HttpHeaderFieldName& name, const char* value, size_t length);
 
 	void remove(const String& name)
 	{
@@ -97,6 +128,11 @@ public:
 
 	void setMultiple(const HttpHeaders& headers);
 
+	/**
+	 * @brief Add any of the given fields which are not already present
+	 */
+	void setDefaults(const HttpHeaders& headers);
+
 	HttpHeaders& operator=(const HttpHeaders& headers)
 	{
 		clear();
@@ -110,6 +146,27 @@ public:
 		HashMap::clear();
 	}
 
+	/**
+	 * @brief Remove all fields, keeping storage for re-use
+	 * @note If storage exists for more than `maxRetainedFields` it is released
+	 */
+	void reset()
+	{
+		HttpHeaderFields::clear();
+		HashMap::reset(maxRetainedFields);
+	}
+
+	/**
+	 * @brief Exchange fields and storage with another set of headers
+	 */
+	void swap(HttpHeaders& other)
+	{
+		HttpHeaderFields::swap(other);
+		HashMap::swap(other);
+	}
+
+	static constexpr unsigned maxRetainedFields{16};
+
 	using HashMap::count;
 
 	DateTime getLastModifiedDate() const
@@ -0,0 +1,471 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/SmingHub/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * HttpMetricsResource.cpp
+ *
+ ****/
+
+#include "HttpMetricsResource.h"
+#include "HttpResponse.h"
+#include <Network/TcpServer.h>
+#include <Network/MqttClient.h>
+#include <Network/Ssl/Session.h>
+#include <Network/LwipStats.h>
+#include <Services/Profiling/CpuUsage.h>
+#include <Services/Profiling/InterruptTiming.h>
+#include <Platform/System.h>
+#ifndef DISABLE_WIFI
+#include <Platform/Station.h>
+#endif
+
+using Metric = HttpMetricsResource::Metric;
+using Type = HttpMetricsResource::Type;
+
+namespace
+{
+bool getHeapFree(void*, int64_t& value)
+{
+	value = system_get_free_heap_size();
+	return true;
+}
+
+bool getTaskQueueMax(void*, int64_t& value)
+{
+#ifdef ENABLE_TASK_COUNT
+	value = System.getMaxTaskCount();
+	return true;
+#else
+	return false;
+#endif
+}
+
+bool getTaskQueueOverflows(void*, int64_t& value)
+{
+	value = 0;
+	for(auto priority : {TaskPriority::Low, TaskPriority::Normal, TaskPriority::High}) {
+		value += System.getTaskQueueStats(priority).overflows;
+	}
+	return true;
+}
+
+bool getSslFull(void*, int64_t& value)
+{
+	value = Ssl::getHandshakeStats().full;
+	return true;
+}
+
+bool getSslResumed(void*, int64_t& value)
+{
+	value = Ssl::getHandshakeStats().resumed;
+	return true;
+}
+
+bool getSslFailed(void*, int64_t& value)
+{
+	value = Ssl::getHandshakeStats().failed;
+	return true;
+}
+
+bool getWifiRssi(void*, int64_t& value)
+{
+#ifndef DISABLE_WIFI
+	if(WifiStation.isConnected()) {
+		value = WifiStation.getRssi();
+		return true;
+	}
+#endif
+	return false;
+}
+
+bool getInterruptsDisabledMax(void*, int64_t& value)
+{
+#if ENABLE_INTERRUPT_TIMING
+	// Microseconds
+	value = Profiling::InterruptTiming::getMaxMaskedCycles() / system_get_cpu_freq();
+	return true;
+#else
+	return false;
+#endif
+}
+
+bool getInterruptsDisabledTotal(void*, int64_t& value)
+{
+#if ENABLE_INTERRUPT_TIMING
+	value = Profiling::InterruptTiming::getTotalMaskedCycles() / system_get_cpu_freq();
+	return true;
+#else
+	return false;
+#endif
+}
+
+// tag, name, help, labels, type, decimals, getter
+#define SYSTEM_METRICS_MAP(XX)                                                                                         \
+	XX(heapFree, "sming_heap_free_bytes", "Free heap memory", "", gauge, 0, getHeapFree)                               \
+	XX(taskQueueMax, "sming_task_queue_max", "Most tasks seen on the normal priority queue", "", gauge, 0,            \
+	   getTaskQueueMax)                                                                                                \
+	XX(taskQueueOverflows, "sming_task_queue_overflows", "Tasks rejected because the queue was full", "", counter, 0, \
+	   getTaskQueueOverflows)                                                                                          \
+	XX(sslFull, "sming_ssl_handshakes", "SSL handshakes", "result=\"full\"", counter, 0, getSslFull)                   \
+	XX(sslResumed, "sming_ssl_handshakes", "SSL handshakes", "result=\"resumed\"", counter, 0, getSslResumed)          \
+	XX(sslFailed, "sming_ssl_handshakes", "SSL handshakes", "result=\"failed\"", counter, 0, getSslFailed)             \
+	XX(wifiRssi, "sming_wifi_rssi_dbm", "WiFi station signal strength", "", gauge, 0, getWifiRssi)                    \
+	XX(irqMaskedMax, "sming_interrupts_disabled_max_seconds", "Longest time with interrupts disabled", "", gauge, 6,   \
+	   getInterruptsDisabledMax)                                                                                       \
+	XX(irqMaskedTotal, "sming_interrupts_disabled_seconds", "Time with interrupts disabled", "", counter, 6,          \
+	   getInterruptsDisabledTotal)
+
+#define XX(tag, name, help, labels, type, decimals, getter)                                                            \
+	const char tag##Name[] PROGMEM = name;                                                                             \
+	const char tag##Help[] PROGMEM = help;                                                                             \
+	const char tag##Labels[] PROGMEM = labels;
+SYSTEM_METRICS_MAP(XX)
+#undef XX
+
+const Metric systemMetrics[] PROGMEM = {
+#define XX(tag, name, help, labels, type, decimals, getter)                                                            \
+	{tag##Name, tag##Help, tag##Labels, getter, nullptr, Type::type, decimals},
+	SYSTEM_METRICS_MAP(XX)
+#undef XX
+};
+
+constexpr unsigned systemMetricCount = ARRAY_SIZE(systemMetrics);
+
+// Object is the pool index
+template <uint32_t LwipStats::Pool::*field> bool getLwipPool(void* object, int64_t& value)
+{
+	LwipStats::Pool pool;
+	if(!LwipStats::getPool(uintptr_t(object), pool)) {
+		return false;
+	}
+	value = pool.*field;
+	return true;
+}
+
+} // namespace
+
+/*
+ * Renders as many metrics as will fit into the buffer at a time.
+ * All strings are accessed as if they might be in flash.
+ */
+class MetricsStream : public IDataSourceStream
+{
+public:
+	MetricsStream(HttpMetricsResource& resource) : resource(resource)
+	{
+	}
+
+	uint16_t readMemoryBlock(char* data, int bufSize) override;
+
+	bool seek(int len) override
+	{
+		if(len < 0 || readPos + len > length) {
+			return false;
+		}
+		readPos += len;
+		return true;
+	}
+
+	bool isFinished() override
+	{
+		return done && readPos >= length;
+	}
+
+private:
+	static constexpr size_t bufferSize{256};
+	static constexpr size_t maxNameLength{64};
+
+	bool getMetric(unsigned index, Metric& metric) const;
+	void fill();
+	bool render(const Metric& metric, int64_t value);
+	bool append(const char* str);
+	bool append(char c);
+	bool appendValue(int64_t value, uint8_t decimals);
+
+	HttpMetricsResource& resource;
+	char buffer[bufferSize];
+	char lastName[maxNameLength]{}; ///< Name of most recent metric family
+	uint16_t length{0};
+	uint16_t readPos{0};
+	uint16_t index{0};
+	bool done{false};
+};
+
+bool MetricsStream::getMetric(unsigned index, Metric& metric) const
+{
+	if(index < systemMetricCount) {
+		memcpy_P(&metric, &systemMetrics[index], sizeof(Metric));
+		return true;
+	}
+	index -= systemMetricCount;
+	if(index < resource.metrics.count()) {
+		metric = resource.metrics[index];
+		return true;
+	}
+	return false;
+}
+
+bool MetricsStream::append(const char* str)
+{
+	if(str == nullptr) {
+		return true;
+	}
+	auto len = strlen_P(str);
+	if(length + len > bufferSize) {
+		return false;
+	}
+	memcpy_P(&buffer[length], str, len);
+	length += len;
+	return true;
+}
+
+bool MetricsStream::append(char c)
+{
+	if(length >= bufferSize) {
+		return false;
+	}
+	buffer[length++] = c;
+	return true;
+}
+
+bool MetricsStream::appendValue(int64_t value, uint8_t decimals)
+{
+	char digits[24];
+	unsigned n{0};
+	bool negative = (value < 0);
+	uint64_t u = negative ? -uint64_t(value) : uint64_t(value);
+	do {
+		digits[n++] = '0' + (u % 10);
+		u /= 10;
+	} while(u != 0 || n <= decimals);
+
+	if(negative && !append('-')) {
+		return false;
+	}
+	while(n != 0) {
+		if(n == decimals && !append('.')) {
+			return false;
+		}
+		if(!append(digits[--n])) {
+			return false;
+		}
+	}
+	return true;
+}
+
+bool MetricsStream::render(const Metric& metric, int64_t value)
+{
+	bool isCounter = (metric.type == Type::counter);
+
+	if(strcmp_P(lastName, metric.name) != 0) {
+		bool ok = append("# HELP ") && append(metric.name) && append(' ') && append(metric.help) && append('\n') &&
+				  append("# TYPE ") && append(metric.name) && append(' ') &&
+				  append(isCounter ? "counter" : "gauge") && append('\n');
+		if(!ok) {
+			return false;
+		}
+	}
+
+	if(!append(metric.name) || (isCounter && !append("_total"))) {
+		return false;
+	}
+	if(metric.labels != nullptr && pgm_read_byte(metric.labels) != '\0') {
+		if(!append('{') || !append(metric.labels) || !append('}')) {
+			return false;
+		}
+	}
+
+	if(!append(' ') || !appendValue(value, metric.decimals) || !append('\n')) {
+		return false;
+	}
+
+	strncpy_P(lastName, metric.name, maxNameLength - 1);
+	return true;
+}
+
+void MetricsStream::fill()
+{
+	length = 0;
+	readPos = 0;
+
+	Metric metric;
+	while(getMetric(index, metric)) {
+		int64_t value;
+		if(metric.getter == nullptr || !metric.getter(metric.object, value)) {
+			// Value not available
+			++index;
+			continue;
+		}
+		auto start = length;
+		if(!render(metric, value)) {
+			length = start;
+			if(start != 0) {
+				// Try again with an empty buffer
+				return;
+			}
+			debug_w("[METRICS] #%u too long", index);
+		}
+		++index;
+	}
+
+	if(append("# EOF\n")) {
+		done = true;
+	}
+}
+
+uint16_t MetricsStream::readMemoryBlock(char* data, int bufSize)
+{
+	if(readPos >= length && !done) {
+		fill();
+	}
+
+	auto len = std::min(int(length - readPos), bufSize);
+	memcpy(data, &buffer[readPos], len);
+	return len;
+}
+
+HttpMetricsResource::HttpMetricsResource()
+{
+	onRequestComplete = HttpResourceDelegate(&HttpMetricsResource::requestComplete, this);
+}
+
+void HttpMetricsResource::add(const Metric* table, unsigned count)
+{
+	for(unsigned i = 0; i < count; ++i) {
+		Metric metric;
+		memcpy_P(&metric, &table[i], sizeof(Metric));
+		metrics.add(metric);
+	}
+}
+
+IDataSourceStream* HttpMetricsResource::createStream()
+{
+	return new MetricsStream(*this);
+}
+
+int HttpMetricsResource::requestComplete(HttpServerConnection&, HttpRequest&, HttpResponse& response)
+{
+	response.headers[HTTP_HEADER_CACHE_CONTROL] = F("no-cache");
+	response.sendDataStream(createStream(), F("application/openmetrics-text; version=1.0.0; charset=utf-8"));
+	return 0;
+}
+
+Metric HttpMetricsResource::activeClients(TcpServer& server, const char* labels)
+{
+	return Metric{
+		PSTR("sming_tcp_server_active_clients"),
+		PSTR("Number of connected clients"),
+		labels,
+		[](void* object, int64_t& value) -> bool {
+			value = static_cast<TcpServer*>(object)->activeClients;
+			return true;
+		},
+		&server,
+		Type::gauge,
+		0,
+	};
+}
+
+Metric HttpMetricsResource::cpuUtilisation(Profiling::CpuUsage& cpuUsage)
+{
+	return Metric{
+		PSTR("sming_cpu_utilisation_ratio"),
+		PSTR("CPU utilisation"),
+		nullptr,
+		[](void* object, int64_t& value) -> bool {
+			// Value is in 1/100ths of a percent
+			value = static_cast<Profiling::CpuUsage*>(object)->getUtilisation();
+			return true;
+		},
+		&cpuUsage,
+		Type::gauge,
+		4,
+	};
+}
+
+Metric HttpMetricsResource::mqttQueueLength(MqttClient& client, const char* labels)
+{
+	return Metric{
+		PSTR("sming_mqtt_queue_length"),
+		PSTR("MQTT requests waiting to be sent or acknowledged"),
+		labels,
+		[](void* object, int64_t& value) -> bool {
+			auto client = static_cast<MqttClient*>(object);
+			value = client->getQueueLength() + client->getInflightCount();
+			return true;
+		},
+		&client,
+		Type::gauge,
+		0,
+	};
+}
+
+Metric HttpMetricsResource::mqttQueuedBytes(MqttClient& client, const char* labels)
+{
+	return Metric{
+		PSTR("sming_mqtt_queued_bytes"),
+		PSTR("MQTT topic and payload bytes waiting to be sent or acknowledged"),
+		labels,
+		[](void* object, int64_t& value) -> bool {
+			value = static_cast<MqttClient*>(object)->getQueuedBytes();
+			return true;
+		},
+		&client,
+		Type::gauge,
+		0,
+	};
+}
+
+Metric HttpMetricsResource::interruptHandlerTime(unsigned gpio, const char* labels)
+{
+	return Metric{
+		PSTR("sming_interrupt_handler_seconds"),
+		PSTR("Time spent in interrupt handler"),
+		labels,
+		[](void* object, int64_t& value) -> bool {
+			// Value is in microseconds
+			Profiling::InterruptTiming::Handler handler;
+			if(!Profiling::InterruptTiming::getHandler(uintptr_t(object), handler)) {
+				return false;
+			}
+			value = handler.totalCycles / system_get_cpu_freq();
+			return true;
+		},
+		reinterpret_cast<void*>(uintptr_t(gpio)),
+		Type::counter,
+		6,
+	};
+}
+
+void HttpMetricsResource::addLwipPools()
+{
+	struct Family {
+		const char* name;
+		const char* help;
+		Getter getter;
+		Type type;
+	};
+	const Family families[]{
+		{PSTR("sming_lwip_pool_size"), PSTR("lwIP memory pool capacity, in bytes for the heap"),
+		 getLwipPool<&LwipStats::Pool::size>, Type::gauge},
+		{PSTR("sming_lwip_pool_used"), PSTR("lwIP memory pool elements in use"), getLwipPool<&LwipStats::Pool::used>,
+		 Type::gauge},
+		{PSTR("sming_lwip_pool_max"), PSTR("lwIP memory pool high-water mark"), getLwipPool<&LwipStats::Pool::max>,
+		 Type::gauge},
+		{PSTR("sming_lwip_pool_errors"), PSTR("lwIP memory pool allocation failures"),
+		 getLwipPool<&LwipStats::Pool::errors>, Type::counter},
+	};
+
+	auto poolCount = LwipStats::getPoolCount();
+	for(auto& family : families) {
+		for(unsigned i = 0; i < poolCount; ++i) {
+			LwipStats::Pool pool;
+			if(LwipStats::getPool(i, pool)) {
+				add(Metric{family.name, family.help, pool.labels, family.getter, reinterpret_cast<void*>(uintptr_t(i)),
+						   family.type, 0});
+			}
+		}
+	}
+}
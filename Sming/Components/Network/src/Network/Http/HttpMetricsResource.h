@@ -0,0 +1,155 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/SmingHub/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * HttpMetricsResource.h
+ *
+ ****/
+
+#pragma once
+
+#include "HttpResource.h"
+#include <WVector.h>
+
+class TcpServer;
+class MqttClient;
+
+namespace Profiling
+{
+class CpuUsage;
+}
+
+/**
+ * @brief Serves runtime metrics in OpenMetrics text format, for scraping by Prometheus
+ * @ingroup httpserver
+ *
+ * A set of built-in system metrics is always included: heap, task queue, SSL handshake
+ * counts and, where applicable, WiFi signal strength. Metrics for application objects,
+ * or any other value, may be added using a table of `Metric` entries.
+ *
+ * Output is generated directly from the tables into a small buffer as the response is sent,
+ * so no `String` objects are created for a scrape.
+ *
+ * For example:
+ *
+ * ```
+ * HttpServer server;
+ * HttpMetricsResource metrics;
+ *
+ * void init()
+ * {
+ *     ...
+ *     metrics.add(HttpMetricsResource::activeClients(server));
+ *     server.paths.set("/metrics", &metrics);
+ * }
+ * ```
+ */
+class HttpMetricsResource : public HttpResource
+{
+public:
+	enum class Type : uint8_t {
+		gauge,	 ///< Value which may go up or down
+		counter, ///< Value which only increases
+	};
+
+	/**
+	 * @brief Function to obtain the value of a metric
+	 * @param object As stored in the Metric entry
+	 * @param value On success, the value scaled by 10^decimals
+	 * @retval bool false if value isn't available, so the sample is omitted
+	 */
+	using Getter = bool (*)(void* object, int64_t& value);
+
+	/**
+	 * @brief Describes a single metric sample
+	 *
+	 * Entries with the same name form a metric family, and must be consecutive.
+	 * They should have different labels.
+	 *
+	 * Strings may be stored in flash, and must remain valid for the lifetime of the resource.
+	 */
+	struct Metric {
+		const char* name;	///< Family name, without the `_total` suffix for counters
+		const char* help;	///< Description
+		const char* labels; ///< Optional label set, such as `port="80"`
+		Getter getter;
+		void* object; ///< Passed to getter
+		Type type;
+		uint8_t decimals; ///< Number of decimal places represented by value
+	};
+
+	HttpMetricsResource();
+
+	/**
+	 * @brief Add a metric
+	 * @note Call during initialisation: adding metrics allocates memory, but serving them does not
+	 */
+	void add(const Metric& metric)
+	{
+		metrics.add(metric);
+	}
+
+	/**
+	 * @brief Add a table of metrics
+	 * @param table Entries are copied, so the table may be stored in flash
+	 * @param count Number of entries in table
+	 */
+	void add(const Metric* table, unsigned count);
+
+	/**
+	 * @brief Get the number of metrics added, built-in metrics excluded
+	 */
+	unsigned count() const
+	{
+		return metrics.count();
+	}
+
+	/**
+	 * @name Metrics for framework objects
+	 * @param labels Optional label set, required where there is more than one instance
+	 * @{
+	 */
+
+	/** @brief Number of connected clients */
+	static Metric activeClients(TcpServer& server, const char* labels = nullptr);
+
+	/** @brief CPU utilisation as a ratio, valid for the period set by the application */
+	static Metric cpuUtilisation(Profiling::CpuUsage& cpuUsage);
+
+	/** @brief Number of requests waiting to be sent or acknowledged */
+	static Metric mqttQueueLength(MqttClient& client, const char* labels = nullptr);
+
+	/** @brief Size of topic and payload for requests waiting to be sent or acknowledged */
+	static Metric mqttQueuedBytes(MqttClient& client, const char* labels = nullptr);
+
+	/**
+	 * @brief Total time spent in the interrupt handler for a GPIO
+	 * @param gpio Pin number
+	 * @param labels Label set identifying the handler, such as `gpio="4"`
+	 * @note Requires ENABLE_INTERRUPT_TIMING
+	 */
+	static Metric interruptHandlerTime(unsigned gpio, const char* labels);
+
+	/** @} */
+
+	/**
+	 * @brief Add size, usage, high-water mark and allocation failures for each lwIP memory pool
+	 * @note Adds nothing unless lwIP statistics are enabled, see `LwipStats`
+	 */
+	void addLwipPools();
+
+	/**
+	 * @brief Create a stream containing the current metrics
+	 * @note The resource must remain valid until the stream is destroyed
+	 */
+	IDataSourceStream* createStream();
+
+private:
+	friend class MetricsStream;
+
+	int requestComplete(HttpServerConnection& connection, HttpRequest& request, HttpResponse& response);
+
+	Vector<Metric> metrics;
+};
@@ -0,0 +1,145 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/SmingHub/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * HttpPathParameters.h
+ *
+ ****/
+
+#pragma once
+
+#include <WString.h>
+
+#ifndef HTTP_MAX_PATH_PARAMETERS
+#define HTTP_MAX_PATH_PARAMETERS 4
+#endif
+
+/**
+ * @brief Values captured from a request path by matching it against a resource pattern
+ * @ingroup http
+ *
+ * For example, matching `/api/device/12/state` against `/api/device/{id}/state` captures `id` = "12".
+ * A trailing `*` wildcard captures the remainder of the path using the name "*".
+ *
+ * Captures are stored as pointers into the matched pattern and request path, so no heap
+ * allocation is performed. Names may therefore refer to flash memory. They remain valid only until the request URL or the resource tree
+ * is modified.
+ */
+class HttpPathParameters
+{
+public:
+	struct Parameter {
+		const char* name; ///< May be in flash
+		const char* value;
+		uint16_t nameLength;
+		uint16_t valueLength;
+
+		bool nameEquals(const char* str, size_t length) const
+		{
+			return length == nameLength && memcmp_P(str, name, length) == 0;
+		}
+
+		String getName() const
+		{
+			return String(FPSTR(name), nameLength);
+		}
+
+		String getValue() const
+		{
+			return String(value, valueLength);
+		}
+	};
+
+	static constexpr unsigned maxCount{HTTP_MAX_PATH_PARAMETERS};
+
+	unsigned count() const
+	{
+		return paramCount;
+	}
+
+	void clear()
+	{
+		paramCount = 0;
+	}
+
+	const Parameter& operator[](unsigned index) const
+	{
+		return params[index];
+	}
+
+	/**
+	 * @brief Find a parameter by name
+	 * @retval const Parameter* nullptr if not found
+	 */
+	const Parameter* find(const char* name, size_t nameLength) const
+	{
+		for(unsigned i = 0; i < paramCount; ++i) {
+			if(params[i].nameEquals(name, nameLength)) {
+				return &params[i];
+			}
+		}
+		return nullptr;
+	}
+
+	const Parameter* find(const String& name) const
+	{
+		return find(name.c_str(), name.length());
+	}
+
+	/**
+	 * @brief Get a parameter value without copying it
+	 * @param name
+	 * @param length On return, length of the value
+	 * @retval const char* Start of value (not NUL-terminated), nullptr if not found
+	 */
+	const char* getValue(const String& name, size_t& length) const
+	{
+		auto param = find(name);
+		if(param == nullptr) {
+			length = 0;
+			return nullptr;
+		}
+		length = param->valueLength;
+		return param->value;
+	}
+
+	/**
+	 * @brief Get a copy of a parameter value
+	 * @retval String Invalid String if not found
+	 */
+	String getValue(const String& name) const
+	{
+		auto param = find(name);
+		return param ? param->getValue() : nullptr;
+	}
+
+	/**
+	 * @brief Add a capture
+	 * @retval bool false if there's no room
+	 * @note Used by HttpResourceTree during path matching
+	 */
+	bool add(const char* name, size_t nameLength, const char* value, size_t valueLength)
+	{
+		if(paramCount >= maxCount) {
+			return false;
+		}
+		params[paramCount++] = {name, value, uint16_t(nameLength), uint16_t(valueLength)};
+		return true;
+	}
+
+	/**
+	 * @brief Remove the most recently added capture
+	 */
+	void pop()
+	{
+		if(paramCount != 0) {
+			--paramCount;
+		}
+	}
+
+private:
+	Parameter params[maxCount];
+	uint8_t paramCount{0};
+};
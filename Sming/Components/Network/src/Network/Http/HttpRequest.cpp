@@ -64,7 +64,8 @@ void HttpRequest::reset()
 
 	postParams.clear();
 	files.clear();
-	headers.clear();
+	headers.reset();
+	pathParameters.clear();
 }
 
 String HttpRequest::toString() const
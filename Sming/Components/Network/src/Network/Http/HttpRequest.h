@@ -20,6 +20,7 @@
 #include "Data/Stream/DataSourceStream.h"
 #include "HttpHeaders.h"
 #include "HttpParams.h"
+#include "HttpPathParameters.h"
 #include "Data/ObjectMap.h"
 
 class HttpConnection;
@@ -28,6 +29,16 @@ using RequestHeadersCompletedDelegate = Delegate<int(HttpConnection& client, Htt
 using RequestBodyDelegate = Delegate<int(HttpConnection& client, const char* at, size_t length)>;
 using RequestCompletedDelegate = Delegate<int(HttpConnection& client, bool successful)>;
 
+/**
+ * @brief Scheduling class for outgoing requests
+ * @ingroup http
+ */
+enum class HttpRequestPriority : uint8_t {
+	Low,	///< Queued behind all other requests
+	Normal, ///< Default
+	High,   ///< Sent ahead of other requests, using a dedicated connection to the server
+};
+
 /**
  * @brief Encapsulates an incoming or outgoing request
  * @ingroup http
@@ -53,8 +64,9 @@ public:
 	 */
 	HttpRequest(const HttpRequest& value)
 		: uri(value.uri), method(value.method), headers(value.headers), postParams(value.postParams),
-		  headersCompletedDelegate(value.headersCompletedDelegate), requestBodyDelegate(value.requestBodyDelegate),
-		  requestCompletedDelegate(value.requestCompletedDelegate), sslInitDelegate(value.sslInitDelegate)
+		  priority(value.priority), headersCompletedDelegate(value.headersCompletedDelegate),
+		  requestBodyDelegate(value.requestBodyDelegate), requestCompletedDelegate(value.requestCompletedDelegate),
+		  sslInitDelegate(value.sslInitDelegate)
 	{
 	}
 
@@ -85,6 +97,35 @@ public:
 		return this;
 	}
 
+	/**
+	 * @brief Set priority for sending this request
+	 * @see HttpRequestPriority
+	 */
+	HttpRequest* setPriority(HttpRequestPriority priority)
+	{
+		this->priority = priority;
+		return this;
+	}
+
+	/**
+	 * @brief Determine if request may safely be sent again, e.g. after losing connection
+	 * @see RFC 7231 4.2.2
+	 */
+	bool isIdempotent() const
+	{
+		switch(method) {
+		case HTTP_GET:
+		case HTTP_HEAD:
+		case HTTP_PUT:
+		case HTTP_DELETE:
+		case HTTP_OPTIONS:
+		case HTTP_TRACE:
+			return true;
+		default:
+			return false;
+		}
+	}
+
 	HttpRequest* setHeaders(const HttpHeaders& headers)
 	{
 		this->headers.setMultiple(headers);
@@ -158,6 +199,17 @@ public:
 		return static_cast<const HttpParams&>(uri.Query)[name] ?: defaultValue;
 	}
 
+	/**
+	 * @brief Get parameter captured from the request path
+	 * @param name Name of parameter, as given in the resource path pattern (e.g. "id" for `/device/{id}`)
+	 * @param defaultValue Optional default value to use if requested parameter not present
+	 * @see HttpResourceTree
+	 */
+	String getPathParameter(const String& name, const String& defaultValue = nullptr) const
+	{
+		return pathParameters.getValue(name) ?: defaultValue;
+	}
+
 	/**
 	 * @brief Moves content from the body stream into a String.
 	 * @retval String
@@ -281,11 +333,14 @@ public:
 	}
 
 public:
-	Url uri;					  ///< Request URL
-	HttpMethod method = HTTP_GET; ///< Request method
-	HttpHeaders headers;		  ///< Request headers
-	HttpParams postParams;		  ///< POST parameters
-	HttpFiles files;			  ///< Attached files
+	Url uri;						   ///< Request URL
+	HttpMethod method = HTTP_GET;	  ///< Request method
+	HttpHeaders headers;			   ///< Request headers
+	HttpParams postParams;			   ///< POST parameters
+	HttpFiles files;				   ///< Attached files
+	HttpPathParameters pathParameters; ///< Parameters captured from path by HttpResourceTree
+
+	HttpRequestPriority priority = HttpRequestPriority::Normal; ///< Scheduling priority for client requests
 
 	int retries = 0; ///< how many times the request should be send again...
 
@@ -306,6 +361,7 @@ protected:
 
 private:
 	HttpParams* queryParams = nullptr; // << @todo deprecate
+	uint8_t replayCount = 0;		   ///< Number of times request has been re-sent after losing connection
 };
 
 inline String toString(const HttpRequest& req)
@@ -1,5 +1,6 @@
 #include "HttpResource.h"
 #include "HttpServerConnection.h"
+#include "HttpResponseCache.h"
 
 namespace
 {
@@ -61,6 +62,23 @@ int HttpResource::handleBody(HttpServerConnection& connection, HttpRequest& requ
 }
 
 int HttpResource::handleRequest(HttpServerConnection& connection, HttpRequest& request, HttpResponse& response)
+{
+	if(responseCache == nullptr || shouldSkip(request)) {
+		return invokeRequest(connection, request, response);
+	}
+
+	if(responseCache->load(request, response)) {
+		return 0;
+	}
+
+	int err = invokeRequest(connection, request, response);
+	if(err == 0 && !shouldSkip(request)) {
+		responseCache->store(request, response);
+	}
+	return err;
+}
+
+int HttpResource::invokeRequest(HttpServerConnection& connection, HttpRequest& request, HttpResponse& response)
 {
 	FUNCTION_TEMPLATE(onRequestComplete, requestComplete, response)
 }
@@ -18,6 +18,7 @@
 #include "Resource/HttpResourcePlugin.h"
 
 class HttpServerConnection;
+class HttpResponseCache;
 
 using HttpServerConnectionBodyDelegate =
 	Delegate<int(HttpServerConnection& connection, HttpRequest&, const char* at, int length)>;
@@ -77,14 +78,25 @@ public:
 		addPlugin(plugins...);
 	}
 
+	/**
+	 * @brief Answer repeated requests from a short-lived cache of responses
+	 * @param cache Not owned, nullptr to disable
+	 */
+	void setResponseCache(HttpResponseCache* cache)
+	{
+		responseCache = cache;
+	}
+
 private:
 	friend class HttpServerConnection;
 
 	PluginRef::OwnedList plugins;
+	HttpResponseCache* responseCache{nullptr};
 
 	int handleUrl(HttpServerConnection& connection, HttpRequest& request, HttpResponse& response);
 	int handleHeaders(HttpServerConnection& connection, HttpRequest& request, HttpResponse& response);
 	int handleUpgrade(HttpServerConnection& connection, HttpRequest& request, char* data, size_t length);
 	int handleBody(HttpServerConnection& connection, HttpRequest& request, char*& data, size_t& length);
 	int handleRequest(HttpServerConnection& connection, HttpRequest& request, HttpResponse& response);
+	int invokeRequest(HttpServerConnection& connection, HttpRequest& request, HttpResponse& response);
 };
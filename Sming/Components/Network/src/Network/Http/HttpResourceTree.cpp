@@ -33,6 +33,44 @@ private:
 
 /* HttpResourceTree */
 
+HttpResourceTree::~HttpResourceTree()
+{
+	delete[] nodes;
+	for(auto& route : flashRoutes) {
+		delete route.resource;
+	}
+}
+
+void HttpResourceTree::set(const FlashString& path, HttpResource* resource)
+{
+	routesValid = false;
+	for(auto& route : flashRoutes) {
+		if(*route.path == path) {
+			delete route.resource;
+			route.resource = resource;
+			return;
+		}
+	}
+	if(!flashRoutes.add(FlashRoute{&path, resource})) {
+		delete resource;
+	}
+}
+
+HttpResource* HttpResourceTree::set(const FlashString& path, const HttpResourceDelegate& onRequestComplete)
+{
+	auto resource = new HttpResource;
+	resource->onRequestComplete = onRequestComplete;
+	set(path, resource);
+	return resource;
+}
+
+HttpResource* HttpResourceTree::set(const FlashString& path, const HttpPathDelegate& callback)
+{
+	auto resource = new HttpCompatResource(callback);
+	set(path, resource);
+	return resource;
+}
+
 HttpResource* HttpResourceTree::set(const String& path, const HttpResourceDelegate& onRequestComplete)
 {
 	auto resource = new HttpResource;
@@ -53,3 +91,275 @@ HttpResource* HttpResourceTree::set(String path, const HttpPathDelegate& callbac
 	set(path, res);
 	return res;
 }
+
+namespace
+{
+/*
+ * Return start of the path segment following `pos`, or nullptr if there are no more
+ */
+const char* nextSegment(const char* segmentEnd, const char* end)
+{
+	return (segmentEnd < end) ? segmentEnd + 1 : nullptr;
+}
+
+const char* findSegmentEnd(const char* pos, const char* end)
+{
+	while(pos < end && *pos != '/') {
+		++pos;
+	}
+	return pos;
+}
+
+/*
+ * Route paths may be in flash, so are read using pgm_read_byte()
+ */
+const char* findSegmentEnd_P(const char* pos, const char* end)
+{
+	while(pos < end && pgm_read_byte(pos) != '/') {
+		++pos;
+	}
+	return pos;
+}
+
+unsigned countSegments_P(const char* pos, size_t length)
+{
+	unsigned count{0};
+	for(size_t i = 0; i < length; ++i) {
+		if(pgm_read_byte(&pos[i]) == '/') {
+			++count;
+		}
+	}
+	return count;
+}
+
+bool textEquals_P(const char* s1, const char* s2, size_t length)
+{
+	for(size_t i = 0; i < length; ++i) {
+		if(pgm_read_byte(&s1[i]) != pgm_read_byte(&s2[i])) {
+			return false;
+		}
+	}
+	return true;
+}
+
+} // namespace
+
+void HttpResourceTree::setCacheControl(const String& pattern, const String& cacheControl)
+{
+	for(unsigned i = 0; i < cacheRules.count(); ++i) {
+		if(cacheRules[i].pattern == pattern) {
+			if(cacheControl) {
+				cacheRules[i].cacheControl = cacheControl;
+			} else {
+				cacheRules.removeElementAt(i);
+			}
+			return;
+		}
+	}
+
+	if(cacheControl) {
+		cacheRules.add(CacheRule{pattern, cacheControl});
+	}
+}
+
+String HttpResourceTree::getCacheControl(const String& path) const
+{
+	for(unsigned i = 0; i < cacheRules.count(); ++i) {
+		auto& rule = cacheRules[i];
+		auto& pattern = rule.pattern;
+		unsigned len = pattern.length() - 1;
+		bool match;
+		if(pattern.endsWith("*")) {
+			match = path.length() >= len && memcmp(path.c_str(), pattern.c_str(), len) == 0;
+		} else if(pattern.startsWith("*")) {
+			match = path.length() >= len && memcmp(path.c_str() + path.length() - len, pattern.c_str() + 1, len) == 0;
+		} else {
+			match = (path == pattern);
+		}
+		if(match) {
+			return rule.cacheControl;
+		}
+	}
+
+	return nullptr;
+}
+
+HttpResource* HttpResourceTree::match(const String& path, HttpPathParameters* params)
+{
+	if(params != nullptr) {
+		params->clear();
+	}
+
+	if(!routesValid || routeEntryCount != count() + flashRoutes.count()) {
+		if(!buildRoutes()) {
+			return find(path);
+		}
+	}
+
+	auto start = path.c_str();
+	auto end = start + path.length();
+	if(start == end || *start != '/') {
+		return nullptr;
+	}
+
+	auto pos = start + 1;
+	if(pos == end) {
+		pos = nullptr;
+	}
+
+	int entry = matchNode(nodes[0], pos, end, params);
+	return (entry < 0) ? nullptr : routeResource(entry);
+}
+
+bool HttpResourceTree::buildRoutes()
+{
+	delete[] nodes;
+	nodes = nullptr;
+	nodeCount = 0;
+	routesValid = false;
+
+	// Each '/' in a path introduces at most one node
+	unsigned routeCount = count() + flashRoutes.count();
+	unsigned maxNodes = 1;
+	for(unsigned i = 0; i < routeCount; ++i) {
+		maxNodes += countSegments_P(routePath(i), routeLength(i));
+	}
+	if(maxNodes > INT16_MAX) {
+		debug_e("[HTTP] Too many paths for routing");
+		return false;
+	}
+
+	nodes = new Node[maxNodes];
+	if(nodes == nullptr) {
+		return false;
+	}
+	nodes[0] = Node{0, 0, 0, Node::Type::Literal, -1, -1, -1};
+	nodeCount = 1;
+
+	for(unsigned i = 0; i < routeCount; ++i) {
+		addRoute(i, routePath(i), routeLength(i));
+	}
+
+	routeEntryCount = routeCount;
+	routesValid = true;
+	return true;
+}
+
+void HttpResourceTree::addRoute(uint16_t index, const char* path, size_t length)
+{
+	auto end = path + length;
+	if(path == end || pgm_read_byte(path) != '/') {
+		return;
+	}
+
+	int16_t parent = 0;
+	auto pos = path + 1;
+	if(pos == end) {
+		pos = nullptr;
+	}
+	while(pos != nullptr) {
+		auto segEnd = findSegmentEnd_P(pos, end);
+		auto next = nextSegment(segEnd, end);
+		Node node{index, uint16_t(pos - path), uint16_t(segEnd - pos), Node::Type::Literal, -1, -1, -1};
+		if(node.length >= 2 && pgm_read_byte(pos) == '{' && pgm_read_byte(segEnd - 1) == '}') {
+			node.type = Node::Type::Parameter;
+			++node.offset;
+			node.length -= 2;
+		} else if(node.length == 1 && pgm_read_byte(pos) == '*' && next == nullptr) {
+			node.type = Node::Type::Wildcard;
+		}
+		parent = addChild(parent, node);
+		pos = next;
+	}
+
+	if(nodes[parent].entry < 0) {
+		nodes[parent].entry = index;
+	}
+}
+
+int16_t HttpResourceTree::addChild(int16_t parent, const Node& node)
+{
+	// Children are ordered by type so literals are tried first, then parameters, then wildcards
+	int16_t prev = -1;
+	for(auto i = nodes[parent].firstChild; i >= 0; i = nodes[i].nextSibling) {
+		auto& child = nodes[i];
+		if(child.type == node.type && child.length == node.length &&
+		   textEquals_P(nodeText(child), nodeText(node), node.length)) {
+			return i;
+		}
+		if(child.type <= node.type) {
+			prev = i;
+		}
+	}
+
+	int16_t index = nodeCount++;
+	nodes[index] = node;
+	auto& link = (prev < 0) ? nodes[parent].firstChild : nodes[prev].nextSibling;
+	nodes[index].nextSibling = link;
+	link = index;
+	return index;
+}
+
+int HttpResourceTree::matchNode(const Node& node, const char* pos, const char* end, HttpPathParameters* params) const
+{
+	if(pos == nullptr) {
+		if(node.entry >= 0) {
+			return node.entry;
+		}
+		// A wildcard also matches an empty remainder
+		for(auto i = node.firstChild; i >= 0; i = nodes[i].nextSibling) {
+			auto& child = nodes[i];
+			if(child.type == Node::Type::Wildcard && child.entry >= 0) {
+				if(params != nullptr) {
+					params->add(nodeText(child), child.length, end, 0);
+				}
+				return child.entry;
+			}
+		}
+		return -1;
+	}
+
+	auto segEnd = findSegmentEnd(pos, end);
+	auto next = nextSegment(segEnd, end);
+	size_t segLength = segEnd - pos;
+
+	for(auto i = node.firstChild; i >= 0; i = nodes[i].nextSibling) {
+		auto& child = nodes[i];
+		switch(child.type) {
+		case Node::Type::Literal:
+			if(child.length == segLength && memcmp_P(pos, nodeText(child), segLength) == 0) {
+				int entry = matchNode(child, next, end, params);
+				if(entry >= 0) {
+					return entry;
+				}
+			}
+			break;
+
+		case Node::Type::Parameter: {
+			if(segLength == 0) {
+				break;
+			}
+			bool added = (params != nullptr) && params->add(nodeText(child), child.length, pos, segLength);
+			int entry = matchNode(child, next, end, params);
+			if(entry >= 0) {
+				return entry;
+			}
+			if(added) {
+				params->pop();
+			}
+			break;
+		}
+
+		case Node::Type::Wildcard:
+			if(child.entry >= 0) {
+				if(params != nullptr) {
+					params->add(nodeText(child), child.length, pos, end - pos);
+				}
+				return child.entry;
+			}
+			break;
+		}
+	}
+
+	return -1;
+}
@@ -13,6 +13,8 @@
 #pragma once
 
 #include "HttpResource.h"
+#include "HttpPathParameters.h"
+#include <WVector.h>
 
 using HttpPathDelegate = Delegate<void(HttpRequest& request, HttpResponse& response)>;
 
@@ -22,10 +24,31 @@ using HttpPathDelegate = Delegate<void(HttpRequest& request, HttpResponse& respo
 /**
  * @brief Class to map URL paths to classes which handle them
  * @ingroup httpserver
+ *
+ * Paths may contain parameters and a trailing wildcard, for example:
+ *
+ * - `/api/device/{id}/state` matches `/api/device/12/state`, capturing `id` = "12"
+ * - `/static/*` matches `/static` and anything below it, capturing the remainder as "*"
+ *
+ * Literal segments take priority over parameters, which take priority over wildcards.
+ *
+ * For large route tables, paths may be defined in flash:
+ *
+ * 		DEFINE_FSTR_LOCAL(pathDeviceState, "/api/device/{id}/state")
+ *
+ * 		server.paths.set(pathDeviceState, onDeviceState);
+ *
+ * The routing trie refers to these directly, so they do not occupy RAM.
  */
 class HttpResourceTree : public ObjectMap<String, HttpResource>
 {
 public:
+	HttpResourceTree()
+	{
+	}
+
+	~HttpResourceTree();
+
 	/** @brief Set the default resource handler
 	 *  @param resource The default resource handler
 	 */
@@ -57,7 +80,69 @@ public:
 		return find(RESOURCE_PATH_DEFAULT);
 	}
 
-	using ObjectMap::set;
+	/**
+	 * @brief Find the resource which best matches a request path
+	 * @param path Request path, starting with '/'
+	 * @param params If provided, receives any captured path parameters
+	 * @retval HttpResource* nullptr if there is no match (default resource is not returned)
+	 * @note Matching is performed in a single pass over the path using a routing trie
+	 * which is built on first use after the tree has been modified.
+	 */
+	HttpResource* match(const String& path, HttpPathParameters* params = nullptr);
+
+	/**
+	 * @brief Set a resource to handle the given path
+	 * @param path URL path or pattern
+	 * @param resource Resource object, owned by the tree
+	 * @note Any existing handler for this path is replaced
+	 */
+	void set(const String& path, HttpResource* resource)
+	{
+		routesValid = false;
+		ObjectMap::set(path, resource);
+	}
+
+	/**
+	 * @brief Set a resource to handle a path stored in flash
+	 * @param path URL path or pattern, which must remain valid for the lifetime of the tree
+	 * @param resource Resource object, owned by the tree
+	 * @note The path is not copied into RAM. Paths set using a String take priority.
+	 * @note Any existing handler for this path is replaced
+	 */
+	void set(const FlashString& path, HttpResource* resource);
+
+	/**
+	 * @brief Set a callback to handle a path stored in flash
+	 * @param path URL path or pattern, which must remain valid for the lifetime of the tree
+	 * @param onRequestComplete Delegate to handle this path
+	 * @retval HttpResource* The created resource object
+	 */
+	HttpResource* set(const FlashString& path, const HttpResourceDelegate& onRequestComplete);
+
+	/**
+	 * @brief Set a callback to handle a path stored in flash
+	 * @param path URL path or pattern, which must remain valid for the lifetime of the tree
+	 * @param callback The callback that will handle this path
+	 * @retval HttpResource* The created resource object
+	 */
+	HttpResource* set(const FlashString& path, const HttpPathDelegate& callback);
+
+	Value operator[](const String& path)
+	{
+		routesValid = false;
+		return ObjectMap::operator[](path);
+	}
+
+	const HttpResource* operator[](const String& path) const
+	{
+		return find(path);
+	}
+
+	Value get(const String& path)
+	{
+		routesValid = false;
+		return ObjectMap::get(path);
+	}
 
 	template <class... Tail>
 	HttpResource* set(const String& path, HttpResource* resource, HttpResourcePlugin* plugin, Tail... plugins)
@@ -124,7 +209,34 @@ public:
 		return res;
 	}
 
+	/**
+	 * @brief Set the Cache-Control header for responses to matching paths
+	 * @param pattern Path to match. A trailing '*' matches any path with that prefix,
+	 * and a leading '*' matches any path with that suffix, e.g. "*.js".
+	 * @param cacheControl Header value, e.g. "public, max-age=86400". Empty to remove the rule.
+	 * @note Rules are checked in the order they were added.
+	 * Responses which already have a Cache-Control header are not changed.
+	 */
+	void setCacheControl(const String& pattern, const String& cacheControl);
+
+	/**
+	 * @brief Get the Cache-Control value for a request path
+	 * @param path Request path, starting with '/'
+	 * @retval String Empty if no rule matches
+	 */
+	String getCacheControl(const String& path) const;
+
 private:
+	struct CacheRule {
+		String pattern;
+		String cacheControl;
+	};
+
+	struct FlashRoute {
+		const FlashString* path;
+		HttpResource* resource;
+	};
+
 	void registerPlugin(HttpResourcePlugin* plugin)
 	{
 		loadedPlugins.add(plugin);
@@ -136,5 +248,56 @@ private:
 		registerPlugin(plugins...);
 	}
 
+	/*
+	 * Node in the routing trie. Segment text is referenced by position within the path
+	 * which created the node. Indices from count() onwards refer to flashRoutes.
+	 * Text may therefore be in flash so must be accessed using pgmspace functions.
+	 */
+	struct Node {
+		enum class Type : uint8_t {
+			Literal,
+			Parameter,
+			Wildcard,
+		};
+		uint16_t keyIndex;
+		uint16_t offset;
+		uint16_t length;
+		Type type;
+		int16_t firstChild;
+		int16_t nextSibling;
+		int16_t entry; ///< Index of matching map entry, -1 if none
+	};
+
+	bool buildRoutes();
+	void addRoute(uint16_t index, const char* path, size_t length);
+	int16_t addChild(int16_t parent, const Node& node);
+	int matchNode(const Node& node, const char* pos, const char* end, HttpPathParameters* params) const;
+
+	const char* routePath(unsigned index) const
+	{
+		return (index < count()) ? keyAt(index).c_str() : flashRoutes[index - count()].path->data();
+	}
+
+	size_t routeLength(unsigned index) const
+	{
+		return (index < count()) ? keyAt(index).length() : flashRoutes[index - count()].path->length();
+	}
+
+	HttpResource* routeResource(unsigned index) const
+	{
+		return (index < count()) ? entries[index].value : flashRoutes[index - count()].resource;
+	}
+
+	const char* nodeText(const Node& node) const
+	{
+		return routePath(node.keyIndex) + node.offset;
+	}
+
 	HttpResourcePlugin::OwnedList loadedPlugins;
+	Vector<CacheRule> cacheRules;
+	Vector<FlashRoute> flashRoutes;
+	Node* nodes{nullptr};
+	uint16_t nodeCount{0};
+	uint16_t routeEntryCount{0};
+	bool routesValid{false};
 };
@@ -14,8 +14,165 @@
 #include <Data/WebConstants.h>
 #include "Data/Stream/MemoryDataStream.h"
 #include "Data/Stream/FileStream.h"
+#include "Data/Stream/ByteRangeStream.h"
+#include "HttpRequest.h"
+#include <FlashString/Stream.hpp>
+#include <DateTime.h>
 #include <esp_systemapi.h>
 
+/**
+ * @brief Number of flash content hashes retained for generating entity tags
+ */
+#ifndef HTTP_ETAG_CACHE_SIZE
+#define HTTP_ETAG_CACHE_SIZE 16
+#endif
+
+namespace
+{
+/*
+ * Pre-compressed variants, in order of preference
+ */
+struct ContentVariant {
+	const char* encoding;
+	const char* extension;
+};
+
+const ContentVariant contentVariants[]{
+	{"br", ".br"},
+	{"gzip", ".gz"},
+};
+
+/*
+ * Check an Accept-Encoding header value, e.g. "gzip, deflate;q=0.5, br"
+ */
+bool acceptsEncoding(const String& acceptEncoding, const char* encoding)
+{
+	unsigned pos = 0;
+	while(pos < acceptEncoding.length()) {
+		int end = acceptEncoding.indexOf(',', pos);
+		if(end < 0) {
+			end = acceptEncoding.length();
+		}
+		String coding = acceptEncoding.substring(pos, end);
+		pos = end + 1;
+
+		String params;
+		int sep = coding.indexOf(';');
+		if(sep >= 0) {
+			params = coding.substring(sep + 1);
+			coding.setLength(sep);
+		}
+		coding.trim();
+		if(coding != "*" && !coding.equalsIgnoreCase(encoding)) {
+			continue;
+		}
+
+		params.trim();
+		return !params.startsWith("q=") || atof(params.c_str() + 2) != 0;
+	}
+
+	return false;
+}
+
+/*
+ * Find the preferred variant of a file acceptable to the client
+ * `exists` returns true if the given name is available
+ * Returns the name of the variant, or an empty String if none exists
+ */
+template <typename Exists>
+String selectVariant(HttpHeaders& headers, const HttpRequest& request, const String& fileName, Exists exists)
+{
+	headers[HTTP_HEADER_VARY] = F("Accept-Encoding");
+
+	const String& acceptEncoding = request.headers[HTTP_HEADER_ACCEPT_ENCODING];
+	for(auto& variant : contentVariants) {
+		if(!acceptsEncoding(acceptEncoding, variant.encoding)) {
+			continue;
+		}
+		String name = fileName + variant.extension;
+		if(exists(name)) {
+			headers[HTTP_HEADER_CONTENT_ENCODING] = variant.encoding;
+			return name;
+		}
+	}
+
+	if(exists(fileName)) {
+		return fileName;
+	}
+
+	// Only a compressed variant is available
+	String name = fileName + _F(".gz");
+	if(exists(name)) {
+		headers[HTTP_HEADER_CONTENT_ENCODING] = F("gzip");
+		return name;
+	}
+
+	return nullptr;
+}
+
+/*
+ * Compare an If-None-Match header value against an entity tag, ignoring weakness
+ */
+bool etagMatches(const String& ifNoneMatch, const String& etag)
+{
+	if(ifNoneMatch == "*") {
+		return true;
+	}
+
+	unsigned pos = 0;
+	while(pos < ifNoneMatch.length()) {
+		int end = ifNoneMatch.indexOf(',', pos);
+		if(end < 0) {
+			end = ifNoneMatch.length();
+		}
+		String tag = ifNoneMatch.substring(pos, end);
+		pos = end + 1;
+		tag.trim();
+		if(tag.startsWith("W/")) {
+			tag.remove(0, 2);
+		}
+		if(tag == etag) {
+			return true;
+		}
+	}
+
+	return false;
+}
+
+/*
+ * FNV-1a hash of flash content, cached as it is not expected to change
+ */
+uint32_t getContentHash(const FSTR::String& content)
+{
+	struct Entry {
+		const void* content;
+		uint32_t hash;
+	};
+	static Entry cache[HTTP_ETAG_CACHE_SIZE];
+	static unsigned nextEntry;
+
+	for(auto& e : cache) {
+		if(e.content == &content) {
+			return e.hash;
+		}
+	}
+
+	uint32_t hash{2166136261U};
+	uint8_t buf[64];
+	for(size_t offset = 0; offset < content.length(); offset += sizeof(buf)) {
+		auto len = content.read(offset, reinterpret_cast<char*>(buf), sizeof(buf));
+		for(unsigned i = 0; i < len; ++i) {
+			hash = (hash ^ buf[i]) * 16777619U;
+		}
+	}
+
+	cache[nextEntry] = Entry{&content, hash};
+	nextEntry = (nextEntry + 1) % HTTP_ETAG_CACHE_SIZE;
+	return hash;
+}
+
+} // namespace
+
 HttpResponse* HttpResponse::setCookie(const String& name, const String& value, bool append)
 {
 	String s = name;
@@ -92,6 +249,184 @@ bool HttpResponse::sendFile(const String& fileName, bool allowGzipFileCheck)
 	return false;
 }
 
+bool HttpResponse::checkNotModified(const HttpRequest& request, const String& etag, time_t lastModified)
+{
+	if(etag) {
+		headers[HTTP_HEADER_ETAG] = etag;
+	}
+	if(lastModified != 0) {
+		headers[HTTP_HEADER_LAST_MODIFIED] = DateTime(lastModified).toHTTPDate();
+	}
+
+	if(request.method != HTTP_GET && request.method != HTTP_HEAD) {
+		return false;
+	}
+
+	// If-None-Match takes precedence
+	bool notModified;
+	if(request.headers.contains(HTTP_HEADER_IF_NONE_MATCH)) {
+		notModified = etag && etagMatches(request.headers[HTTP_HEADER_IF_NONE_MATCH], etag);
+	} else if(lastModified != 0 && request.headers.contains(HTTP_HEADER_IF_MODIFIED_SINCE)) {
+		DateTime since;
+		notModified = since.fromHttpDate(request.headers[HTTP_HEADER_IF_MODIFIED_SINCE]) && lastModified <= time_t(since);
+	} else {
+		notModified = false;
+	}
+
+	if(notModified) {
+		code = HTTP_STATUS_NOT_MODIFIED;
+		headers.remove(HTTP_HEADER_CONTENT_ENCODING);
+		headers.remove(HTTP_HEADER_TRANSFER_ENCODING);
+		freeStreams();
+	}
+	return notModified;
+}
+
+bool HttpResponse::applyRange(const HttpRequest& request)
+{
+	if(code != HTTP_STATUS_OK || request.method != HTTP_GET || stream == nullptr || buffer != nullptr) {
+		return false;
+	}
+
+	// Content length must be known and stream able to seek
+	int size = stream->available();
+	if(size < 0 || stream->seekFrom(0, SeekOrigin::Current) != 0) {
+		return false;
+	}
+
+	headers[HTTP_HEADER_ACCEPT_RANGES] = F("bytes");
+
+	if(!request.headers.contains(HTTP_HEADER_RANGE)) {
+		return false;
+	}
+
+	// Client copy must be current, otherwise send complete content
+	if(request.headers.contains(HTTP_HEADER_IF_RANGE)) {
+		const String& validator = request.headers[HTTP_HEADER_IF_RANGE];
+		auto matches = [&](HttpHeaderFieldName name) { return headers.contains(name) && validator == headers[name]; };
+		if(!matches(HTTP_HEADER_ETAG) && !matches(HTTP_HEADER_LAST_MODIFIED)) {
+			return false;
+		}
+	}
+
+	auto rangeStream = new ByteRangeStream(size, headers[HTTP_HEADER_CONTENT_TYPE]);
+	int count = rangeStream->parse(request.headers[HTTP_HEADER_RANGE]);
+	if(count < 0) {
+		debug_d("Ignoring range '%s'", request.headers[HTTP_HEADER_RANGE].c_str());
+		delete rangeStream;
+		return false;
+	}
+
+	if(count == 0) {
+		delete rangeStream;
+		code = HTTP_STATUS_RANGE_NOT_SATISFIABLE;
+		String s = F("bytes */");
+		s += size;
+		headers[HTTP_HEADER_CONTENT_RANGE] = s;
+		headers.remove(HTTP_HEADER_CONTENT_ENCODING);
+		headers.remove(HTTP_HEADER_TRANSFER_ENCODING);
+		freeStreams();
+		return true;
+	}
+
+	code = HTTP_STATUS_PARTIAL_CONTENT;
+	if(count == 1) {
+		headers[HTTP_HEADER_CONTENT_RANGE] = rangeStream->getContentRange(0);
+	} else {
+		String s = F("multipart/byteranges; boundary=");
+		s += rangeStream->getBoundary();
+		headers[HTTP_HEADER_CONTENT_TYPE] = s;
+	}
+	rangeStream->setSource(stream);
+	stream = rangeStream;
+	return true;
+}
+
+bool HttpResponse::sendFile(const HttpRequest& request, const String& fileName)
+{
+	FileStat stat;
+	String name = selectVariant(headers, request, fileName,
+								[&stat](const String& name) { return fileStats(name, stat) >= 0; });
+	if(!name) {
+		code = HTTP_STATUS_NOT_FOUND;
+		return false;
+	}
+
+	char etag[32];
+	m_snprintf(etag, sizeof(etag), _F("\"%x-%x-%x\""), uint32_t(stat.id), uint32_t(stat.size),
+			   uint32_t(stat.mtime));
+	if(checkNotModified(request, etag, stat.mtime)) {
+		debug_d("%s not modified", name.c_str());
+		return true;
+	}
+
+	if(!headers.contains(HTTP_HEADER_CONTENT_ENCODING)) {
+		// File may have been compressed when building the filesystem image
+		if(stat.compression.type == IFS::Compression::Type::GZip) {
+			headers[HTTP_HEADER_CONTENT_ENCODING] = F("gzip");
+		} else if(stat.compression.type != IFS::Compression::Type::None) {
+			debug_e("Unsupported compression type: %s", ::toString(stat.compression.type).c_str());
+		}
+	}
+
+	auto fs = new FileStream;
+	if(!fs->open(name)) {
+		delete fs;
+		code = HTTP_STATUS_NOT_FOUND;
+		return false;
+	}
+	debug_d("found %s", name.c_str());
+	return sendDataStream(fs, ContentType::fromFullFileName(fileName));
+}
+
+bool HttpResponse::sendFile(const HttpRequest& request, const FSTR::Map<FSTR::String, FSTR::String>& fileMap,
+							const String& fileName)
+{
+	const FSTR::String* content{nullptr};
+	String name = selectVariant(headers, request, fileName, [&](const String& name) {
+		auto pair = fileMap[name];
+		if(!pair) {
+			return false;
+		}
+		content = &pair.content();
+		return true;
+	});
+
+	return sendFlashContent(request, content, fileName);
+}
+
+bool HttpResponse::sendFile(const HttpRequest& request, const FileMapIndex& fileIndex, const String& fileName)
+{
+	const FSTR::String* content{nullptr};
+	String name = selectVariant(headers, request, fileName, [&](const String& name) {
+		int i = fileIndex.indexOf(name);
+		if(i < 0) {
+			return false;
+		}
+		content = &fileIndex.getMap().valueAt(i).content();
+		return true;
+	});
+
+	return sendFlashContent(request, content, fileName);
+}
+
+bool HttpResponse::sendFlashContent(const HttpRequest& request, const FSTR::String* content, const String& fileName)
+{
+	if(content == nullptr) {
+		code = HTTP_STATUS_NOT_FOUND;
+		return false;
+	}
+
+	// Content is in flash so only changes with the firmware
+	char etag[16];
+	m_snprintf(etag, sizeof(etag), _F("\"%08x\""), getContentHash(*content));
+	if(checkNotModified(request, etag)) {
+		return true;
+	}
+
+	return sendDataStream(new FSTR::Stream(*content), ContentType::fromFullFileName(fileName));
+}
+
 bool HttpResponse::sendNamedStream(IDataSourceStream* newDataStream)
 {
 	String contentType;
@@ -125,7 +460,7 @@ bool HttpResponse::sendDataStream(IDataSourceStream* newDataStream, const String
 void HttpResponse::reset()
 {
 	code = HTTP_STATUS_OK;
-	headers.clear();
+	headers.reset();
 	freeStreams();
 }
 
@@ -16,6 +16,10 @@
 #include "Data/Stream/ReadWriteStream.h"
 #include "HttpHeaders.h"
 #include "FileSystem.h"
+#include <FlashString/Map.hpp>
+#include <Data/FlashMapIndex.h>
+
+class HttpRequest;
 
 /**
  * @brief Represents either an incoming or outgoing response to a HTTP request
@@ -70,6 +74,73 @@ public:
 	 */
 	bool sendFile(const String& fileName, bool allowGzipFileCheck = true);
 
+	/**
+	 * @brief Send file by name, using a pre-compressed variant if the client accepts it
+	 * @param request Provides the `Accept-Encoding` header
+	 * @param fileName Name of uncompressed file
+	 * @retval bool
+	 *
+	 * Files with ".br" then ".gz" appended are tried first, if the client accepts that encoding.
+	 * If the uncompressed file doesn't exist, the ".gz" variant is sent regardless.
+	 *
+	 * The `Vary` header is set so caches keep the variants separate.
+	 *
+	 * An entity tag is generated from the file size, identifier and modification time.
+	 * If the client already has a current copy, `304 Not Modified` is sent without opening the file.
+	 */
+	bool sendFile(const HttpRequest& request, const String& fileName);
+
+	/**
+	 * @brief Send file from a FlashString map, using a pre-compressed variant if the client accepts it
+	 * @param request Provides the `Accept-Encoding` header
+	 * @param fileMap Map of file names to content
+	 * @param fileName Name of uncompressed file
+	 * @retval bool
+	 *
+	 * Variants are selected as for `sendFile(const HttpRequest&, const String&)`.
+	 * The entity tag is a hash of the content, calculated on first use.
+	 */
+	bool sendFile(const HttpRequest& request, const FSTR::Map<FSTR::String, FSTR::String>& fileMap,
+				  const String& fileName);
+
+	using FileMapIndex = FlashMapIndex<FSTR::Map<FSTR::String, FSTR::String>>;
+
+	/**
+	 * @brief Send file from an indexed FlashString map
+	 * @param request
+	 * @param fileIndex Index for the map, created once by the application
+	 * @param fileName Name of uncompressed file
+	 * @retval bool
+	 *
+	 * Behaves as `sendFile(const HttpRequest&, const FSTR::Map&, const String&)`, but the time taken
+	 * to locate a file does not grow with the number of files in the map.
+	 */
+	bool sendFile(const HttpRequest& request, const FileMapIndex& fileIndex, const String& fileName);
+
+	/**
+	 * @brief Set validators and check whether the client already has a current copy of the content
+	 * @param request Provides the `If-None-Match` and `If-Modified-Since` headers
+	 * @param etag Quoted entity tag, may be empty
+	 * @param lastModified Time content was last changed, 0 if unknown
+	 * @retval bool true if response has been set to `304 Not Modified`, so no content should be sent
+	 *
+	 * Call this before opening any stream for the content.
+	 */
+	bool checkNotModified(const HttpRequest& request, const String& etag, time_t lastModified = 0);
+
+	/**
+	 * @brief Answer a `Range` request with part of the content
+	 * @param request Provides the `Range` and `If-Range` headers
+	 * @retval bool true if response has been changed to `206 Partial Content` or `416 Range Not Satisfiable`
+	 *
+	 * Applies only to successful GET requests where the stream has a known length and supports seeking,
+	 * in which case `Accept-Ranges` is also set.
+	 * Multiple ranges are sent as `multipart/byteranges` content.
+	 *
+	 * Called by the server once the response is complete, before sending it.
+	 */
+	bool applyRange(const HttpRequest& request);
+
 	/**
 	 * @brief Parse and send stream, using the name to determine the content type
 	 * @param newDataStream If not set already, the contentType will be obtained from the name of this stream
@@ -144,6 +215,7 @@ public:
 
 private:
 	void setStream(IDataSourceStream* stream);
+	bool sendFlashContent(const HttpRequest& request, const FSTR::String* content, const String& fileName);
 
 public:
 	HttpStatus code = HTTP_STATUS_OK;	///< The HTTP status response code
@@ -0,0 +1,200 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/SmingHub/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * HttpResponseCache.cpp
+ *
+ ****/
+
+#include "HttpResponseCache.h"
+#include <Data/Stream/SharedMemoryStream.h>
+#include <Data/Stream/StreamChain.h>
+#include <Clock.h>
+
+void HttpResponseCache::release(Entry& entry)
+{
+	entry.key = nullptr;
+	entry.headers.clear();
+	entry.content.reset();
+	entry.contentSize = 0;
+}
+
+String HttpResponseCache::getKey(const HttpRequest& request) const
+{
+	// NUL separators can't appear in the path, so keys are unambiguous
+	String key = request.uri.Path;
+	for(auto name : keyParameters) {
+		key += '\0';
+		key += request.getQueryParameter(name);
+	}
+	return key;
+}
+
+HttpResponseCache::Entry* HttpResponseCache::find(const String& key, uint32_t now)
+{
+	if(!entries) {
+		return nullptr;
+	}
+
+	for(unsigned i = 0; i < maxEntries; ++i) {
+		auto& entry = entries[i];
+		if(entry.key != key) {
+			continue;
+		}
+		if(isDue(entry.expires, now)) {
+			release(entry);
+			return nullptr;
+		}
+		return &entry;
+	}
+
+	return nullptr;
+}
+
+HttpResponseCache::Entry* HttpResponseCache::allocate(uint32_t now)
+{
+	if(!entries) {
+		entries.reset(new(std::nothrow) Entry[maxEntries]);
+		if(!entries) {
+			return nullptr;
+		}
+	}
+
+	// Prefer an unused or expired entry, otherwise replace the one due to expire first
+	Entry* oldest{nullptr};
+	for(unsigned i = 0; i < maxEntries; ++i) {
+		auto& entry = entries[i];
+		if(!entry.key || isDue(entry.expires, now)) {
+			return &entry;
+		}
+		if(oldest == nullptr || int32_t(entry.expires - oldest->expires) < 0) {
+			oldest = &entry;
+		}
+	}
+	return oldest;
+}
+
+bool HttpResponseCache::load(const HttpRequest& request, HttpResponse& response)
+{
+	if(request.method != HTTP_GET) {
+		return false;
+	}
+
+	auto entry = find(getKey(request), millis());
+	if(entry == nullptr) {
+		++stats.misses;
+		return false;
+	}
+
+	response.code = HTTP_STATUS_OK;
+	response.headers.setMultiple(entry->headers);
+	if(entry->content) {
+		response.freeStreams();
+		response.sendDataStream(new SharedMemoryStream<const char>(entry->content, entry->contentSize));
+	}
+	++stats.hits;
+	return true;
+}
+
+bool HttpResponseCache::readContent(HttpResponse& response, std::shared_ptr<const char>& content, size_t& size)
+{
+	auto stream = response.stream;
+	if(stream == nullptr) {
+		size = 0;
+		return true;
+	}
+
+	int available = stream->available();
+	if(available > int(maxContentSize)) {
+		return false;
+	}
+
+	// Size of generated content may be unknown, so read up to the limit
+	size_t capacity = (available >= 0) ? size_t(available) : maxContentSize;
+	std::shared_ptr<char> buffer(new(std::nothrow) char[capacity], std::default_delete<char[]>());
+	if(!buffer) {
+		return false;
+	}
+	size_t length{0};
+	while(length < capacity) {
+		auto count = stream->readBytes(buffer.get() + length, capacity - length);
+		if(count == 0) {
+			break;
+		}
+		length += count;
+	}
+	bool complete = stream->isFinished();
+
+	// Response now gets its content from the buffer, followed by anything left in the original stream
+	response.stream = nullptr;
+	if(response.buffer == stream) {
+		response.buffer = nullptr;
+	}
+	IDataSourceStream* newStream = new SharedMemoryStream<const char>(buffer, length);
+	if(complete) {
+		delete stream;
+		response.headers.remove(HTTP_HEADER_TRANSFER_ENCODING);
+	} else {
+		auto chain = new StreamChain;
+		chain->attachStream(newStream);
+		chain->attachStream(stream);
+		newStream = chain;
+	}
+	response.sendDataStream(newStream);
+
+	if(!complete) {
+		return false;
+	}
+
+	content = std::move(buffer);
+	size = length;
+	return true;
+}
+
+void HttpResponseCache::store(const HttpRequest& request, HttpResponse& response)
+{
+	if(maxEntries == 0 || request.method != HTTP_GET || response.code != HTTP_STATUS_OK ||
+	   response.headers.contains(HTTP_HEADER_SET_COOKIE)) {
+		return;
+	}
+
+	std::shared_ptr<const char> content;
+	size_t size;
+	if(!readContent(response, content, size)) {
+		return;
+	}
+
+	auto now = millis();
+	auto entry = allocate(now);
+	if(entry == nullptr) {
+		return;
+	}
+
+	entry->key = getKey(request);
+	entry->expires = now + ttl;
+	entry->headers = response.headers;
+	entry->content = std::move(content);
+	entry->contentSize = size;
+	++stats.stores;
+}
+
+void HttpResponseCache::invalidate()
+{
+	entries.reset();
+}
+
+void HttpResponseCache::invalidate(const String& path)
+{
+	if(!entries) {
+		return;
+	}
+
+	for(unsigned i = 0; i < maxEntries; ++i) {
+		auto& entry = entries[i];
+		if(entry.key.startsWith(path) && (entry.key.length() == path.length() || entry.key[path.length()] == '\0')) {
+			release(entry);
+		}
+	}
+}
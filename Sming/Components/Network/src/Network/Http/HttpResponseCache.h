@@ -0,0 +1,126 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/SmingHub/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * HttpResponseCache.h
+ *
+ ****/
+
+#pragma once
+
+#include "HttpRequest.h"
+#include "HttpResponse.h"
+#include <Data/CStringArray.h>
+#include <memory>
+
+/**
+ * @brief Short-lived cache of generated responses for a dynamic resource
+ * @ingroup httpserver
+ *
+ * Endpoints such as status pages are often polled by several clients, each regenerating
+ * identical output. Attach a cache to the resource and successful GET responses are kept
+ * in memory for `ttl` milliseconds. Requests arriving in that time are answered directly
+ * from a shared buffer, without invoking the resource's `onRequestComplete` handler or plugins.
+ *
+ * Entries are keyed by path, plus the values of any query parameters set using `setKeyParameters()`.
+ * Responses which set cookies, or whose content exceeds `maxContentSize`, are not cached.
+ *
+ * Example:
+ *
+ *     HttpResponseCache statusCache(500);
+ *
+ *     server.paths.set("/api/status", onStatus)->setResponseCache(&statusCache);
+ *
+ *     // When status changes
+ *     statusCache.invalidate();
+ */
+class HttpResponseCache
+{
+public:
+	struct Stats {
+		uint32_t hits;	 ///< Requests answered from the cache
+		uint32_t misses; ///< Cacheable requests passed to the resource
+		uint32_t stores; ///< Responses added to the cache
+	};
+
+	/**
+	 * @brief Constructor
+	 * @param ttl How long responses remain valid, in milliseconds
+	 * @param maxEntries Number of distinct keys retained
+	 * @param maxContentSize Largest response body which will be cached
+	 */
+	HttpResponseCache(uint16_t ttl = 1000, uint8_t maxEntries = 4, uint16_t maxContentSize = 4096)
+		: ttl(ttl), maxEntries(maxEntries), maxContentSize(maxContentSize)
+	{
+	}
+
+	/**
+	 * @brief Set query parameters which distinguish responses
+	 * @param names Parameter names. Any others are ignored when looking up responses.
+	 * @note Existing entries are discarded
+	 */
+	void setKeyParameters(const CStringArray& names)
+	{
+		keyParameters = names;
+		invalidate();
+	}
+
+	/**
+	 * @brief Answer a request from the cache
+	 * @retval bool true if response has been set
+	 */
+	bool load(const HttpRequest& request, HttpResponse& response);
+
+	/**
+	 * @brief Add a completed response to the cache
+	 *
+	 * The response body is read into a shared buffer and the response given a stream
+	 * which reads from it.
+	 */
+	void store(const HttpRequest& request, HttpResponse& response);
+
+	/**
+	 * @brief Discard all cached responses
+	 */
+	void invalidate();
+
+	/**
+	 * @brief Discard cached responses for a path
+	 * @param path Request path, starting with '/'
+	 */
+	void invalidate(const String& path);
+
+	const Stats& getStats() const
+	{
+		return stats;
+	}
+
+private:
+	struct Entry {
+		String key;
+		uint32_t expires{0};
+		HttpHeaders headers;
+		std::shared_ptr<const char> content;
+		size_t contentSize{0};
+	};
+
+	static bool isDue(uint32_t time, uint32_t now)
+	{
+		return int32_t(time - now) <= 0;
+	}
+
+	static void release(Entry& entry);
+	String getKey(const HttpRequest& request) const;
+	Entry* find(const String& key, uint32_t now);
+	Entry* allocate(uint32_t now);
+	bool readContent(HttpResponse& response, std::shared_ptr<const char>& content, size_t& size);
+
+	std::unique_ptr<Entry[]> entries;
+	CStringArray keyParameters;
+	Stats stats{};
+	uint16_t ttl;
+	uint8_t maxEntries;
+	uint16_t maxContentSize;
+};
@@ -11,17 +11,15 @@
  ****/
 
 #include "HttpServerConnection.h"
+#include "HttpFastParser.h"
 #include "HttpResourceTree.h"
 #include "Network/HttpServer.h"
 #include "Network/TcpServer.h"
 #include <Data/WebConstants.h>
 #include "Data/Stream/ChunkedStream.h"
+#include "Data/Stream/MemoryDataStream.h"
 #include <SystemClock.h>
 
-#if HTTP_SERVER_EXPOSE_VERSION == 1
-#include <SmingVersion.h>
-#endif
-
 int HttpServerConnection::onMessageBegin(http_parser* parser)
 {
 	// Reset Response ...
@@ -35,11 +33,12 @@ int HttpServerConnection::onMessageBegin(http_parser* parser)
 	reset();
 	bodyParser = nullptr;
 	hasContentError = false;
+	messageActive = true;
 
 	return 0;
 }
 
-int HttpServerConnection::onPath(const Url& uri)
+int HttpServerConnection::onPath(const UrlView& uri)
 {
 	if(resourceTree == nullptr) {
 		debug_e("ERROR: HttpServerConnection: The resource tree is not set!");
@@ -47,9 +46,10 @@ int HttpServerConnection::onPath(const Url& uri)
 		return -1;
 	}
 
-	request.setURL(uri);
+	// Decode straight into the request, avoiding a temporary Url
+	request.uri = uri;
 
-	resource = resourceTree->find(request.uri.Path);
+	resource = resourceTree->match(request.uri.Path, &request.pathParameters);
 	if(resource == nullptr) {
 		resource = resourceTree->getDefault();
 	}
@@ -61,6 +61,7 @@ int HttpServerConnection::onMessageComplete(http_parser* parser)
 {
 	// we are finished with this request
 	int hasError = 0;
+	messageActive = false;
 
 	if(bodyParser) {
 		bodyParser(request, nullptr, PARSE_DATAEND);
@@ -86,7 +87,7 @@ int HttpServerConnection::onMessageComplete(http_parser* parser)
 	return hasError;
 }
 
-int HttpServerConnection::onHeadersComplete(const HttpHeaders& headers)
+int HttpServerConnection::onHeadersComplete(const HttpHeaderBuilder& headers)
 {
 	/* Callbacks should return non-zero to indicate an error. The parser will
 	 * then halt execution.
@@ -103,7 +104,7 @@ int HttpServerConnection::onHeadersComplete(const HttpHeaders& headers)
 	 * `Upgrade` or `Connection: upgrade` headers.
 	 */
 	int error = 0;
-	request.setHeaders(headers);
+	headers.copyTo(request.headers);
 
 	if(resource != nullptr) {
 		error = resource->handleHeaders(*this, request, response);
@@ -187,6 +188,81 @@ int HttpServerConnection::onBody(const char* at, size_t length)
 	return 0;
 }
 
+#if HTTP_FAST_PARSER
+bool HttpServerConnection::onTcpReceive(TcpClient& client, char* data, int size)
+{
+	// Only whole requests are handled here, so http_parser is always between messages
+	while(size > 0 && !messageActive && HTTP_PARSER_ERRNO(&parser) == HPE_OK) {
+		int parsedBytes = fastParse(data, size);
+		if(parsedBytes < 0) {
+			bool isRecoverable = onHttpError(HTTP_PARSER_ERRNO(&parser));
+			if(isRecoverable) {
+				setCloseAfterSent(true);
+			}
+			return isRecoverable;
+		}
+		if(parsedBytes == 0) {
+			break;
+		}
+		data += parsedBytes;
+		size -= parsedBytes;
+	}
+
+	if(size == 0) {
+		return true;
+	}
+
+	return HttpConnection::onTcpReceive(client, data, size);
+}
+
+/*
+ * Handle a simple request without http_parser, invoking the same callbacks.
+ * Returns number of bytes consumed, 0 if http_parser must be used, or -1 on callback error.
+ */
+int HttpServerConnection::fastParse(const char* data, size_t size)
+{
+	HttpFastParser::Request req;
+	incomingHeaders.reset();
+	if(!HttpFastParser::parse(data, size, req, incomingHeaders)) {
+		incomingHeaders.reset();
+		return 0;
+	}
+
+	// Message callbacks reset incomingHeaders, so take the parsed content until it's been processed
+	HttpHeaderBuilder headers(std::move(incomingHeaders));
+
+	reset();
+	parser.method = req.method;
+	HttpError error = HPE_OK;
+	if(onMessageBegin(&parser) != 0) {
+		error = HPE_CB_message_begin;
+	} else if(onPath(UrlView(req.path, req.pathLength)) != 0) {
+		error = HPE_CB_url;
+	} else if(onHeadersComplete(headers) != 0) {
+		error = HPE_CB_headers_complete;
+	}
+
+	// Return buffer to the connection for re-use
+	incomingHeaders = std::move(headers);
+	incomingHeaders.reset();
+
+	if(error == HPE_OK && req.contentLength != 0 && onBody(data + req.headLength, req.contentLength) != 0) {
+		error = HPE_CB_body;
+	}
+	if(error == HPE_OK && onMessageComplete(&parser) != 0) {
+		error = HPE_CB_message_complete;
+	}
+	reset();
+
+	if(error != HPE_OK) {
+		parser.http_errno = unsigned(error);
+		return -1;
+	}
+
+	return req.headLength + req.contentLength;
+}
+#endif
+
 bool HttpServerConnection::onHttpError(HttpError error)
 {
 	response.code = HTTP_STATUS_BAD_REQUEST;
@@ -208,6 +284,8 @@ void HttpServerConnection::onReadyToSendData(TcpConnectionEvent sourceEvent)
 		if(response.stream != nullptr && response.stream->available() == 0 && !response.stream->isFinished()) {
 			break;
 		}
+		// Hold headers back so they share a segment with the start of the body
+		cork();
 		sendResponseHeaders(&response);
 		state = eHCS_SendingHeaders;
 	}
@@ -249,6 +327,11 @@ void HttpServerConnection::onReadyToSendData(TcpConnectionEvent sourceEvent)
 	} /* switch(state) */
 
 	TcpClient::onReadyToSendData(sourceEvent);
+
+	// Headers and first part of body have been queued
+	if(state != eHCS_SendingHeaders && state != eHCS_StartBody) {
+		uncork();
+	}
 }
 
 void HttpServerConnection::sendResponseHeaders(HttpResponse* response)
@@ -265,23 +348,22 @@ void HttpServerConnection::sendResponseHeaders(HttpResponse* response)
 		}
 	}
 
-	if(request.headers.contains(HTTP_HEADER_IF_MATCH) && response->headers.contains(HTTP_HEADER_ETAG) &&
-	   request.headers[HTTP_HEADER_IF_MATCH] == response->headers[HTTP_HEADER_ETAG]) {
-		if(request.method == HTTP_GET || request.method == HTTP_HEAD) {
-			response->code = HTTP_STATUS_NOT_MODIFIED;
-			response->headers[HTTP_HEADER_CONTENT_LENGTH] = "0";
-			delete response->stream;
-			response->stream = nullptr;
-		}
+	if(response->stream != nullptr && response->code == HTTP_STATUS_OK) {
+		response->checkNotModified(request, response->headers[HTTP_HEADER_ETAG]);
 	}
 #endif /* DISABLE_HTTPSRV_ETAG */
 
-	String statusLine = F("HTTP/1.1 ");
-	statusLine += unsigned(response->code);
-	statusLine += ' ';
-	statusLine += toString(response->code);
-	statusLine += "\r\n";
-	sendString(statusLine);
+	if(response->stream != nullptr) {
+		response->applyRange(request);
+	}
+
+	if(resourceTree != nullptr && !response->headers.contains(HTTP_HEADER_CACHE_CONTROL)) {
+		String cacheControl = resourceTree->getCacheControl(request.uri.Path);
+		if(cacheControl) {
+			response->headers[HTTP_HEADER_CACHE_CONTROL] = cacheControl;
+		}
+	}
+
 	if(response->stream != nullptr && response->stream->available() >= 0) {
 		response->headers[HTTP_HEADER_CONTENT_LENGTH] = String(response->stream->available());
 	}
@@ -298,24 +380,41 @@ void HttpServerConnection::sendResponseHeaders(HttpResponse* response)
 		}
 	}
 
-#if HTTP_SERVER_EXPOSE_NAME == 1
-	if(!response->headers.contains(HTTP_HEADER_SERVER)) {
-		String s = F("HttpServer/Sming");
-#if HTTP_SERVER_EXPOSE_VERSION == 1
-		s += F(" Sming/" SMING_VERSION);
-#endif
-		response->headers[HTTP_HEADER_SERVER] = s;
+	if(SystemClock.isSet()) {
+		response->headers[HTTP_HEADER_DATE] = DateTime::getHTTPDate(SystemClock.now(eTZ_UTC));
 	}
-#endif
 
-	if(SystemClock.isSet()) {
-		response->headers[HTTP_HEADER_DATE] = DateTime(SystemClock.now(eTZ_UTC)).toHTTPDate();
+	// Pre-rendered server fields are used as-is unless the response overrides any of them
+	const String* defaultText = nullptr;
+	if(defaultHeaders != nullptr) {
+		if(response->headers.containsAny(defaultHeaders->getHeaders())) {
+			response->headers.setDefaults(defaultHeaders->getHeaders());
+		} else {
+			defaultText = &defaultHeaders->getText();
+		}
 	}
 
-	for(unsigned i = 0; i < response->headers.count(); i++) {
-		sendString(response->headers[i]);
+	// Build complete header in a single buffer
+	String text = F("HTTP/1.1 ");
+	text += unsigned(response->code);
+	text += ' ';
+	text += toString(response->code);
+	text += "\r\n";
+	auto statusLength = text.length();
+	auto defaultLength = defaultText ? defaultText->length() : 0;
+	if(!text.setLength(statusLength + response->headers.getOutputLength() + defaultLength + 2)) {
+		debug_e("[HTTP] Out of memory for response headers");
+		return;
+	}
+	auto ptr = response->headers.write(text.begin() + statusLength);
+	if(defaultLength != 0) {
+		memcpy(ptr, defaultText->c_str(), defaultLength);
+		ptr += defaultLength;
 	}
-	sendString("\r\n");
+	ptr[0] = '\r';
+	ptr[1] = '\n';
+
+	send(new MemoryDataStream(std::move(text)));
 }
 
 bool HttpServerConnection::sendResponseBody(HttpResponse* response)
@@ -15,9 +15,16 @@
 #include "HttpConnection.h"
 #include "HttpResource.h"
 #include "HttpBodyParser.h"
+#include "HttpHeaderBlock.h"
+#include "HttpConnectionRecycler.h"
+#include <ObjectPool.h>
 
 #include <functional>
 
+#ifndef HTTP_FAST_PARSER
+#define HTTP_FAST_PARSER 1
+#endif
+
 /** @ingroup   	httpserver
  *  @brief      Provides http server connection
  *  @{
@@ -32,6 +39,9 @@ using HttpServerProtocolUpgradeCallback = Delegate<bool()>;
 
 class HttpServerConnection : public HttpConnection
 {
+	OBJECT_POOL_ALLOCATED(HttpServerConnection, 0)
+	friend class HttpConnectionRecycler;
+
 public:
 	HttpServerConnection(tcp_pcb* clientTcp) : HttpConnection(clientTcp, HTTP_REQUEST)
 	{
@@ -46,6 +56,10 @@ public:
 		if(bodyParser && request.args != nullptr) {
 			bodyParser(request, nullptr, PARSE_DATAEND);
 		}
+
+		if(recycler != nullptr) {
+			recycler->put(*this);
+		}
 	}
 
 	void setResourceTree(HttpResourceTree* resourceTree)
@@ -85,12 +99,31 @@ public:
 		closeOnContentError = close;
 	}
 
+	/**
+	 * @brief Set fields to be included in every response
+	 * @param headers Owned by the server
+	 */
+	void setDefaultHeaders(const HttpHeaderBlock* headers)
+	{
+		defaultHeaders = headers;
+	}
+
+	/**
+	 * @brief Set recycler to receive header storage when connection closes
+	 * @param recycler Owned by the server, nullptr to release storage normally
+	 */
+	void setRecycler(HttpConnectionRecycler* recycler)
+	{
+		this->recycler = recycler;
+	}
+
 protected:
 	// HTTP parser methods
 
 	int onMessageBegin(http_parser* parser) override;
-	int onPath(const Url& path) override;
-	int onHeadersComplete(const HttpHeaders& headers) override;
+	using HttpConnection::onPath;
+	int onPath(const UrlView& uri) override;
+	int onHeadersComplete(const HttpHeaderBuilder& headers) override;
 	int onBody(const char* at, size_t length) override;
 	int onMessageComplete(http_parser* parser) override;
 
@@ -106,10 +139,16 @@ protected:
 	bool onHttpError(HttpError error) override;
 
 	// TCP methods
+#if HTTP_FAST_PARSER
+	bool onTcpReceive(TcpClient& client, char* data, int size) override;
+#endif
 	void onReadyToSendData(TcpConnectionEvent sourceEvent) override;
 	virtual void sendError(const String& message = nullptr, HttpStatus code = HTTP_STATUS_BAD_REQUEST);
 
 private:
+#if HTTP_FAST_PARSER
+	int fastParse(const char* data, size_t size);
+#endif
 	void sendResponseHeaders(HttpResponse* response);
 	bool sendResponseBody(HttpResponse* response);
 
@@ -127,10 +166,13 @@ private:
 	HttpServerConnectionBodyDelegate onBodyDelegate = nullptr;
 	HttpServerProtocolUpgradeCallback upgradeCallback = nullptr;
 
+	const HttpHeaderBlock* defaultHeaders = nullptr;
+	HttpConnectionRecycler* recycler = nullptr;
 	const BodyParsers* bodyParsers = nullptr;	///< const reference ensures we cannot modify map, only look stuff up
 	HttpBodyParserDelegate bodyParser = nullptr; ///< Active body parser for this message, if any
 	bool closeOnContentError = false;
 	bool hasContentError = false;
+	bool messageActive = false; ///< http_parser is part-way through a message
 };
 
 /** @} */
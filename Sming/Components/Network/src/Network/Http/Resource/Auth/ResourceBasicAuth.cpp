@@ -0,0 +1,121 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/SmingHub/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * ResourceBasicAuth.cpp
+ *
+ ****/
+
+#include "ResourceBasicAuth.h"
+#include "../../HttpServerConnection.h"
+#include <Data/WebHelpers/base64.h>
+
+ResourceBasicAuth::ResourceBasicAuth(const String& realm, const String& username, const String& password)
+	: realm(realm), token(base64_encode(username + ':' + password))
+{
+}
+
+bool ResourceBasicAuth::checkAuthorization(const String& value) const
+{
+	// Expect "Basic <token>", with optional surrounding whitespace
+	auto p = value.c_str();
+	auto end = p + value.length();
+	while(p < end && isspace(*p)) {
+		++p;
+	}
+	while(end > p && isspace(end[-1])) {
+		--end;
+	}
+	constexpr size_t schemeLength{5};
+	if(size_t(end - p) <= schemeLength || strncasecmp(p, _F("Basic"), schemeLength) != 0 ||
+	   !isspace(p[schemeLength])) {
+		return false;
+	}
+	p += schemeLength;
+	while(p < end && isspace(*p)) {
+		++p;
+	}
+
+	// Compare all characters so time taken doesn't indicate where the mismatch is
+	size_t length = end - p;
+	uint8_t diff = (length == token.length()) ? 0 : 1;
+	auto expected = token.c_str();
+	for(size_t i = 0; i < length; ++i) {
+		diff |= uint8_t(p[i]) ^ uint8_t(expected[i % token.length()]);
+	}
+	return diff == 0;
+}
+
+ResourceBasicAuth::FailureEntry* ResourceBasicAuth::findFailures(IpAddress ip)
+{
+	for(auto& e : failures) {
+		if(e.count != 0 && e.ip == ip) {
+			return &e;
+		}
+	}
+	return nullptr;
+}
+
+void ResourceBasicAuth::addFailure(IpAddress ip, FailureEntry* entry)
+{
+	auto now = millis();
+	if(entry == nullptr) {
+		// Prefer an unused entry, otherwise recycle the one least recently used
+		entry = &failures[0];
+		for(auto& e : failures) {
+			if(e.count == 0) {
+				entry = &e;
+				break;
+			}
+			if(uint32_t(now - e.lastFailure) > uint32_t(now - entry->lastFailure)) {
+				entry = &e;
+			}
+		}
+		entry->ip = ip;
+		entry->count = 0;
+	}
+
+	if(entry->count < UINT8_MAX) {
+		++entry->count;
+	}
+	entry->lastFailure = now;
+}
+
+bool ResourceBasicAuth::headersComplete(HttpServerConnection& connection, HttpRequest& request,
+										HttpResponse& response)
+{
+	auto remoteIp = connection.getRemoteIp();
+	auto entry = findFailures(remoteIp);
+	if(entry != nullptr && maxFailures != 0 && entry->count >= maxFailures) {
+		auto elapsed = millis() - entry->lastFailure;
+		if(elapsed < lockoutSeconds * 1000U) {
+			debug_w("[AUTH] %s locked out", remoteIp.toString().c_str());
+			response.code = HTTP_STATUS_TOO_MANY_REQUESTS;
+			response.headers[HTTP_HEADER_RETRY_AFTER] = String(lockoutSeconds - elapsed / 1000U);
+			return false;
+		}
+		// Lockout expired: allow another attempt, but a further failure locks out again
+		entry->count = maxFailures - 1;
+	}
+
+	auto& authorization = static_cast<const HttpHeaders&>(request.headers)[HTTP_HEADER_AUTHORIZATION];
+	if(authorization) {
+		if(checkAuthorization(authorization)) {
+			if(entry != nullptr) {
+				entry->count = 0;
+			}
+			return true;
+		}
+
+		debug_w("[AUTH] Invalid credentials from %s", remoteIp.toString().c_str());
+		addFailure(remoteIp, entry);
+	}
+
+	// specify that the resource is protected...
+	response.code = HTTP_STATUS_UNAUTHORIZED;
+	response.headers[HTTP_HEADER_WWW_AUTHENTICATE] = F("Basic realm=\"") + realm + "\"";
+
+	return false;
+}
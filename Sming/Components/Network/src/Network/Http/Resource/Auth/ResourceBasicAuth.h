@@ -12,55 +12,54 @@
 #pragma once
 
 #include "../HttpResourcePlugin.h"
-#include <Data/WebHelpers/base64.h>
 
+/**
+ * @brief Protect a resource using HTTP Basic authentication
+ *
+ * The expected `Authorization` header token is computed once on construction,
+ * so checking a request requires no decoding or memory allocation.
+ * The comparison takes the same time wherever the first mismatch occurs.
+ *
+ * Repeated failures from the same IP address cause it to be locked out for a period,
+ * during which requests are rejected with `429 Too Many Requests` without checking credentials.
+ * Failures are tracked in a small fixed table, the least recently used entry being recycled as required.
+ */
 class ResourceBasicAuth : public HttpPreFilter
 {
 public:
-	ResourceBasicAuth(const String& realm, const String& username, const String& password)
-		: realm(realm), username(username), password(password)
-	{
-	}
+	static constexpr uint8_t defaultMaxFailures{5};
+	static constexpr uint16_t defaultLockoutSeconds{30};
+	static constexpr unsigned failureTableSize{8};
 
-	bool headersComplete(HttpServerConnection& connection, HttpRequest& request, HttpResponse& response) override
-	{
-		auto& headers = request.headers;
-		auto authorization = headers[HTTP_HEADER_AUTHORIZATION];
-		if(authorization) {
-			// check the authorization
-			authorization.trim();
-			auto pos = authorization.indexOf(' ');
-			if(pos < 0) {
-				debug_w("Invalid authorization header");
-				return true;
-			}
+	ResourceBasicAuth(const String& realm, const String& username, const String& password);
 
-			auto type = authorization.substring(0, pos);
-			auto token = authorization.substring(pos + 1, authorization.length());
-			if(!type.equalsIgnoreCase(F("Basic"))) {
-				return true;
-			}
+	/**
+	 * @brief Set limits on failed authentication attempts
+	 * @param maxFailures Consecutive failures from an IP address before it is locked out, 0 to disable
+	 * @param lockoutSeconds Time for which address is locked out
+	 */
+	void setThrottle(uint8_t maxFailures, uint16_t lockoutSeconds)
+	{
+		this->maxFailures = maxFailures;
+		this->lockoutSeconds = lockoutSeconds;
+	}
 
-			String text = base64_decode(token.c_str(), token.length());
-			pos = text.indexOf(':');
-			if(pos > 0) {
-				auto providedUsername = text.substring(0, pos);
-				auto providedPassword = text.substring(pos + 1, text.length());
-				if(providedUsername == username && providedPassword == password) {
-					return true;
-				}
-			}
-		}
+	bool headersComplete(HttpServerConnection& connection, HttpRequest& request, HttpResponse& response) override;
 
-		// specify that the resource is protected...
-		response.code = HTTP_STATUS_UNAUTHORIZED;
-		response.headers[HTTP_HEADER_WWW_AUTHENTICATE] = F("Basic realm=\"") + realm + "\"";
+private:
+	struct FailureEntry {
+		IpAddress ip;
+		uint32_t lastFailure; ///< millis()
+		uint8_t count;		  ///< Consecutive failed attempts
+	};
 
-		return false;
-	}
+	bool checkAuthorization(const String& value) const;
+	FailureEntry* findFailures(IpAddress ip);
+	void addFailure(IpAddress ip, FailureEntry* entry);
 
-private:
 	String realm;
-	String username;
-	String password;
+	String token; ///< Expected credentials, base64-encoded
+	FailureEntry failures[failureTableSize]{};
+	uint16_t lockoutSeconds{defaultLockoutSeconds};
+	uint8_t maxFailures{defaultMaxFailures};
 };
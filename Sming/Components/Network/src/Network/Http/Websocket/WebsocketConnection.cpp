@@ -15,6 +15,8 @@
 #include <Data/Stream/MemoryDataStream.h>
 #include <Data/Stream/XorOutputStream.h>
 #include <Data/Stream/SharedMemoryStream.h>
+#include <EventBus.h>
+#include <algorithm>
 #include <memory>
 
 DEFINE_FSTR(WSSTR_CONNECTION, "connection")
@@ -28,6 +30,7 @@ DEFINE_FSTR(WSSTR_VERSION, "Sec-WebSocket-Version")
 DEFINE_FSTR(WSSTR_SECRET, "258EAFA5-E914-47DA-95CA-C5AB0DC85B11")
 
 WebsocketList WebsocketConnection::websocketList;
+size_t WebsocketConnection::broadcastLimit{WEBSOCKET_BROADCAST_LIMIT};
 
 /** @brief ws_parser function table
  * 	@note stored in flash memory; as it is word-aligned it can be accessed directly
@@ -71,7 +74,20 @@ bool WebsocketConnection::bind(HttpRequest& request, HttpResponse& response)
 	response.code = HTTP_STATUS_SWITCHING_PROTOCOLS;
 	response.headers[HTTP_HEADER_CONNECTION] = WSSTR_UPGRADE;
 	response.headers[HTTP_HEADER_UPGRADE] = WSSTR_WEBSOCKET;
-	response.headers[HTTP_HEADER_SEC_WEBSOCKET_ACCEPT] = base64_encode(hash.data(), hash.size());
+	char acceptKey[29];
+	int acceptKeyLength = base64_encode(hash.size(), hash.data(), sizeof(acceptKey), acceptKey);
+	response.headers[HTTP_HEADER_SEC_WEBSOCKET_ACCEPT].setString(acceptKey, acceptKeyLength);
+
+	stopDeflate();
+	if(deflateConfig && request.headers.contains(HTTP_HEADER_SEC_WEBSOCKET_EXTENSIONS)) {
+		WsDeflateConfig agreed;
+		String extension;
+		if(WsDeflate::acceptOffer(request.headers[HTTP_HEADER_SEC_WEBSOCKET_EXTENSIONS], *deflateConfig, agreed,
+								  extension) &&
+		   startDeflate(agreed)) {
+			response.headers[HTTP_HEADER_SEC_WEBSOCKET_EXTENSIONS] = extension;
+		}
+	}
 
 	isClientConnection = false;
 
@@ -98,8 +114,80 @@ void WebsocketConnection::activate()
 	connection->setReceiveDelegate(TcpClientDataDelegate(&WebsocketConnection::processFrame, this));
 }
 
+bool WebsocketConnection::startDeflate(const WsDeflateConfig& agreed)
+{
+	// zlib cannot compress with a 256-byte window and uses 512 bytes instead
+	auto rxWindowBits = std::max(agreed.rxWindowBits, uint8_t(9));
+	deflater.reset(new WsDeflater(agreed.txWindowBits, agreed.txNoContextTakeover));
+	inflater.reset(new WsInflater(rxWindowBits, agreed.rxNoContextTakeover, agreed.maxCompressedSize));
+	if(!deflater || !inflater) {
+		stopDeflate();
+		return false;
+	}
+	compressThreshold = agreed.threshold;
+	frameScan = {};
+	return true;
+}
+
+void WebsocketConnection::stopDeflate()
+{
+	deflater.reset();
+	inflater.reset();
+	messageCompressed = false;
+}
+
+bool WebsocketConnection::scanFrameHeaders(char* at, size_t size)
+{
+	auto& scan = frameScan;
+	while(size != 0) {
+		if(scan.headerPos == 0 && scan.payloadRemaining != 0) {
+			auto n = std::min(uint64_t(size), scan.payloadRemaining);
+			at += n;
+			size -= n;
+			scan.payloadRemaining -= n;
+			continue;
+		}
+
+		uint8_t c = *at;
+		if(scan.headerPos == 0) {
+			// FIN, RSV1-3, opcode
+			bool rsv1 = c & bit(6);
+			*at = c & ~bit(6);
+			scan.headerLength = 2;
+			auto opcode = ws_frame_type_t(c & 0x0f);
+			if(opcode == WS_FRAME_TEXT || opcode == WS_FRAME_BINARY) {
+				if(scan.flagCount == 32) {
+					return false;
+				}
+				scan.flags |= uint32_t(rsv1) << scan.flagCount++;
+			}
+		} else if(scan.headerPos == 1) {
+			// MASK, payload length
+			uint8_t len = c & 0x7f;
+			scan.lengthBytes = (len == 126) ? 2 : (len == 127) ? 8 : 0;
+			scan.headerLength = 2 + scan.lengthBytes + ((c & bit(7)) ? 4 : 0);
+			scan.payloadRemaining = (len < 126) ? len : 0;
+		} else if(scan.headerPos < 2 + scan.lengthBytes) {
+			scan.payloadRemaining = (scan.payloadRemaining << 8) | c;
+		}
+
+		++at;
+		--size;
+		if(++scan.headerPos == scan.headerLength) {
+			scan.headerPos = 0;
+		}
+	}
+
+	return true;
+}
+
 bool WebsocketConnection::processFrame(TcpClient& client, char* at, int size)
 {
+	if(inflater && !scanFrameHeaders(at, size)) {
+		debug_e("WebsocketResource error: too many queued messages");
+		return false;
+	}
+
 	int rc = ws_parser_execute(&parser, &parserSettings, this, at, size);
 	if(rc != WS_OK) {
 		debug_e("WebsocketResource error: %d %s\n", rc, ws_parser_error(rc));
@@ -113,31 +201,136 @@ int WebsocketConnection::staticOnDataBegin(void* userData, ws_frame_type_t type)
 {
 	GET_CONNECTION();
 
+	// Any continuation frame extends the current message
+	if(type != WS_FRAME_TEXT && type != WS_FRAME_BINARY) {
+		return WS_OK;
+	}
+
 	connection->frameType = type;
+	connection->messageLength = 0;
+	connection->messageOverflow = false;
+
+	auto& scan = connection->frameScan;
+	connection->messageCompressed = (scan.flags & 1) != 0;
+	if(scan.flagCount != 0) {
+		scan.flags >>= 1;
+		--scan.flagCount;
+	}
 
 	debug_d("data_begin: %s\n", type == WS_FRAME_TEXT ? _F("text") : type == WS_FRAME_BINARY ? _F("binary") : "?");
 
-	return WS_OK;
+	auto pool = connection->reassemblyPool;
+	if(pool != nullptr) {
+		connection->releaseMessageBuffer();
+		connection->messageBuffer = static_cast<char*>(pool->allocate(pool->getObjectSize()));
+		if(connection->messageBuffer == nullptr) {
+			debug_e("Unable to allocate websocket reassembly buffer");
+			connection->messageOverflow = true;
+		}
+	}
+
+	return connection->notifyStream(WsStreamEvent::begin, nullptr, 0);
 }
 
 int WebsocketConnection::staticOnDataPayload(void* userData, const char* at, size_t length)
 {
 	GET_CONNECTION();
 
-	if(connection->frameType == WS_FRAME_TEXT && connection->wsMessage) {
-		connection->wsMessage(*connection, String(at, length));
-	} else if(connection->frameType == WS_FRAME_BINARY && connection->wsBinary) {
-		connection->wsBinary(*connection, reinterpret_cast<uint8_t*>(const_cast<char*>(at)), length);
+	if(connection->messageCompressed) {
+		// Decompressed at end of message
+		if(!connection->inflater->write(at, length)) {
+			debug_e("Compressed websocket message too large");
+			return -1;
+		}
+		return WS_OK;
+	}
+
+	return connection->processPayload(at, length);
+}
+
+int WebsocketConnection::processPayload(const char* data, size_t length)
+{
+	int rc = notifyStream(WsStreamEvent::data, data, length);
+	if(rc != WS_OK) {
+		return rc;
+	}
+
+	auto pool = reassemblyPool;
+	if(pool == nullptr) {
+		deliverMessage(data, length);
+	} else if(!messageOverflow) {
+		if(messageLength + length > pool->getObjectSize()) {
+			debug_w("Websocket message exceeds %u bytes, discarding", pool->getObjectSize());
+			messageOverflow = true;
+			releaseMessageBuffer();
+		} else {
+			memcpy(&messageBuffer[messageLength], data, length);
+		}
 	}
 
+	messageLength += length;
 	return WS_OK;
 }
 
 int WebsocketConnection::staticOnDataEnd(void* userData)
 {
+	GET_CONNECTION();
+
+	if(connection->messageCompressed) {
+		connection->messageCompressed = false;
+		bool ok = connection->inflater->finish([connection](const char* data, size_t length) -> bool {
+			return connection->processPayload(data, length) == WS_OK;
+		});
+		if(!ok) {
+			debug_e("Websocket message decompression failed");
+			return -1;
+		}
+	}
+
+	int rc = connection->notifyStream(WsStreamEvent::end, nullptr, 0);
+	if(rc != WS_OK) {
+		return rc;
+	}
+
+	if(connection->reassemblyPool != nullptr) {
+		if(connection->messageBuffer != nullptr && !connection->messageOverflow) {
+			connection->deliverMessage(connection->messageBuffer, connection->messageLength);
+		}
+		connection->releaseMessageBuffer();
+	}
+
 	return WS_OK;
 }
 
+int WebsocketConnection::notifyStream(WsStreamEvent event, const char* data, size_t length)
+{
+	if(!wsStream) {
+		return WS_OK;
+	}
+
+	WsStreamChunk chunk{event, frameType, data, length, messageLength, event == WsStreamEvent::end};
+	return wsStream(*this, chunk) ? WS_OK : -1;
+}
+
+void WebsocketConnection::deliverMessage(const char* data, size_t length)
+{
+	if(wsData) {
+		wsData(*this, frameType, data, length);
+	} else if(frameType == WS_FRAME_TEXT && wsMessage) {
+		wsMessage(*this, String(data, length));
+	} else if(frameType == WS_FRAME_BINARY && wsBinary) {
+		wsBinary(*this, reinterpret_cast<uint8_t*>(const_cast<char*>(data)), length);
+	}
+}
+
+void WebsocketConnection::releaseMessageBuffer()
+{
+	if(messageBuffer != nullptr) {
+		reassemblyPool->release(messageBuffer);
+		messageBuffer = nullptr;
+	}
+}
+
 int WebsocketConnection::staticOnControlBegin(void* userData, ws_frame_type_t type)
 {
 	GET_CONNECTION();
@@ -183,16 +376,31 @@ bool WebsocketConnection::send(const char* message, size_t length, ws_frame_type
 		return false;
 	}
 
-	size_t written = stream->write(message, length);
-	if(written != length) {
-		debug_e("Unable to store data in memory buffer");
-		return false;
+	bool compress = deflater && (type == WS_FRAME_TEXT || type == WS_FRAME_BINARY) && length >= compressThreshold;
+	if(compress) {
+		if(!deflater->compress(message, length, *stream)) {
+			debug_e("Unable to compress message");
+			delete stream;
+			return false;
+		}
+	} else {
+		size_t written = stream->write(message, length);
+		if(written != length) {
+			debug_e("Unable to store data in memory buffer");
+			return false;
+		}
 	}
 
-	return send(stream, type, isClientConnection);
+	return sendFrame(stream, type, isClientConnection, true, compress);
 }
 
 bool WebsocketConnection::send(IDataSourceStream* source, ws_frame_type_t type, bool useMask, bool isFin)
+{
+	return sendFrame(source, type, useMask, isFin, false);
+}
+
+bool WebsocketConnection::sendFrame(IDataSourceStream* source, ws_frame_type_t type, bool useMask, bool isFin,
+									bool compressed)
 {
 	if(source == nullptr) {
 		return false;
@@ -215,86 +423,180 @@ bool WebsocketConnection::send(IDataSourceStream* source, ws_frame_type_t type,
 
 	debug_d("Sending: %d bytes, Type: %d\n", available, type);
 
-	size_t packetLength = 2;
-	uint16_t lengthValue = available;
-
-	// calculate message length ....
-	if(available <= 125) {
-		lengthValue = available;
-	} else if(available < 65536) {
-		lengthValue = 126;
-		packetLength += 2;
-	} else {
-		lengthValue = 127;
-		packetLength += 8;
+	uint8_t maskKey[4];
+	if(useMask) {
+		for(auto& x : maskKey) {
+			x = os_random();
+		}
 	}
 
+	uint8_t packet[maxFrameHeaderLength];
+	auto packetLength = encodeFrameHeader(packet, available, type, useMask ? maskKey : nullptr, isFin, compressed);
+
 	if(useMask) {
-		packetLength += 4; // we use mask with size 4 bytes
+		auto xorStream = new XorOutputStream(source, maskKey, sizeof(maskKey));
+		source = xorStream;
 	}
 
-	uint8_t packet[packetLength];
-	memset(packet, 0, packetLength);
+	// send the header
+	if(!connection->send(reinterpret_cast<const char*>(packet), packetLength)) {
+		delete source;
+		return false;
+	}
 
-	int i = 0;
-	// byte 0
-	if(isFin) {
-		packet[i] |= bit(7); // set Fin
+	if(!connection->send(source)) {
+		return false;
 	}
-	packet[i++] |= (uint8_t)type; // set opcode
-	// byte 1
-	if(useMask) {
-		packet[i] |= bit(7); // set mask
+
+	if(!connection->isCorked()) {
+		connection->commit();
 	}
 
+	return true;
+}
+
+size_t WebsocketConnection::encodeFrameHeader(uint8_t* packet, size_t payloadLength, ws_frame_type_t type,
+											  const uint8_t* maskKey, bool isFin, bool compressed)
+{
+	unsigned i = 0;
+	// byte 0
+	packet[i++] = (isFin ? bit(7) : 0) | (compressed ? bit(6) : 0) | uint8_t(type);
+	// byte 1
+	uint8_t maskBit = (maskKey == nullptr) ? 0 : bit(7);
+
 	// length
-	if(lengthValue < 126) {
-		packet[i++] |= lengthValue;
-	} else if(lengthValue == 126) {
-		packet[i++] |= 126;
-		packet[i++] = (available >> 8) & 0xFF;
-		packet[i++] = available & 0xFF;
-	} else if(lengthValue == 127) {
-		packet[i++] |= 127;
+	if(payloadLength <= 125) {
+		packet[i++] = maskBit | payloadLength;
+	} else if(payloadLength < 65536) {
+		packet[i++] = maskBit | 126;
+		packet[i++] = (payloadLength >> 8) & 0xFF;
+		packet[i++] = payloadLength & 0xFF;
+	} else {
+		packet[i++] = maskBit | 127;
 		packet[i++] = 0;
 		packet[i++] = 0;
 		packet[i++] = 0;
 		packet[i++] = 0;
-		packet[i++] = (available >> 24) & 0xFF;
-		packet[i++] = (available >> 16) & 0xFF;
-		packet[i++] = (available >> 8) & 0xFF;
-		packet[i++] = (available)&0xFF;
+		packet[i++] = (payloadLength >> 24) & 0xFF;
+		packet[i++] = (payloadLength >> 16) & 0xFF;
+		packet[i++] = (payloadLength >> 8) & 0xFF;
+		packet[i++] = payloadLength & 0xFF;
 	}
 
-	if(useMask) {
-		uint8_t maskKey[4] = {0x00, 0x00, 0x00, 0x00};
-		for(uint8_t x = 0; x < sizeof(maskKey); x++) {
-			maskKey[x] = (char)os_random();
-			packet[i++] = maskKey[x];
-		}
-
-		auto xorStream = new XorOutputStream(source, maskKey, sizeof(maskKey));
-		source = xorStream;
+	if(maskKey != nullptr) {
+		memcpy(&packet[i], maskKey, 4);
+		i += 4;
 	}
 
-	// send the header
-	if(!connection->send(reinterpret_cast<const char*>(packet), packetLength)) {
-		delete source;
+	return i;
+}
+
+bool WebsocketConnection::canBroadcast(size_t frameLength)
+{
+	if(connection == nullptr || !activated || !connection->isProcessing()) {
 		return false;
 	}
 
-	return connection->send(source);
+	auto pending = connection->getPendingLength();
+	if(broadcastLimit == 0 || pending == 0 || pending + frameLength <= broadcastLimit) {
+		return true;
+	}
+
+	// Connection isn't keeping up, so drop this message rather than let its queue grow
+	++broadcastDrops;
+	debug_w("[WS] Broadcast dropped, %u bytes pending", pending);
+	return false;
 }
 
 void WebsocketConnection::broadcast(const char* message, size_t length, ws_frame_type_t type)
 {
-	char* copy = new char[length];
-	memcpy(copy, message, length);
-	std::shared_ptr<const char> data(copy, [](const char* ptr) { delete[] ptr; });
+	/*
+	 * Server connections don't mask data so every client gets identical frames.
+	 * Build the complete frame once and share it between all connections.
+	 */
+	uint8_t header[maxFrameHeaderLength];
+	auto headerLength = encodeFrameHeader(header, length, type, nullptr, true);
+	auto frameLength = headerLength + length;
+	char* frame = new char[frameLength];
+	if(frame == nullptr) {
+		debug_e("Unable to allocate broadcast frame");
+		return;
+	}
+	memcpy(frame, header, headerLength);
+	memcpy(&frame[headerLength], message, length);
+	std::shared_ptr<const char> data(frame, [](const char* ptr) { delete[] ptr; });
 
 	for(unsigned i = 0; i < websocketList.count(); i++) {
-		auto stream = new SharedMemoryStream<const char>(data, length);
-		websocketList[i]->send(stream, type);
+		auto ws = websocketList[i];
+		if(!ws->canBroadcast(frameLength)) {
+			continue;
+		}
+		if(ws->isClientConnection || ws->deflater) {
+			// Client connections require a unique mask for each frame, and compressed data depends on history
+			ws->send(message, length, type);
+			continue;
+		}
+		// On failure the stream is released by the connection
+		if(ws->connection->send(new SharedMemoryStream<const char>(data, frameLength)) &&
+		   !ws->connection->isCorked()) {
+			ws->connection->commit();
+		}
+	}
+}
+
+void WebsocketConnection::broadcast(const EventPayload& payload, ws_frame_type_t type)
+{
+	/*
+	 * As above, but the payload is already shared so only the frame header is built here.
+	 * Each server connection gets a header stream followed by a payload stream.
+	 */
+	uint8_t header[maxFrameHeaderLength];
+	auto headerLength = encodeFrameHeader(header, payload.size(), type, nullptr, true);
+	char* buf = new char[headerLength];
+	if(buf == nullptr) {
+		debug_e("Unable to allocate broadcast frame");
+		return;
+	}
+	memcpy(buf, header, headerLength);
+	std::shared_ptr<const char> headerData(buf, [](const char* ptr) { delete[] ptr; });
+
+	for(unsigned i = 0; i < websocketList.count(); i++) {
+		auto ws = websocketList[i];
+		if(!ws->canBroadcast(headerLength + payload.size())) {
+			continue;
+		}
+		if(ws->isClientConnection || ws->deflater) {
+			ws->send(payload.data(), payload.size(), type);
+			continue;
+		}
+
+		// Create both streams up front so a frame is never started without its payload
+		auto headerStream = new SharedMemoryStream<const char>(headerData, headerLength);
+		IDataSourceStream* payloadStream{nullptr};
+		if(payload.size() != 0) {
+			payloadStream = payload.createStream();
+			if(headerStream == nullptr || payloadStream == nullptr) {
+				delete headerStream;
+				delete payloadStream;
+				continue;
+			}
+		}
+
+		// On failure the stream is released by the connection
+		if(!ws->connection->send(headerStream)) {
+			delete payloadStream;
+			continue;
+		}
+		if(payloadStream != nullptr && !ws->connection->send(payloadStream)) {
+			// Frame header is queued but can't be completed, so the connection is no longer usable
+			debug_e("[WS] Broadcast payload not queued, closing connection");
+			ws->close();
+			--i; // close() removes the connection from the list
+			continue;
+		}
+		if(!ws->connection->isCorked()) {
+			ws->connection->commit();
+		}
 	}
 }
 
@@ -313,6 +615,8 @@ void WebsocketConnection::close()
 		}
 	}
 
+	releaseMessageBuffer();
+
 	if(connection) {
 		connection->setTimeOut(1);
 		connection = nullptr;
@@ -322,6 +626,12 @@ void WebsocketConnection::close()
 void WebsocketConnection::reset()
 {
 	ws_parser_init(&parser);
+	releaseMessageBuffer();
+	if(inflater) {
+		inflater->clear();
+	}
+	messageCompressed = false;
+	frameScan = {};
 
 	activated = false;
 }
@@ -12,6 +12,8 @@
 
 #include "Network/TcpServer.h"
 #include "../HttpConnection.h"
+#include "WsDeflate.h"
+#include <ObjectPool.h>
 
 extern "C" {
 #include "ws_parser/ws_parser.h"
@@ -25,6 +27,13 @@ extern "C" {
 
 #define WEBSOCKET_VERSION 13 // 1.3
 
+#ifndef WEBSOCKET_BROADCAST_LIMIT
+/**
+ * @brief Default limit on data queued for a connection before broadcasts to it are dropped
+ */
+#define WEBSOCKET_BROADCAST_LIMIT 4096
+#endif
+
 DECLARE_FSTR(WSSTR_CONNECTION)
 DECLARE_FSTR(WSSTR_UPGRADE)
 DECLARE_FSTR(WSSTR_WEBSOCKET)
@@ -36,6 +45,7 @@ DECLARE_FSTR(WSSTR_VERSION)
 DECLARE_FSTR(WSSTR_SECRET)
 
 class WebsocketConnection;
+class EventPayload;
 
 using WebsocketList = Vector<WebsocketConnection*>;
 
@@ -43,6 +53,45 @@ using WebsocketDelegate = Delegate<void(WebsocketConnection&)>;
 using WebsocketMessageDelegate = Delegate<void(WebsocketConnection&, const String&)>;
 using WebsocketBinaryDelegate = Delegate<void(WebsocketConnection&, uint8_t* data, size_t size)>;
 
+/**
+ * @brief Handler for received message data, text or binary, without copying
+ * @param type WS_FRAME_TEXT or WS_FRAME_BINARY
+ * @param data Message content, valid only during the callback. Text is not NUL-terminated.
+ * @param size Number of bytes
+ */
+using WebsocketDataDelegate =
+	Delegate<void(WebsocketConnection&, ws_frame_type_t type, const char* data, size_t size)>;
+
+/**
+ * @brief Stage of message reception reported to a stream handler
+ */
+enum class WsStreamEvent {
+	begin, ///< Start of a new message
+	data,  ///< Part of the message payload
+	end,   ///< Message complete
+};
+
+/**
+ * @brief Part of a received message passed to a stream handler
+ *
+ * A message may be sent as several frames, and each frame may arrive in several TCP segments.
+ * The handler sees a single `begin` event, one `data` event per segment of payload, then an `end` event.
+ */
+struct WsStreamChunk {
+	WsStreamEvent event;
+	ws_frame_type_t type; ///< WS_FRAME_TEXT or WS_FRAME_BINARY
+	const char* data;	 ///< Unmasked payload, valid only during the callback. nullptr for begin and end events.
+	size_t length;		  ///< Number of bytes in data
+	size_t offset;		  ///< Position of data within the message. For `end`, this is the total message length.
+	bool fin;			  ///< Set for the `end` event, when the final frame of the message has been received
+};
+
+/**
+ * @brief Handler for streamed message reception
+ * @retval bool Return false to abort the connection
+ */
+using WebsocketStreamDelegate = Delegate<bool(WebsocketConnection&, const WsStreamChunk& chunk)>;
+
 /**
  * @brief Current state of Websocket connection
  */
@@ -123,6 +172,7 @@ public:
 	 * @param message
 	 * @param length
 	 * @param type
+	 * @note The frame is built once and its buffer shared between all server connections.
 	 */
 	static void broadcast(const char* message, size_t length, ws_frame_type_t type = WS_FRAME_TEXT);
 
@@ -136,6 +186,32 @@ public:
 		broadcast(message.c_str(), message.length(), type);
 	}
 
+	/**
+	 * @brief Broadcasts shared content to all active websocket connections
+	 * @param payload
+	 * @param type
+	 * @note Server connections send the payload buffer directly, without copying it into a frame.
+	 */
+	static void broadcast(const EventPayload& payload, ws_frame_type_t type = WS_FRAME_TEXT);
+
+	/**
+	 * @brief Set limit on data queued for a connection before broadcasts to it are dropped
+	 * @param limit Number of bytes, 0 for no limit
+	 * @note A message is always queued for a connection with nothing pending, however large.
+	 */
+	static void setBroadcastLimit(size_t limit)
+	{
+		broadcastLimit = limit;
+	}
+
+	/**
+	 * @brief Get number of broadcast messages dropped for this connection because it was too slow
+	 */
+	unsigned getBroadcastDropCount() const
+	{
+		return broadcastDrops;
+	}
+
 	/**
 	 * @brief Sends a string websocket message
 	 * @param message
@@ -155,6 +231,30 @@ public:
 		return send(reinterpret_cast<const char*>(data), length, WS_FRAME_BINARY);
 	}
 
+	/**
+	 * @brief Combine subsequent messages into as few TCP segments as possible
+	 *
+	 * Messages are normally sent as soon as they're queued.
+	 * Call `uncork()` after the last message to send them.
+	 */
+	void cork()
+	{
+		if(connection != nullptr) {
+			connection->cork();
+		}
+	}
+
+	/**
+	 * @brief Send messages queued since `cork()`
+	 */
+	void uncork()
+	{
+		if(connection != nullptr) {
+			connection->uncork();
+			connection->commit();
+		}
+	}
+
 	/**
 	 * @brief Closes a websocket connection (without closing the underlying http connection)
 	 */
@@ -228,6 +328,62 @@ public:
 	{
 		wsBinary = handler;
 	}
+	/**
+	 * @brief Sets the callback handler to receive text and binary messages as raw data
+	 * @param handler
+	 * @note When set, this is used in place of the message and binary handlers.
+	 * Text is passed without copying it into a String.
+	 */
+	void setDataHandler(WebsocketDataDelegate handler)
+	{
+		wsData = handler;
+	}
+
+	/**
+	 * @brief Sets the callback handler to be called for each part of a message as it is received
+	 * @param handler
+	 *
+	 * Allows large messages to be processed without buffering. Payload data is passed directly from the
+	 * TCP receive buffer. Other handlers are still called as normal.
+	 */
+	void setStreamHandler(WebsocketStreamDelegate handler)
+	{
+		wsStream = handler;
+	}
+
+	/**
+	 * @brief Reassemble messages before passing them to the message, binary or data handler
+	 * @param pool Buffers are allocated from this pool, and its object size limits the size of a message.
+	 * Messages which are too large are discarded. Specify nullptr to disable reassembly.
+	 *
+	 * Without reassembly, handlers are called for each part of a message as it arrives.
+	 * Reassembly ensures each handler call corresponds to one complete message, however it has been
+	 * fragmented into frames or TCP segments.
+	 */
+	void setReassemblyPool(ObjectPool::Pool* pool)
+	{
+		releaseMessageBuffer();
+		reassemblyPool = pool;
+	}
+
+	/**
+	 * @brief Offer or accept the permessage-deflate extension when the connection is established
+	 * @param config Preferences for negotiation, or nullptr to disable compression
+	 * @note Takes effect for the next connection
+	 */
+	void setDeflateConfig(const WsDeflateConfig* config)
+	{
+		deflateConfig.reset(config ? new WsDeflateConfig(*config) : nullptr);
+	}
+
+	/**
+	 * @brief Determine whether permessage-deflate is in use on this connection
+	 */
+	bool isDeflateEnabled() const
+	{
+		return bool(deflater);
+	}
+
 	/**
 	 * @brief Sets the callback handler to be called when pong reply received
 	 * @param handler
@@ -302,10 +458,58 @@ protected:
 	 */
 	bool processFrame(TcpClient& client, char* at, int size);
 
+	/** @brief Maximum size of a frame header: 2 bytes + 8 bytes extended length + 4 bytes mask key
+	 */
+	static constexpr size_t maxFrameHeaderLength{14};
+
+	/** @brief Build a frame header
+	 *  @param packet Buffer of at least maxFrameHeaderLength bytes
+	 *  @param payloadLength
+	 *  @param type
+	 *  @param maskKey 4-byte mask key, or nullptr if frame is not masked
+	 *  @param isFin true if this is the final frame
+	 *  @param compressed Set RSV1 to indicate first frame of a compressed message
+	 *  @retval size_t Number of bytes written to packet
+	 */
+	static size_t encodeFrameHeader(uint8_t* packet, size_t payloadLength, ws_frame_type_t type,
+									const uint8_t* maskKey, bool isFin, bool compressed = false);
+
+	bool sendFrame(IDataSourceStream* source, ws_frame_type_t type, bool useMask, bool isFin, bool compressed);
+
+	/** @brief Create compressor and decompressor using negotiated settings
+	 */
+	bool startDeflate(const WsDeflateConfig& agreed);
+
+	void stopDeflate();
+
+	/** @brief Track frame headers ahead of ws_parser to pick up and clear the RSV1 (compressed) bit
+	 *  @retval bool false if too many messages are queued
+	 */
+	bool scanFrameHeaders(char* at, size_t size);
+
+	/** @brief Process received payload data, or decompressed output
+	 */
+	int processPayload(const char* data, size_t length);
+
+	/** @brief Pass message data to the data, message or binary handler
+	 */
+	void deliverMessage(const char* data, size_t length);
+
+	void releaseMessageBuffer();
+
+	int notifyStream(WsStreamEvent event, const char* data, size_t length);
+
+	/**
+	 * @brief Check whether a broadcast frame can be queued, counting it as dropped if not
+	 */
+	bool canBroadcast(size_t frameLength);
+
 protected:
 	WebsocketDelegate wsConnect = nullptr;
 	WebsocketMessageDelegate wsMessage = nullptr;
 	WebsocketBinaryDelegate wsBinary = nullptr;
+	WebsocketDataDelegate wsData = nullptr;
+	WebsocketStreamDelegate wsStream = nullptr;
 	WebsocketDelegate wsPong = nullptr;
 	WebsocketDelegate wsDisconnect = nullptr;
 
@@ -313,14 +517,42 @@ protected:
 
 	WsConnectionState state = eWSCS_Ready;
 
+	std::unique_ptr<WsDeflateConfig> deflateConfig; ///< Preferences for negotiation
+
 private:
 	ws_frame_type_t frameType = WS_FRAME_TEXT;
 	WsFrameInfo controlFrame;
 
+	ObjectPool::Pool* reassemblyPool = nullptr;
+	char* messageBuffer = nullptr; ///< Reassembly buffer from pool
+	size_t messageLength = 0;	  ///< Bytes received so far in current message
+	bool messageOverflow = false;  ///< Current message too large for reassembly buffer
+	bool messageCompressed = false;
+
+	std::unique_ptr<WsDeflater> deflater;
+	std::unique_ptr<WsInflater> inflater;
+	uint16_t compressThreshold = 0;
+
+	/*
+	 * The parser doesn't support extensions, so frame headers are tracked here.
+	 * RSV1 for each new message is queued until the parser reports the start of that message.
+	 */
+	struct FrameScan {
+		uint64_t payloadRemaining; ///< Payload bytes to skip before next header
+		uint8_t headerPos;		   ///< Position within frame header, 0 at start of frame
+		uint8_t headerLength;
+		uint8_t lengthBytes; ///< Size of extended payload length field
+		uint8_t flagCount;   ///< Number of bits in flags
+		uint32_t flags;		 ///< RSV1 for each message started but not yet seen by parser
+	};
+	FrameScan frameScan{};
+
 	ws_parser_t parser;
 	static const ws_parser_callbacks_t parserSettings;
 
 	static WebsocketList websocketList;
+	static size_t broadcastLimit;
+	unsigned broadcastDrops = 0;
 
 	bool isClientConnection = true;
 
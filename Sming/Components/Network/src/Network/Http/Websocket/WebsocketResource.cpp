@@ -22,6 +22,10 @@ int WebsocketResource::checkHeaders(HttpServerConnection& connection, HttpReques
 
 	socket->setBinaryHandler(wsBinary);
 	socket->setMessageHandler(wsMessage);
+	socket->setDataHandler(wsData);
+	socket->setStreamHandler(wsStream);
+	socket->setReassemblyPool(reassemblyPool);
+	socket->setDeflateConfig(deflateConfig);
 	socket->setConnectionHandler(wsConnect);
 	socket->setPongHandler(wsPong);
 	socket->setDisconnectionHandler(wsDisconnect);
@@ -48,6 +48,34 @@ public:
 		wsBinary = handler;
 	}
 
+	void setDataHandler(WebsocketDataDelegate handler)
+	{
+		wsData = handler;
+	}
+
+	void setStreamHandler(WebsocketStreamDelegate handler)
+	{
+		wsStream = handler;
+	}
+
+	/**
+	 * @brief Set pool for reassembly of messages on all connections
+	 * @see See `WebsocketConnection::setReassemblyPool()`
+	 */
+	void setReassemblyPool(ObjectPool::Pool* pool)
+	{
+		reassemblyPool = pool;
+	}
+
+	/**
+	 * @brief Accept permessage-deflate compression from clients which offer it
+	 * @param config Must remain valid while resource is in use. Specify nullptr to disable compression.
+	 */
+	void setDeflateConfig(const WsDeflateConfig* config)
+	{
+		deflateConfig = config;
+	}
+
 	void setPongHandler(WebsocketDelegate handler)
 	{
 		wsPong = handler;
@@ -65,6 +93,10 @@ protected:
 	WebsocketDelegate wsConnect = nullptr;
 	WebsocketMessageDelegate wsMessage = nullptr;
 	WebsocketBinaryDelegate wsBinary = nullptr;
+	WebsocketDataDelegate wsData = nullptr;
+	WebsocketStreamDelegate wsStream = nullptr;
 	WebsocketDelegate wsPong = nullptr;
 	WebsocketDelegate wsDisconnect = nullptr;
+	ObjectPool::Pool* reassemblyPool = nullptr;
+	const WsDeflateConfig* deflateConfig = nullptr;
 };
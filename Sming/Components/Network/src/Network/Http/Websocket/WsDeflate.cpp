@@ -0,0 +1,796 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/SmingHub/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * WsDeflate.cpp
+ *
+ * Decoder structure follows tinf by Joergen Ibsen.
+ *
+ ****/
+
+#include "WsDeflate.h"
+#include <stringutil.h>
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+
+namespace
+{
+constexpr uint8_t hashBits{9};
+constexpr unsigned hashSize{1U << hashBits};
+constexpr unsigned minMatch{3};
+constexpr unsigned maxMatch{258};
+
+const uint16_t lengthBase[29] = {3,  4,  5,  6,  7,  8,  9,  10, 11,  13,  15,  17,  19,  23, 27,
+								 31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258};
+const uint8_t lengthExtra[29] = {0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0};
+const uint16_t distBase[30] = {1,	2,	3,	4,	5,	7,	 9,	13,	17,	25,	33,	49,	65,	97,	129,
+							   193, 257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577};
+const uint8_t distExtra[30] = {0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13};
+
+// Order in which code length code lengths are stored
+const uint8_t codeLengthIndex[19] = {16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15};
+
+unsigned hash(const uint8_t* p)
+{
+	uint32_t v = (p[0] << 16) | (p[1] << 8) | p[2];
+	return (v * 2654435761U) >> (32 - hashBits);
+}
+
+/*
+ * Extension negotiation
+ */
+
+struct Params {
+	uint8_t serverMaxWindowBits{WsDeflateConfig::maxWindowBits};
+	uint8_t clientMaxWindowBits{WsDeflateConfig::maxWindowBits};
+	bool hasServerMaxWindowBits{false};
+	bool hasClientMaxWindowBits{false};
+	bool serverNoContextTakeover{false};
+	bool clientNoContextTakeover{false};
+};
+
+DEFINE_FSTR_LOCAL(PERMESSAGE_DEFLATE, "permessage-deflate")
+DEFINE_FSTR_LOCAL(SERVER_NO_CONTEXT_TAKEOVER, "server_no_context_takeover")
+DEFINE_FSTR_LOCAL(CLIENT_NO_CONTEXT_TAKEOVER, "client_no_context_takeover")
+DEFINE_FSTR_LOCAL(SERVER_MAX_WINDOW_BITS, "server_max_window_bits")
+DEFINE_FSTR_LOCAL(CLIENT_MAX_WINDOW_BITS, "client_max_window_bits")
+
+bool parseWindowBits(String value, uint8_t& bits)
+{
+	value.trim();
+	auto len = value.length();
+	if(len >= 2 && value[0] == '"' && value[len - 1] == '"') {
+		value = value.substring(1, len - 1);
+		len -= 2;
+	}
+	if(len == 0 || len > 2 || !isdigit(value[0]) || (len == 2 && !isdigit(value[1]))) {
+		return false;
+	}
+	auto n = value.toInt();
+	if(n < WsDeflateConfig::minWindowBits || n > WsDeflateConfig::maxWindowBits) {
+		return false;
+	}
+	bits = n;
+	return true;
+}
+
+/*
+ * Parse one extension element, e.g. "permessage-deflate; client_max_window_bits=10".
+ * Fails for other extensions, unknown parameters and duplicates.
+ */
+bool parseElement(const String& element, Params& params)
+{
+	bool first = true;
+	int start = 0;
+	for(;;) {
+		int end = element.indexOf(';', start);
+		String item = element.substring(start, (end < 0) ? element.length() : end);
+		item.trim();
+		if(first) {
+			if(!item.equalsIgnoreCase(PERMESSAGE_DEFLATE)) {
+				return false;
+			}
+			first = false;
+		} else {
+			String value;
+			int eq = item.indexOf('=');
+			bool hasValue = (eq >= 0);
+			if(hasValue) {
+				value = item.substring(eq + 1);
+				item.setLength(eq);
+				item.trim();
+			}
+
+			if(item.equalsIgnoreCase(SERVER_NO_CONTEXT_TAKEOVER)) {
+				if(hasValue || params.serverNoContextTakeover) {
+					return false;
+				}
+				params.serverNoContextTakeover = true;
+			} else if(item.equalsIgnoreCase(CLIENT_NO_CONTEXT_TAKEOVER)) {
+				if(hasValue || params.clientNoContextTakeover) {
+					return false;
+				}
+				params.clientNoContextTakeover = true;
+			} else if(item.equalsIgnoreCase(SERVER_MAX_WINDOW_BITS)) {
+				if(!hasValue || params.hasServerMaxWindowBits ||
+				   !parseWindowBits(value, params.serverMaxWindowBits)) {
+					return false;
+				}
+				params.hasServerMaxWindowBits = true;
+			} else if(item.equalsIgnoreCase(CLIENT_MAX_WINDOW_BITS)) {
+				// Value is optional in an offer
+				if(params.hasClientMaxWindowBits || (hasValue && !parseWindowBits(value, params.clientMaxWindowBits))) {
+					return false;
+				}
+				params.hasClientMaxWindowBits = true;
+			} else {
+				return false;
+			}
+		}
+
+		if(end < 0) {
+			return true;
+		}
+		start = end + 1;
+	}
+}
+
+void appendParam(String& s, const FlashString& name)
+{
+	s += "; ";
+	s += name;
+}
+
+void appendParam(String& s, const FlashString& name, uint8_t value)
+{
+	appendParam(s, name);
+	s += '=';
+	s += unsigned(value);
+}
+
+} // namespace
+
+namespace WsDeflate
+{
+String makeOffer(const WsDeflateConfig& config)
+{
+	String s = PERMESSAGE_DEFLATE;
+	appendParam(s, CLIENT_MAX_WINDOW_BITS, config.txWindowBits);
+	if(config.rxWindowBits < WsDeflateConfig::maxWindowBits) {
+		appendParam(s, SERVER_MAX_WINDOW_BITS, config.rxWindowBits);
+	}
+	if(config.txNoContextTakeover) {
+		appendParam(s, CLIENT_NO_CONTEXT_TAKEOVER);
+	}
+	if(config.rxNoContextTakeover) {
+		appendParam(s, SERVER_NO_CONTEXT_TAKEOVER);
+	}
+	return s;
+}
+
+bool acceptOffer(const String& offers, const WsDeflateConfig& config, WsDeflateConfig& agreed, String& response)
+{
+	int start = 0;
+	for(;;) {
+		int end = offers.indexOf(',', start);
+		Params params;
+		if(parseElement(offers.substring(start, (end < 0) ? offers.length() : end), params)) {
+			// Client will use a full-size window unless it tells us otherwise
+			uint8_t rxBits = WsDeflateConfig::maxWindowBits;
+			if(params.hasClientMaxWindowBits) {
+				rxBits = std::min(config.rxWindowBits, params.clientMaxWindowBits);
+			}
+			if(rxBits <= config.rxWindowBits) {
+				agreed = config;
+				agreed.rxWindowBits = rxBits;
+				agreed.txWindowBits = std::min(config.txWindowBits, params.serverMaxWindowBits);
+				agreed.txNoContextTakeover = config.txNoContextTakeover || params.serverNoContextTakeover;
+				agreed.rxNoContextTakeover = config.rxNoContextTakeover || params.clientNoContextTakeover;
+
+				response = PERMESSAGE_DEFLATE;
+				if(agreed.txNoContextTakeover) {
+					appendParam(response, SERVER_NO_CONTEXT_TAKEOVER);
+				}
+				if(agreed.rxNoContextTakeover) {
+					appendParam(response, CLIENT_NO_CONTEXT_TAKEOVER);
+				}
+				if(agreed.txWindowBits < WsDeflateConfig::maxWindowBits) {
+					appendParam(response, SERVER_MAX_WINDOW_BITS, agreed.txWindowBits);
+				}
+				if(params.hasClientMaxWindowBits) {
+					appendParam(response, CLIENT_MAX_WINDOW_BITS, agreed.rxWindowBits);
+				}
+				return true;
+			}
+		}
+
+		if(end < 0) {
+			return false;
+		}
+		start = end + 1;
+	}
+}
+
+bool parseResponse(const String& response, const WsDeflateConfig& config, WsDeflateConfig& agreed)
+{
+	Params params;
+	if(response.indexOf(',') >= 0 || !parseElement(response, params)) {
+		return false;
+	}
+
+	// Server must honour our window limit and context takeover request
+	if(params.serverMaxWindowBits > config.rxWindowBits) {
+		return false;
+	}
+	if(config.rxNoContextTakeover && !params.serverNoContextTakeover) {
+		return false;
+	}
+
+	agreed = config;
+	agreed.rxWindowBits = params.serverMaxWindowBits;
+	agreed.rxNoContextTakeover = params.serverNoContextTakeover;
+	agreed.txWindowBits = std::min(config.txWindowBits, params.clientMaxWindowBits);
+	agreed.txNoContextTakeover = config.txNoContextTakeover || params.clientNoContextTakeover;
+	return true;
+}
+
+} // namespace WsDeflate
+
+/*
+ * WsDeflater
+ */
+
+WsDeflater::WsDeflater(uint8_t windowBits, bool noContextTakeover)
+	: windowBits(windowBits), noContextTakeover(noContextTakeover)
+{
+}
+
+bool WsDeflater::compress(const void* data, size_t length, ReadWriteStream& output)
+{
+	const size_t windowSize = 1U << windowBits;
+	if(!buffer) {
+		buffer.reset(new uint8_t[windowSize * 2]);
+		head.reset(new uint16_t[hashSize]);
+		if(!buffer || !head) {
+			buffer.reset();
+			head.reset();
+			return false;
+		}
+		std::fill_n(head.get(), hashSize, 0);
+	}
+
+	this->output = &output;
+	outputFull = false;
+
+	// Single block using fixed Huffman codes: BFINAL=0, BTYPE=01
+	putBits(0x02, 3);
+
+	auto src = static_cast<const uint8_t*>(data);
+	while(length != 0) {
+		auto blockLength = std::min(length, windowSize);
+		if(historyLength + blockLength > windowSize * 2) {
+			// Keep only as much history as the window can reference
+			auto shift = historyLength - windowSize;
+			memmove(&buffer[0], &buffer[shift], windowSize);
+			historyLength = windowSize;
+			for(unsigned i = 0; i < hashSize; ++i) {
+				head[i] = (head[i] > shift) ? head[i] - shift : 0;
+			}
+		}
+		memcpy(&buffer[historyLength], src, blockLength);
+		processBlock(historyLength, historyLength + blockLength);
+		historyLength += blockLength;
+		src += blockLength;
+		length -= blockLength;
+	}
+
+	// End of block
+	putCode(0, 7);
+
+	// Empty stored block for sync flush. LEN/NLEN (00 00 ff ff) are omitted as required by RFC 7692.
+	putBits(0, 3);
+	flushBits();
+	flushOutput();
+
+	// Peer won't see an incomplete message so history must not be referenced
+	if(noContextTakeover || outputFull) {
+		historyLength = 0;
+	}
+
+	return !outputFull;
+}
+
+void WsDeflater::processBlock(size_t start, size_t end)
+{
+	const size_t windowSize = 1U << windowBits;
+	auto pos = start;
+	while(pos < end) {
+		unsigned matchLength = 0;
+		unsigned distance = 0;
+		if(end - pos >= minMatch) {
+			auto& entry = head[hash(&buffer[pos])];
+			size_t candidate = entry;
+			entry = pos;
+			// Stale entries are rejected by comparing data
+			if(candidate < pos && pos - candidate <= windowSize) {
+				auto maxLength = std::min(end - pos, size_t(maxMatch));
+				auto a = &buffer[candidate];
+				auto b = &buffer[pos];
+				unsigned len = 0;
+				while(len < maxLength && a[len] == b[len]) {
+					++len;
+				}
+				if(len >= minMatch) {
+					matchLength = len;
+					distance = pos - candidate;
+				}
+			}
+		}
+
+		if(matchLength == 0) {
+			putLiteral(buffer[pos++]);
+			continue;
+		}
+
+		putMatch(matchLength, distance);
+		auto matchEnd = pos + matchLength;
+		for(++pos; pos < matchEnd; ++pos) {
+			if(end - pos >= minMatch) {
+				head[hash(&buffer[pos])] = pos;
+			}
+		}
+	}
+}
+
+void WsDeflater::putBits(uint32_t value, uint8_t count)
+{
+	bitBuffer |= value << bitCount;
+	bitCount += count;
+	while(bitCount >= 8) {
+		outBuffer[outLength++] = bitBuffer;
+		bitBuffer >>= 8;
+		bitCount -= 8;
+		if(outLength == sizeof(outBuffer)) {
+			flushOutput();
+		}
+	}
+}
+
+void WsDeflater::putCode(uint16_t code, uint8_t length)
+{
+	// Huffman codes are packed starting with the most-significant bit
+	uint16_t value = 0;
+	for(unsigned i = 0; i < length; ++i) {
+		value = (value << 1) | (code & 1);
+		code >>= 1;
+	}
+	putBits(value, length);
+}
+
+void WsDeflater::putLiteral(uint8_t c)
+{
+	if(c < 144) {
+		putCode(0x30 + c, 8);
+	} else {
+		putCode(0x190 + c - 144, 9);
+	}
+}
+
+void WsDeflater::putMatch(unsigned length, unsigned distance)
+{
+	unsigned i = ARRAY_SIZE(lengthBase) - 1;
+	while(lengthBase[i] > length) {
+		--i;
+	}
+	auto symbol = 257 + i;
+	if(symbol < 280) {
+		putCode(symbol - 256, 7);
+	} else {
+		putCode(0xc0 + symbol - 280, 8);
+	}
+	putBits(length - lengthBase[i], lengthExtra[i]);
+
+	i = ARRAY_SIZE(distBase) - 1;
+	while(distBase[i] > distance) {
+		--i;
+	}
+	putCode(i, 5);
+	putBits(distance - distBase[i], distExtra[i]);
+}
+
+void WsDeflater::flushBits()
+{
+	if(bitCount != 0) {
+		putBits(0, 8 - bitCount);
+	}
+}
+
+void WsDeflater::flushOutput()
+{
+	if(outLength == 0) {
+		return;
+	}
+	if(output->write(outBuffer, outLength) != outLength) {
+		outputFull = true;
+	}
+	outLength = 0;
+}
+
+/*
+ * WsInflater
+ */
+
+struct WsInflater::Tree {
+	uint16_t counts[16];   ///< Number of codes of each length
+	uint16_t symbols[288]; ///< Symbols ordered by code
+};
+
+namespace
+{
+template <class Tree> void buildTree(Tree& tree, const uint8_t* lengths, unsigned count)
+{
+	std::fill_n(tree.counts, ARRAY_SIZE(tree.counts), 0);
+	for(unsigned i = 0; i < count; ++i) {
+		++tree.counts[lengths[i]];
+	}
+	tree.counts[0] = 0;
+
+	uint16_t offsets[16];
+	unsigned sum = 0;
+	for(unsigned i = 0; i < 16; ++i) {
+		offsets[i] = sum;
+		sum += tree.counts[i];
+	}
+
+	for(unsigned i = 0; i < count; ++i) {
+		if(lengths[i] != 0) {
+			tree.symbols[offsets[lengths[i]]++] = i;
+		}
+	}
+}
+
+template <class Tree> void buildFixedTrees(Tree& lt, Tree& dt)
+{
+	std::fill_n(lt.counts, ARRAY_SIZE(lt.counts), 0);
+	lt.counts[7] = 24;
+	lt.counts[8] = 152;
+	lt.counts[9] = 112;
+	unsigned n = 0;
+	for(unsigned i = 0; i < 24; ++i) {
+		lt.symbols[n++] = 256 + i;
+	}
+	for(unsigned i = 0; i < 144; ++i) {
+		lt.symbols[n++] = i;
+	}
+	for(unsigned i = 0; i < 8; ++i) {
+		lt.symbols[n++] = 280 + i;
+	}
+	for(unsigned i = 0; i < 112; ++i) {
+		lt.symbols[n++] = 144 + i;
+	}
+
+	std::fill_n(dt.counts, ARRAY_SIZE(dt.counts), 0);
+	dt.counts[5] = 30;
+	for(unsigned i = 0; i < 30; ++i) {
+		dt.symbols[i] = i;
+	}
+}
+
+} // namespace
+
+WsInflater::WsInflater(uint8_t windowBits, bool noContextTakeover, size_t maxCompressedSize)
+	: maxCompressedSize(maxCompressedSize), windowBits(windowBits), noContextTakeover(noContextTakeover)
+{
+}
+
+WsInflater::~WsInflater()
+{
+	clear();
+	delete[] trees;
+}
+
+void WsInflater::clear()
+{
+	free(input);
+	input = nullptr;
+	inputLength = 0;
+}
+
+bool WsInflater::write(const char* data, size_t length)
+{
+	if(inputLength + length > maxCompressedSize) {
+		return false;
+	}
+
+	// Leave room for the sync flush trailer
+	auto buf = static_cast<char*>(realloc(input, inputLength + length + 4));
+	if(buf == nullptr) {
+		return false;
+	}
+	input = buf;
+	memcpy(&input[inputLength], data, length);
+	inputLength += length;
+	return true;
+}
+
+bool WsInflater::finish(OutputDelegate output)
+{
+	if(!window) {
+		window.reset(new uint8_t[1U << windowBits]);
+	}
+	if(trees == nullptr) {
+		trees = new Tree[2];
+	}
+	if(input == nullptr) {
+		input = static_cast<char*>(malloc(4));
+	}
+	if(!window || trees == nullptr || input == nullptr) {
+		clear();
+		return false;
+	}
+
+	// Restore the trailer removed by the sender, space for which is reserved by write()
+	const uint8_t trailer[]{0x00, 0x00, 0xff, 0xff};
+	memcpy(&input[inputLength], trailer, sizeof(trailer));
+	inputLength += sizeof(trailer);
+
+	this->output = output;
+	bool ok = inflate() && flush();
+	pending = 0;
+	clear();
+
+	if(noContextTakeover || !ok) {
+		windowValid = 0;
+	}
+
+	return ok;
+}
+
+bool WsInflater::inflate()
+{
+	inputPos = 0;
+	bitTag = 0;
+	bitCount = 0;
+	inputError = false;
+
+	bool final = false;
+	while(!final && inputPos < inputLength) {
+		final = getBit();
+		bool ok;
+		switch(getBits(2)) {
+		case 0:
+			ok = inflateStored();
+			break;
+		case 1:
+			buildFixedTrees(trees[0], trees[1]);
+			ok = inflateBlock(trees[0], trees[1]);
+			break;
+		case 2:
+			ok = decodeTrees(trees[0], trees[1]) && inflateBlock(trees[0], trees[1]);
+			break;
+		default:
+			ok = false;
+		}
+		if(!ok || inputError) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+bool WsInflater::inflateStored()
+{
+	// Discard remaining bits in current byte
+	bitTag = 0;
+	bitCount = 0;
+
+	if(inputLength - inputPos < 4) {
+		return false;
+	}
+	auto p = reinterpret_cast<const uint8_t*>(&input[inputPos]);
+	unsigned length = p[0] | (p[1] << 8);
+	unsigned invLength = p[2] | (p[3] << 8);
+	inputPos += 4;
+	if(length != (~invLength & 0xffff) || inputLength - inputPos < length) {
+		return false;
+	}
+
+	while(length-- != 0) {
+		if(!putByte(input[inputPos++])) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+bool WsInflater::inflateBlock(const Tree& lt, const Tree& dt)
+{
+	const size_t windowMask = (1U << windowBits) - 1;
+	for(;;) {
+		int symbol = decodeSymbol(lt);
+		if(symbol < 0) {
+			return false;
+		}
+		if(symbol < 256) {
+			if(!putByte(symbol)) {
+				return false;
+			}
+			continue;
+		}
+		if(symbol == 256) {
+			return true;
+		}
+
+		symbol -= 257;
+		if(symbol >= int(ARRAY_SIZE(lengthBase))) {
+			return false;
+		}
+		unsigned length = lengthBase[symbol] + getBits(lengthExtra[symbol]);
+
+		int distSymbol = decodeSymbol(dt);
+		if(distSymbol < 0 || distSymbol >= int(ARRAY_SIZE(distBase))) {
+			return false;
+		}
+		unsigned distance = distBase[distSymbol] + getBits(distExtra[distSymbol]);
+		if(inputError || distance > windowValid) {
+			return false;
+		}
+
+		while(length-- != 0) {
+			if(!putByte(window[(windowPos - distance) & windowMask])) {
+				return false;
+			}
+		}
+	}
+}
+
+bool WsInflater::decodeTrees(Tree& lt, Tree& dt)
+{
+	uint8_t lengths[288 + 32];
+
+	unsigned hlit = getBits(5) + 257;
+	unsigned hdist = getBits(5) + 1;
+	unsigned hclen = getBits(4) + 4;
+	if(hlit > 286 || hdist > 30) {
+		return false;
+	}
+
+	std::fill_n(lengths, 19, 0);
+	for(unsigned i = 0; i < hclen; ++i) {
+		lengths[codeLengthIndex[i]] = getBits(3);
+	}
+
+	// Use literal tree temporarily for code lengths
+	buildTree(lt, lengths, 19);
+
+	for(unsigned num = 0; num < hlit + hdist;) {
+		int symbol = decodeSymbol(lt);
+		if(symbol < 0) {
+			return false;
+		}
+
+		uint8_t value = 0;
+		unsigned count;
+		switch(symbol) {
+		case 16:
+			// Repeat previous length 3-6 times
+			if(num == 0) {
+				return false;
+			}
+			value = lengths[num - 1];
+			count = 3 + getBits(2);
+			break;
+		case 17:
+			// Repeat zero 3-10 times
+			count = 3 + getBits(3);
+			break;
+		case 18:
+			// Repeat zero 11-138 times
+			count = 11 + getBits(7);
+			break;
+		default:
+			value = symbol;
+			count = 1;
+		}
+
+		if(num + count > hlit + hdist) {
+			return false;
+		}
+		std::fill_n(&lengths[num], count, value);
+		num += count;
+	}
+
+	// Must be able to end the block
+	if(lengths[256] == 0) {
+		return false;
+	}
+
+	buildTree(lt, lengths, hlit);
+	buildTree(dt, &lengths[hlit], hdist);
+
+	return !inputError;
+}
+
+unsigned WsInflater::getBit()
+{
+	if(bitCount == 0) {
+		if(inputPos >= inputLength) {
+			inputError = true;
+			return 0;
+		}
+		bitTag = uint8_t(input[inputPos++]);
+		bitCount = 8;
+	}
+
+	unsigned bit = bitTag & 1;
+	bitTag >>= 1;
+	--bitCount;
+	return bit;
+}
+
+unsigned WsInflater::getBits(uint8_t count)
+{
+	unsigned value = 0;
+	for(unsigned i = 0; i < count; ++i) {
+		value |= getBit() << i;
+	}
+	return value;
+}
+
+int WsInflater::decodeSymbol(const Tree& tree)
+{
+	int sum = 0;
+	int cur = 0;
+	unsigned len = 0;
+
+	do {
+		cur = 2 * cur + getBit();
+		if(++len > 15 || inputError) {
+			return -1;
+		}
+		sum += tree.counts[len];
+		cur -= tree.counts[len];
+	} while(cur >= 0);
+
+	return tree.symbols[sum + cur];
+}
+
+bool WsInflater::putByte(uint8_t c)
+{
+	const size_t windowSize = 1U << windowBits;
+	if(pending == windowSize && !flush()) {
+		return false;
+	}
+
+	window[windowPos] = c;
+	windowPos = (windowPos + 1) & (windowSize - 1);
+	++pending;
+	if(windowValid < windowSize) {
+		++windowValid;
+	}
+	return true;
+}
+
+bool WsInflater::flush()
+{
+	if(pending == 0) {
+		return true;
+	}
+
+	const size_t windowSize = 1U << windowBits;
+	auto start = (windowPos - pending) & (windowSize - 1);
+	auto len1 = std::min(pending, windowSize - start);
+	auto len2 = pending - len1;
+	pending = 0;
+
+	auto data = reinterpret_cast<const char*>(window.get());
+	if(!output(&data[start], len1)) {
+		return false;
+	}
+	return len2 == 0 || output(data, len2);
+}
@@ -0,0 +1,181 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/SmingHub/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * WsDeflate.h - permessage-deflate extension (RFC 7692)
+ *
+ ****/
+
+#pragma once
+
+#include <WString.h>
+#include <Delegate.h>
+#include <Data/Stream/ReadWriteStream.h>
+#include <memory>
+
+/**
+ * @brief Settings for the permessage-deflate websocket extension
+ * @ingroup websocket
+ *
+ * The same structure holds the local preferences used during negotiation, and the agreed values.
+ * Window sizes are given as a power of 2, from 8 (256 bytes) to 15 (32 KBytes).
+ * Each side of a connection allocates a buffer of this size, so small windows are recommended.
+ */
+struct WsDeflateConfig {
+	uint8_t txWindowBits{9};		  ///< LZ77 window used for outgoing messages
+	uint8_t rxWindowBits{9};		  ///< Largest window the peer may use for messages it sends
+	bool txNoContextTakeover{false}; ///< Discard compressor history after each message
+	bool rxNoContextTakeover{false}; ///< Ask peer to discard its compressor history after each message
+	uint16_t threshold{64};			  ///< Messages shorter than this are sent uncompressed
+	uint16_t maxCompressedSize{4096}; ///< Longest compressed message accepted for decoding
+
+	static constexpr uint8_t minWindowBits{8};
+	static constexpr uint8_t maxWindowBits{15};
+};
+
+namespace WsDeflate
+{
+/**
+ * @brief Build a client extension offer
+ * @param config
+ * @retval String Value for the `Sec-WebSocket-Extensions` request header
+ */
+String makeOffer(const WsDeflateConfig& config);
+
+/**
+ * @brief Server: select a permessage-deflate offer and build the response
+ * @param offers Value of the `Sec-WebSocket-Extensions` request header
+ * @param config Server preferences
+ * @param agreed On success, the settings which apply to this connection
+ * @param response On success, the value for the `Sec-WebSocket-Extensions` response header
+ * @retval bool false if there's no acceptable offer, in which case compression isn't used
+ */
+bool acceptOffer(const String& offers, const WsDeflateConfig& config, WsDeflateConfig& agreed, String& response);
+
+/**
+ * @brief Client: check the server response against our offer
+ * @param response Value of the `Sec-WebSocket-Extensions` response header
+ * @param config Client preferences, as passed to `makeOffer()`
+ * @param agreed On success, the settings which apply to this connection
+ * @retval bool false if the response is invalid. The connection must then be failed.
+ */
+bool parseResponse(const String& response, const WsDeflateConfig& config, WsDeflateConfig& agreed);
+
+} // namespace WsDeflate
+
+/**
+ * @brief Compresses outgoing messages
+ *
+ * Uses LZ77 with a single-entry hash table and the fixed Huffman code.
+ * This gives most of the benefit for typical JSON or text payloads at a fraction of the RAM
+ * and CPU required by zlib.
+ */
+class WsDeflater
+{
+public:
+	/**
+	 * @param windowBits Size of history buffer
+	 * @param noContextTakeover Set to discard history after each message
+	 */
+	WsDeflater(uint8_t windowBits, bool noContextTakeover);
+
+	/**
+	 * @brief Compress a complete message
+	 * @param data
+	 * @param length
+	 * @param output Stream to receive the frame payload, with the trailing `00 00 ff ff` removed
+	 * @retval bool false if output stream is full
+	 */
+	bool compress(const void* data, size_t length, ReadWriteStream& output);
+
+private:
+	void processBlock(size_t start, size_t end);
+	void putBits(uint32_t value, uint8_t count);
+	void putCode(uint16_t code, uint8_t length);
+	void putLiteral(uint8_t c);
+	void putMatch(unsigned length, unsigned distance);
+	void flushBits();
+	void flushOutput();
+
+	std::unique_ptr<uint8_t[]> buffer; ///< History followed by input block, twice window size
+	std::unique_ptr<uint16_t[]> head;  ///< Most recent buffer position for each hash value
+	ReadWriteStream* output{nullptr};
+	size_t historyLength{0};
+	uint32_t bitBuffer{0};
+	uint8_t bitCount{0};
+	uint8_t windowBits;
+	bool noContextTakeover;
+	bool outputFull{false};
+	uint8_t outLength{0};
+	uint8_t outBuffer[64];
+};
+
+/**
+ * @brief Decompresses incoming messages
+ *
+ * Compressed data for a message is accumulated by `write()`, then decoded by `finish()`.
+ * Output is produced through the window buffer so no other buffering is required.
+ */
+class WsInflater
+{
+public:
+	/**
+	 * @brief Receives decompressed output
+	 * @param data
+	 * @param length
+	 * @retval bool Return false to abort decoding
+	 */
+	using OutputDelegate = Delegate<bool(const char* data, size_t length)>;
+
+	WsInflater(uint8_t windowBits, bool noContextTakeover, size_t maxCompressedSize);
+	~WsInflater();
+
+	/**
+	 * @brief Add compressed data for current message
+	 * @retval bool false if message exceeds maximum compressed size
+	 */
+	bool write(const char* data, size_t length);
+
+	/**
+	 * @brief Decompress message
+	 * @param output Called with blocks of decompressed data
+	 * @retval bool false if data is invalid, or decoding was aborted
+	 */
+	bool finish(OutputDelegate output);
+
+	/**
+	 * @brief Discard any buffered input
+	 */
+	void clear();
+
+private:
+	struct Tree;
+
+	bool inflate();
+	bool inflateStored();
+	bool inflateBlock(const Tree& lt, const Tree& dt);
+	bool decodeTrees(Tree& lt, Tree& dt);
+	unsigned getBit();
+	unsigned getBits(uint8_t count);
+	int decodeSymbol(const Tree& tree);
+	bool putByte(uint8_t c);
+	bool flush();
+
+	std::unique_ptr<uint8_t[]> window;
+	char* input{nullptr};
+	size_t inputLength{0};
+	size_t inputPos{0};
+	size_t maxCompressedSize;
+	OutputDelegate output;
+	Tree* trees{nullptr};
+	uint32_t bitTag{0};
+	uint8_t bitCount{0};
+	bool inputError{false};
+	uint8_t windowBits;
+	bool noContextTakeover;
+	size_t windowPos{0};   ///< Position of next output byte
+	size_t windowValid{0}; ///< Bytes of history available for back-references
+	size_t pending{0};	 ///< Bytes in window not yet passed to output
+};
@@ -12,38 +12,124 @@
 
 #include "HttpClient.h"
 #include "Data/Stream/FileStream.h"
+#include "Data/Stream/WriteBehindStream.h"
+#include <algorithm>
+
+#ifndef HTTP_DOWNLOAD_BLOCK_SIZE
+#define HTTP_DOWNLOAD_BLOCK_SIZE 1024
+#endif
+
+#ifndef HTTP_DOWNLOAD_BLOCK_COUNT
+#define HTTP_DOWNLOAD_BLOCK_COUNT 4
+#endif
 
 HttpClient::HttpConnectionPool HttpClient::httpConnectionPool;
 SimpleTimer HttpClient::cleanUpTimer;
+HttpClient::PoolConfig HttpClient::poolConfig;
+HttpClient::PoolStats HttpClient::poolStats;
 
 bool HttpClient::send(HttpRequest* request)
 {
-	String cacheKey = getCacheKey(request->uri);
-
-	HttpClientConnection* connection = nullptr;
+	auto connection = getConnection(getCacheKey(*request));
+	if(connection == nullptr) {
+		delete request;
+		return false;
+	}
 
-	int i = httpConnectionPool.indexOf(cacheKey);
-	if(i >= 0) {
-		// Check existing connection
-		connection = httpConnectionPool.valueAt(i);
+	if(!cleanUpTimer.isStarted()) {
+		unsigned interval = std::max(1U, std::min(60U, unsigned(poolConfig.idleTimeout)));
+		cleanUpTimer.initializeMs(interval * 1000, HttpClient::cleanInactive).start();
 	}
+	return connection->send(request);
+}
 
-	if(connection == nullptr) {
-		debug_d("Creating new HttpClientConnection");
-		connection = new HttpClientConnection();
+HttpClientConnection* HttpClient::getConnection(const String& cacheKey)
+{
+	// Prefer an idle connection, otherwise open another if permitted, else share the least busy
+	HttpClientConnection* leastBusy = nullptr;
+	String freeSlotKey;
+	for(unsigned slot = 0; slot < std::max(poolConfig.maxConnectionsPerHost, uint8_t(1)); ++slot) {
+		String key = cacheKey;
+		if(slot != 0) {
+			key += '#';
+			key += slot;
+		}
+		auto connection = httpConnectionPool.find(key);
 		if(connection == nullptr) {
-			debug_e("Cannot send request. Out of memory");
-			// Out of memory
-			delete request;
-			return false;
+			if(!freeSlotKey) {
+				freeSlotKey = key;
+			}
+			continue;
+		}
+		if(connection->isFinished()) {
+			leastBusy = connection;
+			break;
+		}
+		if(leastBusy == nullptr || connection->getPendingCount() < leastBusy->getPendingCount()) {
+			leastBusy = connection;
 		}
-		httpConnectionPool[cacheKey] = connection;
 	}
 
-	if(!cleanUpTimer.isStarted()) {
-		cleanUpTimer.initializeMs<60000>(HttpClient::cleanInactive).start(); // run every minute
+	if(leastBusy != nullptr && (leastBusy->isFinished() || !freeSlotKey)) {
+		if(leastBusy->isActive()) {
+			++poolStats.hits;
+		} else {
+			++poolStats.misses;
+		}
+		return leastBusy;
 	}
-	return connection->send(request);
+
+	if(freeSlotKey) {
+		if(httpConnectionPool.count() >= poolConfig.maxConnections) {
+			evictIdleConnection();
+		}
+		if(httpConnectionPool.count() < poolConfig.maxConnections &&
+		   system_get_free_heap_size() >= poolConfig.minFreeHeap) {
+			debug_d("Creating new HttpClientConnection");
+			auto connection = new HttpClientConnection();
+			if(connection != nullptr) {
+				httpConnectionPool[freeSlotKey] = connection;
+				++poolStats.misses;
+				return connection;
+			}
+		}
+	}
+
+	if(leastBusy != nullptr) {
+		// Cannot open another connection so queue on an existing one
+		++poolStats.hits;
+		return leastBusy;
+	}
+
+	debug_e("Cannot send request, no connection available (free heap %u)", system_get_free_heap_size());
+	++poolStats.rejected;
+	return nullptr;
+}
+
+bool HttpClient::evictIdleConnection()
+{
+	int oldest = -1;
+	uint32_t oldestIdleTime = 0;
+	for(unsigned i = 0; i < httpConnectionPool.count(); ++i) {
+		auto connection = httpConnectionPool.valueAt(i);
+		if(!connection->isFinished()) {
+			continue;
+		}
+		auto idleTime = connection->getIdleTime();
+		if(oldest < 0 || idleTime > oldestIdleTime) {
+			oldest = i;
+			oldestIdleTime = idleTime;
+		}
+	}
+
+	if(oldest < 0) {
+		return false;
+	}
+
+	debug_d("Evicting idle connection '%s'", httpConnectionPool.keyAt(oldest).c_str());
+	httpConnectionPool.removeAt(oldest);
+	++poolStats.evictions;
+	return true;
 }
 
 bool HttpClient::downloadFile(const Url& url, const String& saveFileName, RequestCompletedDelegate requestComplete)
@@ -60,21 +146,62 @@ bool HttpClient::downloadFile(const Url& url, const String& saveFileName, Reques
 		return false;
 	}
 
-	return send(
-		createRequest(url)->setResponseStream(fileStream)->setMethod(HTTP_GET)->onRequestComplete(requestComplete));
+	ReadWriteStream* stream = fileStream;
+	if(HTTP_DOWNLOAD_BLOCK_COUNT != 0) {
+		stream = new WriteBehindStream(fileStream, HTTP_DOWNLOAD_BLOCK_SIZE, HTTP_DOWNLOAD_BLOCK_COUNT);
+	}
+
+	auto request = createRequest(url)->setResponseStream(stream)->setMethod(HTTP_GET);
+	request->onHeadersComplete(checkDownloadLength);
+	return send(request->onRequestComplete(requestComplete));
+}
+
+int HttpClient::checkDownloadLength(HttpConnection& connection, HttpResponse& response)
+{
+	if(!response.isSuccess() || !response.headers.contains(HTTP_HEADER_CONTENT_LENGTH)) {
+		return 0;
+	}
+
+	auto length = response.headers[HTTP_HEADER_CONTENT_LENGTH].toInt();
+	if(length <= 0) {
+		return 0;
+	}
+
+	// Fail now rather than part way through if the file system doesn't have room
+	IFS::FileSystem::Info info;
+	if(fileGetSystemInfo(info) >= 0 && info.freeSpace != 0 && uint32_t(length) > info.freeSpace) {
+		debug_e("HttpClient: download of %ld bytes exceeds free space of %u", length, uint32_t(info.freeSpace));
+		return -1;
+	}
+
+	auto request = connection.getRequest();
+	auto stream = request ? request->getResponseStream() : nullptr;
+	if(stream != nullptr && stream->getStreamType() == eSST_Wrapper) {
+		static_cast<WriteBehindStream*>(stream)->setExpectedLength(length);
+	}
+
+	return 0;
 }
 
 void HttpClient::cleanInactive()
 {
 	debug_d("Total connections: %d", httpConnectionPool.count());
 
-	for(size_t i = 0; i < httpConnectionPool.count(); i++) {
+	const uint32_t idleTimeout = poolConfig.idleTimeout * 1000U;
+	unsigned i = 0;
+	while(i < httpConnectionPool.count()) {
 		auto connection = httpConnectionPool.valueAt(i);
 
-		if(connection->getConnectionState() > eTCS_Connecting && !connection->isActive()) {
-			debug_d("Removing stale connection: State: %d, Active: %d, Finished: %d", connection->getConnectionState(),
-					connection->isActive(), connection->isFinished());
+		bool stale = (connection->getConnectionState() > eTCS_Connecting && !connection->isActive());
+		bool idle = connection->isFinished() && connection->getIdleTime() >= idleTimeout;
+		if(stale || idle) {
+			debug_d("Removing %s connection: State: %d, Active: %d, Finished: %d", stale ? "stale" : "idle",
+					connection->getConnectionState(), connection->isActive(), connection->isFinished());
 			httpConnectionPool.removeAt(i);
+			++poolStats.evictions;
+			continue;
 		}
+
+		++i;
 	}
 }
@@ -25,9 +25,49 @@
 #include "Data/Stream/LimitedMemoryStream.h"
 #include <SimpleTimer.h>
 
+#ifndef HTTP_CLIENT_MAX_CONNECTIONS_PER_HOST
+#define HTTP_CLIENT_MAX_CONNECTIONS_PER_HOST 1
+#endif
+
+#ifndef HTTP_CLIENT_MAX_CONNECTIONS
+#define HTTP_CLIENT_MAX_CONNECTIONS 8
+#endif
+
+#ifndef HTTP_CLIENT_IDLE_TIMEOUT
+#define HTTP_CLIENT_IDLE_TIMEOUT 60
+#endif
+
+#ifndef HTTP_CLIENT_MIN_FREE_HEAP
+#define HTTP_CLIENT_MIN_FREE_HEAP 8192
+#endif
+
 class HttpClient
 {
 public:
+	/**
+	 * @brief Configuration for the connection pool shared by all HttpClient instances
+	 */
+	struct PoolConfig {
+		/// Number of parallel connections permitted to a host
+		uint8_t maxConnectionsPerHost = HTTP_CLIENT_MAX_CONNECTIONS_PER_HOST;
+		/// Total connections in the pool
+		uint8_t maxConnections = HTTP_CLIENT_MAX_CONNECTIONS;
+		/// Seconds after which an unused connection is closed
+		uint16_t idleTimeout = HTTP_CLIENT_IDLE_TIMEOUT;
+		/// New connections are not opened when free heap is below this value
+		uint32_t minFreeHeap = HTTP_CLIENT_MIN_FREE_HEAP;
+	};
+
+	/**
+	 * @brief Connection pool statistics
+	 */
+	struct PoolStats {
+		uint32_t hits;		///< Request sent on an already-open connection
+		uint32_t misses;	///< Request required a new connection
+		uint32_t evictions; ///< Connections closed through idleness or to make room for others
+		uint32_t rejected;  ///< Requests refused as no connection was available
+	};
+
 	/**
 	 * @brief HttpClient destructor
 	 * @note DON'T call cleanup.
@@ -96,6 +136,10 @@ public:
 	 * @param url Source of file data
 	 * @param saveFileName Path to save file to. Optional: specify nullptr to use name from url
 	 * @param requestComplete Completion callback
+	 * @note Content is buffered and written to the file from a low-priority task in blocks of
+	 * HTTP_DOWNLOAD_BLOCK_SIZE bytes. The file is complete when `requestComplete` is called.
+	 * If the server gives a Content-Length larger than the free space on the file system,
+	 * the download fails without writing anything.
 	 */
 	bool downloadFile(const Url& url, const String& saveFileName, RequestCompletedDelegate requestComplete = nullptr);
 
@@ -128,19 +172,67 @@ public:
 		httpConnectionPool.clear();
 	}
 
+	static void setPoolConfig(const PoolConfig& config)
+	{
+		poolConfig = config;
+		// Interval is set from idle timeout on next request
+		cleanUpTimer.stop();
+	}
+
+	static const PoolConfig& getPoolConfig()
+	{
+		return poolConfig;
+	}
+
+	static const PoolStats& getPoolStats()
+	{
+		return poolStats;
+	}
+
+	static void resetPoolStats()
+	{
+		poolStats = {};
+	}
+
+	/**
+	 * @brief Get number of connections currently in the pool
+	 */
+	static unsigned getConnectionCount()
+	{
+		return httpConnectionPool.count();
+	}
+
 protected:
 	String getCacheKey(const Url& url)
 	{
 		return url.Host + ':' + url.getPort();
 	}
 
+	/**
+	 * @brief High-priority requests use a separate connection so they aren't held up by other transfers
+	 */
+	String getCacheKey(const HttpRequest& request)
+	{
+		String key = getCacheKey(request.uri);
+		if(request.priority == HttpRequestPriority::High) {
+			key += '^';
+		}
+		return key;
+	}
+
 protected:
 	using HttpConnectionPool = ObjectMap<String, HttpClientConnection>;
 	static HttpConnectionPool httpConnectionPool;
 
 private:
+	static HttpClientConnection* getConnection(const String& cacheKey);
+	static bool evictIdleConnection();
 	static SimpleTimer cleanUpTimer;
 	static void cleanInactive();
+	static int checkDownloadLength(HttpConnection& connection, HttpResponse& response);
+
+	static PoolConfig poolConfig;
+	static PoolStats poolStats;
 };
 
 /** @} */
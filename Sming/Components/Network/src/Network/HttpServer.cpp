@@ -14,6 +14,10 @@
 #include "TcpClient.h"
 #include "WString.h"
 
+#if HTTP_SERVER_EXPOSE_VERSION == 1
+#include <SmingVersion.h>
+#endif
+
 void HttpServer::configure(const HttpServerSettings& settings)
 {
 	this->settings = settings;
@@ -21,6 +25,12 @@ void HttpServer::configure(const HttpServerSettings& settings)
 		minHeapSize = settings.minHeapSize;
 	}
 	maxConnections = settings.maxActiveConnections;
+	setBacklog(settings.backlog);
+	setRateLimit(settings.maxConnectionRate, 1000);
+	setIdleEviction(settings.evictIdleConnections);
+	if(settings.recycleConnections != recycler.getCapacity()) {
+		recycler.setCapacity(settings.recycleConnections);
+	}
 
 	if(settings.useDefaultBodyParsers) {
 		setBodyParser(MIME_FORM_URL_ENCODED, formUrlParser);
@@ -29,12 +39,38 @@ void HttpServer::configure(const HttpServerSettings& settings)
 	setKeepAlive(settings.keepAliveSeconds);
 }
 
+void HttpServer::setDefaultHeaders(const HttpHeaders& headers)
+{
+	HttpHeaders fields(headers);
+#if HTTP_SERVER_EXPOSE_NAME == 1
+	if(!fields.contains(HTTP_HEADER_SERVER)) {
+		String s = F("HttpServer/Sming");
+#if HTTP_SERVER_EXPOSE_VERSION == 1
+		s += F(" Sming/" SMING_VERSION);
+#endif
+		fields[HTTP_HEADER_SERVER] = s;
+	}
+#endif
+	defaultHeaders.set(fields);
+}
+
 TcpConnection* HttpServer::createClient(tcp_pcb* clientTcp)
 {
+#if ENABLE_OBJECT_POOL
+	// Connection, request and response objects are all contained within one pooled block;
+	// the recycler supplies their header storage
+	if(maxConnections != 0) {
+		HttpServerConnection::getPool().reserve(maxConnections);
+	}
+#endif
+
 	HttpServerConnection* con = new HttpServerConnection(clientTcp);
 	con->setResourceTree(&paths);
 	con->setBodyParsers(&bodyParsers);
 	con->setCloseOnContentError(settings.closeOnContentError);
+	con->setDefaultHeaders(&defaultHeaders);
+	con->setRecycler(&recycler);
+	recycler.take(*con);
 
 	return con;
 }
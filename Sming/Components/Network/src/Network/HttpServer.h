@@ -23,6 +23,7 @@
 #include "Http/HttpResourceTree.h"
 #include "Http/HttpServerConnection.h"
 #include "Http/HttpBodyParser.h"
+#include "Http/HttpHeaderBlock.h"
 
 struct HttpServerSettings {
 	uint16_t maxActiveConnections = 10; ///< maximum number of concurrent requests..
@@ -31,6 +32,10 @@ struct HttpServerSettings {
 	bool useDefaultBodyParsers = 1; ///< if the default body parsers,  as form-url-encoded, should be used
 	bool closeOnContentError =
 		true; ///< close the connection if a body parser or resource fails to parse the body content.
+	bool evictIdleConnections = false; ///< when at the connection limit, close the longest idle connection
+	uint8_t backlog = 0;			   ///< limit connections waiting to be accepted, 0 for default
+	uint8_t maxConnectionRate = 0;	   ///< maximum new connections per second from one IP address, 0 for no limit
+	uint8_t recycleConnections = 2;	   ///< keep header storage from closed connections for re-use, 0 to disable
 };
 
 class HttpServer : public TcpServer
@@ -40,11 +45,21 @@ public:
 	{
 		settings.keepAliveSeconds = 2;
 		configure(settings);
+		setDefaultHeaders(HttpHeaders());
 	}
 
 	HttpServer(const HttpServerSettings& settings)
 	{
 		configure(settings);
+		setDefaultHeaders(HttpHeaders());
+	}
+
+	~HttpServer()
+	{
+		// Recycler goes away with the server
+		for(auto connection : connections) {
+			static_cast<HttpServerConnection*>(connection)->setRecycler(nullptr);
+		}
 	}
 
 	/**
@@ -76,6 +91,29 @@ public:
 		bodyParsers[toString(mimeType)] = parser;
 	}
 
+	/**
+	 * @brief Set header fields to be included in every response
+	 * @param headers For example, CORS or caching policy
+	 *
+	 * The fields are rendered once here and copied directly into each response.
+	 * Any field also set for a specific response takes precedence.
+	 * A `Server` field is added unless disabled via HTTP_SERVER_EXPOSE_NAME.
+	 */
+	void setDefaultHeaders(const HttpHeaders& headers);
+
+	const HttpHeaders& getDefaultHeaders() const
+	{
+		return defaultHeaders.getHeaders();
+	}
+
+	/**
+	 * @brief Get statistics for re-use of connection storage
+	 */
+	const HttpConnectionRecycler::Stats& getRecyclerStats() const
+	{
+		return recycler.getStats();
+	}
+
 public:
 	/** @brief Maps paths to resources which deal with incoming requests */
 	HttpResourceTree paths;
@@ -86,6 +124,8 @@ protected:
 private:
 	HttpServerSettings settings;
 	BodyParsers bodyParsers;
+	HttpHeaderBlock defaultHeaders;
+	HttpConnectionRecycler recycler;
 };
 
 /** @} */
@@ -0,0 +1,117 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/SmingHub/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * LwipStats.cpp
+ *
+ ****/
+
+#include "LwipStats.h"
+#include <lwip/init.h>
+#include <lwip/stats.h>
+#include <lwip/memp.h>
+#include <FakePgmSpace.h>
+
+#if LWIP_VERSION_MAJOR >= 2 && LWIP_STATS && MEMP_STATS
+#define POOL_STATS 1
+#define HEAP_STATS MEM_STATS
+#else
+#define POOL_STATS 0
+#define HEAP_STATS 0
+#endif
+
+namespace LwipStats
+{
+namespace
+{
+#if POOL_STATS
+
+// Names and labels indexed by memp_t
+#define LWIP_MEMPOOL(name, num, size, desc)                                                                            \
+	const char poolName_##name[] PROGMEM = #name;                                                                      \
+	const char poolLabels_##name[] PROGMEM = "pool=\"" #name "\"";
+#include <lwip/priv/memp_std.h>
+
+const char* const poolNames[]{
+#define LWIP_MEMPOOL(name, num, size, desc) poolName_##name,
+#include <lwip/priv/memp_std.h>
+};
+
+const char* const poolLabels[]{
+#define LWIP_MEMPOOL(name, num, size, desc) poolLabels_##name,
+#include <lwip/priv/memp_std.h>
+};
+
+constexpr unsigned poolCount{MEMP_MAX};
+
+#else
+constexpr unsigned poolCount{0};
+#endif
+
+#if HEAP_STATS
+const char heapName[] PROGMEM = "HEAP";
+const char heapLabels[] PROGMEM = "pool=\"HEAP\"";
+#endif
+
+struct stats_mem* getStats(unsigned index)
+{
+#if POOL_STATS
+	if(index < poolCount) {
+		return lwip_stats.memp[index];
+	}
+#endif
+#if HEAP_STATS
+	if(index == poolCount) {
+		return &lwip_stats.mem;
+	}
+#endif
+	(void)index;
+	return nullptr;
+}
+
+} // namespace
+
+unsigned getPoolCount()
+{
+	return poolCount + HEAP_STATS;
+}
+
+bool getPool(unsigned index, Pool& pool)
+{
+	auto stats = getStats(index);
+	if(stats == nullptr) {
+		return false;
+	}
+
+#if POOL_STATS
+	if(index < poolCount) {
+		pool.name = poolNames[index];
+		pool.labels = poolLabels[index];
+	}
+#endif
+#if HEAP_STATS
+	if(index == poolCount) {
+		pool.name = heapName;
+		pool.labels = heapLabels;
+	}
+#endif
+	pool.size = stats->avail;
+	pool.used = stats->used;
+	pool.max = stats->max;
+	pool.errors = stats->err;
+	return true;
+}
+
+void resetHighWater()
+{
+	for(unsigned i = 0; i < getPoolCount(); ++i) {
+		auto stats = getStats(i);
+		if(stats != nullptr) {
+			stats->max = stats->used;
+		}
+	}
+}
+
+} // namespace LwipStats
@@ -0,0 +1,58 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/SmingHub/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * LwipStats.h - Memory pool usage for the lwIP stack
+ *
+ ****/
+
+#pragma once
+
+#include <cstdint>
+
+/** @addtogroup tcp
+ *  @{
+ */
+
+/**
+ * @brief Runtime usage of lwIP memory pools, such as TCP segments and packet buffers
+ *
+ * Statistics are only available with lwIP version 2 when built with pool statistics enabled:
+ *
+ * - Host, Rp2040: set ENABLE_LWIP_STATS=1
+ * - Esp32: set CONFIG_LWIP_STATS=y in SDK configuration
+ *
+ * Otherwise `getPoolCount()` returns 0.
+ */
+namespace LwipStats
+{
+struct Pool {
+	const char* name;   ///< Pool name as used by lwIP, such as TCP_SEG (flash string)
+	const char* labels; ///< Label set for metrics, such as `pool="TCP_SEG"` (flash string)
+	uint32_t size;		///< Number of elements available, or bytes for the heap
+	uint32_t used;		///< Number currently allocated
+	uint32_t max;		///< Highest number allocated since startup or `resetHighWater()`
+	uint32_t errors;	///< Number of failed allocations
+};
+
+/**
+ * @brief Get number of pools, including the lwIP heap if it has statistics
+ */
+unsigned getPoolCount();
+
+/**
+ * @brief Get current values for a pool
+ * @retval bool false if index is out of range
+ */
+bool getPool(unsigned index, Pool& pool);
+
+/**
+ * @brief Set each high-water mark to the current value
+ */
+void resetHighWater();
+
+} // namespace LwipStats
+
+/** @} */
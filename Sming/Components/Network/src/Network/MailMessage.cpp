@@ -72,6 +72,18 @@ MailMessage& MailMessage::addAttachment(FileStream* stream)
 	return addAttachment(stream, mime, filename);
 }
 
+MailMessage& MailMessage::addAttachment(const String& filename)
+{
+	auto file = new FileStream(filename);
+	if(!file->isValid()) {
+		debug_e("MailMessage::addAttachment: Unable to open '%s'", filename.c_str());
+		delete file;
+		return *this;
+	}
+
+	return addAttachment(file);
+}
+
 MailMessage& MailMessage::addAttachment(IDataSourceStream* stream, MimeType mime, const String& filename)
 {
 	return addAttachment(stream, toString(mime), filename);
@@ -33,10 +33,10 @@ class MailMessage
 	friend class SmtpClient;
 
 public:
-	String to;
+	String to; ///< One or more recipients, separated by commas
 	String from;
 	String subject;
-	String cc;
+	String cc; ///< Further recipients, separated by commas
 
 	/**
 	 * @brief Set a header value
@@ -87,6 +87,14 @@ public:
 	 */
 	MailMessage& addAttachment(FileStream* stream);
 
+	/**
+	 * @brief Adds a file as an attachment to the email
+	 * @param filename
+	 * @retval MailMessage&
+	 * @note The file is opened immediately, but its content is read and encoded only as the message is sent
+	 */
+	MailMessage& addAttachment(const String& filename);
+
 	/**
 	 * @brief Adds attachment to the email
 	 * @param stream
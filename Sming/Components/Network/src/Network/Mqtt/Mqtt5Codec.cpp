@@ -0,0 +1,632 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/SmingHub/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * Mqtt5Codec.cpp
+ *
+ ****/
+
+#include "Mqtt5Codec.h"
+#include <debug_progmem.h>
+#include <algorithm>
+
+namespace
+{
+constexpr uint8_t MQTT5_PROTOCOL_LEVEL{5};
+
+// Property identifiers
+constexpr uint8_t PROP_MESSAGE_EXPIRY{0x02};
+constexpr uint8_t PROP_RECEIVE_MAXIMUM{0x21};
+constexpr uint8_t PROP_TOPIC_ALIAS_MAXIMUM{0x22};
+constexpr uint8_t PROP_TOPIC_ALIAS{0x23};
+constexpr uint8_t PROP_USER_PROPERTY{0x26};
+
+// CONNECT flags
+constexpr uint8_t CONNECT_FLAG_WILL{0x04};
+
+/*
+ * Aliasing a short topic saves little, as the alias property itself takes 3 bytes
+ */
+constexpr uint16_t minAliasedTopicLength{4};
+
+/*
+ * Number of times a topic must be published before it is given an alias
+ */
+constexpr uint16_t aliasThreshold{2};
+
+/**
+ * @brief Read a variable byte integer
+ * @retval size_t Number of bytes used, 0 if incomplete or invalid
+ */
+size_t readVarInt(const uint8_t* data, size_t length, uint32_t& value)
+{
+	value = 0;
+	for(unsigned i = 0; i < 4 && i < length; ++i) {
+		value |= uint32_t(data[i] & 0x7f) << (7 * i);
+		if((data[i] & 0x80) == 0) {
+			return i + 1;
+		}
+	}
+	return 0;
+}
+
+size_t getVarIntSize(uint32_t value)
+{
+	return (value < 0x80) ? 1 : (value < 0x4000) ? 2 : (value < 0x200000) ? 3 : 4;
+}
+
+size_t writeVarInt(uint8_t* buffer, uint32_t value)
+{
+	size_t n{0};
+	do {
+		uint8_t c = value & 0x7f;
+		value >>= 7;
+		if(value != 0) {
+			c |= 0x80;
+		}
+		buffer[n++] = c;
+	} while(value != 0);
+	return n;
+}
+
+void writeVarInt(String& s, uint32_t value)
+{
+	uint8_t buffer[4];
+	auto n = writeVarInt(buffer, value);
+	s.concat(reinterpret_cast<const char*>(buffer), n);
+}
+
+uint16_t readUint16(const uint8_t* data)
+{
+	return (data[0] << 8) | data[1];
+}
+
+void writeUint16(String& s, uint16_t value)
+{
+	s += char(value >> 8);
+	s += char(value & 0xff);
+}
+
+void writeUint32(String& s, uint32_t value)
+{
+	writeUint16(s, value >> 16);
+	writeUint16(s, value & 0xffff);
+}
+
+void writeString(String& s, const String& value)
+{
+	writeUint16(s, value.length());
+	s += value;
+}
+
+void append(String& s, const uint8_t* data, size_t length)
+{
+	s.concat(reinterpret_cast<const char*>(data), length);
+}
+
+/*
+ * Map MQTT 5 CONNACK reason code to MQTT 3.1.1 return code
+ */
+uint8_t mapConnackReason(uint8_t reason)
+{
+	switch(reason) {
+	case 0x00: // Success
+		return 0;
+	case 0x84: // Unsupported protocol version
+		return 1;
+	case 0x85: // Client identifier not valid
+		return 2;
+	case 0x86: // Bad user name or password
+		return 4;
+	case 0x87: // Not authorized
+		return 5;
+	default: // Server unavailable
+		return 3;
+	}
+}
+
+} // namespace
+
+void Mqtt5Codec::reset()
+{
+	topics.clear();
+	aliasCount = 0;
+	receiveMaximum = 0xffff;
+	topicAliasMaximum = 0;
+	state = State::header;
+	rxBuffer.setLength(0);
+}
+
+void Mqtt5Codec::addUserProperty(const String& name, const String& value)
+{
+	userProperties.add(name);
+	userProperties.add(value);
+}
+
+uint16_t Mqtt5Codec::getTopicAlias(const uint8_t* topic, uint16_t length, bool& established)
+{
+	established = false;
+	uint16_t limit = std::min(maxTopicAliases, topicAliasMaximum);
+	if(limit == 0 || length < minAliasedTopicLength) {
+		return 0;
+	}
+
+	for(unsigned i = 0; i < topics.count(); ++i) {
+		auto& entry = topics[i];
+		if(entry.topic.length() != length || memcmp(entry.topic.c_str(), topic, length) != 0) {
+			continue;
+		}
+		if(entry.alias != 0) {
+			established = true;
+			return entry.alias;
+		}
+		if(++entry.count >= aliasThreshold && aliasCount < limit) {
+			entry.alias = ++aliasCount;
+			return entry.alias;
+		}
+		return 0;
+	}
+
+	// Make room by forgetting the least used topic without an alias
+	if(topics.count() >= 2U * limit) {
+		int victim{-1};
+		for(unsigned i = 0; i < topics.count(); ++i) {
+			auto& entry = topics[i];
+			if(entry.alias == 0 && (victim < 0 || entry.count < topics[victim].count)) {
+				victim = i;
+			}
+		}
+		if(victim < 0) {
+			return 0;
+		}
+		topics.remove(victim);
+	}
+
+	topics.add(TopicEntry{String(reinterpret_cast<const char*>(topic), length), 1, 0});
+	return 0;
+}
+
+void Mqtt5Codec::writeProperties(String& props, uint16_t alias)
+{
+	if(messageExpiry != 0) {
+		props += char(PROP_MESSAGE_EXPIRY);
+		writeUint32(props, messageExpiry);
+	}
+	if(alias != 0) {
+		props += char(PROP_TOPIC_ALIAS);
+		writeUint16(props, alias);
+	}
+	for(unsigned i = 0; i + 1 < userProperties.count(); i += 2) {
+		props += char(PROP_USER_PROPERTY);
+		writeString(props, userProperties[i]);
+		writeString(props, userProperties[i + 1]);
+	}
+}
+
+bool Mqtt5Codec::encode(const uint8_t* packet, size_t length)
+{
+	if(length < 2) {
+		return false;
+	}
+
+	uint32_t remainingLength;
+	auto n = readVarInt(&packet[1], length - 1, remainingLength);
+	if(n == 0) {
+		return false;
+	}
+	auto body = &packet[1 + n];
+	size_t bodyLength = length - 1 - n;
+
+	auto writeHeader = [&](uint32_t newLength) {
+		encoded.setLength(0);
+		encoded += char(packet[0]);
+		writeVarInt(encoded, newLength);
+	};
+
+	switch(PacketType(packet[0] >> 4)) {
+	case PacketType::connect: {
+		reset();
+		// Protocol name, level, flags, keep-alive, client identifier
+		if(bodyLength < 2) {
+			return false;
+		}
+		size_t levelPos = 2 + readUint16(body);
+		size_t propsPos = levelPos + 4;
+		if(bodyLength < propsPos + 2) {
+			return false;
+		}
+		bool will = body[levelPos + 1] & CONNECT_FLAG_WILL;
+		size_t clientIdEnd = propsPos + 2 + readUint16(&body[propsPos]);
+		if(bodyLength < clientIdEnd) {
+			return false;
+		}
+
+		// Empty CONNECT properties, and will properties if required
+		writeHeader(remainingLength + (will ? 2 : 1));
+		auto levelOffset = encoded.length() + levelPos;
+		append(encoded, body, propsPos);
+		encoded[levelOffset] = MQTT5_PROTOCOL_LEVEL;
+		encoded += '\0';
+		if(will) {
+			append(encoded, &body[propsPos], clientIdEnd - propsPos);
+			encoded += '\0';
+			append(encoded, &body[clientIdEnd], bodyLength - clientIdEnd);
+		} else {
+			append(encoded, &body[propsPos], bodyLength - propsPos);
+		}
+		return true;
+	}
+
+	case PacketType::publish: {
+		if(bodyLength < 2) {
+			return false;
+		}
+		uint16_t topicLength = readUint16(body);
+		auto topic = &body[2];
+		size_t propsPos = 2 + topicLength + ((packet[0] & 0x06) ? 2 : 0);
+		if(bodyLength < propsPos) {
+			return false;
+		}
+
+		bool established;
+		auto alias = getTopicAlias(topic, topicLength, established);
+		String props;
+		writeProperties(props, alias);
+		size_t propsSize = getVarIntSize(props.length()) + props.length();
+
+		if(established) {
+			// Server knows the alias, so send an empty topic name
+			writeHeader(remainingLength - topicLength + propsSize);
+			writeUint16(encoded, 0);
+			append(encoded, &topic[topicLength], propsPos - 2 - topicLength);
+			++stats.aliasedMessages;
+			stats.bytesSaved += topicLength;
+		} else {
+			writeHeader(remainingLength + propsSize);
+			append(encoded, body, propsPos);
+		}
+		writeVarInt(encoded, props.length());
+		encoded += props;
+		append(encoded, &body[propsPos], bodyLength - propsPos);
+		return true;
+	}
+
+	case PacketType::subscribe:
+	case PacketType::unsubscribe:
+		// Empty properties follow packet identifier
+		if(bodyLength < 2) {
+			return false;
+		}
+		writeHeader(remainingLength + 1);
+		append(encoded, body, 2);
+		encoded += '\0';
+		append(encoded, &body[2], bodyLength - 2);
+		return true;
+
+	default:
+		// Other packets are compatible
+		return false;
+	}
+}
+
+bool Mqtt5Codec::decode(const uint8_t* data, size_t length, Output output)
+{
+	while(length != 0) {
+		switch(state) {
+		case State::header:
+			fixedHeader = *data++;
+			--length;
+			remainingLength = 0;
+			shift = 0;
+			state = State::remainingLength;
+			break;
+
+		case State::remainingLength: {
+			uint8_t c = *data++;
+			--length;
+			remainingLength |= uint32_t(c & 0x7f) << shift;
+			shift += 7;
+			if(c & 0x80) {
+				if(shift >= 28) {
+					debug_e("[MQTT5] Invalid remaining length");
+					return false;
+				}
+				break;
+			}
+			remaining = remainingLength;
+			if(!startPacket(output)) {
+				return false;
+			}
+			break;
+		}
+
+		case State::collect: {
+			auto n = std::min(length, need - rxBuffer.length());
+			append(rxBuffer, data, n);
+			data += n;
+			length -= n;
+			remaining -= n;
+			if(rxBuffer.length() == need && !processHeader(output)) {
+				return false;
+			}
+			break;
+		}
+
+		case State::body: {
+			auto n = std::min(length, size_t(remaining));
+			if(skipCount != 0) {
+				n = std::min(n, size_t(skipCount));
+				skipCount -= n;
+			} else if(passBody && !output(data, n)) {
+				return false;
+			}
+			data += n;
+			length -= n;
+			remaining -= n;
+			if(remaining == 0) {
+				state = State::header;
+			}
+			break;
+		}
+		}
+	}
+
+	return true;
+}
+
+bool Mqtt5Codec::emit(Output& output, uint32_t remainingLength, const uint8_t* data, size_t length)
+{
+	uint8_t header[5];
+	header[0] = fixedHeader;
+	auto n = 1 + writeVarInt(&header[1], remainingLength);
+	return output(header, n) && (length == 0 || output(data, length));
+}
+
+void Mqtt5Codec::beginBody(uint32_t skip, bool pass)
+{
+	skipCount = skip;
+	passBody = pass;
+	state = (remaining == 0) ? State::header : State::body;
+}
+
+bool Mqtt5Codec::startPacket(Output& output)
+{
+	rxBuffer.setLength(0);
+
+	auto collect = [&](size_t size) {
+		need = size;
+		state = State::collect;
+		return size <= remainingLength;
+	};
+
+	auto type = PacketType(fixedHeader >> 4);
+	switch(type) {
+	case PacketType::puback:
+	case PacketType::pubrec:
+	case PacketType::pubrel:
+	case PacketType::pubcomp:
+	case PacketType::connack:
+		// Reason code and properties may be omitted, in which case the packet is compatible
+		if(remainingLength == 2) {
+			break;
+		}
+		return collect(2);
+
+	case PacketType::publish:
+	case PacketType::suback:
+	case PacketType::unsuback:
+		if(!collect(2)) {
+			debug_e("[MQTT5] Packet too short");
+			return false;
+		}
+		return true;
+
+	case PacketType::disconnect:
+	case PacketType::auth:
+		debug_w("[MQTT5] Ignoring packet type %u", unsigned(type));
+		beginBody(remaining, false);
+		return true;
+
+	default:
+		break;
+	}
+
+	if(!emit(output, remainingLength, nullptr, 0)) {
+		return false;
+	}
+	beginBody(0, true);
+	return true;
+}
+
+bool Mqtt5Codec::processHeader(Output& output)
+{
+	auto buf = reinterpret_cast<const uint8_t*>(rxBuffer.c_str());
+	size_t len = rxBuffer.length();
+
+	auto collect = [&](size_t size) {
+		if(size > remainingLength) {
+			debug_e("[MQTT5] Invalid packet");
+			return false;
+		}
+		need = size;
+		return true;
+	};
+
+	auto type = PacketType(fixedHeader >> 4);
+	size_t prefix{2};
+	switch(type) {
+	case PacketType::puback:
+	case PacketType::pubrec:
+	case PacketType::pubrel:
+	case PacketType::pubcomp:
+	case PacketType::unsuback:
+		// Keep packet identifier, drop reason codes and properties
+		if(!emit(output, 2, buf, 2)) {
+			return false;
+		}
+		beginBody(remaining, false);
+		return true;
+
+	case PacketType::publish:
+		prefix += readUint16(buf);
+		if(fixedHeader & 0x06) {
+			prefix += 2;
+		}
+		break;
+
+	default:
+		break;
+	}
+
+	// Collect prefix, then property length one byte at a time
+	if(len < prefix) {
+		return collect(prefix);
+	}
+	uint32_t propsLength;
+	auto n = readVarInt(&buf[prefix], len - prefix, propsLength);
+	if(n == 0) {
+		if(len - prefix >= 4) {
+			debug_e("[MQTT5] Invalid property length");
+			return false;
+		}
+		return collect(len + 1);
+	}
+	size_t headerLength = prefix + n;
+
+	if(type == PacketType::connack) {
+		if(len < headerLength + propsLength) {
+			return collect(headerLength + propsLength);
+		}
+		readConnackProperties(&buf[headerLength], propsLength);
+		uint8_t connack[]{buf[0], mapConnackReason(buf[1])};
+		if(!emit(output, 2, connack, 2)) {
+			return false;
+		}
+		beginBody(remaining, false);
+		return true;
+	}
+
+	// PUBLISH or SUBACK: skip properties and pass remaining content
+	if(propsLength > remaining) {
+		debug_e("[MQTT5] Invalid property length");
+		return false;
+	}
+	if(!emit(output, remainingLength - n - propsLength, buf, prefix)) {
+		return false;
+	}
+	beginBody(propsLength, true);
+	return true;
+}
+
+bool Mqtt5Codec::readProperty(const uint8_t*& data, const uint8_t* end, Property& prop)
+{
+	if(data >= end) {
+		return false;
+	}
+
+	prop = Property{*data++};
+	auto available = size_t(end - data);
+
+	auto readBinary = [&]() {
+		if(available < 2) {
+			return false;
+		}
+		auto length = readUint16(data);
+		if(available < 2U + length) {
+			return false;
+		}
+		prop.data = data + 2;
+		prop.length = length;
+		data += 2 + length;
+		available -= 2 + length;
+		return true;
+	};
+
+	switch(prop.id) {
+	case 0x01: // Payload format indicator
+	case 0x17: // Request problem information
+	case 0x19: // Request response information
+	case 0x24: // Maximum QoS
+	case 0x25: // Retain available
+	case 0x28: // Wildcard subscription available
+	case 0x29: // Subscription identifier available
+	case 0x2A: // Shared subscription available
+		if(available < 1) {
+			return false;
+		}
+		prop.value = *data++;
+		return true;
+
+	case 0x13: // Server keep alive
+	case PROP_RECEIVE_MAXIMUM:
+	case PROP_TOPIC_ALIAS_MAXIMUM:
+	case PROP_TOPIC_ALIAS:
+		if(available < 2) {
+			return false;
+		}
+		prop.value = readUint16(data);
+		data += 2;
+		return true;
+
+	case PROP_MESSAGE_EXPIRY:
+	case 0x11: // Session expiry interval
+	case 0x18: // Will delay interval
+	case 0x27: // Maximum packet size
+		if(available < 4) {
+			return false;
+		}
+		prop.value = (uint32_t(readUint16(data)) << 16) | readUint16(&data[2]);
+		data += 4;
+		return true;
+
+	case 0x0B: { // Subscription identifier
+		auto n = readVarInt(data, available, prop.value);
+		data += n;
+		return n != 0;
+	}
+
+	case 0x03: // Content type
+	case 0x08: // Response topic
+	case 0x09: // Correlation data
+	case 0x12: // Assigned client identifier
+	case 0x15: // Authentication method
+	case 0x16: // Authentication data
+	case 0x1A: // Response information
+	case 0x1C: // Server reference
+	case 0x1F: // Reason string
+		return readBinary();
+
+	case PROP_USER_PROPERTY:
+		return readBinary() && readBinary();
+
+	default:
+		return false;
+	}
+}
+
+void Mqtt5Codec::readConnackProperties(const uint8_t* props, size_t length)
+{
+	auto end = props + length;
+	Property prop;
+	while(props < end) {
+		if(!readProperty(props, end, prop)) {
+			debug_w("[MQTT5] Invalid CONNACK property");
+			break;
+		}
+		switch(prop.id) {
+		case PROP_RECEIVE_MAXIMUM:
+			if(prop.value != 0) {
+				receiveMaximum = prop.value;
+			}
+			break;
+		case PROP_TOPIC_ALIAS_MAXIMUM:
+			topicAliasMaximum = prop.value;
+			break;
+		default:
+			break;
+		}
+	}
+	debug_d("[MQTT5] Receive maximum %u, topic alias maximum %u", receiveMaximum, topicAliasMaximum);
+}
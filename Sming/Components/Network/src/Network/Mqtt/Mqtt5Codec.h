@@ -0,0 +1,217 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/SmingHub/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * Mqtt5Codec.h
+ *
+ ****/
+
+#pragma once
+
+#include <WString.h>
+#include <WVector.h>
+#include <Delegate.h>
+
+/** @addtogroup mqttclient
+ *  @{
+ */
+
+/**
+ * @brief Maximum number of topic aliases the client will assign
+ */
+#ifndef MQTT_TOPIC_ALIAS_MAX
+#define MQTT_TOPIC_ALIAS_MAX 16
+#endif
+
+/**
+ * @brief Translates packets between MQTT 3.1.1 form, as handled by mqtt-codec, and MQTT 5 on the wire
+ *
+ * Outgoing packets gain the properties MQTT 5 requires, plus:
+ *
+ * - Topic aliases. A topic published more than once is given an alias, if the server allows it,
+ *   and subsequent messages for that topic are sent with an empty topic name.
+ * - Message expiry interval, if set.
+ * - User properties, if set.
+ *
+ * Properties are removed from incoming packets, and reason codes mapped to their MQTT 3.1.1 equivalents.
+ * The server's receive maximum and topic alias maximum are taken from CONNACK.
+ *
+ * Incoming topic aliases are not accepted, so the server always sends topic names in full.
+ */
+class Mqtt5Codec
+{
+public:
+	/**
+	 * @brief Callback to receive decoded data
+	 */
+	using Output = Delegate<bool(const uint8_t* data, size_t length)>;
+
+	/**
+	 * @brief Control packet types
+	 */
+	enum class PacketType : uint8_t {
+		connect = 1,
+		connack = 2,
+		publish = 3,
+		puback = 4,
+		pubrec = 5,
+		pubrel = 6,
+		pubcomp = 7,
+		subscribe = 8,
+		suback = 9,
+		unsubscribe = 10,
+		unsuback = 11,
+		pingreq = 12,
+		pingresp = 13,
+		disconnect = 14,
+		auth = 15,
+	};
+
+	struct Stats {
+		uint32_t aliasedMessages; ///< PUBLISH packets sent without topic name
+		uint32_t bytesSaved;	  ///< Topic bytes not sent due to aliasing
+	};
+
+	/**
+	 * @brief Convert an outgoing packet to MQTT 5
+	 * @param packet Serialised packet. For PUBLISH, the payload may follow separately.
+	 * @param length Length of packet data
+	 * @retval bool true if packet was changed, in which case use `getEncoded()` for the result
+	 * @note A CONNECT packet starts a new session, resetting all state
+	 */
+	bool encode(const uint8_t* packet, size_t length);
+
+	/**
+	 * @brief Get result of last call to `encode()`
+	 */
+	const String& getEncoded() const
+	{
+		return encoded;
+	}
+
+	/**
+	 * @brief Convert incoming data from MQTT 5
+	 * @param data
+	 * @param length
+	 * @param output Receives decoded data, possibly in several calls
+	 * @retval bool false on protocol error, or if output fails
+	 */
+	bool decode(const uint8_t* data, size_t length, Output output);
+
+	/**
+	 * @brief Set message expiry interval for published messages
+	 * @param seconds 0 for no expiry
+	 */
+	void setMessageExpiry(uint32_t seconds)
+	{
+		messageExpiry = seconds;
+	}
+
+	/**
+	 * @brief Add a user property to every published message
+	 */
+	void addUserProperty(const String& name, const String& value);
+
+	void clearUserProperties()
+	{
+		userProperties.clear();
+	}
+
+	/**
+	 * @brief Set maximum number of topic aliases to assign
+	 * @param count 0 to disable aliasing
+	 * @note Takes effect from the next connection
+	 */
+	void setMaxTopicAliases(uint16_t count)
+	{
+		maxTopicAliases = count;
+	}
+
+	/**
+	 * @brief Number of QoS 1 or 2 messages the server will accept concurrently, from CONNACK
+	 */
+	uint16_t getReceiveMaximum() const
+	{
+		return receiveMaximum;
+	}
+
+	/**
+	 * @brief Number of topic aliases the server will accept, from CONNACK
+	 */
+	uint16_t getTopicAliasMaximum() const
+	{
+		return topicAliasMaximum;
+	}
+
+	/**
+	 * @brief Get number of topic aliases assigned in this session
+	 */
+	unsigned getAliasCount() const
+	{
+		return aliasCount;
+	}
+
+	const Stats& getStats() const
+	{
+		return stats;
+	}
+
+private:
+	struct TopicEntry {
+		String topic;
+		uint16_t count;
+		uint16_t alias;
+	};
+
+	struct Property {
+		uint8_t id;
+		uint32_t value;		 ///< Integer value
+		const uint8_t* data; ///< String or binary value
+		uint16_t length;
+	};
+
+	enum class State {
+		header,
+		remainingLength,
+		collect,
+		body,
+	};
+
+	void reset();
+	uint16_t getTopicAlias(const uint8_t* topic, uint16_t length, bool& established);
+	void writeProperties(String& props, uint16_t alias);
+	bool startPacket(Output& output);
+	bool processHeader(Output& output);
+	bool emit(Output& output, uint32_t remainingLength, const uint8_t* data, size_t length);
+	void beginBody(uint32_t skip, bool pass);
+	void readConnackProperties(const uint8_t* props, size_t length);
+	static bool readProperty(const uint8_t*& data, const uint8_t* end, Property& prop);
+
+	// Settings
+	Vector<String> userProperties; ///< Name/value pairs
+	uint32_t messageExpiry{0};
+	uint16_t maxTopicAliases{MQTT_TOPIC_ALIAS_MAX};
+
+	// Session
+	Vector<TopicEntry> topics;
+	uint16_t aliasCount{0};
+	uint16_t receiveMaximum{0xffff};
+	uint16_t topicAliasMaximum{0};
+	Stats stats{};
+	String encoded;
+
+	// Incoming packet
+	State state{State::header};
+	String rxBuffer;
+	uint32_t remaining{0};
+	uint32_t remainingLength{0};
+	uint32_t skipCount{0};
+	size_t need{0};
+	uint8_t fixedHeader{0};
+	uint8_t shift{0};
+	bool passBody{false};
+};
+
+/** @} */
@@ -0,0 +1,363 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/SmingHub/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * MqttOutbox.cpp
+ *
+ ****/
+
+#include "MqttOutbox.h"
+#include <debug_progmem.h>
+
+namespace
+{
+constexpr uint32_t SECTOR_MAGIC{0x424f514d}; // "MQOB"
+constexpr size_t MIN_SECTOR_SIZE{256};
+
+// Record states only ever clear bits, so can be updated without erasing
+constexpr uint8_t STATE_ERASED{0xff};
+constexpr uint8_t STATE_VALID{0xa5};
+constexpr uint8_t STATE_CONSUMED{0x00};
+
+uint16_t crc16(uint16_t crc, const void* data, size_t length)
+{
+	auto p = static_cast<const uint8_t*>(data);
+	while(length-- != 0) {
+		crc ^= uint16_t(*p++) << 8;
+		for(unsigned i = 0; i < 8; ++i) {
+			crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : (crc << 1);
+		}
+	}
+	return crc;
+}
+
+} // namespace
+
+size_t MqttOutbox::recordSize(const RecordHeader& hdr)
+{
+	size_t size = sizeof(hdr) + hdr.topicLength + hdr.contentLength;
+	return (size + 3) & ~3U;
+}
+
+uint16_t MqttOutbox::getChecksum(const RecordHeader& hdr, const char* topic, const char* content)
+{
+	// State and checksum fields are excluded
+	uint16_t crc = crc16(0xffff, &hdr.flags, sizeof(hdr.flags));
+	crc = crc16(crc, &hdr.topicLength, sizeof(hdr.topicLength) + sizeof(hdr.contentLength));
+	crc = crc16(crc, topic, hdr.topicLength);
+	return crc16(crc, content, hdr.contentLength);
+}
+
+size_t MqttOutbox::getMaxMessageSize() const
+{
+	if(sectorCount == 0) {
+		return 0;
+	}
+	return std::min(sectorSize - sizeof(SectorHeader) - sizeof(RecordHeader), size_t(0xffff));
+}
+
+uint32_t MqttOutbox::readSequence(unsigned sector)
+{
+	SectorHeader hdr;
+	if(!partition.read(sectorOffset(sector), &hdr, sizeof(hdr)) || hdr.magic != SECTOR_MAGIC) {
+		return 0;
+	}
+	return hdr.sequence;
+}
+
+bool MqttOutbox::readRecord(unsigned sector, size_t offset, RecordHeader& hdr)
+{
+	if(offset + sizeof(hdr) > sectorSize) {
+		return false;
+	}
+	if(!partition.read(sectorOffset(sector) + offset, &hdr, sizeof(hdr)) || hdr.state == STATE_ERASED) {
+		return false;
+	}
+	return offset + recordSize(hdr) <= sectorSize;
+}
+
+unsigned MqttOutbox::countRecords(unsigned sector, size_t fromOffset)
+{
+	unsigned count{0};
+	size_t offset = sizeof(SectorHeader);
+	RecordHeader hdr;
+	while(readRecord(sector, offset, hdr)) {
+		if(offset >= fromOffset && hdr.state == STATE_VALID) {
+			++count;
+		}
+		offset += recordSize(hdr);
+	}
+	return count;
+}
+
+bool MqttOutbox::begin()
+{
+	sectorCount = 0;
+	if(!partition) {
+		return false;
+	}
+
+	size_t blockSize = partition.getBlockSize();
+	if(blockSize == 0) {
+		return false;
+	}
+	sectorSize = blockSize;
+	if(sectorSize < MIN_SECTOR_SIZE) {
+		sectorSize = ((MIN_SECTOR_SIZE + blockSize - 1) / blockSize) * blockSize;
+	}
+	unsigned count = partition.size() / sectorSize;
+	if(count < 2) {
+		debug_e("[MQTT] Outbox partition '%s' too small", partition.name().c_str());
+		return false;
+	}
+	sectorCount = count;
+
+	// Most recent sector receives new messages
+	headSequence = 0;
+	for(unsigned sector = 0; sector < sectorCount; ++sector) {
+		auto seq = readSequence(sector);
+		if(seq > headSequence) {
+			headSequence = seq;
+			headSector = sector;
+		}
+	}
+
+	if(headSequence == 0) {
+		// Empty: first append opens sector 0
+		headSector = sectorCount - 1;
+		headOffset = sectorSize;
+	} else {
+		size_t offset = sizeof(SectorHeader);
+		RecordHeader hdr;
+		while(readRecord(headSector, offset, hdr)) {
+			offset += recordSize(hdr);
+		}
+		// Never write over a damaged record
+		if(offset + sizeof(hdr) <= sectorSize && hdr.state != STATE_ERASED) {
+			offset = sectorSize;
+		}
+		headOffset = offset;
+	}
+
+	droppedCount = 0;
+	rewind();
+
+	debug_i("[MQTT] Outbox '%s': %u sectors, %u messages stored", partition.name().c_str(), sectorCount,
+			storedCount);
+	return true;
+}
+
+void MqttOutbox::rewind()
+{
+	storedCount = 0;
+	readSectorSequence = 0;
+	readOffset = sizeof(SectorHeader);
+
+	// Oldest sector follows the head
+	for(unsigned i = 1; i <= sectorCount; ++i) {
+		unsigned sector = (headSector + i) % sectorCount;
+		auto seq = readSequence(sector);
+		if(seq == 0) {
+			continue;
+		}
+		if(readSectorSequence == 0) {
+			readSector = sector;
+			readSectorSequence = seq;
+		}
+		storedCount += countRecords(sector, 0);
+	}
+
+	pendingCount = storedCount;
+}
+
+bool MqttOutbox::clear()
+{
+	if(sectorCount == 0 || !partition.erase_range(0, sectorCount * sectorSize)) {
+		return false;
+	}
+
+	// Sequence numbers keep increasing so existing record IDs remain invalid
+	headSector = sectorCount - 1;
+	headOffset = sectorSize;
+	readSectorSequence = 0;
+	storedCount = 0;
+	pendingCount = 0;
+	return true;
+}
+
+bool MqttOutbox::openSector(unsigned sector)
+{
+	SectorHeader hdr{SECTOR_MAGIC, headSequence + 1};
+	if(!partition.erase_range(sectorOffset(sector), sectorSize) ||
+	   !partition.write(sectorOffset(sector), &hdr, sizeof(hdr))) {
+		debug_e("[MQTT] Outbox sector %u write failed", sector);
+		return false;
+	}
+
+	headSector = sector;
+	headSequence = hdr.sequence;
+	headOffset = sizeof(hdr);
+
+	if(readSectorSequence == 0) {
+		readSector = sector;
+		readSectorSequence = hdr.sequence;
+		readOffset = sizeof(hdr);
+	}
+
+	return true;
+}
+
+bool MqttOutbox::makeSpace(size_t size)
+{
+	if(headOffset + size <= sectorSize) {
+		return true;
+	}
+
+	unsigned sector = nextSector(headSector);
+	auto seq = readSequence(sector);
+	if(seq != 0) {
+		auto count = countRecords(sector, 0);
+		if(count != 0) {
+			if(!dropOldest) {
+				debug_w("[MQTT] Outbox full");
+				return false;
+			}
+			debug_w("[MQTT] Outbox full, dropping %u messages", count);
+			droppedCount += count;
+			storedCount -= count;
+		}
+
+		if(readSectorSequence == seq) {
+			pendingCount -= countRecords(sector, readOffset);
+			unsigned next = nextSector(sector);
+			readSector = next;
+			readSectorSequence = readSequence(next);
+			readOffset = sizeof(SectorHeader);
+		}
+	}
+
+	return openSector(sector);
+}
+
+bool MqttOutbox::append(const String& topic, const String& content, uint8_t flags)
+{
+	if(sectorCount == 0) {
+		return false;
+	}
+
+	if(topic.length() + content.length() > getMaxMessageSize()) {
+		debug_e("[MQTT] Message too large for outbox");
+		return false;
+	}
+
+	RecordHeader hdr{STATE_VALID, flags, 0, uint16_t(topic.length()), uint16_t(content.length())};
+	hdr.checksum = getChecksum(hdr, topic.c_str(), content.c_str());
+
+	auto size = recordSize(hdr);
+	if(!makeSpace(size)) {
+		return false;
+	}
+
+	// Space is used even if write fails
+	uint32_t offset = sectorOffset(headSector) + headOffset;
+	headOffset += size;
+
+	bool ok = partition.write(offset, &hdr, sizeof(hdr));
+	offset += sizeof(hdr);
+	if(ok && topic.length() != 0) {
+		ok = partition.write(offset, topic.c_str(), topic.length());
+	}
+	offset += topic.length();
+	if(ok && content.length() != 0) {
+		ok = partition.write(offset, content.c_str(), content.length());
+	}
+	if(!ok) {
+		debug_e("[MQTT] Outbox write failed");
+		return false;
+	}
+
+	++storedCount;
+	++pendingCount;
+	return true;
+}
+
+bool MqttOutbox::read(Message& message)
+{
+	while(readSectorSequence != 0) {
+		if(readSectorSequence == headSequence && readOffset >= headOffset) {
+			return false;
+		}
+
+		RecordHeader hdr;
+		if(!readRecord(readSector, readOffset, hdr)) {
+			if(readSectorSequence == headSequence) {
+				return false;
+			}
+			readSector = nextSector(readSector);
+			readSectorSequence = readSequence(readSector);
+			readOffset = sizeof(SectorHeader);
+			continue;
+		}
+
+		RecordId id{readSectorSequence, sectorOffset(readSector) + readOffset};
+		if(hdr.state != STATE_VALID) {
+			readOffset += recordSize(hdr);
+			continue;
+		}
+
+		if(!message.topic.setLength(hdr.topicLength) || !message.content.setLength(hdr.contentLength)) {
+			debug_e("[MQTT] Out of memory reading outbox");
+			return false;
+		}
+
+		readOffset += recordSize(hdr);
+		--pendingCount;
+
+		uint32_t offset = id.offset + sizeof(hdr);
+		bool ok = (hdr.topicLength == 0 || partition.read(offset, message.topic.begin(), hdr.topicLength)) &&
+				  (hdr.contentLength == 0 ||
+				   partition.read(offset + hdr.topicLength, message.content.begin(), hdr.contentLength));
+		if(ok) {
+			ok = getChecksum(hdr, message.topic.c_str(), message.content.c_str()) == hdr.checksum;
+		}
+		if(!ok) {
+			debug_w("[MQTT] Discarding damaged outbox record @ 0x%08x", id.offset);
+			consume(id);
+			continue;
+		}
+
+		message.id = id;
+		message.flags = hdr.flags;
+		return true;
+	}
+
+	return false;
+}
+
+bool MqttOutbox::consume(const RecordId& id)
+{
+	if(!id || sectorCount == 0) {
+		return false;
+	}
+
+	unsigned sector = id.offset / sectorSize;
+	if(sector >= sectorCount || readSequence(sector) != id.sequence) {
+		// Sector has since been erased
+		return false;
+	}
+
+	RecordHeader hdr;
+	if(!readRecord(sector, id.offset - sectorOffset(sector), hdr) || hdr.state != STATE_VALID) {
+		return false;
+	}
+
+	uint8_t state{STATE_CONSUMED};
+	if(!partition.write(id.offset, &state, sizeof(state))) {
+		return false;
+	}
+
+	--storedCount;
+	return true;
+}
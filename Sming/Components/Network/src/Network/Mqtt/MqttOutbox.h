@@ -0,0 +1,203 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/SmingHub/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * MqttOutbox.h
+ *
+ ****/
+
+#pragma once
+
+#include <Storage/Partition.h>
+#include <WString.h>
+
+/** @addtogroup mqttclient
+ *  @{
+ */
+
+/**
+ * @brief Store for outgoing MQTT messages, held in flash as a circular log
+ *
+ * Messages are appended to the current sector. When it is full the next sector is erased and used,
+ * so flash wear is spread evenly over the partition. Messages are never moved or rewritten:
+ * once delivered, a record is marked as consumed by clearing bits in its header.
+ *
+ * Sectors are only erased when all their messages have been consumed, unless `setDropOldest()` is used.
+ * When there is no space, `append()` fails.
+ *
+ * Records carry a checksum so those damaged by a power failure during writing are discarded.
+ * Messages which have been replayed but not acknowledged are replayed again after a restart,
+ * so delivery is at-least-once.
+ *
+ * @note The partition must have at least two erase blocks.
+ */
+class MqttOutbox
+{
+public:
+	/**
+	 * @brief Identifies a stored record
+	 */
+	struct RecordId {
+		uint32_t sequence; ///< Sequence number of containing sector, 0 if invalid
+		uint32_t offset;   ///< Offset of record within partition
+
+		explicit operator bool() const
+		{
+			return sequence != 0;
+		}
+	};
+
+	/**
+	 * @brief A message read from the outbox
+	 */
+	struct Message {
+		RecordId id;
+		String topic;
+		String content;
+		uint8_t flags; ///< As passed to `MqttClient::publish()`
+	};
+
+	MqttOutbox(Storage::Partition partition) : partition(partition)
+	{
+	}
+
+	/**
+	 * @brief Scan partition and locate existing messages
+	 * @retval bool false if partition is invalid or too small
+	 */
+	bool begin();
+
+	/**
+	 * @brief Store a message
+	 * @param topic
+	 * @param content
+	 * @param flags
+	 * @retval bool false if the outbox is full or the message is too large
+	 */
+	bool append(const String& topic, const String& content, uint8_t flags);
+
+	/**
+	 * @brief Read the next stored message which has not yet been replayed
+	 * @param message On success, contains the message
+	 * @retval bool false if there are no further messages
+	 *
+	 * The message remains stored until `consume()` is called.
+	 */
+	bool read(Message& message);
+
+	/**
+	 * @brief Mark a message as delivered
+	 * @param id Identifier from `read()`
+	 * @retval bool false if the record no longer exists
+	 */
+	bool consume(const RecordId& id);
+
+	/**
+	 * @brief Restart replay from the oldest stored message
+	 *
+	 * Used when messages previously read have not been consumed, and will not be.
+	 */
+	void rewind();
+
+	/**
+	 * @brief Erase all stored messages
+	 */
+	bool clear();
+
+	/**
+	 * @brief When full, discard the oldest sector of messages instead of failing `append()`
+	 */
+	void setDropOldest(bool enable)
+	{
+		dropOldest = enable;
+	}
+
+	bool isReady() const
+	{
+		return sectorCount != 0;
+	}
+
+	/**
+	 * @brief Get number of messages not yet consumed
+	 */
+	unsigned getStoredCount() const
+	{
+		return storedCount;
+	}
+
+	/**
+	 * @brief Get number of messages not yet read for replay
+	 */
+	unsigned getPendingCount() const
+	{
+		return pendingCount;
+	}
+
+	/**
+	 * @brief Get number of messages discarded because the outbox was full
+	 */
+	unsigned getDroppedCount() const
+	{
+		return droppedCount;
+	}
+
+	/**
+	 * @brief Maximum size of topic and content for a single message
+	 */
+	size_t getMaxMessageSize() const;
+
+private:
+	struct SectorHeader {
+		uint32_t magic;
+		uint32_t sequence;
+	};
+
+	struct RecordHeader {
+		uint8_t state;
+		uint8_t flags;
+		uint16_t checksum;
+		uint16_t topicLength;
+		uint16_t contentLength;
+	};
+
+	uint32_t sectorOffset(unsigned sector) const
+	{
+		return sector * sectorSize;
+	}
+
+	unsigned nextSector(unsigned sector) const
+	{
+		return (sector + 1) % sectorCount;
+	}
+
+	static size_t recordSize(const RecordHeader& hdr);
+	static uint16_t getChecksum(const RecordHeader& hdr, const char* topic, const char* content);
+	uint32_t readSequence(unsigned sector);
+	bool readRecord(unsigned sector, size_t offset, RecordHeader& hdr);
+	unsigned countRecords(unsigned sector, size_t fromOffset);
+	bool openSector(unsigned sector);
+	bool makeSpace(size_t size);
+
+	Storage::Partition partition;
+	size_t sectorSize{0};
+	unsigned sectorCount{0};
+
+	// Write position
+	unsigned headSector{0};
+	uint32_t headSequence{0}; ///< 0 if partition is empty
+	size_t headOffset{0};
+
+	// Replay position
+	unsigned readSector{0};
+	uint32_t readSectorSequence{0};
+	size_t readOffset{0};
+
+	unsigned storedCount{0};
+	unsigned pendingCount{0};
+	unsigned droppedCount{0};
+	bool dropOldest{false};
+};
+
+/** @} */
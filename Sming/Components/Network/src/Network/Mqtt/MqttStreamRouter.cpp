@@ -0,0 +1,193 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/SmingHub/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * MqttStreamRouter.cpp
+ *
+ ****/
+
+#include "MqttStreamRouter.h"
+#include <debug_progmem.h>
+
+bool MqttStreamRouter::topicMatches(const char* filter, const char* topic, size_t topicLength)
+{
+	const char* end = topic + topicLength;
+
+	// Topics starting with '$' are not matched by wildcards at the first level
+	if(topicLength != 0 && *topic == '$' && (*filter == '+' || *filter == '#')) {
+		return false;
+	}
+
+	while(*filter != '\0') {
+		if(*filter == '#') {
+			return true;
+		}
+
+		if(*filter == '+') {
+			while(topic < end && *topic != '/') {
+				++topic;
+			}
+			++filter;
+		} else {
+			if(topic == end || *filter != *topic) {
+				// 'a/#' also matches 'a'
+				return topic == end && filter[0] == '/' && filter[1] == '#' && filter[2] == '\0';
+			}
+			++filter;
+			++topic;
+		}
+	}
+
+	return topic == end;
+}
+
+bool MqttStreamRouter::add(const String& topicFilter, StreamFactory factory, CompleteCallback callback)
+{
+	if(!factory) {
+		return false;
+	}
+
+	remove(topicFilter);
+	auto route = new Route{topicFilter, factory, callback, nullptr};
+	if(!routes.addElement(route)) {
+		delete route;
+		return false;
+	}
+	return true;
+}
+
+bool MqttStreamRouter::add(const String& topicFilter, MqttPayloadParser parser)
+{
+	if(!parser) {
+		return false;
+	}
+
+	remove(topicFilter);
+	auto route = new Route{topicFilter, nullptr, nullptr, parser};
+	if(!routes.addElement(route)) {
+		delete route;
+		return false;
+	}
+	return true;
+}
+
+bool MqttStreamRouter::remove(const String& topicFilter)
+{
+	for(unsigned i = 0; i < routes.count(); ++i) {
+		if(routes[i].filter == topicFilter) {
+			if(route == &routes[i]) {
+				// Abandon any message currently being received
+				finish(false);
+				route = nullptr;
+				failed = true;
+			}
+			routes.remove(i);
+			return true;
+		}
+	}
+
+	return false;
+}
+
+const MqttStreamRouter::Route* MqttStreamRouter::findRoute(const mqtt_buffer_t& topic) const
+{
+	auto name = reinterpret_cast<const char*>(topic.data);
+	for(unsigned i = 0; i < routes.count(); ++i) {
+		auto& r = routes[i];
+		if(topicMatches(r.filter.c_str(), name, topic.length)) {
+			return &r;
+		}
+	}
+
+	return nullptr;
+}
+
+void MqttStreamRouter::finish(bool success)
+{
+	if(stream == nullptr) {
+		return;
+	}
+
+	if(route != nullptr && route->callback) {
+		route->callback(topic, *stream, success);
+	}
+
+	delete stream;
+	stream = nullptr;
+	route = nullptr;
+}
+
+int MqttStreamRouter::parse(MqttPayloadParserState& state, mqtt_message_t* message, const char* buffer, int length)
+{
+	if(message == nullptr) {
+		return -1;
+	}
+
+	if(length == MQTT_PAYLOAD_PARSER_START) {
+		// A previous message may have been interrupted by a disconnection
+		finish(false);
+		failed = false;
+		route = findRoute(message->publish.topic_name);
+		if(route == nullptr) {
+			return fallback ? fallback(state, message, buffer, length) : 0;
+		}
+
+		if(route->parser) {
+			return route->parser(state, message, buffer, length);
+		}
+
+		topic.setString(reinterpret_cast<const char*>(message->publish.topic_name.data),
+						message->publish.topic_name.length);
+		stream = route->factory(topic, message->publish.content.length);
+		if(stream == nullptr) {
+			debug_w("[MQTT] No stream for '%s', payload discarded", topic.c_str());
+			route = nullptr;
+			failed = true;
+		}
+		state.offset = 0;
+		return 0;
+	}
+
+	if(failed) {
+		// Ignore remainder of payload, but keep the connection open
+		if(length == MQTT_PAYLOAD_PARSER_END) {
+			message->publish.content.length = 0;
+		}
+		return 0;
+	}
+
+	if(route == nullptr) {
+		return fallback ? fallback(state, message, buffer, length) : 0;
+	}
+
+	if(route->parser) {
+		int err = route->parser(state, message, buffer, length);
+		if(length == MQTT_PAYLOAD_PARSER_END) {
+			route = nullptr;
+		}
+		return err;
+	}
+
+	if(length == MQTT_PAYLOAD_PARSER_END) {
+		bool success = (state.offset == message->publish.content.length);
+		if(!success) {
+			debug_e("[MQTT] Incomplete payload for '%s'", topic.c_str());
+		}
+		// Content is not buffered
+		message->publish.content.length = 0;
+		finish(success);
+		return 0;
+	}
+
+	size_t written = stream->write(reinterpret_cast<const uint8_t*>(buffer), length);
+	state.offset += written;
+	if(written != size_t(length)) {
+		debug_e("[MQTT] Stream write failed for '%s'", topic.c_str());
+		finish(false);
+		failed = true;
+	}
+
+	return 0;
+}
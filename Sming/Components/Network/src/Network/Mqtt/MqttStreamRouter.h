@@ -0,0 +1,148 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/SmingHub/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * MqttStreamRouter.h
+ *
+ ****/
+
+#pragma once
+
+#include "MqttPayloadParser.h"
+#include <Data/Stream/ReadWriteStream.h>
+#include <WString.h>
+#include <WVector.h>
+
+/** @addtogroup mqttpayload
+ *  @{
+ */
+
+/**
+ * @brief Pass incoming PUBLISH payloads to streams as they are received, selected by topic
+ *
+ * Payloads are written in fragments as they arrive from the network, so their size is not limited by available RAM.
+ * For example, to store a configuration file directly into a partition:
+ *
+ *      MqttStreamRouter router;
+ *
+ *      router.add(F("config/+/file"), [](const String& topic, size_t length) -> ReadWriteStream* {
+ *          return new Storage::PartitionStream(configPartition, Storage::Mode::BlockErase);
+ *      }, [](const String& topic, ReadWriteStream& stream, bool success) {
+ *          // Process stored data
+ *      });
+ *
+ *      mqtt.setPayloadParser(router.getParser());
+ *
+ * Routes may instead pass payloads to another MqttPayloadParser, such as one of the OtaUpgradeMqtt parsers.
+ * Messages for unmatched topics go to the fallback parser, which by default buffers the payload as usual.
+ *
+ * The message handler is still invoked for every message. For routed messages, the content buffer is empty.
+ *
+ * @note A router handles one message at a time so must only be used with one MqttClient.
+ */
+class MqttStreamRouter
+{
+public:
+	/**
+	 * @brief Callback to create a stream for an incoming message
+	 * @param topic
+	 * @param length Payload length
+	 * @retval ReadWriteStream* New stream, owned by the router. Return nullptr to discard the payload.
+	 */
+	using StreamFactory = Delegate<ReadWriteStream*(const String& topic, size_t length)>;
+
+	/**
+	 * @brief Callback invoked when payload has been completely written
+	 * @param topic
+	 * @param stream The stream, which is destroyed after the callback returns
+	 * @param success false if the payload could not be written in full
+	 */
+	using CompleteCallback = Delegate<void(const String& topic, ReadWriteStream& stream, bool success)>;
+
+	MqttStreamRouter() : fallback(defaultPayloadParser)
+	{
+	}
+
+	~MqttStreamRouter()
+	{
+		finish(false);
+	}
+
+	/**
+	 * @brief Route payloads to streams
+	 * @param topicFilter Topic, which may contain MQTT wildcards `+` and `#`
+	 * @param factory Creates stream for each message
+	 * @param callback Optional callback when payload is complete
+	 * @retval bool
+	 */
+	bool add(const String& topicFilter, StreamFactory factory, CompleteCallback callback = nullptr);
+
+	/**
+	 * @brief Route payloads to another parser
+	 * @param topicFilter Topic, which may contain MQTT wildcards `+` and `#`
+	 * @param parser
+	 * @retval bool
+	 */
+	bool add(const String& topicFilter, MqttPayloadParser parser);
+
+	/**
+	 * @brief Remove a route
+	 * @param topicFilter As passed to `add()`
+	 * @retval bool true if route was found
+	 */
+	bool remove(const String& topicFilter);
+
+	/**
+	 * @brief Set parser for messages not matching any route
+	 * @param parser Pass nullptr to discard their content
+	 */
+	void setFallback(MqttPayloadParser parser)
+	{
+		fallback = parser;
+	}
+
+	/**
+	 * @brief Get a parser delegate for `MqttClient::setPayloadParser()`
+	 */
+	MqttPayloadParser getParser()
+	{
+		return MqttPayloadParser(&MqttStreamRouter::parse, this);
+	}
+
+	/**
+	 * @brief Payload parser implementation
+	 */
+	int parse(MqttPayloadParserState& state, mqtt_message_t* message, const char* buffer, int length);
+
+	/**
+	 * @brief Determine if a topic matches an MQTT topic filter
+	 * @param filter Filter which may contain `+` (any single level) or `#` (all remaining levels) wildcards
+	 * @param topic Topic name
+	 * @param topicLength Length of topic name
+	 */
+	static bool topicMatches(const char* filter, const char* topic, size_t topicLength);
+
+private:
+	struct Route {
+		String filter;
+		StreamFactory factory;
+		CompleteCallback callback;
+		MqttPayloadParser parser;
+	};
+
+	const Route* findRoute(const mqtt_buffer_t& topic) const;
+	void finish(bool success);
+
+	Vector<Route> routes;
+	MqttPayloadParser fallback;
+
+	// Message currently being received
+	const Route* route{nullptr};
+	String topic;
+	ReadWriteStream* stream{nullptr};
+	bool failed{false};
+};
+
+/** @} */
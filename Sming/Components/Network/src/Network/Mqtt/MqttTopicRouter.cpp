@@ -0,0 +1,200 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/SmingHub/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * MqttTopicRouter.cpp
+ *
+ ****/
+
+#include "MqttTopicRouter.h"
+
+namespace
+{
+/**
+ * @brief Get length of topic level starting at `level`
+ * @param next On return, start of the following level or nullptr if this is the last one
+ */
+size_t getLevel(const char* level, const char* end, const char*& next)
+{
+	auto sep = static_cast<const char*>(memchr(level, '/', end - level));
+	if(sep == nullptr) {
+		next = nullptr;
+		return end - level;
+	}
+	next = sep + 1;
+	return sep - level;
+}
+
+bool isLevel(const String& name, const char* level, size_t length)
+{
+	return name.length() == length && memcmp(name.c_str(), level, length) == 0;
+}
+
+} // namespace
+
+bool MqttTopicRouter::add(const String& topicFilter, MqttDelegate handler)
+{
+	if(!handler || !topicFilter) {
+		return false;
+	}
+
+	// Validate before changing anything
+	auto filter = topicFilter.c_str();
+	auto end = filter + topicFilter.length();
+	for(auto level = filter; level != nullptr;) {
+		const char* next;
+		auto len = getLevel(level, end, next);
+		if(memchr(level, '#', len) != nullptr && (len != 1 || next != nullptr)) {
+			return false;
+		}
+		if(memchr(level, '+', len) != nullptr && len != 1) {
+			return false;
+		}
+		level = next;
+	}
+
+	auto node = &root;
+	for(auto level = filter; level != nullptr;) {
+		const char* next;
+		auto len = getLevel(level, end, next);
+		if(len == 1 && *level == '#') {
+			if(!node->multiHandler) {
+				++routeCount;
+			}
+			node->multiHandler = handler;
+			return true;
+		}
+
+		std::unique_ptr<Node>* child;
+		if(len == 1 && *level == '+') {
+			child = &node->single;
+		} else {
+			child = &node->children;
+			while(*child && !isLevel((*child)->name, level, len)) {
+				child = &(*child)->next;
+			}
+		}
+		if(!*child) {
+			child->reset(new Node);
+			if(!*child) {
+				return false;
+			}
+			if(child != &node->single) {
+				(*child)->name.setString(level, len);
+			}
+		}
+		node = child->get();
+		level = next;
+	}
+
+	if(!node->handler) {
+		++routeCount;
+	}
+	node->handler = handler;
+	return true;
+}
+
+bool MqttTopicRouter::remove(const String& topicFilter)
+{
+	if(!topicFilter) {
+		return false;
+	}
+	if(!remove(root, topicFilter.c_str(), topicFilter.c_str() + topicFilter.length())) {
+		return false;
+	}
+	--routeCount;
+	return true;
+}
+
+bool MqttTopicRouter::remove(Node& node, const char* filter, const char* end)
+{
+	const char* next;
+	auto len = getLevel(filter, end, next);
+	if(len == 1 && *filter == '#' && next == nullptr) {
+		if(!node.multiHandler) {
+			return false;
+		}
+		node.multiHandler = nullptr;
+		return true;
+	}
+
+	std::unique_ptr<Node>* child;
+	if(len == 1 && *filter == '+') {
+		child = &node.single;
+	} else {
+		child = &node.children;
+		while(*child && !isLevel((*child)->name, filter, len)) {
+			child = &(*child)->next;
+		}
+	}
+	auto& target = *child;
+	if(!target) {
+		return false;
+	}
+
+	if(next == nullptr) {
+		if(!target->handler) {
+			return false;
+		}
+		target->handler = nullptr;
+	} else if(!remove(*target, next, end)) {
+		return false;
+	}
+
+	// Prune nodes which no longer lead to a handler
+	if(target->isEmpty()) {
+		auto sibling = std::move(target->next);
+		target = std::move(sibling);
+	}
+	return true;
+}
+
+const MqttDelegate* MqttTopicRouter::match(const Node& node, const char* level, const char* end, bool first)
+{
+	if(level == nullptr) {
+		if(node.handler) {
+			return &node.handler;
+		}
+		// 'a/#' also matches 'a'
+		return node.multiHandler ? &node.multiHandler : nullptr;
+	}
+
+	const char* next;
+	auto len = getLevel(level, end, next);
+
+	for(auto child = node.children.get(); child != nullptr; child = child->next.get()) {
+		if(isLevel(child->name, level, len)) {
+			auto handler = match(*child, next, end, false);
+			if(handler != nullptr) {
+				return handler;
+			}
+			break;
+		}
+	}
+
+	// Topics starting with '$' are not matched by wildcards at the first level
+	if(first && len != 0 && *level == '$') {
+		return nullptr;
+	}
+
+	if(node.single) {
+		auto handler = match(*node.single, next, end, false);
+		if(handler != nullptr) {
+			return handler;
+		}
+	}
+
+	return node.multiHandler ? &node.multiHandler : nullptr;
+}
+
+int MqttTopicRouter::dispatch(MqttClient& client, mqtt_message_t* message)
+{
+	auto& topic = message->publish.topic_name;
+	auto handler = find(reinterpret_cast<const char*>(topic.data), topic.length);
+	if(handler != nullptr) {
+		return (*handler)(client, message);
+	}
+	return fallback ? fallback(client, message) : 0;
+}
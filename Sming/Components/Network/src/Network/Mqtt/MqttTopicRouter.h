@@ -0,0 +1,128 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/SmingHub/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * MqttTopicRouter.h
+ *
+ ****/
+
+#pragma once
+
+#include "../MqttClient.h"
+#include <memory>
+
+/** @addtogroup mqttclient
+ *  @{
+ */
+
+/**
+ * @brief Pass received messages to handlers selected by topic
+ *
+ * Topic filters are stored as a tree with one node per topic level, so the cost of
+ * routing a message depends on the number of levels in its topic rather than on the
+ * number of subscriptions. Routing does not allocate memory.
+ *
+ *      MqttTopicRouter router;
+ *
+ *      router.add(F("sensors/+/temperature"), onTemperature);
+ *      router.add(F("config/#"), onConfig);
+ *      mqtt.setMessageHandler(router.getHandler());
+ *
+ * Where several filters match a topic, the most specific one is used:
+ * an exact level takes precedence over `+`, which takes precedence over `#`.
+ * Messages which match no filter go to the fallback handler, if set.
+ */
+class MqttTopicRouter
+{
+public:
+	/**
+	 * @brief Add a route, replacing any existing route with the same filter
+	 * @param topicFilter Topic, which may contain MQTT wildcards `+` and `#`
+	 * @param handler
+	 * @retval bool false if filter is invalid
+	 */
+	bool add(const String& topicFilter, MqttDelegate handler);
+
+	/**
+	 * @brief Remove a route
+	 * @param topicFilter As passed to `add()`
+	 * @retval bool true if route was found
+	 */
+	bool remove(const String& topicFilter);
+
+	/**
+	 * @brief Remove all routes
+	 */
+	void clear()
+	{
+		root = Node{};
+		routeCount = 0;
+	}
+
+	/**
+	 * @brief Get number of routes
+	 */
+	unsigned count() const
+	{
+		return routeCount;
+	}
+
+	/**
+	 * @brief Set handler for messages not matching any route
+	 */
+	void setFallback(MqttDelegate handler)
+	{
+		fallback = handler;
+	}
+
+	/**
+	 * @brief Get a delegate for `MqttClient::setMessageHandler()`
+	 */
+	MqttDelegate getHandler()
+	{
+		return MqttDelegate(&MqttTopicRouter::dispatch, this);
+	}
+
+	/**
+	 * @brief Pass a message to its handler
+	 * @retval int Value returned from handler, 0 if there is none
+	 */
+	int dispatch(MqttClient& client, mqtt_message_t* message);
+
+	/**
+	 * @brief Find the handler for a topic
+	 * @param topic Topic name
+	 * @param length Length of topic name
+	 * @retval const MqttDelegate* nullptr if no route matches
+	 */
+	const MqttDelegate* find(const char* topic, size_t length) const
+	{
+		return match(root, topic, topic + length, true);
+	}
+
+private:
+	struct Node {
+		String name;
+		MqttDelegate handler;			///< Filter ends at this level
+		MqttDelegate multiHandler;		///< Filter ends at this level with `#`
+		std::unique_ptr<Node> single;   ///< `+` level
+		std::unique_ptr<Node> children; ///< First named sub-level
+		std::unique_ptr<Node> next;		///< Next sibling
+
+		bool isEmpty() const
+		{
+			return !handler && !multiHandler && !single && !children;
+		}
+	};
+
+	static const MqttDelegate* match(const Node& node, const char* level, const char* end, bool first);
+	static bool remove(Node& node, const char* filter, const char* end);
+
+	Node root;
+	MqttDelegate fallback;
+	unsigned routeCount{0};
+};
+
+/** @} */
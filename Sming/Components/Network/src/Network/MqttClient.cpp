@@ -11,6 +11,7 @@
 #include "MqttClient.h"
 
 #include "Data/Stream/DataSourceStream.h"
+#include <EventBus.h>
 
 const mqtt_parser_callbacks_t MqttClient::callbacks PROGMEM = {
 	.on_message_begin = staticOnMessageBegin,
@@ -54,6 +55,35 @@ void clearMessage(mqtt_message_t& message)
 	mqtt_message_clear(&message, 0);
 }
 
+/*
+ * Get topic and payload size of a message, for queue accounting
+ */
+size_t getPayloadSize(const mqtt_message_t& message)
+{
+	if(message.common.type != MQTT_TYPE_PUBLISH) {
+		return 0;
+	}
+
+	size_t size = message.publish.topic_name.length;
+	if(message.publish.content.length == MQTT_PUBLISH_STREAM) {
+		auto stream = reinterpret_cast<IDataSourceStream*>(message.publish.content.data);
+		if(stream != nullptr) {
+			size += stream->available();
+		}
+	} else {
+		size += message.publish.content.length;
+	}
+	return size;
+}
+
+/*
+ * Publish messages with QoS 1 or 2 must be acknowledged by the server
+ */
+bool requiresAcknowledgement(const mqtt_message_t& message)
+{
+	return message.common.type == MQTT_TYPE_PUBLISH && message.common.qos != MQTT_QOS_AT_MOST_ONCE;
+}
+
 bool copyString(mqtt_buffer_t& destBuffer, const String& sourceString)
 {
 	destBuffer.length = sourceString.length();
@@ -94,18 +124,26 @@ MqttClient::~MqttClient()
 		deleteMessage(requestQueue.dequeue());
 	}
 
-	clearMessage(connectMessage);
-	if(outgoingMessage != &connectMessage) {
-		deleteMessage(outgoingMessage);
+	while(inflightCount != 0) {
+		releaseInflight(&inflight[0]);
 	}
-	outgoingMessage = nullptr;
+
+	clearMessage(connectMessage);
 	clearMessage(incomingMessage);
 }
 
 bool MqttClient::onTcpReceive(TcpClient& client, char* data, int size)
 {
 	pingTimer.start();
-	int rc = mqtt_parser_execute(&parser, &incomingMessage, (uint8_t*)data, (size_t)size);
+	if(mqtt5) {
+		return mqtt5->decode(reinterpret_cast<uint8_t*>(data), size, Mqtt5Codec::Output(&MqttClient::parse, this));
+	}
+	return parse(reinterpret_cast<uint8_t*>(data), size);
+}
+
+bool MqttClient::parse(const uint8_t* data, size_t length)
+{
+	int rc = mqtt_parser_execute(&parser, &incomingMessage, const_cast<uint8_t*>(data), length);
 	if(rc == MQTT_PARSER_RC_ERROR) {
 		debug_e("MqttClient parse error: %s", mqtt_error_string(parser.error));
 		return false;
@@ -114,6 +152,27 @@ bool MqttClient::onTcpReceive(TcpClient& client, char* data, int size)
 	return true;
 }
 
+bool MqttClient::setProtocolVersion(uint8_t version)
+{
+	if(isProcessing()) {
+		debug_e("[MQTT] Protocol version must be set before connect");
+		return false;
+	}
+
+	switch(version) {
+	case MQTT_CONNECT_PROTOCOL:
+		mqtt5.reset();
+		return true;
+	case 5:
+		if(!mqtt5) {
+			mqtt5.reset(new Mqtt5Codec);
+		}
+		return bool(mqtt5);
+	default:
+		return false;
+	}
+}
+
 int MqttClient::staticOnMessageBegin(void* userData, mqtt_message_t* message)
 {
 	// At that moment the message contains the type and its common length
@@ -162,6 +221,8 @@ int MqttClient::staticOnMessageEnd(void* userData, mqtt_message_t* message)
 
 int MqttClient::onMessageEnd(mqtt_message_t* message)
 {
+	handleAcknowledgement(message);
+
 	if(message->common.type == MQTT_TYPE_CONNACK) {
 		if(message->connack.return_code) {
 			// failure
@@ -171,6 +232,7 @@ int MqttClient::onMessageEnd(mqtt_message_t* message)
 			// success
 			setTimeOut(USHRT_MAX);
 			setBits(flags, MQTT_CLIENT_CONNECTED);
+			startReplay();
 		}
 	}
 
@@ -182,6 +244,100 @@ int MqttClient::onMessageEnd(mqtt_message_t* message)
 	return 0;
 }
 
+uint16_t MqttClient::getNextMessageId()
+{
+	// Zero is not a valid packet identifier
+	if(++messageId == 0) {
+		messageId = 1;
+	}
+	return messageId;
+}
+
+MqttClient::InflightMessage* MqttClient::findInflight(uint16_t id, mqtt_type_t awaiting)
+{
+	for(unsigned i = 0; i < inflightCount; ++i) {
+		auto& entry = inflight[i];
+		if(entry.id == id && entry.awaiting == awaiting) {
+			return &entry;
+		}
+	}
+	return nullptr;
+}
+
+void MqttClient::releaseInflight(InflightMessage* entry)
+{
+	if(entry->message != nullptr) {
+		deleteMessage(entry->message);
+	}
+	queuedBytes -= entry->size;
+
+	// Retain order of remaining messages
+	unsigned index = entry - inflight;
+	--inflightCount;
+	for(unsigned i = index; i < inflightCount; ++i) {
+		inflight[i] = inflight[i + 1];
+	}
+}
+
+void MqttClient::handleAcknowledgement(mqtt_message_t* message)
+{
+	switch(message->common.type) {
+	case MQTT_TYPE_PUBACK: {
+		auto entry = findInflight(message->puback.message_id, MQTT_TYPE_PUBACK);
+		if(entry != nullptr) {
+			if(entry->outboxRecord && outbox != nullptr) {
+				outbox->consume(entry->outboxRecord);
+			}
+			releaseInflight(entry);
+		}
+		break;
+	}
+
+	case MQTT_TYPE_PUBREC: {
+		auto id = message->pubrec.message_id;
+		auto entry = findInflight(id, MQTT_TYPE_PUBREC);
+		if(entry == nullptr) {
+			debug_w("[MQTT] Unexpected PUBREC %u", id);
+			break;
+		}
+		// Server now owns the message, so respond with PUBREL and await PUBCOMP
+		auto pubrel = createMessage(MQTT_TYPE_PUBREL);
+		if(pubrel == nullptr) {
+			break;
+		}
+		pubrel->common.qos = MQTT_QOS_AT_LEAST_ONCE;
+		pubrel->pubrel.message_id = id;
+		if(entry->outboxRecord && outbox != nullptr) {
+			outbox->consume(entry->outboxRecord);
+			entry->outboxRecord = {};
+		}
+		if(entry->message != nullptr) {
+			deleteMessage(entry->message);
+		}
+		entry->message = pubrel;
+		queuedBytes -= entry->size;
+		entry->size = 0;
+		entry->awaiting = MQTT_TYPE_PUBCOMP;
+		entry->pending = true;
+		break;
+	}
+
+	case MQTT_TYPE_PUBCOMP: {
+		auto entry = findInflight(message->pubcomp.message_id, MQTT_TYPE_PUBCOMP);
+		if(entry != nullptr) {
+			releaseInflight(entry);
+		}
+		break;
+	}
+
+	default:
+		return;
+	}
+
+	// Send PUBREL, or further messages which now fit into the window
+	commit();
+}
+
 bool MqttClient::setWill(const String& topic, const String& message, uint8_t flags)
 {
 	if(bitsSet(this->flags, MQTT_CLIENT_CONNECTED)) {
@@ -244,6 +400,15 @@ bool MqttClient::connect(const Url& url, const String& clientName)
 
 bool MqttClient::publish(const String& topic, const String& content, uint8_t flags)
 {
+	if(outbox != nullptr && (!bitsSet(this->flags, MQTT_CLIENT_CONNECTED) || outbox->getPendingCount() != 0 ||
+							 requestQueue.full())) {
+		if(!outbox->append(topic, content, flags)) {
+			return false;
+		}
+		startReplay();
+		return true;
+	}
+
 	if(requestQueue.full()) {
 		return false;
 	}
@@ -255,18 +420,11 @@ bool MqttClient::publish(const String& topic, const String& content, uint8_t fla
 	message->common.dup = static_cast<mqtt_dup_t>((flags >> 3) & 0x01);
 
 	if(!copyString(message->publish.topic_name, topic) || !copyString(message->publish.content, content)) {
-		delete message;
+		deleteMessage(message);
 		return false;
 	}
 
-	bool success = requestQueue.enqueue(message);
-	if(success) {
-		// Try to force-send message to decrease latency.
-		// Should work for small size messages but there is no guarantee.
-		commit();
-	}
-
-	return success;
+	return enqueue(message, topic.length() + content.length());
 }
 
 bool MqttClient::publish(const String& topic, IDataSourceStream* stream, uint8_t flags)
@@ -287,7 +445,7 @@ bool MqttClient::publish(const String& topic, IDataSourceStream* stream, uint8_t
 	message->common.dup = static_cast<mqtt_dup_t>((flags >> 3) & 0x01);
 
 	if(!copyString(message->publish.topic_name, topic)) {
-		delete message;
+		deleteMessage(message);
 		delete stream;
 		return false;
 	}
@@ -295,14 +453,110 @@ bool MqttClient::publish(const String& topic, IDataSourceStream* stream, uint8_t
 	message->publish.content.length = MQTT_PUBLISH_STREAM;
 	message->publish.content.data = (uint8_t*)stream;
 
-	bool success = requestQueue.enqueue(message);
-	if(success) {
-		// Try to force-send message to decrease latency.
-		// Should work for small size messages but there is no guarantee.
+	if(!enqueue(message, getPayloadSize(*message))) {
+		message->publish.content.data = nullptr;
+		deleteMessage(message);
+		delete stream;
+		return false;
+	}
+
+	return true;
+}
+
+bool MqttClient::publish(const String& topic, const EventPayload& payload, uint8_t flags)
+{
+	return publish(topic, payload.createStream(), flags);
+}
+
+bool MqttClient::enqueue(mqtt_message_t* message, size_t size)
+{
+	if(maxQueuedBytes != 0 && queuedBytes + size > maxQueuedBytes) {
+		debug_w("[MQTT] Queue limit reached, %u bytes queued", queuedBytes);
+		return false;
+	}
+
+	if(!requestQueue.enqueue(message)) {
+		return false;
+	}
+
+	queuedBytes += size;
+
+	// Send immediately if the link is idle to decrease latency.
+	// Otherwise messages accumulate and are sent together when the server acknowledges previous data.
+	if(tcp != nullptr && tcp_sndqueuelen(tcp) == 0) {
 		commit();
 	}
 
-	return success;
+	return true;
+}
+
+void MqttClient::setOutbox(MqttOutbox* outbox)
+{
+	this->outbox = outbox;
+	replayTimer.stop();
+	if(outbox != nullptr) {
+		// Anything read previously but not consumed must be sent again
+		outbox->rewind();
+		startReplay();
+	}
+}
+
+void MqttClient::startReplay()
+{
+	if(outbox == nullptr || outbox->getPendingCount() == 0 || !bitsSet(flags, MQTT_CLIENT_CONNECTED) ||
+	   replayTimer.isStarted()) {
+		return;
+	}
+
+	debug_d("[MQTT] Replaying %u messages from outbox", outbox->getPendingCount());
+	replayTimer.initializeMs(replayInterval, staticReplayCallback, this).start();
+}
+
+void MqttClient::staticReplayCallback(void* arg)
+{
+	auto client = static_cast<MqttClient*>(arg);
+	if(client->outbox == nullptr || client->outbox->getPendingCount() == 0 ||
+	   !bitsSet(client->flags, MQTT_CLIENT_CONNECTED)) {
+		client->replayTimer.stop();
+		return;
+	}
+
+	client->replayDue = true;
+	if(client->tcp != nullptr) {
+		client->commit();
+	}
+}
+
+mqtt_message_t* MqttClient::readOutbox(MqttOutbox::RecordId& id)
+{
+	// Wait for space in the window as an acknowledgement may be required
+	if(!replayDue || outbox == nullptr || !bitsSet(flags, MQTT_CLIENT_CONNECTED) || inflightCount >= getInflightLimit()) {
+		return nullptr;
+	}
+
+	MqttOutbox::Message stored;
+	if(!outbox->read(stored)) {
+		return nullptr;
+	}
+	replayDue = false;
+
+	auto message = createMessage(MQTT_TYPE_PUBLISH);
+	if(message == nullptr) {
+		return nullptr;
+	}
+
+	message->common.retain = static_cast<mqtt_retain_t>((stored.flags >> 0) & 0x01);
+	message->common.qos = static_cast<mqtt_qos_t>((stored.flags >> 1) & 0x03);
+	message->common.dup = static_cast<mqtt_dup_t>((stored.flags >> 3) & 0x01);
+
+	if(!copyString(message->publish.topic_name, stored.topic) || !copyString(message->publish.content, stored.content)) {
+		deleteMessage(message);
+		return nullptr;
+	}
+
+	id = stored.id;
+	queuedBytes += getPayloadSize(*message);
+	return message;
 }
 
 bool MqttClient::subscribe(const String& topic)
@@ -345,82 +599,199 @@ bool MqttClient::unsubscribe(const String& topic)
 	return requestQueue.enqueue(message);
 }
 
-void MqttClient::onReadyToSendData(TcpConnectionEvent sourceEvent)
+size_t MqttClient::writeMessage(mqtt_message_t* message, IDataSourceStream*& payloadStream)
 {
-	switch(state) {
-	REENTER:
-	case eMCS_Ready: {
-		if(outgoingMessage != &connectMessage) {
-			deleteMessage(outgoingMessage);
+	debug_d("[MQTT] Sending message type %u", message->common.type);
+
+	payloadStream = nullptr;
+	if(message->common.type == MQTT_TYPE_PUBLISH && message->publish.content.length == MQTT_PUBLISH_STREAM) {
+		payloadStream = reinterpret_cast<IDataSourceStream*>(message->publish.content.data);
+		if(payloadStream) {
+			message->publish.content.length = payloadStream->available();
 		}
+	}
+
+	size_t packetLength = mqtt_serialiser_size(&serialiser, message);
+	if(!packetLength) {
+		debug_e("Error: Invalid MQTT message detected!");
+		if(payloadStream != nullptr) {
+			message->publish.content.data = nullptr;
+			delete payloadStream;
+			payloadStream = nullptr;
+		}
+		return 0;
+	}
+
+	if(payloadStream != nullptr) {
+		// The packetLength should be big enough for the header ONLY.
+		// Payload will be attached as a second stream
+		packetLength -= message->publish.content.length;
+		message->publish.content.data = nullptr;
+	}
+
+	uint8_t packet[packetLength];
+	mqtt_serialiser_write(&serialiser, message, packet, packetLength);
+
+	if(mqtt5 && mqtt5->encode(packet, packetLength)) {
+		auto& encoded = mqtt5->getEncoded();
+		send(encoded.c_str(), encoded.length());
+		packetLength = encoded.length();
+	} else {
+		send(reinterpret_cast<const char*>(packet), packetLength);
+	}
+	if(payloadStream != nullptr) {
+		send(payloadStream);
+	}
+
+	return packetLength;
+}
+
+bool MqttClient::sendBatch()
+{
+	size_t batchLength{0};
+	IDataSourceStream* payloadStream{nullptr};
+
+	// Stop after a payload stream as any further packets must follow it
+	while(payloadStream == nullptr && batchLength < MQTT_SEND_BATCH_SIZE) {
 		if(connectQueued) {
-			outgoingMessage = &connectMessage;
 			connectQueued = false;
-		} else {
-			outgoingMessage = requestQueue.dequeue();
+			batchLength += writeMessage(&connectMessage, payloadStream);
+			// Resend anything not acknowledged during the previous connection
+			for(unsigned i = 0; i < inflightCount; ++i) {
+				inflight[i].pending = true;
+			}
+			continue;
 		}
-		if(!outgoingMessage) {
-			// Send PINGREQ every PingRepeatTime time, if there is no outgoing traffic
-			if(!pingTimer.expired()) {
+
+		// Retransmissions take priority over new messages
+		InflightMessage* entry{nullptr};
+		for(unsigned i = 0; i < inflightCount; ++i) {
+			if(inflight[i].pending || inflight[i].timer.expired()) {
+				entry = &inflight[i];
 				break;
 			}
-
-			outgoingMessage = createMessage(MQTT_TYPE_PINGREQ);
 		}
-
-		debug_d("[MQTT] Sending message type %u", outgoingMessage->common.type);
-
-		IDataSourceStream* payloadStream{nullptr};
-		if(outgoingMessage->common.type == MQTT_TYPE_PUBLISH &&
-		   outgoingMessage->publish.content.length == MQTT_PUBLISH_STREAM) {
-			payloadStream = reinterpret_cast<IDataSourceStream*>(outgoingMessage->publish.content.data);
-			if(payloadStream) {
-				outgoingMessage->publish.content.length = payloadStream->available();
+		if(entry != nullptr) {
+			if(entry->message == nullptr) {
+				debug_w("[MQTT] Message %u not acknowledged, cannot retransmit stream", entry->id);
+				releaseInflight(entry);
+				continue;
 			}
+			if(!entry->pending) {
+				debug_d("[MQTT] Retransmitting message %u", entry->id);
+				if(entry->message->common.type == MQTT_TYPE_PUBLISH) {
+					entry->message->common.dup = MQTT_DUP_TRUE;
+				}
+			}
+			entry->pending = false;
+			entry->timer.reset(retransmitTimeout);
+			batchLength += writeMessage(entry->message, payloadStream);
+			continue;
 		}
 
-		size_t packetLength = mqtt_serialiser_size(&serialiser, outgoingMessage);
-		if(!packetLength) {
-			debug_e("Error: Invalid MQTT message detected!");
+		// Queued messages take priority over those stored in the outbox
+		MqttOutbox::RecordId outboxRecord{};
+		auto message = requestQueue.peek();
+		if(message == nullptr) {
+			message = readOutbox(outboxRecord);
+			if(message == nullptr) {
+				break;
+			}
+		} else if(requiresAcknowledgement(*message) && inflightCount >= getInflightLimit()) {
 			break;
+		} else {
+			requestQueue.dequeue();
 		}
 
-		if(outgoingMessage->common.type == MQTT_TYPE_PUBLISH && payloadStream != nullptr) {
-			// The packetLength should be big enough for the header ONLY.
-			// Payload will be attached as a second stream
-			packetLength -= outgoingMessage->publish.content.length;
-			outgoingMessage->publish.content.data = nullptr;
+		bool track = requiresAcknowledgement(*message);
+
+		size_t size = getPayloadSize(*message);
+		switch(message->common.type) {
+		case MQTT_TYPE_PUBLISH:
+			if(track) {
+				message->publish.message_id = getNextMessageId();
+			}
+			break;
+		case MQTT_TYPE_SUBSCRIBE:
+			message->subscribe.message_id = getNextMessageId();
+			break;
+		case MQTT_TYPE_UNSUBSCRIBE:
+			message->unsubscribe.message_id = getNextMessageId();
+			break;
+		default:
+			break;
 		}
 
-		uint8_t packet[packetLength];
-		mqtt_serialiser_write(&serialiser, outgoingMessage, packet, packetLength);
+		auto length = writeMessage(message, payloadStream);
+		batchLength += length;
+		if(!track || length == 0) {
+			if(outboxRecord) {
+				outbox->consume(outboxRecord);
+			}
+			queuedBytes -= size;
+			deleteMessage(message);
+			continue;
+		}
 
-		send(reinterpret_cast<const char*>(packet), packetLength);
+		auto& newEntry = inflight[inflightCount++];
+		newEntry.id = message->publish.message_id;
+		newEntry.awaiting = (message->common.qos == MQTT_QOS_AT_LEAST_ONCE) ? MQTT_TYPE_PUBACK : MQTT_TYPE_PUBREC;
+		newEntry.size = size;
+		newEntry.pending = false;
+		newEntry.timer.reset(retransmitTimeout);
+		newEntry.outboxRecord = outboxRecord;
 		if(payloadStream != nullptr) {
-			send(payloadStream);
+			// Content has been handed to the TCP connection
+			deleteMessage(message);
+			message = nullptr;
 		}
+		newEntry.message = message;
+	}
 
-		state = eMCS_SendingData;
+	if(batchLength != 0) {
+		return true;
 	}
 
-	case eMCS_SendingData:
+	// Send PINGREQ every PingRepeatTime time, if there is no outgoing traffic
+	if(!pingTimer.expired()) {
+		return false;
+	}
+
+	auto message = createMessage(MQTT_TYPE_PINGREQ);
+	writeMessage(message, payloadStream);
+	deleteMessage(message);
+	return true;
+}
+
+void MqttClient::onReadyToSendData(TcpConnectionEvent sourceEvent)
+{
+	// Packets queued in this callback, including any nested calls, are combined into full segments
+	bool outermost = !isCorked();
+	cork();
+
+	if(state == eMCS_SendingData) {
 		pingTimer.start();
-		if(stream != nullptr && !stream->isFinished()) {
-			break;
+		if(stream == nullptr || stream->isFinished()) {
+			state = eMCS_Ready;
 		}
+	}
 
-		state = eMCS_Ready;
-		goto REENTER;
-
-	default:
-		break;
+	if(state == eMCS_Ready && sendBatch()) {
+		pingTimer.start();
+		state = eMCS_SendingData;
 	}
 
 	TcpClient::onReadyToSendData(sourceEvent);
+
+	if(outermost) {
+		uncork();
+	}
 }
 
 void MqttClient::onFinished(TcpClientState finishState)
 {
 	clearBits(flags, MQTT_CLIENT_CONNECTED);
+	replayTimer.stop();
+	replayDue = false;
 	TcpClient::onFinished(finishState);
 }
@@ -17,7 +17,11 @@
 #include <WHashMap.h>
 #include <Data/ObjectQueue.h>
 #include <Platform/Timers.h>
+#include <SimpleTimer.h>
+#include <memory>
 #include "Mqtt/MqttPayloadParser.h"
+#include "Mqtt/MqttOutbox.h"
+#include "Mqtt/Mqtt5Codec.h"
 #include "mqtt-codec/src/message.h"
 #include "mqtt-codec/src/serialiser.h"
 #include "mqtt-codec/src/parser.h"
@@ -34,11 +38,47 @@ enum MqttClientState { eMCS_Ready = 0, eMCS_SendingData };
 #define MQTT_REQUEST_POOL_SIZE 10
 #endif
 
+/**
+ * @brief Maximum number of unacknowledged QoS 1 or 2 messages
+ */
+#ifndef MQTT_INFLIGHT_WINDOW
+#define MQTT_INFLIGHT_WINDOW 8
+#endif
+
+/**
+ * @brief Default time in milliseconds before an unacknowledged message is sent again
+ */
+#ifndef MQTT_RETRANSMIT_TIMEOUT
+#define MQTT_RETRANSMIT_TIMEOUT 5000
+#endif
+
+/**
+ * @brief Default limit on publish payload bytes queued or awaiting acknowledgement. 0 means no limit.
+ */
+#ifndef MQTT_MAX_QUEUED_BYTES
+#define MQTT_MAX_QUEUED_BYTES 0
+#endif
+
+/**
+ * @brief Small packets are combined into a single TCP write up to this size
+ */
+#ifndef MQTT_SEND_BATCH_SIZE
+#define MQTT_SEND_BATCH_SIZE 1024
+#endif
+
+/**
+ * @brief Default interval in milliseconds between messages replayed from the outbox
+ */
+#ifndef MQTT_OUTBOX_REPLAY_INTERVAL
+#define MQTT_OUTBOX_REPLAY_INTERVAL 100
+#endif
+
 #define MQTT_CLIENT_CONNECTED bit(1)
 
 #define MQTT_FLAG_RETAINED 1
 
 class MqttClient;
+class EventPayload;
 
 using MqttDelegate = Delegate<int(MqttClient& client, mqtt_message_t* message)>;
 using MqttRequestQueue = ObjectQueue<mqtt_message_t, MQTT_REQUEST_POOL_SIZE>;
@@ -109,6 +149,15 @@ public:
 	 */
 	bool publish(const String& topic, IDataSourceStream* stream, uint8_t flags = 0);
 
+	/**
+	 * @brief Publish shared content
+	 * @param topic
+	 * @param payload Content is read directly from the shared buffer, not copied
+	 * @param flags Optional flags
+	 * @retval bool
+	 */
+	bool publish(const String& topic, const EventPayload& payload, uint8_t flags = 0);
+
 	/**
 	 * @brief Subscribe to a topic
 	 * @param topic
@@ -123,6 +172,104 @@ public:
 	 */
 	bool unsubscribe(const String& topic);
 
+	/**
+	 * @brief Select protocol version
+	 * @param version 4 for MQTT 3.1.1 (the default) or 5 for MQTT 5
+	 * @retval bool false if version is not supported, or connection is active
+	 *
+	 * With MQTT 5, frequently published topics are sent using topic aliases and the server's
+	 * receive maximum limits the inflight window. Use `getMqtt5()` to set message expiry and user properties.
+	 */
+	bool setProtocolVersion(uint8_t version);
+
+	/**
+	 * @brief Get MQTT 5 settings and state
+	 * @retval Mqtt5Codec* nullptr unless protocol version 5 is selected
+	 */
+	Mqtt5Codec* getMqtt5()
+	{
+		return mqtt5.get();
+	}
+
+	/**
+	 * @brief Set maximum number of QoS 1 or 2 messages which may be awaiting acknowledgement
+	 * @param count Number of messages, from 1 to MQTT_INFLIGHT_WINDOW
+	 *
+	 * Further messages are held in the request queue until the window has space.
+	 */
+	void setInflightWindow(uint8_t count)
+	{
+		inflightWindow = std::max(uint8_t(1), std::min(count, uint8_t(MQTT_INFLIGHT_WINDOW)));
+	}
+
+	/**
+	 * @brief Get number of messages awaiting acknowledgement
+	 */
+	uint8_t getInflightCount() const
+	{
+		return inflightCount;
+	}
+
+	/**
+	 * @brief Get number of requests waiting to be sent
+	 */
+	unsigned getQueueLength() const
+	{
+		return requestQueue.count();
+	}
+
+	/**
+	 * @brief Set time after which unacknowledged messages are sent again
+	 * @param milliseconds
+	 */
+	void setRetransmitTimeout(uint16_t milliseconds)
+	{
+		retransmitTimeout = milliseconds;
+	}
+
+	/**
+	 * @brief Limit the amount of publish data which may be queued
+	 * @param bytes Total topic and payload size for messages queued or awaiting acknowledgement, 0 for no limit
+	 *
+	 * When the limit is reached, `publish()` will fail.
+	 */
+	void setMaxQueuedBytes(size_t bytes)
+	{
+		maxQueuedBytes = bytes;
+	}
+
+	/**
+	 * @brief Get total topic and payload size for messages queued or awaiting acknowledgement
+	 */
+	size_t getQueuedBytes() const
+	{
+		return queuedBytes;
+	}
+
+	/**
+	 * @brief Store messages in flash whilst the server cannot be reached
+	 * @param outbox The outbox, which must have been initialised with `begin()`. Pass nullptr to disable.
+	 *
+	 * When set, messages published whilst disconnected, or when the request queue is full, are appended
+	 * to the outbox. After connection they are replayed in order at the rate set by `setOutboxReplayInterval()`.
+	 * Whilst the outbox contains unsent messages new ones are also added to it, so ordering is preserved.
+	 *
+	 * Messages are removed from the outbox only when acknowledged (QoS 1 or 2) or sent (QoS 0).
+	 * Messages published from a stream are not stored.
+	 *
+	 * The outbox is not owned by the client.
+	 */
+	void setOutbox(MqttOutbox* outbox);
+
+	/**
+	 * @brief Set interval between messages replayed from the outbox
+	 * @param milliseconds
+	 */
+	void setOutboxReplayInterval(uint16_t milliseconds)
+	{
+		replayInterval = std::max(milliseconds, uint16_t(1));
+	}
+
 	/**
 	 * @brief Register a callback function to be invoked on incoming event notification
 	 * @param type Type of event to be notified of
@@ -228,6 +375,39 @@ private:
 	static int staticOnMessageEnd(void* user_data, mqtt_message_t* message);
 	int onMessageEnd(mqtt_message_t* message);
 
+	/*
+	 * A QoS 1 or 2 message awaiting acknowledgement
+	 */
+	struct InflightMessage {
+		mqtt_message_t* message;		   ///< Message to retransmit, nullptr if this isn't possible
+		size_t size;					   ///< Included in queuedBytes
+		uint16_t id;					   ///< Packet identifier
+		mqtt_type_t awaiting;			   ///< PUBACK, PUBREC or PUBCOMP
+		bool pending;					   ///< Send at next opportunity
+		OneShotFastMs timer;			   ///< Retransmission timer
+		MqttOutbox::RecordId outboxRecord; ///< Outbox record to consume on acknowledgement
+	};
+
+	bool parse(const uint8_t* data, size_t length);
+	bool enqueue(mqtt_message_t* message, size_t size);
+	bool sendBatch();
+	size_t writeMessage(mqtt_message_t* message, IDataSourceStream*& payloadStream);
+	uint16_t getNextMessageId();
+	InflightMessage* findInflight(uint16_t id, mqtt_type_t awaiting);
+	void releaseInflight(InflightMessage* entry);
+	void handleAcknowledgement(mqtt_message_t* message);
+
+	/*
+	 * Effective window, as MQTT 5 servers may accept fewer messages
+	 */
+	unsigned getInflightLimit() const
+	{
+		return mqtt5 ? std::min(unsigned(inflightWindow), unsigned(mqtt5->getReceiveMaximum())) : inflightWindow;
+	}
+	mqtt_message_t* readOutbox(MqttOutbox::RecordId& id);
+	void startReplay();
+	static void staticReplayCallback(void* arg);
+
 private:
 	Url url;
 
@@ -249,11 +429,26 @@ private:
 	MqttRequestQueue requestQueue;
 	mqtt_message_t connectMessage;
 	bool connectQueued = false; ///< True if our connect message needs to be sent
-	mqtt_message_t* outgoingMessage = nullptr;
 	mqtt_message_t incomingMessage;
+	uint16_t messageId = 0;
+	size_t queuedBytes = 0;
+	size_t maxQueuedBytes = MQTT_MAX_QUEUED_BYTES;
+
+	// acknowledgement window
+	InflightMessage inflight[MQTT_INFLIGHT_WINDOW];
+	uint8_t inflightCount = 0;
+	uint8_t inflightWindow = MQTT_INFLIGHT_WINDOW;
+	uint16_t retransmitTimeout = MQTT_RETRANSMIT_TIMEOUT;
+
+	// persistent store
+	MqttOutbox* outbox = nullptr;
+	SimpleTimer replayTimer;
+	uint16_t replayInterval = MQTT_OUTBOX_REPLAY_INTERVAL;
+	bool replayDue = false;
 
 	// parsers and serializers
 	mqtt_serialiser_t serialiser;
+	std::unique_ptr<Mqtt5Codec> mqtt5;
 	static const mqtt_parser_callbacks_t callbacks;
 	mqtt_parser_t parser;
 
@@ -11,14 +11,37 @@
 #include "NtpClient.h"
 #include "Platform/Station.h"
 #include "SystemClock.h"
+#include <Platform/RTC.h>
 #include <lwip_includes.h>
+#include <algorithm>
+#include <cstdlib>
+
+namespace
+{
+constexpr uint32_t ntpEpochOffset{0x83AA7E80}; ///< Seconds from 1900 to 1970
+constexpr int64_t nsPerSecond{1000000000LL};
+
+uint64_t getTimestamp(pbuf* buf, unsigned offset)
+{
+	uint32_t value[2];
+	pbuf_copy_partial(buf, value, sizeof(value), offset);
+	return (uint64_t(ntohl(value[0])) << 32) | ntohl(value[1]);
+}
+
+void setTimestamp(char* packet, uint64_t timestamp)
+{
+	uint32_t value[2]{htonl(timestamp >> 32), htonl(uint32_t(timestamp))};
+	memcpy(packet, value, sizeof(value));
+}
+
+} // namespace
 
 NtpClient::NtpClient(const String& reqServer, unsigned reqIntervalSeconds, NtpTimeResultDelegate delegateFunction)
 {
 	// Setup timer, but don't start it
-	timer.setCallback(TimerDelegate(&NtpClient::requestTime, this));
+	timer.setCallback(TimerDelegate(&NtpClient::onTimer, this));
 
-	this->server = reqServer ?: NTP_DEFAULT_SERVER;
+	setNtpServer(reqServer ?: NTP_DEFAULT_SERVER);
 	this->delegateCompleted = delegateFunction;
 	if(!delegateFunction) {
 		autoUpdateSystemClock = true;
@@ -33,11 +56,59 @@ NtpClient::NtpClient(const String& reqServer, unsigned reqIntervalSeconds, NtpTi
 	}
 }
 
+void NtpClient::setNtpServer(const String& server)
+{
+	Dns.cancel(this);
+	serverCount = 0;
+	addNtpServer(server);
+}
+
+bool NtpClient::addNtpServer(const String& server)
+{
+	if(serverCount >= NTP_MAX_SERVERS) {
+		return false;
+	}
+
+	servers[serverCount++] = Server{server, IpAddress(), 0};
+	return true;
+}
+
+int64_t NtpClient::timestampToNanoseconds(uint64_t timestamp)
+{
+	uint32_t seconds = timestamp >> 32;
+	uint32_t fraction = timestamp;
+	// Era 0 ends in 2036, and we don't expect times before 1970
+	int64_t unixSeconds = int64_t(seconds) - ntpEpochOffset;
+	if(seconds < ntpEpochOffset) {
+		unixSeconds += 0x100000000LL;
+	}
+	return unixSeconds * nsPerSecond + int64_t((uint64_t(fraction) * nsPerSecond) >> 32);
+}
+
+uint64_t NtpClient::nanosecondsToTimestamp(int64_t nanoseconds)
+{
+	uint32_t seconds = uint32_t(nanoseconds / nsPerSecond) + ntpEpochOffset;
+	uint32_t fraction = (uint64_t(nanoseconds % nsPerSecond) << 32) / nsPerSecond;
+	return (uint64_t(seconds) << 32) | fraction;
+}
+
+void NtpClient::onTimer()
+{
+	if(!querying) {
+		requestTime();
+	} else if(burstRemaining != 0) {
+		sendRequests();
+	} else {
+		completeQuery();
+	}
+}
+
 void NtpClient::requestTime()
 {
 	debug_d("NtpClient::requestTime()");
 
 	// Schedule a retry in anticipation of failure
+	querying = false;
 	startTimer(NTP_CONNECTION_TIMEOUT_MS);
 
 	if(!WifiStation.isConnected()) {
@@ -45,44 +116,60 @@ void NtpClient::requestTime()
 		return;
 	}
 
-	ip_addr_t resolvedIp;
-	int result = dns_gethostbyname(
-		server.c_str(), &resolvedIp,
-		[](const char* name, LWIP_IP_ADDR_T* ip, void* arg) {
-			// We do a new request since the last one was never done.
-			if(ip)
-				reinterpret_cast<NtpClient*>(arg)->internalRequestTime(*ip);
-		},
-		this);
+	querying = true;
+	haveSample = false;
+	burstRemaining = burstCount;
 
-	debug_d("dns_gethostbyname() returned %d", result);
+	for(unsigned i = 0; i < serverCount; ++i) {
+		auto& server = servers[i];
+		server.originate = 0;
+		int result = Dns.resolve(
+			server.name, server.ip,
+			[this, i](const String& name, IpAddress ip) {
+				if(ip.isNull()) {
+					return;
+				}
+				servers[i].ip = ip;
+				// Join the current query
+				if(querying && servers[i].originate == 0) {
+					internalRequestTime(i);
+				}
+			},
+			this);
 
-	switch(result) {
-	case ERR_OK:
-		// Documentation says this will be the result if the string is already
-		// an ip address in dotted decimal form or if the host is found in dns cache.
-		// however I'm not sure if the dns cache is working since this never seems to
-		// be called for a host lookup other than an ip address.
-		// Doesn't really matter since the loockup will be fast anyways, the host
-		// is most likely found in the dns cache of the next node the query is sent to.
-		internalRequestTime(resolvedIp);
-		break;
-	case ERR_INPROGRESS:
-		// currently finding ip, internalRequestTime() will be called when its found.
-		debug_d("DNS IP lookup in progress...");
-		break;
-	default:
-		debug_d("DNS lookup error occurred.");
-		break;
+		debug_d("Dns.resolve(%s) returned %d", server.name.c_str(), result);
+
+		if(result != ERR_OK && result != ERR_INPROGRESS) {
+			// Lookup failed: address may still be valid from a previous query
+			debug_d("DNS lookup error occurred.");
+		} else if(result == ERR_INPROGRESS) {
+			// internalRequestTime() will be called when its found
+			server.ip = IpAddress();
+		}
+	}
+
+	sendRequests();
+}
+
+void NtpClient::sendRequests()
+{
+	for(unsigned i = 0; i < serverCount; ++i) {
+		if(!servers[i].ip.isNull()) {
+			internalRequestTime(i);
+		}
 	}
+
+	--burstRemaining;
+	startTimer((burstRemaining != 0) ? NTP_BURST_INTERVAL_MS : NTP_SAMPLE_TIMEOUT_MS);
 }
 
-void NtpClient::internalRequestTime(IpAddress serverIp)
+void NtpClient::internalRequestTime(unsigned index)
 {
-	debug_d("NtpClient::internalRequestTime()");
+	debug_d("NtpClient::internalRequestTime(%u)", index);
 
-	// connect to current active serverIp, on NTP_PORT
-	connect(serverIp, NTP_PORT);
+	if(udp == nullptr && !listen(0)) {
+		return;
+	}
 
 	// Setup the NTP request packet
 	char packet[NTP_PACKET_SIZE] = {0};
@@ -93,16 +180,21 @@ void NtpClient::internalRequestTime(IpAddress serverIp)
 	packet[0] = (NTP_VERSION << 3 | 0x03); // LI (0 = no warning), Protocol version (4), Client mode (3)
 	packet[1] = 0;						   // Stratum, or type of clock, unspecified.
 
-	// Start timer to retry if no response received
-	startTimer(NTP_RESPONSE_TIMEOUT_MS);
+	// Server returns our transmit timestamp as its originate timestamp, identifying the response
+	auto& server = servers[index];
+	server.originate = nanosecondsToTimestamp(RTC.getRtcNanoseconds());
+	setTimestamp(&packet[40], server.originate);
 
-	// Send to server, serverAddress & port is set in connect
-	NtpClient::send(packet, NTP_PACKET_SIZE);
+	sendTo(server.ip, NTP_PORT, packet, NTP_PACKET_SIZE);
 }
 
 void NtpClient::setAutoQuery(bool autoQuery)
 {
 	autoQueryEnabled = autoQuery;
+	if(querying) {
+		// Timer is rescheduled on completion
+		return;
+	}
 	if(autoQueryEnabled) {
 		startTimer(autoQuerySeconds * 1000U);
 	} else {
@@ -120,10 +212,14 @@ void NtpClient::setAutoQueryInterval(unsigned seconds)
 
 void NtpClient::onReceive(pbuf* buf, IpAddress remoteIP, uint16_t remotePort)
 {
+	// Take receive time before anything else
+	int64_t t4 = RTC.getRtcNanoseconds();
+
 	debug_d("NtpClient::onReceive(%s:%u)", remoteIP.toString().c_str(), remotePort);
 
-	stopTimer();
-	auto retry = [this]() { startTimer(NTP_RESPONSE_TIMEOUT_MS); };
+	if(!querying || buf->tot_len < NTP_PACKET_SIZE) {
+		return;
+	}
 
 	// We do some basic check to see if it really is a ntp packet we receive.
 	// NTP version should be set to same as we used to send, NTP_VERSION
@@ -131,33 +227,87 @@ void NtpClient::onReceive(pbuf* buf, IpAddress remoteIP, uint16_t remotePort)
 	// Mode should be set to NTP_MODE_SERVER
 
 	uint8_t versionMode = pbuf_get_at(buf, 0);
+	uint8_t leap = versionMode >> 6;
 	uint8_t ver = (versionMode & 0b00111000) >> 3;
 	uint8_t mode = (versionMode & 0x07);
+	uint8_t stratum = pbuf_get_at(buf, 1);
 
 	if(mode != NTP_MODE_SERVER) {
-		// Received response from another client - retry
-		return retry();
+		// Received response from another client
+		return;
 	}
 
 	if(ver != NTP_VERSION && ver != (NTP_VERSION - 1)) {
-		// Received an unsupported version - retry
-		return retry();
+		// Received an unsupported version
+		return;
+	}
+
+	// Match response against the outstanding request
+	Server* server{nullptr};
+	for(unsigned i = 0; i < serverCount; ++i) {
+		if(servers[i].ip == remoteIP && servers[i].originate != 0) {
+			server = &servers[i];
+			break;
+		}
+	}
+	if(server == nullptr || getTimestamp(buf, 24) != server->originate) {
+		debug_w("[NTP] Unexpected response from %s", remoteIP.toString().c_str());
+		return;
+	}
+	int64_t t1 = timestampToNanoseconds(server->originate);
+	server->originate = 0;
+
+	uint64_t receiveTimestamp = getTimestamp(buf, 32);
+	uint64_t transmitTimestamp = getTimestamp(buf, 40);
+	if(leap == 3 || stratum == 0 || receiveTimestamp == 0 || transmitTimestamp == 0) {
+		// Server unsynchronised, or kiss-of-death
+		debug_w("[NTP] %s unsynchronised (stratum %u)", remoteIP.toString().c_str(), stratum);
+		return;
 	}
 
-	uint32_t timestamp;
-	pbuf_copy_partial(buf, &timestamp, sizeof(timestamp), 40); // Copy only timestamp.
-	timestamp = ntohl(timestamp);
+	auto sample = NtpSample::calculate(t1, timestampToNanoseconds(receiveTimestamp),
+									   timestampToNanoseconds(transmitTimestamp), t4);
+	debug_d("[NTP] %s offset %c%u.%06u s, delay %d us", remoteIP.toString().c_str(), (sample.offset < 0) ? '-' : '+',
+			unsigned(std::abs(sample.offset) / nsPerSecond), unsigned(std::abs(sample.offset) % nsPerSecond / 1000),
+			int(sample.delay / 1000));
 
-	if(timestamp == 0) {
-		// Timestamp is not valid
-		return retry();
+	// Minimum delay gives the smallest error in the offset
+	if(sample.delay >= 0 && (!haveSample || sample.delay < bestSample.delay)) {
+		bestSample = sample;
+		haveSample = true;
 	}
 
-	// Unix time starts on Jan 1 1970, subtract 70 years:
-	uint32_t epoch = timestamp - 0x83AA7E80;
+	// Finish as soon as the final round is answered
+	if(burstRemaining == 0) {
+		for(unsigned i = 0; i < serverCount; ++i) {
+			if(servers[i].originate != 0) {
+				return;
+			}
+		}
+		completeQuery();
+	}
+}
+
+void NtpClient::completeQuery()
+{
+	querying = false;
+	stopTimer();
+
+	if(!haveSample) {
+		// No valid response - retry
+		for(unsigned i = 0; i < serverCount; ++i) {
+			servers[i].originate = 0;
+		}
+		startTimer(NTP_RESPONSE_TIMEOUT_MS);
+		return;
+	}
+
+	lastSample = bestSample;
+	auto now = RTC.getRtcNanoseconds();
+	time_t epoch = (now + bestSample.offset) / nsPerSecond;
 
 	if(autoUpdateSystemClock) {
-		SystemClock.setTime(epoch, eTZ_UTC); // update systemclock utc value
+		updateClock(bestSample);
 	}
 
 	if(delegateCompleted) {
@@ -167,3 +317,32 @@ void NtpClient::onReceive(pbuf* buf, IpAddress remoteIP, uint16_t remotePort)
 	// If auto query is enabled, schedule the next check
 	setAutoQuery(autoQueryEnabled);
 }
+
+void NtpClient::updateClock(const NtpSample& sample)
+{
+	constexpr int64_t stepThreshold{int64_t(NTP_STEP_THRESHOLD_MS) * 1000000};
+
+	if(!clockDiscipline || !SystemClock.isSet() || std::abs(sample.offset) > stepThreshold) {
+		SystemClock.adjustTime(sample.offset, false);
+		lastClockUpdate = clockDiscipline ? RTC.getRtcNanoseconds() : 0;
+		return;
+	}
+
+	/*
+	 * Frequency-lock loop.
+	 * Any error not already being slewed out has accumulated since the last update,
+	 * so gives the residual frequency error. Apply half of it each time to damp the loop.
+	 */
+	auto now = RTC.getRtcNanoseconds();
+	int64_t interval = now - lastClockUpdate;
+	if(lastClockUpdate != 0 && interval >= int64_t(NTP_MIN_FREQUENCY_INTERVAL) * nsPerSecond) {
+		int64_t residual = sample.offset - SystemClock.getPendingAdjustment();
+		int64_t ppb = SystemClock.getFrequencyCorrection() + residual * nsPerSecond / interval / 2;
+		ppb = std::max(std::min(ppb, int64_t(SYSTEM_CLOCK_MAX_FREQUENCY_PPB)), -int64_t(SYSTEM_CLOCK_MAX_FREQUENCY_PPB));
+		SystemClock.setFrequencyCorrection(ppb);
+		debug_i("[NTP] frequency correction %d ppb", int(ppb));
+	}
+
+	SystemClock.adjustTime(sample.offset, true);
+	lastClockUpdate = now;
+}
@@ -17,9 +17,11 @@
 #pragma once
 
 #include "UdpConnection.h"
+#include "DnsResolver.h"
 #include "Platform/System.h"
 #include "Timer.h"
 #include "DateTime.h"
+#include <algorithm>
 
 #define NTP_PORT 123
 #define NTP_PACKET_SIZE 48
@@ -32,9 +34,35 @@
 #define NTP_MIN_AUTOQUERY_SECONDS 10U	 ///< Minimum autoquery interval
 #define NTP_CONNECTION_TIMEOUT_MS 1666U   ///< Time to retry query when network connection unavailable
 #define NTP_RESPONSE_TIMEOUT_MS 20000U	///< Time to wait before retrying NTP query
+#define NTP_MAX_SERVERS 4U				  ///< Maximum number of servers sampled by each query
+#define NTP_BURST_INTERVAL_MS 2000U		  ///< Spacing of requests to each server during a burst
+#define NTP_SAMPLE_TIMEOUT_MS 1000U		  ///< Time to wait for responses to the final request of a burst
+#define NTP_STEP_THRESHOLD_MS 128U		  ///< Larger offsets are corrected by stepping the clock
+#define NTP_MIN_FREQUENCY_INTERVAL 16U	///< Minimum seconds between frequency updates
 
 class NtpClient;
 
+/**
+ * @brief Result of a single NTP exchange
+ */
+struct NtpSample {
+	int64_t offset; ///< Nanoseconds to add to the local clock
+	int64_t delay;  ///< Round-trip delay in nanoseconds, excluding time spent in the server
+
+	/**
+	 * @brief Calculate offset and delay from the exchange timestamps (RFC 5905, section 8)
+	 * @param t1 Client transmit time
+	 * @param t2 Server receive time
+	 * @param t3 Server transmit time
+	 * @param t4 Client receive time
+	 * @note All times are in nanoseconds
+	 */
+	static NtpSample calculate(int64_t t1, int64_t t2, int64_t t3, int64_t t4)
+	{
+		return NtpSample{((t2 - t1) + (t3 - t4)) / 2, (t4 - t1) - (t3 - t2)};
+	}
+};
+
 // Delegate constructor usage: (&YourClass::method, this)
 using NtpTimeResultDelegate = Delegate<void(NtpClient& client, time_t ntpTime)>;
 
@@ -63,6 +91,11 @@ public:
      */
 	NtpClient(const String& reqServer, unsigned reqIntervalSeconds, NtpTimeResultDelegate onTimeReceivedCb = nullptr);
 
+	~NtpClient()
+	{
+		Dns.cancel(this);
+	}
+
 	/** @brief  Request time from NTP server
      *  @note   Instigates request. Result is handled by NTP result handler function if defined
      */
@@ -70,12 +103,66 @@ public:
 
 	/** @brief  Set the NTP server
      *  @param  server IP address or hostname of NTP server
+     *  @note   Replaces any other servers
+     */
+	void setNtpServer(const String& server);
+
+	/** @brief  Add a further server to be sampled by each query
+     *  @param  server IP address or hostname of NTP server
+     *  @retval bool false if there are already NTP_MAX_SERVERS
+     */
+	bool addNtpServer(const String& server);
+
+	/** @brief  Set the number of requests sent to each server per query
+     *  @param  count Number of samples, each NTP_BURST_INTERVAL_MS apart
+     *  @note   The sample with the shortest round-trip delay gives the most accurate offset and is used
+     *  for the result. The default is a single sample.
+     */
+	void setBurstCount(uint8_t count)
+	{
+		burstCount = std::max(count, uint8_t(1));
+	}
+
+	/** @brief  Enable / disable gradual correction of the system clock
+     *  @param  enable If true, offsets smaller than NTP_STEP_THRESHOLD_MS are slewed so the clock
+     *  doesn't jump, and successive offsets are used to correct the clock frequency.
+     *  Otherwise the clock is stepped to each new time.
+     *  @note   Has no effect unless auto-update of the system clock is enabled
+     */
+	void setClockDiscipline(bool enable)
+	{
+		clockDiscipline = enable;
+	}
+
+	/** @brief  Get the offset measured by the last successful query
+     *  @retval int64_t Nanoseconds by which the local clock was behind the server
+     */
+	int64_t getOffset() const
+	{
+		return lastSample.offset;
+	}
+
+	/** @brief  Get the round-trip delay measured by the last successful query
+     *  @retval int64_t Nanoseconds
      */
-	void setNtpServer(const String& server)
+	int64_t getDelay() const
 	{
-		this->server = server;
+		return lastSample.delay;
 	}
 
+	/** @brief  Convert an NTP timestamp into Unix time
+     *  @param  timestamp 32-bit seconds and 32-bit fraction since 1900
+     *  @retval int64_t Nanoseconds since 1970
+     *  @note   Timestamps before 1970 are taken to be from the next NTP era, beginning 2036
+     */
+	static int64_t timestampToNanoseconds(uint64_t timestamp);
+
+	/** @brief  Convert Unix time into an NTP timestamp
+     *  @param  nanoseconds Nanoseconds since 1970
+     *  @retval uint64_t NTP timestamp
+     */
+	static uint64_t nanosecondsToTimestamp(int64_t nanoseconds);
+
 	/** @brief  Enable / disable periodic query
      *  @param  autoQuery True to enable periodic query of NTP server
      */
@@ -103,9 +190,23 @@ protected:
 	void onReceive(pbuf* buf, IpAddress remoteIP, uint16_t remotePort) override;
 
 	/** @brief  Send time request to NTP server
-     *  @param  serverIp IP address of NTP server
+     *  @param  index Which server to send to
+     */
+	void internalRequestTime(unsigned index);
+
+	/** @brief  Send a request to every server for which an address is known
+     */
+	void sendRequests();
+
+	/** @brief  Called when all requests in a burst have been answered or timed out
      */
-	void internalRequestTime(IpAddress serverIp);
+	void completeQuery();
+
+	/** @brief  Update the system clock using the result of a query
+     */
+	void updateClock(const NtpSample& sample);
+
+	void onTimer();
 
 	/** @brief Start the timer running
 	 *  @param milliseconds Time to run in milliseconds
@@ -124,13 +225,28 @@ protected:
 	}
 
 protected:
-	String server; ///< IP address or Hostname of NTP server
+	struct Server {
+		String name;		 ///< IP address or Hostname of NTP server
+		IpAddress ip;		 ///< Resolved address
+		uint64_t originate; ///< Transmit timestamp of outstanding request, 0 if none
+	};
+
+	Server servers[NTP_MAX_SERVERS];
+	uint8_t serverCount = 0;
 
 	NtpTimeResultDelegate delegateCompleted = nullptr; ///< NTP result handler delegate
 	bool autoUpdateSystemClock = false;				   ///< True to update system clock with NTP time
 	bool autoQueryEnabled = false;
+	bool clockDiscipline = false;
+	bool querying = false;	 ///< A burst is in progress
+	bool haveSample = false;   ///< bestSample is valid
+	uint8_t burstCount = 1;	///< Requests sent to each server per query
+	uint8_t burstRemaining = 0; ///< Requests yet to be sent in current burst
 	unsigned autoQuerySeconds = NTP_DEFAULT_AUTOQUERY_SECONDS;
-	Timer timer; ///< Deals with timeouts, retries and autoquery updates
+	NtpSample bestSample{};
+	NtpSample lastSample{};
+	uint64_t lastClockUpdate = 0; ///< RTC time of last clock correction, 0 if frequency unknown
+	Timer timer;				  ///< Deals with timeouts, retries, bursts and autoquery updates
 };
 
 /** @} */
@@ -0,0 +1,83 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/SmingHub/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * PbufSlice.cpp
+ *
+ ****/
+
+#include "PbufSlice.h"
+#include "TcpConnection.h"
+#include <debug_progmem.h>
+
+PbufSlice::PbufSlice(TcpConnection& connection, pbuf* buf, size_t offset)
+{
+	if(buf == nullptr || offset >= buf->tot_len) {
+		return;
+	}
+
+	if(buf == connection.receiveBuffer) {
+		pbuf_ref(buf);
+		this->buf = buf;
+		this->offset = offset;
+		this->connection = &connection;
+		connection.receiveSlices.add(this);
+		return;
+	}
+
+	// Not owned by lwIP (e.g. decrypted SSL data) so take a copy
+	size_t length = buf->tot_len - offset;
+	auto copy = pbuf_alloc(PBUF_RAW, length, PBUF_RAM);
+	if(copy == nullptr) {
+		debug_e("[TCP] No memory for %u byte slice", length);
+		return;
+	}
+	pbuf_copy_partial(buf, copy->payload, length, offset);
+	this->buf = copy;
+}
+
+void PbufSlice::moveFrom(PbufSlice& other)
+{
+	buf = other.buf;
+	offset = other.offset;
+	connection = other.connection;
+	other.buf = nullptr;
+	other.offset = 0;
+	other.connection = nullptr;
+	if(connection != nullptr) {
+		connection->receiveSlices.remove(&other);
+		connection->receiveSlices.add(this);
+	}
+}
+
+void PbufSlice::release()
+{
+	if(buf == nullptr) {
+		return;
+	}
+
+	if(connection != nullptr) {
+		// The connection no longer holds a reference, so this is the last one
+		if(buf->ref == 1) {
+			connection->receiveReleased(buf->tot_len);
+		}
+		connection->receiveSlices.remove(this);
+		connection = nullptr;
+	}
+
+	pbuf_free(buf);
+	buf = nullptr;
+	offset = 0;
+}
+
+size_t PbufSlice::read(size_t offset, void* buffer, size_t count) const
+{
+	if(buf == nullptr || offset >= length()) {
+		return 0;
+	}
+
+	count = std::min(count, length() - offset);
+	return pbuf_copy_partial(buf, buffer, count, this->offset + offset);
+}
@@ -0,0 +1,186 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/SmingHub/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * PbufSlice.h
+ *
+ ****/
+
+#pragma once
+
+#include <Data/LinkedObjectList.h>
+#include <lwip/pbuf.h>
+#include <iterator>
+
+class TcpConnection;
+
+/** @addtogroup tcp
+ *  @{
+ */
+
+/**
+ * @brief Reference to received TCP data without copying it
+ *
+ * A slice holds a reference to the chain of lwIP packet buffers passed to `TcpConnection::onReceive()`.
+ * The data remains valid after the receive callback returns, until the slice is released or destroyed.
+ *
+ * Whilst any slice of a received packet is held, lwIP is not told the data has been taken
+ * so the TCP receive window is not re-opened. A slow consumer therefore throttles the sender,
+ * instead of data accumulating in RAM.
+ *
+ * Slices can be moved but not copied. Decrypted SSL data is held in a temporary buffer,
+ * so for SSL connections the data is copied into a new packet buffer.
+ */
+class PbufSlice : public LinkedObjectTemplate<PbufSlice>
+{
+public:
+	/**
+	 * @brief A contiguous block of data within the slice
+	 */
+	struct Segment {
+		const char* data;
+		size_t length;
+	};
+
+	/**
+	 * @brief Iterates through contiguous segments of the slice
+	 */
+	class SegmentIterator : public std::iterator<std::forward_iterator_tag, Segment>
+	{
+	public:
+		SegmentIterator(pbuf* buf, size_t offset) : buf(buf), offset(offset)
+		{
+			skipEmpty();
+		}
+
+		Segment operator*() const
+		{
+			return Segment{static_cast<const char*>(buf->payload) + offset, size_t(buf->len - offset)};
+		}
+
+		SegmentIterator& operator++()
+		{
+			buf = buf->next;
+			offset = 0;
+			skipEmpty();
+			return *this;
+		}
+
+		bool operator==(const SegmentIterator& other) const
+		{
+			return buf == other.buf && offset == other.offset;
+		}
+
+		bool operator!=(const SegmentIterator& other) const
+		{
+			return !operator==(other);
+		}
+
+	private:
+		void skipEmpty()
+		{
+			while(buf != nullptr && offset >= buf->len) {
+				offset -= buf->len;
+				buf = buf->next;
+			}
+		}
+
+		pbuf* buf;
+		size_t offset;
+	};
+
+	PbufSlice()
+	{
+	}
+
+	/**
+	 * @brief Take a reference to received data
+	 * @param connection The connection which received the data
+	 * @param buf As passed to `TcpConnection::onReceive()`
+	 * @param offset Number of bytes to skip at start of buffer
+	 */
+	PbufSlice(TcpConnection& connection, pbuf* buf, size_t offset = 0);
+
+	PbufSlice(PbufSlice&& other)
+	{
+		moveFrom(other);
+	}
+
+	PbufSlice& operator=(PbufSlice&& other)
+	{
+		if(&other != this) {
+			release();
+			moveFrom(other);
+		}
+		return *this;
+	}
+
+	PbufSlice(const PbufSlice&) = delete;
+	PbufSlice& operator=(const PbufSlice&) = delete;
+
+	~PbufSlice()
+	{
+		release();
+	}
+
+	/**
+	 * @brief Release the data
+	 *
+	 * When the last slice of a packet is released the connection receive window is updated.
+	 */
+	void release();
+
+	explicit operator bool() const
+	{
+		return buf != nullptr;
+	}
+
+	/**
+	 * @brief Get number of bytes in the slice
+	 */
+	size_t length() const
+	{
+		return (buf == nullptr) ? 0 : buf->tot_len - offset;
+	}
+
+	/**
+	 * @brief Skip data at the start of the slice
+	 * @param count Number of bytes already processed
+	 */
+	void skip(size_t count)
+	{
+		offset += std::min(count, length());
+	}
+
+	/**
+	 * @brief Copy data from the slice
+	 * @param offset Position relative to start of slice
+	 * @param buffer
+	 * @param count Number of bytes to copy
+	 * @retval size_t Number of bytes copied
+	 */
+	size_t read(size_t offset, void* buffer, size_t count) const;
+
+	SegmentIterator begin() const
+	{
+		return SegmentIterator(buf, offset);
+	}
+
+	SegmentIterator end() const
+	{
+		return SegmentIterator(nullptr, 0);
+	}
+
+private:
+	friend class TcpConnection;
+
+	void moveFrom(PbufSlice& other);
+
+	TcpConnection* connection{nullptr}; ///< Set if receive window awaits release
+	pbuf* buf{nullptr};
+	size_t offset{0};
+};
+
+/** @} */
@@ -61,10 +61,43 @@
 		break;                                                                                                         \
 	}
 
+namespace
+{
+/*
+ * Get an address in the form required for MAIL and RCPT commands,
+ * e.g. `"Name" <user@example.com>` becomes `<user@example.com>`
+ */
+String getPath(String address)
+{
+	int start = address.indexOf('<');
+	if(start >= 0) {
+		int end = address.indexOf('>', start);
+		return address.substring(start, (end < 0) ? address.length() : end + 1);
+	}
+	address.trim();
+	return '<' + address + '>';
+}
+
+void addRecipients(String list, Vector<String>& recipients)
+{
+	Vector<String> addresses;
+	splitString(list, ',', addresses);
+	for(auto& address : addresses) {
+		address.trim();
+		if(address) {
+			recipients.add(getPath(address));
+		}
+	}
+}
+
+} // namespace
+
 SmtpClient::~SmtpClient()
 {
 	delete outgoingMail;
 	outgoingMail = nullptr;
+	delete pipelinedMail;
+	pipelinedMail = nullptr;
 
 	while(mailQ.count() != 0) {
 		delete mailQ.dequeue();
@@ -79,6 +112,10 @@ bool SmtpClient::connect(const Url& url)
 
 	bool isSecure = (url.Scheme == URI_SCHEME_SMTP_SECURE);
 	this->url = url;
+	state = eSMTP_Banner;
+	options = 0;
+	codeLength = 0;
+	authMethods.clear();
 	return TcpClient::connect(url.Host, url.getPort(), isSecure);
 }
 
@@ -200,18 +237,13 @@ void SmtpClient::onReadyToSendData(TcpConnectionEvent sourceEvent)
 	}
 
 	case eSMTP_SendMail: {
-		sendString(F("MAIL FROM:") + outgoingMail->from + "\r\n");
-		if(options & SMTP_OPT_PIPELINE) {
-			sendString(F("RCPT TO:") + outgoingMail->to + "\r\n");
-			sendString(F("DATA\r\n"));
-		}
-
+		sendEnvelope(outgoingMail);
 		state = eSMTP_SendingMail;
 		break;
 	}
 
 	case eSMTP_SendRcpt: {
-		sendString(F("RCPT TO:") + outgoingMail->to + "\r\n");
+		sendString(F("RCPT TO:") + recipients[recipientIndex] + "\r\n");
 		state = eSMTP_SendingRcpt;
 		break;
 	}
@@ -250,6 +282,14 @@ void SmtpClient::onReadyToSendData(TcpConnectionEvent sourceEvent)
 		stream = nullptr;
 
 		sendString(F("\r\n.\r\n"));
+
+		// Start the next transaction without waiting for this one to be acknowledged (RFC 2920)
+		if((options & SMTP_OPT_PIPELINE) && pipelinedMail == nullptr) {
+			pipelinedMail = mailQ.dequeue();
+			if(pipelinedMail != nullptr) {
+				sendEnvelope(pipelinedMail);
+			}
+		}
 		break;
 	}
 
@@ -282,6 +322,23 @@ MultipartStream::BodyPart SmtpClient::multipartProducer()
 	return result;
 }
 
+void SmtpClient::sendEnvelope(MailMessage* mail)
+{
+	recipients.clear();
+	addRecipients(mail->to, recipients);
+	addRecipients(mail->cc, recipients);
+	recipientIndex = 0;
+
+	sendString(F("MAIL FROM:") + getPath(mail->from) + "\r\n");
+	if(options & SMTP_OPT_PIPELINE) {
+		// Send the whole envelope as one group, with DATA last
+		for(auto& rcpt : recipients) {
+			sendString(F("RCPT TO:") + rcpt + "\r\n");
+		}
+		sendString(F("DATA\r\n"));
+	}
+}
+
 void SmtpClient::sendMailHeaders(MailMessage* mail)
 {
 	mail->getHeaders();
@@ -449,7 +506,11 @@ int SmtpClient::smtpParse(char* buffer, size_t len)
 		case eSMTP_SendingMail: {
 			RETURN_ON_ERROR(SMTP_CODE_REQUEST_OK);
 
-			state = ((options & SMTP_OPT_PIPELINE) ? eSMTP_SendingRcpt : eSMTP_SendRcpt);
+			if(recipients.count() == 0) {
+				state = ((options & SMTP_OPT_PIPELINE) ? eSMTP_SendingData : eSMTP_SendData);
+			} else {
+				state = ((options & SMTP_OPT_PIPELINE) ? eSMTP_SendingRcpt : eSMTP_SendRcpt);
+			}
 
 			break;
 		}
@@ -457,7 +518,12 @@ int SmtpClient::smtpParse(char* buffer, size_t len)
 		case eSMTP_SendingRcpt: {
 			RETURN_ON_ERROR(SMTP_CODE_REQUEST_OK);
 
-			state = ((options & SMTP_OPT_PIPELINE) ? eSMTP_SendingData : eSMTP_SendData);
+			++recipientIndex;
+			if(recipientIndex < recipients.count()) {
+				state = ((options & SMTP_OPT_PIPELINE) ? eSMTP_SendingRcpt : eSMTP_SendRcpt);
+			} else {
+				state = ((options & SMTP_OPT_PIPELINE) ? eSMTP_SendingData : eSMTP_SendData);
+			}
 
 			break;
 		}
@@ -471,13 +537,15 @@ int SmtpClient::smtpParse(char* buffer, size_t len)
 		case eSMTP_Sent: {
 			RETURN_ON_ERROR(SMTP_CODE_REQUEST_OK);
 
-			state = eSMTP_Ready;
-
 			if(messageSentCallback) {
 				messageSentCallback(*this, codeValue, message);
 			}
 			delete outgoingMail;
-			outgoingMail = nullptr;
+
+			// Replies for a pipelined transaction follow
+			outgoingMail = pipelinedMail;
+			pipelinedMail = nullptr;
+			state = (outgoingMail == nullptr) ? eSMTP_Ready : eSMTP_SendingMail;
 
 			break;
 		}
@@ -37,7 +37,9 @@
 #include <Data/ObjectQueue.h>
 
 /* Maximum waiting emails in the mail queue */
+#ifndef SMTP_QUEUE_SIZE
 #define SMTP_QUEUE_SIZE 5
+#endif
 
 /* Buffer size used to read the error messages */
 #define SMTP_ERROR_LENGTH 40
@@ -135,9 +137,13 @@ public:
 	 */
 	MailMessage* getCurrentMessage();
 
+	/**
+	 * @brief Get number of messages waiting to be sent
+	 * @note Includes any message whose transaction has been pipelined ahead of completion of the current message
+	 */
 	size_t countPending()
 	{
-		return mailQ.count();
+		return mailQ.count() + (pipelinedMail ? 1 : 0);
 	}
 
 	/**
@@ -181,6 +187,7 @@ protected:
 
 	void sendMailHeaders(MailMessage* mail);
 	bool sendMailBody(MailMessage* mail);
+	void sendEnvelope(MailMessage* mail);
 
 private:
 	Url url;
@@ -194,6 +201,9 @@ private:
 	uint8_t codeLength{0};
 	int options{0};
 	MailMessage* outgoingMail{nullptr};
+	MailMessage* pipelinedMail{nullptr}; ///< Next message, started before the current one is acknowledged
+	Vector<String> recipients;			 ///< Envelope addresses for the most recently started transaction
+	unsigned recipientIndex{0};			 ///< Number of RCPT commands acknowledged
 	SmtpState state{eSMTP_Banner};
 
 	SmtpClientCallback errorCallback;
@@ -45,12 +45,21 @@ bool TcpClient::send(const char* data, uint16_t len, bool forceCloseAfterSent)
 	}
 
 	auto memoryStream = static_cast<MemoryDataStream*>(stream);
-	if(memoryStream == nullptr || memoryStream->getStreamType() != eSST_MemoryWritable) {
+	bool isNew = (memoryStream == nullptr || memoryStream->getStreamType() != eSST_MemoryWritable);
+	if(isNew) {
+		// Data may accumulate in many small writes, so avoid reallocating a single buffer
 		memoryStream = new MemoryDataStream();
+		if(memoryStream == nullptr) {
+			return false;
+		}
+		memoryStream->setSegmented(true);
 	}
 
 	if(memoryStream->write(data, len) != len) {
 		debug_e("TcpClient::send ERROR: Unable to store %d bytes in buffer", len);
+		if(isNew) {
+			delete memoryStream;
+		}
 		return false;
 	}
 
@@ -60,6 +69,9 @@ bool TcpClient::send(const char* data, uint16_t len, bool forceCloseAfterSent)
 bool TcpClient::send(IDataSourceStream* source, bool forceCloseAfterSent)
 {
 	if(state != eTCS_Connecting && state != eTCS_Connected) {
+		if(source != stream) {
+			delete source;
+		}
 		return false;
 	}
 
@@ -116,6 +128,20 @@ bool TcpClient::send(IDataSourceStream* source, bool forceCloseAfterSent)
 	return true;
 }
 
+size_t TcpClient::getPendingLength() const
+{
+	if(stream == nullptr) {
+		return 0;
+	}
+
+	if(stream->getStreamType() == eSST_Chain) {
+		return static_cast<StreamChain*>(stream)->getPendingLength();
+	}
+
+	int avail = stream->available();
+	return (avail > 0) ? avail : 0;
+}
+
 err_t TcpClient::onConnected(err_t err)
 {
 	if(err == ERR_OK) {
@@ -142,7 +168,15 @@ err_t TcpClient::onReceive(pbuf* buf)
 		success = false;
 	}
 
-	if(success && receive) {
+	if(success && sliceReceive) {
+		PbufSlice slice(*this, buf);
+		if(!sliceReceive(*this, slice)) {
+			debug_d("TcpClient::onReceive: Aborted from receive callback");
+
+			TcpConnection::onReceive(nullptr);
+			return ERR_ABRT; // abort the connection
+		}
+	} else if(success && receive) {
 		pbuf* cur = buf;
 		while(cur != nullptr && cur->len > 0) {
 			bool success = receive(*this, (char*)cur->payload, cur->len);
@@ -17,6 +17,7 @@
 #pragma once
 
 #include "TcpConnection.h"
+#include <ObjectPool.h>
 
 class TcpClient;
 class ReadWriteStream;
@@ -25,6 +26,7 @@ class IpAddress;
 using TcpClientEventDelegate = Delegate<void(TcpClient& client, TcpConnectionEvent sourceEvent)>;
 using TcpClientCompleteDelegate = Delegate<void(TcpClient& client, bool successful)>;
 using TcpClientDataDelegate = Delegate<bool(TcpClient& client, char* data, int size)>;
+using TcpClientSliceDelegate = Delegate<bool(TcpClient& client, PbufSlice& data)>;
 
 enum TcpClientState {
 	eTCS_Ready,
@@ -45,6 +47,8 @@ enum TcpClientCloseAfterSentState {
 
 class TcpClient : public TcpConnection
 {
+	OBJECT_POOL_ALLOCATED(TcpClient, 0)
+
 public:
 	TcpClient(bool autoDestruct) : TcpConnection(autoDestruct)
 	{
@@ -92,6 +96,17 @@ public:
 		receive = receiveCb;
 	}
 
+	/**	@brief	Set or clear the callback for received data as a slice
+	 *	@param	receiveCb callback delegate or nullptr
+	 *	@note	Replaces any callback set by `setReceiveDelegate()`.
+	 *	To retain the data after the callback returns, move the slice into another PbufSlice object.
+	 *	Flow control then follows the consumer: the sender is throttled until the data is released.
+	 */
+	void setSliceReceiveDelegate(TcpClientSliceDelegate receiveCb = nullptr)
+	{
+		sliceReceive = receiveCb;
+	}
+
 	/**	@brief	Set or clear the callback for connection close
 	 *	@param	completeCb callback delegate or nullptr
 	 */
@@ -119,6 +134,12 @@ public:
 	 */
 	bool send(IDataSourceStream* source, bool forceCloseAfterSent = false);
 
+	/**
+	 * @brief Get number of bytes queued for sending but not yet written to the connection
+	 * @note Streams of unknown length are not counted
+	 */
+	size_t getPendingLength() const;
+
 	bool isProcessing()
 	{
 		return state == eTCS_Connected || state == eTCS_Connecting;
@@ -170,6 +191,7 @@ private:
 	TcpClientCompleteDelegate completed;
 	TcpClientEventDelegate ready;
 	TcpClientDataDelegate receive;
+	TcpClientSliceDelegate sliceReceive;
 
 	TcpClientCloseAfterSentState closeAfterSent = eTCCASS_None;
 	uint16_t totalSentConfirmedBytes = 0;
@@ -13,7 +13,9 @@
 #include <Data/Stream/DataSourceStream.h>
 #include "NetUtils.h"
 #include <WString.h>
-#include <lwip/dns.h>
+#include "DnsResolver.h"
+#include <Services/Profiling/Trace.h>
+#include <Clock.h>
 
 #define debug_tcp_e(fmt, ...) debug_e("TCP %p " fmt, this, ##__VA_ARGS__)
 #define debug_tcp_w(fmt, ...) debug_w("TCP %p " fmt, this, ##__VA_ARGS__)
@@ -29,8 +31,15 @@
 TcpConnection::~TcpConnection()
 {
 	autoSelfDestruct = false;
+	Dns.cancel(this);
 	close();
 
+	// Outstanding slices keep their data but no longer affect the receive window
+	for(auto& slice : receiveSlices) {
+		slice.connection = nullptr;
+	}
+	receiveSlices.clear();
+
 	delete ssl;
 
 	debug_tcp_d("~connection");
@@ -71,8 +80,6 @@ bool TcpConnection::connect(const String& server, int port, bool useSsl)
 		initialize(tcpNew);
 	}
 
-	ip_addr_t addr;
-
 	this->useSsl = useSsl;
 	if(useSsl) {
 		if(!sslCreateSession()) {
@@ -84,26 +91,14 @@ bool TcpConnection::connect(const String& server, int port, bool useSsl)
 	debug_tcp_d("connect to \"%s:%d\"", server.c_str(), port);
 	canSend = false; // Wait for connection
 
-	struct DnsLookup {
-		TcpConnection* con;
-		int port;
-	};
-	DnsLookup* look = new DnsLookup{this, port};
-	err_t dnslook = dns_gethostbyname(
-		server.c_str(), &addr,
-		[](const char* name, LWIP_IP_ADDR_T* ipaddr, void* arg) {
-			auto dlook = static_cast<DnsLookup*>(arg);
-			if(dlook != nullptr) {
-				dlook->con->internalOnDnsResponse(name, ipaddr, dlook->port);
-				delete dlook;
-			}
-		},
-		look);
+	IpAddress addr;
+	err_t dnslook = Dns.resolve(
+		server, addr, [this, port](const String& name, IpAddress ip) { internalOnDnsResponse(name, ip, port); },
+		this);
 	if(dnslook == ERR_INPROGRESS) {
 		// Operation pending - see internalOnDnsResponse()
 		return true;
 	}
-	delete look;
 
 	return (dnslook == ERR_OK) ? internalConnect(addr, port) : false;
 }
@@ -126,6 +121,32 @@ void TcpConnection::setTimeOut(uint16_t waitTimeOut)
 {
 	debug_tcp_d("timeout updating: %d -> %d", timeOut, waitTimeOut);
 	timeOut = waitTimeOut;
+	restartTimeOut();
+}
+
+uint32_t TcpConnection::getIdleTime() const
+{
+	return millis() - lastActivity;
+}
+
+void TcpConnection::restartTimeOut()
+{
+	lastActivity = millis();
+
+	if(tcp == nullptr || timeOut == USHRT_MAX) {
+		idleTimer.stop();
+		return;
+	}
+
+	idleTimer.setCallback(staticOnTimeOut, this);
+	idleTimer.start(timeOut * 1000U);
+}
+
+void TcpConnection::staticOnTimeOut(void* arg)
+{
+	auto con = static_cast<TcpConnection*>(arg);
+	debug_d("TCP %p connection closed by timeout: %u", con, con->timeOut);
+	con->close();
 }
 
 err_t TcpConnection::onReceive(pbuf* buf)
@@ -154,13 +175,6 @@ err_t TcpConnection::onSent(uint16_t len)
 
 err_t TcpConnection::onPoll()
 {
-	if(sleep >= timeOut && timeOut != USHRT_MAX) {
-		debug_tcp_d("connection closed by timeout: %d (from %d)", sleep, timeOut);
-
-		close();
-		return ERR_TIMEOUT;
-	}
-
 	trySend(eTCE_Poll);
 
 	return ERR_OK;
@@ -216,6 +230,9 @@ int TcpConnection::write(const char* data, int len, uint8_t apiflags)
 			len = available;
 		}
 
+		if(corked) {
+			apiflags |= TCP_WRITE_FLAG_MORE;
+		}
 		err = tcp_write(tcp, data, len, apiflags);
 	}
 
@@ -244,28 +261,54 @@ int TcpConnection::write(IDataSourceStream* stream)
 			break;
 		}
 
+		/*
+		 * Memory-resident streams can be written directly without an intermediate copy.
+		 * Composite streams may return blocks from several sources so that full segments
+		 * are built in one pass.
+		 * lwIP must still copy the data (TCP_WRITE_FLAG_COPY): the stream is released as soon as
+		 * it is finished, segmented streams return blocks to the pool as they are consumed,
+		 * and lwIP continues to retransmit unacknowledged segments after tcp_close().
+		 */
+		IDataSourceStream::Block blocks[NETWORK_SEND_MAX_BLOCKS];
+		unsigned blockCount = stream->peekBlocks(blocks, ARRAY_SIZE(blocks), available);
 		char buffer[NETWORK_SEND_BUFFER_SIZE];
-		auto bytesRead = stream->readMemoryBlock(buffer, std::min(sizeof(buffer), available));
-		if(bytesRead == 0) {
+		if(blockCount == 0) {
+			blocks[0].data = buffer;
+			blocks[0].length = stream->readMemoryBlock(buffer, std::min(sizeof(buffer), available));
+			if(blocks[0].length != 0) {
+				blockCount = 1;
+			}
+		}
+		if(blockCount == 0) {
 			break;
 		}
 
 		++pushCount;
 
-		int bytesWritten = write(buffer, bytesRead, TCP_WRITE_FLAG_COPY | TCP_WRITE_FLAG_MORE);
-		debug_tcp_d("Written: %d, Available: %u, isFinished: %d, PushCount: %u", bytesWritten, available,
-					stream->isFinished(), pushCount);
-
-		if(bytesWritten < 0) {
-			break;
+		size_t written = 0;
+		int bytesWritten = 0;
+		for(unsigned i = 0; i < blockCount; ++i) {
+			auto& block = blocks[i];
+			bytesWritten = write(block.data, block.length, TCP_WRITE_FLAG_COPY | TCP_WRITE_FLAG_MORE);
+			debug_tcp_d("Written: %d, Available: %u, isFinished: %d, PushCount: %u", bytesWritten, available,
+						stream->isFinished(), pushCount);
+			if(bytesWritten < 0) {
+				break;
+			}
+			written += size_t(bytesWritten);
+			if(size_t(bytesWritten) < block.length) {
+				break;
+			}
 		}
 
-		if(bytesWritten == 0) {
-			continue;
+		if(written != 0) {
+			total += written;
+			stream->seek(written);
 		}
 
-		total += size_t(bytesWritten);
-		stream->seek(bytesWritten);
+		if(bytesWritten < 0) {
+			break;
+		}
 	}
 
 	if(pushCount == 0) {
@@ -288,6 +331,7 @@ void TcpConnection::close()
 	}
 	debug_tcp_d("connection closing");
 
+	idleTimer.stop();
 	tcp_poll(tcp, staticOnPoll, 1);
 	tcp_arg(tcp, nullptr); // reset pointer to close connection on next callback
 	tcp = nullptr;
@@ -304,8 +348,9 @@ void TcpConnection::initialize(tcp_pcb* pcb)
 	tcp = pcb;
 	sleep = 0;
 	canSend = true;
+	restartTimeOut();
 
-	tcp_nagle_disable(tcp);
+	applyNagle();
 	tcp_arg(tcp, this);
 
 	tcp_sent(tcp, [](void* arg, tcp_pcb* tcp, uint16_t len) -> err_t {
@@ -374,8 +419,53 @@ void TcpConnection::closeTcpConnection(tcp_pcb* tpcb)
 	}
 }
 
+void TcpConnection::applyNagle()
+{
+	if(tcp == nullptr) {
+		return;
+	}
+
+	// Nagle's algorithm prevents partial segments being sent whilst corked
+	if(noDelay && !corked) {
+		tcp_nagle_disable(tcp);
+	} else {
+		tcp_nagle_enable(tcp);
+	}
+}
+
+void TcpConnection::setNoDelay(bool enable)
+{
+	noDelay = enable;
+	applyNagle();
+}
+
+void TcpConnection::cork()
+{
+	if(corked) {
+		return;
+	}
+
+	corked = true;
+	applyNagle();
+}
+
+void TcpConnection::uncork()
+{
+	if(!corked) {
+		return;
+	}
+
+	corked = false;
+	applyNagle();
+	flush();
+}
+
 void TcpConnection::flush()
 {
+	if(corked) {
+		return;
+	}
+
 	if(tcp && tcp->state == ESTABLISHED) {
 		debug_tcp_ext("flush()");
 		tcp_output(tcp);
@@ -402,6 +492,7 @@ bool TcpConnection::internalConnect(IpAddress addr, uint16_t port)
 
 err_t TcpConnection::internalOnConnected(err_t err)
 {
+	TRACE_SCOPE("tcp-connected", this);
 	debug_tcp_d("connected: useSSL: %d, Error: %d", useSsl, err);
 
 	if(useSsl && err == ERR_OK) {
@@ -425,7 +516,9 @@ err_t TcpConnection::internalOnConnected(err_t err)
 
 err_t TcpConnection::internalOnReceive(pbuf* p, err_t err)
 {
+	TRACE_SCOPE("tcp-receive", this);
 	sleep = 0;
+	restartTimeOut();
 
 	if(err != ERR_OK /*&& err != ERR_CLSD && err != ERR_RST*/) {
 		debug_tcp_d("receive ERROR %d", err);
@@ -442,15 +535,15 @@ err_t TcpConnection::internalOnReceive(pbuf* p, err_t err)
 		return err == ERR_ABRT ? ERR_ABRT : ERR_OK;
 	}
 
-	//if (tcp != nullptr && tcp->state == ESTABLISHED) // If active
-	/* We have taken the data. */
-	if(p != nullptr) {
-		tcp_recved(tcp, p->tot_len);
-	} else {
+	if(p == nullptr) {
 		debug_tcp_d("receive: pbuf is NULL");
 	}
 
-	if(ssl != nullptr && p != nullptr) {
+	bool decrypt = (ssl != nullptr && p != nullptr);
+	if(decrypt) {
+		/* We have taken the data. */
+		tcp_recved(tcp, p->tot_len);
+
 		bool isConnecting = !ssl->isConnected();
 
 		Ssl::InputBuffer input(p);
@@ -479,13 +572,24 @@ err_t TcpConnection::internalOnReceive(pbuf* p, err_t err)
 				break;
 			}
 		}
+		if(ssl != nullptr) {
+			ssl->endRead();
+		}
 
 	} else {
+		receiveBuffer = p;
 		err = onReceive(p);
+		receiveBuffer = nullptr;
 	}
 
 	if(p != nullptr) {
+		// If any slices are held, the last one to be released updates the receive window
+		uint16_t length = p->tot_len;
+		bool held = !decrypt && p->ref > 1;
 		pbuf_free(p);
+		if(!decrypt && !held && tcp != nullptr) {
+			tcp_recved(tcp, length);
+		}
 		checkSelfFree();
 	} else {
 		close();
@@ -497,7 +601,9 @@ err_t TcpConnection::internalOnReceive(pbuf* p, err_t err)
 
 err_t TcpConnection::internalOnSent(uint16_t len)
 {
+	TRACE_SCOPE("tcp-sent", this);
 	sleep = 0;
+	restartTimeOut();
 	err_t res = onSent(len);
 	checkSelfFree();
 	debug_tcp_ext("<sent");
@@ -518,6 +624,7 @@ err_t TcpConnection::staticOnPoll(void* arg, tcp_pcb* tcp)
 
 err_t TcpConnection::internalOnPoll()
 {
+	TRACE_SCOPE("tcp-poll", this);
 	sleep++;
 	err_t res = onPoll();
 	if(res == ERR_OK) {
@@ -529,22 +636,23 @@ err_t TcpConnection::internalOnPoll()
 
 void TcpConnection::internalOnError(err_t err)
 {
+	TRACE_INSTANT("tcp-error", err);
 	tcp = nullptr; // IMPORTANT. No available connection after error!
+	idleTimer.stop();
 	onError(err);
 	checkSelfFree();
 	debug_tcp_ext("<error");
 }
 
-void TcpConnection::internalOnDnsResponse(const char* name, LWIP_IP_ADDR_T* ipaddr, int port)
+void TcpConnection::internalOnDnsResponse(const String& name, IpAddress ip, int port)
 {
-	if(ipaddr != nullptr) {
-		IpAddress ip = *ipaddr;
-		debug_tcp_d("DNS record found: %s = %s", name, ip.toString().c_str());
+	if(!ip.isNull()) {
+		debug_tcp_d("DNS record found: %s = %s", name.c_str(), ip.toString().c_str());
 
 		internalConnect(ip, port);
 	} else {
 #ifdef NETWORK_DEBUG
-		debug_tcp_d("DNS record _not_ found: %s", name);
+		debug_tcp_d("DNS record _not_ found: %s", name.c_str());
 #endif
 
 		closeTcpConnection(tcp);
@@ -17,12 +17,21 @@
 
 #include <Network/IpConnection.h>
 #include <Network/Ssl/Session.h>
+#include <Network/PbufSlice.h>
+#include <CoalescedTimer.h>
 #include <lwip/tcp.h>
 
 #define NETWORK_DEBUG
 
 #define NETWORK_SEND_BUFFER_SIZE 1024
 
+/**
+ * @brief Maximum number of stream blocks written per pass when sending a stream
+ */
+#ifndef NETWORK_SEND_MAX_BLOCKS
+#define NETWORK_SEND_MAX_BLOCKS 8
+#endif
+
 enum TcpConnectionEvent {
 	eTCE_Connected = 0, ///< Occurs after connection establishment
 	eTCE_Received,		///< Occurs on data receive
@@ -85,8 +94,11 @@ public:
 
 	/** @brief Writes stream data directly to the TCP buffer
 	 *  @param stream
-	 *  @param apiflags TCP_WRITE_FLAG_COPY, TCP_WRITE_FLAG_MORE
 	 *  @retval int negative on error, 0 when retry is needed or positive on success
+	 *  @note Where the stream supports `IDataSourceStream::peekBlocks()` the intermediate stack buffer
+	 *  is avoided, but lwIP still copies the data into its own segments.
+	 *  Passing stream memory to lwIP without copying would require the stream to remain alive
+	 *  and unchanged until every segment is acknowledged, including after the connection is closed.
 	 */
 	int write(IDataSourceStream* stream);
 
@@ -95,8 +107,50 @@ public:
 		return (canSend && tcp) ? tcp_sndbuf(tcp) : 0;
 	}
 
+	/**
+	 * @brief Send any data queued in the TCP buffer
+	 * @note Has no effect whilst the connection is corked
+	 */
 	void flush();
 
+	/**
+	 * @brief Enable or disable Nagle's algorithm
+	 * @param enable true (the default) to send small segments immediately,
+	 * false to hold them back whilst there is unacknowledged data
+	 * @note May be called before the connection is established
+	 */
+	void setNoDelay(bool enable);
+
+	bool getNoDelay() const
+	{
+		return noDelay;
+	}
+
+	/**
+	 * @brief Hold back partial segments so that subsequent writes are combined
+	 *
+	 * Whilst corked, `flush()` has no effect and writes are queued without the PSH flag.
+	 * lwIP may still send full segments, or output queued data when an acknowledgement arrives.
+	 * Call `uncork()` to send whatever remains.
+	 */
+	void cork();
+
+	/**
+	 * @brief Release a previous `cork()` and flush queued data
+	 */
+	void uncork();
+
+	bool isCorked() const
+	{
+		return corked;
+	}
+
+	/**
+	 * @brief Set idle timeout
+	 * @param waitTimeOut Seconds without any data received or sent before connection is closed.
+	 * USHRT_MAX means no timeout.
+	 * @note The timeout is checked with a resolution of `COALESCED_TIMER_SLACK`.
+	 */
 	void setTimeOut(uint16_t waitTimeOut);
 
 	IpAddress getRemoteIp() const
@@ -109,6 +163,12 @@ public:
 		return (tcp == nullptr) ? 0 : tcp->remote_port;
 	}
 
+	/**
+	 * @brief Get time since data was last sent or received
+	 * @retval uint32_t Milliseconds
+	 */
+	uint32_t getIdleTime() const;
+
 	/**
 	 * @brief Sets a callback to be called when the object instance is destroyed
 	 * @param destroyedDelegate
@@ -152,6 +212,7 @@ public:
 
 protected:
 	void initialize(tcp_pcb* pcb);
+	void applyNagle();
 	bool internalConnect(IpAddress addr, uint16_t port);
 
 	bool sslCreateSession();
@@ -169,6 +230,11 @@ protected:
 	}
 
 	virtual err_t onConnected(err_t err);
+
+	/**
+	 * @brief Called when data has been received, or with nullptr when the connection is closed by the remote end
+	 * @note The buffer is freed after this method returns. To retain the data without copying it, create a `PbufSlice`.
+	 */
 	virtual err_t onReceive(pbuf* buf);
 	virtual err_t onSent(uint16_t len);
 	virtual err_t onPoll();
@@ -201,11 +267,25 @@ protected:
 	err_t internalOnSent(uint16_t len);
 	err_t internalOnPoll();
 	void internalOnError(err_t err);
-	void internalOnDnsResponse(const char* name, LWIP_IP_ADDR_T* ipaddr, int port);
+	void internalOnDnsResponse(const String& name, IpAddress ip, int port);
+
+	/**
+	 * @brief Restart the idle timeout following activity
+	 */
+	void restartTimeOut();
+
+	/**
+	 * @brief Stop the idle timeout, for example on a listening connection
+	 */
+	void cancelTimeOut()
+	{
+		idleTimer.stop();
+	}
 
 private:
 	static err_t staticOnPoll(void* arg, tcp_pcb* tcp);
 	static void closeTcpConnection(tcp_pcb* tpcb);
+	static void staticOnTimeOut(void* arg);
 
 	void checkSelfFree()
 	{
@@ -214,18 +294,33 @@ private:
 		}
 	}
 
+	// Called by PbufSlice
+	friend class PbufSlice;
+	void receiveReleased(uint16_t length)
+	{
+		if(tcp != nullptr) {
+			tcp_recved(tcp, length);
+		}
+	}
+
 protected:
 	tcp_pcb* tcp = nullptr;
 	uint16_t sleep = 0;
 	uint16_t timeOut = USHRT_MAX; ///< By default a TCP connection does not have a time out
+	uint32_t lastActivity = 0;	  ///< Value of millis() when activity last occurred
 	bool canSend = true;
 	bool autoSelfDestruct = true;
+	bool noDelay = true;
+	bool corked = false;
 	Ssl::Session* ssl = nullptr;
 	Ssl::Session::InitDelegate sslInit;
 	bool useSsl = false;
 
 private:
 	TcpConnectionDestroyedDelegate destroyedDelegate = nullptr;
+	pbuf* receiveBuffer = nullptr; ///< Buffer owned by lwIP currently passed to onReceive()
+	CoalescedTimer idleTimer;
+	LinkedObjectListTemplate<PbufSlice> receiveSlices;
 };
 
 /** @} */
@@ -9,6 +9,7 @@
  ****/
 
 #include "TcpServer.h"
+#include <Clock.h>
 
 TcpConnection* TcpServer::createClient(tcp_pcb* clientTcp)
 {
@@ -19,6 +20,12 @@ TcpConnection* TcpServer::createClient(tcp_pcb* clientTcp)
 		return nullptr;
 	}
 
+#if ENABLE_OBJECT_POOL
+	if(maxConnections != 0) {
+		TcpClient::getPool().reserve(maxConnections);
+	}
+#endif
+
 	TcpConnection* con = new TcpClient(clientTcp, TcpClientDataDelegate(&TcpServer::onClientReceive, this),
 									   TcpClientCompleteDelegate(&TcpServer::onClientComplete, this));
 
@@ -44,23 +51,102 @@ bool TcpServer::listen(int port, bool useSsl)
 
 	this->useSsl = useSsl;
 
-	tcp = tcp_listen(tcp);
+	tcp = (backlog == 0) ? tcp_listen(tcp) : tcp_listen_with_backlog(tcp, backlog);
 	tcp_accept(tcp, staticAccept);
 
+	// Listening connection has no idle timeout
+	cancelTimeOut();
+
 	return true;
 }
 
-err_t TcpServer::onAccept(tcp_pcb* clientTcp, err_t err)
+bool TcpServer::checkRate(IpAddress ip)
+{
+	auto now = millis();
+	RateEntry* entry{nullptr};
+	RateEntry* oldest{&rateTable[0]};
+	for(auto& e : rateTable) {
+		if(e.count != 0 && e.ip == ip) {
+			entry = &e;
+			break;
+		}
+		// Prefer an unused entry, otherwise recycle the least recently reset
+		if(oldest->count != 0 && (e.count == 0 || uint32_t(now - e.periodStart) > uint32_t(now - oldest->periodStart))) {
+			oldest = &e;
+		}
+	}
+
+	if(entry == nullptr || uint32_t(now - entry->periodStart) >= ratePeriod) {
+		if(entry == nullptr) {
+			entry = oldest;
+			entry->ip = ip;
+		}
+		entry->periodStart = now;
+		entry->count = 0;
+	}
+
+	if(entry->count >= rateLimit) {
+		return false;
+	}
+
+	++entry->count;
+	return true;
+}
+
+bool TcpServer::evictIdleConnection()
+{
+	TcpConnection* victim{nullptr};
+	uint32_t victimIdle{0};
+	for(auto connection : connections) {
+		auto idle = connection->getIdleTime();
+		if(idle >= evictMinIdle && idle >= victimIdle) {
+			victim = connection;
+			victimIdle = idle;
+		}
+	}
+
+	if(victim == nullptr) {
+		return false;
+	}
+
+	debug_i("Evicting connection idle for %u ms", victimIdle);
+	++admissionStats.evicted;
+	victim->close();
+	return true;
+}
+
+bool TcpServer::admit(tcp_pcb* clientTcp)
 {
 	// Anti DDoS :-)
 	if(system_get_free_heap_size() < minHeapSize) {
 		debug_w("\r\n\r\nCONNECTION DROPPED\r\n\t(free heap: %u)\r\n\r\n", system_get_free_heap_size());
-		return ERR_MEM;
+		++admissionStats.rejectedHeap;
+		return false;
+	}
+
+	if(rateLimit != 0 && !checkRate(clientTcp->remote_ip)) {
+		debug_w("CONNECTION DROPPED (rate limit): %s", IpAddress(clientTcp->remote_ip).toString().c_str());
+		++admissionStats.rejectedRate;
+		return false;
 	}
 
 	// Obey any requested connection limit
 	if(maxConnections != 0 && connections.count() >= maxConnections) {
-		debug_w("\r\n\r\nCONNECTION DROPPED\r\n\t(Existing connections: %u)\r\n\r\n", connections.count());
+		if(!evictIdle || !evictIdleConnection() || connections.count() >= maxConnections) {
+			debug_w("\r\n\r\nCONNECTION DROPPED\r\n\t(Existing connections: %u)\r\n\r\n", connections.count());
+			++admissionStats.rejectedLimit;
+			return false;
+		}
+	}
+
+	return true;
+}
+
+err_t TcpServer::onAccept(tcp_pcb* clientTcp, err_t err)
+{
+	// Reject before allocating anything for the connection
+	if(err == ERR_OK && !admit(clientTcp)) {
+		tcp_abort(clientTcp);
 		return ERR_ABRT;
 	}
 
@@ -94,6 +180,7 @@ err_t TcpServer::onAccept(tcp_pcb* clientTcp, err_t err)
 	client->setDestroyedDelegate(TcpConnectionDestroyedDelegate(&TcpServer::onClientDestroy, this));
 
 	connections.add(client);
+	++admissionStats.accepted;
 	debug_d("Opening connection. Total connections: %d", connections.count());
 
 	onClient(reinterpret_cast<TcpClient*>(client));
@@ -30,6 +30,17 @@ using TcpClientConnectDelegate = Delegate<void(TcpClient* client)>;
 class TcpServer : public TcpConnection
 {
 public:
+	/**
+	 * @brief Counts of admission decisions made in `onAccept()`
+	 */
+	struct AdmissionStats {
+		uint32_t accepted;
+		uint32_t rejectedHeap;	///< Insufficient free heap
+		uint32_t rejectedLimit; ///< Connection limit reached and nothing could be evicted
+		uint32_t rejectedRate;	///< Client exceeded connection rate limit
+		uint32_t evicted;		///< Idle connections closed to admit new ones
+	};
+
 	TcpServer() : TcpConnection(false)
 	{
 		TcpConnection::timeOut = TCP_SERVER_TIMEOUT;
@@ -70,6 +81,45 @@ public:
 
 	void setKeepAlive(uint16_t seconds);
 
+	/**
+	 * @brief Limit number of incoming connections waiting to be accepted
+	 * @param backlog 0 to use the default
+	 * @note Must be called before `listen()`. Has no effect unless lwIP is built with TCP_LISTEN_BACKLOG.
+	 * Further connection attempts are ignored by the stack so clients back off and retry.
+	 */
+	void setBacklog(uint8_t backlog)
+	{
+		this->backlog = backlog;
+	}
+
+	/**
+	 * @brief Limit rate at which any single remote IP address may open connections
+	 * @param connections Maximum connections per period, 0 to disable
+	 * @param periodMs
+	 * @note A small table of recently seen addresses is kept, the oldest being recycled
+	 */
+	void setRateLimit(uint8_t connections, uint16_t periodMs = 1000)
+	{
+		rateLimit = connections;
+		ratePeriod = periodMs;
+	}
+
+	/**
+	 * @brief Configure eviction of idle connections when the connection limit is reached
+	 * @param enable When true, the connection which has been idle the longest is closed to make room
+	 * @param minIdleMs Connections idle for less than this time are never evicted
+	 */
+	void setIdleEviction(bool enable, uint16_t minIdleMs = 1000)
+	{
+		evictIdle = enable;
+		evictMinIdle = minIdleMs;
+	}
+
+	const AdmissionStats& getAdmissionStats() const
+	{
+		return admissionStats;
+	}
+
 	void shutdown();
 
 	const Vector<TcpConnection*>& getConnections() const
@@ -87,8 +137,24 @@ protected:
 	virtual void onClientComplete(TcpClient& client, bool successful);
 	virtual void onClientDestroy(TcpConnection& connection);
 
+	/**
+	 * @brief Decide whether to accept a new connection
+	 * @retval bool false to reject. Called before any connection objects are allocated.
+	 */
+	virtual bool admit(tcp_pcb* clientTcp);
+
 private:
+	struct RateEntry {
+		IpAddress ip;
+		uint32_t periodStart; ///< millis()
+		uint16_t count;		  ///< Connections during current period
+	};
+
+	static constexpr unsigned rateTableSize{8};
+
 	static err_t staticAccept(void* arg, tcp_pcb* new_tcp, err_t err);
+	bool checkRate(IpAddress ip);
+	bool evictIdleConnection();
 
 public:
 	uint16_t activeClients = 0;
@@ -106,6 +172,13 @@ private:
 	TcpClientConnectDelegate clientConnectDelegate = nullptr;
 	TcpClientDataDelegate clientReceiveDelegate = nullptr;
 	TcpClientCompleteDelegate clientCompleteDelegate = nullptr;
+	AdmissionStats admissionStats{};
+	RateEntry rateTable[rateTableSize]{};
+	uint16_t ratePeriod = 1000;
+	uint16_t evictMinIdle = 1000;
+	uint8_t rateLimit = 0;
+	uint8_t backlog = 0;
+	bool evictIdle = false;
 };
 
 /** @} */
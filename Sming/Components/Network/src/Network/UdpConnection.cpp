@@ -11,6 +11,124 @@
 #include "UdpConnection.h"
 #include "WString.h"
 #include <debug_progmem.h>
+#include <Platform/System.h>
+
+/*
+ * Queues are held separately from the connection so that a pending task callback
+ * can safely discover the connection has since been destroyed.
+ */
+struct UdpConnection::Batch {
+	struct Datagram {
+		pbuf* buf;
+		IpAddress ip;
+		uint16_t port;
+	};
+
+	/*
+	 * Fixed-size circular queue of datagrams
+	 */
+	struct Queue {
+		Datagram* items{nullptr};
+		uint8_t size{0};
+		uint8_t head{0};
+		uint8_t count{0};
+
+		~Queue()
+		{
+			clear();
+			delete[] items;
+		}
+
+		bool resize(uint8_t newSize)
+		{
+			clear();
+			delete[] items;
+			items = nullptr;
+			size = 0;
+			if(newSize != 0) {
+				items = new Datagram[newSize];
+				if(items == nullptr) {
+					return false;
+				}
+				size = newSize;
+			}
+			return true;
+		}
+
+		bool isFull() const
+		{
+			return count >= size;
+		}
+
+		void push(pbuf* buf, IpAddress ip, uint16_t port)
+		{
+			items[(head + count) % size] = Datagram{buf, ip, port};
+			++count;
+		}
+
+		Datagram pop()
+		{
+			auto dgram = items[head];
+			head = (head + 1) % size;
+			--count;
+			return dgram;
+		}
+
+		void clear()
+		{
+			while(count != 0) {
+				pbuf_free(pop().buf);
+			}
+			head = 0;
+		}
+	};
+
+	UdpConnection* connection; ///< nullptr when detached
+	Queue sendQueue;
+	Queue receiveQueue;
+	unsigned droppedCount{0};
+	bool scheduled{false}; ///< Task callback pending
+	bool busy{false};	   ///< Processing in progress
+
+	Batch(UdpConnection* connection) : connection(connection)
+	{
+	}
+
+	void schedule()
+	{
+		if(!scheduled) {
+			scheduled = System.queueCallback(staticProcessBatch, this);
+		}
+	}
+};
+
+UdpConnection::~UdpConnection()
+{
+	close();
+
+	if(batch != nullptr) {
+		batch->sendQueue.clear();
+		batch->receiveQueue.clear();
+		if(batch->scheduled || batch->busy) {
+			// Task callback deletes it
+			batch->connection = nullptr;
+		} else {
+			delete batch;
+		}
+	}
+}
+
+UdpConnection::Batch* UdpConnection::getBatch()
+{
+	if(batch == nullptr) {
+		batch = new Batch(this);
+		if(batch != nullptr && !batch->sendQueue.resize(UDP_SEND_QUEUE_SIZE)) {
+			delete batch;
+			batch = nullptr;
+		}
+	}
+	return batch;
+}
 
 bool UdpConnection::initialize(udp_pcb* pcb)
 {
@@ -29,6 +147,13 @@ bool UdpConnection::initialize(udp_pcb* pcb)
 
 void UdpConnection::close()
 {
+	if(batch != nullptr) {
+		// Can't send without a pcb but received data may still be delivered
+		batch->sendQueue.clear();
+	}
+	if(udp == nullptr) {
+		return;
+	}
 	udp_recv(udp, nullptr, nullptr);
 	udp_remove(udp);
 	udp = nullptr;
@@ -93,6 +218,110 @@ bool UdpConnection::sendTo(IpAddress remoteIP, uint16_t remotePort, const char*
 	}
 }
 
+bool UdpConnection::queueTo(IpAddress remoteIP, uint16_t remotePort, const char* data, int length)
+{
+	if(udp == nullptr || length < 0 || getBatch() == nullptr) {
+		return false;
+	}
+
+	auto& queue = batch->sendQueue;
+	if(queue.isFull()) {
+		flush();
+	}
+
+	// Pool buffers are pre-allocated so prefer those, but they may be chained for larger datagrams
+	pbuf* p = pbuf_alloc(PBUF_TRANSPORT, length, PBUF_POOL);
+	if(p == nullptr) {
+		p = pbuf_alloc(PBUF_TRANSPORT, length, PBUF_RAM);
+		if(p == nullptr) {
+			return false;
+		}
+	}
+	pbuf_take(p, data, length);
+
+	queue.push(p, remoteIP, remotePort);
+	batch->schedule();
+	return true;
+}
+
+unsigned UdpConnection::flush()
+{
+	if(batch == nullptr) {
+		return 0;
+	}
+
+	unsigned count{0};
+	auto& queue = batch->sendQueue;
+	while(queue.count != 0) {
+		auto dgram = queue.pop();
+		if(udp != nullptr && udp_sendto(udp, dgram.buf, dgram.ip, dgram.port) == ERR_OK) {
+			++count;
+		}
+		pbuf_free(dgram.buf);
+	}
+
+	return count;
+}
+
+void UdpConnection::setSendQueueSize(uint8_t size)
+{
+	if(getBatch() == nullptr) {
+		return;
+	}
+	flush();
+	batch->sendQueue.resize(std::max(size, uint8_t(1)));
+}
+
+void UdpConnection::setReceiveQueueSize(uint8_t size)
+{
+	if(getBatch() == nullptr) {
+		return;
+	}
+	processBatch();
+	batch->receiveQueue.resize(size);
+}
+
+unsigned UdpConnection::getDroppedCount() const
+{
+	return (batch == nullptr) ? 0 : batch->droppedCount;
+}
+
+void UdpConnection::processBatch()
+{
+	auto b = batch;
+	if(b == nullptr || b->busy) {
+		return;
+	}
+
+	b->busy = true;
+	flush();
+	auto& queue = b->receiveQueue;
+	// Handler may destroy this connection
+	while(b->connection != nullptr && queue.count != 0) {
+		auto dgram = queue.pop();
+		onReceive(dgram.buf, dgram.ip, dgram.port);
+		pbuf_free(dgram.buf);
+	}
+	b->busy = false;
+
+	if(b->connection == nullptr && !b->scheduled) {
+		delete b;
+	}
+}
+
+void UdpConnection::staticProcessBatch(void* param)
+{
+	auto b = static_cast<Batch*>(param);
+	b->scheduled = false;
+	if(b->connection == nullptr) {
+		if(!b->busy) {
+			delete b;
+		}
+		return;
+	}
+	b->connection->processBatch();
+}
+
 void UdpConnection::onReceive(pbuf* buf, IpAddress remoteIP, uint16_t remotePort)
 {
 	debug_d("UDP received: %d bytes", buf->tot_len);
@@ -112,7 +341,20 @@ void UdpConnection::staticOnReceive(void* arg, struct udp_pcb* pcb, struct pbuf*
 	auto conn = static_cast<UdpConnection*>(arg);
 	if(conn != nullptr) {
 		IpAddress reip = addr != nullptr ? IpAddress(*addr) : IpAddress();
-		conn->onReceive(p, reip, port);
+		auto batch = conn->batch;
+		if(batch != nullptr && batch->receiveQueue.size != 0) {
+			auto& queue = batch->receiveQueue;
+			if(queue.isFull()) {
+				++batch->droppedCount;
+			} else {
+				// Buffer is released after delivery
+				queue.push(p, reip, port);
+				batch->schedule();
+				return;
+			}
+		} else {
+			conn->onReceive(p, reip, port);
+		}
 	}
 	pbuf_free(p);
 }
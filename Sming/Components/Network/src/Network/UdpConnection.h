@@ -13,6 +13,13 @@
 #include <Network/IpConnection.h>
 #include <lwip/udp.h>
 
+/**
+ * @brief Default maximum number of datagrams held by `UdpConnection::queueTo()` before flushing
+ */
+#ifndef UDP_SEND_QUEUE_SIZE
+#define UDP_SEND_QUEUE_SIZE 16
+#endif
+
 /** @defgroup   udp UDP
  *  @brief      Provides base for UDP clients or services
  *  @ingroup    networking
@@ -37,10 +44,7 @@ public:
 		initialize();
 	}
 
-	virtual ~UdpConnection()
-	{
-		close();
-	}
+	virtual ~UdpConnection();
 
 	virtual bool listen(int port);
 	virtual bool connect(IpAddress ip, uint16_t port);
@@ -71,6 +75,56 @@ public:
 		return sendTo(remoteIP, remotePort, data.c_str(), data.length());
 	}
 
+	/**
+	 * @brief Queue a datagram for sending
+	 * @param remoteIP
+	 * @param remotePort
+	 * @param data
+	 * @param length
+	 * @retval bool false if out of memory
+	 *
+	 * The data is copied into a packet buffer, taken from the lwIP pool where it fits.
+	 * Queued datagrams are sent together by `flush()`, which happens from the task queue,
+	 * or immediately if the queue is full. Use this when sending many small datagrams
+	 * in quick succession.
+	 */
+	bool queueTo(IpAddress remoteIP, uint16_t remotePort, const char* data, int length);
+
+	bool queueStringTo(IpAddress remoteIP, uint16_t remotePort, const String& data)
+	{
+		return queueTo(remoteIP, remotePort, data.c_str(), data.length());
+	}
+
+	/**
+	 * @brief Send all queued datagrams
+	 * @retval unsigned Number of datagrams sent successfully
+	 */
+	unsigned flush();
+
+	/**
+	 * @brief Set maximum number of datagrams held by `queueTo()`
+	 * @param size Must be at least 1. Any queued datagrams are sent first.
+	 */
+	void setSendQueueSize(uint8_t size);
+
+	/**
+	 * @brief Enable batched reception
+	 * @param size Maximum number of datagrams to hold, 0 to disable
+	 *
+	 * By default each datagram is passed to `onReceive()` directly from the lwIP callback.
+	 * When enabled, received packet buffers are instead held, without copying, and a single
+	 * task callback passes all those waiting to `onReceive()`.
+	 * This reduces overhead where datagrams arrive in bursts.
+	 *
+	 * Datagrams which arrive when the queue is full are discarded.
+	 */
+	void setReceiveQueueSize(uint8_t size);
+
+	/**
+	 * @brief Get number of incoming datagrams discarded because the receive queue was full
+	 */
+	unsigned getDroppedCount() const;
+
 	/**
 	 * @brief Sets the UDP multicast IP.
 	 * @param ip
@@ -102,6 +156,15 @@ protected:
 protected:
 	udp_pcb* udp = nullptr;
 	UdpConnectionDataDelegate onDataCallback = nullptr;
+
+private:
+	struct Batch;
+
+	Batch* getBatch();
+	void processBatch();
+	static void staticProcessBatch(void* param);
+
+	Batch* batch{nullptr}; ///< Created on first use of queueing
 };
 
 /** @} */
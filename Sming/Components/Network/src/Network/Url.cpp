@@ -51,6 +51,37 @@ Url& Url::operator=(String urlString)
 	return *this;
 }
 
+Url& Url::operator=(const UrlView& view)
+{
+	if(!view) {
+		debug_e("URL parsing failed");
+		return *this;
+	}
+
+	auto scheme = view.getScheme();
+	if(scheme) {
+		Scheme = view.toString(scheme);
+		Scheme.toLowerCase();
+	} else {
+		Scheme = URI_SCHEME_DEFAULT;
+	}
+	User = view.decode(view.getUser());
+	Password = view.decode(view.getPassword());
+	Host = view.toString(view.getHost());
+	Port = view.getPort() ?: getDefaultPort(Scheme);
+	Path = view.decode(view.getPath());
+	if(Path.length() == 0 || Path[0] != '/') {
+		Path = String('/') + Path;
+	}
+	Query.clear();
+	for(auto& param : view.getQuery()) {
+		Query[param.getKey()] = param.getValue();
+	}
+	Fragment = view.decode(view.getFragment());
+
+	return *this;
+}
+
 int Url::getDefaultPort(const String& scheme)
 {
 #define XX(name, str, port)                                                                                            \
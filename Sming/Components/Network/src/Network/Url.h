@@ -19,6 +19,7 @@
 
 #include <WString.h>
 #include "Http/HttpParams.h"
+#include "UrlView.h"
 #include <sming_attr.h>
 
 /** @defgroup   url Url
@@ -85,6 +86,14 @@ public:
 	{
 	}
 
+	/** @brief Construct a URL object from a parsed view
+	 *  @param view
+	 */
+	Url(const UrlView& view)
+	{
+		*this = view;
+	}
+
 	Url(const String& scheme, const String& user, const String& password, const String& host, int port = 0,
 		const String& path = nullptr, const String& query = nullptr, const String& fragment = nullptr)
 		: Scheme(scheme), User(user), Password(password), Host(host), Port(port), Path(path), Query(query),
@@ -102,6 +111,12 @@ public:
 	 */
 	Url& operator=(String urlString);
 
+	/** @brief Assign from a parsed view
+	 *  @param view
+	 *  @note Components are un-escaped directly from the view's source text
+	 */
+	Url& operator=(const UrlView& view);
+
 	/** @brief Copy assignment operator, for C-style strings
 	 *  @param urlString Escaped URL
 	 */
@@ -0,0 +1,237 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/SmingHub/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * UrlView.cpp
+ *
+ ****/
+
+#include "UrlView.h"
+#include <Data/WebHelpers/escape.h>
+
+namespace
+{
+const char* findChar(const char* begin, const char* end, char c)
+{
+	auto p = static_cast<const char*>(memchr(begin, c, end - begin));
+	return p ?: end;
+}
+
+int unhex(char c)
+{
+	if(c >= '0' && c <= '9') {
+		return c - '0';
+	}
+	c |= 0x20;
+	if(c >= 'a' && c <= 'f') {
+		return 10 + c - 'a';
+	}
+	return -1;
+}
+
+/*
+ * Un-escape one character, consistent with uri_unescape()
+ */
+char nextChar(const char*& src, const char* end)
+{
+	char c = *src++;
+	if(c == '+') {
+		return ' ';
+	}
+	if(c == '%' && end - src >= 2) {
+		int hi = unhex(src[0]);
+		int lo = unhex(src[1]);
+		if(hi >= 0 && lo >= 0) {
+			src += 2;
+			return (hi << 4) | lo;
+		}
+	}
+	return c;
+}
+
+} // namespace
+
+bool UrlView::parse(size_t length)
+{
+	if(text == nullptr || length > 0xffff) {
+		return false;
+	}
+
+	const char* begin = text;
+	const char* end = text + length;
+	auto span = [&](const char* from, const char* to) { return UrlSpan{uint16_t(from - begin), uint16_t(to - from)}; };
+
+	auto hash = findChar(begin, end, '#');
+	if(hash != end) {
+		fragment = span(hash + 1, end);
+		end = hash;
+	}
+
+	auto qmark = findChar(begin, end, '?');
+	if(qmark != end) {
+		query = span(qmark + 1, end);
+		end = qmark;
+	}
+
+	const char* p = begin;
+	if(p != end && *p != '/') {
+		auto colon = findChar(p, end, ':');
+		if(end - colon >= 3 && colon[1] == '/' && colon[2] == '/' && colon != p) {
+			scheme = span(p, colon);
+			p = colon + 3;
+		}
+
+		auto authorityEnd = findChar(p, end, '/');
+
+		// Last '@' separates user information from host
+		const char* at = nullptr;
+		for(auto s = p; s < authorityEnd; ++s) {
+			if(*s == '@') {
+				at = s;
+			}
+		}
+		if(at != nullptr) {
+			auto sep = findChar(p, at, ':');
+			user = span(p, sep);
+			if(sep != at) {
+				password = span(sep + 1, at);
+			}
+			p = at + 1;
+		}
+
+		const char* hostEnd;
+		if(p != authorityEnd && *p == '[') {
+			// IPv6 literal includes brackets
+			hostEnd = findChar(p, authorityEnd, ']');
+			if(hostEnd == authorityEnd) {
+				return false;
+			}
+			++hostEnd;
+		} else {
+			hostEnd = findChar(p, authorityEnd, ':');
+		}
+		host = span(p, hostEnd);
+		if(!host) {
+			return false;
+		}
+
+		if(hostEnd != authorityEnd) {
+			if(*hostEnd != ':') {
+				return false;
+			}
+			unsigned value{0};
+			for(auto s = hostEnd + 1; s < authorityEnd; ++s) {
+				if(*s < '0' || *s > '9') {
+					return false;
+				}
+				value = (value * 10) + (*s - '0');
+				if(value > 0xffff) {
+					return false;
+				}
+			}
+			port = value;
+		}
+		p = authorityEnd;
+	}
+
+	path = span(p, end);
+	return true;
+}
+
+size_t UrlView::decode(const char* text, UrlSpan span, char* buffer, size_t bufSize)
+{
+	if(buffer == nullptr || bufSize == 0) {
+		return 0;
+	}
+	if(!span) {
+		*buffer = '\0';
+		return 0;
+	}
+	uri_unescape(buffer, bufSize, text + span.offset, span.length);
+	return strlen(buffer);
+}
+
+String UrlView::decode(const char* text, UrlSpan span)
+{
+	if(!span) {
+		return nullptr;
+	}
+	String s;
+	if(!s.setLength(span.length)) {
+		return nullptr;
+	}
+	s.setLength(decode(text, span, s.begin(), span.length + 1));
+	return s;
+}
+
+size_t UrlQueryView::Param::decode(UrlSpan span, char* buffer, size_t bufSize) const
+{
+	return UrlView::decode(text, span, buffer, bufSize);
+}
+
+String UrlQueryView::Param::decode(UrlSpan span) const
+{
+	return UrlView::decode(text, span);
+}
+
+bool UrlQueryView::Param::keyEquals(const char* name) const
+{
+	auto src = text + key.offset;
+	auto end = src + key.length;
+	while(src < end) {
+		if(*name == '\0' || nextChar(src, end) != *name) {
+			return false;
+		}
+		++name;
+	}
+	return *name == '\0';
+}
+
+void UrlQueryView::Iterator::next()
+{
+	while(pos < end && text[pos] == '&') {
+		++pos;
+	}
+	if(pos >= end) {
+		pos = end;
+		return;
+	}
+	auto segment = text + pos;
+	auto segmentEnd = findChar(segment, text + end, '&');
+	auto eq = findChar(segment, segmentEnd, '=');
+	UrlSpan key{pos, uint16_t(eq - segment)};
+	UrlSpan value{uint16_t(segmentEnd - text), 0};
+	bool valuePresent = (eq != segmentEnd);
+	if(valuePresent) {
+		value = UrlSpan{uint16_t(eq + 1 - text), uint16_t(segmentEnd - eq - 1)};
+	}
+	param = Param(text, key, value, valuePresent);
+}
+
+bool UrlQueryView::find(const char* name, Param& param) const
+{
+	for(auto& p : *this) {
+		if(p.keyEquals(name)) {
+			param = p;
+			return true;
+		}
+	}
+	return false;
+}
+
+int UrlQueryView::getValue(const char* name, char* buffer, size_t bufSize) const
+{
+	Param param;
+	if(!find(name, param)) {
+		return -1;
+	}
+	return param.getValue(buffer, bufSize);
+}
+
+String UrlQueryView::operator[](const char* name) const
+{
+	Param param;
+	return find(name, param) ? param.getValue() : nullptr;
+}
@@ -50,12 +50,12 @@ bool WebsocketClient::connect(const Url& url)
 	// Generate the key
 	unsigned char keyStart[17] = {0};
 	char b64Key[25];
-	memset(b64Key, 0, sizeof(b64Key));
 
 	for(int i = 0; i < 16; ++i) {
 		keyStart[i] = 1 + os_random() % 255;
 	}
-	key = base64_encode(keyStart, sizeof(keyStart));
+	int keyLength = base64_encode(sizeof(keyStart), keyStart, sizeof(b64Key), b64Key);
+	key.setString(b64Key, keyLength);
 
 	HttpRequest* request = new HttpRequest(uri);
 	request->headers[HTTP_HEADER_UPGRADE] = WSSTR_WEBSOCKET;
@@ -63,6 +63,9 @@ bool WebsocketClient::connect(const Url& url)
 	request->headers[HTTP_HEADER_SEC_WEBSOCKET_KEY] = key;
 	request->headers[HTTP_HEADER_SEC_WEBSOCKET_PROTOCOL] = F("chat");
 	request->headers[HTTP_HEADER_SEC_WEBSOCKET_VERSION] = String(WEBSOCKET_VERSION);
+	if(deflateConfig) {
+		request->headers[HTTP_HEADER_SEC_WEBSOCKET_EXTENSIONS] = WsDeflate::makeOffer(*deflateConfig);
+	}
 	request->onHeadersComplete(RequestHeadersCompletedDelegate(&WebsocketClient::verifyKey, this));
 
 	if(!httpConnection->send(request)) {
@@ -85,14 +88,27 @@ int WebsocketClient::verifyKey(HttpConnection& connection, HttpResponse& respons
 
 	String keyToHash = key + WSSTR_SECRET;
 	auto hash = Crypto::Sha1().calculate(keyToHash);
-	String base64hash = base64_encode(hash.data(), hash.size());
-	if(base64hash != serverHashedKey) {
-		debug_e("wscli key mismatch: %s | %s", serverHashedKey.c_str(), base64hash.c_str());
+	char base64hash[29];
+	int hashLength = base64_encode(hash.size(), hash.data(), sizeof(base64hash), base64hash);
+	if(!serverHashedKey.equals(base64hash, hashLength)) {
+		debug_e("wscli key mismatch: %s | %.*s", serverHashedKey.c_str(), hashLength, base64hash);
 		state = eWSCS_Closed;
 		WebsocketConnection::getConnection()->setTimeOut(1);
 		return -3;
 	}
 
+	stopDeflate();
+	if(response.headers.contains(HTTP_HEADER_SEC_WEBSOCKET_EXTENSIONS)) {
+		String extension = response.headers[HTTP_HEADER_SEC_WEBSOCKET_EXTENSIONS];
+		WsDeflateConfig agreed;
+		if(!deflateConfig || !WsDeflate::parseResponse(extension, *deflateConfig, agreed) || !startDeflate(agreed)) {
+			debug_e("wscli unsupported extension: %s", extension.c_str());
+			state = eWSCS_Closed;
+			WebsocketConnection::getConnection()->setTimeOut(1);
+			return -4;
+		}
+	}
+
 	response.headers.clear();
 
 	state = eWSCS_Open;
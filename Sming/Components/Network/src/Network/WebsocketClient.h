@@ -41,8 +41,12 @@ public:
 
 	using WebsocketConnection::setBinaryHandler;
 	using WebsocketConnection::setConnectionHandler;
+	using WebsocketConnection::setDataHandler;
+	using WebsocketConnection::setDeflateConfig;
 	using WebsocketConnection::setDisconnectionHandler;
 	using WebsocketConnection::setMessageHandler;
+	using WebsocketConnection::setReassemblyPool;
+	using WebsocketConnection::setStreamHandler;
 
 	HttpConnection* getHttpConnection();
 
@@ -80,6 +84,7 @@ public:
 
 	using WebsocketConnection::close;
 	using WebsocketConnection::getState;
+	using WebsocketConnection::isDeflateEnabled;
 
 	/**
 	 * @brief Set the SSL session initialisation callback
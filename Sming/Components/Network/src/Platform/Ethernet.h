@@ -68,6 +68,19 @@ enum class Speed {
 	MBPS100,
 };
 
+/**
+ * @brief Driver statistics
+ *
+ * Counters are cumulative from when the service is started, and wrap at 2^32.
+ */
+struct Statistics {
+	uint32_t rxFrames;   ///< Frames passed to the TCP/IP stack
+	uint32_t rxBytes;	///< Bytes passed to the TCP/IP stack
+	uint32_t rxDropped;  ///< Frames rejected by the TCP/IP stack
+	uint32_t rxMissed;   ///< Frames discarded by the MAC because no receive buffer was available
+	uint32_t rxOverflow; ///< Frames discarded because of a receive FIFO overflow
+};
+
 /**
  * @brief Constructed PHY instance. An opaque, implementation-specific type.
  */
@@ -192,6 +205,13 @@ public:
 	 */
 	virtual bool enableDHCP(bool enable) = 0;
 
+	/**
+	 * @brief Get driver statistics
+	 *
+	 * Counters not supported by the implementation are left at zero.
+	 */
+	virtual Statistics getStatistics() = 0;
+
 	/**
 	 * @brief Set callback for ethernet events
 	 */
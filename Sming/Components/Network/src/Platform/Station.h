@@ -308,6 +308,28 @@ public:
 	 */
 	virtual bool startScan(ScanCompletedDelegate scanCompleted) = 0;
 
+	/**	@brief	Enable fast reconnection following deep sleep or restart
+	 *	@param	enable False to disable and discard any saved connection details
+	 *	@param	maxAge Saved details older than this many seconds are not used, so a fresh DHCP lease is obtained
+	 *	@retval	bool false if not supported
+	 *
+	 *	Once connected using DHCP, the access point BSSID and channel, together with the IP address,
+	 *	netmask, gateway and DNS server, are kept in RTC memory.
+	 *	When called from `init()` after the next wake or restart, the station is configured to
+	 *	join that access point directly without scanning, and to re-use the saved address rather than waiting for DHCP.
+	 *	Once connected, DHCP is restarted in the background to renew the lease.
+	 *	If this connection fails the details are discarded and the normal configuration is restored.
+	 *
+	 *	The details are only used if the configured SSID is unchanged.
+	 *	Keep `maxAge` within the DHCP lease time so the saved address is still valid when re-used.
+	 */
+	virtual bool setFastConnect(bool enable, uint32_t maxAge = 3600)
+	{
+		(void)enable;
+		(void)maxAge;
+		return false;
+	}
+
 #ifdef ENABLE_SMART_CONFIG
 	/**	@brief	Start WiFi station smart configuration
 	 *	@param	sctype Smart configuration type
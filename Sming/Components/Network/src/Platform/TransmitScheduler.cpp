@@ -0,0 +1,124 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/SmingHub/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * TransmitScheduler.cpp
+ *
+ ****/
+
+#include "TransmitScheduler.h"
+#include <Platform/System.h>
+#include <Clock.h>
+#include <debug_progmem.h>
+#include <algorithm>
+
+#define TX_SCHEDULER_MAX_TIMER_INTERVAL 60000 ///< Timer re-evaluates long delays in steps
+
+TransmitScheduler TxScheduler;
+
+uint32_t TransmitScheduler::getSendTime(uint32_t now, uint32_t deadline, uint32_t reference, uint32_t period)
+{
+	if(period == 0) {
+		return deadline;
+	}
+
+	uint32_t elapsed = deadline - reference;
+	if(int32_t(elapsed) < 0) {
+		return deadline;
+	}
+
+	uint32_t windowStart = deadline - (elapsed % period);
+	if(int32_t(windowStart - now) < 0) {
+		return deadline;
+	}
+
+	return windowStart;
+}
+
+void TransmitScheduler::schedule(Callback callback, uint32_t maxDelay)
+{
+	if(entryCount == TX_SCHEDULER_QUEUE_SIZE) {
+		debug_w("[TXS] Queue full, sending early");
+		flush();
+	}
+
+	auto& entry = entries[entryCount++];
+	entry.callback = std::move(callback);
+	entry.deadline = millis() + maxDelay;
+
+	if(maxDelay == 0) {
+		flush();
+	} else {
+		startTimer();
+	}
+}
+
+void TransmitScheduler::wake()
+{
+	windowReference = millis();
+
+	if(entryCount == 0 || flushQueued) {
+		return;
+	}
+
+	flushQueued = System.queueCallback(
+		[](void* param) {
+			auto scheduler = static_cast<TransmitScheduler*>(param);
+			scheduler->flushQueued = false;
+			scheduler->flush();
+		},
+		this);
+}
+
+void TransmitScheduler::flush()
+{
+	timer.stop();
+	windowReference = millis();
+
+	// Callbacks may schedule further operations
+	Entry pending[TX_SCHEDULER_QUEUE_SIZE];
+	auto pendingCount = entryCount;
+	for(unsigned i = 0; i < pendingCount; ++i) {
+		pending[i] = std::move(entries[i]);
+	}
+	entryCount = 0;
+
+	debug_d("[TXS] Sending %u", pendingCount);
+	for(unsigned i = 0; i < pendingCount; ++i) {
+		pending[i].callback();
+	}
+}
+
+void TransmitScheduler::startTimer()
+{
+	if(entryCount == 0) {
+		timer.stop();
+		return;
+	}
+
+	auto now = millis();
+	uint32_t deadline = entries[0].deadline;
+	for(unsigned i = 1; i < entryCount; ++i) {
+		if(int32_t(entries[i].deadline - deadline) < 0) {
+			deadline = entries[i].deadline;
+		}
+	}
+
+	sendTime = getSendTime(now, deadline, windowReference, windowPeriod);
+	auto delay = std::max(int32_t(sendTime - now), int32_t(1));
+	delay = std::min(delay, int32_t(TX_SCHEDULER_MAX_TIMER_INTERVAL));
+	timer.initializeMs(
+		delay, [](void* param) { static_cast<TransmitScheduler*>(param)->onTimer(); }, this);
+	timer.startOnce();
+}
+
+void TransmitScheduler::onTimer()
+{
+	if(int32_t(millis() - sendTime) >= 0) {
+		flush();
+	} else {
+		startTimer();
+	}
+}
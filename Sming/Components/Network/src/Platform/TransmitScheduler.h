@@ -0,0 +1,130 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/SmingHub/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * TransmitScheduler.h
+ *
+ ****/
+
+#pragma once
+
+#include <Delegate.h>
+#include <SimpleTimer.h>
+
+/**
+ * @brief Number of deferred transmissions which may be pending
+ */
+#ifndef TX_SCHEDULER_QUEUE_SIZE
+#define TX_SCHEDULER_QUEUE_SIZE 8
+#endif
+
+/**
+ * @brief Batches deferrable transmissions to reduce radio wake-ups
+ *
+ * When a station uses modem-sleep the radio is powered up for each DTIM beacon,
+ * and also whenever data is sent. Sending at arbitrary times therefore costs
+ * additional wake-ups.
+ *
+ * Applications pass each deferrable operation (an MQTT publish, HTTP post, etc.) to `schedule()`
+ * together with the longest acceptable delay. Pending operations are all run together,
+ * in the last transmit window which meets every deadline.
+ *
+ * Windows repeat at a fixed period, set using `setWindow()` or `setDtimWindow()`, measured from the
+ * last time the radio was known to be awake: either when pending operations were last run,
+ * or when the application calls `wake()`.
+ */
+class TransmitScheduler
+{
+public:
+	using Callback = Delegate<void()>;
+
+	/**
+	 * @brief Set period of transmit windows
+	 * @param period Milliseconds, 0 to run operations at their deadline without alignment
+	 */
+	void setWindow(uint32_t period)
+	{
+		windowPeriod = period;
+		startTimer();
+	}
+
+	/**
+	 * @brief Set transmit window to match access point beacons
+	 * @param dtimPeriod Number of beacon intervals between DTIM beacons
+	 * @param beaconInterval In time units (1.024 ms)
+	 */
+	void setDtimWindow(uint8_t dtimPeriod, uint16_t beaconInterval = 100)
+	{
+		setWindow((uint32_t(dtimPeriod) * beaconInterval * 1024U + 500U) / 1000U);
+	}
+
+	uint32_t getWindow() const
+	{
+		return windowPeriod;
+	}
+
+	/**
+	 * @brief Schedule an operation
+	 * @param callback Performs the transmission
+	 * @param maxDelay Longest acceptable delay in milliseconds.
+	 * 0 runs the operation immediately, together with anything pending.
+	 *
+	 * If the queue is full, pending operations are run early to make room.
+	 */
+	void schedule(Callback callback, uint32_t maxDelay);
+
+	/**
+	 * @brief Notify that the radio is known to be awake
+	 *
+	 * Call, for example, on receiving data. Pending operations are run shortly afterwards
+	 * and subsequent windows are timed from now.
+	 * May be called from a network callback.
+	 */
+	void wake();
+
+	/**
+	 * @brief Run all pending operations now
+	 */
+	void flush();
+
+	/**
+	 * @brief Get number of pending operations
+	 */
+	unsigned count() const
+	{
+		return entryCount;
+	}
+
+	/**
+	 * @brief Determine when pending operations should be run
+	 * @param now Current time
+	 * @param deadline Time by which operations must be run
+	 * @param reference Start of a transmit window
+	 * @param period Interval between windows, 0 for no alignment
+	 * @retval uint32_t Start of the last window no later than the deadline, or the deadline
+	 * if there is no such window still to come
+	 * @note All values in milliseconds and may wrap
+	 */
+	static uint32_t getSendTime(uint32_t now, uint32_t deadline, uint32_t reference, uint32_t period);
+
+private:
+	struct Entry {
+		Callback callback;
+		uint32_t deadline;
+	};
+
+	void startTimer();
+	void onTimer();
+
+	Entry entries[TX_SCHEDULER_QUEUE_SIZE];
+	SimpleTimer timer;
+	uint32_t windowPeriod{0};
+	uint32_t windowReference{0};
+	uint32_t sendTime{0};
+	uint8_t entryCount{0};
+	bool flushQueued{false};
+};
+
+extern TransmitScheduler TxScheduler;
@@ -0,0 +1,8 @@
+COMPONENT_INCDIRS := src/include
+COMPONENT_SRCDIRS := src
+COMPONENT_DOXYGEN_INPUT := src/include
+
+# Set to 0 to use the heap directly for all pooled classes
+COMPONENT_VARS += ENABLE_OBJECT_POOL
+ENABLE_OBJECT_POOL ?= 1
+GLOBAL_CFLAGS += -DENABLE_OBJECT_POOL=$(ENABLE_OBJECT_POOL)
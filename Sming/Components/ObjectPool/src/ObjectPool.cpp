@@ -0,0 +1,157 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/SmingHub/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * ObjectPool.cpp
+ *
+ ****/
+
+#include "include/ObjectPool.h"
+#include <debug_progmem.h>
+
+namespace ObjectPool
+{
+Pool::List Pool::pools;
+
+Pool::Pool(const char* name, size_t objectSize, uint16_t capacity) : name(name)
+{
+	// Free blocks hold a list pointer, and must remain suitably aligned
+	constexpr size_t align = alignof(max_align_t);
+	objectSize = std::max(objectSize, sizeof(Block));
+	this->objectSize = (objectSize + align - 1) & ~(align - 1);
+	stats.capacity = capacity;
+	pools.add(this);
+}
+
+Pool::~Pool()
+{
+	pools.remove(this);
+	free(slab);
+}
+
+bool Pool::allocateSlab()
+{
+	slab = static_cast<uint8_t*>(malloc(stats.capacity * objectSize));
+	if(slab == nullptr) {
+		debug_w("[POOL] '%s' slab allocation failed", name);
+		return false;
+	}
+
+	// Thread the free list in address order
+	freeList = nullptr;
+	for(unsigned i = stats.capacity; i > 0; --i) {
+		auto block = reinterpret_cast<Block*>(slab + (i - 1) * objectSize);
+		block->next = freeList;
+		freeList = block;
+	}
+	return true;
+}
+
+void* Pool::allocate(size_t size)
+{
+	if(size <= objectSize && stats.capacity != 0) {
+		if(slab == nullptr) {
+			allocateSlab();
+		}
+		if(freeList != nullptr) {
+			auto block = freeList;
+			freeList = block->next;
+			++stats.allocations;
+			++stats.inUse;
+			if(stats.inUse > stats.peak) {
+				stats.peak = stats.inUse;
+			}
+			return block;
+		}
+		++stats.overflows;
+	}
+
+	return malloc(size);
+}
+
+void Pool::release(void* ptr)
+{
+	if(ptr == nullptr) {
+		return;
+	}
+
+	if(!contains(ptr)) {
+		free(ptr);
+		return;
+	}
+
+	auto block = static_cast<Block*>(ptr);
+	block->next = freeList;
+	freeList = block;
+	--stats.inUse;
+}
+
+bool Pool::reserve(uint16_t capacity)
+{
+	if(capacity <= stats.capacity) {
+		return true;
+	}
+
+	if(stats.inUse != 0) {
+		debug_w("[POOL] '%s' in use, cannot grow to %u", name, capacity);
+		return false;
+	}
+
+	free(slab);
+	slab = nullptr;
+	freeList = nullptr;
+	stats.capacity = capacity;
+	return true;
+}
+
+bool Pool::shrink()
+{
+	if(stats.inUse != 0) {
+		return false;
+	}
+
+	free(slab);
+	slab = nullptr;
+	freeList = nullptr;
+	return true;
+}
+
+void Pool::resetStats()
+{
+	stats.peak = stats.inUse;
+	stats.allocations = 0;
+	stats.overflows = 0;
+}
+
+size_t Pool::printTo(Print& p) const
+{
+	size_t n{0};
+	n += p.print(name);
+	n += p.print(_F(": size "));
+	n += p.print(objectSize);
+	n += p.print(_F(", capacity "));
+	n += p.print(stats.capacity);
+	n += p.print(_F(", inUse "));
+	n += p.print(stats.inUse);
+	n += p.print(_F(", peak "));
+	n += p.print(stats.peak);
+	n += p.print(_F(", allocations "));
+	n += p.print(stats.allocations);
+	n += p.print(_F(", overflows "));
+	n += p.print(stats.overflows);
+	return n;
+}
+
+size_t Pool::printAll(Print& p)
+{
+	size_t n{0};
+	for(auto& pool : pools) {
+		n += pool.printTo(p);
+		n += p.println();
+	}
+	return n;
+}
+
+} // namespace ObjectPool
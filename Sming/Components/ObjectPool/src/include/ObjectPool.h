@@ -0,0 +1,174 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/SmingHub/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * ObjectPool.h - Fixed-size object pools
+ *
+ ****/
+
+#pragma once
+
+#include <Data/LinkedObjectList.h>
+#include <Print.h>
+#include <cstdlib>
+
+namespace ObjectPool
+{
+/**
+ * @brief Pool usage statistics
+ */
+struct Stats {
+	uint16_t capacity;	///< Number of objects pool can hold
+	uint16_t inUse;		  ///< Pool objects currently allocated
+	uint16_t peak;		  ///< Highest value of inUse
+	uint32_t allocations; ///< Total allocations satisfied from pool
+	uint32_t overflows;   ///< Allocations which used the heap because the pool was exhausted
+};
+
+/**
+ * @brief A pool of fixed-size memory blocks
+ *
+ * All blocks are obtained from the heap in a single allocation (a slab) when the pool is first used,
+ * and are retained for the lifetime of the pool. Released blocks are kept on a free list for re-use.
+ * Repeated allocation and release of objects therefore leaves the heap unchanged.
+ *
+ * Requests which cannot be met from the pool, because it is exhausted or the requested size is larger
+ * than the block size (e.g. for a derived class), are passed to the heap.
+ *
+ * @note Pools are not interrupt-safe and must only be used from task context.
+ */
+class Pool : public LinkedObjectTemplate<Pool>
+{
+public:
+	using List = LinkedObjectListTemplate<Pool>;
+
+	/**
+	 * @brief Constructor
+	 * @param name Identifies pool in statistics
+	 * @param objectSize Size of each block
+	 * @param capacity Number of blocks in pool. Use 0 to allocate from the heap until `reserve()` is called.
+	 */
+	Pool(const char* name, size_t objectSize, uint16_t capacity);
+
+	~Pool();
+
+	/**
+	 * @brief Allocate memory for an object
+	 * @param size Size of object
+	 * @retval void* nullptr if out of memory
+	 */
+	void* allocate(size_t size);
+
+	/**
+	 * @brief Release memory obtained via `allocate()`
+	 */
+	void release(void* ptr);
+
+	/**
+	 * @brief Ensure pool can hold at least the given number of objects
+	 * @param capacity Required capacity
+	 * @retval bool true on success, false if pool is in use and must be resized
+	 *
+	 * Pool capacity cannot be changed whilst any pool objects are in use.
+	 * The slab is allocated on the next call to `allocate()`.
+	 */
+	bool reserve(uint16_t capacity);
+
+	/**
+	 * @brief Release slab memory back to the heap
+	 * @retval bool false if pool is in use
+	 */
+	bool shrink();
+
+	const char* getName() const
+	{
+		return name;
+	}
+
+	size_t getObjectSize() const
+	{
+		return objectSize;
+	}
+
+	const Stats& getStats() const
+	{
+		return stats;
+	}
+
+	void resetStats();
+
+	/**
+	 * @brief Determine if memory block belongs to this pool
+	 */
+	bool contains(const void* ptr) const
+	{
+		auto p = static_cast<const uint8_t*>(ptr);
+		return slab != nullptr && p >= slab && p < slab + stats.capacity * objectSize;
+	}
+
+	/**
+	 * @brief Print statistics in a single line
+	 */
+	size_t printTo(Print& p) const;
+
+	/**
+	 * @brief Get list of all pools which have been used
+	 */
+	static const List& getPools()
+	{
+		return pools;
+	}
+
+	/**
+	 * @brief Print statistics for all pools, one per line
+	 */
+	static size_t printAll(Print& p);
+
+private:
+	struct Block {
+		Block* next;
+	};
+
+	bool allocateSlab();
+
+	static List pools;
+
+	const char* name;
+	size_t objectSize;
+	uint8_t* slab{nullptr};
+	Block* freeList{nullptr};
+	Stats stats{};
+};
+
+} // namespace ObjectPool
+
+/**
+ * @brief Use within a class definition to allocate instances from a pool
+ * @param ClassName Name of the class being pooled
+ * @param defaultCapacity Initial pool capacity, use 0 to defer pool creation until `getPool().reserve()` is called
+ *
+ * Derived classes inherit these operators, but their instances are larger so are allocated from the heap.
+ */
+#if ENABLE_OBJECT_POOL
+#define OBJECT_POOL_ALLOCATED(ClassName, defaultCapacity)                                                              \
+public:                                                                                                                \
+	static ObjectPool::Pool& getPool()                                                                                 \
+	{                                                                                                                  \
+		static ObjectPool::Pool pool(#ClassName, sizeof(ClassName), defaultCapacity);                                  \
+		return pool;                                                                                                   \
+	}                                                                                                                  \
+                                                                                                                       \
+	static void* operator new(size_t size)                                                                             \
+	{                                                                                                                  \
+		return getPool().allocate(size);                                                                               \
+	}                                                                                                                  \
+                                                                                                                       \
+	static void operator delete(void* ptr)                                                                             \
+	{                                                                                                                  \
+		getPool().release(ptr);                                                                                        \
+	}
+#else
+#define OBJECT_POOL_ALLOCATED(ClassName, defaultCapacity)
+#endif
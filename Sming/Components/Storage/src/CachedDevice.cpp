@@ -0,0 +1,243 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/SmingHub/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * CachedDevice.cpp
+ *
+ ****/
+
+#include "include/Storage/CachedDevice.h"
+#include <debug_progmem.h>
+
+namespace Storage
+{
+CachedDevice::CachedDevice(Device& device, size_t lineSize, uint8_t lineCount, uint8_t readAhead)
+	: device(device), lineSize(lineSize), lineCount(lineCount ?: 1), readAhead(readAhead)
+{
+	auto blockSize = device.getBlockSize();
+	if(blockSize != 0 && this->lineSize > blockSize) {
+		this->lineSize = blockSize;
+	}
+	assert(this->lineSize != 0 && (this->lineSize & (this->lineSize - 1)) == 0);
+
+	lines.reset(new Line[this->lineCount]);
+	buffer.reset(new uint8_t[this->lineCount * this->lineSize]);
+}
+
+int CachedDevice::findLine(uint32_t address) const
+{
+	for(unsigned i = 0; i < lineCount; ++i) {
+		if(lines[i].address == address) {
+			return i;
+		}
+	}
+	return -1;
+}
+
+int CachedDevice::getVictim()
+{
+	int victim{-1};
+	for(unsigned i = 0; i < lineCount; ++i) {
+		auto& line = lines[i];
+		if(line.address == invalidAddress) {
+			return i;
+		}
+		if(victim < 0 || line.lastUsed < lines[victim].lastUsed) {
+			victim = i;
+		}
+	}
+
+	if(lines[victim].dirty && !writeBack(victim)) {
+		return -1;
+	}
+	return victim;
+}
+
+int CachedDevice::loadLine(uint32_t address, bool fetch)
+{
+	int i = getVictim();
+	if(i < 0) {
+		return -1;
+	}
+
+	auto& line = lines[i];
+	if(fetch && !device.read(address, getData(i), lineSize)) {
+		line.address = invalidAddress;
+		return -1;
+	}
+
+	line.address = address;
+	line.dirty = false;
+	touch(i);
+	return i;
+}
+
+bool CachedDevice::writeBack(unsigned index)
+{
+	auto& line = lines[index];
+	if(!device.write(line.address, getData(index), lineSize)) {
+		debug_e("[CACHE] Write back to 0x%08x failed", line.address);
+		return false;
+	}
+	line.dirty = false;
+	++stats.writeBacks;
+	return true;
+}
+
+bool CachedDevice::read(uint32_t address, void* dst, size_t size)
+{
+	auto out = static_cast<uint8_t*>(dst);
+	while(size != 0) {
+		uint32_t lineAddress = address & ~(lineSize - 1);
+		size_t offset = address - lineAddress;
+		size_t len = std::min(size, lineSize - offset);
+
+		int i = findLine(lineAddress);
+		if(i >= 0) {
+			++stats.hits;
+			touch(i);
+			memcpy(out, getData(i) + offset, len);
+		} else if(len == lineSize) {
+			// Read uncached whole lines directly, no point in filling the cache with them
+			++stats.misses;
+			while(len + lineSize <= size && findLine(lineAddress + len) < 0) {
+				len += lineSize;
+			}
+			if(!device.read(address, out, len)) {
+				return false;
+			}
+		} else {
+			++stats.misses;
+			bool sequential = (lastMiss != invalidAddress) && (lineAddress == lastMiss + lineSize);
+			lastMiss = lineAddress;
+			i = loadLine(lineAddress, true);
+			if(i < 0) {
+				return false;
+			}
+			memcpy(out, getData(i) + offset, len);
+
+			// Pre-load following lines, but never at the expense of the one just read
+			if(sequential && lineCount > readAhead) {
+				for(unsigned n = 1; n <= readAhead; ++n) {
+					uint32_t nextAddress = lineAddress + n * lineSize;
+					if(nextAddress + lineSize > device.getSize() || findLine(nextAddress) >= 0) {
+						break;
+					}
+					if(loadLine(nextAddress, true) < 0) {
+						break;
+					}
+					++stats.readAheads;
+					lastMiss = nextAddress;
+				}
+			}
+		}
+
+		address += len;
+		out += len;
+		size -= len;
+	}
+
+	return true;
+}
+
+bool CachedDevice::write(uint32_t address, const void* src, size_t size)
+{
+	bool isFlash = (device.getType() == Type::flash);
+	auto in = static_cast<const uint8_t*>(src);
+	while(size != 0) {
+		uint32_t lineAddress = address & ~(lineSize - 1);
+		size_t offset = address - lineAddress;
+		size_t len = std::min(size, lineSize - offset);
+
+		int i = findLine(lineAddress);
+		if(i >= 0) {
+			++stats.hits;
+			touch(i);
+		} else {
+			++stats.misses;
+			// Existing content not required if it's all being replaced
+			bool fetch = isFlash || len != lineSize;
+			i = loadLine(lineAddress, fetch);
+			if(i < 0) {
+				return false;
+			}
+		}
+
+		auto data = getData(i) + offset;
+		if(isFlash) {
+			for(unsigned n = 0; n < len; ++n) {
+				data[n] &= in[n];
+			}
+		} else {
+			memcpy(data, in, len);
+		}
+		lines[i].dirty = true;
+
+		address += len;
+		in += len;
+		size -= len;
+	}
+
+	return true;
+}
+
+bool CachedDevice::erase_range(uint32_t address, size_t size)
+{
+	uint32_t endAddress = address + size;
+	for(unsigned i = 0; i < lineCount; ++i) {
+		auto& line = lines[i];
+		if(line.address == invalidAddress) {
+			continue;
+		}
+		uint32_t lineEnd = line.address + lineSize;
+		if(lineEnd <= address || line.address >= endAddress) {
+			continue;
+		}
+		// Part of a line outside the erased region must be preserved
+		bool partial = (line.address < address || lineEnd > endAddress);
+		if(partial && line.dirty && !writeBack(i)) {
+			return false;
+		}
+		line.address = invalidAddress;
+		line.dirty = false;
+	}
+
+	return device.erase_range(address, size);
+}
+
+bool CachedDevice::flush()
+{
+	bool success{true};
+	for(;;) {
+		// Lowest address first
+		int next{-1};
+		for(unsigned i = 0; i < lineCount; ++i) {
+			if(lines[i].dirty && (next < 0 || lines[i].address < lines[next].address)) {
+				next = i;
+			}
+		}
+		if(next < 0) {
+			break;
+		}
+		if(!writeBack(next)) {
+			// Drop the data rather than retry forever
+			lines[next].dirty = false;
+			lines[next].address = invalidAddress;
+			success = false;
+		}
+	}
+
+	return success;
+}
+
+void CachedDevice::invalidate()
+{
+	for(unsigned i = 0; i < lineCount; ++i) {
+		lines[i] = Line{};
+	}
+	lastMiss = invalidAddress;
+}
+
+} // namespace Storage
@@ -13,6 +13,7 @@
 #include "include/Storage/partition_info.h"
 #include <FlashString/Vector.hpp>
 #include <debug_progmem.h>
+#include <Platform/System.h>
 
 namespace
 {
@@ -46,11 +47,48 @@ String toLongString(Storage::Device::Type type)
 
 namespace Storage
 {
+namespace
+{
+WriteObserver::List writeObservers;
+}
+
+WriteObserver::~WriteObserver()
+{
+	Device::removeWriteObserver(*this);
+}
+
+bool Device::addWriteObserver(WriteObserver& observer)
+{
+	return writeObservers.add(&observer);
+}
+
+void Device::removeWriteObserver(WriteObserver& observer)
+{
+	writeObservers.remove(&observer);
+}
+
+void Device::notifyWrite(uint32_t address, size_t size)
+{
+	for(auto& observer : writeObservers) {
+		observer.onDeviceWrite(*this, address, size);
+	}
+}
+
 Device::~Device()
 {
 	unRegisterDevice(this);
 }
 
+bool Device::readAsync(uint32_t address, void* dst, size_t size, ReadCallback callback)
+{
+	if(!callback) {
+		return false;
+	}
+
+	bool success = read(address, dst, size);
+	return System.queueCallback([callback, success]() { callback(success); });
+}
+
 bool Device::loadPartitions(Device& source, uint32_t tableOffset)
 {
 	constexpr size_t maxEntries = ESP_PARTITION_TABLE_MAX_LEN / sizeof(esp_partition_info_t);
@@ -220,6 +220,20 @@ bool Partition::read(size_t offset, void* dst, size_t size)
 	return mDevice ? mDevice->read(addr, dst, size) : false;
 }
 
+bool Partition::readAsync(size_t offset, void* dst, size_t size, ReadCallback callback)
+{
+	if(!allowRead()) {
+		return false;
+	}
+
+	uint32_t addr = offset;
+	if(!getDeviceAddress(addr, size)) {
+		return false;
+	}
+
+	return mDevice->readAsync(addr, dst, size, callback);
+}
+
 bool Partition::write(size_t offset, const void* src, size_t size)
 {
 	if(!allowWrite()) {
@@ -231,7 +245,33 @@ bool Partition::write(size_t offset, const void* src, size_t size)
 		return false;
 	}
 
-	return mDevice ? mDevice->write(addr, src, size) : false;
+	if(mDevice == nullptr || !mDevice->write(addr, src, size)) {
+		return false;
+	}
+
+	mDevice->notifyWrite(addr, size);
+	return true;
+}
+
+const void* Partition::getMappedPointer(size_t offset, size_t size) const
+{
+	if(!isReadOnly()) {
+		return nullptr;
+	}
+
+	uint32_t addr = offset;
+	if(!getDeviceAddress(addr, size)) {
+		return nullptr;
+	}
+
+	return mDevice->getMappedPointer(addr, size);
+}
+
+void Partition::releaseMappedPointer(const void* ptr) const
+{
+	if(mDevice != nullptr && ptr != nullptr) {
+		mDevice->releaseMappedPointer(ptr);
+	}
 }
 
 bool Partition::erase_range(size_t offset, size_t size)
@@ -245,7 +285,12 @@ bool Partition::erase_range(size_t offset, size_t size)
 		return false;
 	}
 
-	return mDevice ? mDevice->erase_range(addr, size) : false;
+	if(mDevice == nullptr || !mDevice->erase_range(addr, size)) {
+		return false;
+	}
+
+	mDevice->notifyWrite(addr, size);
+	return true;
 }
 
 } // namespace Storage
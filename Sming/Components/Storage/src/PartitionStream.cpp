@@ -16,6 +16,18 @@ namespace Storage
 uint16_t PartitionStream::readMemoryBlock(char* data, int bufSize)
 {
 	int len = std::min(bufSize, available());
+	if(len <= 0) {
+		return 0;
+	}
+
+	// Avoid device read overhead where content is memory-mapped
+	auto ptr = partition.getMappedPointer(startOffset + readPos, len);
+	if(ptr != nullptr) {
+		memcpy_P(data, ptr, len);
+		partition.releaseMappedPointer(ptr);
+		return len;
+	}
+
 	return partition.read(startOffset + readPos, data, len) ? len : 0;
 }
 
@@ -44,6 +56,49 @@ int PartitionStream::seekFrom(int offset, SeekOrigin origin)
 	return readPos;
 }
 
+bool PartitionStream::eraseTo(uint32_t endPos)
+{
+	if(endPos <= erasePos) {
+		return true;
+	}
+
+	size_t blockSize = partition.getBlockSize();
+	size_t eraseLen = endPos - erasePos + blockSize - 1;
+	eraseLen -= eraseLen % blockSize;
+	debug_d("[PS] erase(0x%08x, 0x%08x", startOffset + erasePos, eraseLen);
+	if(!partition.erase_range(startOffset + erasePos, eraseLen)) {
+		return false;
+	}
+	erasePos += eraseLen;
+	return true;
+}
+
+void PartitionStream::scheduleEraseAhead()
+{
+	if(erasePending || eraseAheadDistance == 0) {
+		return;
+	}
+	auto limit = std::min(size_t(writePos + eraseAheadDistance), size);
+	if(erasePos < limit) {
+		// Delay allows caller (e.g. network stack) to complete processing first
+		erasePending = eraseTimer.startOnce();
+	}
+}
+
+void PartitionStream::eraseAhead()
+{
+	erasePending = false;
+	auto limit = std::min(size_t(writePos + eraseAheadDistance), size);
+	if(erasePos >= limit) {
+		return;
+	}
+
+	// One block at a time, yielding in between
+	if(eraseTo(erasePos + 1)) {
+		scheduleEraseAhead();
+	}
+}
+
 size_t PartitionStream::write(const uint8_t* data, size_t length)
 {
 	auto len = std::min(size_t(size - writePos), length);
@@ -51,18 +106,8 @@ size_t PartitionStream::write(const uint8_t* data, size_t length)
 		return 0;
 	}
 
-	if(blockErase) {
-		auto endPos = writePos + len;
-		if(endPos > erasePos) {
-			size_t blockSize = partition.getBlockSize();
-			size_t eraseLen = endPos - erasePos + blockSize - 1;
-			eraseLen -= eraseLen % blockSize;
-			debug_d("[PS] erase(0x%08x, 0x%08x", startOffset + erasePos, eraseLen);
-			if(!partition.erase_range(startOffset + erasePos, eraseLen)) {
-				return 0;
-			}
-			erasePos += eraseLen;
-		}
+	if(blockErase && !eraseTo(writePos + len)) {
+		return 0;
 	}
 
 	if(!partition.write(startOffset + writePos, data, len)) {
@@ -70,6 +115,11 @@ size_t PartitionStream::write(const uint8_t* data, size_t length)
 	}
 
 	writePos += len;
+
+	if(blockErase) {
+		scheduleEraseAhead();
+	}
+
 	return len;
 }
 
@@ -21,6 +21,16 @@ bool ProgMem::read(uint32_t address, void* dst, size_t size)
 	return readCount == size;
 }
 
+const void* ProgMem::getMappedPointer(uint32_t address, size_t size) const
+{
+	return flashmem_get_pointer(address, size);
+}
+
+void ProgMem::releaseMappedPointer(const void* ptr) const
+{
+	flashmem_release_pointer(ptr);
+}
+
 Partition ProgMem::createPartition(const String& name, const void* flashPtr, size_t size, Partition::Type type,
 								   uint8_t subtype)
 {
@@ -12,6 +12,8 @@
 #include "include/Storage/partition_info.h"
 #include <esp_spi_flash.h>
 #include <debug_progmem.h>
+#include <Platform/System.h>
+#include <Services/Profiling/Trace.h>
 
 namespace Storage
 {
@@ -40,12 +42,53 @@ size_t SpiFlash::getSize() const
 
 bool SpiFlash::read(uint32_t address, void* dst, size_t size)
 {
+	TRACE_SCOPE("flash-read", size);
 	size_t readCount = flashmem_read(dst, address, size);
 	return readCount == size;
 }
 
+bool SpiFlash::readAsync(uint32_t address, void* dst, size_t size, ReadCallback callback)
+{
+	if(!callback) {
+		return false;
+	}
+
+	// Use hardware where available, one transfer at a time
+	if(!asyncPending) {
+		asyncCallback = callback;
+		asyncPending = true;
+		if(flashmem_read_async(dst, address, size, readComplete, this)) {
+			return true;
+		}
+		asyncPending = false;
+		asyncCallback = nullptr;
+	}
+
+	return Device::readAsync(address, dst, size, callback);
+}
+
+void IRAM_ATTR SpiFlash::readComplete(void* param, bool success)
+{
+	auto self = static_cast<SpiFlash*>(param);
+	self->asyncSuccess = success;
+	bool queued = System.queueCallback(
+		[](void* param) {
+			auto self = static_cast<SpiFlash*>(param);
+			auto callback = std::move(self->asyncCallback);
+			self->asyncCallback = nullptr;
+			self->asyncPending = false;
+			callback(self->asyncSuccess);
+		},
+		self);
+	if(!queued) {
+		// Cannot notify caller or free delegate from interrupt context, but don't block subsequent reads
+		self->asyncPending = false;
+	}
+}
+
 bool SpiFlash::write(uint32_t address, const void* src, size_t size)
 {
+	TRACE_SCOPE("flash-write", size);
 	size_t writeCount = flashmem_write(src, address, size);
 	return writeCount == size;
 }
@@ -60,6 +103,7 @@ bool SpiFlash::erase_range(uint32_t address, size_t size)
 	auto sec = address / SPI_FLASH_SEC_SIZE;
 	auto end = (address + size) / SPI_FLASH_SEC_SIZE;
 	while(sec < end) {
+		TRACE_SCOPE("flash-erase", sec);
 		if(!flashmem_erase_sector(sec)) {
 			return false;
 		}
@@ -69,4 +113,14 @@ bool SpiFlash::erase_range(uint32_t address, size_t size)
 	return true;
 }
 
+const void* SpiFlash::getMappedPointer(uint32_t address, size_t size) const
+{
+	return flashmem_get_pointer(address, size);
+}
+
+void SpiFlash::releaseMappedPointer(const void* ptr) const
+{
+	flashmem_release_pointer(ptr);
+}
+
 } // namespace Storage
@@ -11,6 +11,7 @@
 #include "include/Storage.h"
 #include "include/Storage/SpiFlash.h"
 #include <debug_progmem.h>
+#include <Services/Profiling/BootTimeline.h>
 
 namespace Storage
 {
@@ -19,6 +20,7 @@ void initialize()
 	if(spiFlash == nullptr) {
 		spiFlash = new SpiFlash;
 		registerDevice(spiFlash);
+		BOOT_PHASE_SCOPE(partitionTable);
 		spiFlash->loadPartitions(PARTITION_TABLE_OFFSET);
 	}
 }
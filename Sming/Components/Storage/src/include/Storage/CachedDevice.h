@@ -0,0 +1,154 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/SmingHub/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * CachedDevice.h - Write-back sector cache for a storage device
+ *
+ ****/
+
+#pragma once
+
+#include "CustomDevice.h"
+#include <memory>
+
+namespace Storage
+{
+/**
+ * @brief Provides a write-back sector cache over another storage device
+ *
+ * Reads and writes are performed on fixed-size cache lines, which never span an erase block.
+ * The least-recently used line is replaced on a miss.
+ *
+ * Written data is held in the cache until `flush()` is called, or the line is evicted.
+ * Dirty lines are written back in ascending address order so each erase block is programmed
+ * in a single pass. Applications must call `flush()` at points where data must be committed,
+ * e.g. before sleep or restart. The destructor also flushes.
+ *
+ * Create partitions on this device (e.g. via `createPartition(const Partition&)`) so that
+ * filesystem access is routed through the cache.
+ *
+ * For flash devices, writes are applied to cached data in the same way as the hardware,
+ * i.e. bits may only be cleared.
+ */
+class CachedDevice : public CustomDevice
+{
+public:
+	struct Stats {
+		uint32_t hits;
+		uint32_t misses;
+		uint32_t readAheads;
+		uint32_t writeBacks;
+	};
+
+	/**
+	 * @brief Constructor
+	 * @param device The device to be cached
+	 * @param lineSize Size of each cache line, a power of 2 no larger than the device block size
+	 * @param lineCount Number of cache lines
+	 * @param readAhead Number of lines to pre-load when sequential reads are detected
+	 */
+	CachedDevice(Device& device, size_t lineSize = 512, uint8_t lineCount = 4, uint8_t readAhead = 1);
+
+	~CachedDevice()
+	{
+		flush();
+	}
+
+	String getName() const override
+	{
+		return F("cached.") + device.getName();
+	}
+
+	uint32_t getId() const override
+	{
+		return device.getId();
+	}
+
+	size_t getBlockSize() const override
+	{
+		return device.getBlockSize();
+	}
+
+	size_t getSize() const override
+	{
+		return device.getSize();
+	}
+
+	Type getType() const override
+	{
+		return device.getType();
+	}
+
+	bool read(uint32_t address, void* dst, size_t size) override;
+	bool write(uint32_t address, const void* src, size_t size) override;
+	bool erase_range(uint32_t address, size_t size) override;
+
+	/**
+	 * @brief Write any modified cache lines to the device
+	 * @retval bool false if any write failed
+	 */
+	bool flush();
+
+	/**
+	 * @brief Discard all cached data without writing it back
+	 */
+	void invalidate();
+
+	using CustomDevice::createPartition;
+
+	/**
+	 * @brief Create a partition on this device mirroring one on the wrapped device
+	 */
+	Partition createPartition(const Partition& source)
+	{
+		return createPartition(source.name(), source.type(), source.subType(), source.address(), source.size(),
+							   source.flags());
+	}
+
+	const Stats& getStats() const
+	{
+		return stats;
+	}
+
+	void resetStats()
+	{
+		stats = Stats{};
+	}
+
+private:
+	static constexpr uint32_t invalidAddress{0xffffffff};
+
+	struct Line {
+		uint32_t address{invalidAddress};
+		uint32_t lastUsed{0};
+		bool dirty{false};
+	};
+
+	uint8_t* getData(unsigned index)
+	{
+		return &buffer[index * lineSize];
+	}
+
+	int findLine(uint32_t address) const;
+	int loadLine(uint32_t address, bool fetch);
+	int getVictim();
+	bool writeBack(unsigned index);
+	void touch(unsigned index)
+	{
+		lines[index].lastUsed = ++useCounter;
+	}
+
+	Device& device;
+	std::unique_ptr<Line[]> lines;
+	std::unique_ptr<uint8_t[]> buffer;
+	size_t lineSize;
+	uint8_t lineCount;
+	uint8_t readAhead;
+	uint32_t useCounter{0};
+	uint32_t lastMiss{invalidAddress};
+	Stats stats{};
+};
+
+} // namespace Storage
@@ -25,6 +25,32 @@
 namespace Storage
 {
 class SpiFlash;
+class Device;
+
+/**
+ * @brief Receives notification of changes to device content
+ *
+ * Writes and erases made through a Partition are reported after they have succeeded.
+ * Calls made directly on a Device are not reported.
+ *
+ * Use this to invalidate cached information derived from storage content.
+ */
+class WriteObserver : public LinkedObjectTemplate<WriteObserver>
+{
+public:
+	using List = LinkedObjectListTemplate<WriteObserver>;
+
+	virtual ~WriteObserver();
+
+	/**
+	 * @brief Called after a region has been written or erased
+	 * @param device
+	 * @param address Start of region on device
+	 * @param size Size of region in bytes
+	 * @note Observers must not be added or removed from within this callback
+	 */
+	virtual void onDeviceWrite(Device& device, uint32_t address, size_t size) = 0;
+};
 
 /**
  * @brief Represents a storage device (e.g. flash memory)
@@ -122,6 +148,20 @@ public:
 	 */
 	virtual bool read(uint32_t address, void* dst, size_t size) = 0;
 
+	/**
+	 * @brief Read data from the storage device without blocking the caller
+	 * @param address Where to start reading
+	 * @param dst Buffer to store data, must remain valid until the callback is invoked
+	 * @param size Size of data to be read, in bytes.
+	 * @param callback Invoked from task context when the read has completed
+	 * @retval bool true if request was queued, false if it could not be started
+	 * @note The callback is not invoked if this method returns false.
+	 *
+	 * Devices with suitable hardware support (e.g. DMA) override this, performing the transfer
+	 * in the background. The default implementation performs a regular `read()` and queues the callback.
+	 */
+	virtual bool readAsync(uint32_t address, void* dst, size_t size, ReadCallback callback);
+
 	/**
 	 * @brief Write data to the storage device
 	 * @param address Where to start writing
@@ -139,6 +179,54 @@ public:
 	 */
 	virtual bool erase_range(uint32_t address, size_t size) = 0;
 
+	/**
+	 * @brief Obtain a direct pointer to device content, where supported
+	 * @param address Start of region
+	 * @param size Size of region, in bytes
+	 * @retval const void* Location of content in CPU address space, nullptr if not mapped
+	 *
+	 * Use this to access content without copying it into RAM. Callers must fall back
+	 * to `read()` if this fails.
+	 *
+	 * For flash devices the returned pointer is in PROGMEM space and must be accessed accordingly,
+	 * i.e. using `memcpy_P`, `pgm_read_byte`, etc. or 32-bit aligned reads.
+	 * Content is not guaranteed to be consistent if the region is subsequently written or erased.
+	 * Call `releaseMappedPointer()` when access is complete.
+	 */
+	virtual const void* getMappedPointer(uint32_t address, size_t size) const
+	{
+		return nullptr;
+	}
+
+	/**
+	 * @brief Release a pointer obtained from `getMappedPointer()`
+	 * @param ptr May be null
+	 *
+	 * Some devices map regions on demand and have limited address space for doing so.
+	 */
+	virtual void releaseMappedPointer(const void* ptr) const
+	{
+	}
+
+	/**
+	 * @brief Register an observer to be notified of all writes and erases made through partitions
+	 * @retval bool false if already registered
+	 */
+	static bool addWriteObserver(WriteObserver& observer);
+
+	/**
+	 * @brief Remove a registered observer
+	 * @note Observers are removed automatically on destruction
+	 */
+	static void removeWriteObserver(WriteObserver& observer);
+
+	/**
+	 * @brief Report a change to device content to all registered observers
+	 * @param address Start of modified region
+	 * @param size Size of modified region, in bytes
+	 */
+	void notifyWrite(uint32_t address, size_t size);
+
 protected:
 	PartitionTable mPartitions;
 };
@@ -28,6 +28,7 @@
 
 #include <Data/BitSet.h>
 #include <Data/CString.h>
+#include <Delegate.h>
 #include <memory>
 #include <cassert>
 
@@ -72,6 +73,12 @@ class Device;
 class PartitionTable;
 struct esp_partition_info_t;
 
+/**
+ * @brief Completion callback for asynchronous reads
+ * @param success true if all data was read
+ */
+using ReadCallback = Delegate<void(bool success)>;
+
 /**
  * @brief Represents a flash partition
  */
@@ -216,6 +223,17 @@ public:
 		return read(offset, &value, sizeof(value));
 	}
 
+	/**
+	 * @brief Read data from the partition without blocking the caller
+	 * @param offset Where to start reading, relative to start of partition
+	 * @param dst Buffer to store data, must remain valid until the callback is invoked
+	 * @param size Size of data to be read, in bytes.
+	 * @param callback Invoked from task context on completion
+	 * @retval bool true if request was queued, callback will then be invoked
+	 * @see See `Device::readAsync()`
+	 */
+	bool readAsync(size_t offset, void* dst, size_t size, ReadCallback callback);
+
 	/**
 	 * @brief Write data to the partition
 	 * @param offset Where to start writing, relative to start of partition
@@ -235,6 +253,22 @@ public:
 	 */
 	bool erase_range(size_t offset, size_t size);
 
+	/**
+	 * @brief Obtain a direct pointer to partition content for zero-copy access
+	 * @param offset Start of region, relative to start of partition
+	 * @param size Size of region, in bytes
+	 * @retval const void* Location of content, nullptr if unavailable
+	 *
+	 * Only supported for read-only partitions on memory-mapped devices, otherwise use `read()`.
+	 * See `Device::getMappedPointer()` for access restrictions.
+	 */
+	const void* getMappedPointer(size_t offset, size_t size) const;
+
+	/**
+	 * @brief Release a pointer obtained from `getMappedPointer()`
+	 */
+	void releaseMappedPointer(const void* ptr) const;
+
 	/**
 	 * @brief Obtain partition type
 	 */
@@ -11,6 +11,7 @@
 #pragma once
 
 #include <Data/Stream/ReadWriteStream.h>
+#include <SimpleTimer.h>
 #include "Partition.h"
 
 namespace Storage
@@ -67,14 +68,39 @@ public:
 		return available() <= 0;
 	}
 
+	/**
+	 * @brief Erase blocks ahead of the write position during idle time
+	 * @param distance Number of bytes to keep erased ahead of data written, 0 to erase only as required
+	 *
+	 * Blocks are erased one at a time between writes, so the write path need only program
+	 * flash which has already been erased. Has no effect unless blockErase is enabled.
+	 */
+	void setEraseAhead(size_t distance)
+	{
+		eraseAheadDistance = distance;
+		eraseTimer.initializeMs<1>(staticEraseAhead, this);
+	}
+
 private:
+	static void staticEraseAhead(void* param)
+	{
+		static_cast<PartitionStream*>(param)->eraseAhead();
+	}
+
+	bool eraseTo(uint32_t endPos);
+	void eraseAhead();
+	void scheduleEraseAhead();
+
 	Partition partition;
 	uint32_t startOffset;
 	size_t size;
 	uint32_t writePos{0};
 	uint32_t readPos{0};
 	uint32_t erasePos{0};
+	uint32_t eraseAheadDistance{0};
+	SimpleTimer eraseTimer;
 	bool blockErase;
+	bool erasePending{false};
 };
 
 } // namespace Storage
@@ -51,6 +51,9 @@ public:
 		return false;
 	}
 
+	const void* getMappedPointer(uint32_t address, size_t size) const override;
+	void releaseMappedPointer(const void* ptr) const override;
+
 	using CustomDevice::createPartition;
 
 	/**
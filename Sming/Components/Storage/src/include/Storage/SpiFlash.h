@@ -33,8 +33,18 @@ public:
 	uint32_t getId() const override;
 
 	bool read(uint32_t address, void* dst, size_t size) override;
+	bool readAsync(uint32_t address, void* dst, size_t size, ReadCallback callback) override;
 	bool write(uint32_t address, const void* src, size_t size) override;
 	bool erase_range(uint32_t address, size_t size) override;
+	const void* getMappedPointer(uint32_t address, size_t size) const override;
+	void releaseMappedPointer(const void* ptr) const override;
+
+private:
+	static void readComplete(void* param, bool success);
+
+	ReadCallback asyncCallback;
+	volatile bool asyncPending{false}; ///< Set whilst a hardware transfer owns asyncCallback
+	bool asyncSuccess{false};
 };
 
 } // namespace Storage
@@ -70,6 +70,11 @@ public:
 		return true;
 	}
 
+	const void* getMappedPointer(uint32_t address, size_t size) const override
+	{
+		return reinterpret_cast<const void*>(address);
+	}
+
 	using CustomDevice::createPartition;
 
 	/**
@@ -290,6 +290,7 @@ bool i2s_enable_loopback(bool enable);
 typedef struct {
 	uint16_t size;
 	uint16_t used;
+	uint16_t overflows; ///< TX: Buffers sent with no data (underrun), RX: Buffers discarded (overrun)
 } i2s_buffer_stat_t;
 
 /**
@@ -233,6 +233,7 @@ using smg_uart_notify_callback_t = void (*)(smg_uart_t* uart, smg_uart_notify_co
 bool smg_uart_set_notify(unsigned uart_nr, smg_uart_notify_callback_t callback);
 
 struct SerialBuffer;
+struct smg_uart_tx_desc_t;
 
 struct smg_uart_t {
 	uint8_t uart_nr;
@@ -245,6 +246,7 @@ struct smg_uart_t {
 	uint16_t status;				///< All status flags reported to callback since last uart_get_status() call
 	struct SerialBuffer* rx_buffer; ///< Optional receive buffer
 	struct SerialBuffer* tx_buffer; ///< Optional transmit buffer
+	smg_uart_tx_desc_t* tx_queue;	///< Caller-owned blocks awaiting transmission
 	smg_uart_callback_t callback;   ///< Optional User callback routine
 	void* param;					///< User-supplied callback parameter
 };
@@ -298,6 +300,16 @@ typedef struct {
   */
 bool smg_uart_intr_config(smg_uart_t* uart, const smg_uart_intr_config_t* config);
 
+/**
+ * @brief Set receive timeout threshold
+ * @param uart
+ * @param chars Idle time after last received character, in character times
+ * @retval bool true on success, false if unsupported
+ * @note Receive timeout is reported via UART_STATUS_RXFIFO_TOUT, so can be used for idle-line frame detection.
+ * The hardware only generates a timeout if the receive FIFO contains data.
+ */
+bool smg_uart_set_rx_timeout(smg_uart_t* uart, uint8_t chars);
+
 __forceinline int smg_uart_get_nr(smg_uart_t* uart)
 {
 	return uart ? uart->uart_nr : -1;
@@ -410,6 +422,34 @@ static inline size_t smg_uart_write_char(smg_uart_t* uart, char c)
 	return smg_uart_write(uart, &c, 1);
 }
 
+/** @brief Callback invoked when a queued transmit block has been sent or discarded
+ *  @param uart
+ *  @param desc The completed block
+ *  @note Called from interrupt context, except where smg_uart_flush() discards the block
+ */
+typedef void (*smg_uart_tx_done_t)(smg_uart_t* uart, smg_uart_tx_desc_t* desc);
+
+/** @brief Describes a caller-owned block of data for transmission
+ */
+struct smg_uart_tx_desc_t {
+	const uint8_t* data;
+	uint16_t length;
+	uint16_t sent;				 ///< Bytes passed to hardware, less than `length` if discarded
+	smg_uart_tx_done_t callback; ///< Optional completion callback
+	void* param;				 ///< User parameter
+	smg_uart_tx_desc_t* next;	///< Used internally
+};
+
+/** @brief queue a caller-owned block of data for transmission without copying
+ *  @param uart
+ *  @param desc Describes the data, which must remain valid until the callback is invoked
+ *  @retval bool false if the port does not support queued transmission, or `desc` is invalid
+ *  @note Blocks are sent in order, after any data already in the transmit buffer.
+ *  Data subsequently written using smg_uart_write() may be sent ahead of queued blocks.
+ *  Currently supported for physical Esp8266 ports only.
+ */
+bool smg_uart_write_desc(smg_uart_t* uart, smg_uart_tx_desc_t* desc);
+
 /** @brief read a block of data
  *  @param uart
  *  @param buffer where to write the data
@@ -1,3 +1,15 @@
 COMPONENT_SRCDIRS := src
 COMPONENT_INCDIRS := include
 COMPONENT_DOXYGEN_INPUT := include
+
+# Use hardware acceleration where available
+COMPONENT_VARS += ENABLE_HWCRYPTO
+ENABLE_HWCRYPTO ?= 1
+ifeq ($(ENABLE_HWCRYPTO),1)
+ifeq ($(SMING_ARCH),Esp32)
+# SHA peripheral driver is part of mbedcrypto, only linked with networking
+ifneq ($(DISABLE_NETWORK),1)
+COMPONENT_CXXFLAGS += -DENABLE_HWCRYPTO=1
+endif
+endif
+endif
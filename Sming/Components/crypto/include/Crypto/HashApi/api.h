@@ -29,6 +29,9 @@
 #define CRYPTO_FUNC_SET_STATE(hash)                                                                                    \
 	void CRYPTO_NAME(hash, set_state)(CRYPTO_CTX(hash) * ctx, const void* state, uint64_t count)
 
+#define CRYPTO_FUNC_MULTI(hash)                                                                                        \
+	void CRYPTO_NAME(hash, multi)(const uint8_t** msg, const uint32_t* msg_len, int count, uint8_t* digests)
+
 #define CRYPTO_FUNC_HMAC(hash)                                                                                         \
 	void CRYPTO_NAME(hash, hmac)(const uint8_t* msg, int msg_len, const uint8_t* key, int key_len, uint8_t* digest)
 #define CRYPTO_FUNC_HMAC_V(hash)                                                                                       \
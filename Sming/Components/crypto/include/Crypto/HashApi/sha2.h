@@ -52,6 +52,16 @@ CRYPTO_FUNC_FINAL(sha256);
 CRYPTO_FUNC_GET_STATE(sha256);
 CRYPTO_FUNC_SET_STATE(sha256);
 
+/**
+ * @brief Calculate SHA256 digests for several independent messages
+ * @param msg Array of message pointers
+ * @param msg_len Array of message lengths
+ * @param count Number of messages
+ * @param digests Output buffer, receives `count * SHA256_SIZE` bytes
+ * @note Best suited to short messages: two messages are processed at a time with interleaved rounds.
+ */
+CRYPTO_FUNC_MULTI(sha256);
+
 CRYPTO_FUNC_HMAC_V(sha256);
 static inline CRYPTO_FUNC_HMAC(sha256)
 {
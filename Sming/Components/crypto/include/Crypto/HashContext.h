@@ -55,6 +55,25 @@ public:
 		return getHash();
 	}
 
+	/**
+	 * @brief Calculate hashes for several independent messages
+	 * @param messages Array of messages
+	 * @param hashes OUT: Array to receive one hash per message
+	 * @param count Number of messages
+	 *
+	 * Some engines provide an optimised implementation for this, such as SHA256.
+	 */
+	static void calculateBatch(const Blob* messages, Hash* hashes, size_t count)
+	{
+		HashContext ctx;
+		for(size_t i = 0; i < count; ++i) {
+			if(i != 0) {
+				ctx.reset();
+			}
+			hashes[i] = ctx.calculate(messages[i]);
+		}
+	}
+
 	/**
 	 * @name Update hash over a given block of data
 	 * @{
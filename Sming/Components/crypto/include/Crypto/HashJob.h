@@ -0,0 +1,140 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/SmingHub/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * HashJob.h - Calculate a hash in the background
+ *
+ ****/
+
+#pragma once
+
+#include "HashContext.h"
+#include <Platform/System.h>
+#include <Delegate.h>
+
+#ifdef ARCH_RP2040
+#include <core1_worker.h>
+#endif
+
+namespace Crypto
+{
+/**
+ * @brief Calculate a hash over a block of data without blocking the application
+ * @tparam Context Hash context, such as `Crypto::Sha256`
+ *
+ * On the RP2040, when the core1 worker has been started, the hash is calculated on the second core.
+ * Otherwise it is calculated from a low-priority task callback.
+ * In both cases the completion callback is invoked on the main core from the task queue.
+ *
+ * The data must remain valid and unchanged until the completion callback has been invoked.
+ * If the job is destroyed whilst busy the callback is not invoked, and the destructor waits for
+ * any calculation already in progress on core1 so the data may then be released.
+ */
+template <class Context> class HashJob
+{
+public:
+	using Hash = typename Context::Hash;
+	using Callback = Delegate<void(const Hash& hash)>;
+
+	HashJob() = default;
+	HashJob(const HashJob&) = delete;
+	HashJob& operator=(const HashJob&) = delete;
+
+	~HashJob()
+	{
+		if(request == nullptr) {
+			return;
+		}
+		request->job = nullptr;
+		// Request itself is released by the completion callback
+		while(request->onCore1 && !request->done) {
+		}
+	}
+
+	/**
+	 * @brief Start calculating a hash
+	 * @param data Start of data to hash
+	 * @param size Number of bytes
+	 * @param callback Invoked with the result
+	 * @retval bool false if a calculation is already in progress or the job could not be queued
+	 */
+	bool submit(const void* data, size_t size, Callback callback)
+	{
+		if(request != nullptr || !callback) {
+			return false;
+		}
+
+		auto req = new Request{this, data, size, {}, false, false};
+		if(req == nullptr) {
+			return false;
+		}
+
+#ifdef ARCH_RP2040
+		req->onCore1 = core1_worker_submit(execute, complete, req);
+		if(!req->onCore1)
+#endif
+		{
+			auto run = [](void* param) {
+				execute(param);
+				complete(param);
+			};
+			if(!System.queueCallback(TaskPriority::Low, run, req)) {
+				delete req;
+				return false;
+			}
+		}
+
+		request = req;
+		this->callback = std::move(callback);
+		return true;
+	}
+
+	/**
+	 * @brief Determine whether a calculation is in progress
+	 */
+	bool isBusy() const
+	{
+		return request != nullptr;
+	}
+
+private:
+	struct Request {
+		HashJob* volatile job; ///< Cleared if job is destroyed
+		const void* data;
+		size_t size;
+		Hash hash;
+		bool onCore1;
+		volatile bool done;
+	};
+
+	// Called on core1 where available, so must only access the request
+	static void execute(void* param)
+	{
+		auto req = static_cast<Request*>(param);
+		if(req->job != nullptr) {
+			req->hash = Context().calculate(req->data, req->size);
+		}
+		req->done = true;
+	}
+
+	static void complete(void* param)
+	{
+		auto req = static_cast<Request*>(param);
+		auto job = req->job;
+		if(job != nullptr) {
+			job->request = nullptr;
+			// Callback may submit another request
+			auto callback = std::move(job->callback);
+			job->callback = nullptr;
+			callback(req->hash);
+		}
+		delete req;
+	}
+
+	Request* request{nullptr};
+	Callback callback;
+};
+
+} // namespace Crypto
@@ -19,7 +19,11 @@ namespace Crypto
 /**
  * @brief HMAC class template
  *
- * Implements the HMAC algorithm using any defined hash context
+ * Implements the HMAC algorithm using any defined hash context.
+ *
+ * The key is absorbed into inner and outer hash states once, by init().
+ * These states are then copied for each message, so a context may be re-used
+ * for any number of messages with the same key without re-processing the key blocks.
  */
 template <class HashContext> class HmacContext
 {
@@ -59,7 +63,7 @@ public:
 			memcpy(inputPad.data(), hash.data(), hash.size());
 		}
 
-		outputPad = inputPad;
+		auto outputPad = inputPad;
 
 		for(auto& c : inputPad) {
 			c ^= 0x36;
@@ -68,12 +72,25 @@ public:
 			c ^= 0x5c;
 		}
 
-		ctx.reset();
-		ctx.update(inputPad);
+		innerCtx.reset();
+		innerCtx.update(inputPad);
+		outerCtx.reset();
+		outerCtx.update(outputPad);
+		ctx = innerCtx;
 
 		return *this;
 	}
 
+	/**
+	 * @brief Discard any message content and prepare for a new message using the same key
+	 * @retval Reference to enable method chaining
+	 */
+	HmacContext& reset()
+	{
+		ctx = innerCtx;
+		return *this;
+	}
+
 	/**
 	 * @brief Update HMAC with some message content
 	 * @param args See HashContext update() methods
@@ -85,14 +102,21 @@ public:
 		return *this;
 	}
 
+	/**
+	 * @brief Finalise and return the HMAC value
+	 * @retval Hash
+	 * @note The context is reset ready for another message using the same key
+	 */
 	Hash getHash()
 	{
 		auto tmp = ctx.getHash();
 
-		ctx.reset();
-		ctx.update(outputPad);
+		ctx = outerCtx;
 		ctx.update(tmp);
-		return ctx.getHash();
+		auto hash = ctx.getHash();
+
+		ctx = innerCtx;
+		return hash;
 	}
 
 	/**
@@ -111,8 +135,26 @@ public:
 		return getHash();
 	}
 
+	/**
+	 * @brief Calculate HMAC values for several messages using the same key
+	 * @param messages Array of messages
+	 * @param hashes OUT: Array to receive one hash per message
+	 * @param count Number of messages
+	 *
+	 * Any message content added previously via update() is discarded.
+	 */
+	void calculateBatch(const Blob* messages, Hash* hashes, size_t count)
+	{
+		for(size_t i = 0; i < count; ++i) {
+			ctx = innerCtx;
+			ctx.update(messages[i]);
+			hashes[i] = getHash();
+		}
+	}
+
 private:
-	ByteArray<blocksize> outputPad;
+	HashContext innerCtx; ///< State after absorbing key XOR ipad
+	HashContext outerCtx; ///< State after absorbing key XOR opad
 	HashContext ctx;
 };
 
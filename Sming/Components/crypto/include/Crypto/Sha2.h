@@ -14,6 +14,7 @@
 #include "HashEngine.h"
 #include "HashContext.h"
 #include "HmacContext.h"
+#include <algorithm>
 
 namespace Crypto
 {
@@ -31,6 +32,29 @@ using Sha256 = HashContext<Sha256Engine>;
 using Sha384 = HashContext<Sha384Engine>;
 using Sha512 = HashContext<Sha512Engine>;
 
+/**
+ * @brief SHA256 batch calculation using multi-buffer implementation
+ */
+template <>
+inline void HashContext<Sha256Engine>::calculateBatch(const Blob* messages, Hash* hashes, size_t count)
+{
+	static_assert(sizeof(Hash) == SHA256_SIZE, "Unexpected Hash size");
+	constexpr size_t groupSize{8};
+	const uint8_t* msg[groupSize];
+	uint32_t msgLen[groupSize];
+	while(count != 0) {
+		auto n = std::min(count, groupSize);
+		for(size_t i = 0; i < n; ++i) {
+			msg[i] = messages[i].data();
+			msgLen[i] = messages[i].size();
+		}
+		crypto_sha256_multi(msg, msgLen, n, hashes[0].data());
+		messages += n;
+		hashes += n;
+		count -= n;
+	}
+}
+
 /*
  * HMAC contexts
  */
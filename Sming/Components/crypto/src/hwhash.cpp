@@ -0,0 +1,100 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/SmingHub/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * hwhash.cpp
+ *
+ ****/
+
+#include "hwhash.h"
+
+#ifdef CRYPTO_HW_SHA
+
+#include <hal/sha_types.h>
+
+/*
+ * SHA DMA driver provided by the IDF mbedtls port.
+ * Prototypes declared here as the port include directory isn't in the search path.
+ */
+extern "C" {
+void esp_sha_acquire_hardware(void);
+void esp_sha_release_hardware(void);
+int esp_sha_dma(esp_sha_type sha_type, const void* input, uint32_t ilen, const void* buf, uint32_t buf_len,
+				bool is_first_block);
+void esp_sha_write_digest_state(esp_sha_type sha_type, void* digest_state);
+void esp_sha_read_digest_state(esp_sha_type sha_type, void* digest_state);
+}
+
+namespace
+{
+/*
+ * Peripheral holds digest words in big-endian byte order
+ */
+template <typename T> void swapState(T dst[], const T src[], unsigned count)
+{
+	for(unsigned i = 0; i < count; ++i) {
+		dst[i] = (sizeof(T) == sizeof(uint64_t)) ? T(__builtin_bswap64(src[i])) : T(__builtin_bswap32(src[i]));
+	}
+}
+
+template <typename T, unsigned stateWords>
+bool process(esp_sha_type type, T state[], const uint8_t* blocks, size_t length)
+{
+	T hwState[stateWords];
+	swapState(hwState, state, stateWords);
+
+	esp_sha_acquire_hardware();
+	esp_sha_write_digest_state(type, hwState);
+	int err = esp_sha_dma(type, blocks, length, nullptr, 0, false);
+	if(err == 0) {
+		esp_sha_read_digest_state(type, hwState);
+	}
+	esp_sha_release_hardware();
+
+	if(err != 0) {
+		return false;
+	}
+
+	swapState(state, hwState, stateWords);
+	return true;
+}
+
+} // namespace
+
+namespace Crypto
+{
+namespace Internal
+{
+namespace Hardware
+{
+bool sha1Process(uint32_t state[], const uint8_t* blocks, size_t length)
+{
+	return process<uint32_t, 5>(SHA1, state, blocks, length);
+}
+
+bool sha256Process(uint32_t state[], const uint8_t* blocks, size_t length)
+{
+	// SHA224 uses the same compression function, only the IV differs
+	return process<uint32_t, 8>(SHA2_256, state, blocks, length);
+}
+
+bool sha512Process(uint64_t state[], const uint8_t* blocks, size_t length)
+{
+#ifdef CRYPTO_HW_SHA512
+	// SHA384 uses the same compression function, only the IV differs
+	return process<uint64_t, 8>(SHA2_512, state, blocks, length);
+#else
+	(void)state;
+	(void)blocks;
+	(void)length;
+	return false;
+#endif
+}
+
+} // namespace Hardware
+} // namespace Internal
+} // namespace Crypto
+
+#endif // CRYPTO_HW_SHA
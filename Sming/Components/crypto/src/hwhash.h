@@ -0,0 +1,54 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/SmingHub/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * hwhash.h - Hardware hash acceleration
+ *
+ * Where a SHA peripheral is available, complete message blocks are passed to it in bulk.
+ * The intermediate state remains in the software context so get_state / set_state,
+ * partial blocks and finalisation are unaffected.
+ *
+ * The ESP32-S2, S3 and C3 SHA peripherals allow the intermediate state to be loaded, so are supported.
+ * The original ESP32 peripheral does not, and the RP2040 has no SHA peripheral: software is used for these.
+ *
+ ****/
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#if defined(ARCH_ESP32) && defined(ENABLE_HWCRYPTO)
+#include <soc/soc_caps.h>
+#if SOC_SHA_SUPPORT_DMA
+#define CRYPTO_HW_SHA
+#if SOC_SHA_SUPPORT_SHA512
+#define CRYPTO_HW_SHA512
+#endif
+#endif
+#endif
+
+namespace Crypto
+{
+namespace Internal
+{
+namespace Hardware
+{
+/**
+ * @brief Process complete blocks using hardware
+ * @param state Intermediate state in host word order, updated on success
+ * @param blocks Message data, a whole number of blocks
+ * @param length Number of bytes in message data
+ * @retval bool false if hardware is unavailable, in which case state is unchanged
+ * @{
+ */
+bool sha1Process(uint32_t state[], const uint8_t* blocks, size_t length);
+bool sha256Process(uint32_t state[], const uint8_t* blocks, size_t length);
+bool sha512Process(uint64_t state[], const uint8_t* blocks, size_t length);
+/** @} */
+
+} // namespace Hardware
+} // namespace Internal
+} // namespace Crypto
@@ -23,6 +23,7 @@
  */
 
 #include "stdhash.h"
+#include "hwhash.h"
 #include "../include/Crypto/HashApi/sha1.h"
 
 namespace
@@ -137,7 +138,11 @@ CRYPTO_FUNC_INIT(sha1)
 
 CRYPTO_FUNC_UPDATE(sha1)
 {
+#ifdef CRYPTO_HW_SHA
+	hashUpdate(ctx, br_sha1_round, input, length, Hardware::sha1Process);
+#else
 	hashUpdate(ctx, br_sha1_round, input, length);
+#endif
 }
 
 CRYPTO_FUNC_FINAL(sha1)
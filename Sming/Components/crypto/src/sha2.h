@@ -20,6 +20,7 @@
 #pragma once
 
 #include "stdhash.h"
+#include "hwhash.h"
 #include "../include/Crypto/HashApi/sha2.h"
 
 namespace Crypto
@@ -160,6 +161,74 @@ __forceinline void process(T state[], const uint8_t block[], const T k[])
 	state[7] += h;
 }
 
+/**
+ * Two-lane variant of step(), lanes passed as arrays of 2
+ */
+template <class Sum, typename T>
+__forceinline void step2(T a[], T b[], T c[], T d[], T e[], T f[], T g[], T h[], T w0, T w1, T k)
+{
+	T temp1_0 = h[0] + Sum::s1(e[0]) + CH(e[0], f[0], g[0]) + k + w0;
+	T temp1_1 = h[1] + Sum::s1(e[1]) + CH(e[1], f[1], g[1]) + k + w1;
+	T temp2_0 = Sum::s0(a[0]) + MAJ(a[0], b[0], c[0]);
+	T temp2_1 = Sum::s0(a[1]) + MAJ(a[1], b[1], c[1]);
+	d[0] += temp1_0;
+	d[1] += temp1_1;
+	h[0] = temp1_0 + temp2_0;
+	h[1] = temp1_1 + temp2_1;
+}
+
+/**
+ * Process one block from each of two independent messages
+ *
+ * Rounds for the two messages are interleaved. This gives the compiler two independent
+ * dependency chains to schedule, and each round constant is fetched once for both.
+ */
+template <unsigned len, class Sigma, class Sum, typename T>
+__forceinline void process2(T state0[], const uint8_t block0[], T state1[], const uint8_t block1[], const T k[])
+{
+	T w0[len];
+	T w1[len];
+	extend<Sigma, len>(w0, block0);
+	extend<Sigma, len>(w1, block1);
+
+	T a[2]{state0[0], state1[0]};
+	T b[2]{state0[1], state1[1]};
+	T c[2]{state0[2], state1[2]};
+	T d[2]{state0[3], state1[3]};
+	T e[2]{state0[4], state1[4]};
+	T f[2]{state0[5], state1[5]};
+	T g[2]{state0[6], state1[6]};
+	T h[2]{state0[7], state1[7]};
+
+	for(unsigned i = 0; i < len; i += 8) {
+		step2<Sum>(a, b, c, d, e, f, g, h, w0[i + 0], w1[i + 0], k[i + 0]);
+		step2<Sum>(h, a, b, c, d, e, f, g, w0[i + 1], w1[i + 1], k[i + 1]);
+		step2<Sum>(g, h, a, b, c, d, e, f, w0[i + 2], w1[i + 2], k[i + 2]);
+		step2<Sum>(f, g, h, a, b, c, d, e, w0[i + 3], w1[i + 3], k[i + 3]);
+		step2<Sum>(e, f, g, h, a, b, c, d, w0[i + 4], w1[i + 4], k[i + 4]);
+		step2<Sum>(d, e, f, g, h, a, b, c, w0[i + 5], w1[i + 5], k[i + 5]);
+		step2<Sum>(c, d, e, f, g, h, a, b, w0[i + 6], w1[i + 6], k[i + 6]);
+		step2<Sum>(b, c, d, e, f, g, h, a, w0[i + 7], w1[i + 7], k[i + 7]);
+	}
+
+	state0[0] += a[0];
+	state0[1] += b[0];
+	state0[2] += c[0];
+	state0[3] += d[0];
+	state0[4] += e[0];
+	state0[5] += f[0];
+	state0[6] += g[0];
+	state0[7] += h[0];
+	state1[0] += a[1];
+	state1[1] += b[1];
+	state1[2] += c[1];
+	state1[3] += d[1];
+	state1[4] += e[1];
+	state1[5] += f[1];
+	state1[6] += g[1];
+	state1[7] += h[1];
+}
+
 } // namespace sha2
 } // namespace Internal
 } // namespace Crypto
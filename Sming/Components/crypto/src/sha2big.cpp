@@ -68,7 +68,11 @@ CRYPTO_FUNC_INIT(sha384)
 
 CRYPTO_FUNC_UPDATE(sha384)
 {
+#ifdef CRYPTO_HW_SHA512
+	hashUpdate(ctx, sha2big_process, input, length, Hardware::sha512Process);
+#else
 	hashUpdate(ctx, sha2big_process, input, length);
+#endif
 }
 
 CRYPTO_FUNC_FINAL(sha384)
@@ -12,25 +12,80 @@
 
 namespace
 {
+using Sigma = sha2::Sigma<uint32_t, 7, 18, 3, 17, 19, 10>;
+using Sum = sha2::Sum<uint32_t, 2, 13, 22, 6, 11, 25>;
+
+const uint32_t K[64] PROGMEM = {
+	0x428A2F98, 0x71374491, 0xB5C0FBCF, 0xE9B5DBA5, 0x3956C25B, 0x59F111F1, 0x923F82A4, 0xAB1C5ED5,
+	0xD807AA98, 0x12835B01, 0x243185BE, 0x550C7DC3, 0x72BE5D74, 0x80DEB1FE, 0x9BDC06A7, 0xC19BF174,
+	0xE49B69C1, 0xEFBE4786, 0x0FC19DC6, 0x240CA1CC, 0x2DE92C6F, 0x4A7484AA, 0x5CB0A9DC, 0x76F988DA,
+	0x983E5152, 0xA831C66D, 0xB00327C8, 0xBF597FC7, 0xC6E00BF3, 0xD5A79147, 0x06CA6351, 0x14292967,
+	0x27B70A85, 0x2E1B2138, 0x4D2C6DFC, 0x53380D13, 0x650A7354, 0x766A0ABB, 0x81C2C92E, 0x92722C85,
+	0xA2BFE8A1, 0xA81A664B, 0xC24B8B70, 0xC76C51A3, 0xD192E819, 0xD6990624, 0xF40E3585, 0x106AA070,
+	0x19A4C116, 0x1E376C08, 0x2748774C, 0x34B0BCB5, 0x391C0CB3, 0x4ED8AA4A, 0x5B9CCA4F, 0x682E6FF3,
+	0x748F82EE, 0x78A5636F, 0x84C87814, 0x8CC70208, 0x90BEFFFA, 0xA4506CEB, 0xBEF9A3F7, 0xC67178F2,
+};
+
+const uint32_t sha256_IV[8] PROGMEM = {
+	0x6A09E667, 0xBB67AE85, 0x3C6EF372, 0xA54FF53A, 0x510E527F, 0x9B05688C, 0x1F83D9AB, 0x5BE0CD19,
+};
+
 void sha2small_process(uint32_t state[], const uint8_t block[])
 {
-	using Sigma = sha2::Sigma<uint32_t, 7, 18, 3, 17, 19, 10>;
-	using Sum = sha2::Sum<uint32_t, 2, 13, 22, 6, 11, 25>;
-
-	static const uint32_t K[64] PROGMEM = {
-		0x428A2F98, 0x71374491, 0xB5C0FBCF, 0xE9B5DBA5, 0x3956C25B, 0x59F111F1, 0x923F82A4, 0xAB1C5ED5,
-		0xD807AA98, 0x12835B01, 0x243185BE, 0x550C7DC3, 0x72BE5D74, 0x80DEB1FE, 0x9BDC06A7, 0xC19BF174,
-		0xE49B69C1, 0xEFBE4786, 0x0FC19DC6, 0x240CA1CC, 0x2DE92C6F, 0x4A7484AA, 0x5CB0A9DC, 0x76F988DA,
-		0x983E5152, 0xA831C66D, 0xB00327C8, 0xBF597FC7, 0xC6E00BF3, 0xD5A79147, 0x06CA6351, 0x14292967,
-		0x27B70A85, 0x2E1B2138, 0x4D2C6DFC, 0x53380D13, 0x650A7354, 0x766A0ABB, 0x81C2C92E, 0x92722C85,
-		0xA2BFE8A1, 0xA81A664B, 0xC24B8B70, 0xC76C51A3, 0xD192E819, 0xD6990624, 0xF40E3585, 0x106AA070,
-		0x19A4C116, 0x1E376C08, 0x2748774C, 0x34B0BCB5, 0x391C0CB3, 0x4ED8AA4A, 0x5B9CCA4F, 0x682E6FF3,
-		0x748F82EE, 0x78A5636F, 0x84C87814, 0x8CC70208, 0x90BEFFFA, 0xA4506CEB, 0xBEF9A3F7, 0xC67178F2,
-	};
-
 	sha2::process<64, Sigma, Sum>(state, block, K);
 }
 
+/*
+ * One message being processed by crypto_sha256_multi().
+ * Complete blocks are read directly from the message; the remaining bytes are padded in `tail`.
+ */
+struct Lane {
+	uint32_t state[8];
+	const uint8_t* msg;
+	uint32_t blockBytes; ///< Bytes of complete blocks remaining in msg
+	uint8_t tail[2 * SHA256_BLOCKSIZE];
+	uint8_t tailBlocks;	///< Padded blocks remaining in tail
+	uint8_t tailIndex;
+	uint8_t* digest;
+
+	void begin(const uint8_t* input, uint32_t length, uint8_t* output)
+	{
+		memcpy(state, sha256_IV, sizeof(state));
+		msg = input;
+		digest = output;
+		blockBytes = length - (length % SHA256_BLOCKSIZE);
+
+		auto tailLength = length - blockBytes;
+		memcpy(tail, input + blockBytes, tailLength);
+		tail[tailLength++] = 0x80;
+		constexpr auto countPos = SHA256_BLOCKSIZE - sizeof(uint64_t);
+		tailBlocks = (tailLength > countPos) ? 2 : 1;
+		auto tailEnd = tailBlocks * SHA256_BLOCKSIZE;
+		memset(tail + tailLength, 0, tailEnd - sizeof(uint64_t) - tailLength);
+		encbe(tail + tailEnd - sizeof(uint64_t), uint64_t(length) * 8);
+		tailIndex = 0;
+	}
+
+	const uint8_t* nextBlock()
+	{
+		if(blockBytes != 0) {
+			auto block = msg;
+			msg += SHA256_BLOCKSIZE;
+			blockBytes -= SHA256_BLOCKSIZE;
+			return block;
+		}
+		if(tailIndex < tailBlocks) {
+			return &tail[SHA256_BLOCKSIZE * tailIndex++];
+		}
+		return nullptr;
+	}
+
+	void end()
+	{
+		Range<SHA256_SIZE / sizeof(state[0])>::encode(digest, state);
+	}
+};
+
 void sha2small_final(uint8_t* digest, crypto_sha256_context_t* ctx, bool isSha224)
 {
 	decltype(ctx->state) val;
@@ -50,17 +105,17 @@ void sha2small_final(uint8_t* digest, crypto_sha256_context_t* ctx, bool isSha22
 
 CRYPTO_FUNC_INIT(sha256)
 {
-	static const uint32_t sha256_IV[8] PROGMEM = {
-		0x6A09E667, 0xBB67AE85, 0x3C6EF372, 0xA54FF53A, 0x510E527F, 0x9B05688C, 0x1F83D9AB, 0x5BE0CD19,
-	};
-
 	memcpy(ctx->state, sha256_IV, SHA256_STATESIZE);
 	ctx->count = 0;
 }
 
 CRYPTO_FUNC_UPDATE(sha256)
 {
+#ifdef CRYPTO_HW_SHA
+	hashUpdate(ctx, sha2small_process, input, length, Hardware::sha256Process);
+#else
 	hashUpdate(ctx, sha2small_process, input, length);
+#endif
 }
 
 CRYPTO_FUNC_FINAL(sha256)
@@ -80,6 +135,56 @@ CRYPTO_FUNC_SET_STATE(sha256)
 	ctx->count = count;
 }
 
+CRYPTO_FUNC_MULTI(sha256)
+{
+	Lane lanes[2];
+	int next{0};
+
+	// Load a message into a lane, returns false if there are none left
+	auto load = [&](Lane& lane) {
+		if(next >= count) {
+			return false;
+		}
+		lane.begin(msg[next], msg_len[next], &digests[next * SHA256_SIZE]);
+		++next;
+		return true;
+	};
+
+	bool active0 = load(lanes[0]);
+	bool active1 = load(lanes[1]);
+	const uint8_t* block0 = active0 ? lanes[0].nextBlock() : nullptr;
+	const uint8_t* block1 = active1 ? lanes[1].nextBlock() : nullptr;
+
+	while(block0 != nullptr || block1 != nullptr) {
+		if(block0 != nullptr && block1 != nullptr) {
+			sha2::process2<64, Sigma, Sum>(lanes[0].state, block0, lanes[1].state, block1, K);
+		} else if(block0 != nullptr) {
+			sha2small_process(lanes[0].state, block0);
+		} else {
+			sha2small_process(lanes[1].state, block1);
+		}
+
+		if(block0 != nullptr) {
+			block0 = lanes[0].nextBlock();
+			if(block0 == nullptr) {
+				lanes[0].end();
+				if(load(lanes[0])) {
+					block0 = lanes[0].nextBlock();
+				}
+			}
+		}
+		if(block1 != nullptr) {
+			block1 = lanes[1].nextBlock();
+			if(block1 == nullptr) {
+				lanes[1].end();
+				if(load(lanes[1])) {
+					block1 = lanes[1].nextBlock();
+				}
+			}
+		}
+	}
+}
+
 /*
  * SHA224
  */
@@ -27,15 +27,26 @@ namespace Internal
  */
 template <typename State> using HashProcess = void(State state[], const uint8_t block[]);
 
+/**
+ * @brief Bulk block hash operation, e.g. using hardware acceleration
+ * @param state Intermediate digest state
+ * @param blocks Data, a whole number of blocks
+ * @param length Number of bytes of data
+ * @retval bool false if data could not be processed, state must be left unchanged
+ */
+template <typename State> using HashProcessBlocks = bool(State state[], const uint8_t* blocks, size_t length);
+
 /**
  * @brief Perform a hash update with some message data
  * @param ctx Hash function context containing state, count and buffer elements
  * @param process Called to process a complete block of data
  * @param input The input message
  * @param length Number of bytes in the message
+ * @param processBlocks Optional bulk processing function, falls back to `process` on failure
  */
 template <typename Context, typename T = decltype(Context::state[0])>
-void hashUpdate(Context* ctx, HashProcess<T> process, const void* input, size_t length)
+void hashUpdate(Context* ctx, HashProcess<T> process, const void* input, size_t length,
+				HashProcessBlocks<T>* processBlocks = nullptr)
 {
 	auto msg = static_cast<const uint8_t*>(input);
 	auto bufsize = sizeof(ctx->buffer);
@@ -54,6 +65,11 @@ void hashUpdate(Context* ctx, HashProcess<T> process, const void* input, size_t
 	}
 
 	// Process complete blocks directly from input, buffer not required
+	auto blockBytes = length - (length % bufsize);
+	if(blockBytes != 0 && processBlocks != nullptr && processBlocks(ctx->state, msg, blockBytes)) {
+		length -= blockBytes;
+		msg += blockBytes;
+	}
 	while(length >= bufsize) {
 		process(ctx->state, msg);
 		length -= bufsize;
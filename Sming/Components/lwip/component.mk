@@ -24,10 +24,26 @@ COMPONENT_VARS		+= ENABLE_LWIPDEBUG
 ENABLE_LWIPDEBUG	?= 0
 LWIP_LIBNAME		:= clwip
 
+# Buffer and pool sizes, see lwipopts.h
+COMPONENT_VARS		+= LWIP_PROFILE
+LWIP_PROFILE		?= balanced
+LWIP_PROFILES		:= small balanced throughput
+ifeq (,$(filter $(LWIP_PROFILE),$(LWIP_PROFILES)))
+$(error LWIP_PROFILE must be one of: $(LWIP_PROFILES))
+endif
+
+COMPONENT_VARS		+= ENABLE_LWIP_STATS
+ENABLE_LWIP_STATS	?= 0
+
+# Must be consistent for both library and application code
+LWIP_CONFIG_DEFINES := LWIP_PROFILE=LWIP_PROFILE_$(call ToUpper,$(LWIP_PROFILE));ENABLE_LWIP_STATS=$(ENABLE_LWIP_STATS)
+GLOBAL_CFLAGS		+= $(addprefix -D,$(subst ;, ,$(LWIP_CONFIG_DEFINES)))
+
 LWIP_CMAKE_OPTIONS		:= \
 	-G Ninja \
 	-DLWIP_LIBNAME=$(LWIP_LIBNAME) \
 	-DLWIP_DIR=$(COMPONENT_PATH)/lwip \
+	-DSMING_LWIP_DEFINITIONS="$(LWIP_CONFIG_DEFINES)" \
 	-DCMAKE_MAKE_PROGRAM="$(NINJA)"
 
 ifeq ($(ENABLE_LWIPDEBUG), 1)
@@ -45,6 +45,53 @@
 
 #include "lwip/debug.h"
 
+/*
+   ---------------------------------------
+   ---------- Sming build profile ----------
+   ---------------------------------------
+*/
+/**
+ * LWIP_PROFILE: Set via LWIP_PROFILE build variable to select buffer and pool sizes
+ */
+#define LWIP_PROFILE_SMALL              1
+#define LWIP_PROFILE_BALANCED           2
+#define LWIP_PROFILE_THROUGHPUT         3
+
+#ifndef LWIP_PROFILE
+#define LWIP_PROFILE                    LWIP_PROFILE_BALANCED
+#endif
+
+#if LWIP_PROFILE == LWIP_PROFILE_SMALL
+#define PROFILE_MEM_SIZE                6000
+#define PROFILE_MEMP_NUM_PBUF           8
+#define PROFILE_MEMP_NUM_TCP_SEG        8
+#define PROFILE_PBUF_POOL_SIZE          4
+#define PROFILE_TCP_MSS                 536
+#define PROFILE_TCP_WND                 (2 * TCP_MSS)
+#define PROFILE_TCP_SND_BUF             (2 * TCP_MSS)
+#define PROFILE_TCP_QUEUE_OOSEQ         0
+#elif LWIP_PROFILE == LWIP_PROFILE_BALANCED
+#define PROFILE_MEM_SIZE                16000
+#define PROFILE_MEMP_NUM_PBUF           16
+#define PROFILE_MEMP_NUM_TCP_SEG        16
+#define PROFILE_PBUF_POOL_SIZE          8
+#define PROFILE_TCP_MSS                 1390
+#define PROFILE_TCP_WND                 (4 * TCP_MSS)
+#define PROFILE_TCP_SND_BUF             (2 * TCP_MSS)
+#define PROFILE_TCP_QUEUE_OOSEQ         0
+#elif LWIP_PROFILE == LWIP_PROFILE_THROUGHPUT
+#define PROFILE_MEM_SIZE                32000
+#define PROFILE_MEMP_NUM_PBUF           32
+#define PROFILE_MEMP_NUM_TCP_SEG        32
+#define PROFILE_PBUF_POOL_SIZE          16
+#define PROFILE_TCP_MSS                 1460
+#define PROFILE_TCP_WND                 (8 * TCP_MSS)
+#define PROFILE_TCP_SND_BUF             (4 * TCP_MSS)
+#define PROFILE_TCP_QUEUE_OOSEQ         1
+#else
+#error "Unknown LWIP_PROFILE"
+#endif
+
 /*
    -----------------------------------------------
    ---------- Platform specific locking ----------
@@ -81,7 +128,7 @@
  * MEM_SIZE: the size of the heap memory. If the application will send
  * a lot of data that needs to be copied, this should be set high.
  */
-#define MEM_SIZE                        16000
+#define MEM_SIZE                        PROFILE_MEM_SIZE
 
 /*
    ------------------------------------------------
@@ -93,7 +140,7 @@
  * If the application sends a lot of data out of ROM (or other static memory),
  * this should be set high.
  */
-#define MEMP_NUM_PBUF                   16
+#define MEMP_NUM_PBUF                   PROFILE_MEMP_NUM_PBUF
 
 /**
  * MEMP_NUM_RAW_PCB: Number of raw connection PCBs
@@ -124,7 +171,7 @@
  * MEMP_NUM_TCP_SEG: the number of simultaneously queued TCP segments.
  * (requires the LWIP_TCP option)
  */
-#define MEMP_NUM_TCP_SEG                16
+#define MEMP_NUM_TCP_SEG                PROFILE_MEMP_NUM_TCP_SEG
 
 /**
  * MEMP_NUM_REASSDATA: the number of simultaneously IP packets queued for
@@ -176,7 +223,7 @@
 /**
  * PBUF_POOL_SIZE: the number of buffers in the pbuf pool.
  */
-#define PBUF_POOL_SIZE                  8
+#define PBUF_POOL_SIZE                  PROFILE_PBUF_POOL_SIZE
 
 /*
    ---------------------------------
@@ -346,9 +393,12 @@
  */
 #define LWIP_TCP                        1
 #define LWIP_LISTEN_BACKLOG             0
-#define TCP_QUEUE_OOSEQ                 0
+#define TCP_LISTEN_BACKLOG              1
+#define TCP_QUEUE_OOSEQ                 PROFILE_TCP_QUEUE_OOSEQ
 #define LWIP_TCP_KEEPALIVE              1
-#define TCP_MSS                         1390
+#define TCP_MSS                         PROFILE_TCP_MSS
+#define TCP_WND                         PROFILE_TCP_WND
+#define TCP_SND_BUF                     PROFILE_TCP_SND_BUF
 
 /*
    ----------------------------------
@@ -417,8 +467,28 @@
 */
 /**
  * LWIP_STATS==1: Enable statistics collection in lwip_stats.
- */
+ * Set via ENABLE_LWIP_STATS build variable. Only memory pool and heap statistics are collected.
+ */
+#if ENABLE_LWIP_STATS
+#define LWIP_STATS                      1
+#define MEM_STATS                       1
+#define MEMP_STATS                      1
+#define LINK_STATS                      0
+#define ETHARP_STATS                    0
+#define IP_STATS                        0
+#define IPFRAG_STATS                    0
+#define ICMP_STATS                      0
+#define IGMP_STATS                      0
+#define UDP_STATS                       0
+#define TCP_STATS                       0
+#define IP6_STATS                       0
+#define ICMP6_STATS                     0
+#define IP6_FRAG_STATS                  0
+#define MLD6_STATS                      0
+#define ND6_STATS                       0
+#else
 #define LWIP_STATS                      0
+#endif
 /*
    ---------------------------------
    ---------- PPP options ----------
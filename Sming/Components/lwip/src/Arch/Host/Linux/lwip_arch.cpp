@@ -17,6 +17,7 @@
  *
  ****/
 #include "../lwip_arch.h"
+#include "vswitch.h"
 #include <hostlib/hostmsg.h>
 #include <lwip/timeouts.h>
 #include <cstring>
@@ -33,6 +34,7 @@ extern "C" {
 namespace
 {
 struct netif net_if;
+bool usingVSwitch;
 
 void getMacAddress(const char* ifname, uint8_t hwaddr[6])
 {
@@ -102,6 +104,17 @@ bool getifaddr(struct lwip_net_config& netcfg)
 
 struct netif* lwip_arch_init(struct lwip_net_config& netcfg)
 {
+	if(VSwitch::isVSwitch(netcfg.ifname)) {
+		VSwitch::Config config;
+		if(!VSwitch::parseConfig(netcfg.ifname, config)) {
+			return nullptr;
+		}
+		lwip_init();
+		auto netif = VSwitch::init(config, netcfg);
+		usingVSwitch = (netif != nullptr);
+		return netif;
+	}
+
 	if(!getifaddr(netcfg)) {
 		if(netcfg.ifname[0] == '\0') {
 			host_debug_e("%s", "No compatible interface found");
@@ -127,6 +140,12 @@ struct netif* lwip_arch_init(struct lwip_net_config& netcfg)
 
 bool lwip_arch_service()
 {
+	if(usingVSwitch) {
+		bool res = VSwitch::service();
+		sys_check_timeouts();
+		return res;
+	}
+
 	/* poll netif, pass packet to lwIP */
 	int res = tapif_select(&net_if);
 	netif_poll(&net_if);
@@ -135,6 +154,21 @@ bool lwip_arch_service()
 	return res > 0;
 }
 
+int lwip_arch_get_fd()
+{
+	if(usingVSwitch) {
+		return VSwitch::getSocket();
+	}
+
+	// tapif keeps its descriptor as the first (only) member of its state structure
+	auto state = static_cast<const int*>(net_if.state);
+	return state ? *state : -1;
+}
+
 void lwip_arch_shutdown()
 {
+	if(usingVSwitch) {
+		VSwitch::shutdown();
+		usingVSwitch = false;
+	}
 }
@@ -0,0 +1,482 @@
+/**
+ * vswitch.cpp
+ *
+ * This file is part of the Sming Framework Project
+ *
+ * This library is free software: you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation, version 3 or later.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this library.
+ * If not, see <https://www.gnu.org/licenses/>.
+ *
+ ****/
+
+#include "vswitch.h"
+#include <hostlib/hostmsg.h>
+#include <esp_system.h>
+#include <netif/etharp.h>
+#include <lwip/pbuf.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <dirent.h>
+#include <unistd.h>
+#include <errno.h>
+#include <cstdlib>
+#include <cstdio>
+#include <deque>
+#include <random>
+#include <vector>
+
+namespace VSwitch
+{
+namespace
+{
+constexpr size_t maxFrameSize{1514};
+constexpr size_t maxQueuedFrames{256};
+constexpr unsigned maxReceivePerService{32};
+constexpr size_t macNameLength{12};
+
+struct Frame {
+	uint64_t due; ///< Delivery time in microseconds
+	std::vector<uint8_t> data;
+};
+
+struct netif net_if;
+Config config;
+char socketDir[108 - macNameLength - 2];
+char nodeName[macNameLength + 1];
+int sock{-1};
+std::deque<Frame> txQueue;
+uint64_t linkFree;	 ///< When last queued frame has finished transmitting
+uint64_t lastDue;	 ///< Delivery time of last queued frame, to preserve ordering
+unsigned lossCount;	 ///< Frames dropped by link model
+unsigned queueDrops; ///< Frames dropped because queue was full
+std::mt19937 rng(getpid());
+
+uint64_t now()
+{
+	return os_get_nanoseconds() / 1000U;
+}
+
+void getMacName(const uint8_t* mac, char* name)
+{
+	for(unsigned i = 0; i < 6; ++i) {
+		sprintf(&name[i * 2], "%02x", mac[i]);
+	}
+}
+
+/*
+ * Locally administered unicast address derived from IP address, so unique within fabric
+ */
+void getMacAddress(const ip4_addr_t& ip, uint8_t* mac)
+{
+	mac[0] = 0x02;
+	mac[1] = 0x00;
+	memcpy(&mac[2], &ip.addr, 4);
+}
+
+bool makePath(sockaddr_un& addr, const char* name)
+{
+	addr = sockaddr_un{};
+	addr.sun_family = AF_UNIX;
+	int len = snprintf(addr.sun_path, sizeof(addr.sun_path), "%s/%s", socketDir, name);
+	return len > 0 && size_t(len) < sizeof(addr.sun_path);
+}
+
+bool createDirectory()
+{
+	auto tmp = getenv("TMPDIR");
+	int len = snprintf(socketDir, sizeof(socketDir), "%s/sming-vswitch", tmp ?: "/tmp");
+	if(len <= 0 || size_t(len) >= sizeof(socketDir)) {
+		return false;
+	}
+	mkdir(socketDir, 0777);
+	len = snprintf(socketDir, sizeof(socketDir), "%s/sming-vswitch/%s", tmp ?: "/tmp", config.name);
+	if(len <= 0 || size_t(len) >= sizeof(socketDir)) {
+		return false;
+	}
+	if(mkdir(socketDir, 0777) < 0 && errno != EEXIST) {
+		host_debug_e("vswitch: Failed to create '%s': %s", socketDir, strerror(errno));
+		return false;
+	}
+	return true;
+}
+
+/*
+ * Socket files are left behind by instances which don't exit cleanly
+ */
+bool isStale(const sockaddr_un& addr)
+{
+	int fd = socket(AF_UNIX, SOCK_DGRAM, 0);
+	if(fd < 0) {
+		return false;
+	}
+	bool stale = connect(fd, reinterpret_cast<const sockaddr*>(&addr), sizeof(addr)) < 0 && errno == ECONNREFUSED;
+	close(fd);
+	return stale;
+}
+
+/*
+ * Claim a node name
+ * @retval int 1 on success, 0 if name is in use, -1 on error
+ */
+int bindNode(const char* name)
+{
+	sockaddr_un addr;
+	if(!makePath(addr, name)) {
+		return -1;
+	}
+
+	for(unsigned attempt = 0; attempt < 2; ++attempt) {
+		if(bind(sock, reinterpret_cast<const sockaddr*>(&addr), sizeof(addr)) == 0) {
+			strcpy(nodeName, name);
+			return 1;
+		}
+		if(errno != EADDRINUSE) {
+			host_debug_e("vswitch: bind '%s' failed: %s", addr.sun_path, strerror(errno));
+			return -1;
+		}
+		if(!isStale(addr)) {
+			return 0;
+		}
+		unlink(addr.sun_path);
+	}
+
+	return 0;
+}
+
+bool bindAddress(const ip4_addr_t& ip)
+{
+	uint8_t mac[6];
+	getMacAddress(ip, mac);
+	char name[macNameLength + 1];
+	getMacName(mac, name);
+	return bindNode(name) > 0;
+}
+
+/*
+ * Find first free address in network
+ */
+bool allocateAddress(struct lwip_net_config& netcfg)
+{
+	uint32_t mask = lwip_ntohl(netcfg.netmask.addr);
+	uint32_t network = lwip_ntohl(netcfg.gw.addr) & mask;
+	uint32_t hostCount = ~mask;
+	uint32_t gw = lwip_ntohl(netcfg.gw.addr);
+
+	// Start at .10, consistent with TAP interface default
+	for(uint32_t host = 10; host < hostCount; ++host) {
+		if((network | host) == gw) {
+			continue;
+		}
+		ip4_addr_t ip;
+		ip.addr = lwip_htonl(network | host);
+		if(bindAddress(ip)) {
+			netcfg.ipaddr = ip;
+			return true;
+		}
+	}
+
+	host_debug_e("vswitch: No free addresses in network");
+	return false;
+}
+
+enum class SendResult {
+	sent,
+	absent, ///< No such node
+	busy,	///< Receive queue full
+};
+
+SendResult sendToNode(const char* name, const void* data, size_t length)
+{
+	sockaddr_un addr;
+	if(!makePath(addr, name)) {
+		return SendResult::absent;
+	}
+	if(sendto(sock, data, length, 0, reinterpret_cast<const sockaddr*>(&addr), sizeof(addr)) >= 0) {
+		return SendResult::sent;
+	}
+	switch(errno) {
+	case ECONNREFUSED:
+		unlink(addr.sun_path);
+		return SendResult::absent;
+	case ENOENT:
+		return SendResult::absent;
+	case EAGAIN:
+		return SendResult::busy;
+	default:
+		host_debug_w("vswitch: send failed: %s", strerror(errno));
+		return SendResult::sent;
+	}
+}
+
+/*
+ * Broadcast frames are not retried if a receiver is busy, as that would duplicate delivery to the others
+ */
+void flood(const void* data, size_t length)
+{
+	auto dir = opendir(socketDir);
+	if(dir == nullptr) {
+		return;
+	}
+	while(auto entry = readdir(dir)) {
+		if(entry->d_name[0] == '.' || strcmp(entry->d_name, nodeName) == 0) {
+			continue;
+		}
+		sendToNode(entry->d_name, data, length);
+	}
+	closedir(dir);
+}
+
+/*
+ * @retval bool false if receiver is busy and frame should be retried
+ */
+bool transmit(const uint8_t* data, size_t length)
+{
+	auto dst = data;
+	bool isGroup = dst[0] & 0x01;
+	if(!isGroup) {
+		char name[macNameLength + 1];
+		getMacName(dst, name);
+		switch(sendToNode(name, data, length)) {
+		case SendResult::sent:
+			return true;
+		case SendResult::busy:
+			return false;
+		case SendResult::absent:
+			break;
+		}
+	}
+	flood(data, length);
+	return true;
+}
+
+bool flushQueue()
+{
+	auto time = now();
+	while(!txQueue.empty() && txQueue.front().due <= time) {
+		auto& frame = txQueue.front();
+		if(!transmit(frame.data.data(), frame.data.size())) {
+			break;
+		}
+		txQueue.pop_front();
+	}
+	return !txQueue.empty();
+}
+
+void enqueue(uint64_t due, const uint8_t* data, size_t length)
+{
+	if(txQueue.size() >= maxQueuedFrames) {
+		++queueDrops;
+		return;
+	}
+	txQueue.push_back(Frame{due, std::vector<uint8_t>(data, data + length)});
+}
+
+err_t linkOutput(struct netif*, struct pbuf* p)
+{
+	if(p->tot_len > maxFrameSize) {
+		return ERR_IF;
+	}
+
+	if(config.loss > 0 && std::uniform_real_distribution<float>(0, 100)(rng) < config.loss) {
+		++lossCount;
+		return ERR_OK;
+	}
+
+	uint8_t buffer[maxFrameSize];
+	auto length = pbuf_copy_partial(p, buffer, p->tot_len, 0);
+
+	auto time = now();
+	if(config.latency == 0 && config.jitter == 0 && config.bandwidth == 0) {
+		// Preserve order if earlier frames are waiting for a busy receiver
+		if(!txQueue.empty() || !transmit(buffer, length)) {
+			enqueue(time, buffer, length);
+		}
+		return ERR_OK;
+	}
+
+	if(txQueue.size() >= maxQueuedFrames) {
+		++queueDrops;
+		return ERR_OK;
+	}
+
+	uint64_t departure = std::max(time, linkFree);
+	if(config.bandwidth != 0) {
+		departure += uint64_t(length) * 8000U / config.bandwidth;
+	}
+	linkFree = departure;
+	uint64_t due = departure + config.latency * 1000ULL;
+	if(config.jitter != 0) {
+		due += std::uniform_int_distribution<unsigned>(0, config.jitter * 1000U)(rng);
+	}
+	due = std::max(due, lastDue);
+	lastDue = due;
+
+	enqueue(due, buffer, length);
+	flushQueue();
+	return ERR_OK;
+}
+
+err_t netifInit(struct netif* netif)
+{
+	netif->name[0] = 'v';
+	netif->name[1] = 's';
+	netif->output = etharp_output;
+	netif->linkoutput = linkOutput;
+	netif->mtu = 1500;
+	netif->hwaddr_len = ETH_HWADDR_LEN;
+	getMacAddress(*netif_ip4_addr(netif), netif->hwaddr);
+	netif->flags = NETIF_FLAG_BROADCAST | NETIF_FLAG_ETHARP | NETIF_FLAG_IGMP | NETIF_FLAG_LINK_UP;
+	return ERR_OK;
+}
+
+bool receive()
+{
+	bool active{false};
+	for(unsigned i = 0; i < maxReceivePerService; ++i) {
+		uint8_t buffer[maxFrameSize];
+		auto len = recv(sock, buffer, sizeof(buffer), 0);
+		if(len <= 0) {
+			break;
+		}
+		active = true;
+		auto p = pbuf_alloc(PBUF_RAW, len, PBUF_POOL);
+		if(p == nullptr) {
+			continue;
+		}
+		pbuf_take(p, buffer, len);
+		if(net_if.input(p, &net_if) != ERR_OK) {
+			pbuf_free(p);
+		}
+	}
+	return active;
+}
+
+} // namespace
+
+bool parseConfig(const char* ifname, Config& cfg)
+{
+	if(!isVSwitch(ifname)) {
+		return false;
+	}
+
+	cfg = Config{};
+	auto spec = ifname + strlen(prefix);
+	auto sep = strchr(spec, ',');
+	size_t len = sep ? size_t(sep - spec) : strlen(spec);
+	if(len == 0 || len >= sizeof(cfg.name) || memchr(spec, '/', len) != nullptr) {
+		host_debug_e("vswitch: Invalid fabric name");
+		return false;
+	}
+	memcpy(cfg.name, spec, len);
+
+	while(sep != nullptr) {
+		auto param = sep + 1;
+		sep = strchr(param, ',');
+		auto eq = strchr(param, '=');
+		if(eq == nullptr || (sep != nullptr && eq > sep)) {
+			host_debug_e("vswitch: Expected name=value");
+			return false;
+		}
+		auto nameLen = eq - param;
+		auto value = eq + 1;
+		auto matches = [&](const char* s) { return strlen(s) == size_t(nameLen) && memcmp(param, s, nameLen) == 0; };
+		if(matches("latency")) {
+			cfg.latency = strtoul(value, nullptr, 0);
+		} else if(matches("jitter")) {
+			cfg.jitter = strtoul(value, nullptr, 0);
+		} else if(matches("bandwidth")) {
+			cfg.bandwidth = strtoul(value, nullptr, 0);
+		} else if(matches("loss")) {
+			cfg.loss = strtof(value, nullptr);
+		} else {
+			host_debug_e("vswitch: Unknown parameter '%.*s'", int(nameLen), param);
+			return false;
+		}
+	}
+
+	return true;
+}
+
+struct netif* init(const Config& cfg, struct lwip_net_config& netcfg)
+{
+	config = cfg;
+	if(!createDirectory()) {
+		return nullptr;
+	}
+
+	sock = socket(AF_UNIX, SOCK_DGRAM | SOCK_NONBLOCK, 0);
+	if(sock < 0) {
+		host_debug_e("vswitch: socket() failed: %s", strerror(errno));
+		return nullptr;
+	}
+
+	if(ip_addr_isany(&netcfg.netmask)) {
+		IP4_ADDR(&netcfg.netmask, 255, 255, 255, 0);
+	}
+	if(ip_addr_isany(&netcfg.gw)) {
+		IP4_ADDR(&netcfg.gw, 192, 168, 13, 1);
+	}
+
+	bool ok;
+	if(ip_addr_isany(&netcfg.ipaddr)) {
+		ok = allocateAddress(netcfg);
+	} else {
+		ok = bindAddress(netcfg.ipaddr);
+		if(!ok) {
+			host_debug_e("vswitch: Address already in use");
+		}
+	}
+	if(!ok) {
+		shutdown();
+		return nullptr;
+	}
+
+	host_debug_i("vswitch: Joined '%s' as %s, latency %u+%u ms, bandwidth %u kbit/s, loss %.1f%%", config.name,
+				 nodeName, config.latency, config.jitter, config.bandwidth, config.loss);
+
+	netif_add(&net_if, &netcfg.ipaddr, &netcfg.netmask, &netcfg.gw, nullptr, netifInit, ethernet_input);
+	return &net_if;
+}
+
+bool service()
+{
+	if(sock < 0) {
+		return false;
+	}
+	bool active = receive();
+	return flushQueue() || active;
+}
+
+int getSocket()
+{
+	return sock;
+}
+
+void shutdown()
+{
+	if(sock < 0) {
+		return;
+	}
+	close(sock);
+	sock = -1;
+	if(nodeName[0] != '\0') {
+		sockaddr_un addr;
+		if(makePath(addr, nodeName)) {
+			unlink(addr.sun_path);
+		}
+		nodeName[0] = '\0';
+	}
+	txQueue.clear();
+	if(lossCount != 0 || queueDrops != 0) {
+		host_debug_i("vswitch: %u frames lost, %u dropped with queue full", lossCount, queueDrops);
+	}
+}
+
+} // namespace VSwitch
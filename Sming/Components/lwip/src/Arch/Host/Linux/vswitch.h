@@ -0,0 +1,79 @@
+/**
+ * vswitch.h - Userspace ethernet fabric connecting emulator instances
+ *
+ * This file is part of the Sming Framework Project
+ *
+ * This library is free software: you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation, version 3 or later.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this library.
+ * If not, see <https://www.gnu.org/licenses/>.
+ *
+ ****/
+
+#pragma once
+
+#include "../lwip_arch.h"
+#include <lwip/netif.h>
+#include <cstring>
+
+/*
+ * Each instance joining a fabric binds a UNIX datagram socket in a common directory,
+ * named after its MAC address. Frames for a known MAC are sent directly to that socket,
+ * anything else (broadcast, multicast or unknown) is sent to all of them.
+ * There is no central process so instances may come and go freely.
+ *
+ * The link model is applied on transmit: each frame may be dropped, then is queued
+ * for delivery after the serialisation time at the configured bandwidth plus latency and jitter.
+ */
+namespace VSwitch
+{
+constexpr const char* prefix{"vswitch:"};
+
+struct Config {
+	char name[64];		///< Fabric name
+	unsigned latency;	///< Milliseconds
+	unsigned jitter;	///< Maximum additional random delay in milliseconds
+	unsigned bandwidth; ///< kbit/s, 0 for unlimited
+	float loss;			///< Percentage of frames dropped
+};
+
+/**
+ * @brief Determine if interface name refers to a virtual switch
+ */
+inline bool isVSwitch(const char* ifname)
+{
+	return strncmp(ifname, prefix, strlen(prefix)) == 0;
+}
+
+/**
+ * @brief Parse interface specification
+ * @param ifname e.g. "vswitch:mesh,latency=20,jitter=5,loss=0.5,bandwidth=250"
+ */
+bool parseConfig(const char* ifname, Config& config);
+
+/**
+ * @brief Join fabric and add lwIP network interface
+ * @param netcfg If no IP address is given, the first one in the network not already in use is taken
+ */
+struct netif* init(const Config& config, struct lwip_net_config& netcfg);
+
+/**
+ * @brief Deliver received frames to lwIP and send any queued frames which are due
+ * @retval bool true if any frames were processed, or are waiting
+ */
+bool service();
+
+void shutdown();
+
+/**
+ * @brief Get socket descriptor, readable when frames are waiting
+ * @retval int -1 if not initialised
+ */
+int getSocket();
+
+} // namespace VSwitch
@@ -198,6 +198,12 @@ bool lwip_arch_service()
 	return true;
 }
 
+int lwip_arch_get_fd()
+{
+	// pcap handles can't be waited on with sockets
+	return -1;
+}
+
 void lwip_arch_shutdown()
 {
 	/* release the pcap library... */
@@ -20,6 +20,8 @@
 #include "lwip_arch.h"
 #include "lwip/netif.h"
 #include <SimpleTimer.h>
+#include <hostlib/poller.h>
+#include <esp_tasks.h>
 
 namespace
 {
@@ -30,6 +32,52 @@ host_lwip_init_callback_t init_callback;
 constexpr unsigned activeInterval{2};
 constexpr unsigned inactiveInterval{100};
 
+void service()
+{
+	bool active = lwip_arch_service();
+	lwipServiceTimer.setIntervalMs(active ? activeInterval : inactiveInterval);
+	lwipServiceTimer.startOnce();
+}
+
+/*
+ * Wakes the main loop as soon as frames arrive, rather than waiting for the service timer.
+ * The descriptor is disabled until the stack has been serviced.
+ */
+class NetworkPollHandler : public CPollHandler
+{
+public:
+	bool begin(int fd)
+	{
+		descriptor = fd;
+		return host_poller().add(fd, POLL_EVENT_READ, this);
+	}
+
+	void end()
+	{
+		if(descriptor >= 0) {
+			host_poller().remove(descriptor);
+			descriptor = -1;
+		}
+	}
+
+	void onPoll(CPoller& poller, int fd, unsigned) override
+	{
+		poller.modify(fd, 0);
+		host_queue_callback(
+			[](uint32_t param) {
+				service();
+				host_poller().modify(int(param), POLL_EVENT_READ);
+			},
+			fd);
+		host_thread_kick();
+	}
+
+private:
+	int descriptor{-1};
+};
+
+NetworkPollHandler pollHandler;
+
 } // namespace
 
 bool host_lwip_init(const struct lwip_param& param)
@@ -80,19 +128,21 @@ bool host_lwip_init(const struct lwip_param& param)
 		init_callback();
 	}
 
-	lwipServiceTimer.initializeMs(activeInterval, []() {
-		bool active = lwip_arch_service();
-		lwipServiceTimer.setIntervalMs(active ? activeInterval : inactiveInterval);
-		lwipServiceTimer.startOnce();
-	});
+	lwipServiceTimer.initializeMs(activeInterval, service);
 	lwipServiceTimer.startOnce();
 
+	int fd = lwip_arch_get_fd();
+	if(fd >= 0) {
+		pollHandler.begin(fd);
+	}
+
 	return true;
 }
 
 void host_lwip_shutdown()
 {
 	lwipServiceTimer.stop();
+	pollHandler.end();
 	lwip_arch_shutdown();
 }
 
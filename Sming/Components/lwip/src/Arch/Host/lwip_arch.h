@@ -45,6 +45,12 @@ void lwip_arch_shutdown();
  */
 bool lwip_arch_service();
 
+/*
+ * Get descriptor which becomes readable when frames arrive, so the stack can be serviced promptly.
+ * Return -1 if not supported.
+ */
+int lwip_arch_get_fd();
+
 #ifdef __cplusplus
 }
 #endif
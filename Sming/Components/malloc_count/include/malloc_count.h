@@ -31,6 +31,9 @@
 #include <stdlib.h>
 #include <stdbool.h>
 #include <functional>
+#include <cstdint>
+
+class Print;
 
 namespace MallocCount
 {
@@ -93,4 +96,181 @@ void enableLogging(bool enable);
  */
 void setLogThreshold(size_t threshold);
 
+/**
+ * @name Allocation-site profiling
+ * @{
+ */
+
+/**
+ * @brief Maximum number of distinct allocation sites tracked
+ *
+ * Allocations from further sites are accumulated in a final 'other' entry.
+ */
+constexpr unsigned maxSites{32};
+
+/**
+ * @brief Number of allocation size histogram buckets
+ *
+ * Bucket 0 contains allocations up to 16 bytes, bucket 1 up to 32 bytes, etc.
+ * The final bucket contains all larger allocations.
+ */
+constexpr unsigned histogramBuckets{12};
+
+/**
+ * @brief Statistics for a single allocation site
+ *
+ * A site is identified by a tag if one is active, otherwise by the caller's address.
+ */
+struct Site {
+	const void* caller; ///< Return address of allocating function, nullptr for tagged site
+	const char* tag;	///< Tag name, or nullptr
+	size_t current;		///< Bytes currently allocated
+	size_t peak;		///< Highest value of current
+	size_t total;		///< Cumulative bytes allocated
+	unsigned count;		///< Number of allocations
+	unsigned live;		///< Number of allocations not yet freed
+};
+
+/**
+ * @brief Size histogram bucket
+ */
+struct Bucket {
+	unsigned count; ///< Number of allocations
+	unsigned live;	///< Number of allocations not yet freed
+};
+
+/**
+ * @brief Heap state at a point in time
+ */
+struct Sample {
+	uint32_t time;			///< System time in milliseconds
+	size_t current;			///< Bytes allocated
+	size_t freeHeap;		///< Free heap size
+	size_t largest;			///< Largest block which can be allocated
+	unsigned fragmentation; ///< Fragmentation percentage
+};
+
+/**
+ * @brief Number of samples retained
+ */
+constexpr unsigned maxSamples{32};
+
+/**
+ * @brief Enable/disable allocation site tracking
+ *
+ * Site tracking is disabled by default as it adds a small overhead to each allocation.
+ * Allocations made whilst tracking is disabled are not attributed to any site.
+ */
+void enableSiteTracking(bool enable);
+
+/**
+ * @brief Tag subsequent allocations
+ * @param tag Name for allocation site, or nullptr to use caller address. Must be a static string.
+ * @retval const char* The previous tag
+ * @see TagScope
+ */
+const char* setTag(const char* tag);
+
+/**
+ * @brief Get the active tag
+ */
+const char* getTag();
+
+/**
+ * @brief Tag allocations made within a scope
+ *
+ * For example:
+ *
+ *      void HttpServer::handleRequest()
+ *      {
+ *          MallocCount::TagScope tag("http");
+ *          ...
+ *      }
+ *
+ * @note Tagged allocations get one site regardless of where they are made,
+ * so tagging a whole subsystem is a good way to find where allocations come from.
+ */
+class TagScope
+{
+public:
+	TagScope(const char* tag) : prevTag(setTag(tag))
+	{
+	}
+
+	~TagScope()
+	{
+		setTag(prevTag);
+	}
+
+private:
+	const char* prevTag;
+};
+
+/**
+ * @brief Get number of sites in use
+ */
+unsigned getSiteCount();
+
+/**
+ * @brief Get allocation site information
+ * @param index Site index, from 0 to getSiteCount() - 1
+ * @retval const Site* nullptr if index is out of range
+ */
+const Site* getSite(unsigned index);
+
+/**
+ * @brief Reset cumulative site, histogram and peak counters
+ *
+ * Sites and current allocations are retained.
+ */
+void resetSites();
+
+/**
+ * @brief Get size histogram bucket
+ * @param index Bucket index, from 0 to histogramBuckets - 1
+ */
+const Bucket& getBucket(unsigned index);
+
+/**
+ * @brief Get the largest block which can currently be allocated
+ * @note This may be measured by probing the heap so should not be called too often
+ */
+size_t getLargestFreeBlock();
+
+/**
+ * @brief Get heap fragmentation percentage
+ *
+ * A value of 0 means all free heap is available as a single block.
+ * Values approaching 100 mean free memory is scattered in small blocks.
+ */
+unsigned getFragmentation();
+
+/**
+ * @brief Measure heap state and record it in the sample history
+ *
+ * Call periodically, for example using a timer, to observe how fragmentation develops.
+ */
+const Sample& sample();
+
+/**
+ * @brief Get number of samples in history
+ */
+unsigned getSampleCount();
+
+/**
+ * @brief Get a sample from history
+ * @param index Sample index, 0 is the oldest
+ * @retval const Sample* nullptr if index is out of range
+ */
+const Sample* getSample(unsigned index);
+
+/**
+ * @brief Print heap statistics, size histogram, sites and sample history
+ * @param p Output, e.g. `Serial` or a MemoryDataStream to send as an HTTP response
+ * @retval size_t Number of characters written
+ */
+size_t printReport(Print& p);
+
+/** @} */
+
 }; // namespace MallocCount
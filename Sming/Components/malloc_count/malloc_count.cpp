@@ -40,6 +40,14 @@
 #include "include/malloc_count.h"
 #include <debug_progmem.h>
 #include <esp_attr.h>
+#include <esp_systemapi.h>
+#include <Print.h>
+#ifdef ARCH_ESP32
+#include <esp_heap_caps.h>
+#endif
+#ifdef ENABLE_HEAP_REGIONS
+#include <heap_region.h>
+#endif
 
 // Names for the actual implementations
 #ifdef ARCH_ESP8266
@@ -82,6 +90,14 @@ constexpr size_t alignment{16}; /* bytes (>= 2*sizeof(size_t)) */
 /* a sentinel value prefixed to each allocation */
 constexpr size_t sentinel{0xDEADC0DE};
 
+/* bookkeeping data at start of each allocation, sentinel occupies the end */
+struct Header {
+	uint32_t size;
+	uint16_t site; // Index + 1 into site table, 0 if not tracked
+};
+
+static_assert(sizeof(Header) + sizeof(size_t) <= alignment, "Allocation header too large");
+
 /* Macro to get pointer to sentinel */
 #define GET_SENTINEL(ptr) (size_t*)((char*)ptr - sizeof(size_t))
 
@@ -110,10 +126,79 @@ size_t allocationLimit{0};
 
 MallocCount::Callback userCallback;
 
+/*******************************/
+/* allocation-site attribution */
+/*******************************/
+
+using MallocCount::Bucket;
+using MallocCount::histogramBuckets;
+using MallocCount::maxSamples;
+using MallocCount::maxSites;
+using MallocCount::Sample;
+using MallocCount::Site;
+
+bool siteTracking{false};
+const char* currentTag;
+Site sites[maxSites];
+unsigned siteCount;
+Bucket histogram[histogramBuckets];
+Sample samples[maxSamples];
+unsigned sampleHead; // Index of oldest sample
+unsigned sampleCount;
+
 #ifdef ENABLE_MALLOC_COUNT
 
+unsigned getBucketIndex(size_t size)
+{
+	unsigned i{0};
+	for(size_t limit = 16; size > limit && i < histogramBuckets - 1; limit <<= 1) {
+		++i;
+	}
+	return i;
+}
+
+bool tagsMatch(const char* tag1, const char* tag2)
+{
+	if(tag1 == tag2) {
+		return true;
+	}
+	return tag1 != nullptr && tag2 != nullptr && strcmp(tag1, tag2) == 0;
+}
+
+/* get site index + 1 for an allocation, creating a new entry if required */
+uint16_t findSite(const void* caller)
+{
+	if(!siteTracking) {
+		return 0;
+	}
+
+	auto tag = currentTag;
+	if(tag != nullptr) {
+		caller = nullptr;
+	}
+	for(unsigned i = 0; i < siteCount; ++i) {
+		if(sites[i].caller == caller && tagsMatch(sites[i].tag, tag)) {
+			return i + 1;
+		}
+	}
+
+	// Last entry is reserved for untracked sites
+	unsigned i = std::min(siteCount, maxSites - 1);
+	if(i == siteCount) {
+		sites[i] = Site{};
+		if(i == maxSites - 1) {
+			sites[i].tag = "other";
+		} else {
+			sites[i].caller = caller;
+			sites[i].tag = tag;
+		}
+		++siteCount;
+	}
+	return i + 1;
+}
+
 /* add allocation to statistics */
-void inc_count(size_t inc)
+void inc_count(size_t inc, uint16_t site)
 {
 	stats.current += inc;
 	stats.total += inc;
@@ -122,20 +207,100 @@ void inc_count(size_t inc)
 	}
 	++stats.count;
 
+	auto& bucket = histogram[getBucketIndex(inc)];
+	++bucket.count;
+	++bucket.live;
+
+	if(site != 0 && site <= siteCount) {
+		auto& s = sites[site - 1];
+		s.current += inc;
+		s.total += inc;
+		if(s.current > s.peak) {
+			s.peak = s.current;
+		}
+		++s.count;
+		++s.live;
+	}
+
 	if(userCallback) {
 		userCallback(stats.current);
 	}
 }
 
 /* decrement allocation to statistics */
-void dec_count(size_t dec)
+void dec_count(size_t dec, uint16_t site)
 {
 	stats.current -= dec;
+
+	auto& bucket = histogram[getBucketIndex(dec)];
+	if(bucket.live != 0) {
+		--bucket.live;
+	}
+
+	if(site != 0 && site <= siteCount) {
+		auto& s = sites[site - 1];
+		s.current -= std::min(s.current, dec);
+		if(s.live != 0) {
+			--s.live;
+		}
+	}
+
 	if(userCallback) {
 		userCallback(stats.current);
 	}
 }
 
+void* allocate(size_t size, const void* caller)
+{
+	if(size == 0) {
+		return nullptr;
+	}
+
+	if(allocationLimit != 0 && stats.current + size > allocationLimit) {
+		log("malloc(%u) -> exceeds maximum (current is %u bytes)", size, stats.current);
+		return nullptr;
+	}
+
+	/* call read malloc procedure in libc */
+	void* ret = REAL(F_MALLOC)(alignment + size);
+
+	if(ret == nullptr) {
+		log("malloc(%u) failed", size);
+		return ret;
+	}
+
+	/* prepend allocation size and check sentinel */
+	auto hdr = static_cast<Header*>(ret);
+	hdr->size = size;
+	hdr->site = findSite(caller);
+	ret = (char*)ret + alignment;
+	*GET_SENTINEL(ret) = sentinel;
+
+	inc_count(size, hdr->site);
+	if(size >= logThreshold) {
+		log("malloc(%u) = %p (cur %u)", size, ret, stats.current);
+	}
+
+	return ret;
+}
+
+void* zallocate(size_t size, const void* caller)
+{
+	auto ptr = allocate(size, caller);
+	if(ptr != nullptr) {
+		memset(ptr, 0, size);
+	}
+	return ptr;
+}
+
+#define RAW_MALLOC REAL(F_MALLOC)
+#define RAW_FREE REAL(F_FREE)
+
+#else
+
+#define RAW_MALLOC malloc
+#define RAW_FREE free
+
 #endif // ENABLE_MALLOC_COUNT
 
 } // namespace
@@ -198,51 +363,201 @@ void setCallback(Callback callback)
 	userCallback = callback;
 }
 
-#ifdef ENABLE_MALLOC_COUNT
+void enableSiteTracking(bool enable)
+{
+	siteTracking = enable;
+}
 
-/****************************************************/
-/* malloc_count function implementations             */
-/****************************************************/
+const char* setTag(const char* tag)
+{
+	auto prev = currentTag;
+	currentTag = tag;
+	return prev;
+}
 
-extern "C" void* mc_malloc(size_t size)
+const char* getTag()
 {
-	if(size == 0) {
-		return nullptr;
+	return currentTag;
+}
+
+unsigned getSiteCount()
+{
+	return siteCount;
+}
+
+const Site* getSite(unsigned index)
+{
+	return (index < siteCount) ? &sites[index] : nullptr;
+}
+
+void resetSites()
+{
+	for(unsigned i = 0; i < siteCount; ++i) {
+		auto& s = sites[i];
+		s.peak = s.current;
+		s.total = 0;
+		s.count = 0;
 	}
+	for(auto& bucket : histogram) {
+		bucket.count = 0;
+	}
+}
 
-	if(allocationLimit != 0 && stats.current + size > allocationLimit) {
-		log("malloc(%u) -> exceeds maximum (current is %u bytes)", size, stats.current);
-		return nullptr;
+const Bucket& getBucket(unsigned index)
+{
+	return histogram[std::min(index, histogramBuckets - 1)];
+}
+
+size_t getLargestFreeBlock()
+{
+#ifdef ARCH_ESP32
+	return heap_caps_get_largest_free_block(MALLOC_CAP_8BIT);
+#else
+	// Binary search for largest allocation which succeeds, bypassing counters
+	size_t freeHeap = system_get_free_heap_size();
+	size_t step{8};
+	while(step * 2 <= freeHeap) {
+		step <<= 1;
 	}
+#ifdef ARCH_ESP8266
+	// SDK reports failed allocations
+	auto osPrint = system_get_os_print();
+	system_set_os_print(false);
+#endif
+	size_t largest{0};
+	auto ptr = RAW_MALLOC(freeHeap);
+	if(ptr != nullptr) {
+		RAW_FREE(ptr);
+		largest = freeHeap;
+		step = 0;
+	}
+	for(; step >= 8; step >>= 1) {
+		auto size = largest + step;
+		if(size > freeHeap) {
+			continue;
+		}
+		ptr = RAW_MALLOC(size);
+		if(ptr != nullptr) {
+			RAW_FREE(ptr);
+			largest = size;
+		}
+	}
+#ifdef ARCH_ESP8266
+	system_set_os_print(osPrint);
+#endif
+	return largest;
+#endif
+}
 
-	/* call read malloc procedure in libc */
-	void* ret = REAL(F_MALLOC)(alignment + size);
+unsigned getFragmentation()
+{
+	size_t freeHeap = system_get_free_heap_size();
+	if(freeHeap == 0) {
+		return 0;
+	}
+	size_t largest = std::min(getLargestFreeBlock(), freeHeap);
+	return 100 - (largest * 100 / freeHeap);
+}
 
-	if(ret == nullptr) {
-		log("malloc(%u) failed", size);
-		return ret;
+const Sample& sample()
+{
+	unsigned i = (sampleHead + sampleCount) % maxSamples;
+	if(sampleCount < maxSamples) {
+		++sampleCount;
+	} else {
+		sampleHead = (sampleHead + 1) % maxSamples;
 	}
 
-	/* prepend allocation size and check sentinel */
-	*(size_t*)ret = size;
-	ret = (char*)ret + alignment;
-	*GET_SENTINEL(ret) = sentinel;
+	auto& s = samples[i];
+	s.time = system_get_time() / 1000;
+	s.current = stats.current;
+	s.freeHeap = system_get_free_heap_size();
+	s.largest = std::min(getLargestFreeBlock(), s.freeHeap);
+	s.fragmentation = (s.freeHeap == 0) ? 0 : 100 - (s.largest * 100 / s.freeHeap);
+	return s;
+}
 
-	inc_count(size);
-	if(size >= logThreshold) {
-		log("malloc(%u) = %p (cur %u)", size, ret, stats.current);
+unsigned getSampleCount()
+{
+	return sampleCount;
+}
+
+const Sample* getSample(unsigned index)
+{
+	return (index < sampleCount) ? &samples[(sampleHead + index) % maxSamples] : nullptr;
+}
+
+size_t printReport(Print& p)
+{
+	size_t n{0};
+	n += p.printf(_F("Heap: current %u, peak %u, total %u, allocations %u, free %u\r\n"), stats.current, stats.peak,
+				  stats.total, stats.count, system_get_free_heap_size());
+
+	n += p.println(_F("Size histogram (size: count, live):"));
+	for(unsigned i = 0; i < histogramBuckets; ++i) {
+		auto& bucket = histogram[i];
+		if(bucket.count == 0 && bucket.live == 0) {
+			continue;
+		}
+		if(i == histogramBuckets - 1) {
+			n += p.printf(_F("  >%u: %u, %u\r\n"), 8U << i, bucket.count, bucket.live);
+		} else {
+			n += p.printf(_F("  <=%u: %u, %u\r\n"), 16U << i, bucket.count, bucket.live);
+		}
 	}
 
-	return ret;
+	if(siteCount != 0) {
+		n += p.println(_F("Sites (site: current, peak, total, count, live):"));
+		for(unsigned i = 0; i < siteCount; ++i) {
+			auto& s = sites[i];
+			n += p.print(_F("  "));
+			if(s.tag != nullptr) {
+				n += p.print(s.tag);
+			} else {
+				n += p.print(_F("0x"));
+				n += p.print(uintptr_t(s.caller), HEX);
+			}
+			n += p.printf(_F(": %u, %u, %u, %u, %u\r\n"), s.current, s.peak, s.total, s.count, s.live);
+		}
+	}
+
+	if(sampleCount != 0) {
+		n += p.println(_F("Samples (time: current, free, largest, fragmentation%):"));
+		for(unsigned i = 0; i < sampleCount; ++i) {
+			auto s = getSample(i);
+			n += p.printf(_F("  %u: %u, %u, %u, %u\r\n"), s->time, s->current, s->freeHeap, s->largest,
+						  s->fragmentation);
+		}
+	}
+
+#ifdef ENABLE_HEAP_REGIONS
+	heap_region_info_t info;
+	for(unsigned i = 0; heap_region_get_info(heap_region_get(i), &info); ++i) {
+		if(i == 0) {
+			n += p.println(_F("Regions (name: size, free, min free, largest, allocations, failures):"));
+		}
+		n += p.printf(_F("  %s: %u, %u, %u, %u, %u, %u\r\n"), info.name, info.size, info.free, info.min_free,
+					  info.largest_free, info.alloc_count, info.fail_count);
+	}
+#endif
+
+	return n;
+}
+
+#ifdef ENABLE_MALLOC_COUNT
+
+/****************************************************/
+/* malloc_count function implementations             */
+/****************************************************/
+
+extern "C" void* mc_malloc(size_t size)
+{
+	return allocate(size, __builtin_return_address(0));
 }
 
 extern "C" void* mc_zalloc(size_t size)
 {
-	auto ptr = mc_malloc(size);
-	if(ptr != nullptr) {
-		memset(ptr, 0, size);
-	}
-	return ptr;
+	return zallocate(size, __builtin_return_address(0));
 }
 
 extern "C" void mc_free(void* ptr)
@@ -260,8 +575,9 @@ extern "C" void mc_free(void* ptr)
 		*p_sentinel = 0; // Clear sentinel to avoid false-positives
 		ptr = (char*)ptr - alignment;
 
-		size_t size = *(size_t*)ptr;
-		dec_count(size);
+		auto hdr = static_cast<Header*>(ptr);
+		size_t size = hdr->size;
+		dec_count(size, hdr->site);
 
 		if(size >= logThreshold) {
 			log("free(%p) -> %u (cur %u)", (char*)ptr + alignment, size, stats.current);
@@ -273,7 +589,7 @@ extern "C" void mc_free(void* ptr)
 
 extern "C" void* mc_calloc(size_t nmemb, size_t size)
 {
-	return mc_zalloc(nmemb * size);
+	return zallocate(nmemb * size, __builtin_return_address(0));
 }
 
 extern "C" void* mc_realloc(void* ptr, size_t size)
@@ -286,7 +602,7 @@ extern "C" void* mc_realloc(void* ptr, size_t size)
 
 	// special case ptr == 0 -> malloc()
 	if(ptr == nullptr) {
-		return mc_malloc(size);
+		return allocate(size, __builtin_return_address(0));
 	}
 
 	if(*GET_SENTINEL(ptr) != sentinel) {
@@ -303,7 +619,9 @@ extern "C" void* mc_realloc(void* ptr, size_t size)
 
 	ptr = (char*)ptr - alignment;
 
-	size_t oldsize = *(size_t*)ptr;
+	auto hdr = static_cast<Header*>(ptr);
+	size_t oldsize = hdr->size;
+	uint16_t oldsite = hdr->site;
 
 	void* newptr = REAL(F_REALLOC)(ptr, alignment + size);
 
@@ -312,8 +630,11 @@ extern "C" void* mc_realloc(void* ptr, size_t size)
 		return nullptr;
 	}
 
-	dec_count(oldsize);
-	inc_count(size);
+	dec_count(oldsize, oldsite);
+	hdr = static_cast<Header*>(newptr);
+	hdr->size = size;
+	hdr->site = findSite(__builtin_return_address(0));
+	inc_count(size, hdr->site);
 
 	if(size >= logThreshold) {
 		if(newptr == ptr) {
@@ -324,8 +645,6 @@ extern "C" void* mc_realloc(void* ptr, size_t size)
 		}
 	}
 
-	*(size_t*)newptr = size;
-
 	return (char*)newptr + alignment;
 }
 
@@ -364,22 +683,22 @@ using namespace MallocCount;
 
 void* operator new(size_t size)
 {
-	return mc_malloc(size);
+	return allocate(size, __builtin_return_address(0));
 }
 
 void* operator new(size_t size, const std::nothrow_t&)
 {
-	return mc_malloc(size);
+	return allocate(size, __builtin_return_address(0));
 }
 
 void* operator new[](size_t size)
 {
-	return mc_malloc(size);
+	return allocate(size, __builtin_return_address(0));
 }
 
 void* operator new[](size_t size, const std::nothrow_t&)
 {
-	return mc_malloc(size);
+	return allocate(size, __builtin_return_address(0));
 }
 
 void operator delete(void* ptr)
@@ -56,9 +56,9 @@ String BrCertificate::getName(DN dn, RDN rdn) const
 
 	switch(dn) {
 	case DN::ISSUER:
-		return issuer.getRDN(type);
+		return names.getRDN(false, type);
 	case DN::SUBJECT:
-		return issuer.getRDN(type);
+		return names.getRDN(true, type);
 	default:
 		return nullptr;
 	}
@@ -25,10 +25,15 @@ public:
 
 	String getName(DN dn, RDN rdn) const override;
 
+	time_t getNotAfter() const override
+	{
+		return notAfter;
+	}
+
 	std::unique_ptr<Fingerprint::Cert::Sha1> fpCertSha1;
 	std::unique_ptr<Fingerprint::Cert::Sha256> fpCertSha256;
-	X509Name issuer;
-	X509Name subject;
+	X509Names names;
+	time_t notAfter{0};
 };
 
 } // namespace Ssl
@@ -44,10 +44,11 @@ int BrClientConnection::init()
 	br_ssl_client_zero(&clientContext);
 
 	// Use Mono-directional buffer size according to requested max. fragment size
-	size_t bufSize = maxBufferSizeToBytes(context.session.maxBufferSize);
+	size_t bufSize = maxBufferSizeToBytes(context.session.getBufferSize());
 	if(bufSize == 0) {
 		bufSize = 4096;
 	}
+	fragmentLength = bufSize;
 	int err = BrConnection::init(bufSize, false);
 	if(err < 0) {
 		return err;
@@ -55,7 +56,25 @@ int BrClientConnection::init()
 
 	br_ssl_client_set_default_rsapub(&clientContext);
 	br_ssl_engine_set_x509(getEngine(), x509);
-	if(!br_ssl_client_reset(&clientContext, context.session.hostName.c_str(), 0)) {
+
+	return begin();
+}
+
+int BrClientConnection::start()
+{
+	// Offer a previous session for resumption, if there is one
+	auto params = context.session.getResumeParameters();
+	if(params != nullptr) {
+		br_ssl_session_parameters pp{};
+		memcpy(pp.session_id, params->id, params->idLength);
+		pp.session_id_len = params->idLength;
+		pp.version = params->version;
+		pp.cipher_suite = params->cipherSuite;
+		memcpy(pp.master_secret, params->masterSecret, sizeof(pp.master_secret));
+		br_ssl_engine_set_session_parameters(getEngine(), &pp);
+	}
+
+	if(!br_ssl_client_reset(&clientContext, context.session.hostName.c_str(), params != nullptr)) {
 		debug_e("br_ssl_client_reset failed");
 		return getLastError();
 	}
@@ -70,7 +89,7 @@ void BrClientConnection::startCert(uint32_t length)
 	}
 
 	certificate.reset(new BrCertificate);
-	x509Decoder.reset(new X509Decoder(&certificate->subject, &certificate->issuer));
+	x509Decoder.reset(new X509Decoder(&certificate->names));
 
 	auto& types = context.session.validators.fingerprintTypes;
 	resetHash(certSha1Context, types.contains(Fingerprint::Type::CertSha1));
@@ -98,6 +117,7 @@ void BrClientConnection::endCert()
 	assert(certificate);
 
 	publicKey = x509Decoder->getPublicKey();
+	certificate->notAfter = x509Decoder->getNotAfter();
 
 	getCalculatedFingerprint(certificate->fpCertSha1, certSha1Context);
 	getCalculatedFingerprint(certificate->fpCertSha256, certSha256Context);
@@ -28,6 +28,8 @@ public:
 
 	int init();
 
+	int start() override;
+
 	const Certificate* getCertificate() const override
 	{
 		return certificate.get();
@@ -38,6 +40,15 @@ public:
 		certificate.reset();
 	}
 
+	int getMaxFragmentLength() const override
+	{
+		// Requested length is derived from buffer size
+		if(fragmentLength >= 16384 || !br_ssl_engine_get_mfln_negotiated(BrConnection::getEngine())) {
+			return 0;
+		}
+		return fragmentLength;
+	}
+
 	/* BrConnection */
 
 	br_ssl_engine_context* getEngine() override
@@ -69,6 +80,7 @@ private:
 	std::unique_ptr<BrCertificate> certificate;
 	std::unique_ptr<Crypto::Sha1> certSha1Context;
 	std::unique_ptr<Crypto::Sha256> certSha256Context;
+	uint16_t fragmentLength{0};
 };
 
 } // namespace Ssl
@@ -106,14 +106,147 @@ int BrConnection::init(size_t bufferSize, bool bidi)
 		bufferSize += MAX_OUT_OVERHEAD;
 	}
 	debug_i("Using buffer size of %u bytes", bufferSize);
-	buffer.reset(new uint8_t[bufferSize]);
-	if(!buffer) {
+	this->bufferSize = bufferSize;
+	this->bidi = bidi;
+
+	if(context.session.options.releaseIdleBuffer) {
+		// Handshake state refers to the buffer, so must not occur once established
+		br_ssl_engine_add_flags(engine, BR_OPT_NO_RENEGOTIATION);
+	}
+
+	return BR_ERR_OK;
+}
+
+BrConnection::~BrConnection()
+{
+	BufferPool::cancel(*this);
+	BufferPool::release(buffer);
+}
+
+int BrConnection::begin()
+{
+	buffer = BufferPool::allocate(bufferSize, this);
+	if(buffer == nullptr) {
+		if(isWaiting()) {
+			debug_i("SSL: Waiting for buffer");
+			return BR_ERR_OK;
+		}
 		debug_e("Buffer allocation failed");
 		return -BR_ERR_BAD_PARAM;
 	}
-	br_ssl_engine_set_buffer(engine, buffer.get(), bufferSize, bidi);
 
-	return BR_ERR_OK;
+	br_ssl_engine_set_buffer(getEngine(), buffer, bufferSize, bidi);
+	started = true;
+	return start();
+}
+
+void BrConnection::bufferAvailable()
+{
+	resume();
+}
+
+void BrConnection::resume()
+{
+	if(started) {
+		return;
+	}
+
+	int err = begin();
+	if(err < 0) {
+		debug_w("SSL: Deferred start failed: %d (%s)", err, getErrorString(err).c_str());
+		return;
+	}
+	if(!started || !pendingInput) {
+		return;
+	}
+
+	// Process anything received whilst waiting
+	pbuf buf{};
+	buf.payload = pendingInput.begin();
+	buf.tot_len = buf.len = pendingInput.length();
+	InputBuffer input(&buf);
+	runUntil(input, BR_SSL_SENDAPP | BR_SSL_RECVAPP);
+	pendingInput = nullptr;
+}
+
+int BrConnection::savePendingInput(InputBuffer& input)
+{
+	auto len = pendingInput.length();
+	auto avail = input.available();
+	if(len + avail > maxPendingInput || !pendingInput.setLength(len + avail)) {
+		debug_e("SSL: Too much data received whilst waiting for buffer");
+		return -BR_ERR_TOO_LARGE;
+	}
+	input.read(reinterpret_cast<uint8_t*>(pendingInput.begin() + len), avail);
+	return 0;
+}
+
+/*
+ * Engine is idle when nothing is partially received or waiting to be sent.
+ * Buffer indices are reset by make_ready_in() and make_ready_out() in ssl_engine.c
+ */
+bool BrConnection::isIdle()
+{
+	if(!handshakeDone || buffer == nullptr) {
+		return false;
+	}
+	auto engine = getEngine();
+	unsigned state = br_ssl_engine_current_state(engine);
+	if(state & (BR_SSL_CLOSED | BR_SSL_SENDREC | BR_SSL_RECVAPP)) {
+		return false;
+	}
+	return engine->ixa == 0 && engine->ixb == 0 && engine->ixc == 5 && engine->oxa == engine->oxc;
+}
+
+void BrConnection::releaseIfIdle()
+{
+	if(!context.session.options.releaseIdleBuffer || !isIdle()) {
+		return;
+	}
+	debug_d("SSL: Releasing idle buffer");
+	releasedBuffer = uintptr_t(buffer);
+	BufferPool::release(buffer);
+	buffer = nullptr;
+}
+
+/*
+ * Buffer contents are not required when idle, but the engine holds pointers into it.
+ * The engine state remains valid so br_ssl_engine_set_buffer() must not be used as that resets it.
+ */
+bool BrConnection::restoreBuffer()
+{
+	if(buffer != nullptr) {
+		return true;
+	}
+	buffer = BufferPool::allocate(bufferSize, nullptr);
+	if(buffer == nullptr) {
+		// Pool exhausted: data cannot be held whilst waiting so use the heap
+		buffer = new uint8_t[bufferSize];
+		if(buffer == nullptr) {
+			debug_e("Buffer allocation failed");
+			return false;
+		}
+	}
+
+	auto rebase = [&](auto& ptr) {
+		auto offset = uintptr_t(ptr) - releasedBuffer;
+		if(ptr != nullptr && offset < bufferSize) {
+			ptr = buffer + offset;
+		}
+	};
+	auto engine = getEngine();
+	rebase(engine->ibuf);
+	rebase(engine->obuf);
+	rebase(engine->hbuf_in);
+	rebase(engine->hbuf_out);
+	rebase(engine->saved_hbuf_out);
+	releasedBuffer = 0;
+	return true;
+}
+
+void BrConnection::endRead()
+{
+	releaseIfIdle();
 }
 
 void BrConnection::setCipherSuites(const CipherSuites::Array* cipherSuites)
@@ -133,6 +266,13 @@ void BrConnection::setCipherSuites(const CipherSuites::Array* cipherSuites)
 
 int BrConnection::read(InputBuffer& input, uint8_t*& output)
 {
+	if(!started) {
+		return savePendingInput(input);
+	}
+	if(!restoreBuffer()) {
+		return -BR_ERR_BAD_PARAM;
+	}
+
 	int state = runUntil(input, BR_SSL_RECVAPP);
 	if(state <= 0) {
 		return state;
@@ -153,6 +293,13 @@ int BrConnection::read(InputBuffer& input, uint8_t*& output)
 
 int BrConnection::write(const uint8_t* data, size_t length)
 {
+	if(!started) {
+		return 0;
+	}
+	if(!restoreBuffer()) {
+		return -BR_ERR_BAD_PARAM;
+	}
+
 	InputBuffer input(nullptr);
 	int state = runUntil(input, BR_SSL_SENDAPP);
 	if(state < 0) {
@@ -188,6 +335,7 @@ int BrConnection::write(const uint8_t* data, size_t length)
 	 * the return value as this will get resolved on the next read operation.
 	 */
 	runUntil(input, BR_SSL_SENDAPP | BR_SSL_RECVAPP);
+	releaseIfIdle();
 	return length;
 }
 
@@ -202,12 +350,18 @@ int BrConnection::runUntil(InputBuffer& input, unsigned target)
 			int err = getLastError();
 			debug_w("SSL CLOSED, last error = %d (%s), heap free = %u", err, getErrorString(err).c_str(),
 					system_get_free_heap_size());
+			if(!handshakeDone && !handshakeFailed) {
+				handshakeFailed = true;
+				context.session.handshakeComplete(false);
+				handshakeComplete(false);
+			}
 			return err;
 		}
 
 		if(!handshakeDone && (state & BR_SSL_SENDAPP)) {
 			handshakeDone = true;
 			context.session.handshakeComplete(true);
+			handshakeComplete(true);
 			debug_i("Negotiated MFLN: %u", br_ssl_engine_get_mfln_negotiated(engine));
 			continue;
 		}
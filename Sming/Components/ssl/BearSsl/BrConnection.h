@@ -13,22 +13,26 @@
 #pragma once
 
 #include <Network/Ssl/Connection.h>
+#include <Network/Ssl/BufferPool.h>
 #include "BrError.h"
 #include "BrCertificate.h"
 #include <bearssl.h>
-#include <memory>
 
 namespace Ssl
 {
-class BrConnection : public Connection
+class BrConnection : public Connection, protected BufferPool::Waiter
 {
 public:
 	using Connection::Connection;
 
+	~BrConnection();
+
 	int read(InputBuffer& input, uint8_t*& output) override;
 
 	int write(const uint8_t* data, size_t length) override;
 
+	void endRead() override;
+
 	CipherSuite getCipherSuite() const override
 	{
 		if(handshakeDone) {
@@ -49,6 +53,25 @@ public:
 		return id;
 	}
 
+	bool getSessionParameters(SessionParameters& params) const override
+	{
+		if(!handshakeDone) {
+			return false;
+		}
+
+		br_ssl_session_parameters pp;
+		br_ssl_engine_get_session_parameters(getEngine(), &pp);
+		if(pp.session_id_len == 0) {
+			return false;
+		}
+		memcpy(params.id, pp.session_id, pp.session_id_len);
+		params.idLength = pp.session_id_len;
+		params.version = pp.version;
+		params.cipherSuite = pp.cipher_suite;
+		memcpy(params.masterSecret, pp.master_secret, sizeof(params.masterSecret));
+		return true;
+	}
+
 	bool isHandshakeDone() const override
 	{
 		return handshakeDone;
@@ -84,6 +107,34 @@ protected:
 	 */
 	int init(size_t bufferSize, bool bidi);
 
+	/**
+	 * @brief Obtain I/O buffer then call start(), or wait until a buffer is available
+	 */
+	int begin();
+
+	/**
+	 * @brief Reset engine and start handshake, called when I/O buffer has been set
+	 */
+	virtual int start() = 0;
+
+	/**
+	 * @brief Start a deferred connection, processing any input received whilst waiting
+	 */
+	void resume();
+
+	/**
+	 * @brief Called when handshake has completed or failed
+	 */
+	virtual void handshakeComplete(bool success)
+	{
+		(void)success;
+	}
+
+	bool isStarted() const
+	{
+		return started;
+	}
+
 	int runUntil(InputBuffer& input, unsigned target);
 
 	int startHandshake()
@@ -95,9 +146,23 @@ protected:
 private:
 	void setCipherSuites(const CipherSuites::Array* cipherSuites);
 
+	void bufferAvailable() override;
+	int savePendingInput(InputBuffer& input);
+	bool isIdle();
+	void releaseIfIdle();
+	bool restoreBuffer();
+
 private:
-	std::unique_ptr<uint8_t[]> buffer;
+	static constexpr size_t maxPendingInput{2048};
+
+	uint8_t* buffer{nullptr};
+	uintptr_t releasedBuffer{0}; ///< Address of buffer released whilst idle
+	size_t bufferSize{0};
+	String pendingInput; ///< Data received whilst waiting for a buffer
+	bool bidi{false};
+	bool started{false};
 	bool handshakeDone = false;
+	bool handshakeFailed = false;
 };
 
 } // namespace Ssl
@@ -31,6 +31,27 @@ Connection* BrContext::createClient(tcp_pcb* tcp)
 	return connection;
 }
 
+bool BrContext::initServer()
+{
+	if(serverKey) {
+		return true;
+	}
+
+	auto& keyCert = session.keyCert;
+	serverCert.data = const_cast<uint8_t*>(keyCert.getCertificate());
+	serverCert.data_len = keyCert.getCertificateLength();
+	if(!serverKey.decode(keyCert.getKey(), keyCert.getKeyLength())) {
+		debug_e("Failed to decode keyCert");
+		return false;
+	}
+
+	if(session.cacheSize > 0) {
+		sessionCache.reset(new BrSessionCache(session.cacheSize));
+	}
+
+	return true;
+}
+
 Connection* BrContext::createServer(tcp_pcb* tcp)
 {
 	auto connection = new BrServerConnection(*this, tcp);
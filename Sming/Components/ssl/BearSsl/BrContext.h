@@ -13,6 +13,8 @@
 #pragma once
 
 #include <Network/Ssl/Context.h>
+#include "BrPrivateKey.h"
+#include "BrSessionCache.h"
 
 namespace Ssl
 {
@@ -33,6 +35,37 @@ public:
 
 	Connection* createClient(tcp_pcb* tcp) override;
 	Connection* createServer(tcp_pcb* tcp) override;
+
+	/**
+	 * @brief Decode server key and certificate, shared by all connections
+	 * @retval bool true if key is valid
+	 * @note Decoding is done once only, on first call
+	 */
+	bool initServer();
+
+	const br_x509_certificate& getServerCertificate() const
+	{
+		return serverCert;
+	}
+
+	const BrPrivateKey& getServerKey() const
+	{
+		return serverKey;
+	}
+
+	/**
+	 * @brief Get cache for resuming sessions with clients
+	 * @retval BrSessionCache* nullptr if caching is disabled
+	 */
+	BrSessionCache* getSessionCache()
+	{
+		return sessionCache.get();
+	}
+
+private:
+	br_x509_certificate serverCert{};
+	BrPrivateKey serverKey;
+	std::unique_ptr<BrSessionCache> sessionCache;
 };
 
 } // namespace Ssl
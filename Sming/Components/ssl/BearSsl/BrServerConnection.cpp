@@ -14,10 +14,20 @@
  */
 #include <SslDebug.h>
 #include "BrServerConnection.h"
+#include "BrContext.h"
 #include <Network/Ssl/Session.h>
+#include <Platform/System.h>
 
 namespace Ssl
 {
+namespace
+{
+unsigned activeHandshakes;
+BrServerConnection* waitHead;
+BrServerConnection* waitTail;
+bool admitPending;
+} // namespace
+
 int BrServerConnection::init()
 {
 	br_ssl_server_zero(&serverContext);
@@ -39,15 +49,107 @@ int BrServerConnection::init()
 
 	br_ssl_engine_add_flags(engine, BR_OPT_NO_RENEGOTIATION);
 
-	auto& keyCert = context.session.keyCert;
-	cert.data = const_cast<uint8_t*>(keyCert.getCertificate());
-	cert.data_len = keyCert.getCertificateLength();
-	if(!key.decode(keyCert.getKey(), keyCert.getKeyLength())) {
-		debug_e("Failed to decode keyCert");
+	// Key and certificate are decoded once and shared by all connections
+	auto& brContext = static_cast<BrContext&>(context);
+	if(!brContext.initServer()) {
 		return -BR_ERR_BAD_PARAM;
 	}
-	br_ssl_server_set_single_rsa(&serverContext, &cert, 1, key, BR_KEYTYPE_RSA | BR_KEYTYPE_KEYX | BR_KEYTYPE_SIGN,
-								 br_rsa_private_get_default(), br_rsa_pkcs1_sign_get_default());
+	auto& key = brContext.getServerKey();
+	br_ssl_server_set_single_rsa(&serverContext, &brContext.getServerCertificate(), 1, key,
+								 BR_KEYTYPE_RSA | BR_KEYTYPE_KEYX | BR_KEYTYPE_SIGN, br_rsa_private_get_default(),
+								 br_rsa_pkcs1_sign_get_default());
+
+	auto cache = brContext.getSessionCache();
+	if(cache != nullptr) {
+		br_ssl_server_set_cache(&serverContext, cache->getVtable());
+	}
+
+	if(SSL_MAX_SERVER_HANDSHAKES != 0 && (activeHandshakes >= SSL_MAX_SERVER_HANDSHAKES || waitHead != nullptr)) {
+		// Join the queue, holding on to any received data until admitted
+		debug_i("SSL: %u handshakes active, waiting", activeHandshakes);
+		admission = Admission::waiting;
+		if(waitTail == nullptr) {
+			waitHead = this;
+		} else {
+			waitTail->nextWaiting = this;
+		}
+		waitTail = this;
+		return BR_ERR_OK;
+	}
+
+	admission = Admission::active;
+	++activeHandshakes;
+	return begin();
+}
+
+BrServerConnection::~BrServerConnection()
+{
+	leave();
+}
+
+/*
+ * Give up handshake slot or place in queue
+ */
+void BrServerConnection::leave()
+{
+	if(admission == Admission::waiting) {
+		BrServerConnection* prev{nullptr};
+		for(auto conn = waitHead; conn != nullptr; prev = conn, conn = conn->nextWaiting) {
+			if(conn != this) {
+				continue;
+			}
+			if(prev == nullptr) {
+				waitHead = nextWaiting;
+			} else {
+				prev->nextWaiting = nextWaiting;
+			}
+			if(waitTail == this) {
+				waitTail = prev;
+			}
+			break;
+		}
+		nextWaiting = nullptr;
+	} else if(admission == Admission::active) {
+		--activeHandshakes;
+		if(waitHead != nullptr && !admitPending) {
+			admitPending = System.queueCallback(admitNext);
+		}
+	}
+	admission = Admission::done;
+}
+
+void BrServerConnection::handshakeComplete(bool)
+{
+	leave();
+}
+
+/*
+ * Start the next waiting handshake from the task queue, so each runs in its own task
+ */
+void BrServerConnection::admitNext(void*)
+{
+	admitPending = false;
+	if(activeHandshakes >= SSL_MAX_SERVER_HANDSHAKES || waitHead == nullptr) {
+		return;
+	}
+
+	auto conn = waitHead;
+	waitHead = conn->nextWaiting;
+	if(waitHead == nullptr) {
+		waitTail = nullptr;
+	}
+	conn->nextWaiting = nullptr;
+	conn->admission = Admission::active;
+	++activeHandshakes;
+	conn->resume();
+
+	if(waitHead != nullptr && activeHandshakes < SSL_MAX_SERVER_HANDSHAKES && !admitPending) {
+		admitPending = System.queueCallback(admitNext);
+	}
+}
+
+int BrServerConnection::start()
+{
 	// Warning: Inconsistent return type: not an error code
 	if(!br_ssl_server_reset(&serverContext)) {
 		debug_e("br_ssl_client_reset failed");
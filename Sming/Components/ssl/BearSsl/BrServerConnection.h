@@ -13,7 +13,13 @@
 #pragma once
 
 #include "BrConnection.h"
-#include "BrPrivateKey.h"
+
+/**
+ * @brief Maximum number of server handshakes to run concurrently, 0 for no limit
+ */
+#ifndef SSL_MAX_SERVER_HANDSHAKES
+#define SSL_MAX_SERVER_HANDSHAKES 0
+#endif
 
 namespace Ssl
 {
@@ -22,8 +28,12 @@ class BrServerConnection : public BrConnection
 public:
 	using BrConnection::BrConnection;
 
+	~BrServerConnection();
+
 	int init();
 
+	int start() override;
+
 	const Certificate* getCertificate() const override
 	{
 		return nullptr;
@@ -38,10 +48,23 @@ public:
 		return &serverContext.eng;
 	}
 
+protected:
+	void handshakeComplete(bool success) override;
+
 private:
+	enum class Admission : uint8_t {
+		none,
+		waiting, ///< In queue for a handshake slot
+		active,	 ///< Holding a handshake slot
+		done,
+	};
+
+	static void admitNext(void*);
+	void leave();
+
 	br_ssl_server_context serverContext;
-	br_x509_certificate cert;
-	BrPrivateKey key;
+	BrServerConnection* nextWaiting{nullptr};
+	Admission admission{Admission::none};
 };
 
 } // namespace Ssl
@@ -0,0 +1,93 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/SmingHub/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * BrSessionCache.cpp
+ *
+ ****/
+
+#include <SslDebug.h>
+#include "BrSessionCache.h"
+#include <Platform/Timers.h>
+
+namespace Ssl
+{
+namespace
+{
+// Never zero, which marks an unused entry
+uint32_t getTimestamp()
+{
+	return (millis() / 1000) | 1;
+}
+
+} // namespace
+
+const br_ssl_session_cache_class BrSessionCache::cacheClass{
+	sizeof(BrSessionCache),
+	save,
+	load,
+};
+
+void BrSessionCache::save(const br_ssl_session_cache_class** ctx, br_ssl_server_context*,
+						  const br_ssl_session_parameters* params)
+{
+	auto cache = self(ctx);
+	if(cache->size == 0 || params->session_id_len != sizeof(Entry::id)) {
+		return;
+	}
+
+	if(!cache->entries) {
+		cache->entries.reset(new Entry[cache->size]{});
+		if(!cache->entries) {
+			return;
+		}
+	}
+
+	// Replace unused or oldest entry
+	auto now = getTimestamp();
+	auto entry = &cache->entries[0];
+	for(unsigned i = 1; i < cache->size && entry->timestamp != 0; ++i) {
+		auto& e = cache->entries[i];
+		if(e.timestamp == 0 || now - e.timestamp > now - entry->timestamp) {
+			entry = &e;
+		}
+	}
+
+	memcpy(entry->id, params->session_id, sizeof(entry->id));
+	memcpy(entry->masterSecret, params->master_secret, sizeof(entry->masterSecret));
+	entry->version = params->version;
+	entry->cipherSuite = params->cipher_suite;
+	entry->timestamp = now;
+}
+
+int BrSessionCache::load(const br_ssl_session_cache_class** ctx, br_ssl_server_context*,
+						 br_ssl_session_parameters* params)
+{
+	auto cache = self(ctx);
+	if(!cache->entries || params->session_id_len != sizeof(Entry::id)) {
+		return 0;
+	}
+
+	auto now = getTimestamp();
+	for(unsigned i = 0; i < cache->size; ++i) {
+		auto& entry = cache->entries[i];
+		if(entry.timestamp == 0 || memcmp(entry.id, params->session_id, sizeof(entry.id)) != 0) {
+			continue;
+		}
+		if(now - entry.timestamp > SSL_SERVER_SESSION_LIFETIME) {
+			debug_d("SSL: Cached session expired");
+			entry = Entry{};
+			return 0;
+		}
+		memcpy(params->master_secret, entry.masterSecret, sizeof(entry.masterSecret));
+		params->version = entry.version;
+		params->cipher_suite = entry.cipherSuite;
+		return 1;
+	}
+
+	return 0;
+}
+
+} // namespace Ssl
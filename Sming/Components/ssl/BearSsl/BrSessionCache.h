@@ -0,0 +1,80 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/SmingHub/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * BrSessionCache.h
+ *
+ ****/
+
+#pragma once
+
+#include <bearssl.h>
+#include <memory>
+
+/**
+ * @brief Maximum age of a cached server session, in seconds
+ */
+#ifndef SSL_SERVER_SESSION_LIFETIME
+#define SSL_SERVER_SESSION_LIFETIME 3600
+#endif
+
+namespace Ssl
+{
+/**
+ * @brief Server session cache shared by all connections using a context
+ *
+ * Entries are allocated on first use. When full, the oldest entry is replaced.
+ * Sessions older than SSL_SERVER_SESSION_LIFETIME are not resumed.
+ */
+class BrSessionCache
+{
+public:
+	BrSessionCache(unsigned size) : size(size)
+	{
+	}
+
+	/**
+	 * @brief Get the cache interface to pass to br_ssl_server_set_cache()
+	 */
+	const br_ssl_session_cache_class** getVtable()
+	{
+		return &vtable;
+	}
+
+	/**
+	 * @brief Discard all cached sessions
+	 */
+	void clear()
+	{
+		entries.reset();
+	}
+
+private:
+	struct Entry {
+		uint8_t id[32];
+		uint8_t masterSecret[48];
+		uint16_t version;
+		uint16_t cipherSuite;
+		uint32_t timestamp; ///< Seconds, 0 if unused
+	};
+
+	static BrSessionCache* self(const br_ssl_session_cache_class** ctx)
+	{
+		return reinterpret_cast<BrSessionCache*>(ctx);
+	}
+
+	static void save(const br_ssl_session_cache_class** ctx, br_ssl_server_context*,
+					 const br_ssl_session_parameters* params);
+	static int load(const br_ssl_session_cache_class** ctx, br_ssl_server_context*,
+					br_ssl_session_parameters* params);
+
+	static const br_ssl_session_cache_class cacheClass;
+
+	const br_ssl_session_cache_class* vtable{&cacheClass}; ///< Must be first
+	std::unique_ptr<Entry[]> entries;
+	unsigned size;
+};
+
+} // namespace Ssl
@@ -20,10 +20,14 @@ namespace Ssl
 class X509Decoder
 {
 public:
-	X509Decoder(X509Name* subject = nullptr, X509Name* issuer = nullptr)
+	/**
+	 * @brief Constructor
+	 * @param names If provided, receives issuer and subject DNs
+	 */
+	X509Decoder(X509Names* names = nullptr)
 	{
-		br_x509_decoder_init(&context, subject ? X509Name::append : nullptr, subject,
-							 issuer ? X509Name::append : nullptr, issuer);
+		br_x509_decoder_init(&context, names ? X509Names::appendSubject : nullptr, names,
+							 names ? X509Names::appendIssuer : nullptr, names);
 	}
 
 	void push(const uint8_t* buf, size_t len)
@@ -36,6 +40,19 @@ public:
 		return br_x509_decoder_get_pkey(&context);
 	}
 
+	/**
+	 * @brief Get end of validity period as Unix time, 0 if not decoded
+	 */
+	time_t getNotAfter() const
+	{
+		// Decoder counts days from 1 January 0 AD
+		constexpr uint32_t unixEpochDays{719528};
+		if(context.notafter_days < unixEpochDays) {
+			return 0;
+		}
+		return time_t(context.notafter_days - unixEpochDays) * 86400 + context.notafter_seconds;
+	}
+
 private:
 	br_x509_decoder_context context;
 };
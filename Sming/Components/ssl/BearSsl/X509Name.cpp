@@ -14,9 +14,13 @@
 
 namespace Ssl
 {
-String X509Name::getRDN(uint8_t type) const
+String X509Names::getRDN(const uint8_t* dn, size_t length, uint8_t type)
 {
-	Asn1Parser parser(reinterpret_cast<const uint8_t*>(dn.c_str()), dn.length());
+	if(length == 0) {
+		return nullptr;
+	}
+
+	Asn1Parser parser(dn, length);
 
 	if(parser.getNextObject(ASN1_SEQUENCE) == 0) {
 		return nullptr;
@@ -16,50 +16,60 @@
 namespace Ssl
 {
 /**
- * @brief Contains a DER-encoded Distinguished Name
+ * @brief Contains the DER-encoded issuer and subject Distinguished Names of a certificate
+ *
+ * The issuer precedes the subject in a certificate, so both are appended to a single buffer
+ * as they are decoded and only the offset of the subject is kept.
+ * Nothing is parsed until an RDN is requested.
  */
-class X509Name
+class X509Names
 {
 public:
-	X509Name() = default;
-
-	X509Name(const X509Name& name) : dn(name.dn)
-	{
-	}
-
-	X509Name(X509Name&& name) : dn(std::move(name.dn))
-	{
-	}
-
-	X509Name& operator=(X509Name&& name)
-	{
-		if(this != &name) {
-			dn = std::move(name.dn);
-		}
-		return *this;
-	}
-
 	void clear()
 	{
 		dn.setLength(0);
+		subjectOffset = 0;
 	}
 
-	const String& getDN() const
+	/**
+	 * @brief Callback for br_x509_decoder_init() to receive issuer DN
+	 */
+	static void appendIssuer(void* ctx, const void* buf, size_t len)
 	{
-		return dn;
+		auto self = static_cast<X509Names*>(ctx);
+		self->dn.concat(static_cast<const char*>(buf), len);
+		self->subjectOffset = self->dn.length();
 	}
 
-	static void append(void* ctx, const void* buf, size_t len)
+	/**
+	 * @brief Callback for br_x509_decoder_init() to receive subject DN
+	 */
+	static void appendSubject(void* ctx, const void* buf, size_t len)
 	{
-		auto self = static_cast<X509Name*>(ctx);
+		auto self = static_cast<X509Names*>(ctx);
 		self->dn.concat(static_cast<const char*>(buf), len);
 	}
 
-	// Obtain Relative Distinguished Name by type
-	String getRDN(uint8_t type) const;
+	/**
+	 * @brief Obtain Relative Distinguished Name by type
+	 * @param subject true for subject, false for issuer
+	 * @param type OID type
+	 */
+	String getRDN(bool subject, uint8_t type) const
+	{
+		auto data = reinterpret_cast<const uint8_t*>(dn.c_str());
+		return subject ? getRDN(&data[subjectOffset], dn.length() - subjectOffset, type)
+					   : getRDN(data, subjectOffset, type);
+	}
+
+	/**
+	 * @brief Obtain Relative Distinguished Name by type from a DER-encoded DN
+	 */
+	static String getRDN(const uint8_t* dn, size_t length, uint8_t type);
 
 private:
-	String dn; ///< The ASN1-encoded Distinguished Name
+	String dn;				   ///< Issuer DN followed by subject DN
+	uint16_t subjectOffset{0}; ///< Start of subject within `dn`
 };
 
 } // namespace Ssl
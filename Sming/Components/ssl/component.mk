@@ -26,6 +26,29 @@ endif
 #
 COMPONENT_DEPENDS		+= crypto
 
+# Shared I/O buffers
+COMPONENT_VARS			+= SSL_BUFFER_POOL_COUNT SSL_BUFFER_POOL_SIZE
+SSL_BUFFER_POOL_COUNT	?= 0
+SSL_BUFFER_POOL_SIZE	?= 5120
+GLOBAL_CFLAGS			+= \
+	-DSSL_BUFFER_POOL_COUNT=$(SSL_BUFFER_POOL_COUNT) \
+	-DSSL_BUFFER_POOL_SIZE=$(SSL_BUFFER_POOL_SIZE)
+
+# Certificate validation results
+COMPONENT_VARS			+= SSL_VALIDATION_CACHE_SIZE
+SSL_VALIDATION_CACHE_SIZE	?= 0
+GLOBAL_CFLAGS			+= -DSSL_VALIDATION_CACHE_SIZE=$(SSL_VALIDATION_CACHE_SIZE)
+
+# Limit CPU load from bursts of incoming connections
+COMPONENT_VARS			+= SSL_MAX_SERVER_HANDSHAKES
+SSL_MAX_SERVER_HANDSHAKES	?= 0
+COMPONENT_CXXFLAGS		+= -DSSL_MAX_SERVER_HANDSHAKES=$(SSL_MAX_SERVER_HANDSHAKES)
+
+# Server session cache
+COMPONENT_VARS			+= SSL_SERVER_SESSION_LIFETIME
+SSL_SERVER_SESSION_LIFETIME	?= 3600
+COMPONENT_CXXFLAGS		+= -DSSL_SERVER_SESSION_LIFETIME=$(SSL_SERVER_SESSION_LIFETIME)
+
 COMPONENT_RELINK_VARS	+= SSL_DEBUG
 SSL_DEBUG				?= 0
 ifeq ($(SSL_DEBUG),1)
@@ -0,0 +1,129 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/SmingHub/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * BufferPool.h
+ *
+ ****/
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @brief Number of I/O buffers in the pool, 0 to allocate from the heap per connection
+ */
+#ifndef SSL_BUFFER_POOL_COUNT
+#define SSL_BUFFER_POOL_COUNT 0
+#endif
+
+/**
+ * @brief Size of each pooled buffer, including record overheads
+ */
+#ifndef SSL_BUFFER_POOL_SIZE
+#define SSL_BUFFER_POOL_SIZE 5120
+#endif
+
+namespace Ssl
+{
+/**
+ * @brief Shared pool of fixed-size I/O buffers for SSL connections
+ *
+ * Each connection needs an I/O buffer of several kilobytes. Allocating and freeing these for every connection
+ * fragments the heap until handshakes start to fail, so instead a fixed number of buffers are allocated
+ * as a single block which is retained for the life of the application.
+ *
+ * When all buffers are in use a new connection waits, in order of arrival, until one is released.
+ * Connections needing a larger buffer than the pool provides allocate from the heap as before.
+ */
+namespace BufferPool
+{
+class WaitQueue;
+
+/**
+ * @brief Implemented by connections which can wait for a buffer
+ */
+class Waiter
+{
+public:
+	virtual ~Waiter()
+	{
+	}
+
+	/**
+	 * @brief Called from the task queue when a buffer may be available
+	 * @note Call allocate() again to obtain it
+	 */
+	virtual void bufferAvailable() = 0;
+
+	bool isWaiting() const
+	{
+		return waiting;
+	}
+
+private:
+	friend WaitQueue;
+
+	Waiter* next{nullptr};
+	bool waiting{false};
+};
+
+struct Stats {
+	uint16_t count;		 ///< Number of buffers in pool
+	uint16_t used;		 ///< Buffers currently allocated
+	uint16_t maxUsed;	 ///< Highest number of buffers allocated at once
+	uint16_t waiting;	 ///< Connections currently waiting for a buffer
+	uint32_t waits;		 ///< Number of times a connection has had to wait
+	uint32_t heapAllocs; ///< Requests too large for the pool, allocated from heap
+};
+
+/**
+ * @brief Allocate pool memory
+ *
+ * Called automatically on first use. Call early in application startup so the pool
+ * is allocated before the heap becomes fragmented.
+ *
+ * @retval bool false if pool is disabled or memory could not be allocated
+ */
+bool init();
+
+/**
+ * @brief Get size of pooled buffers
+ */
+inline constexpr size_t getBufferSize()
+{
+	return SSL_BUFFER_POOL_SIZE;
+}
+
+/**
+ * @brief Obtain a buffer
+ * @param size Required size in bytes
+ * @param waiter If no buffer is available, this is queued for notification
+ * @retval uint8_t* nullptr if waiting, or if heap allocation failed
+ *
+ * If the pool is disabled, or the requested size exceeds the pool buffer size, the buffer is allocated from the heap.
+ */
+uint8_t* allocate(size_t size, Waiter* waiter);
+
+/**
+ * @brief Return a buffer obtained with allocate()
+ */
+void release(uint8_t* buffer);
+
+/**
+ * @brief Remove a waiter from the queue
+ *
+ * Must be called by connections before they are destroyed.
+ */
+void cancel(Waiter& waiter);
+
+/**
+ * @brief Get pool statistics
+ */
+Stats getStats();
+
+} // namespace BufferPool
+} // namespace Ssl
@@ -14,6 +14,7 @@
 
 #include <WString.h>
 #include "Fingerprints.h"
+#include <ctime>
 
 namespace Ssl
 {
@@ -86,6 +87,15 @@ public:
 	 */
 	virtual String getName(DN dn, RDN rdn) const = 0;
 
+	/**
+	 * @brief Get end of certificate validity period
+	 * @retval time_t Unix time (UTC), 0 if not available
+	 */
+	virtual time_t getNotAfter() const
+	{
+		return 0;
+	}
+
 	/**
 	 * @brief Debugging print support
 	 */
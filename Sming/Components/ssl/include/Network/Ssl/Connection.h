@@ -72,6 +72,25 @@ public:
 	 */
 	virtual int write(const uint8_t* data, size_t length) = 0;
 
+	/**
+	 * @brief Called when all available received data has been processed
+	 *
+	 * Implementations may release resources which are not required until more data arrives.
+	 */
+	virtual void endRead()
+	{
+	}
+
+	/**
+	 * @brief Get negotiated maximum fragment length
+	 * @retval int Length in bytes, 0 if not negotiated, or -1 if not known by the adapter
+	 * @see https://tools.ietf.org/html/rfc6066#section-4
+	 */
+	virtual int getMaxFragmentLength() const
+	{
+		return -1;
+	}
+
 	/**
 	 * @brief Gets the cipher suite that was used
 	 * @retval CipherSuite IDs as defined by SSL/TLS standard
@@ -85,6 +104,17 @@ public:
 	 */
 	virtual SessionId getSessionId() const = 0;
 
+	/**
+	 * @brief Get the parameters required to resume the current session later on
+	 * @param params On success, contains the session parameters
+	 * @retval bool false if the implementation does not support exporting session parameters
+	 */
+	virtual bool getSessionParameters(SessionParameters& params) const
+	{
+		(void)params;
+		return false;
+	}
+
 	/**
 	 * @brief Gets the certificate object.
 	 *        That object MUST be owned by the Connection implementation
@@ -13,6 +13,7 @@
 #include "Context.h"
 #include "KeyCertPair.h"
 #include "ValidatorList.h"
+#include "SessionStore.h"
 #include <Platform/System.h>
 
 class TcpConnection;
@@ -54,8 +55,12 @@ struct Options {
 	bool clientAuthentication : 1;
 	bool verifyLater : 1; ///< Allow handshake to complete before verifying certificate
 	bool freeKeyCertAfterHandshake : 1;
+	bool releaseIdleBuffer : 1; ///< Free I/O buffer between exchanges, reacquiring it as required
+	bool adaptiveBufferSize : 1; ///< Use full-size buffers for servers which don't accept maxBufferSize
 
-	Options() : sessionResume(false), clientAuthentication(false), verifyLater(false), freeKeyCertAfterHandshake(false)
+	Options()
+		: sessionResume(false), clientAuthentication(false), verifyLater(false), freeKeyCertAfterHandshake(false),
+		  releaseIdleBuffer(false), adaptiveBufferSize(false)
 	{
 	}
 
@@ -67,6 +72,18 @@ __forceinline String toString(const Options& options)
 	return options.toString();
 }
 
+/**
+ * @brief Handshake counters, accumulated across all sessions
+ */
+struct HandshakeStats {
+	uint32_t full;	  ///< Handshakes requiring full key exchange
+	uint32_t resumed; ///< Handshakes which resumed a previous session
+	uint32_t failed;  ///< Handshakes which did not complete
+};
+
+const HandshakeStats& getHandshakeStats();
+void resetHandshakeStats();
+
 /**
  * @brief Handles all SSL activity for a TCP connection
  *
@@ -117,11 +134,20 @@ public:
 	 */
 	ValidatorList validators;
 
+	/**
+	 * @brief Optional persistent storage for client session parameters
+	 *
+	 * Used with `options.sessionResume` so a session may be resumed following restart or deep sleep.
+	 * The store is not owned by the session.
+	 */
+	SessionStore* store = nullptr;
+
 public:
 	~Session()
 	{
 		close();
 		delete sessionId;
+		delete resumeParameters;
 	}
 
 	/**
@@ -133,6 +159,26 @@ public:
 		return sessionId;
 	}
 
+	/**
+	 * @brief Get parameters to be used by the SSL adapter for resuming a client session
+	 * @retval SessionParameters* nullptr if there is no session to resume
+	 * @note SSL Internal method
+	 */
+	const SessionParameters* getResumeParameters() const
+	{
+		return resumeParameters;
+	}
+
+	/**
+	 * @brief Get buffer size to request for a client connection
+	 *
+	 * Normally this is `maxBufferSize`. With `options.adaptiveBufferSize` set, servers which have previously
+	 * failed to negotiate that fragment length get MaxBufferSize::K16 instead.
+	 *
+	 * @note SSL Internal method
+	 */
+	MaxBufferSize getBufferSize() const;
+
 	/**
 	 * @brief Called when a client connection is made via server TCP socket
 	 * @param client The client TCP socket
@@ -191,6 +237,16 @@ public:
 	 */
 	int read(InputBuffer& input, uint8_t*& output);
 
+	/**
+	 * @brief Called when all received data has been read, so decrypted content is no longer required
+	 */
+	void endRead()
+	{
+		if(connection != nullptr) {
+			connection->endRead();
+		}
+	}
+
 	/**
 	 * @brief Write data to SSL connection
 	 * @param data
@@ -221,11 +277,16 @@ public:
 private:
 	void beginHandshake();
 	void endHandshake();
+	bool loadResumeParameters();
+	void discardResumeParameters();
+	void updateFragmentLengthCache(bool success);
 
 private:
 	Context* context = nullptr;
 	Connection* connection = nullptr;
 	SessionId* sessionId = nullptr;
+	SessionParameters* resumeParameters = nullptr;
+	bool resumeOffered = false;
 	CpuFrequency curFreq = CpuFrequency(0);
 };
 
@@ -45,6 +45,16 @@ public:
 		return true;
 	}
 
+	bool operator==(const SessionId& other) const
+	{
+		return value == other.value;
+	}
+
+	bool operator!=(const SessionId& other) const
+	{
+		return !operator==(other);
+	}
+
 	/**
 	 * @brief Return a string representation of the session ID
 	 */
@@ -62,4 +72,33 @@ __forceinline String toString(const SessionId& id)
 	return id.toString();
 }
 
+/**
+ * @brief Everything a client needs to resume an SSL session without a full handshake
+ *
+ * This is a plain structure so it can be written directly to RTC memory or flash.
+ */
+struct SessionParameters {
+	static constexpr size_t maxIdLength{32};
+	static constexpr size_t masterSecretLength{48};
+
+	uint8_t id[maxIdLength];
+	uint8_t idLength;
+	uint16_t version;
+	uint16_t cipherSuite;
+	uint8_t masterSecret[masterSecretLength];
+
+	bool isValid() const
+	{
+		return idLength != 0 && idLength <= maxIdLength;
+	}
+
+	/**
+	 * @brief Determine if a negotiated session ID matches the one stored here
+	 */
+	bool matches(const SessionId& sessionId) const
+	{
+		return isValid() && sessionId.getLength() == idLength && memcmp(sessionId.getValue(), id, idLength) == 0;
+	}
+};
+
 } // namespace Ssl
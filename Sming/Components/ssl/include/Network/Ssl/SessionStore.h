@@ -0,0 +1,136 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/SmingHub/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * SessionStore.h
+ *
+ ****/
+
+#pragma once
+
+#include "SessionId.h"
+#include <Storage/Partition.h>
+
+namespace Ssl
+{
+/**
+ * @brief Pluggable persistence for client session parameters
+ *
+ * Assign an implementation to `Session::store` so sessions may be resumed after a restart or deep sleep.
+ * Entries are keyed by host name.
+ */
+class SessionStore
+{
+public:
+	virtual ~SessionStore()
+	{
+	}
+
+	/**
+	 * @brief Fetch stored parameters for a host
+	 * @retval bool true if valid parameters were found
+	 */
+	virtual bool load(const String& hostName, SessionParameters& params) = 0;
+
+	/**
+	 * @brief Store parameters for a host, replacing any existing entry
+	 * @retval bool true on success
+	 */
+	virtual bool save(const String& hostName, const SessionParameters& params) = 0;
+
+	/**
+	 * @brief Discard any entry for a host, e.g. because resumption was rejected
+	 */
+	virtual void remove(const String& hostName) = 0;
+
+	/**
+	 * @brief Stored form of an entry, protected by a checksum
+	 */
+	struct Record {
+		uint32_t magic;
+		uint32_t hostHash;
+		SessionParameters params;
+		uint32_t checksum;
+
+		void init(uint32_t hostHash, const SessionParameters& params);
+		bool isValid() const;
+	};
+
+protected:
+	static uint32_t getHostHash(const String& hostName);
+};
+
+/**
+ * @brief Keeps session parameters in memory which survives deep sleep
+ *
+ * On the Esp8266 this uses the user area of RTC memory. Elsewhere a `noinit` buffer is used,
+ * which survives a software restart on supported architectures.
+ *
+ * Each entry requires 25 words (100 bytes) of RTC memory.
+ */
+class RtcSessionStore : public SessionStore
+{
+public:
+	static constexpr unsigned maxSlots{4};
+
+	/**
+	 * @brief Start of RTC memory area reserved for session storage on the Esp8266
+	 *
+	 * The area extends to the start of the crash log record, if enabled, which by default
+	 * leaves room for one slot. Otherwise all four slots are available.
+	 * See `esp_rtc_map.h`.
+	 */
+	static constexpr uint8_t defaultRtcAddress{81};
+
+	/**
+	 * @brief Constructor
+	 * @param rtcAddress First RTC memory block (in 32-bit words) to use.
+	 * @param slotCount Number of hosts which may be stored, at most `maxSlots`
+	 * @note On the Esp8266 the slot count is reduced if necessary to fit the reserved area.
+	 * If `rtcAddress` lies outside that area then nothing is stored.
+	 */
+	RtcSessionStore(uint8_t rtcAddress = defaultRtcAddress, uint8_t slotCount = 1);
+
+	bool load(const String& hostName, SessionParameters& params) override;
+	bool save(const String& hostName, const SessionParameters& params) override;
+	void remove(const String& hostName) override;
+
+private:
+	bool readSlot(unsigned index, Record& rec);
+	bool writeSlot(unsigned index, const Record& rec);
+	int findSlot(uint32_t hostHash, Record& rec);
+
+	uint8_t rtcAddress;
+	uint8_t slotCount;
+};
+
+/**
+ * @brief Keeps session parameters in a flash partition
+ *
+ * Records are appended to the first erase block of the partition, so flash is only erased
+ * when that block fills up. At this point the block is erased and only the most recent
+ * record retained.
+ *
+ * A small custom data partition (one erase block) is sufficient.
+ */
+class PartitionSessionStore : public SessionStore
+{
+public:
+	PartitionSessionStore(Storage::Partition partition) : partition(partition)
+	{
+	}
+
+	bool load(const String& hostName, SessionParameters& params) override;
+	bool save(const String& hostName, const SessionParameters& params) override;
+	void remove(const String& hostName) override;
+
+private:
+	unsigned getCapacity() const;
+	bool append(const Record& rec);
+
+	Storage::Partition partition;
+};
+
+} // namespace Ssl
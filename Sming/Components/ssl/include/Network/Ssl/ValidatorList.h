@@ -16,6 +16,13 @@
 #include "Fingerprints.h"
 #include <WVector.h>
 
+/**
+ * @brief Number of successful certificate validations to remember, 0 to disable
+ */
+#ifndef SSL_VALIDATION_CACHE_SIZE
+#define SSL_VALIDATION_CACHE_SIZE 0
+#endif
+
 namespace Ssl
 {
 /**
@@ -32,6 +39,14 @@ namespace Ssl
 class ValidatorList : public Vector<Validator>
 {
 public:
+	ValidatorList()
+	{
+		if(SSL_VALIDATION_CACHE_SIZE != 0) {
+			// Cache is keyed by certificate fingerprint
+			fingerprintTypes.add(Fingerprint::Type::CertSha256);
+		}
+	}
+
 	/**
 	 * @brief Add a validator to the list
 	 * @param validator Must be allocated on the heap
@@ -77,6 +92,24 @@ public:
 	 */
 	bool validate(const Certificate* certificate);
 
+	/**
+	 * @brief Validate certificate, using a previous successful result if available
+	 * @param certificate
+	 * @param hostName Cached results only apply to connections with the same host name
+	 * @retval bool true on success, false on failure
+	 *
+	 * Successful results are cached, keyed by SHA256 fingerprint of the certificate, until the certificate expires.
+	 * The least recently used entry is discarded when the cache is full.
+	 * Has the same effect as `validate(certificate)` if SSL_VALIDATION_CACHE_SIZE is 0,
+	 * or the SSL adapter does not provide a SHA256 fingerprint.
+	 */
+	bool validate(const Certificate* certificate, const String& hostName);
+
+	/**
+	 * @brief Discard all cached validation results
+	 */
+	static void clearCache();
+
 	/**
 	 * @brief Contains a list of registered fingerprint types
 	 *
@@ -0,0 +1,204 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/SmingHub/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * BufferPool.cpp
+ *
+ ****/
+
+#include <SslDebug.h>
+#include <Network/Ssl/BufferPool.h>
+#include <Platform/System.h>
+#include <memory>
+
+namespace Ssl
+{
+namespace BufferPool
+{
+/*
+ * Connections waiting for a buffer, in order of arrival
+ */
+class WaitQueue
+{
+public:
+	void add(Waiter& waiter)
+	{
+		if(waiter.waiting) {
+			return;
+		}
+		waiter.next = nullptr;
+		waiter.waiting = true;
+		if(tail == nullptr) {
+			head = &waiter;
+		} else {
+			tail->next = &waiter;
+		}
+		tail = &waiter;
+		++count;
+	}
+
+	Waiter* front() const
+	{
+		return head;
+	}
+
+	void remove(Waiter& waiter)
+	{
+		if(!waiter.waiting) {
+			return;
+		}
+		Waiter* prev{nullptr};
+		for(auto w = head; w != nullptr; prev = w, w = w->next) {
+			if(w != &waiter) {
+				continue;
+			}
+			if(prev == nullptr) {
+				head = w->next;
+			} else {
+				prev->next = w->next;
+			}
+			if(tail == w) {
+				tail = prev;
+			}
+			break;
+		}
+		waiter.next = nullptr;
+		waiter.waiting = false;
+		--count;
+	}
+
+	bool isEmpty() const
+	{
+		return head == nullptr;
+	}
+
+	uint16_t count{0};
+
+private:
+	Waiter* head{nullptr};
+	Waiter* tail{nullptr};
+};
+
+namespace
+{
+uint8_t* pool;
+uint32_t freeMask; ///< One bit per buffer
+WaitQueue waitQueue;
+Stats stats;
+bool notifyPending;
+
+static_assert(SSL_BUFFER_POOL_COUNT <= 32, "SSL_BUFFER_POOL_COUNT too large");
+
+/*
+ * Runs from task queue so waiters are never resumed from within another connection
+ */
+void notifyWaiter(void*)
+{
+	notifyPending = false;
+	if(freeMask == 0) {
+		return;
+	}
+	auto waiter = waitQueue.front();
+	if(waiter == nullptr) {
+		return;
+	}
+	waiter->bufferAvailable();
+	if(waitQueue.front() == waiter) {
+		// Didn't take the buffer, so must not block others
+		waitQueue.remove(*waiter);
+		stats.waiting = waitQueue.count;
+	}
+	if(freeMask != 0 && !waitQueue.isEmpty() && !notifyPending) {
+		notifyPending = System.queueCallback(notifyWaiter);
+	}
+}
+
+} // namespace
+
+bool init()
+{
+	if(SSL_BUFFER_POOL_COUNT == 0) {
+		return false;
+	}
+	if(pool != nullptr) {
+		return true;
+	}
+	pool = new uint8_t[SSL_BUFFER_POOL_COUNT * SSL_BUFFER_POOL_SIZE];
+	if(pool == nullptr) {
+		debug_e("[SSL] Buffer pool allocation failed");
+		return false;
+	}
+	freeMask = (SSL_BUFFER_POOL_COUNT == 32) ? 0xffffffff : (1U << SSL_BUFFER_POOL_COUNT) - 1;
+	stats.count = SSL_BUFFER_POOL_COUNT;
+	debug_i("[SSL] Buffer pool %u x %u bytes", SSL_BUFFER_POOL_COUNT, SSL_BUFFER_POOL_SIZE);
+	return true;
+}
+
+uint8_t* allocate(size_t size, Waiter* waiter)
+{
+	if(size > SSL_BUFFER_POOL_SIZE || !init()) {
+		if(SSL_BUFFER_POOL_COUNT != 0) {
+			++stats.heapAllocs;
+			debug_w("[SSL] Buffer of %u bytes exceeds pool size", size);
+		}
+		return new uint8_t[size];
+	}
+
+	// Waiting connections are served in order
+	if(freeMask == 0 || (waiter != nullptr && !waitQueue.isEmpty() && waitQueue.front() != waiter)) {
+		// Join the back of the queue
+		if(waiter != nullptr) {
+			if(!waiter->waiting) {
+				++stats.waits;
+			}
+			waitQueue.add(*waiter);
+		}
+		stats.waiting = waitQueue.count;
+		return nullptr;
+	}
+
+	if(waiter != nullptr) {
+		waitQueue.remove(*waiter);
+	}
+	unsigned index = __builtin_ctz(freeMask);
+	freeMask &= ~(1U << index);
+	++stats.used;
+	if(stats.used > stats.maxUsed) {
+		stats.maxUsed = stats.used;
+	}
+	stats.waiting = waitQueue.count;
+	return &pool[index * SSL_BUFFER_POOL_SIZE];
+}
+
+void release(uint8_t* buffer)
+{
+	if(buffer == nullptr) {
+		return;
+	}
+	if(pool == nullptr || buffer < pool || buffer >= &pool[SSL_BUFFER_POOL_COUNT * SSL_BUFFER_POOL_SIZE]) {
+		delete[] buffer;
+		return;
+	}
+	unsigned index = (buffer - pool) / SSL_BUFFER_POOL_SIZE;
+	freeMask |= 1U << index;
+	--stats.used;
+	if(!waitQueue.isEmpty() && !notifyPending) {
+		notifyPending = System.queueCallback(notifyWaiter);
+	}
+}
+
+void cancel(Waiter& waiter)
+{
+	waitQueue.remove(waiter);
+	stats.waiting = waitQueue.count;
+}
+
+Stats getStats()
+{
+	return stats;
+}
+
+} // namespace BufferPool
+} // namespace Ssl
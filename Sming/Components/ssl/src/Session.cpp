@@ -15,8 +15,58 @@
 #include <Print.h>
 #include <Platform/Clocks.h>
 
+#ifdef ENABLE_HEAP_REGIONS
+#include <heap_region.h>
+#define SSL_HEAP_SCOPE() HeapRegionScope heapScope(HEAP_CLIENT_SSL)
+#else
+#define SSL_HEAP_SCOPE()
+#endif
+
 namespace Ssl
 {
+namespace
+{
+HandshakeStats handshakeStats;
+
+/*
+ * Hashes of host names which did not negotiate a reduced fragment length,
+ * replaced in round-robin order
+ */
+constexpr unsigned fragmentCacheSize{8};
+uint32_t fullSizeHosts[fragmentCacheSize];
+unsigned fullSizeNext;
+
+uint32_t getHostHash(const String& hostName)
+{
+	uint32_t hash{2166136261U};
+	for(auto c : hostName) {
+		hash = (hash ^ uint8_t(c)) * 16777619U;
+	}
+	return hash;
+}
+
+int findFullSizeHost(uint32_t hash)
+{
+	for(unsigned i = 0; i < fragmentCacheSize; ++i) {
+		if(fullSizeHosts[i] == hash) {
+			return i;
+		}
+	}
+	return -1;
+}
+
+} // namespace
+
+const HandshakeStats& getHandshakeStats()
+{
+	return handshakeStats;
+}
+
+void resetHandshakeStats()
+{
+	handshakeStats = HandshakeStats{};
+}
+
 String Options::toString() const
 {
 	String s;
@@ -33,6 +83,8 @@ String Options::toString() const
 	ADD(clientAuthentication);
 	ADD(verifyLater);
 	ADD(freeKeyCertAfterHandshake);
+	ADD(releaseIdleBuffer);
+	ADD(adaptiveBufferSize);
 
 #undef ADD
 
@@ -43,6 +95,8 @@ bool Session::onAccept(TcpConnection* client, tcp_pcb* tcp)
 {
 	debug_i("SSL %p onAccept(%p, %p)", this, client, tcp);
 
+	SSL_HEAP_SCOPE();
+
 	if(!keyCert.isValid()) {
 		debug_e("SSL: server certificate and key are not provided!");
 		return false;
@@ -73,6 +127,8 @@ bool Session::onConnect(tcp_pcb* tcp)
 {
 	debug_d("SSL %p: Starting connection...", this);
 
+	SSL_HEAP_SCOPE();
+
 	assert(connection == nullptr);
 	assert(context == nullptr);
 
@@ -90,7 +146,12 @@ bool Session::onConnect(tcp_pcb* tcp)
 		return false;
 	}
 
-	if(sessionId != nullptr && sessionId->isValid()) {
+	if(options.sessionResume) {
+		loadResumeParameters();
+	}
+
+	resumeOffered = (sessionId != nullptr && sessionId->isValid());
+	if(resumeOffered) {
 		debug_d("-----BEGIN SSL SESSION PARAMETERS-----");
 		debug_d("SessionId: %s", toString(*sessionId).c_str());
 		debug_d("------END SSL SESSION PARAMETERS------");
@@ -150,6 +211,7 @@ int Session::read(InputBuffer& input, uint8_t*& output)
 		debug_w("SSL: no connection");
 		return -1;
 	}
+	SSL_HEAP_SCOPE();
 	int len = connection->read(input, output);
 	if(len < 0) {
 		debug_w("SSL: Got error: %d (%s)", len, connection->getErrorString(len).c_str());
@@ -170,6 +232,7 @@ int Session::write(const uint8_t* data, size_t length)
 		return ERR_CONN;
 	}
 
+	SSL_HEAP_SCOPE();
 	int res = connection->write(data, length);
 	if(res < 0) {
 		debug_d("SSL: write returned %d (%s)", res, connection->getErrorString(res).c_str());
@@ -186,7 +249,7 @@ bool Session::validateCertificate()
 		return true;
 	}
 
-	if(validators.validate(connection->getCertificate())) {
+	if(validators.validate(connection->getCertificate(), hostName)) {
 		debug_i("SSL validation passed, heap free = %u", system_get_free_heap_size());
 		return true;
 	}
@@ -200,22 +263,130 @@ void Session::handshakeComplete(bool success)
 	endHandshake();
 
 	if(success) {
-		// If requested, take a copy of the session ID for later re-use
-		if(options.sessionResume) {
+		SessionId newId;
+		if(connection != nullptr) {
+			newId = connection->getSessionId();
+		}
+		bool resumed = resumeOffered && *sessionId == newId;
+		if(resumed) {
+			++handshakeStats.resumed;
+		} else {
+			++handshakeStats.full;
+		}
+		debug_i("SSL: Handshake %s", resumed ? "resumed" : "full");
+
+		// If requested, take a copy of the session ID and parameters for later re-use
+		if(options.sessionResume && connection != nullptr) {
 			if(sessionId == nullptr) {
 				sessionId = new SessionId;
 			}
-			*sessionId = connection->getSessionId();
+			*sessionId = newId;
+
+			SessionParameters params;
+			if(!resumed && connection->getSessionParameters(params)) {
+				if(resumeParameters == nullptr) {
+					resumeParameters = new SessionParameters;
+				}
+				*resumeParameters = params;
+				if(store != nullptr && !store->save(hostName, params)) {
+					debug_w("SSL: Failed to store session parameters");
+				}
+			}
 		}
 	} else {
 		debug_w("SSL Handshake failed");
+		++handshakeStats.failed;
+		if(resumeOffered) {
+			// Don't try to resume this session again
+			discardResumeParameters();
+		}
 	}
 
+	updateFragmentLengthCache(success);
+	resumeOffered = false;
+
 	if(options.freeKeyCertAfterHandshake && connection != nullptr) {
 		connection->freeCertificate();
 	}
 }
 
+bool Session::loadResumeParameters()
+{
+	if(resumeParameters != nullptr) {
+		return true;
+	}
+
+	if(store == nullptr) {
+		return false;
+	}
+
+	SessionParameters params;
+	if(!store->load(hostName, params)) {
+		return false;
+	}
+
+	resumeParameters = new SessionParameters(params);
+	if(sessionId == nullptr) {
+		sessionId = new SessionId;
+	}
+	sessionId->assign(params.id, params.idLength);
+	debug_d("SSL: Loaded stored session for '%s'", hostName.c_str());
+	return true;
+}
+
+void Session::discardResumeParameters()
+{
+	delete resumeParameters;
+	resumeParameters = nullptr;
+	delete sessionId;
+	sessionId = nullptr;
+	if(store != nullptr) {
+		store->remove(hostName);
+	}
+}
+
+MaxBufferSize Session::getBufferSize() const
+{
+	if(options.adaptiveBufferSize && maxBufferSize != MaxBufferSize::Default && hostName &&
+	   findFullSizeHost(getHostHash(hostName)) >= 0) {
+		return MaxBufferSize::K16;
+	}
+	return maxBufferSize;
+}
+
+/*
+ * Remember servers which don't accept a reduced fragment length, and so may send records too large for the buffer
+ */
+void Session::updateFragmentLengthCache(bool success)
+{
+	if(!options.adaptiveBufferSize || !hostName || maxBufferSize == MaxBufferSize::Default ||
+	   maxBufferSize == MaxBufferSize::K16) {
+		return;
+	}
+
+	bool fullSize;
+	if(success) {
+		int length = (connection != nullptr) ? connection->getMaxFragmentLength() : -1;
+		if(length < 0) {
+			return;
+		}
+		fullSize = (length == 0);
+	} else {
+		// Failure may be due to the server sending a record which is too large
+		fullSize = true;
+	}
+
+	auto hash = getHostHash(hostName);
+	int index = findFullSizeHost(hash);
+	if(fullSize && index < 0) {
+		debug_i("SSL: '%s' requires full-size buffers", hostName.c_str());
+		fullSizeHosts[fullSizeNext] = hash;
+		fullSizeNext = (fullSizeNext + 1) % fragmentCacheSize;
+	} else if(!fullSize && index >= 0) {
+		fullSizeHosts[index] = 0;
+	}
+}
+
 size_t Session::printTo(Print& p) const
 {
 	size_t n = 0;
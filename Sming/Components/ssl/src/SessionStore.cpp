@@ -0,0 +1,251 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/SmingHub/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * SessionStore.cpp
+ *
+ ****/
+
+#include <SslDebug.h>
+#include <Network/Ssl/SessionStore.h>
+#include <esp_systemapi.h>
+
+#ifdef ARCH_ESP32
+#include <esp_attr.h>
+#endif
+
+#ifdef ARCH_ESP8266
+#include <esp_rtc_map.h>
+static_assert(Ssl::RtcSessionStore::defaultRtcAddress == RTC_MAP_SSL_SESSION_ADDR,
+			  "RtcSessionStore default address does not match RTC map");
+#endif
+
+namespace
+{
+constexpr uint32_t recordMagic{0x53534c31}; // "SSL1"
+constexpr uint32_t erasedMagic{0xffffffff};
+
+uint32_t fnv1a(uint32_t hash, const void* data, size_t length)
+{
+	auto p = static_cast<const uint8_t*>(data);
+	while(length-- != 0) {
+		hash = (hash ^ *p++) * 16777619U;
+	}
+	return hash;
+}
+
+constexpr uint32_t fnvBasis{2166136261U};
+
+} // namespace
+
+namespace Ssl
+{
+/* SessionStore */
+
+void SessionStore::Record::init(uint32_t hostHash, const SessionParameters& params)
+{
+	magic = recordMagic;
+	this->hostHash = hostHash;
+	this->params = params;
+	checksum = fnv1a(fnvBasis, this, offsetof(Record, checksum));
+}
+
+bool SessionStore::Record::isValid() const
+{
+	return magic == recordMagic && checksum == fnv1a(fnvBasis, this, offsetof(Record, checksum));
+}
+
+uint32_t SessionStore::getHostHash(const String& hostName)
+{
+	return fnv1a(fnvBasis, hostName.c_str(), hostName.length());
+}
+
+/* RtcSessionStore */
+
+#ifndef ARCH_ESP8266
+namespace
+{
+#ifdef ARCH_ESP32
+RTC_NOINIT_ATTR
+#endif
+uint8_t rtcBuffer[RtcSessionStore::maxSlots * sizeof(SessionStore::Record)];
+} // namespace
+#endif
+
+RtcSessionStore::RtcSessionStore(uint8_t rtcAddress, uint8_t slotCount)
+	: rtcAddress(rtcAddress), slotCount(slotCount < maxSlots ? slotCount : uint8_t(maxSlots))
+{
+#ifdef ARCH_ESP8266
+	constexpr unsigned slotWords = sizeof(Record) / 4;
+	unsigned available = 0;
+	if(rtcAddress >= RTC_MAP_SSL_SESSION_ADDR && rtcAddress < RTC_MAP_SSL_SESSION_END) {
+		available = (RTC_MAP_SSL_SESSION_END - rtcAddress) / slotWords;
+	}
+	if(this->slotCount > available) {
+		debug_w("[SSL] RTC session store at %u has room for %u of %u slots", rtcAddress, available,
+				this->slotCount);
+		this->slotCount = available;
+	}
+#endif
+}
+
+bool RtcSessionStore::readSlot(unsigned index, Record& rec)
+{
+#ifdef ARCH_ESP8266
+	uint8_t addr = rtcAddress + index * (sizeof(Record) / 4);
+	if(!system_rtc_mem_read(addr, &rec, sizeof(Record))) {
+		return false;
+	}
+#else
+	memcpy(&rec, &rtcBuffer[index * sizeof(Record)], sizeof(Record));
+#endif
+	return rec.isValid();
+}
+
+bool RtcSessionStore::writeSlot(unsigned index, const Record& rec)
+{
+#ifdef ARCH_ESP8266
+	uint8_t addr = rtcAddress + index * (sizeof(Record) / 4);
+	return system_rtc_mem_write(addr, &rec, sizeof(Record));
+#else
+	memcpy(&rtcBuffer[index * sizeof(Record)], &rec, sizeof(Record));
+	return true;
+#endif
+}
+
+int RtcSessionStore::findSlot(uint32_t hostHash, Record& rec)
+{
+	for(unsigned i = 0; i < slotCount; ++i) {
+		if(readSlot(i, rec) && rec.hostHash == hostHash) {
+			return i;
+		}
+	}
+	return -1;
+}
+
+bool RtcSessionStore::load(const String& hostName, SessionParameters& params)
+{
+	Record rec;
+	if(findSlot(getHostHash(hostName), rec) < 0 || !rec.params.isValid()) {
+		return false;
+	}
+	params = rec.params;
+	return true;
+}
+
+bool RtcSessionStore::save(const String& hostName, const SessionParameters& params)
+{
+	if(slotCount == 0) {
+		return false;
+	}
+
+	auto hostHash = getHostHash(hostName);
+	Record rec;
+	int slot = findSlot(hostHash, rec);
+	if(slot < 0) {
+		// Use a free slot if there is one, otherwise replace an existing entry
+		slot = hostHash % slotCount;
+		for(unsigned i = 0; i < slotCount; ++i) {
+			if(!readSlot(i, rec)) {
+				slot = i;
+				break;
+			}
+		}
+	}
+
+	rec.init(hostHash, params);
+	return writeSlot(slot, rec);
+}
+
+void RtcSessionStore::remove(const String& hostName)
+{
+	Record rec;
+	int slot = findSlot(getHostHash(hostName), rec);
+	if(slot >= 0) {
+		rec.magic = 0;
+		writeSlot(slot, rec);
+	}
+}
+
+/* PartitionSessionStore */
+
+unsigned PartitionSessionStore::getCapacity() const
+{
+	size_t size = partition.getBlockSize();
+	if(size == 0 || size > partition.size()) {
+		size = partition.size();
+	}
+	return size / sizeof(Record);
+}
+
+bool PartitionSessionStore::append(const Record& rec)
+{
+	if(!partition) {
+		return false;
+	}
+
+	auto capacity = getCapacity();
+	for(unsigned i = 0; i < capacity; ++i) {
+		uint32_t magic;
+		if(!partition.read(i * sizeof(Record), &magic, sizeof(magic))) {
+			return false;
+		}
+		if(magic == erasedMagic) {
+			return partition.write(i * sizeof(Record), &rec, sizeof(Record));
+		}
+	}
+
+	// Log is full
+	debug_d("[SSL] Erasing session store");
+	if(!partition.erase_range(0, partition.getBlockSize())) {
+		return false;
+	}
+	return partition.write(0, &rec, sizeof(Record));
+}
+
+bool PartitionSessionStore::load(const String& hostName, SessionParameters& params)
+{
+	if(!partition) {
+		return false;
+	}
+
+	// Most recent entry wins
+	auto hostHash = getHostHash(hostName);
+	bool found{false};
+	auto capacity = getCapacity();
+	for(unsigned i = 0; i < capacity; ++i) {
+		Record rec;
+		if(!partition.read(i * sizeof(Record), &rec, sizeof(Record)) || rec.magic == erasedMagic) {
+			break;
+		}
+		if(rec.isValid() && rec.hostHash == hostHash) {
+			params = rec.params;
+			found = params.isValid();
+		}
+	}
+
+	return found;
+}
+
+bool PartitionSessionStore::save(const String& hostName, const SessionParameters& params)
+{
+	Record rec;
+	rec.init(getHostHash(hostName), params);
+	return append(rec);
+}
+
+void PartitionSessionStore::remove(const String& hostName)
+{
+	SessionParameters params;
+	if(!load(hostName, params)) {
+		return;
+	}
+
+	// Invalidated entry masks any earlier ones
+	params.idLength = 0;
+	save(hostName, params);
+}
+
+} // namespace Ssl
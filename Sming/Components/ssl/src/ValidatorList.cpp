@@ -12,9 +12,106 @@
 
 #include <Network/Ssl/ValidatorList.h>
 #include <debug_progmem.h>
+#include <SystemClock.h>
 
 namespace Ssl
 {
+namespace
+{
+#if SSL_VALIDATION_CACHE_SIZE
+struct CacheEntry {
+	Crypto::Sha256::Hash hash;
+	uint32_t hostHash;
+	uint32_t lastUsed; ///< For LRU replacement
+	time_t expiry;
+};
+
+CacheEntry cache[SSL_VALIDATION_CACHE_SIZE];
+uint32_t useCount;
+
+uint32_t getHostHash(const String& hostName)
+{
+	uint32_t hash{2166136261U};
+	for(auto c : hostName) {
+		hash = (hash ^ uint8_t(c)) * 16777619U;
+	}
+	return hash;
+}
+
+CacheEntry* findEntry(const Crypto::Sha256::Hash& hash, uint32_t hostHash)
+{
+	for(auto& entry : cache) {
+		if(entry.expiry != 0 && entry.hostHash == hostHash && entry.hash == hash) {
+			return &entry;
+		}
+	}
+	return nullptr;
+}
+
+CacheEntry& getFreeEntry()
+{
+	CacheEntry* lru = &cache[0];
+	for(auto& entry : cache) {
+		if(entry.expiry == 0) {
+			return entry;
+		}
+		if(entry.lastUsed < lru->lastUsed) {
+			lru = &entry;
+		}
+	}
+	return *lru;
+}
+#endif
+
+} // namespace
+
+bool ValidatorList::validate(const Certificate* certificate, const String& hostName)
+{
+#if SSL_VALIDATION_CACHE_SIZE
+	Fingerprint::Cert::Sha256 fp;
+	if(certificate == nullptr || !certificate->getFingerprint(fp.type, reinterpret_cast<Fingerprint&>(fp))) {
+		return validate(certificate);
+	}
+
+	auto hostHash = getHostHash(hostName);
+	auto now = SystemClock.isSet() ? SystemClock.now(eTZ_UTC) : 0;
+	auto entry = findEntry(fp.hash, hostHash);
+	if(entry != nullptr) {
+		if(now < entry->expiry) {
+			debug_i("SSL validator: Cached");
+			entry->lastUsed = ++useCount;
+			removeAllElements();
+			return true;
+		}
+		// Expired, so validate again
+		*entry = CacheEntry{};
+	}
+
+	if(!validate(certificate)) {
+		return false;
+	}
+
+	auto expiry = certificate->getNotAfter();
+	if(expiry > now) {
+		auto& newEntry = getFreeEntry();
+		newEntry = CacheEntry{fp.hash, hostHash, ++useCount, expiry};
+	}
+	return true;
+#else
+	(void)hostName;
+	return validate(certificate);
+#endif
+}
+
+void ValidatorList::clearCache()
+{
+#if SSL_VALIDATION_CACHE_SIZE
+	for(auto& entry : cache) {
+		entry = CacheEntry{};
+	}
+#endif
+}
+
 bool ValidatorList::validate(const Certificate* certificate)
 {
 	if(certificate == nullptr) {
@@ -0,0 +1,117 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/SmingHub/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * AdcSampler.cpp
+ *
+ ****/
+
+#include "AdcSampler.h"
+#include <Platform/System.h>
+#include <debug_progmem.h>
+
+/*
+ * A queued callback cannot be cancelled, so it refers to the sampler indirectly.
+ * The token is allocated in begin() as blocks may complete in interrupt context.
+ * If sampling stops whilst a callback is pending the reference is cleared
+ * and the callback releases the token.
+ */
+struct AdcSampler::Task {
+	AdcSampler* sampler;
+};
+
+bool AdcSampler::begin(uint16_t pin, uint32_t sampleRate, size_t blockSize, Callback callback)
+{
+	end();
+
+	if(sampleRate == 0 || blockSize == 0 || !callback) {
+		return false;
+	}
+
+	task = new Task{this};
+	if(task == nullptr) {
+		return false;
+	}
+
+	buffer = new Sample[2 * blockSize];
+	if(buffer == nullptr) {
+		delete task;
+		task = nullptr;
+		return false;
+	}
+
+	this->blockSize = blockSize;
+	this->sampleRate = sampleRate;
+	this->callback = callback;
+	readyBlock = -1;
+	resetStats();
+
+	if(!hardwareBegin(pin)) {
+		debug_e("[ADC] Sampling not available for pin %u", pin);
+		delete[] buffer;
+		buffer = nullptr;
+		delete task;
+		task = nullptr;
+		return false;
+	}
+
+	return true;
+}
+
+void AdcSampler::end()
+{
+	if(buffer == nullptr) {
+		return;
+	}
+
+	hardwareEnd();
+
+	if(readyBlock >= 0) {
+		// Callback pending or in progress, which releases the token
+		task->sampler = nullptr;
+	} else {
+		delete task;
+	}
+	task = nullptr;
+
+	delete[] buffer;
+	buffer = nullptr;
+	readyBlock = -1;
+}
+
+void AdcSampler::blockComplete(unsigned index)
+{
+	if(readyBlock >= 0) {
+		// Callback hasn't finished with previous block
+		++stats.overruns;
+		return;
+	}
+
+	readyBlock = index;
+	if(!System.queueCallback(taskCallback, task)) {
+		readyBlock = -1;
+		++stats.overruns;
+	}
+}
+
+void AdcSampler::taskCallback(void* param)
+{
+	auto task = static_cast<Task*>(param);
+	auto sampler = task->sampler;
+	if(sampler == nullptr) {
+		delete task;
+		return;
+	}
+
+	sampler->callback(sampler->getBlock(sampler->readyBlock), sampler->blockSize);
+
+	// Sampler may have been stopped or destroyed by the callback
+	if(task->sampler == nullptr) {
+		delete task;
+		return;
+	}
+	++sampler->stats.blocks;
+	sampler->readyBlock = -1;
+}
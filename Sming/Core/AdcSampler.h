@@ -0,0 +1,142 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/SmingHub/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * AdcSampler.h - Continuous ADC sampling into double buffers
+ *
+ ****/
+
+#pragma once
+
+#include <Delegate.h>
+#include <esp_systemapi.h>
+
+/**
+ * @brief Samples an analogue input continuously at a fixed rate
+ *
+ * Two buffers of `blockSize` samples are filled alternately by the hardware, using DMA where available.
+ * Each time a block is completed it is passed to the application callback in task context,
+ * whilst the hardware fills the other buffer.
+ *
+ * The callback must therefore finish with a block within one block period.
+ * If it has not finished when the next block completes, that block is discarded and counted as an overrun.
+ *
+ * Samples are raw, right-aligned ADC values. For FFT processing, copy each block into the
+ * real input array and run the transform from the callback:
+ *
+ * 		void blockReady(const AdcSampler::Sample* samples, size_t count)
+ * 		{
+ * 			for(unsigned i = 0; i < count; ++i) {
+ * 				vReal[i] = samples[i];
+ * 				vImag[i] = 0;
+ * 			}
+ * 			FFT.Compute(vReal, vImag, count, FFT_FORWARD);
+ * 		}
+ *
+ * Architecture support:
+ *
+ * - Esp32: I2S DMA via the built-in ADC mode, for ADC1 pins on the original ESP32 only
+ * - Rp2040: ADC FIFO with two chained DMA channels
+ * - Esp8266: Hardware timer interrupt, limited by `system_adc_read()` to a few kHz
+ * - Host: Simulated using a software timer
+ *
+ * Only one sampler may be active at a time.
+ */
+class AdcSampler
+{
+public:
+	using Sample = uint16_t;
+
+	/**
+	 * @brief Callback invoked in task context with a full block of samples
+	 * @param samples Valid only until callback returns
+	 * @param count Number of samples in block
+	 */
+	using Callback = Delegate<void(const Sample* samples, size_t count)>;
+
+	struct Stats {
+		uint32_t blocks;   ///< Blocks passed to callback
+		uint32_t overruns; ///< Blocks discarded because callback hadn't finished with the previous one
+	};
+
+	~AdcSampler()
+	{
+		end();
+	}
+
+	/**
+	 * @brief Start sampling
+	 * @param pin Analogue input pin
+	 * @param sampleRate Requested rate in Hz, see getSampleRate()
+	 * @param blockSize Number of samples per block
+	 * @param callback Invoked for every completed block
+	 * @retval bool true on success
+	 */
+	bool begin(uint16_t pin, uint32_t sampleRate, size_t blockSize, Callback callback);
+
+	/**
+	 * @brief Stop sampling and release buffers
+	 */
+	void end();
+
+	bool isRunning() const
+	{
+		return buffer != nullptr;
+	}
+
+	/**
+	 * @brief Get the actual sample rate, which may differ slightly from that requested
+	 */
+	uint32_t getSampleRate() const
+	{
+		return sampleRate;
+	}
+
+	size_t getBlockSize() const
+	{
+		return blockSize;
+	}
+
+	const Stats& getStats() const
+	{
+		return stats;
+	}
+
+	void resetStats()
+	{
+		stats = {};
+	}
+
+private:
+	/*
+	 * Architecture-specific implementation, in Arch/{SMING_ARCH}/Core/AdcSampler.cpp.
+	 * hardwareBegin() may adjust sampleRate to the rate actually achieved.
+	 */
+	bool hardwareBegin(uint16_t pin);
+	void hardwareEnd();
+	static void IRAM_ATTR hardwareInterrupt(void* param);
+
+	__forceinline Sample* IRAM_ATTR getBlock(unsigned index)
+	{
+		return &buffer[index * blockSize];
+	}
+
+	/*
+	 * Called by hardware layer when a block has been filled, from interrupt or driver task context.
+	 */
+	void IRAM_ATTR blockComplete(unsigned index);
+
+	struct Task;
+
+	static void taskCallback(void* param);
+
+	Callback callback;
+	Task* task{nullptr}; ///< Passed to queued callbacks, outlives sampler if a callback is pending
+	Sample* buffer{nullptr};
+	size_t blockSize{0};
+	uint32_t sampleRate{0};
+	Stats stats{};
+	volatile int8_t readyBlock{-1}; ///< Block pending or being processed by callback
+};
@@ -0,0 +1,246 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/SmingHub/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * CoalescedTimer.cpp
+ *
+ * Timers are kept in a ring of buckets, each spanning COALESCED_TIMER_SLACK milliseconds.
+ * Timers due beyond the end of the ring go into the last bucket and are re-inserted when it
+ * is reached. A bitmap of occupied buckets allows the next one to be found directly.
+ *
+ ****/
+
+#include "CoalescedTimer.h"
+#include "SimpleTimer.h"
+#include "Clock.h"
+#include <Services/Profiling/Trace.h>
+
+static_assert(COALESCED_TIMER_SLACK > 0, "COALESCED_TIMER_SLACK must be non-zero");
+
+class CoalescedTimerQueue
+{
+public:
+	static constexpr unsigned bucketCount{64};
+	static constexpr uint32_t slack{COALESCED_TIMER_SLACK};
+
+	using Timer = CoalescedTimer;
+
+	void insert(Timer& timer);
+	void remove(Timer& timer);
+
+	/*
+	 * Get the time a bucket is due, relative to base
+	 */
+	uint32_t getBucketTime(unsigned bucket) const
+	{
+		return ((bucket - baseIndex) % bucketCount) * slack;
+	}
+
+	uint32_t getBaseTime() const
+	{
+		return baseTime;
+	}
+
+private:
+	void link(Timer& timer, unsigned bucket);
+	bool findNext(unsigned& dist) const;
+	void expire(unsigned bucket, uint32_t now);
+	void schedule();
+	void service();
+
+	static void serviceCallback(void* arg)
+	{
+		static_cast<CoalescedTimerQueue*>(arg)->service();
+	}
+
+	Timer* buckets[bucketCount]{};
+	uint64_t bitmap{0}; ///< Bit set for each occupied bucket
+	SimpleTimer timer;
+	uint32_t baseTime{0}; ///< Start time of the current bucket, a multiple of slack
+	uint32_t nextDue{0};  ///< When timer is due to fire
+	uint8_t baseIndex{0}; ///< Index of the current bucket
+	bool scheduled{false};
+	bool servicing{false};
+};
+
+namespace
+{
+CoalescedTimerQueue queue;
+}
+
+void CoalescedTimerQueue::link(Timer& timer, unsigned bucket)
+{
+	auto& head = buckets[bucket];
+	timer.next = head;
+	if(head != nullptr) {
+		head->pprev = &timer.next;
+	}
+	head = &timer;
+	timer.pprev = &head;
+	timer.bucket = bucket;
+	bitmap |= uint64_t(1) << bucket;
+}
+
+void CoalescedTimerQueue::insert(Timer& timer)
+{
+	if(bitmap == 0 && !servicing) {
+		uint32_t now = millis();
+		baseTime = now - (now % slack);
+	}
+
+	// Round up to the end of a bucket so timer never fires early
+	uint32_t dist{0};
+	int delta = timer.expire - baseTime;
+	if(delta > 0) {
+		dist = (uint32_t(delta) + slack - 1) / slack;
+		if(dist >= bucketCount) {
+			dist = bucketCount - 1;
+		}
+	}
+
+	link(timer, (baseIndex + dist) % bucketCount);
+
+	if(!servicing && (!scheduled || int(baseTime + dist * slack - nextDue) < 0)) {
+		schedule();
+	}
+}
+
+void CoalescedTimerQueue::remove(Timer& timer)
+{
+	*timer.pprev = timer.next;
+	if(timer.next != nullptr) {
+		timer.next->pprev = timer.pprev;
+	}
+	timer.next = nullptr;
+	timer.pprev = nullptr;
+
+	if(buckets[timer.bucket] == nullptr) {
+		bitmap &= ~(uint64_t(1) << timer.bucket);
+		if(bitmap == 0 && scheduled && !servicing) {
+			this->timer.stop();
+			scheduled = false;
+		}
+	}
+}
+
+bool CoalescedTimerQueue::findNext(unsigned& dist) const
+{
+	if(bitmap == 0) {
+		return false;
+	}
+
+	auto bits = bitmap;
+	if(baseIndex != 0) {
+		bits = (bits >> baseIndex) | (bits << (bucketCount - baseIndex));
+	}
+	dist = __builtin_ctzll(bits);
+	return true;
+}
+
+void CoalescedTimerQueue::expire(unsigned bucket, uint32_t now)
+{
+	Timer* list = buckets[bucket];
+	buckets[bucket] = nullptr;
+	bitmap &= ~(uint64_t(1) << bucket);
+	if(list == nullptr) {
+		return;
+	}
+
+	// Detach bucket so callbacks can safely start, stop or destroy any timer
+	list->pprev = &list;
+	while(auto t = list) {
+		*t->pprev = t->next;
+		if(t->next != nullptr) {
+			t->next->pprev = t->pprev;
+		}
+		t->next = nullptr;
+		t->pprev = nullptr;
+
+		if(int(t->expire - now) > 0) {
+			// Restarted, or beyond range of the ring
+			insert(*t);
+			continue;
+		}
+
+		if(t->callback != nullptr) {
+			TRACE_SCOPE("coalesced-timer", t);
+			t->callback(t->arg);
+		}
+	}
+}
+
+void CoalescedTimerQueue::schedule()
+{
+	unsigned dist;
+	if(!findNext(dist)) {
+		if(scheduled) {
+			timer.stop();
+			scheduled = false;
+		}
+		return;
+	}
+
+	nextDue = baseTime + dist * slack;
+	int ms = nextDue - millis();
+	timer.initializeMs((ms > 0) ? ms : 1, serviceCallback, this).startOnce();
+	scheduled = true;
+}
+
+void CoalescedTimerQueue::service()
+{
+	scheduled = false;
+	servicing = true;
+
+	uint32_t now = millis();
+	unsigned dist;
+	while(findNext(dist) && dist * slack <= now - baseTime) {
+		baseTime += dist * slack;
+		baseIndex = (baseIndex + dist) % bucketCount;
+		expire(baseIndex, now);
+	}
+
+	// Move to current bucket; any remaining timers are due later
+	uint32_t steps = (now - baseTime) / slack;
+	baseTime += steps * slack;
+	baseIndex = (baseIndex + steps) % bucketCount;
+
+	servicing = false;
+	schedule();
+}
+
+void CoalescedTimer::start(uint32_t milliseconds)
+{
+	uint32_t newExpire = millis() + milliseconds;
+
+	if(isStarted()) {
+		// Leave in place if bucket is due before new expiry time; it gets moved when serviced
+		int diff = newExpire - (queue.getBaseTime() + queue.getBucketTime(bucket));
+		if(diff >= 0) {
+			expire = newExpire;
+			return;
+		}
+		queue.remove(*this);
+	}
+
+	expire = newExpire;
+	queue.insert(*this);
+}
+
+void CoalescedTimer::stop()
+{
+	if(isStarted()) {
+		queue.remove(*this);
+	}
+}
+
+uint32_t CoalescedTimer::remaining() const
+{
+	if(!isStarted()) {
+		return 0;
+	}
+
+	int ms = expire - millis();
+	return (ms > 0) ? ms : 0;
+}
@@ -0,0 +1,100 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/SmingHub/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * CoalescedTimer.h - Low-resolution timers which expire in batches
+ *
+ ****/
+
+#pragma once
+
+#include "CallbackTimer.h"
+
+/**
+ * @brief Granularity of coalesced timers, in milliseconds
+ *
+ * Expiry times are rounded up to a multiple of this value, so a timer may fire late by up to this amount.
+ */
+#ifndef COALESCED_TIMER_SLACK
+#define COALESCED_TIMER_SLACK 250
+#endif
+
+/**
+ * @defgroup coalesced_timer CoalescedTimer
+ * @brief Low-resolution timers which expire in batches
+ * @ingroup timers
+ * @{
+ */
+
+/**
+ * @brief One-shot timer intended for timeouts where precision is not important
+ *
+ * All coalesced timers share a single `SimpleTimer`. Expiry times are rounded up to the
+ * next multiple of `COALESCED_TIMER_SLACK`, so timers due at about the same time are
+ * all expired together in one pass. This means far fewer wake-ups where there are many
+ * timers, such as idle timeouts for a large number of network connections.
+ *
+ * Restarting a timer with a later expiry time, as happens on each new activity for an
+ * idle timeout, just records the new time: the timer is moved when its original time
+ * is reached.
+ *
+ * Callbacks execute in the task context.
+ */
+class CoalescedTimer
+{
+public:
+	CoalescedTimer()
+	{
+	}
+
+	CoalescedTimer(const CoalescedTimer&) = delete;
+
+	~CoalescedTimer()
+	{
+		stop();
+	}
+
+	/**
+	 * @brief Set the callback function
+	 * @param callback Invoked on expiry. The timer may be restarted or destroyed from here.
+	 * @param arg Argument passed to callback
+	 */
+	void setCallback(TimerCallback callback, void* arg = nullptr)
+	{
+		this->callback = callback;
+		this->arg = arg;
+	}
+
+	/**
+	 * @brief Start, or restart, the timer
+	 * @param milliseconds Time from now until expiry
+	 */
+	void start(uint32_t milliseconds);
+
+	void stop();
+
+	bool isStarted() const
+	{
+		return pprev != nullptr;
+	}
+
+	/**
+	 * @brief Get time remaining until expiry
+	 * @retval uint32_t Milliseconds, 0 if not started
+	 */
+	uint32_t remaining() const;
+
+private:
+	friend class CoalescedTimerQueue;
+
+	CoalescedTimer* next{nullptr};
+	CoalescedTimer** pprev{nullptr}; ///< Link which points to this timer, nullptr if not started
+	TimerCallback callback{nullptr};
+	void* arg{nullptr};
+	uint32_t expire{0}; ///< System time in milliseconds when timer is due
+	uint8_t bucket{0};
+};
+
+/** @} */
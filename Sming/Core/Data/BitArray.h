@@ -0,0 +1,615 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/SmingHub/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * BitArray.h - Large sets of bits operated on a word at a time
+ *
+ ****/
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+#include <memory>
+#include <FakePgmSpace.h>
+
+/**
+ * @brief Read-only operations for an array of bits stored in 32-bit words
+ *
+ * Derived classes must provide `size()` and `getWord(index)`.
+ * Unused bits in the final word must always be zero.
+ */
+template <class Derived> class BitArrayConstMethods
+{
+public:
+	using Word = uint32_t;
+	static constexpr size_t wordBits{sizeof(Word) * 8};
+
+	/**
+	 * @brief Get number of words required to store the given number of bits
+	 */
+	static constexpr size_t wordCount(size_t bitCount)
+	{
+		return (bitCount + wordBits - 1) / wordBits;
+	}
+
+	/**
+	 * @brief Iterates through positions of set bits
+	 */
+	class Iterator
+	{
+	public:
+		Iterator(const Derived& array, size_t pos) : array(array), pos(pos)
+		{
+		}
+
+		size_t operator*() const
+		{
+			return pos;
+		}
+
+		Iterator& operator++()
+		{
+			pos = array.findNext(pos);
+			return *this;
+		}
+
+		bool operator==(const Iterator& rhs) const
+		{
+			return pos == rhs.pos;
+		}
+
+		bool operator!=(const Iterator& rhs) const
+		{
+			return pos != rhs.pos;
+		}
+
+	private:
+		const Derived& array;
+		size_t pos;
+	};
+
+	Iterator begin() const
+	{
+		return Iterator(self(), findFirst());
+	}
+
+	Iterator end() const
+	{
+		return Iterator(self(), self().size());
+	}
+
+	/**
+	 * @brief Determine if given bit is set
+	 */
+	bool test(size_t pos) const
+	{
+		return pos < self().size() && (self().getWord(pos / wordBits) & bitMask(pos)) != 0;
+	}
+
+	bool operator[](size_t pos) const
+	{
+		return test(pos);
+	}
+
+	/**
+	 * @brief Get the number of bits set to 1
+	 */
+	size_t count() const
+	{
+		size_t n{0};
+		for(size_t i = 0; i < words(); ++i) {
+			n += __builtin_popcount(self().getWord(i));
+		}
+		return n;
+	}
+
+	/**
+	 * @brief Determine if any bits are set
+	 */
+	bool any() const
+	{
+		for(size_t i = 0; i < words(); ++i) {
+			if(self().getWord(i) != 0) {
+				return true;
+			}
+		}
+		return false;
+	}
+
+	/**
+	 * @brief Determine if no bits are set
+	 */
+	bool none() const
+	{
+		return !any();
+	}
+
+	/**
+	 * @brief Determine if all bits are set
+	 */
+	bool all() const
+	{
+		auto n = words();
+		if(n == 0) {
+			return true;
+		}
+		for(size_t i = 0; i + 1 < n; ++i) {
+			if(self().getWord(i) != ~Word(0)) {
+				return false;
+			}
+		}
+		return self().getWord(n - 1) == lastWordMask();
+	}
+
+	/**
+	 * @brief Get position of first set bit
+	 * @retval size_t `size()` if no bits are set
+	 */
+	size_t findFirst() const
+	{
+		return find(0);
+	}
+
+	/**
+	 * @brief Get position of next set bit
+	 * @param pos Previous position
+	 * @retval size_t `size()` if no bits are set after pos
+	 */
+	size_t findNext(size_t pos) const
+	{
+		return find(pos + 1);
+	}
+
+	template <class Other> bool operator==(const BitArrayConstMethods<Other>& other) const
+	{
+		auto& rhs = static_cast<const Other&>(other);
+		if(rhs.size() != self().size()) {
+			return false;
+		}
+		for(size_t i = 0; i < words(); ++i) {
+			if(self().getWord(i) != rhs.getWord(i)) {
+				return false;
+			}
+		}
+		return true;
+	}
+
+	template <class Other> bool operator!=(const BitArrayConstMethods<Other>& other) const
+	{
+		return !operator==(other);
+	}
+
+protected:
+	static constexpr Word bitMask(size_t pos)
+	{
+		return Word(1) << (pos % wordBits);
+	}
+
+	/**
+	 * @brief Mask for valid bits in the final word
+	 */
+	Word lastWordMask() const
+	{
+		auto n = self().size() % wordBits;
+		return (n == 0) ? ~Word(0) : (Word(1) << n) - 1;
+	}
+
+	size_t words() const
+	{
+		return wordCount(self().size());
+	}
+
+	/**
+	 * @brief Find first set bit at or after given position
+	 */
+	size_t find(size_t pos) const
+	{
+		auto size = self().size();
+		if(pos >= size) {
+			return size;
+		}
+		size_t i = pos / wordBits;
+		Word w = self().getWord(i) & (~Word(0) << (pos % wordBits));
+		auto n = words();
+		while(w == 0) {
+			if(++i >= n) {
+				return size;
+			}
+			w = self().getWord(i);
+		}
+		return (i * wordBits) + __builtin_ctz(w);
+	}
+
+private:
+	const Derived& self() const
+	{
+		return *static_cast<const Derived*>(this);
+	}
+};
+
+/**
+ * @brief Modifying operations for an array of bits stored in 32-bit words
+ *
+ * Derived classes must additionally provide `getWords()` returning a writeable pointer.
+ * Set operations with other arrays work on whole words, and are restricted to the smaller of the two.
+ */
+template <class Derived> class BitArrayMethods : public BitArrayConstMethods<Derived>
+{
+public:
+	using Base = BitArrayConstMethods<Derived>;
+	using typename Base::Word;
+	using Base::wordBits;
+
+	/**
+	 * @brief Read/write reference to a single bit
+	 */
+	class BitRef
+	{
+	public:
+		BitRef(Derived& array, size_t pos) : array(array), pos(pos)
+		{
+		}
+
+		operator bool() const
+		{
+			return array.test(pos);
+		}
+
+		BitRef& operator=(bool state)
+		{
+			array.set(pos, state);
+			return *this;
+		}
+
+	private:
+		Derived& array;
+		size_t pos;
+	};
+
+	using Base::operator[];
+
+	BitRef operator[](size_t pos)
+	{
+		return BitRef(self(), pos);
+	}
+
+	/**
+	 * @brief Set state of one bit
+	 */
+	Derived& set(size_t pos, bool state = true)
+	{
+		if(pos < self().size()) {
+			auto& w = self().getWords()[pos / wordBits];
+			if(state) {
+				w |= Base::bitMask(pos);
+			} else {
+				w &= ~Base::bitMask(pos);
+			}
+		}
+		return self();
+	}
+
+	/**
+	 * @brief Set all bits
+	 */
+	Derived& set()
+	{
+		auto n = this->words();
+		if(n != 0) {
+			memset(self().getWords(), 0xff, n * sizeof(Word));
+			self().getWords()[n - 1] = this->lastWordMask();
+		}
+		return self();
+	}
+
+	/**
+	 * @brief Clear one bit
+	 */
+	Derived& reset(size_t pos)
+	{
+		return set(pos, false);
+	}
+
+	/**
+	 * @brief Clear all bits
+	 */
+	Derived& reset()
+	{
+		auto n = this->words();
+		if(n != 0) {
+			memset(self().getWords(), 0, n * sizeof(Word));
+		}
+		return self();
+	}
+
+	/**
+	 * @brief Toggle one bit
+	 */
+	Derived& flip(size_t pos)
+	{
+		if(pos < self().size()) {
+			self().getWords()[pos / wordBits] ^= Base::bitMask(pos);
+		}
+		return self();
+	}
+
+	/**
+	 * @brief Toggle all bits
+	 */
+	Derived& flip()
+	{
+		auto n = this->words();
+		auto words = self().getWords();
+		for(size_t i = 0; i < n; ++i) {
+			words[i] = ~words[i];
+		}
+		if(n != 0) {
+			words[n - 1] &= this->lastWordMask();
+		}
+		return self();
+	}
+
+	/**
+	 * @brief Set state of a range of bits
+	 * @param pos First bit
+	 * @param count Number of bits
+	 * @param state
+	 */
+	Derived& setRange(size_t pos, size_t count, bool state = true)
+	{
+		applyRange(pos, count, [state](Word& w, Word mask) { w = state ? (w | mask) : (w & ~mask); });
+		return self();
+	}
+
+	/**
+	 * @brief Toggle a range of bits
+	 * @param pos First bit
+	 * @param count Number of bits
+	 */
+	Derived& flipRange(size_t pos, size_t count)
+	{
+		applyRange(pos, count, [](Word& w, Word mask) { w ^= mask; });
+		return self();
+	}
+
+	template <class Other> Derived& operator&=(const BitArrayConstMethods<Other>& other)
+	{
+		auto& rhs = static_cast<const Other&>(other);
+		auto n = std::min(this->words(), rhs.wordCount(rhs.size()));
+		auto words = self().getWords();
+		for(size_t i = 0; i < n; ++i) {
+			words[i] &= rhs.getWord(i);
+		}
+		// Bits not present in other are cleared
+		for(size_t i = n; i < this->words(); ++i) {
+			words[i] = 0;
+		}
+		return self();
+	}
+
+	template <class Other> Derived& operator|=(const BitArrayConstMethods<Other>& other)
+	{
+		return combine(other, [](Word& w, Word v) { w |= v; });
+	}
+
+	template <class Other> Derived& operator^=(const BitArrayConstMethods<Other>& other)
+	{
+		return combine(other, [](Word& w, Word v) { w ^= v; });
+	}
+
+	/**
+	 * @brief Clear all bits which are set in another array
+	 */
+	template <class Other> Derived& operator-=(const BitArrayConstMethods<Other>& other)
+	{
+		return combine(other, [](Word& w, Word v) { w &= ~v; });
+	}
+
+private:
+	Derived& self()
+	{
+		return *static_cast<Derived*>(this);
+	}
+
+	const Derived& self() const
+	{
+		return *static_cast<const Derived*>(this);
+	}
+
+	template <class Other, typename Op> Derived& combine(const BitArrayConstMethods<Other>& other, Op op)
+	{
+		auto& rhs = static_cast<const Other&>(other);
+		auto n = std::min(this->words(), rhs.wordCount(rhs.size()));
+		auto words = self().getWords();
+		for(size_t i = 0; i < n; ++i) {
+			op(words[i], rhs.getWord(i));
+		}
+		if(n != 0 && n == this->words()) {
+			words[n - 1] &= this->lastWordMask();
+		}
+		return self();
+	}
+
+	template <typename Op> void applyRange(size_t pos, size_t count, Op op)
+	{
+		auto size = self().size();
+		if(pos >= size) {
+			return;
+		}
+		count = std::min(count, size - pos);
+		auto words = self().getWords();
+		while(count != 0) {
+			auto offset = pos % wordBits;
+			auto bits = std::min(count, wordBits - offset);
+			Word mask = (bits == wordBits) ? ~Word(0) : ((Word(1) << bits) - 1) << offset;
+			op(words[pos / wordBits], mask);
+			pos += bits;
+			count -= bits;
+		}
+	}
+};
+
+/**
+ * @brief Fixed-size array of bits
+ * @tparam size_ Number of bits
+ *
+ * Occupies exactly the space required for the bits, rounded up to a whole number of words.
+ */
+template <size_t size_> class BitArray : public BitArrayMethods<BitArray<size_>>
+{
+public:
+	using typename BitArrayMethods<BitArray>::Word;
+
+	static constexpr size_t size()
+	{
+		return size_;
+	}
+
+	Word getWord(size_t index) const
+	{
+		return bits[index];
+	}
+
+	Word* getWords()
+	{
+		return bits;
+	}
+
+	const Word* getWords() const
+	{
+		return bits;
+	}
+
+private:
+	Word bits[BitArrayConstMethods<BitArray>::wordCount(size_)]{};
+};
+
+/**
+ * @brief Array of bits whose size is set at runtime
+ */
+class DynamicBitArray : public BitArrayMethods<DynamicBitArray>
+{
+public:
+	DynamicBitArray() = default;
+
+	explicit DynamicBitArray(size_t size)
+	{
+		resize(size);
+	}
+
+	DynamicBitArray(const DynamicBitArray& other)
+	{
+		*this = other;
+	}
+
+	DynamicBitArray(DynamicBitArray&& other) = default;
+
+	DynamicBitArray& operator=(const DynamicBitArray& other)
+	{
+		if(this != &other && resize(other.bitCount)) {
+			for(size_t i = 0; i < words(); ++i) {
+				bits[i] = other.bits[i];
+			}
+		}
+		return *this;
+	}
+
+	DynamicBitArray& operator=(DynamicBitArray&& other) = default;
+
+	/**
+	 * @brief Change number of bits
+	 * @param size New size. Existing bits are retained, new bits are cleared.
+	 * @retval bool false on memory allocation failure
+	 */
+	bool resize(size_t size)
+	{
+		auto oldWords = words();
+		auto newWords = wordCount(size);
+		if(newWords != oldWords) {
+			std::unique_ptr<Word[]> newBits(new(std::nothrow) Word[newWords]);
+			if(!newBits && newWords != 0) {
+				return false;
+			}
+			auto n = std::min(oldWords, newWords);
+			for(size_t i = 0; i < newWords; ++i) {
+				newBits[i] = (i < n) ? bits[i] : 0;
+			}
+			bits = std::move(newBits);
+		}
+		bitCount = size;
+		if(newWords != 0) {
+			bits[newWords - 1] &= lastWordMask();
+		}
+		return true;
+	}
+
+	size_t size() const
+	{
+		return bitCount;
+	}
+
+	Word getWord(size_t index) const
+	{
+		return bits[index];
+	}
+
+	Word* getWords()
+	{
+		return bits.get();
+	}
+
+	const Word* getWords() const
+	{
+		return bits.get();
+	}
+
+private:
+	std::unique_ptr<Word[]> bits;
+	size_t bitCount{0};
+};
+
+/**
+ * @brief Read-only array of bits stored in flash memory
+ *
+ * For example:
+ *
+ * 		const uint32_t ledMaskData[] PROGMEM = {0x0000ffff, 0xffff0000, ...};
+ * 		FlashBitArray ledMask(ledMaskData, 256);
+ *
+ * 		for(auto led : ledMask) {
+ * 			...
+ * 		}
+ *
+ * Any bits beyond the given size must be zero.
+ */
+class FlashBitArray : public BitArrayConstMethods<FlashBitArray>
+{
+public:
+	constexpr FlashBitArray(const Word* data, size_t size) : data(data), bitCount(size)
+	{
+	}
+
+	template <size_t N> constexpr FlashBitArray(const Word (&data)[N]) : FlashBitArray(data, N * wordBits)
+	{
+	}
+
+	size_t size() const
+	{
+		return bitCount;
+	}
+
+	Word getWord(size_t index) const
+	{
+		// Aligned 32-bit reads are safe from flash
+		return data[index];
+	}
+
+private:
+	const Word* data;
+	size_t bitCount;
+};
@@ -174,7 +174,26 @@ public:
 	 */
 	size_t count() const
 	{
-		return __builtin_popcount(bitSetValue);
+		return (sizeof(S) > sizeof(unsigned)) ? __builtin_popcountll(bitSetValue) : __builtin_popcount(bitSetValue);
+	}
+
+	/**
+	 * @brief Get index of the first element in the set
+	 * @retval size_t `size()` if the set is empty
+	 */
+	size_t findFirst() const
+	{
+		return find(0);
+	}
+
+	/**
+	 * @brief Get index of the next element in the set
+	 * @param pos Index of the previous element
+	 * @retval size_t `size()` if there are no more elements
+	 */
+	size_t findNext(size_t pos) const
+	{
+		return find(pos + 1);
 	}
 
 	/**
@@ -371,6 +390,18 @@ private:
 	{
 	}
 
+	size_t find(size_t pos) const
+	{
+		if(pos >= size_) {
+			return size_;
+		}
+		S value = bitSetValue >> pos;
+		if(value == 0) {
+			return size_;
+		}
+		return pos + ((sizeof(S) > sizeof(unsigned)) ? __builtin_ctzll(value) : __builtin_ctz(value));
+	}
+
 	S bitSetValue{0};
 };
 
@@ -16,6 +16,7 @@
 #pragma once
 
 #include "Data/Stream/ReadWriteStream.h"
+#include "Data/MemoryClass.h"
 
 /**
  * @brief      Circular stream class
@@ -28,13 +29,18 @@
 class CircularBuffer : public ReadWriteStream
 {
 public:
-	CircularBuffer(int size) : buffer(new char[size]), readPos(buffer), writePos(buffer), size(size)
+	/**
+	 * @param size Buffer size in bytes
+	 * @param memClass Use MemoryClass::Bulk for large buffers which may be placed in external RAM
+	 */
+	CircularBuffer(int size, MemoryClass memClass = MemoryClass::Default)
+		: buffer(static_cast<char*>(Memory::allocate(size, memClass))), readPos(buffer), writePos(buffer), size(size)
 	{
 	}
 
 	~CircularBuffer()
 	{
-		delete[] buffer;
+		free(buffer);
 	}
 
 	/** @brief  Get the stream type
@@ -0,0 +1,263 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/SmingHub/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * SpscRing.h - Lock-free single-producer, single-consumer ring buffer
+ *
+ ****/
+
+#pragma once
+
+#include <Platform/System.h>
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <type_traits>
+
+/**
+ * @brief Fixed-size ring buffer for passing data from one producer to one consumer without locking
+ * @tparam T Element type, must be trivially copyable
+ * @tparam size Number of elements, must be a power of 2
+ *
+ * Typical use is to pass data from an interrupt handler to task context.
+ * The producer writes and the consumer reads concurrently with no need to disable interrupts.
+ * Each side updates only its own index, so only plain atomic loads and stores are required.
+ *
+ * Indices run freely and are masked on access, so all `size` elements are usable.
+ *
+ * The producer may optionally notify the consumer by calling notify() at the end of a batch.
+ * This queues the consumer callback once, however many batches are written before it runs.
+ *
+ * Producer methods are safe to call from interrupt context on all architectures.
+ */
+template <typename T, size_t size> class SpscRing
+{
+	static_assert(size != 0 && (size & (size - 1)) == 0, "SpscRing size must be a power of 2");
+	static_assert(std::is_trivially_copyable<T>::value, "SpscRing requires a trivially copyable type");
+
+public:
+	static constexpr size_t capacity()
+	{
+		return size;
+	}
+
+	/**
+	 * @name Producer methods
+	 * @{
+	 */
+
+	/**
+	 * @brief Get number of elements which may be written
+	 */
+	__forceinline size_t IRAM_ATTR space() const
+	{
+		return size - (head.load(std::memory_order_relaxed) - tail.load(std::memory_order_acquire));
+	}
+
+	/**
+	 * @brief Add an element
+	 * @retval bool false if buffer is full
+	 */
+	__forceinline bool IRAM_ATTR push(const T& item)
+	{
+		auto h = head.load(std::memory_order_relaxed);
+		if(h - tail.load(std::memory_order_acquire) == size) {
+			return false;
+		}
+		buffer[h & mask] = item;
+		head.store(h + 1, std::memory_order_release);
+		return true;
+	}
+
+	/**
+	 * @brief Add elements
+	 * @param data
+	 * @param count Number of elements to write
+	 * @retval size_t Number of elements written, less than count if buffer became full
+	 */
+	__forceinline size_t IRAM_ATTR write(const T* data, size_t count)
+	{
+		T* span;
+		size_t written{0};
+		// Free space may be split across the end of the buffer
+		for(unsigned i = 0; i < 2 && written < count; ++i) {
+			auto n = std::min(getWriteSpan(span), count - written);
+			if(n == 0) {
+				break;
+			}
+			memcpy(span, &data[written], n * sizeof(T));
+			commitWrite(n);
+			written += n;
+		}
+		return written;
+	}
+
+	/**
+	 * @brief Get contiguous free space for writing in place
+	 * @param span On return, points to first free element
+	 * @retval size_t Number of contiguous free elements
+	 * @note Call commitWrite() when done
+	 */
+	__forceinline size_t IRAM_ATTR getWriteSpan(T*& span)
+	{
+		auto h = head.load(std::memory_order_relaxed);
+		auto unused = size - (h - tail.load(std::memory_order_acquire));
+		auto index = h & mask;
+		span = &buffer[index];
+		return std::min(unused, size - index);
+	}
+
+	/**
+	 * @brief Make elements written via getWriteSpan() available to the consumer
+	 * @param count Must not exceed the value returned by getWriteSpan()
+	 */
+	__forceinline void IRAM_ATTR commitWrite(size_t count)
+	{
+		head.store(head.load(std::memory_order_relaxed) + count, std::memory_order_release);
+	}
+
+	/**
+	 * @brief Queue the consumer callback if it isn't already pending
+	 * @retval bool true if the callback is pending
+	 * @note Has no effect unless setNotify() has been called
+	 */
+	__forceinline bool IRAM_ATTR notify()
+	{
+		if(notifyCallback == nullptr) {
+			return false;
+		}
+		if(notifyPending.load(std::memory_order_acquire)) {
+			return true;
+		}
+		notifyPending.store(true, std::memory_order_release);
+		if(System.queueCallback(notifyHandler, this)) {
+			return true;
+		}
+		// Try again next batch
+		notifyPending.store(false, std::memory_order_release);
+		return false;
+	}
+
+	/** @} */
+
+	/**
+	 * @name Consumer methods
+	 * @{
+	 */
+
+	/**
+	 * @brief Get number of elements which may be read
+	 */
+	size_t available() const
+	{
+		return head.load(std::memory_order_acquire) - tail.load(std::memory_order_relaxed);
+	}
+
+	bool isEmpty() const
+	{
+		return available() == 0;
+	}
+
+	/**
+	 * @brief Remove an element
+	 * @retval bool false if buffer is empty
+	 */
+	bool pop(T& item)
+	{
+		auto t = tail.load(std::memory_order_relaxed);
+		if(head.load(std::memory_order_acquire) == t) {
+			return false;
+		}
+		item = buffer[t & mask];
+		tail.store(t + 1, std::memory_order_release);
+		return true;
+	}
+
+	/**
+	 * @brief Remove elements
+	 * @param data
+	 * @param count Maximum number of elements to read
+	 * @retval size_t Number of elements read
+	 */
+	size_t read(T* data, size_t count)
+	{
+		const T* span;
+		size_t done{0};
+		for(unsigned i = 0; i < 2 && done < count; ++i) {
+			auto n = std::min(getReadSpan(span), count - done);
+			if(n == 0) {
+				break;
+			}
+			memcpy(&data[done], span, n * sizeof(T));
+			consume(n);
+			done += n;
+		}
+		return done;
+	}
+
+	/**
+	 * @brief Get contiguous data for reading in place
+	 * @param span On return, points to the oldest element
+	 * @retval size_t Number of contiguous elements available
+	 * @note Call consume() when done
+	 */
+	size_t getReadSpan(const T*& span) const
+	{
+		auto t = tail.load(std::memory_order_relaxed);
+		auto used = head.load(std::memory_order_acquire) - t;
+		auto index = t & mask;
+		span = &buffer[index];
+		return std::min(used, size - index);
+	}
+
+	/**
+	 * @brief Release elements read via getReadSpan()
+	 * @param count Must not exceed the value returned by getReadSpan()
+	 */
+	void consume(size_t count)
+	{
+		tail.store(tail.load(std::memory_order_relaxed) + count, std::memory_order_release);
+	}
+
+	/**
+	 * @brief Discard all available elements
+	 */
+	void clear()
+	{
+		tail.store(head.load(std::memory_order_acquire), std::memory_order_release);
+	}
+
+	/**
+	 * @brief Set callback to be queued when the producer calls notify()
+	 * @param callback Invoked in task context, and should read all available data
+	 * @param param Passed to callback
+	 * @note Call before the producer starts
+	 */
+	void setNotify(TaskCallback callback, void* param = nullptr)
+	{
+		notifyParam = param;
+		notifyCallback = callback;
+	}
+
+	/** @} */
+
+private:
+	static constexpr size_t mask{size - 1};
+
+	static void notifyHandler(void* param)
+	{
+		auto ring = static_cast<SpscRing*>(param);
+		// Clear first, so data written from here on generates another notification
+		ring->notifyPending.store(false, std::memory_order_release);
+		ring->notifyCallback(ring->notifyParam);
+	}
+
+	T buffer[size];
+	std::atomic<size_t> head{0}; ///< Written only by producer
+	std::atomic<size_t> tail{0}; ///< Written only by consumer
+	std::atomic<bool> notifyPending{false};
+	TaskCallback notifyCallback{nullptr};
+	void* notifyParam{nullptr};
+};
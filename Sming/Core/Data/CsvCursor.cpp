@@ -0,0 +1,340 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/SmingHub/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * CsvCursor.cpp
+ *
+ ****/
+
+#include "CsvCursor.h"
+#include <Storage/PartitionStream.h>
+#include <climits>
+
+namespace
+{
+/*
+ * Character-level CSV state machine, as used by CsvReader::readRow()
+ */
+class FieldParser
+{
+public:
+	enum class Result {
+		skip,
+		character,
+		fieldEnd,
+		lineEnd,
+	};
+
+	FieldParser(char fieldSeparator) : fieldSeparator(fieldSeparator)
+	{
+	}
+
+	/**
+	 * @brief Process next character
+	 * @param c Source character, on return contains the un-escaped character
+	 */
+	Result feed(char& c)
+	{
+		if(escape) {
+			switch(c) {
+			case 'n':
+				c = '\n';
+				break;
+			case 'r':
+				c = '\r';
+				break;
+			case 't':
+				c = '\t';
+				break;
+			default:;
+				// Just accept character
+			}
+			escape = false;
+			lc = c;
+			return Result::character;
+		}
+
+		if(fieldKind == FieldKind::unknown) {
+			if(c == quoteChar) {
+				fieldKind = FieldKind::quoted;
+				quote = true;
+				lc = '\0';
+				return Result::skip;
+			}
+			fieldKind = FieldKind::unquoted;
+		}
+		if(c == quoteChar) {
+			quote = !quote;
+			if(fieldKind == FieldKind::quoted) {
+				if(lc == quoteChar) {
+					lc = '\0';
+					return Result::character;
+				}
+				lc = c;
+				return Result::skip;
+			}
+		} else if(c == '\\') {
+			escape = true;
+			return Result::skip;
+		} else if(!quote) {
+			if(c == fieldSeparator) {
+				fieldKind = FieldKind::unknown;
+				lc = '\0';
+				return Result::fieldEnd;
+			}
+			if(c == '\r') {
+				return Result::skip;
+			}
+			if(c == '\n') {
+				return Result::lineEnd;
+			}
+		}
+		lc = c;
+		return Result::character;
+	}
+
+private:
+	static constexpr char quoteChar{'"'};
+	enum class FieldKind {
+		unknown,
+		quoted,
+		unquoted,
+	};
+	FieldKind fieldKind{};
+	char fieldSeparator;
+	bool escape{false};
+	bool quote{false};
+	char lc{'\0'};
+};
+
+} // namespace
+
+CsvCursor::CsvCursor(const Storage::Partition& partition, char fieldSeparator, const CStringArray& headings)
+	: fieldSeparator(fieldSeparator), userHeadingsProvided(headings), headings(headings)
+{
+	mappedData = static_cast<const char*>(partition.getMappedPointer(0, partition.size()));
+	if(mappedData != nullptr) {
+		dataLength = partition.size();
+	} else {
+		stream.reset(new Storage::PartitionStream(partition));
+	}
+	init();
+}
+
+void CsvCursor::init()
+{
+	if(!userHeadingsProvided && scanRow(0)) {
+		currentRow = 0;
+		for(unsigned i = 0; i < fields.count(); ++i) {
+			headings.add(getValue(i));
+		}
+		dataStart = nextRowOffset;
+	}
+	currentRow = -1;
+}
+
+bool CsvCursor::fillWindow(uint32_t offset)
+{
+	if(offset >= dataLength) {
+		return false;
+	}
+
+	size_t len = std::min(size_t(dataLength - offset), windowSize);
+	if(mappedData != nullptr) {
+		memcpy_P(window, mappedData + offset, len);
+	} else {
+		if(!stream || stream->seekFrom(offset, SeekOrigin::Start) != int(offset)) {
+			return false;
+		}
+		len = stream->readBytes(window, len);
+		if(len == 0) {
+			dataLength = offset;
+			return false;
+		}
+	}
+
+	// Check for end marker
+	for(unsigned i = 0; i < len; ++i) {
+		if(window[i] == '\0' || window[i] == '\xff') {
+			len = i;
+			dataLength = offset + i;
+			break;
+		}
+	}
+
+	windowOffset = offset;
+	windowLength = len;
+	return len != 0;
+}
+
+bool CsvCursor::scanRow(uint32_t offset)
+{
+	if(charAt(offset) < 0) {
+		return false;
+	}
+
+	// Extra fields are ignored, but only once headings are known
+	unsigned maxFields = headings.count() ?: UINT_MAX;
+	FieldParser parser(fieldSeparator);
+	fields.clear();
+	rowOffset = offset;
+	uint32_t fieldStart = offset;
+	for(;;) {
+		int c = charAt(offset);
+		if(c < 0) {
+			nextRowOffset = offset;
+			break;
+		}
+		char ch = c;
+		auto result = parser.feed(ch);
+		if(result == FieldParser::Result::lineEnd) {
+			nextRowOffset = offset + 1;
+			break;
+		}
+		if(result == FieldParser::Result::fieldEnd) {
+			if(fields.count() < maxFields && !fields.add(Field{fieldStart, offset - fieldStart})) {
+				return false;
+			}
+			fieldStart = offset + 1;
+		}
+		++offset;
+	}
+
+	if(fields.count() < maxFields && !fields.add(Field{fieldStart, offset - fieldStart})) {
+		return false;
+	}
+
+	// Missing fields are empty
+	while(fields.count() < headings.count()) {
+		if(!fields.add(Field{offset, 0})) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+bool CsvCursor::next()
+{
+	uint32_t offset = (currentRow < 0) ? dataStart : nextRowOffset;
+	if(!scanRow(offset)) {
+		currentRow = -1;
+		return false;
+	}
+	++currentRow;
+	return true;
+}
+
+bool CsvCursor::seek(unsigned row)
+{
+	uint32_t offset = dataStart;
+	unsigned n = 0;
+
+	// Start from current position or nearest indexed row, whichever is closer
+	if(currentRow >= 0 && unsigned(currentRow) <= row) {
+		offset = rowOffset;
+		n = currentRow;
+	}
+	if(indexInterval != 0 && rowIndex.count() != 0) {
+		unsigned i = std::min(row / indexInterval, rowIndex.count() - 1);
+		if(i * indexInterval > n) {
+			offset = rowIndex[i];
+			n = i * indexInterval;
+		}
+	}
+
+	currentRow = -1;
+	for(;;) {
+		if(!scanRow(offset)) {
+			return false;
+		}
+		if(n == row) {
+			currentRow = n;
+			return true;
+		}
+		offset = nextRowOffset;
+		++n;
+	}
+}
+
+bool CsvCursor::buildIndex(unsigned interval)
+{
+	rowIndex.clear();
+	indexInterval = 0;
+	rowCount = -1;
+	currentRow = -1;
+	if(interval == 0) {
+		return false;
+	}
+
+	unsigned n = 0;
+	for(uint32_t offset = dataStart; scanRow(offset); offset = nextRowOffset, ++n) {
+		if(n % interval == 0 && !rowIndex.add(offset)) {
+			rowIndex.clear();
+			return false;
+		}
+	}
+	rowIndex.trimToSize();
+	indexInterval = interval;
+	rowCount = n;
+	return true;
+}
+
+int CsvCursor::getValue(int column, char* buffer, size_t bufSize)
+{
+	auto field = getField(column);
+	if(field == nullptr || buffer == nullptr || bufSize == 0) {
+		return -1;
+	}
+
+	FieldParser parser(fieldSeparator);
+	size_t len{0};
+	auto end = field->offset + field->length;
+	for(auto offset = field->offset; offset < end && len + 1 < bufSize; ++offset) {
+		char c = charAt(offset);
+		if(parser.feed(c) == FieldParser::Result::character) {
+			buffer[len++] = c;
+		}
+	}
+	buffer[len] = '\0';
+	return len;
+}
+
+String CsvCursor::getValue(int column)
+{
+	auto field = getField(column);
+	if(field == nullptr) {
+		return nullptr;
+	}
+
+	// Decoded value is never longer than source text
+	String s;
+	if(!s.setLength(field->length)) {
+		return nullptr;
+	}
+	s.setLength(getValue(column, s.begin(), field->length + 1));
+	return s;
+}
+
+bool CsvCursor::valueEquals(int column, const char* value)
+{
+	auto field = getField(column);
+	if(field == nullptr || value == nullptr) {
+		return false;
+	}
+
+	FieldParser parser(fieldSeparator);
+	auto end = field->offset + field->length;
+	for(auto offset = field->offset; offset < end; ++offset) {
+		char c = charAt(offset);
+		if(parser.feed(c) != FieldParser::Result::character) {
+			continue;
+		}
+		if(*value++ != c) {
+			return false;
+		}
+	}
+	return *value == '\0';
+}
@@ -0,0 +1,248 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/SmingHub/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * CsvCursor.h
+ *
+ ****/
+
+#pragma once
+
+#include "Stream/DataSourceStream.h"
+#include "CStringArray.h"
+#include <ValueVector.h>
+#include <memory>
+
+namespace Storage
+{
+class Partition;
+}
+
+/**
+ * @brief Cursor for reading large CSV data sets without buffering rows
+ *
+ * Parsing follows the same rules as `CsvReader`, but only the location of each field
+ * within the source is recorded. Values are un-quoted and un-escaped on request,
+ * either into a caller-provided buffer or a String.
+ *
+ * Source data is accessed through a small window buffer, so rows and fields may be of any length.
+ * Data may be provided as a seekable stream, a memory-mapped (flash) region or a partition.
+ * A NUL or 0xFF byte marks the end of data, so content need not fill a flash partition.
+ *
+ * Locating a row requires scanning from the start of the data. For large tables call
+ * `buildIndex()` once: this records the offset of every Nth row so `seek()` need
+ * scan at most N-1 rows.
+ *
+ * Column lookup by name should be done once, with the index then used for each row:
+ *
+ * 		CsvCursor csv(partition);
+ * 		int keyColumn = csv.getColumn("key");
+ * 		int valueColumn = csv.getColumn("value");
+ * 		while(csv.next()) {
+ * 			if(csv.valueEquals(keyColumn, "something")) {
+ * 				char buffer[32];
+ * 				csv.getValue(valueColumn, buffer, sizeof(buffer));
+ * 				...
+ * 			}
+ * 		}
+ */
+class CsvCursor
+{
+public:
+	static constexpr size_t windowSize{128};
+
+	/**
+	 * @brief Read CSV data from a stream
+	 * @param source Must support seeking via `seekFrom()`
+	 * @param fieldSeparator
+	 * @param headings Required if source data does not contain field headings as first row
+	 */
+	CsvCursor(IDataSourceStream* source, char fieldSeparator = ',', const CStringArray& headings = nullptr)
+		: stream(source), fieldSeparator(fieldSeparator), userHeadingsProvided(headings), headings(headings)
+	{
+		init();
+	}
+
+	/**
+	 * @brief Read CSV data from memory
+	 * @param data Content may be in flash, such as a FlashString or `Partition::getMappedPointer()`
+	 * @param length Size of data in bytes
+	 * @param fieldSeparator
+	 * @param headings Required if source data does not contain field headings as first row
+	 */
+	CsvCursor(const void* data, size_t length, char fieldSeparator = ',', const CStringArray& headings = nullptr)
+		: mappedData(static_cast<const char*>(data)), fieldSeparator(fieldSeparator), userHeadingsProvided(headings),
+		  headings(headings), dataLength(length)
+	{
+		init();
+	}
+
+	/**
+	 * @brief Read CSV data from a partition
+	 * @param partition Content is memory-mapped where supported, otherwise accessed via `PartitionStream`
+	 * @param fieldSeparator
+	 * @param headings Required if source data does not contain field headings as first row
+	 */
+	CsvCursor(const Storage::Partition& partition, char fieldSeparator = ',', const CStringArray& headings = nullptr);
+
+	/**
+	 * @brief Reset cursor to 'before start'
+	 *
+	 * Call `next()` to fetch first record. The row index is retained.
+	 */
+	void reset()
+	{
+		currentRow = -1;
+	}
+
+	/**
+	 * @brief Move to next record
+	 * @retval bool false at end of data
+	 */
+	bool next();
+
+	/**
+	 * @brief Move to a specific record
+	 * @param row Index of row, starting at 0 for the first data row (i.e. after any headings)
+	 * @retval bool false if row does not exist
+	 */
+	bool seek(unsigned row);
+
+	/**
+	 * @brief Scan all data to build a sparse row index
+	 * @param interval Record location of every `interval` rows
+	 * @retval bool false on memory allocation failure
+	 *
+	 * Also determines the number of rows. Cursor is reset to 'before start'.
+	 */
+	bool buildIndex(unsigned interval = 32);
+
+	/**
+	 * @brief Get number of data rows
+	 * @retval int -1 if unknown as `buildIndex()` has not been called
+	 */
+	int getRowCount() const
+	{
+		return rowCount;
+	}
+
+	/**
+	 * @brief Get index of current row
+	 * @retval int -1 if there is no current row
+	 */
+	int getRowIndex() const
+	{
+		return currentRow;
+	}
+
+	/**
+	 * @brief Get number of columns
+	 */
+	unsigned count() const
+	{
+		return headings.count();
+	}
+
+	/**
+	 * @brief Get index of column given its name
+	 * @param name Column name to find
+	 * @retval int -1 if name is not found
+	 */
+	int getColumn(const char* name) const
+	{
+		return headings.indexOf(name);
+	}
+
+	/**
+	 * @brief Get headings
+	 */
+	const CStringArray& getHeadings() const
+	{
+		return headings;
+	}
+
+	/**
+	 * @brief Determine if cursor is on a valid row
+	 */
+	explicit operator bool() const
+	{
+		return currentRow >= 0;
+	}
+
+	/**
+	 * @brief Get a value from the current row
+	 * @param column Column index, starts at 0
+	 * @param buffer
+	 * @param bufSize Size of buffer, including NUL terminator
+	 * @retval int Length of value, truncated if necessary to fit buffer. -1 if column or row is not valid.
+	 */
+	int getValue(int column, char* buffer, size_t bufSize);
+
+	/**
+	 * @brief Get a value from the current row
+	 * @param column Column index, starts at 0
+	 * @retval String Invalid if column or row is not valid
+	 */
+	String getValue(int column);
+
+	/**
+	 * @brief Get a value from the current row
+	 * @param name Column name
+	 * @retval String Invalid if column or row is not valid
+	 * @note Prefer looking up column index once, outside of any loop
+	 */
+	String getValue(const char* name)
+	{
+		return getValue(getColumn(name));
+	}
+
+	/**
+	 * @brief Compare a value from the current row without copying it
+	 * @param column Column index, starts at 0
+	 * @param value
+	 */
+	bool valueEquals(int column, const char* value);
+
+private:
+	struct Field {
+		uint32_t offset;
+		uint32_t length;
+	};
+
+	void init();
+	bool scanRow(uint32_t offset);
+	bool fillWindow(uint32_t offset);
+
+	int charAt(uint32_t offset)
+	{
+		if(offset - windowOffset >= windowLength && !fillWindow(offset)) {
+			return -1;
+		}
+		return uint8_t(window[offset - windowOffset]);
+	}
+
+	const Field* getField(int column) const
+	{
+		return (currentRow >= 0 && column >= 0 && unsigned(column) < fields.count()) ? &fields[column] : nullptr;
+	}
+
+	std::unique_ptr<IDataSourceStream> stream;
+	const char* mappedData{nullptr};
+	char fieldSeparator;
+	bool userHeadingsProvided;
+	CStringArray headings;
+	ValueVector<Field> fields;
+	ValueVector<uint32_t> rowIndex;
+	unsigned indexInterval{0};
+	int rowCount{-1};
+	int currentRow{-1};
+	uint32_t dataLength{UINT32_MAX}; ///< Reduced when end of data is found
+	uint32_t dataStart{0};
+	uint32_t rowOffset{0};
+	uint32_t nextRowOffset{0};
+	uint32_t windowOffset{0};
+	uint16_t windowLength{0};
+	char window[windowSize];
+};
@@ -0,0 +1,77 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/SmingHub/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * DoublyLinkedObjectList.cpp
+ *
+ ****/
+
+#include "DoublyLinkedObjectList.h"
+
+void DoublyLinkedObject::unlink()
+{
+	if(mList != nullptr) {
+		mList->remove(this);
+	}
+}
+
+bool DoublyLinkedObjectList::insertBefore(DoublyLinkedObject* object, DoublyLinkedObject* position)
+{
+	if(object == nullptr || object == position) {
+		return false;
+	}
+	if(position != nullptr && position->mList != this) {
+		return false;
+	}
+
+	object->unlink();
+
+	object->mList = this;
+	object->mNext = position;
+	if(position == nullptr) {
+		object->mPrev = mTail;
+		mTail = object;
+	} else {
+		object->mPrev = position->mPrev;
+		position->mPrev = object;
+	}
+	if(object->mPrev == nullptr) {
+		mHead = object;
+	} else {
+		object->mPrev->mNext = object;
+	}
+	++mCount;
+	return true;
+}
+
+bool DoublyLinkedObjectList::remove(DoublyLinkedObject* object)
+{
+	if(object == nullptr || object->mList != this) {
+		return false;
+	}
+
+	if(object->mPrev == nullptr) {
+		mHead = object->mNext;
+	} else {
+		object->mPrev->mNext = object->mNext;
+	}
+	if(object->mNext == nullptr) {
+		mTail = object->mPrev;
+	} else {
+		object->mNext->mPrev = object->mPrev;
+	}
+	object->mNext = nullptr;
+	object->mPrev = nullptr;
+	object->mList = nullptr;
+	--mCount;
+	return true;
+}
+
+void DoublyLinkedObjectList::clear()
+{
+	while(remove(mHead)) {
+		//
+	}
+}
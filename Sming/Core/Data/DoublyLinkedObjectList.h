@@ -0,0 +1,344 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/SmingHub/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * DoublyLinkedObjectList.h
+ *
+ ****/
+#pragma once
+
+#include <iterator>
+#include <algorithm>
+
+class DoublyLinkedObjectList;
+
+/**
+ * @brief Base class for objects which may be placed in a DoublyLinkedObjectList
+ *
+ * Each object knows which list it is in, so can be removed without searching.
+ * An object is removed from its list automatically when destroyed.
+ */
+class DoublyLinkedObject
+{
+public:
+	DoublyLinkedObject() = default;
+
+	DoublyLinkedObject(const DoublyLinkedObject&) = delete;
+	DoublyLinkedObject& operator=(const DoublyLinkedObject&) = delete;
+
+	virtual ~DoublyLinkedObject()
+	{
+		unlink();
+	}
+
+	DoublyLinkedObject* getNext() const
+	{
+		return mNext;
+	}
+
+	DoublyLinkedObject* getPrev() const
+	{
+		return mPrev;
+	}
+
+	/**
+	 * @brief Get the list this object is in
+	 * @retval DoublyLinkedObjectList* nullptr if not in a list
+	 */
+	DoublyLinkedObjectList* getList() const
+	{
+		return mList;
+	}
+
+	/**
+	 * @brief Remove object from its list, if any
+	 */
+	void unlink();
+
+private:
+	friend class DoublyLinkedObjectList;
+
+	DoublyLinkedObject* mNext{nullptr};
+	DoublyLinkedObject* mPrev{nullptr};
+	DoublyLinkedObjectList* mList{nullptr};
+};
+
+/**
+ * @brief Base class template for doubly-linked items with type casting
+ */
+template <typename ObjectType> class DoublyLinkedObjectTemplate : public DoublyLinkedObject
+{
+public:
+	ObjectType* getNext() const
+	{
+		return static_cast<ObjectType*>(DoublyLinkedObject::getNext());
+	}
+
+	ObjectType* getPrev() const
+	{
+		return static_cast<ObjectType*>(DoublyLinkedObject::getPrev());
+	}
+};
+
+/**
+ * @brief Doubly-linked list of objects
+ *
+ * Unlike LinkedObjectList, removal takes constant time and the number of items is tracked,
+ * so this suits registries where items come and go frequently.
+ *
+ * @note We don't own the items, just keep references to them.
+ * An object can only be in one list at a time: adding it to a list moves it from any other.
+ */
+class DoublyLinkedObjectList
+{
+public:
+	DoublyLinkedObjectList() = default;
+
+	DoublyLinkedObjectList(const DoublyLinkedObjectList&) = delete;
+	DoublyLinkedObjectList& operator=(const DoublyLinkedObjectList&) = delete;
+
+	~DoublyLinkedObjectList()
+	{
+		clear();
+	}
+
+	/**
+	 * @brief Add object to end of list
+	 */
+	bool add(DoublyLinkedObject* object)
+	{
+		return insertBefore(object, nullptr);
+	}
+
+	/**
+	 * @brief Add object to start of list
+	 */
+	bool insert(DoublyLinkedObject* object)
+	{
+		return insertBefore(object, mHead);
+	}
+
+	/**
+	 * @brief Add object before another
+	 * @param object Object to add
+	 * @param position Existing item in this list, or nullptr to add at end
+	 * @retval bool false if position is not in this list
+	 */
+	bool insertBefore(DoublyLinkedObject* object, DoublyLinkedObject* position);
+
+	/**
+	 * @brief Remove an object from the list
+	 * @retval bool false if object is not in this list
+	 */
+	bool remove(DoublyLinkedObject* object);
+
+	/**
+	 * @brief Remove and return the first object in the list
+	 */
+	DoublyLinkedObject* pop()
+	{
+		auto object = mHead;
+		remove(object);
+		return object;
+	}
+
+	/**
+	 * @brief Remove all objects
+	 */
+	void clear();
+
+	DoublyLinkedObject* head()
+	{
+		return mHead;
+	}
+
+	const DoublyLinkedObject* head() const
+	{
+		return mHead;
+	}
+
+	DoublyLinkedObject* tail()
+	{
+		return mTail;
+	}
+
+	const DoublyLinkedObject* tail() const
+	{
+		return mTail;
+	}
+
+	bool isEmpty() const
+	{
+		return mHead == nullptr;
+	}
+
+	size_t count() const
+	{
+		return mCount;
+	}
+
+	bool contains(const DoublyLinkedObject& object) const
+	{
+		return object.mList == this;
+	}
+
+protected:
+	DoublyLinkedObject* mHead{nullptr};
+	DoublyLinkedObject* mTail{nullptr};
+	size_t mCount{0};
+};
+
+/**
+ * @brief Class template for doubly-linked list of objects
+ *
+ * Iteration may continue safely when the current item is removed, as the iterator
+ * has already fetched the next one. Removing any other item during iteration is not safe.
+ */
+template <typename ObjectType> class DoublyLinkedObjectListTemplate : public DoublyLinkedObjectList
+{
+public:
+	template <typename T> class IteratorTemplate : public std::iterator<std::forward_iterator_tag, T>
+	{
+	public:
+		IteratorTemplate(T* object) : mObject(object), mNext(getNext(object))
+		{
+		}
+
+		IteratorTemplate& operator++()
+		{
+			mObject = mNext;
+			mNext = getNext(mObject);
+			return *this;
+		}
+
+		IteratorTemplate operator++(int)
+		{
+			IteratorTemplate tmp(*this);
+			operator++();
+			return tmp;
+		}
+
+		bool operator==(const IteratorTemplate& rhs) const
+		{
+			return mObject == rhs.mObject;
+		}
+
+		bool operator!=(const IteratorTemplate& rhs) const
+		{
+			return mObject != rhs.mObject;
+		}
+
+		T& operator*()
+		{
+			return *mObject;
+		}
+
+		T* operator->()
+		{
+			return mObject;
+		}
+
+		operator T*()
+		{
+			return mObject;
+		}
+
+	private:
+		static T* getNext(T* object)
+		{
+			return object ? object->getNext() : nullptr;
+		}
+
+		T* mObject;
+		T* mNext;
+	};
+
+	using Iterator = IteratorTemplate<ObjectType>;
+	using ConstIterator = IteratorTemplate<const ObjectType>;
+
+	ObjectType* head()
+	{
+		return static_cast<ObjectType*>(mHead);
+	}
+
+	const ObjectType* head() const
+	{
+		return static_cast<const ObjectType*>(mHead);
+	}
+
+	ObjectType* tail()
+	{
+		return static_cast<ObjectType*>(mTail);
+	}
+
+	const ObjectType* tail() const
+	{
+		return static_cast<const ObjectType*>(mTail);
+	}
+
+	Iterator begin()
+	{
+		return head();
+	}
+
+	Iterator end()
+	{
+		return nullptr;
+	}
+
+	ConstIterator begin() const
+	{
+		return head();
+	}
+
+	ConstIterator end() const
+	{
+		return nullptr;
+	}
+
+	bool add(ObjectType* object)
+	{
+		return DoublyLinkedObjectList::add(object);
+	}
+
+	/**
+	 * @brief Add object in sorted position
+	 * @param object
+	 * @param compare Function `bool(const ObjectType& a, const ObjectType& b)` returning true
+	 * if `a` should come before `b`
+	 * @retval bool true on success
+	 * @note Object is placed after any which compare equal, so items of the same priority
+	 * stay in the order they were added.
+	 */
+	template <typename Compare> bool add(ObjectType* object, Compare compare)
+	{
+		if(object == nullptr) {
+			return false;
+		}
+		object->unlink();
+		auto it = std::find_if(begin(), end(), [&](const ObjectType& item) { return compare(*object, item); });
+		return insertBefore(object, it);
+	}
+
+	bool insert(ObjectType* object)
+	{
+		return DoublyLinkedObjectList::insert(object);
+	}
+
+	bool insertBefore(ObjectType* object, ObjectType* position)
+	{
+		return DoublyLinkedObjectList::insertBefore(object, position);
+	}
+
+	bool remove(ObjectType* object)
+	{
+		return DoublyLinkedObjectList::remove(object);
+	}
+
+	ObjectType* pop()
+	{
+		return static_cast<ObjectType*>(DoublyLinkedObjectList::pop());
+	}
+};
@@ -0,0 +1,115 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/SmingHub/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * FlashMapIndex.h - Hashed lookup for FlashString maps
+ *
+ ****/
+
+#pragma once
+
+#include "StringIndex.h"
+#include <WString.h>
+#include <memory>
+#include <algorithm>
+
+#if __cplusplus >= 201402L
+
+/**
+ * @brief Hashed index for a FlashString Map with String keys
+ *
+ * Looking up a key in a `FSTR::Map` compares it against every key in turn, which becomes slow
+ * for large maps such as those holding web assets. This class hashes each key once and keeps
+ * the hashes sorted, so a lookup is a binary search followed by a single key comparison.
+ *
+ * Map contents are generated at build time in their own order, so the index is built on construction
+ * and uses 8 bytes of RAM per entry. Create it once, after which lookup time does not depend on map size:
+ *
+ *	  IMPORT_FSTR_MAP(fileMap, ...);
+ *	  FlashMapIndex<decltype(fileMap)> fileIndex(fileMap);
+ *
+ *	  int i = fileIndex.indexOf("index.html");
+ *	  if(i >= 0) {
+ *		  auto& content = fileMap.valueAt(i).content();
+ *	  }
+ *
+ * As with `FSTR::Map`, keys are compared without regard to case.
+ * With C++11 the map is searched directly.
+ *
+ * @tparam MapType Type of map, which must have FSTR::String keys
+ */
+template <class MapType> class FlashMapIndex : public StringIndexBase
+{
+public:
+	FlashMapIndex(const MapType& map) : map(map), count(map.length())
+	{
+		entries.reset(new Entry[count]);
+		for(unsigned i = 0; i < count; ++i) {
+			auto& key = map.valueAt(i).key();
+			entries[i] = Entry{hash(key), uint32_t(i | (key.length() << 16))};
+		}
+		std::stable_sort(&entries[0], &entries[count],
+						 [](const Entry& e1, const Entry& e2) { return e1.hash < e2.hash; });
+	}
+
+	/**
+	 * @brief Locate a key
+	 * @retval int Index of map entry, -1 if not found
+	 */
+	int indexOf(const char* key, size_t length) const
+	{
+		if(key == nullptr) {
+			return -1;
+		}
+		auto h = hash(key, length);
+		auto end = &entries[count];
+		for(auto e = lowerBound(&entries[0], end, h); e < end && e->hash == h; ++e) {
+			if(e->length() == length && equalsIgnoreCase(map.valueAt(e->index()).key(), key, length)) {
+				return e->index();
+			}
+		}
+		return -1;
+	}
+
+	int indexOf(const String& key) const
+	{
+		return indexOf(key.c_str(), key.length());
+	}
+
+	const MapType& getMap() const
+	{
+		return map;
+	}
+
+private:
+	const MapType& map;
+	unsigned count;
+	std::unique_ptr<Entry[]> entries;
+};
+
+#else
+
+template <class MapType> class FlashMapIndex
+{
+public:
+	FlashMapIndex(const MapType& map) : map(map)
+	{
+	}
+
+	int indexOf(const String& key) const
+	{
+		return map.indexOf(key);
+	}
+
+	const MapType& getMap() const
+	{
+		return map;
+	}
+
+private:
+	const MapType& map;
+};
+
+#endif
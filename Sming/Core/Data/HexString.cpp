@@ -9,7 +9,87 @@
  */
 
 #include "HexString.h"
-#include <stringutil.h>
+
+namespace
+{
+const char hexDigits[] = "0123456789abcdef";
+
+// Values for characters '0' to 'f', -1 if not a hex digit
+const int8_t hexValues['f' - '0' + 1] = {
+	 0,  1,  2,  3,  4,  5,  6,  7,  8,  9, -1, -1, -1, -1, -1, -1, -1, 10, 11, 12,
+	13, 14, 15, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+	-1, -1, -1, -1, -1, -1, -1, -1, -1, 10, 11, 12, 13, 14, 15,
+};
+
+int decodeChar(char c)
+{
+	unsigned i = uint8_t(c) - '0';
+	return (i < sizeof(hexValues)) ? hexValues[i] : -1;
+}
+
+char* encodeByte(char* out, uint8_t c)
+{
+	out[0] = hexDigits[c >> 4];
+	out[1] = hexDigits[c & 0x0f];
+	return out + 2;
+}
+
+} // namespace
+
+char* hexEncode(const void* data, size_t length, char* output)
+{
+	auto in = static_cast<const uint8_t*>(data);
+	char* out = output;
+
+	while(length != 0 && (uintptr_t(in) & 3) != 0) {
+		out = encodeByte(out, *in++);
+		--length;
+	}
+
+	// Read aligned input a word at a time
+	while(length >= 4) {
+		uint32_t word;
+		memcpy(&word, __builtin_assume_aligned(in, 4), sizeof(word));
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+		out = encodeByte(out, word);
+		out = encodeByte(out, word >> 8);
+		out = encodeByte(out, word >> 16);
+		out = encodeByte(out, word >> 24);
+#else
+		out = encodeByte(out, word >> 24);
+		out = encodeByte(out, word >> 16);
+		out = encodeByte(out, word >> 8);
+		out = encodeByte(out, word);
+#endif
+		in += 4;
+		length -= 4;
+	}
+
+	while(length-- != 0) {
+		out = encodeByte(out, *in++);
+	}
+
+	return out;
+}
+
+int hexDecode(const char* text, size_t length, uint8_t* output)
+{
+	if(length % 2 != 0) {
+		return -1;
+	}
+
+	auto out = output;
+	for(auto end = text + length; text < end; text += 2) {
+		int hi = decodeChar(text[0]);
+		int lo = decodeChar(text[1]);
+		if((hi | lo) < 0) {
+			return -1;
+		}
+		*out++ = (hi << 4) | lo;
+	}
+
+	return out - output;
+}
 
 String makeHexString(const uint8_t* data, unsigned length, char separator)
 {
@@ -28,12 +108,16 @@ String makeHexString(const uint8_t* data, unsigned length, char separator)
 	}
 
 	char* p = result.begin();
+	if(separator == '\0') {
+		hexEncode(data, length, p);
+		return result;
+	}
+
 	for(unsigned i = 0; i < length; ++i) {
-		if(i != 0 && separator != '\0') {
+		if(i != 0) {
 			*p++ = separator;
 		}
-		*p++ = hexchar(data[i] >> 4);
-		*p++ = hexchar(data[i] & 0x0F);
+		p = encodeByte(p, data[i]);
 	}
 
 	return result;
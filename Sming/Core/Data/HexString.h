@@ -21,3 +21,21 @@
  *  @retval String
  */
 String makeHexString(const uint8_t* data, unsigned length, char separator = '\0');
+
+/**
+ * @brief Encode binary data as lower-case hexadecimal characters
+ * @param data
+ * @param length Number of bytes to encode
+ * @param output Buffer for (length * 2) characters, which are not NUL-terminated
+ * @retval char* Points to end of output
+ */
+char* hexEncode(const void* data, size_t length, char* output);
+
+/**
+ * @brief Decode hexadecimal text into binary data
+ * @param text Upper or lower-case hexadecimal characters
+ * @param length Number of characters, must be even
+ * @param output Buffer for (length / 2) bytes
+ * @retval int Number of bytes written to output, -1 if text is not valid hexadecimal
+ */
+int hexDecode(const char* text, size_t length, uint8_t* output);
@@ -0,0 +1,391 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/SmingHub/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * JsonStreamParser.cpp
+ *
+ ****/
+
+#include "JsonStreamParser.h"
+#include <stringutil.h>
+#include <debug_progmem.h>
+
+namespace
+{
+bool isSpace(char c)
+{
+	return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+} // namespace
+
+void JsonStreamParser::reset()
+{
+	path.setLength(0);
+	tokenLength = 0;
+	highSurrogate = 0;
+	arrays = 0;
+	depth = 0;
+	hasKey = false;
+	state = State::value;
+	error = Error::None;
+}
+
+bool JsonStreamParser::parse(const char* data, size_t length)
+{
+	for(size_t i = 0; i < length; ++i) {
+		if(!process(data[i])) {
+			return false;
+		}
+	}
+
+	return error == Error::None;
+}
+
+bool JsonStreamParser::finish()
+{
+	// A number or literal at the root is terminated by the end of data
+	if(state == State::number || state == State::literal) {
+		process(' ');
+	}
+
+	if(error == Error::None && state != State::done) {
+		fail(Error::Incomplete);
+	}
+
+	return error == Error::None;
+}
+
+void JsonStreamParser::fail(Error err)
+{
+	debug_w("[JSON] Parse error %u at '%s'", unsigned(err), path.c_str());
+	error = err;
+	state = State::error;
+}
+
+bool JsonStreamParser::process(char c)
+{
+	switch(state) {
+	case State::firstValue:
+		if(c == ']') {
+			return endContainer(c);
+		}
+		// fall-through
+
+	case State::value:
+		if(isSpace(c)) {
+			return true;
+		}
+		if(c == '{' || c == '[') {
+			return beginContainer(c);
+		}
+		if(c == '"') {
+			isKey = false;
+			tokenLength = 0;
+			state = State::string;
+			return beginValue();
+		}
+		if(c == '-' || isdigit(c)) {
+			state = State::number;
+			tokenLength = 0;
+			return beginValue() && addChar(c);
+		}
+		if(c == 't' || c == 'f' || c == 'n') {
+			state = State::literal;
+			tokenLength = 0;
+			return beginValue() && addChar(c);
+		}
+		break;
+
+	case State::firstKey:
+		if(c == '}') {
+			return endContainer(c);
+		}
+		// fall-through
+
+	case State::key:
+		if(isSpace(c)) {
+			return true;
+		}
+		if(c == '"') {
+			isKey = true;
+			tokenLength = 0;
+			state = State::string;
+			return true;
+		}
+		break;
+
+	case State::colon:
+		if(isSpace(c)) {
+			return true;
+		}
+		if(c == ':') {
+			state = State::value;
+			return true;
+		}
+		break;
+
+	case State::afterValue:
+		if(isSpace(c)) {
+			return true;
+		}
+		if(c == ',') {
+			state = isArray() ? State::value : State::key;
+			return true;
+		}
+		if(c == '}' || c == ']') {
+			return endContainer(c);
+		}
+		break;
+
+	case State::string:
+		if(c == '"') {
+			return endString();
+		}
+		if(c == '\\') {
+			state = State::escape;
+			return true;
+		}
+		if(uint8_t(c) < 0x20) {
+			break;
+		}
+		return addChar(c);
+
+	case State::escape: {
+		state = State::string;
+		const char* escapes = "\"\"\\\\//b\bf\fn\nr\rt\t";
+		for(unsigned i = 0; escapes[i] != '\0'; i += 2) {
+			if(c == escapes[i]) {
+				return addChar(escapes[i + 1]);
+			}
+		}
+		if(c == 'u') {
+			unicode = 0;
+			unicodeDigits = 0;
+			state = State::unicode;
+			return true;
+		}
+		break;
+	}
+
+	case State::unicode: {
+		if(!isxdigit(c)) {
+			break;
+		}
+		unicode = (unicode << 4) | unhex(c);
+		if(++unicodeDigits < 4) {
+			return true;
+		}
+		state = State::string;
+		if(unicode >= 0xD800 && unicode < 0xDC00) {
+			// Wait for second half of surrogate pair
+			highSurrogate = unicode;
+			return true;
+		}
+		uint32_t cp = unicode;
+		if(unicode >= 0xDC00 && unicode < 0xE000 && highSurrogate != 0) {
+			cp = 0x10000 + ((highSurrogate - 0xD800) << 10) + (unicode - 0xDC00);
+		}
+		highSurrogate = 0;
+		return addCodePoint(cp);
+	}
+
+	case State::number:
+		if(isdigit(c) || c == '.' || c == 'e' || c == 'E' || c == '+' || c == '-') {
+			return addChar(c);
+		}
+		if(!endToken(Type::Number)) {
+			return false;
+		}
+		return process(c);
+
+	case State::literal: {
+		if(c >= 'a' && c <= 'z') {
+			return addChar(c);
+		}
+		token[tokenLength] = '\0';
+		Type type;
+		if(strcmp(token, "true") == 0 || strcmp(token, "false") == 0) {
+			type = Type::Boolean;
+		} else if(strcmp(token, "null") == 0) {
+			type = Type::Null;
+		} else {
+			break;
+		}
+		if(!endToken(type)) {
+			return false;
+		}
+		return process(c);
+	}
+
+	case State::done:
+		if(isSpace(c)) {
+			return true;
+		}
+		break;
+
+	case State::error:
+		return false;
+	}
+
+	fail(Error::Syntax);
+	return false;
+}
+
+bool JsonStreamParser::addChar(char c)
+{
+	if(tokenLength >= JSON_PARSER_MAX_TOKEN) {
+		fail(Error::TokenLength);
+		return false;
+	}
+
+	token[tokenLength++] = c;
+	return true;
+}
+
+bool JsonStreamParser::addCodePoint(uint32_t cp)
+{
+	// Encode as UTF-8
+	if(cp < 0x80) {
+		return addChar(cp);
+	}
+	if(cp < 0x800) {
+		return addChar(0xC0 | (cp >> 6)) && addChar(0x80 | (cp & 0x3F));
+	}
+	if(cp < 0x10000) {
+		return addChar(0xE0 | (cp >> 12)) && addChar(0x80 | ((cp >> 6) & 0x3F)) && addChar(0x80 | (cp & 0x3F));
+	}
+	return addChar(0xF0 | (cp >> 18)) && addChar(0x80 | ((cp >> 12) & 0x3F)) && addChar(0x80 | ((cp >> 6) & 0x3F)) &&
+		   addChar(0x80 | (cp & 0x3F));
+}
+
+bool JsonStreamParser::pushPath()
+{
+	path.setLength(pathLengths[depth]);
+	path += '/';
+	if(isArray()) {
+		path += unsigned(indexes[depth - 1]);
+		return true;
+	}
+
+	// Escape as required for JSON Pointer
+	for(auto p = key; *p != '\0'; ++p) {
+		if(*p == '~') {
+			path += "~0";
+		} else if(*p == '/') {
+			path += "~1";
+		} else {
+			path += *p;
+		}
+	}
+	return true;
+}
+
+bool JsonStreamParser::beginValue()
+{
+	if(depth == 0) {
+		path.setLength(0);
+		return true;
+	}
+	return pushPath();
+}
+
+bool JsonStreamParser::endValue()
+{
+	if(depth == 0) {
+		state = State::done;
+		return true;
+	}
+
+	if(isArray()) {
+		++indexes[depth - 1];
+	}
+	path.setLength(pathLengths[depth]);
+	hasKey = false;
+	state = State::afterValue;
+	return true;
+}
+
+bool JsonStreamParser::emit(Type type, const char* value, unsigned length)
+{
+	if(!callback) {
+		return true;
+	}
+
+	bool isMember = hasKey && !isArray();
+	Element element{type, path.c_str(), isMember ? key : nullptr, value, uint16_t(length), depth};
+	if(!callback(element)) {
+		fail(Error::Aborted);
+		return false;
+	}
+	return true;
+}
+
+bool JsonStreamParser::endString()
+{
+	token[tokenLength] = '\0';
+	if(!isKey) {
+		return endToken(Type::String);
+	}
+
+	memcpy(key, token, tokenLength + 1);
+	hasKey = true;
+	state = State::colon;
+	return true;
+}
+
+bool JsonStreamParser::endToken(Type type)
+{
+	token[tokenLength] = '\0';
+	if(type == Type::Null) {
+		if(!emit(type, nullptr, 0)) {
+			return false;
+		}
+	} else if(!emit(type, token, tokenLength)) {
+		return false;
+	}
+	return endValue();
+}
+
+bool JsonStreamParser::beginContainer(char c)
+{
+	if(depth >= JSON_PARSER_MAX_DEPTH) {
+		fail(Error::Depth);
+		return false;
+	}
+
+	bool array = (c == '[');
+	if(!beginValue() || !emit(array ? Type::ArrayStart : Type::ObjectStart, nullptr, 0)) {
+		return false;
+	}
+
+	if(array) {
+		arrays |= BIT(depth);
+	} else {
+		arrays &= ~BIT(depth);
+	}
+	indexes[depth] = 0;
+	++depth;
+	pathLengths[depth] = path.length();
+	hasKey = false;
+	state = array ? State::firstValue : State::firstKey;
+	return true;
+}
+
+bool JsonStreamParser::endContainer(char c)
+{
+	bool array = (c == ']');
+	if(array != isArray()) {
+		fail(Error::Syntax);
+		return false;
+	}
+
+	--depth;
+	hasKey = false;
+	if(!emit(array ? Type::ArrayEnd : Type::ObjectEnd, nullptr, 0)) {
+		return false;
+	}
+	return endValue();
+}
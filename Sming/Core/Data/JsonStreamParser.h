@@ -0,0 +1,191 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/SmingHub/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * JsonStreamParser.h
+ *
+ ****/
+
+#pragma once
+
+#include <WString.h>
+#include <Delegate.h>
+
+/**
+ * @brief Maximum nesting depth of objects and arrays accepted by JsonStreamParser
+ */
+#ifndef JSON_PARSER_MAX_DEPTH
+#define JSON_PARSER_MAX_DEPTH 8
+#endif
+
+/**
+ * @brief Maximum length of a name or value accepted by JsonStreamParser
+ */
+#ifndef JSON_PARSER_MAX_TOKEN
+#define JSON_PARSER_MAX_TOKEN 128
+#endif
+
+static_assert(JSON_PARSER_MAX_DEPTH <= 32, "JSON_PARSER_MAX_DEPTH too large");
+
+/**
+ * @brief Incremental JSON parser
+ *
+ * Data is passed in as it arrives, in pieces of any size. A callback is invoked
+ * for each value and for the start and end of each object and array, so the document
+ * is never held in memory.
+ *
+ * Each element is identified by its path, in JSON Pointer notation (RFC 6901).
+ * For example, in `{"wifi":{"ssid":"x"},"items":[1,2]}` the ssid value has path "/wifi/ssid"
+ * and the second item "/items/1".
+ *
+ * Nesting depth is limited to `JSON_PARSER_MAX_DEPTH`, and names and values to
+ * `JSON_PARSER_MAX_TOKEN` characters. Exceeding either is an error.
+ */
+class JsonStreamParser
+{
+public:
+	enum class Type {
+		ObjectStart,
+		ObjectEnd,
+		ArrayStart,
+		ArrayEnd,
+		String,
+		Number,
+		Boolean,
+		Null,
+	};
+
+	enum class Error {
+		None,
+		Syntax,		 ///< Invalid JSON
+		Depth,		 ///< Nesting too deep
+		TokenLength, ///< Name or value too long
+		Aborted,	 ///< Callback requested parsing to stop
+		Incomplete,  ///< Document ended prematurely
+	};
+
+	/**
+	 * @brief Describes a value, or the start or end of an object or array
+	 */
+	struct Element {
+		Type type;
+		const char* path;  ///< Location within the document, "" for the root element
+		const char* key;   ///< Member name, nullptr for array elements
+		const char* value; ///< Text of value, with strings unescaped. nullptr for objects and arrays.
+		uint16_t length;   ///< Length of value
+		uint8_t level;	 ///< Nesting depth, 0 for the root element
+
+		/**
+		 * @brief Get boolean value
+		 */
+		bool asBool() const
+		{
+			return type == Type::Boolean && value[0] == 't';
+		}
+
+		/**
+		 * @brief Get integer value
+		 * @retval int 0 if not a number
+		 */
+		int asInt() const
+		{
+			return type == Type::Number ? atoi(value) : 0;
+		}
+
+		/**
+		 * @brief Get value as a String, invalid for null values, objects and arrays
+		 */
+		String toString() const
+		{
+			return value ? String(value, length) : nullptr;
+		}
+	};
+
+	/**
+	 * @brief Callback invoked for each element
+	 * @retval bool Return false to stop parsing
+	 */
+	using Callback = Delegate<bool(const Element& element)>;
+
+	JsonStreamParser(Callback callback) : callback(callback)
+	{
+	}
+
+	/**
+	 * @brief Parse more data
+	 * @param data
+	 * @param length
+	 * @retval bool false if an error has been found, either now or previously
+	 */
+	bool parse(const char* data, size_t length);
+
+	/**
+	 * @brief Indicate that all data has been parsed
+	 * @retval bool true if document was complete and valid
+	 */
+	bool finish();
+
+	/**
+	 * @brief Prepare to parse a new document
+	 */
+	void reset();
+
+	Error getError() const
+	{
+		return error;
+	}
+
+private:
+	enum class State {
+		value,		  ///< Expecting a value
+		firstValue,   ///< Start of array, expecting value or end
+		firstKey,	 ///< Start of object, expecting name or end
+		key,		  ///< Expecting name
+		colon,		  ///< Expecting ':' after name
+		afterValue,   ///< Expecting ',' or end of container
+		string,		  ///< Reading string
+		escape,		  ///< Read '\' within string
+		unicode,	  ///< Reading 4-digit hex code
+		number,		  ///< Reading number
+		literal,	  ///< Reading true, false or null
+		done,		  ///< Root value complete
+		error,
+	};
+
+	bool isArray() const
+	{
+		return depth != 0 && (arrays & (1U << (depth - 1)));
+	}
+
+	bool process(char c);
+	bool addChar(char c);
+	bool addCodePoint(uint32_t cp);
+	bool beginValue();
+	bool endValue();
+	bool endString();
+	bool endToken(Type type);
+	bool beginContainer(char c);
+	bool endContainer(char c);
+	bool emit(Type type, const char* value, unsigned length);
+	bool pushPath();
+	void fail(Error err);
+
+	Callback callback;
+	String path;
+	uint16_t pathLengths[JSON_PARSER_MAX_DEPTH + 1]{};
+	uint16_t indexes[JSON_PARSER_MAX_DEPTH]{}; ///< Element index for arrays
+	char token[JSON_PARSER_MAX_TOKEN + 1];
+	char key[JSON_PARSER_MAX_TOKEN + 1];
+	uint16_t tokenLength{0};
+	uint16_t unicode{0};	  ///< Code unit being read from \u escape
+	uint16_t highSurrogate{0}; ///< First half of a surrogate pair
+	uint32_t arrays{0};		   ///< Bit set for each level which is an array
+	uint8_t depth{0};
+	uint8_t unicodeDigits{0};
+	bool isKey{false};  ///< String being read is a name
+	bool hasKey{false}; ///< Key holds name for next value
+	State state{State::value};
+	Error error{Error::None};
+};
@@ -0,0 +1,98 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/SmingHub/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * MemoryClass.cpp
+ *
+ ****/
+
+#include "MemoryClass.h"
+#include <cstdlib>
+#ifdef ARCH_ESP32
+#include <esp_heap_caps.h>
+#endif
+
+namespace Memory
+{
+namespace
+{
+size_t bulkThreshold{MEMORY_BULK_THRESHOLD};
+
+#ifdef ARCH_ESP32
+uint32_t getCaps(size_t size, MemoryClass memClass)
+{
+	switch(memClass) {
+	case MemoryClass::Fast:
+		return MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT;
+	case MemoryClass::Bulk:
+		if(size >= bulkThreshold) {
+			return MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT;
+		}
+		return MALLOC_CAP_DEFAULT;
+	case MemoryClass::Default:
+	default:
+		return MALLOC_CAP_DEFAULT;
+	}
+}
+#endif
+
+} // namespace
+
+void* allocate(size_t size, MemoryClass memClass)
+{
+#ifdef ARCH_ESP32
+	auto caps = getCaps(size, memClass);
+	if(caps != MALLOC_CAP_DEFAULT) {
+		auto ptr = heap_caps_malloc(size, caps);
+		if(ptr != nullptr) {
+			return ptr;
+		}
+	}
+#endif
+	return malloc(size);
+}
+
+void* reallocate(void* ptr, size_t size, MemoryClass memClass)
+{
+#ifdef ARCH_ESP32
+	auto caps = getCaps(size, memClass);
+	if(caps != MALLOC_CAP_DEFAULT) {
+		auto newPtr = heap_caps_realloc(ptr, size, caps);
+		if(newPtr != nullptr || size == 0) {
+			return newPtr;
+		}
+	}
+#endif
+	return realloc(ptr, size);
+}
+
+void setBulkThreshold(size_t size)
+{
+	bulkThreshold = size;
+}
+
+size_t getBulkThreshold()
+{
+	return bulkThreshold;
+}
+
+bool getUsage(bool external, Usage& usage)
+{
+#ifdef ARCH_ESP32
+	multi_heap_info_t info;
+	heap_caps_get_info(&info, (external ? MALLOC_CAP_SPIRAM : MALLOC_CAP_INTERNAL) | MALLOC_CAP_8BIT);
+	usage.free = info.total_free_bytes;
+	usage.total = info.total_free_bytes + info.total_allocated_bytes;
+	usage.minFree = info.minimum_free_bytes;
+	usage.largest = info.largest_free_block;
+	return usage.total != 0;
+#else
+	(void)external;
+	(void)usage;
+	return false;
+#endif
+}
+
+} // namespace Memory
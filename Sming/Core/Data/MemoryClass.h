@@ -0,0 +1,81 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/SmingHub/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * MemoryClass.h - Allocation hints for buffers
+ *
+ ****/
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @brief Default size at or above which bulk allocations may use external RAM
+ */
+#ifndef MEMORY_BULK_THRESHOLD
+#define MEMORY_BULK_THRESHOLD 4096
+#endif
+
+/**
+ * @brief Indicates how a memory block will be used
+ *
+ * On devices with external RAM (e.g. ESP32 with PSRAM) this determines where the block is allocated.
+ * Elsewhere all classes use the main heap.
+ */
+enum class MemoryClass {
+	Default, ///< Standard heap behaviour
+	Fast,	///< Latency-critical, always internal RAM
+	Bulk,	///< Large and infrequently accessed, external RAM if at least the threshold size
+};
+
+namespace Memory
+{
+/**
+ * @brief Allocate a block of memory
+ * @param size
+ * @param memClass
+ * @retval void* Release using `free()`. nullptr if allocation failed.
+ *
+ * If the preferred memory is exhausted then the block is taken from another region.
+ */
+void* allocate(size_t size, MemoryClass memClass);
+
+/**
+ * @brief Resize a block of memory
+ * @param ptr Existing block, may be nullptr
+ * @param size New size
+ * @param memClass Used if the block must be moved
+ * @retval void* nullptr if reallocation failed, in which case the existing block is unchanged
+ */
+void* reallocate(void* ptr, size_t size, MemoryClass memClass);
+
+/**
+ * @brief Set size at or above which MemoryClass::Bulk allocations use external RAM
+ */
+void setBulkThreshold(size_t size);
+
+size_t getBulkThreshold();
+
+/**
+ * @brief Usage information for one type of memory
+ */
+struct Usage {
+	size_t total;	///< Total size
+	size_t free;	 ///< Available
+	size_t minFree;  ///< Lowest value of `free`
+	size_t largest;  ///< Largest block which can be allocated
+};
+
+/**
+ * @brief Get usage information
+ * @param external true for external RAM, false for internal
+ * @param usage On success, contains usage information
+ * @retval bool false if not supported, or external RAM not present
+ */
+bool getUsage(bool external, Usage& usage);
+
+} // namespace Memory
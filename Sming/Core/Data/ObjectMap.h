@@ -12,7 +12,7 @@
 
 #pragma once
 
-#include "WVector.h"
+#include "ValueVector.h"
 
 /**
  * @brief Implementation of a HashMap for owned objects, i.e. anything created with new().
@@ -212,7 +212,7 @@ public:
 			delete entries[i].value;
 			entries[i].value = value;
 		} else {
-			entries.addElement(new Entry(key, value));
+			entries.emplace(key, value);
 		}
 	}
 
@@ -327,13 +327,31 @@ protected:
 		{
 		}
 
+		Entry(const Entry&) = delete;
+
+		Entry(Entry&& other) : key(std::move(other.key)), value(other.value)
+		{
+			other.value = nullptr;
+		}
+
+		Entry& operator=(Entry&& other)
+		{
+			if(this != &other) {
+				delete value;
+				key = std::move(other.key);
+				value = other.value;
+				other.value = nullptr;
+			}
+			return *this;
+		}
+
 		~Entry()
 		{
 			delete value;
 		}
 	};
 
-	Vector<Entry> entries;
+	ValueVector<Entry> entries;
 
 private:
 	// Copy constructor unsafe, so prevent access
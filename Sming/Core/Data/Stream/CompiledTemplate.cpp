@@ -0,0 +1,292 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/SmingHub/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * CompiledTemplate.cpp
+ *
+ ****/
+
+#include "CompiledTemplate.h"
+#include <debug_progmem.h>
+
+/*
+ * Identifies tags one character at a time, so they may span reads from the source.
+ *
+ * The template is scanned twice: first to count tokens, then to store them.
+ */
+class CompiledTemplate::Scanner
+{
+public:
+	Scanner(const CompiledTemplate& tmpl, CompiledTemplate::Token* tokens) : tmpl(tmpl), tokens(tokens)
+	{
+	}
+
+	unsigned scan(IDataSourceStream& source)
+	{
+		char buf[64];
+		uint16_t len;
+		while((len = source.readMemoryBlock(buf, sizeof(buf))) != 0) {
+			for(unsigned i = 0; i < len; ++i) {
+				process(buf[i]);
+				++pos;
+			}
+			source.seek(len);
+		}
+
+		if(state == State::closing) {
+			addTag(pos);
+		}
+		addLiteral(pos);
+		return count;
+	}
+
+private:
+	enum class State {
+		text,
+		brace,	 ///< Found opening brace
+		name,	 ///< Reading variable name
+		closing, ///< Optional second closing brace
+	};
+
+	void process(char c)
+	{
+		switch(state) {
+		case State::text:
+			break;
+
+		case State::brace:
+			if(tmpl.doubleBraces) {
+				if(c == '{') {
+					state = State::name;
+					nameLength = 0;
+					return;
+				}
+			} else if(c > ' ' && c != '"' && c != '{') {
+				state = State::name;
+				nameLength = 0;
+				process(c);
+				return;
+			}
+			break;
+
+		case State::name:
+			if(c == '}') {
+				endName();
+				return;
+			}
+			if(nameLength < TEMPLATE_MAX_VAR_NAME_LEN && c != '{') {
+				name[nameLength++] = c;
+				return;
+			}
+			break;
+
+		case State::closing:
+			if(c == '}') {
+				addTag(pos + 1);
+				return;
+			}
+			addTag(pos);
+			break;
+		}
+
+		// Look for start of next tag
+		if(c == '{') {
+			tagStart = pos;
+			state = State::brace;
+		} else {
+			state = State::text;
+		}
+	}
+
+	void endName()
+	{
+		name[nameLength] = '\0';
+		id = tmpl.names.indexOf(name, false);
+		if(id < 0) {
+			state = State::text;
+		} else if(tmpl.doubleBraces) {
+			// Second closing brace isn't necessary, but if present include it
+			state = State::closing;
+		} else {
+			addTag(pos + 1);
+		}
+	}
+
+	void addTag(uint32_t end)
+	{
+		addLiteral(tagStart);
+		add(tagStart, end - tagStart, id);
+		literalStart = end;
+		state = State::text;
+	}
+
+	void addLiteral(uint32_t end)
+	{
+		while(literalStart < end) {
+			auto len = std::min(end - literalStart, uint32_t(0xffff));
+			add(literalStart, len, Token::literal);
+			literalStart += len;
+		}
+	}
+
+	void add(uint32_t offset, uint16_t length, uint16_t id)
+	{
+		if(tokens != nullptr) {
+			tokens[count] = Token{offset, length, id};
+		}
+		++count;
+	}
+
+	const CompiledTemplate& tmpl;
+	CompiledTemplate::Token* tokens;
+	unsigned count{0};
+	uint32_t pos{0};
+	uint32_t literalStart{0};
+	uint32_t tagStart{0};
+	int id{-1};
+	char name[TEMPLATE_MAX_VAR_NAME_LEN + 1];
+	unsigned nameLength{0};
+	State state{State::text};
+};
+
+bool CompiledTemplate::compile(IDataSourceStream& source)
+{
+	tokens.reset();
+	tokenCount = 0;
+
+	if(source.seekFrom(0, SeekOrigin::Start) != 0) {
+		debug_e("[TMPL] Cannot compile, source doesn't support seeking");
+		return false;
+	}
+	unsigned count = Scanner(*this, nullptr).scan(source);
+
+	std::unique_ptr<Token[]> list(new Token[count]);
+	if(!list || source.seekFrom(0, SeekOrigin::Start) != 0) {
+		return false;
+	}
+	if(Scanner(*this, list.get()).scan(source) != count) {
+		return false;
+	}
+
+	tokens = std::move(list);
+	tokenCount = count;
+	debug_d("[TMPL] Compiled %u tokens", count);
+	return true;
+}
+
+CompiledTemplateStream::CompiledTemplateStream(CompiledTemplate& tmpl, IDataSourceStream* source,
+											   GetValueDelegate getValue, bool owned)
+	: tmpl(tmpl), source(source), getValue(getValue), owned(owned)
+{
+	if(source != nullptr && !tmpl.isCompiled()) {
+		tmpl.compile(*source);
+	}
+}
+
+size_t CompiledTemplateStream::getTokenLength() const
+{
+	return sendingValue ? value.length() : tmpl[tokenIndex].length;
+}
+
+void CompiledTemplateStream::nextToken()
+{
+	if(started) {
+		++tokenIndex;
+	}
+	started = true;
+	tokenPos = 0;
+
+	for(; tokenIndex < tmpl.count(); ++tokenIndex) {
+		auto& tok = tmpl[tokenIndex];
+		if(tok.isLiteral()) {
+			sendingValue = false;
+			return;
+		}
+		value = getValue ? getValue(tok.id) : nullptr;
+		// Emit tag unchanged if there's no value
+		sendingValue = bool(value);
+		if(!sendingValue || value.length() != 0) {
+			return;
+		}
+	}
+
+	value = nullptr;
+	sendingValue = false;
+}
+
+bool CompiledTemplateStream::isFinished()
+{
+	if(source == nullptr) {
+		return true;
+	}
+	if(!started) {
+		nextToken();
+	}
+	return tokenIndex >= tmpl.count();
+}
+
+uint16_t CompiledTemplateStream::readMemoryBlock(char* data, int bufSize)
+{
+	if(data == nullptr || bufSize <= 0 || isFinished()) {
+		return 0;
+	}
+
+	size_t len = std::min(size_t(bufSize), getTokenLength() - tokenPos);
+	if(sendingValue) {
+		memcpy(data, value.c_str() + tokenPos, len);
+		return len;
+	}
+
+	// Avoid seeking where literal follows on directly from previous one
+	int pos = tmpl[tokenIndex].offset + tokenPos;
+	if(sourcePos != pos) {
+		sourcePos = source->seekFrom(pos, SeekOrigin::Start);
+		if(sourcePos != pos) {
+			debug_e("[TMPL] Seek to %d failed", pos);
+			return 0;
+		}
+	}
+	return source->readMemoryBlock(data, len);
+}
+
+int CompiledTemplateStream::seekFrom(int offset, SeekOrigin origin)
+{
+	if(origin == SeekOrigin::Start && offset == 0) {
+		tokenIndex = 0;
+		tokenPos = 0;
+		started = false;
+		sendingValue = false;
+		value = nullptr;
+		streamPos = 0;
+		return streamPos;
+	}
+
+	// Forward-only seeks within current token
+	if(origin != SeekOrigin::Current || offset < 0 || isFinished()) {
+		return -1;
+	}
+
+	if(size_t(offset) > getTokenLength() - tokenPos) {
+		debug_e("[TMPL] seek beyond end of token");
+		return -1;
+	}
+
+	// Source is re-positioned on next read if necessary
+	if(!sendingValue && offset != 0) {
+		int pos = tmpl[tokenIndex].offset + tokenPos;
+		if(sourcePos == pos && source->seek(offset)) {
+			sourcePos += offset;
+		} else {
+			sourcePos = -1;
+		}
+	}
+
+	tokenPos += offset;
+	streamPos += offset;
+	if(tokenPos >= getTokenLength()) {
+		nextToken();
+	}
+	return streamPos;
+}
@@ -0,0 +1,172 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/SmingHub/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * CompiledTemplate.h
+ *
+ ****/
+
+#pragma once
+
+#include "TemplateStream.h"
+#include "../CStringArray.h"
+#include <memory>
+
+/**
+ * @brief Template which has been scanned into a list of literal spans and variable references
+ *
+ * Tags use the same syntax as `TemplateStream`. Each tag naming one of the given variables
+ * is recorded with the index of that variable in the list. Any other text, including tags
+ * for unknown variables, is recorded as a literal span.
+ *
+ * The template is scanned once and the result used for every subsequent render with
+ * `CompiledTemplateStream`, so rendering does not search for tags or compare names.
+ *
+ * Typically a compiled template is declared statically alongside the template content
+ * and compiled on first use.
+ *
+ * @ingroup stream
+ */
+class CompiledTemplate
+{
+public:
+	/**
+	 * @brief Identifies a span of the template
+	 */
+	struct Token {
+		static constexpr uint16_t literal{0xffff};
+
+		uint32_t offset; ///< Position in template
+		uint16_t length; ///< Length of literal text or tag
+		uint16_t id;	 ///< Index of variable, or `literal`
+
+		bool isLiteral() const
+		{
+			return id == literal;
+		}
+	};
+
+	/**
+	 * @brief Construct a template
+	 * @param names Names of variables, in order of identifier
+	 * @param doubleBraces Tags are marked using `{{X}}` instead of `{X}`
+	 */
+	CompiledTemplate(const CStringArray& names, bool doubleBraces = false) : names(names), doubleBraces(doubleBraces)
+	{
+	}
+
+	/**
+	 * @brief Scan a template
+	 * @param source Must support seeking. Position is undefined on return.
+	 * @retval bool true on success
+	 */
+	bool compile(IDataSourceStream& source);
+
+	bool isCompiled() const
+	{
+		return bool(tokens);
+	}
+
+	/**
+	 * @brief Get number of tokens
+	 */
+	unsigned count() const
+	{
+		return tokenCount;
+	}
+
+	const Token& operator[](unsigned index) const
+	{
+		return tokens[index];
+	}
+
+	/**
+	 * @brief Get the name of a variable from its identifier
+	 */
+	const char* getVarName(unsigned id) const
+	{
+		return names[id];
+	}
+
+private:
+	class Scanner;
+
+	const CStringArray names;
+	std::unique_ptr<Token[]> tokens;
+	unsigned tokenCount{0};
+	bool doubleBraces;
+};
+
+/**
+ * @brief Stream which renders a compiled template
+ *
+ * Literal spans are read directly from the source, seeking over each tag.
+ * Values are obtained using the variable identifier.
+ *
+ * If the template has not been compiled, that is done using the source stream on construction.
+ *
+ * Unlike `TemplateStream`, output cannot be enabled or disabled during rendering.
+ *
+ * @ingroup stream
+ */
+class CompiledTemplateStream : public IDataSourceStream
+{
+public:
+	/**
+	 * @brief Callback type to return values
+	 * @param id Index of variable, as given to `CompiledTemplate`
+	 * @retval String Invalid String to emit tag unchanged
+	 */
+	using GetValueDelegate = Delegate<String(unsigned id)>;
+
+	/**
+	 * @brief Create a stream to render a template
+	 * @param tmpl The compiled template. Must remain valid for the lifetime of this stream.
+	 * @param source The template content, which must support seeking
+	 * @param getValue Callback to obtain values
+	 * @param owned If true (default) then source will be destroyed with this stream
+	 */
+	CompiledTemplateStream(CompiledTemplate& tmpl, IDataSourceStream* source, GetValueDelegate getValue,
+						   bool owned = true);
+
+	~CompiledTemplateStream()
+	{
+		if(owned) {
+			delete source;
+		}
+	}
+
+	StreamType getStreamType() const override
+	{
+		return (source && tmpl.isCompiled()) ? eSST_Template : eSST_Invalid;
+	}
+
+	uint16_t readMemoryBlock(char* data, int bufSize) override;
+
+	int seekFrom(int offset, SeekOrigin origin) override;
+
+	bool isFinished() override;
+
+	String getName() const override
+	{
+		return source ? source->getName() : nullptr;
+	}
+
+private:
+	void nextToken();
+	size_t getTokenLength() const;
+
+	const CompiledTemplate& tmpl;
+	IDataSourceStream* source;
+	GetValueDelegate getValue;
+	String value;
+	uint32_t streamPos{0};	  ///< Position in output stream
+	int sourcePos{-1};		  ///< Current position in source, -1 if unknown
+	unsigned tokenIndex{0};	  ///< Token being sent
+	size_t tokenPos{0};		  ///< How much of token has been sent
+	bool started{false};	  ///< Set once first token has been evaluated
+	bool sendingValue{false}; ///< Current token is a variable with a value
+	bool owned;
+};
@@ -30,6 +30,22 @@ int IDataSourceStream::peek()
 	return -1;
 }
 
+unsigned IDataSourceStream::peekBlocks(Block* blocks, unsigned maxBlocks, size_t maxLength)
+{
+	if(maxBlocks == 0 || maxLength == 0) {
+		return 0;
+	}
+
+	size_t length;
+	auto data = peekBlock(length);
+	if(data == nullptr || length == 0) {
+		return 0;
+	}
+
+	blocks[0] = Block{data, std::min(length, maxLength)};
+	return 1;
+}
+
 size_t IDataSourceStream::readBytes(char* buffer, size_t length)
 {
 	auto count = readMemoryBlock(buffer, length);
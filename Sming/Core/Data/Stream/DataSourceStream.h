@@ -75,6 +75,42 @@ public:
      */
 	virtual uint16_t readMemoryBlock(char* data, int bufSize) = 0;
 
+	/**
+	 * @brief Get a pointer to the next contiguous block of unread data
+	 * @param length On return, number of bytes available at the returned location
+	 * @retval const char* nullptr if direct access is not supported by the stream
+	 * @note Memory-resident streams implement this so that data may be consumed without
+	 * first being copied into an intermediate buffer.
+	 * The stream position is not changed: call `seek()` once the data has been consumed.
+	 * The pointer is only valid until the stream is next modified or destroyed.
+	 */
+	virtual const char* peekBlock(size_t& length)
+	{
+		length = 0;
+		return nullptr;
+	}
+
+	/**
+	 * @brief Describes a contiguous block of unread data
+	 */
+	struct Block {
+		const char* data;
+		size_t length;
+	};
+
+	/**
+	 * @brief Get pointers to several blocks of unread data
+	 * @param blocks Array to receive block descriptors
+	 * @param maxBlocks Number of entries in array
+	 * @param maxLength Stop once this many bytes have been described
+	 * @retval unsigned Number of blocks returned, 0 if direct access is not supported
+	 * @note As with `peekBlock()` the stream position is not changed:
+	 * call `seek()` with the total length consumed.
+	 * Streams composed of other streams override this so that blocks from several sources
+	 * may be consumed in one pass.
+	 */
+	virtual unsigned peekBlocks(Block* blocks, unsigned maxBlocks, size_t maxLength);
+
 	/**
 	 * @brief Read one character and moves the stream pointer
 	 * @retval The character that was read or -1 if none is available
@@ -39,6 +39,15 @@ public:
 		return stream ? stream->readMemoryBlock(data, bufSize) : 0;
 	}
 
+	const char* peekBlock(size_t& length) override
+	{
+		if(stream == nullptr) {
+			length = 0;
+			return nullptr;
+		}
+		return stream->peekBlock(length);
+	}
+
 	bool seek(int len) override;
 
 	/** @brief  Write chars to stream
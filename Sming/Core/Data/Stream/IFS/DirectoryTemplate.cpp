@@ -12,6 +12,9 @@
 
 #include "DirectoryTemplate.h"
 #include <DateTime.h>
+#include <Clock.h>
+#include <Storage/Device.h>
+#include <Data/StringIndex.h>
 #include <FlashString/Vector.hpp>
 
 namespace IFS
@@ -26,8 +29,188 @@ DIRSTREAM_FIELD_MAP(XX)
 DEFINE_FSTR_VECTOR(fieldStrings, FSTR::String, DIRSTREAM_FIELD_MAP(XX))
 #undef XX
 
+#define XX(name, comment) #name,
+constexpr const char* fieldNameList[]{DIRSTREAM_FIELD_MAP(XX)};
+#undef XX
+constexpr StringIndex<ARRAY_SIZE(fieldNameList)> fieldIndex PROGMEM{fieldNameList};
+
+/*
+ * Directories kept open at the end of a page so the next page can continue from there.
+ * Any write to the partition containing the filesystem discards them.
+ */
+class CursorCache : public Storage::WriteObserver
+{
+public:
+	bool park(Directory* dir, uint32_t id)
+	{
+		auto fs = dir->getFileSystem();
+		FileSystem::Info info;
+		if(fs == nullptr || fs->getinfo(info) != FS_OK || !info.partition) {
+			return false;
+		}
+
+		if(!registered) {
+			registered = Storage::Device::addWriteObserver(*this);
+		}
+
+		auto now = millis();
+		Entry* slot = &entries[0];
+		for(auto& e : entries) {
+			if(!e.dir) {
+				slot = &e;
+				break;
+			}
+			if(now - e.time > now - slot->time) {
+				slot = &e;
+			}
+		}
+		slot->dir.reset(dir);
+		slot->partition = info.partition;
+		slot->id = id;
+		slot->time = now;
+		return true;
+	}
+
+	/*
+	 * Obtain the parked directory for a cursor, provided it is listing the same location
+	 */
+	Directory* take(uint32_t id, const Directory& match)
+	{
+		expire();
+		for(auto& e : entries) {
+			if(!e.dir || e.id != id) {
+				continue;
+			}
+			Directory* dir = e.dir.release();
+			if(dir->getFileSystem() == match.getFileSystem() && dir->getPath() == match.getPath()) {
+				return dir;
+			}
+			delete dir;
+			break;
+		}
+		return nullptr;
+	}
+
+	void clear()
+	{
+		for(auto& e : entries) {
+			e.dir.reset();
+		}
+	}
+
+	void onDeviceWrite(Storage::Device& device, uint32_t address, size_t size) override
+	{
+		for(auto& e : entries) {
+			if(!e.dir || e.partition.getDevice() != &device) {
+				continue;
+			}
+			if(address <= e.partition.lastAddress() && address + size > e.partition.address()) {
+				e.dir.reset();
+			}
+		}
+	}
+
+private:
+	struct Entry {
+		std::unique_ptr<Directory> dir;
+		Storage::Partition partition;
+		uint32_t id{0};
+		uint32_t time{0};
+	};
+
+	void expire()
+	{
+		auto now = millis();
+		for(auto& e : entries) {
+			if(e.dir && now - e.time >= DirectoryTemplate::cursorTimeout) {
+				e.dir.reset();
+			}
+		}
+	}
+
+	Entry entries[DirectoryTemplate::maxCursors];
+	bool registered{false};
+};
+
+CursorCache cursorCache;
+uint32_t lastCursorId;
+
 } // namespace
 
+DirectoryTemplate::~DirectoryTemplate()
+{
+	if(nextCursorId == 0 || !cursorCache.park(directory, nextCursorId)) {
+		delete directory;
+	}
+}
+
+void DirectoryTemplate::releaseCursors()
+{
+	cursorCache.clear();
+}
+
+bool DirectoryTemplate::setCursor(const String& cursor, unsigned limit)
+{
+	char* end;
+	auto id = strtoul(cursor.c_str(), &end, 16);
+	if(id == 0 || *end != '.') {
+		return false;
+	}
+	auto offset = strtoul(end + 1, &end, 10);
+	if(*end != '\0') {
+		return false;
+	}
+	setPage(offset, limit);
+	cursorId = id;
+	return true;
+}
+
+bool DirectoryTemplate::seekPage()
+{
+	if(cursorId != 0) {
+		auto dir = cursorCache.take(cursorId, *directory);
+		if(dir != nullptr) {
+			// Continue with the entry read at the end of the previous page
+			delete directory;
+			directory = dir;
+			return true;
+		}
+	}
+
+	for(unsigned i = 0; directory->next(); ++i) {
+		if(i >= pageOffset) {
+			return true;
+		}
+	}
+	return false;
+}
+
+bool DirectoryTemplate::nextRecord()
+{
+	if(sectionIndex() != 1) {
+		return recordIndex() < 0;
+	}
+
+	if(recordIndex() < 0) {
+		return seekPage();
+	}
+
+	if(!directory->next()) {
+		return false;
+	}
+
+	if(pageLimit == 0 || unsigned(recordIndex() + 1) < pageLimit) {
+		return true;
+	}
+
+	// Page is full. The entry just read starts the next one.
+	if(++lastCursorId == 0) {
+		++lastCursorId;
+	}
+	nextCursorId = lastCursorId;
+	return false;
+}
+
 String DirectoryTemplate::getValue(const char* name)
 {
 	String value = SectionTemplate::getValue(name);
@@ -35,7 +218,7 @@ String DirectoryTemplate::getValue(const char* name)
 		return value;
 	}
 
-	int i = fieldStrings.indexOf(name);
+	int i = fieldIndex.indexOf(fieldStrings, name);
 	auto field = Field(i + 1);
 
 	auto& d = dir();
@@ -110,6 +293,18 @@ String DirectoryTemplate::getValue(const char* name)
 
 	case Field::last_error:
 		return d.getLastErrorString();
+
+	case Field::next_offset:
+		return nextCursorId ? String(pageOffset + pageLimit) : "";
+
+	case Field::next_cursor:
+		if(nextCursorId == 0) {
+			return "";
+		}
+		value = String(nextCursorId, HEX);
+		value += '.';
+		value += pageOffset + pageLimit;
+		return value;
 	}
 
 	return nullptr;
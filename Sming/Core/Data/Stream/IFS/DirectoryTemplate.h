@@ -31,17 +31,25 @@
 	XX(total_size, "Total size of files processed (in bytes)")                                                         \
 	XX(path, "Path to containing directory")                                                                           \
 	XX(parent, "Path to parent directory (if any)")                                                                    \
-	XX(last_error, "Last error message")
+	XX(last_error, "Last error message")                                                                               \
+	XX(next_offset, "Offset of first entry on the next page, empty if there are no more")                              \
+	XX(next_cursor, "Cursor for continuing to the next page, empty if there are no more")
 
 namespace IFS
 {
 /**
   * @brief      Directory stream class
   * @ingroup    stream data
+  *
+  * By default the entire directory is listed. For large directories call `setPage()` or `setCursor()`
+  * to list a limited number of entries at a time.
  */
 class DirectoryTemplate : public SectionTemplate
 {
 public:
+	static constexpr unsigned maxCursors{2};		///< Directories kept open for continuation
+	static constexpr uint32_t cursorTimeout{30000}; ///< Milliseconds before an unused cursor is released
+
 	enum class Field {
 		unknown = 0,
 #define XX(name, comment) name,
@@ -53,30 +61,64 @@ public:
 	{
 	}
 
-	~DirectoryTemplate()
-	{
-		delete directory;
-	}
+	~DirectoryTemplate();
 
+	/**
+	 * @brief Access the directory being listed
+	 * @note When continuing from a cursor the directory object is replaced by the one
+	 * used for the previous page, so don't retain this reference.
+	 */
 	Directory& dir()
 	{
 		return *directory;
 	}
 
-	bool nextRecord() override
+	/**
+	 * @brief List a range of entries
+	 * @param offset Zero-based index of first entry to list
+	 * @param limit Maximum number of entries to list, 0 for no limit
+	 *
+	 * The directory must be read from the start to reach `offset`, which can be slow for large directories.
+	 * Where possible use `setCursor()` instead.
+	 */
+	void setPage(unsigned offset, unsigned limit)
 	{
-		if(sectionIndex() == 1) {
-			return directory->next();
-		}
-
-		return recordIndex() < 0;
+		pageOffset = offset;
+		pageLimit = limit;
+		cursorId = 0;
 	}
 
+	/**
+	 * @brief Continue listing from the end of a previous page
+	 * @param cursor Value of the `next_cursor` field emitted by the previous page
+	 * @param limit Maximum number of entries to list, 0 for no limit
+	 * @retval bool false if cursor is invalid
+	 *
+	 * The previous page keeps its directory open for a short time so that listing can continue
+	 * without reading the preceding entries again. If it has since expired, or the filesystem has been
+	 * written to, this behaves as `setPage()`.
+	 */
+	bool setCursor(const String& cursor, unsigned limit);
+
+	/**
+	 * @brief Close all directories held open for cursors
+	 * @note Call this before unmounting a filesystem
+	 */
+	static void releaseCursors();
+
+	bool nextRecord() override;
+
 protected:
 	String getValue(const char* name) override;
 
 private:
+	bool seekPage();
+
 	Directory* directory;
+	unsigned pageOffset{0};
+	unsigned pageLimit{0};
+	uint32_t cursorId{0};	  ///< Identifies parked directory to continue from
+	uint32_t nextCursorId{0}; ///< Set when there are more entries to list
 };
 
 } // namespace IFS
@@ -12,8 +12,21 @@
 
 #define ETAG_SIZE 16
 
+/**
+ * @brief Default number of read-ahead buffers reserved in the shared pool
+ */
+#ifndef FILESTREAM_BUFFER_POOL_SIZE
+#define FILESTREAM_BUFFER_POOL_SIZE 0
+#endif
+
 namespace IFS
 {
+ObjectPool::Pool& FileStream::getBufferPool()
+{
+	static ObjectPool::Pool pool("FileStream", FILESTREAM_BUFFER_SIZE, FILESTREAM_BUFFER_POOL_SIZE);
+	return pool;
+}
+
 void FileStream::attach(FileHandle file, size_t size)
 {
 	close();
@@ -27,6 +40,8 @@ void FileStream::attach(FileHandle file, size_t size)
 	this->size = size;
 	fs->lseek(handle, 0, SeekOrigin::Start);
 	pos = 0;
+	filePos = 0;
+	bufferLength = 0;
 
 	debug_d("attached file: '%s' (%u bytes) #0x%08X", fileName().c_str(), size, this);
 }
@@ -62,39 +77,121 @@ void FileStream::close()
 		fs->close(handle);
 		handle = -1;
 	}
+	releaseBuffer();
 	size = 0;
 	pos = 0;
 	lastError = FS_OK;
 }
 
-size_t FileStream::readBytes(char* buffer, size_t length)
+void FileStream::releaseBuffer()
 {
-	if(buffer == nullptr || length == 0 || pos >= size) {
-		return 0;
+	if(buffer != nullptr) {
+		getBufferPool().release(buffer);
+		buffer = nullptr;
 	}
+	bufferLength = 0;
+}
 
-	GET_FS(0)
+bool FileStream::seekFile(size_t offset)
+{
+	if(offset == filePos) {
+		return true;
+	}
+
+	GET_FS(false)
+
+	int res = fs->lseek(handle, offset, SeekOrigin::Start);
+	if(!check(res)) {
+		return false;
+	}
+	filePos = size_t(res);
+	return filePos == offset;
+}
+
+bool FileStream::fillBuffer()
+{
+	if(bufferSize == 0 || pos >= size) {
+		return false;
+	}
+
+	if(buffer == nullptr) {
+		buffer = static_cast<char*>(getBufferPool().allocate(bufferSize));
+		if(buffer == nullptr) {
+			return false;
+		}
+	}
+
+	GET_FS(false)
 
-	int available = fs->read(handle, buffer, std::min(size - pos, length));
-	if(!check(available)) {
+	bufferLength = 0;
+	if(!seekFile(pos)) {
+		return false;
+	}
+
+	int count = fs->read(handle, buffer, std::min(size - pos, size_t(bufferSize)));
+	if(!check(count)) {
+		return false;
+	}
+
+	filePos += size_t(count);
+	bufferPos = pos;
+	bufferLength = count;
+	return count != 0;
+}
+
+const char* FileStream::peekBlock(size_t& length)
+{
+	length = buffered();
+	if(length == 0 && fillBuffer()) {
+		length = buffered();
+	}
+	return (length == 0) ? nullptr : &buffer[pos - bufferPos];
+}
+
+size_t FileStream::readBytes(char* buffer, size_t length)
+{
+	if(buffer == nullptr || length == 0 || pos >= size) {
 		return 0;
 	}
 
-	pos += size_t(available);
+	length = std::min(size - pos, length);
+	size_t count{0};
+	while(count < length) {
+		auto n = buffered();
+		if(n != 0) {
+			n = std::min(n, length - count);
+			memcpy(&buffer[count], &this->buffer[pos - bufferPos], n);
+		} else if(length - count >= bufferSize) {
+			// Large reads bypass the buffer
+			GET_FS(count)
+			if(!seekFile(pos)) {
+				break;
+			}
+			int res = fs->read(handle, &buffer[count], length - count);
+			if(!check(res) || res == 0) {
+				break;
+			}
+			n = size_t(res);
+			filePos += n;
+		} else if(!fillBuffer()) {
+			break;
+		} else {
+			continue;
+		}
+		count += n;
+		pos += n;
+	}
 
-	return available;
+	return count;
 }
 
 uint16_t FileStream::readMemoryBlock(char* data, int bufSize)
 {
-	GET_FS(0)
-
 	assert(bufSize >= 0);
+
+	// Stream position is restored afterwards, but data read is retained in the buffer
 	size_t startPos = pos;
 	size_t count = readBytes(data, bufSize);
-
-	// Move cursor back to start position
-	(void)fs->lseek(handle, startPos, SeekOrigin::Start);
 	pos = startPos;
 
 	return count;
@@ -104,18 +201,19 @@ size_t FileStream::write(const uint8_t* buffer, size_t size)
 {
 	GET_FS(0)
 
-	if(pos != this->size) {
+	if(pos != this->size || filePos != this->size) {
 		int writePos = fs->lseek(handle, 0, SeekOrigin::End);
 		if(!check(writePos)) {
 			return 0;
 		}
 
-		pos = size_t(writePos);
+		pos = filePos = size_t(writePos);
 	}
 
 	int written = fs->write(handle, buffer, size);
 	if(check(written)) {
 		pos += size_t(written);
+		filePos = pos;
 		this->size = pos;
 	}
 
@@ -126,11 +224,32 @@ int FileStream::seekFrom(int offset, SeekOrigin origin)
 {
 	GET_FS(lastError)
 
+	int64_t target;
+	switch(origin) {
+	case SeekOrigin::Start:
+		target = offset;
+		break;
+	case SeekOrigin::Current:
+		target = int64_t(pos) + offset;
+		break;
+	case SeekOrigin::End:
+		target = int64_t(size) + offset;
+		break;
+	default:
+		target = -1;
+	}
+
+	// Moving within the file needs no filesystem access
+	if(target >= 0 && target <= int64_t(size)) {
+		pos = size_t(target);
+		return pos;
+	}
+
 	// Cannot rely on return value from fileSeek - failure does not mean position hasn't changed
 	fs->lseek(handle, offset, origin);
 	int newpos = fs->tell(handle);
 	if(check(newpos)) {
-		pos = size_t(newpos);
+		pos = filePos = size_t(newpos);
 		if(pos > size) {
 			size = pos;
 		}
@@ -191,6 +310,11 @@ bool FileStream::truncate(size_t newSize)
 		if(pos > size) {
 			pos = size;
 		}
+		if(bufferPos + bufferLength > size) {
+			bufferLength = (size > bufferPos) ? size - bufferPos : 0;
+		}
+		// Don't make assumptions about where this leaves the file pointer
+		filePos = SIZE_MAX;
 	}
 	return res;
 }
@@ -12,12 +12,27 @@
 
 #include "../ReadWriteStream.h"
 #include <IFS/FsBase.h>
+#include <ObjectPool.h>
+
+/**
+ * @brief Default size of read-ahead buffer for file streams, 0 to disable
+ */
+#ifndef FILESTREAM_BUFFER_SIZE
+#define FILESTREAM_BUFFER_SIZE 512
+#endif
 
 namespace IFS
 {
 /**
  * @brief    File stream class
  * @ingroup  stream data
+ *
+ * Reads are made through a read-ahead buffer, which is exposed via `peekBlock()`.
+ * Consumers such as `TcpConnection` which peek at data then seek past what they managed to send
+ * therefore only read each block from the filesystem once. Seeking within the file only
+ * updates the stream position: the file itself is repositioned when next accessed.
+ *
+ * Buffers are obtained from a shared pool, see `getBufferPool()`.
  */
 class FileStream : public FsBase, public ReadWriteStream
 {
@@ -29,6 +44,25 @@ public:
 		close();
 	}
 
+	/**
+	 * @brief Set size of read-ahead buffer
+	 * @param size Use 0 to disable buffering
+	 * @note Any currently buffered data is discarded
+	 */
+	void setReadAhead(uint16_t size)
+	{
+		releaseBuffer();
+		bufferSize = size;
+	}
+
+	/**
+	 * @brief Pool shared by read-ahead buffers of the default size
+	 *
+	 * By default buffers come from the heap: call `getBufferPool().reserve()` to pre-allocate buffers
+	 * for the expected number of concurrently open streams.
+	 */
+	static ObjectPool::Pool& getBufferPool();
+
 	/** @brief Attach this stream object to an open file handle
 	 *  @param file
 	 *  @param size
@@ -66,12 +100,13 @@ public:
 
 	uint16_t readMemoryBlock(char* data, int bufSize) override;
 
+	const char* peekBlock(size_t& length) override;
+
 	int seekFrom(int offset, SeekOrigin origin) override;
 
 	bool isFinished() override
 	{
-		auto fs = getFileSystem();
-		return fs == nullptr || lastError != FS_OK || fs->eof(handle) != 0;
+		return getFileSystem() == nullptr || lastError != FS_OK || pos >= size;
 	}
 
 	/** @brief Filename of file stream is attached to
@@ -147,9 +182,28 @@ public:
 	}
 
 private:
+	/**
+	 * @brief Get number of bytes buffered from the current position
+	 */
+	size_t buffered() const
+	{
+		return (bufferLength != 0 && pos >= bufferPos && pos < bufferPos + bufferLength)
+				   ? bufferPos + bufferLength - pos
+				   : 0;
+	}
+
+	bool fillBuffer();
+	void releaseBuffer();
+	bool seekFile(size_t offset);
+
 	FileHandle handle{-1};
 	size_t pos{0};
 	size_t size{0};
+	size_t filePos{0};		 ///< Actual position of file handle
+	size_t bufferPos{0};	 ///< File offset of buffer contents
+	char* buffer{nullptr};
+	uint16_t bufferSize{FILESTREAM_BUFFER_SIZE};
+	uint16_t bufferLength{0}; ///< Number of valid bytes in buffer
 };
 
 } // namespace IFS
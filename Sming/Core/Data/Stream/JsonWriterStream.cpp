@@ -0,0 +1,264 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/SmingHub/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * JsonWriterStream.cpp
+ *
+ ****/
+
+#include "JsonWriterStream.h"
+#include <debug_progmem.h>
+#include <stringutil.h>
+#include <stringconversion.h>
+#include <cmath>
+
+void JsonWriterStream::beginValue()
+{
+	if(depth == 0) {
+		return;
+	}
+
+	uint32_t bit = BIT(depth - 1);
+	if(arrays & bit) {
+		if(notEmpty & bit) {
+			buffer += ',';
+		}
+		notEmpty |= bit;
+	} else if(named) {
+		named = false;
+	} else {
+		debug_w("[JSON] Object member has no name");
+	}
+}
+
+void JsonWriterStream::name(const String& name)
+{
+	if(depth == 0 || (arrays & BIT(depth - 1))) {
+		debug_w("[JSON] Name '%s' not within object", name.c_str());
+		return;
+	}
+
+	uint32_t bit = BIT(depth - 1);
+	if(notEmpty & bit) {
+		buffer += ',';
+	}
+	notEmpty |= bit;
+	writeString(name.c_str(), name.length());
+	buffer += ':';
+	named = true;
+}
+
+void JsonWriterStream::begin(char c, const String& name)
+{
+	if(depth >= maxDepth) {
+		debug_e("[JSON] Nesting too deep");
+		return;
+	}
+
+	if(name) {
+		this->name(name);
+	}
+	beginValue();
+	buffer += c;
+
+	uint32_t bit = BIT(depth);
+	if(c == '[') {
+		arrays |= bit;
+	} else {
+		arrays &= ~bit;
+	}
+	notEmpty &= ~bit;
+	++depth;
+}
+
+void JsonWriterStream::end(char c)
+{
+	if(depth == 0) {
+		debug_e("[JSON] Unexpected '%c'", c);
+		return;
+	}
+
+	--depth;
+	bool isArray = arrays & BIT(depth);
+	if(isArray != (c == ']')) {
+		debug_w("[JSON] Mismatched '%c'", c);
+	}
+	buffer += isArray ? ']' : '}';
+	named = false;
+}
+
+void JsonWriterStream::beginObject(const String& name)
+{
+	begin('{', name);
+}
+
+void JsonWriterStream::endObject()
+{
+	end('}');
+}
+
+void JsonWriterStream::beginArray(const String& name)
+{
+	begin('[', name);
+}
+
+void JsonWriterStream::endArray()
+{
+	end(']');
+}
+
+void JsonWriterStream::writeString(const char* str, size_t length)
+{
+	buffer += '"';
+
+	// Copy runs of characters which don't need escaping
+	size_t start{0};
+	for(size_t i = 0; i < length; ++i) {
+		auto c = uint8_t(str[i]);
+		if(c >= 0x20 && c != '"' && c != '\\') {
+			continue;
+		}
+
+		buffer.concat(&str[start], i - start);
+		start = i + 1;
+		buffer += '\\';
+		switch(c) {
+		case '"':
+		case '\\':
+			buffer += char(c);
+			break;
+		case '\b':
+			buffer += 'b';
+			break;
+		case '\f':
+			buffer += 'f';
+			break;
+		case '\n':
+			buffer += 'n';
+			break;
+		case '\r':
+			buffer += 'r';
+			break;
+		case '\t':
+			buffer += 't';
+			break;
+		default:
+			buffer += "u00";
+			buffer += hexchar(c >> 4);
+			buffer += hexchar(c & 0x0f);
+		}
+	}
+	buffer.concat(&str[start], length - start);
+
+	buffer += '"';
+}
+
+void JsonWriterStream::value(const char* str)
+{
+	if(str == nullptr) {
+		nullValue();
+		return;
+	}
+	beginValue();
+	writeString(str, strlen(str));
+}
+
+void JsonWriterStream::value(const String& str)
+{
+	if(!str) {
+		nullValue();
+		return;
+	}
+	beginValue();
+	writeString(str.c_str(), str.length());
+}
+
+void JsonWriterStream::value(bool b)
+{
+	beginValue();
+	buffer += b ? "true" : "false";
+}
+
+void JsonWriterStream::writeFloat(double number, int decimalPlaces, bool isFloat)
+{
+	if(std::isnan(number) || std::isinf(number)) {
+		nullValue();
+		return;
+	}
+	beginValue();
+	char buf[DTOA_SHORTEST_BUFSIZE];
+	size_t len;
+	if(decimalPlaces >= 0 && decimalPlaces <= 9 && std::fabs(number) < 1e9) {
+		len = dtoa_fixed(number, buf, decimalPlaces);
+	} else if(isFloat) {
+		len = ftoa_shortest(float(number), buf);
+	} else {
+		len = dtoa_shortest(number, buf);
+	}
+	buffer.concat(buf, len);
+}
+
+void JsonWriterStream::writeInteger(uint64_t number, bool isSigned)
+{
+	beginValue();
+	if(isSigned) {
+		buffer += (long long)number;
+	} else {
+		buffer += (unsigned long long)number;
+	}
+}
+
+void JsonWriterStream::nullValue()
+{
+	beginValue();
+	buffer += "null";
+}
+
+void JsonWriterStream::raw(const String& json)
+{
+	beginValue();
+	buffer += json;
+}
+
+void JsonWriterStream::fill()
+{
+	// Discard content which has been read, keeping the allocation
+	buffer.setLength(0);
+	readPos = 0;
+
+	while(!finished && buffer.length() < bufferSize) {
+		if(!producer || !producer(*this)) {
+			while(depth != 0) {
+				end((arrays & BIT(depth - 1)) ? ']' : '}');
+			}
+			finished = true;
+		}
+	}
+}
+
+uint16_t JsonWriterStream::readMemoryBlock(char* data, int bufSize)
+{
+	if(data == nullptr || bufSize <= 0) {
+		return 0;
+	}
+
+	if(readPos >= buffer.length()) {
+		fill();
+	}
+
+	size_t len = std::min(size_t(bufSize), buffer.length() - readPos);
+	memcpy(data, buffer.c_str() + readPos, len);
+	return len;
+}
+
+bool JsonWriterStream::seek(int len)
+{
+	if(len < 0 || size_t(len) > buffer.length() - readPos) {
+		return false;
+	}
+
+	readPos += len;
+	return true;
+}
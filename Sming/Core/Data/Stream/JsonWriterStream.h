@@ -0,0 +1,182 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/SmingHub/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * JsonWriterStream.h
+ *
+ ****/
+
+#pragma once
+
+#include "DataSourceStream.h"
+#include <Delegate.h>
+#include <type_traits>
+
+/**
+ * @brief Read-only stream which generates JSON incrementally
+ *
+ * Content is obtained from a producer callback, which is invoked whenever the stream
+ * needs more data. Each call writes the next part of the document, such as a single
+ * array element, using the writer methods. Only content produced but not yet read is held
+ * in memory, so document size is not limited by available RAM.
+ *
+ * Commas, colons and string escaping are handled by the writer.
+ * When the producer indicates completion, any open objects or arrays are closed.
+ *
+ * For example:
+ *
+ * ```
+ * unsigned index{0};
+ * auto stream = new JsonWriterStream([&index](JsonWriterStream& json) {
+ *     if(index == 0) {
+ *         json.beginObject();
+ *         json.beginArray("readings");
+ *     }
+ *     json.value(readings[index++]);
+ *     return index < readingCount;
+ * });
+ * response.sendDataStream(stream, MIME_JSON);
+ * ```
+ *
+ * Stream length is not known in advance, so HTTP responses use chunked encoding.
+ *
+ * @ingroup stream
+ */
+class JsonWriterStream : public IDataSourceStream
+{
+public:
+	/**
+	 * @brief Maximum nesting depth for objects and arrays
+	 */
+	static constexpr unsigned maxDepth{32};
+
+	/**
+	 * @brief Callback to produce content
+	 * @param writer This stream
+	 * @retval bool true if there is more to come, false when document is complete
+	 */
+	using Producer = Delegate<bool(JsonWriterStream& writer)>;
+
+	/**
+	 * @brief Construct a writer stream
+	 * @param producer Invoked to write content
+	 * @param bufferSize Producer is called until at least this amount of output is available
+	 */
+	JsonWriterStream(Producer producer, size_t bufferSize = 256) : producer(producer), bufferSize(bufferSize)
+	{
+	}
+
+	/**
+	 * @name Write structure
+	 * @param name Name of member, if inside an object
+	 * @{
+	 */
+	void beginObject(const String& name = nullptr);
+	void endObject();
+	void beginArray(const String& name = nullptr);
+	void endArray();
+	/** @} */
+
+	/**
+	 * @brief Write name for the next value
+	 *
+	 * Required for all values written inside an object.
+	 */
+	void name(const String& name);
+
+	/**
+	 * @name Write values
+	 * @{
+	 */
+	void value(const char* str);
+
+	void value(const String& str);
+
+	void value(bool b);
+
+	/**
+	 * @brief Write a floating-point value
+	 * @param number NaN and infinite values are written as null
+	 * @param decimalPlaces Number of digits after the decimal point.
+	 * Use -1 for the shortest representation which reads back as the same value.
+	 * @note The shortest representation is also used for values of 1e9 or more, or more than 9 decimal places
+	 */
+	void value(double number, int decimalPlaces = 2)
+	{
+		writeFloat(number, decimalPlaces, false);
+	}
+
+	/**
+	 * @brief Write a single-precision floating-point value
+	 * @note With decimalPlaces of -1, digits are only generated to float precision
+	 */
+	void value(float number, int decimalPlaces = 2)
+	{
+		writeFloat(number, decimalPlaces, true);
+	}
+
+	template <typename T> typename std::enable_if<std::is_integral<T>::value>::type value(T number)
+	{
+		writeInteger(number, std::is_signed<T>());
+	}
+
+	void nullValue();
+	/** @} */
+
+	/**
+	 * @brief Write a named value
+	 */
+	template <typename T> void member(const String& key, const T& v)
+	{
+		name(key);
+		value(v);
+	}
+
+	/**
+	 * @brief Write a value containing JSON which has already been serialised
+	 */
+	void raw(const String& json);
+
+	/**
+	 * @brief Get current nesting level
+	 */
+	unsigned getDepth() const
+	{
+		return depth;
+	}
+
+	uint16_t readMemoryBlock(char* data, int bufSize) override;
+
+	bool seek(int len) override;
+
+	bool isFinished() override
+	{
+		return finished && readPos >= buffer.length();
+	}
+
+	MimeType getMimeType() const override
+	{
+		return MIME_JSON;
+	}
+
+private:
+	void beginValue();
+	void begin(char c, const String& name);
+	void end(char c);
+	void writeString(const char* str, size_t length);
+	void writeInteger(uint64_t number, bool isSigned);
+	void writeFloat(double number, int decimalPlaces, bool isFloat);
+	void fill();
+
+	Producer producer;
+	String buffer;
+	size_t bufferSize;
+	size_t readPos{0};
+	uint32_t arrays{0};	  ///< Bits set for arrays, clear for objects
+	uint32_t notEmpty{0}; ///< Bits set once container has content
+	uint8_t depth{0};
+	bool named{false}; ///< Name has been written for next value
+	bool finished{false};
+};
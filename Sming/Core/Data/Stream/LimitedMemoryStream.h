@@ -73,6 +73,12 @@ public:
 
 	uint16_t readMemoryBlock(char* data, int bufSize) override;
 
+	const char* peekBlock(size_t& length) override
+	{
+		length = available();
+		return getStreamPointer();
+	}
+
 	int seekFrom(int offset, SeekOrigin origin) override;
 
 	size_t write(const uint8_t* buffer, size_t size) override;
@@ -9,6 +9,7 @@
  ****/
 
 #include "MemoryDataStream.h"
+#include <ObjectPool.h>
 #include <debug_progmem.h>
 
 MemoryDataStream::MemoryDataStream(String&& string) noexcept
@@ -19,8 +20,146 @@ MemoryDataStream::MemoryDataStream(String&& string) noexcept
 	capacity = buf.size;
 }
 
+ObjectPool::Pool& MemoryDataStream::getSegmentPool()
+{
+	static ObjectPool::Pool pool("MemoryDataStream", MEMORY_STREAM_SEGMENT_SIZE, 0);
+	return pool;
+}
+
+void MemoryDataStream::releaseSegments(Segment* segment)
+{
+	auto& pool = getSegmentPool();
+	while(segment != nullptr) {
+		auto next = segment->next;
+		pool.release(segment);
+		segment = next;
+	}
+}
+
+bool MemoryDataStream::setSegmented(bool enable)
+{
+	if(size != 0) {
+		return false;
+	}
+	if(enable == segmented) {
+		return true;
+	}
+
+	if(enable) {
+		free(buffer);
+		buffer = nullptr;
+	} else {
+		releaseSegments(head);
+		head = tail = writeSegment = readSegment = nullptr;
+		writeSegmentStart = readSegmentStart = 0;
+	}
+	capacity = 0;
+	readPos = 0;
+	segmented = enable;
+	return true;
+}
+
+void MemoryDataStream::clear()
+{
+	size = 0;
+	readPos = 0;
+	if(!segmented || head == nullptr) {
+		return;
+	}
+
+	releaseSegments(head->next);
+	head->next = nullptr;
+	tail = writeSegment = readSegment = head;
+	writeSegmentStart = readSegmentStart = 0;
+	capacity = segmentDataSize;
+}
+
+bool MemoryDataStream::ensureSegmentCapacity(size_t minCapacity)
+{
+	if(minCapacity > maxCapacity) {
+		debug_e("MemoryDataStream too large, requested %u limit is %u", minCapacity, maxCapacity);
+		return false;
+	}
+
+	while(capacity < minCapacity) {
+		auto segment = static_cast<Segment*>(getSegmentPool().allocate(MEMORY_STREAM_SEGMENT_SIZE));
+		if(segment == nullptr) {
+			debug_e("MemoryDataStream segment allocation failed");
+			return false;
+		}
+		segment->next = nullptr;
+		if(tail == nullptr) {
+			head = writeSegment = readSegment = segment;
+		} else {
+			tail->next = segment;
+		}
+		tail = segment;
+		capacity += segmentDataSize;
+	}
+
+	return true;
+}
+
+size_t MemoryDataStream::writeSegments(const uint8_t* data, size_t len)
+{
+	// If allocation fails, write as much as possible in any remaining space
+	if(!ensureSegmentCapacity(size + len)) {
+		len = capacity - size;
+	}
+
+	size_t written{0};
+	while(written < len) {
+		size_t offset = size - writeSegmentStart;
+		if(offset == segmentDataSize) {
+			writeSegment = writeSegment->next;
+			writeSegmentStart += segmentDataSize;
+			offset = 0;
+		}
+		auto n = std::min(len - written, segmentDataSize - offset);
+		memcpy(writeSegment->data() + offset, data + written, n);
+		written += n;
+		size += n;
+	}
+
+	return written;
+}
+
+MemoryDataStream::Segment* MemoryDataStream::getReadSegment(size_t& offset) const
+{
+	auto segment = readSegment;
+	if(segment == nullptr) {
+		return nullptr;
+	}
+	offset = readPos - readSegmentStart;
+	// Read position may be at the end of a segment filled before the next was added
+	if(offset == segmentDataSize && segment->next != nullptr) {
+		segment = segment->next;
+		offset = 0;
+	}
+	return segment;
+}
+
+void MemoryDataStream::seekSegment(size_t newPos)
+{
+	if(readSegment == nullptr) {
+		return;
+	}
+	if(newPos < readSegmentStart) {
+		readSegment = head;
+		readSegmentStart = 0;
+	}
+	while(newPos - readSegmentStart >= segmentDataSize && readSegment->next != nullptr) {
+		readSegment = readSegment->next;
+		readSegmentStart += segmentDataSize;
+	}
+}
+
 bool MemoryDataStream::ensureCapacity(size_t minCapacity)
 {
+	if(segmented) {
+		return ensureSegmentCapacity(minCapacity);
+	}
+
 	if(capacity < minCapacity) {
 		if(minCapacity > maxCapacity) {
 			debug_e("MemoryDataStream too large, requested %u limit is %u", minCapacity, maxCapacity);
@@ -33,7 +172,7 @@ bool MemoryDataStream::ensureCapacity(size_t minCapacity)
 		}
 		debug_d("MemoryDataStream::realloc %u -> %u", capacity, newCapacity);
 		// realloc can fail, store the result in temporary pointer
-		auto newBuffer = (char*)realloc(buffer, newCapacity);
+		auto newBuffer = static_cast<char*>(Memory::reallocate(buffer, newCapacity, memClass));
 		if(newBuffer == nullptr) {
 			debug_e("MemoryDataStream realloc(%u) failed", newCapacity);
 			return false;
@@ -52,7 +191,9 @@ size_t MemoryDataStream::write(const uint8_t* data, size_t len)
 		return 0;
 	}
 
-	// TODO: add queued buffers without full copy
+	if(segmented) {
+		return writeSegments(data, len);
+	}
 
 	// If reallocation fails, write as much as possible in any remaining space
 	if(!ensureCapacity(size + len)) {
@@ -68,7 +209,23 @@ size_t MemoryDataStream::write(const uint8_t* data, size_t len)
 uint16_t MemoryDataStream::readMemoryBlock(char* data, int bufSize)
 {
 	size_t available = std::min(size - readPos, size_t(bufSize));
-	memcpy(data, buffer + readPos, available);
+	if(!segmented) {
+		memcpy(data, buffer + readPos, available);
+		return available;
+	}
+
+	size_t offset;
+	auto segment = getReadSegment(offset);
+	for(size_t done = 0; done < available;) {
+		if(offset == segmentDataSize) {
+			segment = segment->next;
+			offset = 0;
+		}
+		auto n = std::min(available - done, segmentDataSize - offset);
+		memcpy(data + done, segment->data() + offset, n);
+		done += n;
+		offset += n;
+	}
 	return available;
 }
 
@@ -93,12 +250,36 @@ int MemoryDataStream::seekFrom(int offset, SeekOrigin origin)
 		return -1;
 	}
 
+	if(segmented) {
+		seekSegment(newPos);
+	}
 	readPos = newPos;
 	return readPos;
 }
 
 bool MemoryDataStream::moveString(String& s)
 {
+	if(segmented) {
+		// Content must be copied into a single buffer
+		if(!s.setLength(size)) {
+			return false;
+		}
+		auto dst = s.begin();
+		size_t offset{0};
+		for(auto segment = head; offset < size; segment = segment->next) {
+			auto n = std::min(size - offset, segmentDataSize);
+			memcpy(dst + offset, segment->data(), n);
+			offset += n;
+		}
+		releaseSegments(head);
+		head = tail = writeSegment = readSegment = nullptr;
+		writeSegmentStart = readSegmentStart = 0;
+		readPos = 0;
+		size = 0;
+		capacity = 0;
+		return true;
+	}
+
 	// Ensure size < capacity
 	bool sizeOk = ensureCapacity(size + 1);
 
@@ -12,6 +12,19 @@
 
 #include "ReadWriteStream.h"
 #include <WString.h>
+#include "../MemoryClass.h"
+
+/**
+ * @brief Size of each block used by segmented memory streams, including a link pointer
+ */
+#ifndef MEMORY_STREAM_SEGMENT_SIZE
+#define MEMORY_STREAM_SEGMENT_SIZE 512
+#endif
+
+namespace ObjectPool
+{
+class Pool;
+}
 
 /**
  * @brief Read/write stream using expandable memory buffer
@@ -21,12 +34,23 @@
  * It is _not_ intended to have data continuously written in and read out; memory is not reclaimed
  * as it is read.
  *
+ * By default content is stored in a single buffer, which is reallocated as the stream grows.
+ * In segmented mode, content is instead stored in a chain of fixed-size blocks taken from a shared pool.
+ * Growing the stream never copies existing content and never needs a large contiguous allocation,
+ * so is preferable for large content built up in small writes.
+ * Data is read out a segment at a time using `peekBlock()`.
+ *
  * @ingroup stream
  */
 class MemoryDataStream : public ReadWriteStream
 {
 public:
-	MemoryDataStream(size_t maxCapacity = UINT16_MAX) : maxCapacity(maxCapacity)
+	/**
+	 * @param maxCapacity Limit size of stream
+	 * @param memClass Use MemoryClass::Bulk for large streams which may be placed in external RAM
+	 */
+	MemoryDataStream(size_t maxCapacity = UINT16_MAX, MemoryClass memClass = MemoryClass::Default)
+		: maxCapacity(maxCapacity), memClass(memClass)
 	{
 	}
 
@@ -37,6 +61,7 @@ public:
 
 	~MemoryDataStream()
 	{
+		releaseSegments(head);
 		free(buffer);
 	}
 
@@ -45,11 +70,29 @@ public:
 		return eSST_MemoryWritable;
 	}
 
+	/**
+	 * @brief Store content in linked segments instead of a single buffer
+	 * @param enable
+	 * @retval bool false if stream is not empty
+	 */
+	bool setSegmented(bool enable);
+
+	bool isSegmented() const
+	{
+		return segmented;
+	}
+
 	/** @brief  Get a pointer to the current position
 	 *  @retval "const char*" Pointer to current cursor position within the data stream
+	 *  @note In segmented mode, data is contiguous only up to the end of the current segment
 	 */
 	const char* getStreamPointer() const
 	{
+		if(segmented) {
+			size_t offset;
+			auto segment = getReadSegment(offset);
+			return segment ? segment->data() + offset : nullptr;
+		}
 		return buffer ? buffer + readPos : nullptr;
 	}
 
@@ -73,6 +116,21 @@ public:
 
 	uint16_t readMemoryBlock(char* data, int bufSize) override;
 
+	const char* peekBlock(size_t& length) override
+	{
+		length = available();
+		if(segmented) {
+			size_t offset;
+			auto segment = getReadSegment(offset);
+			if(segment == nullptr) {
+				return nullptr;
+			}
+			length = std::min(length, segmentDataSize - offset);
+			return segment->data() + offset;
+		}
+		return getStreamPointer();
+	}
+
 	int seekFrom(int offset, SeekOrigin origin) override;
 
 	bool isFinished() override
@@ -97,12 +155,9 @@ public:
 
 	/**
 	 * @brief Clear data from stream and reset to start, but keep buffer allocated
+	 * @note In segmented mode, only the first segment is kept
 	 */
-	void clear()
-	{
-		size = 0;
-		readPos = 0;
-	}
+	void clear();
 
 	size_t getSize() const
 	{
@@ -114,10 +169,44 @@ public:
 		return capacity;
 	}
 
+	/**
+	 * @brief Get the pool from which segments are allocated
+	 *
+	 * The pool is empty by default, so segments come from the heap.
+	 * Call `reserve()` to hold a number of segments for re-use.
+	 */
+	static ObjectPool::Pool& getSegmentPool();
+
 private:
+	struct Segment {
+		Segment* next;
+
+		char* data()
+		{
+			return reinterpret_cast<char*>(this + 1);
+		}
+	};
+
+	static constexpr size_t segmentDataSize{MEMORY_STREAM_SEGMENT_SIZE - sizeof(Segment)};
+
+	bool ensureSegmentCapacity(size_t minCapacity);
+	size_t writeSegments(const uint8_t* data, size_t len);
+	void seekSegment(size_t newPos);
+	Segment* getReadSegment(size_t& offset) const;
+	static void releaseSegments(Segment* segment);
+
 	char* buffer = nullptr;			///< Stream content stored here
 	size_t maxCapacity{UINT16_MAX}; ///< Limit size of stream
 	size_t readPos = 0;				///< Offset to current read position
 	size_t size = 0;				///< Number of bytes stored in stream (i.e. the write position)
 	size_t capacity = 0;			///< Number of bytes allocated in buffer
+	MemoryClass memClass{};			///< Where buffer should be allocated
+	// Segmented mode
+	Segment* head{nullptr};			///< First segment
+	Segment* tail{nullptr};			///< Last allocated segment
+	Segment* writeSegment{nullptr}; ///< Segment containing write position
+	Segment* readSegment{nullptr};  ///< Segment containing read position
+	size_t writeSegmentStart{0};	///< Stream offset of writeSegment
+	size_t readSegmentStart{0};		///< Stream offset of readSegment
+	bool segmented{false};
 };
@@ -12,24 +12,140 @@
 
 #include "MultiStream.h"
 
+namespace
+{
+/*
+ * A stream's available() gives the unread length, if known.
+ * Only when that is fully consumed is it safe to carry on with the next stream.
+ */
+bool isExhaustedBy(IDataSourceStream& stream, size_t length)
+{
+	int avail = stream.available();
+	return avail >= 0 && size_t(avail) == length;
+}
+
+} // namespace
+
+MultiStream::~MultiStream()
+{
+	for(unsigned i = 0; i < streamCount; ++i) {
+		delete streams[i];
+	}
+}
+
+IDataSourceStream* MultiStream::getStream(unsigned index)
+{
+	while(streamCount <= index) {
+		auto stream = getNextStream();
+		if(stream == nullptr) {
+			return nullptr;
+		}
+		streams[streamCount++] = stream;
+	}
+
+	return streams[index];
+}
+
+IDataSourceStream* MultiStream::getCurrentStream()
+{
+	IDataSourceStream* stream;
+	while((stream = getStream(0)) != nullptr && stream->isFinished()) {
+		nextStream();
+	}
+
+	if(stream == nullptr) {
+		finished = true;
+	}
+
+	return stream;
+}
+
+void MultiStream::nextStream()
+{
+	if(streamCount == 0) {
+		return;
+	}
+
+	delete streams[0];
+	--streamCount;
+	for(unsigned i = 0; i < streamCount; ++i) {
+		streams[i] = streams[i + 1];
+	}
+	streams[streamCount] = nullptr;
+}
+
 uint16_t MultiStream::readMemoryBlock(char* data, int bufSize)
 {
-	if(stream && stream->isFinished()) {
-		stream.reset();
+	if(getCurrentStream() == nullptr || bufSize <= 0) {
+		return 0;
 	}
 
-	if(!stream) {
-		stream.reset(getNextStream());
-		if(!stream) {
-			finished = true;
-			return 0;
+	size_t count = 0;
+	for(unsigned i = 0; i < MULTI_STREAM_LOOKAHEAD && count < size_t(bufSize); ++i) {
+		auto stream = getStream(i);
+		if(stream == nullptr) {
+			break;
+		}
+		auto len = stream->readMemoryBlock(data + count, bufSize - count);
+		count += len;
+		if(!isExhaustedBy(*stream, len)) {
+			break;
 		}
 	}
 
-	return stream->readMemoryBlock(data, bufSize);
+	return count;
+}
+
+unsigned MultiStream::peekBlocks(Block* blocks, unsigned maxBlocks, size_t maxLength)
+{
+	if(getCurrentStream() == nullptr) {
+		return 0;
+	}
+
+	unsigned count = 0;
+	size_t total = 0;
+	for(unsigned i = 0; i < MULTI_STREAM_LOOKAHEAD && count < maxBlocks && total < maxLength; ++i) {
+		auto stream = getStream(i);
+		if(stream == nullptr) {
+			break;
+		}
+		auto n = stream->peekBlocks(&blocks[count], maxBlocks - count, maxLength - total);
+		size_t len = 0;
+		for(unsigned j = 0; j < n; ++j) {
+			len += blocks[count + j].length;
+		}
+		count += n;
+		total += len;
+		if(!isExhaustedBy(*stream, len)) {
+			break;
+		}
+	}
+
+	return count;
 }
 
 bool MultiStream::seek(int len)
 {
-	return stream ? stream->seek(len) : false;
+	if(len <= 0) {
+		auto stream = getStream(0);
+		return stream ? stream->seek(len) : false;
+	}
+
+	while(len > 0) {
+		auto stream = getStream(0);
+		if(stream == nullptr) {
+			return false;
+		}
+		int avail = stream->available();
+		int n = (avail < 0) ? len : std::min(len, avail);
+		if(n > 0 && !stream->seek(n)) {
+			return false;
+		}
+		len -= n;
+		if(len > 0) {
+			nextStream();
+		}
+	}
+
+	return true;
 }
@@ -14,7 +14,16 @@
 #pragma once
 
 #include "DataSourceStream.h"
-#include <memory>
+
+/**
+ * @brief Maximum number of source streams a MultiStream reads from at once
+ *
+ * Reads and seeks may span this many streams, so that small streams can be
+ * combined into larger blocks for sending.
+ */
+#ifndef MULTI_STREAM_LOOKAHEAD
+#define MULTI_STREAM_LOOKAHEAD 4
+#endif
 
 /**
  * @brief Base class for read-only stream which generates output from multiple source streams
@@ -23,8 +32,22 @@
 class MultiStream : public IDataSourceStream
 {
 public:
+	~MultiStream();
+
+	/**
+	 * @brief Read data, continuing into following streams where their length is known
+	 */
 	uint16_t readMemoryBlock(char* data, int bufSize) override;
 
+	/**
+	 * @brief Get blocks from the current and following streams
+	 * @note Stops at the first stream which does not support direct access
+	 */
+	unsigned peekBlocks(Block* blocks, unsigned maxBlocks, size_t maxLength) override;
+
+	/**
+	 * @brief Advance position, moving to following streams as required
+	 */
 	bool seek(int len) override;
 
 	bool isFinished() override
@@ -41,6 +64,11 @@ protected:
 	virtual IDataSourceStream* getNextStream() = 0;
 
 private:
-	std::unique_ptr<IDataSourceStream> stream;
+	IDataSourceStream* getStream(unsigned index);
+	IDataSourceStream* getCurrentStream();
+	void nextStream();
+
+	IDataSourceStream* streams[MULTI_STREAM_LOOKAHEAD]{}; ///< Current stream first, then those fetched ahead
+	uint8_t streamCount{0};
 	bool finished{false};
 };
@@ -56,6 +56,12 @@ public:
 		return written;
 	}
 
+	const char* peekBlock(size_t& length) override
+	{
+		length = available();
+		return reinterpret_cast<const char*>(buffer.get()) + readPos;
+	}
+
 	bool seek(int len) override
 	{
 		if(readPos + len > capacity) {
@@ -14,6 +14,7 @@
 
 #include "MultiStream.h"
 #include "../ObjectQueue.h"
+#include <algorithm>
 
 #ifndef MAX_STREAM_CHAIN_SIZE
 /**
@@ -44,7 +45,34 @@ public:
 			return false;
 		}
 
-		return queue.enqueue(stream);
+		int avail = stream->available();
+		if(!queue.enqueue(stream)) {
+			return false;
+		}
+		if(avail > 0) {
+			pendingLength += avail;
+		}
+		return true;
+	}
+
+	/**
+	 * @brief Get number of bytes attached but not yet read out
+	 * @note Only streams which report their length via `available()` are counted
+	 */
+	size_t getPendingLength() const
+	{
+		return pendingLength;
+	}
+
+	bool seek(int len) override
+	{
+		if(!MultiStream::seek(len)) {
+			return false;
+		}
+		if(len > 0) {
+			pendingLength -= std::min(size_t(len), pendingLength);
+		}
+		return true;
 	}
 
 	StreamType getStreamType() const override
@@ -62,4 +90,5 @@ private:
 	using Queue = ObjectQueue<IDataSourceStream, MAX_STREAM_CHAIN_SIZE>;
 
 	Queue queue;
+	size_t pendingLength{0};
 };
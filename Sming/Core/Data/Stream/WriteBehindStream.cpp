@@ -0,0 +1,160 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/SmingHub/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * WriteBehindStream.cpp
+ *
+ ****/
+
+#include "WriteBehindStream.h"
+#include <Platform/System.h>
+#include <debug_progmem.h>
+#include <algorithm>
+#include <cstring>
+#include <new>
+
+/*
+ * A queued task cannot be cancelled, so it refers to the stream indirectly.
+ * If the stream is destroyed first it clears the reference.
+ */
+struct WriteBehindStream::Task {
+	WriteBehindStream* stream;
+};
+
+WriteBehindStream::~WriteBehindStream()
+{
+	flush();
+	if(task != nullptr) {
+		task->stream = nullptr;
+	}
+}
+
+void WriteBehindStream::setExpectedLength(size_t length)
+{
+	if(buffer) {
+		return;
+	}
+	auto count = std::max((length + blockSize - 1) / blockSize, size_t(1));
+	blockCount = std::min(count, size_t(blockCount));
+}
+
+size_t WriteBehindStream::write(const uint8_t* data, size_t size)
+{
+	if(failed || getSource() == nullptr) {
+		return 0;
+	}
+
+	if(!buffer) {
+		buffer.reset(new(std::nothrow) uint8_t[blockCount * blockSize]);
+		if(!buffer) {
+			// Carry on without buffering
+			auto written = getSource()->write(data, size);
+			stats.bytesWritten += written;
+			return written;
+		}
+	}
+
+	size_t done{0};
+	while(done < size) {
+		if(fullCount == blockCount) {
+			++stats.stalls;
+			writeBlocks();
+			if(failed) {
+				return 0;
+			}
+		}
+
+		auto n = std::min(size - done, size_t(blockSize - fillPos));
+		memcpy(&buffer[head * blockSize + fillPos], &data[done], n);
+		done += n;
+		fillPos += n;
+		if(fillPos == blockSize) {
+			fillPos = 0;
+			head = (head + 1) % blockCount;
+			++fullCount;
+		}
+	}
+
+	if(fullCount != 0) {
+		queueTask();
+	}
+
+	return done;
+}
+
+void WriteBehindStream::queueTask()
+{
+	if(task != nullptr) {
+		return;
+	}
+
+	task = new Task{this};
+	if(!System.queueCallback(TaskPriority::Low, taskCallback, task)) {
+		// Blocks get written when the buffer fills, or on flush
+		delete task;
+		task = nullptr;
+	}
+}
+
+void WriteBehindStream::taskCallback(void* param)
+{
+	auto task = static_cast<Task*>(param);
+	auto stream = task->stream;
+	delete task;
+	if(stream == nullptr) {
+		return;
+	}
+
+	stream->task = nullptr;
+	stream->writeBlocks();
+	if(stream->fullCount != 0 && !stream->failed) {
+		stream->queueTask();
+	}
+}
+
+void WriteBehindStream::writeBlocks()
+{
+	// Don't wrap, so data is contiguous
+	unsigned count = std::min(fullCount, uint8_t(blockCount - tail));
+	if(count == 0) {
+		return;
+	}
+
+	size_t length = count * blockSize;
+	auto written = getSource()->write(&buffer[tail * blockSize], length);
+	stats.bytesWritten += written;
+	if(written != length) {
+		debug_e("[WBS] Write failed");
+		++stats.writeErrors;
+		failed = true;
+	}
+
+	tail = (tail + count) % blockCount;
+	fullCount -= count;
+}
+
+void WriteBehindStream::flush()
+{
+	auto source = getSource();
+	if(source == nullptr) {
+		return;
+	}
+
+	while(fullCount != 0 && !failed) {
+		writeBlocks();
+	}
+
+	if(fillPos != 0 && !failed) {
+		auto written = source->write(&buffer[head * blockSize], fillPos);
+		stats.bytesWritten += written;
+		if(written != fillPos) {
+			++stats.writeErrors;
+			failed = true;
+		}
+		fillPos = 0;
+	}
+
+	source->flush();
+}
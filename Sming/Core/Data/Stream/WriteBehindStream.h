@@ -0,0 +1,108 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/SmingHub/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * WriteBehindStream.h
+ *
+ ****/
+
+#pragma once
+
+#include "StreamWrapper.h"
+#include <memory>
+#include <algorithm>
+
+/**
+ * @brief Collects written data into blocks which are passed on to the source stream in the background
+ * @ingroup stream
+ *
+ * Data arriving in small, irregular pieces, such as from a TCP connection, is copied into a ring of
+ * fixed-size blocks so `write()` returns immediately. Completed blocks are written to the source
+ * stream from a low-priority task, as many contiguous blocks at a time as possible.
+ * Using a multiple of the file system page or sector size for the block size keeps file writes aligned.
+ *
+ * If all blocks are full then the oldest are written before `write()` returns.
+ * `getStats().stalls` counts how often this happens.
+ *
+ * Once a write to the source stream fails, all subsequent writes are rejected.
+ *
+ * @note `flush()` writes all pending data, including any partial block, then flushes the source stream.
+ * Data is also flushed when the stream is destroyed.
+ */
+class WriteBehindStream : public StreamWrapper
+{
+public:
+	struct Stats {
+		uint32_t bytesWritten; ///< Passed to source stream
+		uint16_t stalls;	   ///< Times all blocks were full, so data was written immediately
+		uint16_t writeErrors;
+	};
+
+	/**
+	 * @brief Constructor
+	 * @param source Stream to write to
+	 * @param blockSize Size of each write to the source stream
+	 * @param blockCount Number of blocks to allocate, at the first write
+	 */
+	WriteBehindStream(ReadWriteStream* source, uint16_t blockSize = 1024, uint8_t blockCount = 4)
+		: StreamWrapper(source), blockSize(blockSize), blockCount(std::max(blockCount, uint8_t(1)))
+	{
+	}
+
+	~WriteBehindStream();
+
+	size_t write(const uint8_t* buffer, size_t size) override;
+
+	using ReadWriteStream::write;
+
+	void flush() override;
+
+	String getName() const override
+	{
+		auto source = getSource();
+		return source ? source->getName() : nullptr;
+	}
+
+	/**
+	 * @brief Give the total amount of data expected so that no more blocks are allocated than required
+	 * @note Has no effect after the first write
+	 */
+	void setExpectedLength(size_t length);
+
+	/**
+	 * @brief Get number of bytes waiting to be written
+	 */
+	size_t getPending() const
+	{
+		return fullCount * blockSize + fillPos;
+	}
+
+	const Stats& getStats() const
+	{
+		return stats;
+	}
+
+private:
+	struct Task;
+
+	static void taskCallback(void* param);
+	void queueTask();
+
+	/**
+	 * @brief Write contiguous full blocks from the tail of the queue
+	 */
+	void writeBlocks();
+
+	std::unique_ptr<uint8_t[]> buffer;
+	Task* task{nullptr}; ///< Queued background write
+	Stats stats{};
+	uint16_t blockSize;
+	uint16_t fillPos{0}; ///< Bytes used in head block
+	uint8_t blockCount;
+	uint8_t head{0};	  ///< Block being filled
+	uint8_t tail{0};	  ///< Oldest full block
+	uint8_t fullCount{0}; ///< Number of full blocks
+	bool failed{false};
+};
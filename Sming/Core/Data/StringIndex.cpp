@@ -0,0 +1,60 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/SmingHub/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * StringIndex.cpp
+ *
+ ****/
+
+#include "StringIndex.h"
+#include <stringutil.h>
+#include <algorithm>
+
+#if __cplusplus >= 201402L
+
+uint32_t StringIndexBase::hash(const FSTR::String& str)
+{
+	uint32_t h{hashInit};
+	char buffer[16];
+	auto length = str.length();
+	for(size_t offset = 0; offset < length; offset += sizeof(buffer)) {
+		auto n = std::min(length - offset, sizeof(buffer));
+		str.read(offset, buffer, n);
+		h = hash(buffer, n, h);
+	}
+	return h;
+}
+
+bool StringIndexBase::equalsIgnoreCase(const FSTR::String& str, const char* key, size_t length)
+{
+	if(str.length() != length) {
+		return false;
+	}
+
+	char buffer[16];
+	for(size_t offset = 0; offset < length; offset += sizeof(buffer)) {
+		auto n = std::min(length - offset, sizeof(buffer));
+		str.read(offset, buffer, n);
+		if(memicmp(buffer, &key[offset], n) != 0) {
+			return false;
+		}
+	}
+	return true;
+}
+
+const StringIndexBase::Entry* StringIndexBase::lowerBound(const Entry* begin, const Entry* end, uint32_t hash)
+{
+	while(begin < end) {
+		auto mid = begin + (end - begin) / 2;
+		if(mid->hash < hash) {
+			begin = mid + 1;
+		} else {
+			end = mid;
+		}
+	}
+	return begin;
+}
+
+#endif
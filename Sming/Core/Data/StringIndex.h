@@ -0,0 +1,197 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/SmingHub/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * StringIndex.h - Compile-time hashed index for fixed string tables
+ *
+ ****/
+
+#pragma once
+
+#include <FlashString/Vector.hpp>
+#include <cstdint>
+#include <cstring>
+
+#if __cplusplus >= 201402L
+
+/**
+ * @brief Non-template part of StringIndex
+ */
+class StringIndexBase
+{
+public:
+	struct Entry {
+		uint32_t hash;
+		uint32_t info; ///< index in bits 0-15, string length in bits 16-31
+
+		constexpr unsigned index() const
+		{
+			return info & 0xffff;
+		}
+
+		constexpr unsigned length() const
+		{
+			return info >> 16;
+		}
+	};
+
+	static constexpr uint32_t hashInit{2166136261U};
+
+	/**
+	 * @brief Case-insensitive FNV-1a hash, usable at compile time
+	 * @param str
+	 * @param length
+	 * @param h Initial value, or result of previous call to continue a hash
+	 */
+	static constexpr uint32_t hash(const char* str, size_t length, uint32_t h = hashInit)
+	{
+		for(size_t i = 0; i < length; ++i) {
+			char c = str[i];
+			if(c >= 'A' && c <= 'Z') {
+				c += 'a' - 'A';
+			}
+			h = (h ^ uint8_t(c)) * 16777619U;
+		}
+		return h;
+	}
+
+	/**
+	 * @brief Hash a flash string
+	 */
+	static uint32_t hash(const FSTR::String& str);
+
+	/**
+	 * @brief Compare a flash string against a key, ignoring case
+	 */
+	static bool equalsIgnoreCase(const FSTR::String& str, const char* key, size_t length);
+
+protected:
+	static constexpr size_t getLength(const char* str)
+	{
+		size_t len{0};
+		while(str[len] != '\0') {
+			++len;
+		}
+		return len;
+	}
+
+	/**
+	 * @brief Find first entry with the given hash in a sorted table
+	 * @retval const Entry* Entry with hash not less than the one requested, or `end`
+	 */
+	static const Entry* lowerBound(const Entry* begin, const Entry* end, uint32_t hash);
+};
+
+/**
+ * @brief Compile-time lookup index for a fixed list of strings
+ *
+ * Each string is identified by a case-insensitive 32-bit hash. The table is sorted by hash when
+ * the program is compiled, so a lookup is a binary search followed by a single string comparison.
+ * Only the hashes, lengths and indices are stored: the strings themselves stay wherever the caller
+ * keeps them, usually in a FlashString Vector built from the same list.
+ *
+ * Declare instances `constexpr` with PROGMEM so the table is built by the compiler and kept in flash:
+ *
+ *	  #define XX(tag, str) str,
+ *	  constexpr const char* fruitList[]{FRUIT_MAP(XX)};
+ *	  constexpr StringIndex<ARRAY_SIZE(fruitList)> fruitIndex PROGMEM{fruitList};
+ *
+ * Where a string appears more than once the lowest index is returned, as with a linear search.
+ *
+ * Building the table needs C++14 constexpr support. With C++11 a linear search is used instead.
+ *
+ * @tparam N Number of strings
+ */
+template <size_t N> class StringIndex : public StringIndexBase
+{
+public:
+	static_assert(N != 0 && N <= 0xffff, "Invalid string count");
+
+	constexpr StringIndex(const char* const (&strings)[N])
+	{
+		for(size_t i = 0; i < N; ++i) {
+			auto len = getLength(strings[i]);
+			Entry e{hash(strings[i], len), uint32_t(i | (len << 16))};
+			// Insertion sort, stable so equal strings keep their order
+			size_t j = i;
+			for(; j > 0 && entries[j - 1].hash > e.hash; --j) {
+				entries[j] = entries[j - 1];
+			}
+			entries[j] = e;
+		}
+	}
+
+	static constexpr size_t count()
+	{
+		return N;
+	}
+
+	/**
+	 * @brief Locate a string
+	 * @param key String to search for
+	 * @param length Length of key
+	 * @param match Callback `bool(unsigned index)` to confirm a candidate, since hashes may collide
+	 * @retval int Index of matching string, -1 if not found
+	 */
+	template <typename Match> int find(const char* key, size_t length, Match match) const
+	{
+		if(key == nullptr) {
+			return -1;
+		}
+		auto h = hash(key, length);
+		for(auto e = lowerBound(entries, entries + N, h); e < entries + N && e->hash == h; ++e) {
+			if(e->length() == length && match(e->index())) {
+				return e->index();
+			}
+		}
+		return -1;
+	}
+
+	/**
+	 * @brief Locate a string in the Vector from which this index was built
+	 * @param strings Must contain the same strings, in the same order, as those given to the constructor
+	 * @param key String to search for, case is ignored
+	 * @retval int Index of matching string, -1 if not found
+	 */
+	int indexOf(const FSTR::Vector<FSTR::String>& strings, const char* key, size_t length) const
+	{
+		return find(key, length, [&](unsigned i) { return equalsIgnoreCase(strings[i], key, length); });
+	}
+
+	int indexOf(const FSTR::Vector<FSTR::String>& strings, const char* key) const
+	{
+		return key ? indexOf(strings, key, strlen(key)) : -1;
+	}
+
+private:
+	Entry entries[N]{};
+};
+
+#else
+
+template <size_t N> class StringIndex
+{
+public:
+	constexpr StringIndex(const char* const (&)[N])
+	{
+	}
+
+	static constexpr size_t count()
+	{
+		return N;
+	}
+
+	int indexOf(const FSTR::Vector<FSTR::String>& strings, const char* key) const
+	{
+		return key ? strings.indexOf(key) : -1;
+	}
+
+	int indexOf(const FSTR::Vector<FSTR::String>& strings, const char* key, size_t length) const
+	{
+		return key ? strings.indexOf(String(key, length).c_str()) : -1;
+	}
+};
+
+#endif
@@ -9,6 +9,7 @@
  ****/
 
 #include "WebConstants.h"
+#include "StringIndex.h"
 #include <FakePgmSpace.h>
 #include <FlashString/Vector.hpp>
 #include <stringutil.h>
@@ -24,6 +25,11 @@ MIME_TYPE_MAP(XX)
 DEFINE_FSTR_VECTOR(contentTypeStrings, FlashString, MIME_TYPE_MAP(XX))
 #undef XX
 
+#define XX(name, ext, mime) mime,
+constexpr const char* contentTypeList[]{MIME_TYPE_MAP(XX)};
+#undef XX
+constexpr StringIndex<ARRAY_SIZE(contentTypeList)> contentTypeIndex PROGMEM{contentTypeList};
+
 // File extensions
 #define XX(name, ext, mime) DEFINE_FSTR_LOCAL(str_ext_##name, ext)
 MIME_TYPE_MAP(XX)
@@ -32,6 +38,11 @@ MIME_TYPE_MAP(XX)
 #define XX(name, ext, mime) &str_ext_##name,
 DEFINE_FSTR_VECTOR(extensionStrings, FlashString, MIME_TYPE_MAP(XX))
 #undef XX
+
+#define XX(name, ext, mime) ext,
+constexpr const char* extensionList[]{MIME_TYPE_MAP(XX)};
+#undef XX
+constexpr StringIndex<ARRAY_SIZE(extensionList)> extensionIndex PROGMEM{extensionList};
 } // namespace
 
 String toString(MimeType m)
@@ -47,13 +58,17 @@ namespace ContentType
 {
 MimeType fromFileExtension(const char* extension, MimeType unknown)
 {
+	int i = extensionIndex.indexOf(extensionStrings, extension);
+	if(i >= 0) {
+		return MimeType(i);
+	}
+
 	// We accept 'htm' or 'html', but the latter is preferred
-	if(strcasecmp(extension, _F("htm")) == 0) {
+	if(extension != nullptr && strcasecmp(extension, _F("htm")) == 0) {
 		return MIME_HTML;
 	}
 
-	int i = extensionStrings.indexOf(extension);
-	return (i < 0) ? unknown : MimeType(i);
+	return unknown;
 }
 
 String fromFileExtension(const char* extension)
@@ -69,7 +84,7 @@ String fromFileExtension(const char* extension)
 
 MimeType fromString(const char* str)
 {
-	int i = contentTypeStrings.indexOf(str);
+	int i = contentTypeIndex.indexOf(contentTypeStrings, str);
 	if(i < 0) {
 		if(strcasecmp(str, _F("application/xml")) == 0) {
 			return MIME_XML;
@@ -11,8 +11,200 @@
 
 #include "base64.h"
 
-#include "libb64/cencode.h"
-#include "libb64/cdecode.h"
+namespace
+{
+const char encodeTable[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+// Values for ASCII characters, -1 if not in the base64 alphabet
+const int8_t decodeTable[128] = {
+	-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+	-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 62, -1, -1, -1, 63, 52, 53, 54, 55,
+	56, 57, 58, 59, 60, 61, -1, -1, -1, -1, -1, -1, -1, 0,  1,  2,  3,  4,  5,  6,  7,  8,  9,  10, 11, 12,
+	13, 14, 15, 16, 17, 18, 19, 20, 21, 22, 23, 24, 25, -1, -1, -1, -1, -1, -1, 26, 27, 28, 29, 30, 31, 32,
+	33, 34, 35, 36, 37, 38, 39, 40, 41, 42, 43, 44, 45, 46, 47, 48, 49, 50, 51, -1, -1, -1, -1, -1,
+};
+
+bool isWordAligned(const void* ptr)
+{
+	return (uintptr_t(ptr) & 3) == 0;
+}
+
+/*
+ * Read 4 bytes from a word-aligned address using a single load, most significant byte first.
+ * memcpy() avoids aliasing issues and compiles to a plain load as the compiler knows the alignment.
+ */
+uint32_t loadWordBE(const uint8_t* ptr)
+{
+	uint32_t word;
+	memcpy(&word, __builtin_assume_aligned(ptr, 4), sizeof(word));
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+	word = __builtin_bswap32(word);
+#endif
+	return word;
+}
+
+uint32_t load24(const uint8_t* ptr)
+{
+	return (ptr[0] << 16) | (ptr[1] << 8) | ptr[2];
+}
+
+int8_t decodeValue(uint8_t c)
+{
+	return (c < sizeof(decodeTable)) ? decodeTable[c] : -1;
+}
+
+} // namespace
+
+/* Base64Encoder */
+
+size_t Base64Encoder::maxOutputLength(size_t length) const
+{
+	size_t groups = (pendingCount + length) / 3;
+	size_t outlen = groups * 4;
+	if(groupsPerLine != 0) {
+		outlen += (groupCount + groups) / groupsPerLine;
+	}
+	return outlen;
+}
+
+char* Base64Encoder::writeGroup(char* output, uint32_t value)
+{
+	if(groupsPerLine != 0) {
+		if(groupCount == groupsPerLine) {
+			*output++ = '\n';
+			groupCount = 0;
+		}
+		++groupCount;
+	}
+	output[0] = encodeTable[(value >> 18) & 0x3f];
+	output[1] = encodeTable[(value >> 12) & 0x3f];
+	output[2] = encodeTable[(value >> 6) & 0x3f];
+	output[3] = encodeTable[value & 0x3f];
+	return output + 4;
+}
+
+size_t Base64Encoder::update(const void* data, size_t length, char* output)
+{
+	auto in = static_cast<const uint8_t*>(data);
+	char* out = output;
+
+	// Complete any group left over from previous call
+	while(pendingCount != 0 && length != 0) {
+		if(pendingCount == 2) {
+			out = writeGroup(out, (pending[0] << 16) | (pending[1] << 8) | *in++);
+			pendingCount = 0;
+		} else {
+			pending[pendingCount++] = *in++;
+		}
+		--length;
+	}
+
+	// Groups are 3 bytes so alignment is reached within at most 3 groups
+	while(length >= 3 && !isWordAligned(in)) {
+		out = writeGroup(out, load24(in));
+		in += 3;
+		length -= 3;
+	}
+
+	// Encode 4 groups from every 3 words
+	while(length >= 12) {
+		uint32_t w0 = loadWordBE(in);
+		uint32_t w1 = loadWordBE(in + 4);
+		uint32_t w2 = loadWordBE(in + 8);
+		out = writeGroup(out, w0 >> 8);
+		out = writeGroup(out, (w0 << 16) | (w1 >> 16));
+		out = writeGroup(out, (w1 << 8) | (w2 >> 24));
+		out = writeGroup(out, w2);
+		in += 12;
+		length -= 12;
+	}
+
+	while(length >= 3) {
+		out = writeGroup(out, load24(in));
+		in += 3;
+		length -= 3;
+	}
+
+	// Save remainder for next time
+	while(length-- != 0) {
+		pending[pendingCount++] = *in++;
+	}
+
+	return out - output;
+}
+
+size_t Base64Encoder::finish(char* output)
+{
+	if(pendingCount == 0) {
+		reset();
+		return 0;
+	}
+
+	uint32_t value = pending[0] << 16;
+	if(pendingCount == 2) {
+		value |= pending[1] << 8;
+	}
+	char* out = writeGroup(output, value);
+	out[-1] = '=';
+	if(pendingCount == 1) {
+		out[-2] = '=';
+	}
+
+	reset();
+	return out - output;
+}
+
+/* Base64Decoder */
+
+size_t Base64Decoder::update(const char* text, size_t length, uint8_t* output)
+{
+	auto in = reinterpret_cast<const uint8_t*>(text);
+	auto end = in + length;
+	auto out = output;
+
+	while(in < end) {
+		// Decode complete groups directly, provided they contain only valid characters
+		while(bitCount == 0 && end - in >= 4) {
+			uint32_t chars = isWordAligned(in) ? loadWordBE(in) : (load24(in) << 8) | in[3];
+			int8_t a = decodeValue(chars >> 24);
+			int8_t b = decodeValue(chars >> 16);
+			int8_t c = decodeValue(chars >> 8);
+			int8_t d = decodeValue(chars);
+			if((a | b | c | d) < 0) {
+				break;
+			}
+			uint32_t value = (a << 18) | (b << 12) | (c << 6) | d;
+			out[0] = value >> 16;
+			out[1] = value >> 8;
+			out[2] = value;
+			out += 3;
+			in += 4;
+		}
+
+		if(in == end) {
+			break;
+		}
+
+		// Slow path: line breaks, padding, partial groups
+		int8_t value = decodeValue(*in++);
+		if(value < 0) {
+			continue;
+		}
+		bits = (bits << 6) | value;
+		bitCount += 6;
+		if(bitCount >= 8) {
+			bitCount -= 8;
+			*out++ = bits >> bitCount;
+		}
+		if(bitCount == 0) {
+			bits = 0;
+		}
+	}
+
+	return out - output;
+}
+
+/* Functions */
 
 size_t base64_min_encode_len(size_t in_len)
 {
@@ -27,16 +219,15 @@ size_t base64_min_decode_len(size_t in_len)
 
 int base64_encode(size_t in_len, const unsigned char* in, size_t out_len, char* out)
 {
-	// Base-64 encoding produces 3 output bytes for every 2 input bytes
+	// Base-64 encoding produces 4 output characters for every 3 input bytes
 	unsigned min_out_len = base64_min_encode_len(in_len);
 	if(out_len < min_out_len) {
 		return -1;
 	}
 
-	base64_encodestate state;
-	base64_init_encodestate(&state, 0); // Don't include any linebreaks
-	int codelength = base64_encode_block((const char*)in, in_len, out, &state);
-	codelength += base64_encode_blockend(out + codelength, &state);
+	Base64Encoder encoder; // Don't include any linebreaks
+	size_t codelength = encoder.update(in, in_len, out);
+	codelength += encoder.finish(out + codelength);
 	return codelength;
 }
 
@@ -63,9 +254,8 @@ int base64_decode(size_t in_len, const char* in, size_t out_len, unsigned char*
 		return -1;
 	}
 
-	base64_decodestate _state;
-	base64_init_decodestate(&_state);
-	return base64_decode_block(in, in_len, (char*)out, &_state);
+	Base64Decoder decoder;
+	return decoder.update(in, in_len, out);
 }
 
 String base64_decode(const char* in, size_t in_len)
@@ -34,14 +34,109 @@ size_t base64_min_encode_len(size_t in_len);
  */
 size_t base64_min_decode_len(size_t in_len);
 
+/**
+ * @brief Incremental base64 encoder
+ *
+ * Encodes data supplied in any number of blocks, as for a stream.
+ * Complete 3-byte groups are encoded immediately; up to two bytes are retained between calls.
+ */
+class Base64Encoder
+{
+public:
+	/**
+	 * @brief Constructor
+	 * @param charsPerLine Insert a newline between lines of this many characters.
+	 * Rounded down to a multiple of 4. Specify 0 to disable line breaking.
+	 */
+	Base64Encoder(unsigned charsPerLine = 0) : groupsPerLine(charsPerLine / 4)
+	{
+	}
+
+	/**
+	 * @brief Discard any pending data and start a new encoding
+	 */
+	void reset()
+	{
+		pendingCount = 0;
+		groupCount = 0;
+	}
+
+	/**
+	 * @brief Get maximum number of characters which update() may produce
+	 * @param length Number of input bytes
+	 */
+	size_t maxOutputLength(size_t length) const;
+
+	/**
+	 * @brief Encode a block of data
+	 * @param data
+	 * @param length
+	 * @param output Buffer of at least maxOutputLength() characters
+	 * @retval size_t Number of characters written to output
+	 */
+	size_t update(const void* data, size_t length, char* output);
+
+	/**
+	 * @brief Encode any remaining data, with padding
+	 * @param output Buffer of at least 5 characters
+	 * @retval size_t Number of characters written to output
+	 * @note A trailing newline is never added
+	 */
+	size_t finish(char* output);
+
+private:
+	char* writeGroup(char* output, uint32_t value);
+
+	uint8_t pending[2];
+	uint8_t pendingCount{0};
+	uint16_t groupsPerLine;
+	uint16_t groupCount{0};
+};
+
+/**
+ * @brief Incremental base64 decoder
+ *
+ * Characters outside of the base64 alphabet, such as line breaks and padding, are ignored.
+ */
+class Base64Decoder
+{
+public:
+	void reset()
+	{
+		bits = 0;
+		bitCount = 0;
+	}
+
+	/**
+	 * @brief Get maximum number of bytes which update() may produce
+	 * @param length Number of input characters
+	 */
+	size_t maxOutputLength(size_t length) const
+	{
+		return ((length * 6) + bitCount) / 8;
+	}
+
+	/**
+	 * @brief Decode a block of text
+	 * @param text
+	 * @param length
+	 * @param output Buffer of at least maxOutputLength() bytes
+	 * @retval size_t Number of bytes written to output
+	 */
+	size_t update(const char* text, size_t length, uint8_t* output);
+
+private:
+	uint32_t bits{0};
+	uint8_t bitCount{0};
+};
+
 /** @brief encode binary data into base64 digits with MIME style === pads
  *  @param in_len quantity of characters to encode
  *  @param in data to encode
  *  @param out_len size of output buffer
  *  @param out buffer for base64-encoded text
  *  @retval int length of encoded text, or -1 if output buffer is too small
- *  @note Output is broken by newline every 72 characters. Final terminating newline
- *  is not included.
+ *  @note Output is not broken into lines
  */
 int base64_encode(size_t in_len, const unsigned char* in, size_t out_len, char* out);
 
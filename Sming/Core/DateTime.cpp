@@ -11,8 +11,6 @@
 #include "Data/CStringArray.h"
 #include <stringconversion.h>
 
-#define LEAP_YEAR(year) ((year % 4) == 0)
-
 DEFINE_FSTR_LOCAL(flashMonthNames, LOCALE_MONTH_NAMES);
 DEFINE_FSTR_LOCAL(flashDayNames, LOCALE_DAY_NAMES);
 
@@ -38,17 +36,48 @@ static const FourDigitName isoMonthNames[12] PROGMEM = {
 	{'S', 'e', 'p', '\0'}, {'O', 'c', 't', '\0'}, {'N', 'o', 'v', '\0'}, {'D', 'e', 'c', '\0'},
 };
 
-/** @brief Get the number of days in a month, taking leap years into account
- *  @param month 0=jan
- *  @param year
- *  @retval uint8_t number of days in the month
- */
-static uint8_t getMonthDays(uint8_t month, uint8_t year)
+namespace
+{
+// Days before start of each month in a non-leap year
+const uint16_t daysBeforeMonth[12] PROGMEM = {0, 31, 59, 90, 120, 151, 181, 212, 243, 273, 304, 334};
+
+// Days from 0000-03-01 to 1970-01-01
+constexpr uint32_t epochDays{719468};
+// Days in a 400-year cycle
+constexpr uint32_t daysPerEra{146097};
+
+char* writeNumber(char* buffer, unsigned number, unsigned digits)
+{
+	for(unsigned i = digits; i != 0; number /= 10) {
+		buffer[--i] = '0' + (number % 10);
+	}
+	return buffer + digits;
+}
+
+char* writeTime(char* buffer, const DateTime& dt)
 {
-	static const uint8_t monthDays[] PROGMEM = {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
-	return (month == 1 && LEAP_YEAR(year)) ? 29 : pgm_read_byte(&monthDays[month]);
+	buffer = writeNumber(buffer, dt.Hour, 2);
+	*buffer++ = ':';
+	buffer = writeNumber(buffer, dt.Minute, 2);
+	*buffer++ = ':';
+	return writeNumber(buffer, dt.Second, 2);
 }
 
+char* writeName(char* buffer, const FourDigitName& name)
+{
+	FourDigitName value;
+	memcpy_P(&value, &name, sizeof(value));
+	memcpy(buffer, value.c, 3);
+	return buffer + 3;
+}
+
+struct CachedText {
+	time_t time;
+	char text[DateTime::httpDateLength + 1];
+};
+
+} // namespace
+
 //******************************************************************************
 //* DateTime Public Methods
 //******************************************************************************
@@ -160,12 +189,66 @@ String DateTime::toFullDateTimeString()
 
 String DateTime::toISO8601()
 {
-	return format(_F("%FT%TZ"));
+	char buffer[iso8601Length + 1];
+	return String(buffer, toISO8601(buffer) - buffer);
 }
 
 String DateTime::toHTTPDate()
 {
-	return format(_F("%a, %d %b %Y %T GMT"));
+	char buffer[httpDateLength + 1];
+	return String(buffer, toHTTPDate(buffer) - buffer);
+}
+
+char* DateTime::toISO8601(char* buffer) const
+{
+	auto p = writeNumber(buffer, Year, 4);
+	*p++ = '-';
+	p = writeNumber(p, Month + 1, 2);
+	*p++ = '-';
+	p = writeNumber(p, Day, 2);
+	*p++ = 'T';
+	p = writeTime(p, *this);
+	*p++ = 'Z';
+	*p = '\0';
+	return p;
+}
+
+char* DateTime::toHTTPDate(char* buffer) const
+{
+	auto p = writeName(buffer, isoDayNames[DayofWeek % 7]);
+	*p++ = ',';
+	*p++ = ' ';
+	p = writeNumber(p, Day, 2);
+	*p++ = ' ';
+	p = writeName(p, isoMonthNames[Month % 12]);
+	*p++ = ' ';
+	p = writeNumber(p, Year, 4);
+	*p++ = ' ';
+	p = writeTime(p, *this);
+	memcpy(p, " GMT", 4);
+	p += 4;
+	*p = '\0';
+	return p;
+}
+
+const char* DateTime::getISO8601(time_t time)
+{
+	static CachedText cache{-1, {}};
+	if(time != cache.time || cache.text[0] == '\0') {
+		DateTime(time).toISO8601(cache.text);
+		cache.time = time;
+	}
+	return cache.text;
+}
+
+const char* DateTime::getHTTPDate(time_t time)
+{
+	static CachedText cache{-1, {}};
+	if(time != cache.time || cache.text[0] == '\0') {
+		DateTime(time).toHTTPDate(cache.text);
+		cache.time = time;
+	}
+	return cache.text;
 }
 
 void DateTime::addMilliseconds(long add)
@@ -202,34 +285,18 @@ void DateTime::fromUnixTime(time_t timep, uint8_t* psec, uint8_t* pmin, uint8_t*
 		*pwday = (epoch + 4) % 7;
 	}
 
-	unsigned year = 70;
-	unsigned long days = 0;
-	while((days += (LEAP_YEAR(year) ? 366 : 365)) <= epoch) {
-		year++;
-	}
-	if(pyear != nullptr) {
-		*pyear = year + 1900; // *pyear is returned as years from 1900
-	}
-
-	days -= LEAP_YEAR(year) ? 366 : 365;
-	epoch -= days; // now it is days in this year, starting at 0
-	// *pdayofyear=epoch;  // days since jan 1 this year
-
+	uint8_t day;
 	uint8_t month;
-	for(month = 0; month < 12; month++) {
-		uint8_t monthDays = getMonthDays(month, year);
-		if(epoch >= monthDays) {
-			epoch -= monthDays;
-		} else {
-			break;
-		}
+	uint16_t year;
+	fromDays(epoch, day, month, year);
+	if(pyear != nullptr) {
+		*pyear = year;
 	}
-
 	if(pmonth != nullptr) {
 		*pmonth = month; // jan is month 0
 	}
 	if(pday != nullptr) {
-		*pday = epoch + 1; // day of month
+		*pday = day; // day of month
 	}
 }
 
@@ -241,21 +308,7 @@ time_t DateTime::toUnixTime(uint8_t sec, uint8_t min, uint8_t hour, uint8_t day,
 	if(year < 69) {
 		year += 2000;
 	}
-	// seconds from 1970 till 1 jan 00:00:00 this year
-	time_t seconds = (year - 1970) * (SECS_PER_DAY * 365);
-
-	// add extra days for leap years
-	for(unsigned i = 1970; i < year; i++) {
-		if(LEAP_YEAR(i)) {
-			seconds += SECS_PER_DAY;
-		}
-	}
-	// add days for this year
-	for(unsigned i = 0; i < month; i++) {
-		seconds += SECS_PER_DAY * getMonthDays(i, year);
-	}
-
-	seconds += (day - 1) * SECS_PER_DAY;
+	time_t seconds = time_t(toDays(day, month, year)) * time_t(SECS_PER_DAY);
 	seconds += hour * SECS_PER_HOUR;
 	seconds += min * SECS_PER_MIN;
 	seconds += sec;
@@ -263,6 +316,42 @@ time_t DateTime::toUnixTime(uint8_t sec, uint8_t min, uint8_t hour, uint8_t day,
 	return seconds;
 }
 
+/*
+ * Calendar conversions use the algorithms described by Howard Hinnant,
+ * http://howardhinnant.github.io/date_algorithms.html
+ *
+ * Years are considered to start on 1 March so the leap day falls at the end.
+ * Days are then split into 400-year eras, each of which has exactly the same number of days.
+ */
+
+void DateTime::fromDays(uint32_t days, uint8_t& day, uint8_t& month, uint16_t& year)
+{
+	days += epochDays;
+	uint32_t era = days / daysPerEra;
+	// [0, 146096]
+	uint32_t dayOfEra = days - era * daysPerEra;
+	// [0, 399]
+	uint32_t yearOfEra = (dayOfEra - dayOfEra / 1460 + dayOfEra / 36524 - dayOfEra / 146096) / 365;
+	// [0, 365], starting at 1 March
+	uint32_t dayOfYear = dayOfEra - (365 * yearOfEra + yearOfEra / 4 - yearOfEra / 100);
+	// [0, 11], starting at March
+	uint32_t mp = (5 * dayOfYear + 2) / 153;
+	day = dayOfYear - (153 * mp + 2) / 5 + 1;
+	month = (mp < 10) ? mp + 2 : mp - 10;
+	year = yearOfEra + era * 400 + (month <= 1);
+}
+
+int32_t DateTime::toDays(uint8_t day, uint8_t month, uint16_t year)
+{
+	unsigned y = year - (month <= 1);
+	unsigned era = y / 400;
+	unsigned yearOfEra = y - era * 400;
+	unsigned mp = (month <= 1) ? month + 10 : month - 2;
+	unsigned dayOfYear = (153 * mp + 2) / 5 + day - 1;
+	unsigned dayOfEra = yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear;
+	return int32_t(era * daysPerEra + dayOfEra) - int32_t(epochDays);
+}
+
 String DateTime::format(const char* sFormat)
 {
 	if(sFormat == nullptr) {
@@ -407,23 +496,10 @@ String DateTime::format(const char* sFormat)
 
 void DateTime::calcDayOfYear()
 {
-	DayofYear = 0;
-	for(auto i = 0; i < Month; ++i) {
-		switch(i) {
-		case 8:  // Sep
-		case 3:  // Apr
-		case 5:  // Jun
-		case 10: // Nov
-			DayofYear += 30;
-			break;
-		case 1: // Feb
-			DayofYear += LEAP_YEAR(Year) ? 29 : 28;
-			break;
-		default:
-			DayofYear += 31;
-		}
+	DayofYear = pgm_read_word(&daysBeforeMonth[Month % 12]) + Day;
+	if(Month > 1 && isLeapYear(Year)) {
+		++DayofYear;
 	}
-	DayofYear += Day;
 }
 
 uint8_t DateTime::calcWeek(uint8_t firstDay)
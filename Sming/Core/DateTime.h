@@ -171,6 +171,36 @@ public:
 	 */
 	String toHTTPDate();
 
+	static constexpr size_t iso8601Length{20};  ///< Length of text written by `toISO8601(char*)`
+	static constexpr size_t httpDateLength{29}; ///< Length of text written by `toHTTPDate(char*)`
+
+	/** @brief  Write date and time into a buffer in format YYYY-MM-DDThh:mm:ssZ
+	 *  @param  buffer Must have room for `iso8601Length + 1` characters
+	 *  @retval char* Points to NUL terminator
+	 */
+	char* toISO8601(char* buffer) const;
+
+	/** @brief  Write date and time into a buffer in format DDD, DD MMM YYYY hh:mm:ss GMT
+	 *  @param  buffer Must have room for `httpDateLength + 1` characters
+	 *  @retval char* Points to NUL terminator
+	 *  @note   Day and month names are always English, as required by HTTP
+	 */
+	char* toHTTPDate(char* buffer) const;
+
+	/** @brief  Get ISO8601 text for a Unix timestamp
+	 *  @param  time
+	 *  @retval const char* Refers to a shared buffer which is only updated when the time changes,
+	 *  so repeated calls within the same second (e.g. for log records) are cheap
+	 */
+	static const char* getISO8601(time_t time);
+
+	/** @brief  Get HTTP date text for a Unix timestamp
+	 *  @param  time
+	 *  @retval const char* Refers to a shared buffer which is only updated when the time changes,
+	 *  so repeated calls within the same second (e.g. for response headers) are cheap
+	 */
+	static const char* getHTTPDate(time_t time);
+
 	/** @brief  Add time to date time object
 	 *  @param  add Quantity of milliseconds to add to object
 	 */
@@ -212,6 +242,30 @@ public:
 	 */
 	static time_t toUnixTime(uint8_t sec, uint8_t min, uint8_t hour, uint8_t day, uint8_t month, uint16_t year);
 
+	/** @brief  Convert a quantity of days since 1970-01-01 into a calendar date
+	 *  @param  days Days since the epoch
+	 *  @param  day Day of month (1-31)
+	 *  @param  month Month (0-11)
+	 *  @param  year Full year number
+	 *  @note   Uses a constant-time calculation, valid for any date in the Gregorian calendar
+	 */
+	static void fromDays(uint32_t days, uint8_t& day, uint8_t& month, uint16_t& year);
+
+	/** @brief  Convert a calendar date into a quantity of days since 1970-01-01
+	 *  @param  day Day of month, starting at 1. May exceed length of month.
+	 *  @param  month Month (0-11)
+	 *  @param  year Full year number
+	 *  @retval int32_t Negative for dates before 1970
+	 */
+	static int32_t toDays(uint8_t day, uint8_t month, uint16_t year);
+
+	/** @brief  Determine if a year has 366 days
+	 */
+	static bool isLeapYear(uint16_t year)
+	{
+		return (year % 4) == 0 && ((year % 100) != 0 || (year % 400) == 0);
+	}
+
 	/** @brief  Create string formatted with time and date placeholders
 	 *  @param  formatString String including date and time formatting
 	 *  @retval String Formatted string
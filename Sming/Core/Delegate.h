@@ -43,3 +43,5 @@ public:
 };
 
 /** @} */
+
+#include "InlineDelegate.h"
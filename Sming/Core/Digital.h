@@ -76,4 +76,49 @@ unsigned long pulseIn(uint16_t pin, uint8_t state, unsigned long timeout = 10000
 
 uint16_t analogRead(uint16_t pin);
 
+/**
+ * @name Port-level access
+ * @brief Operate on GPIO0-31 together, bit N in a mask or value corresponds to GPIOn
+ *
+ * Each call maps onto the set, clear or toggle registers of the GPIO hardware, so all pins in
+ * the mask change at the same instant. They're inline on hardware architectures.
+ * Pins must already be configured using pinMode().
+ *
+ * @note Where there is no toggle register (Esp8266, Esp32) digitalToggleMask() and digitalWriteMask()
+ * read and then write the output register, so must not race with interrupt code writing to the same port.
+ *
+ * @see DigitalPins for compile-time pin groups, e.g. data buses
+ * @{
+ */
+
+/** @brief Set outputs HIGH
+ *  @param mask Pins to set
+ */
+void IRAM_ATTR digitalSetMask(uint32_t mask);
+
+/** @brief Set outputs LOW
+ *  @param mask Pins to clear
+ */
+void IRAM_ATTR digitalClearMask(uint32_t mask);
+
+/** @brief Invert outputs
+ *  @param mask Pins to toggle
+ */
+void IRAM_ATTR digitalToggleMask(uint32_t mask);
+
+/** @brief Update a group of outputs, leaving others unchanged
+ *  @param mask Pins to update
+ *  @param value New states, bits outside mask are ignored
+ */
+void IRAM_ATTR digitalWriteMask(uint32_t mask, uint32_t value);
+
+/** @brief Read state of all inputs
+ *  @retval uint32_t
+ */
+uint32_t IRAM_ATTR digitalReadPort();
+
+/** @} */
+
 /** @} */
+
+#include <digital_arch.h>
@@ -0,0 +1,118 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/SmingHub/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * DigitalPins.h - Compile-time GPIO pin groups
+ *
+ ****/
+
+#pragma once
+
+#include "Digital.h"
+#include <utility>
+
+/**
+ * @brief A fixed group of GPIO pins, accessed together at register speed
+ * @tparam pins GPIO numbers, 0-31. The first pin corresponds to bit 0 of values.
+ *
+ * Mapping between values and pins is resolved at compile time, so for example
+ * an 8-bit parallel bus can be written with a handful of instructions:
+ *
+ * 		using DataBus = DigitalPins<12, 13, 14, 15, 4, 5, 2, 0>;
+ * 		DataBus::setMode(OUTPUT);
+ * 		DataBus::write(0xA5);
+ *
+ * Where the pins are consecutive and in ascending order a single shift is used.
+ */
+template <uint8_t... pins> class DigitalPins
+{
+	static_assert(sizeof...(pins) != 0, "DigitalPins requires at least one pin");
+	static_assert(((pins < 32) && ...), "DigitalPins only handles GPIO0-31");
+
+public:
+	static constexpr unsigned count = sizeof...(pins);
+	static constexpr uint32_t mask = ((1U << pins) | ...);
+	static_assert(__builtin_popcount(mask) == count, "DigitalPins contains duplicate pins");
+
+	/**
+	 * @brief Convert a value into pin states
+	 */
+	static constexpr uint32_t toPort(uint32_t value)
+	{
+		if constexpr(consecutive()) {
+			return (value << firstPin) & mask;
+		} else {
+			return toPort(value, std::make_index_sequence<count>());
+		}
+	}
+
+	/**
+	 * @brief Convert pin states into a value
+	 */
+	static constexpr uint32_t fromPort(uint32_t port)
+	{
+		if constexpr(consecutive()) {
+			return (port & mask) >> firstPin;
+		} else {
+			return fromPort(port, std::make_index_sequence<count>());
+		}
+	}
+
+	static void setMode(uint8_t mode)
+	{
+		for(auto pin : pinList) {
+			pinMode(pin, mode);
+		}
+	}
+
+	__forceinline static void IRAM_ATTR write(uint32_t value)
+	{
+		digitalWriteMask(mask, toPort(value));
+	}
+
+	__forceinline static uint32_t IRAM_ATTR read()
+	{
+		return fromPort(digitalReadPort());
+	}
+
+	__forceinline static void IRAM_ATTR set()
+	{
+		digitalSetMask(mask);
+	}
+
+	__forceinline static void IRAM_ATTR clear()
+	{
+		digitalClearMask(mask);
+	}
+
+	__forceinline static void IRAM_ATTR toggle()
+	{
+		digitalToggleMask(mask);
+	}
+
+private:
+	static constexpr uint8_t pinList[]{pins...};
+	static constexpr uint8_t firstPin{pinList[0]};
+
+	static constexpr bool consecutive()
+	{
+		for(unsigned i = 1; i < count; ++i) {
+			if(pinList[i] != firstPin + i) {
+				return false;
+			}
+		}
+		return true;
+	}
+
+	template <size_t... index> static constexpr uint32_t toPort(uint32_t value, std::index_sequence<index...>)
+	{
+		return ((((value >> index) & 1U) << pinList[index]) | ...);
+	}
+
+	template <size_t... index> static constexpr uint32_t fromPort(uint32_t port, std::index_sequence<index...>)
+	{
+		return ((((port >> pinList[index]) & 1U) << index) | ...);
+	}
+};
@@ -0,0 +1,214 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/SmingHub/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * EventBus.cpp
+ *
+ * Each subscriber queues references to payloads in a ring buffer.
+ * A single task queue callback per bus delivers everything pending.
+ *
+ ****/
+
+#include "EventBus.h"
+#include <Platform/System.h>
+#include <debug_progmem.h>
+
+namespace
+{
+Vector<const FlashString*> topicNames;
+}
+
+/* EventPayload */
+
+EventPayload::EventPayload(const void* data, size_t size) : length(size)
+{
+	auto buf = new char[size];
+	if(buf == nullptr) {
+		length = 0;
+		return;
+	}
+	memcpy(buf, data, size);
+	buffer = std::shared_ptr<const char>(buf, [](const char* p) { delete[] p; });
+}
+
+/* EventSubscriber */
+
+EventSubscriber::EventSubscriber(Callback callback, uint8_t queueSize, DropPolicy policy)
+	: callback(callback), queue(new Event[queueSize]), queueSize(queueSize), policy(policy)
+{
+}
+
+EventSubscriber::~EventSubscriber()
+{
+	if(bus != nullptr) {
+		bus->unsubscribe(*this);
+	}
+}
+
+bool EventSubscriber::enqueue(Topic topic, const EventPayload& payload)
+{
+	if(queueSize == 0) {
+		++stats.dropped;
+		return false;
+	}
+
+	if(count == queueSize) {
+		++stats.dropped;
+		if(policy == DropPolicy::newest) {
+			return false;
+		}
+		queue[head] = Event{};
+		head = (head + 1) % queueSize;
+		--count;
+	}
+
+	queue[(head + count) % queueSize] = Event{topic, payload};
+	++count;
+	return true;
+}
+
+void EventSubscriber::deliver()
+{
+	unsigned n = count;
+	if(n == 0) {
+		return;
+	}
+
+	// Move events out so the callback may publish, including to this subscriber
+	std::unique_ptr<Event[]> batch(new Event[n]);
+	for(unsigned i = 0; i < n; ++i) {
+		batch[i] = std::move(queue[(head + i) % queueSize]);
+	}
+	head = 0;
+	count = 0;
+
+	stats.delivered += n;
+	++stats.batches;
+	if(callback) {
+		callback(batch.get(), n);
+	}
+}
+
+void EventSubscriber::clear()
+{
+	for(unsigned i = 0; i < count; ++i) {
+		queue[(head + i) % queueSize] = Event{};
+	}
+	head = 0;
+	count = 0;
+	ready = false;
+}
+
+/* EventBus */
+
+EventBus::~EventBus()
+{
+	while(auto subscriber = subscribers.head()) {
+		unsubscribe(*subscriber);
+	}
+}
+
+void EventBus::subscribe(EventSubscriber& subscriber)
+{
+	if(subscriber.bus == this) {
+		return;
+	}
+	if(subscriber.bus != nullptr) {
+		subscriber.bus->unsubscribe(subscriber);
+	}
+	subscribers.add(&subscriber);
+	subscriber.bus = this;
+}
+
+void EventBus::unsubscribe(EventSubscriber& subscriber)
+{
+	if(subscriber.bus != this) {
+		return;
+	}
+	subscribers.remove(&subscriber);
+	subscriber.bus = nullptr;
+	subscriber.clear();
+}
+
+unsigned EventBus::publish(Topic topic, const EventPayload& payload)
+{
+	unsigned queued{0};
+	for(auto& subscriber : subscribers) {
+		if(subscriber.wants(topic) && subscriber.enqueue(topic, payload)) {
+			++queued;
+		}
+	}
+	if(queued != 0) {
+		schedule();
+	}
+	return queued;
+}
+
+void EventBus::schedule()
+{
+	if(scheduled) {
+		return;
+	}
+
+	scheduled = System.queueCallback(
+		[](void* param) {
+			auto bus = static_cast<EventBus*>(param);
+			bus->scheduled = false;
+			bus->dispatch();
+		},
+		this);
+
+	if(!scheduled) {
+		debug_w("[EVENT] Task queue full");
+	}
+}
+
+void EventBus::dispatch()
+{
+	// Events published by callbacks are left for the next dispatch
+	for(auto& subscriber : subscribers) {
+		subscriber.ready = (subscriber.count != 0);
+	}
+
+	// Callbacks may change subscriptions, so search again after each one
+	for(;;) {
+		EventSubscriber* next{nullptr};
+		for(auto& subscriber : subscribers) {
+			if(subscriber.ready) {
+				next = &subscriber;
+				break;
+			}
+		}
+		if(next == nullptr) {
+			break;
+		}
+		next->ready = false;
+		next->deliver();
+	}
+}
+
+EventBus::Topic EventBus::getTopic(const FlashString& name)
+{
+	for(unsigned i = 0; i < topicNames.count(); ++i) {
+		auto entry = topicNames[i];
+		if(entry == &name || *entry == name) {
+			return firstInternedTopic + i;
+		}
+	}
+	topicNames.add(&name);
+	return firstInternedTopic + topicNames.count() - 1;
+}
+
+String EventBus::getTopicName(Topic topic)
+{
+	if(topic < firstInternedTopic) {
+		return nullptr;
+	}
+	unsigned index = topic - firstInternedTopic;
+	if(index >= topicNames.count()) {
+		return nullptr;
+	}
+	return *topicNames[index];
+}
@@ -0,0 +1,235 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/SmingHub/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * EventBus.h - In-process publish/subscribe with shared payloads
+ *
+ ****/
+
+#pragma once
+
+#include <WString.h>
+#include <Delegate.h>
+#include <FlashString/String.hpp>
+#include <Data/DoublyLinkedObjectList.h>
+#include <Data/Stream/SharedMemoryStream.h>
+#include <memory>
+
+/**
+ * @defgroup eventbus Event Bus
+ * @brief In-process publish/subscribe with shared payloads
+ * @{
+ */
+
+/**
+ * @brief Immutable, reference-counted event content
+ *
+ * Content is copied once when the payload is created. Copies of the payload object
+ * share the same buffer, which is freed when the last copy goes.
+ */
+class EventPayload
+{
+public:
+	EventPayload()
+	{
+	}
+
+	EventPayload(const void* data, size_t size);
+
+	explicit EventPayload(const String& content) : EventPayload(content.c_str(), content.length())
+	{
+	}
+
+	const char* data() const
+	{
+		return buffer.get();
+	}
+
+	size_t size() const
+	{
+		return length;
+	}
+
+	explicit operator bool() const
+	{
+		return bool(buffer);
+	}
+
+	/**
+	 * @brief Create a stream which reads from the shared content without copying it
+	 */
+	IDataSourceStream* createStream() const
+	{
+		return buffer ? new SharedMemoryStream<const char>(buffer, length) : nullptr;
+	}
+
+private:
+	std::shared_ptr<const char> buffer;
+	size_t length{0};
+};
+
+class EventBus;
+
+/**
+ * @brief Receives events from an EventBus
+ *
+ * Each subscriber has its own bounded queue. Events are delivered from the task queue
+ * in batches, so a burst of events results in a single callback.
+ * If events arrive faster than they are handled the queue fills and, depending on the
+ * drop policy, either the oldest queued event or the new event is discarded.
+ */
+class EventSubscriber : public DoublyLinkedObjectTemplate<EventSubscriber>
+{
+public:
+	using Topic = uint16_t;
+
+	struct Event {
+		Topic topic;
+		EventPayload payload;
+	};
+
+	/**
+	 * @brief Invoked with a batch of events in the order they were published
+	 * @param events Valid only until callback returns
+	 * @param count Number of events
+	 * @note The subscriber must not be destroyed from within its own callback
+	 */
+	using Callback = Delegate<void(const Event* events, unsigned count)>;
+
+	enum class DropPolicy {
+		oldest, ///< Discard oldest queued event to make room, for subscribers which want the latest values
+		newest, ///< Discard the event being published, for subscribers which want a consistent history
+	};
+
+	struct Stats {
+		uint32_t delivered; ///< Events passed to callback
+		uint32_t dropped;	///< Events discarded because queue was full
+		uint32_t batches;   ///< Number of callbacks
+	};
+
+	/**
+	 * @brief Constructor
+	 * @param callback
+	 * @param queueSize Maximum number of events waiting for delivery
+	 * @param policy What to discard when the queue is full
+	 */
+	EventSubscriber(Callback callback, uint8_t queueSize = 8, DropPolicy policy = DropPolicy::oldest);
+
+	~EventSubscriber();
+
+	/**
+	 * @brief Receive events for a topic
+	 * @note With no topics set, events for all topics are received
+	 */
+	void addTopic(Topic topic)
+	{
+		if(!topics.contains(topic)) {
+			topics.add(topic);
+		}
+	}
+
+	void removeTopic(Topic topic)
+	{
+		topics.removeElement(topic);
+	}
+
+	bool wants(Topic topic) const
+	{
+		return topics.isEmpty() || topics.contains(topic);
+	}
+
+	/**
+	 * @brief Get number of events waiting for delivery
+	 */
+	unsigned getQueued() const
+	{
+		return count;
+	}
+
+	const Stats& getStats() const
+	{
+		return stats;
+	}
+
+private:
+	friend class EventBus;
+
+	bool enqueue(Topic topic, const EventPayload& payload);
+	void deliver();
+	void clear();
+
+	Callback callback;
+	std::unique_ptr<Event[]> queue;
+	Vector<Topic> topics;
+	EventBus* bus{nullptr};
+	Stats stats{};
+	uint8_t queueSize;
+	uint8_t head{0};
+	uint8_t count{0};
+	DropPolicy policy;
+	bool ready{false};
+};
+
+/**
+ * @brief Distributes events to subscribers
+ *
+ * Topics are integers chosen by the application, below `firstInternedTopic`,
+ * or obtained by interning a name using `getTopic()`.
+ *
+ * Publishing queues a reference to the payload for each interested subscriber; content is never copied.
+ * Delivery happens in task context, so `publish()` returns quickly and subscribers may be slow.
+ *
+ * @note Methods must be called in task context, not from interrupts
+ */
+class EventBus
+{
+public:
+	using Topic = EventSubscriber::Topic;
+	using Event = EventSubscriber::Event;
+
+	static constexpr Topic firstInternedTopic{0x8000};
+
+	~EventBus();
+
+	void subscribe(EventSubscriber& subscriber);
+
+	void unsubscribe(EventSubscriber& subscriber);
+
+	/**
+	 * @brief Post an event to all interested subscribers
+	 * @retval unsigned Number of subscribers the event was queued for
+	 */
+	unsigned publish(Topic topic, const EventPayload& payload);
+
+	unsigned publish(const FlashString& topicName, const EventPayload& payload)
+	{
+		return publish(getTopic(topicName), payload);
+	}
+
+	/**
+	 * @brief Get topic ID for a name
+	 * @param name Must remain valid as it is referenced, not copied
+	 * @retval Topic Same value is returned for the same name content
+	 * @note Interned names are shared by all buses
+	 */
+	static Topic getTopic(const FlashString& name);
+
+	/**
+	 * @brief Get name of interned topic
+	 * @retval String Empty if topic is not interned
+	 */
+	static String getTopicName(Topic topic);
+
+private:
+	friend class EventSubscriber;
+
+	void schedule();
+	void dispatch();
+
+	DoublyLinkedObjectListTemplate<EventSubscriber> subscribers;
+	bool scheduled{false};
+};
+
+/** @} */
@@ -11,23 +11,39 @@
 #include "FileSystem.h"
 #include <Storage.h>
 #include <debug_progmem.h>
+#include <Services/Profiling/BootTimeline.h>
 
 namespace SmingInternal
 {
 IFS::FileSystem* activeFileSystem;
+IFS::IFileSystem* pendingFileSystem;
+
+IFS::FileSystem* mountPendingFileSystem()
+{
+	auto fs = pendingFileSystem;
+	pendingFileSystem = nullptr;
+	debug_d("Mounting file system on first access");
+	// On failure, there's no filesystem so further calls won't retry
+	fileMountFileSystem(fs);
+	return activeFileSystem;
 }
 
+} // namespace SmingInternal
+
 namespace IFS
 {
 FileSystem* getDefaultFileSystem()
 {
-	return SmingInternal::activeFileSystem;
+	return SmingInternal::getActiveFileSystem();
 }
 
 } // namespace IFS
 
 void fileSetFileSystem(IFS::IFileSystem* fileSystem)
 {
+	delete SmingInternal::pendingFileSystem;
+	SmingInternal::pendingFileSystem = nullptr;
+
 	if(SmingInternal::activeFileSystem != fileSystem) {
 		delete SmingInternal::activeFileSystem;
 		SmingInternal::activeFileSystem = IFS::FileSystem::cast(fileSystem);
@@ -41,7 +57,9 @@ bool fileMountFileSystem(IFS::IFileSystem* fs)
 		return false;
 	}
 
+	BOOT_PHASE_BEGIN(fileSystem);
 	int res = fs->mount();
+	BOOT_PHASE_END(fileSystem);
 	debug_i("mount() returned %d (%s)", res, fs->getErrorString(res).c_str());
 
 	if(res < 0) {
@@ -55,6 +73,18 @@ bool fileMountFileSystem(IFS::IFileSystem* fs)
 	return true;
 }
 
+bool fileMountFileSystemLazy(IFS::IFileSystem* fs)
+{
+	if(fs == nullptr) {
+		debug_e("Failed to created filesystem object");
+		return false;
+	}
+
+	fileSetFileSystem(nullptr);
+	SmingInternal::pendingFileSystem = fs;
+	return true;
+}
+
 bool fwfs_mount()
 {
 	auto part = Storage::findDefaultPartition(Storage::Partition::SubType::Data::fwfs);
@@ -69,7 +99,7 @@ bool fwfs_mount(Storage::Partition partition)
 
 IFS::IFileSystem::Type fileSystemType()
 {
-	if(SmingInternal::activeFileSystem == nullptr) {
+	if(!fileHasFileSystem()) {
 		return IFS::IFileSystem::Type::Unknown;
 	}
 	IFS::IFileSystem::Info info;
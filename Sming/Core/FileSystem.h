@@ -45,13 +45,33 @@ namespace SmingInternal
  */
 extern IFS::FileSystem* activeFileSystem;
 
+/**
+ * @brief File system waiting to be mounted on first access
+ * @see fileMountFileSystemLazy()
+ */
+extern IFS::IFileSystem* pendingFileSystem;
+
+/**
+ * @brief Mount pending file system and make it active
+ * @retval IFS::FileSystem* Active file system, nullptr if mount failed
+ */
+IFS::FileSystem* mountPendingFileSystem();
+
+/**
+ * @brief Get active file system, mounting it first if necessary
+ */
+inline IFS::FileSystem* getActiveFileSystem()
+{
+	return pendingFileSystem ? mountPendingFileSystem() : activeFileSystem;
+}
+
 } // namespace SmingInternal
 
 /*
  * Boilerplate check for file function wrappers to catch undefined filesystem.
  */
 #define CHECK_FS(_method)                                                                                              \
-	auto fileSystem = static_cast<IFS::FileSystem*>(SmingInternal::activeFileSystem);                                  \
+	auto fileSystem = SmingInternal::getActiveFileSystem();                                                            \
 	if(fileSystem == nullptr) {                                                                                        \
 		debug_e("ERROR in %s(): No active file system", __FUNCTION__);                                                 \
 		return FileHandle(IFS::Error::NoFileSystem);                                                                   \
@@ -63,10 +83,11 @@ extern IFS::FileSystem* activeFileSystem;
  */
 inline IFS::FileSystem* getFileSystem()
 {
-	if(SmingInternal::activeFileSystem == nullptr) {
+	auto fs = SmingInternal::getActiveFileSystem();
+	if(fs == nullptr) {
 		debug_e("ERROR: No active file system");
 	}
-	return SmingInternal::activeFileSystem;
+	return fs;
 }
 
 /** @brief Sets the currently active file system
@@ -89,6 +110,29 @@ inline void fileFreeFileSystem()
  */
 bool fileMountFileSystem(IFS::IFileSystem* fs);
 
+/**
+ * @brief Set a constructed filesystem to be mounted when first accessed
+ * @param fs
+ * @retval bool false if fs is nullptr
+ *
+ * Mounting requires reading and checking filesystem structures, which can take a significant
+ * part of the boot time and is wasted if the application doesn't use files, for example when
+ * waking from deep sleep just to send a reading. This defers mounting until the first
+ * file operation. If mounting fails at that point the filesystem is discarded and the
+ * operation returns `IFS::Error::NoFileSystem`.
+ *
+ * Any active filesystem is destroyed first.
+ */
+bool fileMountFileSystemLazy(IFS::IFileSystem* fs);
+
+/**
+ * @brief Determine if a filesystem is available, either mounted or due to be mounted on first access
+ */
+inline bool fileHasFileSystem()
+{
+	return SmingInternal::activeFileSystem != nullptr || SmingInternal::pendingFileSystem != nullptr;
+}
+
 /**
  * @brief Mount the first available FWFS volume
  * @retval bool true on success
@@ -118,6 +118,34 @@ public:
 		return maxduty;
 	}
 
+	/** @brief  Set duty cycles for several channels at once
+	 *  @param  duties Array of duty values, starting at channel 0
+	 *  @param  count Number of values in array
+	 *  @retval bool True on success, no changes are made on failure
+	 *  @note   New values take effect together at the start of the next period
+	 */
+	bool setDuties(const uint32_t* duties, uint8_t count);
+
+	/** @brief  Play back a precomputed sequence of duty cycles, such as a fade curve
+	 *  @param  duties Array of duty values, `steps` rows each containing a value for every channel
+	 *  @param  steps Number of rows in the array
+	 *  @param  periodsPerStep Number of PWM periods each step is output for
+	 *  @param  loop true to repeat the sequence, false to hold the final step
+	 *  @retval bool True on success, false if not supported or invalid
+	 *  @note   Steps are switched by the PWM driver at period boundaries, with no further CPU work.
+	 *          The duty array may be discarded once this call returns.
+	 *          Any subsequent duty or period update cancels the sequence.
+	 */
+	bool playSequence(const uint32_t* duties, uint16_t steps, uint16_t periodsPerStep = 1, bool loop = false);
+
+	/** @brief  Stop sequence playback, holding the current step
+	 */
+	void stopSequence();
+
+	/** @brief  Determine if a sequence is being played
+	 */
+	bool isSequenceRunning();
+
 	/** @brief  This function is used to actually update the PWM.
 	 */
 	void update();
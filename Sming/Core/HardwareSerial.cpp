@@ -12,6 +12,7 @@
 
 #include "HardwareSerial.h"
 #include <cstdarg>
+#include <driver/SerialBuffer.h>
 #include "Platform/System.h"
 #include "m_printf.h"
 
@@ -21,11 +22,110 @@
 
 HardwareSerial Serial(UART_ID_0);
 
+/*
+ * Ping-pong buffers for frame reception.
+ * One buffer is filled by the ISR whilst the other is owned by the application.
+ */
+struct HardwareSerial::FrameReceiver {
+	FrameReceiver(size_t size, uint8_t idleChars) : size(size), idleChars(idleChars)
+	{
+		buffers[0] = new uint8_t[size * 2];
+		buffers[1] = buffers[0] + size;
+	}
+
+	~FrameReceiver()
+	{
+		delete[] buffers[0];
+	}
+
+	/*
+	 * Called from ISR
+	 * @retval bool true if a frame is ready for delivery
+	 */
+	bool IRAM_ATTR receive(smg_uart_t* uart, uint32_t status);
+
+	void reset()
+	{
+		length = 0;
+		frameStatus = 0;
+		truncated = false;
+	}
+
+	uint8_t* buffers[2];
+	size_t size;
+	uint8_t idleChars;
+	uint8_t active{0};			///< Buffer being filled by ISR
+	size_t length{0};			///< Data in active buffer
+	unsigned frameStatus{0};	///< SerialStatus bits for active frame
+	bool truncated{false};		///< Active frame exceeds buffer size
+	volatile bool ready{false}; ///< Inactive buffer contains a frame for the application
+	size_t readyLength{0};
+	unsigned readyStatus{0};
+	SerialFrameStats stats{};
+};
+
+bool HardwareSerial::FrameReceiver::receive(smg_uart_t* uart, uint32_t status)
+{
+	if(status & UART_STATUS_RXFIFO_OVF) {
+		++stats.overflows;
+		bitSet(frameStatus, eSERS_Overflow);
+	}
+	if(status & UART_STATUS_BRK_DET) {
+		++stats.breaks;
+		bitSet(frameStatus, eSERS_BreakDetected);
+	}
+
+	/*
+	 * Driver has already moved data from the hardware FIFO into the receive buffer.
+	 * Copy it out in contiguous blocks: the drivers own that buffer, so it cannot be handed over directly.
+	 */
+	auto rxbuf = uart->rx_buffer;
+	if(rxbuf != nullptr) {
+		void* data;
+		size_t avail;
+		while((avail = rxbuf->getReadData(data)) != 0) {
+			size_t space = size - length;
+			size_t count = (avail <= space) ? avail : space;
+			memcpy(&buffers[active][length], data, count);
+			length += count;
+			if(count < avail) {
+				truncated = true;
+			}
+			rxbuf->skipRead(avail);
+		}
+	}
+
+	// Line has gone idle, so frame is complete
+	if((status & UART_STATUS_RXFIFO_TOUT) == 0 || length == 0) {
+		return false;
+	}
+
+	if(truncated) {
+		++stats.oversize;
+		bitSet(frameStatus, eSERS_Overflow);
+	}
+
+	if(ready) {
+		// Application hasn't finished with the other buffer
+		++stats.overruns;
+		reset();
+		return false;
+	}
+
+	readyLength = length;
+	readyStatus = frameStatus;
+	active ^= 1;
+	ready = true;
+	reset();
+	return true;
+}
+
 HardwareSerial::~HardwareSerial()
 {
 #if ENABLE_CMD_EXECUTOR
 	delete commandExecutor;
 #endif
+	onFrameReceived(nullptr);
 }
 
 void HardwareSerial::begin(uint32_t baud, SerialFormat format, SerialMode mode, uint8_t txPin, uint8_t rxPin)
@@ -48,6 +148,7 @@ void HardwareSerial::begin(uint32_t baud, SerialFormat format, SerialMode mode,
 	};
 	uart = smg_uart_init_ex(cfg);
 	updateUartCallback();
+	applyFrameTimeout();
 }
 
 void HardwareSerial::end()
@@ -84,6 +185,25 @@ size_t HardwareSerial::setTxBufferSize(size_t size)
 	return txSize;
 }
 
+bool HardwareSerial::queueWrite(SerialTxDescriptor& desc)
+{
+	if(smg_uart_write_desc(uart, &desc)) {
+		return true;
+	}
+
+	if(!smg_uart_tx_enabled(uart) || desc.data == nullptr || desc.length == 0) {
+		return false;
+	}
+
+	// Not supported by this port, so copy the data instead
+	desc.sent = smg_uart_write(uart, desc.data, desc.length);
+	desc.next = nullptr;
+	if(desc.callback != nullptr) {
+		desc.callback(uart, &desc);
+	}
+	return true;
+}
+
 void HardwareSerial::systemDebugOutput(bool enabled)
 {
 	if(!uart) {
@@ -118,6 +238,11 @@ void HardwareSerial::invokeCallbacks()
 		transmitComplete(*this);
 	}
 
+	if(frameReceiver != nullptr) {
+		deliverFrame();
+		return;
+	}
+
 	// RX FIFO Full or RX FIFO Timeout or RX Overflow ?
 	if(status & (UART_STATUS_RXFIFO_FULL | UART_STATUS_RXFIFO_TOUT | UART_STATUS_RXFIFO_OVF)) {
 		auto receivedChar = smg_uart_peek_last_char(uart);
@@ -135,6 +260,84 @@ void HardwareSerial::invokeCallbacks()
 	}
 }
 
+bool HardwareSerial::onFrameReceived(SerialFrameDelegate callback, size_t maxFrameSize, uint8_t idleChars)
+{
+	FrameReceiver* newReceiver{nullptr};
+	if(callback) {
+		if(maxFrameSize == 0) {
+			return false;
+		}
+		newReceiver = new FrameReceiver(maxFrameSize, idleChars);
+		// Frames are assembled from the receive buffer
+		if(rxSize == 0) {
+			setRxBufferSize(DEFAULT_RX_BUFFER_SIZE);
+		}
+	}
+
+	(void)smg_uart_disable_interrupts();
+	auto oldReceiver = frameReceiver;
+	frameReceiver = newReceiver;
+	frameReceived = callback;
+	smg_uart_restore_interrupts();
+	delete oldReceiver;
+
+	applyFrameTimeout();
+	updateUartCallback();
+	return true;
+}
+
+void HardwareSerial::applyFrameTimeout()
+{
+	if(uart != nullptr && frameReceiver != nullptr) {
+		smg_uart_set_rx_timeout(uart, frameReceiver->idleChars);
+	}
+}
+
+void HardwareSerial::deliverFrame()
+{
+	auto fr = frameReceiver;
+	if(!fr->ready) {
+		return;
+	}
+
+	// Hardware only latches these conditions, so attribute them to the frame just received
+	unsigned status = fr->readyStatus | getStatus();
+	if(bitRead(status, eSERS_FramingError)) {
+		++fr->stats.framingErrors;
+	}
+	if(bitRead(status, eSERS_ParityError)) {
+		++fr->stats.parityErrors;
+	}
+	++fr->stats.frames;
+
+	if(frameReceived) {
+		frameReceived(*this, fr->buffers[fr->active ^ 1], fr->readyLength, status);
+	}
+
+	// Release buffer for use by ISR
+	fr->ready = false;
+}
+
+SerialFrameStats HardwareSerial::getFrameStats() const
+{
+	if(frameReceiver == nullptr) {
+		return SerialFrameStats{};
+	}
+	(void)smg_uart_disable_interrupts();
+	auto stats = frameReceiver->stats;
+	smg_uart_restore_interrupts();
+	return stats;
+}
+
+void HardwareSerial::resetFrameStats()
+{
+	if(frameReceiver != nullptr) {
+		(void)smg_uart_disable_interrupts();
+		frameReceiver->stats = SerialFrameStats{};
+		smg_uart_restore_interrupts();
+	}
+}
+
 unsigned HardwareSerial::getStatus()
 {
 	unsigned status = 0;
@@ -181,8 +384,10 @@ void HardwareSerial::staticCallbackHandler(smg_uart_t* uart, uint32_t status)
 
 	serial->callbackStatus |= status;
 
+	bool frameReady = (serial->frameReceiver != nullptr) && serial->frameReceiver->receive(uart, status);
+
 	// If required, queue a callback
-	if((status & serial->statusMask) != 0 && !serial->callbackQueued) {
+	if((frameReady || (status & serial->statusMask) != 0) && !serial->callbackQueued) {
 		System.queueCallback(staticOnStatusChange, serial);
 		serial->callbackQueued = true;
 	}
@@ -205,9 +410,10 @@ bool HardwareSerial::updateUartCallback()
 
 	statusMask = mask;
 
-	setUartCallback(mask == 0 ? nullptr : staticCallbackHandler, this);
+	bool enabled = (mask != 0) || (frameReceiver != nullptr);
+	setUartCallback(enabled ? staticCallbackHandler : nullptr, this);
 
-	return mask != 0;
+	return enabled;
 }
 
 void HardwareSerial::commandProcessing(bool reqEnable)
@@ -50,6 +50,30 @@ using StreamDataReceivedDelegate = Delegate<void(Stream& source, char arrivedCha
  */
 using TransmitCompleteDelegate = Delegate<void(HardwareSerial& serial)>;
 
+/** @brief Delegate callback type for frame reception
+ *  @param serial The serial port
+ *  @param data Frame content, valid only until the callback returns
+ *  @param length Number of bytes in the frame
+ *  @param status Combination of SerialStatus bits for errors detected whilst the frame was received
+ *  @see See `HardwareSerial::onFrameReceived()`
+ */
+using SerialFrameDelegate =
+	Delegate<void(HardwareSerial& serial, const uint8_t* data, size_t length, unsigned status)>;
+
+/** @brief Describes a caller-owned block of data for `HardwareSerial::queueWrite()` */
+using SerialTxDescriptor = smg_uart_tx_desc_t;
+
+/** @brief Frame reception statistics */
+struct SerialFrameStats {
+	uint32_t frames;		///< Frames delivered to the application
+	uint32_t overruns;		///< Frames discarded because the application was still handling the previous one
+	uint32_t oversize;		///< Frames truncated because they exceeded the buffer size
+	uint32_t overflows;		///< Receive FIFO overflows
+	uint32_t breaks;		///< Break conditions detected
+	uint32_t framingErrors; ///< Frames received with framing errors
+	uint32_t parityErrors;  ///< Frames received with parity errors
+};
+
 class CommandExecutor;
 
 // clang-format off
@@ -326,6 +350,24 @@ public:
 		return smg_uart_write(uart, buffer, size);
 	}
 
+	/**
+	 * @brief Queue caller-owned data for transmission without copying
+	 * @param desc Describes the data, and must remain valid until its callback is invoked
+	 * @retval bool true if data was queued or written
+	 *
+	 * The serial ISR feeds the data straight into the hardware FIFO, so large blocks do not
+	 * pass through the transmit buffer. Blocks are sent in order. Once all of a block has been passed
+	 * to the hardware, or it has been discarded by `clear()`, `desc.callback` is invoked
+	 * (normally from interrupt context) and the buffer may be re-used. `desc.sent` indicates how much
+	 * was transmitted.
+	 *
+	 * Where the port doesn't support this the data is written via the transmit buffer instead,
+	 * and the callback invoked before returning.
+	 *
+	 * @note Data written using `write()` whilst blocks are queued may be sent ahead of them.
+	 */
+	bool queueWrite(SerialTxDescriptor& desc);
+
 	/** @brief  Configure serial port for system debug output and redirect output from debugf
 	 *  @param  enabled True to enable this port for system debug output
 	 *  @note   If enabled, port will issue system debug messages
@@ -359,6 +401,37 @@ public:
 		return updateUartCallback();
 	}
 
+	/**
+	 * @brief Receive data as complete frames, delimited by an idle period on the receive line
+	 * @param callback Invoked for each frame. Specify nullptr to revert to normal operation.
+	 * @param maxFrameSize Largest frame to be received. Longer frames are truncated.
+	 * @param idleChars Idle time which terminates a frame, in character times
+	 * @retval bool true on success
+	 *
+	 * Received data is accumulated into one of two frame buffers from the serial ISR.
+	 * This is copied in blocks from the driver's receive buffer, which is still used to drain the hardware FIFO.
+	 * When the line goes idle the buffers are swapped and the completed frame is passed
+	 * to the application from task context without further copying. The next frame is received whilst the previous one
+	 * is being handled: if the application hasn't finished before another frame completes,
+	 * that frame is discarded and counted as an overrun.
+	 *
+	 * For Modbus RTU, for example, an idle period of 3.5 character times delimits frames so use idleChars = 4.
+	 *
+	 * @note Whilst enabled, received data is not available via `read()` and `onDataReceived()` callbacks are not invoked.
+	 * Idle detection relies on the hardware receive timeout, which cannot be adjusted on some architectures.
+	 */
+	bool onFrameReceived(SerialFrameDelegate callback, size_t maxFrameSize = 256, uint8_t idleChars = 4);
+
+	/**
+	 * @brief Get frame reception statistics
+	 */
+	SerialFrameStats getFrameStats() const;
+
+	/**
+	 * @brief Reset frame reception statistics
+	 */
+	void resetFrameStats();
+
 	/**
 	 * @brief  Set callback ISR for received data
 	 * @param  callback Function to handle received data
@@ -442,10 +515,14 @@ public:
 	unsigned getStatus();
 
 private:
+	struct FrameReceiver;
+
 	int uartNr = UART_NO;
 	TransmitCompleteDelegate transmitComplete = nullptr; ///< Callback for transmit completion
 	StreamDataReceivedDelegate HWSDelegate = nullptr;	///< Callback for received data
 	CommandExecutor* commandExecutor = nullptr;			 ///< Callback for command execution (received data)
+	SerialFrameDelegate frameReceived = nullptr;		 ///< Callback for received frames
+	FrameReceiver* frameReceiver = nullptr;				 ///< Frame buffers and state
 	smg_uart_t* uart = nullptr;
 	uart_options_t options = _BV(UART_OPT_TXWAIT);
 	size_t txSize = DEFAULT_TX_BUFFER_SIZE;
@@ -462,6 +539,8 @@ private:
 	static void IRAM_ATTR staticCallbackHandler(smg_uart_t* uart, uint32_t status);
 	static void staticOnStatusChange(void* param);
 	void invokeCallbacks();
+	void deliverFrame();
+	void applyFrameTimeout();
 
 	/**
 	 * @brief Called whenever one of the user callbacks change
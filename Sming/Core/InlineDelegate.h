@@ -0,0 +1,169 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/SmingHub/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * InlineDelegate.h
+ *
+ ****/
+
+/** @addtogroup   delegate
+ *  @{
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+/**
+ * @brief Default storage capacity for an InlineDelegate, in bytes
+ *
+ * Sufficient for a method delegate (member function pointer plus object) or
+ * a lambda capturing up to four pointers.
+ */
+#ifndef DELEGATE_INLINE_CAPACITY
+#define DELEGATE_INLINE_CAPACITY (4 * sizeof(void*))
+#endif
+
+template <typename, size_t Capacity = DELEGATE_INLINE_CAPACITY> class InlineDelegate; /* undefined */
+
+/**
+ * @brief Delegate with fixed inline storage which never uses the heap
+ * @tparam Capacity Bytes available for the callable object
+ *
+ * May be constructed in the same way as a Delegate, from a function pointer,
+ * a class method and object pointer, or a lambda.
+ *
+ * The callable must fit within `Capacity` and be trivially copyable:
+ * this is checked at compile time so a large capture is an error rather than a hidden heap allocation.
+ * For lambdas this means capturing pointers, references or simple values, but not (for example) a String.
+ * Copying an InlineDelegate is then just a copy of its storage.
+ *
+ * Calling an empty InlineDelegate does nothing and returns a default-constructed value.
+ */
+template <typename ReturnType, typename... ParamTypes, size_t Capacity>
+class InlineDelegate<ReturnType(ParamTypes...), Capacity>
+{
+public:
+	static constexpr size_t capacity{Capacity};
+
+	InlineDelegate() = default;
+
+	InlineDelegate(std::nullptr_t)
+	{
+	}
+
+	/** @brief Delegate a regular function
+	 *  @param fn Function pointer, may be null
+	 */
+	InlineDelegate(ReturnType (*fn)(ParamTypes...))
+	{
+		if(fn != nullptr) {
+			assign(fn);
+		}
+	}
+
+	/** @brief  Delegate a class method
+	 *  @param m Method declaration to delegate
+	 *  @param  c Pointer to the class type
+	 */
+	template <class ClassType> InlineDelegate(ReturnType (ClassType::*m)(ParamTypes...), ClassType* c)
+	{
+		assign([m, c](ParamTypes... params) -> ReturnType { return (c->*m)(params...); });
+	}
+
+	/** @brief Delegate any other callable object, such as a lambda
+	 */
+	template <typename Callable, typename = typename std::enable_if<
+									 !std::is_same<typename std::decay<Callable>::type, InlineDelegate>::value &&
+									 !std::is_pointer<typename std::decay<Callable>::type>::value>::type>
+	InlineDelegate(Callable&& callable)
+	{
+		assign(std::forward<Callable>(callable));
+	}
+
+	InlineDelegate& operator=(std::nullptr_t)
+	{
+		invoker = nullptr;
+		return *this;
+	}
+
+	explicit operator bool() const
+	{
+		return invoker != nullptr;
+	}
+
+	ReturnType operator()(ParamTypes... params) const
+	{
+		if(invoker == nullptr) {
+			return empty();
+		}
+		return invoker(&storage, params...);
+	}
+
+	bool operator==(std::nullptr_t) const
+	{
+		return invoker == nullptr;
+	}
+
+	bool operator!=(std::nullptr_t) const
+	{
+		return invoker != nullptr;
+	}
+
+private:
+	using Invoker = ReturnType (*)(const void* storage, ParamTypes... params);
+
+	template <typename Callable> void assign(Callable&& callable)
+	{
+		using T = typename std::decay<Callable>::type;
+		static_assert(sizeof(T) <= Capacity, "Capture too large for InlineDelegate");
+		static_assert(alignof(T) <= alignof(uint64_t), "Capture alignment not supported by InlineDelegate");
+		static_assert(std::is_trivially_copyable<T>::value, "InlineDelegate requires a trivially copyable capture");
+		static_assert(std::is_trivially_destructible<T>::value,
+					  "InlineDelegate requires a trivially destructible capture");
+
+		new(&storage) T(std::forward<Callable>(callable));
+		invoker = [](const void* storage, ParamTypes... params) -> ReturnType {
+			auto& fn = *static_cast<T*>(const_cast<void*>(storage));
+			return fn(params...);
+		};
+	}
+
+	// Result of invoking an empty delegate, selected by tag dispatch to remain C++11 compatible
+	using EmptyVoid = std::integral_constant<int, 0>;
+	using EmptyDefault = std::integral_constant<int, 1>;
+	using EmptyAbort = std::integral_constant<int, 2>;
+	using EmptyKind = typename std::conditional<
+		std::is_void<ReturnType>::value, EmptyVoid,
+		typename std::conditional<std::is_default_constructible<ReturnType>::value, EmptyDefault, EmptyAbort>::type>::type;
+
+	static ReturnType empty()
+	{
+		return empty(EmptyKind());
+	}
+
+	static ReturnType empty(EmptyVoid)
+	{
+	}
+
+	static ReturnType empty(EmptyDefault)
+	{
+		return ReturnType();
+	}
+
+	static ReturnType empty(EmptyAbort)
+	{
+		abort();
+	}
+
+	alignas(uint64_t) unsigned char storage[Capacity];
+	Invoker invoker{nullptr};
+};
+
+/** @} */
@@ -0,0 +1,154 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/SmingHub/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * Job.cpp
+ *
+ * Running jobs are kept in a list, serviced round-robin by a single low-priority task queue callback.
+ *
+ ****/
+
+#include "Job.h"
+#include <Platform/System.h>
+#include <Platform/WDT.h>
+#include <Platform/Timers.h>
+#include <Services/Profiling/Trace.h>
+#include <debug_progmem.h>
+
+class JobQueue
+{
+public:
+	void add(Job& job)
+	{
+		jobs.add(&job);
+		schedule();
+	}
+
+	void remove(Job& job)
+	{
+		if(&job == current) {
+			current = job.getNext();
+		}
+		jobs.remove(&job);
+	}
+
+private:
+	void schedule();
+	void service();
+
+	LinkedObjectListTemplate<Job> jobs;
+	Job* current{nullptr};
+	bool scheduled{false};
+};
+
+namespace
+{
+JobQueue queue;
+}
+
+void JobQueue::schedule()
+{
+	if(scheduled || jobs.isEmpty()) {
+		return;
+	}
+
+	scheduled = System.queueCallback(
+		TaskPriority::Low,
+		[](void* param) {
+			auto queue = static_cast<JobQueue*>(param);
+			queue->scheduled = false;
+			queue->service();
+		},
+		this);
+
+	if(!scheduled) {
+		debug_w("[JOB] Task queue full");
+	}
+}
+
+void JobQueue::service()
+{
+	if(current == nullptr) {
+		current = jobs.head();
+	}
+	auto job = current;
+	if(job == nullptr) {
+		return;
+	}
+
+	TRACE_SCOPE("job", job);
+
+	++job->turnCount;
+	OneShotFastUs timer(job->budget);
+	auto result = Job::Result::More;
+	do {
+		result = job->step();
+	} while(result == Job::Result::More && job->isRunning() && !timer.expired());
+
+	WDT.alive();
+
+	// Cancelled from within step()
+	if(!job->isRunning()) {
+		schedule();
+		return;
+	}
+
+	current = job->getNext();
+
+	if(result != Job::Result::More) {
+		job->finish(result == Job::Result::Done ? Job::State::Complete : Job::State::Failed);
+	} else if(job->progressChanged) {
+		job->progressChanged = false;
+		if(job->progressCallback) {
+			job->progressCallback(*job);
+		}
+	}
+
+	schedule();
+}
+
+Job::~Job()
+{
+	if(state == State::Running) {
+		queue.remove(*this);
+	}
+}
+
+bool Job::start(uint32_t budget)
+{
+	if(state == State::Running) {
+		return false;
+	}
+
+	this->budget = budget;
+	progress = 0;
+	progressChanged = false;
+	turnCount = 0;
+	state = State::Running;
+	queue.add(*this);
+	return true;
+}
+
+void Job::cancel()
+{
+	if(state == State::Running) {
+		finish(State::Cancelled);
+	}
+}
+
+void Job::finish(State newState)
+{
+	queue.remove(*this);
+	state = newState;
+	if(progressChanged) {
+		progressChanged = false;
+		if(progressCallback) {
+			progressCallback(*this);
+		}
+	}
+	if(completeCallback) {
+		completeCallback(*this);
+	}
+}
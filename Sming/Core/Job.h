@@ -0,0 +1,178 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/SmingHub/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * Job.h - Long-running work performed co-operatively in the background
+ *
+ ****/
+
+#pragma once
+
+#include <Delegate.h>
+#include <Data/LinkedObjectList.h>
+
+/**
+ * @brief Default time in microseconds given to a job on each turn
+ */
+#ifndef JOB_STEP_BUDGET_US
+#define JOB_STEP_BUDGET_US 2000
+#endif
+
+/**
+ * @defgroup job Job
+ * @brief Long-running work performed co-operatively in the background
+ * @{
+ */
+
+/**
+ * @brief Base class for a long-running job
+ *
+ * Operations such as erasing large areas of flash, hashing a file or copying a partition take
+ * too long to run in one go: they trip the watchdog and hold up network processing.
+ *
+ * Implement such an operation by dividing the work into small pieces, each performed by a call to `step()`.
+ * Running jobs take turns from the low-priority task queue. On each turn `step()` is called repeatedly
+ * until the job's time budget is used, then the watchdog is fed and the next job gets a turn.
+ * Other tasks, including network processing, run between turns.
+ *
+ * A job must remain valid until it has completed or been cancelled.
+ */
+class Job : public LinkedObjectTemplate<Job>
+{
+public:
+	enum class State {
+		Idle,	  ///< Not started
+		Running,   ///< Waiting for a turn
+		Complete,  ///< step() returned Result::Done
+		Failed,	///< step() returned Result::Error
+		Cancelled, ///< cancel() was called
+	};
+
+	/**
+	 * @brief Value returned from step()
+	 */
+	enum class Result {
+		More,  ///< Call again
+		Done,  ///< Job completed successfully
+		Error, ///< Job failed
+	};
+
+	/**
+	 * @brief Callback for progress and completion
+	 */
+	using Callback = Delegate<void(Job& job)>;
+
+	Job()
+	{
+	}
+
+	Job(const Job&) = delete;
+
+	~Job();
+
+	/**
+	 * @brief Start the job
+	 * @param budget Time in microseconds to spend on each turn. A single step always runs to completion,
+	 * so may exceed this.
+	 * @retval bool false if already running
+	 */
+	bool start(uint32_t budget = JOB_STEP_BUDGET_US);
+
+	/**
+	 * @brief Stop the job
+	 *
+	 * If running, the state changes to `Cancelled` and the completion callback is invoked.
+	 * May be called from within step().
+	 */
+	void cancel();
+
+	/**
+	 * @brief Set callback invoked after each turn in which progress was updated
+	 */
+	void onProgress(Callback callback)
+	{
+		progressCallback = callback;
+	}
+
+	/**
+	 * @brief Set callback invoked when the job completes, fails or is cancelled
+	 * @note The job may be destroyed or restarted from here
+	 */
+	void onComplete(Callback callback)
+	{
+		completeCallback = callback;
+	}
+
+	State getState() const
+	{
+		return state;
+	}
+
+	bool isRunning() const
+	{
+		return state == State::Running;
+	}
+
+	/**
+	 * @brief Get the amount of work done, in units defined by the job
+	 */
+	size_t getProgress() const
+	{
+		return progress;
+	}
+
+	/**
+	 * @brief Get the total amount of work, or 0 if unknown
+	 */
+	size_t getTotal() const
+	{
+		return total;
+	}
+
+	/**
+	 * @brief Get number of turns taken so far
+	 */
+	unsigned getTurnCount() const
+	{
+		return turnCount;
+	}
+
+protected:
+	/**
+	 * @brief Implement to perform a small piece of work
+	 *
+	 * Each call should take much less than the time budget.
+	 */
+	virtual Result step() = 0;
+
+	void setTotal(size_t total)
+	{
+		this->total = total;
+	}
+
+	void setProgress(size_t progress)
+	{
+		if(progress != this->progress) {
+			this->progress = progress;
+			progressChanged = true;
+		}
+	}
+
+private:
+	friend class JobQueue;
+
+	void finish(State newState);
+
+	Callback progressCallback;
+	Callback completeCallback;
+	size_t progress{0};
+	size_t total{0};
+	uint32_t budget{0};
+	unsigned turnCount{0};
+	State state{State::Idle};
+	bool progressChanged{false};
+};
+
+/** @} */
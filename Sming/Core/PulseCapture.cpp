@@ -0,0 +1,135 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/SmingHub/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * PulseCapture.cpp
+ *
+ ****/
+
+#include "PulseCapture.h"
+#include <Interrupts.h>
+#include <debug_progmem.h>
+
+namespace
+{
+PulseCapture* slots[PulseCapture::maxCaptures];
+
+// Pulses converted for each callback
+constexpr size_t batchSize{32};
+
+} // namespace
+
+bool PulseCapture::begin(uint16_t pin, Callback callback)
+{
+	end();
+
+	if(!callback) {
+		return false;
+	}
+
+	for(unsigned i = 0; i < maxCaptures; ++i) {
+		if(slots[i] == nullptr) {
+			slot = i;
+			break;
+		}
+	}
+	if(slot < 0) {
+		debug_e("[PCAP] No free capture slot");
+		return false;
+	}
+
+	this->pin = pin;
+	this->callback = callback;
+	ticksPerUs = 1;
+	ring.clear();
+	ring.setNotify(taskCallback, this);
+	resetStats();
+	slots[slot] = this;
+
+	if(!hardwareBegin()) {
+		debug_e("[PCAP] Capture not available for pin %u", pin);
+		slots[slot] = nullptr;
+		slot = -1;
+		return false;
+	}
+
+	return true;
+}
+
+void PulseCapture::end()
+{
+	if(slot < 0) {
+		return;
+	}
+
+	hardwareEnd();
+
+	/*
+	 * A queued callback may still be pending. It checks the slot before use,
+	 * but the object itself must remain valid until it's run.
+	 */
+	slots[slot] = nullptr;
+	slot = -1;
+	ring.clear();
+}
+
+void PulseCapture::taskCallback(void* param)
+{
+	auto capture = static_cast<PulseCapture*>(param);
+	if(capture->slot < 0) {
+		return;
+	}
+
+	Pulse pulses[batchSize];
+	Edge edge;
+	while(!capture->ring.isEmpty()) {
+		unsigned count{0};
+		while(count < batchSize && capture->ring.pop(edge)) {
+			if(edge.level == capture->lastLevel) {
+				// Missed an edge: extend the current pulse
+				continue;
+			}
+			pulses[count++] = Pulse{(edge.time - capture->lastTime) / capture->ticksPerUs, capture->lastLevel};
+			capture->lastTime = edge.time;
+			capture->lastLevel = edge.level;
+		}
+		if(count == 0) {
+			break;
+		}
+		capture->callback(pulses, count);
+		++capture->stats.batches;
+		if(capture->slot < 0) {
+			// Stopped by callback
+			break;
+		}
+	}
+}
+
+template <unsigned index> void IRAM_ATTR PulseCapture::slotInterrupt()
+{
+	auto capture = slots[index];
+	if(capture != nullptr) {
+		hardwareInterrupt(*capture);
+	}
+}
+
+bool PulseCapture::attachEdgeInterrupt()
+{
+	static constexpr InterruptCallback slotInterrupts[]{
+		slotInterrupt<0>,
+		slotInterrupt<1>,
+		slotInterrupt<2>,
+		slotInterrupt<3>,
+	};
+	static_assert(ARRAY_SIZE(slotInterrupts) == maxCaptures, "Interrupt table doesn't match capture count");
+
+	attachInterrupt(pin, slotInterrupts[slot], CHANGE);
+	return true;
+}
+
+void PulseCapture::detachEdgeInterrupt()
+{
+	detachInterrupt(pin);
+}
@@ -0,0 +1,142 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/SmingHub/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * PulseCapture.h - Timestamp input edges and report pulse widths in task context
+ *
+ ****/
+
+#pragma once
+
+#include <Delegate.h>
+#include <Data/Buffer/SpscRing.h>
+#include <esp_systemapi.h>
+
+/**
+ * @brief Measures the pulses on a digital input
+ *
+ * Each change of input level is timestamped as close to the hardware as possible and queued.
+ * Pulses are then passed to the application callback in batches, in task context,
+ * so decoding doesn't add to interrupt latency and can take as long as it needs.
+ *
+ * A pulse is reported when it ends, i.e. at the following edge.
+ *
+ * Architecture support:
+ *
+ * - Esp8266: GPIO interrupt timestamps edges using the CPU cycle counter
+ * - Esp32: RMT peripheral measures pulses in hardware, 1us resolution
+ * - Rp2040: GPIO interrupt timestamps edges using the 1MHz system timer
+ * - Host: Writing to the pin with digitalWrite() generates edges, for testing
+ *
+ * Up to `maxCaptures` inputs may be captured at once.
+ */
+class PulseCapture
+{
+public:
+	static constexpr unsigned maxCaptures{4};
+	static constexpr size_t bufferSize{128}; ///< Edges queued for processing
+
+	struct Pulse {
+		uint32_t duration; ///< Microseconds
+		uint8_t level;	 ///< Input level during pulse
+	};
+
+	/**
+	 * @brief Callback invoked in task context with captured pulses
+	 * @param pulses Valid only until callback returns
+	 * @param count Number of pulses
+	 */
+	using Callback = Delegate<void(const Pulse* pulses, size_t count)>;
+
+	struct Stats {
+		uint32_t edges;		///< Edges captured
+		uint32_t batches;   ///< Number of times callback was invoked
+		uint32_t overflows; ///< Edges lost because the buffer was full
+	};
+
+	~PulseCapture()
+	{
+		end();
+	}
+
+	/**
+	 * @brief Start capturing
+	 * @param pin Input to monitor
+	 * @param callback Invoked with each batch of pulses
+	 * @retval bool true on success
+	 */
+	bool begin(uint16_t pin, Callback callback);
+
+	/**
+	 * @brief Stop capturing
+	 */
+	void end();
+
+	bool isRunning() const
+	{
+		return slot >= 0;
+	}
+
+	uint16_t getPin() const
+	{
+		return pin;
+	}
+
+	const Stats& getStats() const
+	{
+		return stats;
+	}
+
+	void resetStats()
+	{
+		stats = {};
+	}
+
+private:
+	struct Edge {
+		uint32_t time;
+		uint8_t level; ///< Input level following edge
+	};
+
+	/*
+	 * Architecture-specific implementation, in Arch/{SMING_ARCH}/Core/PulseCapture.cpp.
+	 * hardwareBegin() sets ticksPerUs to suit the timestamps it provides.
+	 */
+	bool hardwareBegin();
+	void hardwareEnd();
+	static void IRAM_ATTR hardwareInterrupt(PulseCapture& capture);
+
+	/*
+	 * For implementations using GPIO interrupts, which call hardwareInterrupt()
+	 */
+	bool attachEdgeInterrupt();
+	void detachEdgeInterrupt();
+	template <unsigned index> static void IRAM_ATTR slotInterrupt();
+
+	/*
+	 * Called by hardware layer for each edge, from interrupt or driver task context.
+	 * There must be only one caller at a time.
+	 */
+	__forceinline void IRAM_ATTR edgeCaptured(uint32_t time, uint8_t level)
+	{
+		if(ring.push(Edge{time, level})) {
+			++stats.edges;
+		} else {
+			++stats.overflows;
+		}
+		ring.notify();
+	}
+
+	static void taskCallback(void* param);
+
+	Callback callback;
+	SpscRing<Edge, bufferSize> ring;
+	Stats stats{};
+	uint32_t lastTime{0};
+	uint32_t ticksPerUs{1};
+	uint16_t pin{0};
+	uint8_t lastLevel{0};
+	int8_t slot{-1};
+};
@@ -106,10 +106,21 @@ private:
 	TickType interval = 0;
 };
 
+#if ENABLE_TIMER_WHEEL
+#include "WheelTimer.h"
+using SimpleTimerApi = WheelTimerApi;
+#else
+/**
+ * @brief Timer API used by `SimpleTimer` and `Timer`
+ * @note Set ENABLE_TIMER_WHEEL=1 to use `WheelTimerApi` instead
+ */
+using SimpleTimerApi = OsTimerApi;
+#endif
+
 /**
  * @brief Basic callback timer
  * @note For delegate callback support and other features see `Timer` class.
  */
-using SimpleTimer = CallbackTimer<OsTimerApi>;
+using SimpleTimer = CallbackTimer<SimpleTimerApi>;
 
 /** @} */
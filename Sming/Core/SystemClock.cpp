@@ -10,10 +10,24 @@
 
 #include "SystemClock.h"
 #include <Platform/RTC.h>
+#include <SimpleTimer.h>
 #include <debug_progmem.h>
+#include <algorithm>
 
 SystemClockClass SystemClock;
 
+namespace
+{
+/*
+ * Small corrections made often keep the clock smooth:
+ * at the maximum slew rate each step is 500us.
+ */
+constexpr uint32_t adjustIntervalMs{1000};
+
+SimpleTimer adjustTimer;
+
+} // namespace
+
 time_t SystemClockClass::now(TimeZone timeType) const
 {
 	uint32_t systemTime = RTC.getRtcSeconds();
@@ -31,13 +45,96 @@ bool SystemClockClass::setTime(time_t time, TimeZone timeType)
 		time -= timeZoneOffsetSecs;
 	}
 
+	pendingAdjustment = 0;
 	timeSet = RTC.setRtcSeconds(time);
+	lastAdjustTime = RTC.getRtcNanoseconds();
+	updateTimer();
 
 	debugf("time updated? %d", timeSet);
 
 	return timeSet;
 }
 
+bool SystemClockClass::adjustTime(int64_t offset, bool slew)
+{
+	if(slew) {
+		pendingAdjustment = offset;
+		updateTimer();
+		return true;
+	}
+
+	pendingAdjustment = 0;
+	updateTimer();
+	auto now = RTC.getRtcNanoseconds();
+	if(offset < 0 && uint64_t(-offset) > now) {
+		return false;
+	}
+	lastAdjustTime = now + offset;
+	timeSet = RTC.setRtcNanoseconds(lastAdjustTime);
+
+	auto absOffset = uint64_t((offset < 0) ? -offset : offset);
+	debug_i("[CLOCK] stepped %c%u.%06u s", (offset < 0) ? '-' : '+', unsigned(absOffset / 1000000000),
+			unsigned(absOffset % 1000000000 / 1000));
+
+	return timeSet;
+}
+
+bool SystemClockClass::setFrequencyCorrection(int32_t ppb)
+{
+	if(abs(ppb) > SYSTEM_CLOCK_MAX_FREQUENCY_PPB) {
+		return false;
+	}
+
+	frequencyCorrection = ppb;
+	updateTimer();
+	return true;
+}
+
+void SystemClockClass::updateTimer()
+{
+	if(pendingAdjustment == 0 && frequencyCorrection == 0) {
+		adjustTimer.stop();
+		return;
+	}
+
+	if(!adjustTimer.isStarted()) {
+		lastAdjustTime = RTC.getRtcNanoseconds();
+		adjustTimer.initializeMs<adjustIntervalMs>(staticAdjust, this).start();
+	}
+}
+
+void SystemClockClass::staticAdjust(void* param)
+{
+	static_cast<SystemClockClass*>(param)->applyAdjustment();
+}
+
+void SystemClockClass::applyAdjustment()
+{
+	auto now = RTC.getRtcNanoseconds();
+	int64_t elapsed = now - lastAdjustTime;
+	if(elapsed <= 0) {
+		return;
+	}
+
+	// Frequency correction is applied continuously
+	int64_t delta = elapsed * frequencyCorrection / 1000000000LL;
+
+	// Slew at no more than the maximum rate, limiting the correction to what remains
+	int64_t maxSlew = elapsed * SYSTEM_CLOCK_MAX_SLEW_PPM / 1000000;
+	int64_t slew = std::max(-maxSlew, std::min(maxSlew, pendingAdjustment));
+	pendingAdjustment -= slew;
+	delta += slew;
+
+	lastAdjustTime = now + delta;
+	if(delta != 0) {
+		RTC.setRtcNanoseconds(lastAdjustTime);
+	}
+
+	if(pendingAdjustment == 0 && frequencyCorrection == 0) {
+		adjustTimer.stop();
+	}
+}
+
 String SystemClockClass::getSystemTimeString(TimeZone timeType) const
 {
 	DateTime dt(now(timeType));
@@ -27,6 +27,18 @@ enum TimeZone {
 };
 /** @} */
 
+/**
+ * @brief Maximum rate at which `SystemClockClass::adjustTime()` slews the clock, in parts per million
+ */
+#ifndef SYSTEM_CLOCK_MAX_SLEW_PPM
+#define SYSTEM_CLOCK_MAX_SLEW_PPM 500
+#endif
+
+/**
+ * @brief Largest frequency correction accepted by `SystemClockClass::setFrequencyCorrection()`, in parts per billion
+ */
+#define SYSTEM_CLOCK_MAX_FREQUENCY_PPB 500000
+
 /** @brief  System clock class
  *  @addtogroup systemclock
  *  @{
@@ -80,6 +92,38 @@ public:
 		return timeZoneOffsetSecs;
 	}
 
+	/** @brief Correct the system clock
+	 *  @param offset Nanoseconds to add to the clock, may be negative
+	 *  @param slew If true, the clock is adjusted gradually so it never jumps or runs backwards,
+	 *  at no more than SYSTEM_CLOCK_MAX_SLEW_PPM. Otherwise, the clock is stepped immediately.
+	 *  @retval bool true on success
+	 *  @note Any outstanding slew is cancelled, so the offset should be the currently measured error.
+	 *  Stepping the clock marks it as set.
+	 */
+	bool adjustTime(int64_t offset, bool slew);
+
+	/** @brief Get the part of the last slewed adjustment which has yet to be applied
+	 *  @retval int64_t Offset in nanoseconds
+	 */
+	int64_t getPendingAdjustment() const
+	{
+		return pendingAdjustment;
+	}
+
+	/** @brief Compensate for the clock running fast or slow
+	 *  @param ppb Rate correction in parts per billion: positive values make the clock run faster
+	 *  @retval bool false if value out of range
+	 */
+	bool setFrequencyCorrection(int32_t ppb);
+
+	/** @brief Get the current frequency correction
+	 *  @retval int32_t Parts per billion
+	 */
+	int32_t getFrequencyCorrection() const
+	{
+		return frequencyCorrection;
+	}
+
 	/** @brief Determine if `setTime()` has been called yet
 	 *  @note Indicates whether time returned can be relied upon
 	 */
@@ -89,7 +133,14 @@ public:
 	}
 
 private:
+	static void staticAdjust(void* param);
+	void applyAdjustment();
+	void updateTimer();
+
+	int64_t pendingAdjustment = 0;
+	uint64_t lastAdjustTime = 0;
 	int timeZoneOffsetSecs = 0;
+	int32_t frequencyCorrection = 0;
 	bool timeSet = false;
 };
 
@@ -12,6 +12,7 @@
 
 #include "Interrupts.h"
 #include "SimpleTimer.h"
+#include <Services/Profiling/Trace.h>
 
 /**
  * @defgroup timer Timer
@@ -26,7 +27,7 @@
 template <class TimerClass> class OsTimer64Api : public CallbackTimerApi<OsTimer64Api<TimerClass>>
 {
 public:
-	using Clock = OsTimerApi::Clock;
+	using Clock = SimpleTimerApi::Clock;
 	using TickType = uint64_t;
 	using TimeType = uint64_t;
 
@@ -113,7 +114,7 @@ protected:
 	void longTick();
 
 private:
-	OsTimerApi osTimer;
+	SimpleTimerApi osTimer;
 	struct {
 		TimerCallback func = nullptr;
 		void* arg = nullptr;
@@ -174,6 +175,7 @@ template <class TimerClass> void OsTimer64Api<TimerClass>::longTick()
 		}
 	}
 
+	TRACE_SCOPE("timer", this);
 	if(callback.func != nullptr) {
 		callback.func(callback.arg);
 	} else if(delegate) {
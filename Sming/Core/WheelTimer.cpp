@@ -0,0 +1,345 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/SmingHub/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * WheelTimer.cpp
+ *
+ * Each level of the wheel has 64 slots. A level 0 slot spans `resolution` clock ticks,
+ * and each slot of the next level spans an entire revolution of the level below.
+ *
+ * A timer is placed in the lowest level able to represent its expiry time. When the
+ * wheel reaches a slot above level 0, its timers are re-distributed ('cascaded') into the
+ * lower levels. Timers in a level 0 slot are expired together.
+ *
+ * Only occupied slots are of interest, so a bitmap is kept for each level.
+ * The next event can then be found without visiting empty slots.
+ *
+ ****/
+
+#include "WheelTimer.h"
+#include <driver/os_timer.h>
+#include <Services/Profiling/Trace.h>
+
+namespace
+{
+constexpr unsigned log2(uint32_t value)
+{
+	return (value <= 1) ? 0 : 1 + log2(value >> 1);
+}
+
+int ctz64(uint64_t value)
+{
+	return __builtin_ctzll(value);
+}
+
+} // namespace
+
+class TimerWheel
+{
+public:
+	using Timer = WheelTimerApi;
+	using Clock = Timer::Clock;
+
+	static constexpr unsigned levelBits{6};
+	static constexpr unsigned slotCount{1U << levelBits};
+	static constexpr unsigned slotMask{slotCount - 1};
+	static constexpr unsigned levelCount{4};
+	static constexpr uint8_t expiringLevel{levelCount}; ///< Marks timer as being in expiry list
+
+	/*
+	 * Resolution is about 100us, but the range of the wheel must remain within
+	 * a signed 32-bit tick count.
+	 */
+	static constexpr unsigned maxResolutionBits{30 - levelBits * levelCount};
+	static constexpr unsigned resolutionBits{log2(Clock::frequency() / 10000) < maxResolutionBits
+												 ? log2(Clock::frequency() / 10000)
+												 : maxResolutionBits};
+	static constexpr uint32_t resolutionMask{(1U << resolutionBits) - 1};
+
+	void insert(Timer& timer);
+	void remove(Timer& timer);
+
+private:
+	static constexpr unsigned getShift(unsigned level)
+	{
+		return resolutionBits + level * levelBits;
+	}
+
+	bool isEmpty() const
+	{
+		for(auto b : bitmap) {
+			if(b != 0) {
+				return false;
+			}
+		}
+		return true;
+	}
+
+	void link(Timer& timer, unsigned level, unsigned slot);
+	bool findNext(unsigned& level, uint32_t& delta) const;
+	void expire(unsigned slot);
+	void cascade(unsigned level, unsigned slot);
+	void schedule();
+	void service();
+
+	static void IRAM_ATTR serviceCallback(void* arg)
+	{
+		static_cast<TimerWheel*>(arg)->service();
+	}
+
+	Timer* slots[levelCount][slotCount]{};
+	uint64_t bitmap[levelCount]{}; ///< Bit set for each occupied slot
+	Timer* expiring{nullptr};	   ///< Timers being expired
+	os_timer_t osTimer{};
+	uint32_t base{0};	 ///< Clock ticks up to which the wheel has been processed
+	uint32_t nextDue{0}; ///< Clock ticks when osTimer is due to fire
+	bool initialised{false};
+	bool scheduled{false};
+	bool servicing{false};
+};
+
+namespace
+{
+TimerWheel timerWheel;
+}
+
+void TimerWheel::link(Timer& timer, unsigned level, unsigned slot)
+{
+	auto& head = slots[level][slot];
+	timer.next = head;
+	if(head != nullptr) {
+		head->pprev = &timer.next;
+	}
+	head = &timer;
+	timer.pprev = &head;
+	timer.level = level;
+	timer.slot = slot;
+	bitmap[level] |= uint64_t(1) << slot;
+}
+
+void TimerWheel::insert(Timer& timer)
+{
+	if(!initialised) {
+		os_timer_setfn(&osTimer, serviceCallback, this);
+		initialised = true;
+	}
+
+	if(isEmpty() && !servicing) {
+		base = Clock::ticks();
+	}
+
+	// Round up so timer never expires early
+	uint32_t key = timer.expire + resolutionMask;
+	if(int(timer.expire - base) <= 0) {
+		key = base;
+	}
+
+	unsigned level = 0;
+	unsigned shift = getShift(0);
+	uint32_t dist;
+	for(;;) {
+		dist = ((key >> shift) - (base >> shift)) & (0xFFFFFFFFU >> shift);
+		if(dist < slotCount) {
+			break;
+		}
+		if(level == levelCount - 1) {
+			// Beyond range: re-evaluated when slot is cascaded
+			dist = slotCount - 1;
+			break;
+		}
+		++level;
+		shift += levelBits;
+	}
+
+	link(timer, level, ((base >> shift) + dist) & slotMask);
+
+	if(servicing) {
+		return;
+	}
+
+	// Re-schedule if this timer is now the earliest
+	uint32_t delta = (dist << shift) - (base & ((1U << shift) - 1));
+	if(int(delta) < 0) {
+		delta = 0;
+	}
+	if(!scheduled || int(base + delta - nextDue) < 0) {
+		schedule();
+	}
+}
+
+void TimerWheel::remove(Timer& timer)
+{
+	*timer.pprev = timer.next;
+	if(timer.next != nullptr) {
+		timer.next->pprev = timer.pprev;
+	}
+	timer.next = nullptr;
+	timer.pprev = nullptr;
+
+	if(timer.level == expiringLevel) {
+		return;
+	}
+
+	if(slots[timer.level][timer.slot] == nullptr) {
+		bitmap[timer.level] &= ~(uint64_t(1) << timer.slot);
+		// Leave osTimer running unless there's nothing left to do
+		if(scheduled && !servicing && isEmpty()) {
+			os_timer_disarm(&osTimer);
+			scheduled = false;
+		}
+	}
+}
+
+/*
+ * Find the next occupied slot, returning its level and the number of ticks from base.
+ * Where events coincide, higher levels are returned first so cascaded timers are
+ * expired along with any already in level 0.
+ */
+bool TimerWheel::findNext(unsigned& level, uint32_t& delta) const
+{
+	bool found{false};
+	for(int lvl = levelCount - 1; lvl >= 0; --lvl) {
+		auto bits = bitmap[lvl];
+		if(bits == 0) {
+			continue;
+		}
+		auto shift = getShift(lvl);
+		unsigned index = (base >> shift) & slotMask;
+		if(index != 0) {
+			bits = (bits >> index) | (bits << (slotCount - index));
+		}
+		if(lvl != 0) {
+			// Current slot has already been cascaded
+			bits &= ~uint64_t(1);
+			if(bits == 0) {
+				continue;
+			}
+		}
+		uint32_t dist = ctz64(bits);
+		int d = (dist << shift) - (base & ((1U << shift) - 1));
+		if(d < 0) {
+			d = 0;
+		}
+		if(!found || uint32_t(d) < delta) {
+			level = lvl;
+			delta = d;
+			found = true;
+		}
+	}
+
+	return found;
+}
+
+void TimerWheel::expire(unsigned slot)
+{
+	auto& head = slots[0][slot];
+	expiring = head;
+	head = nullptr;
+	bitmap[0] &= ~(uint64_t(1) << slot);
+	if(expiring == nullptr) {
+		return;
+	}
+	expiring->pprev = &expiring;
+	for(auto t = expiring; t != nullptr; t = t->next) {
+		t->level = expiringLevel;
+	}
+
+	// Callbacks may arm or disarm any timer, including those remaining in this list
+	while(auto timer = expiring) {
+		remove(*timer);
+		if(timer->period != 0) {
+			timer->expire += timer->period;
+			auto now = Clock::ticks();
+			if(int(timer->expire - now) <= 0) {
+				// Don't try to catch up on missed intervals
+				timer->expire = now + timer->period;
+			}
+			insert(*timer);
+		}
+		if(timer->callback != nullptr) {
+			TRACE_SCOPE("wheel-timer", timer);
+			timer->callback(timer->arg);
+		}
+	}
+}
+
+void TimerWheel::cascade(unsigned level, unsigned slot)
+{
+	auto& head = slots[level][slot];
+	auto timer = head;
+	head = nullptr;
+	bitmap[level] &= ~(uint64_t(1) << slot);
+	while(timer != nullptr) {
+		auto next = timer->next;
+		insert(*timer);
+		timer = next;
+	}
+}
+
+void TimerWheel::schedule()
+{
+	unsigned level;
+	uint32_t delta;
+	if(!findNext(level, delta)) {
+		if(scheduled) {
+			os_timer_disarm(&osTimer);
+			scheduled = false;
+		}
+		return;
+	}
+
+	nextDue = base + delta;
+	int ticks = nextDue - Clock::ticks();
+	os_timer_arm_ticks(&osTimer, (ticks > 0) ? ticks : 1, false);
+	scheduled = true;
+}
+
+void TimerWheel::service()
+{
+	scheduled = false;
+	servicing = true;
+
+	auto now = Clock::ticks();
+	unsigned level;
+	uint32_t delta;
+	while(findNext(level, delta) && delta <= now - base) {
+		base += delta;
+		auto slot = (base >> getShift(level)) & slotMask;
+		if(level == 0) {
+			expire(slot);
+		} else {
+			cascade(level, slot);
+		}
+	}
+	base = now;
+
+	servicing = false;
+	schedule();
+}
+
+WheelTimerApi::TickType WheelTimerApi::ticks() const
+{
+	if(!isArmed()) {
+		return 0;
+	}
+
+	int remain = expire - Clock::ticks();
+	return (remain > 0) ? remain : 0;
+}
+
+void WheelTimerApi::arm(bool repeating)
+{
+	disarm();
+	period = repeating ? interval : 0;
+	expire = Clock::ticks() + interval;
+	timerWheel.insert(*this);
+}
+
+void WheelTimerApi::disarm()
+{
+	if(isArmed()) {
+		timerWheel.remove(*this);
+	}
+}
@@ -0,0 +1,114 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/SmingHub/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * WheelTimer.h - Software timers using a hierarchical timing wheel
+ *
+ ****/
+
+#pragma once
+
+#include "esp_systemapi.h"
+#include "CallbackTimer.h"
+#include <Platform/Clocks.h>
+
+/**
+ * @defgroup wheel_timer WheelTimer
+ * @brief Software timers scheduled using a hierarchical timing wheel
+ * @ingroup timers
+ * @{
+ */
+
+/**
+ * @brief Callback timer API using a hierarchical timing wheel
+ *
+ * The OS timer queue is a sorted linked list, so arming a timer takes time proportional
+ * to the number of timers already armed. Here, all timers share a single OS timer.
+ * Each armed timer is placed into a wheel slot according to its expiry time, so arming
+ * and disarming take constant time regardless of how many timers are in use.
+ *
+ * All timers due in the same slot are processed together from one OS timer callback,
+ * and the OS timer is only armed for the next occupied slot, so there is no periodic
+ * tick when the system is idle.
+ *
+ * Expiry is rounded up to the wheel resolution of approximately 100us.
+ * Callbacks run in the same context as for `OsTimerApi`.
+ *
+ * @note Not for use from interrupt context.
+ */
+class WheelTimerApi : public CallbackTimerApi<WheelTimerApi>
+{
+public:
+	using Clock = OsTimerClock;
+	using TickType = uint32_t;
+	using TimeType = uint32_t;
+
+	static constexpr const char* typeName()
+	{
+		return "WheelTimerApi";
+	}
+
+	static constexpr TickType minTicks()
+	{
+		return 1;
+	}
+
+	static constexpr TickType maxTicks()
+	{
+		return 0x7FFFFFFF;
+	}
+
+	~WheelTimerApi()
+	{
+		disarm();
+	}
+
+	__forceinline bool isArmed() const
+	{
+		return pprev != nullptr;
+	}
+
+	TickType ticks() const;
+
+	__forceinline void IRAM_ATTR setCallback(TimerCallback callback, void* arg)
+	{
+		this->callback = callback;
+		this->arg = arg;
+	}
+
+	__forceinline void IRAM_ATTR setInterval(TickType interval)
+	{
+		this->interval = interval;
+	}
+
+	__forceinline TickType IRAM_ATTR getInterval() const
+	{
+		return interval;
+	}
+
+	void arm(bool repeating);
+
+	void disarm();
+
+private:
+	friend class TimerWheel;
+
+	WheelTimerApi* next{nullptr};
+	WheelTimerApi** pprev{nullptr}; ///< Link which points to this timer, nullptr if not armed
+	TimerCallback callback{nullptr};
+	void* arg{nullptr};
+	TickType interval{0};
+	TickType period{0}; ///< Interval for repeating timers, 0 for one-shot
+	uint32_t expire{0}; ///< Clock ticks at which timer is due
+	uint8_t level{0};
+	uint8_t slot{0};
+};
+
+/**
+ * @brief Basic callback timer using the timing wheel
+ */
+using WheelTimer = CallbackTimer<WheelTimerApi>;
+
+/** @} */
@@ -28,6 +28,8 @@
 #include "Wire.h"
 #include "Digital.h"
 #include <Platform/System.h>
+#include <esp_systemapi.h>
+#include <driver/hw_timer.h>
 
 #ifndef FCPU80
 #define FCPU80 80000000L
@@ -63,11 +65,19 @@ void TwoWire::begin()
 	setClockStretchLimit(230); // default value is 230 uS
 
 	flush();
+
+#if TWI_HARDWARE
+	hardwareBegin();
+#endif
 }
 
 void TwoWire::end()
 {
 	debug_d("[TWI] end(%u, %u)", twi_sda, twi_scl);
+	wait();
+#if TWI_HARDWARE
+	hardwareEnd();
+#endif
 	pinMode(twi_sda, INPUT);
 	pinMode(twi_scl, INPUT);
 }
@@ -105,6 +115,17 @@ TwoWire::Status TwoWire::status()
 
 void TwoWire::setClock(uint32_t freq)
 {
+	frequency = freq;
+	timerInterval = HW_TIMER_BASE_CLK / (2 * freq);
+	if(timerInterval == 0) {
+		timerInterval = 1;
+	}
+#if TWI_HARDWARE
+	if(hardwareBus >= 0) {
+		hardwareBegin();
+	}
+#endif
+
 	auto sys = System.getCpuFrequency();
 	if(sys == eCF_80MHz) {
 		if(freq <= 100000) {
@@ -148,7 +169,12 @@ uint8_t TwoWire::requestFrom(uint8_t address, uint8_t size, bool sendStop)
 		size = BUFFER_LENGTH;
 	}
 
-	auto err = twi_readFrom(address, rxBuffer, size, sendStop);
+	Transaction trans;
+	trans.address = address;
+	trans.rxData = rxBuffer;
+	trans.rxLength = size;
+	trans.sendStop = sendStop;
+	auto err = execute(trans);
 	rxBufferIndex = 0;
 	rxBufferLength = err ? 0 : size;
 	return rxBufferLength;
@@ -164,7 +190,12 @@ void TwoWire::beginTransmission(uint8_t address)
 
 TwoWire::Error TwoWire::endTransmission(bool sendStop)
 {
-	auto err = twi_writeTo(txAddress, txBuffer, txBufferLength, sendStop);
+	Transaction trans;
+	trans.address = txAddress;
+	trans.txData = txBuffer;
+	trans.txLength = txBufferLength;
+	trans.sendStop = sendStop;
+	auto err = execute(trans);
 	txBufferIndex = 0;
 	txBufferLength = 0;
 	transmitting = false;
@@ -290,127 +321,364 @@ bool TwoWire::twi_write_start()
 	return true;
 }
 
-bool TwoWire::twi_write_stop()
+bool TwoWire::twi_read_bit()
 {
 	SCL_LOW();
-	SDA_LOW();
-	twi_delay(twi_dcount);
+	SDA_HIGH();
+	twi_delay(twi_dcount + 2);
 	SCL_HIGH();
 	for(unsigned i = 0; SCL_READ() == 0 && i++ < twi_clockStretchLimit;) {
 		// Clock stretching
 	}
+	bool bit = SDA_READ();
 	twi_delay(twi_dcount);
-	SDA_HIGH();
-	twi_delay(twi_dcount);
-
-	return true;
+	return bit;
 }
 
-bool TwoWire::twi_write_bit(bool bit)
+bool TwoWire::queue(Transaction& transaction)
 {
-	SCL_LOW();
-	if(bit) {
-		SDA_HIGH();
-	} else {
-		SDA_LOW();
+	if((transaction.txLength != 0 && transaction.txData == nullptr) ||
+	   (transaction.rxLength != 0 && transaction.rxData == nullptr)) {
+		return false;
 	}
-	twi_delay(twi_dcount + 1);
-	SCL_HIGH();
-	for(unsigned i = 0; SCL_READ() == 0 && i++ < twi_clockStretchLimit;) {
-		// Clock stretching
+
+	if(enqueue(transaction)) {
+		startTransaction();
 	}
-	twi_delay(twi_dcount);
 	return true;
 }
 
-bool TwoWire::twi_read_bit()
+TwoWire::Error TwoWire::execute(Transaction& transaction)
 {
-	SCL_LOW();
-	SDA_HIGH();
-	twi_delay(twi_dcount + 2);
-	SCL_HIGH();
-	for(unsigned i = 0; SCL_READ() == 0 && i++ < twi_clockStretchLimit;) {
-		// Clock stretching
+	wait();
+
+#if TWI_HARDWARE
+	if(hardwareBus >= 0) {
+		auto callback = transaction.callback;
+		transaction.callback = nullptr;
+		if(queue(transaction)) {
+			wait();
+		} else {
+			transaction.error = I2C_ERR_LINE_BUSY;
+		}
+		transaction.callback = callback;
+		return transaction.error;
 	}
-	bool bit = SDA_READ();
-	twi_delay(twi_dcount);
-	return bit;
+#endif
+
+	setupTransaction(transaction);
+	while(step()) {
+		twi_delay(twi_dcount);
+	}
+	active = nullptr;
+	return transaction.error;
 }
 
-bool TwoWire::twi_write_byte(uint8_t byte)
+/*
+ * Add a transaction to the end of the queue.
+ * Returns true if the queue was empty, so the caller must start it.
+ */
+bool IRAM_ATTR TwoWire::enqueue(Transaction& transaction)
 {
-	for(uint8_t mask = 0x80; mask != 0; mask >>= 1) {
-		twi_write_bit(byte & mask);
+	transaction.next = nullptr;
+	transaction.error = I2C_ERR_SUCCESS;
+
+	auto level = noInterrupts();
+	bool idle = (queueHead == nullptr);
+	if(idle) {
+		queueHead = &transaction;
+	} else {
+		queueTail->next = &transaction;
 	}
-	return !twi_read_bit(); //NACK/ACK
+	queueTail = &transaction;
+	restoreInterrupts(level);
+
+	return idle;
 }
 
-uint8_t TwoWire::twi_read_byte(bool nack)
+/*
+ * Remove the completed transaction at the head of the queue.
+ * Returns the next transaction, if any.
+ */
+TwoWire::Transaction* IRAM_ATTR TwoWire::dequeue()
 {
-	uint8_t res{0};
-	for(uint8_t mask = 0x80; mask != 0; mask >>= 1) {
-		res |= twi_read_bit() ? mask : 0;
+	auto level = noInterrupts();
+	auto next = queueHead->next;
+	queueHead = next;
+	if(next == nullptr) {
+		queueTail = nullptr;
 	}
-	twi_write_bit(nack);
-	return res;
+	restoreInterrupts(level);
+
+	return next;
 }
 
-TwoWire::Error TwoWire::twi_writeTo(uint8_t address, const uint8_t* buf, size_t len, bool sendStop)
+/*
+ * Start the transaction at the head of an idle queue
+ */
+void IRAM_ATTR TwoWire::startTransaction()
 {
-	if(!twi_write_start()) {
-		return I2C_ERR_LINE_BUSY;
+#if TWI_HARDWARE
+	if(hardwareBus >= 0) {
+		hardwareStart();
+		return;
 	}
-	if(!twi_write_byte(((address << 1) | 0) & 0xFF)) {
-		if(sendStop) {
-			twi_write_stop();
-		}
-		return I2C_ERR_ADDR_NACK;
+#endif
+
+#ifdef ARCH_HOST
+	/*
+	 * There are no interrupts so all transactions are run to completion here.
+	 * Any queued by a completion callback are picked up by the loop, rather than by recursion.
+	 */
+	if(active != nullptr) {
+		return;
 	}
-	for(unsigned i = 0; i < len; i++) {
-		if(!twi_write_byte(buf[i])) {
-			if(sendStop) {
-				twi_write_stop();
-			}
-			return I2C_ERR_DATA_NACK;
+	Transaction* trans;
+	while((trans = queueHead) != nullptr) {
+		setupTransaction(*trans);
+		while(step()) {
+		}
+		dequeue();
+		if(trans->callback != nullptr) {
+			trans->callback(*trans);
 		}
 	}
-	if(sendStop) {
-		twi_write_stop();
-	}
-	for(unsigned i = 0; SDA_READ() == 0 && i++ < 10;) {
-		SCL_LOW();
-		twi_delay(twi_dcount);
-		SCL_HIGH();
-		twi_delay(twi_dcount);
-	}
-	return I2C_ERR_SUCCESS;
+	active = nullptr;
+#else
+	setupTransaction(*queueHead);
+	hw_timer1_attach_interrupt(TIMER_FRC1_SOURCE, timerHandler, this);
+	hw_timer1_enable(TIMER_CLKDIV_1, TIMER_EDGE_INT, true);
+	hw_timer1_write(timerInterval);
+#endif
 }
 
-TwoWire::Error TwoWire::twi_readFrom(uint8_t address, uint8_t* buf, size_t len, bool sendStop)
+/*
+ * Each timer tick advances the bus by half a clock cycle
+ */
+void IRAM_ATTR TwoWire::timerHandler(void* param)
 {
-	if(!twi_write_start()) {
-		return I2C_ERR_LINE_BUSY;
+	auto wire = static_cast<TwoWire*>(param);
+	if(wire->step()) {
+		return;
 	}
-	if(!twi_write_byte(((address << 1) | 1) & 0xFF)) {
-		if(sendStop) {
-			twi_write_stop();
-		}
-		return I2C_ERR_ADDR_NACK;
+
+	auto trans = wire->active;
+	auto next = wire->dequeue();
+	if(next == nullptr) {
+		hw_timer1_disable();
+		wire->active = nullptr;
+	} else {
+		wire->setupTransaction(*next);
 	}
-	for(unsigned i = 0; i + 1 < len; i++) {
-		buf[i] = twi_read_byte(false);
+
+	if(trans->callback != nullptr) {
+		trans->callback(*trans);
 	}
-	buf[len - 1] = twi_read_byte(true);
-	if(sendStop) {
-		twi_write_stop();
+}
+
+void IRAM_ATTR TwoWire::setupTransaction(Transaction& transaction)
+{
+	active = &transaction;
+	transaction.error = I2C_ERR_SUCCESS;
+	dataIndex = 0;
+	reading = (transaction.txLength == 0 && transaction.rxLength != 0);
+	recoverStart = false;
+	state = busHeld ? State::restartLow : State::start;
+}
+
+void IRAM_ATTR TwoWire::clockStretch()
+{
+	for(unsigned i = 0; SCL_READ() == 0 && i++ < twi_clockStretchLimit;) {
 	}
-	for(unsigned i = 0; SDA_READ() == 0 && i++ < 10;) {
+}
+
+/*
+ * Record result and release the bus, if required.
+ * The bus is always released after a failed transfer so a misbehaving slave cannot keep it held.
+ */
+void IRAM_ATTR TwoWire::finish(Error error)
+{
+	active->error = error;
+	state = (active->sendStop || error != I2C_ERR_SUCCESS) ? State::stopLow : State::done;
+}
+
+/*
+ * Bus state machine. Each call performs one half of a clock cycle, either with SCL low or high.
+ * Returns false when the transaction is complete.
+ */
+bool IRAM_ATTR TwoWire::step()
+{
+	auto& trans = *active;
+
+	switch(state) {
+	case State::start:
+		SCL_HIGH();
+		SDA_HIGH();
+		if(SDA_READ() == 0) {
+			if(!recoverStart) {
+				// Try clocking the line free once before giving up
+				recoverStart = true;
+				recoverCount = 0;
+				state = State::recoverLow;
+				break;
+			}
+			// Line held by another device
+			trans.error = I2C_ERR_LINE_BUSY;
+			state = State::done;
+			break;
+		}
+		state = State::startLow;
+		break;
+
+	case State::startLow:
+		SDA_LOW();
+		busHeld = true;
+		addressPhase = true;
+		dataByte = (trans.address << 1) | (reading ? 1 : 0);
+		bitMask = 0x80;
+		state = State::txLow;
+		break;
+
+	case State::txLow:
 		SCL_LOW();
-		twi_delay(twi_dcount);
+		if(dataByte & bitMask) {
+			SDA_HIGH();
+		} else {
+			SDA_LOW();
+		}
+		state = State::txHigh;
+		break;
+
+	case State::txHigh:
 		SCL_HIGH();
-		twi_delay(twi_dcount);
+		clockStretch();
+		bitMask >>= 1;
+		state = (bitMask == 0) ? State::ackLow : State::txLow;
+		break;
+
+	case State::ackLow:
+		SCL_LOW();
+		SDA_HIGH();
+		state = State::ackHigh;
+		break;
+
+	case State::ackHigh:
+		SCL_HIGH();
+		clockStretch();
+		if(SDA_READ()) {
+			finish(addressPhase ? I2C_ERR_ADDR_NACK : I2C_ERR_DATA_NACK);
+			break;
+		}
+		addressPhase = false;
+		if(reading) {
+			dataByte = 0;
+			bitMask = 0x80;
+			state = State::rxLow;
+		} else if(dataIndex < trans.txLength) {
+			dataByte = trans.txData[dataIndex++];
+			bitMask = 0x80;
+			state = State::txLow;
+		} else if(trans.rxLength != 0) {
+			reading = true;
+			dataIndex = 0;
+			state = State::restartLow;
+		} else {
+			finish(I2C_ERR_SUCCESS);
+		}
+		break;
+
+	case State::rxLow:
+		SCL_LOW();
+		SDA_HIGH();
+		state = State::rxHigh;
+		break;
+
+	case State::rxHigh:
+		SCL_HIGH();
+		clockStretch();
+		if(SDA_READ()) {
+			dataByte |= bitMask;
+		}
+		bitMask >>= 1;
+		state = (bitMask == 0) ? State::masterAckLow : State::rxLow;
+		break;
+
+	case State::masterAckLow:
+		SCL_LOW();
+		trans.rxData[dataIndex++] = dataByte;
+		// NACK the final byte
+		if(dataIndex < trans.rxLength) {
+			SDA_LOW();
+		} else {
+			SDA_HIGH();
+		}
+		state = State::masterAckHigh;
+		break;
+
+	case State::masterAckHigh:
+		SCL_HIGH();
+		clockStretch();
+		if(dataIndex < trans.rxLength) {
+			dataByte = 0;
+			bitMask = 0x80;
+			state = State::rxLow;
+		} else {
+			finish(I2C_ERR_SUCCESS);
+		}
+		break;
+
+	case State::restartLow:
+		SCL_LOW();
+		SDA_HIGH();
+		state = State::restartHigh;
+		break;
+
+	case State::restartHigh:
+		SCL_HIGH();
+		clockStretch();
+		state = State::start;
+		break;
+
+	case State::stopLow:
+		SCL_LOW();
+		SDA_LOW();
+		state = State::stopHigh;
+		break;
+
+	case State::stopHigh:
+		SCL_HIGH();
+		clockStretch();
+		state = State::stopEnd;
+		break;
+
+	case State::stopEnd:
+		SDA_HIGH();
+		busHeld = false;
+		// A slave still holding SDA low is clocked until it releases the line
+		recoverStart = false;
+		recoverCount = 0;
+		state = (SDA_READ() == 0) ? State::recoverLow : State::done;
+		break;
+
+	case State::recoverLow:
+		SCL_LOW();
+		state = State::recoverHigh;
+		break;
+
+	case State::recoverHigh:
+		SCL_HIGH();
+		if(SDA_READ() == 0 && ++recoverCount < 10) {
+			state = State::recoverLow;
+		} else {
+			state = recoverStart ? State::start : State::done;
+		}
+		break;
+
+	case State::done:
+		break;
 	}
-	return I2C_ERR_SUCCESS;
+
+	return state != State::done;
 }
 
 #if !defined(NO_GLOBAL_INSTANCES) && !defined(NO_GLOBAL_TWOWIRE)
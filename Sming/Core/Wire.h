@@ -26,6 +26,10 @@
 #include <Stream.h>
 #include <twi_arch.h>
 
+#ifndef TWI_HARDWARE
+#define TWI_HARDWARE 0
+#endif
+
 class TwoWire : public Stream
 {
 public:
@@ -49,6 +53,35 @@ public:
 	using UserRequest = void (*)();
 	using UserReceive = void (*)(int len);
 
+	/**
+	 * @brief Describes a bus transaction
+	 *
+	 * Any data is written first, followed by a read using a repeated start condition.
+	 * Either length may be zero. If both are zero then only the address is sent, which can be used to probe for devices.
+	 */
+	struct Transaction {
+		/**
+		 * @brief Invoked on completion
+		 * @note Called in interrupt context, so code must be in IRAM.
+		 * The callback may queue another transaction, or re-queue this one.
+		 */
+		using Callback = void (*)(Transaction& transaction);
+
+		const uint8_t* txData{nullptr};
+		uint8_t* rxData{nullptr};
+		uint16_t txLength{0};
+		uint16_t rxLength{0};
+		Callback callback{nullptr};
+		void* param{nullptr}; ///< For use by callback
+		uint8_t address{0};
+		bool sendStop{true};		  ///< Set to false to hold the bus for a following transaction
+		Error error{I2C_ERR_SUCCESS}; ///< Result, valid on completion
+
+	private:
+		friend class TwoWire;
+		Transaction* next{nullptr};
+	};
+
 	TwoWire() : Stream()
 	{
 	}
@@ -114,6 +147,54 @@ public:
 	 */
 	Status status();
 
+	/**
+	 * @name Asynchronous transactions
+	 *
+	 * Transactions are queued and run in the background, so the application can do other work whilst
+	 * the bus is active. On completion of each transaction the next is started from the interrupt handler.
+	 *
+	 * Rp2040 uses the I2C controller when the selected pins support it, otherwise the bus is driven by
+	 * a state machine running from the hardware timer. This takes one interrupt per half clock cycle,
+	 * so keep the clock at or below 100 kHz and do not use `HardwareTimer` at the same time.
+	 * Host completes transactions immediately.
+	 *
+	 * The blocking methods wait for any queued transactions to complete before starting.
+	 * @{
+	 */
+
+	/**
+	 * @brief Queue a transaction
+	 * @param transaction Must remain valid, with its buffers, until the callback has been invoked
+	 * @retval bool false if transaction is invalid
+	 */
+	bool queue(Transaction& transaction);
+
+	/**
+	 * @brief Determine if any transactions are pending
+	 */
+	bool isBusy() const
+	{
+		return queueHead != nullptr;
+	}
+
+	/**
+	 * @brief Wait for all queued transactions to complete
+	 */
+	void wait()
+	{
+		while(isBusy()) {
+		}
+	}
+
+	/** @} */
+
+	/**
+	 * @brief Perform a transaction, waiting for it to complete
+	 * @param transaction The callback, if any, is not invoked
+	 * @retval Error
+	 */
+	Error execute(Transaction& transaction);
+
 	/* Stream methods */
 
 	size_t write(uint8_t) override;
@@ -138,6 +219,60 @@ public:
 	}
 
 private:
+	enum class State : uint8_t {
+		start,
+		startLow,
+		txLow,
+		txHigh,
+		ackLow,
+		ackHigh,
+		rxLow,
+		rxHigh,
+		masterAckLow,
+		masterAckHigh,
+		restartLow,
+		restartHigh,
+		stopLow,
+		stopHigh,
+		stopEnd,
+		recoverLow,
+		recoverHigh,
+		done,
+	};
+
+	bool enqueue(Transaction& transaction);
+	Transaction* dequeue();
+	void startTransaction();
+	void setupTransaction(Transaction& transaction);
+	bool step();
+	void clockStretch();
+	void finish(Error error);
+	static void timerHandler(void* param);
+#if TWI_HARDWARE
+	bool hardwareBegin();
+	void hardwareEnd();
+	void hardwareStart();
+	void hardwareService();
+	static void hardwareInterruptHandler();
+	int8_t hardwareBus{-1};
+	uint16_t cmdIndex{0};
+#endif
+
+	Transaction* volatile queueHead{nullptr};
+	Transaction* queueTail{nullptr};
+	Transaction* active{nullptr};
+	uint32_t frequency{100000};
+	uint32_t timerInterval{0};
+	uint16_t dataIndex{0};
+	uint8_t dataByte{0};
+	uint8_t bitMask{0};
+	uint8_t recoverCount{0};
+	State state{State::done};
+	bool reading{false};
+	bool addressPhase{false};
+	bool busHeld{false};
+	bool recoverStart{false};
+
 	uint8_t twi_sda{DEFAULT_SDA_PIN};
 	uint8_t twi_scl{DEFAULT_SCL_PIN};
 	uint8_t twi_dcount{18};
@@ -160,13 +295,7 @@ private:
 
 	void twi_delay(uint8_t v);
 	bool twi_write_start();
-	bool twi_write_stop();
-	bool twi_write_bit(bool bit);
 	bool twi_read_bit();
-	bool twi_write_byte(uint8_t byte);
-	uint8_t twi_read_byte(bool nack);
-	Error twi_writeTo(uint8_t address, const uint8_t* buf, size_t len, bool sendStop);
-	Error twi_readFrom(uint8_t address, uint8_t* buf, size_t len, bool sendStop);
 };
 
 #if !defined(NO_GLOBAL_INSTANCES) && !defined(NO_GLOBAL_TWOWIRE)
@@ -0,0 +1,95 @@
+/****
+ * AnimatedGifPlayer.cpp
+ *
+ * This library is free software: you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation, version 3 or later.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this library.
+ * If not, see <https://www.gnu.org/licenses/>.
+ *
+ ****/
+
+#include "AnimatedGifPlayer.h"
+#include "GifDraw.h"
+#include <Clock.h>
+#include <debug_progmem.h>
+#include <algorithm>
+
+bool AnimatedGifPlayer::play(GifStream* source)
+{
+	stop();
+
+	this->source.reset(source);
+	if(!source->open(gif, drawCallback)) {
+		debug_e("[GIF] Open failed, error %d", gif.getLastError());
+		this->source.reset();
+		return false;
+	}
+
+	stats = {};
+	dropping = false;
+	frameDue = millis();
+	timer.setCallback([](void* param) { static_cast<AnimatedGifPlayer*>(param)->playFrame(); }, this);
+	playFrame();
+	return true;
+}
+
+void AnimatedGifPlayer::stop()
+{
+	if(!source) {
+		return;
+	}
+
+	timer.stop();
+	gif.close();
+	source.reset();
+}
+
+void AnimatedGifPlayer::drawCallback(GIFDRAW* pDraw)
+{
+	auto player = static_cast<AnimatedGifPlayer*>(pDraw->pUser);
+
+	if(player->dropping && !pDraw->ucHasTransparency && pDraw->iX == 0 && pDraw->iY == 0 &&
+	   pDraw->iWidth == player->gif.getCanvasWidth() && pDraw->iHeight == player->gif.getCanvasHeight()) {
+		player->frameDropped = true;
+		return;
+	}
+
+	drawGifLine(player->surface, pDraw);
+}
+
+void AnimatedGifPlayer::playFrame()
+{
+	dropping = int32_t(millis() - frameDue) > int32_t(maxLag);
+	frameDropped = false;
+
+	int delayMs{0};
+	int res = gif.playFrame(false, &delayMs, this);
+	if(res < 0) {
+		debug_e("[GIF] Decode failed, error %d", gif.getLastError());
+		stop();
+		return;
+	}
+
+	if(frameDropped) {
+		++stats.framesDropped;
+	} else {
+		++stats.framesShown;
+		if(dropping) {
+			// Couldn't drop this frame so we're still behind: restart timeline rather than trying to catch up
+			frameDue = millis();
+		}
+	}
+	if(res == 0) {
+		++stats.loops;
+	}
+
+	frameDue += std::max(delayMs, 1);
+	int32_t wait = frameDue - millis();
+	timer.setIntervalMs(std::max(wait, int32_t(1)));
+	timer.startOnce();
+}
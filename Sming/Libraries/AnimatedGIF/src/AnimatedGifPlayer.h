@@ -0,0 +1,95 @@
+/****
+ * AnimatedGifPlayer.h
+ *
+ * This library is free software: you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation, version 3 or later.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this library.
+ * If not, see <https://www.gnu.org/licenses/>.
+ *
+ ****/
+
+#pragma once
+
+#include <SimpleTimer.h>
+#include <Graphics/Surface.h>
+#include "GifStream.h"
+
+/**
+ * @brief Plays an animated GIF at the rate given by its frame delays
+ *
+ * Each frame is decoded from a timer callback, with lines passed straight to the display surface.
+ * Frames are scheduled against a fixed timeline so that decoding time does not accumulate as drift.
+ *
+ * If playback falls more than `maxLag` milliseconds behind, frames are dropped until it catches up.
+ * Only frames which replace the entire image can be dropped, as other frames depend on what is already
+ * displayed. Where those fall behind the timeline is restarted from the current time instead.
+ */
+class AnimatedGifPlayer
+{
+public:
+	struct Stats {
+		uint32_t framesShown;
+		uint32_t framesDropped;
+		uint32_t loops; ///< Number of times the animation has completed
+	};
+
+	static constexpr uint16_t defaultMaxLag{100};
+
+	AnimatedGifPlayer(Graphics::Surface& surface) : surface(surface)
+	{
+	}
+
+	~AnimatedGifPlayer()
+	{
+		stop();
+	}
+
+	/**
+	 * @brief Start playback
+	 * @param source Ownership is transferred
+	 * @retval bool false if GIF could not be opened
+	 */
+	bool play(GifStream* source);
+
+	/**
+	 * @brief Stop playback and release source
+	 */
+	void stop();
+
+	bool isPlaying() const
+	{
+		return bool(source);
+	}
+
+	/**
+	 * @brief Set how late a frame may be before frames are dropped
+	 */
+	void setMaxLag(uint16_t milliseconds)
+	{
+		maxLag = milliseconds;
+	}
+
+	const Stats& getStats() const
+	{
+		return stats;
+	}
+
+private:
+	static void drawCallback(GIFDRAW* pDraw);
+	void playFrame();
+
+	Graphics::Surface& surface;
+	AnimatedGIF gif;
+	std::unique_ptr<GifStream> source;
+	SimpleTimer timer;
+	Stats stats{};
+	uint32_t frameDue{0}; ///< Time at which current frame should be shown
+	uint16_t maxLag{defaultMaxLag};
+	bool dropping{false};	  ///< Skip output for frames which can be dropped
+	bool frameDropped{false}; ///< Current frame has been dropped
+};
@@ -16,7 +16,10 @@
  ****/
 
 #include "AnimatedGifTask.h"
+#include "GifDraw.h"
 
+namespace
+{
 void draw(GIFDRAW* pDraw)
 {
 	auto surface = static_cast<Graphics::Surface*>(pDraw->pUser);
@@ -24,11 +27,18 @@ void draw(GIFDRAW* pDraw)
 		return;
 	}
 
-	const auto& tftSize = surface->getSize();
+	drawGifLine(*surface, pDraw);
+}
+
+} // namespace
+
+void drawGifLine(Graphics::Surface& surface, GIFDRAW* pDraw)
+{
+	const auto& tftSize = surface.getSize();
 	const int DISPLAY_WIDTH = tftSize.w;
 	const int DISPLAY_HEIGHT = tftSize.h;
 
-	auto pixelFormat = surface->getPixelFormat();
+	auto pixelFormat = surface.getPixelFormat();
 	auto bytesPerPixel = Graphics::getBytesPerPixel(pixelFormat);
 
 	uint16_t usTemp[DISPLAY_WIDTH];
@@ -80,10 +90,10 @@ void draw(GIFDRAW* pDraw)
 			{
 				Graphics::convert(usTemp, Graphics::PixelFormat::RGB565, buffer.get(), pixelFormat, iCount);
 				Graphics::Rect r(pDraw->iX + x, y, iCount, 1);
-				surface->reset();
-				surface->setAddrWindow(r);
-				surface->writeDataBuffer(buffer, 0, iCount * bytesPerPixel);
-				surface->present();
+				surface.reset();
+				surface.setAddrWindow(r);
+				surface.writeDataBuffer(buffer, 0, iCount * bytesPerPixel);
+				surface.present();
 				x += iCount;
 				iCount = 0;
 			}
@@ -110,12 +120,12 @@ void draw(GIFDRAW* pDraw)
 		for(int x = 0; x < iWidth; x++) {
 			usTemp[x] = __builtin_bswap16(usPalette[*s++]);
 		}
-		Graphics::convert(usTemp, Graphics::PixelFormat::RGB565, buffer.get(), surface->getPixelFormat(), iWidth);
+		Graphics::convert(usTemp, Graphics::PixelFormat::RGB565, buffer.get(), surface.getPixelFormat(), iWidth);
 		Graphics::Rect r(pDraw->iX, y, iWidth, 1);
-		surface->reset();
-		surface->setAddrWindow(r);
-		surface->writeDataBuffer(buffer, 0, iWidth * bytesPerPixel);
-		surface->present();
+		surface.reset();
+		surface.setAddrWindow(r);
+		surface.writeDataBuffer(buffer, 0, iWidth * bytesPerPixel);
+		surface.present();
 	}
 }
 
@@ -130,6 +140,11 @@ AnimatedGifTask::AnimatedGifTask(Graphics::Surface& surface, const void* data, s
 	}
 }
 
+AnimatedGifTask::AnimatedGifTask(Graphics::Surface& surface, GifStream* source) : surface(surface), source(source)
+{
+	this->source->open(gif, draw);
+}
+
 void AnimatedGifTask::loop()
 {
 	gif.playFrame(true, nullptr, &surface);
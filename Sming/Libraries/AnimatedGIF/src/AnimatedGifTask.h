@@ -20,6 +20,7 @@
 #include <Task.h>
 #include <AnimatedGIF.h>
 #include <Graphics/Surface.h>
+#include "GifStream.h"
 
 class AnimatedGifTask : public Task
 {
@@ -31,6 +32,13 @@ public:
 	{
 	}
 
+	/**
+	 * @brief Play from a stream, such as a file, without loading it into RAM
+	 * @param surface
+	 * @param source Ownership is transferred
+	 */
+	AnimatedGifTask(Graphics::Surface& surface, GifStream* source);
+
 	~AnimatedGifTask()
 	{
 		gif.close();
@@ -42,4 +50,5 @@ protected:
 private:
 	AnimatedGIF gif;
 	Graphics::Surface& surface;
+	std::unique_ptr<GifStream> source;
 };
@@ -0,0 +1,26 @@
+/****
+ * GifDraw.h
+ *
+ * This library is free software: you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation, version 3 or later.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this library.
+ * If not, see <https://www.gnu.org/licenses/>.
+ *
+ ****/
+
+#pragma once
+
+#include <AnimatedGIF.h>
+#include <Graphics/Surface.h>
+
+/**
+ * @brief Write one decoded line to a display surface, handling transparency and disposal
+ * @param surface Each run of opaque pixels is submitted to the display as a separate request
+ * @param pDraw Line information from decoder
+ */
+void drawGifLine(Graphics::Surface& surface, GIFDRAW* pDraw);
@@ -0,0 +1,139 @@
+/****
+ * GifStream.cpp
+ *
+ * This library is free software: you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation, version 3 or later.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this library.
+ * If not, see <https://www.gnu.org/licenses/>.
+ *
+ ****/
+
+#include "GifStream.h"
+#include <Storage/PartitionStream.h>
+#include <debug_progmem.h>
+#include <algorithm>
+#include <cstring>
+
+GifStream::GifStream(Storage::Partition partition, uint32_t offset, size_t size, size_t bufferSize)
+	: GifStream(new Storage::PartitionStream(partition, offset, size), bufferSize)
+{
+}
+
+bool GifStream::open(AnimatedGIF& gif, GIF_DRAW_CALLBACK* draw)
+{
+	if(!stream) {
+		return false;
+	}
+
+	if(!buffer) {
+		buffer.reset(new uint8_t[bufferSize]);
+		if(!buffer) {
+			return false;
+		}
+	}
+	bufferLength = 0;
+
+	// The decoder passes the 'filename' to openCallback(), which is how it gets to us
+	return gif.open(reinterpret_cast<const char*>(this), openCallback, closeCallback, readCallback, seekCallback,
+					draw) != 0;
+}
+
+void* GifStream::openCallback(const char* name, int32_t* size)
+{
+	auto self = reinterpret_cast<GifStream*>(const_cast<char*>(name));
+	if(self->stream->seekFrom(0, SeekOrigin::Start) != 0) {
+		debug_e("[GIF] Stream not seekable");
+		return nullptr;
+	}
+	self->streamPos = 0;
+
+	int available = self->stream->available();
+	if(available <= 0) {
+		return nullptr;
+	}
+	*size = available;
+	return self;
+}
+
+void GifStream::closeCallback(void*)
+{
+	// Stream remains open so playback may be restarted
+}
+
+int32_t GifStream::readCallback(GIFFILE* file, uint8_t* buf, int32_t len)
+{
+	auto self = static_cast<GifStream*>(file->fHandle);
+	len = std::min(len, file->iSize - file->iPos);
+	if(len <= 0) {
+		return 0;
+	}
+	auto count = self->read(file->iPos, buf, len);
+	file->iPos += count;
+	return count;
+}
+
+int32_t GifStream::seekCallback(GIFFILE* file, int32_t position)
+{
+	// Same behaviour as decoder's own memory-based seek
+	file->iPos = std::max(std::min(position, file->iSize - 1), 0);
+	return file->iPos;
+}
+
+size_t GifStream::read(uint32_t pos, uint8_t* buf, size_t len)
+{
+	size_t done{0};
+	while(done < len) {
+		if(pos >= bufferStart && pos < bufferStart + bufferLength) {
+			auto offset = pos - bufferStart;
+			auto n = std::min(len - done, bufferLength - offset);
+			memcpy(&buf[done], &buffer[offset], n);
+			done += n;
+			pos += n;
+			continue;
+		}
+
+		if(len - done >= bufferSize) {
+			// Don't bother buffering large reads
+			done += readDirect(pos, &buf[done], len - done);
+			break;
+		}
+
+		bufferStart = pos;
+		bufferLength = readDirect(pos, buffer.get(), bufferSize);
+		if(bufferLength == 0) {
+			break;
+		}
+	}
+
+	return done;
+}
+
+size_t GifStream::readDirect(uint32_t pos, uint8_t* buf, size_t len)
+{
+	if(pos != streamPos) {
+		if(stream->seekFrom(pos, SeekOrigin::Start) != int(pos)) {
+			return 0;
+		}
+		streamPos = pos;
+	}
+
+	size_t done{0};
+	while(done < len) {
+		// readMemoryBlock() returns uint16_t, so limit request size
+		auto n = stream->readMemoryBlock(reinterpret_cast<char*>(&buf[done]), std::min(len - done, size_t(0x8000)));
+		if(n == 0) {
+			break;
+		}
+		stream->seek(n);
+		done += n;
+	}
+	streamPos += done;
+	++readCount;
+
+	return done;
+}
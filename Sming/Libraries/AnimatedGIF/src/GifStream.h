@@ -0,0 +1,89 @@
+/****
+ * GifStream.h
+ *
+ * This library is free software: you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation, version 3 or later.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this library.
+ * If not, see <https://www.gnu.org/licenses/>.
+ *
+ ****/
+
+#pragma once
+
+#include <AnimatedGIF.h>
+#include <Data/Stream/DataSourceStream.h>
+#include <Storage/Partition.h>
+#include <memory>
+
+/**
+ * @brief Feeds GIF data to the decoder from any seekable stream, with read-ahead buffering
+ *
+ * Suitable sources include `IFS::FileStream`, `FlashMemoryStream` and `Storage::PartitionStream`.
+ * Only `bufferSize` bytes of RAM are required, however large the file.
+ *
+ * The decoder makes many small reads, mostly sequential, so these are served from the buffer.
+ * Reads larger than the buffer go directly to the stream.
+ */
+class GifStream
+{
+public:
+	static constexpr size_t defaultBufferSize{1024};
+
+	/**
+	 * @brief Construct from a stream
+	 * @param stream Must support seeking from start. Ownership is transferred.
+	 * @param bufferSize Size of read-ahead buffer
+	 */
+	GifStream(IDataSourceStream* stream, size_t bufferSize = defaultBufferSize)
+		: stream(stream), bufferSize(bufferSize)
+	{
+	}
+
+	/**
+	 * @brief Construct to read from a partition
+	 * @param partition
+	 * @param offset Location of GIF data in partition
+	 * @param size Size of GIF data
+	 * @param bufferSize Size of read-ahead buffer
+	 */
+	GifStream(Storage::Partition partition, uint32_t offset, size_t size, size_t bufferSize = defaultBufferSize);
+
+	/**
+	 * @brief Open GIF decoder using this stream
+	 * @param gif Decoder instance
+	 * @param draw Callback to receive decoded lines
+	 * @retval bool true on success
+	 * @note This object must remain valid until the decoder is closed
+	 */
+	bool open(AnimatedGIF& gif, GIF_DRAW_CALLBACK* draw);
+
+	/**
+	 * @brief Get number of times the underlying stream has been read
+	 */
+	unsigned getReadCount() const
+	{
+		return readCount;
+	}
+
+private:
+	static void* openCallback(const char* name, int32_t* size);
+	static void closeCallback(void* handle);
+	static int32_t readCallback(GIFFILE* file, uint8_t* buf, int32_t len);
+	static int32_t seekCallback(GIFFILE* file, int32_t position);
+
+	size_t read(uint32_t pos, uint8_t* buf, size_t len);
+	size_t readDirect(uint32_t pos, uint8_t* buf, size_t len);
+
+	std::unique_ptr<IDataSourceStream> stream;
+	std::unique_ptr<uint8_t[]> buffer;
+	size_t bufferSize;
+	uint32_t bufferStart{0};  ///< Stream position of first byte in buffer
+	size_t bufferLength{0};	  ///< Number of valid bytes in buffer
+	uint32_t streamPos{0};	  ///< Current stream position
+	unsigned readCount{0};
+};
@@ -0,0 +1,207 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/SmingHub/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * ArduCAMCapture.cpp
+ *
+ ****/
+
+#include "ArduCAMCapture.h"
+#include <Platform/Timers.h>
+#include <Clock.h>
+#include <debug_progmem.h>
+#include <algorithm>
+#include <cstring>
+
+namespace
+{
+// FIFO length register is 19 bits wide: full-scale value indicates overflow
+constexpr size_t fifoLengthMask{0x07ffff};
+
+} // namespace
+
+/* ArduCAMCapture */
+
+ArduCAMFrameStream* ArduCAMCapture::capture()
+{
+	auto stream = new ArduCAMFrameStream(*this);
+	if(!stream->start()) {
+		delete stream;
+		return nullptr;
+	}
+	return stream;
+}
+
+ArduCAMFrameStream* ArduCAMCapture::createStream()
+{
+	auto stream = new ArduCAMFrameStream(*this);
+	stream->start();
+	return stream;
+}
+
+int ArduCAMCapture::acquire(ArduCAMFrameStream* stream)
+{
+	if(owner != nullptr) {
+		++stats.framesDropped;
+		return 0;
+	}
+
+	cam.clear_fifo_flag();
+	cam.write_reg(ARDUCHIP_FRAMES, 0x00);
+	cam.start_capture();
+
+	OneShotFastMs timer(timeout);
+	while(!cam.get_bit(ARDUCHIP_TRIG, CAP_DONE_MASK)) {
+		if(timer.expired()) {
+			debug_w("[CAM] Capture timeout");
+			++stats.timeouts;
+			return -1;
+		}
+		delay(1);
+	}
+
+	size_t length = cam.read_fifo_length();
+	if(length == 0 || length >= fifoLengthMask) {
+		debug_w("[CAM] Bad FIFO length %u", length);
+		cam.clear_fifo_flag();
+		return -1;
+	}
+
+	owner = stream;
+	++stats.framesCaptured;
+	return length;
+}
+
+void ArduCAMCapture::release(ArduCAMFrameStream* stream)
+{
+	if(owner == stream) {
+		cam.clear_fifo_flag();
+		owner = nullptr;
+	}
+}
+
+void ArduCAMCapture::readFifo(uint8_t* buffer, size_t length, bool first)
+{
+	/*
+	 * The FIFO read pointer is retained between bursts so CS may be released after each chunk,
+	 * leaving the bus free for other devices while the network catches up.
+	 */
+	cam.CS_LOW();
+	cam.set_fifo_burst();
+	if(first) {
+		// Discard dummy byte
+		SPI.transfer(0x00);
+	}
+	SPI.transfer(buffer, length);
+	cam.CS_HIGH();
+}
+
+/* ArduCAMFrameStream */
+
+ArduCAMFrameStream::~ArduCAMFrameStream()
+{
+	capture.release(this);
+}
+
+bool ArduCAMFrameStream::start()
+{
+	int length = capture.acquire(this);
+	if(length == 0) {
+		return false;
+	}
+	if(length < 0) {
+		state = State::done;
+		return false;
+	}
+
+	chunk.reset(new uint8_t[capture.chunkSize]);
+	if(!chunk) {
+		capture.release(this);
+		state = State::done;
+		return false;
+	}
+
+	frameSize = fifoRemaining = length;
+	state = State::reading;
+	return true;
+}
+
+size_t ArduCAMFrameStream::fillChunk()
+{
+	if(chunkPos < chunkLength) {
+		return chunkLength - chunkPos;
+	}
+
+	if(state == State::pending && !start()) {
+		return 0;
+	}
+	if(state != State::reading) {
+		if(state == State::buffering) {
+			state = State::done;
+		}
+		return 0;
+	}
+
+	chunkLength = std::min(fifoRemaining, capture.chunkSize);
+	chunkPos = 0;
+	capture.readFifo(chunk.get(), chunkLength, fifoRemaining == frameSize);
+	fifoRemaining -= chunkLength;
+	if(fifoRemaining == 0) {
+		// Frame is entirely off the camera so a new capture may begin
+		capture.release(this);
+		state = State::buffering;
+	}
+
+	return chunkLength;
+}
+
+int ArduCAMFrameStream::available()
+{
+	if(state == State::pending) {
+		return -1;
+	}
+	return fifoRemaining + chunkLength - chunkPos;
+}
+
+const char* ArduCAMFrameStream::peekBlock(size_t& length)
+{
+	length = fillChunk();
+	return length ? reinterpret_cast<const char*>(&chunk[chunkPos]) : nullptr;
+}
+
+uint16_t ArduCAMFrameStream::readMemoryBlock(char* data, int bufSize)
+{
+	if(bufSize <= 0) {
+		return 0;
+	}
+	size_t count = std::min(fillChunk(), size_t(bufSize));
+	if(count == 0) {
+		return 0;
+	}
+	memcpy(data, &chunk[chunkPos], count);
+	return count;
+}
+
+bool ArduCAMFrameStream::seek(int len)
+{
+	if(len < 0) {
+		return false;
+	}
+
+	while(len > 0) {
+		auto n = std::min(fillChunk(), size_t(len));
+		if(n == 0) {
+			return false;
+		}
+		chunkPos += n;
+		len -= n;
+	}
+
+	if(state == State::buffering && chunkPos == chunkLength) {
+		state = State::done;
+	}
+
+	return true;
+}
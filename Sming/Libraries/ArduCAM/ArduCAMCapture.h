@@ -0,0 +1,185 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/SmingHub/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * ArduCAMCapture.h - Stream JPEG frames directly from the ArduCAM FIFO
+ *
+ ****/
+
+#pragma once
+
+#include "ArduCAM.h"
+#include <Data/Stream/DataSourceStream.h>
+#include <memory>
+
+class ArduCAMFrameStream;
+
+/**
+ * @brief Arbitrates access to the camera FIFO
+ *
+ * The FIFO holds a single frame, so only one stream may be reading it at a time.
+ * Each stream triggers a fresh capture, so clients always get the latest frame.
+ * Where the FIFO is busy the request is dropped rather than queued.
+ */
+class ArduCAMCapture
+{
+public:
+	struct Stats {
+		uint32_t framesCaptured;
+		uint32_t framesDropped; ///< Attempts made whilst FIFO busy
+		uint32_t timeouts;		///< Capture did not complete in time
+	};
+
+	static constexpr size_t defaultChunkSize{1024};
+	static constexpr unsigned defaultTimeout{1000};
+
+	/**
+	 * @brief Constructor
+	 * @param cam Camera to capture from, already initialised and configured for JPEG output
+	 * @param chunkSize Size of RAM buffer used by each stream
+	 */
+	ArduCAMCapture(ArduCAM& cam, size_t chunkSize = defaultChunkSize) : cam(cam), chunkSize(chunkSize)
+	{
+	}
+
+	/**
+	 * @brief Capture a frame now
+	 * @retval ArduCAMFrameStream* nullptr if FIFO is busy or the capture failed
+	 * @note Use this where the frame size must be known in advance, such as for websocket frames.
+	 * The FIFO is released as soon as the last chunk has been read.
+	 */
+	ArduCAMFrameStream* capture();
+
+	/**
+	 * @brief Create a stream which captures a frame when first read
+	 * @retval ArduCAMFrameStream*
+	 * @note If the FIFO is busy the stream reports no data until it becomes free.
+	 * Use this for HTTP responses and MJPEG parts where frame size need not be known up front.
+	 */
+	ArduCAMFrameStream* createStream();
+
+	/**
+	 * @brief Determine if a stream is currently reading from the FIFO
+	 */
+	bool isBusy() const
+	{
+		return owner != nullptr;
+	}
+
+	/**
+	 * @brief Set time allowed for capture to complete
+	 */
+	void setTimeout(unsigned milliseconds)
+	{
+		timeout = milliseconds;
+	}
+
+	const Stats& getStats() const
+	{
+		return stats;
+	}
+
+private:
+	friend class ArduCAMFrameStream;
+
+	/**
+	 * @brief Capture a frame on behalf of a stream
+	 * @retval int Size of frame, 0 if FIFO busy, -1 on failure
+	 */
+	int acquire(ArduCAMFrameStream* stream);
+	void release(ArduCAMFrameStream* stream);
+
+	/**
+	 * @brief Burst-read the next block of data from the FIFO
+	 */
+	void readFifo(uint8_t* buffer, size_t length, bool first);
+
+	ArduCAM& cam;
+	ArduCAMFrameStream* owner{nullptr};
+	size_t chunkSize;
+	unsigned timeout{defaultTimeout};
+	Stats stats{};
+};
+
+/**
+ * @brief Reads a captured JPEG frame in chunks
+ *
+ * Only one chunk is held in RAM at any time. Data is burst-read from the FIFO as the consumer
+ * asks for it, so a TCP connection pulls no more than it can currently send.
+ * The chunk is exposed via `peekBlock()` so it is passed to the network stack without further copying.
+ */
+class ArduCAMFrameStream : public IDataSourceStream
+{
+public:
+	~ArduCAMFrameStream();
+
+	StreamType getStreamType() const override
+	{
+		return eSST_User;
+	}
+
+	MimeType getMimeType() const override
+	{
+		return MIME_JPEG;
+	}
+
+	uint16_t readMemoryBlock(char* data, int bufSize) override;
+	const char* peekBlock(size_t& length) override;
+	bool seek(int len) override;
+
+	/**
+	 * @brief Number of bytes remaining in frame
+	 * @retval int -1 if capture has not yet taken place
+	 */
+	int available() override;
+
+	bool isFinished() override
+	{
+		return state == State::done;
+	}
+
+	/**
+	 * @brief Get total size of frame
+	 * @retval size_t 0 if capture has not yet taken place
+	 */
+	size_t getFrameSize() const
+	{
+		return frameSize;
+	}
+
+private:
+	friend class ArduCAMCapture;
+
+	enum class State {
+		pending,   ///< Waiting for FIFO
+		reading,   ///< FIFO contains unread data
+		buffering, ///< Final chunk is buffered, FIFO released
+		done,
+	};
+
+	ArduCAMFrameStream(ArduCAMCapture& capture) : capture(capture)
+	{
+	}
+
+	/**
+	 * @brief Obtain frame from camera if not already done
+	 * @retval bool true if frame data is available
+	 */
+	bool start();
+
+	/**
+	 * @brief Ensure chunk contains unread data
+	 * @retval size_t Number of unread bytes in chunk
+	 */
+	size_t fillChunk();
+
+	ArduCAMCapture& capture;
+	std::unique_ptr<uint8_t[]> chunk;
+	size_t frameSize{0};
+	size_t fifoRemaining{0}; ///< Bytes still to be read from FIFO
+	size_t chunkLength{0};
+	size_t chunkPos{0};
+	State state{State::pending};
+};
@@ -10,7 +10,7 @@
 
 #pragma once
 
-#include <Data/Stream/MemoryDataStream.h>
+#include <Data/Stream/DataSourceStream.h>
 #include "ArduinoJson.h"
 
 /** @brief JsonObject stream class
@@ -19,7 +19,19 @@
  *
  */
 
-class JsonObjectStream : public MemoryDataStream
+/**
+ * @brief Stream which serialises a JSON document on demand
+ *
+ * The serialised document is never stored. Instead, each call to `readMemoryBlock()` runs the
+ * serialiser over the document and captures only the bytes at the current stream position,
+ * writing them directly into the caller's buffer. Peak memory usage is therefore the document itself
+ * plus the caller's buffer, regardless of how large the serialised output is.
+ *
+ * Reading does not advance the stream, so a connection may re-read data it could not send.
+ *
+ * @note The document must not be modified once reading has started.
+ */
+class JsonObjectStream : public IDataSourceStream
 {
 public:
 	/** @brief Create a JSON object stream with a specific format
@@ -56,39 +68,112 @@ public:
 	//Use base class documentation
 	uint16_t readMemoryBlock(char* data, int bufSize) override
 	{
-		getData();
-		return MemoryDataStream::readMemoryBlock(data, bufSize);
+		if(data == nullptr || bufSize <= 0 || getLength() <= readPos) {
+			return 0;
+		}
+
+		Window window(data, readPos, bufSize);
+		Json::serialize(doc, window, format);
+		return window.getLength();
+	}
+
+	int seekFrom(int offset, SeekOrigin origin) override
+	{
+		size_t newPos;
+		switch(origin) {
+		case SeekOrigin::Start:
+			newPos = offset;
+			break;
+		case SeekOrigin::Current:
+			newPos = readPos + offset;
+			break;
+		case SeekOrigin::End:
+			newPos = getLength() + offset;
+			break;
+		default:
+			return -1;
+		}
+
+		if(newPos > getLength()) {
+			return -1;
+		}
+
+		readPos = newPos;
+		return readPos;
 	}
 
 	/**
-	 * @brief Return the total length of the stream
-	 * @retval int -1 is returned when the size cannot be determined
+	 * @brief Return the number of bytes remaining to be read
 	 */
 	int available() override
 	{
-		getData();
-		return (doc.isNull() ? 0 : Json::measure(doc, format));
+		return getLength() - readPos;
 	}
 
 	bool isFinished() override
 	{
-		getData();
-		return MemoryDataStream::isFinished();
+		return readPos >= getLength();
 	}
 
 private:
-	void getData()
+	/*
+	 * Captures the section of serialised output which falls within the read window
+	 */
+	class Window : public Print
+	{
+	public:
+		Window(char* buffer, size_t start, size_t size) : buffer(buffer), start(start), end(start + size)
+		{
+		}
+
+		size_t write(uint8_t c) override
+		{
+			if(pos >= start && pos < end) {
+				buffer[pos - start] = c;
+			}
+			++pos;
+			return 1;
+		}
+
+		size_t write(const uint8_t* data, size_t size) override
+		{
+			if(pos < end && pos + size > start) {
+				size_t offset = (pos < start) ? start - pos : 0;
+				size_t len = std::min(pos + size, end) - (pos + offset);
+				memcpy(&buffer[pos + offset - start], &data[offset], len);
+			}
+			pos += size;
+			return size;
+		}
+
+		size_t getLength() const
+		{
+			return (pos <= start) ? 0 : std::min(pos, end) - start;
+		}
+
+	private:
+		char* buffer;
+		size_t pos{0};
+		size_t start;
+		size_t end;
+	};
+
+	/*
+	 * Document size is measured once, when first required
+	 */
+	size_t getLength()
 	{
-		if(send && !doc.isNull()) {
-			Json::serialize(doc, this, format);
-			send = false;
+		if(length < 0) {
+			length = doc.isNull() ? 0 : Json::measure(doc, format);
 		}
+		return length;
 	}
 
 private:
 	DynamicJsonDocument doc;
 	Json::SerializationFormat format = Json::Compact;
-	bool send = true;
+	size_t readPos{0};
+	int length{-1};
 };
 
 /** @} */
@@ -0,0 +1,189 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/SmingHub/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * Output.h - Mixed audio output using I2S DMA
+ *
+ ****/
+
+#pragma once
+
+#include <driver/i2s.h>
+#include <Data/LinkedObjectList.h>
+#include <Delegate.h>
+
+namespace Audio
+{
+/**
+ * @brief Provides samples for an Output
+ *
+ * Samples are requested from task context as output buffers become free,
+ * so implementations should generate them quickly and must not block.
+ */
+class Source : public LinkedObjectTemplate<Source>
+{
+public:
+	using List = LinkedObjectListTemplate<Source>;
+
+	static constexpr uint16_t unityGain{256};
+
+	/**
+	 * @brief Produce samples
+	 * @param buffer Location for stereo samples
+	 * @param count Number of samples required
+	 * @retval size_t Number of samples produced. Fewer than `count` indicates the source has finished.
+	 */
+	virtual size_t read(i2s_sample_t* buffer, size_t count) = 0;
+
+	/**
+	 * @brief Set level for mixing
+	 * @param gain Scale factor, where `unityGain` leaves samples unchanged
+	 */
+	void setGain(uint16_t gain)
+	{
+		this->gain = gain;
+	}
+
+	uint16_t getGain() const
+	{
+		return gain;
+	}
+
+private:
+	uint16_t gain{unityGain};
+};
+
+/**
+ * @brief Plays audio from one or more sources through the I2S peripheral
+ *
+ * Samples are written into a ring of DMA buffers which the hardware sends without CPU involvement.
+ * When enough buffers become free the output pulls more samples from its sources at task level,
+ * mixes them and refills the buffers. The buffers therefore provide a lookahead of
+ * `(bufferCount - 1) * bufferLength` samples, which is how long other tasks may run
+ * (for example network or flash activity) before the output runs dry.
+ *
+ * If no sources are active the output is silent.
+ *
+ * Only one instance may be active at a time.
+ */
+class Output
+{
+public:
+	using FinishedCallback = Delegate<void(Source& source)>;
+
+	struct Config {
+		uint32_t sampleRate{44100};
+		uint16_t bufferLength{256}; ///< Samples per DMA buffer
+		uint8_t bufferCount{8};		///< Number of DMA buffers
+		uint8_t fillThreshold{0};   ///< Refill when this many buffers are free, 0 for half of them
+		i2s_pin_set_t pins{I2S_PIN_DATA_OUT | I2S_PIN_WS_OUT | I2S_PIN_BCK_OUT};
+	};
+
+	struct Stats {
+		uint32_t fills;			///< Number of times buffers were refilled
+		uint32_t samples;		///< Samples written
+		uint32_t maxFillTime;   ///< Longest refill, in microseconds
+		uint16_t minLookahead;  ///< Fewest samples queued when a refill started
+		uint16_t underruns;		///< Buffers sent with no data
+		uint16_t missedQueues;  ///< Refills which could not be scheduled
+		uint8_t maxSourceCount; ///< Largest number of sources mixed at once
+	};
+
+	~Output()
+	{
+		end();
+	}
+
+	/**
+	 * @brief Start output
+	 * @retval bool false if the I2S driver could not be started
+	 */
+	bool begin(const Config& config);
+
+	bool begin()
+	{
+		return begin(Config{});
+	}
+
+	/**
+	 * @brief Stop output and release the I2S driver
+	 * @note Sources are removed without notification
+	 */
+	void end();
+
+	bool isActive() const
+	{
+		return active == this;
+	}
+
+	/**
+	 * @brief Actual sample rate, which may differ from that requested
+	 */
+	float getSampleRate() const;
+
+	/**
+	 * @brief Start playing a source
+	 * @param source Must remain valid until it finishes or is removed
+	 * @retval bool true on success, including if the source is already playing
+	 */
+	bool addSource(Source& source)
+	{
+		return sources.add(&source);
+	}
+
+	/**
+	 * @brief Stop playing a source
+	 */
+	void removeSource(Source& source)
+	{
+		sources.remove(&source);
+	}
+
+	const Source::List& getSources() const
+	{
+		return sources;
+	}
+
+	/**
+	 * @brief Set callback invoked when a source has no more samples
+	 *
+	 * The source has been removed from the output and may be deleted or restarted.
+	 */
+	void onFinished(FinishedCallback callback)
+	{
+		finishedCallback = callback;
+	}
+
+	/**
+	 * @brief Obtain mixed samples from all sources
+	 * @param buffer
+	 * @param count Number of samples to produce
+	 *
+	 * This is used internally to fill the DMA buffers, but may also be used to send audio elsewhere.
+	 */
+	void mix(i2s_sample_t* buffer, size_t count);
+
+	/**
+	 * @brief Get statistics
+	 */
+	Stats getStats() const;
+
+	void resetStats();
+
+private:
+	static void IRAM_ATTR i2sCallback(void* param, i2s_event_type_t event);
+	static void fillCallback(void* param);
+
+	void fill();
+
+	static Output* active;
+	Source::List sources;
+	FinishedCallback finishedCallback;
+	Stats stats{};
+	uint16_t baseUnderruns{0};
+	volatile bool fillQueued{false};
+};
+
+} // namespace Audio
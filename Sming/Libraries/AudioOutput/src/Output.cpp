@@ -0,0 +1,221 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/SmingHub/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * Output.cpp
+ *
+ ****/
+
+#include <Audio/Output.h>
+#include <Platform/System.h>
+#include <debug_progmem.h>
+#include <Clock.h>
+#include <algorithm>
+
+namespace Audio
+{
+namespace
+{
+// Samples mixed at a time for each additional source
+constexpr size_t chunkSize{32};
+
+int16_t clip(int32_t value)
+{
+	return std::min(std::max(value, int32_t(INT16_MIN)), int32_t(INT16_MAX));
+}
+
+void applyGain(i2s_sample_t* buffer, size_t count, uint16_t gain)
+{
+	for(unsigned i = 0; i < count; ++i) {
+		auto& s = buffer[i];
+		s.left = clip((s.left * gain) >> 8);
+		s.right = clip((s.right * gain) >> 8);
+	}
+}
+
+void addSamples(i2s_sample_t* dst, const i2s_sample_t* src, size_t count, uint16_t gain)
+{
+	for(unsigned i = 0; i < count; ++i) {
+		dst[i].left = clip(dst[i].left + ((src[i].left * gain) >> 8));
+		dst[i].right = clip(dst[i].right + ((src[i].right * gain) >> 8));
+	}
+}
+
+} // namespace
+
+Output* Output::active;
+
+bool Output::begin(const Config& config)
+{
+	if(active != nullptr) {
+		debug_e("[AUDIO] Output already active");
+		return false;
+	}
+
+	i2s_config_t cfg{};
+	cfg.tx.mode = I2S_MODE_MASTER;
+	cfg.tx.bits_per_sample = I2S_BITS_PER_SAMPLE_16BIT;
+	cfg.tx.channel_format = I2S_CHANNEL_FMT_RIGHT_LEFT;
+	cfg.tx.communication_format = I2S_COMM_FORMAT_I2S_MSB;
+	cfg.tx.dma_buf_len = config.bufferLength;
+	cfg.tx.dma_buf_count = config.bufferCount;
+	cfg.tx.callback_threshold = config.fillThreshold ? config.fillThreshold : config.bufferCount / 2;
+	cfg.sample_rate = config.sampleRate;
+	// Mute output if we fall behind
+	cfg.tx_desc_auto_clear = true;
+	cfg.callback = i2sCallback;
+	cfg.param = this;
+	cfg.bits_mod = 16;
+	if(!i2s_driver_install(&cfg)) {
+		debug_e("[AUDIO] I2S driver install failed");
+		return false;
+	}
+
+	i2s_set_pins(config.pins, true);
+	active = this;
+	resetStats();
+	fill();
+	if(!i2s_start()) {
+		end();
+		return false;
+	}
+	return true;
+}
+
+void Output::end()
+{
+	if(active != this) {
+		return;
+	}
+
+	i2s_stop();
+	i2s_driver_uninstall();
+	active = nullptr;
+	sources.clear();
+}
+
+float Output::getSampleRate() const
+{
+	return isActive() ? i2s_get_real_rate() : 0;
+}
+
+void IRAM_ATTR Output::i2sCallback(void* param, i2s_event_type_t event)
+{
+	if(event != I2S_EVENT_TX_DONE) {
+		return;
+	}
+
+	auto self = static_cast<Output*>(param);
+	if(self->fillQueued) {
+		return;
+	}
+	if(System.queueCallback(TaskPriority::High, fillCallback, self)) {
+		self->fillQueued = true;
+	} else {
+		++self->stats.missedQueues;
+	}
+}
+
+void Output::fillCallback(void* param)
+{
+	auto self = static_cast<Output*>(param);
+	self->fillQueued = false;
+	if(self->isActive()) {
+		self->fill();
+	}
+}
+
+void Output::fill()
+{
+	auto startTime = micros();
+
+	i2s_buffer_stat_t stat;
+	if(i2s_stat_tx(&stat)) {
+		uint16_t lookahead = stat.used / sizeof(i2s_sample_t);
+		stats.minLookahead = std::min(stats.minLookahead, lookahead);
+	}
+
+	i2s_buffer_info_t info;
+	while(i2s_dma_write(&info, UINT_MAX)) {
+		auto count = info.size / sizeof(i2s_sample_t);
+		mix(info.samples, count);
+		stats.samples += count;
+	}
+
+	++stats.fills;
+	stats.maxFillTime = std::max(stats.maxFillTime, uint32_t(micros() - startTime));
+}
+
+void Output::mix(i2s_sample_t* buffer, size_t count)
+{
+	i2s_sample_t chunk[chunkSize];
+	unsigned sourceCount{0};
+
+	auto src = sources.head();
+	while(src != nullptr) {
+		auto next = src->getNext();
+		auto gain = src->getGain();
+		size_t produced{0};
+		if(sourceCount == 0) {
+			// First source writes directly to output
+			produced = src->read(buffer, count);
+			if(produced < count) {
+				memset(&buffer[produced], 0, (count - produced) * sizeof(i2s_sample_t));
+			}
+			if(gain != Source::unityGain) {
+				applyGain(buffer, produced, gain);
+			}
+		} else {
+			while(produced < count) {
+				auto required = std::min(chunkSize, count - produced);
+				auto n = src->read(chunk, required);
+				addSamples(&buffer[produced], chunk, n, gain);
+				produced += n;
+				if(n < required) {
+					break;
+				}
+			}
+		}
+		++sourceCount;
+
+		if(produced < count) {
+			// Notify from a separate task so the callback can safely restart the source
+			sources.remove(src);
+			if(finishedCallback) {
+				System.queueCallback([this, src]() { finishedCallback(*src); });
+			}
+		}
+
+		src = next;
+	}
+
+	if(sourceCount == 0) {
+		memset(buffer, 0, count * sizeof(i2s_sample_t));
+	}
+
+	stats.maxSourceCount = std::max(stats.maxSourceCount, uint8_t(std::min(sourceCount, 255U)));
+}
+
+Output::Stats Output::getStats() const
+{
+	Stats s = stats;
+	i2s_buffer_stat_t stat;
+	if(isActive() && i2s_stat_tx(&stat)) {
+		s.underruns = stat.overflows - baseUnderruns;
+	}
+	return s;
+}
+
+void Output::resetStats()
+{
+	stats = Stats{};
+	stats.minLookahead = UINT16_MAX;
+	i2s_buffer_stat_t stat;
+	if(isActive() && i2s_stat_tx(&stat)) {
+		baseUnderruns = stat.overflows;
+	}
+}
+
+} // namespace Audio
@@ -0,0 +1,112 @@
+#include <SmingTest.h>
+#include <Audio/Output.h>
+
+namespace
+{
+/*
+ * Produces a fixed number of constant samples
+ */
+class ConstantSource : public Audio::Source
+{
+public:
+	ConstantSource(int16_t value, size_t length) : value(value), remaining(length)
+	{
+	}
+
+	size_t read(i2s_sample_t* buffer, size_t count) override
+	{
+		count = std::min(count, remaining);
+		for(unsigned i = 0; i < count; ++i) {
+			buffer[i].left = value;
+			buffer[i].right = -value;
+		}
+		remaining -= count;
+		return count;
+	}
+
+private:
+	int16_t value;
+	size_t remaining;
+};
+
+} // namespace
+
+class AudioOutputTest : public TestGroup
+{
+public:
+	AudioOutputTest() : TestGroup(_F("AudioOutput"))
+	{
+	}
+
+	void execute() override
+	{
+		TEST_CASE("Silence")
+		{
+			i2s_sample_t buffer[16];
+			memset(buffer, 0xaa, sizeof(buffer));
+			output.mix(buffer, ARRAY_SIZE(buffer));
+			for(auto& s : buffer) {
+				REQUIRE_EQ(s.u32, 0U);
+			}
+		}
+
+		TEST_CASE("Mix")
+		{
+			ConstantSource src1(1000, 100);
+			ConstantSource src2(500, 50);
+			src2.setGain(Audio::Source::unityGain / 2);
+			ConstantSource src3(32000, 200);
+			REQUIRE(output.addSource(src1));
+			REQUIRE(output.addSource(src2));
+			REQUIRE(output.addSource(src3));
+
+			i2s_sample_t buffer[80];
+			output.mix(buffer, ARRAY_SIZE(buffer));
+
+			// Sum is clipped
+			REQUIRE_EQ(buffer[0].left, INT16_MAX);
+			REQUIRE_EQ(buffer[0].right, INT16_MIN);
+
+			// src2 finished after 50 samples and has been removed
+			REQUIRE_EQ(buffer[79].left, INT16_MAX);
+			REQUIRE_EQ(output.getSources().count(), 2U);
+
+			output.removeSource(src3);
+			output.mix(buffer, ARRAY_SIZE(buffer));
+			REQUIRE_EQ(buffer[0].left, 1000);
+			REQUIRE_EQ(buffer[19].right, -1000);
+			REQUIRE_EQ(buffer[20].u32, 0U);
+			REQUIRE_EQ(output.getSources().count(), 0U);
+			REQUIRE_EQ(output.getStats().maxSourceCount, 3);
+
+			ConstantSource src4(800, 10);
+			src4.setGain(Audio::Source::unityGain / 2);
+			REQUIRE(output.addSource(src4));
+			output.mix(buffer, ARRAY_SIZE(buffer));
+			REQUIRE_EQ(buffer[0].left, 400);
+			REQUIRE_EQ(buffer[9].right, -400);
+			REQUIRE_EQ(buffer[10].u32, 0U);
+		}
+
+		TEST_CASE("Finished callback")
+		{
+			ConstantSource src(100, 10);
+			output.onFinished([this, &src](Audio::Source& source) {
+				REQUIRE(&source == &src);
+				complete();
+			});
+			output.addSource(src);
+			i2s_sample_t buffer[16];
+			output.mix(buffer, ARRAY_SIZE(buffer));
+			pending();
+		}
+	}
+
+private:
+	Audio::Output output;
+};
+
+void REGISTER_TEST(AudioOutput)
+{
+	registerGroup<AudioOutputTest>();
+}
@@ -0,0 +1,11 @@
+ARDUINO_LIBRARIES := \
+	SmingTest \
+	AudioOutput
+
+#
+HOST_NETWORK_OPTIONS := --nonet
+DISABLE_NETWORK := 1
+DEBUG_VERBOSE_LEVEL := 2
+
+.PHONY: execute
+execute: flash run
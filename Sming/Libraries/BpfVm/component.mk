@@ -0,0 +1,4 @@
+COMPONENT_SRCDIRS := src
+COMPONENT_INCDIRS := src/include
+
+COMPONENT_DOXYGEN_INPUT := src/include
@@ -0,0 +1,305 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/SmingHub/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * Execute.cpp - Threaded-code interpreter
+ *
+ * Each translated instruction holds the index of its handler. Handlers end by jumping directly
+ * to the handler for the next instruction using a computed goto, so there is no central dispatch loop
+ * and no decoding at run time. All operands were validated by Program::load().
+ *
+ ****/
+
+#include <Bpf/Program.h>
+#include "Ops.h"
+#include <cstring>
+
+namespace Bpf
+{
+bool Program::run(void* context, size_t contextSize, uint64_t& result)
+{
+	if(count == 0) {
+		lastError = Error::notLoaded;
+		return false;
+	}
+
+	static const void* const handlers[] = {
+#define XX(name, ...) &&op_##name,
+		BPF_OPCODE_MAP(XX) BPF_ENDIAN_MAP(XX)
+#undef XX
+			&&op_invalid,
+	};
+
+	alignas(8) uint8_t stack[stackSize];
+	uint64_t reg[11]{};
+	const auto stackAddr = uint64_t(uintptr_t(stack));
+	const auto contextAddr = uint64_t(uintptr_t(context));
+	reg[1] = contextAddr;
+	reg[2] = contextSize;
+	reg[10] = stackAddr + stackSize;
+
+	uint32_t branches = branchLimit;
+	const Insn* pc = code.get();
+
+	// Get a pointer to memory the program may access, nullptr if not permitted
+	auto access = [&](uint64_t addr, size_t size, bool write) -> uint8_t* {
+		if(addr >= stackAddr && addr - stackAddr <= stackSize - size) {
+			return reinterpret_cast<uint8_t*>(uintptr_t(addr));
+		}
+		if((!write || contextWritable) && size <= contextSize && addr >= contextAddr &&
+		   addr - contextAddr <= contextSize - size) {
+			return reinterpret_cast<uint8_t*>(uintptr_t(addr));
+		}
+		return nullptr;
+	};
+
+#define DST reg[pc->dst]
+#define SRC reg[pc->src]
+#define IMM uint64_t(int64_t(pc->imm))
+#define DISPATCH() goto* handlers[pc->op]
+#define NEXT()                                                                                                         \
+	++pc;                                                                                                              \
+	DISPATCH()
+#define JUMP()                                                                                                         \
+	if(pc->offset < 0 && --branches == 0) {                                                                            \
+		lastError = Error::branchLimit;                                                                                \
+		return false;                                                                                                  \
+	}                                                                                                                  \
+	pc += pc->offset + 1;                                                                                              \
+	DISPATCH()
+
+// Labels are given in full as `and`, `or` and `xor` are reserved tokens
+#define ALU(imm64, reg64, imm32, reg32, op)                                                                            \
+	imm64 : DST = DST op IMM;                                                                                          \
+	NEXT();                                                                                                            \
+	reg64 : DST = DST op SRC;                                                                                          \
+	NEXT();                                                                                                            \
+	imm32 : DST = uint32_t(uint32_t(DST) op uint32_t(pc->imm));                                                        \
+	NEXT();                                                                                                            \
+	reg32 : DST = uint32_t(uint32_t(DST) op uint32_t(SRC));                                                            \
+	NEXT();
+
+#define COND(name, op, T)                                                                                              \
+	op_##name##_imm : if(T(DST) op T(IMM))                                                                             \
+	{                                                                                                                  \
+		JUMP();                                                                                                        \
+	}                                                                                                                  \
+	NEXT();                                                                                                            \
+	op_##name##_reg : if(T(DST) op T(SRC))                                                                             \
+	{                                                                                                                  \
+		JUMP();                                                                                                        \
+	}                                                                                                                  \
+	NEXT();
+
+#define LOAD(name, T)                                                                                                  \
+	op_##name:                                                                                                         \
+	{                                                                                                                  \
+		auto p = access(SRC + pc->offset, sizeof(T), false);                                                           \
+		if(p == nullptr) {                                                                                             \
+			goto fault;                                                                                                \
+		}                                                                                                              \
+		T value;                                                                                                       \
+		memcpy(&value, p, sizeof(T));                                                                                  \
+		DST = value;                                                                                                   \
+	}                                                                                                                  \
+	NEXT();
+
+#define STORE(name, T, value_)                                                                                         \
+	op_##name:                                                                                                         \
+	{                                                                                                                  \
+		auto p = access(DST + pc->offset, sizeof(T), true);                                                            \
+		if(p == nullptr) {                                                                                             \
+			goto fault;                                                                                                \
+		}                                                                                                              \
+		T value = T(value_);                                                                                           \
+		memcpy(p, &value, sizeof(T));                                                                                  \
+	}                                                                                                                  \
+	NEXT();
+
+	DISPATCH();
+
+	ALU(op_add64_imm, op_add64_reg, op_add32_imm, op_add32_reg, +)
+	ALU(op_sub64_imm, op_sub64_reg, op_sub32_imm, op_sub32_reg, -)
+	ALU(op_mul64_imm, op_mul64_reg, op_mul32_imm, op_mul32_reg, *)
+	ALU(op_or64_imm, op_or64_reg, op_or32_imm, op_or32_reg, |)
+	ALU(op_and64_imm, op_and64_reg, op_and32_imm, op_and32_reg, &)
+	ALU(op_xor64_imm, op_xor64_reg, op_xor32_imm, op_xor32_reg, ^)
+
+op_div64_imm:
+	DST /= IMM;
+	NEXT();
+op_div64_reg:
+	DST = SRC ? DST / SRC : 0;
+	NEXT();
+op_div32_imm:
+	DST = uint32_t(DST) / uint32_t(pc->imm);
+	NEXT();
+op_div32_reg:
+	DST = uint32_t(SRC) ? uint32_t(DST) / uint32_t(SRC) : 0;
+	NEXT();
+
+op_mod64_imm:
+	DST %= IMM;
+	NEXT();
+op_mod64_reg:
+	if(SRC != 0) {
+		DST %= SRC;
+	}
+	NEXT();
+op_mod32_imm:
+	DST = uint32_t(DST) % uint32_t(pc->imm);
+	NEXT();
+op_mod32_reg:
+	DST = uint32_t(SRC) ? uint32_t(DST) % uint32_t(SRC) : uint32_t(DST);
+	NEXT();
+
+op_lsh64_imm:
+	DST <<= pc->imm;
+	NEXT();
+op_lsh64_reg:
+	DST <<= (SRC & 63);
+	NEXT();
+op_rsh64_imm:
+	DST >>= pc->imm;
+	NEXT();
+op_rsh64_reg:
+	DST >>= (SRC & 63);
+	NEXT();
+op_arsh64_imm:
+	DST = uint64_t(int64_t(DST) >> pc->imm);
+	NEXT();
+op_arsh64_reg:
+	DST = uint64_t(int64_t(DST) >> (SRC & 63));
+	NEXT();
+op_lsh32_imm:
+	DST = uint32_t(uint32_t(DST) << pc->imm);
+	NEXT();
+op_lsh32_reg:
+	DST = uint32_t(uint32_t(DST) << (SRC & 31));
+	NEXT();
+op_rsh32_imm:
+	DST = uint32_t(DST) >> pc->imm;
+	NEXT();
+op_rsh32_reg:
+	DST = uint32_t(DST) >> (SRC & 31);
+	NEXT();
+op_arsh32_imm:
+	DST = uint32_t(int32_t(DST) >> pc->imm);
+	NEXT();
+op_arsh32_reg:
+	DST = uint32_t(int32_t(DST) >> (SRC & 31));
+	NEXT();
+
+op_neg64:
+	DST = -DST;
+	NEXT();
+op_neg32:
+	DST = uint32_t(-uint32_t(DST));
+	NEXT();
+
+op_mov64_imm:
+	DST = IMM;
+	NEXT();
+op_mov64_reg:
+	DST = SRC;
+	NEXT();
+op_mov32_imm:
+	DST = uint32_t(pc->imm);
+	NEXT();
+op_mov32_reg:
+	DST = uint32_t(SRC);
+	NEXT();
+
+	// Only little-endian hosts are supported
+op_le16:
+	DST = uint16_t(DST);
+	NEXT();
+op_le32:
+	DST = uint32_t(DST);
+	NEXT();
+op_le64:
+	NEXT();
+op_be16:
+	DST = __builtin_bswap16(uint16_t(DST));
+	NEXT();
+op_be32:
+	DST = __builtin_bswap32(uint32_t(DST));
+	NEXT();
+op_be64:
+	DST = __builtin_bswap64(DST);
+	NEXT();
+
+op_lddw:
+	DST = uint32_t(pc[0].imm) | (uint64_t(uint32_t(pc[1].imm)) << 32);
+	pc += 2;
+	DISPATCH();
+
+	LOAD(ldxb, uint8_t)
+	LOAD(ldxh, uint16_t)
+	LOAD(ldxw, uint32_t)
+	LOAD(ldxdw, uint64_t)
+
+	STORE(stb, uint8_t, pc->imm)
+	STORE(sth, uint16_t, pc->imm)
+	STORE(stw, uint32_t, pc->imm)
+	STORE(stdw, uint64_t, IMM)
+	STORE(stxb, uint8_t, SRC)
+	STORE(stxh, uint16_t, SRC)
+	STORE(stxw, uint32_t, SRC)
+	STORE(stxdw, uint64_t, SRC)
+
+op_ja:
+	JUMP();
+
+	COND(jeq, ==, uint64_t)
+	COND(jne, !=, uint64_t)
+	COND(jgt, >, uint64_t)
+	COND(jge, >=, uint64_t)
+	COND(jlt, <, uint64_t)
+	COND(jle, <=, uint64_t)
+	COND(jsgt, >, int64_t)
+	COND(jsge, >=, int64_t)
+	COND(jslt, <, int64_t)
+	COND(jsle, <=, int64_t)
+
+op_jset_imm:
+	if(DST & IMM) {
+		JUMP();
+	}
+	NEXT();
+op_jset_reg:
+	if(DST & SRC) {
+		JUMP();
+	}
+	NEXT();
+
+op_call:
+	reg[0] = helpers[pc->imm](reg[1], reg[2], reg[3], reg[4], reg[5]);
+	NEXT();
+
+op_exit:
+	result = reg[0];
+	lastError = Error::none;
+	return true;
+
+op_invalid:
+	// Not reachable in a verified program
+fault:
+	lastError = Error::memoryAccess;
+	return false;
+
+#undef DST
+#undef SRC
+#undef IMM
+#undef DISPATCH
+#undef NEXT
+#undef JUMP
+#undef ALU
+#undef COND
+#undef LOAD
+#undef STORE
+}
+
+} // namespace Bpf
@@ -0,0 +1,131 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/SmingHub/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * Ops.h - Instruction handlers for the translated program format
+ *
+ ****/
+
+#pragma once
+
+#include <cstdint>
+
+/*
+ * Supported eBPF opcodes, with the handler each is translated to.
+ *
+ * XX(handler, opcode)
+ */
+#define BPF_OPCODE_MAP(XX)                                                                                             \
+	XX(add64_imm, 0x07)                                                                                                \
+	XX(add64_reg, 0x0f)                                                                                                \
+	XX(sub64_imm, 0x17)                                                                                                \
+	XX(sub64_reg, 0x1f)                                                                                                \
+	XX(mul64_imm, 0x27)                                                                                                \
+	XX(mul64_reg, 0x2f)                                                                                                \
+	XX(div64_imm, 0x37)                                                                                                \
+	XX(div64_reg, 0x3f)                                                                                                \
+	XX(or64_imm, 0x47)                                                                                                 \
+	XX(or64_reg, 0x4f)                                                                                                 \
+	XX(and64_imm, 0x57)                                                                                                \
+	XX(and64_reg, 0x5f)                                                                                                \
+	XX(lsh64_imm, 0x67)                                                                                                \
+	XX(lsh64_reg, 0x6f)                                                                                                \
+	XX(rsh64_imm, 0x77)                                                                                                \
+	XX(rsh64_reg, 0x7f)                                                                                                \
+	XX(neg64, 0x87)                                                                                                    \
+	XX(mod64_imm, 0x97)                                                                                                \
+	XX(mod64_reg, 0x9f)                                                                                                \
+	XX(xor64_imm, 0xa7)                                                                                                \
+	XX(xor64_reg, 0xaf)                                                                                                \
+	XX(mov64_imm, 0xb7)                                                                                                \
+	XX(mov64_reg, 0xbf)                                                                                                \
+	XX(arsh64_imm, 0xc7)                                                                                               \
+	XX(arsh64_reg, 0xcf)                                                                                               \
+	XX(add32_imm, 0x04)                                                                                                \
+	XX(add32_reg, 0x0c)                                                                                                \
+	XX(sub32_imm, 0x14)                                                                                                \
+	XX(sub32_reg, 0x1c)                                                                                                \
+	XX(mul32_imm, 0x24)                                                                                                \
+	XX(mul32_reg, 0x2c)                                                                                                \
+	XX(div32_imm, 0x34)                                                                                                \
+	XX(div32_reg, 0x3c)                                                                                                \
+	XX(or32_imm, 0x44)                                                                                                 \
+	XX(or32_reg, 0x4c)                                                                                                 \
+	XX(and32_imm, 0x54)                                                                                                \
+	XX(and32_reg, 0x5c)                                                                                                \
+	XX(lsh32_imm, 0x64)                                                                                                \
+	XX(lsh32_reg, 0x6c)                                                                                                \
+	XX(rsh32_imm, 0x74)                                                                                                \
+	XX(rsh32_reg, 0x7c)                                                                                                \
+	XX(neg32, 0x84)                                                                                                    \
+	XX(mod32_imm, 0x94)                                                                                                \
+	XX(mod32_reg, 0x9c)                                                                                                \
+	XX(xor32_imm, 0xa4)                                                                                                \
+	XX(xor32_reg, 0xac)                                                                                                \
+	XX(mov32_imm, 0xb4)                                                                                                \
+	XX(mov32_reg, 0xbc)                                                                                                \
+	XX(arsh32_imm, 0xc4)                                                                                               \
+	XX(arsh32_reg, 0xcc)                                                                                               \
+	XX(lddw, 0x18)                                                                                                     \
+	XX(ldxw, 0x61)                                                                                                     \
+	XX(ldxh, 0x69)                                                                                                     \
+	XX(ldxb, 0x71)                                                                                                     \
+	XX(ldxdw, 0x79)                                                                                                    \
+	XX(stw, 0x62)                                                                                                      \
+	XX(sth, 0x6a)                                                                                                      \
+	XX(stb, 0x72)                                                                                                      \
+	XX(stdw, 0x7a)                                                                                                     \
+	XX(stxw, 0x63)                                                                                                     \
+	XX(stxh, 0x6b)                                                                                                     \
+	XX(stxb, 0x73)                                                                                                     \
+	XX(stxdw, 0x7b)                                                                                                    \
+	XX(ja, 0x05)                                                                                                       \
+	XX(jeq_imm, 0x15)                                                                                                  \
+	XX(jeq_reg, 0x1d)                                                                                                  \
+	XX(jgt_imm, 0x25)                                                                                                  \
+	XX(jgt_reg, 0x2d)                                                                                                  \
+	XX(jge_imm, 0x35)                                                                                                  \
+	XX(jge_reg, 0x3d)                                                                                                  \
+	XX(jlt_imm, 0xa5)                                                                                                  \
+	XX(jlt_reg, 0xad)                                                                                                  \
+	XX(jle_imm, 0xb5)                                                                                                  \
+	XX(jle_reg, 0xbd)                                                                                                  \
+	XX(jset_imm, 0x45)                                                                                                 \
+	XX(jset_reg, 0x4d)                                                                                                 \
+	XX(jne_imm, 0x55)                                                                                                  \
+	XX(jne_reg, 0x5d)                                                                                                  \
+	XX(jsgt_imm, 0x65)                                                                                                 \
+	XX(jsgt_reg, 0x6d)                                                                                                 \
+	XX(jsge_imm, 0x75)                                                                                                 \
+	XX(jsge_reg, 0x7d)                                                                                                 \
+	XX(jslt_imm, 0xc5)                                                                                                 \
+	XX(jslt_reg, 0xcd)                                                                                                 \
+	XX(jsle_imm, 0xd5)                                                                                                 \
+	XX(jsle_reg, 0xdd)                                                                                                 \
+	XX(call, 0x85)                                                                                                     \
+	XX(exit, 0x95)
+
+/*
+ * Byte swap instructions share opcodes 0xd4 (le) and 0xdc (be) and are selected by the immediate value,
+ * so each size gets its own handler.
+ */
+#define BPF_ENDIAN_MAP(XX)                                                                                             \
+	XX(le16)                                                                                                           \
+	XX(le32)                                                                                                           \
+	XX(le64)                                                                                                           \
+	XX(be16)                                                                                                           \
+	XX(be32)                                                                                                           \
+	XX(be64)
+
+namespace Bpf
+{
+enum class Op : uint8_t {
+#define XX(name, ...) name,
+	BPF_OPCODE_MAP(XX) BPF_ENDIAN_MAP(XX)
+#undef XX
+		invalid,
+};
+
+} // namespace Bpf
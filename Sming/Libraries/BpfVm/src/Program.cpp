@@ -0,0 +1,250 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/SmingHub/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * Program.cpp - Verification and translation
+ *
+ ****/
+
+#include <Bpf/Program.h>
+#include "Ops.h"
+#include <debug_progmem.h>
+#include <cstring>
+#include <new>
+
+namespace Bpf
+{
+namespace
+{
+constexpr uint8_t regCount{11};
+constexpr uint8_t regFramePointer{10};
+
+/*
+ * Encoded eBPF instruction
+ */
+struct RawInsn {
+	uint8_t opcode;
+	uint8_t dst : 4;
+	uint8_t src : 4;
+	int16_t offset;
+	int32_t imm;
+};
+
+static_assert(sizeof(RawInsn) == 8, "Bad RawInsn size");
+
+Op translate(uint8_t opcode)
+{
+	switch(opcode) {
+#define XX(name, opcode)                                                                                               \
+	case opcode:                                                                                                       \
+		return Op::name;
+		BPF_OPCODE_MAP(XX)
+#undef XX
+	default:
+		return Op::invalid;
+	}
+}
+
+Op translateEndian(uint8_t opcode, int32_t imm)
+{
+	bool be = (opcode == 0xdc);
+	switch(imm) {
+	case 16:
+		return be ? Op::be16 : Op::le16;
+	case 32:
+		return be ? Op::be32 : Op::le32;
+	case 64:
+		return be ? Op::be64 : Op::le64;
+	default:
+		return Op::invalid;
+	}
+}
+
+bool isJump(Op op)
+{
+	return op >= Op::ja && op <= Op::jsle_reg;
+}
+
+/*
+ * Instructions which modify dst
+ */
+bool writesDst(Op op)
+{
+	return op <= Op::ldxdw || (op >= Op::le16 && op <= Op::be64);
+}
+
+} // namespace
+
+String toString(Error error)
+{
+	switch(error) {
+	case Error::none:
+		return F("none");
+	case Error::notLoaded:
+		return F("not loaded");
+	case Error::badSize:
+		return F("bad size");
+	case Error::badOpcode:
+		return F("bad opcode");
+	case Error::badRegister:
+		return F("bad register");
+	case Error::badJump:
+		return F("bad jump");
+	case Error::badCall:
+		return F("bad call");
+	case Error::badImmediate:
+		return F("bad immediate");
+	case Error::noExit:
+		return F("no exit");
+	case Error::memoryAccess:
+		return F("memory access");
+	case Error::branchLimit:
+		return F("branch limit");
+	default:
+		return F("unknown");
+	}
+}
+
+void Program::unload()
+{
+	code.reset();
+	count = 0;
+	helpers = nullptr;
+	helperCount = 0;
+	lastError = Error::notLoaded;
+}
+
+Error Program::load(const void* bytecode, size_t size, const Helper* helpers, uint8_t helperCount)
+{
+	unload();
+
+	auto fail = [this](Error err, unsigned pc) {
+		debug_w("[BPF] Load failed at #%u: %s", pc, toString(err).c_str());
+		code.reset();
+		return lastError = err;
+	};
+
+	if(bytecode == nullptr || size == 0 || size % sizeof(RawInsn) != 0) {
+		return fail(Error::badSize, 0);
+	}
+	unsigned insnCount = size / sizeof(RawInsn);
+	if(insnCount > maxInstructions) {
+		return fail(Error::badSize, 0);
+	}
+
+	code.reset(new(std::nothrow) Insn[insnCount]);
+	if(!code) {
+		return fail(Error::badSize, 0);
+	}
+
+	// Second slots of 64-bit immediate loads, which may not be jumped to
+	std::unique_ptr<uint8_t[]> wide(new(std::nothrow) uint8_t[(insnCount + 7) / 8]{});
+	if(!wide) {
+		return fail(Error::badSize, 0);
+	}
+	auto isWide = [&](unsigned pc) { return (wide[pc / 8] >> (pc % 8)) & 1; };
+
+	// Bytecode may not be aligned
+	auto raw = static_cast<const uint8_t*>(bytecode);
+	for(unsigned pc = 0; pc < insnCount; ++pc) {
+		RawInsn in;
+		memcpy(&in, &raw[pc * sizeof(RawInsn)], sizeof(in));
+
+		auto& out = code[pc];
+		out.dst = in.dst;
+		out.src = in.src;
+		out.offset = in.offset;
+		out.imm = in.imm;
+
+		if(isWide(pc)) {
+			if(in.opcode != 0 || in.dst != 0 || in.src != 0 || in.offset != 0) {
+				return fail(Error::badOpcode, pc);
+			}
+			out.op = uint8_t(Op::invalid);
+			continue;
+		}
+
+		auto op = (in.opcode == 0xd4 || in.opcode == 0xdc) ? translateEndian(in.opcode, in.imm) : translate(in.opcode);
+		if(op == Op::invalid) {
+			return fail((in.opcode == 0xd4 || in.opcode == 0xdc) ? Error::badImmediate : Error::badOpcode, pc);
+		}
+		out.op = uint8_t(op);
+
+		if(in.dst >= regCount || in.src >= regCount) {
+			return fail(Error::badRegister, pc);
+		}
+		if(in.dst == regFramePointer && writesDst(op)) {
+			return fail(Error::badRegister, pc);
+		}
+
+		switch(op) {
+		case Op::lddw:
+			if(pc + 1 >= insnCount) {
+				return fail(Error::noExit, pc);
+			}
+			wide[(pc + 1) / 8] |= 1 << ((pc + 1) % 8);
+			break;
+
+		case Op::div64_imm:
+		case Op::mod64_imm:
+		case Op::div32_imm:
+		case Op::mod32_imm:
+			if(in.imm == 0) {
+				return fail(Error::badImmediate, pc);
+			}
+			break;
+
+		case Op::lsh64_imm:
+		case Op::rsh64_imm:
+		case Op::arsh64_imm:
+			if(in.imm < 0 || in.imm >= 64) {
+				return fail(Error::badImmediate, pc);
+			}
+			break;
+
+		case Op::lsh32_imm:
+		case Op::rsh32_imm:
+		case Op::arsh32_imm:
+			if(in.imm < 0 || in.imm >= 32) {
+				return fail(Error::badImmediate, pc);
+			}
+			break;
+
+		case Op::call:
+			if(helpers == nullptr || in.imm < 0 || in.imm >= helperCount || helpers[in.imm] == nullptr) {
+				return fail(Error::badCall, pc);
+			}
+			break;
+
+		default:
+			break;
+		}
+	}
+
+	// Check jump targets once all wide slots are known
+	for(unsigned pc = 0; pc < insnCount; ++pc) {
+		auto op = Op(code[pc].op);
+		if(isWide(pc) || !isJump(op)) {
+			continue;
+		}
+		int target = int(pc) + 1 + code[pc].offset;
+		if(target < 0 || unsigned(target) >= insnCount || isWide(target)) {
+			return fail(Error::badJump, pc);
+		}
+	}
+
+	auto last = Op(code[insnCount - 1].op);
+	if(isWide(insnCount - 1) || (last != Op::exit && last != Op::ja)) {
+		return fail(Error::noExit, insnCount - 1);
+	}
+
+	this->helpers = helpers;
+	this->helperCount = helperCount;
+	count = insnCount;
+	lastError = Error::none;
+	return Error::none;
+}
+
+} // namespace Bpf
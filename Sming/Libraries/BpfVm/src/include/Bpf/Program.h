@@ -0,0 +1,170 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/SmingHub/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * Program.h - Verified, pre-decoded eBPF program
+ *
+ ****/
+
+#pragma once
+
+#include <WString.h>
+#include <memory>
+
+namespace Bpf
+{
+/**
+ * @brief Function callable from a program using the eBPF `call` instruction
+ *
+ * Arguments are passed in r1-r5 and the result returned in r0.
+ */
+using Helper = uint64_t (*)(uint64_t r1, uint64_t r2, uint64_t r3, uint64_t r4, uint64_t r5);
+
+enum class Error : uint8_t {
+	none,
+	// Detected by load()
+	notLoaded,		///< No program has been loaded
+	badSize,		///< Bytecode is empty, too large or not a whole number of instructions
+	badOpcode,		///< Unknown or unsupported instruction
+	badRegister,	///< Register number out of range, or write to read-only r10
+	badJump,		///< Jump target outside program, or into the middle of an instruction
+	badCall,		///< Call to a helper which has not been provided
+	badImmediate,   ///< Invalid shift count, division by constant zero or byte swap size
+	noExit,			///< Execution could fall off the end of the program
+	// Detected by run()
+	memoryAccess,   ///< Load or store outside the stack or context
+	branchLimit,	///< Too many backward branches taken
+};
+
+/**
+ * @brief An eBPF program which has been verified and converted for fast execution
+ *
+ * Bytecode is checked once by `load()` and translated into an internal format in which each
+ * instruction refers directly to its handler. `run()` then dispatches from one handler to the next
+ * with a single indirect jump (threaded code) and performs no per-instruction validation,
+ * apart from bounds checks on memory accesses.
+ *
+ * On entry, r1 points to the context and r2 contains its size. r10 points to the top of
+ * a stack of `stackSize` bytes. Programs may only access memory within the context or stack.
+ *
+ * Example, accepting UDP packets which start with the byte 0x55:
+ *
+ * 		const uint64_t filterCode[] = {
+ * 			0x00000000000000b7, // mov r0, 0
+ * 			0x0000000000001271, // ldxb r2, [r1]
+ * 			0x0000005500010255, // jne r2, 0x55, +1
+ * 			0x00000001000000b7, // mov r0, 1
+ * 			0x0000000000000095, // exit
+ * 		};
+ *
+ * 		Bpf::Program filter;
+ * 		filter.load(filterCode, sizeof(filterCode));
+ *
+ * 		void onReceive(UdpConnection& connection, char* data, int size, IpAddress remoteIP, uint16_t remotePort)
+ * 		{
+ * 			uint64_t accept;
+ * 			if(!filter.run(data, size, accept) || accept == 0) {
+ * 				return;
+ * 			}
+ * 			...
+ * 		}
+ */
+class Program
+{
+public:
+	static constexpr size_t stackSize{512};
+	static constexpr size_t maxInstructions{4096};
+	static constexpr uint32_t defaultBranchLimit{10000};
+
+	/**
+	 * @brief Verify and translate a program
+	 * @param code eBPF bytecode, in host byte order
+	 * @param size Size of bytecode in bytes
+	 * @param helpers Functions available via `call`, indexed by the instruction immediate value
+	 * @param helperCount Number of entries in helpers
+	 * @retval Error Error::none on success
+	 */
+	Error load(const void* code, size_t size, const Helper* helpers = nullptr, uint8_t helperCount = 0);
+
+	/**
+	 * @brief Release the translated program
+	 */
+	void unload();
+
+	bool isLoaded() const
+	{
+		return count != 0;
+	}
+
+	/**
+	 * @brief Number of instructions, counting 64-bit immediate loads as two
+	 */
+	unsigned size() const
+	{
+		return count;
+	}
+
+	/**
+	 * @brief Allow the context to be modified by the program (read-only by default)
+	 */
+	void setContextWritable(bool writable)
+	{
+		contextWritable = writable;
+	}
+
+	/**
+	 * @brief Set maximum number of backward branches taken per run, which bounds loop execution
+	 */
+	void setBranchLimit(uint32_t limit)
+	{
+		branchLimit = limit;
+	}
+
+	/**
+	 * @brief Execute the program
+	 * @param context Data to pass to the program in r1, e.g. a received packet
+	 * @param contextSize Size of data, passed in r2
+	 * @param result On success, value of r0 on exit
+	 * @retval bool false if program is not loaded or terminated with an error, see `getLastError()`
+	 */
+	bool run(void* context, size_t contextSize, uint64_t& result);
+
+	/**
+	 * @brief Get error from the most recent call to `load()` or `run()`
+	 */
+	Error getLastError() const
+	{
+		return lastError;
+	}
+
+	/**
+	 * @brief Translated instruction
+	 *
+	 * Register numbers are unpacked to avoid masking and shifting at run time.
+	 */
+	struct Insn {
+		uint8_t op; ///< Handler index
+		uint8_t dst;
+		uint8_t src;
+		int16_t offset;
+		int32_t imm;
+	};
+
+private:
+	std::unique_ptr<Insn[]> code;
+	const Helper* helpers{nullptr};
+	uint16_t count{0};
+	uint8_t helperCount{0};
+	bool contextWritable{false};
+	uint32_t branchLimit{defaultBranchLimit};
+	Error lastError{Error::notLoaded};
+};
+
+/**
+ * @brief Get a printable description of an error
+ */
+String toString(Error error);
+
+} // namespace Bpf
@@ -0,0 +1,140 @@
+#include <SmingTest.h>
+#include <Bpf/Program.h>
+
+namespace
+{
+uint64_t helperAdd(uint64_t r1, uint64_t r2, uint64_t, uint64_t, uint64_t)
+{
+	return r1 + r2;
+}
+
+// Return 1 if first byte of context is 0x55
+const uint64_t filterCode[] = {
+	0x00000000000000b7, // mov r0, 0
+	0x0000000000001271, // ldxb r2, [r1]
+	0x0000005500010255, // jne r2, 0x55, +1
+	0x00000001000000b7, // mov r0, 1
+	0x0000000000000095, // exit
+};
+
+// Sum bytes of context
+const uint64_t sumCode[] = {
+	0x00000000000000b7, // mov r0, 0
+	0x00000000000013bf, // mov r3, r1
+	0x00000000000014bf, // mov r4, r1
+	0x000000000000240f, // add r4, r2
+	0x000000000004433d, // loop: jge r3, r4, +4
+	0x0000000000003571, // ldxb r5, [r3]
+	0x000000000000500f, // add r0, r5
+	0x0000000100000307, // add r3, 1
+	0x00000000fffb0005, // ja loop
+	0x0000000000000095, // exit
+};
+
+// Wide immediate, byte swap, stack access and helper call
+const uint64_t miscCode[] = {
+	0x1234567800000018, // lddw r0, 0x0000000112345678
+	0x0000000100000000,
+	0x00000010000000dc, // be16 r0
+	0x00000000fff80a7b, // stxdw [r10-8], r0
+	0x00000000fff8a179, // ldxdw r1, [r10-8]
+	0x00000005000002b7, // mov r2, 5
+	0x0000000000000085, // call 0
+	0x0000000000000095, // exit
+};
+
+// Store byte to context
+const uint64_t storeCode[] = {
+	0x0000000100000172, // stb [r1], 1
+	0x00000000000000b7, // mov r0, 0
+	0x0000000000000095, // exit
+};
+
+} // namespace
+
+class BpfVmTest : public TestGroup
+{
+public:
+	BpfVmTest() : TestGroup(_F("BpfVm"))
+	{
+	}
+
+	void execute() override
+	{
+		Bpf::Program prog;
+		uint64_t result;
+
+		TEST_CASE("Filter")
+		{
+			REQUIRE(prog.load(filterCode, sizeof(filterCode)) == Bpf::Error::none);
+			char packet[]{0x55, 0x01, 0x02};
+			REQUIRE(prog.run(packet, sizeof(packet), result));
+			REQUIRE_EQ(result, 1);
+			packet[0] = 0;
+			REQUIRE(prog.run(packet, sizeof(packet), result));
+			REQUIRE_EQ(result, 0);
+			REQUIRE(!prog.run(packet, 0, result));
+			REQUIRE(prog.getLastError() == Bpf::Error::memoryAccess);
+		}
+
+		TEST_CASE("Loop")
+		{
+			REQUIRE(prog.load(sumCode, sizeof(sumCode)) == Bpf::Error::none);
+			uint8_t data[200];
+			uint64_t sum{0};
+			for(unsigned i = 0; i < sizeof(data); ++i) {
+				data[i] = i * 7;
+				sum += data[i];
+			}
+			REQUIRE(prog.run(data, sizeof(data), result));
+			REQUIRE_EQ(result, sum);
+
+			prog.setBranchLimit(10);
+			REQUIRE(!prog.run(data, sizeof(data), result));
+			REQUIRE(prog.getLastError() == Bpf::Error::branchLimit);
+		}
+
+		TEST_CASE("Helpers and stack")
+		{
+			const Bpf::Helper helpers[]{helperAdd};
+			REQUIRE(prog.load(miscCode, sizeof(miscCode), helpers, 1) == Bpf::Error::none);
+			REQUIRE(prog.run(nullptr, 0, result));
+			REQUIRE_EQ(result, 0x7856 + 5);
+		}
+
+		TEST_CASE("Context write")
+		{
+			REQUIRE(prog.load(storeCode, sizeof(storeCode)) == Bpf::Error::none);
+			uint8_t data[4]{};
+			REQUIRE(!prog.run(data, sizeof(data), result));
+			prog.setContextWritable(true);
+			REQUIRE(prog.run(data, sizeof(data), result));
+			REQUIRE_EQ(data[0], 1);
+		}
+
+		TEST_CASE("Verifier")
+		{
+			auto check = [&](std::initializer_list<uint64_t> code, Bpf::Error expected) {
+				auto err = prog.load(code.begin(), code.size() * sizeof(uint64_t));
+				REQUIRE_EQ(toString(err), toString(expected));
+				REQUIRE(!prog.isLoaded());
+			};
+
+			check({}, Bpf::Error::badSize);
+			check({0xb7}, Bpf::Error::noExit);
+			check({0xff, 0x95}, Bpf::Error::badOpcode);
+			check({0x00050005, 0x95}, Bpf::Error::badJump);
+			check({0x0ab7, 0x95}, Bpf::Error::badRegister);
+			check({0x85, 0x95}, Bpf::Error::badCall);
+			check({0x37, 0x95}, Bpf::Error::badImmediate);
+			check({0x0000004000000067, 0x95}, Bpf::Error::badImmediate);
+			// Jump into second half of lddw
+			check({0x18, 0, 0x95, 0xfffd0005}, Bpf::Error::badJump);
+		}
+	}
+};
+
+void REGISTER_TEST(BpfVm)
+{
+	registerGroup<BpfVmTest>();
+}
@@ -7,6 +7,7 @@
 
 #include "Arduino.h"
 #include <Libraries/OneWire/OneWire.h>
+#include <Libraries/OneWire/OneWireAsync.h>
 #include "ds18s20.h"
 
 #define DEBUG_DS18S20
@@ -25,20 +26,24 @@
 
 
 
-DS18S20::DS18S20(uint8_t workPin /* = DS1820_WORK_PIN */)
+DS18S20::DS18S20(uint8_t workPin /* = DS1820_WORK_PIN */) : workPin(workPin)
 {
-	ds = new OneWire(workPin);
+	ds = new OneWireAsync;
 }
 
 DS18S20::~DS18S20()
 {
+	DelaysTimer.stop();
+	ds->end();
 	delete ds;
 	ds = nullptr;
 }
 
 void DS18S20::Init(uint8_t pinOneWire)
 {
-   ds->begin(pinOneWire);
+   workPin = pinOneWire;
+   ds->begin(workPin);
+   DelaysTimer.stop();
    InProgress=false;
 }
 
@@ -49,169 +54,185 @@ void DS18S20::StartMeasure()
 
 		debugx("  DBG: DS1820 reading task start, try to read up to %d sensors",MAX_SENSORS);
 		InProgress=true;
-		ds->begin();
-		ds->reset_search();
-		DelaysTimer.initializeMs(150, TimerDelegate(&DS18S20::DoSearch, this)).start(false);
+		ds->begin(workPin);
+		numberOf=0;
+		DoSearch();
 	}
 
 }
 
-
-
-uint8_t DS18S20::FindAlladdresses()
+void DS18S20::DoSearch()
 {
-	uint8_t counter=0;
-	uint8_t thermoNo=0;
-	uint8_t a;
+	if (numberOf >= MAX_SENSORS || !ds->searchNext(OneWireAsync::Callback(&DS18S20::SearchResult, this)))
+	{
+		// Search complete
+		StartConversion();
+	}
+}
 
-	while (counter++ < MAX_SENSORS)
+void DS18S20::SearchResult(bool success)
+{
+	if (!success)
 	{
-		if (!ds->search(addr))
-		{
-			debugx("  DBG: No more address found");
-            break;
-		}
-		else
-		if (OneWire::crc8(addr, 7) == addr[7])
-			{
-			  debugx("  DBG: CRC is valid");
-				switch (addr[0]) {
-				case 0x10:
-				  debugx("  DBG: Chip = DS18S20");  // or old DS1820
-				  type_s[thermoNo] = 1;
-				  break;
-				case 0x28:
-				  debugx("  DBG: Chip = DS18B20");
-				  type_s[thermoNo] = 0;
-				  break;
-				case 0x22:
-				  debugx("  DBG: Chip = DS1822");
-				  type_s[thermoNo] = 0;
-				  break;
-				default:
-				  debugx("  DBG: This Device is not a DS18x20 family device.");
-				  break;
-				}
-
-			    // address ok, copy uwaga na default teraz zle
-				for(a=0;a<8;a++)
-				addresses[thermoNo]=(addresses[thermoNo]<<8) +(uint64_t)addr[a];
-                thermoNo++;
-			}
-			else
-			{
-			debugx("  DBG: CRC is not valid");
-			}
+		debugx("  DBG: No more address found");
+		StartConversion();
+		return;
 	}
 
+	auto addr = ds->getRom();
+	switch (addr[0]) {
+	case 0x10:
+	  debugx("  DBG: Chip = DS18S20");  // or old DS1820
+	  type_s[numberOf] = 1;
+	  break;
+	case 0x28:
+	  debugx("  DBG: Chip = DS18B20");
+	  type_s[numberOf] = 0;
+	  break;
+	case 0x22:
+	  debugx("  DBG: Chip = DS1822");
+	  type_s[numberOf] = 0;
+	  break;
+	default:
+	  debugx("  DBG: This Device is not a DS18x20 family device.");
+	  DoSearch();
+	  return;
+	}
 
-  return thermoNo;
+	uint64_t id = 0;
+	for (uint8_t a=0;a<8;a++)
+		id=(id<<8) +(uint64_t)addr[a];
+	addresses[numberOf]=id;
+	ValidTemperature[numberOf]=false;
+	numberOf++;
+
+	DoSearch();
 }
 
-void DS18S20::DoSearch(void)
+void DS18S20::StartConversion()
 {
-
-	numberOf=FindAlladdresses();
-
 	if (!numberOf)
 	{
 		debugx("  DBG: No DS1820 sensor found");
-        InProgress=false;
-
+		ReadComplete();
+		return;
 	}
-	else
-	{
-      debugx("  DBG: %d DS1820 sensors found",numberOf);
 
-      numberOfread=0;
-      StartReadNext();
+	debugx("  DBG: %d DS1820 sensors found",numberOf);
+
+	// Start conversion on all sensors at once, with parasite power on at the end
+	const uint8_t cmd[] = {SKIPROM, STARTCONVO};
+	if (!ds->transaction(cmd, sizeof(cmd), 0, OneWireAsync::Callback(&DS18S20::ConversionStarted, this), true, true))
+	{
+		ReadComplete();
 	}
+}
 
+void DS18S20::ConversionStarted(bool success)
+{
+	if (!success)
+	{
+		debugx("  DBG: No response to conversion request");
+		ReadComplete();
+		return;
+	}
 
+	numberOfread=0;
+	DelaysTimer.initializeMs(CONVERSION_TIME_MS, TimerDelegate(&DS18S20::StartReadNext, this)).start(false);
 }
 
 void DS18S20::StartReadNext()
 {
-   if (numberOf > numberOfread )
-   {
-	ds->reset();
-
-	  uint64_t tmp=addresses[numberOfread];
-	  for (uint8_t a=0;a<8;a++)
-	  {
-	    addr[7-a]=(uint8_t)tmp;
-	    tmp=tmp>>8;
-	  }
-
-	  ds->select(addr);
-	  ds->write(STARTCONVO, 1);        // start conversion, with parasite power on at the end
-
-	  DelaysTimer.initializeMs(900, TimerDelegate(&DS18S20::DoMeasure, this)).start(false);
-   }
-   else
-   {
-	   debugx("  DBG: DS18S20 reading task end");
-	   InProgress=false;
-	   if(readEndCallback) //If callback set, execute function
-	   {
-		   readEndCallback();
-	   }
-   }
+	if (numberOf <= numberOfread)
+	{
+		ReadComplete();
+		return;
+	}
+
+	uint8_t cmd[10];
+	cmd[0] = MATCHROM;
+	uint64_t tmp=addresses[numberOfread];
+	for (uint8_t a=0;a<8;a++)
+	{
+		cmd[8-a]=(uint8_t)tmp;
+		tmp=tmp>>8;
+	}
+	cmd[9] = READSCRATCH;         // Read Scratchpad
+
+	// we need 9 bytes
+	if (!ds->transaction(cmd, sizeof(cmd), 9, OneWireAsync::Callback(&DS18S20::DoMeasure, this)))
+	{
+		DoMeasure(false);
+	}
 }
 
-void DS18S20::DoMeasure()
+void DS18S20::ReadComplete()
 {
+	ds->depower();
+	debugx("  DBG: DS18S20 reading task end");
+	InProgress=false;
+	if(readEndCallback) //If callback set, execute function
+	{
+		readEndCallback();
+	}
+}
 
-	uint8_t present,i;
-	present = ds->reset();
-	ds->select(addr);
-	ds->write(READSCRATCH);         // Read Scratchpad
+void DS18S20::DoMeasure(bool success)
+{
+	auto data = ds->getData();
 
 	debugx("  DBG: T%d",numberOfread+1);
+	debugx("  DBG: Data = %x %x %x %x %x %x %x %x %x %x  CRC=%x",success,data[0],data[1],data[2],data[3],data[4],data[5],data[6],data[7],data[8],OneWire::crc8(data, 8));
 
-	for ( i = 0; i < 9; i++)
+	if (success && OneWire::crc8(data, 8) != data[8])
 	{
-		// we need 9 bytes
-		data[i] = ds->read();
+		debugx("  DBG: CRC is not valid");
+		success = false;
 	}
-	debugx("  DBG: Data = %x %x %x %x %x %x %x %x %x %x  CRC=%x",present,data[0],data[1],data[2],data[3],data[4],data[5],data[6],data[7],data[8],OneWire::crc8(data, 8));
-
-	// Convert the data to actual temperature
-	// because the result is a 16 bit signed integer, it should
-	// be stored to an "int16_t" type, which is always 16 bits
-	// even when compiled on a 32 bit processor.
-	unsigned int raw = (data[1] << 8) | data[0];
-	if (type_s[numberOfread])
+
+	ValidTemperature[numberOfread]=success;
+
+	if (success)
 	{
-		raw = raw << 3; // 9 bit resolution default
-		if (data[7] == 0x10)
+		// Convert the data to actual temperature
+		// because the result is a 16 bit signed integer, it should
+		// be stored to an "int16_t" type, which is always 16 bits
+		// even when compiled on a 32 bit processor.
+		unsigned int raw = (data[1] << 8) | data[0];
+		if (type_s[numberOfread])
 		{
-		  // "count remain" gives full 12 bit resolution
-		  raw = (raw & 0xFFF0) + 12 - data[6];
+			raw = raw << 3; // 9 bit resolution default
+			if (data[7] == 0x10)
+			{
+			  // "count remain" gives full 12 bit resolution
+			  raw = (raw & 0xFFF0) + 12 - data[6];
+			}
+		} else {
+			byte cfg = (data[4] & 0x60);
+			// at lower res, the low bits are undefined, so let's zero them
+			if (cfg == 0x00) raw = raw & ~7;  // 9 bit resolution, 93.75 ms
+			else if (cfg == 0x20) raw = raw & ~3; // 10 bit res, 187.5 ms
+			else if (cfg == 0x40) raw = raw & ~1; // 11 bit res, 375 ms
+			//// default is 12 bit resolution, 750 ms conversion time
 		}
-	} else {
-		byte cfg = (data[4] & 0x60);
-		// at lower res, the low bits are undefined, so let's zero them
-		if (cfg == 0x00) raw = raw & ~7;  // 9 bit resolution, 93.75 ms
-		else if (cfg == 0x20) raw = raw & ~3; // 10 bit res, 187.5 ms
-		else if (cfg == 0x40) raw = raw & ~1; // 11 bit res, 375 ms
-		//// default is 12 bit resolution, 750 ms conversion time
-	}
 
-	ValidTemperature[numberOfread]=true;
-	
-    if (raw & 0x8000)   //is minus ?
-	  celsius[numberOfread] = 0 - ((float) ((raw ^ 0xffff) + 1) / 16.0); // 2's comp
-	else
-	  celsius[numberOfread] = (float)raw / 16.0;	
+		if (raw & 0x8000)   //is minus ?
+		  celsius[numberOfread] = 0 - ((float) ((raw ^ 0xffff) + 1) / 16.0); // 2's comp
+		else
+		  celsius[numberOfread] = (float)raw / 16.0;
 
-	fahrenheit[numberOfread] = celsius[numberOfread] * 1.8 + 32.0;
+		fahrenheit[numberOfread] = celsius[numberOfread] * 1.8 + 32.0;
 
-	debugx("  DBG: Temperature = %f Celsius, %f Fahrenheit",celsius[numberOfread],fahrenheit[numberOfread]);
+		debugx("  DBG: Temperature = %f Celsius, %f Fahrenheit",celsius[numberOfread],fahrenheit[numberOfread]);
+	}
 
-	numberOfread++;
-	DelaysTimer.initializeMs(100, TimerDelegate(&DS18S20::StartReadNext, this)).start(false);
+	if (valueCallback)
+	{
+		valueCallback(numberOfread, success ? celsius[numberOfread] : 0, success);
+	}
 
+	numberOfread++;
+	StartReadNext();
 }
 
 float DS18S20::GetCelsius(uint8_t index)
@@ -225,7 +246,7 @@ float DS18S20::GetCelsius(uint8_t index)
 
 float DS18S20::GetFahrenheit(uint8_t index)
 {
-	  if (index <= numberOf)
+	  if (index < numberOf)
 	     return fahrenheit[index];
 	  else
 		 return 0;
@@ -235,7 +256,7 @@ float DS18S20::GetFahrenheit(uint8_t index)
 
 bool DS18S20::IsValidTemperature(uint8_t index)
 {
-	  if (index <= numberOf)
+	  if (index < numberOf)
 		  return ValidTemperature[index];
 	  else
 		  return false;
@@ -248,7 +269,7 @@ bool DS18S20::MeasureStatus()
 
 uint64_t DS18S20::GetSensorID(uint8_t index)
 {
-	  if (index <= numberOf)
+	  if (index < numberOf)
 		  return addresses[index];
 	  else
 		  return 0;
@@ -269,3 +290,8 @@ void DS18S20::UnRegisterCallback()
 	readEndCallback = nullptr;
 }
 
+void DS18S20::RegisterValueCallback(DS18S20ValueDelegate callback)
+{
+	valueCallback = callback;
+}
+
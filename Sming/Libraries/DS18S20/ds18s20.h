@@ -11,13 +11,19 @@
 /** @defgroup   DS18S20 DS18S20 Temperature Sensor
  *  @brief  This library provides access to DS18S20 temperature sensors connected via 1-Wire bus to a single GPIO
  *          The DS18S20 can run in several modes, with varying degrees of resolution. The highest resolution is 12-bit which provides 0.0625C resolution.
-            12-bit measurement takes 750ms. With 4 sensors connected, measurement will take 3s.
+            12-bit measurement takes 750ms. All sensors convert at the same time, so this is also the time taken to measure several sensors.
+            The bus is driven from a hardware timer interrupt so the main loop is not blocked during measurement.
  *  @ingroup    libraries
  *  @{
 */
 #include <Wire.h>
+#include <Timer.h>
 
+#ifndef MAX_SENSORS
 #define MAX_SENSORS 4         ///< Maximum quantity of sensors to read
+#endif
+
+#define CONVERSION_TIME_MS 750	///< Time for 12-bit conversion
 
 // OneWire commands
 
@@ -28,6 +34,8 @@
 #define READPOWERSUPPLY 0xB4  // parasite power
 #define ALARMSEARCH     0xEC  // Query for alarm
 #define STARTCONVO      0x44  // temperature reading
+#define MATCHROM        0x55  // Address a single device
+#define SKIPROM         0xCC  // Address all devices
 
 #define DS1820_WORK_PIN 2	// default DS1820 on GPIO2, can be changed by Init
 
@@ -36,7 +44,12 @@
 */
 typedef Delegate<void()> DS18S20CompletedDelegate;
 
-class OneWire;
+/** @brief  Definition of callback function called as each sensor is read
+    @note   Example: void onValue(uint8_t index, float celsius, bool valid) { ... };
+*/
+typedef Delegate<void(uint8_t index, float celsius, bool valid)> DS18S20ValueDelegate;
+
+class OneWireAsync;
 
 /** @brief  This class implements access to the DS18x20 range of temperature sensors
 */
@@ -53,7 +66,8 @@ public:
 	void Init(uint8_t);
 
     /** @brief  Start measurement of all connected sensors
-    *   @note   Scans for all connected sensors, measures value from each then calls the registered callback function
+    *   @note   Scans for all connected sensors, starts conversion on all of them at once,
+    *           reads the value from each then calls the registered callback function
     */
 	void StartMeasure();
 
@@ -67,6 +81,11 @@ public:
 	*/
 	void UnRegisterCallback();             			//Unset conversion end function
 
+	/** @brief  Register a callback function to run as the value from each sensor is read
+	*   @param  Name of the callback function, or nullptr to unregister
+	*/
+	void RegisterValueCallback(DS18S20ValueDelegate);
+
     /** @brief  Get the value of the last measurement from a sensor
     *   @param  Index of sensor to retrieve value from
     *   @return Temperature value in degrees Celsius or zero for invalid sensor index
@@ -110,29 +129,32 @@ public:
 
 private:
 
-	void DoMeasure();
+	void DoMeasure(bool success);
 	void DoSearch();
+	void SearchResult(bool success);
+	void StartConversion();
+	void ConversionStarted(bool success);
 	void StartReadNext();
-	uint8_t FindAlladdresses();
+	void ReadComplete();
 
 private:
 	bool InProgress = false;
 	bool ValidTemperature[MAX_SENSORS];
-	uint8_t addr[8];
+	uint8_t workPin;
 	uint8_t type_s[MAX_SENSORS];
-	uint8_t data[12];
 	uint64_t addresses[MAX_SENSORS];
 	uint8_t numberOf=0;
 	uint8_t numberOfread=0;
 
 	DS18S20CompletedDelegate readEndCallback;
+	DS18S20ValueDelegate valueCallback;
 
 	Timer DelaysTimer;
 
 
 	float celsius[MAX_SENSORS], fahrenheit[MAX_SENSORS];
 
-	OneWire* ds = nullptr;
+	OneWireAsync* ds = nullptr;
 };
 
 /** @} */
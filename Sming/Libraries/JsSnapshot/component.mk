@@ -0,0 +1,62 @@
+COMPONENT_DEPENDS := jerryscript
+
+COMPONENT_SRCDIRS := src
+COMPONENT_INCDIRS := src/include
+
+COMPONENT_DOXYGEN_INPUT := src/include
+
+# Snapshot compiler from JerryScript, must match the engine version
+CONFIG_VARS			+= JERRY_SNAPSHOT_TOOL
+JERRY_SNAPSHOT_TOOL	?= jerry-snapshot
+
+# Generate static snapshots, which require all literals to be registered as magic strings
+CONFIG_VARS			+= JS_SNAPSHOT_STATIC
+JS_SNAPSHOT_STATIC	?= 0
+
+JS_SNAPSHOT_FLAGS	:= $(if $(filter 1,$(JS_SNAPSHOT_STATIC)),--static)
+
+# Tool to pack snapshots into a partition image
+JS_SNAPPACK			:= $(PYTHON) $(COMPONENT_PATH)/tools/snappack.py
+
+##@Building
+
+# => Snapshots for import via IMPORT_FSTR
+CONFIG_VARS			+= JS_SNAPSHOT_DIRS
+JS_SNAPSHOT_OUTPUT	:= $(PROJECT_DIR)/$(OUT_BASE)/js-snapshots
+APP_CFLAGS			+= -DJS_SNAPSHOT_OUTPUT=\"$(JS_SNAPSHOT_OUTPUT)\"
+ifdef JS_SNAPSHOT_DIRS
+JS_SNAPSHOT_SOURCES	:= $(call ListAllFiles,$(JS_SNAPSHOT_DIRS),*.js)
+JS_SNAPSHOT_FILES	:= $(addprefix $(JS_SNAPSHOT_OUTPUT)/,$(patsubst %.js,%.snapshot,$(notdir $(JS_SNAPSHOT_SOURCES))))
+CUSTOM_TARGETS		+= js-snapshots
+
+.PHONY: js-snapshots
+js-snapshots: $(JS_SNAPSHOT_FILES) ##Compile JavaScript snapshots
+
+define JsSnapshotTarget
+$(JS_SNAPSHOT_OUTPUT)/$(patsubst %.js,%.snapshot,$(notdir $1)): $1
+	@echo "JSC $$<"
+	$$(Q) mkdir -p $$(@D)
+	$$(Q) $$(JERRY_SNAPSHOT_TOOL) generate $$(JS_SNAPSHOT_FLAGS) -o $$@ $$<
+endef
+$(foreach f,$(JS_SNAPSHOT_SOURCES),$(eval $(call JsSnapshotTarget,$f)))
+endif
+
+# => Snapshot image partition
+HWCONFIG_BUILDSPECS += $(COMPONENT_PATH)/build.json
+
+# Target invoked via partition table
+ifneq (,$(filter jssnapshot,$(MAKECMDGOALS)))
+PART_TARGET := $(PARTITION_$(PART)_FILENAME)
+$(eval PART_FILES := $(call HwExpr,part.build['files']))
+PART_SOURCES := $(if $(PART_FILES),$(call ListAllFiles,$(PART_FILES),*.js))
+PART_TMPDIR := $(BUILD_BASE)/jssnapshot/$(PART)
+.PHONY: jssnapshot
+jssnapshot:
+ifneq (,$(PART_TARGET))
+	@echo "Creating JavaScript snapshot image '$(PART_TARGET)'"
+	$(Q) rm -rf $(PART_TMPDIR)
+	$(Q) mkdir -p $(PART_TMPDIR) $(dir $(PART_TARGET))
+	$(Q) $(foreach f,$(PART_SOURCES),$(JERRY_SNAPSHOT_TOOL) generate $(JS_SNAPSHOT_FLAGS) -o $(PART_TMPDIR)/$(basename $(notdir $f)).snapshot $f && ) true
+	$(Q) $(JS_SNAPPACK) --size $(PARTITION_$(PART)_SIZE_BYTES) -o $(PART_TARGET) $(PART_TMPDIR)
+endif
+endif
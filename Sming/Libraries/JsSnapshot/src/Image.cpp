@@ -0,0 +1,74 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/SmingHub/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * Image.cpp
+ *
+ ****/
+
+#include <JsSnapshot/Image.h>
+#include <debug_progmem.h>
+
+namespace JsSnapshot
+{
+bool Image::open(const Storage::Partition& partition)
+{
+	this->partition = Storage::Partition();
+	entryCount = 0;
+
+	Header header;
+	if(!partition || !Storage::Partition(partition).read(0, &header, sizeof(header))) {
+		return false;
+	}
+	if(header.magic != magic || header.version != version || header.size > partition.size() ||
+	   sizeof(Header) + header.count * sizeof(Entry) > header.size) {
+		debug_w("[JS] Partition '%s' has no valid snapshot image", partition.name().c_str());
+		return false;
+	}
+
+	this->partition = partition;
+	entryCount = header.count;
+	return true;
+}
+
+bool Image::readEntry(unsigned index, Entry& entry) const
+{
+	if(index >= entryCount) {
+		return false;
+	}
+	if(!Storage::Partition(partition).read(sizeof(Header) + index * sizeof(Entry), &entry, sizeof(entry))) {
+		return false;
+	}
+	entry.name[maxNameLength] = '\0';
+	return true;
+}
+
+String Image::getName(unsigned index) const
+{
+	Entry entry;
+	return readEntry(index, entry) ? String(entry.name) : nullptr;
+}
+
+View Image::operator[](unsigned index) const
+{
+	Entry entry;
+	if(!readEntry(index, entry)) {
+		return View();
+	}
+	return View::fromPartition(partition, entry.offset, entry.size);
+}
+
+View Image::find(const String& name) const
+{
+	Entry entry;
+	for(unsigned i = 0; i < entryCount; ++i) {
+		if(readEntry(i, entry) && name == entry.name) {
+			return View::fromPartition(partition, entry.offset, entry.size);
+		}
+	}
+	return View();
+}
+
+} // namespace JsSnapshot
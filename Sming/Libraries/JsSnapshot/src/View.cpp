@@ -0,0 +1,90 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/SmingHub/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * View.cpp
+ *
+ ****/
+
+#include <JsSnapshot/View.h>
+#include <Platform/Timers.h>
+#include <debug_progmem.h>
+#include <new>
+
+namespace JsSnapshot
+{
+View View::fromPartition(const Storage::Partition& partition, size_t offset, size_t size)
+{
+	if(!partition || (offset % 4) != 0 || size == 0 || offset >= partition.size() ||
+	   size > partition.size() - offset) {
+		return View();
+	}
+
+#ifndef ARCH_ESP8266
+	auto ptr = partition.getMappedPointer(offset, size);
+	if(ptr != nullptr) {
+		return View(ptr, size);
+	}
+#endif
+
+	View view;
+	if(view.load(nullptr, size) && Storage::Partition(partition).read(offset, view.buffer.get(), size)) {
+		return view;
+	}
+	return View();
+}
+
+View View::fromFlash(const FSTR::ObjectBase& object)
+{
+#ifdef ARCH_ESP8266
+	View view;
+	if(view.load(object.data(), object.size())) {
+		return view;
+	}
+	return View();
+#else
+	return View(object.data(), object.size());
+#endif
+}
+
+bool View::load(const void* src, size_t size)
+{
+	buffer.reset(new(std::nothrow) uint32_t[(size + 3) / 4]);
+	if(!buffer) {
+		return false;
+	}
+	if(src != nullptr) {
+		memcpy_P(buffer.get(), src, size);
+	}
+	data = buffer.get();
+	length = size;
+	return true;
+}
+
+jerry_value_t View::exec(size_t functionIndex) const
+{
+	if(data == nullptr) {
+		return jerry_create_error(JERRY_ERROR_COMMON, reinterpret_cast<const jerry_char_t*>("No snapshot"));
+	}
+
+	ElapseTimer timer;
+	auto res = jerry_exec_snapshot(data, length, functionIndex, JERRY_SNAPSHOT_EXEC_ALLOW_STATIC);
+	debug_d("[JS] Snapshot (%u bytes, %s) executed in %s", length, isMapped() ? _F("mapped") : _F("loaded"),
+			timer.elapsedTime().toString().c_str());
+	return res;
+}
+
+bool View::run(size_t functionIndex) const
+{
+	auto res = exec(functionIndex);
+	bool ok = !jerry_value_is_error(res);
+	if(!ok) {
+		debug_e("[JS] Snapshot execution failed");
+	}
+	jerry_release_value(res);
+	return ok;
+}
+
+} // namespace JsSnapshot
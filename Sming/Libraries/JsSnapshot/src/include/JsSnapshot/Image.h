@@ -0,0 +1,93 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/SmingHub/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * Image.h - Snapshot images stored in a partition
+ *
+ ****/
+
+#pragma once
+
+#include "View.h"
+#include <WString.h>
+
+namespace JsSnapshot
+{
+/**
+ * @brief A set of named snapshots packed into a partition by the `jssnapshot` build target
+ *
+ * Example:
+ *
+ * 		JsSnapshot::Image scripts;
+ * 		if(scripts.open(Storage::findPartition("scripts"))) {
+ * 			static auto view = scripts.find("main");
+ * 			view.run();
+ * 		}
+ */
+class Image
+{
+public:
+	static constexpr uint32_t magic{0x4953534A}; ///< "JSSI"
+	static constexpr uint32_t version{1};
+	static constexpr size_t maxNameLength{23};
+
+	/**
+	 * @brief Read and validate the image header
+	 * @retval bool false if the partition does not contain a valid image
+	 */
+	bool open(const Storage::Partition& partition);
+
+	explicit operator bool() const
+	{
+		return bool(partition);
+	}
+
+	/**
+	 * @brief Number of snapshots in the image
+	 */
+	unsigned count() const
+	{
+		return entryCount;
+	}
+
+	/**
+	 * @brief Get name of a snapshot, the script filename without extension
+	 */
+	String getName(unsigned index) const;
+
+	/**
+	 * @brief Get a snapshot by position
+	 */
+	View operator[](unsigned index) const;
+
+	/**
+	 * @brief Get a snapshot by name
+	 * @retval View Invalid if not found
+	 */
+	View find(const String& name) const;
+
+private:
+	struct Header {
+		uint32_t magic;
+		uint32_t version;
+		uint32_t count;
+		uint32_t size;
+	};
+
+	struct Entry {
+		char name[maxNameLength + 1];
+		uint32_t offset;
+		uint32_t size;
+	};
+
+	static_assert(sizeof(Entry) == 32, "Bad Entry size");
+
+	bool readEntry(unsigned index, Entry& entry) const;
+
+	Storage::Partition partition;
+	uint32_t entryCount{0};
+};
+
+} // namespace JsSnapshot
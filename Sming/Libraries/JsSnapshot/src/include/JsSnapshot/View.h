@@ -0,0 +1,116 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/SmingHub/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * View.h - Execute precompiled JerryScript snapshots in place
+ *
+ ****/
+
+#pragma once
+
+#include <jerryscript.h>
+#include <Storage/Partition.h>
+#include <FlashString/ObjectBase.hpp>
+#include <memory>
+
+namespace JsSnapshot
+{
+/**
+ * @brief Locates a JerryScript snapshot for execution without parsing
+ *
+ * Where the snapshot is memory-mapped, such as in a read-only partition or a FlashString,
+ * bytecode is executed directly from flash and only literals are allocated on the JavaScript heap.
+ * Otherwise, such as for a partition on an external device, the snapshot is loaded into RAM.
+ *
+ * The view must remain valid for as long as any functions defined by the script may be called,
+ * since the engine refers to the snapshot bytecode rather than copying it.
+ *
+ * Example:
+ *
+ * 		IMPORT_FSTR(mainSnapshot, JS_SNAPSHOT_OUTPUT "/main.snapshot")
+ *
+ * 		JsSnapshot::View mainScript = JsSnapshot::View::fromFlash(mainSnapshot);
+ *
+ * 		jerry_init(JERRY_INIT_EMPTY);
+ * 		mainScript.run();
+ *
+ * @note The ESP8266 cannot read single bytes from flash, so there snapshots are always loaded into RAM.
+ * This still avoids parsing, which is where most of the time and heap goes.
+ */
+class View
+{
+public:
+	View() = default;
+
+	/**
+	 * @brief Reference an existing snapshot, which must be word-aligned
+	 */
+	View(const void* data, size_t size) : data(static_cast<const uint32_t*>(data)), length(size)
+	{
+	}
+
+	View(View&&) = default;
+	View& operator=(View&&) = default;
+
+	/**
+	 * @brief Access a snapshot stored in a partition
+	 * @param partition
+	 * @param offset Start of snapshot within partition, must be a multiple of 4
+	 * @param size Size of snapshot
+	 * @retval View Invalid if partition cannot be read
+	 */
+	static View fromPartition(const Storage::Partition& partition, size_t offset, size_t size);
+
+	/**
+	 * @brief Access a snapshot stored as a FlashString, for example via IMPORT_FSTR
+	 * @note FlashString data is always word-aligned
+	 */
+	static View fromFlash(const FSTR::ObjectBase& object);
+
+	explicit operator bool() const
+	{
+		return data != nullptr;
+	}
+
+	const void* getData() const
+	{
+		return data;
+	}
+
+	size_t size() const
+	{
+		return length;
+	}
+
+	/**
+	 * @brief Determine whether snapshot is executed in place, or has been loaded into RAM
+	 */
+	bool isMapped() const
+	{
+		return data != nullptr && !buffer;
+	}
+
+	/**
+	 * @brief Execute the snapshot
+	 * @param functionIndex Index of function in a merged snapshot, 0 for a single script
+	 * @retval jerry_value_t Result of execution, which the caller must release
+	 */
+	jerry_value_t exec(size_t functionIndex = 0) const;
+
+	/**
+	 * @brief Execute the snapshot and discard the result
+	 * @retval bool false if the snapshot is invalid or the script threw an exception
+	 */
+	bool run(size_t functionIndex = 0) const;
+
+private:
+	bool load(const void* src, size_t size);
+
+	std::unique_ptr<uint32_t[]> buffer; ///< Used only if snapshot cannot be executed in place
+	const uint32_t* data{nullptr};
+	size_t length{0};
+};
+
+} // namespace JsSnapshot
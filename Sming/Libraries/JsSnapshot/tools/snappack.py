@@ -0,0 +1,70 @@
+#!/usr/bin/env python3
+#
+# Sming JsSnapshot image packer
+#
+# Combines JerryScript snapshot files into a single image for storing in a partition.
+#
+# Image layout (little-endian):
+#
+#   Header      magic 'JSSI', version, entry count, total size (4 x uint32)
+#   Index       one entry per snapshot: name (24 bytes, NUL-padded), offset, size (2 x uint32)
+#   Data        snapshot content, each starting on a 4-byte boundary
+#
+
+import argparse
+import os
+import struct
+import sys
+
+MAGIC = b'JSSI'
+VERSION = 1
+HEADER_FORMAT = '<4sIII'
+ENTRY_FORMAT = '<24sII'
+NAME_MAX = 23
+ALIGN = 4
+
+
+def align(value):
+    return (value + ALIGN - 1) & ~(ALIGN - 1)
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Pack JerryScript snapshots into a partition image')
+    parser.add_argument('-o', '--output', required=True, help='Image file to create')
+    parser.add_argument('--size', type=lambda x: int(x, 0), default=0, help='Maximum image size')
+    parser.add_argument('input', help='Directory containing .snapshot files')
+    args = parser.parse_args()
+
+    files = sorted(f for f in os.listdir(args.input) if f.endswith('.snapshot'))
+    snapshots = []
+    for f in files:
+        name = os.path.splitext(f)[0]
+        if len(name) > NAME_MAX:
+            raise ValueError("Snapshot name '%s' exceeds %u characters" % (name, NAME_MAX))
+        with open(os.path.join(args.input, f), 'rb') as fh:
+            snapshots.append((name, fh.read()))
+
+    offset = struct.calcsize(HEADER_FORMAT) + len(snapshots) * struct.calcsize(ENTRY_FORMAT)
+    index = b''
+    data = b''
+    for name, content in snapshots:
+        pos = align(offset + len(data))
+        data += b'\0' * (pos - offset - len(data))
+        index += struct.pack(ENTRY_FORMAT, name.encode(), pos, len(content))
+        data += content
+
+    image = struct.pack(HEADER_FORMAT, MAGIC, VERSION, len(snapshots), offset + len(data)) + index + data
+    if args.size and len(image) > args.size:
+        raise ValueError("Image size %u exceeds partition size %u" % (len(image), args.size))
+
+    with open(args.output, 'wb') as fh:
+        fh.write(image)
+    print("Packed %u snapshots, %u bytes" % (len(snapshots), len(image)))
+
+
+if __name__ == '__main__':
+    try:
+        main()
+    except Exception as e:
+        print("Error: %s" % e, file=sys.stderr)
+        sys.exit(1)
@@ -0,0 +1,562 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/SmingHub/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * KeyValueStore.cpp
+ *
+ ****/
+
+#include "KeyValueStore.h"
+#include <debug_progmem.h>
+#include <algorithm>
+#include <cstring>
+
+namespace
+{
+// Size of buffer used when comparing or copying entries
+constexpr size_t chunkSize{32};
+
+} // namespace
+
+uint32_t KeyValueStore::hash(const char* key, size_t length)
+{
+	// FNV-1a
+	uint32_t h{2166136261U};
+	while(length-- != 0) {
+		h = (h ^ uint8_t(*key++)) * 16777619U;
+	}
+	return h;
+}
+
+uint16_t KeyValueStore::crc16(uint16_t crc, const void* data, size_t length)
+{
+	// CRC-16/CCITT
+	auto p = static_cast<const uint8_t*>(data);
+	while(length-- != 0) {
+		crc ^= uint16_t(*p++) << 8;
+		for(unsigned i = 0; i < 8; ++i) {
+			crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : crc << 1;
+		}
+	}
+	return crc;
+}
+
+uint16_t KeyValueStore::headerCrc(const EntryHeader& hdr)
+{
+	// type, keyLength, reserved, valueLength
+	uint16_t crc = crc16(0xFFFF, &hdr.type, offsetof(EntryHeader, crc) - offsetof(EntryHeader, type));
+	return crc16(crc, &hdr.sequence, sizeof(hdr.sequence));
+}
+
+bool KeyValueStore::readSectorHeader(unsigned sector, SectorHeader& hdr)
+{
+	return partition.read(sectorAddress(sector), &hdr, sizeof(hdr)) && hdr.magic == SectorHeader::Magic;
+}
+
+int KeyValueStore::readEntryHeader(uint32_t address, uint32_t end, EntryHeader& hdr)
+{
+	if(address + sizeof(EntryHeader) > end) {
+		return 0;
+	}
+	if(!partition.read(address, &hdr, sizeof(hdr))) {
+		return -1;
+	}
+
+	auto p = reinterpret_cast<const uint8_t*>(&hdr);
+	if(std::all_of(p, p + sizeof(hdr), [](uint8_t c) { return c == 0xFF; })) {
+		return 0;
+	}
+
+	if(hdr.keyLength == 0 || hdr.keyLength > maxKeyLength) {
+		return -1;
+	}
+	auto size = entrySize(hdr);
+	if(address + size > end) {
+		return -1;
+	}
+	return size;
+}
+
+bool KeyValueStore::verifyEntry(uint32_t address, const EntryHeader& hdr)
+{
+	uint16_t crc = headerCrc(hdr);
+	uint8_t buffer[chunkSize];
+	address += sizeof(EntryHeader);
+	size_t remain = hdr.keyLength + hdr.valueLength;
+	while(remain != 0) {
+		auto n = std::min(remain, chunkSize);
+		if(!partition.read(address, buffer, n)) {
+			return false;
+		}
+		crc = crc16(crc, buffer, n);
+		address += n;
+		remain -= n;
+	}
+	return crc == hdr.crc;
+}
+
+bool KeyValueStore::valueEquals(uint32_t address, const EntryHeader& hdr, const void* value)
+{
+	uint8_t buffer[chunkSize];
+	address += sizeof(EntryHeader) + hdr.keyLength;
+	auto src = static_cast<const uint8_t*>(value);
+	size_t remain = hdr.valueLength;
+	while(remain != 0) {
+		auto n = std::min(remain, chunkSize);
+		if(!partition.read(address, buffer, n) || memcmp(buffer, src, n) != 0) {
+			return false;
+		}
+		address += n;
+		src += n;
+		remain -= n;
+	}
+	return true;
+}
+
+bool KeyValueStore::supersede(uint32_t address)
+{
+	uint8_t state{EntryHeader::stateSuperseded};
+	return partition.write(address + offsetof(EntryHeader, state), &state, sizeof(state));
+}
+
+int KeyValueStore::findSlot(const char* key, size_t keyLength, uint32_t hash, EntryKey* entry)
+{
+	EntryKey ek;
+	// Table is never more than half full so an empty slot is always found
+	for(unsigned i = hash & slotMask;; i = (i + 1) & slotMask) {
+		auto& slot = slots[i];
+		if(slot.address == Slot::empty) {
+			return -1;
+		}
+		if(slot.hash != hash) {
+			continue;
+		}
+		if(!partition.read(slot.address, &ek, sizeof(EntryHeader) + keyLength)) {
+			continue;
+		}
+		if(ek.hdr.keyLength == keyLength && memcmp(ek.key, key, keyLength) == 0) {
+			if(entry != nullptr) {
+				*entry = ek;
+			}
+			return i;
+		}
+	}
+}
+
+void KeyValueStore::insertSlot(uint32_t hash, uint32_t address)
+{
+	unsigned i = hash & slotMask;
+	while(slots[i].address != Slot::empty) {
+		i = (i + 1) & slotMask;
+	}
+	slots[i] = Slot{hash, address};
+}
+
+void KeyValueStore::removeSlot(unsigned index)
+{
+	// Backward-shift deletion keeps probe sequences intact without tombstones
+	unsigned i = index;
+	unsigned j = index;
+	for(;;) {
+		j = (j + 1) & slotMask;
+		if(slots[j].address == Slot::empty) {
+			break;
+		}
+		unsigned k = slots[j].hash & slotMask;
+		// Move entry back unless its home position lies cyclically within (i, j]
+		if((j > i) ? (k <= i || k > j) : (k <= i && k > j)) {
+			slots[i] = slots[j];
+			i = j;
+		}
+	}
+	slots[i].address = Slot::empty;
+}
+
+void KeyValueStore::indexEntry(uint32_t address, const EntryHeader& hdr)
+{
+	char key[maxKeyLength];
+	if(!partition.read(address + sizeof(EntryHeader), key, hdr.keyLength)) {
+		return;
+	}
+
+	auto h = hash(key, hdr.keyLength);
+	EntryKey existing;
+	int slot = findSlot(key, hdr.keyLength, h, &existing);
+	if(slot < 0) {
+		if(keyCount >= maxKeys) {
+			debug_w("[KVS] Index full, entry ignored");
+			return;
+		}
+		insertSlot(h, address);
+		++keyCount;
+		return;
+	}
+
+	// Interrupted update: keep the newer entry
+	if(hdr.sequence >= existing.hdr.sequence) {
+		supersede(slots[slot].address);
+		slots[slot].address = address;
+	} else {
+		supersede(address);
+	}
+}
+
+bool KeyValueStore::begin()
+{
+	sectorCount = 0;
+	keyCount = 0;
+	if(!partition) {
+		return false;
+	}
+
+	sectorSize = partition.getBlockSize();
+	auto count = std::min(partition.size() / sectorSize, size_t(0xFFFF));
+	if(count < 2 || sectorSize < sizeof(SectorHeader) + align(sizeof(EntryKey))) {
+		debug_e("[KVS] Partition '%s' unsuitable", partition.name().c_str());
+		return false;
+	}
+
+	unsigned slotCount{2};
+	while(slotCount < 2U * maxKeys) {
+		slotCount <<= 1;
+	}
+	slots.reset(new Slot[slotCount]);
+	if(!slots) {
+		return false;
+	}
+	for(unsigned i = 0; i < slotCount; ++i) {
+		slots[i].address = Slot::empty;
+	}
+	slotMask = slotCount - 1;
+	sectorCount = count;
+
+	// Locate newest and oldest sectors
+	usedSectors = 0;
+	uint32_t oldestSequence{0};
+	for(unsigned i = 0; i < sectorCount; ++i) {
+		SectorHeader hdr;
+		if(!readSectorHeader(i, hdr)) {
+			continue;
+		}
+		if(usedSectors == 0 || hdr.sequence > sectorSequence) {
+			headSector = i;
+			sectorSequence = hdr.sequence;
+		}
+		if(usedSectors == 0 || hdr.sequence < oldestSequence) {
+			oldestSector = i;
+			oldestSequence = hdr.sequence;
+		}
+		++usedSectors;
+	}
+
+	nextSequence = 0;
+	if(usedSectors == 0) {
+		headSector = sectorCount - 1;
+		writeOffset = sectorSize;
+		sectorSequence = 0;
+		return true;
+	}
+
+	// Index entries in order written
+	for(unsigned n = 0; n < sectorCount; ++n) {
+		unsigned sector = (oldestSector + n) % sectorCount;
+		SectorHeader sh;
+		if(!readSectorHeader(sector, sh)) {
+			continue;
+		}
+		uint32_t base = sectorAddress(sector);
+		uint32_t offset = sizeof(SectorHeader);
+		for(;;) {
+			EntryHeader hdr;
+			int size = readEntryHeader(base + offset, base + sectorSize, hdr);
+			if(size < 0) {
+				// Remainder of sector is unusable
+				debug_w("[KVS] Bad entry @ 0x%08x", base + offset);
+				offset = sectorSize;
+				break;
+			}
+			if(size == 0) {
+				break;
+			}
+			if(hdr.state == EntryHeader::stateValid && verifyEntry(base + offset, hdr)) {
+				indexEntry(base + offset, hdr);
+			}
+			if(hdr.sequence >= nextSequence) {
+				nextSequence = hdr.sequence + 1;
+			}
+			offset += size;
+		}
+		if(sector == headSector) {
+			writeOffset = offset;
+			break;
+		}
+	}
+
+	debug_d("[KVS] Mounted '%s', %u keys", partition.name().c_str(), keyCount);
+	return true;
+}
+
+bool KeyValueStore::format()
+{
+	if(sectorCount == 0 && !begin()) {
+		return false;
+	}
+
+	for(unsigned i = 0; i < sectorCount; ++i) {
+		SectorHeader hdr;
+		if(readSectorHeader(i, hdr)) {
+			if(!partition.erase_range(sectorAddress(i), sectorSize)) {
+				return false;
+			}
+			++eraseCount;
+		}
+	}
+
+	for(unsigned i = 0; i <= slotMask; ++i) {
+		slots[i].address = Slot::empty;
+	}
+	keyCount = 0;
+	usedSectors = 0;
+	writeOffset = sectorSize;
+	return true;
+}
+
+bool KeyValueStore::openSector()
+{
+	unsigned sector = (headSector + 1) % sectorCount;
+	if(!partition.erase_range(sectorAddress(sector), sectorSize)) {
+		debug_e("[KVS] Erase failed");
+		return false;
+	}
+	++eraseCount;
+
+	SectorHeader hdr{SectorHeader::Magic, sectorSequence + 1};
+	if(!partition.write(sectorAddress(sector), &hdr, sizeof(hdr))) {
+		debug_e("[KVS] Write failed");
+		return false;
+	}
+
+	++sectorSequence;
+	if(usedSectors == 0) {
+		oldestSector = sector;
+	}
+	++usedSectors;
+	headSector = sector;
+	writeOffset = sizeof(SectorHeader);
+	return true;
+}
+
+bool KeyValueStore::copyEntry(uint32_t from, uint32_t to, size_t size)
+{
+	uint8_t buffer[chunkSize];
+	while(size != 0) {
+		auto n = std::min(size, chunkSize);
+		if(!partition.read(from, buffer, n) || !partition.write(to, buffer, n)) {
+			return false;
+		}
+		from += n;
+		to += n;
+		size -= n;
+	}
+	return true;
+}
+
+bool KeyValueStore::compactOldest()
+{
+	unsigned source = oldestSector;
+	if(!openSector()) {
+		return false;
+	}
+
+	uint32_t base = sectorAddress(source);
+	uint32_t offset = sizeof(SectorHeader);
+	for(;;) {
+		EntryHeader hdr;
+		int size = readEntryHeader(base + offset, base + sectorSize, hdr);
+		if(size <= 0) {
+			break;
+		}
+		if(hdr.state == EntryHeader::stateValid) {
+			// Copy only if index refers to this entry
+			char key[maxKeyLength];
+			if(partition.read(base + offset + sizeof(EntryHeader), key, hdr.keyLength)) {
+				int slot = findSlot(key, hdr.keyLength, hash(key, hdr.keyLength));
+				if(slot >= 0 && slots[slot].address == base + offset) {
+					auto to = sectorAddress(headSector) + writeOffset;
+					if(writeOffset + size > sectorSize || !copyEntry(base + offset, to, size)) {
+						return false;
+					}
+					slots[slot].address = to;
+					writeOffset += size;
+				}
+			}
+		}
+		offset += size;
+	}
+
+	if(!partition.erase_range(base, sectorSize)) {
+		debug_e("[KVS] Erase failed");
+		return false;
+	}
+	++eraseCount;
+	oldestSector = (source + 1) % sectorCount;
+	--usedSectors;
+	return true;
+}
+
+bool KeyValueStore::allocate(size_t size)
+{
+	if(writeOffset + size <= sectorSize) {
+		return true;
+	}
+
+	// Each pass either opens a free sector or reclaims space from the oldest one
+	for(unsigned i = 0; i < sectorCount; ++i) {
+		if(usedSectors + 1 < sectorCount) {
+			if(!openSector()) {
+				return false;
+			}
+		} else if(!compactOldest()) {
+			return false;
+		}
+		if(writeOffset + size <= sectorSize) {
+			return true;
+		}
+	}
+
+	debug_w("[KVS] Store full");
+	return false;
+}
+
+bool KeyValueStore::set(const char* key, Type type, const void* value, size_t length)
+{
+	if(sectorCount == 0 || key == nullptr) {
+		return false;
+	}
+	auto keyLength = strlen(key);
+	if(keyLength == 0 || keyLength > maxKeyLength || length > 0xFFFF) {
+		return false;
+	}
+	auto size = align(sizeof(EntryHeader) + keyLength + length);
+	if(size > sectorSize - sizeof(SectorHeader)) {
+		return false;
+	}
+
+	auto h = hash(key, keyLength);
+	EntryKey existing;
+	int slot = findSlot(key, keyLength, h, &existing);
+	if(slot >= 0) {
+		if(existing.hdr.type == type && existing.hdr.valueLength == length &&
+		   valueEquals(slots[slot].address, existing.hdr, value)) {
+			return true;
+		}
+	} else if(keyCount >= maxKeys) {
+		debug_w("[KVS] Too many keys");
+		return false;
+	}
+
+	// Compaction may move entries, but doesn't change slot positions
+	if(!allocate(size)) {
+		return false;
+	}
+
+	EntryHeader hdr{EntryHeader::stateValid, type, uint8_t(keyLength), 0xFF, uint16_t(length), 0, nextSequence};
+	uint16_t crc = headerCrc(hdr);
+	crc = crc16(crc, key, keyLength);
+	hdr.crc = crc16(crc, value, length);
+
+	auto address = sectorAddress(headSector) + writeOffset;
+	if(!partition.write(address, &hdr, sizeof(hdr)) ||
+	   !partition.write(address + sizeof(hdr), key, keyLength) ||
+	   (length != 0 && !partition.write(address + sizeof(hdr) + keyLength, value, length))) {
+		// Entry may be partially written, so don't use this sector again
+		debug_e("[KVS] Write failed");
+		writeOffset = sectorSize;
+		++nextSequence;
+		return false;
+	}
+	writeOffset += size;
+	++nextSequence;
+
+	if(slot >= 0) {
+		supersede(slots[slot].address);
+		slots[slot].address = address;
+	} else {
+		insertSlot(h, address);
+		++keyCount;
+	}
+	return true;
+}
+
+int KeyValueStore::get(const char* key, Type type, void* buffer, size_t bufSize)
+{
+	if(sectorCount == 0 || key == nullptr) {
+		return -1;
+	}
+	auto keyLength = strlen(key);
+	if(keyLength == 0 || keyLength > maxKeyLength) {
+		return -1;
+	}
+
+	EntryKey ek;
+	int slot = findSlot(key, keyLength, hash(key, keyLength), &ek);
+	if(slot < 0 || ek.hdr.type != type) {
+		return -1;
+	}
+
+	auto n = std::min(size_t(ek.hdr.valueLength), bufSize);
+	if(n != 0 && !partition.read(slots[slot].address + sizeof(EntryHeader) + keyLength, buffer, n)) {
+		return -1;
+	}
+	return ek.hdr.valueLength;
+}
+
+String KeyValueStore::getString(const String& key, const String& defaultValue)
+{
+	Type type;
+	size_t length;
+	if(!getType(key, type, length) || type != Type::string) {
+		return defaultValue;
+	}
+
+	String s;
+	if(!s.setLength(length)) {
+		return defaultValue;
+	}
+	if(get(key.c_str(), Type::string, s.begin(), length) != int(length)) {
+		return defaultValue;
+	}
+	return s;
+}
+
+bool KeyValueStore::getType(const String& key, Type& type, size_t& length)
+{
+	if(sectorCount == 0 || key.length() == 0 || key.length() > maxKeyLength) {
+		return false;
+	}
+
+	EntryKey ek;
+	if(findSlot(key.c_str(), key.length(), hash(key.c_str(), key.length()), &ek) < 0) {
+		return false;
+	}
+	type = ek.hdr.type;
+	length = ek.hdr.valueLength;
+	return true;
+}
+
+bool KeyValueStore::remove(const String& key)
+{
+	if(sectorCount == 0 || key.length() == 0 || key.length() > maxKeyLength) {
+		return false;
+	}
+
+	int slot = findSlot(key.c_str(), key.length(), hash(key.c_str(), key.length()));
+	if(slot < 0 || !supersede(slots[slot].address)) {
+		return false;
+	}
+	removeSlot(slot);
+	--keyCount;
+	return true;
+}
@@ -0,0 +1,277 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/SmingHub/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * KeyValueStore.h - Typed key/value storage directly on a flash partition
+ *
+ ****/
+
+#pragma once
+
+#include <Storage/Partition.h>
+#include <WString.h>
+#include <memory>
+#include <cstddef>
+#include <type_traits>
+
+/**
+ * @brief Stores typed values by name in a partition without using a filesystem
+ *
+ * Entries are appended to a ring of erase blocks (sectors), so changing a value writes only that entry.
+ * The previous entry is then marked as superseded. If power is lost in between, both entries are
+ * present on the next mount and the one with the higher sequence number is used.
+ *
+ * One sector is always kept free. When space runs out, entries still in use are copied out of the
+ * oldest sector into the free one before the oldest sector is erased. Nothing is erased until it has
+ * been copied, so an interrupted update never loses data.
+ *
+ * A hash table of key locations is built in RAM at mount, so `get()` requires a lookup and a single
+ * flash read to find an entry.
+ *
+ * @note All methods must be called from task context.
+ */
+class KeyValueStore
+{
+public:
+	enum class Type : uint8_t {
+		blob = 0x01,
+		string = 0x02,
+		signedInt = 0x10,
+		unsignedInt = 0x11,
+		floatingPoint = 0x12,
+		boolean = 0x13,
+	};
+
+	static constexpr size_t maxKeyLength{31};
+	static constexpr uint16_t defaultMaxKeys{64};
+
+	/**
+	 * @brief Constructor
+	 * @param partition Must contain at least two erase blocks
+	 * @param maxKeys Maximum number of keys stored. Sets the size of the RAM index, 16 bytes per key.
+	 */
+	KeyValueStore(Storage::Partition partition, uint16_t maxKeys = defaultMaxKeys)
+		: partition(partition), maxKeys(maxKeys)
+	{
+	}
+
+	/**
+	 * @brief Build index from the partition content
+	 * @retval bool false if partition is unsuitable
+	 * @note An unformatted partition is treated as an empty store
+	 */
+	bool begin();
+
+	/**
+	 * @brief Erase all entries
+	 */
+	bool format();
+
+	/**
+	 * @brief Store a value
+	 * @param key Up to `maxKeyLength` characters
+	 * @param type
+	 * @param value
+	 * @param length
+	 * @retval bool false if the store is full or a write failed, in which case the previous value is retained
+	 */
+	bool set(const char* key, Type type, const void* value, size_t length);
+
+	/**
+	 * @brief Read a value
+	 * @param key
+	 * @param type Must match type of stored value
+	 * @param buffer
+	 * @param bufSize
+	 * @retval int Length of stored value which may be more than bufSize, or -1 if not found
+	 */
+	int get(const char* key, Type type, void* buffer, size_t bufSize);
+
+	template <typename T> typename std::enable_if<std::is_arithmetic<T>::value, bool>::type set(const String& key, T value)
+	{
+		return set(key.c_str(), typeOf<T>(), &value, sizeof(value));
+	}
+
+	bool set(const String& key, const String& value)
+	{
+		return set(key.c_str(), Type::string, value.c_str(), value.length());
+	}
+
+	bool set(const String& key, const char* value)
+	{
+		return set(key.c_str(), Type::string, value, value ? strlen(value) : 0);
+	}
+
+	/**
+	 * @brief Read a numeric or boolean value
+	 * @param key
+	 * @param defaultValue Returned if key not found, or stored value has a different type or size
+	 */
+	template <typename T>
+	typename std::enable_if<std::is_arithmetic<T>::value, T>::type get(const String& key, T defaultValue = {})
+	{
+		T value;
+		return (get(key.c_str(), typeOf<T>(), &value, sizeof(value)) == sizeof(value)) ? value : defaultValue;
+	}
+
+	String getString(const String& key, const String& defaultValue = nullptr);
+
+	/**
+	 * @brief Get type of stored value
+	 * @retval bool false if key not found
+	 */
+	bool getType(const String& key, Type& type, size_t& length);
+
+	bool contains(const String& key)
+	{
+		Type type;
+		size_t length;
+		return getType(key, type, length);
+	}
+
+	/**
+	 * @brief Remove a key
+	 * @retval bool false if key not found or write failed
+	 */
+	bool remove(const String& key);
+
+	/**
+	 * @brief Number of keys stored
+	 */
+	unsigned count() const
+	{
+		return keyCount;
+	}
+
+	/**
+	 * @brief Total number of sector erases performed by this instance, including compaction
+	 */
+	uint32_t getEraseCount() const
+	{
+		return eraseCount;
+	}
+
+	template <typename T> static constexpr Type typeOf()
+	{
+		return std::is_same<T, bool>::value			? Type::boolean
+			   : std::is_floating_point<T>::value ? Type::floatingPoint
+			   : std::is_signed<T>::value		  ? Type::signedInt
+												  : Type::unsignedInt;
+	}
+
+private:
+	struct SectorHeader {
+		static constexpr uint32_t Magic{0x5356564B}; // "KVVS"
+
+		uint32_t magic;
+		uint32_t sequence; ///< Increases with each sector brought into use
+	};
+
+	struct EntryHeader {
+		static constexpr uint8_t stateValid{0xFF};
+		static constexpr uint8_t stateSuperseded{0x00};
+
+		uint8_t state;
+		Type type;
+		uint8_t keyLength;
+		uint8_t reserved; ///< Left erased
+		uint16_t valueLength;
+		uint16_t crc;	  ///< Of all fields following, the key and value
+		uint32_t sequence; ///< Increases with each entry written
+	};
+
+	/**
+	 * @brief Header plus key, read together for lookups
+	 */
+	struct EntryKey {
+		EntryHeader hdr;
+		char key[maxKeyLength];
+	};
+
+	struct Slot {
+		static constexpr uint32_t empty{0xFFFFFFFF};
+
+		uint32_t hash;
+		uint32_t address; ///< Of entry within partition
+	};
+
+	static constexpr size_t align(size_t length)
+	{
+		return (length + 3) & ~3U;
+	}
+
+	static size_t entrySize(const EntryHeader& hdr)
+	{
+		return align(sizeof(EntryHeader) + hdr.keyLength + hdr.valueLength);
+	}
+
+	static uint32_t hash(const char* key, size_t length);
+	static uint16_t crc16(uint16_t crc, const void* data, size_t length);
+	static uint16_t headerCrc(const EntryHeader& hdr);
+
+	uint32_t sectorAddress(unsigned sector) const
+	{
+		return sector * sectorSize;
+	}
+
+	bool readSectorHeader(unsigned sector, SectorHeader& hdr);
+
+	/**
+	 * @brief Read and validate an entry header
+	 * @retval int Size of entry, 0 at end of sector, -1 if corrupt
+	 */
+	int readEntryHeader(uint32_t address, uint32_t end, EntryHeader& hdr);
+
+	bool verifyEntry(uint32_t address, const EntryHeader& hdr);
+	bool valueEquals(uint32_t address, const EntryHeader& hdr, const void* value);
+
+	bool supersede(uint32_t address);
+
+	/**
+	 * @brief Find index slot for key
+	 * @retval int -1 if not found
+	 */
+	int findSlot(const char* key, size_t keyLength, uint32_t hash, EntryKey* entry = nullptr);
+
+	void insertSlot(uint32_t hash, uint32_t address);
+	void removeSlot(unsigned index);
+
+	/**
+	 * @brief Add entry found at mount to index, resolving duplicates
+	 */
+	void indexEntry(uint32_t address, const EntryHeader& hdr);
+
+	/**
+	 * @brief Ensure there is space in head sector for a new entry
+	 */
+	bool allocate(size_t size);
+
+	/**
+	 * @brief Erase and bring into use the sector following the head
+	 */
+	bool openSector();
+
+	/**
+	 * @brief Copy entries in use from oldest sector into head, then erase it
+	 */
+	bool compactOldest();
+
+	bool copyEntry(uint32_t from, uint32_t to, size_t size);
+
+	Storage::Partition partition;
+	std::unique_ptr<Slot[]> slots;
+	uint32_t sectorSize{0};
+	uint32_t writeOffset{0}; ///< Position for next entry in head sector
+	uint32_t nextSequence{0};
+	uint32_t sectorSequence{0};
+	uint32_t eraseCount{0};
+	uint16_t maxKeys;
+	uint16_t slotMask{0};
+	uint16_t keyCount{0};
+	uint16_t sectorCount{0};
+	uint16_t oldestSector{0};
+	uint16_t headSector{0};
+	uint16_t usedSectors{0};
+};
@@ -0,0 +1,213 @@
+#include <SmingTest.h>
+#include <KeyValueStore.h>
+#include <Storage/CustomDevice.h>
+
+namespace
+{
+/*
+ * RAM-backed device with NOR flash semantics
+ */
+class FlashDevice : public Storage::CustomDevice
+{
+public:
+	static constexpr size_t size{2048};
+	static constexpr size_t blockSize{512};
+
+	FlashDevice()
+	{
+		memset(data, 0xff, size);
+	}
+
+	String getName() const override
+	{
+		return F("flashDevice");
+	}
+
+	size_t getBlockSize() const override
+	{
+		return blockSize;
+	}
+
+	size_t getSize() const override
+	{
+		return size;
+	}
+
+	Type getType() const override
+	{
+		return Type::flash;
+	}
+
+	bool read(uint32_t address, void* dst, size_t len) override
+	{
+		if(address + len > size) {
+			return false;
+		}
+		memcpy(dst, &data[address], len);
+		return true;
+	}
+
+	bool write(uint32_t address, const void* src, size_t len) override
+	{
+		if(address + len > size) {
+			return false;
+		}
+		auto p = static_cast<const uint8_t*>(src);
+		for(unsigned i = 0; i < len; ++i) {
+			data[address + i] &= p[i];
+		}
+		return true;
+	}
+
+	bool erase_range(uint32_t address, size_t len) override
+	{
+		if(address + len > size) {
+			return false;
+		}
+		memset(&data[address], 0xff, len);
+		++erases[address / blockSize];
+		return true;
+	}
+
+	uint8_t data[size];
+	unsigned erases[size / blockSize]{};
+};
+
+} // namespace
+
+class KeyValueStoreTest : public TestGroup
+{
+public:
+	KeyValueStoreTest() : TestGroup(_F("KeyValueStore"))
+	{
+	}
+
+	void execute() override
+	{
+		FlashDevice flash;
+		auto part = flash.createPartition(F("config"), Storage::Partition::Type::data, 0x92, 0, flash.size);
+
+		TEST_CASE("Typed values")
+		{
+			KeyValueStore store(part, 16);
+			REQUIRE(store.begin());
+			REQUIRE_EQ(store.count(), 0);
+			REQUIRE(store.set("ssid", "MyNetwork"));
+			REQUIRE(store.set("port", uint16_t(8080)));
+			REQUIRE(store.set("offset", -12));
+			REQUIRE(store.set("gain", 1.5f));
+			REQUIRE(store.set("enabled", true));
+			REQUIRE_EQ(store.count(), 5);
+
+			REQUIRE_EQ(store.getString("ssid"), "MyNetwork");
+			REQUIRE_EQ(store.get<uint16_t>("port"), 8080);
+			REQUIRE_EQ(store.get<int>("offset"), -12);
+			REQUIRE(store.get<float>("gain") == 1.5f);
+			REQUIRE(store.get<bool>("enabled"));
+
+			// Type and size must match
+			REQUIRE_EQ(store.get<uint32_t>("port", 1), 1);
+			REQUIRE_EQ(store.get<int>("ssid", -1), -1);
+			REQUIRE_EQ(store.getString("missing", "none"), "none");
+
+			uint8_t blob[]{1, 2, 3, 4, 5};
+			REQUIRE(store.set("blob", KeyValueStore::Type::blob, blob, sizeof(blob)));
+			uint8_t buffer[8]{};
+			REQUIRE_EQ(store.get("blob", KeyValueStore::Type::blob, buffer, sizeof(buffer)), int(sizeof(blob)));
+			REQUIRE(memcmp(buffer, blob, sizeof(blob)) == 0);
+		}
+
+		TEST_CASE("Update and remove")
+		{
+			KeyValueStore store(part, 16);
+			REQUIRE(store.begin());
+			REQUIRE_EQ(store.count(), 6);
+			REQUIRE_EQ(store.getString("ssid"), "MyNetwork");
+
+			// Unchanged value isn't written again
+			auto erases = flash.erases[0] + flash.erases[1] + flash.erases[2] + flash.erases[3];
+			REQUIRE(store.set("port", uint16_t(8080)));
+			REQUIRE(store.set("ssid", "OtherNetwork"));
+			REQUIRE(store.remove("offset"));
+			REQUIRE(!store.remove("offset"));
+			REQUIRE_EQ(store.count(), 5);
+
+			KeyValueStore store2(part, 16);
+			REQUIRE(store2.begin());
+			REQUIRE_EQ(store2.count(), 5);
+			REQUIRE_EQ(store2.getString("ssid"), "OtherNetwork");
+			REQUIRE(!store2.contains("offset"));
+			REQUIRE_EQ(flash.erases[0] + flash.erases[1] + flash.erases[2] + flash.erases[3], erases);
+		}
+
+		TEST_CASE("Compaction")
+		{
+			KeyValueStore store(part, 16);
+			REQUIRE(store.begin());
+			for(unsigned i = 0; i < 500; ++i) {
+				REQUIRE(store.set(F("counter") + (i % 4), i));
+			}
+			debug_i("Erase count %u", store.getEraseCount());
+			REQUIRE(store.getEraseCount() > 4);
+			for(unsigned i = 0; i < 4; ++i) {
+				REQUIRE_EQ(store.get<unsigned>(F("counter") + i), 496 + i);
+			}
+			REQUIRE_EQ(store.getString("ssid"), "OtherNetwork");
+
+			KeyValueStore store2(part, 16);
+			REQUIRE(store2.begin());
+			REQUIRE_EQ(store2.count(), 9);
+			REQUIRE_EQ(store2.get<unsigned>("counter3"), 499);
+			REQUIRE(store2.get<bool>("enabled"));
+		}
+
+		TEST_CASE("Store full")
+		{
+			KeyValueStore store(part, 16);
+			REQUIRE(store.format());
+			String value;
+			REQUIRE(value.setLength(400));
+			memset(value.begin(), 'x', value.length());
+			unsigned count{0};
+			while(store.set(String(count), value)) {
+				++count;
+			}
+			REQUIRE_EQ(count, 3);
+			// Existing values are intact
+			REQUIRE_EQ(store.getString("0"), value);
+			REQUIRE(store.remove("0"));
+			REQUIRE(store.set("new", value));
+		}
+
+		TEST_CASE("Interrupted update")
+		{
+			KeyValueStore store(part, 16);
+			REQUIRE(store.format());
+			REQUIRE(store.set("mode", 1));
+			REQUIRE(store.set("mode", 2));
+
+			// Restore superseded flag on first entry, as if power failed before it was written
+			auto name = "mode";
+			auto pos = std::search(flash.data, flash.data + flash.size, name, name + 4);
+			REQUIRE(pos != flash.data + flash.size);
+			pos[-12] = 0xFF;
+			REQUIRE(store.begin());
+			REQUIRE_EQ(store.count(), 1);
+			REQUIRE_EQ(store.get<int>("mode"), 2);
+
+			// Incomplete write of second entry: first is retained
+			pos[-12] = 0xFF;
+			auto pos2 = std::search(pos + 4, flash.data + flash.size, name, name + 4);
+			REQUIRE(pos2 != flash.data + flash.size);
+			pos2[4] = 0;
+			REQUIRE(store.begin());
+			REQUIRE_EQ(store.count(), 1);
+			REQUIRE_EQ(store.get<int>("mode"), 1);
+		}
+	}
+};
+
+void REGISTER_TEST(KeyValueStore)
+{
+	registerGroup<KeyValueStoreTest>();
+}
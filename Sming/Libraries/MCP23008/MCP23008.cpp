@@ -23,6 +23,8 @@
 //	uint8_t readINTCAP();					// Read INTCAP register
 //	uint8_t readGPIO();						// Read GPIO register
 //	uint8_t readOLAT();						// Read OLAT register
+//	void readRegisters(uint8_t Register, uint8_t* Buffer, uint8_t Count);
+//	void readInterrupt(uint8_t& Flags, uint8_t& Captured);
 //
 //	void writebyte(uint8_t Address, uint8_t Register, uint8_t Value);
 //	uint8_t readbyte(uint8_t Address, uint8_t Register);
@@ -435,3 +437,44 @@ uint8_t MCP23008::readOLAT()
 {
   return readbyte(_ADDR, regOLAT);
 }
+
+// readRegisters
+//------------------------------------------------------------------------------
+// Reads consecutive MCP23008 registers in a single transaction.
+// Requires sequential operation to be enabled (IOCON bit 5 clear, the default).
+//
+// Parameter	Description
+//------------------------------------------------------------------------------
+// Register		First register to read
+// Buffer		Receives register values
+// Count		Number of registers to read
+
+void MCP23008::readRegisters(uint8_t Register, uint8_t* Buffer, uint8_t Count)
+{
+  Wire.beginTransmission(_ADDR);
+  Wire.write(Register);
+  Wire.endTransmission();
+  Wire.requestFrom((char)_ADDR,Count);
+  for(uint8_t i=0;i<Count;i++)
+  {
+    Buffer[i] = Wire.read();
+  }
+}
+
+// readInterrupt
+//------------------------------------------------------------------------------
+// Reads the MCP23008 INTF and INTCAP registers in a single transaction.
+// Reading INTCAP clears the interrupt condition.
+//
+// Parameter	Description
+//------------------------------------------------------------------------------
+// Flags		Interrupt Flag Register (0=No Interrupt; 1=Caused Interrupt)
+// Captured		Interrupt Capture Register (0=Logic Low; 1=Logic High)
+
+void MCP23008::readInterrupt(uint8_t& Flags, uint8_t& Captured)
+{
+  uint8_t buf[2];
+  readRegisters(regINTF, buf, 2);
+  Flags = buf[0];
+  Captured = buf[1];
+}
@@ -48,6 +48,9 @@ class MCP23008
 	uint8_t readINTCAP();					// Read INTCAP register
 	uint8_t readGPIO();						// Read GPIO register
 	uint8_t readOLAT();						// Read OLAT register
+
+	void readRegisters(uint8_t Register, uint8_t* Buffer, uint8_t Count);	// Read consecutive registers
+	void readInterrupt(uint8_t& Flags, uint8_t& Captured);	// Read INTF and INTCAP registers
 	
   private:
 
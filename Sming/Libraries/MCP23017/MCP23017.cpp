@@ -88,21 +88,123 @@ void MCP23017::writeRegister(uint8_t regAddr, uint8_t regValue){
 }
 
 
+/**
+ * Writes consecutive registers, using the address auto-increment
+ */
+void MCP23017::writeRegisters(uint8_t regAddr, const uint8_t* values, uint8_t count){
+	Wire.beginTransmission(MCP23017_ADDRESS | i2caddr);
+	wiresend(regAddr);
+	for(uint8_t i=0;i<count;i++) wiresend(values[i]);
+	Wire.endTransmission();
+}
+
+/**
+ * Reads consecutive registers, using the address auto-increment
+ */
+void MCP23017::readRegisters(uint8_t regAddr, uint8_t* buffer, uint8_t count){
+	Wire.beginTransmission(MCP23017_ADDRESS | i2caddr);
+	wiresend(regAddr);
+	Wire.endTransmission();
+	Wire.requestFrom(MCP23017_ADDRESS | i2caddr, count);
+	for(uint8_t i=0;i<count;i++) buffer[i]=wirerecv();
+}
+
+/**
+ * Determine if a register is held in the cache.
+ * Flag, capture and port registers change independently so are always read from the device.
+ * Writes to GPIO are made via OLAT instead.
+ */
+bool MCP23017::isCached(uint8_t regAddr){
+	return regAddr<cacheSize && (regAddr<MCP23017_INTFA || regAddr>MCP23017_GPIOB);
+}
+
+/**
+ * Get register value, from the cache if possible
+ */
+uint8_t MCP23017::getRegister(uint8_t regAddr){
+	return isCached(regAddr) ? regCache[regAddr] : readRegister(regAddr);
+}
+
+/**
+ * Set register value. Cached registers are only written if changed,
+ * and are deferred if an update is in progress.
+ */
+void MCP23017::setRegister(uint8_t regAddr, uint8_t regValue){
+	if(!isCached(regAddr)) {
+		writeRegister(regAddr,regValue);
+		return;
+	}
+
+	if(regCache[regAddr]==regValue) {
+		return;
+	}
+
+	regCache[regAddr]=regValue;
+	// IOCONA and IOCONB both access the same register
+	if(regAddr==MCP23017_IOCONA || regAddr==MCP23017_IOCONB) {
+		regCache[MCP23017_IOCONA]=regCache[MCP23017_IOCONB]=regValue;
+	}
+
+	if(updateLevel!=0) {
+		bitSet(dirtyMask,regAddr);
+	} else {
+		writeRegister(regAddr,regValue);
+	}
+}
+
+/**
+ * Write all modified registers, as few transactions as possible
+ */
+void MCP23017::flush(){
+	uint8_t regAddr=0;
+	while(dirtyMask!=0) {
+		while(!bitRead(dirtyMask,regAddr)) regAddr++;
+		uint8_t count=0;
+		while(bitRead(dirtyMask,regAddr+count)) {
+			bitClear(dirtyMask,regAddr+count);
+			count++;
+		}
+		writeRegisters(regAddr,&regCache[regAddr],count);
+		regAddr+=count;
+	}
+}
+
+void MCP23017::beginUpdate(){
+	updateLevel++;
+}
+
+void MCP23017::endUpdate(){
+	if(updateLevel==0) {
+		return;
+	}
+	if(--updateLevel==0) {
+		flush();
+	}
+}
+
+/**
+ * Loads all registers in a single transaction
+ */
+void MCP23017::refreshCache(){
+	readRegisters(0,regCache,cacheSize);
+	dirtyMask=0;
+}
+
 /**
  * Helper to update a single bit of an A/B register.
- * - Reads the current register value
- * - Writes the new register value
+ * - Gets the current register value from the cache
+ * - Writes the new register value if it has changed
  */
 void MCP23017::updateRegisterBit(uint8_t pin, uint8_t pValue, uint8_t portAaddr, uint8_t portBaddr) {
 	uint8_t regValue;
 	uint8_t regAddr=regForPin(pin,portAaddr,portBaddr);
 	uint8_t bit=bitForPin(pin);
-	regValue = readRegister(regAddr);
+	regValue = getRegister(regAddr);
 
 	// set the value for the particular bit
 	bitWrite(regValue,bit,pValue);
 
-	writeRegister(regAddr,regValue);
+	setRegister(regAddr,regValue);
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -118,10 +220,13 @@ void MCP23017::begin(uint8_t addr) {
 
 	Wire.begin();
 
+	updateLevel=0;
+	refreshCache();
+
 	// set defaults!
 	// all inputs on port A and B
-	writeRegister(MCP23017_IODIRA,0xff);
-	writeRegister(MCP23017_IODIRB,0xff);
+	regCache[MCP23017_IODIRA]=regCache[MCP23017_IODIRB]=0xff;
+	writeRegisters(MCP23017_IODIRA,&regCache[MCP23017_IODIRA],2);
 }
 
 /**
@@ -182,11 +287,17 @@ uint8_t MCP23017::readGPIO(uint8_t b) {
  * Writes all the pins in one go. This method is very useful if you are implementing a multiplexed matrix and want to get a decent refresh rate.
  */
 void MCP23017::writeGPIOAB(uint16_t ba) {
-	Wire.beginTransmission(MCP23017_ADDRESS | i2caddr);
-	wiresend(MCP23017_GPIOA);
-	wiresend(ba & 0xFF);
-	wiresend(ba >> 8);
-	Wire.endTransmission();
+	beginUpdate();
+	setRegister(MCP23017_OLATA,ba & 0xFF);
+	setRegister(MCP23017_OLATB,ba >> 8);
+	endUpdate();
+}
+
+/**
+ * Write a single port, A or B. Parameter b should be 0 for GPIOA, and 1 for GPIOB.
+ */
+void MCP23017::writeGPIO(uint8_t b, uint8_t value) {
+	setRegister((b == 0) ? MCP23017_OLATA : MCP23017_OLATB,value);
 }
 
 void MCP23017::digitalWrite(uint8_t pin, uint8_t d) {
@@ -194,16 +305,15 @@ void MCP23017::digitalWrite(uint8_t pin, uint8_t d) {
 	uint8_t bit=bitForPin(pin);
 
 
-	// read the current GPIO output latches
+	// get the current GPIO output latches
 	uint8_t regAddr=regForPin(pin,MCP23017_OLATA,MCP23017_OLATB);
-	gpio = readRegister(regAddr);
+	gpio = getRegister(regAddr);
 
 	// set the pin and direction
 	bitWrite(gpio,bit,d);
 
 	// write the new GPIO
-	regAddr=regForPin(pin,MCP23017_GPIOA,MCP23017_GPIOB);
-	writeRegister(regAddr,gpio);
+	setRegister(regAddr,gpio);
 }
 
 void MCP23017::pullUp(uint8_t p, uint8_t d) {
@@ -264,28 +374,30 @@ void MCP23017::setupInterruptPin(uint8_t pin, uint8_t mode) {
 }
 
 uint8_t MCP23017::getLastInterruptPin(){
-	uint8_t intf;
+	uint8_t intf[2];
+	readRegisters(MCP23017_INTFA,intf,2);
 
-	// try port A
-	intf=readRegister(MCP23017_INTFA);
-	for(int i=0;i<8;i++) if (bitRead(intf,i)) return i;
-
-	// try port B
-	intf=readRegister(MCP23017_INTFB);
-	for(int i=0;i<8;i++) if (bitRead(intf,i)) return i+8;
+	uint16_t flags=(intf[1] << 8) | intf[0];
+	for(int i=0;i<16;i++) if (bitRead(flags,i)) return i;
 
 	return MCP23017_INT_ERR;
 
 }
 uint8_t MCP23017::getLastInterruptPinValue(){
-	uint8_t intPin=getLastInterruptPin();
-	if(intPin!=MCP23017_INT_ERR){
-		uint8_t intcapreg=regForPin(intPin,MCP23017_INTCAPA,MCP23017_INTCAPB);
-		uint8_t bit=bitForPin(intPin);
-		return (readRegister(intcapreg)>>bit) & (0x01);
-	}
+	uint16_t flags, captured;
+	readInterrupt(flags,captured);
+
+	for(int i=0;i<16;i++) if (bitRead(flags,i)) return bitRead(captured,i);
 
 	return MCP23017_INT_ERR;
 }
 
+void MCP23017::readInterrupt(uint16_t& flags, uint16_t& captured){
+	// INTFA, INTFB, INTCAPA, INTCAPB
+	uint8_t buf[4];
+	readRegisters(MCP23017_INTFA,buf,4);
+	flags=(buf[1] << 8) | buf[0];
+	captured=(buf[3] << 8) | buf[2];
+}
+
 
@@ -32,26 +32,63 @@ public:
   uint8_t digitalRead(uint8_t p);
 
   void writeGPIOAB(uint16_t);
+  void writeGPIO(uint8_t b, uint8_t value);
   uint16_t readGPIOAB();
   uint8_t readGPIO(uint8_t b);
 
+  /**
+   * Defer register writes until endUpdate() is called.
+   * Calls may be nested: writes are made by the outermost endUpdate().
+   */
+  void beginUpdate();
+  void endUpdate();
+
+  /**
+   * Read consecutive registers in a single transaction
+   */
+  void readRegisters(uint8_t addr, uint8_t* buffer, uint8_t count);
+
+  /**
+   * Re-read all configuration and output latch registers from the device,
+   * in case they have been changed other than through this class.
+   */
+  void refreshCache();
+
   void setupInterrupts(uint8_t mirroring, uint8_t open, uint8_t polarity);
   void setupInterruptPin(uint8_t p, uint8_t mode);
   uint8_t getLastInterruptPin();
   uint8_t getLastInterruptPinValue();
 
+  /**
+   * Read interrupt flags and captured port values for both ports in a single transaction.
+   * Reading INTCAP clears the interrupt condition.
+   * Bits 0-7 are for port A, 8-15 for port B.
+   */
+  void readInterrupt(uint16_t& flags, uint16_t& captured);
+
  private:
+  static constexpr uint8_t cacheSize{0x16};
+
   uint8_t i2caddr;
+  uint8_t updateLevel{0};
+  uint32_t dirtyMask{0};
+  uint8_t regCache[cacheSize]{}; ///< Shadow copy of registers, see isCached()
+
+  static bool isCached(uint8_t addr);
+  uint8_t getRegister(uint8_t addr);
+  void setRegister(uint8_t addr, uint8_t value);
+  void flush();
 
   uint8_t bitForPin(uint8_t pin);
   uint8_t regForPin(uint8_t pin, uint8_t portAaddr, uint8_t portBaddr);
 
   uint8_t readRegister(uint8_t addr);
   void writeRegister(uint8_t addr, uint8_t value);
+  void writeRegisters(uint8_t addr, const uint8_t* values, uint8_t count);
 
   /**
    * Utility private method to update a register associated with a pin (whether port A/B)
-   * reads its value, updates the particular bit, and writes its value.
+   * updates the particular bit of the cached value, and writes its value if changed.
    */
   void updateRegisterBit(uint8_t p, uint8_t pValue, uint8_t portAaddr, uint8_t portBaddr);
 
@@ -11,7 +11,9 @@
  Output write
  Input read
 
- Interrupt features are not implemented in this version
+ Interrupt configuration and capture
+ Batched updates: writes are deferred between beginUpdate() and endUpdate()
+
  byte based (portA, portB) functions are not implemented in this version
 
  NOTE:  Addresses below are only valid when IOCON.BANK=0 (register addressing mode)
@@ -50,6 +52,79 @@ MCP::MCP(uint8_t address, uint8_t cs)
 	_outputCache = 0x0000;            // Default output state is all off, 0x0000
 	_pullupCache = 0x0000;           // Default pull-up state is all off, 0x0000
 	_invertCache = 0x0000; // Default input inversion state is not inverted, 0x0000
+	_intEnableCache = 0x0000; // Default is no interrupts enabled
+	_intControlCache = 0x0000; // Default is compare with previous value
+	_defValCache = 0x0000;
+	_updateLevel = 0;
+	_dirty = 0;
+}
+
+void MCP::csLow()
+{
+#ifdef CS_PIN_16
+	::digitalWrite(_cs, LOW);
+#else
+	GPIO_REG_WRITE(GPIO_OUT_W1TC_ADDRESS, _csBitmask);
+#endif
+}
+
+void MCP::csHigh()
+{
+#ifdef CS_PIN_16
+	::digitalWrite(_cs, HIGH);
+#else
+	GPIO_REG_WRITE(GPIO_OUT_W1TS_ADDRESS, _csBitmask);
+#endif
+}
+
+// CACHED WRITE - skips the write if the value is unchanged, defers it if an update is in progress
+
+void MCP::cacheWrite(uint8_t reg, unsigned int& cache, unsigned int value)
+{
+	if (cache == value) {
+		return;
+	}
+	cache = value;
+	if (_updateLevel != 0) {
+		_dirty |= 1 << (reg >> 1);
+	} else {
+		wordWrite(reg, value);
+	}
+}
+
+void MCP::beginUpdate()
+{
+	_updateLevel++;
+}
+
+void MCP::endUpdate()
+{
+	if (_updateLevel == 0 || --_updateLevel != 0) {
+		return;
+	}
+
+	if (_dirty & (1 << (IODIRA >> 1))) {
+		wordWrite(IODIRA, _modeCache);
+	}
+	if (_dirty & (1 << (IPOLA >> 1))) {
+		wordWrite(IPOLA, _invertCache);
+	}
+	if (_dirty & (1 << (GPINTENA >> 1))) {
+		wordWrite(GPINTENA, _intEnableCache);
+	}
+	if (_dirty & (1 << (DEFVALA >> 1))) {
+		wordWrite(DEFVALA, _defValCache);
+	}
+	if (_dirty & (1 << (INTCONA >> 1))) {
+		wordWrite(INTCONA, _intControlCache);
+	}
+	if (_dirty & (1 << (GPPUA >> 1))) {
+		wordWrite(GPPUA, _pullupCache);
+	}
+	if (_dirty & (1 << (GPIOA >> 1))) {
+		wordWrite(GPIOA, _outputCache);
+	}
+	_dirty = 0;
 }
 
 void MCP::begin()
@@ -111,21 +186,21 @@ void MCP::pinMode(uint8_t pin, uint8_t mode)
 		return; // If the pin value is not valid (0-15) return, do nothing and return
 	}
 
+	unsigned int value = _modeCache;
 	if (mode == INPUT)
 	{      // Determine the mode before changing the bit state in the mode cache
-		_modeCache |= 1 << pin; // Since input = "HIGH", OR in a 1 in the appropriate place
+		value |= 1 << pin; // Since input = "HIGH", OR in a 1 in the appropriate place
 	}
 	else
 	{
-		_modeCache &= ~(1 << pin); // If not, the mode must be output, so and in a 0 in the appropriate place
+		value &= ~(1 << pin); // If not, the mode must be output, so and in a 0 in the appropriate place
 	}
-	wordWrite(IODIRA, _modeCache); // Call the generic word writer with start register and the mode cache
+	cacheWrite(IODIRA, _modeCache, value); // Update the mode cache, writing the register pair if changed
 }
 
 void MCP::pinMode(unsigned int mode)
 {    // Accept the word�
-	wordWrite(IODIRA, mode); // Call the the generic word writer with start register and the mode cache
-	_modeCache = mode;
+	cacheWrite(IODIRA, _modeCache, mode); // Update the mode cache, writing the register pair if changed
 }
 
 // THE FOLLOWING WRITE FUNCTIONS ARE NEARLY IDENTICAL TO THE FIRST AND ARE NOT INDIVIDUALLY COMMENTED
@@ -138,21 +213,21 @@ void MCP::pullupMode(uint8_t pin, uint8_t mode)
 		return;
 	}
 
+	unsigned int word = _pullupCache;
 	if (mode == ON)
 	{
-		_pullupCache |= 1 << pin;
+		word |= 1 << pin;
 	}
 	else
 	{
-		_pullupCache &= ~(1 << pin);
+		word &= ~(1 << pin);
 	}
-	wordWrite(GPPUA, _pullupCache);
+	cacheWrite(GPPUA, _pullupCache, word);
 }
 
 void MCP::pullupMode(unsigned int mode)
 {
-	wordWrite(GPPUA, mode);
-	_pullupCache = mode;
+	cacheWrite(GPPUA, _pullupCache, mode);
 }
 
 // INPUT INVERSION SETTING FUNCTIONS - BY WORD AND BY PIN
@@ -163,21 +238,21 @@ void MCP::inputInvert(uint8_t pin, uint8_t mode)
 		return;
 	}
 
+	unsigned int word = _invertCache;
 	if (mode == ON)
 	{
-		_invertCache |= 1 << pin;
+		word |= 1 << pin;
 	}
 	else
 	{
-		_invertCache &= ~(1 << pin);
+		word &= ~(1 << pin);
 	}
-	wordWrite(IPOLA, _invertCache);
+	cacheWrite(IPOLA, _invertCache, word);
 }
 
 void MCP::inputInvert(unsigned int mode)
 {
-	wordWrite(IPOLA, mode);
-	_invertCache = mode;
+	cacheWrite(IPOLA, _invertCache, mode);
 }
 
 // WRITE FUNCTIONS - BY WORD AND BY PIN
@@ -188,21 +263,21 @@ void MCP::digitalWrite(uint8_t pin, uint8_t value)
 		return;
 	}
 
+	unsigned int word = _outputCache;
 	if (value)
 	{
-		_outputCache |= 1 << pin;
+		word |= 1 << pin;
 	}
 	else
 	{
-		_outputCache &= ~(1 << pin);
+		word &= ~(1 << pin);
 	}
-	wordWrite(GPIOA, _outputCache);
+	cacheWrite(GPIOA, _outputCache, word);
 }
 
 void MCP::digitalWrite(unsigned int value)
 {
-	wordWrite(GPIOA, value);
-	_outputCache = value;
+	cacheWrite(GPIOA, _outputCache, value);
 }
 
 // READ FUNCTIONS - BY WORD, BYTE AND BY PIN
@@ -254,3 +329,60 @@ uint8_t MCP::digitalRead(uint8_t pin)
 
 	return digitalRead() & (1 << pin) ? HIGH : LOW; // Call the word reading function, extract HIGH/LOW information from the requested pin
 }
+
+void MCP::burstRead(uint8_t reg, uint8_t* buffer, uint8_t count)
+{
+	csLow();
+	SPI.transfer(_rcmd); // Send the MCP23S17 opcode, chip address, and read bit
+	SPI.transfer(reg); // Send the first register we want to read
+	for (uint8_t i = 0; i < count; i++) {
+		buffer[i] = SPI.transfer(0x00); // Register address pointer will auto-increment after each read
+	}
+	csHigh();
+}
+
+// INTERRUPT FUNCTIONS
+
+void MCP::interruptSetup(uint8_t mirroring, uint8_t openDrain, uint8_t polarity)
+{
+	uint8_t iocon = ADDR_ENABLE;
+	if (mirroring) {
+		iocon |= 0x40; // INTA and INTB are internally connected
+	}
+	if (openDrain) {
+		iocon |= 0x04; // Overrides polarity
+	}
+	if (polarity) {
+		iocon |= 0x02; // Active-high
+	}
+	byteWrite(IOCON, iocon);
+}
+
+void MCP::interruptMode(uint8_t pin, uint8_t mode)
+{
+	if (pin > 15) {
+		return;
+	}
+
+	unsigned int mask = 1 << pin;
+	bool enable = (mode == CHANGE || mode == FALLING || mode == RISING);
+
+	beginUpdate();
+	// 0 means compare with previous value, 1 means compare with DEFVAL
+	cacheWrite(INTCONA, _intControlCache, (mode == CHANGE || !enable) ? (_intControlCache & ~mask) : (_intControlCache | mask));
+	// Interrupt is triggered when the pin differs from DEFVAL, so FALLING needs a 1
+	if (enable && mode != CHANGE) {
+		cacheWrite(DEFVALA, _defValCache, (mode == FALLING) ? (_defValCache | mask) : (_defValCache & ~mask));
+	}
+	cacheWrite(GPINTENA, _intEnableCache, enable ? (_intEnableCache | mask) : (_intEnableCache & ~mask));
+	endUpdate();
+}
+
+void MCP::interruptRead(unsigned int& flags, unsigned int& captured)
+{
+	// INTFA, INTFB, INTCAPA, INTCAPB
+	uint8_t buf[4];
+	burstRead(INTFA, buf, sizeof(buf));
+	flags = buf[0] | (buf[1] << 8);
+	captured = buf[2] | (buf[3] << 8);
+}
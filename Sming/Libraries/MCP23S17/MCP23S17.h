@@ -11,7 +11,9 @@
  Output write
  Input read
 
- Interrupt features are not implemented in this version
+ Interrupt configuration and capture
+ Batched updates: writes are deferred between beginUpdate() and endUpdate()
+
  byte based (portA, portB) functions are not implemented in this version
 
  NOTE:  Addresses below are only valid when IOCON.BANK=0 (register addressing mode)
@@ -109,7 +111,17 @@ public:
 	uint8_t digitalRead(uint8_t);            // Reads an individual input pin
 	uint8_t byteRead(uint8_t); // Reads an individual register and returns the byte. Argument is the register address
 	unsigned int digitalRead(void); // Reads all input  pins at once. Be sure it ignore the value of pins configured as output!
+	void burstRead(uint8_t, uint8_t*, uint8_t); // Reads consecutive registers in a single transfer, arguments: start register, buffer, count
+	void beginUpdate(); // Defer register writes until endUpdate(). Calls may be nested.
+	void endUpdate(); // Write any registers changed since beginUpdate(), one transfer per register pair
+	void interruptSetup(uint8_t, uint8_t, uint8_t); // Configure INT pins, arguments: mirroring, open drain, polarity (HIGH = active-high)
+	void interruptMode(uint8_t, uint8_t); // Enable interrupt for a single pin, mode is CHANGE, FALLING or RISING. Any other value disables it.
+	void interruptRead(unsigned int&, unsigned int&); // Reads interrupt flags and captured values for all pins in one transfer. Clears the interrupt.
 private:
+	void csLow();
+	void csHigh();
+	void cacheWrite(uint8_t, unsigned int&, unsigned int); // Update a cached register pair, writing it if changed
+
 	uint8_t _address; // Address of the MCP23S17 in use
 	uint8_t _cs; // CS pin number for MCP23S17
 	uint32_t _csBitmask; //CS bitmask for FAST GPIO
@@ -119,6 +131,11 @@ private:
 	unsigned int _pullupCache; // Caches the internal pull-up configuration of input pins (values persist across mode changes)
 	unsigned int _invertCache; // Caches the input pin inversion selection (values persist across mode changes)
 	unsigned int _outputCache;            // Caches the output pin state of pins
+	unsigned int _intEnableCache; // Caches the interrupt-on-change enable of pins
+	unsigned int _intControlCache; // Caches the interrupt compare mode of pins (1 = compare with DEFVAL)
+	unsigned int _defValCache; // Caches the interrupt compare values
+	uint8_t _updateLevel; // Nesting count for beginUpdate()
+	uint16_t _dirty; // Register pairs awaiting write, bit number is register address / 2
 };
 
 #endif //MCP23S17
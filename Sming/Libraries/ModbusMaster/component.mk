@@ -1,8 +1,10 @@
 COMPONENT_SUBMODULES := ModbusMaster
-COMPONENT_SRCDIRS := ModbusMaster/src
-COMPONENT_INCDIRS := ModbusMaster/src
+COMPONENT_SRCDIRS := ModbusMaster/src src
+COMPONENT_INCDIRS := ModbusMaster/src include
 
 # Configurable Modbus response timeout
 COMPONENT_VARS += MB_RESPONSE_TIMEOUT
 MB_RESPONSE_TIMEOUT ?= 300
 COMPONENT_CXXFLAGS := -DMB_RESPONSE_TIMEOUT=$(MB_RESPONSE_TIMEOUT)
+# Default for asynchronous masters is set in Modbus/Master.h
+APP_CFLAGS += -DMB_RESPONSE_TIMEOUT=$(MB_RESPONSE_TIMEOUT)
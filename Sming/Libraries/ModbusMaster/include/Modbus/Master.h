@@ -0,0 +1,339 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/SmingHub/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * Master.h - Asynchronous Modbus master, common request handling
+ *
+ ****/
+
+#pragma once
+
+#include <Data/LinkedObjectList.h>
+#include <Delegate.h>
+#include <WString.h>
+#include <memory>
+
+#ifndef MB_RESPONSE_TIMEOUT
+#define MB_RESPONSE_TIMEOUT 300
+#endif
+
+namespace Modbus
+{
+/**
+ * @brief Modbus function codes supported by the master
+ */
+enum class Function : uint8_t {
+	readCoils = 0x01,
+	readDiscreteInputs = 0x02,
+	readHoldingRegisters = 0x03,
+	readInputRegisters = 0x04,
+	writeSingleCoil = 0x05,
+	writeSingleRegister = 0x06,
+	writeMultipleCoils = 0x0F,
+	writeMultipleRegisters = 0x10,
+};
+
+/**
+ * @brief Request completion status
+ *
+ * Values match the ModbusMaster `ku8MB...` codes.
+ */
+enum class Status : uint8_t {
+	success = 0x00,
+	// Exception codes returned by slave
+	illegalFunction = 0x01,
+	illegalDataAddress = 0x02,
+	illegalDataValue = 0x03,
+	slaveDeviceFailure = 0x04,
+	// Errors detected by master
+	invalidSlaveId = 0xE0,
+	invalidFunction = 0xE1,
+	responseTimedOut = 0xE2,
+	invalidCrc = 0xE3,
+	invalidResponse = 0xE4,
+	cancelled = 0xE5,
+	connectionFailed = 0xE6,
+};
+
+String toString(Status status);
+
+/**
+ * @brief Result of a request, passed to its completion callback
+ *
+ * Where reads have been coalesced, this refers to the part of the shared response
+ * which corresponds to the original request.
+ */
+class Response
+{
+public:
+	Response(Status status) : status(status)
+	{
+	}
+
+	Response(const uint8_t* data, uint16_t offset, uint16_t count)
+		: data(data), offset(offset), count(count), status(Status::success)
+	{
+	}
+
+	Status getStatus() const
+	{
+		return status;
+	}
+
+	explicit operator bool() const
+	{
+		return status == Status::success;
+	}
+
+	/**
+	 * @brief Number of registers or bits available
+	 */
+	uint16_t getCount() const
+	{
+		return data ? count : 0;
+	}
+
+	/**
+	 * @brief Get a register value returned by a register read
+	 */
+	uint16_t getRegister(uint16_t index) const
+	{
+		if(index >= getCount()) {
+			return 0;
+		}
+		auto p = &data[(offset + index) * 2];
+		return (p[0] << 8) | p[1];
+	}
+
+	/**
+	 * @brief Get a bit value returned by a coil or discrete input read
+	 */
+	bool getBit(uint16_t index) const
+	{
+		if(index >= getCount()) {
+			return false;
+		}
+		unsigned n = offset + index;
+		return (data[n / 8] >> (n % 8)) & 0x01;
+	}
+
+private:
+	const uint8_t* data{nullptr};
+	uint16_t offset{0};
+	uint16_t count{0};
+	Status status;
+};
+
+class Request;
+
+/**
+ * @brief Callback invoked when a request has completed
+ */
+using RequestCallback = Delegate<void(const Request& request, const Response& response)>;
+
+/**
+ * @brief A queued request
+ */
+class Request : public LinkedObjectTemplate<Request>
+{
+public:
+	using OwnedList = OwnedLinkedObjectListTemplate<Request>;
+
+	bool isRead() const
+	{
+		return uint8_t(function) <= uint8_t(Function::readInputRegisters);
+	}
+
+	/**
+	 * @brief Determine if request returns bits, rather than registers
+	 */
+	bool isBitAccess() const
+	{
+		return function == Function::readCoils || function == Function::readDiscreteInputs ||
+			   function == Function::writeMultipleCoils;
+	}
+
+	RequestCallback callback;
+	std::unique_ptr<uint8_t[]> data; ///< Encoded values for writes
+	uint16_t address;
+	uint16_t quantity;
+	uint8_t dataLength{0};
+	uint8_t slave;
+	Function function;
+};
+
+/**
+ * @brief Base class for asynchronous Modbus masters
+ *
+ * Requests are queued and each is completed via its own callback.
+ * Requests to the same slave are sent in the order they were queued, except that a read may be coalesced
+ * with an earlier queued read of the same type whose address range is adjacent or overlapping.
+ * The combined read is sent as a single bus request. A read is never moved ahead of a write to the same slave.
+ */
+class Master
+{
+public:
+	static constexpr uint16_t maxReadRegisters{125};
+	static constexpr uint16_t maxReadBits{2000};
+	static constexpr uint16_t maxWriteRegisters{123};
+	static constexpr uint16_t maxWriteBits{1968};
+
+	virtual ~Master()
+	{
+	}
+
+	/**
+	 * @name Queue requests
+	 * @param slave Slave address. 0 broadcasts writes to all slaves.
+	 * @param address First register or bit
+	 * @param count Number of registers or bits
+	 * @param callback Invoked on completion
+	 * @retval bool false if parameters are invalid or queue is full
+	 * @{
+	 */
+	bool readCoils(uint8_t slave, uint16_t address, uint16_t count, RequestCallback callback)
+	{
+		return read(slave, Function::readCoils, address, count, callback);
+	}
+
+	bool readDiscreteInputs(uint8_t slave, uint16_t address, uint16_t count, RequestCallback callback)
+	{
+		return read(slave, Function::readDiscreteInputs, address, count, callback);
+	}
+
+	bool readHoldingRegisters(uint8_t slave, uint16_t address, uint16_t count, RequestCallback callback)
+	{
+		return read(slave, Function::readHoldingRegisters, address, count, callback);
+	}
+
+	bool readInputRegisters(uint8_t slave, uint16_t address, uint16_t count, RequestCallback callback)
+	{
+		return read(slave, Function::readInputRegisters, address, count, callback);
+	}
+
+	bool writeSingleCoil(uint8_t slave, uint16_t address, bool state, RequestCallback callback = nullptr);
+	bool writeSingleRegister(uint8_t slave, uint16_t address, uint16_t value, RequestCallback callback = nullptr);
+	bool writeMultipleRegisters(uint8_t slave, uint16_t address, const uint16_t* values, uint16_t count,
+								RequestCallback callback = nullptr);
+
+	/**
+	 * @param states Bit values, packed LSB first as for a coil read response
+	 */
+	bool writeMultipleCoils(uint8_t slave, uint16_t address, const uint8_t* states, uint16_t count,
+							RequestCallback callback = nullptr);
+	/** @} */
+
+	/**
+	 * @brief Set time to wait for a response before failing a request
+	 */
+	void setResponseTimeout(uint16_t milliseconds)
+	{
+		responseTimeout = milliseconds;
+	}
+
+	/**
+	 * @brief Enable or disable coalescing of adjacent reads (enabled by default)
+	 */
+	void setCoalescing(bool enable)
+	{
+		coalescing = enable;
+	}
+
+	/**
+	 * @brief Set maximum number of requests which may be waiting to be sent
+	 */
+	void setMaxQueued(uint8_t count)
+	{
+		maxQueued = count;
+	}
+
+	/**
+	 * @brief Get number of requests waiting to be sent
+	 */
+	size_t getQueueLength() const
+	{
+		return queue.count();
+	}
+
+	/**
+	 * @brief Fail all requests which have not yet been sent with Status::cancelled
+	 */
+	void cancelQueued();
+
+protected:
+	/**
+	 * @brief Requests sent as a single bus transaction
+	 */
+	struct Transaction : public LinkedObjectTemplate<Transaction> {
+		using OwnedList = OwnedLinkedObjectListTemplate<Transaction>;
+
+		Request::OwnedList requests; ///< First is the original request, others have been coalesced
+		uint32_t startTime{0};		 ///< For response timeout
+		uint16_t address;
+		uint16_t quantity;
+		uint16_t id{0}; ///< Transaction identifier, used by Modbus TCP
+		uint8_t slave;
+		Function function;
+	};
+
+	/**
+	 * @brief Called when a request has been queued, or a transaction has completed
+	 */
+	virtual void startNext() = 0;
+
+	/**
+	 * @brief Take the next request from the queue, coalescing reads where possible
+	 * @retval Transaction* nullptr if queue is empty
+	 */
+	Transaction* nextTransaction();
+
+	/**
+	 * @brief Encode the request PDU (function code and data)
+	 * @param buffer Must have room for maxPduSize bytes
+	 * @retval size_t Size of PDU
+	 */
+	static size_t encodePdu(const Transaction& transaction, uint8_t* buffer);
+
+	/**
+	 * @brief Validate a response PDU and complete all requests in the transaction
+	 * @note The transaction is destroyed
+	 */
+	void complete(Transaction* transaction, const uint8_t* pdu, size_t length);
+
+	/**
+	 * @brief Complete all requests in the transaction with an error
+	 * @note The transaction is destroyed
+	 */
+	void fail(Transaction* transaction, Status status);
+
+	bool isTimedOut(const Transaction& transaction) const;
+
+	uint16_t getResponseTimeout() const
+	{
+		return responseTimeout;
+	}
+
+	bool isQueueEmpty() const
+	{
+		return queue.isEmpty();
+	}
+
+	static constexpr size_t maxPduSize{253};
+
+private:
+	bool read(uint8_t slave, Function function, uint16_t address, uint16_t count, RequestCallback callback);
+	bool write(uint8_t slave, Function function, uint16_t address, uint16_t quantity, const uint8_t* data,
+			   uint8_t dataLength, RequestCallback callback);
+	bool submit(Request* request);
+	void coalesce(Transaction& transaction);
+	static Status checkResponse(const Transaction& transaction, const uint8_t* pdu, size_t length);
+
+	Request::OwnedList queue;
+	uint16_t responseTimeout{MB_RESPONSE_TIMEOUT};
+	uint8_t maxQueued{32};
+	bool coalescing{true};
+};
+
+} // namespace Modbus
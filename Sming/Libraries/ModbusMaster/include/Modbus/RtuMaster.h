@@ -0,0 +1,131 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/SmingHub/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * RtuMaster.h - Asynchronous Modbus RTU master
+ *
+ ****/
+
+#pragma once
+
+#include "Master.h"
+#include <HardwareSerial.h>
+#include <Timer.h>
+
+namespace Modbus
+{
+/**
+ * @brief Modbus RTU master using interrupt-driven serial frame reception
+ *
+ * Response frames are delimited by the serial driver using the line idle time (see `HardwareSerial::onFrameReceived()`)
+ * so no polling is required. The next request is sent as soon as the previous one completes,
+ * after the 3.5 character inter-frame delay.
+ *
+ * Example:
+ *
+ * 		Modbus::RtuMaster modbus;
+ *
+ * 		modbus.begin(Serial);
+ * 		modbus.readHoldingRegisters(1, 100, 4, [](const Modbus::Request& req, const Modbus::Response& rsp) {
+ * 			if(rsp) {
+ * 				debugf("Reg 100 = %u", rsp.getRegister(0));
+ * 			}
+ * 		});
+ */
+class RtuMaster : public Master
+{
+public:
+	/**
+	 * @brief Called before and after transmission, e.g. to control an RS485 driver enable pin
+	 */
+	using TransmitDelegate = Delegate<void()>;
+
+	~RtuMaster()
+	{
+		end();
+	}
+
+	/**
+	 * @brief Start using serial port
+	 * @param serial Port which has been configured with the required baud rate and format
+	 * @retval bool false if frame reception could not be enabled
+	 */
+	bool begin(HardwareSerial& serial);
+
+	/**
+	 * @brief Stop using serial port
+	 *
+	 * Callbacks are not invoked for any request in progress, or for queued requests.
+	 */
+	void end();
+
+	void setPreTransmission(TransmitDelegate callback)
+	{
+		preTransmission = callback;
+	}
+
+	/**
+	 * @brief Set callback to be invoked once the last character of a request has been sent
+	 */
+	void setPostTransmission(TransmitDelegate callback)
+	{
+		postTransmission = callback;
+	}
+
+	/**
+	 * @brief Set time to wait after a broadcast before sending the next request
+	 *
+	 * Slaves do not reply to broadcasts so require time to process them.
+	 */
+	void setTurnaroundDelay(uint16_t milliseconds)
+	{
+		turnaroundDelay = milliseconds;
+	}
+
+	/**
+	 * @brief Determine if a request is in progress
+	 */
+	bool isBusy() const
+	{
+		return state != State::idle;
+	}
+
+protected:
+	void startNext() override;
+
+private:
+	enum class State : uint8_t {
+		idle,
+		frameDelay,   ///< Waiting for inter-frame delay to expire before sending
+		transmitting, ///< Waiting for transmit FIFO to empty
+		draining,	  ///< Last character still being sent
+		waiting,	  ///< Waiting for response
+		turnaround,   ///< Waiting after broadcast
+	};
+
+	static constexpr size_t maxAduSize{256};
+
+	void send();
+	void onTimer();
+	void transmitComplete(HardwareSerial& serial);
+	void frameReceived(HardwareSerial& serial, const uint8_t* data, size_t length, unsigned status);
+	void finish(const uint8_t* pdu, size_t length, Status status);
+	void startTimer(uint32_t microseconds);
+
+	HardwareSerial* serial{nullptr};
+	Transaction* current{nullptr};
+	Timer timer;
+	TransmitDelegate preTransmission;
+	TransmitDelegate postTransmission;
+	uint8_t adu[maxAduSize];
+	uint16_t aduLength{0};
+	uint16_t turnaroundDelay{100};
+	uint16_t frameDelayUs{0};
+	uint16_t charTimeUs{0};
+	uint32_t lastActivity{0}; ///< Time bus activity last ended, in microseconds
+	State state{State::idle};
+};
+
+} // namespace Modbus
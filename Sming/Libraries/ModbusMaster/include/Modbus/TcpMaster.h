@@ -0,0 +1,92 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/SmingHub/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * TcpMaster.h - Asynchronous Modbus TCP master
+ *
+ ****/
+
+#pragma once
+
+#ifndef DISABLE_NETWORK
+
+#include "Master.h"
+#include <Network/TcpClient.h>
+#include <Timer.h>
+
+namespace Modbus
+{
+/**
+ * @brief Modbus TCP master
+ *
+ * Several requests may be outstanding on the connection at once. Responses are matched
+ * to requests using the MBAP transaction identifier so may arrive in any order.
+ * The connection is opened when the first request is queued, and re-opened as required.
+ *
+ * The slave address of each request is sent as the MBAP unit identifier, for use with gateways.
+ * Use 255 (or 0 for writes) when addressing a Modbus TCP device directly.
+ */
+class TcpMaster : public Master
+{
+public:
+	static constexpr uint16_t defaultPort{502};
+
+	TcpMaster(const String& host, uint16_t port = defaultPort);
+
+	~TcpMaster();
+
+	/**
+	 * @brief Set maximum number of requests sent without waiting for a response
+	 *
+	 * Not all servers support pipelining: use 1 to send requests one at a time.
+	 */
+	void setMaxInFlight(uint8_t count)
+	{
+		maxInFlight = (count == 0) ? 1 : count;
+	}
+
+	/**
+	 * @brief Get number of requests awaiting a response
+	 */
+	size_t getInFlight() const
+	{
+		return inFlight.count();
+	}
+
+	/**
+	 * @brief Close the connection
+	 *
+	 * Requests awaiting a response fail with Status::connectionFailed.
+	 */
+	void close();
+
+protected:
+	void startNext() override;
+
+private:
+	static constexpr size_t mbapHeaderSize{7};
+	static constexpr size_t maxAduSize{mbapHeaderSize + maxPduSize};
+	static constexpr uint16_t pollInterval{50};
+
+	bool onReceive(TcpClient& client, char* data, int size);
+	void onComplete(TcpClient& client, bool successful);
+	void processFrames();
+	void checkTimeouts();
+	void failInFlight();
+
+	String host;
+	TcpClient client;
+	Transaction::OwnedList inFlight;
+	Timer timer;
+	uint8_t rxBuffer[maxAduSize];
+	uint16_t rxLength{0};
+	uint16_t port;
+	uint16_t nextId{0};
+	uint8_t maxInFlight{4};
+};
+
+} // namespace Modbus
+
+#endif // DISABLE_NETWORK
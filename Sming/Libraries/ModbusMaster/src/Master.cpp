@@ -0,0 +1,332 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/SmingHub/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * Master.cpp
+ *
+ ****/
+
+#include <Modbus/Master.h>
+#include <Clock.h>
+#include <algorithm>
+#include <new>
+
+namespace Modbus
+{
+namespace
+{
+uint16_t getWord(const uint8_t* p)
+{
+	return (p[0] << 8) | p[1];
+}
+
+uint8_t* putWord(uint8_t* p, uint16_t value)
+{
+	*p++ = value >> 8;
+	*p++ = value & 0xff;
+	return p;
+}
+
+} // namespace
+
+String toString(Status status)
+{
+	switch(status) {
+	case Status::success:
+		return F("success");
+	case Status::illegalFunction:
+		return F("illegal function");
+	case Status::illegalDataAddress:
+		return F("illegal data address");
+	case Status::illegalDataValue:
+		return F("illegal data value");
+	case Status::slaveDeviceFailure:
+		return F("slave device failure");
+	case Status::invalidSlaveId:
+		return F("invalid slave ID");
+	case Status::invalidFunction:
+		return F("invalid function");
+	case Status::responseTimedOut:
+		return F("response timed out");
+	case Status::invalidCrc:
+		return F("invalid CRC");
+	case Status::invalidResponse:
+		return F("invalid response");
+	case Status::cancelled:
+		return F("cancelled");
+	case Status::connectionFailed:
+		return F("connection failed");
+	default:
+		return F("exception #") + String(unsigned(status));
+	}
+}
+
+bool Master::read(uint8_t slave, Function function, uint16_t address, uint16_t count, RequestCallback callback)
+{
+	auto maxCount = (function <= Function::readDiscreteInputs) ? maxReadBits : maxReadRegisters;
+	if(slave == 0 || count == 0 || count > maxCount || !callback) {
+		return false;
+	}
+
+	auto req = new(std::nothrow) Request;
+	if(req == nullptr) {
+		return false;
+	}
+	req->slave = slave;
+	req->function = function;
+	req->address = address;
+	req->quantity = count;
+	req->callback = callback;
+	return submit(req);
+}
+
+bool Master::write(uint8_t slave, Function function, uint16_t address, uint16_t quantity, const uint8_t* data,
+				   uint8_t dataLength, RequestCallback callback)
+{
+	auto req = new(std::nothrow) Request;
+	if(req == nullptr) {
+		return false;
+	}
+	req->data.reset(new(std::nothrow) uint8_t[dataLength]);
+	if(!req->data) {
+		delete req;
+		return false;
+	}
+	memcpy(req->data.get(), data, dataLength);
+	req->dataLength = dataLength;
+	req->slave = slave;
+	req->function = function;
+	req->address = address;
+	req->quantity = quantity;
+	req->callback = callback;
+	return submit(req);
+}
+
+bool Master::writeSingleCoil(uint8_t slave, uint16_t address, bool state, RequestCallback callback)
+{
+	uint8_t data[]{uint8_t(state ? 0xff : 0x00), 0x00};
+	return write(slave, Function::writeSingleCoil, address, 1, data, sizeof(data), callback);
+}
+
+bool Master::writeSingleRegister(uint8_t slave, uint16_t address, uint16_t value, RequestCallback callback)
+{
+	uint8_t data[2];
+	putWord(data, value);
+	return write(slave, Function::writeSingleRegister, address, 1, data, sizeof(data), callback);
+}
+
+bool Master::writeMultipleRegisters(uint8_t slave, uint16_t address, const uint16_t* values, uint16_t count,
+									RequestCallback callback)
+{
+	if(values == nullptr || count == 0 || count > maxWriteRegisters) {
+		return false;
+	}
+	uint8_t data[maxWriteRegisters * 2];
+	auto p = data;
+	for(unsigned i = 0; i < count; ++i) {
+		p = putWord(p, values[i]);
+	}
+	return write(slave, Function::writeMultipleRegisters, address, count, data, count * 2, callback);
+}
+
+bool Master::writeMultipleCoils(uint8_t slave, uint16_t address, const uint8_t* states, uint16_t count,
+								RequestCallback callback)
+{
+	if(states == nullptr || count == 0 || count > maxWriteBits) {
+		return false;
+	}
+	return write(slave, Function::writeMultipleCoils, address, count, states, (count + 7) / 8, callback);
+}
+
+bool Master::submit(Request* request)
+{
+	if(queue.count() >= maxQueued) {
+		delete request;
+		return false;
+	}
+	queue.add(request);
+	startNext();
+	return true;
+}
+
+void Master::cancelQueued()
+{
+	Request* req;
+	while((req = queue.pop()) != nullptr) {
+		if(req->callback) {
+			req->callback(*req, Response(Status::cancelled));
+		}
+		delete req;
+	}
+}
+
+Master::Transaction* Master::nextTransaction()
+{
+	auto req = queue.pop();
+	if(req == nullptr) {
+		return nullptr;
+	}
+
+	auto trans = new(std::nothrow) Transaction;
+	if(trans == nullptr) {
+		if(req->callback) {
+			req->callback(*req, Response(Status::cancelled));
+		}
+		delete req;
+		return nullptr;
+	}
+
+	trans->slave = req->slave;
+	trans->function = req->function;
+	trans->address = req->address;
+	trans->quantity = req->quantity;
+	trans->requests.add(req);
+	if(coalescing && req->isRead()) {
+		coalesce(*trans);
+	}
+	return trans;
+}
+
+/*
+ * Merge queued reads into the transaction.
+ * Repeat until nothing changes, as extending the range may make a previously skipped request adjacent.
+ */
+void Master::coalesce(Transaction& trans)
+{
+	auto limit = trans.requests.head()->isBitAccess() ? maxReadBits : maxReadRegisters;
+	bool merged;
+	do {
+		merged = false;
+		Request* next;
+		for(auto req = queue.head(); req != nullptr; req = next) {
+			next = req->getNext();
+			if(req->slave != trans.slave) {
+				continue;
+			}
+			if(!req->isRead()) {
+				// Don't re-order reads with respect to writes
+				break;
+			}
+			if(req->function != trans.function) {
+				continue;
+			}
+			uint32_t transEnd = trans.address + trans.quantity;
+			uint32_t reqEnd = req->address + req->quantity;
+			if(req->address > transEnd || reqEnd < trans.address) {
+				continue;
+			}
+			auto start = std::min(trans.address, req->address);
+			auto end = std::max(transEnd, reqEnd);
+			if(end - start > limit) {
+				continue;
+			}
+			queue.LinkedObjectList::remove(req);
+			trans.requests.add(req);
+			trans.address = start;
+			trans.quantity = end - start;
+			merged = true;
+		}
+	} while(merged);
+}
+
+size_t Master::encodePdu(const Transaction& trans, uint8_t* buffer)
+{
+	auto p = buffer;
+	*p++ = uint8_t(trans.function);
+	p = putWord(p, trans.address);
+	auto req = trans.requests.head();
+	switch(trans.function) {
+	case Function::writeSingleCoil:
+	case Function::writeSingleRegister:
+		memcpy(p, req->data.get(), 2);
+		p += 2;
+		break;
+	case Function::writeMultipleCoils:
+	case Function::writeMultipleRegisters:
+		p = putWord(p, trans.quantity);
+		*p++ = req->dataLength;
+		memcpy(p, req->data.get(), req->dataLength);
+		p += req->dataLength;
+		break;
+	default:
+		p = putWord(p, trans.quantity);
+	}
+	return p - buffer;
+}
+
+Status Master::checkResponse(const Transaction& trans, const uint8_t* pdu, size_t length)
+{
+	if(length < 2) {
+		return Status::invalidResponse;
+	}
+
+	auto function = uint8_t(trans.function);
+	if(pdu[0] == (function | 0x80)) {
+		return Status(pdu[1]);
+	}
+	if(pdu[0] != function) {
+		return Status::invalidFunction;
+	}
+
+	auto req = trans.requests.head();
+	if(req->isRead()) {
+		unsigned byteCount = req->isBitAccess() ? (trans.quantity + 7) / 8 : trans.quantity * 2;
+		if(pdu[1] != byteCount || length != 2 + byteCount) {
+			return Status::invalidResponse;
+		}
+		return Status::success;
+	}
+
+	// Write responses echo the address, and either the value or quantity written
+	if(length != 5 || getWord(&pdu[1]) != trans.address) {
+		return Status::invalidResponse;
+	}
+	if(trans.function == Function::writeSingleCoil || trans.function == Function::writeSingleRegister) {
+		if(memcmp(&pdu[3], req->data.get(), 2) != 0) {
+			return Status::invalidResponse;
+		}
+	} else if(getWord(&pdu[3]) != trans.quantity) {
+		return Status::invalidResponse;
+	}
+	return Status::success;
+}
+
+void Master::complete(Transaction* trans, const uint8_t* pdu, size_t length)
+{
+	auto status = checkResponse(*trans, pdu, length);
+	if(status != Status::success) {
+		fail(trans, status);
+		return;
+	}
+
+	for(auto& req : trans->requests) {
+		if(!req.callback) {
+			continue;
+		}
+		if(req.isRead()) {
+			req.callback(req, Response(&pdu[2], req.address - trans->address, req.quantity));
+		} else {
+			req.callback(req, Response(Status::success));
+		}
+	}
+	delete trans;
+}
+
+void Master::fail(Transaction* trans, Status status)
+{
+	for(auto& req : trans->requests) {
+		if(req.callback) {
+			req.callback(req, Response(status));
+		}
+	}
+	delete trans;
+}
+
+bool Master::isTimedOut(const Transaction& trans) const
+{
+	return millis() - trans.startTime >= responseTimeout;
+}
+
+} // namespace Modbus
@@ -0,0 +1,220 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/SmingHub/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * RtuMaster.cpp
+ *
+ ****/
+
+#include <Modbus/RtuMaster.h>
+#include <Clock.h>
+#include <debug_progmem.h>
+
+namespace Modbus
+{
+namespace
+{
+uint16_t crc16(const uint8_t* data, size_t length)
+{
+	uint16_t crc = 0xffff;
+	while(length--) {
+		crc ^= *data++;
+		for(unsigned i = 0; i < 8; ++i) {
+			crc = (crc & 0x0001) ? (crc >> 1) ^ 0xA001 : crc >> 1;
+		}
+	}
+	return crc;
+}
+
+} // namespace
+
+bool RtuMaster::begin(HardwareSerial& serial)
+{
+	end();
+
+	auto baud = serial.baudRate();
+	if(baud == 0) {
+		return false;
+	}
+
+	// Assume 11 bits per character (start, 8 data, parity or 2 stop bits)
+	charTimeUs = 11000000U / baud;
+	// Above 19200 baud the specification fixes the inter-frame delay
+	frameDelayUs = (baud > 19200) ? 1750 : (charTimeUs * 7 + 1) / 2;
+
+	serial.setTxBufferSize(maxAduSize);
+	if(!serial.onFrameReceived(SerialFrameDelegate(&RtuMaster::frameReceived, this), maxAduSize, 4)) {
+		return false;
+	}
+	serial.onTransmitComplete(TransmitCompleteDelegate(&RtuMaster::transmitComplete, this));
+	timer.setCallback(TimerDelegate(&RtuMaster::onTimer, this));
+
+	this->serial = &serial;
+	lastActivity = micros();
+	startNext();
+	return true;
+}
+
+void RtuMaster::end()
+{
+	if(serial == nullptr) {
+		return;
+	}
+
+	timer.stop();
+	serial->onFrameReceived(nullptr);
+	serial->onTransmitComplete(nullptr);
+	serial = nullptr;
+	delete current;
+	current = nullptr;
+	state = State::idle;
+}
+
+void RtuMaster::startNext()
+{
+	if(serial == nullptr || state != State::idle) {
+		return;
+	}
+
+	current = nextTransaction();
+	if(current == nullptr) {
+		return;
+	}
+
+	adu[0] = current->slave;
+	aduLength = 1 + encodePdu(*current, &adu[1]);
+	auto crc = crc16(adu, aduLength);
+	adu[aduLength++] = crc & 0xff;
+	adu[aduLength++] = crc >> 8;
+
+	// Respect the inter-frame delay from the end of the last frame on the bus
+	uint32_t elapsed = micros() - lastActivity;
+	if(elapsed < frameDelayUs) {
+		state = State::frameDelay;
+		startTimer(frameDelayUs - elapsed);
+		return;
+	}
+
+	send();
+}
+
+void RtuMaster::send()
+{
+	if(preTransmission) {
+		preTransmission();
+	}
+	state = State::transmitting;
+	serial->write(adu, aduLength);
+}
+
+void RtuMaster::startTimer(uint32_t microseconds)
+{
+	timer.setIntervalUs(microseconds);
+	timer.startOnce();
+}
+
+void RtuMaster::transmitComplete(HardwareSerial&)
+{
+	if(state != State::transmitting) {
+		return;
+	}
+
+	// Transmit FIFO is empty but the last character is still being shifted out
+	state = State::draining;
+	startTimer(charTimeUs);
+}
+
+void RtuMaster::onTimer()
+{
+	switch(state) {
+	case State::frameDelay:
+		send();
+		break;
+
+	case State::draining:
+		if(postTransmission) {
+			postTransmission();
+		}
+		lastActivity = micros();
+		if(current->slave == 0) {
+			// No response to broadcast
+			state = State::turnaround;
+			timer.setIntervalMs(turnaroundDelay);
+			timer.startOnce();
+		} else {
+			state = State::waiting;
+			timer.setIntervalMs(getResponseTimeout());
+			timer.startOnce();
+		}
+		break;
+
+	case State::turnaround: {
+		// Write response PDUs echo the request, so report success that way
+		uint8_t pdu[5];
+		memcpy(pdu, &adu[1], sizeof(pdu));
+		finish(pdu, sizeof(pdu), Status::success);
+		break;
+	}
+
+	case State::waiting:
+		debug_w("[MB] Response timeout, slave %u", current->slave);
+		finish(nullptr, 0, Status::responseTimedOut);
+		break;
+
+	default:;
+	}
+}
+
+void RtuMaster::frameReceived(HardwareSerial&, const uint8_t* data, size_t length, unsigned status)
+{
+	lastActivity = micros();
+
+	// Ignore noise, frames from other masters and any echo of our own request
+	if(state != State::waiting) {
+		return;
+	}
+
+	// Where the transceiver receiver isn't disabled during transmission, the request echo may arrive late
+	if(length == aduLength && memcmp(data, adu, length) == 0 && current->requests.head()->isRead()) {
+		return;
+	}
+
+	timer.stop();
+
+	if(length < 4 || status != 0) {
+		finish(nullptr, 0, Status::invalidCrc);
+		return;
+	}
+
+	uint16_t crc = data[length - 2] | (data[length - 1] << 8);
+	if(crc16(data, length - 2) != crc) {
+		finish(nullptr, 0, Status::invalidCrc);
+		return;
+	}
+
+	if(data[0] != current->slave) {
+		finish(nullptr, 0, Status::invalidSlaveId);
+		return;
+	}
+
+	finish(&data[1], length - 3, Status::success);
+}
+
+void RtuMaster::finish(const uint8_t* pdu, size_t length, Status status)
+{
+	auto trans = current;
+	current = nullptr;
+	state = State::idle;
+
+	if(status == Status::success) {
+		complete(trans, pdu, length);
+	} else {
+		fail(trans, status);
+	}
+
+	startNext();
+}
+
+} // namespace Modbus
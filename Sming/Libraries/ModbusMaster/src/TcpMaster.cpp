@@ -0,0 +1,204 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/SmingHub/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * TcpMaster.cpp
+ *
+ ****/
+
+#ifndef DISABLE_NETWORK
+
+#include <Modbus/TcpMaster.h>
+#include <Clock.h>
+#include <debug_progmem.h>
+#include <algorithm>
+
+namespace Modbus
+{
+namespace
+{
+uint16_t getWord(const uint8_t* p)
+{
+	return (p[0] << 8) | p[1];
+}
+
+uint8_t* putWord(uint8_t* p, uint16_t value)
+{
+	*p++ = value >> 8;
+	*p++ = value & 0xff;
+	return p;
+}
+
+} // namespace
+
+TcpMaster::TcpMaster(const String& host, uint16_t port)
+	: host(host),
+	  client(TcpClientCompleteDelegate(&TcpMaster::onComplete, this), TcpClientDataDelegate(&TcpMaster::onReceive, this)),
+	  port(port)
+{
+	timer.initializeMs(pollInterval, TimerDelegate(&TcpMaster::checkTimeouts, this));
+}
+
+TcpMaster::~TcpMaster()
+{
+	timer.stop();
+	client.setCompleteDelegate(nullptr);
+	client.setReceiveDelegate(nullptr);
+	client.close();
+}
+
+void TcpMaster::close()
+{
+	client.close();
+	failInFlight();
+}
+
+void TcpMaster::startNext()
+{
+	while(inFlight.count() < maxInFlight && !isQueueEmpty()) {
+		if(!client.isProcessing()) {
+			rxLength = 0;
+			if(!client.connect(host, port)) {
+				debug_w("[MB] Connect to %s:%u failed", host.c_str(), port);
+				// Fail only the first request, others may be retried when the timer next fires
+				auto trans = nextTransaction();
+				if(trans != nullptr) {
+					fail(trans, Status::connectionFailed);
+				}
+				break;
+			}
+		}
+
+		auto trans = nextTransaction();
+		if(trans == nullptr) {
+			break;
+		}
+
+		uint8_t adu[maxAduSize];
+		auto pduLength = encodePdu(*trans, &adu[mbapHeaderSize]);
+		trans->id = ++nextId;
+		auto p = putWord(adu, trans->id);
+		p = putWord(p, 0); // Protocol identifier
+		p = putWord(p, 1 + pduLength);
+		*p = trans->slave;
+
+		if(!client.send(reinterpret_cast<const char*>(adu), mbapHeaderSize + pduLength)) {
+			fail(trans, Status::connectionFailed);
+			continue;
+		}
+
+		trans->startTime = millis();
+		inFlight.add(trans);
+	}
+
+	if(!inFlight.isEmpty() || !isQueueEmpty()) {
+		if(!timer.isStarted()) {
+			timer.start();
+		}
+	}
+}
+
+bool TcpMaster::onReceive(TcpClient&, char* data, int size)
+{
+	if(data == nullptr || size <= 0) {
+		return true;
+	}
+
+	while(size > 0) {
+		auto len = std::min(size_t(size), sizeof(rxBuffer) - rxLength);
+		memcpy(&rxBuffer[rxLength], data, len);
+		rxLength += len;
+		data += len;
+		size -= len;
+		processFrames();
+	}
+
+	startNext();
+	return true;
+}
+
+/*
+ * Extract complete responses from the receive stream.
+ * TCP may split or combine responses arbitrarily.
+ */
+void TcpMaster::processFrames()
+{
+	unsigned offset = 0;
+	while(offset + mbapHeaderSize <= rxLength) {
+		auto hdr = &rxBuffer[offset];
+		uint16_t length = getWord(&hdr[4]);
+		if(getWord(&hdr[2]) != 0 || length < 2 || length > 1 + maxPduSize) {
+			debug_w("[MB] Invalid MBAP header, discarding %u bytes", rxLength - offset);
+			offset = rxLength;
+			break;
+		}
+		unsigned frameSize = 6 + length;
+		if(offset + frameSize > rxLength) {
+			break;
+		}
+
+		uint16_t id = getWord(&hdr[0]);
+		auto trans = std::find_if(inFlight.begin(), inFlight.end(), [id](const Transaction& t) { return t.id == id; });
+		if(trans == inFlight.end()) {
+			debug_w("[MB] Response for unknown transaction #%u", id);
+		} else {
+			auto t = static_cast<Transaction*>(trans);
+			inFlight.LinkedObjectList::remove(t);
+			if(hdr[6] != t->slave) {
+				fail(t, Status::invalidSlaveId);
+			} else {
+				complete(t, &hdr[mbapHeaderSize], length - 1);
+			}
+		}
+		offset += frameSize;
+	}
+
+	// Callbacks may have closed the connection
+	if(offset >= rxLength) {
+		rxLength = 0;
+	} else {
+		rxLength -= offset;
+		memmove(rxBuffer, &rxBuffer[offset], rxLength);
+	}
+}
+
+void TcpMaster::checkTimeouts()
+{
+	// Callbacks may change the list, so start again after each failure
+	auto trans = inFlight.head();
+	while(trans != nullptr) {
+		if(isTimedOut(*trans)) {
+			inFlight.LinkedObjectList::remove(trans);
+			fail(trans, Status::responseTimedOut);
+			trans = inFlight.head();
+		} else {
+			trans = trans->getNext();
+		}
+	}
+
+	if(inFlight.isEmpty() && isQueueEmpty()) {
+		timer.stop();
+		return;
+	}
+
+	startNext();
+}
+
+void TcpMaster::onComplete(TcpClient&, bool)
+{
+	failInFlight();
+}
+
+void TcpMaster::failInFlight()
+{
+	Transaction* trans;
+	while((trans = inFlight.pop()) != nullptr) {
+		fail(trans, Status::connectionFailed);
+	}
+}
+
+} // namespace Modbus
+
+#endif // DISABLE_NETWORK
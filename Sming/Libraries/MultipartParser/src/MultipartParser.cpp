@@ -109,13 +109,14 @@ int MultipartParser::readHeaderValue(multipart_parser_t* p, const char* at, size
 {
 	GET_PARSER();
 
-	return parser->headerBuilder.onHeaderValue(parser->incomingHeaders, at, length);
+	return parser->headerBuilder.onHeaderValue(at, length);
 }
 
 int MultipartParser::partHeadersComplete(multipart_parser_t* p)
 {
 	GET_PARSER();
 
+	parser->headerBuilder.copyTo(parser->incomingHeaders);
 	auto& headers = static_cast<const HttpHeaders&>(parser->incomingHeaders);
 	String headerValue = headers[HTTP_HEADER_CONTENT_DISPOSITION];
 	if(!headerValue) {
@@ -220,6 +221,11 @@ int MultipartParser::partEnd(multipart_parser_t* p)
 
 	parser->resetHeaders();
 
+	// Allow buffering streams to complete and verify their content
+	if(parser->stream != nullptr) {
+		parser->stream->flush();
+	}
+
 	return 0;
 }
 
@@ -73,6 +73,11 @@ public:
 		return getSource()->isFinished();
 	}
 
+	void flush() override
+	{
+		getSource()->flush();
+	}
+
 private:
 	bool save{true};
 	CheckerCallback callback;
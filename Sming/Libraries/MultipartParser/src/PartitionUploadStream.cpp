@@ -0,0 +1,127 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/SmingHub/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * PartitionUploadStream.cpp
+ *
+ ****/
+
+#include "PartitionUploadStream.h"
+#include <debug_progmem.h>
+
+void PartitionUploadStream::setError(Error code)
+{
+	debug_e("[UPLOAD] %s", toString(code).c_str());
+	error = code;
+}
+
+size_t PartitionUploadStream::write(const uint8_t* data, size_t size)
+{
+	if(finished || error != Error::None) {
+		return 0;
+	}
+
+	if(received + size > maxSize) {
+		setError(Error::TooLarge);
+		return 0;
+	}
+
+	if(!buffer) {
+		buffer.reset(new uint8_t[blockSize]);
+		if(!buffer) {
+			setError(Error::OutOfMemory);
+			return 0;
+		}
+	}
+
+	updateHash(data, size);
+	received += size;
+
+	auto remaining = size;
+	while(remaining != 0) {
+		// Write whole blocks directly from the source
+		if(bufferLength == 0 && remaining >= blockSize) {
+			auto len = remaining - (remaining % blockSize);
+			if(!writeBlock(data, len)) {
+				return 0;
+			}
+			data += len;
+			remaining -= len;
+			continue;
+		}
+
+		auto len = std::min(remaining, blockSize - bufferLength);
+		memcpy(&buffer[bufferLength], data, len);
+		bufferLength += len;
+		data += len;
+		remaining -= len;
+		if(bufferLength == blockSize) {
+			if(!writeBlock(buffer.get(), blockSize)) {
+				return 0;
+			}
+			bufferLength = 0;
+		}
+	}
+
+	return size;
+}
+
+bool PartitionUploadStream::writeBlock(const uint8_t* data, size_t length)
+{
+	if(output.write(data, length) != length) {
+		setError(Error::FlashWriteFailed);
+		return false;
+	}
+
+	return true;
+}
+
+void PartitionUploadStream::flush()
+{
+	if(finished || error != Error::None) {
+		return;
+	}
+
+	finished = true;
+
+	if(bufferLength != 0 && !writeBlock(buffer.get(), bufferLength)) {
+		return;
+	}
+	bufferLength = 0;
+	buffer.reset();
+
+	if(expectedSize != 0 && received != expectedSize) {
+		setError(Error::SizeMismatch);
+		return;
+	}
+
+	if(!verifyHash()) {
+		setError(Error::HashMismatch);
+		return;
+	}
+
+	debug_i("[UPLOAD] %u bytes written to '%s'", received, partition.name().c_str());
+}
+
+String toString(PartitionUploadStream::Error error)
+{
+	using Error = PartitionUploadStream::Error;
+	switch(error) {
+	case Error::None:
+		return nullptr;
+	case Error::TooLarge:
+		return F("Upload too large");
+	case Error::SizeMismatch:
+		return F("Upload size incorrect");
+	case Error::HashMismatch:
+		return F("Upload verification failed");
+	case Error::FlashWriteFailed:
+		return F("Flash write failed");
+	case Error::OutOfMemory:
+		return F("Out of memory");
+	default:
+		return F("Unknown");
+	}
+}
@@ -0,0 +1,205 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/SmingHub/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * PartitionUploadStream.h
+ *
+ ****/
+
+#pragma once
+
+#include <Storage/PartitionStream.h>
+#include <algorithm>
+#include <memory>
+
+/**
+ * @brief Write-only stream which stores an uploaded file directly into a flash partition
+ *
+ * Incoming data is collected into fixed-size blocks which are written at aligned offsets,
+ * and flash is erased ahead of the write position while the connection is idle.
+ *
+ * An upload larger than the expected size (or the partition) is rejected as soon as the excess arrives,
+ * which aborts the request.
+ * When used with #HttpMultipartResource the final block is written, and the size and digest verified,
+ * at the end of the part so the result is available to the request completion callback.
+ *
+ * @note Content is written to flash as it arrives, so the partition must not be used
+ * (for example, by activating an OTA slot) unless `isComplete()` returns true.
+ */
+class PartitionUploadStream : public ReadWriteStream
+{
+public:
+	enum class Error {
+		None,			 ///< No error
+		TooLarge,		 ///< More data received than expected or partition can hold
+		SizeMismatch,	///< Upload complete but shorter than expected
+		HashMismatch,	///< Upload complete but digest check failed
+		FlashWriteFailed, ///< Error while erasing or writing to flash
+		OutOfMemory,	  ///< Unable to allocate write buffer
+	};
+
+	static constexpr size_t defaultBlockSize{512};
+	static constexpr size_t defaultEraseAhead{8192};
+
+	/**
+	 * @brief Construct an upload stream
+	 * @param partition Destination partition
+	 * @param expectedSize If non-zero, upload must be exactly this size
+	 * @param blockSize Size of write buffer. Should be a factor of the flash sector size.
+	 */
+	PartitionUploadStream(Storage::Partition partition, size_t expectedSize = 0, size_t blockSize = defaultBlockSize)
+		: partition(partition),
+		  maxSize(expectedSize ? std::min(expectedSize, partition.size()) : partition.size()),
+		  output(partition, 0, maxSize, true), expectedSize(expectedSize), blockSize(blockSize)
+	{
+		output.setEraseAhead(defaultEraseAhead);
+	}
+
+	/**
+	 * @brief Change how far ahead of the write position flash is erased
+	 * @param distance 0 to erase only as required
+	 */
+	void setEraseAhead(size_t distance)
+	{
+		output.setEraseAhead(distance);
+	}
+
+	size_t write(const uint8_t* data, size_t size) override;
+
+	/**
+	 * @brief Write any remaining data and verify upload
+	 *
+	 * Called by the multipart parser at the end of the part. Subsequent writes are rejected.
+	 */
+	void flush() override;
+
+	StreamType getStreamType() const override
+	{
+		return eSST_User;
+	}
+
+	bool isValid() const override
+	{
+		return error == Error::None;
+	}
+
+	uint16_t readMemoryBlock(char* data, int bufSize) override
+	{
+		return 0;
+	}
+
+	int available() override
+	{
+		return received;
+	}
+
+	bool isFinished() override
+	{
+		return true;
+	}
+
+	/**
+	 * @brief Determine whether upload has been written and verified
+	 */
+	bool isComplete() const
+	{
+		return finished && error == Error::None;
+	}
+
+	Error getError() const
+	{
+		return error;
+	}
+
+	Storage::Partition getPartition() const
+	{
+		return partition;
+	}
+
+protected:
+	/**
+	 * @brief Implement to compute digest of received data
+	 */
+	virtual void updateHash(const uint8_t* data, size_t length)
+	{
+	}
+
+	/**
+	 * @brief Implement to check digest once upload is complete
+	 */
+	virtual bool verifyHash()
+	{
+		return true;
+	}
+
+private:
+	bool writeBlock(const uint8_t* data, size_t length);
+	void setError(Error code);
+
+	Storage::Partition partition;
+	size_t maxSize;
+	Storage::PartitionStream output;
+	std::unique_ptr<uint8_t[]> buffer;
+	size_t expectedSize;
+	size_t blockSize;
+	size_t bufferLength{0};
+	size_t received{0};
+	Error error{Error::None};
+	bool finished{false};
+};
+
+/**
+ * @brief Partition upload stream which also verifies a digest of the content
+ * @tparam HashContext Hash implementation, such as Crypto::Sha256
+ *
+ * The digest is calculated as data arrives, so costs nothing extra at the end of the upload.
+ * If an expected value is provided, the upload fails if it doesn't match.
+ */
+template <class HashContext> class HashedPartitionUploadStream : public PartitionUploadStream
+{
+public:
+	using Hash = typename HashContext::Hash;
+
+	using PartitionUploadStream::PartitionUploadStream;
+
+	/**
+	 * @brief Set the expected digest
+	 * @note May be called at any time before the upload completes
+	 */
+	void setExpectedHash(const Hash& hash)
+	{
+		expectedHash = hash;
+		checkHash = true;
+	}
+
+	/**
+	 * @brief Get digest of uploaded content
+	 * @note Valid only after upload has completed
+	 */
+	const Hash& getHash() const
+	{
+		return hash;
+	}
+
+protected:
+	void updateHash(const uint8_t* data, size_t length) override
+	{
+		context.update(data, length);
+	}
+
+	bool verifyHash() override
+	{
+		hash = context.getHash();
+		return !checkHash || hash == expectedHash;
+	}
+
+private:
+	HashContext context;
+	Hash hash{};
+	Hash expectedHash{};
+	bool checkHash{false};
+};
+
+String toString(PartitionUploadStream::Error error);
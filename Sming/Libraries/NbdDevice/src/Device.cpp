@@ -0,0 +1,745 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/SmingHub/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * Device.cpp
+ *
+ ****/
+
+#ifndef DISABLE_NETWORK
+
+#include <Nbd/Device.h>
+#include <Platform/System.h>
+#include <debug_progmem.h>
+#include <algorithm>
+#include <new>
+
+namespace Nbd
+{
+namespace
+{
+// Handshake
+constexpr uint64_t nbdMagic{0x4e42444d41474943ULL}; // "NBDMAGIC"
+constexpr uint64_t optMagic{0x49484156454f5054ULL}; // "IHAVEOPT"
+constexpr uint16_t flagFixedNewstyle{1U << 0};
+constexpr uint16_t flagNoZeroes{1U << 1};
+constexpr uint32_t optExportName{1};
+constexpr size_t handshakeSize{18};
+constexpr size_t exportInfoSize{10};
+constexpr uint8_t exportPaddingSize{124};
+
+// Transmission
+constexpr uint16_t transmitReadOnly{1U << 1};
+constexpr uint16_t transmitSendFlush{1U << 2};
+constexpr uint32_t requestMagic{0x25609513};
+constexpr uint32_t simpleReplyMagic{0x67446698};
+constexpr size_t requestHeaderSize{28};
+constexpr size_t replyHeaderSize{16};
+
+constexpr uint16_t pollInterval{100};
+
+uint16_t getBE16(const uint8_t* p)
+{
+	return (p[0] << 8) | p[1];
+}
+
+uint32_t getBE32(const uint8_t* p)
+{
+	return (uint32_t(getBE16(p)) << 16) | getBE16(p + 2);
+}
+
+uint64_t getBE64(const uint8_t* p)
+{
+	return (uint64_t(getBE32(p)) << 32) | getBE32(p + 4);
+}
+
+uint8_t* putBE16(uint8_t* p, uint16_t value)
+{
+	*p++ = value >> 8;
+	*p++ = value;
+	return p;
+}
+
+uint8_t* putBE32(uint8_t* p, uint32_t value)
+{
+	p = putBE16(p, value >> 16);
+	return putBE16(p, value);
+}
+
+uint8_t* putBE64(uint8_t* p, uint64_t value)
+{
+	p = putBE32(p, value >> 32);
+	return putBE32(p, value);
+}
+
+} // namespace
+
+Device::Device(const String& name, const Config& config)
+	: name(name), config(config),
+	  client(TcpClientCompleteDelegate(&Device::onComplete, this), TcpClientDataDelegate(&Device::onReceive, this))
+{
+	if(this->config.lineCount != 0) {
+		lines.reset(new Line[this->config.lineCount]);
+		buffer.reset(new uint8_t[this->config.lineSize * this->config.lineCount]);
+	}
+	if(this->config.maxBatchSize == 0) {
+		this->config.maxBatchSize = 1;
+	}
+	batchTimer.initializeMs(std::max(config.batchDelay, uint16_t(1)), TimerDelegate(&Device::submitBatch, this));
+	pollTimer.initializeMs(pollInterval, TimerDelegate(&Device::checkTimeouts, this));
+}
+
+Device::~Device()
+{
+	client.setCompleteDelegate(nullptr);
+	client.setReceiveDelegate(nullptr);
+	close();
+}
+
+bool Device::connect(const String& host, uint16_t port, const String& exportName, ConnectCallback callback)
+{
+	close();
+
+	this->exportName = exportName;
+	connectCallback = callback;
+	size = 0;
+	state = State::handshake;
+	if(!client.connect(host, port)) {
+		debug_w("[NBD] Connect to %s:%u failed", host.c_str(), port);
+		state = State::closed;
+		return false;
+	}
+
+	return true;
+}
+
+void Device::close()
+{
+	if(state == State::closed) {
+		return;
+	}
+
+	state = State::closed;
+	client.close();
+	failAll();
+}
+
+void Device::onComplete(TcpClient&, bool)
+{
+	auto prevState = state;
+	state = State::closed;
+	failAll();
+
+	if((prevState == State::handshake || prevState == State::exportInfo) && connectCallback) {
+		connectCallback(*this, false);
+	}
+}
+
+void Device::failAll()
+{
+	batchTimer.stop();
+	pollTimer.stop();
+	batch.reset();
+	rxLength = 0;
+	rxSkip = 0;
+
+	if(rxRequest != nullptr) {
+		auto req = rxRequest;
+		rxRequest = nullptr;
+		completeRequest(req, false);
+	}
+
+	// Callbacks may change the lists, so always take the first entry
+	Request* req;
+	while((req = inFlight.head()) != nullptr) {
+		inFlight.LinkedObjectList::remove(req);
+		completeRequest(req, false);
+	}
+	while((req = queued.head()) != nullptr) {
+		queued.LinkedObjectList::remove(req);
+		completeRequest(req, false);
+	}
+
+	writeBacklog = 0;
+}
+
+/*
+ * Cache
+ */
+
+int Device::findLine(uint32_t address) const
+{
+	for(unsigned i = 0; i < config.lineCount; ++i) {
+		if(lines[i].address == address) {
+			return i;
+		}
+	}
+	return -1;
+}
+
+bool Device::readCache(uint32_t address, uint8_t* dst, size_t size)
+{
+	auto mask = config.lineSize - 1;
+	uint32_t end = address + size;
+
+	for(uint32_t a = address & ~mask; a < end; a += config.lineSize) {
+		if(findLine(a) < 0) {
+			return false;
+		}
+	}
+
+	for(uint32_t a = address; a < end;) {
+		uint32_t lineAddr = a & ~mask;
+		auto index = findLine(lineAddr);
+		auto offset = a - lineAddr;
+		auto n = std::min(end - a, uint32_t(config.lineSize - offset));
+		if(dst != nullptr) {
+			memcpy(dst, &getLineData(index)[offset], n);
+			dst += n;
+		}
+		lines[index].lastUsed = ++useCounter;
+		a += n;
+	}
+
+	return true;
+}
+
+void Device::updateCache(uint32_t address, const uint8_t* src, size_t size)
+{
+	auto mask = config.lineSize - 1;
+	uint32_t end = address + size;
+
+	for(uint32_t a = address; a < end;) {
+		uint32_t lineAddr = a & ~mask;
+		auto offset = a - lineAddr;
+		auto n = std::min(end - a, uint32_t(config.lineSize - offset));
+		auto index = findLine(lineAddr);
+		if(index >= 0) {
+			if(src != nullptr) {
+				memcpy(&getLineData(index)[offset], &src[a - address], n);
+			} else {
+				memset(&getLineData(index)[offset], 0xff, n);
+			}
+		}
+		a += n;
+	}
+}
+
+void Device::storeLines(uint32_t address, const uint8_t* src, size_t size)
+{
+	if(config.lineCount == 0) {
+		return;
+	}
+
+	// Only complete lines are cached
+	for(uint32_t pos = 0; pos + config.lineSize <= size; pos += config.lineSize) {
+		auto index = findLine(address + pos);
+		if(index < 0) {
+			index = 0;
+			for(unsigned i = 1; i < config.lineCount; ++i) {
+				if(lines[i].lastUsed < lines[index].lastUsed) {
+					index = i;
+				}
+			}
+			lines[index].address = address + pos;
+		}
+		memcpy(getLineData(index), &src[pos], config.lineSize);
+		lines[index].lastUsed = ++useCounter;
+	}
+}
+
+void Device::invalidate()
+{
+	for(unsigned i = 0; i < config.lineCount; ++i) {
+		lines[i] = Line{};
+	}
+}
+
+/*
+ * Data read from the server may pre-date writes which have not yet been acknowledged,
+ * as servers may process requests in any order. Apply those writes, oldest first.
+ */
+void Device::applyWrites(uint32_t address, uint8_t* dst, size_t size)
+{
+	auto apply = [&](const Request& req) {
+		if(req.command != Command::write) {
+			return;
+		}
+		auto start = std::max(address, req.offset);
+		auto end = std::min(uint32_t(address + size), req.offset + req.length);
+		if(start < end) {
+			memcpy(&dst[start - address], &req.data[start - req.offset], end - start);
+		}
+	};
+
+	for(auto& req : inFlight) {
+		apply(req);
+	}
+	for(auto& req : queued) {
+		apply(req);
+	}
+	if(batch) {
+		apply(*batch);
+	}
+}
+
+/*
+ * Reading
+ */
+
+bool Device::read(uint32_t address, void* dst, size_t size)
+{
+	if(!checkRange(address, size)) {
+		return false;
+	}
+
+	if(readCache(address, static_cast<uint8_t*>(dst), size)) {
+		++stats.hits;
+		return true;
+	}
+
+	// Start loading so a later attempt may succeed
+	prefetch(address, size);
+	return false;
+}
+
+bool Device::readAsync(uint32_t address, void* dst, size_t size, Storage::ReadCallback callback)
+{
+	if(!checkRange(address, size)) {
+		return false;
+	}
+
+	auto buf = static_cast<uint8_t*>(dst);
+	if(readCache(address, buf, size)) {
+		++stats.hits;
+		if(callback) {
+			System.queueCallback([callback]() { callback(true); });
+		}
+		return true;
+	}
+
+	++stats.misses;
+
+	auto mask = config.lineSize - 1;
+	uint32_t start = address & ~mask;
+	uint32_t end = std::min(uint32_t((address + size + mask) & ~mask), this->size);
+
+	std::unique_ptr<Request> req;
+	if(end - start <= config.lineSize * config.lineCount) {
+		// Read complete lines so they can be cached
+		req.reset(new Request(Command::read, start, end - start));
+		req->data.reset(new(std::nothrow) uint8_t[req->length]);
+		if(!req->data) {
+			return false;
+		}
+		req->dst = buf;
+		req->dstOffset = address - start;
+		req->dstLength = size;
+	} else if(buf != nullptr) {
+		// Too large to cache, read directly into caller's buffer
+		req.reset(new Request(Command::read, address, size));
+		req->dst = buf;
+	} else {
+		debug_w("[NBD] Prefetch of %u bytes exceeds cache size", size);
+		return false;
+	}
+
+	req->readCallback = callback;
+	++stats.readRequests;
+	submitBatch();
+	queue(req.release());
+	return true;
+}
+
+/*
+ * Writing
+ */
+
+bool Device::write(uint32_t address, const void* src, size_t size)
+{
+	return src != nullptr && appendWrite(address, src, size);
+}
+
+bool Device::erase_range(uint32_t address, size_t size)
+{
+	return appendWrite(address, nullptr, size);
+}
+
+bool Device::appendWrite(uint32_t address, const void* src, size_t size)
+{
+	if(!checkRange(address, size) || readOnly) {
+		return false;
+	}
+
+	if(writeBacklog + size > config.maxWriteBacklog) {
+		debug_w("[NBD] Write backlog full");
+		submitBatch();
+		return false;
+	}
+
+	auto data = static_cast<const uint8_t*>(src);
+	updateCache(address, data, size);
+	writeBacklog += size;
+
+	while(size != 0) {
+		if(batch && (address != batch->offset + batch->length || batch->length == config.maxBatchSize)) {
+			submitBatch();
+		}
+		if(!batch) {
+			batch.reset(new Request(Command::write, address, 0));
+			batch->data.reset(new uint8_t[config.maxBatchSize]);
+		}
+		auto n = std::min(size, size_t(config.maxBatchSize - batch->length));
+		if(data != nullptr) {
+			memcpy(&batch->data[batch->length], data, n);
+			data += n;
+		} else {
+			memset(&batch->data[batch->length], 0xff, n);
+		}
+		batch->length += n;
+		address += n;
+		size -= n;
+	}
+
+	if(batch->length == config.maxBatchSize) {
+		submitBatch();
+	} else if(!batchTimer.isStarted()) {
+		batchTimer.startOnce();
+	}
+
+	return true;
+}
+
+void Device::submitBatch()
+{
+	batchTimer.stop();
+	if(!batch) {
+		return;
+	}
+
+	if(batch->length < config.maxBatchSize) {
+		auto data = new uint8_t[batch->length];
+		memcpy(data, batch->data.get(), batch->length);
+		batch->data.reset(data);
+	}
+
+	++stats.writeRequests;
+	queue(batch.release());
+}
+
+bool Device::flush(FlushCallback callback)
+{
+	if(state != State::ready) {
+		return false;
+	}
+
+	submitBatch();
+	auto req = new Request(Command::flush, 0, 0);
+	req->flushCallback = callback;
+	queue(req);
+	return true;
+}
+
+/*
+ * Request handling
+ */
+
+void Device::queue(Request* req)
+{
+	queued.add(req);
+	startNext();
+}
+
+void Device::startNext()
+{
+	if(state != State::ready) {
+		return;
+	}
+
+	Request* req;
+	while((req = queued.head()) != nullptr && inFlight.count() < config.maxInFlight) {
+		// A flush only applies to writes which have completed
+		if(req->command == Command::flush && (!inFlight.isEmpty() || rxRequest != nullptr)) {
+			break;
+		}
+
+		queued.LinkedObjectList::remove(req);
+
+		if(req->command == Command::flush && !canFlush) {
+			completeRequest(req, true);
+			continue;
+		}
+
+		req->sentTime = millis();
+		inFlight.add(req);
+		if(!sendRequest(*req)) {
+			debug_e("[NBD] Send failed");
+			close();
+			return;
+		}
+	}
+
+	if(!inFlight.isEmpty() && !pollTimer.isStarted()) {
+		pollTimer.start();
+	}
+}
+
+bool Device::sendRequest(Request& req)
+{
+	req.handle = ++nextHandle;
+
+	uint8_t hdr[requestHeaderSize];
+	auto p = putBE32(hdr, requestMagic);
+	p = putBE16(p, 0);
+	p = putBE16(p, uint16_t(req.command));
+	p = putBE64(p, req.handle);
+	p = putBE64(p, req.offset);
+	putBE32(p, req.length);
+
+	if(!client.send(reinterpret_cast<const char*>(hdr), sizeof(hdr))) {
+		return false;
+	}
+
+	if(req.command == Command::write) {
+		return client.send(reinterpret_cast<const char*>(req.data.get()), req.length);
+	}
+
+	return true;
+}
+
+void Device::completeRequest(Request* req, bool success)
+{
+	// Request has been removed from lists, so callbacks may safely make further requests
+	std::unique_ptr<Request> owner(req);
+
+	switch(req->command) {
+	case Command::read:
+		if(success) {
+			if(req->data) {
+				applyWrites(req->offset, req->data.get(), req->length);
+				storeLines(req->offset, req->data.get(), req->length);
+				if(req->dst != nullptr) {
+					memcpy(req->dst, &req->data[req->dstOffset], req->dstLength);
+				}
+			} else {
+				applyWrites(req->offset, req->dst, req->length);
+			}
+		}
+		if(req->readCallback) {
+			req->readCallback(success);
+		}
+		break;
+
+	case Command::write:
+		writeBacklog -= std::min(writeBacklog, size_t(req->length));
+		if(!success) {
+			writeFailed = true;
+			++stats.writeErrors;
+		}
+		break;
+
+	case Command::flush: {
+		bool ok = success && !writeFailed;
+		writeFailed = false;
+		if(req->flushCallback) {
+			req->flushCallback(ok);
+		}
+		break;
+	}
+
+	default:
+		break;
+	}
+}
+
+void Device::checkTimeouts()
+{
+	auto req = inFlight.head();
+	if(req == nullptr && rxRequest == nullptr) {
+		pollTimer.stop();
+		return;
+	}
+
+	auto sent = rxRequest ? rxRequest->sentTime : req->sentTime;
+	if(millis() - sent >= config.timeout) {
+		debug_e("[NBD] Request timed out");
+		close();
+	}
+}
+
+/*
+ * Receiving
+ */
+
+bool Device::gather(const uint8_t*& data, size_t& size, size_t required)
+{
+	auto n = std::min(size, required - rxLength);
+	memcpy(&rxBuffer[rxLength], data, n);
+	rxLength += n;
+	data += n;
+	size -= n;
+	if(rxLength < required) {
+		return false;
+	}
+	rxLength = 0;
+	return true;
+}
+
+bool Device::onReceive(TcpClient&, char* data, int size)
+{
+	if(data == nullptr || size <= 0) {
+		return true;
+	}
+
+	auto p = reinterpret_cast<const uint8_t*>(data);
+	size_t len = size;
+	while(len != 0 && state != State::closed) {
+		if(rxSkip != 0) {
+			auto n = std::min(len, size_t(rxSkip));
+			rxSkip -= n;
+			p += n;
+			len -= n;
+			continue;
+		}
+
+		if(rxRequest != nullptr) {
+			auto req = rxRequest;
+			auto n = std::min(len, size_t(req->length - rxDataPos));
+			auto dst = req->data ? req->data.get() : req->dst;
+			memcpy(&dst[rxDataPos], p, n);
+			rxDataPos += n;
+			p += n;
+			len -= n;
+			if(rxDataPos == req->length) {
+				rxRequest = nullptr;
+				completeRequest(req, true);
+			}
+			continue;
+		}
+
+		bool ok;
+		switch(state) {
+		case State::handshake:
+			if(!gather(p, len, handshakeSize)) {
+				continue;
+			}
+			ok = processHandshake();
+			break;
+
+		case State::exportInfo:
+			if(!gather(p, len, exportInfoSize)) {
+				continue;
+			}
+			ok = processExportInfo();
+			break;
+
+		default:
+			if(!gather(p, len, replyHeaderSize)) {
+				continue;
+			}
+			ok = processReplyHeader();
+		}
+
+		if(!ok) {
+			// Connection will be closed
+			return false;
+		}
+	}
+
+	startNext();
+	return true;
+}
+
+bool Device::processHandshake()
+{
+	if(getBE64(&rxBuffer[0]) != nbdMagic || getBE64(&rxBuffer[8]) != optMagic) {
+		debug_e("[NBD] Server does not support newstyle negotiation");
+		return false;
+	}
+
+	auto flags = getBE16(&rxBuffer[16]);
+	if((flags & flagFixedNewstyle) == 0) {
+		debug_e("[NBD] Server does not support fixed newstyle negotiation");
+		return false;
+	}
+	noZeroes = (flags & flagNoZeroes) != 0;
+
+	uint8_t msg[20];
+	auto p = putBE32(msg, flagFixedNewstyle | (noZeroes ? flagNoZeroes : 0));
+	p = putBE64(p, optMagic);
+	p = putBE32(p, optExportName);
+	putBE32(p, exportName.length());
+	if(!client.send(reinterpret_cast<const char*>(msg), sizeof(msg))) {
+		return false;
+	}
+	if(exportName && !client.send(exportName.c_str(), exportName.length())) {
+		return false;
+	}
+
+	state = State::exportInfo;
+	return true;
+}
+
+bool Device::processExportInfo()
+{
+	auto exportSize = getBE64(&rxBuffer[0]);
+	auto flags = getBE16(&rxBuffer[8]);
+
+	if(exportSize > 0xffffffffULL) {
+		debug_w("[NBD] Export too large, only first 4GB accessible");
+		exportSize = 0xffffffffULL & ~uint64_t(config.blockSize - 1);
+	}
+	size = exportSize;
+	readOnly = (flags & transmitReadOnly) != 0;
+	canFlush = (flags & transmitSendFlush) != 0;
+	writeFailed = false;
+	if(!noZeroes) {
+		rxSkip = exportPaddingSize;
+	}
+	invalidate();
+
+	state = State::ready;
+	debug_i("[NBD] '%s' ready, %u bytes%s", name.c_str(), size, readOnly ? _F(", read-only") : "");
+
+	if(connectCallback) {
+		connectCallback(*this, true);
+	}
+	return true;
+}
+
+bool Device::processReplyHeader()
+{
+	if(getBE32(&rxBuffer[0]) != simpleReplyMagic) {
+		debug_e("[NBD] Invalid reply");
+		return false;
+	}
+
+	auto error = getBE32(&rxBuffer[4]);
+	auto handle = getBE64(&rxBuffer[8]);
+	auto it = std::find_if(inFlight.begin(), inFlight.end(), [handle](const Request& r) { return r.handle == handle; });
+	if(it == inFlight.end()) {
+		// Can't tell how much data might follow, so give up
+		debug_e("[NBD] Reply for unknown request #%u", uint32_t(handle));
+		return false;
+	}
+
+	auto req = static_cast<Request*>(it);
+	inFlight.LinkedObjectList::remove(req);
+
+	if(error != 0) {
+		debug_w("[NBD] Error %u for command %u at 0x%08x", error, unsigned(req->command), req->offset);
+	} else if(req->command == Command::read && req->length != 0) {
+		rxRequest = req;
+		rxDataPos = 0;
+		return true;
+	}
+
+	completeRequest(req, error == 0);
+	return true;
+}
+
+} // namespace Nbd
+
+#endif // DISABLE_NETWORK
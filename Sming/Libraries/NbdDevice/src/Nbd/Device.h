@@ -0,0 +1,267 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/SmingHub/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * Device.h - Storage device accessed over the network using the NBD protocol
+ *
+ ****/
+
+#pragma once
+
+#ifndef DISABLE_NETWORK
+
+#include <Storage/CustomDevice.h>
+#include <Network/TcpClient.h>
+#include <Data/LinkedObjectList.h>
+#include <Timer.h>
+#include <memory>
+
+namespace Nbd
+{
+/**
+ * @brief Network Block Device client
+ *
+ * Connects to a server such as `nbd-server`, `qemu-nbd` or `nbdkit` and presents the export
+ * as a storage device. Partitions may be created on it once connected.
+ *
+ * Reads are served from a small line cache. Misses are sent to the server as requests,
+ * several of which may be outstanding at once. Writes are collected into batches of adjacent data
+ * which are sent after a short delay, when the batch is full, or on `flush()`.
+ *
+ * The network is asynchronous, so `read()` can only succeed if the data is already cached.
+ * On a miss it starts fetching the data and returns false. Use `readAsync()` or `prefetch()` instead
+ * where possible. Writes and erases are accepted immediately, and fail only if too much data is
+ * waiting to be sent or the connection is closed. Errors reported by the server for written data
+ * are counted and cause the next `flush()` to fail.
+ *
+ * Erasing writes 0xFF, as for flash memory.
+ */
+class Device : public Storage::CustomDevice
+{
+public:
+	static constexpr uint16_t defaultPort{10809};
+
+	using ConnectCallback = Delegate<void(Device& device, bool success)>;
+	using FlushCallback = Delegate<void(bool success)>;
+
+	struct Config {
+		size_t blockSize{4096};		   ///< Reported erase block size
+		size_t lineSize{512};		   ///< Size of each cache line, a power of 2
+		uint8_t lineCount{8};		   ///< Number of cache lines
+		uint8_t maxInFlight{8};		   ///< Maximum requests awaiting a reply
+		uint16_t maxBatchSize{4096};   ///< Largest write request
+		size_t maxWriteBacklog{16384}; ///< Written data not yet acknowledged by the server
+		uint16_t batchDelay{20};	   ///< Milliseconds to wait for more data before sending a write batch
+		uint16_t timeout{5000};		   ///< Milliseconds to wait for a reply before closing the connection
+	};
+
+	struct Stats {
+		uint32_t hits;
+		uint32_t misses;
+		uint32_t readRequests;
+		uint32_t writeRequests;
+		uint32_t writeErrors;
+	};
+
+	Device(const String& name, const Config& config);
+
+	Device(const String& name) : Device(name, Config{})
+	{
+	}
+
+	~Device();
+
+	/**
+	 * @brief Connect to a server
+	 * @param host
+	 * @param port
+	 * @param exportName Name of export to use, empty for the server's default
+	 * @param callback Invoked when the device is ready for use, or the connection fails
+	 * @retval bool false if connection could not be started
+	 */
+	bool connect(const String& host, uint16_t port = defaultPort, const String& exportName = nullptr,
+				 ConnectCallback callback = nullptr);
+
+	/**
+	 * @brief Close the connection
+	 *
+	 * Outstanding reads fail and unsent writes are discarded.
+	 * Use `flush()` first to ensure written data has been committed.
+	 */
+	void close();
+
+	bool isConnected() const
+	{
+		return state == State::ready;
+	}
+
+	bool isReadOnly() const
+	{
+		return readOnly;
+	}
+
+	String getName() const override
+	{
+		return name;
+	}
+
+	size_t getBlockSize() const override
+	{
+		return config.blockSize;
+	}
+
+	size_t getSize() const override
+	{
+		return size;
+	}
+
+	Type getType() const override
+	{
+		return Type::disk;
+	}
+
+	bool read(uint32_t address, void* dst, size_t size) override;
+	bool readAsync(uint32_t address, void* dst, size_t size, Storage::ReadCallback callback) override;
+	bool write(uint32_t address, const void* src, size_t size) override;
+	bool erase_range(uint32_t address, size_t size) override;
+
+	/**
+	 * @brief Load a region into the cache
+	 * @param address
+	 * @param size Must fit within the cache
+	 * @param callback Optional
+	 * @retval bool false if the request could not be started
+	 */
+	bool prefetch(uint32_t address, size_t size, Storage::ReadCallback callback = nullptr)
+	{
+		return readAsync(address, nullptr, size, callback);
+	}
+
+	/**
+	 * @brief Send all written data and ask the server to commit it
+	 * @param callback Invoked when complete, with success false if any write since the last flush failed
+	 * @retval bool false if not connected
+	 */
+	bool flush(FlushCallback callback = nullptr);
+
+	/**
+	 * @brief Discard all cached data
+	 */
+	void invalidate();
+
+	const Stats& getStats() const
+	{
+		return stats;
+	}
+
+	void resetStats()
+	{
+		stats = Stats{};
+	}
+
+private:
+	enum class State {
+		closed,
+		handshake,
+		exportInfo,
+		ready,
+	};
+
+	enum class Command : uint16_t {
+		read = 0,
+		write = 1,
+		disconnect = 2,
+		flush = 3,
+	};
+
+	struct Request : public LinkedObjectTemplate<Request> {
+		using OwnedList = OwnedLinkedObjectListTemplate<Request>;
+
+		Command command;
+		uint32_t handle{0};
+		uint32_t offset;
+		uint32_t length;
+		std::unique_ptr<uint8_t[]> data; ///< Write payload, or data to be cached
+		uint8_t* dst{nullptr};			 ///< Caller's buffer
+		uint32_t dstOffset{0};			 ///< Location of caller's data within `data`
+		uint32_t dstLength{0};
+		Storage::ReadCallback readCallback;
+		FlushCallback flushCallback;
+		uint32_t sentTime{0};
+
+		Request(Command command, uint32_t offset, uint32_t length) : command(command), offset(offset), length(length)
+		{
+		}
+	};
+
+	static constexpr uint32_t invalidAddress{0xffffffff};
+
+	struct Line {
+		uint32_t address{invalidAddress};
+		uint32_t lastUsed{0};
+	};
+
+	bool checkRange(uint32_t address, size_t size) const
+	{
+		return state == State::ready && address < this->size && size <= this->size - address;
+	}
+
+	uint8_t* getLineData(unsigned index)
+	{
+		return &buffer[index * config.lineSize];
+	}
+
+	int findLine(uint32_t address) const;
+	bool readCache(uint32_t address, uint8_t* dst, size_t size);
+	void updateCache(uint32_t address, const uint8_t* src, size_t size);
+	void storeLines(uint32_t address, const uint8_t* src, size_t size);
+	void applyWrites(uint32_t address, uint8_t* dst, size_t size);
+	bool appendWrite(uint32_t address, const void* src, size_t size);
+	void submitBatch();
+	void queue(Request* req);
+	void startNext();
+	bool sendRequest(Request& req);
+	bool onReceive(TcpClient& client, char* data, int size);
+	void onComplete(TcpClient& client, bool successful);
+	bool gather(const uint8_t*& data, size_t& size, size_t required);
+	bool processHandshake();
+	bool processExportInfo();
+	bool processReplyHeader();
+	void completeRequest(Request* req, bool success);
+	void checkTimeouts();
+	void failAll();
+
+	String name;
+	Config config;
+	TcpClient client;
+	String exportName;
+	ConnectCallback connectCallback;
+	Request::OwnedList queued;
+	Request::OwnedList inFlight;
+	std::unique_ptr<Request> batch;
+	Request* rxRequest{nullptr}; ///< Read request receiving data
+	uint32_t rxDataPos{0};
+	Timer batchTimer;
+	Timer pollTimer;
+	std::unique_ptr<Line[]> lines;
+	std::unique_ptr<uint8_t[]> buffer;
+	uint32_t size{0};
+	uint32_t nextHandle{0};
+	uint32_t useCounter{0};
+	size_t writeBacklog{0};
+	Stats stats{};
+	State state{State::closed};
+	uint8_t rxBuffer[18];
+	uint8_t rxLength{0};
+	uint8_t rxSkip{0}; ///< Padding bytes to discard
+	bool noZeroes{false};
+	bool readOnly{false};
+	bool canFlush{false};
+	bool writeFailed{false};
+};
+
+} // namespace Nbd
+
+#endif // DISABLE_NETWORK
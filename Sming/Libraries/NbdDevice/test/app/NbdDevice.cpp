@@ -0,0 +1,237 @@
+#include <SmingTest.h>
+#include <Nbd/Device.h>
+#include <Network/TcpServer.h>
+#include <Platform/Station.h>
+
+namespace
+{
+constexpr uint16_t serverPort{10809};
+constexpr size_t imageSize{65536};
+
+uint32_t getBE32(const uint8_t* p)
+{
+	return (p[0] << 24) | (p[1] << 16) | (p[2] << 8) | p[3];
+}
+
+void putBE32(uint8_t* p, uint32_t value)
+{
+	p[0] = value >> 24;
+	p[1] = value >> 16;
+	p[2] = value >> 8;
+	p[3] = value;
+}
+
+/*
+ * Minimal NBD server for a RAM image, handling one client
+ */
+class TestServer
+{
+public:
+	TestServer()
+		: server(TcpClientConnectDelegate(&TestServer::onConnect, this),
+				 TcpClientDataDelegate(&TestServer::onReceive, this), nullptr)
+	{
+		for(unsigned i = 0; i < imageSize; ++i) {
+			image[i] = i * 13;
+		}
+	}
+
+	bool listen()
+	{
+		server.setTimeOut(USHRT_MAX);
+		return server.listen(serverPort);
+	}
+
+	void shutdown()
+	{
+		server.shutdown();
+	}
+
+	uint8_t image[imageSize];
+	unsigned requestCount{0};
+	unsigned flushCount{0};
+
+private:
+	void onConnect(TcpClient* client)
+	{
+		// NBDMAGIC, IHAVEOPT, FIXED_NEWSTYLE | NO_ZEROES
+		const uint8_t hello[]{'N', 'B', 'D', 'M', 'A', 'G', 'I', 'C', 'I', 'H', 'A', 'V', 'E', 'O', 'P', 'T', 0, 3};
+		client->send(reinterpret_cast<const char*>(hello), sizeof(hello));
+		rx = nullptr;
+		negotiated = false;
+	}
+
+	bool onReceive(TcpClient& client, char* data, int size)
+	{
+		rx.concat(data, size);
+		auto p = reinterpret_cast<const uint8_t*>(rx.c_str());
+		unsigned pos = 0;
+
+		if(!negotiated) {
+			// Client flags, IHAVEOPT, option, length, name
+			if(rx.length() < 20 || rx.length() < 20 + getBE32(&p[16])) {
+				return true;
+			}
+			pos = 20 + getBE32(&p[16]);
+			// Size (64 bits), flags HAS_FLAGS | SEND_FLUSH
+			uint8_t info[10]{};
+			putBE32(&info[4], imageSize);
+			info[9] = 0x05;
+			client.send(reinterpret_cast<const char*>(info), sizeof(info));
+			negotiated = true;
+		}
+
+		while(rx.length() - pos >= 28) {
+			auto hdr = &p[pos];
+			auto type = hdr[7];
+			auto offset = getBE32(&hdr[20]);
+			auto length = getBE32(&hdr[24]);
+			if(type == 1 && rx.length() - pos < 28 + length) {
+				break;
+			}
+			++requestCount;
+
+			uint8_t reply[16]{0x67, 0x44, 0x66, 0x98};
+			memcpy(&reply[8], &hdr[8], 8);
+			client.send(reinterpret_cast<const char*>(reply), sizeof(reply));
+			switch(type) {
+			case 0:
+				client.send(reinterpret_cast<const char*>(&image[offset]), length);
+				break;
+			case 1:
+				memcpy(&image[offset], &hdr[28], length);
+				pos += length;
+				break;
+			case 3:
+				++flushCount;
+				break;
+			}
+			pos += 28;
+		}
+
+		rx.remove(0, pos);
+		return true;
+	}
+
+	TcpServer server;
+	String rx;
+	bool negotiated{false};
+};
+
+} // namespace
+
+class NbdDeviceTest : public TestGroup
+{
+public:
+	NbdDeviceTest() : TestGroup(_F("NbdDevice"))
+	{
+	}
+
+	void execute() override
+	{
+		if(!WifiStation.isConnected()) {
+			Serial.println("No network, skipping tests");
+			return;
+		}
+
+		REQUIRE(server.listen());
+
+		Nbd::Device::Config config;
+		config.lineSize = 256;
+		config.lineCount = 8;
+		device.reset(new Nbd::Device(F("nbd0"), config));
+
+		TEST_CASE("Connect")
+		{
+			bool ok = device->connect(WifiStation.getIP().toString(), serverPort, nullptr,
+									  [this](Nbd::Device& dev, bool success) {
+										  REQUIRE(success);
+										  REQUIRE_EQ(dev.getSize(), imageSize);
+										  REQUIRE(!dev.isReadOnly());
+										  testRead();
+									  });
+			REQUIRE(ok);
+			pending();
+		}
+	}
+
+	void testRead()
+	{
+		TEST_CASE("Read")
+		{
+			// Not cached yet
+			REQUIRE(!device->read(1000, buffer, 300));
+			REQUIRE(device->readAsync(100, buffer, sizeof(buffer), [this](bool success) {
+				REQUIRE(success);
+				REQUIRE(memcmp(buffer, &server.image[100], sizeof(buffer)) == 0);
+				// Now it is
+				uint8_t tmp[300];
+				REQUIRE(device->read(1000, tmp, sizeof(tmp)));
+				REQUIRE(memcmp(tmp, &server.image[1000], sizeof(tmp)) == 0);
+				REQUIRE(device->getStats().hits != 0);
+				testWrite();
+			}));
+		}
+	}
+
+	void testWrite()
+	{
+		TEST_CASE("Write")
+		{
+			for(unsigned i = 0; i < sizeof(buffer); ++i) {
+				buffer[i] = i;
+			}
+			// Cached region is updated immediately
+			REQUIRE(device->write(1100, buffer, 100));
+			uint8_t tmp[100];
+			REQUIRE(device->read(1100, tmp, sizeof(tmp)));
+			REQUIRE(memcmp(tmp, buffer, sizeof(tmp)) == 0);
+
+			// Adjacent writes are batched: this sends the previous write, then two requests
+			auto requests = device->getStats().writeRequests;
+			REQUIRE(device->write(40000, buffer, 1000));
+			REQUIRE(device->write(41000, buffer, 1000));
+			REQUIRE(device->erase_range(50000, 4096));
+
+			// Reads see writes which haven't yet been sent
+			REQUIRE(device->readAsync(40900, readBuffer, 200, [this](bool success) {
+				REQUIRE(success);
+				REQUIRE(memcmp(readBuffer, &buffer[900], 100) == 0);
+				REQUIRE(memcmp(&readBuffer[100], buffer, 100) == 0);
+			}));
+			REQUIRE_EQ(device->getStats().writeRequests, requests + 3);
+
+			REQUIRE(device->flush([this](bool success) {
+				REQUIRE(success);
+				REQUIRE_EQ(server.flushCount, 1);
+				REQUIRE(memcmp(&server.image[1100], buffer, 100) == 0);
+				REQUIRE(memcmp(&server.image[40000], buffer, 1000) == 0);
+				REQUIRE(memcmp(&server.image[41000], buffer, 1000) == 0);
+				for(unsigned i = 50000; i < 50000 + 4096; ++i) {
+					REQUIRE_EQ(server.image[i], 0xff);
+				}
+				shutdown();
+			}));
+		}
+	}
+
+	void shutdown()
+	{
+		device->close();
+		server.shutdown();
+		timer.initializeMs<500>([this]() { complete(); });
+		timer.startOnce();
+	}
+
+private:
+	TestServer server;
+	std::unique_ptr<Nbd::Device> device;
+	uint8_t buffer[1024];
+	uint8_t readBuffer[200];
+	Timer timer;
+};
+
+void REGISTER_TEST(NbdDevice)
+{
+	registerGroup<NbdDeviceTest>();
+}
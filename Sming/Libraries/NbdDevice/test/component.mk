@@ -0,0 +1,9 @@
+ARDUINO_LIBRARIES := \
+	SmingTest \
+	NbdDevice
+
+#
+DEBUG_VERBOSE_LEVEL := 2
+
+.PHONY: execute
+execute: flash run
@@ -2,5 +2,5 @@ COMPONENT_SUBMODULES := esp-nimble-cpp
 
 COMPONENT_SOC := esp32 esp32c3 esp32s3
 
-COMPONENT_SRCDIRS := esp-nimble-cpp/src
+COMPONENT_SRCDIRS := esp-nimble-cpp/src src
 COMPONENT_INCDIRS := $(COMPONENT_SRCDIRS)
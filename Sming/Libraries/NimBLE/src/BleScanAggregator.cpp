@@ -0,0 +1,312 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/SmingHub/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * BleScanAggregator.cpp
+ *
+ ****/
+
+#include "BleScanAggregator.h"
+#include <debug_progmem.h>
+#include <algorithm>
+
+namespace
+{
+// Marks an unused table entry
+constexpr uint8_t emptySlot{0xff};
+// Marks a new entry with no RSSI average yet
+constexpr int16_t noRssi{INT16_MIN};
+
+unsigned hashAddress(const ble_addr_t& address)
+{
+	// FNV-1a
+	uint32_t hash{2166136261U};
+	auto add = [&](uint8_t c) {
+		hash ^= c;
+		hash *= 16777619U;
+	};
+	add(address.type);
+	for(auto c : address.val) {
+		add(c);
+	}
+	return hash;
+}
+
+bool operator==(const ble_addr_t& a1, const ble_addr_t& a2)
+{
+	return a1.type == a2.type && memcmp(a1.val, a2.val, sizeof(a1.val)) == 0;
+}
+
+} // namespace
+
+bool BleScanAggregator::begin(const Config& config, Callback callback)
+{
+	end();
+
+	if(!callback || config.capacity == 0 || config.interval == 0) {
+		return false;
+	}
+
+	unsigned size{1};
+	while(size < config.capacity) {
+		size <<= 1;
+	}
+	std::unique_ptr<Device[]> newTable(new(std::nothrow) Device[size]);
+	std::unique_ptr<Device[]> newBatch(new(std::nothrow) Device[size]);
+	if(!newTable || !newBatch) {
+		debug_e("[BLE] Scan table allocation failed");
+		return false;
+	}
+	for(unsigned i = 0; i < size; ++i) {
+		newTable[i].address.type = emptySlot;
+	}
+
+	this->config = config;
+	this->callback = callback;
+	portENTER_CRITICAL(&lock);
+	table = std::move(newTable);
+	batch = std::move(newBatch);
+	mask = size - 1;
+	deviceCount = 0;
+	stats = {};
+	portEXIT_CRITICAL(&lock);
+
+	ble_gap_disc_params params{};
+	params.passive = !config.active;
+	// Controller de-duplication would also suppress RSSI updates
+	params.filter_duplicates = 0;
+	int rc = ble_gap_disc(config.ownAddrType, BLE_HS_FOREVER, &params, gapEvent, this);
+	if(rc != 0) {
+		debug_e("[BLE] Scan start failed (%d)", rc);
+		end();
+		return false;
+	}
+
+	timer.initializeMs(config.interval, TimerDelegate(&BleScanAggregator::snapshot, this)).start();
+	return true;
+}
+
+void BleScanAggregator::end()
+{
+	if(!table) {
+		return;
+	}
+
+	timer.stop();
+	ble_gap_disc_cancel();
+
+	// Host task may still be handling an event, so don't free memory inside the lock
+	portENTER_CRITICAL(&lock);
+	auto oldTable = table.release();
+	auto oldBatch = batch.release();
+	deviceCount = 0;
+	portEXIT_CRITICAL(&lock);
+	delete[] oldTable;
+	delete[] oldBatch;
+}
+
+bool BleScanAggregator::setFilter(uint8_t adType, const void* prefix, size_t length)
+{
+	if(length > maxFilterLength) {
+		return false;
+	}
+
+	portENTER_CRITICAL(&lock);
+	filter.adType = adType;
+	filter.length = length;
+	if(length != 0) {
+		memcpy(filter.prefix, prefix, length);
+	}
+	filterEnabled = true;
+	portEXIT_CRITICAL(&lock);
+	return true;
+}
+
+void BleScanAggregator::clearFilter()
+{
+	portENTER_CRITICAL(&lock);
+	filterEnabled = false;
+	portEXIT_CRITICAL(&lock);
+}
+
+BleScanAggregator::Stats BleScanAggregator::getStats() const
+{
+	portENTER_CRITICAL(&lock);
+	Stats s = stats;
+	portEXIT_CRITICAL(&lock);
+	return s;
+}
+
+int BleScanAggregator::gapEvent(ble_gap_event* event, void* arg)
+{
+	auto self = static_cast<BleScanAggregator*>(arg);
+	switch(event->type) {
+	case BLE_GAP_EVENT_DISC:
+		self->handleAdvertisement(event->disc);
+		break;
+	case BLE_GAP_EVENT_DISC_COMPLETE:
+		debug_w("[BLE] Scan stopped (%d)", event->disc_complete.reason);
+		break;
+	default:
+		break;
+	}
+	return 0;
+}
+
+/*
+ * Called in NimBLE host task context
+ */
+void BleScanAggregator::handleAdvertisement(const ble_gap_disc_desc& desc)
+{
+	auto now = millis();
+	auto length = std::min(desc.length_data, uint8_t(BLE_HS_ADV_MAX_SZ));
+
+	portENTER_CRITICAL(&lock);
+
+	if(!table) {
+		portEXIT_CRITICAL(&lock);
+		return;
+	}
+
+	++stats.received;
+	if(desc.rssi < config.minRssi || (filterEnabled && !matchFilter(desc.data, length))) {
+		++stats.filtered;
+		portEXIT_CRITICAL(&lock);
+		return;
+	}
+
+	auto device = findDevice(desc.addr, true);
+	if(device == nullptr) {
+		++stats.dropped;
+		portEXIT_CRITICAL(&lock);
+		return;
+	}
+
+	if(device->rssiAverage == noRssi) {
+		device->rssiAverage = desc.rssi * 16;
+	} else {
+		// Exponential moving average, weight 1/4
+		device->rssiAverage += (desc.rssi * 16 - device->rssiAverage) / 4;
+	}
+	device->lastRssi = desc.rssi;
+	device->lastSeen = now;
+	if(device->count < UINT16_MAX) {
+		++device->count;
+	}
+	// Scan responses carry different data so don't overwrite the advertisement with them
+	if(desc.event_type != BLE_HCI_ADV_RPT_EVTYPE_SCAN_RSP || device->dataLength == 0) {
+		device->dataLength = length;
+		memcpy(device->data, desc.data, length);
+	}
+
+	portEXIT_CRITICAL(&lock);
+}
+
+bool BleScanAggregator::matchFilter(const uint8_t* data, size_t length) const
+{
+	// Advertising data is a sequence of [length][type][value...] structures
+	unsigned offset{0};
+	while(offset + 1 < length) {
+		uint8_t fieldLength = data[offset];
+		if(fieldLength == 0 || offset + 1 + fieldLength > length) {
+			break;
+		}
+		uint8_t type = data[offset + 1];
+		uint8_t valueLength = fieldLength - 1;
+		if(type == filter.adType && valueLength >= filter.length &&
+		   memcmp(&data[offset + 2], filter.prefix, filter.length) == 0) {
+			return true;
+		}
+		offset += 1 + fieldLength;
+	}
+	return false;
+}
+
+BleScanAggregator::Device* BleScanAggregator::findDevice(const ble_addr_t& address, bool create)
+{
+	// Linear probing, keeping the table no more than 3/4 full so searches stay short
+	auto index = hashAddress(address) & mask;
+	for(;;) {
+		auto& device = table[index];
+		if(device.address.type == emptySlot) {
+			break;
+		}
+		if(device.address == address) {
+			return &device;
+		}
+		index = (index + 1) & mask;
+	}
+
+	if(!create || deviceCount >= (mask + 1) * 3 / 4) {
+		return nullptr;
+	}
+
+	auto& device = table[index];
+	device = Device{};
+	device.address = address;
+	device.rssiAverage = noRssi;
+	++deviceCount;
+	return &device;
+}
+
+void BleScanAggregator::removeDevice(unsigned index)
+{
+	// Shift following entries back so lookups don't stop early at the gap
+	unsigned next = index;
+	for(;;) {
+		table[index].address.type = emptySlot;
+		for(;;) {
+			next = (next + 1) & mask;
+			auto& device = table[next];
+			if(device.address.type == emptySlot) {
+				--deviceCount;
+				return;
+			}
+			auto home = hashAddress(device.address) & mask;
+			bool inPlace = (index <= next) ? (index < home && home <= next) : (index < home || home <= next);
+			if(!inPlace) {
+				break;
+			}
+		}
+		table[index] = table[next];
+		index = next;
+	}
+}
+
+void BleScanAggregator::snapshot()
+{
+	auto now = millis();
+	unsigned count{0};
+
+	portENTER_CRITICAL(&lock);
+	if(!table) {
+		portEXIT_CRITICAL(&lock);
+		return;
+	}
+	for(unsigned i = 0; i <= mask;) {
+		auto& device = table[i];
+		if(device.address.type == emptySlot) {
+			++i;
+			continue;
+		}
+		if(device.count != 0) {
+			batch[count++] = device;
+			device.count = 0;
+		} else if(now - device.lastSeen > config.expiry) {
+			// Slot is refilled by the following entry, if any, so check it again
+			removeDevice(i);
+			continue;
+		}
+		++i;
+	}
+	if(count != 0) {
+		++stats.snapshots;
+	}
+	portEXIT_CRITICAL(&lock);
+
+	if(count != 0) {
+		callback(batch.get(), count);
+	}
+}
@@ -0,0 +1,141 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/SmingHub/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * BleScanAggregator.h - Batched BLE advertisement scanning
+ *
+ ****/
+
+#pragma once
+
+#include <NimBLEDevice.h>
+#include <Timer.h>
+#include <Delegate.h>
+#include <memory>
+
+/**
+ * @brief Scans for BLE advertisements and reports them in periodic batches
+ *
+ * Advertisements are handled directly in the NimBLE host task without allocating memory.
+ * Those which pass the filter are merged into a fixed-capacity table keyed by device address,
+ * keeping the latest advertising data and a smoothed RSSI.
+ * At each interval a snapshot of devices heard since the previous one is passed to the
+ * application callback in task context.
+ *
+ * Memory use is fixed when scanning starts: two tables of `capacity` devices.
+ * Devices not heard from for `expiry` milliseconds are removed to make room for new ones;
+ * advertisements from new devices which don't fit are dropped and counted.
+ *
+ * @note Uses the GAP discovery procedure directly, so don't run NimBLEScan at the same time.
+ */
+class BleScanAggregator
+{
+public:
+	struct Config {
+		uint16_t capacity{64};   ///< Maximum number of devices tracked, rounded up to a power of 2
+		uint16_t interval{1000}; ///< Milliseconds between snapshots
+		uint16_t expiry{10000};  ///< Forget devices not heard from for this many milliseconds
+		int8_t minRssi{-127};	///< Ignore weaker advertisements
+		bool active{false};		 ///< Request scan responses
+		uint8_t ownAddrType{BLE_OWN_ADDR_PUBLIC};
+	};
+
+	struct Device {
+		ble_addr_t address;
+		uint32_t lastSeen;	///< Time of latest advertisement, from millis()
+		uint16_t count;		  ///< Advertisements received since previous snapshot
+		int16_t rssiAverage;  ///< Smoothed RSSI, 1/16 dB units
+		int8_t lastRssi;	  ///< RSSI of latest advertisement
+		uint8_t dataLength;   ///< Length of latest advertising data
+		uint8_t data[BLE_HS_ADV_MAX_SZ];
+
+		/**
+		 * @brief Smoothed RSSI in dB
+		 */
+		int8_t getRssi() const
+		{
+			return (rssiAverage - 8) / 16;
+		}
+	};
+
+	/**
+	 * @brief Invoked in task context with devices heard since the previous snapshot
+	 * @param devices Valid only until callback returns
+	 * @param count Number of devices
+	 */
+	using Callback = Delegate<void(const Device* devices, size_t count)>;
+
+	struct Stats {
+		uint32_t received;  ///< Advertisements received
+		uint32_t filtered;  ///< Advertisements rejected by filter or RSSI threshold
+		uint32_t dropped;   ///< Advertisements from new devices which didn't fit in the table
+		uint32_t snapshots; ///< Number of times callback was invoked
+	};
+
+	~BleScanAggregator()
+	{
+		end();
+	}
+
+	/**
+	 * @brief Start scanning
+	 * @param config
+	 * @param callback
+	 * @retval bool true on success
+	 * @note NimBLEDevice::init() must have been called first
+	 */
+	bool begin(const Config& config, Callback callback);
+
+	/**
+	 * @brief Stop scanning and release memory
+	 */
+	void end();
+
+	bool isScanning() const
+	{
+		return bool(table);
+	}
+
+	/**
+	 * @brief Only accept advertisements containing a matching AD structure
+	 * @param adType AD structure type, e.g. BLE_HS_ADV_TYPE_MFG_DATA
+	 * @param prefix Data which the AD structure value must start with
+	 * @param length Length of prefix, up to `maxFilterLength`
+	 * @retval bool false if prefix is too long
+	 */
+	bool setFilter(uint8_t adType, const void* prefix = nullptr, size_t length = 0);
+
+	void clearFilter();
+
+	Stats getStats() const;
+
+	static constexpr size_t maxFilterLength{16};
+
+private:
+	struct Filter {
+		uint8_t adType;
+		uint8_t length;
+		uint8_t prefix[maxFilterLength];
+	};
+
+	static int gapEvent(ble_gap_event* event, void* arg);
+	void handleAdvertisement(const ble_gap_disc_desc& desc);
+	bool matchFilter(const uint8_t* data, size_t length) const;
+	Device* findDevice(const ble_addr_t& address, bool create);
+	void removeDevice(unsigned index);
+	void snapshot();
+
+	Config config;
+	Callback callback;
+	Filter filter{};
+	bool filterEnabled{false};
+	Stats stats{};
+	std::unique_ptr<Device[]> table;
+	std::unique_ptr<Device[]> batch;
+	unsigned mask{0};
+	unsigned deviceCount{0};
+	Timer timer;
+	mutable portMUX_TYPE lock = portMUX_INITIALIZER_UNLOCKED;
+};
@@ -0,0 +1,307 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/SmingHub/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * OneWireAsync.cpp
+ *
+ * Slot timings follow those used by OneWire.cpp.
+ *
+ ****/
+
+#include "OneWireAsync.h"
+#include "OneWire.h"
+#include <Platform/System.h>
+#include <Digital.h>
+#include <Clock.h>
+
+namespace
+{
+constexpr uint8_t CMD_SEARCH_ROM{0xF0};
+
+} // namespace
+
+void OneWireAsync::begin(uint8_t pin)
+{
+	end();
+	this->pin = pin;
+	release();
+	noPullup(pin);
+	timer.setCallback(timerCallback, this);
+	resetSearch();
+}
+
+void OneWireAsync::end()
+{
+	if(pin == invalidPin) {
+		return;
+	}
+	timer.stop();
+	state = State::idle;
+	release();
+}
+
+void OneWireAsync::depower()
+{
+	if(!isBusy()) {
+		release();
+	}
+}
+
+bool OneWireAsync::transaction(const void* txData, uint8_t txLength, uint8_t rxLength, Callback callback, bool reset,
+							   bool power)
+{
+	if(isBusy() || txLength > maxBytes || rxLength > maxBytes || (txLength != 0 && txData == nullptr)) {
+		return false;
+	}
+
+	memcpy(data, txData, txLength);
+	txBits = txLength * 8;
+	totalBits = txBits + rxLength * 8;
+	searching = false;
+	this->power = power;
+	this->callback = callback;
+	return start(reset);
+}
+
+void OneWireAsync::resetSearch()
+{
+	lastDiscrepancy = 0;
+	lastDevice = false;
+	memset(rom, 0, sizeof(rom));
+}
+
+bool OneWireAsync::searchNext(Callback callback)
+{
+	if(isBusy() || lastDevice) {
+		return false;
+	}
+
+	data[0] = CMD_SEARCH_ROM;
+	txBits = 8;
+	// Each ROM bit takes three slots: read bit, read complement, write direction
+	totalBits = txBits + 64 * 3;
+	searching = true;
+	lastZero = 0;
+	power = false;
+	this->callback = callback;
+	return start(true);
+}
+
+bool OneWireAsync::start(bool reset)
+{
+	bitIndex = 0;
+	result = false;
+
+	// Wait for bus to be released, in case of a short
+	release();
+	unsigned retries = 125;
+	while(!readPin()) {
+		if(--retries == 0) {
+			return false;
+		}
+		delayMicroseconds(2);
+	}
+
+	if(reset) {
+		state = State::resetRelease;
+		driveLow();
+		timer.setIntervalUs<480>();
+	} else {
+		state = State::slot;
+		timer.setIntervalUs<MIN_HW_TIMER1_INTERVAL_US>();
+	}
+	timer.startOnce();
+	return true;
+}
+
+void OneWireAsync::timerCallback(void* param)
+{
+	static_cast<OneWireAsync*>(param)->service();
+}
+
+void OneWireAsync::service()
+{
+	switch(state) {
+	case State::resetRelease:
+		release();
+		state = State::resetSample;
+		timer.setIntervalUs<70>();
+		timer.startOnce();
+		break;
+
+	case State::resetSample:
+		if(readPin()) {
+			// No presence pulse
+			finish(false);
+			break;
+		}
+		state = State::slot;
+		timer.setIntervalUs<410>();
+		timer.startOnce();
+		break;
+
+	case State::writeZeroRelease:
+		release();
+		delayMicroseconds(5);
+		state = State::slot;
+		nextSlot();
+		break;
+
+	case State::slot:
+		nextSlot();
+		break;
+
+	default:;
+	}
+}
+
+void OneWireAsync::nextSlot()
+{
+	if(bitIndex >= totalBits) {
+		finish(true);
+		return;
+	}
+
+	bool isWrite;
+	bool value{false};
+	unsigned rxIndex{0};
+	if(bitIndex < txBits) {
+		isWrite = true;
+		value = (data[bitIndex / 8] >> (bitIndex % 8)) & 1;
+	} else if(searching) {
+		isWrite = ((bitIndex - txBits) % 3) == 2;
+		if(isWrite && !nextSearchBit(value)) {
+			finish(false);
+			return;
+		}
+	} else {
+		isWrite = false;
+		rxIndex = bitIndex - txBits;
+		if(rxIndex % 8 == 0) {
+			data[rxIndex / 8] = 0;
+		}
+	}
+
+	if(isWrite) {
+		driveLow();
+		if(value) {
+			delayMicroseconds(6);
+			release();
+			timer.setIntervalUs<64>();
+		} else {
+			state = State::writeZeroRelease;
+			timer.setIntervalUs<60>();
+		}
+	} else {
+		driveLow();
+		delayMicroseconds(3);
+		release();
+		delayMicroseconds(9);
+		bool bit = readPin();
+		if(!searching) {
+			data[rxIndex / 8] |= bit << (rxIndex % 8);
+		} else if((bitIndex - txBits) % 3 == 0) {
+			idBit = bit;
+		} else {
+			idBit |= bit << 1;
+		}
+		timer.setIntervalUs<53>();
+	}
+
+	++bitIndex;
+	timer.startOnce();
+}
+
+/*
+ * Decide search direction, as described in Maxim application note 187
+ */
+bool OneWireAsync::nextSearchBit(bool& value)
+{
+	unsigned bitNumber = 1 + (bitIndex - txBits) / 3;
+	bool id = idBit & 0x01;
+	bool cmp = idBit & 0x02;
+
+	if(id && cmp) {
+		// No devices participating
+		return false;
+	}
+
+	uint8_t& romByte = rom[(bitNumber - 1) / 8];
+	uint8_t romMask = 1 << ((bitNumber - 1) % 8);
+	if(id != cmp) {
+		value = id;
+	} else {
+		if(bitNumber < lastDiscrepancy) {
+			value = romByte & romMask;
+		} else {
+			value = (bitNumber == lastDiscrepancy);
+		}
+		if(!value) {
+			lastZero = bitNumber;
+		}
+	}
+
+	if(value) {
+		romByte |= romMask;
+	} else {
+		romByte &= ~romMask;
+	}
+	return true;
+}
+
+void OneWireAsync::finish(bool success)
+{
+	timer.stop();
+	if(power) {
+		digitalWrite(pin, HIGH);
+		pinMode(pin, OUTPUT);
+	} else {
+		release();
+	}
+	result = success;
+	state = State::complete;
+	System.queueCallback(taskCallback, this);
+}
+
+void OneWireAsync::taskCallback(void* param)
+{
+	auto self = static_cast<OneWireAsync*>(param);
+	if(self->state != State::complete) {
+		// Aborted
+		return;
+	}
+
+	bool success = self->result;
+	if(self->searching) {
+		if(success && OneWire::crc8(self->rom, 7) == self->rom[7] && self->rom[0] != 0) {
+			self->lastDiscrepancy = self->lastZero;
+			self->lastDevice = (self->lastDiscrepancy == 0);
+		} else {
+			success = false;
+			self->resetSearch();
+		}
+	}
+
+	self->state = State::idle;
+	if(self->callback) {
+		self->callback(success);
+	}
+}
+
+void OneWireAsync::driveLow()
+{
+	digitalWrite(pin, LOW);
+	pinMode(pin, OUTPUT);
+}
+
+void OneWireAsync::release()
+{
+	pinMode(pin, INPUT);
+}
+
+bool OneWireAsync::readPin()
+{
+	return digitalRead(pin);
+}
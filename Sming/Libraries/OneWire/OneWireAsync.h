@@ -0,0 +1,149 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/SmingHub/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * OneWireAsync.h - Interrupt-driven 1-Wire bus engine
+ *
+ ****/
+
+#pragma once
+
+#include <HardwareTimer.h>
+#include <Delegate.h>
+
+/**
+ * @brief Non-blocking 1-Wire bus master
+ *
+ * Bus transactions are run by a hardware timer interrupt, one time slot per interrupt.
+ * The CPU is busy for at most about 12us per slot, instead of the whole transaction,
+ * so a 480us reset pulse or a long read does not stall the main loop.
+ * Completion callbacks are queued and run in task context.
+ *
+ * A transaction consists of an optional reset, a number of bytes to write then a number of bytes to read.
+ * Only one transaction may be in progress at a time.
+ *
+ * @note This class uses the Timer1 hardware timer, so cannot be used at the same time as
+ * other users of that timer, such as the Servo library. Only one instance may be active.
+ */
+class OneWireAsync
+{
+public:
+	using Timer = HardwareTimer1<TIMER_CLKDIV_16, eHWT_Maskable>;
+
+	/**
+	 * @brief Callback invoked when a transaction has completed
+	 * @param success false if no device responded, or search failed
+	 */
+	using Callback = Delegate<void(bool success)>;
+
+	static constexpr uint8_t maxBytes{16}; ///< Maximum data in either direction
+
+	/**
+	 * @brief Prepare bus for use
+	 * @param pin GPIO, which requires an external pull-up resistor
+	 */
+	void begin(uint8_t pin);
+
+	/**
+	 * @brief Abort any transaction and release the bus
+	 */
+	void end();
+
+	/**
+	 * @brief Determine if a transaction is in progress
+	 */
+	bool isBusy() const
+	{
+		return state != State::idle;
+	}
+
+	/**
+	 * @brief Start a transaction
+	 * @param txData Bytes to write, e.g. ROM and function commands
+	 * @param txLength Number of bytes to write
+	 * @param rxLength Number of bytes to read after writing, available from `getData()`
+	 * @param callback Invoked on completion
+	 * @param reset Issue a reset first. The transaction fails if no device responds.
+	 * @param power Drive the bus high on completion, for parasite-powered devices.
+	 * 		  This is released at the start of the next transaction or by calling `depower()`.
+	 * @retval bool false if busy or parameters are invalid
+	 */
+	bool transaction(const void* txData, uint8_t txLength, uint8_t rxLength, Callback callback, bool reset = true,
+					 bool power = false);
+
+	/**
+	 * @brief Stop driving the bus high after a powered transaction
+	 */
+	void depower();
+
+	/**
+	 * @brief Get data read by the last transaction
+	 */
+	const uint8_t* getData() const
+	{
+		return data;
+	}
+
+	/**
+	 * @brief Clear search state so next search starts from the beginning
+	 */
+	void resetSearch();
+
+	/**
+	 * @brief Search for the next device on the bus
+	 * @param callback Invoked on completion. On success the ROM code is available from `getRom()`.
+	 * @retval bool false if busy or search has completed
+	 */
+	bool searchNext(Callback callback);
+
+	/**
+	 * @brief Get ROM code of device found by last successful search
+	 */
+	const uint8_t* getRom() const
+	{
+		return rom;
+	}
+
+private:
+	static constexpr uint8_t invalidPin{0xff};
+
+	enum class State : uint8_t {
+		idle,
+		resetRelease,
+		resetSample,
+		slot,
+		writeZeroRelease,
+		complete,
+	};
+
+	static void IRAM_ATTR timerCallback(void* param);
+	static void taskCallback(void* param);
+	bool start(bool reset);
+	void IRAM_ATTR service();
+	void IRAM_ATTR nextSlot();
+	bool IRAM_ATTR nextSearchBit(bool& value);
+	void IRAM_ATTR finish(bool success);
+	void IRAM_ATTR driveLow();
+	void IRAM_ATTR release();
+	bool IRAM_ATTR readPin();
+
+	Timer timer;
+	Callback callback;
+	uint8_t data[maxBytes];
+	uint8_t rom[8]{};
+	uint8_t pin{invalidPin};
+	uint16_t bitIndex{0};
+	uint16_t txBits{0};
+	uint16_t totalBits{0};
+	bool searching{false};
+	bool power{false};
+	volatile State state{State::idle};
+	volatile bool result{false};
+	// Search state
+	uint8_t idBit;
+	uint8_t lastZero;
+	uint8_t lastDiscrepancy{0};
+	bool lastDevice{false};
+};
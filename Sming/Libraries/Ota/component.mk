@@ -13,6 +13,8 @@ COMPONENT_INCDIRS := \
         src/include \
         src/Arch/$(COMPONENT_ARCH)/include
 
+COMPONENT_DEPENDS := crypto
+
 ifeq ($(COMPONENT_ARCH),Esp8266)
 	COMPONENT_DEPENDS += rboot
 endif
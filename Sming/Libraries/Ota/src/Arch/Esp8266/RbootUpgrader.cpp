@@ -9,6 +9,8 @@
  ****/
 
 #include "include/Ota/RbootUpgrader.h"
+#include <esp_spi_flash.h>
+#include <algorithm>
 
 using namespace Storage;
 
@@ -23,12 +25,37 @@ bool RbootUpgrader::begin(Partition partition, size_t size)
 	status = rboot_write_init(partition.address());
 
 	maxSize = size ?: partition.size();
+	endAddress = partition.address() + maxSize;
+	eraseTimer.initializeMs<1>(staticEraseAhead, this);
 
 	writtenSoFar = 0;
 
 	return true;
 }
 
+void RbootUpgrader::eraseAhead()
+{
+	erasePending = false;
+
+	uint32_t writeAddress = status.start_addr + status.extra_count;
+	uint32_t limit = std::min(writeAddress + eraseAheadDistance, endAddress);
+	uint32_t sector = status.last_sector_erased + 1;
+	uint32_t address = sector * INTERNAL_FLASH_SECTOR_SIZE;
+	if(address >= limit) {
+		return;
+	}
+
+	if(!flashmem_erase_sector(sector)) {
+		return;
+	}
+	status.last_sector_erased = sector;
+
+	// Yield between sectors
+	if(address + INTERNAL_FLASH_SECTOR_SIZE < limit) {
+		erasePending = eraseTimer.startOnce();
+	}
+}
+
 size_t RbootUpgrader::write(const uint8_t* buffer, size_t size)
 {
 	if(writtenSoFar + size > maxSize) {
@@ -43,6 +70,11 @@ size_t RbootUpgrader::write(const uint8_t* buffer, size_t size)
 
 	writtenSoFar += size;
 
+	// Delay allows network stack to acknowledge data first
+	if(eraseAheadDistance != 0 && !erasePending) {
+		erasePending = eraseTimer.startOnce();
+	}
+
 	return size;
 }
 
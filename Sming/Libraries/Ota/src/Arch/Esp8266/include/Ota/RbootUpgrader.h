@@ -13,6 +13,7 @@
 #pragma once
 #include <Ota/UpgraderBase.h>
 #include <rboot-api.h>
+#include <SimpleTimer.h>
 
 namespace Ota
 {
@@ -22,14 +23,23 @@ namespace Ota
 class RbootUpgrader : public UpgraderBase
 {
 public:
+	static constexpr size_t defaultEraseAhead{0x1000};
+
 	/**
 	 * @brief Prepare the partition for
 	 */
 	bool begin(Partition partition, size_t size = 0) override;
 	size_t write(const uint8_t* buffer, size_t size) override;
 
+	void setEraseAhead(size_t distance) override
+	{
+		eraseAheadDistance = distance;
+	}
+
 	bool end() override
 	{
+		eraseTimer.stop();
+		erasePending = false;
 		return rboot_write_end(&status);
 	}
 
@@ -62,9 +72,24 @@ public:
 	}
 
 private:
+	/*
+	 * rboot erases each sector when the first write to it arrives. Instead, erase sectors ahead of the
+	 * write position, one at a time, between writes so they're ready before more data is received.
+	 */
+	static void staticEraseAhead(void* param)
+	{
+		static_cast<RbootUpgrader*>(param)->eraseAhead();
+	}
+
+	void eraseAhead();
+
 	rboot_write_status status{};
+	SimpleTimer eraseTimer;
+	uint32_t endAddress{0};
+	uint32_t eraseAheadDistance{defaultEraseAhead};
 	size_t maxSize{0};
 	size_t writtenSoFar{0};
+	bool erasePending{false};
 };
 
 } // namespace Ota
@@ -0,0 +1,201 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/SmingHub/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * PatchOutputStream.cpp
+ *
+ *
+ */
+
+#include "include/Ota/PatchOutputStream.h"
+#include <Platform/WDT.h>
+#include <debug_progmem.h>
+#include <algorithm>
+
+namespace
+{
+constexpr uint32_t copyBufferSize{256};
+}
+
+namespace Ota
+{
+void PatchOutputStream::setError(const char* message)
+{
+	debug_e("[OTA] Patch: %s", message);
+	state = State::Error;
+}
+
+bool PatchOutputStream::collect(void* dest, size_t length, const uint8_t*& data, size_t& size)
+{
+	auto n = std::min(length - received, size);
+	memcpy(static_cast<uint8_t*>(dest) + received, data, n);
+	received += n;
+	data += n;
+	size -= n;
+	if(received < length) {
+		return false;
+	}
+	received = 0;
+	return true;
+}
+
+bool PatchOutputStream::output(const uint8_t* data, size_t size)
+{
+	if(UpgradeOutputStream::write(data, size) != size) {
+		setError("Write failed");
+		return false;
+	}
+	targetContext.update(data, size);
+	return true;
+}
+
+bool PatchOutputStream::processHeader()
+{
+	if(header.magic != Header::Magic) {
+		setError("Invalid header");
+		return false;
+	}
+	if(header.sourceSize > source.size() || header.targetSize > maxLength) {
+		setError("Image too large");
+		return false;
+	}
+	if(source == partition) {
+		setError("Source and target must differ");
+		return false;
+	}
+
+	// Confirm the patch was made for the image we have before touching the target
+	Crypto::Md5 ctx;
+	uint8_t buffer[copyBufferSize];
+	for(uint32_t offset = 0; offset < header.sourceSize; offset += copyBufferSize) {
+		auto len = std::min(header.sourceSize - offset, copyBufferSize);
+		if(!source.read(offset, buffer, len)) {
+			setError("Source read failed");
+			return false;
+		}
+		ctx.update(buffer, len);
+		WDT.alive();
+	}
+	if(ctx.getHash() != header.sourceHash) {
+		setError("Source image does not match");
+		return false;
+	}
+
+	debug_i("[OTA] Patch '%s' -> '%s', %u bytes", source.name().c_str(), partition.name().c_str(),
+			header.targetSize);
+	if(header.targetSize == 0) {
+		verifyTarget();
+	} else {
+		state = State::Command;
+	}
+	return true;
+}
+
+bool PatchOutputStream::processCommand()
+{
+	// Compare without risk of overflow
+	if(command.copyOffset > header.sourceSize || command.copyLength > header.sourceSize - command.copyOffset) {
+		setError("Copy out of range");
+		return false;
+	}
+	if(command.copyLength > header.targetSize - written ||
+	   command.insertLength > header.targetSize - written - command.copyLength) {
+		setError("Output too long");
+		return false;
+	}
+
+	uint8_t buffer[copyBufferSize];
+	auto offset = command.copyOffset;
+	for(auto len = command.copyLength; len != 0;) {
+		auto n = std::min(len, copyBufferSize);
+		if(!source.read(offset, buffer, n)) {
+			setError("Source read failed");
+			return false;
+		}
+		if(!output(buffer, n)) {
+			return false;
+		}
+		offset += n;
+		len -= n;
+		WDT.alive();
+	}
+
+	remaining = command.insertLength;
+	state = State::Insert;
+	return true;
+}
+
+size_t PatchOutputStream::write(const uint8_t* data, size_t size)
+{
+	const size_t origSize = size;
+
+	while(size != 0) {
+		switch(state) {
+		case State::Header:
+			if(collect(&header, sizeof(header), data, size)) {
+				processHeader();
+			}
+			break;
+
+		case State::Command:
+			if(collect(&command, sizeof(command), data, size)) {
+				processCommand();
+			}
+			break;
+
+		case State::Insert: {
+			auto n = std::min(size_t(remaining), size);
+			if(!output(data, n)) {
+				break;
+			}
+			data += n;
+			size -= n;
+			remaining -= n;
+			break;
+		}
+
+		case State::Complete:
+			setError("Unexpected data");
+			break;
+
+		case State::Error:
+			return origSize - size;
+		}
+
+		if(state == State::Insert && remaining == 0) {
+			if(written < header.targetSize) {
+				state = State::Command;
+			} else {
+				verifyTarget();
+			}
+		}
+	}
+
+	return origSize - size;
+}
+
+void PatchOutputStream::verifyTarget()
+{
+	if(targetContext.getHash() == header.targetHash) {
+		debug_i("[OTA] Patch applied");
+		state = State::Complete;
+	} else {
+		setError("Patched image verification failed");
+	}
+}
+
+bool PatchOutputStream::close()
+{
+	bool ok = UpgradeOutputStream::close();
+	if(state == State::Complete) {
+		return ok;
+	}
+	if(state != State::Error) {
+		debug_e("[OTA] Patch incomplete");
+	}
+	return false;
+}
+
+} // namespace Ota
@@ -0,0 +1,111 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/SmingHub/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * PatchOutputStream.h
+ *
+ *
+*/
+
+#pragma once
+
+#include "UpgradeOutputStream.h"
+#include <Crypto/Md5.h>
+
+namespace Ota
+{
+/**
+ * @brief Write-only stream which applies a delta patch to build a new image
+ *
+ * The patch is generated by `otatool.py mkpatch` from the firmware image currently installed (source)
+ * and the new one (target). It consists of a header followed by a sequence of commands, each of which
+ * copies a range from the source partition then appends data carried in the patch.
+ *
+ * The source partition is checked against the hash in the patch header before anything is written,
+ * and the target is hashed as it is written so `close()` fails if the result isn't exactly as expected.
+ * Only a small copy buffer is required, regardless of image size.
+ *
+ * @note Source and target must be different partitions, typically the running partition and the next boot partition.
+ */
+class PatchOutputStream : public UpgradeOutputStream
+{
+public:
+	using Hash = Crypto::Md5::Hash;
+
+	/**
+	 * @brief Patch file header
+	 */
+	struct Header {
+		static constexpr uint32_t Magic{0x48435450}; // "PTCH"
+
+		uint32_t magic;
+		uint32_t sourceSize; ///< Length of source image
+		uint32_t targetSize; ///< Length of image produced by patch
+		Hash sourceHash;	 ///< MD5 of source image
+		Hash targetHash;	 ///< MD5 of target image
+	};
+
+	/**
+	 * @brief Each command is followed by `insertLength` bytes of data
+	 */
+	struct Command {
+		uint32_t copyOffset; ///< Position in source
+		uint32_t copyLength; ///< Number of bytes to copy from source
+		uint32_t insertLength;
+	};
+
+	/**
+	 * @brief Construct a stream to patch an image
+	 * @param source Partition containing the source image
+	 * @param target Partition to receive the new image
+	 */
+	PatchOutputStream(Partition source, Partition target) : UpgradeOutputStream(target), source(source)
+	{
+	}
+
+	size_t write(const uint8_t* data, size_t size) override;
+
+	/**
+	 * @brief Complete the upgrade
+	 * @retval bool false if patch was incomplete or the resulting image is incorrect
+	 */
+	bool close() override;
+
+	bool hasError() const
+	{
+		return state == State::Error;
+	}
+
+private:
+	enum class State {
+		Header,
+		Command,
+		Insert,
+		Complete,
+		Error,
+	};
+
+	/**
+	 * @brief Accumulate data for header or command structure
+	 * @retval bool true when structure is complete
+	 */
+	bool collect(void* dest, size_t length, const uint8_t*& data, size_t& size);
+
+	bool processHeader();
+	bool processCommand();
+	bool output(const uint8_t* data, size_t size);
+	void verifyTarget();
+	void setError(const char* message);
+
+	Partition source;
+	Crypto::Md5 targetContext;
+	Header header{};
+	Command command{};
+	State state{State::Header};
+	size_t received{0};	///< Bytes collected for header or command
+	uint32_t remaining{0}; ///< Bytes left to insert for current command
+};
+
+} // namespace Ota
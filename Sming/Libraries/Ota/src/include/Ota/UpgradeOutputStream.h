@@ -68,6 +68,16 @@ public:
 
 	virtual bool close();
 
+	/**
+	 * @brief Erase flash ahead of the write position during idle time
+	 * @param distance Number of bytes to keep erased ahead of the data written
+	 * @see `UpgraderBase::setEraseAhead()`
+	 */
+	void setEraseAhead(size_t distance)
+	{
+		ota.setEraseAhead(distance);
+	}
+
 	size_t getStartAddress() const
 	{
 		return partition.address();
@@ -51,6 +51,15 @@ public:
 	 */
 	virtual bool end() = 0;
 
+	/**
+	 * @brief Set how far ahead of the write position flash should be erased during idle time
+	 * @param distance In bytes. Set to 0 to erase only as data is written.
+	 * @note Has no effect if the implementation erases the partition in ``begin()``
+	 */
+	virtual void setEraseAhead(size_t distance)
+	{
+	}
+
 	/**
 	* @brief Aborts a partition upgrade
 	*/
@@ -10,65 +10,136 @@
 
 #include "include/Ota/Network/HttpUpgrader.h"
 #include <Ota/Manager.h>
+#include <algorithm>
 
 namespace Ota
 {
 namespace Network
 {
+size_t HttpUpgrader::ItemStream::write(const uint8_t* data, size_t size)
+{
+	// Discard data already written by a previous attempt
+	auto n = std::min(item.skip, size);
+	item.skip -= n;
+	if(n == size) {
+		return size;
+	}
+
+	auto stream = item.getStream();
+	auto written = stream->write(data + n, size - n);
+	item.size += written;
+	return n + written;
+}
+
 void HttpUpgrader::start()
 {
-	for(unsigned i = 0; i < items.count(); i++) {
-		auto& it = items[i];
-		debug_d("Download file:\r\n"
-				"    (%u) %s -> %s @ 0x%X",
-				currentItem, it.url.c_str(), it.partition.name().c_str(), it.partition.address());
-
-		HttpRequest* request;
-		if(baseRequest != nullptr) {
-			request = baseRequest->clone();
-			request->setURL(it.url);
-		} else {
-			request = new HttpRequest(it.url);
-		}
+	currentItem = 0;
+	if(items.count() != 0) {
+		sendItem();
+	}
+}
 
-		request->setMethod(HTTP_GET);
-		request->setResponseStream(it.getStream());
+bool HttpUpgrader::sendItem()
+{
+	auto& it = items[currentItem];
+	debug_d("Download file:\r\n"
+			"    (%u) %s -> %s @ 0x%X",
+			currentItem, it.url.c_str(), it.partition.name().c_str(), it.partition.address());
+
+	HttpRequest* request;
+	if(baseRequest != nullptr) {
+		request = baseRequest->clone();
+		request->setURL(it.url);
+	} else {
+		request = new HttpRequest(it.url);
+	}
 
-		if(i == items.count() - 1) {
-			request->onRequestComplete(RequestCompletedDelegate(&HttpUpgrader::updateComplete, this));
-		} else {
-			request->onRequestComplete(RequestCompletedDelegate(&HttpUpgrader::itemComplete, this));
-		}
+	request->setMethod(HTTP_GET);
+	if(it.size != 0) {
+		debug_i("Resuming download from %u", it.size);
+		request->headers[HTTP_HEADER_RANGE] = F("bytes=") + String(it.size) + '-';
+	}
+	request->setResponseStream(new ItemStream(it));
+	request->onHeadersComplete(RequestHeadersCompletedDelegate(&HttpUpgrader::itemHeadersComplete, this));
+
+	if(currentItem == items.count() - 1) {
+		request->onRequestComplete(RequestCompletedDelegate(&HttpUpgrader::updateComplete, this));
+	} else {
+		request->onRequestComplete(RequestCompletedDelegate(&HttpUpgrader::itemComplete, this));
+	}
 
-		if(!send(request)) {
-			debug_e("ERROR: Rejected sending new request.");
-			break;
+	if(!send(request)) {
+		debug_e("ERROR: Rejected sending new request.");
+		return false;
+	}
+
+	return true;
+}
+
+int HttpUpgrader::itemHeadersComplete(HttpConnection& client, HttpResponse& response)
+{
+	auto& it = items[currentItem];
+	it.skip = 0;
+
+	if(response.code == HTTP_STATUS_PARTIAL_CONTENT && it.size != 0) {
+		// Content-Range should start where we left off
+		String range = response.headers[HTTP_HEADER_CONTENT_RANGE];
+		String expected = F("bytes ") + String(it.size) + '-';
+		if(range.startsWith(expected)) {
+			return 0;
 		}
+		debug_e("Unexpected Content-Range: %s", range.c_str());
+		return -1;
 	}
+
+	if(response.code == HTTP_STATUS_OK) {
+		// Server doesn't support ranges, or this is the first attempt
+		it.skip = it.size;
+		return 0;
+	}
+
+	debug_e("Download failed, HTTP status %u", response.code);
+	return -1;
 }
 
 int HttpUpgrader::itemComplete(HttpConnection& client, bool success)
 {
+	auto& it = items[currentItem];
+
 	if(!success) {
+		if(it.retries < maxRetries) {
+			++it.retries;
+			debug_w("Download interrupted after %u bytes, retry %u of %u", it.size, it.retries, maxRetries);
+			if(sendItem()) {
+				// Let caller know this request has been handled
+				return 0;
+			}
+		}
 		updateFailed();
 		return -1;
 	}
 
-	auto& it = items[currentItem];
-	debug_d("Finished: URL: %s, Offset: 0x%X, Length: %u", it.url.c_str(), it.partition.address(),
-			it.stream->available());
+	debug_d("Finished: URL: %s, Offset: 0x%X, Length: %u", it.url.c_str(), it.partition.address(), it.size);
 
-	it.size = it.stream->available();
-	it.stream = nullptr; // the actual deletion will happen outside of this class
+	// Closes the stream, completing flash writes
+	delete it.stream;
+	it.stream = nullptr;
 	currentItem++;
 
+	if(currentItem < items.count() && !sendItem()) {
+		updateFailed();
+		return -1;
+	}
+
 	return 0;
 }
 
 int HttpUpgrader::updateComplete(HttpConnection& client, bool success)
 {
+	auto item = currentItem;
 	int hasError = itemComplete(client, success);
-	if(hasError != 0) {
+	if(hasError != 0 || currentItem == item) {
+		// Failed, or retrying
 		return hasError;
 	}
 
@@ -77,11 +148,6 @@ int HttpUpgrader::updateComplete(HttpConnection& client, bool success)
 		debug_d(" - item: %u, addr: 0x%X, url: %s", i, items[i].partition.address(), items[i].url.c_str());
 	}
 
-	if(!success) {
-		updateFailed();
-		return -1;
-	}
-
 	if(updateDelegate) {
 		updateDelegate(*this, true);
 	}
@@ -102,8 +168,8 @@ void HttpUpgrader::updateFailed()
 
 void HttpUpgrader::applyUpdate()
 {
-	items.clear();
 	if(romSlot == NO_ROM_SWITCH) {
+		items.clear();
 		debug_d("Firmware updated.");
 		return;
 	}
@@ -112,6 +178,7 @@ void HttpUpgrader::applyUpdate()
 	debug_d("Firmware updated, rebooting to rom %u...\r\n", romSlot);
 
 	OtaManager.setBootPartition(items[romSlot].partition);
+	items.clear();
 	System.restart();
 }
 
@@ -27,17 +27,28 @@ namespace Network
  */
 constexpr uint8_t NO_ROM_SWITCH{0xff};
 
+/**
+ * @brief Downloads firmware items in sequence and writes them to flash
+ *
+ * If a download fails part-way through, it is resumed from where it left off using a HTTP Range request.
+ * Data already written is retained. If the server doesn't support ranges then the full content is requested
+ * again and data already received is skipped.
+ */
 class HttpUpgrader : protected HttpClient
 {
 public:
 	using CompletedDelegate = Delegate<void(HttpUpgrader& client, bool result)>;
 	using Partition = Storage::Partition;
 
+	static constexpr uint8_t defaultMaxRetries{3};
+
 	struct Item {
 		String url;
 		Partition partition;			  // << partition to write the data to
 		size_t size{0};					  // << actual size of written bytes
 		ReadWriteStream* stream{nullptr}; // (optional) output stream to use.
+		size_t skip{0};					  // << bytes to discard from start of response when resuming
+		uint8_t retries{0};				  // << number of times download has been resumed
 
 		Item(String url, Partition partition, ReadWriteStream* stream) : url(url), partition(partition), stream(stream)
 		{
@@ -94,6 +105,14 @@ public:
 		this->romSlot = romSlot;
 	}
 
+	/**
+	 * @brief Set number of attempts made to resume each item following a failed download
+	 */
+	void setMaxRetries(uint8_t count)
+	{
+		maxRetries = count;
+	}
+
 	void setCallback(CompletedDelegate reqUpdateDelegate)
 	{
 		setDelegate(reqUpdateDelegate);
@@ -131,15 +150,53 @@ protected:
 	void applyUpdate();
 	void updateFailed();
 
+	/**
+	 * @brief Send request for current item, resuming from end of data already written
+	 */
+	bool sendItem();
+
 	virtual int itemComplete(HttpConnection& client, bool success);
 	virtual int updateComplete(HttpConnection& client, bool success);
+	int itemHeadersComplete(HttpConnection& client, HttpResponse& response);
 
 protected:
+	/**
+	 * @brief Passed to each request so the item's output stream survives failed requests
+	 */
+	class ItemStream : public ReadWriteStream
+	{
+	public:
+		ItemStream(Item& item) : item(item)
+		{
+		}
+
+		size_t write(const uint8_t* data, size_t size) override;
+
+		uint16_t readMemoryBlock(char* data, int bufSize) override
+		{
+			return 0;
+		}
+
+		int available() override
+		{
+			return item.size;
+		}
+
+		bool isFinished() override
+		{
+			return true;
+		}
+
+	private:
+		Item& item;
+	};
+
 	ItemList items;
 	CompletedDelegate updateDelegate;
 	HttpRequest* baseRequest{nullptr};
 	uint8_t romSlot{NO_ROM_SWITCH};
 	uint8_t currentItem{0};
+	uint8_t maxRetries{defaultMaxRetries};
 };
 
 } // namespace Network
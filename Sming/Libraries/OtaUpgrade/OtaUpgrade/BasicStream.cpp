@@ -75,6 +75,34 @@ void BasicStream::nextRom()
 	}
 }
 
+bool BasicStream::processFileHeader()
+{
+#ifdef ENABLE_OTA_COMPRESSION
+	compressed = (fileHeader.magic == expectedHeaderMagicCompressed);
+	if(compressed) {
+		uint8_t windowBits = fileHeader.compression >> 4;
+		uint8_t lookaheadBits = fileHeader.compression & 0x0f;
+		if(!Decompressor::isValid(windowBits, lookaheadBits)) {
+			setError(Error::UnsupportedData);
+			return false;
+		}
+		if(!decompressor.begin(windowBits, lookaheadBits)) {
+			setError(Error::OutOfMemory);
+			return false;
+		}
+		debug_i("Compressed images, window %u bytes", 1U << windowBits);
+		return true;
+	}
+#endif
+
+	if(fileHeader.magic != expectedHeaderMagic) {
+		setError(Error::InvalidFormat);
+		return false;
+	}
+
+	return true;
+}
+
 void BasicStream::processRomHeader()
 {
 	bool addressMatch = (slot.partition.address() & 0xFFFFF) == (romHeader.address & 0xFFFFF);
@@ -94,6 +122,42 @@ void BasicStream::processRomHeader()
 	setupChunk(State::SkipRom, romHeader.size);
 }
 
+#ifdef ENABLE_OTA_COMPRESSION
+bool BasicStream::writeDecompressed(const uint8_t* data, size_t size)
+{
+	if(decompressor.getOutputSize() > slot.partition.size()) {
+		setError(Error::RomTooLarge);
+		return false;
+	}
+	return ota.write(data, size) == size;
+}
+#endif
+
+bool BasicStream::writeRom(const uint8_t* data, size_t size)
+{
+#ifdef ENABLE_OTA_COMPRESSION
+	if(compressed) {
+		return decompressor.write(data, size);
+	}
+#endif
+	return ota.write(data, size) == size;
+}
+
+bool BasicStream::endRom()
+{
+#ifdef ENABLE_OTA_COMPRESSION
+	if(compressed) {
+		bool ok = decompressor.flush();
+		debug_i("Decompressed ROM image %u -> %u bytes", romHeader.size, decompressor.getOutputSize());
+		decompressor.end();
+		if(!ok) {
+			return false;
+		}
+	}
+#endif
+	return ota.end();
+}
+
 void BasicStream::verifyRoms()
 {
 	state = State::RomsComplete;
@@ -135,7 +199,7 @@ size_t BasicStream::write(const uint8_t* data, size_t size)
 		switch(state) {
 		case State::Header:
 			if(consume(data, size)) {
-				if(fileHeader.magic == expectedHeaderMagic) {
+				if(processFileHeader()) {
 #ifndef ENABLE_OTA_DOWNGRADE
 					const auto buildTimestampFirmware = FSTR::readValue(&BuildTimestamp);
 					debug_i("Build timestamp of current firmware: %ull", buildTimestampFirmware);
@@ -149,8 +213,6 @@ size_t BasicStream::write(const uint8_t* data, size_t size)
 #endif
 					debug_i("Starting firmware upgrade, receive %u image(s)", fileHeader.romCount);
 					nextRom();
-				} else {
-					setError(Error::InvalidFormat);
 				}
 			}
 			break;
@@ -162,14 +224,14 @@ size_t BasicStream::write(const uint8_t* data, size_t size)
 			break;
 
 		case State::WriteRom: {
-			bool ok = ota.write(data, std::min(remainingBytes, size));
+			bool ok = writeRom(data, std::min(remainingBytes, size));
 			if(ok) {
 				if(consume(data, size)) {
-					ok = slot.updated = ota.end();
+					ok = slot.updated = endRom();
 					nextRom();
 				}
 			}
-			if(!ok) {
+			if(!ok && !hasError()) {
 				setError(Error::FlashWriteFailed);
 			}
 		} break;
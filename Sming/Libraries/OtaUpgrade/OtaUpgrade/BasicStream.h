@@ -19,6 +19,9 @@
 #else
 #include "ChecksumVerifier.h"
 #endif
+#ifdef ENABLE_OTA_COMPRESSION
+#include "Decompressor.h"
+#endif
 
 namespace OtaUpgrade
 {
@@ -36,6 +39,9 @@ namespace OtaUpgrade
  * Call `hasError()` and/or check the public \c #errorCode member to determine if
  * everything went smoothly.
  *
+ * If compression support is enabled, compressed ROM images are decoded as they arrive
+ * using a small history window, so files need never be stored in full.
+ *
  * For further information on configuration options and the file format,
  * refer to the library's documentation.
  *
@@ -128,12 +134,22 @@ private:
 #ifdef ENABLE_OTA_SIGNING
 	using Verifier = SignatureVerifier;
 	static const uint32_t expectedHeaderMagic{OTA_HEADER_MAGIC_SIGNED};
+	static const uint32_t expectedHeaderMagicCompressed{OTA_HEADER_MAGIC_SIGNED_COMPRESSED};
 #else
 	using Verifier = ChecksumVerifier;
 	static const uint32_t expectedHeaderMagic{OTA_HEADER_MAGIC_NOT_SIGNED};
+	static const uint32_t expectedHeaderMagicCompressed{OTA_HEADER_MAGIC_NOT_SIGNED_COMPRESSED};
 #endif
 	Verifier verifier;
 
+#ifdef ENABLE_OTA_COMPRESSION
+	Decompressor decompressor{Decompressor::Output(&BasicStream::writeDecompressed, this)};
+	bool compressed{false};
+
+	/** Output callback for `decompressor`, checks decoded image fits and writes it to flash. */
+	bool writeDecompressed(const uint8_t* data, size_t size);
+#endif
+
 	OtaFileHeader fileHeader;
 	OtaRomHeader romHeader;
 
@@ -171,6 +187,14 @@ private:
 	 * Decides if the ROM fits the selected upgrade slot or must be ignored.
 	 */
 	void processRomHeader();
+	/** Called after reception of an #OTA_FileHeader to check the magic number and prepare for decompression.
+	 * @retval bool false if the file format is not supported; `setError()` has been called.
+	 */
+	bool processFileHeader();
+	/** Write a chunk of ROM image content to flash, decompressing if required. */
+	bool writeRom(const uint8_t* data, size_t size);
+	/** Complete writing the current ROM image. */
+	bool endRom();
 	/** Called after completion of all ROM images from the upgrade file to perform checksum/signature validation.
 	 * If successful, the upgraded slot is set as active ROM using the rBoot API.
 	 */
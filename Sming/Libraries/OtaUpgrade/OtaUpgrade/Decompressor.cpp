@@ -0,0 +1,107 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2017 by Slavey Karadzhov
+ * http://github.com/SmingHub/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * Decompressor.cpp
+ *
+ ****/
+
+#include "Decompressor.h"
+#include <cstring>
+
+namespace OtaUpgrade
+{
+bool Decompressor::begin(uint8_t windowBits, uint8_t lookaheadBits)
+{
+	if(!isValid(windowBits, lookaheadBits)) {
+		return false;
+	}
+
+	size_t windowSize = 1U << windowBits;
+	if(!window || windowBits != this->windowBits) {
+		window.reset(new uint8_t[windowSize]);
+		if(!window) {
+			this->windowBits = 0;
+			return false;
+		}
+	}
+
+	// Encoder never refers to data before start of stream, but be consistent with heatshrink anyway
+	memset(window.get(), 0, windowSize);
+	this->windowBits = windowBits;
+	this->lookaheadBits = lookaheadBits;
+	windowMask = windowSize - 1;
+	outputPos = flushPos = 0;
+	bitBuffer = 0;
+	bitCount = 0;
+	state = State::Tag;
+	return true;
+}
+
+bool Decompressor::write(const uint8_t* data, size_t size)
+{
+	if(!window) {
+		return false;
+	}
+
+	while(size-- != 0) {
+		bitBuffer = (bitBuffer << 8) | *data++;
+		bitCount += 8;
+
+		unsigned value;
+		for(bool more = true; more;) {
+			switch(state) {
+			case State::Tag:
+				if((more = getBits(1, value))) {
+					state = value ? State::Literal : State::Index;
+				}
+				break;
+
+			case State::Literal:
+				if((more = getBits(8, value))) {
+					if(!put(value)) {
+						return false;
+					}
+					state = State::Tag;
+				}
+				break;
+
+			case State::Index:
+				if((more = getBits(windowBits, value))) {
+					distance = value + 1;
+					state = State::Count;
+				}
+				break;
+
+			case State::Count:
+				if((more = getBits(lookaheadBits, value))) {
+					for(unsigned count = value + 1; count != 0; --count) {
+						if(!put(window[(outputPos - distance) & windowMask])) {
+							return false;
+						}
+					}
+					state = State::Tag;
+				}
+				break;
+			}
+		}
+	}
+
+	return true;
+}
+
+bool Decompressor::flush()
+{
+	if(outputPos == flushPos) {
+		return true;
+	}
+
+	// Flushes happen when window fills, so pending data always starts at the beginning
+	size_t len = outputPos - flushPos;
+	flushPos = outputPos;
+	return output && output(window.get(), len);
+}
+
+} // namespace OtaUpgrade
@@ -0,0 +1,129 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2017 by Slavey Karadzhov
+ * http://github.com/SmingHub/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * Decompressor.h - Incremental LZSS decoder for compressed ROM images
+ *
+ ****/
+
+#pragma once
+
+#include <Delegate.h>
+#include <memory>
+
+namespace OtaUpgrade
+{
+/**
+ * @brief Incremental decoder for LZSS streams as produced by otatool.py (or heatshrink)
+ *
+ * The stream is a sequence of bit-packed tokens, most significant bit first:
+ *
+ * - Literal: `1` followed by 8 bits of data
+ * - Back-reference: `0`, followed by (distance - 1) in `windowBits` and (count - 1) in `lookaheadBits`
+ *
+ * The only RAM required is the history window of (1 << windowBits) bytes, which doubles as the output buffer.
+ * Decoded data is passed to the output callback one window at a time, so input may be fed in arbitrarily sized chunks.
+ */
+class Decompressor
+{
+public:
+	/**
+	 * @brief Receives decoded data
+	 * @retval bool Return false to abort decoding
+	 */
+	using Output = Delegate<bool(const uint8_t* data, size_t size)>;
+
+	static constexpr uint8_t minWindowBits{8};
+	static constexpr uint8_t maxWindowBits{12};
+	static constexpr uint8_t minLookaheadBits{3};
+
+	Decompressor(Output output) : output(output)
+	{
+	}
+
+	/**
+	 * @brief Check whether compression parameters are supported
+	 */
+	static bool isValid(uint8_t windowBits, uint8_t lookaheadBits)
+	{
+		return windowBits >= minWindowBits && windowBits <= maxWindowBits && lookaheadBits >= minLookaheadBits &&
+			   lookaheadBits < windowBits;
+	}
+
+	/**
+	 * @brief Prepare to decode a new stream
+	 * @retval bool false if parameters are invalid or window allocation failed
+	 * @note The window is retained if already allocated with the same size
+	 */
+	bool begin(uint8_t windowBits, uint8_t lookaheadBits);
+
+	/**
+	 * @brief Decode a chunk of compressed data
+	 * @retval bool false if output callback failed
+	 */
+	bool write(const uint8_t* data, size_t size);
+
+	/**
+	 * @brief Pass any remaining decoded data to output callback
+	 * @note Call at end of stream. Any incomplete token (i.e. trailing padding) is discarded.
+	 */
+	bool flush();
+
+	/**
+	 * @brief Release window memory
+	 */
+	void end()
+	{
+		window.reset();
+		windowBits = 0;
+	}
+
+	/**
+	 * @brief Number of bytes decoded since `begin()`
+	 */
+	uint32_t getOutputSize() const
+	{
+		return outputPos;
+	}
+
+private:
+	enum class State {
+		Tag,
+		Literal,
+		Index,
+		Count,
+	};
+
+	bool getBits(uint8_t count, unsigned& value)
+	{
+		if(bitCount < count) {
+			return false;
+		}
+		bitCount -= count;
+		value = (bitBuffer >> bitCount) & ((1U << count) - 1);
+		return true;
+	}
+
+	bool put(uint8_t c)
+	{
+		window[outputPos & windowMask] = c;
+		++outputPos;
+		return (outputPos - flushPos) <= windowMask || flush();
+	}
+
+	Output output;
+	std::unique_ptr<uint8_t[]> window;
+	uint32_t windowMask{0};
+	uint32_t outputPos{0}; ///< Total bytes decoded
+	uint32_t flushPos{0};  ///< Total bytes passed to output
+	uint32_t bitBuffer{0};
+	uint16_t distance{0};
+	uint8_t bitCount{0};
+	uint8_t windowBits{0};
+	uint8_t lookaheadBits{0};
+	State state{State::Tag};
+};
+
+} // namespace OtaUpgrade
@@ -16,79 +16,50 @@ namespace OtaUpgrade
 {
 DECLARE_FSTR_ARRAY(DecryptionKey, uint8_t)
 
-size_t EncryptedStream::write(const uint8_t* data, size_t size)
+EncryptedStream::EncryptedStream()
 {
-	const size_t origSize = size;
-
-	while(!hasError() && (size > 0)) {
-		std::size_t toConsume = std::min(remainingBytes, size);
-		memcpy(fragmentPtr, data, toConsume);
-		size -= toConsume;
-		data += toConsume;
-		fragmentPtr += toConsume;
-		remainingBytes -= toConsume;
-
-		if(remainingBytes == 0) {
-			switch(fragment) {
-			case Fragment::Header: {
-				assert(DecryptionKey.length() == crypto_secretstream_xchacha20poly1305_KEYBYTES);
-				LOAD_FSTR_ARRAY(key, DecryptionKey);
-				bool ok = (crypto_secretstream_xchacha20poly1305_init_pull(&state, header, key) == 0);
-				sodium_memzero(key, sizeof(key));
-				if(!ok) {
-					setError(Error::DecryptionFailed);
-					break;
-				}
-				fragment = Fragment::ChunkSize;
-				fragmentPtr = reinterpret_cast<uint8_t*>(&chunkSizeMinusOne);
-				remainingBytes = sizeof(chunkSizeMinusOne);
-			} break;
+	using namespace Sodium::SecretStream;
 
-			case Fragment::ChunkSize:
-				remainingBytes = 1 + chunkSizeMinusOne;
-				if(!buffer || bufferSize < remainingBytes) {
-					buffer.reset(new uint8_t[remainingBytes]);
-					if(!buffer) {
-						setError(Error::OutOfMemory);
-						break;
-					}
-					bufferSize = remainingBytes;
-				}
-				fragmentPtr = buffer.get();
-				fragment = Fragment::Chunk;
-				break;
+	assert(DecryptionKey.length() == sizeof(Key));
+	Key key;
+	{
+		LOAD_FSTR_ARRAY(keyData, DecryptionKey);
+		memcpy(key.data(), keyData, key.size());
+		sodium_memzero(keyData, sizeof(keyData));
+	}
+	decoder.reset(new Decoder(key, [this](const uint8_t* data, size_t length) {
+		BasicStream::write(data, length);
+		return !hasError();
+	}));
+	sodium_memzero(key.data(), key.size());
+}
 
-			case Fragment::Chunk: {
-				unsigned char tag;
-				size_t chiperTextLength = 1 + chunkSizeMinusOne;
-				unsigned long long messageLength = 0;
-				bool ok = (crypto_secretstream_xchacha20poly1305_pull(&state, buffer.get(), &messageLength, &tag,
-																	  buffer.get(), chiperTextLength, nullptr, 0) == 0);
-				if(!ok || messageLength > bufferSize) {
-					setError(Error::DecryptionFailed);
-					break;
-				}
-				if(tag != crypto_secretstream_xchacha20poly1305_TAG_FINAL) {
-					fragment = Fragment::ChunkSize;
-					fragmentPtr = reinterpret_cast<uint8_t*>(&chunkSizeMinusOne);
-					remainingBytes = sizeof(chunkSizeMinusOne);
-				} else {
-					fragment = Fragment::None;
-				}
+size_t EncryptedStream::write(const uint8_t* data, size_t size)
+{
+	using DecoderError = Sodium::SecretStream::Decoder::Error;
 
-				BasicStream::write(buffer.get(), size_t(messageLength));
-			} break;
+	if(hasError()) {
+		return 0;
+	}
 
-			case Fragment::None:
-				setError(Error::InvalidFormat);
-				break;
+	size_t written = decoder->write(data, size);
 
-			default:
-				setError(Error::Internal);
-			}
-		}
+	switch(decoder->getError()) {
+	case DecoderError::None:
+	case DecoderError::Aborted:
+		// Any error already set by BasicStream
+		break;
+	case DecoderError::OutOfMemory:
+		setError(Error::OutOfMemory);
+		break;
+	case DecoderError::InvalidFormat:
+		setError(Error::InvalidFormat);
+		break;
+	default:
+		setError(Error::DecryptionFailed);
 	}
-	return origSize - size;
+
+	return written;
 }
 
 } // namespace OtaUpgrade
@@ -11,8 +11,7 @@
 #pragma once
 
 #include "BasicStream.h"
-#include <sodium/crypto_secretstream_xchacha20poly1305.h>
-#include <memory>
+#include <Sodium/SecretStream.h>
 
 namespace OtaUpgrade
 {
@@ -23,11 +22,13 @@ namespace OtaUpgrade
  * A buffer is allocated dynamically to fit the largest chunk of the encryption container
  * (2kB unless otatool.py was modified). The actual processing of the decrypted data is
  * deferred to #BasicStream.
+ *
+ * Decryption is performed by Sodium::SecretStream::Decoder.
  */
 class EncryptedStream : public BasicStream
 {
 public:
-	EncryptedStream() = default;
+	EncryptedStream();
 
 	/** @brief Process an arbitrarily sized chunk of an encrypted OTA upgrade file.
 	 * @param data Pointer to chunk of data.
@@ -38,25 +39,7 @@ public:
 	size_t write(const uint8_t* data, size_t size) override;
 
 private:
-	crypto_secretstream_xchacha20poly1305_state state;
-
-	union {
-		uint8_t header[crypto_secretstream_xchacha20poly1305_HEADERBYTES];
-		uint16_t chunkSizeMinusOne;
-	};
-
-	enum class Fragment {
-		Header,
-		ChunkSize,
-		Chunk,
-		None,
-	};
-
-	Fragment fragment{Fragment::Header};
-	size_t remainingBytes{sizeof header};
-	uint8_t* fragmentPtr{header};
-	std::unique_ptr<uint8_t[]> buffer;
-	size_t bufferSize{0};
+	std::unique_ptr<Sodium::SecretStream::Decoder> decoder;
 };
 
 } // namespace OtaUpgrade
@@ -26,20 +26,25 @@ struct OtaFileHeader {
 	uint32_t buildTimestampLow;  ///< File creation timestamp, Milliseconds since 1900/01/01 (lower 32 bits)
 	uint32_t buildTimestampHigh; ///< File creation timestamp, Milliseconds since 1900/01/01 (lower 32 bits)
 	uint8_t romCount;			 ///< Number of ROM images in this filem, each preceded with an #OTA_RomHeader.
-	uint8_t reserved[3];		 ///< Reserved bytes, must be zero for compatibility with future versions.
+	uint8_t compression;		 ///< For compressed files, window bits (upper nibble) and lookahead bits (lower nibble)
+	uint8_t reserved[2];		 ///< Reserved bytes, must be zero for compatibility with future versions.
 };
 
 /** Header of ROM image inside an OTA upgrade file.
  */
 struct OtaRomHeader {
 	uint32_t address; ///< Flash memory destination offset for this ROM image.
-	uint32_t size;	///< Size of ROM image content following this header, in bytes.
+	uint32_t size;	///< Size of ROM image content following this header, in bytes (compressed size if applicable).
 };
 
 /** Expected value for OTA_FileHeader::magic for digitally signed upgrad file. */
 #define OTA_HEADER_MAGIC_SIGNED 0xf01af02a
 /** Expected value for OTA_FileHeader::magic when signing is disabled. */
 #define OTA_HEADER_MAGIC_NOT_SIGNED 0xf01af020
+/** Expected value for OTA_FileHeader::magic for digitally signed upgrade file with compressed ROM images. */
+#define OTA_HEADER_MAGIC_SIGNED_COMPRESSED 0xf01af02b
+/** Expected value for OTA_FileHeader::magic for compressed ROM images when signing is disabled. */
+#define OTA_HEADER_MAGIC_NOT_SIGNED_COMPRESSED 0xf01af021
 
 #ifdef __cplusplus
 }
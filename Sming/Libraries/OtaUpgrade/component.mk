@@ -42,6 +42,20 @@ GLOBAL_CFLAGS += -DENABLE_OTA_ENCRYPTION
 COMPONENT_SRCFILES += OtaUpgrade/EncryptedStream.cpp
 endif
 
+COMPONENT_VARS += ENABLE_OTA_COMPRESSION
+ENABLE_OTA_COMPRESSION ?= 0
+
+# Window size used by otatool.py: the decoder allocates (1 << OTA_COMPRESSION_WINDOW_BITS) bytes during upgrade
+CONFIG_VARS += OTA_COMPRESSION_WINDOW_BITS
+OTA_COMPRESSION_WINDOW_BITS ?= 10
+
+ifeq ($(ENABLE_OTA_COMPRESSION),1)
+OTA_COMPRESSION_FEATURES := --compressed --window-bits=$(OTA_COMPRESSION_WINDOW_BITS)
+# has to be global, because it is used in a public header file
+GLOBAL_CFLAGS += -DENABLE_OTA_COMPRESSION
+COMPONENT_SRCFILES += OtaUpgrade/Decompressor.cpp
+endif
+
 ifneq ($(OTA_CRYPTO_FEATURES),)
 COMPONENT_DEPENDS += libsodium
 # Crypto features require the PyNaCl - the Python equivalent of libsodium
@@ -105,6 +119,7 @@ endif
 
 
 OTA_CRYPTO_FEATURES_IMAGE := $(OTA_CRYPTO_FEATURES)
+OTA_COMPRESSION_FEATURES_IMAGE := $(OTA_COMPRESSION_FEATURES)
 OTA_KEY_IMAGE := $(OTA_KEY)
 -include ota-rollover.mk
 
@@ -116,6 +131,7 @@ ota-rollover:
 	$(Q) echo 'OTA_ROLLOVER_IN_PROGRESS := 1' >> ota-rollover.mk
 	$(Q) echo 'OTA_KEY_IMAGE := ota-rollover.key' >> ota-rollover.mk
 	$(Q) echo 'OTA_CRYPTO_FEATURES_IMAGE := $(OTA_CRYPTO_FEATURES)' >> ota-rollover.mk
+	$(Q) echo 'OTA_COMPRESSION_FEATURES_IMAGE := $(OTA_COMPRESSION_FEATURES)' >> ota-rollover.mk
 	@echo
 	@echo "===== OTA upgrade key/setting rollover now in progress ====="
 	@echo
@@ -157,6 +173,7 @@ endif
 endif
 	$(Q) $(OTATOOL) mkfile \
 		$(OTA_CRYPTO_FEATURES_IMAGE) \
+		$(OTA_COMPRESSION_FEATURES_IMAGE) \
 		$(if $(OTA_CRYPTO_FEATURES_IMAGE),--key=$(OTA_KEY_IMAGE)) \
 		$(if $(PARTITION_factory_FILENAME),--rom=$(PARTITION_factory_FILENAME)@$(PARTITION_factory_ADDRESS)) \
 		$(if $(PARTITION_rom0_FILENAME),--rom=$(PARTITION_rom0_FILENAME)@$(PARTITION_rom0_ADDRESS))          \
@@ -180,6 +197,7 @@ endef
 $(eval $(call _ota-verify-boolean-setting,ENABLE_OTA_SIGNING))
 $(eval $(call _ota-verify-boolean-setting,ENABLE_OTA_ENCRYPTION))
 $(eval $(call _ota-verify-boolean-setting,ENABLE_OTA_DOWNGRADE))
+$(eval $(call _ota-verify-boolean-setting,ENABLE_OTA_COMPRESSION))
 
 # Convenience target for uploading file via HTTP POST
 CACHE_VARS += OTA_UPLOAD_URL OTA_UPLOAD_NAME
@@ -22,6 +22,10 @@ def import_nacl():
 
 MAGIC_UNSIGNED = 0xf01af020
 MAGIC_SIGNED = 0xf01af02a
+MAGIC_UNSIGNED_COMPRESSED = 0xf01af021
+MAGIC_SIGNED_COMPRESSED = 0xf01af02b
+
+LOOKAHEAD_BITS = 4
 
 def load_keys(keyfilepath):
     try:
@@ -66,7 +70,71 @@ def make_bin_keys(args):
     with open(os.path.join(args.output, 'verify.key.bin'), 'wb') as keyfile:
         keyfile.write(pk)
 
-def make_rom_image(address, filepath):
+def compress(data, window_bits, lookahead_bits):
+    """LZSS compression, compatible with heatshrink and OtaUpgrade::Decompressor.
+
+    Tokens are bit-packed, MSB first:
+    - Literal: 1, followed by 8 data bits
+    - Back-reference: 0, followed by (distance - 1) in window_bits and (count - 1) in lookahead_bits
+    """
+    window_size = 1 << window_bits
+    max_count = 1 << lookahead_bits
+    min_count = 3 # Shorter matches are coded as literals
+    max_chain = 16 # Limit number of candidates examined per position
+
+    out = bytearray()
+    acc = 0
+    acc_bits = 0
+    chains = {}
+    pos = 0
+    end = len(data)
+
+    while pos < end:
+        best_count = 0
+        best_distance = 0
+        limit = min(max_count, end - pos)
+        if limit >= min_count:
+            key = data[pos:pos + min_count]
+            candidates = chains.get(key)
+            if candidates:
+                for start in reversed(candidates[-max_chain:]):
+                    distance = pos - start
+                    if distance > window_size:
+                        break
+                    if best_count and data[start + best_count] != data[pos + best_count]:
+                        continue
+                    count = min_count
+                    while count < limit and data[start + count] == data[pos + count]:
+                        count += 1
+                    if count > best_count:
+                        best_count = count
+                        best_distance = distance
+                        if count == limit:
+                            break
+
+        if best_count:
+            acc = (acc << (1 + window_bits + lookahead_bits)) | ((best_distance - 1) << lookahead_bits) | (best_count - 1)
+            acc_bits += 1 + window_bits + lookahead_bits
+            step = best_count
+        else:
+            acc = (acc << 9) | 0x100 | data[pos]
+            acc_bits += 9
+            step = 1
+
+        while acc_bits >= 8:
+            acc_bits -= 8
+            out.append((acc >> acc_bits) & 0xff)
+        acc &= (1 << acc_bits) - 1
+
+        for i in range(pos, min(pos + step, end - min_count + 1)):
+            chains.setdefault(data[i:i + min_count], []).append(i)
+        pos += step
+
+    if acc_bits:
+        out.append((acc << (8 - acc_bits)) & 0xff)
+    return bytes(out)
+
+def make_rom_image(address, filepath, window_bits):
     try:
         with open(filepath, 'rb') as f:
             image_content = f.read()
@@ -74,6 +142,12 @@ def make_rom_image(address, filepath):
         sys.stderr.write('Failed to read %s\n' % filepath)
         raise
 
+    if window_bits:
+        size = len(image_content)
+        image_content = compress(image_content, window_bits, LOOKAHEAD_BITS)
+        print("Compressed %s: %u -> %u bytes (%.1f%%)" % (filepath, size, len(image_content),
+            100.0 * len(image_content) / max(size, 1)))
+
     image_header = struct.pack('<II', address, len(image_content))
     return image_header + image_content
 
@@ -91,12 +165,20 @@ def make_ota_file(args):
 
     assert len(args.roms) < 256
 
-    magic = MAGIC_SIGNED if args.signed else MAGIC_UNSIGNED
+    if args.compressed:
+        assert 8 <= args.window_bits <= 12, 'Window bits must be in range 8 to 12'
+        magic = MAGIC_SIGNED_COMPRESSED if args.signed else MAGIC_UNSIGNED_COMPRESSED
+        window_bits = args.window_bits
+        compression = (window_bits << 4) | LOOKAHEAD_BITS
+    else:
+        magic = MAGIC_SIGNED if args.signed else MAGIC_UNSIGNED
+        window_bits = 0
+        compression = 0
     timestamp = int((datetime.now() - datetime(1900, 1, 1)).total_seconds() * 1000)
-    ota = struct.pack('<IQBxxx', magic, timestamp, len(args.roms))
+    ota = struct.pack('<IQBBxx', magic, timestamp, len(args.roms), compression)
 
     for (address, filepath) in args.roms:
-        ota += make_rom_image(address, filepath)
+        ota += make_rom_image(address, filepath, window_bits)
 
     if args.signed:
         # calculate and append signature over whole file, including header, such that even the build timestamp cannot be forged
@@ -144,6 +226,101 @@ def make_ota_file(args):
     print("OTA upgrade file written to %s" % args.output)
 
 
+PATCH_MAGIC = 0x48435450 # "PTCH"
+PATCH_BLOCK_SIZE = 16 # Length of source blocks indexed for matching
+PATCH_MIN_MATCH = 24 # Shorter matches cost more than the command needed to copy them
+
+def diff(source, target):
+    """Generate a delta patch for use with Ota::PatchOutputStream.
+
+    Output is a sequence of commands, each of which copies a range from the source then inserts literal data:
+    - uint32 copy offset
+    - uint32 copy length
+    - uint32 insert length
+    - insert data
+    """
+    # Index source blocks at 4-byte intervals: any match of at least PATCH_BLOCK_SIZE + 3 includes one of these
+    index = {}
+    for i in range(0, len(source) - PATCH_BLOCK_SIZE + 1, 4):
+        index.setdefault(source[i:i + PATCH_BLOCK_SIZE], i)
+
+    commands = bytearray()
+    copy_offset = copy_length = 0
+    literal_start = 0
+    pos = 0
+    # Code following a change is typically moved by a fixed amount, so check there first
+    expected = 0
+
+    def match_length(src, dst):
+        length = 0
+        limit = min(len(source) - src, len(target) - dst)
+        step = 64
+        while length < limit:
+            n = min(step, limit - length)
+            if source[src + length:src + length + n] == target[dst + length:dst + length + n]:
+                length += n
+            elif step > 1:
+                step //= 8
+            else:
+                break
+        return length
+
+    while pos + PATCH_BLOCK_SIZE <= len(target):
+        block = target[pos:pos + PATCH_BLOCK_SIZE]
+        if expected + PATCH_BLOCK_SIZE <= len(source) and source[expected:expected + PATCH_BLOCK_SIZE] == block:
+            src = expected
+        else:
+            src = index.get(block)
+            if src is None:
+                pos += 1
+                continue
+
+        length = match_length(src, pos)
+        # Extend backwards into pending literal data
+        start = pos
+        while start > literal_start and src > 0 and source[src - 1] == target[start - 1]:
+            start -= 1
+            src -= 1
+            length += 1
+        if length < PATCH_MIN_MATCH:
+            pos += 1
+            continue
+
+        commands += struct.pack('<III', copy_offset, copy_length, start - literal_start)
+        commands += target[literal_start:start]
+        copy_offset, copy_length = src, length
+        pos = start + length
+        literal_start = pos
+        expected = src + length
+
+    commands += struct.pack('<III', copy_offset, copy_length, len(target) - literal_start)
+    commands += target[literal_start:]
+    return commands
+
+def make_patch_file(args):
+    import hashlib
+    try:
+        with open(args.source, 'rb') as f:
+            source = f.read()
+        with open(args.target, 'rb') as f:
+            target = f.read()
+    except:
+        sys.stderr.write('Failed to read image\n')
+        raise
+
+    patch = struct.pack('<III', PATCH_MAGIC, len(source), len(target))
+    patch += hashlib.md5(source).digest() + hashlib.md5(target).digest()
+    patch += diff(source, target)
+
+    try:
+        with open(args.output, 'wb') as f:
+            f.write(patch)
+    except:
+        sys.stderr.write('Failed to write patch file %s\n' % args.output)
+        raise
+    print("Patch file written to %s: %u bytes for %u byte image" % (args.output, len(patch), len(target)))
+
+
 def upload_http_post(args):
     print('Uploading firmware...')
     import random
@@ -207,6 +384,10 @@ def make_parser():
         help='Input file containing private key for signing and/or encryption of the generated OTA file.')
     mkota_parser.add_argument('-s', '--signed', action='store_true', default=False, help='Sign upgrade image')
     mkota_parser.add_argument('-e', '--encrypted', action='store_true', default=False, help='Encrypt upgrade file')
+    mkota_parser.add_argument('-c', '--compressed', action='store_true', default=False,
+        help='Compress ROM images. Requires firmware built with ENABLE_OTA_COMPRESSION=1.')
+    mkota_parser.add_argument('--window-bits', type=int, default=10,
+        help='Compression window size as power of 2, from 8 to 12. The device allocates this much RAM during upgrade.')
 
     def get_address(string):
         try:
@@ -233,6 +414,13 @@ def make_parser():
         help="Image file and flash offset address of ROM to include in the OTA upgrade file, e.g. 'rom0.bin@0x2000'")
     mkota_parser.set_defaults(func=make_ota_file)
 
+    mkpatch_parser = subparsers.add_parser('mkpatch', help='Generate delta patch from currently installed firmware image \
+        for use with Ota::PatchOutputStream')
+    mkpatch_parser.add_argument('-s', '--source', required=True, help='Firmware image currently installed on device')
+    mkpatch_parser.add_argument('-t', '--target', required=True, help='New firmware image')
+    mkpatch_parser.add_argument('-o', '--output', required=True, help='Output location of patch file')
+    mkpatch_parser.set_defaults(func=make_patch_file)
+
     upload_parser = subparsers.add_parser('upload', help='HTTP POST upload of OTA upgrade image (encoded as multipart/form-data)')
     upload_parser.add_argument('--field', default='firmware', help='Set the field of the form data field')
     upload_parser.add_argument('-u', '--url', required=True, help='Upload Url')
@@ -1,6 +1,7 @@
 #include <SmingCore.h>
 #include <Storage/SpiFlash.h>
 #include <Ota/Manager.h>
+#include <Network/Mqtt/MqttStreamRouter.h>
 #include <OtaUpgrade/Mqtt/StandardPayloadParser.h>
 
 #if ENABLE_OTA_ADVANCED
@@ -22,6 +23,7 @@
 namespace
 {
 MqttClient mqtt;
+MqttStreamRouter router;
 
 #if ENABLE_CLIENT_CERTIFICATE
 IMPORT_FSTR(privateKeyData, PROJECT_DIR "/files/private.pem.key.der");
@@ -79,13 +81,17 @@ void otaUpdate()
 	auto parser = new OtaUpgrade::Mqtt::StandardPayloadParser(part, APP_VERSION_PATCH);
 #endif
 
-	mqtt.setPayloadParser([parser](MqttPayloadParserState& state, mqtt_message_t* message, const char* buffer,
-								   int length) -> int { return parser->parse(state, message, buffer, length); });
-
 	String updateTopic = "a/";
 	updateTopic += APP_ID;
 	updateTopic += "/u/";
 	updateTopic += APP_VERSION;
+
+	/*
+	 * Firmware is written to flash as it arrives. Messages on other topics are buffered as usual.
+	 */
+	router.add(updateTopic, parser->getParser());
+	mqtt.setPayloadParser(router.getParser());
+
 	debug_d("Subscribing to topic: %s", updateTopic.c_str());
 	mqtt.subscribe(updateTopic);
 }
@@ -79,6 +79,14 @@ public:
 	 */
 	int parse(MqttPayloadParserState& state, mqtt_message_t* message, const char* buffer, int length);
 
+	/**
+	 * @brief Get a delegate for `MqttClient::setPayloadParser()` or `MqttStreamRouter::add()`
+	 */
+	MqttPayloadParser getParser()
+	{
+		return MqttPayloadParser(&PayloadParser::parse, this);
+	}
+
 private:
 	int getPatchVersion(const char* buffer, int length, size_t& offset, size_t versionStart = 0);
 
@@ -0,0 +1,8 @@
+COMPONENT_SOC := rp2040
+
+COMPONENT_DEPENDS := Adafruit_GFX
+
+COMPONENT_SRCDIRS := src
+COMPONENT_INCDIRS := src
+
+COMPONENT_DOXYGEN_INPUT := src
@@ -0,0 +1,286 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/SmingHub/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * ParallelBus.cpp
+ *
+ * The PIO program, pre-assembled:
+ *
+ *	.side_set 1
+ *	.wrap_target
+ *		out pins, <width>	side 1
+ *		nop					side 0
+ *		nop					side 1
+ *	.wrap
+ *
+ * The state machine stalls on `out` with WR high, so the bus is idle between transfers.
+ * Data is shifted out MSB first. A 16-bit DMA write is replicated across the 32-bit FIFO word,
+ * so with an 8-bit bus and a pull threshold of 16 each pixel is sent high byte first.
+ * Commands are written with the threshold set to the bus width.
+ *
+ ****/
+
+#include "ParallelBus.h"
+#include <hardware/pio.h>
+#include <hardware/dma.h>
+#include <hardware/gpio.h>
+#include <hardware/clocks.h>
+#include <debug_progmem.h>
+#include <algorithm>
+
+namespace
+{
+constexpr unsigned cyclesPerWrite{3};
+
+constexpr uint16_t program8Instructions[]{
+	0x7008, //  0: out    pins, 8         side 1
+	0xa042, //  1: nop                    side 0
+	0xb042, //  2: nop                    side 1
+};
+
+constexpr uint16_t program16Instructions[]{
+	0x7010, //  0: out    pins, 16        side 1
+	0xa042, //  1: nop                    side 0
+	0xb042, //  2: nop                    side 1
+};
+
+const pio_program_t program8{
+	.instructions = program8Instructions,
+	.length = ARRAY_SIZE(program8Instructions),
+	.origin = -1,
+};
+
+const pio_program_t program16{
+	.instructions = program16Instructions,
+	.length = ARRAY_SIZE(program16Instructions),
+	.origin = -1,
+};
+
+// Program offset for each PIO and bus width, shared by all buses
+int8_t programOffsets[NUM_PIOS][2]{{-1, -1}, {-1, -1}};
+
+__forceinline PIO getPio(unsigned index)
+{
+	return index ? pio1 : pio0;
+}
+
+} // namespace
+
+bool ParallelBus::begin(const Config& cfg)
+{
+	end();
+
+	if(cfg.width != 8 && cfg.width != 16) {
+		return false;
+	}
+	if(cfg.dataPin + cfg.width > NUM_BANK0_GPIOS || cfg.wrPin >= NUM_BANK0_GPIOS ||
+	   cfg.dcPin >= NUM_BANK0_GPIOS || cfg.csPin >= int(NUM_BANK0_GPIOS)) {
+		return false;
+	}
+
+	auto& program = (cfg.width == 8) ? program8 : program16;
+	unsigned programIndex = (cfg.width == 8) ? 0 : 1;
+
+	for(unsigned i = 0; i < NUM_PIOS; ++i) {
+		auto pio = getPio(i);
+		if(programOffsets[i][programIndex] < 0 && !pio_can_add_program(pio, &program)) {
+			continue;
+		}
+		int n = pio_claim_unused_sm(pio, false);
+		if(n < 0) {
+			continue;
+		}
+		if(programOffsets[i][programIndex] < 0) {
+			programOffsets[i][programIndex] = pio_add_program(pio, &program);
+		}
+		pioIndex = i;
+		sm = n;
+		break;
+	}
+	if(sm < 0) {
+		debug_e("[PBUS] No free PIO state machine");
+		return false;
+	}
+
+	dma = dma_claim_unused_channel(false);
+	if(dma < 0) {
+		debug_e("[PBUS] No free DMA channel");
+		pio_sm_unclaim(getPio(pioIndex), sm);
+		sm = -1;
+		return false;
+	}
+
+	config = cfg;
+	programOffset = programOffsets[pioIndex][programIndex];
+
+	// Control lines
+	gpio_init(config.dcPin);
+	gpio_put(config.dcPin, true);
+	gpio_set_dir(config.dcPin, GPIO_OUT);
+	if(config.csPin >= 0) {
+		gpio_init(config.csPin);
+		gpio_put(config.csPin, true);
+		gpio_set_dir(config.csPin, GPIO_OUT);
+	}
+
+	// State machine
+	auto pio = getPio(pioIndex);
+	for(unsigned i = 0; i < config.width; ++i) {
+		pio_gpio_init(pio, config.dataPin + i);
+	}
+	pio_gpio_init(pio, config.wrPin);
+	pio_sm_set_pins_with_mask(pio, sm, 1U << config.wrPin, 1U << config.wrPin);
+	pio_sm_set_consecutive_pindirs(pio, sm, config.dataPin, config.width, true);
+	pio_sm_set_consecutive_pindirs(pio, sm, config.wrPin, 1, true);
+
+	auto c = pio_get_default_sm_config();
+	sm_config_set_wrap(&c, programOffset, programOffset + program.length - 1);
+	sm_config_set_sideset(&c, 1, false, false);
+	sm_config_set_sideset_pins(&c, config.wrPin);
+	sm_config_set_out_pins(&c, config.dataPin, config.width);
+	sm_config_set_out_shift(&c, false, true, config.width);
+	sm_config_set_fifo_join(&c, PIO_FIFO_JOIN_TX);
+	float div = float(clock_get_hz(clk_sys)) / (config.frequency * cyclesPerWrite);
+	sm_config_set_clkdiv(&c, std::max(div, 1.0f));
+	pio_sm_init(pio, sm, programOffset, &c);
+	pio_sm_set_enabled(pio, sm, true);
+	wordBits = config.width;
+
+	// DMA, with source, count and increment set per transfer
+	auto dc = dma_channel_get_default_config(dma);
+	channel_config_set_transfer_data_size(&dc, DMA_SIZE_16);
+	channel_config_set_write_increment(&dc, false);
+	channel_config_set_dreq(&dc, pio_get_dreq(pio, sm, true));
+	dma_channel_configure(dma, &dc, &pio->txf[sm], nullptr, 0, false);
+
+	return true;
+}
+
+void ParallelBus::end()
+{
+	if(sm < 0) {
+		return;
+	}
+
+	wait();
+	dma_channel_unclaim(dma);
+	dma = -1;
+	auto pio = getPio(pioIndex);
+	pio_sm_set_enabled(pio, sm, false);
+	pio_sm_unclaim(pio, sm);
+	sm = -1;
+}
+
+bool ParallelBus::isBusy() const
+{
+	if(sm < 0) {
+		return false;
+	}
+	return dma_channel_is_busy(dma) || !pio_sm_is_tx_fifo_empty(getPio(pioIndex), sm);
+}
+
+void ParallelBus::wait()
+{
+	if(sm < 0) {
+		return;
+	}
+
+	dma_channel_wait_for_finish_blocking(dma);
+
+	// FIFO empty is not enough: the state machine must also have shifted out the last word
+	auto pio = getPio(pioIndex);
+	uint32_t stallMask = 1U << (PIO_FDEBUG_TXSTALL_LSB + sm);
+	pio->fdebug = stallMask;
+	while((pio->fdebug & stallMask) == 0) {
+	}
+}
+
+/*
+ * The pull threshold is changed with the state machine halted, then restarted
+ * so its output shift register is empty and the next word is pulled afresh.
+ */
+void ParallelBus::setWordBits(uint8_t bits)
+{
+	if(bits == wordBits) {
+		return;
+	}
+
+	wait();
+	auto pio = getPio(pioIndex);
+	pio_sm_set_enabled(pio, sm, false);
+	hw_write_masked(&pio->sm[sm].shiftctrl, uint32_t(bits) << PIO_SM0_SHIFTCTRL_PULL_THRESH_LSB,
+					PIO_SM0_SHIFTCTRL_PULL_THRESH_BITS);
+	pio_sm_restart(pio, sm);
+	pio_sm_exec(pio, sm, pio_encode_jmp(programOffset));
+	pio_sm_set_enabled(pio, sm, true);
+	wordBits = bits;
+}
+
+void ParallelBus::writeCommand(uint8_t command, const uint8_t* params, size_t length)
+{
+	if(sm < 0) {
+		return;
+	}
+
+	setWordBits(config.width);
+	wait();
+
+	auto pio = getPio(pioIndex);
+	unsigned shift = 32 - config.width;
+	gpio_put(config.dcPin, false);
+	pio_sm_put_blocking(pio, sm, uint32_t(command) << shift);
+	wait();
+	gpio_put(config.dcPin, true);
+	for(size_t i = 0; i < length; ++i) {
+		pio_sm_put_blocking(pio, sm, uint32_t(params[i]) << shift);
+	}
+}
+
+void ParallelBus::startDma(const void* src, size_t count, bool increment)
+{
+	auto dc = dma_get_channel_config(dma);
+	channel_config_set_read_increment(&dc, increment);
+	dma_channel_set_config(dma, &dc, false);
+	dma_channel_transfer_from_buffer_now(dma, src, count);
+}
+
+void ParallelBus::writePixels(const uint16_t* pixels, size_t count)
+{
+	if(sm < 0 || count == 0) {
+		return;
+	}
+
+	setWordBits(16);
+	dma_channel_wait_for_finish_blocking(dma);
+	startDma(pixels, count, true);
+}
+
+void ParallelBus::fillPixels(uint16_t color, size_t count)
+{
+	if(sm < 0 || count == 0) {
+		return;
+	}
+
+	setWordBits(16);
+	dma_channel_wait_for_finish_blocking(dma);
+	fillValue = color;
+	startDma(&fillValue, count, false);
+}
+
+void ParallelBus::select()
+{
+	if(config.csPin >= 0) {
+		wait();
+		gpio_put(config.csPin, false);
+	}
+}
+
+void ParallelBus::deselect()
+{
+	if(config.csPin >= 0) {
+		wait();
+		gpio_put(config.csPin, true);
+	}
+}
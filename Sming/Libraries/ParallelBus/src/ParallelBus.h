@@ -0,0 +1,114 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/SmingHub/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * ParallelBus.h - 8080-style parallel display bus using RP2040 PIO and DMA
+ *
+ ****/
+
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+
+/**
+ * @brief Write-only 8080-style parallel bus, as used by many TFT display controllers
+ *
+ * One PIO state machine generates the WR strobe and drives the data lines, fed by DMA.
+ * Pixel transfers run in the background. DC and CS are driven directly, after the state
+ * machine has finished any previous transfer.
+ *
+ * Each bus write takes three PIO cycles: data is set with WR high, then WR is pulsed low.
+ * At the default 125 MHz system clock the bus therefore runs at up to about 40 million writes per second,
+ * although most controllers specify a much lower limit.
+ */
+class ParallelBus
+{
+public:
+	struct Config {
+		uint8_t dataPin;			  ///< First data line, D0. Remaining lines use consecutive GPIOs.
+		uint8_t width{8};			  ///< 8 or 16 data lines
+		uint8_t wrPin;				  ///< Write strobe
+		uint8_t dcPin;				  ///< Data/command select, also known as RS
+		int8_t csPin{-1};			  ///< Chip select, or -1 if tied low
+		uint32_t frequency{20000000}; ///< Maximum write rate
+	};
+
+	ParallelBus() = default;
+	ParallelBus(const ParallelBus&) = delete;
+	ParallelBus& operator=(const ParallelBus&) = delete;
+
+	~ParallelBus()
+	{
+		end();
+	}
+
+	/**
+	 * @brief Claim a PIO state machine and DMA channel, and configure pins
+	 * @retval bool false if configuration is invalid or resources are unavailable
+	 */
+	bool begin(const Config& config);
+
+	/**
+	 * @brief Wait for any transfer to complete and release resources
+	 */
+	void end();
+
+	/**
+	 * @brief Write a command followed by any parameter bytes
+	 * @note Waits for any previous transfer first. Parameters are written before returning.
+	 */
+	void writeCommand(uint8_t command, const uint8_t* params = nullptr, size_t length = 0);
+
+	/**
+	 * @brief Start writing pixel data
+	 * @param pixels Must remain valid until the transfer completes
+	 * @param count Number of pixels
+	 * @note With an 8-bit bus each pixel is sent as two writes, high byte first
+	 */
+	void writePixels(const uint16_t* pixels, size_t count);
+
+	/**
+	 * @brief Start writing the same pixel value repeatedly
+	 */
+	void fillPixels(uint16_t color, size_t count);
+
+	/**
+	 * @brief Determine if a transfer is in progress
+	 */
+	bool isBusy() const;
+
+	/**
+	 * @brief Wait until all data has been written to the bus
+	 */
+	void wait();
+
+	/**
+	 * @brief Assert chip select, if used
+	 */
+	void select();
+
+	/**
+	 * @brief Release chip select, if used, once all data has been written
+	 */
+	void deselect();
+
+	uint8_t getWidth() const
+	{
+		return config.width;
+	}
+
+private:
+	void setWordBits(uint8_t bits);
+	void startDma(const void* src, size_t count, bool increment);
+
+	Config config{};
+	uint16_t fillValue{0};
+	int8_t pioIndex{-1};
+	int8_t sm{-1};
+	int8_t dma{-1};
+	uint8_t programOffset{0};
+	uint8_t wordBits{0}; ///< Bits per FIFO word: bus width for commands, 16 for pixels
+};
@@ -0,0 +1,152 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/SmingHub/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * ParallelTFT.cpp
+ *
+ ****/
+
+#include "ParallelTFT.h"
+#include <Digital.h>
+#include <Clock.h>
+#include <algorithm>
+
+namespace
+{
+// MIPI DCS commands
+constexpr uint8_t DCS_SOFT_RESET{0x01};
+constexpr uint8_t DCS_EXIT_SLEEP_MODE{0x11};
+constexpr uint8_t DCS_EXIT_INVERT_MODE{0x20};
+constexpr uint8_t DCS_ENTER_INVERT_MODE{0x21};
+constexpr uint8_t DCS_SET_DISPLAY_ON{0x29};
+constexpr uint8_t DCS_SET_COLUMN_ADDRESS{0x2A};
+constexpr uint8_t DCS_SET_PAGE_ADDRESS{0x2B};
+constexpr uint8_t DCS_WRITE_MEMORY_START{0x2C};
+constexpr uint8_t DCS_SET_ADDRESS_MODE{0x36};
+constexpr uint8_t DCS_SET_PIXEL_FORMAT{0x3A};
+
+// Address mode bits
+constexpr uint8_t MADCTL_MY{0x80};
+constexpr uint8_t MADCTL_MX{0x40};
+constexpr uint8_t MADCTL_MV{0x20};
+constexpr uint8_t MADCTL_BGR{0x08};
+
+constexpr uint8_t PIXEL_FORMAT_16BPP{0x55};
+
+} // namespace
+
+void ParallelTFT::begin(int8_t resetPin, bool bgr)
+{
+	this->bgr = bgr;
+
+	bus.select();
+	if(resetPin >= 0) {
+		pinMode(resetPin, OUTPUT);
+		digitalWrite(resetPin, LOW);
+		delay(10);
+		digitalWrite(resetPin, HIGH);
+	} else {
+		bus.writeCommand(DCS_SOFT_RESET);
+	}
+	delay(150);
+
+	bus.writeCommand(DCS_EXIT_SLEEP_MODE);
+	delay(120);
+	bus.writeCommand(DCS_SET_PIXEL_FORMAT, &PIXEL_FORMAT_16BPP, 1);
+	setRotation(getRotation());
+	bus.writeCommand(DCS_SET_DISPLAY_ON);
+}
+
+void ParallelTFT::setRotation(uint8_t r)
+{
+	Adafruit_GFX::setRotation(r);
+
+	static constexpr uint8_t modes[]{
+		MADCTL_MX,
+		MADCTL_MV,
+		MADCTL_MY,
+		MADCTL_MX | MADCTL_MY | MADCTL_MV,
+	};
+	uint8_t mode = modes[getRotation()];
+	if(bgr) {
+		mode |= MADCTL_BGR;
+	}
+
+	bus.writeCommand(DCS_SET_ADDRESS_MODE, &mode, 1);
+}
+
+void ParallelTFT::invertDisplay(bool invert)
+{
+	bus.writeCommand(invert ? DCS_ENTER_INVERT_MODE : DCS_EXIT_INVERT_MODE);
+}
+
+void ParallelTFT::setWindow(uint16_t x, uint16_t y, uint16_t w, uint16_t h)
+{
+	uint16_t x1 = x + w - 1;
+	uint16_t y1 = y + h - 1;
+	uint8_t columns[]{uint8_t(x >> 8), uint8_t(x), uint8_t(x1 >> 8), uint8_t(x1)};
+	uint8_t pages[]{uint8_t(y >> 8), uint8_t(y), uint8_t(y1 >> 8), uint8_t(y1)};
+	bus.writeCommand(DCS_SET_COLUMN_ADDRESS, columns, sizeof(columns));
+	bus.writeCommand(DCS_SET_PAGE_ADDRESS, pages, sizeof(pages));
+	bus.writeCommand(DCS_WRITE_MEMORY_START);
+}
+
+void ParallelTFT::drawPixel(int16_t x, int16_t y, uint16_t color)
+{
+	fillRect(x, y, 1, 1, color);
+}
+
+void ParallelTFT::fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color)
+{
+	if(w < 0) {
+		x += w + 1;
+		w = -w;
+	}
+	if(h < 0) {
+		y += h + 1;
+		h = -h;
+	}
+	if(x < 0) {
+		w += x;
+		x = 0;
+	}
+	if(y < 0) {
+		h += y;
+		y = 0;
+	}
+	w = std::min(int(w), width() - x);
+	h = std::min(int(h), height() - y);
+	if(w <= 0 || h <= 0) {
+		return;
+	}
+
+	setWindow(x, y, w, h);
+	bus.fillPixels(color, size_t(w) * h);
+}
+
+void ParallelTFT::drawFastVLine(int16_t x, int16_t y, int16_t h, uint16_t color)
+{
+	fillRect(x, y, 1, h, color);
+}
+
+void ParallelTFT::drawFastHLine(int16_t x, int16_t y, int16_t w, uint16_t color)
+{
+	fillRect(x, y, w, 1, color);
+}
+
+void ParallelTFT::fillScreen(uint16_t color)
+{
+	fillRect(0, 0, width(), height(), color);
+}
+
+void ParallelTFT::pushPixels(int16_t x, int16_t y, int16_t w, int16_t h, const uint16_t* pixels)
+{
+	if(x < 0 || y < 0 || w <= 0 || h <= 0 || x + w > width() || y + h > height()) {
+		return;
+	}
+
+	setWindow(x, y, w, h);
+	bus.writePixels(pixels, size_t(w) * h);
+}
@@ -0,0 +1,85 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/SmingHub/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * ParallelTFT.h - Adafruit_GFX display on a ParallelBus
+ *
+ ****/
+
+#pragma once
+
+#include <Adafruit_GFX.h>
+#include "ParallelBus.h"
+
+/**
+ * @brief TFT display connected via a ParallelBus
+ *
+ * Works with controllers using the standard MIPI DCS command set in 16 bits per pixel mode,
+ * such as the ILI9341, ILI9488 and ST7796.
+ *
+ * Filled areas and pixel blocks are sent by DMA, so drawing calls return as soon as the
+ * transfer has started. The next call waits for it to finish.
+ *
+ * The display is selected by `begin()` and remains so: the bus is dedicated to it.
+ */
+class ParallelTFT : public Adafruit_GFX
+{
+public:
+	/**
+	 * @brief Constructor
+	 * @param bus Must already have been started with `ParallelBus::begin()`
+	 * @param width Width of panel in its native orientation
+	 * @param height Height of panel in its native orientation
+	 */
+	ParallelTFT(ParallelBus& bus, uint16_t width, uint16_t height) : Adafruit_GFX(width, height), bus(bus)
+	{
+	}
+
+	/**
+	 * @brief Initialise the display controller
+	 * @param resetPin Hardware reset line, or -1 to use a software reset
+	 * @param bgr Set if the panel has blue and red subpixels swapped
+	 */
+	void begin(int8_t resetPin = -1, bool bgr = true);
+
+	/**
+	 * @name Adafruit_GFX methods
+	 * @{
+	 */
+	void drawPixel(int16_t x, int16_t y, uint16_t color) override;
+	void fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color) override;
+	void drawFastVLine(int16_t x, int16_t y, int16_t h, uint16_t color) override;
+	void drawFastHLine(int16_t x, int16_t y, int16_t w, uint16_t color) override;
+	void fillScreen(uint16_t color) override;
+	void setRotation(uint8_t r) override;
+	void invertDisplay(bool invert) override;
+	/** @} */
+
+	/**
+	 * @brief Send a block of pixels
+	 * @param pixels Row-major pixel data, which must remain valid until `wait()` returns
+	 * @note Area must lie within the display
+	 */
+	void pushPixels(int16_t x, int16_t y, int16_t w, int16_t h, const uint16_t* pixels);
+
+	/**
+	 * @brief Wait for any transfer in progress to complete
+	 */
+	void wait()
+	{
+		bus.wait();
+	}
+
+	ParallelBus& getBus()
+	{
+		return bus;
+	}
+
+private:
+	void setWindow(uint16_t x, uint16_t y, uint16_t w, uint16_t h);
+
+	ParallelBus& bus;
+	bool bgr{true};
+};
@@ -73,6 +73,10 @@ const unsigned int RCSwitch::nSeparationLimit = 4600;
 // according to discussion on issue #14 it might be more suitable to set the separation
 // limit to the same time as the 'low' part of the sync signal for the current protocol.
 unsigned int RCSwitch::timings[RCSWITCH_MAX_CHANGES];
+#if not defined(RaspberryPi)
+// Receiver shared by all instances, as with the interrupt handler
+static PulseCapture receiveCapture;
+#endif
 #endif
 
 RCSwitch::RCSwitch() {
@@ -622,12 +626,39 @@ void RCSwitch::enableReceive() {
   }
 }
 
+#if not defined(RaspberryPi)
+/**
+ * Enable receiving data using PulseCapture
+ *
+ * Edges are timestamped by the capture hardware and decoded in task context,
+ * so reception isn't affected by interrupt latency and doesn't add to it.
+ */
+void RCSwitch::enableReceiveCapture(int pinNumber) {
+  this->nReceiverInterrupt = pinNumber;
+  RCSwitch::nReceivedValue = 0;
+  RCSwitch::nReceivedBitlength = 0;
+  if (!receiveCapture.begin(pinNumber, handleCapture)) {
+    this->nReceiverInterrupt = -1;
+  }
+}
+
+void RCSwitch::handleCapture(const PulseCapture::Pulse* pulses, size_t count) {
+  for (unsigned int i = 0; i < count; i++) {
+    handleDuration(pulses[i].duration);
+  }
+}
+#endif
+
 /**
  * Disable receiving data
  */
 void RCSwitch::disableReceive() {
 #if not defined(RaspberryPi) // Arduino
-  detachInterrupt(this->nReceiverInterrupt);
+  if (receiveCapture.isRunning()) {
+    receiveCapture.end();
+  } else {
+    detachInterrupt(this->nReceiverInterrupt);
+  }
 #endif // For Raspberry Pi (wiringPi) you can't unregister the ISR
   this->nReceiverInterrupt = -1;
 }
@@ -704,15 +735,21 @@ bool RCSwitch::receiveProtocol(const int p, unsigned int changeCount) {
 
 void RCSwitch::handleInterrupt() {
 
-  static unsigned int duration;
-  static unsigned int changeCount;
   static unsigned long lastTime;
-  static unsigned int repeatCount;
-
 
   long time = system_get_time(); //micros();
-  duration = time - lastTime;
- 
+  handleDuration(time - lastTime);
+  lastTime = time;
+}
+
+/**
+ * Process the duration of the pulse which has just ended
+ */
+void RCSwitch::handleDuration(unsigned int duration) {
+
+  static unsigned int changeCount;
+  static unsigned int repeatCount;
+
   if (duration > RCSwitch::nSeparationLimit && diff(duration, RCSwitch::timings[0]) < 200) {
     repeatCount++;
     changeCount--;
@@ -735,7 +772,6 @@ void RCSwitch::handleInterrupt() {
     repeatCount = 0;
   }
   RCSwitch::timings[changeCount++] = duration;
-  lastTime = time;  
 }
 #endif
 
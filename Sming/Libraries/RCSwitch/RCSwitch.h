@@ -60,6 +60,7 @@
     // Last line within Raspberry Pi block
 #else
     #include "WProgram.h"
+    #include <PulseCapture.h>
 #endif
 
 
@@ -96,6 +97,9 @@ class RCSwitch {
     #if not defined( RCSwitchDisableReceiving )
     void enableReceive(int pinNumber);
     void enableReceive();
+    #if not defined(RaspberryPi)
+    void enableReceiveCapture(int pinNumber);
+    #endif
     void disableReceive();
     bool available();
     void resetAvailable();
@@ -150,6 +154,10 @@ class RCSwitch {
     
     #if not defined( RCSwitchDisableReceiving )
     static IRAM_ATTR void handleInterrupt();
+    static IRAM_ATTR void handleDuration(unsigned int duration);
+    #if not defined(RaspberryPi)
+    static void handleCapture(const PulseCapture::Pulse* pulses, size_t count);
+    #endif
     static IRAM_ATTR bool receiveProtocol(const int p, unsigned int changeCount);
     int nReceiverInterrupt;
     #endif
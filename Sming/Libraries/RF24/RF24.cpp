@@ -9,6 +9,7 @@
 #include "nRF24L01.h"
 #include "RF24_config.h"
 #include "RF24.h"
+#include <new>
 
 /****************************************************************************/
 
@@ -402,6 +403,9 @@ void RF24::startListening(void)
   flush_rx();
   flush_tx();
 
+  if (irq)
+    irq->tx_active = false;
+
   // Go!
   ce(HIGH);
 
@@ -977,5 +981,246 @@ void RF24::setRetries(uint8_t delay, uint8_t count)
  write_register(SETUP_RETR,(delay&0xf)<<ARD | (count&0xf)<<ARC);
 }
 
+/****************************************************************************/
+
+bool RF24::allocIrq(void)
+{
+  if (!irq)
+  {
+    irq.reset(new (std::nothrow) IrqState{});
+    if (!irq)
+      return false;
+    irq->irq_pin = 0xff;
+    irq->rx.setNotify(packetNotify, this);
+  }
+  return true;
+}
+
+/****************************************************************************/
+
+bool RF24::beginIrq(uint8_t irq_pin)
+{
+  if (!allocIrq())
+    return false;
+
+  irq->irq_pin = irq_pin;
+
+  // Unmask all interrupt sources and clear anything pending
+  write_register(CONFIG, read_register(CONFIG) & ~(_BV(MASK_RX_DR) | _BV(MASK_TX_DS) | _BV(MASK_MAX_RT)));
+
+  pinMode(irq_pin, INPUT);
+  attachInterrupt(irq_pin, InterruptDelegate(&RF24::irqService, this), FALLING);
+
+  // Collect anything which arrived before the handler was attached
+  irqService();
+
+  return true;
+}
+
+/****************************************************************************/
+
+void RF24::endIrq(void)
+{
+  if (!irq || irq->irq_pin == 0xff)
+    return;
+
+  detachInterrupt(irq->irq_pin);
+  irq->irq_pin = 0xff;
+  if (irq->tx_active)
+  {
+    ce(LOW);
+    irq->tx_active = false;
+  }
+
+  // Queues are retained as a notification may still be pending
+  irq->tx.clear();
+}
+
+/****************************************************************************/
+
+void RF24::onPacket(Delegate<void()> callback)
+{
+  if (allocIrq())
+    irq->packetCallback = callback;
+}
+
+/****************************************************************************/
+
+void RF24::packetNotify(void* param)
+{
+  RF24* self = static_cast<RF24*>(param);
+  if (self->irq->packetCallback)
+    self->irq->packetCallback();
+}
+
+/****************************************************************************/
+
+bool RF24::readPacket(RF24Packet& packet)
+{
+  return irq && irq->rx.pop(packet);
+}
+
+/****************************************************************************/
+
+void RF24::irqService(void)
+{
+  if (!irq || irq->irq_pin == 0xff)
+    return;
+
+  // Clearing the flags first releases the IRQ line, so anything which
+  // happens from here on raises another interrupt
+  uint8_t flags = write_register(REG_STATUS, _BV(RX_DR) | _BV(TX_DS) | _BV(MAX_RT));
+
+  // Drain the RX FIFO: the pipe number reads as B111 when it's empty
+  bool received = false;
+  for (;;)
+  {
+    uint8_t status;
+    uint8_t len = payload_size;
+    csn(LOW);
+    if (dynamic_payloads_enabled)
+    {
+      status = SPI.transfer( R_RX_PL_WID );
+      len = SPI.transfer(0xff);
+    }
+    else
+      status = SPI.transfer( NOP );
+    csn(HIGH);
+
+    uint8_t pipe = ( status >> RX_P_NO ) & B111;
+    if (pipe > 5)
+      break;
+
+    if (len > 32)
+    {
+      // Corrupt payload, datasheet says to flush
+      flush_rx();
+      break;
+    }
+
+    // Command and payload in a single transfer
+    uint8_t buf[1 + 32];
+    buf[0] = R_RX_PAYLOAD;
+    memset(&buf[1], 0xff, len);
+    csn(LOW);
+    SPI.transfer(buf, 1 + len);
+    csn(HIGH);
+
+    RF24PipeStats& stats = irq->pipeStats[pipe];
+    if (!irq->rx.space())
+    {
+      stats.dropped++;
+      continue;
+    }
+
+    RF24Packet* packet;
+    irq->rx.getWriteSpan(packet);
+    packet->pipe = pipe;
+    packet->length = len;
+    memcpy(packet->data, &buf[1], len);
+    irq->rx.commitWrite(1);
+    stats.received++;
+    received = true;
+  }
+
+  if (received)
+    irq->rx.notify();
+
+  if (flags & _BV(MAX_RT))
+  {
+    // Radio will not continue until the failed payload is removed
+    irq->txStats.failed++;
+    flush_tx();
+  }
+
+  if (irq->tx_active)
+    fillTxFifo(get_status());
+}
+
+/****************************************************************************/
+
+void RF24::fillTxFifo(uint8_t status)
+{
+  RF24Packet packet;
+  while ( !(status & _BV(TX_FULL)) && irq->tx.pop(packet) )
+  {
+    uint8_t data_len = min(packet.length, payload_size);
+    uint8_t total_len = dynamic_payloads_enabled ? data_len : payload_size;
+
+    uint8_t buf[1 + 32];
+    buf[0] = W_TX_PAYLOAD;
+    memcpy(&buf[1], packet.data, data_len);
+    memset(&buf[1 + data_len], 0, total_len - data_len);
+    csn(LOW);
+    SPI.transfer(buf, 1 + total_len);
+    csn(HIGH);
+
+    irq->txStats.written++;
+    status = get_status();
+  }
+}
+
+/****************************************************************************/
+
+bool RF24::queuePacket(const void* buf, uint8_t len)
+{
+  if (!irq || irq->irq_pin == 0xff || len > sizeof(RF24Packet::data))
+    return false;
+
+  RF24Packet packet;
+  packet.pipe = 0;
+  packet.length = len;
+  memcpy(packet.data, buf, len);
+  if (!irq->tx.push(packet))
+  {
+    irq->txStats.dropped++;
+    return false;
+  }
+
+  if (!irq->tx_active)
+  {
+    // Transmitter power-up
+    uint8_t config = read_register(CONFIG);
+    write_register(CONFIG, ( config | _BV(PWR_UP) ) & ~_BV(PRIM_RX) );
+    if (!(config & _BV(PWR_UP)))
+      delayMicroseconds(150);
+
+    // CE is held high so the FIFO is sent back-to-back as it's refilled
+    fillTxFifo(get_status());
+    ce(HIGH);
+    irq->tx_active = true;
+  }
+  else
+    fillTxFifo(get_status());
+
+  return true;
+}
+
+/****************************************************************************/
+
+RF24PipeStats RF24::getPipeStats(uint8_t pipe) const
+{
+  if (irq && pipe < 6)
+    return irq->pipeStats[pipe];
+  return RF24PipeStats{};
+}
+
+/****************************************************************************/
+
+RF24TxStats RF24::getTxStats(void) const
+{
+  return irq ? irq->txStats : RF24TxStats{};
+}
+
+/****************************************************************************/
+
+void RF24::resetStats(void)
+{
+  if (!irq)
+    return;
+  memset(irq->pipeStats, 0, sizeof(irq->pipeStats));
+  irq->txStats = RF24TxStats{};
+}
+
 // vim:ai:cin:sts=2 sw=2 ft=cpp
 
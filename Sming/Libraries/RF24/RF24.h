@@ -16,6 +16,9 @@
 #define __RF24_H__
 
 #include "RF24_config.h"
+#include <Data/Buffer/SpscRing.h>
+#include <Delegate.h>
+#include <memory>
 
 /**
  * Power Amplifier level.
@@ -38,6 +41,35 @@ typedef enum { RF24_1MBPS = 0, RF24_2MBPS, RF24_250KBPS } rf24_datarate_e;
  */
 typedef enum { RF24_CRC_DISABLED = 0, RF24_CRC_8, RF24_CRC_16 } rf24_crclength_e;
 
+/**
+ * A packet received or queued for sending in interrupt-driven mode
+ */
+struct RF24Packet
+{
+  uint8_t pipe; /**< Pipe the packet was received on, unused for transmit */
+  uint8_t length; /**< Number of bytes in @p data */
+  uint8_t data[32];
+};
+
+/**
+ * Receive statistics for one pipe, in interrupt-driven mode
+ */
+struct RF24PipeStats
+{
+  uint32_t received; /**< Packets queued for the application */
+  uint32_t dropped; /**< Packets discarded because the receive queue was full */
+};
+
+/**
+ * Transmit statistics, in interrupt-driven mode
+ */
+struct RF24TxStats
+{
+  uint32_t written; /**< Packets loaded into the radio's TX FIFO */
+  uint32_t failed; /**< Retries exhausted (MAX_RT). Any other packets in the TX FIFO are also discarded. */
+  uint32_t dropped; /**< Packets rejected by queuePacket() because the transmit queue was full */
+};
+
 /**
  * Driver for nRF24L01(+) 2.4GHz Wireless Transceiver
  */
@@ -55,6 +87,21 @@ private:
   uint8_t ack_payload_length; /**< Dynamic size of pending ack payload. */
   uint64_t pipe0_reading_address; /**< Last address set on pipe 0 for reading. */
 
+  /**
+   * State for interrupt-driven operation, only allocated if beginIrq() is called
+   */
+  struct IrqState
+  {
+    SpscRing<RF24Packet, RF24_RX_QUEUE_SIZE> rx;
+    SpscRing<RF24Packet, RF24_TX_QUEUE_SIZE> tx;
+    Delegate<void()> packetCallback;
+    RF24PipeStats pipeStats[6];
+    RF24TxStats txStats;
+    uint8_t irq_pin;
+    bool tx_active; /**< In transmit mode with CE held high */
+  };
+  std::unique_ptr<IrqState> irq;
+
 protected:
   /**
    * @name Low-level internal interface.
@@ -647,6 +694,95 @@ public:
   bool isValid() { return ce_pin != 0xff && csn_pin != 0xff; } 
 
   /**@}*/
+  /**
+   * @name Interrupt-driven operation
+   *
+   *  Instead of polling, the radio's IRQ pin is used to service the FIFOs.
+   *  Each interrupt drains all received payloads into a receive queue and keeps
+   *  the 3-deep TX FIFO topped up from a transmit queue, so the radio can
+   *  receive and send back-to-back without waiting for the application.
+   *
+   *  The interrupt is serviced in task context, as the SPI bus cannot be used
+   *  from an interrupt handler. The application reads packets from the queue
+   *  using readPacket(), typically from the callback set by onPacket().
+   *
+   *  Do not mix these methods with available(), read() or write().
+   */
+  /**@{*/
+
+  /**
+   * Enable interrupt-driven operation
+   *
+   * Enables all three interrupt sources on the radio and attaches a handler to @p irq_pin.
+   * Call after begin() and after configuring pipes.
+   *
+   * @param irq_pin The pin attached to IRQ on the RF module
+   * @return false if memory could not be allocated
+   */
+  bool beginIrq(uint8_t irq_pin);
+
+  /**
+   * Stop interrupt-driven operation and release queues
+   */
+  void endIrq();
+
+  /**
+   * Set callback invoked when received packets are available
+   *
+   * The callback is queued once per batch of packets, and should call
+   * readPacket() until it returns false.
+   */
+  void onPacket(Delegate<void()> callback);
+
+  /**
+   * Get the next received packet
+   *
+   * @param[out] packet
+   * @return false if no packets are queued
+   */
+  bool readPacket(RF24Packet& packet);
+
+  /**
+   * Get number of received packets waiting in the queue
+   */
+  size_t packetsAvailable() const { return irq ? irq->rx.available() : 0; }
+
+  /**
+   * Queue a packet for sending to the open writing pipe
+   *
+   * Call stopListening() first. Packets are loaded into the radio as space in
+   * its TX FIFO becomes available, and are sent back-to-back.
+   *
+   * @param buf Pointer to the data to be sent
+   * @param len Number of bytes to be sent, up to 32
+   * @return false if the queue is full, or not in interrupt-driven mode
+   */
+  bool queuePacket(const void* buf, uint8_t len);
+
+  /**
+   * Get receive statistics for a pipe
+   *
+   * @param pipe Which pipe# (0-5)
+   */
+  RF24PipeStats getPipeStats(uint8_t pipe) const;
+
+  /**
+   * Get transmit statistics
+   */
+  RF24TxStats getTxStats() const;
+
+  /**
+   * Reset all statistics to zero
+   */
+  void resetStats();
+
+  /**@}*/
+
+private:
+  bool allocIrq();
+  static void packetNotify(void* param);
+  void irqService();
+  void fillTxFifo(uint8_t status);
 };
 
 /**
@@ -29,6 +29,14 @@ extern HardwareSPI SPI;
 #define _BV(x) (1<<(x))
 #endif
 
+// Queue sizes for interrupt-driven operation, must be powers of 2
+#ifndef RF24_RX_QUEUE_SIZE
+#define RF24_RX_QUEUE_SIZE 16
+#endif
+#ifndef RF24_TX_QUEUE_SIZE
+#define RF24_TX_QUEUE_SIZE 8
+#endif
+
 #undef SERIAL_DEBUG
 #ifdef SERIAL_DEBUG
 #define IF_SERIAL_DEBUG(x) ({x;})
@@ -0,0 +1,392 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/SmingHub/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * RecordLog.cpp
+ *
+ ****/
+
+#include "RecordLog.h"
+#include <debug_progmem.h>
+#include <algorithm>
+#include <cstring>
+
+uint16_t RecordLog::crc16(uint16_t crc, const void* data, size_t length)
+{
+	// CRC-16/CCITT
+	auto p = static_cast<const uint8_t*>(data);
+	while(length-- != 0) {
+		crc ^= uint16_t(*p++) << 8;
+		for(unsigned i = 0; i < 8; ++i) {
+			crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : crc << 1;
+		}
+	}
+	return crc;
+}
+
+uint16_t RecordLog::recordCrc(const RecordHeader& hdr, const void* data)
+{
+	uint16_t crc = crc16(0xFFFF, &hdr.sequence, sizeof(hdr.sequence));
+	crc = crc16(crc, &hdr.length, sizeof(hdr.length));
+	return crc16(crc, data, hdr.length);
+}
+
+bool RecordLog::readSectorHeader(unsigned sector, SectorHeader& hdr)
+{
+	return partition.read(sectorAddress(sector), &hdr, sizeof(hdr)) && hdr.magic == SectorHeader::Magic;
+}
+
+bool RecordLog::begin()
+{
+	sectorCount = 0;
+	if(!partition) {
+		return false;
+	}
+
+	sectorSize = partition.getBlockSize();
+	if(sectorSize < sizeof(SectorHeader) + align(sizeof(RecordHeader) + maxRecordSize)) {
+		debug_e("[RLOG] Sector size %u too small", sectorSize);
+		return false;
+	}
+	auto count = std::min(partition.size() / sectorSize, size_t(0xFFFF));
+	if(count < 2) {
+		debug_e("[RLOG] Partition '%s' too small", partition.name().c_str());
+		return false;
+	}
+
+	if(!scanBuffer) {
+		scanBuffer.reset(new uint8_t[maxRecordSize]);
+		if(!scanBuffer) {
+			return false;
+		}
+	}
+
+	sectorCount = count;
+
+	// Locate newest and oldest sectors
+	usedSectors = 0;
+	uint32_t newestSequence{0};
+	for(unsigned i = 0; i < sectorCount; ++i) {
+		SectorHeader hdr;
+		if(!readSectorHeader(i, hdr)) {
+			continue;
+		}
+		if(usedSectors == 0 || int32_t(hdr.firstSequence - newestSequence) > 0) {
+			headSector = i;
+			newestSequence = hdr.firstSequence;
+			eraseCount = hdr.eraseCount;
+		}
+		if(usedSectors == 0 || int32_t(hdr.firstSequence - firstSequence) < 0) {
+			oldestSector = i;
+			firstSequence = hdr.firstSequence;
+		}
+		++usedSectors;
+	}
+
+	lastOffset = 0;
+
+	if(usedSectors == 0) {
+		headSector = sectorCount - 1;
+		writeOffset = sectorSize;
+		firstSequence = nextSequence = 0;
+		return true;
+	}
+
+	// Find end of records in head sector
+	writeOffset = sectorSize;
+	Cursor cursor{headSector, sizeof(SectorHeader), newestSequence};
+	for(;;) {
+		auto offset = cursor.offset;
+		uint32_t sequence;
+		int len = readRecord(cursor, sequence);
+		if(len == readEnd) {
+			break;
+		}
+		if(len == readCorrupt) {
+			// Sequence number is consumed so it isn't re-used
+			debug_w("[RLOG] Record #%u corrupt", sequence);
+		} else {
+			lastOffset = offset;
+			lastSequence = sequence;
+		}
+	}
+	writeOffset = cursor.offset;
+	nextSequence = cursor.sequence;
+
+	debug_d("[RLOG] Mounted '%s', records %u - %u", partition.name().c_str(), firstSequence, nextSequence - 1);
+	return true;
+}
+
+bool RecordLog::format(uint32_t firstSequence)
+{
+	if(sectorCount == 0 && !begin()) {
+		return false;
+	}
+
+	// Sectors are erased when brought into use, so only headers need clearing
+	for(unsigned i = 0; i < sectorCount; ++i) {
+		SectorHeader hdr;
+		if(readSectorHeader(i, hdr) && !partition.erase_range(sectorAddress(i), sectorSize)) {
+			return false;
+		}
+	}
+
+	// Carry on from current sector to keep wear even
+	usedSectors = 0;
+	writeOffset = sectorSize;
+	lastOffset = 0;
+	this->firstSequence = nextSequence = firstSequence;
+	return true;
+}
+
+bool RecordLog::nextSector()
+{
+	unsigned sector = (headSector + 1) % sectorCount;
+
+	SectorHeader hdr;
+	uint32_t erases = readSectorHeader(sector, hdr) ? hdr.eraseCount + 1 : 1;
+
+	if(usedSectors == sectorCount) {
+		// Discard oldest sector
+		--usedSectors;
+		oldestSector = (sector + 1) % sectorCount;
+		if(readSectorHeader(oldestSector, hdr)) {
+			firstSequence = hdr.firstSequence;
+		}
+	}
+
+	if(!partition.erase_range(sectorAddress(sector), sectorSize)) {
+		debug_e("[RLOG] Erase failed");
+		return false;
+	}
+
+	hdr = SectorHeader{SectorHeader::Magic, nextSequence, erases};
+	if(!partition.write(sectorAddress(sector), &hdr, sizeof(hdr))) {
+		debug_e("[RLOG] Write failed");
+		return false;
+	}
+
+	if(usedSectors == 0) {
+		oldestSector = sector;
+		firstSequence = nextSequence;
+	}
+	++usedSectors;
+	headSector = sector;
+	writeOffset = sizeof(SectorHeader);
+	lastOffset = 0;
+	eraseCount = erases;
+	return true;
+}
+
+bool RecordLog::append(const void* data, size_t length)
+{
+	if(sectorCount == 0 || length > maxRecordSize) {
+		return false;
+	}
+
+	auto recordSize = align(sizeof(RecordHeader) + length);
+	if(writeOffset + recordSize > sectorSize && !nextSector()) {
+		return false;
+	}
+
+	RecordHeader hdr{uint16_t(length), 0, nextSequence};
+	hdr.crc = recordCrc(hdr, data);
+	auto addr = sectorAddress(headSector) + writeOffset;
+	if(!partition.write(addr, &hdr, sizeof(hdr)) ||
+	   (length != 0 && !partition.write(addr + sizeof(hdr), data, length))) {
+		// Record may be partially written, so don't use this sector again
+		debug_e("[RLOG] Write failed");
+		writeOffset = sectorSize;
+		++nextSequence;
+		return false;
+	}
+
+	lastOffset = writeOffset;
+	lastSequence = nextSequence;
+	writeOffset += recordSize;
+	++nextSequence;
+	return true;
+}
+
+int RecordLog::readRecord(Cursor& cursor, uint32_t& sequence)
+{
+	sequence = cursor.sequence;
+
+	if(cursor.offset + sizeof(RecordHeader) > sectorSize) {
+		return readEnd;
+	}
+
+	RecordHeader hdr;
+	auto addr = sectorAddress(cursor.sector) + cursor.offset;
+	if(!partition.read(addr, &hdr, sizeof(hdr))) {
+		cursor.offset = sectorSize;
+		return readCorrupt;
+	}
+
+	if(hdr.length == RecordHeader::Erased) {
+		if(hdr.crc == 0xFFFF && hdr.sequence == 0xFFFFFFFF) {
+			return readEnd;
+		}
+		// Header partially written
+		cursor.offset = sectorSize;
+		++cursor.sequence;
+		return readCorrupt;
+	}
+
+	auto recordSize = align(sizeof(RecordHeader) + hdr.length);
+	if(hdr.length > maxRecordSize || cursor.offset + recordSize > sectorSize) {
+		cursor.offset = sectorSize;
+		++cursor.sequence;
+		return readCorrupt;
+	}
+
+	cursor.offset += recordSize;
+	++cursor.sequence;
+	if(hdr.sequence != sequence || !partition.read(addr + sizeof(hdr), scanBuffer.get(), hdr.length) ||
+	   hdr.crc != recordCrc(hdr, scanBuffer.get())) {
+		return readCorrupt;
+	}
+
+	return hdr.length;
+}
+
+int RecordLog::readNext(Cursor& cursor, uint32_t& sequence)
+{
+	for(;;) {
+		if(cursor.sector == headSector && cursor.offset >= writeOffset) {
+			return readEnd;
+		}
+
+		int len = readRecord(cursor, sequence);
+		if(len != readEnd) {
+			return len;
+		}
+
+		if(cursor.sector == headSector) {
+			return readEnd;
+		}
+
+		cursor.sector = (cursor.sector + 1) % sectorCount;
+		SectorHeader hdr;
+		if(!readSectorHeader(cursor.sector, hdr)) {
+			return readEnd;
+		}
+		cursor.offset = sizeof(SectorHeader);
+		cursor.sequence = hdr.firstSequence;
+	}
+}
+
+bool RecordLog::seek(uint32_t sequence, Cursor& cursor)
+{
+	if(usedSectors == 0 || int32_t(sequence - firstSequence) < 0 || int32_t(sequence - nextSequence) >= 0) {
+		return false;
+	}
+
+	// Binary search for the last sector starting at or before the requested sequence
+	SectorHeader hdr;
+	unsigned lo = 0;
+	unsigned hi = usedSectors - 1;
+	while(lo < hi) {
+		unsigned mid = (lo + hi + 1) / 2;
+		if(!readSectorHeader((oldestSector + mid) % sectorCount, hdr)) {
+			return false;
+		}
+		if(int32_t(hdr.firstSequence - sequence) <= 0) {
+			lo = mid;
+		} else {
+			hi = mid - 1;
+		}
+	}
+
+	unsigned sector = (oldestSector + lo) % sectorCount;
+	if(!readSectorHeader(sector, hdr)) {
+		return false;
+	}
+	cursor = Cursor{uint16_t(sector), sizeof(SectorHeader), hdr.firstSequence};
+
+	// Skip preceding records using headers only
+	while(cursor.sequence != sequence) {
+		RecordHeader rec;
+		if(!partition.read(sectorAddress(sector) + cursor.offset, &rec, sizeof(rec)) ||
+		   rec.length == RecordHeader::Erased || rec.length > maxRecordSize) {
+			return false;
+		}
+		cursor.offset += align(sizeof(RecordHeader) + rec.length);
+		++cursor.sequence;
+		if(cursor.offset + sizeof(RecordHeader) > sectorSize) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+int RecordLog::read(uint32_t sequence, void* buffer, size_t bufSize)
+{
+	Cursor cursor;
+	if(!seek(sequence, cursor)) {
+		return -1;
+	}
+
+	uint32_t seq;
+	int len = readRecord(cursor, seq);
+	if(len < 0) {
+		return -1;
+	}
+
+	memcpy(buffer, scanBuffer.get(), std::min(size_t(len), bufSize));
+	return len;
+}
+
+int RecordLog::readLast(void* buffer, size_t bufSize)
+{
+	if(getCount() == 0) {
+		return -1;
+	}
+
+	if(lastOffset == 0) {
+		return read(nextSequence - 1, buffer, bufSize);
+	}
+
+	Cursor cursor{headSector, lastOffset, lastSequence};
+	uint32_t seq;
+	int len = readRecord(cursor, seq);
+	if(len < 0) {
+		return -1;
+	}
+
+	memcpy(buffer, scanBuffer.get(), std::min(size_t(len), bufSize));
+	return len;
+}
+
+unsigned RecordLog::scan(uint32_t first, uint32_t last, ScanCallback callback)
+{
+	if(int32_t(first - firstSequence) < 0) {
+		first = firstSequence;
+	}
+
+	Cursor cursor;
+	if(!callback || !seek(first, cursor)) {
+		return 0;
+	}
+
+	unsigned count{0};
+	for(;;) {
+		uint32_t sequence;
+		int len = readNext(cursor, sequence);
+		if(len == readEnd || int32_t(sequence - last) > 0) {
+			break;
+		}
+		if(len < 0) {
+			continue;
+		}
+		++count;
+		if(!callback(sequence, scanBuffer.get(), len)) {
+			break;
+		}
+	}
+
+	return count;
+}
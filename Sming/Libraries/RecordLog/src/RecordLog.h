@@ -0,0 +1,227 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/SmingHub/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * RecordLog.h - Append-only record storage directly on a flash partition
+ *
+ ****/
+
+#pragma once
+
+#include <Storage/Partition.h>
+#include <Delegate.h>
+#include <memory>
+
+/**
+ * @brief Stores a sequence of records in a partition without using a filesystem
+ *
+ * The partition is used as a ring of erase blocks (sectors). Records are appended to the current sector
+ * and when it fills the oldest sector is erased and re-used, so all sectors wear evenly.
+ * Each record is assigned a sequence number, one greater than the previous record.
+ *
+ * Sector layout:
+ *
+ * 	SectorHeader
+ * 	RecordHeader, data, padding to 4 bytes
+ * 	RecordHeader, data, padding
+ * 	...
+ * 	erased (0xFF)
+ *
+ * Each record carries a CRC so one interrupted by power loss is detected on mount and skipped.
+ * Appending never overwrites programmed flash.
+ *
+ * Mounting reads the header of each sector plus the records in the newest sector.
+ * Appending and reading the most recent record take constant time.
+ * Locating a sequence number uses a binary search of sector headers followed by a walk through one sector.
+ */
+class RecordLog
+{
+public:
+	static constexpr size_t defaultMaxRecordSize{256};
+
+	/**
+	 * @brief Called for each record during a scan
+	 * @param sequence
+	 * @param data
+	 * @param length
+	 * @retval bool Return false to stop the scan
+	 */
+	using ScanCallback = Delegate<bool(uint32_t sequence, const void* data, size_t length)>;
+
+	/**
+	 * @brief Constructor
+	 * @param partition Must contain at least two erase blocks
+	 * @param maxRecordSize Largest record which may be stored, and size of buffer used by `scan()`
+	 */
+	RecordLog(Storage::Partition partition, uint16_t maxRecordSize = defaultMaxRecordSize)
+		: partition(partition), maxRecordSize(maxRecordSize)
+	{
+	}
+
+	/**
+	 * @brief Locate the most recent record and prepare for appending
+	 * @retval bool false if partition is unsuitable
+	 * @note An unformatted partition is treated as an empty log
+	 */
+	bool begin();
+
+	/**
+	 * @brief Discard all records
+	 * @param firstSequence Sequence number to assign to the next record
+	 * @note Calls `begin()` if it hasn't already been done
+	 */
+	bool format(uint32_t firstSequence = 0);
+
+	/**
+	 * @brief Add a record to the log
+	 * @param data
+	 * @param length Must not exceed maxRecordSize
+	 * @retval bool true on success
+	 * @note If no space remains the oldest sector, and all records in it, are discarded.
+	 */
+	bool append(const void* data, size_t length);
+
+	/**
+	 * @brief Read a record
+	 * @param sequence
+	 * @param buffer
+	 * @param bufSize
+	 * @retval int Length of record, or -1 if not found or corrupt.
+	 * The record is truncated if larger than the buffer.
+	 */
+	int read(uint32_t sequence, void* buffer, size_t bufSize);
+
+	/**
+	 * @brief Read the most recently appended record
+	 * @retval int Length of record, or -1 if log is empty
+	 */
+	int readLast(void* buffer, size_t bufSize);
+
+	/**
+	 * @brief Visit records in order of sequence number
+	 * @param first Starting sequence number. Earlier records are skipped if this has been discarded.
+	 * @param last Final sequence number
+	 * @param callback
+	 * @retval unsigned Number of records visited
+	 * @note Corrupt records are skipped
+	 */
+	unsigned scan(uint32_t first, uint32_t last, ScanCallback callback);
+
+	/**
+	 * @brief Sequence number of the oldest record held
+	 */
+	uint32_t getFirstSequence() const
+	{
+		return firstSequence;
+	}
+
+	/**
+	 * @brief Sequence number which will be assigned by the next append
+	 */
+	uint32_t getNextSequence() const
+	{
+		return nextSequence;
+	}
+
+	/**
+	 * @brief Number of records held, including any which are corrupt
+	 */
+	uint32_t getCount() const
+	{
+		return nextSequence - firstSequence;
+	}
+
+	/**
+	 * @brief Number of times the current sector has been erased
+	 */
+	uint32_t getEraseCount() const
+	{
+		return eraseCount;
+	}
+
+private:
+	struct SectorHeader {
+		static constexpr uint32_t Magic{0x474C4352}; // "RCLG"
+
+		uint32_t magic;
+		uint32_t firstSequence; ///< Of first record in this sector
+		uint32_t eraseCount;
+	};
+
+	struct RecordHeader {
+		static constexpr uint16_t Erased{0xFFFF};
+
+		uint16_t length; ///< Of data, excluding header
+		uint16_t crc;	///< Of sequence, length and data
+		uint32_t sequence;
+	};
+
+	/**
+	 * @brief Position of a record within the partition
+	 */
+	struct Cursor {
+		uint16_t sector;
+		uint32_t offset;   ///< From start of sector
+		uint32_t sequence; ///< Expected at this position
+	};
+
+	static constexpr size_t align(size_t length)
+	{
+		return (length + 3) & ~3U;
+	}
+
+	static uint16_t crc16(uint16_t crc, const void* data, size_t length);
+	static uint16_t recordCrc(const RecordHeader& hdr, const void* data);
+
+	uint32_t sectorAddress(unsigned sector) const
+	{
+		return sector * sectorSize;
+	}
+
+	bool readSectorHeader(unsigned sector, SectorHeader& hdr);
+
+	/**
+	 * @brief Erase the sector following the current one and make it current
+	 */
+	bool nextSector();
+
+	/**
+	 * @brief Find position of a record
+	 * @retval bool false if sequence not held
+	 */
+	bool seek(uint32_t sequence, Cursor& cursor);
+
+	/**
+	 * @brief Read record at cursor into scan buffer and advance past it
+	 * @retval int Length of record, or one of:
+	 * 	`readCorrupt` Record is invalid. If its length is unknown, cursor is moved to end of sector.
+	 * 	`readEnd` No more records in sector
+	 */
+	int readRecord(Cursor& cursor, uint32_t& sequence);
+
+	/**
+	 * @brief Read next record, moving on to following sectors as required
+	 * @retval int As for `readRecord()`, with `readEnd` indicating no more records in log
+	 */
+	int readNext(Cursor& cursor, uint32_t& sequence);
+
+	static constexpr int readCorrupt{-1};
+	static constexpr int readEnd{-2};
+
+	Storage::Partition partition;
+	std::unique_ptr<uint8_t[]> scanBuffer;
+	uint32_t sectorSize{0};
+	uint32_t writeOffset{0}; ///< Position for next record in head sector
+	uint32_t lastOffset{0};  ///< Most recent record in head sector, 0 if none
+	uint32_t lastSequence{0};
+	uint32_t firstSequence{0};
+	uint32_t nextSequence{0};
+	uint32_t eraseCount{0};
+	uint16_t maxRecordSize;
+	uint16_t sectorCount{0};
+	uint16_t oldestSector{0};
+	uint16_t headSector{0};
+	uint16_t usedSectors{0}; ///< Number of sectors holding records, 0 if log is empty
+};
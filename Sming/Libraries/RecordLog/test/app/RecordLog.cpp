@@ -0,0 +1,225 @@
+#include <SmingTest.h>
+#include <RecordLog.h>
+#include <Storage/CustomDevice.h>
+
+namespace
+{
+/*
+ * RAM-backed device with NOR flash semantics
+ */
+class FlashDevice : public Storage::CustomDevice
+{
+public:
+	static constexpr size_t size{2048};
+	static constexpr size_t blockSize{512};
+
+	FlashDevice()
+	{
+		memset(data, 0xff, size);
+	}
+
+	String getName() const override
+	{
+		return F("flashDevice");
+	}
+
+	size_t getBlockSize() const override
+	{
+		return blockSize;
+	}
+
+	size_t getSize() const override
+	{
+		return size;
+	}
+
+	Type getType() const override
+	{
+		return Type::flash;
+	}
+
+	bool read(uint32_t address, void* dst, size_t len) override
+	{
+		if(address + len > size) {
+			return false;
+		}
+		memcpy(dst, &data[address], len);
+		return true;
+	}
+
+	bool write(uint32_t address, const void* src, size_t len) override
+	{
+		if(address + len > size) {
+			return false;
+		}
+		auto p = static_cast<const uint8_t*>(src);
+		for(unsigned i = 0; i < len; ++i) {
+			data[address + i] &= p[i];
+		}
+		return true;
+	}
+
+	bool erase_range(uint32_t address, size_t len) override
+	{
+		if(address + len > size) {
+			return false;
+		}
+		memset(&data[address], 0xff, len);
+		++erases[address / blockSize];
+		return true;
+	}
+
+	uint8_t data[size];
+	unsigned erases[size / blockSize]{};
+};
+
+constexpr uint16_t maxRecordSize{64};
+
+String makeRecord(uint32_t sequence)
+{
+	return F("sample #") + String(sequence);
+}
+
+} // namespace
+
+class RecordLogTest : public TestGroup
+{
+public:
+	RecordLogTest() : TestGroup(_F("RecordLog"))
+	{
+	}
+
+	void execute() override
+	{
+		FlashDevice flash;
+		auto part = flash.createPartition(F("log"), Storage::Partition::Type::data, 0x91, 0, flash.size);
+		char buffer[maxRecordSize];
+
+		auto checkRecord = [&](RecordLog& log, uint32_t sequence) {
+			int len = log.read(sequence, buffer, sizeof(buffer));
+			REQUIRE_EQ(String(buffer, std::max(len, 0)), makeRecord(sequence));
+		};
+
+		TEST_CASE("Append and read")
+		{
+			RecordLog log(part, maxRecordSize);
+			REQUIRE(log.begin());
+			REQUIRE_EQ(log.getCount(), 0);
+			REQUIRE_EQ(log.readLast(buffer, sizeof(buffer)), -1);
+			for(unsigned i = 0; i < 10; ++i) {
+				auto rec = makeRecord(i);
+				REQUIRE(log.append(rec.c_str(), rec.length()));
+			}
+			REQUIRE_EQ(log.getCount(), 10);
+			for(unsigned i = 0; i < 10; ++i) {
+				checkRecord(log, i);
+			}
+			int len = log.readLast(buffer, sizeof(buffer));
+			REQUIRE_EQ(String(buffer, len), makeRecord(9));
+			REQUIRE_EQ(log.read(10, buffer, sizeof(buffer)), -1);
+		}
+
+		TEST_CASE("Remount")
+		{
+			RecordLog log(part, maxRecordSize);
+			REQUIRE(log.begin());
+			REQUIRE_EQ(log.getFirstSequence(), 0);
+			REQUIRE_EQ(log.getNextSequence(), 10);
+			int len = log.readLast(buffer, sizeof(buffer));
+			REQUIRE_EQ(String(buffer, len), makeRecord(9));
+			auto rec = makeRecord(10);
+			REQUIRE(log.append(rec.c_str(), rec.length()));
+			checkRecord(log, 10);
+		}
+
+		TEST_CASE("Scan range")
+		{
+			RecordLog log(part, maxRecordSize);
+			REQUIRE(log.begin());
+			uint32_t expected{3};
+			bool ok{true};
+			auto count = log.scan(3, 7, [&](uint32_t sequence, const void* data, size_t length) {
+				ok &= (sequence == expected++);
+				ok &= (String(static_cast<const char*>(data), length) == makeRecord(sequence));
+				return true;
+			});
+			REQUIRE_EQ(count, 5);
+			REQUIRE(ok);
+		}
+
+		TEST_CASE("Sector rotation")
+		{
+			RecordLog log(part, maxRecordSize);
+			REQUIRE(log.begin());
+			for(unsigned i = log.getNextSequence(); i < 500; ++i) {
+				auto rec = makeRecord(i);
+				REQUIRE(log.append(rec.c_str(), rec.length()));
+			}
+			auto first = log.getFirstSequence();
+			debug_i("Log holds records %u - %u", first, log.getNextSequence() - 1);
+			REQUIRE(first > 0);
+			REQUIRE_EQ(log.read(first - 1, buffer, sizeof(buffer)), -1);
+			checkRecord(log, first);
+			checkRecord(log, 499);
+
+			// Erases are spread over the partition
+			for(auto n : flash.erases) {
+				REQUIRE(n > 1);
+			}
+
+			RecordLog log2(part, maxRecordSize);
+			REQUIRE(log2.begin());
+			REQUIRE_EQ(log2.getFirstSequence(), first);
+			REQUIRE_EQ(log2.getNextSequence(), 500);
+			REQUIRE_EQ(log2.getEraseCount(), log.getEraseCount());
+
+			uint32_t expected{first};
+			auto count = log2.scan(0, 499, [&](uint32_t sequence, const void*, size_t) {
+				if(sequence != expected) {
+					return false;
+				}
+				++expected;
+				return true;
+			});
+			REQUIRE_EQ(count, 500 - first);
+		}
+
+		TEST_CASE("Damaged record")
+		{
+			RecordLog log(part, maxRecordSize);
+			REQUIRE(log.format(1000));
+			REQUIRE_EQ(log.getCount(), 0);
+			for(unsigned i = 1000; i < 1003; ++i) {
+				auto rec = makeRecord(i);
+				REQUIRE(log.append(rec.c_str(), rec.length()));
+			}
+
+			// Simulate incomplete write of final record
+			auto rec = makeRecord(1002);
+			auto pos = std::search(flash.data, flash.data + flash.size, rec.begin(), rec.end());
+			REQUIRE(pos != flash.data + flash.size);
+			pos[rec.length() - 1] = 0;
+
+			REQUIRE(log.begin());
+			REQUIRE_EQ(log.getNextSequence(), 1003);
+			REQUIRE_EQ(log.read(1002, buffer, sizeof(buffer)), -1);
+			int len = log.readLast(buffer, sizeof(buffer));
+			REQUIRE_EQ(String(buffer, len), makeRecord(1001));
+
+			rec = makeRecord(1003);
+			REQUIRE(log.append(rec.c_str(), rec.length()));
+			uint32_t sum{0};
+			auto count = log.scan(1000, 1003, [&](uint32_t sequence, const void*, size_t) {
+				sum += sequence;
+				return true;
+			});
+			REQUIRE_EQ(count, 3);
+			REQUIRE_EQ(sum, 1000 + 1001 + 1003);
+		}
+	}
+};
+
+void REGISTER_TEST(RecordLog)
+{
+	registerGroup<RecordLogTest>();
+}
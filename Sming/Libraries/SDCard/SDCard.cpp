@@ -34,6 +34,7 @@ Descr: Low-level SDCard functions
 /-------------------------------------------------------------------------*/
 #include "SDCard.h"
 #include "fatfs/diskio.h" /* Declarations of disk I/O functions */
+#include <SPI.h>
 #include <Clock.h>
 #include <debug_progmem.h>
 
@@ -44,11 +45,13 @@ namespace
 FATFS* pFatFs;		  /* FatFs work area needed for each volume */
 uint8_t chipSelect;   /* SPI client selector */
 uint32_t spiInitFreq; /* SPI frequency used for initialisation */
+SPIClass* blockSPI;   /* Set to use queued transactions for data blocks */
 
 }; // namespace
 
 bool SDCard_begin(uint8_t slaveSelect, uint32_t freqLimit)
 {
+	blockSPI = nullptr;
 	chipSelect = slaveSelect;
 	digitalWrite(chipSelect, HIGH);
 	pinMode(chipSelect, OUTPUT);
@@ -99,6 +102,16 @@ bool SDCard_begin(uint8_t slaveSelect, uint32_t freqLimit)
 	return true;
 }
 
+bool SDCard_begin(SPIClass& spi, uint8_t slaveSelect, uint32_t freqLimit)
+{
+	SDCardSPI = &spi;
+	if(!SDCard_begin(slaveSelect, freqLimit)) {
+		return false;
+	}
+	blockSPI = &spi;
+	return true;
+}
+
 namespace
 {
 /*-------------------------------------------------------------------------*/
@@ -186,6 +199,27 @@ bool select() /* 1:OK, 0:Timeout */
 	return false;
 }
 
+/*-----------------------------------------------------------------------*/
+/* Transfer data block without modifying it                              */
+/*-----------------------------------------------------------------------*/
+
+bool queueBlock(const BYTE* txData, BYTE* rxData, UINT length)
+{
+	if(blockSPI == nullptr) {
+		return false;
+	}
+
+	SpiTransaction trans;
+	trans.txData = txData;
+	trans.rxData = rxData;
+	trans.length = length;
+	if(!blockSPI->queue(trans)) {
+		return false;
+	}
+	blockSPI->wait();
+	return true;
+}
+
 /*-----------------------------------------------------------------------*/
 /* Receive a data packet from the card                                   */
 /*-----------------------------------------------------------------------*/
@@ -208,9 +242,11 @@ bool rcvr_datablock(			/* 1:OK, 0:Failed */
 		return false; /* If not valid data token, return with error */
 	}
 
-	memset(buff, 0xFF, btr);		/* Send 0xFF */
-	SDCardSPI->transfer(buff, btr); /* Receive the data block into buffer */
-	SDCardSPI->transfer16(0xffff);  /* keep MOSI HIGH, discard CRC */
+	if(!queueBlock(nullptr, buff, btr)) { /* Queued transactions send 0xFF */
+		memset(buff, 0xFF, btr);		  /* Send 0xFF */
+		SDCardSPI->transfer(buff, btr);   /* Receive the data block into buffer */
+	}
+	SDCardSPI->transfer16(0xffff); /* keep MOSI HIGH, discard CRC */
 
 	// success
 	return true;
@@ -232,10 +268,12 @@ bool xmit_datablock(				  /* 1:OK, 0:Failed */
 
 	SDCardSPI->transfer(token); /* Xmit a token */
 	if(token != 0xFD) {			/* Is it data token? */
-		// Data gets modified so take a copy
-		uint8_t buffer[512];
-		memcpy(buffer, buff, sizeof(buffer));
-		SDCardSPI->transfer(buffer, sizeof(buffer)); /* Xmit the 512 byte data block to MMC */
+		if(!queueBlock(buff, nullptr, 512)) {
+			// Data gets modified so take a copy
+			uint8_t buffer[512];
+			memcpy(buffer, buff, sizeof(buffer));
+			SDCardSPI->transfer(buffer, sizeof(buffer)); /* Xmit the 512 byte data block to MMC */
+		}
 
 		//		SDCardSPI->setMOSI(HIGH); /* Send 0xFF */
 		SDCardSPI->transfer16(0xffff);		/* Xmit dummy CRC */
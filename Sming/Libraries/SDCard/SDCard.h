@@ -21,4 +21,18 @@ Descr: Low-level SDCard functions
  */
 bool SDCard_begin(uint8_t slaveSelect, uint32_t freqLimit);
 
+class SPIClass;
+
+/**
+ * @brief Initialise SD card interface using a hardware SPI controller
+ * @param spi Controller to use, assigned to `SDCardSPI`
+ * @param slaveSelect Pin to use for CS
+ * @param freqLimit Maximum SPI clock speed
+ * @retval bool true on success, false on error
+ *
+ * Data blocks are transferred using queued SPI transactions, which use DMA where the hardware supports it.
+ * This also avoids having to copy blocks which are written.
+ */
+bool SDCard_begin(SPIClass& spi, uint8_t slaveSelect, uint32_t freqLimit);
+
 extern SPIBase* SDCardSPI;
@@ -0,0 +1,151 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/SmingHub/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * SDCardWriteQueue.cpp
+ *
+ ****/
+
+#include "SDCardWriteQueue.h"
+#include <Platform/System.h>
+#include <debug_progmem.h>
+#include <algorithm>
+#include <cstring>
+
+/*
+ * A queued task cannot be cancelled, so it refers to the queue indirectly.
+ * If the queue is destroyed first it clears the reference.
+ */
+struct SDCardWriteQueue::Task {
+	SDCardWriteQueue* queue;
+};
+
+SDCardWriteQueue::~SDCardWriteQueue()
+{
+	flush();
+	if(task != nullptr) {
+		task->queue = nullptr;
+	}
+}
+
+size_t SDCardWriteQueue::write(const void* data, size_t length)
+{
+	if(!buffer) {
+		buffer.reset(new uint8_t[sectorCount * sectorSize]);
+		if(!buffer) {
+			stats.bytesDropped += length;
+			return 0;
+		}
+	}
+
+	auto src = static_cast<const uint8_t*>(data);
+	size_t done{0};
+	while(done < length) {
+		if(fullCount == sectorCount) {
+			stats.bytesDropped += length - done;
+			break;
+		}
+
+		auto n = std::min(length - done, sectorSize - fillPos);
+		memcpy(&buffer[head * sectorSize + fillPos], &src[done], n);
+		done += n;
+		fillPos += n;
+		if(fillPos == sectorSize) {
+			fillPos = 0;
+			head = (head + 1) % sectorCount;
+			++fullCount;
+			stats.maxSectorsPending = std::max(stats.maxSectorsPending, fullCount);
+		}
+	}
+
+	if(fullCount != 0) {
+		queueTask();
+	}
+
+	return done;
+}
+
+void SDCardWriteQueue::queueTask()
+{
+	if(task != nullptr) {
+		return;
+	}
+
+	task = new Task{this};
+	if(task != nullptr && !System.queueCallback(TaskPriority::Low, taskCallback, task)) {
+		// Sectors get written on the next write, or on flush
+		delete task;
+		task = nullptr;
+	}
+}
+
+void SDCardWriteQueue::taskCallback(void* param)
+{
+	auto task = static_cast<Task*>(param);
+	auto queue = task->queue;
+	delete task;
+	if(queue != nullptr) {
+		queue->task = nullptr;
+		queue->service();
+	}
+}
+
+void SDCardWriteQueue::service()
+{
+	writeSectors(sectorsPerWrite);
+	if(fullCount != 0) {
+		queueTask();
+	}
+}
+
+void SDCardWriteQueue::writeSectors(unsigned maxSectors)
+{
+	// Don't wrap, so data is contiguous
+	unsigned count = std::min({unsigned(fullCount), maxSectors, unsigned(sectorCount - tail)});
+	if(count == 0) {
+		return;
+	}
+
+	UINT length = count * sectorSize;
+	UINT written{0};
+	FRESULT res = f_write(&file, &buffer[tail * sectorSize], length, &written);
+	stats.bytesWritten += written;
+	if(res != FR_OK || written != length) {
+		// Data is discarded rather than retried, so a failed card doesn't block the queue
+		debug_e("[SDCard] Write failed, res %d", res);
+		++stats.writeErrors;
+	}
+
+	tail = (tail + count) % sectorCount;
+	fullCount -= count;
+}
+
+bool SDCardWriteQueue::flush()
+{
+	if(!buffer) {
+		return true;
+	}
+
+	auto errors = stats.writeErrors;
+	while(fullCount != 0) {
+		writeSectors(sectorCount);
+	}
+
+	if(fillPos != 0) {
+		UINT written{0};
+		FRESULT res = f_write(&file, &buffer[head * sectorSize], fillPos, &written);
+		stats.bytesWritten += written;
+		if(res != FR_OK || written != fillPos) {
+			++stats.writeErrors;
+		}
+		fillPos = 0;
+	}
+
+	if(f_sync(&file) != FR_OK) {
+		++stats.writeErrors;
+	}
+
+	return stats.writeErrors == errors;
+}
@@ -0,0 +1,120 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/SmingHub/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * SDCardWriteQueue.h - Write-behind buffering for data logging to SD card
+ *
+ ****/
+
+#pragma once
+
+#include <fatfs/ff.h>
+#include <memory>
+
+/**
+ * @brief Queues data for writing to a file in the background
+ *
+ * Data is copied into a ring of sector-sized buffers, so `write()` returns immediately.
+ * Full sectors are written from a low-priority task, as many contiguous sectors at a time as possible.
+ * FatFS passes aligned writes of whole sectors directly to the card as a single multi-block write,
+ * so the file position should be a multiple of 512 bytes when the queue is created.
+ *
+ * If the card cannot keep up the queue fills, new data is discarded and counted in the statistics.
+ * Sizing the queue to cover the longest write latency of the card (typically 100-250ms)
+ * avoids this. RAM requirement is `sectorCount * 512` bytes.
+ *
+ * @note All methods must be called from task context.
+ */
+class SDCardWriteQueue
+{
+public:
+	struct Stats {
+		uint32_t bytesWritten;
+		uint32_t bytesDropped; ///< Discarded because queue was full
+		uint16_t writeErrors;
+		uint8_t maxSectorsPending; ///< Highest number of full sectors waiting to be written
+	};
+
+	static constexpr size_t sectorSize{512};
+
+	/**
+	 * @brief Constructor
+	 * @param file Open for writing. Must remain valid for the lifetime of the queue.
+	 * @param sectorCount Number of 512-byte buffers to allocate
+	 * @param sectorsPerWrite Maximum number of sectors to write in one go,
+	 * which limits how long the task queue is held up by each write
+	 */
+	SDCardWriteQueue(FIL& file, uint8_t sectorCount = 16, uint8_t sectorsPerWrite = 8)
+		: file(file), sectorCount(sectorCount), sectorsPerWrite(sectorsPerWrite)
+	{
+	}
+
+	/**
+	 * @brief Destructor
+	 * @note Queued data is flushed. Any background write already scheduled is cancelled.
+	 */
+	~SDCardWriteQueue();
+
+	/**
+	 * @brief Queue data for writing
+	 * @param data
+	 * @param length
+	 * @retval size_t Number of bytes queued, less than length if queue is full
+	 */
+	size_t write(const void* data, size_t length);
+
+	/**
+	 * @brief Write all queued data, including any partial sector, then sync the file
+	 * @retval bool true on success
+	 * @note This blocks until complete. Writing a partial sector leaves the file unaligned,
+	 * so should normally only be done before closing the file.
+	 */
+	bool flush();
+
+	/**
+	 * @brief Get number of bytes waiting to be written
+	 */
+	size_t getPending() const
+	{
+		return fullCount * sectorSize + fillPos;
+	}
+
+	/**
+	 * @brief Determine if a background write is scheduled
+	 */
+	bool isBusy() const
+	{
+		return task != nullptr;
+	}
+
+	const Stats& getStats() const
+	{
+		return stats;
+	}
+
+private:
+	struct Task;
+
+	static void taskCallback(void* param);
+	void queueTask();
+	void service();
+
+	/**
+	 * @brief Write contiguous full sectors from the tail of the queue
+	 * @param maxSectors
+	 */
+	void writeSectors(unsigned maxSectors);
+
+	FIL& file;
+	std::unique_ptr<uint8_t[]> buffer;
+	uint8_t sectorCount;
+	uint8_t sectorsPerWrite;
+	uint8_t head{0};	  ///< Sector being filled
+	uint8_t tail{0};	  ///< Oldest full sector
+	uint8_t fullCount{0}; ///< Number of full sectors
+	uint16_t fillPos{0};  ///< Bytes used in head sector
+	Task* task{nullptr}; ///< Queued background write
+	Stats stats{};
+};
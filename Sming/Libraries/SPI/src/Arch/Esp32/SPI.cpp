@@ -23,6 +23,8 @@
 #include <hal/spi_ll.h>
 #include <hal/clk_gate_ll.h>
 #include <soc/rtc.h>
+#include <hal/gpio_ll.h>
+#include <esp_intr_alloc.h>
 #include <Data/BitSet.h>
 
 // Use SPI hardware byte ordering so we don't need to do it in software
@@ -176,6 +178,23 @@ struct SpiDevice {
 			memcpy((void*)info.hw->data_buf, wordBuffer, ALIGNUP4(length));
 		}
 	}
+
+	void fill(uint32_t value, size_t length)
+	{
+		for(unsigned i = 0; i < ALIGNUP4(length) / 4; ++i) {
+			info.hw->data_buf[i] = value;
+		}
+	}
+
+	void enable_interrupt(bool enable)
+	{
+		spi_ll_clear_int_stat(info.hw);
+		if(enable) {
+			spi_ll_enable_int(info.hw);
+		} else {
+			spi_ll_disable_int(info.hw);
+		}
+	}
 };
 
 /** @brief Check speed settings and perform any pre-calculation required
@@ -211,6 +230,9 @@ void SpiDevice::set_clock(SPISpeed& speed)
 
 BitSet<uint8_t, SpiBus, SOC_SPI_PERIPH_NUM + 1> busAssigned;
 
+// Allocated on first use of asynchronous transactions, indexed by SpiBus
+intr_handle_t interruptHandles[SOC_SPI_PERIPH_NUM + 1];
+
 } // namespace
 
 SPIClass::SPIClass() : SPIBase(defaultPins[unsigned(SpiBus::DEFAULT) - 1])
@@ -307,6 +329,13 @@ void SPIClass::end()
 {
 	GET_DEVICE();
 
+	wait();
+	auto& handle = interruptHandles[unsigned(busId)];
+	if(handle != nullptr) {
+		esp_intr_free(handle);
+		handle = nullptr;
+	}
+
 	dev.deinit();
 	busAssigned -= busId;
 }
@@ -393,3 +422,102 @@ bool SPIClass::loopback(bool enable)
 	gpio_matrix_in(enable ? pins.mosi : pins.miso, dev.info.spiq_in, false);
 	return true;
 }
+
+bool SPIClass::queue(SpiTransaction& transaction)
+{
+	GET_DEVICE(false);
+
+	if(transaction.length == 0 || (transaction.csPin != SPI_PIN_NONE && !GPIO_IS_VALID_OUTPUT_GPIO(transaction.csPin))) {
+		return false;
+	}
+
+	if(transaction.settings != nullptr && transaction.settings->speed.regVal == 0) {
+		checkSpeed(transaction.settings->speed);
+	}
+
+	auto& handle = interruptHandles[unsigned(busId)];
+	if(handle == nullptr) {
+		// Handler is not IRAM-safe so is deferred whilst flash cache is disabled
+		auto err = esp_intr_alloc(dev.info.irq, 0, interruptHandler, this, &handle);
+		if(err != ESP_OK) {
+			debug_e("[SPI] Interrupt allocation failed, %d", err);
+			return false;
+		}
+	}
+
+	if(enqueue(transaction)) {
+		runTransaction();
+	}
+	return true;
+}
+
+void SPIClass::runTransaction()
+{
+	auto& trans = *queueHead;
+	SpiDevice dev{busId};
+
+	if(trans.done == 0) {
+		if(trans.settings != nullptr) {
+			auto& settings = *trans.settings;
+			dev.set_mode(settings.dataMode);
+			spi_ll_master_set_clock_by_reg(dev.info.hw, &settings.speed.regVal);
+			dev.set_bit_order(settings.bitOrder);
+			lsbFirst = (settings.bitOrder != MSBFIRST);
+		}
+#if BYTE_ORDER_SUPPORTED
+		// Transfer LS byte first to match system byte order, as for transfer()
+		dev.set_byte_order(LSBFIRST);
+#endif
+		if(trans.csPin != SPI_PIN_NONE) {
+			gpio_ll_set_level(&GPIO, gpio_num_t(trans.csPin), 0);
+		}
+		dev.enable_interrupt(true);
+	}
+
+	auto blockLen = std::min(trans.length - trans.done, SPI_FIFO_SIZE);
+	if(trans.txData == nullptr) {
+		dev.fill(0xffffffff, blockLen);
+	} else {
+		dev.write(static_cast<const uint8_t*>(trans.txData) + trans.done, blockLen);
+	}
+	dev.send(blockLen * 8);
+}
+
+void SPIClass::interruptHandler(void* param)
+{
+	auto spi = static_cast<SPIClass*>(param);
+	SpiDevice dev{spi->busId};
+	spi_ll_clear_int_stat(dev.info.hw);
+
+	auto trans = spi->queueHead;
+	if(trans == nullptr) {
+		return;
+	}
+
+	auto blockLen = std::min(trans->length - trans->done, SPI_FIFO_SIZE);
+	if(trans->rxData != nullptr) {
+		dev.read(static_cast<uint8_t*>(trans->rxData) + trans->done, blockLen);
+	}
+	trans->done += blockLen;
+	if(trans->done < trans->length) {
+		spi->runTransaction();
+		return;
+	}
+
+	if(trans->csPin != SPI_PIN_NONE) {
+		gpio_ll_set_level(&GPIO, gpio_num_t(trans->csPin), 1);
+	}
+#if BYTE_ORDER_SUPPORTED
+	dev.set_byte_order(spi->lsbFirst ? LSBFIRST : MSBFIRST);
+#endif
+
+	if(spi->dequeue() != nullptr) {
+		spi->runTransaction();
+	} else {
+		dev.enable_interrupt(false);
+	}
+
+	if(trans->callback != nullptr) {
+		trans->callback(*trans);
+	}
+}
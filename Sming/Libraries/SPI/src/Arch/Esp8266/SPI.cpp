@@ -19,6 +19,7 @@
 #include "espinc/eagle_soc.h"
 #include "espinc/spi_register.h"
 #include "espinc/spi_struct.h"
+#include <spisoft_arch.h>
 
 // ESP8266 SPI hardware supports byte ordering so we don't need to do it in software
 #define BYTE_ORDER_SUPPORTED 1
@@ -43,6 +44,11 @@ constexpr SpiPins defaultPins{
 constexpr size_t SPI_FIFO_SIZE{64};
 
 bool busAssigned;
+bool isrAttached;
+
+// DPORT register indicating source of SPI interrupt
+constexpr uint32_t DPORT_SPI_INT_STATUS_REG{0x3ff00020};
+constexpr uint32_t DPORT_SPI1_INT{BIT7};
 
 // Used internally to calculate optimum SPI speed
 struct SpiPreDiv {
@@ -81,13 +87,13 @@ struct SpiDevice {
 	/**
 	 * @brief Initiate an SPI user transaction
 	 */
-	void send(unsigned num_bits)
+	__forceinline void send(unsigned num_bits)
 	{
 		hw->user1.usr_mosi_bitlen = num_bits - 1;
 		hw->cmd.usr = true;
 	}
 
-	void set_mode(SpiMode mode)
+	__forceinline void set_mode(SpiMode mode)
 	{
 		uint8_t mode_num = SPISettings::getModeNum(mode);
 		bool spi_cpha = (mode_num & 0x01) != 0;
@@ -101,7 +107,7 @@ struct SpiDevice {
 		hw->pin.ck_idle_edge = spi_cpol;
 	}
 
-	void set_bit_order(uint8_t bit_order)
+	__forceinline void set_bit_order(uint8_t bit_order)
 	{
 #ifdef SPI_DEBUG
 		debugf("[SPI] set_bit_order(bit_order %u)", bit_order);
@@ -114,7 +120,7 @@ struct SpiDevice {
 	}
 
 #if BYTE_ORDER_SUPPORTED
-	void set_byte_order(uint8_t byte_order)
+	__forceinline void set_byte_order(uint8_t byte_order)
 	{
 		decltype(hw->user) user;
 		user.val = hw->user.val;
@@ -134,7 +140,7 @@ struct SpiDevice {
 		hw->data_buf[0] = value;
 	}
 
-	void read(void* buffer, size_t length)
+	__forceinline void read(void* buffer, size_t length)
 	{
 		if(IS_ALIGNED(buffer) && IS_ALIGNED(length)) {
 			memcpy(buffer, (void*)hw->data_buf, length);
@@ -145,7 +151,7 @@ struct SpiDevice {
 		}
 	}
 
-	void write(const void* buffer, size_t length)
+	__forceinline void write(const void* buffer, size_t length)
 	{
 		if(IS_ALIGNED(buffer)) {
 			memcpy((void*)hw->data_buf, buffer, ALIGNUP4(length));
@@ -155,6 +161,19 @@ struct SpiDevice {
 			memcpy((void*)hw->data_buf, wordBuffer, ALIGNUP4(length));
 		}
 	}
+
+	__forceinline void fill(uint32_t value, size_t length)
+	{
+		for(unsigned i = 0; i < ALIGNUP4(length) / 4; ++i) {
+			hw->data_buf[i] = value;
+		}
+	}
+
+	__forceinline void enable_interrupt(bool enable)
+	{
+		hw->slave.trans_done = false;
+		hw->slave.trans_inten = enable;
+	}
 };
 
 /**
@@ -291,6 +310,7 @@ void SPIClass::end()
 {
 	GET_DEVICE();
 
+	wait();
 	busAssigned = false;
 }
 
@@ -375,3 +395,98 @@ bool SPIClass::loopback(bool enable)
 	(void)enable;
 	return false;
 }
+
+bool IRAM_ATTR SPIClass::queue(SpiTransaction& transaction)
+{
+	GET_DEVICE(false);
+
+	if(transaction.length == 0 || (transaction.csPin != SPI_PIN_NONE && transaction.csPin >= 16)) {
+		return false;
+	}
+
+	if(transaction.settings != nullptr && transaction.settings->speed.regVal == 0) {
+		checkSpeed(transaction.settings->speed);
+	}
+
+	if(!isrAttached) {
+		ETS_SPI_INTR_ATTACH(interruptHandler, this);
+		ETS_SPI_INTR_ENABLE();
+		isrAttached = true;
+	}
+
+	if(enqueue(transaction)) {
+		runTransaction();
+	}
+	return true;
+}
+
+void IRAM_ATTR SPIClass::runTransaction()
+{
+	auto& trans = *queueHead;
+	SpiDevice dev;
+
+	if(trans.done == 0) {
+		if(trans.settings != nullptr) {
+			auto& settings = *trans.settings;
+			dev.set_mode(settings.dataMode);
+			dev.hw->clock.val = settings.speed.regVal;
+			dev.set_bit_order(settings.bitOrder);
+			lsbFirst = (settings.bitOrder != MSBFIRST);
+		}
+		// Transfer LS byte first to match system byte order, as for transfer()
+		dev.set_byte_order(LSBFIRST);
+		if(trans.csPin != SPI_PIN_NONE) {
+			GP_OUT(trans.csPin, 0);
+		}
+		dev.enable_interrupt(true);
+	}
+
+	auto blockLen = std::min(trans.length - trans.done, SPI_FIFO_SIZE);
+	if(trans.txData == nullptr) {
+		dev.fill(0xffffffff, blockLen);
+	} else {
+		dev.write(static_cast<const uint8_t*>(trans.txData) + trans.done, blockLen);
+	}
+	dev.send(blockLen * 8);
+}
+
+void IRAM_ATTR SPIClass::interruptHandler(void* param)
+{
+	if((READ_PERI_REG(DPORT_SPI_INT_STATUS_REG) & DPORT_SPI1_INT) == 0) {
+		return;
+	}
+
+	SpiDevice dev;
+	dev.hw->slave.trans_done = false;
+
+	auto spi = static_cast<SPIClass*>(param);
+	auto trans = spi->queueHead;
+	if(trans == nullptr) {
+		return;
+	}
+
+	auto blockLen = std::min(trans->length - trans->done, SPI_FIFO_SIZE);
+	if(trans->rxData != nullptr) {
+		dev.read(static_cast<uint8_t*>(trans->rxData) + trans->done, blockLen);
+	}
+	trans->done += blockLen;
+	if(trans->done < trans->length) {
+		spi->runTransaction();
+		return;
+	}
+
+	if(trans->csPin != SPI_PIN_NONE) {
+		GP_OUT(trans->csPin, 1);
+	}
+	dev.set_byte_order(spi->lsbFirst ? LSBFIRST : MSBFIRST);
+
+	if(spi->dequeue() != nullptr) {
+		spi->runTransaction();
+	} else {
+		dev.enable_interrupt(false);
+	}
+
+	if(trans->callback != nullptr) {
+		trans->callback(*trans);
+	}
+}
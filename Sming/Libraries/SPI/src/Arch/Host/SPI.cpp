@@ -266,3 +266,66 @@ bool SPIClass::loopback(bool enable)
 	(void)enable;
 	return true;
 }
+
+bool SPIClass::queue(SpiTransaction& transaction)
+{
+	GET_DEVICE(false);
+
+	if(transaction.length == 0) {
+		return false;
+	}
+
+	if(enqueue(transaction)) {
+		runTransaction();
+	}
+	return true;
+}
+
+/*
+ * There are no interrupts so all transactions are run to completion here.
+ * Any queued by a completion callback are picked up by the loop, rather than by recursion.
+ */
+void SPIClass::runTransaction()
+{
+	static BitSet<uint8_t, SpiBus, SOC_SPI_PERIPH_NUM + 1> running;
+	if(running[busId]) {
+		return;
+	}
+	running += busId;
+
+	SpiTransaction* trans;
+	while((trans = queueHead) != nullptr) {
+		if(trans->settings != nullptr) {
+			prepare(*trans->settings);
+		}
+		if(trans->csPin != SPI_PIN_NONE) {
+			digitalWrite(trans->csPin, LOW);
+		}
+
+		uint8_t block[64];
+		while(trans->done < trans->length) {
+			auto blockLen = std::min(trans->length - trans->done, sizeof(block));
+			if(trans->txData == nullptr) {
+				memset(block, 0xff, blockLen);
+			} else {
+				memcpy(block, static_cast<const uint8_t*>(trans->txData) + trans->done, blockLen);
+			}
+			transfer(block, blockLen);
+			if(trans->rxData != nullptr) {
+				memcpy(static_cast<uint8_t*>(trans->rxData) + trans->done, block, blockLen);
+			}
+			trans->done += blockLen;
+		}
+
+		if(trans->csPin != SPI_PIN_NONE) {
+			digitalWrite(trans->csPin, HIGH);
+		}
+
+		dequeue();
+		if(trans->callback != nullptr) {
+			trans->callback(*trans);
+		}
+	}
+
+	running -= busId;
+}
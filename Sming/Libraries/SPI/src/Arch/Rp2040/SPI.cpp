@@ -14,6 +14,8 @@
 #include <hardware/address_mapped.h>
 #include <hardware/resets.h>
 #include <hardware/gpio.h>
+#include <hardware/dma.h>
+#include <hardware/irq.h>
 #include <Data/BitSet.h>
 #include <debug_progmem.h>
 
@@ -180,6 +182,23 @@ SpiDevice& getDevice(SpiBus busId)
 
 BitSet<uint8_t, SpiBus, SOC_SPI_PERIPH_NUM + 1> busAssigned;
 
+// DMA channels claimed on first use of asynchronous transactions
+struct DmaChannels {
+	int tx{-1};
+	int rx{-1};
+	SPIClass* spi{nullptr};
+};
+
+DmaChannels dmaChannels[SOC_SPI_PERIPH_NUM];
+bool dmaIrqInitialised;
+uint8_t dmaDiscard;
+const uint8_t dmaFill{0xff};
+
+DmaChannels& getDmaChannels(SpiBus busId)
+{
+	return dmaChannels[unsigned(busId) - 1];
+}
+
 // Cortex M0+ doesn't support the rbit instruction
 // __forceinline uint32_t reverseBits(uint32_t value)
 // {
@@ -294,6 +313,14 @@ bool SPIClass::begin()
 void SPIClass::end()
 {
 	GET_DEVICE();
+	wait();
+	auto& dma = getDmaChannels(busId);
+	if(dma.spi != nullptr) {
+		dma_channel_set_irq0_enabled(dma.rx, false);
+		dma_channel_unclaim(dma.tx);
+		dma_channel_unclaim(dma.rx);
+		dma = DmaChannels{};
+	}
 	dev.deinit();
 	busAssigned -= busId;
 }
@@ -415,3 +442,114 @@ bool SPIClass::loopback(bool enable)
 	dev.loopback(enable);
 	return true;
 }
+
+bool SPIClass::queue(SpiTransaction& transaction)
+{
+	GET_DEVICE(false);
+
+	if(transaction.length == 0) {
+		return false;
+	}
+
+	// DMA cannot reverse bit order
+	auto settings = transaction.settings;
+	if((settings != nullptr) ? (settings->bitOrder == LSBFIRST) : lsbFirst) {
+		debug_e("[SPI] LSBFIRST not supported for queued transactions");
+		return false;
+	}
+
+	if(settings != nullptr && settings->speed.regVal == 0) {
+		settings->speed.regVal = calculateSpeed(settings->speed.frequency).reg.val;
+	}
+
+	auto& dma = getDmaChannels(busId);
+	if(dma.spi == nullptr) {
+		if(!dmaIrqInitialised) {
+			irq_add_shared_handler(DMA_IRQ_0, interruptHandler, PICO_SHARED_IRQ_HANDLER_DEFAULT_ORDER_PRIORITY);
+			irq_set_enabled(DMA_IRQ_0, true);
+			dmaIrqInitialised = true;
+		}
+		dma.tx = dma_claim_unused_channel(true);
+		dma.rx = dma_claim_unused_channel(true);
+		dma_channel_acknowledge_irq0(dma.rx);
+		dma_channel_set_irq0_enabled(dma.rx, true);
+		dma.spi = this;
+	}
+
+	if(enqueue(transaction)) {
+		runTransaction();
+	}
+	return true;
+}
+
+void IRAM_ATTR SPIClass::runTransaction()
+{
+	auto& trans = *queueHead;
+	auto& dev = getDevice(busId);
+	auto& dma = getDmaChannels(busId);
+
+	if(trans.settings != nullptr) {
+		auto& settings = *trans.settings;
+		ClockReg clk;
+		clk.val = settings.speed.regVal;
+		cr0val = dev.configure(8, settings.dataMode, clk);
+		lsbFirst = false;
+	} else {
+		dev.set_data_bits(cr0val, 8);
+	}
+
+	if(trans.csPin != SPI_PIN_NONE) {
+		gpio_put(trans.csPin, false);
+	}
+
+	dev.hw->dmacr = SPI_SSPDMACR_TXDMAE_BITS | SPI_SSPDMACR_RXDMAE_BITS;
+	auto dreqBase = (dev.hw == spi0_hw) ? DREQ_SPI0_TX : DREQ_SPI1_TX;
+
+	// Receive channel completes last, so raises the interrupt
+	auto cfg = dma_channel_get_default_config(dma.rx);
+	channel_config_set_transfer_data_size(&cfg, DMA_SIZE_8);
+	channel_config_set_dreq(&cfg, dreqBase + 1);
+	channel_config_set_read_increment(&cfg, false);
+	channel_config_set_write_increment(&cfg, trans.rxData != nullptr);
+	dma_channel_configure(dma.rx, &cfg, trans.rxData ? trans.rxData : &dmaDiscard, &dev.hw->dr, trans.length, false);
+
+	cfg = dma_channel_get_default_config(dma.tx);
+	channel_config_set_transfer_data_size(&cfg, DMA_SIZE_8);
+	channel_config_set_dreq(&cfg, dreqBase);
+	channel_config_set_read_increment(&cfg, trans.txData != nullptr);
+	channel_config_set_write_increment(&cfg, false);
+	dma_channel_configure(dma.tx, &cfg, &dev.hw->dr, trans.txData ? trans.txData : &dmaFill, trans.length, false);
+
+	dma_start_channel_mask(BIT(dma.tx) | BIT(dma.rx));
+}
+
+void IRAM_ATTR SPIClass::interruptHandler()
+{
+	for(auto& dma : dmaChannels) {
+		if(dma.spi == nullptr || !dma_channel_get_irq0_status(dma.rx)) {
+			continue;
+		}
+		dma_channel_acknowledge_irq0(dma.rx);
+
+		auto spi = dma.spi;
+		auto trans = spi->queueHead;
+		if(trans == nullptr) {
+			continue;
+		}
+
+		auto& dev = getDevice(spi->busId);
+		dev.hw->dmacr = 0;
+		trans->done = trans->length;
+		if(trans->csPin != SPI_PIN_NONE) {
+			gpio_put(trans->csPin, true);
+		}
+
+		if(spi->dequeue() != nullptr) {
+			spi->runTransaction();
+		}
+
+		if(trans->callback != nullptr) {
+			trans->callback(*trans);
+		}
+	}
+}
@@ -23,6 +23,39 @@
  * @{
  */
 
+/**
+ * @brief Use for SpiTransaction::csPin where no chip select is required
+ */
+static constexpr uint8_t SPI_PIN_NONE{0xff};
+
+/**
+ * @brief Describes an asynchronous SPI transfer
+ *
+ * The transaction object and its buffers must remain valid until the callback has been invoked.
+ * Transfers are full-duplex: `txData` and `rxData` may refer to the same buffer.
+ */
+struct SpiTransaction {
+	/**
+	 * @brief Invoked on completion
+	 * @note Called in interrupt context, so code must be in IRAM.
+	 * The callback may queue another transaction, or re-queue this one.
+	 */
+	using Callback = void (*)(SpiTransaction& transaction);
+
+	SPISettings* settings{nullptr}; ///< Applied before the transfer, nullptr to leave unchanged
+	const void* txData{nullptr};	///< Data to send, nullptr to send 0xff
+	void* rxData{nullptr};			///< Buffer for received data, nullptr to discard
+	size_t length{0};				///< Number of bytes to transfer
+	Callback callback{nullptr};
+	void* param{nullptr};		 ///< For use by callback
+	uint8_t csPin{SPI_PIN_NONE}; ///< Output GPIO driven low for the duration of the transfer (Esp8266: 0-15)
+
+private:
+	friend class SPIClass;
+	SpiTransaction* next{nullptr};
+	size_t done{0}; ///< Number of bytes transferred so far
+};
+
 /**
  * @brief  Hardware SPI class
  */
@@ -57,6 +90,48 @@ public:
 
 	bool loopback(bool enable) override;
 
+	/**
+	 * @name Asynchronous transfers
+	 *
+	 * Transactions are queued and run in the background, so the application can do other work whilst
+	 * the bus is active. On completion of each transaction the next is started from the interrupt handler.
+	 *
+	 * Esp8266 and Esp32 transfer data via the 64-byte hardware buffer, with an interrupt for each block.
+	 * Rp2040 uses DMA, with one interrupt per transaction. Host completes transactions immediately.
+	 *
+	 * Synchronous methods must not be used whilst transactions are pending. Use isBusy() or wait() to check.
+	 * @{
+	 */
+
+	/**
+	 * @brief Queue a transaction
+	 * @param transaction
+	 * @retval bool false if bus is not ready or transaction is invalid
+	 * @note If called from interrupt context, any settings must already have been used
+	 * (e.g. via beginTransaction) so that clock register values are pre-calculated.
+	 * Settings remain in effect after the transaction, as with `beginTransaction()`.
+	 */
+	bool queue(SpiTransaction& transaction);
+
+	/**
+	 * @brief Determine if any transactions are pending
+	 */
+	bool isBusy() const
+	{
+		return queueHead != nullptr;
+	}
+
+	/**
+	 * @brief Wait for all queued transactions to complete
+	 */
+	void wait()
+	{
+		while(isBusy()) {
+		}
+	}
+
+	/** @} */
+
 #ifdef ARCH_HOST
 	/**
 	 * @brief Used for testing purposes only
@@ -79,6 +154,17 @@ protected:
 	void prepare(SPISettings& settings) override;
 
 private:
+	bool enqueue(SpiTransaction& transaction);
+	SpiTransaction* dequeue();
+	void runTransaction();
+#ifdef ARCH_RP2040
+	static void interruptHandler();
+#else
+	static void interruptHandler(void* param);
+#endif
+
+	SpiTransaction* volatile queueHead{nullptr};
+	SpiTransaction* queueTail{nullptr};
 #ifndef ARCH_ESP8266
 	SpiBus busId{SpiBus::DEFAULT};
 #endif
@@ -0,0 +1,51 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/SmingHub/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * SPITransaction.cpp - Transaction queue management common to all architectures
+ *
+ ****/
+
+#include "SPI.h"
+#include <esp_systemapi.h>
+
+/*
+ * Add a transaction to the end of the queue.
+ * Returns true if the queue was empty, so the caller must start it.
+ */
+bool IRAM_ATTR SPIClass::enqueue(SpiTransaction& transaction)
+{
+	transaction.next = nullptr;
+	transaction.done = 0;
+
+	auto level = noInterrupts();
+	bool idle = (queueHead == nullptr);
+	if(idle) {
+		queueHead = &transaction;
+	} else {
+		queueTail->next = &transaction;
+	}
+	queueTail = &transaction;
+	restoreInterrupts(level);
+
+	return idle;
+}
+
+/*
+ * Remove the completed transaction at the head of the queue.
+ * Returns the next transaction, if any.
+ */
+SpiTransaction* IRAM_ATTR SPIClass::dequeue()
+{
+	auto level = noInterrupts();
+	auto next = queueHead->next;
+	queueHead = next;
+	if(next == nullptr) {
+		queueTail = nullptr;
+	}
+	restoreInterrupts(level);
+
+	return next;
+}
@@ -281,6 +281,51 @@ public:
 
 			printStats();
 		}
+
+#if !SPISOFT_ENABLE
+		TEST_CASE("Queued transactions")
+		{
+			static volatile unsigned completeCount;
+			completeCount = 0;
+
+			DEFINE_FSTR_LOCAL(seq1, "Queued transactions run in the background, one after the other");
+			String txData = seq1;
+			txData += txData;
+			txData += txData;
+			String rxData[2];
+			SpiTransaction trans[2];
+			settings.bitOrder = MSBFIRST;
+			for(unsigned i = 0; i < 2; ++i) {
+				rxData[i].setLength(txData.length() - i);
+				trans[i].settings = &settings;
+				trans[i].txData = txData.c_str() + i;
+				trans[i].rxData = rxData[i].begin();
+				trans[i].length = rxData[i].length();
+				trans[i].callback = [](SpiTransaction&) { ++completeCount; };
+			}
+
+			// Clock register values must be calculated before queuing from interrupt context
+			SPI.beginTransaction(settings);
+			SPI.endTransaction();
+
+			REQUIRE(SPI.queue(trans[0]));
+			REQUIRE(SPI.queue(trans[1]));
+			SPI.wait();
+			REQUIRE(!SPI.isBusy());
+			REQUIRE_EQ(completeCount, 2);
+
+			for(unsigned i = 0; i < 2; ++i) {
+				if(memcmp(rxData[i].c_str(), txData.c_str() + i, rxData[i].length()) != 0) {
+					m_printHex("<", rxData[i].c_str(), std::min(rxData[i].length(), 64U));
+					if(allowFailure) {
+						fail(__PRETTY_FUNCTION__);
+					} else {
+						TEST_ASSERT(false);
+					}
+				}
+			}
+		}
+#endif
 	}
 
 	void send(uint32_t outValue, uint8_t bits)
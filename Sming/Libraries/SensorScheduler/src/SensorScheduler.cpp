@@ -0,0 +1,329 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/SmingHub/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * SensorScheduler.cpp
+ *
+ * All state changes happen in task context. The transaction callback, which runs in
+ * interrupt context, only flags completion and queues a service call.
+ *
+ ****/
+
+#include "SensorScheduler.h"
+#include <Platform/System.h>
+#include <Clock.h>
+#include <debug_progmem.h>
+
+/* I2cSensor */
+
+I2cSensor::I2cSensor(uint8_t address, const Step* steps, uint8_t stepCount, Callback callback)
+	: callback(callback), steps(steps), stepCount(stepCount)
+{
+	transaction.address = address;
+	transaction.callback = transactionComplete;
+	transaction.param = this;
+}
+
+I2cSensor::~I2cSensor()
+{
+	if(scheduler != nullptr) {
+		scheduler->remove(*this);
+	}
+}
+
+uint32_t I2cSensor::getLatency() const
+{
+	uint32_t latency{0};
+	for(unsigned i = 0; i + 1 < stepCount; ++i) {
+		latency += steps[i].delay;
+	}
+	return latency;
+}
+
+void IRAM_ATTR I2cSensor::transactionComplete(TwoWire::Transaction& transaction)
+{
+	auto sensor = static_cast<I2cSensor*>(transaction.param);
+	sensor->completed = true;
+	sensor->busy = false;
+	sensor->scheduler->requestService();
+}
+
+/* SensorScheduler */
+
+SensorScheduler::~SensorScheduler()
+{
+	stop();
+	while(auto sensor = sensors.head()) {
+		remove(*sensor);
+	}
+}
+
+void SensorScheduler::add(I2cSensor& sensor)
+{
+	if(sensor.scheduler == this) {
+		return;
+	}
+	if(sensor.scheduler != nullptr) {
+		sensor.scheduler->remove(sensor);
+	}
+	sensor.scheduler = this;
+	sensor.active = false;
+	sensors.add(&sensor);
+	if(running) {
+		requestService();
+	}
+}
+
+void SensorScheduler::remove(I2cSensor& sensor)
+{
+	if(sensor.scheduler != this) {
+		return;
+	}
+	if(sensor.busy) {
+		wire.wait();
+	}
+	sensors.remove(&sensor);
+	sensor.scheduler = nullptr;
+	sensor.active = false;
+	if(running) {
+		requestService();
+	}
+}
+
+void SensorScheduler::start(uint32_t intervalMs)
+{
+	interval = intervalMs;
+	running = true;
+	phase = Phase::idle;
+	cycleStart = millis() - interval;
+	requestService();
+}
+
+void SensorScheduler::stop()
+{
+	running = false;
+	timer.stop();
+	phase = Phase::idle;
+	for(auto& sensor : sensors) {
+		sensor.active = false;
+	}
+}
+
+void SensorScheduler::staticService(void* param)
+{
+	auto scheduler = static_cast<SensorScheduler*>(param);
+	scheduler->serviceQueued = false;
+	scheduler->service();
+}
+
+void IRAM_ATTR SensorScheduler::requestService()
+{
+	if(!serviceQueued) {
+		serviceQueued = System.queueCallback(staticService, this);
+	}
+}
+
+void SensorScheduler::arm(uint32_t ms)
+{
+	auto callback = [](void* param) { static_cast<SensorScheduler*>(param)->requestService(); };
+	timer.initializeMs(std::max(ms, uint32_t(1)), callback, this);
+	timer.startOnce();
+}
+
+void SensorScheduler::service()
+{
+	if(!running) {
+		return;
+	}
+
+	auto now = millis();
+
+	for(auto& sensor : sensors) {
+		if(sensor.completed) {
+			sensor.completed = false;
+			handleCompletion(sensor, now);
+		}
+	}
+
+	if(phase == Phase::idle) {
+		if(sensors.isEmpty()) {
+			return;
+		}
+		uint32_t elapsed = now - cycleStart;
+		if(elapsed < interval) {
+			arm(interval - elapsed);
+			return;
+		}
+		startCycle(now);
+	}
+
+	if(phase == Phase::converting) {
+		uint32_t wait;
+		if(!updateConversions(now, wait)) {
+			if(wait != 0) {
+				arm(wait);
+			}
+			return;
+		}
+
+		// All conversions complete, so read results as one batch
+		phase = Phase::reading;
+		for(auto& sensor : sensors) {
+			if(sensor.active && !sensor.failed) {
+				queueStep(sensor);
+			}
+		}
+	}
+
+	for(auto& sensor : sensors) {
+		if(sensor.active && sensor.busy) {
+			// Completion will request service again
+			return;
+		}
+	}
+
+	finishCycle();
+	requestService();
+}
+
+void SensorScheduler::startCycle(uint32_t now)
+{
+	// Sensors which take longest to convert are started first
+	uint32_t maxLatency{0};
+	for(auto& sensor : sensors) {
+		sensor.active = (sensor.stepCount != 0) && (cycleIndex % sensor.divider == 0);
+		if(sensor.active) {
+			maxLatency = std::max(maxLatency, sensor.getLatency());
+		}
+	}
+
+	for(auto& sensor : sensors) {
+		if(!sensor.active) {
+			continue;
+		}
+		sensor.failed = false;
+		sensor.stepIndex = 0;
+		sensor.dueTime = now + maxLatency - sensor.getLatency();
+	}
+
+	cycleStart = now;
+	phase = Phase::converting;
+}
+
+/*
+ * Run any conversion steps which are due.
+ * Returns true when every active sensor is waiting only for its final step.
+ * Otherwise, wait is set to the time until the next step is due, or 0 if waiting for the bus.
+ */
+bool SensorScheduler::updateConversions(uint32_t now, uint32_t& wait)
+{
+	bool ready{true};
+	wait = UINT32_MAX;
+	for(auto& sensor : sensors) {
+		if(!sensor.active || sensor.failed) {
+			continue;
+		}
+		if(sensor.busy) {
+			ready = false;
+			wait = 0;
+			continue;
+		}
+		int32_t remaining = sensor.dueTime - now;
+		if(remaining > 0) {
+			ready = false;
+			if(wait != 0) {
+				wait = std::min(wait, uint32_t(remaining));
+			}
+			continue;
+		}
+		if(!sensor.isFinalStep()) {
+			queueStep(sensor);
+			if(!sensor.failed) {
+				// Completion will request service
+				ready = false;
+				wait = 0;
+			}
+		}
+	}
+
+	if(wait == UINT32_MAX) {
+		wait = 0;
+	}
+	return ready;
+}
+
+void SensorScheduler::queueStep(I2cSensor& sensor)
+{
+	auto& step = sensor.steps[sensor.stepIndex];
+	auto& t = sensor.transaction;
+	t.txData = step.command;
+	t.txLength = std::min(step.commandLength, uint8_t(sizeof(step.command)));
+	t.rxData = sensor.data;
+	t.rxLength = std::min(step.readLength, uint8_t(SENSOR_MAX_DATA_LENGTH));
+	t.sendStop = true;
+
+	sensor.busy = true;
+	if(!wire.queue(t)) {
+		sensor.busy = false;
+		sensor.failed = true;
+		sensor.error = TwoWire::I2C_ERR_LINE_BUSY;
+	}
+}
+
+void SensorScheduler::handleCompletion(I2cSensor& sensor, uint32_t now)
+{
+	if(!sensor.active) {
+		return;
+	}
+
+	auto& step = sensor.steps[sensor.stepIndex];
+	auto& t = sensor.transaction;
+	if(t.error != TwoWire::I2C_ERR_SUCCESS && !step.ignoreNack) {
+		debug_w("[SENSOR] 0x%02x step %u error %u", t.address, sensor.stepIndex, t.error);
+		sensor.failed = true;
+		sensor.error = t.error;
+		return;
+	}
+
+	if(t.rxLength != 0) {
+		sensor.dataLength = t.rxLength;
+	}
+
+	if(!sensor.isFinalStep()) {
+		sensor.dueTime = now + step.delay;
+		++sensor.stepIndex;
+	}
+}
+
+void SensorScheduler::finishCycle()
+{
+	phase = Phase::idle;
+	++cycleIndex;
+	++stats.cycles;
+	if(interval != 0 && millis() - cycleStart > interval) {
+		++stats.overruns;
+	}
+
+	// A callback may remove its own sensor
+	for(auto& sensor : sensors) {
+		if(!sensor.active) {
+			continue;
+		}
+		sensor.active = false;
+		if(sensor.failed) {
+			++sensor.stats.errors;
+		} else {
+			sensor.error = TwoWire::I2C_ERR_SUCCESS;
+			++sensor.stats.samples;
+		}
+		if(sensor.callback) {
+			sensor.callback(sensor);
+		}
+	}
+
+	if(cycleCallback) {
+		cycleCallback();
+	}
+}
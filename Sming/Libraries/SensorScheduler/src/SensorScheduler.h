@@ -0,0 +1,243 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/SmingHub/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * SensorScheduler.h - Non-blocking polling of I2C sensors
+ *
+ ****/
+
+#pragma once
+
+#include <Wire.h>
+#include <SimpleTimer.h>
+#include <Delegate.h>
+#include <Data/DoublyLinkedObjectList.h>
+
+/**
+ * @brief Maximum number of bytes read from a sensor per sample
+ */
+#ifndef SENSOR_MAX_DATA_LENGTH
+#define SENSOR_MAX_DATA_LENGTH 16
+#endif
+
+class SensorScheduler;
+
+/**
+ * @brief An I2C sensor described as a sequence of bus transactions with delays between them
+ *
+ * Typically there are two steps: write a command to start a conversion, wait for it to complete,
+ * then read the result. The last step which reads data provides the sample.
+ */
+class I2cSensor : public DoublyLinkedObjectTemplate<I2cSensor>
+{
+public:
+	struct Step {
+		uint8_t command[4];	///< Bytes to write, e.g. command or register address
+		uint8_t commandLength; ///< Number of command bytes
+		uint8_t readLength;	///< Bytes to read after writing command
+		uint16_t delay;		   ///< Milliseconds to wait after this step before starting the next
+		bool ignoreNack;	   ///< Set for wake-up sequences where the device does not acknowledge
+	};
+
+	struct Stats {
+		uint32_t samples; ///< Successful samples
+		uint32_t errors;  ///< Samples lost due to bus errors
+	};
+
+	/**
+	 * @brief Invoked in task context once a sample has been read, or has failed
+	 */
+	using Callback = Delegate<void(I2cSensor& sensor)>;
+
+	/**
+	 * @brief Constructor
+	 * @param address Device address
+	 * @param steps Must remain valid for the lifetime of the sensor
+	 * @param stepCount Number of steps
+	 * @param callback
+	 */
+	I2cSensor(uint8_t address, const Step* steps, uint8_t stepCount, Callback callback = nullptr);
+
+	template <size_t N>
+	I2cSensor(uint8_t address, const Step (&steps)[N], Callback callback = nullptr)
+		: I2cSensor(address, steps, N, callback)
+	{
+	}
+
+	~I2cSensor();
+
+	void onData(Callback callback)
+	{
+		this->callback = callback;
+	}
+
+	/**
+	 * @brief Sample only every so many cycles
+	 * @param cycles 1 to sample every cycle
+	 */
+	void setDivider(uint8_t cycles)
+	{
+		divider = cycles ? cycles : 1;
+	}
+
+	uint8_t getAddress() const
+	{
+		return transaction.address;
+	}
+
+	/**
+	 * @brief Get data read by last sample
+	 */
+	const uint8_t* getData() const
+	{
+		return data;
+	}
+
+	size_t getLength() const
+	{
+		return dataLength;
+	}
+
+	/**
+	 * @brief Get result of last sample
+	 */
+	TwoWire::Error getError() const
+	{
+		return error;
+	}
+
+	/**
+	 * @brief Time from start of first step until final step may run
+	 */
+	uint32_t getLatency() const;
+
+	const Stats& getStats() const
+	{
+		return stats;
+	}
+
+private:
+	friend class SensorScheduler;
+
+	static void transactionComplete(TwoWire::Transaction& transaction);
+	bool isFinalStep() const
+	{
+		return stepIndex + 1 >= stepCount;
+	}
+
+	TwoWire::Transaction transaction;
+	SensorScheduler* scheduler{nullptr};
+	Callback callback;
+	const Step* steps;
+	Stats stats{};
+	uint32_t dueTime{0};
+	uint8_t stepCount;
+	uint8_t stepIndex{0};
+	uint8_t divider{1};
+	uint8_t dataLength{0};
+	uint8_t data[SENSOR_MAX_DATA_LENGTH]{};
+	TwoWire::Error error{TwoWire::I2C_ERR_SUCCESS};
+	volatile bool busy{false};
+	volatile bool completed{false};
+	bool active{false};
+	bool failed{false};
+};
+
+/**
+ * @brief Polls I2C sensors without blocking
+ *
+ * Each cycle, every sensor is started at a time chosen so that all conversions finish together.
+ * The final reads are then queued back-to-back as one batch. Transactions use `TwoWire::queue()`,
+ * so the bus runs in the background and the application is never held up waiting for a sensor.
+ */
+class SensorScheduler
+{
+public:
+	using CycleCallback = Delegate<void()>;
+
+	struct Stats {
+		uint32_t cycles;	///< Completed cycles
+		uint32_t overruns; ///< Cycles which took longer than the interval
+	};
+
+	SensorScheduler(TwoWire& wire) : wire(wire)
+	{
+	}
+
+	~SensorScheduler();
+
+	/**
+	 * @brief Add a sensor
+	 * @note Takes effect from the next cycle
+	 */
+	void add(I2cSensor& sensor);
+
+	/**
+	 * @brief Remove a sensor
+	 * @note If the sensor has a transaction in progress this waits for the bus to finish
+	 */
+	void remove(I2cSensor& sensor);
+
+	/**
+	 * @brief Start sampling
+	 * @param intervalMs Time between the start of each cycle. Use 0 to sample as fast as the sensors allow.
+	 */
+	void start(uint32_t intervalMs);
+
+	/**
+	 * @brief Stop sampling
+	 * @note The current cycle is abandoned, but any transactions already queued will complete
+	 */
+	void stop();
+
+	bool isRunning() const
+	{
+		return running;
+	}
+
+	/**
+	 * @brief Set callback to run after all sensors have been read each cycle
+	 */
+	void onCycleComplete(CycleCallback callback)
+	{
+		cycleCallback = callback;
+	}
+
+	const Stats& getStats() const
+	{
+		return stats;
+	}
+
+private:
+	friend class I2cSensor;
+
+	enum class Phase {
+		idle,
+		converting,
+		reading,
+	};
+
+	static void staticService(void* param);
+	void requestService();
+	void service();
+	void startCycle(uint32_t now);
+	bool updateConversions(uint32_t now, uint32_t& wait);
+	void finishCycle();
+	void queueStep(I2cSensor& sensor);
+	void handleCompletion(I2cSensor& sensor, uint32_t now);
+	void arm(uint32_t ms);
+
+	TwoWire& wire;
+	DoublyLinkedObjectListTemplate<I2cSensor> sensors;
+	SimpleTimer timer;
+	CycleCallback cycleCallback;
+	Stats stats{};
+	uint32_t interval{0};
+	uint32_t cycleStart{0};
+	uint32_t cycleIndex{0};
+	Phase phase{Phase::idle};
+	volatile bool serviceQueued{false};
+	bool running{false};
+};
@@ -7,9 +7,50 @@
 
 #include "Servo.h"
 #include <Digital.h>
+#include <esp_clk.h>
+#include <algorithm>
+
+#if defined(ARCH_ESP8266)
+#include <espinc/gpio_register.h>
+#elif defined(ARCH_RP2040)
+#include <hardware/gpio.h>
+#endif
 
 Servo servo;
 
+namespace
+{
+static_assert(Servo::maxChannels <= sizeof(Servo::PinMask) * 8, "Too many servo channels");
+
+/*
+ * Switch a group of pins in one go, via the GPIO set/clear registers where possible
+ */
+__forceinline void IRAM_ATTR writePins(Servo::PinMask clearMask, Servo::PinMask setMask)
+{
+#if defined(ARCH_ESP8266)
+	GPIO_REG_WRITE(GPIO_OUT_W1TC_ADDRESS, clearMask & 0xffff);
+	GPIO_REG_WRITE(GPIO_OUT_W1TS_ADDRESS, setMask & 0xffff);
+	// GPIO16 is on a separate register
+	if((clearMask | setMask) & BIT(16)) {
+		digitalWrite(16, (setMask & BIT(16)) != 0);
+	}
+#elif defined(ARCH_RP2040)
+	gpio_clr_mask(clearMask);
+	gpio_set_mask(setMask);
+#else
+	for(unsigned pin = 0; clearMask | setMask; ++pin, clearMask >>= 1, setMask >>= 1) {
+		if(clearMask & 1) {
+			digitalWrite(pin, false);
+		}
+		if(setMask & 1) {
+			digitalWrite(pin, true);
+		}
+	}
+#endif
+}
+
+} // namespace
+
 void Servo::staticTimerIsr()
 {
 	servo.timerIsr();
@@ -17,17 +58,25 @@ void Servo::staticTimerIsr()
 
 void Servo::timerIsr()
 {
-	auto& frame = frames[activeFrameIndex];
-	hardwareTimer.setInterval(frame.slots[activeSlot]);
-	if(activeSlot > 0) {
-		digitalWrite(frame.pins[activeSlot - 1], false);
-	}
-	++activeSlot;
-	if(activeSlot < frame.slotCount) {
-		digitalWrite(frame.pins[activeSlot - 1], true);
-	} else {
-		activeFrameIndex = nextFrameIndex;
-		activeSlot = 0;
+	auto frame = &frames[activeFrameIndex];
+	hardwareTimer.setInterval(frame->slots[activeSlot].interval);
+	auto startCycles = esp_get_ccount();
+	for(;;) {
+		auto& slot = frame->slots[activeSlot];
+		writePins(slot.clearMask, slot.setMask);
+		++activeSlot;
+		if(activeSlot >= frame->slotCount) {
+			// Final slot always ends with a long gap, so can switch frames here
+			activeFrameIndex = nextFrameIndex;
+			activeSlot = 0;
+			return;
+		}
+		if(slot.spinCycles == 0) {
+			return;
+		}
+		// Next edge is too close for another interrupt
+		while(esp_get_ccount() - startCycles < slot.spinCycles) {
+		}
 	}
 }
 
@@ -58,6 +107,14 @@ bool Servo::addChannel(ServoChannel* channel)
 		return true; // Already added
 	}
 
+	if(channel->getPin() >= sizeof(PinMask) * 8) {
+		return false;
+	}
+
+	if(mode == Mode::Sequential && channelCount >= maxSequentialChannels) {
+		return false;
+	}
+
 	// Find a free channel
 	i = findChannel(nullptr);
 	if(i < 0) {
@@ -100,6 +157,19 @@ void Servo::updateChannel(ServoChannel* channel)
 	updateTimer.startOnce();
 }
 
+bool Servo::setMode(Mode mode)
+{
+	if(mode == Mode::Sequential && channelCount > maxSequentialChannels) {
+		return false;
+	}
+
+	if(mode != this->mode) {
+		this->mode = mode;
+		updateTimer.startOnce();
+	}
+	return true;
+}
+
 void Servo::update()
 {
 	if(channelCount == 0) {
@@ -130,8 +200,20 @@ void Servo::calcTiming()
 	}
 
 	auto& frame = frames[newFrameIndex];
-	unsigned slotCount = 0;
+	frame.slotCount = (mode == Mode::Parallel) ? calcParallel(frame) : calcSequential(frame);
+	calcInterrupts(frame);
+
+	// ISR will switch at end of next frame
+	nextFrameIndex = newFrameIndex;
+}
 
+/*
+ * Each pulse starts when the previous one ends
+ */
+unsigned Servo::calcSequential(Frame& frame)
+{
+	unsigned slotCount = 0;
+	PinMask prevMask = 0;
 	uint32_t totalTicks = 0;
 	for(unsigned i = 0; i < maxChannels; ++i) {
 		auto channel = channels[i];
@@ -139,15 +221,93 @@ void Servo::calcTiming()
 			continue;
 		}
 
-		frame.pins[slotCount] = channel->getPin();
-		auto ticks = HardwareTimer::usToTicks(channel->getValue());
-		frame.slots[slotCount] = ticks;
-		totalTicks += ticks;
-		++slotCount;
+		auto& slot = frame.slots[slotCount++];
+		PinMask mask = PinMask(1) << channel->getPin();
+		slot.clearMask = prevMask;
+		slot.setMask = mask;
+		slot.ticks = HardwareTimer::usToTicks(channel->getValue());
+		totalTicks += slot.ticks;
+		prevMask = mask;
 	}
-	frame.slots[slotCount++] = periodTicks - totalTicks;
-	frame.slotCount = slotCount;
 
-	// ISR will switch at end of next frame
-	nextFrameIndex = newFrameIndex;
+	auto& slot = frame.slots[slotCount++];
+	slot.clearMask = prevMask;
+	slot.setMask = 0;
+	slot.ticks = periodTicks - totalTicks;
+	return slotCount;
+}
+
+/*
+ * All pulses start together, then end in order of duration.
+ * Channels ending at the same time share a slot.
+ */
+unsigned Servo::calcParallel(Frame& frame)
+{
+	struct Edge {
+		uint32_t ticks;
+		PinMask mask;
+	};
+	Edge edges[maxChannels];
+	unsigned edgeCount = 0;
+	PinMask allMask = 0;
+	for(unsigned i = 0; i < maxChannels; ++i) {
+		auto channel = channels[i];
+		if(channel == nullptr) {
+			continue;
+		}
+
+		auto& edge = edges[edgeCount++];
+		edge.ticks = HardwareTimer::usToTicks(channel->getValue());
+		edge.mask = PinMask(1) << channel->getPin();
+		allMask |= edge.mask;
+	}
+	std::sort(edges, edges + edgeCount, [](const Edge& e1, const Edge& e2) { return e1.ticks < e2.ticks; });
+
+	auto slot = &frame.slots[0];
+	slot->setMask = allMask;
+	slot->clearMask = 0;
+	unsigned slotCount = 1;
+	uint32_t slotTime = 0;
+	for(unsigned i = 0; i < edgeCount; ++i) {
+		auto& edge = edges[i];
+		if(edge.ticks != slotTime) {
+			slot->ticks = edge.ticks - slotTime;
+			slotTime = edge.ticks;
+			slot = &frame.slots[slotCount++];
+			slot->setMask = 0;
+			slot->clearMask = 0;
+		}
+		slot->clearMask |= edge.mask;
+	}
+	slot->ticks = periodTicks - slotTime;
+	return slotCount;
+}
+
+/*
+ * Edges closer together than the timer can manage are output from the same interrupt.
+ * The slot starting each interrupt gets the interval to the next one, and a slot followed
+ * by a close edge gets the CPU cycle count at which to output it, relative to the interrupt.
+ */
+void Servo::calcInterrupts(Frame& frame)
+{
+	const uint32_t cpuFrequency = system_get_cpu_freq() * 1000000U;
+	Slot* start = nullptr;
+	uint32_t elapsed = 0;
+	for(unsigned i = 0; i < frame.slotCount; ++i) {
+		auto& slot = frame.slots[i];
+		if(start == nullptr) {
+			start = &slot;
+			elapsed = 0;
+		}
+		elapsed += slot.ticks;
+		slot.interval = 0;
+		bool closeEdge = (i + 1 < frame.slotCount) && slot.ticks < HardwareTimer::minTicks();
+		if(closeEdge) {
+			slot.spinCycles = uint64_t(elapsed) * cpuFrequency / HardwareTimer::Clock::frequency();
+		} else {
+			slot.spinCycles = 0;
+			start->interval = elapsed;
+			start = nullptr;
+		}
+	}
 }
@@ -7,6 +7,7 @@
 /** @addtogroup   Servo RC Servo functions
  *  @brief      Provides Library to control rc servos with pwm signals
  *  - uses an internal instance of HardwareTimer (which use interrupts)
+ *  - pins are switched together using the GPIO set/clear registers where available
  *  @{
 */
 
@@ -16,6 +17,13 @@
 #include <HardwareTimer.h>
 #include <SimpleTimer.h>
 
+/**
+ * @brief Maximum number of servo channels
+ */
+#ifndef SERVO_MAX_CHANNELS
+#define SERVO_MAX_CHANNELS 16
+#endif
+
 /**
  * @brief Manages multiple servo channels
  * @note Do not call this class directly, instead use `ServoChannel` methods.
@@ -23,14 +31,29 @@
 class Servo
 {
 public:
-	static constexpr unsigned maxChannels = 5;	 ///< maximum number of servo channels
-	static constexpr uint32_t framePeriod = 20000; ///< Total frame time in microseconds
+	/**
+	 * @brief How channel pulses are arranged within each frame
+	 */
+	enum class Mode {
+		Sequential, ///< One pulse after another, limited to `maxSequentialChannels`
+		Parallel,	///< All pulses start together at the beginning of the frame
+	};
+
+	static constexpr unsigned maxChannels = SERVO_MAX_CHANNELS; ///< maximum number of servo channels
+	static constexpr unsigned maxSequentialChannels = 5;		  ///< maximum channels in Sequential mode
+	static constexpr uint32_t framePeriod = 20000;				  ///< Total frame time in microseconds
 	using HardwareTimer = HardwareTimer1<TIMER_CLKDIV_16, eHWT_NonMaskable>;
 	static constexpr uint32_t periodTicks = HardwareTimer::usToTicks<framePeriod>();
 	//	static constexpr uint32_t minChannelTime = HardwareTimer::ticksToUs<HardwareTimer::minTicks()>();
 	static constexpr uint32_t minChannelTime = MIN_HW_TIMER1_INTERVAL_US;
 	//	static constexpr uint32_t maxChannelTime = HardwareTimer::ticksToUs<channelTicks - HardwareTimer::minTicks()>();
-	static constexpr uint32_t maxChannelTime = framePeriod / maxChannels;
+	static constexpr uint32_t maxChannelTime = framePeriod / maxSequentialChannels;
+
+#if defined(ARCH_ESP8266) || defined(ARCH_RP2040)
+	using PinMask = uint32_t;
+#else
+	using PinMask = uint64_t;
+#endif
 
 	/** @brief  Instantiate servo object
 	 *  @note   Public global instance of Servo is available as variable servo.
@@ -57,10 +80,34 @@ public:
      */
 	void updateChannel(ServoChannel* channel);
 
+	/** @brief  Select how pulses are arranged within a frame
+	 *  @param  mode
+	 *  @retval bool false if there are too many channels for the requested mode
+	 *  @note   Parallel mode supports all `maxChannels` with the same timing accuracy, as all edges
+	 *  		are sorted into one precomputed schedule. Edges too close together for separate timer
+	 *  		interrupts are output from the same interrupt, using the CPU cycle counter.
+	 */
+	bool setMode(Mode mode);
+
+	Mode getMode() const
+	{
+		return mode;
+	}
+
+	/**
+	 * @brief One edge event in a frame
+	 */
+	struct Slot {
+		PinMask setMask;	 ///< Pins to switch ON
+		PinMask clearMask;	 ///< Pins to switch OFF
+		uint32_t ticks;		 ///< Time until the next slot, in timer ticks
+		uint32_t interval;	 ///< Timer ticks until the next interrupt, if this slot starts one
+		uint32_t spinCycles; ///< For a slot followed by a close edge, CPU cycles from interrupt to that edge
+	};
+
 	// Frame timings
 	struct Frame {
-		uint32_t slots[maxChannels + 1]; ///< Transition times in timer ticks
-		uint8_t pins[maxChannels];		 ///< Active pins
+		Slot slots[maxChannels + 1];
 		uint8_t slotCount = 0;
 	};
 
@@ -73,11 +120,15 @@ private:
 	void update();
 	int findChannel(ServoChannel* channel);
 	void calcTiming();
+	unsigned calcSequential(Frame& frame);
+	unsigned calcParallel(Frame& frame);
+	static void calcInterrupts(Frame& frame);
 	static void IRAM_ATTR staticTimerIsr();
 	void IRAM_ATTR timerIsr();
 
 private:
 	ServoChannel* channels[maxChannels] = {0};
+	Mode mode = Mode::Sequential;
 	unsigned channelCount = 0;   ///< Number of active channels
 	HardwareTimer hardwareTimer; ///< Handles generation of output signals
 	Frame frames[2];			 ///< Contains the active and next frames
@@ -23,6 +23,11 @@ COMPONENT_CXXFLAGS		+= -DSPIFF_FILEDESC_COUNT=$(SPIFF_FILEDESC_COUNT)
 
 COMPONENT_CFLAGS		+= -Wno-tautological-compare
 
+COMPONENT_RELINK_VARS	+= SPIFFS_INDEX_SIZE SPIFFS_INDEX_PERSIST
+SPIFFS_INDEX_SIZE		?= 16
+SPIFFS_INDEX_PERSIST	?= 0
+COMPONENT_CXXFLAGS		+= -DSPIFFS_INDEX_SIZE=$(SPIFFS_INDEX_SIZE) -DSPIFFS_INDEX_PERSIST=$(SPIFFS_INDEX_PERSIST)
+
 COMPONENT_RELINK_VARS	+= SPIFFS_OBJ_META_LEN
 SPIFFS_OBJ_META_LEN		?= 16
 COMPONENT_CFLAGS		+= -DSPIFFS_OBJ_META_LEN=$(SPIFFS_OBJ_META_LEN)
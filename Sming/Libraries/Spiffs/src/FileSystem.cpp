@@ -22,6 +22,7 @@
 #include "include/IFS/SPIFFS/FileSystem.h"
 #include "include/IFS/SPIFFS/Error.h"
 #include <IFS/Util.h>
+#include <algorithm>
 
 namespace IFS
 {
@@ -41,6 +42,9 @@ struct FileDir {
 
 constexpr uint32_t logicalBlockSize{4096 * 2};
 
+// Hidden file containing persisted object index
+constexpr char indexFileName[]{".spiffs-index"};
+
 namespace
 {
 /** @brief map IFS OpenFlags to SPIFFS equivalents
@@ -121,6 +125,7 @@ s32_t FileSystem::f_erase(struct spiffs_t* spiffs, u32_t addr, u32_t size)
 
 FileSystem::~FileSystem()
 {
+	saveIndex();
 	SPIFFS_unmount(handle());
 }
 
@@ -155,6 +160,8 @@ int FileSystem::mount()
 		 * For now, just format it.
 		 */
 		res = format();
+	} else {
+		loadIndex();
 	}
 
 #if SPIFFS_TEST_VISUALISATION
@@ -189,6 +196,7 @@ int FileSystem::format()
 	spiffs_config cfg = fs.cfg;
 	// Must be unmounted before format is called - see API
 	SPIFFS_unmount(handle());
+	index.clear();
 	int err = SPIFFS_format(handle());
 	if(err < 0) {
 		err = Error::fromSystem(err);
@@ -212,6 +220,43 @@ int FileSystem::check()
 	return Error::fromSystem(err);
 }
 
+int FileSystem::getGcInfo(GcInfo& info)
+{
+	info = GcInfo{};
+	CHECK_MOUNTED()
+
+	info.blockCount = fs.block_count;
+	info.freeBlocks = fs.free_blocks;
+	info.totalPages = (SPIFFS_PAGES_PER_BLOCK(&fs) - SPIFFS_OBJ_LOOKUP_PAGES(&fs)) * fs.block_count;
+	info.usedPages = fs.stats_p_allocated;
+	info.deletedPages = fs.stats_p_deleted;
+	return FS_OK;
+}
+
+int FileSystem::gcStep(bool compact)
+{
+	CHECK_MOUNTED()
+
+	auto freeBlocks = fs.free_blocks;
+
+	// Cheapest first: erase a block containing only deleted pages, nothing is moved
+	int err = SPIFFS_gc_quick(handle(), 0);
+	if(err == SPIFFS_ERR_NO_DELETED_BLOCKS && compact) {
+		// Request room for a single page, so SPIFFS cleans as little as it can
+		err = SPIFFS_gc(handle(), SPIFFS_DATA_PAGE_SIZE(&fs));
+	}
+	if(err == SPIFFS_ERR_NO_DELETED_BLOCKS || err == SPIFFS_ERR_FULL) {
+		err = SPIFFS_OK;
+	}
+	if(err < 0) {
+		err = Error::fromSystem(err);
+		debug_ifserr(err, "gcStep()");
+		return err;
+	}
+
+	return std::max(int(fs.free_blocks) - int(freeBlocks), 0);
+}
+
 int FileSystem::getinfo(Info& info)
 {
 	info.clear();
@@ -271,7 +316,7 @@ FileHandle FileSystem::open(const char* path, OpenFlags flags)
 		return FileHandle(Error::NotSupported);
 	}
 
-	auto file = SPIFFS_open(handle(), path, sflags, 0);
+	auto file = openIndexed(path, ObjectIndex::hash(path), sflags);
 	if(file < 0) {
 		int err = Error::fromSystem(file);
 		debug_ifserr(err, "open('%s')", path);
@@ -302,6 +347,104 @@ FileHandle FileSystem::open(const char* path, OpenFlags flags)
 	return file;
 }
 
+FileHandle FileSystem::openIndexed(const char* path, uint32_t hash, spiffs_flags sflags)
+{
+	auto& stats = index.getStats();
+	// Only SPIFFS_open() can check the file doesn't already exist
+	auto entry = (sflags & SPIFFS_O_EXCL) ? nullptr : index.find(hash);
+	if(entry == nullptr) {
+		++stats.misses;
+	} else {
+		/*
+		 * Garbage collection may have moved the header, and the page re-used by another file.
+		 * Open read-only to confirm the page still holds the header for this file,
+		 * so a stale entry can never modify anything.
+		 */
+		auto file = SPIFFS_open_by_page(handle(), entry->pix, SPIFFS_O_RDONLY, 0);
+		if(file >= 0) {
+			auto fd = getDescriptor(file);
+			spiffs_stat ss;
+			if(fd != nullptr && fd->obj_id == entry->objId && SPIFFS_fstat(handle(), file, &ss) >= 0 &&
+			   strcmp(reinterpret_cast<const char*>(ss.name), path) == 0) {
+				++stats.hits;
+				if(sflags == SPIFFS_O_RDONLY) {
+					return file;
+				}
+				// Page is verified, so re-open with requested flags
+				SPIFFS_close(handle(), file);
+				return SPIFFS_open_by_page(handle(), entry->pix, sflags, 0);
+			}
+			SPIFFS_close(handle(), file);
+		}
+		++stats.stale;
+		index.remove(hash);
+	}
+
+	auto file = SPIFFS_open(handle(), path, sflags, 0);
+	if(file >= 0) {
+		auto fd = getDescriptor(file);
+		if(fd != nullptr) {
+			index.update(hash, fd->obj_id, fd->objix_hdr_pix);
+		}
+	}
+	return file;
+}
+
+spiffs_fd* FileSystem::getDescriptor(FileHandle file)
+{
+	spiffs_fd* fd;
+	int err = spiffs_fd_get(handle(), SPIFFS_FH_UNOFFS(handle(), file), &fd);
+	return (err == SPIFFS_OK) ? fd : nullptr;
+}
+
+void FileSystem::loadIndex()
+{
+#if SPIFFS_INDEX_PERSIST
+	auto file = SPIFFS_open(handle(), indexFileName, SPIFFS_O_RDONLY, 0);
+	if(file < 0) {
+		return;
+	}
+
+	ObjectIndex::Image image;
+	int len = SPIFFS_read(handle(), file, &image, sizeof(image));
+	SPIFFS_close(handle(), file);
+	if(len != sizeof(image) || !index.setImage(image)) {
+		debug_w("[SPIFFS] Object index invalid, ignoring");
+	}
+#endif
+}
+
+int FileSystem::saveIndex()
+{
+#if SPIFFS_INDEX_PERSIST
+	CHECK_MOUNTED()
+
+	if(!index.isDirty() || partition.isReadOnly()) {
+		return FS_OK;
+	}
+
+	ObjectIndex::Image image;
+	index.getImage(image);
+	auto file = SPIFFS_open(handle(), indexFileName, SPIFFS_O_CREAT | SPIFFS_O_TRUNC | SPIFFS_O_WRONLY, 0);
+	if(file < 0) {
+		return Error::fromSystem(file);
+	}
+	int res = SPIFFS_write(handle(), file, &image, sizeof(image));
+	int err = SPIFFS_close(handle(), file);
+	if(res >= 0) {
+		res = err;
+	}
+	if(res < 0) {
+		res = Error::fromSystem(res);
+		debug_ifserr(res, "saveIndex()");
+		return res;
+	}
+	return FS_OK;
+#else
+	return Error::NotSupported;
+#endif
+}
+
 int FileSystem::close(FileHandle file)
 {
 	CHECK_MOUNTED()
@@ -311,6 +454,11 @@ int FileSystem::close(FileHandle file)
 	}
 
 	int res = flushMeta(file);
+	// Header page moves when file is modified
+	auto fd = getDescriptor(file);
+	if(fd != nullptr) {
+		index.updatePage(fd->obj_id, fd->objix_hdr_pix);
+	}
 	int err = SPIFFS_close(handle(), file);
 	if(err < 0) {
 		res = Error::fromSystem(err);
@@ -656,6 +804,9 @@ int FileSystem::readdir(DirHandle dir, Stat& stat)
 		 */
 
 		auto name = (char*)e.name;
+		if(strcmp(name, indexFileName) == 0) {
+			continue;
+		}
 
 		// For sub-directories, match the parsing path
 		auto len = strlen(name);
@@ -745,6 +896,9 @@ int FileSystem::rename(const char* oldpath, const char* newpath)
 	}
 
 	int err = SPIFFS_rename(handle(), oldpath, newpath);
+	if(err >= 0) {
+		index.remove(ObjectIndex::hash(oldpath));
+	}
 	return Error::fromSystem(err);
 }
 
@@ -766,6 +920,7 @@ int FileSystem::remove(const char* path)
 		}
 	}
 
+	index.remove(ObjectIndex::hash(path));
 	int err = SPIFFS_remove(handle(), path);
 	err = Error::fromSystem(err);
 	debug_ifserr(err, "remove('%s')", path);
@@ -785,6 +940,10 @@ int FileSystem::fremove(FileHandle file)
 		return Error::ReadOnly;
 	}
 
+	auto fd = getDescriptor(file);
+	if(fd != nullptr) {
+		index.removeObject(fd->obj_id);
+	}
 	int err = SPIFFS_fremove(handle(), file);
 	return Error::fromSystem(err);
 }
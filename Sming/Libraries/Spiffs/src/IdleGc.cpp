@@ -0,0 +1,113 @@
+/**
+ * IdleGc.cpp
+ *
+ * Copyright 2019 mikee47 <mike@sillyhouse.net>
+ *
+ * This file is part of the SPIFFS IFS Library
+ *
+ * This library is free software: you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation, version 3 or later.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this library.
+ * If not, see <https://www.gnu.org/licenses/>.
+ *
+ ****/
+
+#include "include/IFS/SPIFFS/IdleGc.h"
+#include <Data/LinkedObjectList.h>
+#include <Platform/System.h>
+#include <Clock.h>
+#include <algorithm>
+
+namespace IFS
+{
+namespace SPIFFS
+{
+namespace
+{
+// Running services, so a queued task can tell if its service has since been stopped
+LinkedObjectListTemplate<IdleGc> active;
+
+} // namespace
+
+constexpr IdleGc::Config IdleGc::defaultConfig;
+
+void IdleGc::start(const Config& config)
+{
+	this->config = config;
+	lastInfo = {};
+	if(!isRunning()) {
+		active.insert(this);
+	}
+	timer.initializeMs(config.interval, timerCallback, this).start();
+}
+
+void IdleGc::stop()
+{
+	timer.stop();
+	active.remove(this);
+	pending = false;
+}
+
+bool IdleGc::isRequired()
+{
+	FileSystem::GcInfo info;
+	if(fs.getGcInfo(info) < 0 || info.deletedPages == 0 || info.totalPages == 0) {
+		return false;
+	}
+
+	// Last step achieved nothing, so wait until something changes
+	if(info.usedPages == lastInfo.usedPages && info.deletedPages == lastInfo.deletedPages &&
+	   info.freeBlocks == lastInfo.freeBlocks) {
+		return false;
+	}
+
+	return info.freePages() * 100 < info.totalPages * config.minFreePercent ||
+		   info.deletedPages * 100 >= info.totalPages * config.maxDeletedPercent;
+}
+
+void IdleGc::timerCallback(void* param)
+{
+	auto gc = static_cast<IdleGc*>(param);
+	if(gc->pending || !gc->isRequired()) {
+		return;
+	}
+	gc->pending = System.queueCallback(TaskPriority::Low, taskCallback, gc);
+}
+
+void IdleGc::taskCallback(void* param)
+{
+	for(auto& gc : active) {
+		if(&gc == param) {
+			gc.step();
+			break;
+		}
+	}
+}
+
+void IdleGc::step()
+{
+	pending = false;
+
+	auto startTime = micros();
+	int res = fs.gcStep(true);
+	stats.lastTime = micros() - startTime;
+	stats.maxTime = std::max(stats.maxTime, stats.lastTime);
+	++stats.steps;
+
+	if(res > 0) {
+		stats.blocks += res;
+		lastInfo = {};
+	} else {
+		fs.getGcInfo(lastInfo);
+	}
+
+	debug_d("[SPIFFS] GC step %d, %u us", res, stats.lastTime);
+}
+
+} // namespace SPIFFS
+} // namespace IFS
@@ -0,0 +1,167 @@
+/**
+ * ObjectIndex.cpp
+ *
+ * Copyright 2019 mikee47 <mike@sillyhouse.net>
+ *
+ * This file is part of the SPIFFS IFS Library
+ *
+ * This library is free software: you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation, version 3 or later.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this library.
+ * If not, see <https://www.gnu.org/licenses/>.
+ *
+ ****/
+
+#include "include/IFS/SPIFFS/ObjectIndex.h"
+#include <cstring>
+
+namespace IFS
+{
+namespace SPIFFS
+{
+namespace
+{
+constexpr uint32_t fnvBasis{2166136261U};
+
+uint32_t fnv1a(uint32_t hash, const void* data, size_t length)
+{
+	auto p = static_cast<const uint8_t*>(data);
+	while(length-- != 0) {
+		hash = (hash ^ *p++) * 16777619U;
+	}
+	return hash;
+}
+
+} // namespace
+
+uint32_t ObjectIndex::hash(const char* name)
+{
+	return fnv1a(fnvBasis, name, strlen(name));
+}
+
+ObjectIndex::Entry* ObjectIndex::findEntry(uint32_t hash)
+{
+	for(unsigned i = 0; i < count; ++i) {
+		if(entries[i].hash == hash) {
+			return &entries[i];
+		}
+	}
+	return nullptr;
+}
+
+const ObjectIndex::Entry* ObjectIndex::find(uint32_t hash) const
+{
+	return const_cast<ObjectIndex*>(this)->findEntry(hash);
+}
+
+void ObjectIndex::update(uint32_t hash, spiffs_obj_id objId, spiffs_page_ix pix)
+{
+	if(capacity == 0) {
+		return;
+	}
+
+	auto entry = findEntry(hash);
+	if(entry == nullptr) {
+		if(count < capacity) {
+			entry = &entries[count++];
+		} else {
+			entry = &entries[next];
+			if(++next == capacity) {
+				next = 0;
+			}
+		}
+	} else if(entry->objId == objId && entry->pix == pix) {
+		return;
+	}
+
+	*entry = Entry{hash, objId, pix};
+	++generation;
+}
+
+void ObjectIndex::updatePage(spiffs_obj_id objId, spiffs_page_ix pix)
+{
+	for(unsigned i = 0; i < count; ++i) {
+		auto& e = entries[i];
+		if(e.objId == objId) {
+			if(e.pix != pix) {
+				e.pix = pix;
+				++generation;
+			}
+			return;
+		}
+	}
+}
+
+void ObjectIndex::removeAt(unsigned i)
+{
+	--count;
+	entries[i] = entries[count];
+	if(next > count) {
+		next = 0;
+	}
+	++generation;
+}
+
+void ObjectIndex::remove(uint32_t hash)
+{
+	for(unsigned i = 0; i < count; ++i) {
+		if(entries[i].hash == hash) {
+			removeAt(i);
+			return;
+		}
+	}
+}
+
+void ObjectIndex::removeObject(spiffs_obj_id objId)
+{
+	for(unsigned i = 0; i < count; ++i) {
+		if(entries[i].objId == objId) {
+			removeAt(i);
+			return;
+		}
+	}
+}
+
+void ObjectIndex::clear()
+{
+	if(count != 0) {
+		count = next = 0;
+		++generation;
+	}
+}
+
+void ObjectIndex::getImage(Image& image)
+{
+	image = Image{};
+	image.magic = Image::Magic;
+	image.capacity = capacity;
+	image.count = count;
+	image.generation = generation;
+	image.entries = entries;
+	image.checksum = fnv1a(fnvBasis, image.entries.data(), count * sizeof(Entry));
+	savedGeneration = generation;
+}
+
+bool ObjectIndex::setImage(const Image& image)
+{
+	count = next = 0;
+
+	if(image.magic != Image::Magic || image.capacity != capacity || image.count > capacity ||
+	   image.checksum != fnv1a(fnvBasis, image.entries.data(), image.count * sizeof(Entry))) {
+		++generation;
+		return false;
+	}
+
+	entries = image.entries;
+	count = image.count;
+	generation = savedGeneration = image.generation;
+	return true;
+}
+
+} // namespace SPIFFS
+} // namespace IFS
@@ -37,12 +37,18 @@
  *  	Standard IFS truncate() method allows file size to be reduced.
  *  	This was added to Sming in version 4.
  *
+ *	Object index
+ *
+ *		Locations of recently opened files are cached so they may be re-opened
+ *		without scanning the whole volume. See ObjectIndex.
+ *
  */
 
 #pragma once
 
 #include <IFS/IFileSystem.h>
 #include "FileMeta.h"
+#include "ObjectIndex.h"
 #include "../../../../spiffs/src/spiffs.h"
 extern "C" {
 #include "../../../../spiffs/src/spiffs_nucleus.h"
@@ -102,6 +108,54 @@ public:
 	 */
 	int getFilePath(FileID fileid, NameBuffer& buffer);
 
+	/**
+	 * @brief Get object index statistics
+	 */
+	const ObjectIndex::Stats& getIndexStats() const
+	{
+		return index.getStats();
+	}
+
+	/**
+	 * @brief Write object index to volume if it has changed
+	 * @retval int error code
+	 * @note Called automatically on unmount. Requires SPIFFS_INDEX_PERSIST.
+	 */
+	int saveIndex();
+
+	/**
+	 * @brief Page usage relevant to garbage collection
+	 */
+	struct GcInfo {
+		uint32_t totalPages;   ///< Data pages on volume, excluding lookup pages
+		uint32_t usedPages;    ///< Pages holding live data
+		uint32_t deletedPages; ///< Pages which must be reclaimed by erasing their block
+		uint16_t blockCount;
+		uint16_t freeBlocks; ///< Fully erased blocks
+
+		uint32_t freePages() const
+		{
+			return totalPages - usedPages - deletedPages;
+		}
+	};
+
+	/**
+	 * @brief Get current page usage
+	 * @retval int error code
+	 */
+	int getGcInfo(GcInfo& info);
+
+	/**
+	 * @brief Perform a single, bounded step of garbage collection
+	 * @param compact If no block consists entirely of deleted pages, clean the best candidate block
+	 * by moving its live pages elsewhere. SPIFFS only does this when three or fewer free blocks remain,
+	 * which is when the next write would otherwise do it.
+	 * @retval int Number of blocks reclaimed (0 if there was nothing to do), or error code
+	 * @note At most one block is erased, except where SPIFFS has fewer than three free blocks
+	 * in which case it may clean several.
+	 */
+	int gcStep(bool compact);
+
 private:
 	spiffs* handle()
 	{
@@ -110,6 +164,23 @@ private:
 
 	int tryMount(spiffs_config& cfg);
 
+	/**
+	 * @brief Open file using object index if possible
+	 * @param path
+	 * @param hash Of path
+	 * @param sflags
+	 * @retval FileHandle
+	 */
+	FileHandle openIndexed(const char* path, uint32_t hash, spiffs_flags sflags);
+
+	/**
+	 * @brief Get SPIFFS descriptor for a file handle
+	 * @retval spiffs_fd* nullptr if handle is invalid
+	 */
+	spiffs_fd* getDescriptor(FileHandle file);
+
+	void loadIndex();
+
 	SpiffsMetaBuffer* initMetaBuffer(FileHandle file);
 	SpiffsMetaBuffer* getMetaBuffer(FileHandle file);
 	int flushMeta(FileHandle file);
@@ -139,6 +210,7 @@ private:
 	uint16_t workBuffer[LOG_PAGE_SIZE];
 	spiffs_fd fileDescriptors[SPIFF_FILEDESC_COUNT];
 	uint8_t cache[CACHE_SIZE];
+	ObjectIndex index;
 };
 
 } // namespace SPIFFS
@@ -0,0 +1,112 @@
+/**
+ * IdleGc.h
+ *
+ * Copyright 2019 mikee47 <mike@sillyhouse.net>
+ *
+ * This file is part of the SPIFFS IFS Library
+ *
+ * This library is free software: you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation, version 3 or later.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this library.
+ * If not, see <https://www.gnu.org/licenses/>.
+ *
+ ****/
+
+#pragma once
+
+#include "FileSystem.h"
+#include <SimpleTimer.h>
+#include <Data/LinkedObject.h>
+
+namespace IFS
+{
+namespace SPIFFS
+{
+/**
+ * @brief Performs SPIFFS garbage collection in the background
+ *
+ * SPIFFS reclaims deleted pages from within a write once free blocks run low,
+ * which can stall that write for hundreds of milliseconds.
+ *
+ * This service checks page usage periodically and, when thresholds are crossed, queues a
+ * low-priority task to perform a single `FileSystem::gcStep()`. Low-priority tasks only run
+ * once the normal and high priority queues are empty, so the work is done whilst the system
+ * is otherwise idle.
+ *
+ * Steps which reclaim nothing are not repeated until page usage changes.
+ * The filesystem must remain mounted for as long as the service is running.
+ */
+class IdleGc : public LinkedObjectTemplate<IdleGc>
+{
+public:
+	struct Config {
+		uint16_t interval;         ///< Check interval in milliseconds
+		uint8_t minFreePercent;    ///< Collect when free pages fall below this proportion
+		uint8_t maxDeletedPercent; ///< Collect when deleted pages reach this proportion
+	};
+
+	static constexpr Config defaultConfig{1000, 25, 10};
+
+	struct Stats {
+		uint32_t steps;    ///< Number of GC steps run
+		uint32_t blocks;   ///< Number of blocks reclaimed
+		uint32_t lastTime; ///< Duration of last step, in microseconds
+		uint32_t maxTime;  ///< Longest step, in microseconds
+	};
+
+	IdleGc(FileSystem& fs) : fs(fs)
+	{
+	}
+
+	~IdleGc()
+	{
+		stop();
+	}
+
+	/**
+	 * @brief Start checking the filesystem
+	 */
+	void start(const Config& config = defaultConfig);
+
+	void stop();
+
+	bool isRunning() const
+	{
+		return timer.isStarted();
+	}
+
+	/**
+	 * @brief Determine if page usage warrants garbage collection
+	 */
+	bool isRequired();
+
+	const Stats& getStats() const
+	{
+		return stats;
+	}
+
+	void resetStats()
+	{
+		stats = {};
+	}
+
+private:
+	static void timerCallback(void* param);
+	static void taskCallback(void* param);
+	void step();
+
+	FileSystem& fs;
+	SimpleTimer timer;
+	Config config{defaultConfig};
+	Stats stats{};
+	FileSystem::GcInfo lastInfo{}; ///< Page usage following an unproductive step
+	bool pending{false};
+};
+
+} // namespace SPIFFS
+} // namespace IFS
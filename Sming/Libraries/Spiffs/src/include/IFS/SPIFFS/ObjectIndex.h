@@ -0,0 +1,151 @@
+/**
+ * ObjectIndex.h
+ *
+ * Copyright 2019 mikee47 <mike@sillyhouse.net>
+ *
+ * This file is part of the SPIFFS IFS Library
+ *
+ * This library is free software: you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation, version 3 or later.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this library.
+ * If not, see <https://www.gnu.org/licenses/>.
+ *
+ ****/
+
+#pragma once
+
+#include "../../../../spiffs/src/spiffs.h"
+#include <array>
+
+#ifndef SPIFFS_INDEX_SIZE
+#define SPIFFS_INDEX_SIZE 16
+#endif
+
+#ifndef SPIFFS_INDEX_PERSIST
+#define SPIFFS_INDEX_PERSIST 0
+#endif
+
+static_assert(SPIFFS_INDEX_SIZE <= 255, "SPIFFS_INDEX_SIZE too large");
+
+namespace IFS
+{
+namespace SPIFFS
+{
+/**
+ * @brief Maps file names to the location of their object index header page
+ *
+ * Opening a file by name requires SPIFFS to scan the lookup table of every block,
+ * whereas opening by page reads only that page.
+ *
+ * Entries are hints only: pages move as files are written and during garbage collection,
+ * so the caller must confirm the file found is the one requested before using it.
+ */
+class ObjectIndex
+{
+public:
+	struct Entry {
+		uint32_t hash; ///< Of file name
+		spiffs_obj_id objId;
+		spiffs_page_ix pix; ///< Object index header page
+	};
+
+	struct Stats {
+		uint32_t hits;   ///< Opened directly by page
+		uint32_t misses; ///< Name not in index
+		uint32_t stale;  ///< Entry found but no longer valid
+	};
+
+	static constexpr size_t capacity{SPIFFS_INDEX_SIZE};
+
+	/**
+	 * @brief Persistent form of the index
+	 */
+	struct Image {
+		/// Identifies valid image, and changes if Entry layout changes
+		static constexpr uint32_t Magic{0x58494653 + sizeof(Entry)};
+
+		uint32_t magic;
+		uint8_t capacity;
+		uint8_t count;
+		uint16_t reserved;
+		uint32_t generation;
+		uint32_t checksum; ///< Over entries
+		std::array<Entry, SPIFFS_INDEX_SIZE> entries;
+	};
+
+	static uint32_t hash(const char* name);
+
+	/**
+	 * @brief Look up an entry by name hash
+	 * @retval Entry* nullptr if not found
+	 */
+	const Entry* find(uint32_t hash) const;
+
+	/**
+	 * @brief Add or replace an entry
+	 * @note When full, the oldest entry is replaced
+	 */
+	void update(uint32_t hash, spiffs_obj_id objId, spiffs_page_ix pix);
+
+	/**
+	 * @brief Record new header location for an object, if indexed
+	 */
+	void updatePage(spiffs_obj_id objId, spiffs_page_ix pix);
+
+	void remove(uint32_t hash);
+	void removeObject(spiffs_obj_id objId);
+	void clear();
+
+	/**
+	 * @brief Incremented whenever the index changes
+	 */
+	uint32_t getGeneration() const
+	{
+		return generation;
+	}
+
+	/**
+	 * @brief Determine if index has changed since last load or save
+	 */
+	bool isDirty() const
+	{
+		return generation != savedGeneration;
+	}
+
+	void getImage(Image& image);
+
+	/**
+	 * @brief Replace content with a previously saved image
+	 * @retval bool false if image is invalid, in which case the index is left empty
+	 */
+	bool setImage(const Image& image);
+
+	Stats& getStats()
+	{
+		return stats;
+	}
+
+	const Stats& getStats() const
+	{
+		return stats;
+	}
+
+private:
+	Entry* findEntry(uint32_t hash);
+	void removeAt(unsigned i);
+
+	std::array<Entry, capacity> entries;
+	uint8_t count{0};
+	uint8_t next{0}; ///< Candidate for replacement when full
+	uint32_t generation{0};
+	uint32_t savedGeneration{0};
+	Stats stats{};
+};
+
+} // namespace SPIFFS
+} // namespace IFS
@@ -0,0 +1,5 @@
+COMPONENT_SRCDIRS := src
+COMPONENT_INCDIRS := src
+COMPONENT_DEPENDS := Storage crypto
+
+COMPONENT_DOXYGEN_INPUT := src
@@ -0,0 +1,96 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/SmingHub/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * FileDigest.cpp
+ *
+ ****/
+
+#include "StorageHash/FileDigest.h"
+
+namespace StorageHash
+{
+FileDigest::FileDigest(const String& path, Storage::Partition fsPartition) : path(path), fsPartition(fsPartition)
+{
+	if(fsPartition) {
+		Storage::Device::addWriteObserver(*this);
+	}
+}
+
+FileDigest::~FileDigest()
+{
+	close();
+}
+
+void FileDigest::close()
+{
+	if(file >= 0) {
+		fileClose(file);
+		file = -1;
+	}
+}
+
+void FileDigest::onDeviceWrite(Storage::Device& device, uint32_t address, size_t size)
+{
+	if(&device != fsPartition.getDevice()) {
+		return;
+	}
+	uint32_t start = fsPartition.address();
+	if(address + size <= start || address >= start + fsPartition.size()) {
+		return;
+	}
+
+	valid = false;
+	// Any write during hashing may affect this file
+	close();
+}
+
+Job::Result FileDigest::step()
+{
+	if(file >= 0 && getProgress() == 0) {
+		// Job was cancelled and restarted
+		close();
+	}
+
+	if(file < 0) {
+		FileStat newStat;
+		if(fileStats(path, newStat) < 0) {
+			valid = false;
+			return Result::Error;
+		}
+		if(valid && newStat.size == stat.size && newStat.mtime == stat.mtime && newStat.id == stat.id) {
+			return Result::Done;
+		}
+
+		valid = false;
+		stat = newStat;
+		file = fileOpen(path);
+		if(file < 0) {
+			return Result::Error;
+		}
+		ctx.reset();
+		setTotal(stat.size);
+		setProgress(0);
+	}
+
+	uint8_t buffer[readChunkSize];
+	int len = fileRead(file, buffer, sizeof(buffer));
+	if(len < 0) {
+		close();
+		return Result::Error;
+	}
+	if(len > 0) {
+		ctx.update(buffer, len);
+		setProgress(getProgress() + len);
+		return Result::More;
+	}
+
+	close();
+	digest = ctx.getHash();
+	valid = true;
+	return Result::Done;
+}
+
+} // namespace StorageHash
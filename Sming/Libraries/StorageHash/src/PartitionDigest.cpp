@@ -0,0 +1,186 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/SmingHub/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * PartitionDigest.cpp
+ *
+ ****/
+
+#include "StorageHash/PartitionDigest.h"
+#include <algorithm>
+
+namespace StorageHash
+{
+PartitionDigest::PartitionDigest(Storage::Partition partition, uint32_t offset, size_t size, size_t leafSize)
+	: partition(partition), offset(offset), size(size), leafSize(leafSize)
+{
+	auto partSize = partition.size();
+	if(offset > partSize) {
+		this->offset = partSize;
+	}
+	if(size == 0 || size > partSize - this->offset) {
+		this->size = partSize - this->offset;
+	}
+
+	if(leafSize != 0) {
+		leafCount = (this->size + leafSize - 1) / leafSize;
+		leaves.reset(new Digest[leafCount]);
+		auto words = (leafCount + 31) / 32;
+		dirty.reset(new uint32_t[words]);
+		std::fill_n(dirty.get(), words, 0xffffffffU);
+	}
+
+	Storage::Device::addWriteObserver(*this);
+}
+
+const Digest* PartitionDigest::getLeafDigest(unsigned index) const
+{
+	if(index >= leafCount || isDirty(index)) {
+		return nullptr;
+	}
+	return &leaves[index];
+}
+
+void PartitionDigest::invalidate()
+{
+	valid = false;
+	inProgress = false;
+	currentLeaf = -1;
+	for(unsigned i = 0; i < leafCount; ++i) {
+		setDirty(i);
+	}
+}
+
+void PartitionDigest::onDeviceWrite(Storage::Device& device, uint32_t address, size_t size)
+{
+	if(&device != partition.getDevice()) {
+		return;
+	}
+
+	uint32_t regionStart = partition.address() + offset;
+	uint32_t regionEnd = regionStart + this->size;
+	uint32_t writeEnd = address + size;
+	if(writeEnd <= regionStart || address >= regionEnd) {
+		return;
+	}
+
+	valid = false;
+
+	if(leafCount == 0) {
+		// Restart from the beginning on next step
+		inProgress = false;
+		return;
+	}
+
+	unsigned first = (std::max(address, regionStart) - regionStart) / leafSize;
+	unsigned last = (std::min(writeEnd, regionEnd) - 1 - regionStart) / leafSize;
+	for(unsigned i = first; i <= last; ++i) {
+		setDirty(i);
+	}
+	if(currentLeaf >= int(first) && currentLeaf <= int(last)) {
+		// Leaf is part-hashed, so start it again
+		currentLeaf = -1;
+	}
+}
+
+bool PartitionDigest::hashChunk(uint32_t end)
+{
+	uint8_t buffer[readChunkSize];
+	auto len = std::min(size_t(end - position), sizeof(buffer));
+	if(!partition.read(offset + position, buffer, len)) {
+		inProgress = false;
+		return false;
+	}
+	ctx.update(buffer, len);
+	position += len;
+	return true;
+}
+
+Job::Result PartitionDigest::step()
+{
+	return (leafCount == 0) ? stepFlat() : stepTree();
+}
+
+Job::Result PartitionDigest::stepFlat()
+{
+	if(!inProgress) {
+		if(valid) {
+			return Result::Done;
+		}
+		ctx.reset();
+		position = 0;
+		inProgress = true;
+		setTotal(size);
+		setProgress(0);
+	}
+
+	if(position < size) {
+		if(!hashChunk(size)) {
+			return Result::Error;
+		}
+		setProgress(position);
+		return Result::More;
+	}
+
+	digest = ctx.getHash();
+	inProgress = false;
+	valid = true;
+	return Result::Done;
+}
+
+Job::Result PartitionDigest::stepTree()
+{
+	if(!inProgress) {
+		if(valid) {
+			return Result::Done;
+		}
+		inProgress = true;
+		currentLeaf = -1;
+		leavesHashed = 0;
+		unsigned dirtyCount{0};
+		for(unsigned i = 0; i < leafCount; ++i) {
+			dirtyCount += isDirty(i);
+		}
+		setTotal(dirtyCount);
+		setProgress(0);
+	}
+
+	if(currentLeaf < 0) {
+		unsigned leaf = 0;
+		while(leaf < leafCount && !isDirty(leaf)) {
+			++leaf;
+		}
+
+		if(leaf == leafCount) {
+			ctx.reset();
+			ctx.update(leaves.get(), leafCount * sizeof(Digest));
+			digest = ctx.getHash();
+			inProgress = false;
+			valid = true;
+			return Result::Done;
+		}
+
+		currentLeaf = leaf;
+		position = leaf * leafSize;
+		ctx.reset();
+	}
+
+	uint32_t leafEnd = std::min((currentLeaf + 1) * leafSize, size);
+	if(!hashChunk(leafEnd)) {
+		return Result::Error;
+	}
+
+	if(position == leafEnd) {
+		leaves[currentLeaf] = ctx.getHash();
+		clearDirty(currentLeaf);
+		currentLeaf = -1;
+		++leavesHashed;
+		setProgress(leavesHashed);
+	}
+
+	return Result::More;
+}
+
+} // namespace StorageHash
@@ -0,0 +1,27 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/SmingHub/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * Digest.h
+ *
+ ****/
+
+#pragma once
+
+#include <Crypto/Sha2.h>
+
+namespace StorageHash
+{
+/**
+ * @brief All digests are SHA-256
+ */
+using Digest = Crypto::Sha256::Hash;
+
+/**
+ * @brief Amount of data read and hashed in each job step
+ */
+constexpr size_t readChunkSize{512};
+
+} // namespace StorageHash
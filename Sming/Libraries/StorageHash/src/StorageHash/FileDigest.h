@@ -0,0 +1,87 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/SmingHub/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * FileDigest.h
+ *
+ ****/
+
+#pragma once
+
+#include "Digest.h"
+#include <Storage/Partition.h>
+#include <Storage/Device.h>
+#include <FileSystem.h>
+#include <Job.h>
+
+namespace StorageHash
+{
+/**
+ * @brief Cached SHA-256 digest of a file, computed as a background job
+ *
+ * The file's size, modification time and ID are recorded with the digest.
+ * Starting the job when these are unchanged completes immediately.
+ *
+ * Modification times typically have a resolution of one second, so a file rewritten with the same size
+ * may not be detected. Pass the partition holding the filesystem to the constructor to guard against this:
+ * any write to that partition then causes the file to be hashed again.
+ * Sectors cannot be related to individual files, so this is conservative.
+ */
+class FileDigest : public Job, private Storage::WriteObserver
+{
+public:
+	/**
+	 * @brief Constructor
+	 * @param path File to hash, using the global filesystem
+	 * @param fsPartition Optional partition containing the filesystem
+	 */
+	FileDigest(const String& path, Storage::Partition fsPartition = {});
+
+	~FileDigest();
+
+	/**
+	 * @brief Determine if the digest was computed and no change has since been detected
+	 * @note A change to the file is only detected when the job is next run
+	 */
+	bool isValid() const
+	{
+		return valid;
+	}
+
+	const Digest& getDigest() const
+	{
+		return digest;
+	}
+
+	const String& getPath() const
+	{
+		return path;
+	}
+
+	/**
+	 * @brief Discard the cached digest so it is recomputed
+	 */
+	void invalidate()
+	{
+		valid = false;
+	}
+
+protected:
+	Result step() override;
+
+private:
+	void onDeviceWrite(Storage::Device& device, uint32_t address, size_t size) override;
+	void close();
+
+	String path;
+	Storage::Partition fsPartition;
+	Crypto::Sha256 ctx;
+	Digest digest{};
+	FileStat stat{};
+	FileHandle file{-1};
+	bool valid{false};
+};
+
+} // namespace StorageHash
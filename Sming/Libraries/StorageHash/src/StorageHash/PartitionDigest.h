@@ -0,0 +1,132 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/SmingHub/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * PartitionDigest.h
+ *
+ ****/
+
+#pragma once
+
+#include "Digest.h"
+#include <Storage/Partition.h>
+#include <Storage/Device.h>
+#include <Job.h>
+#include <memory>
+
+namespace StorageHash
+{
+/**
+ * @brief Cached SHA-256 digest of a partition region, computed as a background job
+ *
+ * The digest remains valid until the region is written or erased through any Partition
+ * on the same device, or invalidate() is called. Starting the job when the digest is valid
+ * completes immediately.
+ *
+ * With a `leafSize` of zero the digest is a plain SHA-256 of the region, and any change
+ * requires the whole region to be hashed again.
+ *
+ * Otherwise the region is divided into leaves of `leafSize` bytes, each with its own digest.
+ * The overall digest is the SHA-256 of the leaf digests, concatenated in order.
+ * Only leaves affected by a change are hashed again. Each leaf requires 32 bytes of RAM.
+ */
+class PartitionDigest : public Job, private Storage::WriteObserver
+{
+public:
+	/**
+	 * @brief Constructor
+	 * @param partition
+	 * @param offset Start of region within partition
+	 * @param size Size of region in bytes, 0 for the rest of the partition
+	 * @param leafSize 0 for a single digest, otherwise size of each leaf in bytes
+	 */
+	PartitionDigest(Storage::Partition partition, uint32_t offset = 0, size_t size = 0, size_t leafSize = 0);
+
+	/**
+	 * @brief Determine if getDigest() reflects current content of the region
+	 */
+	bool isValid() const
+	{
+		return valid;
+	}
+
+	/**
+	 * @brief Get the computed digest
+	 * @note Only meaningful if isValid() returns true
+	 */
+	const Digest& getDigest() const
+	{
+		return digest;
+	}
+
+	/**
+	 * @brief Number of leaves, 0 if not using a digest tree
+	 */
+	unsigned getLeafCount() const
+	{
+		return leafCount;
+	}
+
+	/**
+	 * @brief Get digest for a leaf
+	 * @retval const Digest* nullptr if index is invalid or the leaf has changed since it was hashed
+	 */
+	const Digest* getLeafDigest(unsigned index) const;
+
+	/**
+	 * @brief Get number of leaves hashed by the last computation
+	 */
+	unsigned getLeavesHashed() const
+	{
+		return leavesHashed;
+	}
+
+	/**
+	 * @brief Discard the cached digest so it is recomputed in full
+	 */
+	void invalidate();
+
+protected:
+	Result step() override;
+
+private:
+	void onDeviceWrite(Storage::Device& device, uint32_t address, size_t size) override;
+
+	bool isDirty(unsigned leaf) const
+	{
+		return dirty[leaf / 32] & (1U << (leaf % 32));
+	}
+
+	void setDirty(unsigned leaf)
+	{
+		dirty[leaf / 32] |= 1U << (leaf % 32);
+	}
+
+	void clearDirty(unsigned leaf)
+	{
+		dirty[leaf / 32] &= ~(1U << (leaf % 32));
+	}
+
+	Result stepFlat();
+	Result stepTree();
+	bool hashChunk(uint32_t end);
+
+	Storage::Partition partition;
+	uint32_t offset;
+	size_t size;
+	size_t leafSize;
+	unsigned leafCount{0};
+	std::unique_ptr<Digest[]> leaves;
+	std::unique_ptr<uint32_t[]> dirty;
+	Crypto::Sha256 ctx;
+	Digest digest{};
+	uint32_t position{0};	///< Current read position within region
+	int currentLeaf{-1};	 ///< Leaf being hashed, -1 if none
+	unsigned leavesHashed{0};
+	bool inProgress{false};
+	bool valid{false};
+};
+
+} // namespace StorageHash
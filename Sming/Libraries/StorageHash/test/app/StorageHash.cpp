@@ -0,0 +1,184 @@
+#include <SmingTest.h>
+#include <StorageHash/PartitionDigest.h>
+#include <Storage/CustomDevice.h>
+
+using namespace StorageHash;
+
+namespace
+{
+/*
+ * RAM-backed device
+ */
+class RamDevice : public Storage::CustomDevice
+{
+public:
+	static constexpr size_t size{8192};
+	static constexpr size_t blockSize{512};
+
+	RamDevice()
+	{
+		for(unsigned i = 0; i < size; ++i) {
+			data[i] = i * 7;
+		}
+	}
+
+	String getName() const override
+	{
+		return F("ramDevice");
+	}
+
+	size_t getBlockSize() const override
+	{
+		return blockSize;
+	}
+
+	size_t getSize() const override
+	{
+		return size;
+	}
+
+	Type getType() const override
+	{
+		return Type::sysmem;
+	}
+
+	bool read(uint32_t address, void* dst, size_t len) override
+	{
+		if(address + len > size) {
+			return false;
+		}
+		memcpy(dst, &data[address], len);
+		return true;
+	}
+
+	bool write(uint32_t address, const void* src, size_t len) override
+	{
+		if(address + len > size) {
+			return false;
+		}
+		memcpy(&data[address], src, len);
+		return true;
+	}
+
+	bool erase_range(uint32_t address, size_t len) override
+	{
+		if(address + len > size) {
+			return false;
+		}
+		memset(&data[address], 0xff, len);
+		return true;
+	}
+
+	uint8_t data[size];
+};
+
+/*
+ * Run job steps synchronously
+ */
+class TestDigest : public PartitionDigest
+{
+public:
+	using PartitionDigest::PartitionDigest;
+	using PartitionDigest::step;
+
+	Result run()
+	{
+		Result res;
+		while((res = step()) == Result::More) {
+		}
+		return res;
+	}
+};
+
+} // namespace
+
+class StorageHashTest : public TestGroup
+{
+public:
+	StorageHashTest() : TestGroup(_F("StorageHash"))
+	{
+	}
+
+	void execute() override
+	{
+		RamDevice dev;
+		auto part = dev.createPartition(F("data"), Storage::Partition::Type::data, 0x91, 0, dev.size);
+
+		TEST_CASE("Flat digest")
+		{
+			TestDigest digest(part, 1000, 5000);
+			REQUIRE(!digest.isValid());
+			REQUIRE(digest.run() == Job::Result::Done);
+			REQUIRE(digest.isValid());
+			REQUIRE(digest.getDigest() == Crypto::Sha256().calculate(&dev.data[1000], 5000));
+
+			// Write outside region
+			uint8_t value{0x55};
+			part.write(0, &value, 1);
+			part.write(6000, &value, 1);
+			REQUIRE(digest.isValid());
+
+			// Write inside region
+			part.write(5999, &value, 1);
+			REQUIRE(!digest.isValid());
+			REQUIRE(digest.run() == Job::Result::Done);
+			REQUIRE(digest.getDigest() == Crypto::Sha256().calculate(&dev.data[1000], 5000));
+		}
+
+		TEST_CASE("Digest tree")
+		{
+			constexpr size_t leafSize{1024};
+			TestDigest digest(part, 0, 0, leafSize);
+			REQUIRE_EQ(digest.getLeafCount(), dev.size / leafSize);
+			REQUIRE(digest.run() == Job::Result::Done);
+			REQUIRE_EQ(digest.getLeavesHashed(), digest.getLeafCount());
+
+			auto check = [&]() {
+				Crypto::Sha256 root;
+				for(unsigned i = 0; i < digest.getLeafCount(); ++i) {
+					auto leaf = Crypto::Sha256().calculate(&dev.data[i * leafSize], leafSize);
+					auto cached = digest.getLeafDigest(i);
+					REQUIRE(cached != nullptr);
+					REQUIRE(*cached == leaf);
+					root.update(leaf);
+				}
+				REQUIRE(digest.getDigest() == root.getHash());
+			};
+			check();
+
+			// Erase spanning two leaves
+			part.erase_range(3000, 1500);
+			REQUIRE(!digest.isValid());
+			REQUIRE(digest.getLeafDigest(1) != nullptr);
+			REQUIRE(digest.getLeafDigest(2) == nullptr);
+			REQUIRE(digest.getLeafDigest(4) == nullptr);
+			REQUIRE(digest.run() == Job::Result::Done);
+			REQUIRE_EQ(digest.getLeavesHashed(), 3);
+			check();
+
+			// Running again does nothing
+			REQUIRE(digest.run() == Job::Result::Done);
+			REQUIRE_EQ(digest.getLeavesHashed(), 3);
+
+			digest.invalidate();
+			REQUIRE(digest.run() == Job::Result::Done);
+			REQUIRE_EQ(digest.getLeavesHashed(), digest.getLeafCount());
+		}
+
+		TEST_CASE("Change during hashing")
+		{
+			TestDigest digest(part, 0, 0, 2048);
+			// Hash first chunk of leaf 0
+			REQUIRE(digest.step() == Job::Result::More);
+			uint8_t value{0xaa};
+			part.write(100, &value, 1);
+			REQUIRE(digest.run() == Job::Result::Done);
+			REQUIRE(*digest.getLeafDigest(0) == Crypto::Sha256().calculate(dev.data, 2048));
+		}
+	}
+};
+
+void REGISTER_TEST(StorageHash)
+{
+	registerGroup<StorageHashTest>();
+}
@@ -0,0 +1,13 @@
+COMPONENT_DEPENDS := \
+	Adafruit_GFX \
+	SPI
+
+COMPONENT_SRCDIRS := src
+COMPONENT_INCDIRS := src
+
+COMPONENT_DOXYGEN_INPUT := src
+
+# Maximum number of dirty rectangles tracked
+COMPONENT_VARS += DIRTY_REGION_MAX_RECTS
+DIRTY_REGION_MAX_RECTS ?= 8
+GLOBAL_CFLAGS += -DDIRTY_REGION_MAX_RECTS=$(DIRTY_REGION_MAX_RECTS)
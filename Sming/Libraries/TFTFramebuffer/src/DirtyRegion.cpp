@@ -0,0 +1,75 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/SmingHub/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * DirtyRegion.cpp
+ *
+ ****/
+
+#include "DirtyRegion.h"
+#include <algorithm>
+
+void DirtyRegion::add(const Rect& rect)
+{
+	Rect r = rect;
+
+	for(;;) {
+		unsigned best{rectCount};
+		uint32_t bestWaste{UINT32_MAX};
+		for(unsigned i = 0; i < rectCount; ++i) {
+			auto& existing = rects[i];
+			if(existing.contains(r)) {
+				return;
+			}
+			auto w = existing.intersects(r) ? 0 : waste(existing, r);
+			if(w < bestWaste) {
+				best = i;
+				bestWaste = w;
+			}
+		}
+
+		if(best == rectCount || (bestWaste > mergeThreshold && rectCount < maxRects)) {
+			break;
+		}
+
+		// The combined area may now overlap others, so go round again
+		r = combine(rects[best], r);
+		remove(best);
+	}
+
+	rects[rectCount++] = r;
+}
+
+uint32_t DirtyRegion::area() const
+{
+	uint32_t total{0};
+	for(unsigned i = 0; i < rectCount; ++i) {
+		total += rects[i].area();
+	}
+	return total;
+}
+
+DirtyRegion::Rect DirtyRegion::combine(const Rect& a, const Rect& b)
+{
+	uint16_t x = std::min(a.x, b.x);
+	uint16_t y = std::min(a.y, b.y);
+	uint16_t w = std::max(a.right(), b.right()) - x;
+	uint16_t h = std::max(a.bottom(), b.bottom()) - y;
+	return Rect{x, y, w, h};
+}
+
+/*
+ * Number of unchanged pixels which would be sent if non-overlapping rectangles were combined
+ */
+uint32_t DirtyRegion::waste(const Rect& a, const Rect& b)
+{
+	return combine(a, b).area() - a.area() - b.area();
+}
+
+void DirtyRegion::remove(unsigned index)
+{
+	--rectCount;
+	std::copy(&rects[index + 1], &rects[rectCount + 1], &rects[index]);
+}
@@ -0,0 +1,115 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/SmingHub/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * DirtyRegion.h - Track changed areas of a framebuffer as a small set of rectangles
+ *
+ ****/
+
+#pragma once
+
+#include <cstdint>
+
+/**
+ * @brief Maximum number of separate rectangles tracked before they are forcibly merged
+ */
+#ifndef DIRTY_REGION_MAX_RECTS
+#define DIRTY_REGION_MAX_RECTS 8
+#endif
+
+/**
+ * @brief Collects updated areas as a list of non-overlapping rectangles
+ *
+ * Each rectangle costs a window setup when flushed, so a new area is merged with an existing one
+ * if the combined bounding box adds no more than `mergeThreshold` unchanged pixels.
+ * Overlapping areas are always merged. When the list is full, the new area is merged with whichever
+ * rectangle wastes least.
+ */
+class DirtyRegion
+{
+public:
+	struct Rect {
+		uint16_t x;
+		uint16_t y;
+		uint16_t w;
+		uint16_t h;
+
+		uint16_t right() const
+		{
+			return x + w;
+		}
+
+		uint16_t bottom() const
+		{
+			return y + h;
+		}
+
+		uint32_t area() const
+		{
+			return uint32_t(w) * h;
+		}
+
+		bool intersects(const Rect& r) const
+		{
+			return r.x < right() && x < r.right() && r.y < bottom() && y < r.bottom();
+		}
+
+		bool contains(const Rect& r) const
+		{
+			return r.x >= x && r.y >= y && r.right() <= right() && r.bottom() <= bottom();
+		}
+
+		bool operator==(const Rect& r) const
+		{
+			return x == r.x && y == r.y && w == r.w && h == r.h;
+		}
+	};
+
+	static constexpr unsigned maxRects{DIRTY_REGION_MAX_RECTS};
+
+	/**
+	 * @brief Merging costs less than a separate window of this many pixels
+	 */
+	static constexpr uint32_t mergeThreshold{64};
+
+	/**
+	 * @brief Add an area
+	 * @param rect Must be non-empty and already clipped to the framebuffer
+	 */
+	void add(const Rect& rect);
+
+	void clear()
+	{
+		rectCount = 0;
+	}
+
+	bool isEmpty() const
+	{
+		return rectCount == 0;
+	}
+
+	unsigned count() const
+	{
+		return rectCount;
+	}
+
+	const Rect& operator[](unsigned index) const
+	{
+		return rects[index];
+	}
+
+	/**
+	 * @brief Get total number of pixels covered
+	 */
+	uint32_t area() const;
+
+private:
+	static Rect combine(const Rect& a, const Rect& b);
+	static uint32_t waste(const Rect& a, const Rect& b);
+	void remove(unsigned index);
+
+	Rect rects[maxRects];
+	uint8_t rectCount{0};
+};
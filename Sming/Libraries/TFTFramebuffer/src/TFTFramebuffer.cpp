@@ -0,0 +1,304 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/SmingHub/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * TFTFramebuffer.cpp
+ *
+ ****/
+
+#include "TFTFramebuffer.h"
+#include <Digital.h>
+#include <Platform/System.h>
+#include <algorithm>
+
+namespace
+{
+// MIPI DCS commands
+constexpr uint8_t CMD_CASET{0x2A};
+constexpr uint8_t CMD_RASET{0x2B};
+constexpr uint8_t CMD_RAMWR{0x2C};
+
+__forceinline uint16_t swapBytes(uint16_t value)
+{
+	return __builtin_bswap16(value);
+}
+
+} // namespace
+
+bool TFTFramebuffer::begin(const SPISettings& settings, Buffering buffering, uint16_t originX, uint16_t originY)
+{
+	end();
+
+	size_t pixelCount = size_t(WIDTH) * HEIGHT;
+	memory = new uint16_t[pixelCount * (buffering == Buffering::Double ? 2 : 1)];
+	if(memory == nullptr) {
+		return false;
+	}
+	drawBuffer = memory;
+	sendBuffer = (buffering == Buffering::Double) ? &memory[pixelCount] : memory;
+	std::fill_n(memory, (sendBuffer == drawBuffer) ? pixelCount : 2 * pixelCount, 0);
+
+	this->settings = settings;
+	this->originX = originX;
+	this->originY = originY;
+
+	transaction.callback = transferComplete;
+	transaction.param = this;
+
+	pinMode(csPin, OUTPUT);
+	pinMode(dcPin, OUTPUT);
+	digitalWrite(csPin, HIGH);
+
+	invalidate();
+	return true;
+}
+
+void TFTFramebuffer::end()
+{
+	if(memory == nullptr) {
+		return;
+	}
+
+	wait();
+	delete[] memory;
+	memory = drawBuffer = sendBuffer = nullptr;
+	dirty.clear();
+}
+
+void TFTFramebuffer::fillRaw(uint16_t x, uint16_t y, uint16_t w, uint16_t h, uint16_t color)
+{
+	if(drawBuffer == nullptr) {
+		return;
+	}
+
+	color = swapBytes(color);
+	auto row = &drawBuffer[y * WIDTH + x];
+	for(unsigned i = 0; i < h; ++i, row += WIDTH) {
+		std::fill_n(row, w, color);
+	}
+	markDirty(x, y, w, h);
+}
+
+void TFTFramebuffer::fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color)
+{
+	// Clip in rotated coordinates
+	if(w < 0) {
+		x += w + 1;
+		w = -w;
+	}
+	if(h < 0) {
+		y += h + 1;
+		h = -h;
+	}
+	if(x < 0) {
+		w += x;
+		x = 0;
+	}
+	if(y < 0) {
+		h += y;
+		y = 0;
+	}
+	w = std::min(w, int16_t(_width - x));
+	h = std::min(h, int16_t(_height - y));
+	if(w <= 0 || h <= 0) {
+		return;
+	}
+
+	// Map to buffer coordinates
+	switch(getRotation()) {
+	case 1:
+		fillRaw(WIDTH - (y + h), x, h, w, color);
+		break;
+	case 2:
+		fillRaw(WIDTH - (x + w), HEIGHT - (y + h), w, h, color);
+		break;
+	case 3:
+		fillRaw(y, HEIGHT - (x + w), h, w, color);
+		break;
+	default:
+		fillRaw(x, y, w, h, color);
+	}
+}
+
+void TFTFramebuffer::drawPixel(int16_t x, int16_t y, uint16_t color)
+{
+	fillRect(x, y, 1, 1, color);
+}
+
+void TFTFramebuffer::drawFastVLine(int16_t x, int16_t y, int16_t h, uint16_t color)
+{
+	fillRect(x, y, 1, h, color);
+}
+
+void TFTFramebuffer::drawFastHLine(int16_t x, int16_t y, int16_t w, uint16_t color)
+{
+	fillRect(x, y, w, 1, color);
+}
+
+void TFTFramebuffer::fillScreen(uint16_t color)
+{
+	fillRaw(0, 0, WIDTH, HEIGHT, color);
+}
+
+uint16_t TFTFramebuffer::getPixel(int16_t x, int16_t y) const
+{
+	if(drawBuffer == nullptr || x < 0 || y < 0 || x >= _width || y >= _height) {
+		return 0;
+	}
+
+	int16_t t;
+	switch(getRotation()) {
+	case 1:
+		t = x;
+		x = WIDTH - 1 - y;
+		y = t;
+		break;
+	case 2:
+		x = WIDTH - 1 - x;
+		y = HEIGHT - 1 - y;
+		break;
+	case 3:
+		t = x;
+		x = y;
+		y = HEIGHT - 1 - t;
+		break;
+	}
+
+	return swapBytes(drawBuffer[y * WIDTH + x]);
+}
+
+void TFTFramebuffer::markDirty(uint16_t x, uint16_t y, uint16_t w, uint16_t h)
+{
+	if(x >= WIDTH || y >= HEIGHT) {
+		return;
+	}
+	w = std::min(w, uint16_t(WIDTH - x));
+	h = std::min(h, uint16_t(HEIGHT - y));
+	if(w == 0 || h == 0) {
+		return;
+	}
+	dirty.add({x, y, w, h});
+}
+
+bool TFTFramebuffer::flush()
+{
+	wait();
+
+	if(drawBuffer == nullptr || dirty.isEmpty()) {
+		return false;
+	}
+
+	if(sendBuffer != drawBuffer) {
+		std::swap(drawBuffer, sendBuffer);
+		// New drawing buffer is out of date only where the frame just completed was changed
+		for(unsigned i = 0; i < dirty.count(); ++i) {
+			copyRect(drawBuffer, sendBuffer, dirty[i]);
+		}
+	}
+
+	flushArea = dirty;
+	dirty.clear();
+	rectIndex = 0;
+	flushing = true;
+	startRect();
+	return true;
+}
+
+void TFTFramebuffer::wait()
+{
+	while(flushing) {
+		// Completion is signalled from interrupt context, so the next rectangle may need starting from here
+		service();
+	}
+}
+
+void TFTFramebuffer::copyRect(uint16_t* dst, const uint16_t* src, const DirtyRegion::Rect& rect)
+{
+	size_t offset = rect.y * WIDTH + rect.x;
+	if(rect.w == WIDTH) {
+		std::copy_n(&src[offset], rect.area(), &dst[offset]);
+		return;
+	}
+	for(unsigned i = 0; i < rect.h; ++i, offset += WIDTH) {
+		std::copy_n(&src[offset], rect.w, &dst[offset]);
+	}
+}
+
+/*
+ * Window commands are short so are sent synchronously. Chip select is left asserted for the pixel data.
+ */
+void TFTFramebuffer::setWindow(const DirtyRegion::Rect& rect)
+{
+	auto sendCommand = [&](uint8_t cmd, uint16_t start, uint16_t end) {
+		digitalWrite(dcPin, LOW);
+		spi.transfer(cmd);
+		digitalWrite(dcPin, HIGH);
+		spi.transfer16(start);
+		spi.transfer16(end);
+	};
+
+	spi.beginTransaction(settings);
+	digitalWrite(csPin, LOW);
+	sendCommand(CMD_CASET, originX + rect.x, originX + rect.right() - 1);
+	sendCommand(CMD_RASET, originY + rect.y, originY + rect.bottom() - 1);
+	digitalWrite(dcPin, LOW);
+	spi.transfer(CMD_RAMWR);
+	digitalWrite(dcPin, HIGH);
+	spi.endTransaction();
+}
+
+void TFTFramebuffer::startRect()
+{
+	auto& rect = flushArea[rectIndex];
+	setWindow(rect);
+
+	transaction.txData = &sendBuffer[rect.y * WIDTH + rect.x];
+	if(rect.w == WIDTH) {
+		// Rows are contiguous
+		transaction.length = rect.area() * 2;
+		rowsRemaining = 0;
+	} else {
+		transaction.length = rect.w * 2;
+		rowsRemaining = rect.h - 1;
+	}
+	rectDone = false;
+	spi.queue(transaction);
+}
+
+void TFTFramebuffer::transferComplete(SpiTransaction& trans)
+{
+	auto self = static_cast<TFTFramebuffer*>(trans.param);
+
+	if(self->rowsRemaining != 0) {
+		--self->rowsRemaining;
+		trans.txData = static_cast<const uint16_t*>(trans.txData) + self->WIDTH;
+		self->spi.queue(trans);
+		return;
+	}
+
+	digitalSetMask(BIT(self->csPin));
+	self->rectDone = true;
+	System.queueCallback(taskCallback, self);
+}
+
+void TFTFramebuffer::taskCallback(void* param)
+{
+	static_cast<TFTFramebuffer*>(param)->service();
+}
+
+void TFTFramebuffer::service()
+{
+	if(!rectDone) {
+		return;
+	}
+	rectDone = false;
+
+	++rectIndex;
+	if(rectIndex < flushArea.count()) {
+		startRect();
+	} else {
+		flushing = false;
+	}
+}
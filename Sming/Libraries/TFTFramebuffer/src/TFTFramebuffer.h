@@ -0,0 +1,178 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/SmingHub/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * TFTFramebuffer.h - RAM framebuffer for SPI TFT displays with dirty-rectangle flushing
+ *
+ ****/
+
+#pragma once
+
+#include <Adafruit_GFX.h>
+#include <SPI.h>
+#include "DirtyRegion.h"
+
+/**
+ * @brief Draw into RAM and send only changed areas to an SPI TFT display
+ *
+ * Works with any controller using the standard MIPI DCS commands for column address (0x2A),
+ * page address (0x2B) and memory write (0x2C), which includes the ILI9341, ST7735 and ILI9163C.
+ * The display driver is used only to initialise the panel and set its orientation:
+ *
+ * 		Adafruit_ILI9341 tft(TFT_CS_PIN, TFT_DC_PIN);
+ * 		TFTFramebuffer fb(320, 240, TFT_CS_PIN, TFT_DC_PIN);
+ *
+ * 		tft.begin();
+ * 		tft.setRotation(1);
+ * 		fb.begin(SPISettings(40000000, MSBFIRST, SPI_MODE0));
+ * 		fb.fillScreen(ILI9341_BLACK);
+ * 		...
+ * 		fb.flush();
+ *
+ * Each drawing operation records the area it touched. flush() sends each resulting rectangle
+ * using one window setup followed by a background SPI transfer of its pixel rows.
+ * Full-width rectangles are sent as a single transfer.
+ *
+ * With Buffering::Double, flush() exchanges buffers so the next frame may be drawn whilst the
+ * previous one is sent. Areas changed in the previous frame are first copied into the new buffer.
+ * With Buffering::Single, call wait() before drawing again to avoid tearing.
+ *
+ * The framebuffer need not cover the whole display: use begin() with an origin to place it.
+ * The origin should also include any panel memory offset, as required for some ST7735 modules.
+ *
+ * Memory required is `width * height * 2` bytes per buffer.
+ */
+class TFTFramebuffer : public Adafruit_GFX
+{
+public:
+	enum class Buffering {
+		Single,
+		Double,
+	};
+
+	/**
+	 * @brief Constructor
+	 * @param width Framebuffer width, normally display width after rotation
+	 * @param height Framebuffer height
+	 * @param csPin Display chip select, 0-31
+	 * @param dcPin Display data/command select
+	 * @param spi Bus the display is connected to
+	 */
+	TFTFramebuffer(uint16_t width, uint16_t height, uint8_t csPin, uint8_t dcPin, SPIClass& spi = SPI)
+		: Adafruit_GFX(width, height), spi(spi), csPin(csPin), dcPin(dcPin)
+	{
+	}
+
+	~TFTFramebuffer()
+	{
+		end();
+	}
+
+	/**
+	 * @brief Allocate buffers and prepare for output
+	 * @param settings SPI settings for pixel transfers
+	 * @param buffering
+	 * @param originX Display column corresponding to framebuffer x = 0
+	 * @param originY Display row corresponding to framebuffer y = 0
+	 * @retval bool false if memory could not be allocated
+	 * @note The display must already have been initialised
+	 */
+	bool begin(const SPISettings& settings, Buffering buffering = Buffering::Single, uint16_t originX = 0,
+			   uint16_t originY = 0);
+
+	/**
+	 * @brief Wait for any flush to complete and release buffers
+	 */
+	void end();
+
+	/**
+	 * @name Adafruit_GFX drawing primitives
+	 * @{
+	 */
+	void drawPixel(int16_t x, int16_t y, uint16_t color) override;
+	void fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color) override;
+	void drawFastVLine(int16_t x, int16_t y, int16_t h, uint16_t color) override;
+	void drawFastHLine(int16_t x, int16_t y, int16_t w, uint16_t color) override;
+	void fillScreen(uint16_t color) override;
+	/** @} */
+
+	/**
+	 * @brief Read back a pixel from the drawing buffer
+	 */
+	uint16_t getPixel(int16_t x, int16_t y) const;
+
+	/**
+	 * @brief Get the drawing buffer, for direct access
+	 * @note Pixels are stored big-endian, in unrotated order. Call markDirty() after writing.
+	 */
+	uint16_t* getBuffer()
+	{
+		return drawBuffer;
+	}
+
+	/**
+	 * @brief Record an area as changed, in unrotated coordinates
+	 */
+	void markDirty(uint16_t x, uint16_t y, uint16_t w, uint16_t h);
+
+	/**
+	 * @brief Mark entire framebuffer for sending on next flush
+	 */
+	void invalidate()
+	{
+		markDirty(0, 0, WIDTH, HEIGHT);
+	}
+
+	/**
+	 * @brief Send all changed areas to the display
+	 * @retval bool true if a flush was started, false if there was nothing to send
+	 * @note Waits for any previous flush to complete first
+	 */
+	bool flush();
+
+	/**
+	 * @brief Determine if a flush is in progress
+	 */
+	bool isFlushing() const
+	{
+		return flushing;
+	}
+
+	/**
+	 * @brief Wait for any flush in progress to complete
+	 */
+	void wait();
+
+	const DirtyRegion& getDirtyRegion() const
+	{
+		return dirty;
+	}
+
+private:
+	void fillRaw(uint16_t x, uint16_t y, uint16_t w, uint16_t h, uint16_t color);
+	void copyRect(uint16_t* dst, const uint16_t* src, const DirtyRegion::Rect& rect);
+	void setWindow(const DirtyRegion::Rect& rect);
+	void startRect();
+	void service();
+	static void IRAM_ATTR transferComplete(SpiTransaction& trans);
+	static void taskCallback(void* param);
+
+	SPIClass& spi;
+	SPISettings settings;
+	SpiTransaction transaction;
+	DirtyRegion dirty;	   ///< Areas changed since last flush
+	DirtyRegion flushArea; ///< Areas being sent
+	uint16_t* memory{nullptr};
+	uint16_t* drawBuffer{nullptr};
+	uint16_t* sendBuffer{nullptr}; ///< Same as drawBuffer if single-buffered
+	uint16_t originX{0};
+	uint16_t originY{0};
+	uint16_t rowsRemaining{0};
+	uint8_t rectIndex{0};
+	uint8_t csPin;
+	uint8_t dcPin;
+	volatile bool flushing{false};
+	volatile bool rectDone{false};
+};
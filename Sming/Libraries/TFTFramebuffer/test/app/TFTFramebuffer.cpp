@@ -0,0 +1,164 @@
+#include <SmingTest.h>
+#include <TFTFramebuffer.h>
+
+namespace
+{
+using Rect = DirtyRegion::Rect;
+
+constexpr uint8_t csPin{15};
+constexpr uint8_t dcPin{5};
+constexpr size_t windowSetupBytes{11};
+
+#ifdef ARCH_HOST
+size_t bytesSent;
+
+void ioCallback(uint16_t, uint8_t bits, bool read)
+{
+	if(!read) {
+		bytesSent += bits / 8;
+	}
+}
+#endif
+
+} // namespace
+
+class TFTFramebufferTest : public TestGroup
+{
+public:
+	TFTFramebufferTest() : TestGroup(_F("TFTFramebuffer"))
+	{
+	}
+
+	void execute() override
+	{
+		dirtyRegionTests();
+		framebufferTests();
+	}
+
+	void dirtyRegionTests()
+	{
+		TEST_CASE("Separate areas")
+		{
+			DirtyRegion region;
+			region.add({0, 0, 10, 10});
+			region.add({100, 100, 10, 10});
+			REQUIRE_EQ(region.count(), 2);
+			REQUIRE_EQ(region.area(), 200);
+		}
+
+		TEST_CASE("Contained and overlapping areas")
+		{
+			DirtyRegion region;
+			region.add({10, 10, 20, 20});
+			region.add({15, 15, 5, 5});
+			REQUIRE_EQ(region.count(), 1);
+			REQUIRE(region[0] == Rect({10, 10, 20, 20}));
+
+			region.add({25, 25, 20, 20});
+			REQUIRE_EQ(region.count(), 1);
+			REQUIRE(region[0] == Rect({10, 10, 35, 35}));
+		}
+
+		TEST_CASE("Adjacent areas")
+		{
+			// Characters drawn along a line of text
+			DirtyRegion region;
+			for(uint16_t x = 0; x < 60; x += 6) {
+				region.add({x, 20, 6, 8});
+			}
+			REQUIRE_EQ(region.count(), 1);
+			REQUIRE(region[0] == Rect({0, 20, 60, 8}));
+		}
+
+		TEST_CASE("Merge chain")
+		{
+			// Joining two areas should pull in a third which now overlaps
+			DirtyRegion region;
+			region.add({0, 0, 50, 2});
+			region.add({0, 40, 50, 2});
+			region.add({60, 0, 2, 42});
+			REQUIRE_EQ(region.count(), 3);
+			region.add({0, 0, 62, 42});
+			REQUIRE_EQ(region.count(), 1);
+			REQUIRE(region[0] == Rect({0, 0, 62, 42}));
+		}
+
+		TEST_CASE("Full list")
+		{
+			DirtyRegion region;
+			for(unsigned i = 0; i <= DirtyRegion::maxRects; ++i) {
+				region.add({uint16_t(i * 40), uint16_t(i * 40), 4, 4});
+			}
+			REQUIRE_EQ(region.count(), DirtyRegion::maxRects);
+			// All pixels still covered
+			REQUIRE(region.area() >= (DirtyRegion::maxRects + 1) * 16);
+		}
+	}
+
+	void framebufferTests()
+	{
+		REQUIRE(SPI.begin());
+
+		TEST_CASE("Rotation")
+		{
+			TFTFramebuffer fb(40, 30, csPin, dcPin);
+			REQUIRE(fb.begin(SPISettings()));
+			auto buffer = fb.getBuffer();
+			for(uint8_t rotation = 0; rotation < 4; ++rotation) {
+				fb.setRotation(rotation);
+				fb.fillScreen(0);
+				fb.drawPixel(1, 2, 0x1234);
+				REQUIRE_EQ(fb.getPixel(1, 2), 0x1234);
+				fb.fillRect(3, 4, 5, 6, 0xabcd);
+				REQUIRE_EQ(fb.getPixel(3, 4), 0xabcd);
+				REQUIRE_EQ(fb.getPixel(7, 9), 0xabcd);
+				REQUIRE_EQ(fb.getPixel(8, 9), 0);
+				unsigned count{0};
+				for(unsigned i = 0; i < 40 * 30; ++i) {
+					count += (buffer[i] == 0xcdab);
+				}
+				REQUIRE_EQ(count, 30);
+			}
+		}
+
+		TEST_CASE("Flush")
+		{
+			TFTFramebuffer fb(64, 48, csPin, dcPin);
+			REQUIRE(fb.begin(SPISettings(), TFTFramebuffer::Buffering::Double));
+			REQUIRE_EQ(fb.getDirtyRegion().count(), 1);
+			REQUIRE(fb.flush());
+			fb.wait();
+			REQUIRE(!fb.flush());
+
+			fb.fillRect(0, 0, 8, 8, 0xffff);
+			fb.drawFastHLine(0, 40, 64, 0x1111);
+			auto& dirty = fb.getDirtyRegion();
+			REQUIRE_EQ(dirty.count(), 2);
+			size_t expectedBytes = dirty.count() * windowSetupBytes + dirty.area() * 2;
+
+#ifdef ARCH_HOST
+			bytesSent = 0;
+			SPI.setDebugIoCallback(ioCallback);
+#endif
+			REQUIRE(fb.flush());
+			// Double-buffered, so drawing may continue using up-to-date content
+			REQUIRE_EQ(fb.getPixel(7, 7), 0xffff);
+			fb.drawPixel(10, 10, 0x2222);
+			fb.wait();
+#ifdef ARCH_HOST
+			SPI.setDebugIoCallback(nullptr);
+			REQUIRE_EQ(bytesSent, expectedBytes);
+#else
+			(void)expectedBytes;
+#endif
+			REQUIRE_EQ(fb.getDirtyRegion().count(), 1);
+			REQUIRE_EQ(fb.getPixel(10, 10), 0x2222);
+			REQUIRE_EQ(fb.getPixel(20, 40), 0x1111);
+		}
+	}
+};
+
+void REGISTER_TEST(TFTFramebuffer)
+{
+	registerGroup<TFTFramebufferTest>();
+}
@@ -0,0 +1,12 @@
+COMPONENT_DEPENDS := Arduino_TensorFlowLite
+
+COMPONENT_SRCDIRS := src
+COMPONENT_INCDIRS := src/include
+
+COMPONENT_DOXYGEN_INPUT := src/include
+
+# Maximum number of distinct operators tracked by the profiler
+COMPONENT_VARS += TFLITE_PROFILER_MAX_OPS
+TFLITE_PROFILER_MAX_OPS ?= 32
+COMPONENT_CXXFLAGS := -DTFLITE_PROFILER_MAX_OPS=$(TFLITE_PROFILER_MAX_OPS)
+APP_CFLAGS += -DTFLITE_PROFILER_MAX_OPS=$(TFLITE_PROFILER_MAX_OPS)
@@ -0,0 +1,141 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/SmingHub/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * Arena.cpp
+ *
+ ****/
+
+#include <TfLite/Arena.h>
+#include <debug_progmem.h>
+#include <cstdlib>
+
+#ifdef ARCH_ESP32
+#include <esp_heap_caps.h>
+#endif
+
+namespace TfLite
+{
+namespace
+{
+uint8_t* alignBuffer(void* buffer)
+{
+	auto addr = reinterpret_cast<uintptr_t>(buffer);
+	addr = (addr + Arena::alignment - 1) & ~(Arena::alignment - 1);
+	return reinterpret_cast<uint8_t*>(addr);
+}
+
+} // namespace
+
+void* Arena::alloc(size_t size, Region region)
+{
+	switch(region) {
+	case Region::heap:
+		return malloc(size);
+
+	case Region::internal:
+#ifdef ARCH_ESP32
+		return heap_caps_malloc(size, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+#else
+		return malloc(size);
+#endif
+
+	case Region::external:
+#ifdef ARCH_ESP32
+		return heap_caps_malloc(size, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+#else
+		return nullptr;
+#endif
+
+	default:
+		return nullptr;
+	}
+}
+
+bool Arena::allocate(size_t size, Region region)
+{
+	if(region == Region::fixed) {
+		return buffer != nullptr && size <= bufferSize;
+	}
+
+	release();
+
+	memory = alloc(size + alignment - 1, region);
+	if(memory == nullptr) {
+		debug_w("[TFL] Arena of %u bytes unavailable", size);
+		return false;
+	}
+
+	buffer = alignBuffer(memory);
+	bufferSize = size;
+	this->region = region;
+	return true;
+}
+
+void Arena::assign(void* buffer, size_t size)
+{
+	release();
+
+	memory = buffer;
+	this->buffer = alignBuffer(buffer);
+	auto offset = this->buffer - static_cast<uint8_t*>(buffer);
+	bufferSize = (size > offset) ? size - offset : 0;
+	region = Region::fixed;
+}
+
+size_t Arena::measure(Region region, size_t maxSize, MeasureDelegate callback)
+{
+	if(!callback) {
+		return 0;
+	}
+
+	if(region == Region::fixed) {
+		if(buffer == nullptr) {
+			return 0;
+		}
+		used = callback(buffer, bufferSize);
+		debug_i("[TFL] Arena uses %u of %u bytes", used, bufferSize);
+		return (used == 0) ? 0 : bufferSize;
+	}
+
+	release();
+
+	// Largest trial buffer available, but no smaller than is likely to be useful
+	constexpr size_t minTrialSize{1024};
+	while(!allocate(maxSize, region)) {
+		if(maxSize < 2 * minTrialSize) {
+			return 0;
+		}
+		maxSize /= 2;
+	}
+
+	auto required = callback(buffer, bufferSize);
+	release();
+	if(required == 0) {
+		debug_w("[TFL] Arena measurement failed with %u bytes", maxSize);
+		return 0;
+	}
+
+	debug_i("[TFL] Arena requires %u bytes", required);
+	if(!allocate(required, region)) {
+		return 0;
+	}
+	used = required;
+	return bufferSize;
+}
+
+void Arena::release()
+{
+	if(region != Region::fixed) {
+		free(memory);
+	}
+	memory = nullptr;
+	buffer = nullptr;
+	bufferSize = 0;
+	used = 0;
+	region = Region::heap;
+}
+
+} // namespace TfLite
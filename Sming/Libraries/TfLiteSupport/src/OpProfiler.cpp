@@ -0,0 +1,84 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/SmingHub/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * OpProfiler.cpp
+ *
+ ****/
+
+#include <TfLite/OpProfiler.h>
+#include <cstring>
+#include <new>
+
+namespace TfLite
+{
+uint32_t OpProfiler::begin(const char* tag)
+{
+	if(tag == nullptr) {
+		return invalidHandle;
+	}
+
+	// Tags are usually static operator names so compare pointers first
+	unsigned i = 0;
+	for(; i < count; ++i) {
+		auto& entry = entries[i];
+		if(entry.tag == tag || strcmp(entry.tag, tag) == 0) {
+			entry.times->start();
+			return i;
+		}
+	}
+
+	if(count >= maxOps) {
+		++dropped;
+		return invalidHandle;
+	}
+
+	auto times = new(std::nothrow) Times(tag);
+	if(times == nullptr) {
+		++dropped;
+		return invalidHandle;
+	}
+
+	auto& entry = entries[count++];
+	entry.tag = tag;
+	entry.times.reset(times);
+	times->start();
+	return i;
+}
+
+uint32_t OpProfiler::getTotalTime() const
+{
+	uint32_t total{0};
+	for(unsigned i = 0; i < count; ++i) {
+		total += entries[i].times->getTotalTime();
+	}
+	return total;
+}
+
+void OpProfiler::clear()
+{
+	for(unsigned i = 0; i < count; ++i) {
+		entries[i].times->clear();
+	}
+	dropped = 0;
+}
+
+size_t OpProfiler::printTo(Print& p) const
+{
+	size_t n{0};
+	for(unsigned i = 0; i < count; ++i) {
+		n += p.println(*entries[i].times);
+	}
+	n += p.print(_F("Total "));
+	n += p.print(getTotalTime());
+	n += p.println(_F("us"));
+	if(dropped != 0) {
+		n += p.print(_F("Dropped "));
+		n += p.println(dropped);
+	}
+	return n;
+}
+
+} // namespace TfLite
@@ -0,0 +1,138 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/SmingHub/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * Arena.h - Tensor arena management for TensorFlow Lite Micro
+ *
+ ****/
+
+#pragma once
+
+#include <Delegate.h>
+#include <cstdint>
+#include <cstddef>
+
+namespace TfLite
+{
+/**
+ * @brief Memory region from which an arena is allocated
+ */
+enum class Region {
+	heap,	 ///< Default heap
+	internal, ///< On-chip RAM only, avoiding PSRAM. Same as `heap` where there is no external RAM.
+	external, ///< PSRAM (ESP32 only). Larger but slower than internal RAM.
+	fixed,	///< Buffer provided by the application, see `Arena::assign()`
+};
+
+/**
+ * @brief Memory used by a MicroInterpreter for tensors and operator state
+ *
+ * The required size depends on the model and operators so is hard to determine in advance.
+ * `measure()` finds it by allocating as large a trial buffer as requested, letting the interpreter
+ * allocate its tensors, and then replacing the trial buffer with one of the size actually used.
+ * Applications may store the result and pass it to `allocate()` on subsequent runs.
+ *
+ * Example:
+ *
+ * 		TfLite::Arena arena;
+ *
+ * 		size_t size = arena.measure(TfLite::Region::external, 256 * 1024, [](uint8_t* buffer, size_t size) -> size_t {
+ * 			tflite::MicroInterpreter interpreter(model, resolver, buffer, size, &errorReporter);
+ * 			if(interpreter.AllocateTensors() != kTfLiteOk) {
+ * 				return 0;
+ * 			}
+ * 			return interpreter.arena_used_bytes();
+ * 		});
+ *
+ * 		interpreter = new tflite::MicroInterpreter(model, resolver, arena.data(), arena.size(), &errorReporter);
+ */
+class Arena
+{
+public:
+	/**
+	 * @brief Called by `measure()` to set up an interpreter using a trial buffer
+	 * @param buffer The trial arena
+	 * @param size Size of trial arena
+	 * @retval size_t Number of bytes used, as returned by `MicroInterpreter::arena_used_bytes()`. 0 on failure.
+	 * @note The interpreter must be destroyed before returning.
+	 */
+	using MeasureDelegate = Delegate<size_t(uint8_t* buffer, size_t size)>;
+
+	/**
+	 * @brief Arena alignment, as required by TensorFlow Lite Micro
+	 */
+	static constexpr size_t alignment{16};
+
+	~Arena()
+	{
+		release();
+	}
+
+	/**
+	 * @brief Allocate an arena of a known size
+	 * @retval bool false if there is insufficient memory in the region
+	 */
+	bool allocate(size_t size, Region region = Region::heap);
+
+	/**
+	 * @brief Use a buffer provided by the application, typically a static array
+	 *
+	 * The buffer is aligned as required, so may be up to `alignment - 1` bytes smaller in use.
+	 */
+	void assign(void* buffer, size_t size);
+
+	/**
+	 * @brief Determine arena size required and allocate it
+	 * @param region Where to allocate the arena. For `Region::fixed`, the buffer set via `assign()` is used unchanged.
+	 * @param maxSize Size of trial buffer. If this cannot be allocated, it is halved until allocation succeeds.
+	 * @param callback Creates an interpreter using the trial buffer and returns the number of bytes it used
+	 * @retval size_t Size of arena allocated, 0 on failure
+	 */
+	size_t measure(Region region, size_t maxSize, MeasureDelegate callback);
+
+	/**
+	 * @brief Free the arena
+	 */
+	void release();
+
+	uint8_t* data() const
+	{
+		return buffer;
+	}
+
+	size_t size() const
+	{
+		return bufferSize;
+	}
+
+	Region getRegion() const
+	{
+		return region;
+	}
+
+	/**
+	 * @brief Get number of bytes used by the interpreter, as determined by `measure()`
+	 */
+	size_t getUsed() const
+	{
+		return used;
+	}
+
+	explicit operator bool() const
+	{
+		return buffer != nullptr;
+	}
+
+private:
+	static void* alloc(size_t size, Region region);
+
+	void* memory{nullptr}; ///< Allocated block, or buffer passed to assign()
+	uint8_t* buffer{nullptr};
+	size_t bufferSize{0};
+	size_t used{0};
+	Region region{Region::heap};
+};
+
+} // namespace TfLite
@@ -0,0 +1,138 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/SmingHub/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * OpProfiler.h - Per-operator timing for TensorFlow Lite Micro
+ *
+ ****/
+
+#pragma once
+
+#include <Services/Profiling/MinMaxTimes.h>
+#include <memory>
+
+/*
+ * The profiler interface changed when TensorFlow Lite Micro was split from the main TensorFlow tree.
+ */
+#if __has_include(<tensorflow/lite/micro/micro_profiler_interface.h>)
+#include <tensorflow/lite/micro/micro_profiler_interface.h>
+#define TFLITE_MICRO_PROFILER_INTERFACE 1
+#else
+#include <tensorflow/lite/core/api/profiler.h>
+#define TFLITE_MICRO_PROFILER_INTERFACE 0
+#endif
+
+#ifndef TFLITE_PROFILER_MAX_OPS
+#define TFLITE_PROFILER_MAX_OPS 32
+#endif
+
+namespace TfLite
+{
+/**
+ * @brief Collects execution times for each type of operator invoked by an interpreter
+ *
+ * Pass to the `MicroInterpreter` constructor as its profiler. Times for all operators
+ * of the same type (e.g. CONV_2D) are combined. Print the profiler to list them.
+ *
+ * Example:
+ *
+ * 		TfLite::OpProfiler profiler;
+ * 		tflite::MicroInterpreter interpreter(model, resolver, arena.data(), arena.size(), &errorReporter, &profiler);
+ *
+ * 		interpreter.Invoke();
+ * 		Serial.print(profiler);
+ */
+class OpProfiler : public Printable,
+#if TFLITE_MICRO_PROFILER_INTERFACE
+				   public tflite::MicroProfilerInterface
+#else
+				   public tflite::Profiler
+#endif
+{
+public:
+	using Times = Profiling::MicroTimes;
+
+	static constexpr unsigned maxOps{TFLITE_PROFILER_MAX_OPS};
+
+#if TFLITE_MICRO_PROFILER_INTERFACE
+	uint32_t BeginEvent(const char* tag) override
+	{
+		return begin(tag);
+	}
+#else
+	uint32_t BeginEvent(const char* tag, EventType, int64_t, int64_t) override
+	{
+		return begin(tag);
+	}
+#endif
+
+	void EndEvent(uint32_t handle) override
+	{
+		end(handle);
+	}
+
+	/**
+	 * @brief Start timing an operator
+	 * @retval uint32_t Handle to pass to `end()`
+	 */
+	uint32_t begin(const char* tag);
+
+	/**
+	 * @brief Stop timing an operator
+	 */
+	void end(uint32_t handle)
+	{
+		if(handle < count) {
+			entries[handle].times->update();
+		}
+	}
+
+	/**
+	 * @brief Number of operator types recorded
+	 */
+	unsigned getCount() const
+	{
+		return count;
+	}
+
+	const Times& operator[](unsigned index) const
+	{
+		return *entries[index].times;
+	}
+
+	/**
+	 * @brief Get total time spent in all operators, in microseconds
+	 */
+	uint32_t getTotalTime() const;
+
+	/**
+	 * @brief Number of events discarded because `maxOps` was exceeded
+	 */
+	unsigned getDropped() const
+	{
+		return dropped;
+	}
+
+	/**
+	 * @brief Reset times for all operators
+	 */
+	void clear();
+
+	size_t printTo(Print& p) const override;
+
+private:
+	static constexpr uint32_t invalidHandle{UINT32_MAX};
+
+	struct Entry {
+		const char* tag;
+		std::unique_ptr<Times> times;
+	};
+
+	Entry entries[maxOps];
+	uint8_t count{0};
+	unsigned dropped{0};
+};
+
+} // namespace TfLite
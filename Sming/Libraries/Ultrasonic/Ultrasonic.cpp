@@ -68,6 +68,53 @@ uint32_t Ultrasonic::ping()
 	return pulseIn(pinECHO, HIGH, echoTimeout);
 }
 
+/**
+ * Trigger pulse and report echo duration without blocking
+ *
+ * The echo is measured using PulseCapture so other tasks may run while waiting for it.
+ * Returns false if a ping is already in progress or the echo pin can't be captured.
+ */
+bool Ultrasonic::startPing(PingCallback callback)
+{
+	if(!callback || pingCallback) {
+		return false;
+	}
+
+	if(!echoCapture.begin(pinECHO, PulseCapture::Callback(&Ultrasonic::echoCaptured, this))) {
+		return false;
+	}
+
+	pingCallback = callback;
+	echoTimer.initializeUs(echoTimeout, [this]() { pingComplete(0); }).startOnce();
+
+	digitalWrite(pinTRIG, LOW);
+	delayMicroseconds(2);
+	digitalWrite(pinTRIG, HIGH);
+	delayMicroseconds(trigDuration);
+	digitalWrite(pinTRIG, LOW);
+
+	return true;
+}
+
+void Ultrasonic::echoCaptured(const PulseCapture::Pulse* pulses, size_t count)
+{
+	for(unsigned i = 0; i < count; ++i) {
+		if(pulses[i].level == HIGH) {
+			pingComplete(pulses[i].duration);
+			return;
+		}
+	}
+}
+
+void Ultrasonic::pingComplete(uint32_t duration)
+{
+	echoTimer.stop();
+	echoCapture.end();
+	auto callback = pingCallback;
+	pingCallback = nullptr;
+	callback(duration);
+}
+
 /**
  * Measure distance in centimeters
  */
@@ -23,13 +23,22 @@
 #include "WProgram.h"
 #endif
 
+#include <PulseCapture.h>
+#include <Timer.h>
+
 class Ultrasonic
 {
 public:
+	/**
+	 * @brief Reports echo duration in microseconds, or 0 on timeout
+	 */
+	using PingCallback = Delegate<void(uint32_t duration)>;
+
 	Ultrasonic();
 
 	void begin(uint16_t trigPin, uint8_t echoPin);
 	uint32_t ping();
+	bool startPing(PingCallback callback);
 	uint16_t us2cm(unsigned long microseconds);
 	uint16_t us2inch(unsigned long microseconds);
 	uint16_t rangeCM();
@@ -62,6 +71,13 @@ private:
 
 	// fast square root
 	unsigned int root(unsigned int x);
+
+	void echoCaptured(const PulseCapture::Pulse* pulses, size_t count);
+	void pingComplete(uint32_t duration);
+
+	PulseCapture echoCapture;
+	Timer echoTimer;
+	PingCallback pingCallback;
 };
 
 #endif //#ifndef ULTRASONIC_H
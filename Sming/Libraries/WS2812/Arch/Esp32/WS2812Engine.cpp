@@ -0,0 +1,126 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/SmingHub/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * WS2812Engine.cpp - RMT output
+ *
+ * Each strip is assigned an RMT transmit channel. Pixel data is translated into RMT items
+ * by the driver interrupt as channel memory becomes free.
+ *
+ ****/
+
+#include <WS2812Strip.h>
+#include <driver/rmt.h>
+#include <debug_progmem.h>
+
+namespace WS2812
+{
+namespace
+{
+#ifdef SOC_RMT_TX_CANDIDATES_PER_GROUP
+constexpr unsigned channelCount{SOC_RMT_TX_CANDIDATES_PER_GROUP};
+#else
+constexpr unsigned channelCount{RMT_CHANNEL_MAX};
+#endif
+
+// 80 MHz APB clock divided by 2 gives 25ns ticks
+constexpr uint8_t clockDivider{2};
+constexpr uint32_t nsToTicks(uint32_t ns)
+{
+	return ns / 25;
+}
+
+Strip* channels[channelCount];
+bool callbackRegistered;
+
+} // namespace
+
+class EngineImpl : public Engine
+{
+public:
+	static void IRAM_ATTR translate(const void* src, rmt_item32_t* dest, size_t src_size, size_t wanted_num,
+									size_t* translated_size, size_t* item_num)
+	{
+		rmt_item32_t bit0{};
+		bit0.duration0 = nsToTicks(400);
+		bit0.level0 = 1;
+		bit0.duration1 = nsToTicks(850);
+		bit0.level1 = 0;
+		rmt_item32_t bit1{};
+		bit1.duration0 = nsToTicks(800);
+		bit1.level0 = 1;
+		bit1.duration1 = nsToTicks(450);
+		bit1.level1 = 0;
+
+		auto data = static_cast<const uint8_t*>(src);
+		size_t size{0};
+		size_t num{0};
+		while(size < src_size && num + 8 <= wanted_num) {
+			auto c = data[size++];
+			for(uint8_t mask = 0x80; mask != 0; mask >>= 1) {
+				dest[num++].val = (c & mask) ? bit1.val : bit0.val;
+			}
+		}
+		*translated_size = size;
+		*item_num = num;
+	}
+
+	static void IRAM_ATTR txEnd(rmt_channel_t channel, void*)
+	{
+		if(unsigned(channel) < channelCount && channels[channel] != nullptr) {
+			frameComplete(*channels[channel]);
+		}
+	}
+};
+
+bool Engine::begin(Strip& strip)
+{
+	unsigned channel = 0;
+	while(channel < channelCount && channels[channel] != nullptr) {
+		++channel;
+	}
+	if(channel == channelCount) {
+		debug_e("[WS2812] No free RMT channel");
+		return false;
+	}
+
+	auto rmtChannel = rmt_channel_t(channel);
+	rmt_config_t config = RMT_DEFAULT_CONFIG_TX(gpio_num_t(strip.getPin()), rmtChannel);
+	config.clk_div = clockDivider;
+	if(rmt_config(&config) != ESP_OK) {
+		return false;
+	}
+	if(rmt_driver_install(rmtChannel, 0, 0) != ESP_OK) {
+		return false;
+	}
+	rmt_translator_init(rmtChannel, EngineImpl::translate);
+
+	if(!callbackRegistered) {
+		rmt_register_tx_end_callback(EngineImpl::txEnd, nullptr);
+		callbackRegistered = true;
+	}
+
+	channels[channel] = &strip;
+	strip.channel = channel;
+	return true;
+}
+
+void Engine::end(Strip& strip)
+{
+	if(strip.channel < 0) {
+		return;
+	}
+
+	rmt_driver_uninstall(rmt_channel_t(strip.channel));
+	channels[strip.channel] = nullptr;
+	strip.channel = -1;
+}
+
+void Engine::start(Strip& strip)
+{
+	rmt_write_sample(rmt_channel_t(strip.channel), getData(strip), getSize(strip), false);
+}
+
+} // namespace WS2812
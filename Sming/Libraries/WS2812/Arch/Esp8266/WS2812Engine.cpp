@@ -0,0 +1,152 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/SmingHub/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * WS2812Engine.cpp - I2S DMA output
+ *
+ * The I2S bit clock runs at 3.2 MHz, so four I2S bits make up one 1.25us WS2812 bit:
+ * 1000 for a zero and 1110 for a one. Each pixel byte therefore occupies one 32-bit sample.
+ *
+ * Data is encoded into the DMA buffers from the I2S interrupt as space becomes available.
+ * Buffers are cleared after transmission, so the line idles low between frames.
+ *
+ ****/
+
+#include <WS2812Strip.h>
+#include <driver/i2s.h>
+#include <esp_systemapi.h>
+#include <debug_progmem.h>
+#include <cstring>
+
+namespace WS2812
+{
+namespace
+{
+constexpr uint8_t dataPin{3};
+constexpr uint8_t bckDiv{5};
+constexpr uint8_t mclkDiv{10};
+
+constexpr uint16_t nibblePattern(uint8_t n)
+{
+	return ((n & 0x08) ? 0xe000 : 0x8000) | ((n & 0x04) ? 0x0e00 : 0x0800) | ((n & 0x02) ? 0x00e0 : 0x0080) |
+		   ((n & 0x01) ? 0x000e : 0x0008);
+}
+
+// Kept in RAM for access from interrupt context
+const uint16_t bitPatterns[16]{
+	nibblePattern(0),  nibblePattern(1),  nibblePattern(2),  nibblePattern(3),
+	nibblePattern(4),  nibblePattern(5),  nibblePattern(6),  nibblePattern(7),
+	nibblePattern(8),  nibblePattern(9),  nibblePattern(10), nibblePattern(11),
+	nibblePattern(12), nibblePattern(13), nibblePattern(14), nibblePattern(15),
+};
+
+Strip* activeStrip;
+const uint8_t* txPos;
+const uint8_t* txEnd;
+bool padded;
+
+} // namespace
+
+class EngineImpl : public Engine
+{
+public:
+	static void IRAM_ATTR fill()
+	{
+		i2s_buffer_info_t info;
+		while(txPos < txEnd && i2s_dma_write(&info, (txEnd - txPos) * sizeof(uint32_t))) {
+			auto dst = static_cast<uint32_t*>(info.buffer);
+			for(auto n = info.size / sizeof(uint32_t); n != 0; --n) {
+				auto c = *txPos++;
+				*dst++ = (bitPatterns[c >> 4] << 16) | bitPatterns[c & 0x0f];
+			}
+		}
+
+		// Complete the final buffer so it starts clean for the next frame
+		if(txPos == txEnd && !padded && i2s_dma_write(&info, SIZE_MAX)) {
+			memset(info.buffer, 0, info.size);
+			padded = true;
+		}
+	}
+
+	static void IRAM_ATTR callback(void*, i2s_event_type_t event)
+	{
+		if(event != I2S_EVENT_TX_DONE || activeStrip == nullptr || !activeStrip->isBusy()) {
+			return;
+		}
+
+		fill();
+		if(!padded) {
+			return;
+		}
+
+		i2s_buffer_stat_t stat;
+		if(i2s_stat_tx(&stat) && stat.used == 0) {
+			frameComplete(*activeStrip);
+		}
+	}
+};
+
+bool Engine::begin(Strip& strip)
+{
+	if(activeStrip != nullptr) {
+		debug_e("[WS2812] I2S in use");
+		return false;
+	}
+	if(strip.getPin() != dataPin) {
+		debug_e("[WS2812] I2S output requires GPIO%u", dataPin);
+		return false;
+	}
+
+	i2s_config_t config{};
+	config.tx = i2s_module_config_t{
+		.mode = I2S_MODE_MASTER,
+		.bits_per_sample = I2S_BITS_PER_SAMPLE_16BIT,
+		.channel_format = I2S_CHANNEL_FMT_RIGHT_LEFT,
+		.communication_format = I2S_COMM_FORMAT_I2S_MSB,
+		.dma_buf_len = 128, // in samples
+		.dma_buf_count = 4,
+		.callback_threshold = 0,
+	};
+	config.sample_rate = 100000;
+	config.tx_desc_auto_clear = true;
+	config.auto_start = false;
+	config.callback = EngineImpl::callback;
+	if(!i2s_driver_install(&config)) {
+		return false;
+	}
+	i2s_set_dividers(bckDiv, mclkDiv);
+	i2s_set_pins(I2S_PIN_DATA_OUT, true);
+	i2s_zero_dma_buffer();
+	i2s_start();
+
+	activeStrip = &strip;
+	strip.channel = 0;
+	return true;
+}
+
+void Engine::end(Strip& strip)
+{
+	if(activeStrip != &strip) {
+		return;
+	}
+
+	i2s_stop();
+	i2s_set_pins(I2S_PIN_DATA_OUT, false);
+	i2s_driver_uninstall();
+	activeStrip = nullptr;
+	strip.channel = -1;
+}
+
+void Engine::start(Strip& strip)
+{
+	auto level = noInterrupts();
+	txPos = getData(strip);
+	txEnd = txPos + getSize(strip);
+	padded = false;
+	EngineImpl::fill();
+	restoreInterrupts(level);
+}
+
+} // namespace WS2812
@@ -0,0 +1,33 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/SmingHub/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * WS2812Engine.cpp - Host emulation
+ *
+ * There is no output hardware, so frames complete immediately.
+ *
+ ****/
+
+#include <WS2812Strip.h>
+
+namespace WS2812
+{
+bool Engine::begin(Strip& strip)
+{
+	strip.channel = 0;
+	return true;
+}
+
+void Engine::end(Strip& strip)
+{
+	strip.channel = -1;
+}
+
+void Engine::start(Strip& strip)
+{
+	frameComplete(strip);
+}
+
+} // namespace WS2812
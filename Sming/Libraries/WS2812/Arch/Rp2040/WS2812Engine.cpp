@@ -0,0 +1,171 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/SmingHub/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * WS2812Engine.cpp - PIO output
+ *
+ * Each strip uses one PIO state machine, fed by DMA from the frame buffer.
+ * The program is `ws2812.pio` from the pico-examples repository, pre-assembled.
+ * Each data bit takes 10 PIO cycles, so the state machine runs at 8 MHz.
+ *
+ * DMA writes each byte to the TX FIFO, where it is replicated across the 32-bit word.
+ * The state machine shifts out the 8 most significant bits.
+ *
+ ****/
+
+#include <WS2812Strip.h>
+#include <hardware/pio.h>
+#include <hardware/dma.h>
+#include <hardware/irq.h>
+#include <hardware/clocks.h>
+#include <debug_progmem.h>
+
+namespace WS2812
+{
+namespace
+{
+constexpr uint32_t bitRate{800000};
+constexpr unsigned cyclesPerBit{10};
+constexpr unsigned smCount{NUM_PIOS * NUM_PIO_STATE_MACHINES};
+
+constexpr uint16_t programInstructions[]{
+	//     .wrap_target
+	0x6221, //  0: out    x, 1            side 0 [2]
+	0x1123, //  1: jmp    !x, 3           side 1 [1]
+	0x1400, //  2: jmp    0               side 1 [4]
+	0xa442, //  3: nop                    side 0 [4]
+			//     .wrap
+};
+
+const pio_program_t program{
+	.instructions = programInstructions,
+	.length = ARRAY_SIZE(programInstructions),
+	.origin = -1,
+};
+
+struct Channel {
+	Strip* strip;
+	int8_t dma;
+};
+
+Channel channels[smCount];
+int8_t programOffset[NUM_PIOS]{-1, -1};
+bool irqInitialised;
+
+__forceinline PIO getPio(unsigned channel)
+{
+	return (channel < NUM_PIO_STATE_MACHINES) ? pio0 : pio1;
+}
+
+} // namespace
+
+class EngineImpl : public Engine
+{
+public:
+	static void IRAM_ATTR dmaInterrupt()
+	{
+		for(auto& ch : channels) {
+			if(ch.strip == nullptr || !dma_channel_get_irq0_status(ch.dma)) {
+				continue;
+			}
+			dma_channel_acknowledge_irq0(ch.dma);
+			frameComplete(*ch.strip);
+		}
+	}
+};
+
+bool Engine::begin(Strip& strip)
+{
+	unsigned channel;
+	int sm{-1};
+	for(channel = 0; channel < smCount; channel += NUM_PIO_STATE_MACHINES) {
+		sm = pio_claim_unused_sm(getPio(channel), false);
+		if(sm >= 0) {
+			channel += sm;
+			break;
+		}
+	}
+	if(sm < 0) {
+		debug_e("[WS2812] No free PIO state machine");
+		return false;
+	}
+
+	auto pio = getPio(channel);
+	auto pioIndex = pio_get_index(pio);
+	if(programOffset[pioIndex] < 0) {
+		if(!pio_can_add_program(pio, &program)) {
+			pio_sm_unclaim(pio, sm);
+			return false;
+		}
+		programOffset[pioIndex] = pio_add_program(pio, &program);
+	}
+
+	int dma = dma_claim_unused_channel(false);
+	if(dma < 0) {
+		pio_sm_unclaim(pio, sm);
+		debug_e("[WS2812] No free DMA channel");
+		return false;
+	}
+
+	// State machine
+	unsigned pin = strip.getPin();
+	unsigned offset = programOffset[pioIndex];
+	pio_gpio_init(pio, pin);
+	pio_sm_set_consecutive_pindirs(pio, sm, pin, 1, true);
+	auto c = pio_get_default_sm_config();
+	sm_config_set_wrap(&c, offset, offset + program.length - 1);
+	sm_config_set_sideset(&c, 1, false, false);
+	sm_config_set_sideset_pins(&c, pin);
+	sm_config_set_out_shift(&c, false, true, 8);
+	sm_config_set_fifo_join(&c, PIO_FIFO_JOIN_TX);
+	sm_config_set_clkdiv(&c, float(clock_get_hz(clk_sys)) / (bitRate * cyclesPerBit));
+	pio_sm_init(pio, sm, offset, &c);
+	pio_sm_set_enabled(pio, sm, true);
+
+	// DMA
+	auto dc = dma_channel_get_default_config(dma);
+	channel_config_set_transfer_data_size(&dc, DMA_SIZE_8);
+	channel_config_set_read_increment(&dc, true);
+	channel_config_set_write_increment(&dc, false);
+	channel_config_set_dreq(&dc, pio_get_dreq(pio, sm, true));
+	dma_channel_configure(dma, &dc, &pio->txf[sm], nullptr, 0, false);
+
+	if(!irqInitialised) {
+		irq_add_shared_handler(DMA_IRQ_0, EngineImpl::dmaInterrupt, PICO_SHARED_IRQ_HANDLER_DEFAULT_ORDER_PRIORITY);
+		irq_set_enabled(DMA_IRQ_0, true);
+		irqInitialised = true;
+	}
+	dma_channel_acknowledge_irq0(dma);
+	dma_channel_set_irq0_enabled(dma, true);
+
+	channels[channel] = {&strip, int8_t(dma)};
+	strip.channel = channel;
+	return true;
+}
+
+void Engine::end(Strip& strip)
+{
+	if(strip.channel < 0) {
+		return;
+	}
+
+	auto& ch = channels[strip.channel];
+	dma_channel_set_irq0_enabled(ch.dma, false);
+	dma_channel_unclaim(ch.dma);
+	auto pio = getPio(strip.channel);
+	unsigned sm = strip.channel % NUM_PIO_STATE_MACHINES;
+	pio_sm_set_enabled(pio, sm, false);
+	pio_sm_unclaim(pio, sm);
+	ch = {};
+	strip.channel = -1;
+}
+
+void Engine::start(Strip& strip)
+{
+	auto& ch = channels[strip.channel];
+	dma_channel_transfer_from_buffer_now(ch.dma, getData(strip), getSize(strip));
+}
+
+} // namespace WS2812
@@ -4,6 +4,8 @@
 
 #include "WS2812.h"
 
+#ifdef ARCH_ESP8266
+
 // The ICACHE_FLASH_ATTR is there to trick the compiler and get the very first pulse width correct.
 static void ICACHE_FLASH_ATTR send_ws_0(uint8_t gpio)
 {
@@ -55,3 +57,5 @@ void ICACHE_FLASH_ATTR ws2812_writergb(uint8_t gpio, char *buffer, size_t length
     }
     interrupts();
 }
+
+#endif // ARCH_ESP8266
@@ -3,7 +3,12 @@
 
 #include <SmingCore.h>
 
+#include "WS2812Strip.h"
+
+#ifdef ARCH_ESP8266
 // Byte triples in the buffer are interpreted as R G B values and sent to the hardware as G R B.
+// Bit-banged with interrupts disabled: prefer WS2812::Strip.
 void ICACHE_FLASH_ATTR ws2812_writergb(uint8_t gpio, char *buffer, size_t length);
+#endif
 
 #endif
@@ -0,0 +1,98 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/SmingHub/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * WS2812Strip.cpp
+ *
+ ****/
+
+#include "WS2812Strip.h"
+#include <esp_systemapi.h>
+#include <cstring>
+
+namespace WS2812
+{
+bool Strip::begin()
+{
+	if(buffers[0] != nullptr) {
+		return true;
+	}
+
+	auto size = getFrameSize();
+	auto mem = new uint8_t[size * 2];
+	if(mem == nullptr) {
+		return false;
+	}
+	memset(mem, 0, size * 2);
+	buffers[0] = mem;
+	buffers[1] = mem + size;
+	frontIndex = 0;
+
+	if(!Engine::begin(*this)) {
+		delete[] mem;
+		buffers[0] = buffers[1] = nullptr;
+		return false;
+	}
+
+	return true;
+}
+
+void Strip::end()
+{
+	if(buffers[0] == nullptr) {
+		return;
+	}
+
+	wait();
+	Engine::end(*this);
+	delete[] buffers[0];
+	buffers[0] = buffers[1] = nullptr;
+}
+
+void Strip::setPixel(unsigned index, uint8_t red, uint8_t green, uint8_t blue)
+{
+	if(index >= ledCount || buffers[0] == nullptr) {
+		return;
+	}
+	auto p = &getPixels()[index * bytesPerPixel];
+	p[0] = green;
+	p[1] = red;
+	p[2] = blue;
+}
+
+void Strip::fill(uint8_t red, uint8_t green, uint8_t blue)
+{
+	for(unsigned i = 0; i < ledCount; ++i) {
+		setPixel(i, red, green, blue);
+	}
+}
+
+bool Strip::show()
+{
+	if(busy || buffers[0] == nullptr) {
+		return false;
+	}
+
+	// Consecutive frames must be separated by the reset period
+	while(system_get_time() - latchTime < resetTime) {
+	}
+
+	frontIndex = 1 - frontIndex;
+	memcpy(getPixels(), getFrontBuffer(), getFrameSize());
+	busy = true;
+	Engine::start(*this);
+	return true;
+}
+
+void IRAM_ATTR Strip::frameComplete()
+{
+	latchTime = system_get_time();
+	busy = false;
+	if(callback != nullptr) {
+		callback(param);
+	}
+}
+
+} // namespace WS2812
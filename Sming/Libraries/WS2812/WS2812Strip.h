@@ -0,0 +1,192 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/SmingHub/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * WS2812Strip.h - Background output for WS2812 LED strips
+ *
+ ****/
+
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+
+namespace WS2812
+{
+class Engine;
+
+/**
+ * @brief Drive a strip of WS2812 LEDs using hardware, without blocking the CPU
+ *
+ * Pixels are drawn into a back buffer whilst the previous frame is sent from the front buffer.
+ * `show()` exchanges the buffers and starts output, so the application may begin drawing
+ * the next frame immediately.
+ *
+ * Output engines:
+ *
+ * - Esp8266: I2S DMA, each data bit encoded as four I2S bits at 3.2 MHz. Output is fixed
+ *   to GPIO3 (RX0), so only one strip is supported.
+ * - Esp32: RMT, one channel per strip.
+ * - Rp2040: PIO with DMA, one state machine and DMA channel per strip.
+ * - Host: Frames are discarded and complete immediately.
+ *
+ * Several strips may run in parallel, up to the number of hardware channels available.
+ */
+class Strip
+{
+public:
+	/**
+	 * @brief Called when a frame has been sent and latched
+	 * @note Invoked in interrupt context, so code must be in IRAM.
+	 * Use `System.queueCallback()` to defer any other processing.
+	 */
+	using Callback = void (*)(void* param);
+
+	static constexpr unsigned bytesPerPixel{3};
+
+	/**
+	 * @brief Minimum time between frames in microseconds
+	 *
+	 * Covers the WS2812 reset period plus data still held in hardware FIFOs.
+	 */
+	static constexpr unsigned resetTime{400};
+
+	Strip(uint8_t pin, uint16_t ledCount) : pin(pin), ledCount(ledCount)
+	{
+	}
+
+	~Strip()
+	{
+		end();
+	}
+
+	/**
+	 * @brief Allocate frame buffers and initialise output hardware
+	 * @retval bool false if out of memory or no hardware channel is available
+	 */
+	bool begin();
+
+	/**
+	 * @brief Wait for any frame in progress, then release resources
+	 */
+	void end();
+
+	/**
+	 * @brief Set callback to be invoked on completion of each frame
+	 */
+	void onComplete(Callback callback, void* param = nullptr)
+	{
+		this->param = param;
+		this->callback = callback;
+	}
+
+	uint8_t getPin() const
+	{
+		return pin;
+	}
+
+	uint16_t getLedCount() const
+	{
+		return ledCount;
+	}
+
+	/**
+	 * @brief Get the back buffer for direct access
+	 * @retval uint8_t* Pixels in GRB order, as sent to the strip
+	 */
+	uint8_t* getPixels()
+	{
+		return buffers[1 - frontIndex];
+	}
+
+	void setPixel(unsigned index, uint8_t red, uint8_t green, uint8_t blue);
+
+	void fill(uint8_t red, uint8_t green, uint8_t blue);
+
+	void clear()
+	{
+		fill(0, 0, 0);
+	}
+
+	/**
+	 * @brief Send the back buffer to the strip
+	 *
+	 * The buffers are exchanged, and the new back buffer is initialised with a copy of the frame being sent.
+	 *
+	 * @retval bool false if the previous frame is still being sent
+	 */
+	bool show();
+
+	/**
+	 * @brief Determine if a frame is being sent
+	 */
+	bool isBusy() const
+	{
+		return busy;
+	}
+
+	/**
+	 * @brief Wait for the current frame to complete
+	 */
+	void wait()
+	{
+		while(busy) {
+		}
+	}
+
+private:
+	friend class Engine;
+
+	size_t getFrameSize() const
+	{
+		return ledCount * bytesPerPixel;
+	}
+
+	const uint8_t* getFrontBuffer() const
+	{
+		return buffers[frontIndex];
+	}
+
+	void frameComplete();
+
+	uint8_t* buffers[2]{};
+	Callback callback{nullptr};
+	void* param{nullptr};
+	uint32_t latchTime{0};
+	uint16_t ledCount;
+	uint8_t pin;
+	uint8_t frontIndex{0};
+	int8_t channel{-1}; ///< Assigned by output engine
+	volatile bool busy{false};
+};
+
+/**
+ * @brief Interface to the architecture-specific output hardware
+ */
+class Engine
+{
+public:
+	static bool begin(Strip& strip);
+	static void end(Strip& strip);
+	static void start(Strip& strip);
+
+protected:
+	static const uint8_t* getData(const Strip& strip)
+	{
+		return strip.getFrontBuffer();
+	}
+
+	static size_t getSize(const Strip& strip)
+	{
+		return strip.getFrameSize();
+	}
+
+	static void frameComplete(Strip& strip)
+	{
+		strip.frameComplete();
+	}
+};
+
+} // namespace WS2812
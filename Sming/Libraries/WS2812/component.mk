@@ -1 +1,7 @@
-COMPONENT_SOC := esp8266
+COMPONENT_SRCDIRS := \
+	. \
+	Arch/$(SMING_ARCH)
+
+COMPONENT_INCDIRS := .
+
+COMPONENT_DOXYGEN_INPUT := WS2812Strip.h
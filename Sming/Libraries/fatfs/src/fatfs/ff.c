@@ -1022,6 +1022,29 @@ DWORD clmt_clust (	/* <2:Error, >=2:Cluster number */
 	}
 	return cl + *tbl;	/* Return the cluster number */
 }
+
+
+#if !_FS_READONLY
+static
+DWORD clmt_remain (	/* 0:Error, >=1:Number of clusters */
+	FIL* fp,		/* Pointer to the file object */
+	DWORD ofs		/* File offset */
+)
+{
+	DWORD cl, ncl, *tbl;
+
+
+	tbl = fp->cltbl + 1;	/* Top of CLMT */
+	cl = ofs / SS(fp->fs) / fp->fs->csize;	/* Cluster order from top of the file */
+	for (;;) {
+		ncl = *tbl++;			/* Number of cluters in the fragment */
+		if (!ncl) return 0;		/* End of table? (error) */
+		if (cl < ncl) break;	/* In this fragment? */
+		cl -= ncl; tbl++;		/* Next fragment */
+	}
+	return ncl - cl;	/* Clusters from the one containing ofs to the end of the fragment */
+}
+#endif
 #endif	/* _USE_FASTSEEK */
 
 
@@ -2651,6 +2674,9 @@ FRESULT f_write (
 	UINT wcnt, cc;
 	const BYTE *wbuff = (const BYTE*)buff;
 	BYTE csect;
+#if _USE_FASTSEEK
+	DWORD ncl;
+#endif
 
 
 	*bw = 0;	/* Clear write byte counter */
@@ -2701,10 +2727,20 @@ FRESULT f_write (
 			sect += csect;
 			cc = btw / SS(fp->fs);			/* When remaining bytes >= sector size, */
 			if (cc) {						/* Write maximum contiguous sectors directly */
+#if _USE_FASTSEEK
+				ncl = fp->cltbl ? clmt_remain(fp, fp->fptr) : 0;
+				if (ncl > 1) {				/* Following clusters are contiguous on the volume */
+					if (csect + cc > ncl * fp->fs->csize)	/* Clip at end of fragment */
+						cc = ncl * fp->fs->csize - csect;
+				} else
+#endif
 				if (csect + cc > fp->fs->csize)	/* Clip at cluster boundary */
 					cc = fp->fs->csize - csect;
 				if (disk_write(fp->fs->drv, wbuff, sect, cc) != RES_OK)
 					ABORT(fp->fs, FR_DISK_ERR);
+#if _USE_FASTSEEK
+				fp->clust += (csect + cc - 1) / fp->fs->csize;	/* Cluster containing the last sector written */
+#endif
 #if _FS_MINIMIZE <= 2
 #if _FS_TINY
 				if (fp->fs->winsect - sect < cc) {	/* Refill sector cache if it gets invalidated by the direct write */
@@ -3458,6 +3494,9 @@ FRESULT f_truncate (
 					if (res == FR_OK) res = remove_chain(fp->fs, ncl);
 				}
 			}
+#if _USE_FASTSEEK
+			fp->cltbl = 0;			/* Link map table no longer matches the cluster chain */
+#endif
 #if !_FS_TINY
 			if (res == FR_OK && (fp->flag & FA__DIRTY)) {
 				if (disk_write(fp->fs->drv, fp->buf, fp->dsect, 1) != RES_OK)
@@ -3475,6 +3514,79 @@ FRESULT f_truncate (
 
 
 
+#if _USE_EXPAND
+/*-----------------------------------------------------------------------*/
+/* Allocate a Contiguous Block to the File                               */
+/*-----------------------------------------------------------------------*/
+
+FRESULT f_expand (
+	FIL* fp,		/* Pointer to the file object */
+	DWORD fsz,		/* File size to be expanded to */
+	BYTE opt		/* Operation mode 0:Find and prepare or 1:Find and allocate */
+)
+{
+	FRESULT res;
+	FATFS *fs;
+	DWORD n, clst, stcl, scl, ncl, tcl;
+
+
+	res = validate(fp);						/* Check validity of the object */
+	if (res != FR_OK) LEAVE_FF(fp->fs, res);
+	if (fp->err)							/* Check error */
+		LEAVE_FF(fp->fs, (FRESULT)fp->err);
+	if (fsz == 0 || fp->fsize != 0 || !(fp->flag & FA_WRITE))	/* Check if the file is empty and writable */
+		LEAVE_FF(fp->fs, FR_DENIED);
+
+	fs = fp->fs;
+	n = (DWORD)fs->csize * SS(fs);			/* Cluster size */
+	tcl = fsz / n + ((fsz & (n - 1)) ? 1 : 0);	/* Number of clusters required */
+	stcl = fs->last_clust;					/* Search from the last allocated cluster */
+	if (stcl < 2 || stcl >= fs->n_fatent) stcl = 2;
+
+	scl = clst = stcl; ncl = 0;
+	for (;;) {								/* Find a contiguous cluster block */
+		n = get_fat(fs, clst);
+		if (n == 1) { res = FR_INT_ERR; break; }
+		if (n == 0xFFFFFFFF) { res = FR_DISK_ERR; break; }
+		if (n == 0) {						/* Is it a free cluster? */
+			if (++ncl == tcl) break;		/* Break if a contiguous cluster block is found */
+		} else {
+			ncl = 0;						/* Not a free cluster */
+		}
+		if (++clst >= fs->n_fatent) {		/* A block cannot wrap around the end of the FAT */
+			clst = 2; ncl = 0;
+		}
+		if (ncl == 0) scl = clst;			/* Block can only start at the next cluster */
+		if (clst == stcl) { res = FR_DENIED; break; }	/* No contiguous cluster block? */
+	}
+
+	if (res == FR_OK) {
+		if (opt) {							/* Allocate the cluster block */
+			for (clst = scl, n = tcl; n; clst++, n--) {
+				res = put_fat(fs, clst, (n == 1) ? 0x0FFFFFFF : clst + 1);
+				if (res != FR_OK) break;
+			}
+			if (res == FR_OK) {
+				fs->last_clust = scl + tcl - 1;
+				if (fs->free_clust != 0xFFFFFFFF) {	/* Update FSINFO */
+					fs->free_clust -= tcl;
+					fs->fsi_flag |= 1;
+				}
+				fp->sclust = scl;			/* Update object allocation information */
+				fp->fsize = fsz;
+				fp->flag |= FA__WRITTEN;
+			}
+		} else {							/* Set it as suggested point for next allocation */
+			fs->last_clust = scl - 1;
+		}
+	}
+
+	LEAVE_FF(fs, res);
+}
+#endif /* _USE_EXPAND */
+
+
+
 
 /*-----------------------------------------------------------------------*/
 /* Delete a File or Directory                                            */
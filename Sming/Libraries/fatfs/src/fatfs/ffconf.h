@@ -51,8 +51,14 @@
 /* This option switches f_mkfs() function. (0:Disable or 1:Enable) */
 
 
-#define	_USE_FASTSEEK	0
-/* This option switches fast seek feature. (0:Disable or 1:Enable) */
+#define	_USE_FASTSEEK	1
+/* This option switches fast seek feature. (0:Disable or 1:Enable)
+/  In fast seek mode, f_write() also writes across clusters which are contiguous
+/  on the volume with a single disk_write() call. */
+
+
+#define	_USE_EXPAND		1
+/* This option switches f_expand() function. (0:Disable or 1:Enable) */
 
 
 #define _USE_LABEL		0
@@ -0,0 +1,257 @@
+#include <SmingTest.h>
+#include <fatfs/ff.h>
+#include <fatfs/diskio.h>
+
+namespace
+{
+/*
+ * RAM disk holding a small FAT12 volume, one sector per cluster
+ */
+constexpr unsigned sectorSize{512};
+constexpr unsigned sectorCount{128};
+
+uint8_t disk[sectorCount * sectorSize];
+unsigned writeCalls;
+
+void format()
+{
+	memset(disk, 0, sizeof(disk));
+
+	// Boot sector
+	auto bs = disk;
+	bs[0] = 0xEB;
+	bs[1] = 0x3C;
+	bs[2] = 0x90;
+	memcpy(&bs[3], "MSDOS5.0", 8);
+	bs[11] = sectorSize & 0xFF; // Bytes per sector
+	bs[12] = sectorSize >> 8;
+	bs[13] = 1;  // Sectors per cluster
+	bs[14] = 1;  // Reserved sectors
+	bs[16] = 1;  // Number of FATs
+	bs[17] = 16; // Root directory entries
+	bs[19] = sectorCount;
+	bs[21] = 0xF8; // Media type
+	bs[22] = 1;	// Sectors per FAT
+	bs[38] = 0x29;
+	memcpy(&bs[54], "FAT12   ", 8);
+	bs[510] = 0x55;
+	bs[511] = 0xAA;
+
+	// Reserved FAT entries
+	auto fat = &disk[sectorSize];
+	fat[0] = 0xF8;
+	fat[1] = 0xFF;
+	fat[2] = 0xFF;
+}
+
+} // namespace
+
+DSTATUS disk_initialize(BYTE pdrv)
+{
+	return (pdrv == 0) ? 0 : STA_NOINIT;
+}
+
+DSTATUS disk_status(BYTE pdrv)
+{
+	return (pdrv == 0) ? 0 : STA_NOINIT;
+}
+
+DRESULT disk_read(BYTE pdrv, BYTE* buff, DWORD sector, UINT count)
+{
+	if(pdrv != 0 || sector + count > sectorCount) {
+		return RES_PARERR;
+	}
+	memcpy(buff, &disk[sector * sectorSize], count * sectorSize);
+	return RES_OK;
+}
+
+DRESULT disk_write(BYTE pdrv, const BYTE* buff, DWORD sector, UINT count)
+{
+	if(pdrv != 0 || sector + count > sectorCount) {
+		return RES_PARERR;
+	}
+	memcpy(&disk[sector * sectorSize], buff, count * sectorSize);
+	++writeCalls;
+	return RES_OK;
+}
+
+DRESULT disk_ioctl(BYTE pdrv, BYTE cmd, void* buff)
+{
+	return (pdrv == 0 && cmd == CTRL_SYNC) ? RES_OK : RES_PARERR;
+}
+
+class FatFsTest : public TestGroup
+{
+public:
+	FatFsTest() : TestGroup(_F("FatFs"))
+	{
+	}
+
+	void execute() override
+	{
+		format();
+		REQUIRE_EQ(f_mount(&fs, "", 1), FR_OK);
+
+		TEST_CASE("Fragmented write")
+		{
+			// Leave two 4-cluster holes between files
+			for(char c = 'a'; c <= 'e'; ++c) {
+				REQUIRE(writeFile(String(c), 4 * sectorSize, c));
+			}
+			REQUIRE_EQ(f_unlink("b"), FR_OK);
+			REQUIRE_EQ(f_unlink("d"), FR_OK);
+
+			// After re-mounting, allocation starts from the beginning of the volume
+			remount();
+			REQUIRE(writeFile("frag", 12 * sectorSize, 'x'));
+
+			FIL file;
+			REQUIRE_EQ(f_open(&file, "frag", FA_READ | FA_WRITE), FR_OK);
+			DWORD linkMap[16]{ARRAY_SIZE(linkMap)};
+			file.cltbl = linkMap;
+			REQUIRE_EQ(f_lseek(&file, CREATE_LINKMAP), FR_OK);
+			REQUIRE_EQ(linkMap[0], 8U); // Three fragments and terminator
+			REQUIRE_EQ(linkMap[1], 4U);
+			REQUIRE_EQ(linkMap[2], 6U);
+
+			// Each fragment is written in one call
+			REQUIRE_EQ(f_lseek(&file, 0), FR_OK);
+			fill(12 * sectorSize, 'y');
+			writeCalls = 0;
+			UINT bw{0};
+			REQUIRE_EQ(f_write(&file, buffer, 12 * sectorSize, &bw), FR_OK);
+			REQUIRE_EQ(bw, 12 * sectorSize);
+			REQUIRE_EQ(writeCalls, 3U);
+			REQUIRE_EQ(f_close(&file), FR_OK);
+
+			REQUIRE(checkFile("frag", 12 * sectorSize, 'y'));
+			REQUIRE(checkFile("c", 4 * sectorSize, 'c'));
+			REQUIRE(checkFile("e", 4 * sectorSize, 'e'));
+		}
+
+		TEST_CASE("Expand and truncate")
+		{
+			DWORD freeBefore = getFree();
+
+			FIL file;
+			REQUIRE_EQ(f_open(&file, "contig", FA_WRITE | FA_CREATE_ALWAYS), FR_OK);
+			REQUIRE_EQ(f_expand(&file, 8 * sectorSize, 1), FR_OK);
+			REQUIRE_EQ(f_size(&file), 8 * sectorSize);
+			REQUIRE_EQ(file.sclust, DWORD(26)); // Following "frag"
+
+			// Only an empty file can be expanded
+			REQUIRE_EQ(f_expand(&file, 16 * sectorSize, 1), FR_DENIED);
+
+			DWORD linkMap[8]{ARRAY_SIZE(linkMap)};
+			file.cltbl = linkMap;
+			REQUIRE_EQ(f_lseek(&file, CREATE_LINKMAP), FR_OK);
+			REQUIRE_EQ(linkMap[0], 4U); // Single fragment and terminator
+			REQUIRE_EQ(linkMap[1], 8U);
+
+			fill(3 * sectorSize, 'z');
+			writeCalls = 0;
+			UINT bw{0};
+			REQUIRE_EQ(f_write(&file, buffer, 3 * sectorSize, &bw), FR_OK);
+			REQUIRE_EQ(bw, 3 * sectorSize);
+			REQUIRE_EQ(writeCalls, 1U);
+
+			// Release unused clusters
+			REQUIRE_EQ(f_truncate(&file), FR_OK);
+			REQUIRE(file.cltbl == nullptr);
+			REQUIRE_EQ(f_size(&file), 3 * sectorSize);
+			REQUIRE_EQ(f_close(&file), FR_OK);
+			REQUIRE_EQ(getFree(), freeBefore - 3);
+
+			REQUIRE(checkFile("contig", 3 * sectorSize, 'z'));
+		}
+
+		TEST_CASE("Expand prepare mode")
+		{
+			FIL file;
+			REQUIRE_EQ(f_open(&file, "prep", FA_WRITE | FA_CREATE_ALWAYS), FR_OK);
+			REQUIRE_EQ(f_expand(&file, 4 * sectorSize, 0), FR_OK);
+			REQUIRE_EQ(f_size(&file), 0U);
+			REQUIRE_EQ(file.sclust, DWORD(0));
+
+			// Next allocation starts at the block found, within space released by truncating "contig"
+			fill(4 * sectorSize, 'p');
+			UINT bw{0};
+			REQUIRE_EQ(f_write(&file, buffer, 4 * sectorSize, &bw), FR_OK);
+			REQUIRE_EQ(file.sclust, DWORD(33));
+			REQUIRE_EQ(f_close(&file), FR_OK);
+			REQUIRE(checkFile("prep", 4 * sectorSize, 'p'));
+		}
+
+		TEST_CASE("Oversized expand")
+		{
+			DWORD freeBefore = getFree();
+
+			FIL file;
+			REQUIRE_EQ(f_open(&file, "big", FA_WRITE | FA_CREATE_ALWAYS), FR_OK);
+			REQUIRE_EQ(f_expand(&file, (freeBefore + 1) * sectorSize, 1), FR_DENIED);
+			// Enough free space in total, but not in one block
+			REQUIRE_EQ(f_expand(&file, freeBefore * sectorSize, 1), FR_DENIED);
+			REQUIRE_EQ(f_size(&file), 0U);
+			REQUIRE_EQ(f_close(&file), FR_OK);
+			REQUIRE_EQ(getFree(), freeBefore);
+		}
+
+		f_mount(nullptr, "", 0);
+	}
+
+private:
+	void remount()
+	{
+		REQUIRE_EQ(f_mount(nullptr, "", 0), FR_OK);
+		REQUIRE_EQ(f_mount(&fs, "", 1), FR_OK);
+	}
+
+	DWORD getFree()
+	{
+		DWORD count{0};
+		FATFS* pfs;
+		REQUIRE_EQ(f_getfree("", &count, &pfs), FR_OK);
+		return count;
+	}
+
+	void fill(size_t length, char c)
+	{
+		for(unsigned i = 0; i < length; ++i) {
+			buffer[i] = c + (i / sectorSize);
+		}
+	}
+
+	bool writeFile(const String& name, size_t length, char c)
+	{
+		FIL file;
+		if(f_open(&file, name.c_str(), FA_WRITE | FA_CREATE_ALWAYS) != FR_OK) {
+			return false;
+		}
+		fill(length, c);
+		UINT bw{0};
+		auto res = f_write(&file, buffer, length, &bw);
+		return f_close(&file) == FR_OK && res == FR_OK && bw == length;
+	}
+
+	bool checkFile(const String& name, size_t length, char c)
+	{
+		FIL file;
+		if(f_open(&file, name.c_str(), FA_READ) != FR_OK) {
+			return false;
+		}
+		static uint8_t data[sizeof(buffer)];
+		UINT br{0};
+		auto res = f_read(&file, data, sizeof(data), &br);
+		f_close(&file);
+		fill(length, c);
+		return res == FR_OK && br == length && memcmp(data, buffer, length) == 0;
+	}
+
+	FATFS fs;
+	uint8_t buffer[12 * sectorSize];
+};
+
+void REGISTER_TEST(FatFs)
+{
+	registerGroup<FatFsTest>();
+}
@@ -1,2 +1,2 @@
-COMPONENT_INCDIRS 		:= src/include
+COMPONENT_INCDIRS 		:= include src/include
 COMPONENT_SUBMODULES	:= src
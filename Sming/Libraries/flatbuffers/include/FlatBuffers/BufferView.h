@@ -0,0 +1,243 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/SmingHub/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * BufferView.h - In-place access to flatbuffers stored in flash
+ *
+ ****/
+
+#pragma once
+
+#include <flatbuffers/flatbuffers.h>
+#include <Storage/Partition.h>
+#include <FlashString/ObjectBase.hpp>
+#include <FileSystem.h>
+#include <memory>
+#include <new>
+
+namespace FlatBuffers
+{
+/**
+ * @brief Locates a serialised flatbuffer for in-place access
+ *
+ * Where the data is memory-mapped, such as a read-only partition or a FlashString, the buffer
+ * is accessed directly with no load step and no RAM cost.
+ * Otherwise, such as for a file or a partition on an external device, the content is loaded into RAM.
+ *
+ * Example:
+ *
+ * 		auto part = Storage::findPartition("profiles");
+ * 		auto view = FlatBuffers::BufferView::fromPartition(part);
+ * 		if(view.verify<DeviceProfile>()) {
+ * 			auto profile = view.getRoot<DeviceProfile>();
+ * 			...
+ * 		}
+ *
+ * On the ESP8266, table fields read through generated accessors are handled correctly if
+ * the buffer is in flash. However, strings, vectors of bytes and structs are accessed
+ * by pointer so must be copied into RAM first, using `toString()` or `read()`.
+ */
+class BufferView
+{
+public:
+	BufferView() = default;
+
+	/**
+	 * @brief Reference an existing buffer, which may be in flash
+	 */
+	BufferView(const void* data, size_t size) : data(static_cast<const uint8_t*>(data)), length(size)
+	{
+	}
+
+	BufferView(BufferView&& other)
+	{
+		*this = std::move(other);
+	}
+
+	BufferView& operator=(BufferView&& other)
+	{
+		if(this != &other) {
+			release();
+			buffer = std::move(other.buffer);
+			partition = other.partition;
+			data = other.data;
+			length = other.length;
+			other.partition = Storage::Partition{};
+			other.data = nullptr;
+			other.length = 0;
+		}
+		return *this;
+	}
+
+	~BufferView()
+	{
+		release();
+	}
+
+	/**
+	 * @brief Access a flatbuffer stored in a partition
+	 * @param partition
+	 * @param offset Start of buffer within partition
+	 * @param size Size of buffer, or 0 for remainder of partition
+	 * @retval BufferView Invalid if partition cannot be read
+	 */
+	static BufferView fromPartition(const Storage::Partition& partition, size_t offset = 0, size_t size = 0)
+	{
+		if(!partition || offset >= partition.size()) {
+			return BufferView();
+		}
+		if(size == 0 || size > partition.size() - offset) {
+			size = partition.size() - offset;
+		}
+
+		auto ptr = partition.getMappedPointer(offset, size);
+		if(ptr != nullptr) {
+			BufferView view(ptr, size);
+			view.partition = partition;
+			return view;
+		}
+
+		BufferView view;
+		if(view.allocate(size) && Storage::Partition(partition).read(offset, view.buffer.get(), size)) {
+			return view;
+		}
+		return BufferView();
+	}
+
+	/**
+	 * @brief Access a flatbuffer stored as a FlashString asset, for example via IMPORT_FSTR
+	 * @note FlashString data is always word-aligned
+	 */
+	static BufferView fromFlash(const FSTR::ObjectBase& object)
+	{
+		return BufferView(object.data(), object.size());
+	}
+
+	/**
+	 * @brief Load a flatbuffer from a file into RAM
+	 */
+	static BufferView fromFile(const String& filename)
+	{
+		BufferView view;
+		auto size = fileGetSize(filename);
+		if(size != 0 && view.allocate(size) && fileGetContent(filename, view.buffer.get(), size) == size) {
+			return view;
+		}
+		return BufferView();
+	}
+
+	explicit operator bool() const
+	{
+		return data != nullptr;
+	}
+
+	const uint8_t* getData() const
+	{
+		return data;
+	}
+
+	size_t size() const
+	{
+		return length;
+	}
+
+	/**
+	 * @brief Determine whether buffer is accessed in place, or has been loaded into RAM
+	 */
+	bool isMapped() const
+	{
+		return data != nullptr && !buffer;
+	}
+
+	/**
+	 * @brief Check buffer contains a valid flatbuffer of the given type
+	 * @param identifier Optional 4-character file identifier to check
+	 * @retval bool
+	 * @note On the ESP8266 the verifier reads single bytes directly, so buffers in flash are
+	 * verified using a temporary copy in RAM. The copy is released before returning.
+	 */
+	template <typename T> bool verify(const char* identifier = nullptr) const
+	{
+		if(data == nullptr) {
+			return false;
+		}
+#ifdef ARCH_ESP8266
+		if(isFlashPtr(data)) {
+			std::unique_ptr<char[]> tmp(new(std::nothrow) char[length]);
+			if(!tmp) {
+				return false;
+			}
+			memcpy_P(tmp.get(), data, length);
+			flatbuffers::Verifier verifier(reinterpret_cast<const uint8_t*>(tmp.get()), length);
+			return verifier.VerifyBuffer<T>(identifier);
+		}
+#endif
+		flatbuffers::Verifier verifier(data, length);
+		return verifier.VerifyBuffer<T>(identifier);
+	}
+
+	/**
+	 * @brief Get the root table
+	 * @retval const T* nullptr if buffer is invalid
+	 */
+	template <typename T> const T* getRoot() const
+	{
+		return data ? flatbuffers::GetRoot<T>(data) : nullptr;
+	}
+
+private:
+	void release()
+	{
+		if(partition) {
+			partition.releaseMappedPointer(data);
+			partition = Storage::Partition{};
+		}
+	}
+
+	bool allocate(size_t size)
+	{
+		buffer.reset(new(std::nothrow) char[size]);
+		if(!buffer) {
+			return false;
+		}
+		data = reinterpret_cast<const uint8_t*>(buffer.get());
+		length = size;
+		return true;
+	}
+
+	std::unique_ptr<char[]> buffer; ///< Used only if data cannot be accessed in place
+	Storage::Partition partition;   ///< Set if data is mapped from this partition
+	const uint8_t* data{nullptr};
+	size_t length{0};
+};
+
+/**
+ * @brief Copy a flatbuffer string into a String, safe for buffers in flash
+ */
+inline String toString(const flatbuffers::String* str)
+{
+	if(str == nullptr) {
+		return nullptr;
+	}
+	String s;
+	if(!s.setLength(str->size())) {
+		return nullptr;
+	}
+	memcpy_P(s.begin(), str->c_str(), str->size());
+	return s;
+}
+
+/**
+ * @brief Copy a flatbuffer struct into RAM, safe for buffers in flash
+ */
+template <typename T> T read(const T* value)
+{
+	static_assert(std::is_trivially_copyable<T>::value, "Type must be trivially copyable");
+	T result;
+	memcpy_P(&result, value, sizeof(T));
+	return result;
+}
+
+} // namespace FlatBuffers
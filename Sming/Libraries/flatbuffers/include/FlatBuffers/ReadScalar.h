@@ -0,0 +1,67 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/SmingHub/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * ReadScalar.h - Flash-safe scalar access for flatbuffers
+ *
+ * Included by `flatbuffers/base.h` (see src.patch) before the generic `ReadScalar()` is defined.
+ *
+ * The ESP8266 can only read memory-mapped flash using aligned 32-bit loads.
+ * Flatbuffer tables contain 8 and 16-bit values (vtable entries, for example) and 64-bit values
+ * which may not be aligned to 4 bytes, so reading them directly from flash causes an exception.
+ * All flatbuffer field access goes through `ReadScalar()`, so specialising it here is sufficient
+ * for generated accessors to work with buffers in flash.
+ *
+ ****/
+
+#pragma once
+
+#if defined(ARCH_ESP8266)
+
+#include <FakePgmSpace.h>
+#include <cstdint>
+
+namespace flatbuffers
+{
+template <typename T> T ReadScalar(const void* p);
+
+namespace detail
+{
+template <typename T> inline T readFlashSafe(const void* p)
+{
+	if(!isFlashPtr(p)) {
+		return *static_cast<const T*>(p);
+	}
+	// Flatbuffers are little-endian, as is the ESP8266, so no byte swapping is required
+	T value;
+	memcpy_P(&value, p, sizeof(T));
+	return value;
+}
+
+} // namespace detail
+
+#define FLATBUFFERS_READ_SCALAR_FLASH(T)                                                                               \
+	template <> inline T ReadScalar<T>(const void* p)                                                                  \
+	{                                                                                                                  \
+		return detail::readFlashSafe<T>(p);                                                                            \
+	}
+
+FLATBUFFERS_READ_SCALAR_FLASH(char)
+FLATBUFFERS_READ_SCALAR_FLASH(int8_t)
+FLATBUFFERS_READ_SCALAR_FLASH(uint8_t)
+FLATBUFFERS_READ_SCALAR_FLASH(int16_t)
+FLATBUFFERS_READ_SCALAR_FLASH(uint16_t)
+FLATBUFFERS_READ_SCALAR_FLASH(int32_t)
+FLATBUFFERS_READ_SCALAR_FLASH(uint32_t)
+FLATBUFFERS_READ_SCALAR_FLASH(int64_t)
+FLATBUFFERS_READ_SCALAR_FLASH(uint64_t)
+FLATBUFFERS_READ_SCALAR_FLASH(float)
+FLATBUFFERS_READ_SCALAR_FLASH(double)
+
+#undef FLATBUFFERS_READ_SCALAR_FLASH
+
+} // namespace flatbuffers
+
+#endif // ARCH_ESP8266
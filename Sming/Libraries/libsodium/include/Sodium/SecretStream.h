@@ -0,0 +1,204 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/SmingHub/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * SecretStream.h
+ *
+ ****/
+
+#pragma once
+
+#include <Core/Data/StreamTransformer.h>
+#include <Crypto/ByteArray.h>
+#include <Delegate.h>
+#include <sodium/crypto_secretstream_xchacha20poly1305.h>
+#include <memory>
+
+/**
+ * @brief Authenticated encryption of data streams using XChaCha20-Poly1305
+ *
+ * Data is split into chunks, each of which is encrypted and authenticated individually,
+ * so memory use is bounded by the chunk size regardless of the total stream length.
+ * Truncation, re-ordering or modification of chunks is detected.
+ *
+ * The container format is that produced by `otatool.py` for encrypted OTA upgrade files:
+ *
+ * - Secretstream header (24 bytes)
+ * - Chunks: 16-bit little-endian ciphertext length minus one, followed by the ciphertext
+ *
+ * The last chunk carries the FINAL tag.
+ */
+namespace Sodium
+{
+namespace SecretStream
+{
+constexpr size_t headerSize{crypto_secretstream_xchacha20poly1305_HEADERBYTES};
+constexpr size_t chunkOverhead{sizeof(uint16_t) + crypto_secretstream_xchacha20poly1305_ABYTES};
+constexpr size_t maxChunkSize{0x10000 - crypto_secretstream_xchacha20poly1305_ABYTES}; ///< Largest plaintext chunk
+
+using Key = Crypto::ByteArray<crypto_secretstream_xchacha20poly1305_KEYBYTES>;
+
+/**
+ * @brief Generate a new random key
+ */
+Key generateKey();
+
+/**
+ * @brief Encrypt data into chunks
+ */
+class Encoder
+{
+public:
+	Encoder(const Key& key);
+
+	~Encoder();
+
+	/**
+	 * @brief Get the stream header
+	 * @param buffer Receives headerSize bytes
+	 */
+	void getHeader(uint8_t* buffer) const
+	{
+		memcpy(buffer, header, headerSize);
+	}
+
+	/**
+	 * @brief Encrypt one chunk
+	 * @param in Plaintext
+	 * @param inLength Up to maxChunkSize bytes
+	 * @param out Output buffer, requires `inLength + chunkOverhead` bytes
+	 * @param final true for the last chunk in the stream
+	 * @retval size_t Number of bytes written to out, 0 on error
+	 */
+	size_t encrypt(const uint8_t* in, size_t inLength, uint8_t* out, bool final);
+
+private:
+	crypto_secretstream_xchacha20poly1305_state state;
+	uint8_t header[headerSize];
+};
+
+/**
+ * @brief Decrypt a stream of arbitrarily sized fragments
+ *
+ * A buffer is allocated to fit the largest chunk encountered.
+ */
+class Decoder
+{
+public:
+	enum class Error {
+		None,
+		DecryptionFailed, ///< Bad key, or data has been tampered with
+		ChunkTooLarge,	///< Chunk exceeds configured limit
+		OutOfMemory,
+		InvalidFormat, ///< Data following the final chunk
+		Aborted,	   ///< Callback returned false
+	};
+
+	/**
+	 * @brief Receives each decrypted chunk
+	 * @retval bool Return false to abort decoding
+	 */
+	using Callback = Delegate<bool(const uint8_t* data, size_t length)>;
+
+	/**
+	 * @brief Constructor
+	 * @param key
+	 * @param callback Invoked for each decrypted chunk
+	 * @param chunkLimit Largest ciphertext chunk accepted, limits memory usage
+	 */
+	Decoder(const Key& key, Callback callback, size_t chunkLimit = 0x10000);
+
+	~Decoder();
+
+	/**
+	 * @brief Process a fragment of the encrypted stream
+	 * @param data
+	 * @param size Need not correspond to chunk boundaries
+	 * @retval size_t Number of bytes consumed. If less than size, an error occurred.
+	 */
+	size_t write(const uint8_t* data, size_t size);
+
+	Error getError() const
+	{
+		return error;
+	}
+
+	/**
+	 * @brief Determine if the final chunk has been decoded successfully
+	 */
+	bool isFinished() const
+	{
+		return fragment == Fragment::None && error == Error::None;
+	}
+
+private:
+	enum class Fragment {
+		Header,
+		ChunkSize,
+		Chunk,
+		None,
+	};
+
+	Key key;
+	Callback callback;
+	crypto_secretstream_xchacha20poly1305_state state;
+	union {
+		uint8_t header[headerSize];
+		uint16_t chunkSizeMinusOne;
+	};
+	size_t chunkLimit;
+	Fragment fragment{Fragment::Header};
+	size_t remainingBytes{headerSize};
+	uint8_t* fragmentPtr{header};
+	std::unique_ptr<uint8_t[]> buffer;
+	size_t bufferSize{0};
+	Error error{Error::None};
+};
+
+/**
+ * @brief Read-only stream which encrypts content from a source stream
+ *
+ * Each block read from the source produces one chunk.
+ */
+class EncryptionStream : public StreamTransformer
+{
+public:
+	/**
+	 * @brief Constructor
+	 * @param stream Source stream, owned by this object
+	 * @param key
+	 * @param chunkSize Plaintext bytes per chunk
+	 * @note Encrypted chunks are staged in the 1kB transformer buffer, so chunkSize must not exceed 960 bytes
+	 */
+	EncryptionStream(IDataSourceStream* stream, const Key& key, size_t chunkSize = 512)
+		: StreamTransformer(stream, headerSize + chunkSize + chunkOverhead, chunkSize), encoder(key)
+	{
+		assert(chunkSize <= 960);
+	}
+
+	size_t transform(const uint8_t* in, size_t inLength, uint8_t* out, size_t outLength) override;
+
+	void saveState() override
+	{
+		savedEncoder = encoder;
+		savedHeaderSent = headerSent;
+	}
+
+	void restoreState() override
+	{
+		encoder = savedEncoder;
+		headerSent = savedHeaderSent;
+	}
+
+private:
+	Encoder encoder;
+	Encoder savedEncoder{encoder};
+	bool headerSent{false};
+	bool savedHeaderSent{false};
+	bool finalSent{false};
+};
+
+} // namespace SecretStream
+} // namespace Sodium
@@ -0,0 +1,183 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/SmingHub/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * SecretStream.cpp
+ *
+ ****/
+
+#include <Sodium/SecretStream.h>
+#include <sodium/utils.h>
+#include <new>
+
+namespace Sodium
+{
+namespace SecretStream
+{
+Key generateKey()
+{
+	Key key;
+	crypto_secretstream_xchacha20poly1305_keygen(key.data());
+	return key;
+}
+
+/* Encoder */
+
+Encoder::Encoder(const Key& key)
+{
+	crypto_secretstream_xchacha20poly1305_init_push(&state, header, key.data());
+}
+
+Encoder::~Encoder()
+{
+	sodium_memzero(&state, sizeof(state));
+}
+
+size_t Encoder::encrypt(const uint8_t* in, size_t inLength, uint8_t* out, bool final)
+{
+	if(inLength > maxChunkSize) {
+		return 0;
+	}
+
+	auto tag = final ? crypto_secretstream_xchacha20poly1305_TAG_FINAL : 0;
+	unsigned long long outLength{0};
+	crypto_secretstream_xchacha20poly1305_push(&state, &out[sizeof(uint16_t)], &outLength, in, inLength, nullptr, 0,
+											   tag);
+
+	uint16_t chunkSizeMinusOne = outLength - 1;
+	out[0] = chunkSizeMinusOne & 0xff;
+	out[1] = chunkSizeMinusOne >> 8;
+	return sizeof(uint16_t) + outLength;
+}
+
+/* Decoder */
+
+Decoder::Decoder(const Key& key, Callback callback, size_t chunkLimit)
+	: key(key), callback(callback), chunkLimit(chunkLimit)
+{
+}
+
+Decoder::~Decoder()
+{
+	sodium_memzero(key.data(), key.size());
+	sodium_memzero(&state, sizeof(state));
+}
+
+size_t Decoder::write(const uint8_t* data, size_t size)
+{
+	const size_t origSize = size;
+
+	while(error == Error::None && size > 0) {
+		if(fragment == Fragment::None) {
+			error = Error::InvalidFormat;
+			break;
+		}
+
+		size_t toConsume = std::min(remainingBytes, size);
+		memcpy(fragmentPtr, data, toConsume);
+		size -= toConsume;
+		data += toConsume;
+		fragmentPtr += toConsume;
+		remainingBytes -= toConsume;
+
+		if(remainingBytes != 0) {
+			continue;
+		}
+
+		switch(fragment) {
+		case Fragment::Header: {
+			bool ok = (crypto_secretstream_xchacha20poly1305_init_pull(&state, header, key.data()) == 0);
+			sodium_memzero(key.data(), key.size());
+			if(!ok) {
+				error = Error::DecryptionFailed;
+				break;
+			}
+			fragment = Fragment::ChunkSize;
+			fragmentPtr = reinterpret_cast<uint8_t*>(&chunkSizeMinusOne);
+			remainingBytes = sizeof(chunkSizeMinusOne);
+			break;
+		}
+
+		case Fragment::ChunkSize:
+			remainingBytes = 1 + chunkSizeMinusOne;
+			if(remainingBytes > chunkLimit) {
+				error = Error::ChunkTooLarge;
+				break;
+			}
+			if(!buffer || bufferSize < remainingBytes) {
+				buffer.reset(new(std::nothrow) uint8_t[remainingBytes]);
+				if(!buffer) {
+					bufferSize = 0;
+					error = Error::OutOfMemory;
+					break;
+				}
+				bufferSize = remainingBytes;
+			}
+			fragmentPtr = buffer.get();
+			fragment = Fragment::Chunk;
+			break;
+
+		case Fragment::Chunk: {
+			unsigned char tag;
+			size_t cipherTextLength = 1 + chunkSizeMinusOne;
+			unsigned long long messageLength = 0;
+			bool ok = (crypto_secretstream_xchacha20poly1305_pull(&state, buffer.get(), &messageLength, &tag,
+																  buffer.get(), cipherTextLength, nullptr, 0) == 0);
+			if(!ok || messageLength > bufferSize) {
+				error = Error::DecryptionFailed;
+				break;
+			}
+			if(tag != crypto_secretstream_xchacha20poly1305_TAG_FINAL) {
+				fragment = Fragment::ChunkSize;
+				fragmentPtr = reinterpret_cast<uint8_t*>(&chunkSizeMinusOne);
+				remainingBytes = sizeof(chunkSizeMinusOne);
+			} else {
+				fragment = Fragment::None;
+			}
+
+			if(callback && !callback(buffer.get(), size_t(messageLength))) {
+				error = Error::Aborted;
+			}
+			break;
+		}
+
+		case Fragment::None:
+			break;
+		}
+	}
+
+	return origSize - size;
+}
+
+/* EncryptionStream */
+
+size_t EncryptionStream::transform(const uint8_t* in, size_t inLength, uint8_t* out, size_t outLength)
+{
+	size_t n{0};
+	if(!headerSent) {
+		encoder.getHeader(out);
+		n += headerSize;
+		headerSent = true;
+	}
+
+	if(in == nullptr) {
+		if(finalSent) {
+			return n;
+		}
+		finalSent = true;
+		assert(n + chunkOverhead <= outLength);
+		return n + encoder.encrypt(nullptr, 0, &out[n], true);
+	}
+
+	if(inLength != 0) {
+		assert(n + inLength + chunkOverhead <= outLength);
+		n += encoder.encrypt(in, inLength, &out[n], false);
+	}
+
+	return n;
+}
+
+} // namespace SecretStream
+} // namespace Sodium
@@ -0,0 +1,149 @@
+#include <SmingTest.h>
+#include <Sodium/SecretStream.h>
+#include <Data/Stream/MemoryDataStream.h>
+#include <Platform/Timers.h>
+
+using namespace Sodium::SecretStream;
+
+namespace
+{
+String makeText(size_t length)
+{
+	String s;
+	s.reserve(length);
+	while(s.length() < length) {
+		s += F("The quick brown fox jumps over the lazy dog. ");
+	}
+	s.setLength(length);
+	return s;
+}
+
+String encrypt(const Key& key, const String& text, size_t chunkSize)
+{
+	auto src = new MemoryDataStream;
+	src->print(text);
+	EncryptionStream stream(src, key, chunkSize);
+	String output;
+	char buffer[256];
+	while(!stream.isFinished()) {
+		auto n = stream.readMemoryBlock(buffer, sizeof(buffer));
+		if(n == 0) {
+			continue;
+		}
+		output.concat(buffer, n);
+		stream.seek(n);
+	}
+	return output;
+}
+
+} // namespace
+
+class SecretStreamTest : public TestGroup
+{
+public:
+	SecretStreamTest() : TestGroup(_F("SecretStream"))
+	{
+	}
+
+	void execute() override
+	{
+		auto key = generateKey();
+		auto text = makeText(5000);
+
+		TEST_CASE("Round trip")
+		{
+			for(size_t chunkSize : {1U, 64U, 512U, 960U}) {
+				auto encrypted = encrypt(key, text, chunkSize);
+				unsigned chunks = (text.length() + chunkSize - 1) / chunkSize;
+				REQUIRE_EQ(encrypted.length(), headerSize + text.length() + (chunks + 1) * chunkOverhead);
+
+				// Feed decoder with irregular fragment sizes
+				String decrypted;
+				Decoder decoder(key, [&](const uint8_t* data, size_t length) {
+					decrypted.concat(reinterpret_cast<const char*>(data), length);
+					return true;
+				});
+				auto p = reinterpret_cast<const uint8_t*>(encrypted.c_str());
+				size_t offset{0};
+				for(size_t len = 1; offset < encrypted.length(); len = (len * 3) % 97 + 1) {
+					len = std::min(len, encrypted.length() - offset);
+					REQUIRE_EQ(decoder.write(&p[offset], len), len);
+					offset += len;
+				}
+				REQUIRE(decoder.isFinished());
+				REQUIRE(decrypted == text);
+			}
+		}
+
+		TEST_CASE("Tampering")
+		{
+			auto encrypted = encrypt(key, text, 512);
+			encrypted[headerSize + 600] ^= 0x01;
+			size_t received{0};
+			Decoder decoder(key, [&](const uint8_t*, size_t length) {
+				received += length;
+				return true;
+			});
+			auto len = decoder.write(reinterpret_cast<const uint8_t*>(encrypted.c_str()), encrypted.length());
+			REQUIRE(len < encrypted.length());
+			REQUIRE(decoder.getError() == Decoder::Error::DecryptionFailed);
+			REQUIRE_EQ(received, 512);
+		}
+
+		TEST_CASE("Truncation")
+		{
+			auto encrypted = encrypt(key, text, 512);
+			Decoder decoder(key, nullptr);
+			auto len = encrypted.length() - chunkOverhead;
+			REQUIRE_EQ(decoder.write(reinterpret_cast<const uint8_t*>(encrypted.c_str()), len), len);
+			REQUIRE(!decoder.isFinished());
+		}
+
+		TEST_CASE("Chunk limit")
+		{
+			auto encrypted = encrypt(key, text, 960);
+			Decoder decoder(key, nullptr, 512 + chunkOverhead);
+			decoder.write(reinterpret_cast<const uint8_t*>(encrypted.c_str()), encrypted.length());
+			REQUIRE(decoder.getError() == Decoder::Error::ChunkTooLarge);
+		}
+
+		TEST_CASE("Benchmark")
+		{
+			constexpr size_t dataSize{16384};
+			auto data = makeText(dataSize);
+			uint8_t out[960 + chunkOverhead];
+			Serial.println(_F("  chunk     encrypt MB/s  decrypt MB/s"));
+			for(size_t chunkSize : {64U, 256U, 960U}) {
+				Encoder encoder(key);
+				String encrypted;
+				encrypted.reserve(headerSize + dataSize + chunkOverhead * (1 + dataSize / chunkSize));
+				encoder.getHeader(out);
+				encrypted.concat(reinterpret_cast<const char*>(out), headerSize);
+
+				OneShotFastUs timer;
+				auto p = reinterpret_cast<const uint8_t*>(data.c_str());
+				for(size_t offset = 0; offset < dataSize; offset += chunkSize) {
+					auto len = std::min(chunkSize, dataSize - offset);
+					auto n = encoder.encrypt(&p[offset], len, out, offset + len == dataSize);
+					encrypted.concat(reinterpret_cast<const char*>(out), n);
+				}
+				auto encryptTime = std::max(timer.elapsedTime().time, 1U);
+
+				Decoder decoder(key, nullptr);
+				timer.start();
+				decoder.write(reinterpret_cast<const uint8_t*>(encrypted.c_str()), encrypted.length());
+				auto decryptTime = std::max(timer.elapsedTime().time, 1U);
+				REQUIRE(decoder.isFinished());
+
+				// bytes per microsecond == MB/s
+				Serial.printf(_F("  %5u  %12.2f  %12.2f\r\n"), chunkSize, float(dataSize) / encryptTime,
+							  float(dataSize) / decryptTime);
+			}
+		}
+	}
+};
+
+void REGISTER_TEST(SecretStream)
+{
+	registerGroup<SecretStreamTest>();
+}
@@ -0,0 +1,178 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/SmingHub/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * Input.cpp
+ *
+ ****/
+
+#include "include/Protobuf/Input.h"
+#include <lwip/pbuf.h>
+
+namespace Protobuf
+{
+/* InputSource */
+
+bool InputSource::readCallback(pb_istream_t* stream, pb_byte_t* buf, size_t count)
+{
+	auto self = static_cast<InputSource*>(stream->state);
+	assert(self != nullptr);
+	if(self->read(self->position, buf, count) != count) {
+		return false;
+	}
+	self->position += count;
+	return true;
+}
+
+bool InputSource::skip(pb_istream_t* stream, size_t count)
+{
+	auto self = fromStream(stream);
+	if(self == nullptr || count > stream->bytes_left) {
+		return false;
+	}
+	self->position += count;
+	stream->bytes_left -= count;
+	return true;
+}
+
+bool InputSource::decode(const pb_msgdesc_t* fields, void* dest_struct)
+{
+	pb_istream_t is{};
+	is.callback = readCallback;
+	is.state = this;
+	is.bytes_left = length - position;
+	bool res = pb_decode(&is, fields, dest_struct);
+	errmsg = is.errmsg;
+	return res;
+}
+
+/* MemoryInputSource */
+
+size_t MemoryInputSource::read(size_t offset, void* buffer, size_t count)
+{
+	memcpy_P(buffer, data + offset, count);
+	return count;
+}
+
+/* PartitionInputSource */
+
+size_t PartitionInputSource::read(size_t offset, void* buffer, size_t count)
+{
+	if(mappedData != nullptr) {
+		memcpy_P(buffer, mappedData + offset, count);
+		return count;
+	}
+
+	return partition.read(this->offset + offset, buffer, count) ? count : 0;
+}
+
+/* PbufInputSource */
+
+namespace
+{
+size_t getChainLength(const pbuf* buf)
+{
+	return buf ? buf->tot_len : 0;
+}
+
+} // namespace
+
+PbufInputSource::PbufInputSource(pbuf* buf, size_t offset, size_t length)
+	: InputSource(std::min(length, getChainLength(buf) - std::min(offset, getChainLength(buf)))), buf(buf),
+	  offset(offset)
+{
+}
+
+size_t PbufInputSource::read(size_t offset, void* buffer, size_t count)
+{
+	offset += this->offset;
+	auto out = static_cast<uint8_t*>(buffer);
+	size_t copied{0};
+	for(auto p = buf; p != nullptr && copied < count; p = p->next) {
+		if(offset >= p->len) {
+			offset -= p->len;
+			continue;
+		}
+		size_t len = std::min(size_t(p->len) - offset, count - copied);
+		memcpy(&out[copied], static_cast<const uint8_t*>(p->payload) + offset, len);
+		copied += len;
+		offset = 0;
+	}
+	return copied;
+}
+
+const uint8_t* PbufInputSource::getPointer(size_t offset, size_t count)
+{
+	offset += this->offset;
+	for(auto p = buf; p != nullptr; p = p->next) {
+		if(offset < p->len) {
+			return (offset + count <= p->len) ? static_cast<const uint8_t*>(p->payload) + offset : nullptr;
+		}
+		offset -= p->len;
+	}
+	return nullptr;
+}
+
+/* FieldView */
+
+bool FieldView::decode(pb_istream_t* stream)
+{
+	auto src = InputSource::fromStream(stream);
+	if(src == nullptr) {
+		return false;
+	}
+	source = src;
+	offset = src->getPosition();
+	length = stream->bytes_left;
+	return InputSource::skip(stream, length);
+}
+
+bool FieldView::equals(const char* value, size_t len) const
+{
+	if(source == nullptr || len != length) {
+		return false;
+	}
+
+	auto data = getData();
+	if(data != nullptr) {
+		return memcmp_P(value, data, len) == 0;
+	}
+
+	// Compare in chunks
+	char buffer[32];
+	for(size_t pos = 0; pos < len;) {
+		size_t n = std::min(len - pos, sizeof(buffer));
+		if(source->read(offset + pos, buffer, n) != n || memcmp(&value[pos], buffer, n) != 0) {
+			return false;
+		}
+		pos += n;
+	}
+	return true;
+}
+
+bool FieldView::operator==(const char* value) const
+{
+	return value ? equals(value, strlen(value)) : source == nullptr;
+}
+
+bool FieldView::operator==(const String& value) const
+{
+	return value ? equals(value.c_str(), value.length()) : source == nullptr;
+}
+
+FieldView::operator String() const
+{
+	if(source == nullptr) {
+		return nullptr;
+	}
+
+	String s;
+	if(!s.setLength(length) || read(s.begin(), length) != length) {
+		return nullptr;
+	}
+	return s;
+}
+
+} // namespace Protobuf
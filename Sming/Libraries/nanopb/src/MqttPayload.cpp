@@ -0,0 +1,76 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/SmingHub/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * MqttPayload.cpp
+ *
+ ****/
+
+#include "include/Protobuf/MqttPayload.h"
+
+namespace Protobuf
+{
+int MqttPayloadDecoder::dispatch(mqtt_message_t& message, const void* data, size_t length)
+{
+	decoded = true;
+	if(!handler) {
+		return 0;
+	}
+	MemoryInputSource source(data, length);
+	return handler(message, source);
+}
+
+int MqttPayloadDecoder::parse(MqttPayloadParserState& state, mqtt_message_t* message, const char* data, int length)
+{
+	if(message == nullptr) {
+		return -1;
+	}
+
+	size_t payloadLength = message->publish.content.length;
+
+	if(length == MQTT_PAYLOAD_PARSER_START) {
+		buffer.reset();
+		decoded = false;
+		state.offset = 0;
+		message->publish.content.data = nullptr;
+		return (payloadLength > maxLength) ? -2 : 0;
+	}
+
+	if(length == MQTT_PAYLOAD_PARSER_END) {
+		if(decoded) {
+			return 0;
+		}
+		if(state.offset != payloadLength) {
+			debug_e("[PB] Incomplete payload");
+			buffer.reset();
+			return -4;
+		}
+		int res = dispatch(*message, buffer.get(), payloadLength);
+		buffer.reset();
+		return res;
+	}
+
+	// Payload received in one piece: no need to copy
+	if(state.offset == 0 && size_t(length) == payloadLength) {
+		state.offset = length;
+		return dispatch(*message, data, length);
+	}
+
+	if(!buffer) {
+		buffer.reset(new(std::nothrow) uint8_t[payloadLength]);
+		if(!buffer) {
+			return -3;
+		}
+	}
+
+	if(state.offset + length > payloadLength) {
+		return -4;
+	}
+	memcpy(&buffer[state.offset], data, length);
+	state.offset += length;
+	return 0;
+}
+
+} // namespace Protobuf
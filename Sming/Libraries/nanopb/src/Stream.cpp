@@ -25,7 +25,7 @@ bool InputStream::decode(const pb_msgdesc_t* fields, void* dest_struct)
 		auto self = static_cast<InputStream*>(stream->state);
 		assert(self != nullptr);
 		size_t read = self->stream.readBytes(reinterpret_cast<char*>(buf), count);
-		return true;
+		return read == count;
 	};
 	is.state = this;
 	is.bytes_left = size_t(avail);
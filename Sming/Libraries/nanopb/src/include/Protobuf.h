@@ -12,6 +12,7 @@
 
 #include "Protobuf/Stream.h"
 #include "Protobuf/Callback.h"
+#include "Protobuf/Input.h"
 
 namespace Protobuf
 {
@@ -0,0 +1,297 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/SmingHub/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * Input.h
+ *
+ ****/
+
+#pragma once
+
+#include <WString.h>
+#include <pb_decode.h>
+#include <Storage/Partition.h>
+
+struct pbuf;
+
+namespace Protobuf
+{
+/**
+ * @brief Random-access source of encoded message data
+ *
+ * Decoding reads directly from the source into the destination structure, without first
+ * copying the message into a contiguous buffer.
+ * String and bytes fields may be attached to a `FieldView` so their content is not copied at all.
+ */
+class InputSource
+{
+public:
+	InputSource(size_t length) : length(length)
+	{
+	}
+
+	virtual ~InputSource()
+	{
+	}
+
+	/**
+	 * @brief Decode a message starting at the current position
+	 * @param fields Message descriptor
+	 * @param dest_struct Destination structure
+	 * @retval bool true on success
+	 */
+	bool decode(const pb_msgdesc_t* fields, void* dest_struct);
+
+	/**
+	 * @brief Read data from the source
+	 * @param offset Location relative to start of message
+	 * @param buffer
+	 * @param count Number of bytes to read
+	 * @retval size_t Number of bytes read
+	 */
+	virtual size_t read(size_t offset, void* buffer, size_t count) = 0;
+
+	/**
+	 * @brief Get a direct pointer to source data
+	 * @retval const uint8_t* nullptr if source data is not contiguous in memory for the given range
+	 * @note Data may be in flash, so must be accessed using `memcpy_P`, etc. or `pgm_read_xxx`
+	 */
+	virtual const uint8_t* getPointer(size_t offset, size_t count)
+	{
+		return nullptr;
+	}
+
+	/**
+	 * @brief Get number of bytes in message
+	 */
+	size_t getLength() const
+	{
+		return length;
+	}
+
+	/**
+	 * @brief Get current decoding position
+	 */
+	size_t getPosition() const
+	{
+		return position;
+	}
+
+	/**
+	 * @brief Set decoding position, e.g. to decode further messages from the same source
+	 */
+	void setPosition(size_t pos)
+	{
+		position = std::min(pos, length);
+	}
+
+	/**
+	 * @brief Get error message for the last call to `decode()`
+	 */
+	String getErrorString() const
+	{
+		return errmsg;
+	}
+
+	/**
+	 * @brief Obtain the source for a stream being decoded
+	 * @retval InputSource* nullptr if stream does not belong to an InputSource
+	 */
+	static InputSource* fromStream(pb_istream_t* stream)
+	{
+		return (stream->callback == readCallback) ? static_cast<InputSource*>(stream->state) : nullptr;
+	}
+
+	/**
+	 * @brief Advance position without reading, for use by field callbacks
+	 * @param stream Stream passed to the field callback
+	 * @param count Number of bytes to skip
+	 */
+	static bool skip(pb_istream_t* stream, size_t count);
+
+private:
+	static bool readCallback(pb_istream_t* stream, pb_byte_t* buf, size_t count);
+
+	size_t length;
+	size_t position{0};
+	const char* errmsg{nullptr};
+};
+
+/**
+ * @brief Decode from a memory buffer, which may be in flash
+ *
+ * Use this for memory-mapped flash partitions, FlashStrings or RAM buffers.
+ */
+class MemoryInputSource : public InputSource
+{
+public:
+	MemoryInputSource(const void* data, size_t length) : InputSource(length), data(static_cast<const uint8_t*>(data))
+	{
+	}
+
+	size_t read(size_t offset, void* buffer, size_t count) override;
+
+	const uint8_t* getPointer(size_t offset, size_t count) override
+	{
+		return data + offset;
+	}
+
+private:
+	const uint8_t* data;
+};
+
+/**
+ * @brief Decode from a partition
+ *
+ * The partition is accessed directly if it is memory-mapped, otherwise via `Partition::read()`.
+ */
+class PartitionInputSource : public InputSource
+{
+public:
+	/**
+	 * @brief Construct a partition input source
+	 * @param partition
+	 * @param offset Location of message within partition
+	 * @param length Size of message
+	 */
+	PartitionInputSource(const Storage::Partition& partition, size_t offset, size_t length)
+		: InputSource(length), partition(partition), offset(offset)
+	{
+		mappedData = static_cast<const uint8_t*>(partition.getMappedPointer(offset, length));
+	}
+
+	PartitionInputSource(const PartitionInputSource&) = delete;
+	PartitionInputSource& operator=(const PartitionInputSource&) = delete;
+
+	~PartitionInputSource()
+	{
+		partition.releaseMappedPointer(mappedData);
+	}
+
+	size_t read(size_t offset, void* buffer, size_t count) override;
+
+	const uint8_t* getPointer(size_t offset, size_t count) override
+	{
+		return mappedData ? mappedData + offset : nullptr;
+	}
+
+private:
+	Storage::Partition partition;
+	size_t offset;
+	const uint8_t* mappedData;
+};
+
+/**
+ * @brief Decode from a chain of pbufs, such as received by a TcpConnection
+ *
+ * Data is read from each pbuf payload in turn, the chain is not flattened.
+ * The pbuf is not owned by this object and must remain valid whilst it is in use.
+ */
+class PbufInputSource : public InputSource
+{
+public:
+	/**
+	 * @brief Construct a pbuf input source
+	 * @param buf First pbuf in chain
+	 * @param offset Location of message within chain
+	 * @param length Size of message, defaults to the remainder of the chain
+	 */
+	PbufInputSource(pbuf* buf, size_t offset = 0, size_t length = SIZE_MAX);
+
+	size_t read(size_t offset, void* buffer, size_t count) override;
+
+	const uint8_t* getPointer(size_t offset, size_t count) override;
+
+private:
+	pbuf* buf;
+	size_t offset;
+};
+
+/**
+ * @brief Records location of a string or bytes field without copying its content
+ *
+ * Attach to a `pb_callback_t` field before decoding. After decoding, content may be compared
+ * or read on demand, or accessed directly where the source is contiguous in memory.
+ * The view is only valid whilst the `InputSource` remains valid.
+ *
+ * If the field is repeated, only the last occurrence is recorded.
+ */
+class FieldView
+{
+public:
+	FieldView(pb_callback_t& cb) : cb(cb)
+	{
+		cb.arg = this;
+		cb.funcs.decode = static_decode;
+	}
+
+	~FieldView()
+	{
+		cb.arg = nullptr;
+		cb.funcs.decode = nullptr;
+	}
+
+	/**
+	 * @brief Determine if field was present in the message
+	 */
+	explicit operator bool() const
+	{
+		return source != nullptr;
+	}
+
+	size_t getLength() const
+	{
+		return length;
+	}
+
+	/**
+	 * @brief Get a direct pointer to the field content
+	 * @retval const uint8_t* nullptr if field is absent or source is not contiguous
+	 * @note Data may be in flash
+	 */
+	const uint8_t* getData() const
+	{
+		return source ? source->getPointer(offset, length) : nullptr;
+	}
+
+	/**
+	 * @brief Copy content into a buffer
+	 * @param buffer
+	 * @param bufSize
+	 * @retval size_t Number of bytes read
+	 */
+	size_t read(void* buffer, size_t bufSize) const
+	{
+		return source ? source->read(offset, buffer, std::min(bufSize, length)) : 0;
+	}
+
+	bool operator==(const char* value) const;
+
+	bool operator==(const String& value) const;
+
+	template <typename T> bool operator!=(const T& value) const
+	{
+		return !operator==(value);
+	}
+
+	explicit operator String() const;
+
+private:
+	static bool static_decode(pb_istream_t* stream, const pb_field_t* field, void** arg)
+	{
+		auto self = static_cast<FieldView*>(*arg);
+		return self ? self->decode(stream) : false;
+	}
+
+	bool decode(pb_istream_t* stream);
+	bool equals(const char* value, size_t len) const;
+
+	pb_callback_t& cb;
+	InputSource* source{nullptr};
+	size_t offset{0};
+	size_t length{0};
+};
+
+} // namespace Protobuf
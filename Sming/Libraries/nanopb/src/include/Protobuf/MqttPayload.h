@@ -0,0 +1,86 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/SmingHub/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * MqttPayload.h
+ *
+ ****/
+
+#pragma once
+
+#include "Input.h"
+#include <Network/Mqtt/MqttPayloadParser.h>
+#include <memory>
+
+namespace Protobuf
+{
+/**
+ * @brief Decode protobuf messages received as MQTT PUBLISH payloads
+ *
+ * Where a payload arrives in a single fragment it is decoded directly from the receive buffer.
+ * Otherwise fragments are collected into one buffer, allocated once to the size of the payload.
+ *
+ * Example:
+ *
+ * 		Protobuf::MqttPayloadDecoder decoder([](mqtt_message_t& message, Protobuf::InputSource& source) -> int {
+ * 			Telemetry msg = Telemetry_init_default;
+ * 			Protobuf::FieldView name(msg.name);
+ * 			if(!source.decode(Telemetry_fields, &msg)) {
+ * 				return -1;
+ * 			}
+ * 			...
+ * 			return 0;
+ * 		});
+ *
+ * 		mqtt.setPayloadParser(decoder.getParser());
+ *
+ * The handler is called before the message handler. The message content buffer is always empty.
+ *
+ * @note A decoder handles one message at a time so must only be used with one MqttClient.
+ */
+class MqttPayloadDecoder
+{
+public:
+	/**
+	 * @brief Callback to decode a complete payload
+	 * @param message
+	 * @param source Payload data, valid only during the callback
+	 * @retval int 0 on success, as for MqttPayloadParser
+	 */
+	using Handler = Delegate<int(mqtt_message_t& message, InputSource& source)>;
+
+	/**
+	 * @brief Construct a decoder
+	 * @param handler
+	 * @param maxLength Payloads larger than this are rejected
+	 */
+	MqttPayloadDecoder(Handler handler, size_t maxLength = MQTT_PAYLOAD_LENGTH)
+		: handler(handler), maxLength(maxLength)
+	{
+	}
+
+	/**
+	 * @brief Get a parser delegate for `MqttClient::setPayloadParser()` or `MqttStreamRouter::add()`
+	 */
+	MqttPayloadParser getParser()
+	{
+		return MqttPayloadParser(&MqttPayloadDecoder::parse, this);
+	}
+
+	/**
+	 * @brief Payload parser implementation
+	 */
+	int parse(MqttPayloadParserState& state, mqtt_message_t* message, const char* buffer, int length);
+
+private:
+	int dispatch(mqtt_message_t& message, const void* data, size_t length);
+
+	Handler handler;
+	size_t maxLength;
+	std::unique_ptr<uint8_t[]> buffer;
+	bool decoded{false};
+};
+
+} // namespace Protobuf
@@ -0,0 +1,149 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/SmingHub/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * CpuGovernor.cpp
+ *
+ ****/
+
+#include "CpuGovernor.h"
+#include <debug_progmem.h>
+
+namespace
+{
+#if defined(ARCH_ESP8266)
+constexpr CpuFrequency levels[]{eCF_80MHz, eCF_160MHz};
+#elif defined(ARCH_ESP32)
+constexpr CpuFrequency levels[]{eCF_80MHz, eCF_160MHz, eCF_240MHz};
+#else
+constexpr CpuFrequency levels[]{eCF_80MHz, eCF_125MHz, eCF_133MHz};
+#endif
+constexpr unsigned levelCount{ARRAY_SIZE(levels)};
+
+} // namespace
+
+void CpuGovernor::begin(const Config& config)
+{
+	end();
+	this->config = config;
+
+	minLevel = levelCount - 1;
+	maxLevel = 0;
+	for(unsigned i = 0; i < levelCount; ++i) {
+		if(levels[i] >= config.minFrequency && i < minLevel) {
+			minLevel = i;
+		}
+		if(levels[i] <= config.maxFrequency) {
+			maxLevel = i;
+		}
+	}
+	if(minLevel > maxLevel) {
+		minLevel = maxLevel;
+	}
+
+	// Not all chip variants support the highest level
+	while(maxLevel > minLevel && !System.setCpuFrequency(levels[maxLevel])) {
+		--maxLevel;
+	}
+	setLevel(maxLevel);
+
+	active = true;
+	usage.begin([this]() { start(); });
+}
+
+void CpuGovernor::start()
+{
+	if(!active) {
+		return;
+	}
+
+	idleStart = millis();
+	timer.initializeMs(
+		config.interval, [](void* param) { static_cast<CpuGovernor*>(param)->update(); }, this);
+	timer.start();
+	debug_i("[CPUGOV] Started, %u - %u MHz", levels[minLevel], levels[maxLevel]);
+}
+
+void CpuGovernor::end()
+{
+	if(!active) {
+		return;
+	}
+
+	active = false;
+	timer.stop();
+	usage.end();
+	setLevel(maxLevel);
+}
+
+void CpuGovernor::boost(uint32_t duration)
+{
+	if(!active) {
+		return;
+	}
+
+	auto now = millis();
+	if(duration != 0 && int32_t(now + duration - boostEnd) > 0) {
+		boostEnd = now + duration;
+	}
+	idleStart = now;
+	setLevel(maxLevel);
+}
+
+void CpuGovernor::update()
+{
+	utilisation = usage.getUtilisation() / 100;
+	usage.reset();
+
+	auto now = millis();
+	bool busy = (utilisation >= config.boostThreshold) || int32_t(boostEnd - now) > 0;
+#ifdef ENABLE_TASK_COUNT
+	busy |= System.getTaskCount() >= config.queueThreshold;
+#endif
+	if(busy) {
+		idleStart = now;
+		setLevel(maxLevel);
+		return;
+	}
+
+	if(utilisation >= config.idleThreshold || level == minLevel) {
+		idleStart = now;
+		return;
+	}
+
+	if(now - idleStart < config.holdTime) {
+		return;
+	}
+
+	// Load scales inversely with frequency: don't step down if that would cause a boost
+	unsigned projected = utilisation * levels[level] / levels[level - 1];
+	if(projected >= (config.idleThreshold + config.boostThreshold) / 2U) {
+		return;
+	}
+
+	setLevel(level - 1);
+	idleStart = now;
+}
+
+bool CpuGovernor::setLevel(unsigned index)
+{
+	if(index == level && System.getCpuFrequency() == levels[index]) {
+		return true;
+	}
+
+	auto freq = levels[index];
+	if(!System.setCpuFrequency(freq)) {
+		debug_w("[CPUGOV] Failed to set %u MHz", freq);
+		return false;
+	}
+
+	level = index;
+	++changeCount;
+	debug_d("[CPUGOV] %u MHz, load %u%%", freq, utilisation);
+	if(changeCallback) {
+		changeCallback(freq);
+	}
+	return true;
+}
@@ -0,0 +1,121 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/SmingHub/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * CpuGovernor.h - Dynamic CPU frequency scaling
+ *
+ ****/
+
+#pragma once
+
+#include "System.h"
+#include <SimpleTimer.h>
+#include <Services/Profiling/CpuUsage.h>
+
+/**
+ * @brief Adjusts CPU frequency according to load
+ *
+ * CPU utilisation is measured using Profiling::CpuUsage. When it exceeds `boostThreshold`,
+ * or the task queue grows to `queueThreshold`, the CPU switches immediately to the maximum frequency.
+ * Once utilisation has stayed below `idleThreshold` for `holdTime`, the frequency steps down one level.
+ * It does not step down if the load at the lower frequency would be expected to trigger a boost,
+ * so the frequency does not flap between levels.
+ *
+ * Peripheral clocks (UART, hardware timers) do not depend on the CPU clock so are unaffected by changes.
+ * Code which counts CPU cycles (such as CpuCycleTimer) should not span a frequency change.
+ *
+ * Available levels are 80/160 MHz for Esp8266, 80/160/240 MHz for Esp32 (where supported by the chip)
+ * and 80/125/133 MHz for Rp2040.
+ */
+class CpuGovernor
+{
+public:
+	struct Config {
+		CpuFrequency minFrequency{eCF_80MHz};  ///< Lowest frequency to use
+		CpuFrequency maxFrequency{eCF_240MHz}; ///< Highest frequency to use, limited to what the chip supports
+		uint16_t interval{100};				   ///< Sampling interval in milliseconds
+		uint16_t holdTime{2000};			   ///< Milliseconds below idle threshold before stepping down
+		uint8_t boostThreshold{70};			   ///< Utilisation (percent) which triggers a boost
+		uint8_t idleThreshold{25};			   ///< Utilisation (percent) below which frequency may be reduced
+		uint8_t queueThreshold{4};			   ///< Task queue depth which triggers a boost (requires ENABLE_TASK_COUNT)
+	};
+
+	using ChangeCallback = Delegate<void(CpuFrequency freq)>;
+
+	~CpuGovernor()
+	{
+		end();
+	}
+
+	/**
+	 * @brief Start the governor
+	 * @param config
+	 *
+	 * Runs at the maximum frequency whilst Profiling::CpuUsage is calibrated,
+	 * so call from `init()` before the application gets busy.
+	 */
+	void begin(const Config& config = {});
+
+	/**
+	 * @brief Stop the governor and return to the maximum frequency
+	 */
+	void end();
+
+	/**
+	 * @brief Switch to maximum frequency immediately
+	 * @param duration Minimum time to remain there, in milliseconds
+	 *
+	 * Use before work known to be CPU-intensive, such as an SSL handshake.
+	 */
+	void boost(uint32_t duration = 0);
+
+	/**
+	 * @brief Set callback to be invoked after the frequency changes
+	 */
+	void onChange(ChangeCallback callback)
+	{
+		changeCallback = callback;
+	}
+
+	/**
+	 * @brief Get utilisation measured over the most recent interval
+	 * @retval unsigned Percent of available CPU time, at the frequency in use at the time
+	 */
+	unsigned getUtilisation() const
+	{
+		return utilisation;
+	}
+
+	/**
+	 * @brief Get number of frequency changes made
+	 */
+	unsigned getChangeCount() const
+	{
+		return changeCount;
+	}
+
+	bool isActive() const
+	{
+		return active;
+	}
+
+private:
+	void start();
+	void update();
+	bool setLevel(unsigned index);
+
+	Profiling::CpuUsage usage;
+	SimpleTimer timer;
+	ChangeCallback changeCallback;
+	Config config;
+	uint32_t idleStart{0};
+	uint32_t boostEnd{0};
+	unsigned changeCount{0};
+	uint8_t minLevel{0};
+	uint8_t maxLevel{0};
+	uint8_t level{0};
+	uint8_t utilisation{0};
+	bool active{false};
+};
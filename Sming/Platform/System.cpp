@@ -10,15 +10,18 @@
 
 #include "Platform/System.h"
 #include "Timer.h"
+#include <Services/Profiling/Trace.h>
+#include <Services/Profiling/CallbackTiming.h>
+#include <Services/Profiling/BootTimeline.h>
+#include <Services/Profiling/StackUsage.h>
+#if ENABLE_TASK_TIMING
+#include <esp_clk.h>
+#endif
+#include <stringutil.h>
 
 SystemClass System;
 SystemState SystemClass::state = eSS_None;
 
-#ifdef ARCH_ESP32
-#undef TASK_QUEUE_LENGTH
-#define TASK_QUEUE_LENGTH 0
-#define taskQueue nullptr
-#else
 #ifdef TASK_QUEUE_LENGTH
 static_assert(TASK_QUEUE_LENGTH >= 8, "Task queue too small");
 #else
@@ -28,27 +31,176 @@ static_assert(TASK_QUEUE_LENGTH >= 8, "Task queue too small");
  */
 #define TASK_QUEUE_LENGTH 10
 #endif
-os_event_t SystemClass::taskQueue[TASK_QUEUE_LENGTH];
+#ifndef TASK_QUEUE_LENGTH_HIGH
+/** @brief default number of tasks in high-priority queue
+ *  @note Set to 0 to disable the queue, in which case such tasks are posted to the normal queue.
+ */
+#define TASK_QUEUE_LENGTH_HIGH 4
+#endif
+#ifndef TASK_QUEUE_LENGTH_LOW
+/** @brief default number of tasks in low-priority queue
+ *  @note Set to 0 to disable the queue, in which case such tasks are posted to the normal queue.
+ */
+#define TASK_QUEUE_LENGTH_LOW 4
 #endif
 
-#ifdef ENABLE_TASK_COUNT
-volatile uint8_t SystemClass::taskCount;
-volatile uint8_t SystemClass::maxTaskCount;
+TaskQueueStats SystemClass::taskQueueStats[taskPriorityCount];
+
+namespace
+{
+#if TASK_QUEUE_LENGTH_LOW
+os_event_t taskQueueLow[TASK_QUEUE_LENGTH_LOW];
+#else
+#define taskQueueLow nullptr
+#endif
+#if TASK_QUEUE_LENGTH
+os_event_t taskQueueNormal[TASK_QUEUE_LENGTH];
+#else
+#define taskQueueNormal nullptr
+#endif
+#if TASK_QUEUE_LENGTH_HIGH
+os_event_t taskQueueHigh[TASK_QUEUE_LENGTH_HIGH];
+#else
+#define taskQueueHigh nullptr
+#endif
+
+struct TaskQueueInfo {
+	uint8_t osPriority;
+	uint8_t length;
+	os_event_t* events;
+};
+
+// Indexed by TaskPriority
+constexpr TaskQueueInfo taskQueueInfo[]{
+	{USER_TASK_PRIO_0, TASK_QUEUE_LENGTH_LOW, taskQueueLow},
+	{USER_TASK_PRIO_1, TASK_QUEUE_LENGTH, taskQueueNormal},
+	{USER_TASK_PRIO_2, TASK_QUEUE_LENGTH_HIGH, taskQueueHigh},
+};
+
+static_assert(ARRAY_SIZE(taskQueueInfo) == taskPriorityCount, "Task queue table size mismatch");
+
+// Set during initialisation for each queue successfully created
+bool taskQueueActive[taskPriorityCount];
+
+} // namespace
+
+#ifdef TASK_DELEGATE_POOL_SIZE
+static_assert(TASK_DELEGATE_POOL_SIZE <= 255, "Task delegate pool too large");
+#else
+/** @brief default number of pre-allocated slots for queued Delegate callbacks
+ *  @note If the pool is exhausted then slots are allocated from the heap.
+ *  Check `SystemClass::getMaxDelegateCount()` to establish an appropriate size.
+ */
+#define TASK_DELEGATE_POOL_SIZE 8
 #endif
 
+namespace
+{
+/**
+ * @brief Fixed-size pool of slots for queued delegates
+ *
+ * `queueCallback(TaskDelegate)` is heavily used so allocating each delegate
+ * from the heap is slow and leads to fragmentation.
+ *
+ * Slots are handed out initially in order, then recycled via a free stack.
+ * The pool is constructed with other globals, so delegates must not be queued from global constructors.
+ */
+class TaskDelegatePool
+{
+public:
+	TaskDelegate* allocate()
+	{
+		TaskDelegate* slot{nullptr};
+		auto level = noInterrupts();
+		if(freeCount != 0) {
+			slot = &slots[freeStack[--freeCount]];
+		} else if(issued < TASK_DELEGATE_POOL_SIZE) {
+			slot = &slots[issued++];
+		}
+		if(slot != nullptr) {
+			++used;
+			if(used > maxUsed) {
+				maxUsed = used;
+			}
+		}
+		restoreInterrupts(level);
+		return slot;
+	}
+
+	void release(TaskDelegate* slot)
+	{
+		auto level = noInterrupts();
+		freeStack[freeCount++] = slot - slots;
+		--used;
+		restoreInterrupts(level);
+	}
+
+	bool contains(const TaskDelegate* slot) const
+	{
+		return slot >= slots && slot < &slots[TASK_DELEGATE_POOL_SIZE];
+	}
+
+	uint8_t getUsed() const
+	{
+		return used;
+	}
+
+	uint8_t getMaxUsed() const
+	{
+		return maxUsed;
+	}
+
+private:
+	TaskDelegate slots[TASK_DELEGATE_POOL_SIZE];
+	uint8_t freeStack[TASK_DELEGATE_POOL_SIZE];
+	uint8_t freeCount;
+	uint8_t issued;
+	uint8_t used;
+	uint8_t maxUsed;
+};
+
+TaskDelegatePool delegatePool;
+uint16_t delegatePoolOverflows;
+
+void releaseDelegate(TaskDelegate* delegate)
+{
+	if(delegatePool.contains(delegate)) {
+		*delegate = nullptr;
+		delegatePool.release(delegate);
+	} else {
+		delete delegate;
+	}
+}
+
+} // namespace
+
 /** @brief OS calls this function which invokes user-defined callback
  *  @note callback function pointer is placed in event->sig, with parameter in event->par.
  */
-void SystemClass::taskHandler(os_event_t* event)
+template <TaskPriority priority> void SystemClass::taskHandler(os_event_t* event)
 {
 #ifdef ENABLE_TASK_COUNT
 	auto level = noInterrupts();
-	--taskCount;
+	--taskQueueStats[unsigned(priority)].count;
 	restoreInterrupts(level);
 #endif
 	auto callback = reinterpret_cast<TaskCallback32>(event->sig);
 	if(callback != nullptr) {
+		TRACE_SCOPE("task", callback);
+#if ENABLE_TASK_TIMING
+#if ENABLE_STACK_USAGE
+		auto stackStart = Profiling::StackUsage::beginMeasure();
+#endif
+		auto startCycles = esp_get_ccount();
+		callback(event->par);
+		Profiling::CallbackTiming::record(reinterpret_cast<const void*>(callback), esp_get_ccount() - startCycles);
+#if ENABLE_STACK_USAGE
+		Profiling::CallbackTiming::recordStack(reinterpret_cast<const void*>(callback),
+											   Profiling::StackUsage::endMeasure(stackStart));
+#endif
+#else
 		callback(event->par);
+#endif
 	}
 }
 
@@ -60,39 +212,80 @@ bool SystemClass::initialize()
 
 	state = eSS_Intializing;
 
-	// Initialise the global task queue
-	if(!system_os_task(taskHandler, USER_TASK_PRIO_1, taskQueue, TASK_QUEUE_LENGTH)) {
+#if ENABLE_STACK_USAGE
+	Profiling::StackUsage::paint();
+#endif
+
+	// Initialise the global task queues
+	const os_task_t handlers[]{
+		taskHandler<TaskPriority::Low>,
+		taskHandler<TaskPriority::Normal>,
+		taskHandler<TaskPriority::High>,
+	};
+	for(unsigned i = 0; i < taskPriorityCount; ++i) {
+		auto& info = taskQueueInfo[i];
+		if(info.length == 0) {
+			continue;
+		}
+		taskQueueActive[i] = system_os_task(handlers[i], info.osPriority, info.events, info.length);
+	}
+
+	// The normal queue is mandatory
+	if(!taskQueueActive[unsigned(TaskPriority::Normal)]) {
 		return false;
 	}
 
 #ifdef ARCH_ESP8266
-	system_init_done_cb([]() { state = eSS_Ready; });
+	system_init_done_cb([]() {
+		BOOT_PHASE_MARK(systemReady);
+		state = eSS_Ready;
+	});
 #else
+	BOOT_PHASE_MARK(systemReady);
 	state = eSS_Ready;
 #endif
 
 	return true;
 }
 
-bool SystemClass::queueCallback(TaskCallback32 callback, uint32_t param)
+bool SystemClass::queueCallback(TaskPriority priority, TaskCallback32 callback, uint32_t param)
 {
 	if(callback == nullptr) {
 		return false;
 	}
 
+	auto index = unsigned(priority);
+	if(index >= taskPriorityCount || !taskQueueActive[index]) {
+		index = unsigned(TaskPriority::Normal);
+	}
+	auto& stats = taskQueueStats[index];
+
 #ifdef ENABLE_TASK_COUNT
 	auto level = noInterrupts();
-	++taskCount;
-	if(taskCount > maxTaskCount) {
-		maxTaskCount = taskCount;
+	++stats.count;
+	if(stats.count > stats.maxCount) {
+		stats.maxCount = stats.count;
 	}
 	restoreInterrupts(level);
 #endif
 
-	return system_os_post(USER_TASK_PRIO_1, reinterpret_cast<os_signal_t>(callback), param);
+	if(system_os_post(taskQueueInfo[index].osPriority, reinterpret_cast<os_signal_t>(callback), param)) {
+		return true;
+	}
+
+#ifdef ENABLE_TASK_COUNT
+	level = noInterrupts();
+	--stats.count;
+#else
+	auto level = noInterrupts();
+#endif
+	++stats.overflows;
+	restoreInterrupts(level);
+
+	return false;
 }
 
-bool SystemClass::queueCallback(TaskDelegate callback)
+bool SystemClass::queueCallback(TaskPriority priority, TaskDelegate callback)
 {
 	if(!callback) {
 		return false;
@@ -100,25 +293,49 @@ bool SystemClass::queueCallback(TaskDelegate callback)
 
 	// @todo consider failing immediately if called from interrupt context
 
-	auto delegate = new TaskDelegate(callback);
-	if(delegate == nullptr) {
-		return false;
+	auto delegate = delegatePool.allocate();
+	if(delegate != nullptr) {
+		*delegate = std::move(callback);
+	} else {
+		// Pool exhausted, fall back to heap
+		delegate = new TaskDelegate(std::move(callback));
+		if(delegate == nullptr) {
+			return false;
+		}
+		++delegatePoolOverflows;
 	}
 
 	auto delegateHandler = [](void* param) {
 		auto delegate = static_cast<TaskDelegate*>(param);
-		(*delegate)();
-		delete delegate;
+		// Free the slot before invoking so callback may re-queue itself
+		TaskDelegate callback(std::move(*delegate));
+		releaseDelegate(delegate);
+		callback();
 	};
 
-	if(!queueCallback(delegateHandler, delegate)) {
-		delete delegate;
+	if(!queueCallback(priority, delegateHandler, delegate)) {
+		releaseDelegate(delegate);
 		return false;
 	}
 
 	return true;
 }
 
+unsigned SystemClass::getDelegateCount()
+{
+	return delegatePool.getUsed();
+}
+
+unsigned SystemClass::getMaxDelegateCount()
+{
+	return delegatePool.getMaxUsed();
+}
+
+unsigned SystemClass::getDelegatePoolOverflows()
+{
+	return delegatePoolOverflows;
+}
+
 void SystemClass::restart(unsigned deferMillis)
 {
 	if(deferMillis == 0) {
@@ -49,6 +49,31 @@ using TaskDelegate = Delegate<void()>;
  */
 using SystemReadyDelegate = TaskDelegate;
 
+/**
+ * @brief Task queue priority
+ * @note Queues are serviced in priority order, so high-priority tasks queued
+ * before normal/low priority ones will always be executed first.
+ */
+enum class TaskPriority {
+	Low,	///< Background work which can withstand some latency
+	Normal, ///< Default priority
+	High,   ///< Latency-sensitive work
+};
+
+/**
+ * @brief Number of available task priorities
+ */
+constexpr unsigned taskPriorityCount{3};
+
+/**
+ * @brief Task queue statistics
+ */
+struct TaskQueueStats {
+	uint8_t count;		///< Number of tasks currently on queue (requires ENABLE_TASK_COUNT)
+	uint8_t maxCount;   ///< Maximum number of tasks seen on queue (requires ENABLE_TASK_COUNT)
+	uint16_t overflows; ///< Number of tasks rejected because queue was full
+};
+
 /**
  * @brief Interface class implemented by classes to support on-ready callback
  */
@@ -183,6 +208,7 @@ public:
 
 	/**
 	 * @brief Queue a deferred callback.
+	 * @param priority Queue to post the callback to
 	 * @param callback The function to be called
 	 * @param param Parameter passed to the callback (optional)
 	 * @retval bool false if callback could not be queued
@@ -190,71 +216,135 @@ public:
 	 * for example if memory is allocated and relies on the callback to free it again.
 	 * Note also that this method is typically called from interrupt context so must avoid things
 	 * like heap allocation, etc.
+	 * If the requested priority queue is disabled (zero length) then the normal queue is used.
 	 */
-	static bool IRAM_ATTR queueCallback(TaskCallback32 callback, uint32_t param = 0);
+	static bool IRAM_ATTR queueCallback(TaskPriority priority, TaskCallback32 callback, uint32_t param = 0);
 
 	/**
 	 * @brief Queue a deferred callback, with optional void* parameter
 	 */
-	__forceinline static bool IRAM_ATTR queueCallback(TaskCallback callback, void* param = nullptr)
+	__forceinline static bool IRAM_ATTR queueCallback(TaskPriority priority, TaskCallback callback,
+													  void* param = nullptr)
 	{
-		return queueCallback(reinterpret_cast<TaskCallback32>(callback), reinterpret_cast<uint32_t>(param));
+		return queueCallback(priority, reinterpret_cast<TaskCallback32>(callback), reinterpret_cast<uint32_t>(param));
 	}
 
 	/**
 	 * @brief Queue a deferred callback with no callback parameter
 	 */
-	__forceinline static bool IRAM_ATTR queueCallback(InterruptCallback callback)
+	__forceinline static bool IRAM_ATTR queueCallback(TaskPriority priority, InterruptCallback callback)
 	{
-		return queueCallback(reinterpret_cast<TaskCallback>(callback));
+		return queueCallback(priority, reinterpret_cast<TaskCallback>(callback));
 	}
 
 	/**
 	 * @brief Queue a deferred Delegate callback
+	 * @param priority Queue to post the callback to
 	 * @param callback The Delegate to be called
 	 * @retval bool false if callback could not be queued
 	 * @note Provides flexibility and ease of use for using capturing lambdas, etc.
-	 * but requires heap allocation and not as fast as a function callback.
+	 * but not as fast as a function callback.
+	 * Delegates are stored in a fixed pool of TASK_DELEGATE_POOL_SIZE slots,
+	 * with heap allocation used only if the pool is exhausted.
 	 * DO NOT use from interrupt context, use a Task/Interrupt callback.
 	 */
-	static bool queueCallback(TaskDelegate callback);
+	static bool queueCallback(TaskPriority priority, TaskDelegate callback);
+
+	/**
+	 * @brief Queue a deferred callback with normal priority
+	 * @param callback The function to be called
+	 * @param param Parameter passed to the callback (optional)
+	 * @retval bool false if callback could not be queued
+	 */
+	__forceinline static bool IRAM_ATTR queueCallback(TaskCallback32 callback, uint32_t param = 0)
+	{
+		return queueCallback(TaskPriority::Normal, callback, param);
+	}
+
+	/**
+	 * @brief Queue a deferred callback with normal priority, with optional void* parameter
+	 */
+	__forceinline static bool IRAM_ATTR queueCallback(TaskCallback callback, void* param = nullptr)
+	{
+		return queueCallback(TaskPriority::Normal, callback, param);
+	}
 
-	/** @brief Get number of tasks currently on queue
+	/**
+	 * @brief Queue a deferred callback with normal priority and no callback parameter
+	 */
+	__forceinline static bool IRAM_ATTR queueCallback(InterruptCallback callback)
+	{
+		return queueCallback(TaskPriority::Normal, callback);
+	}
+
+	/**
+	 * @brief Queue a deferred Delegate callback with normal priority
+	 * @see See `queueCallback(TaskPriority, TaskDelegate)`
+	 */
+	static bool queueCallback(TaskDelegate callback)
+	{
+		return queueCallback(TaskPriority::Normal, std::move(callback));
+	}
+
+	/** @brief Get number of tasks currently on the normal priority queue
 	 *  @retval unsigned
 	 */
 	static unsigned getTaskCount()
 	{
 #ifdef ENABLE_TASK_COUNT
-		return taskCount;
+		return taskQueueStats[unsigned(TaskPriority::Normal)].count;
 #else
 		return 255;
 #endif
 	}
 
-	/** @brief Get maximum number of tasks seen on queue at any one time
+	/** @brief Get maximum number of tasks seen on the normal priority queue at any one time
 	 *  @retval unsigned
-	 *  @note If return value is higher than maximum task queue TASK_QUEUE_LENGTH then
-	 *  the queue has overflowed at some point and tasks have been left un-executed.
+	 *  @note If this reaches TASK_QUEUE_LENGTH then the queue may have overflowed.
+	 *  Check `getTaskQueueStats()` for the number of rejected tasks.
 	 */
 	static unsigned getMaxTaskCount()
 	{
 #ifdef ENABLE_TASK_COUNT
-		return maxTaskCount;
+		return taskQueueStats[unsigned(TaskPriority::Normal)].maxCount;
 #else
 		return 255;
 #endif
 	}
 
+	/** @brief Get statistics for a task queue
+	 *  @param priority
+	 *  @retval TaskQueueStats
+	 *  @note The `count` and `maxCount` fields are only maintained if ENABLE_TASK_COUNT is set.
+	 *  If a priority queue is disabled then its tasks are accounted against the normal queue.
+	 */
+	static const TaskQueueStats& getTaskQueueStats(TaskPriority priority)
+	{
+		return taskQueueStats[unsigned(priority)];
+	}
+
+	/** @brief Get number of delegate pool slots currently in use
+	 *  @retval unsigned
+	 */
+	static unsigned getDelegateCount();
+
+	/** @brief Get maximum number of delegate pool slots in use at any one time
+	 *  @retval unsigned
+	 *  @note Use this to establish an appropriate value for TASK_DELEGATE_POOL_SIZE.
+	 */
+	static unsigned getMaxDelegateCount();
+
+	/** @brief Get number of times a queued delegate was allocated on the heap because the pool was full
+	 *  @retval unsigned
+	 */
+	static unsigned getDelegatePoolOverflows();
+
 private:
-	static void taskHandler(os_event_t* event);
+	template <TaskPriority priority> static void taskHandler(os_event_t* event);
 
 private:
 	static SystemState state;
-	static os_event_t taskQueue[]; ///< OS task queue
-#ifdef ENABLE_TASK_COUNT
-	static volatile uint8_t taskCount;	///< Number of tasks on queue
-	static volatile uint8_t maxTaskCount; ///< Profiling to establish appropriate queue size
-#endif
+	static TaskQueueStats taskQueueStats[]; ///< Indexed by TaskPriority
 };
 
 /**	@brief	Global instance of system object
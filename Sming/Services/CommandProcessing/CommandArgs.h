@@ -0,0 +1,100 @@
+/*
+ * CommandArgs.h
+ *
+ * Zero-allocation tokenisation of a command line
+ *
+ */
+/** @addtogroup commandhandler
+ *  @{
+ */
+
+#pragma once
+
+#include <cstddef>
+
+/**
+ * @brief Maximum number of arguments, including the command name
+ * @note Any text beyond the last argument is left untouched and included in it
+ */
+#ifndef COMMAND_MAX_ARGS
+#define COMMAND_MAX_ARGS 8
+#endif
+
+/**
+ * @brief Arguments for a command, tokenised in-place
+ *
+ * Spaces separating arguments are replaced with NUL characters so each argument
+ * can be referred to directly within the line buffer. The line itself is therefore
+ * modified, and the arguments are only valid for the duration of the command callback.
+ */
+class CommandArgs
+{
+public:
+	/**
+	 * @brief Tokenise a command line
+	 * @param line Text to split, NUL-terminated: this is modified
+	 * @param length Number of characters in line
+	 */
+	CommandArgs(char* line, size_t length)
+	{
+		tokenise(line, length);
+	}
+
+	/**
+	 * @brief Get number of arguments, including the command name
+	 */
+	unsigned count() const
+	{
+		return argc;
+	}
+
+	/**
+	 * @brief Get an argument
+	 * @param index 0 for the command name
+	 * @retval const char* The argument, nullptr if index is out of range
+	 */
+	const char* operator[](unsigned index) const
+	{
+		return (index < argc) ? argv[index] : nullptr;
+	}
+
+	/**
+	 * @brief Get the command name
+	 */
+	const char* getCommand() const
+	{
+		return (*this)[0];
+	}
+
+private:
+	void tokenise(char* line, size_t length)
+	{
+		char* end = line + length;
+		char* p = line;
+		while(argc < COMMAND_MAX_ARGS) {
+			while(p < end && *p == ' ') {
+				++p;
+			}
+			if(p == end) {
+				break;
+			}
+			argv[argc++] = p;
+			if(argc == COMMAND_MAX_ARGS) {
+				// Last argument gets the remainder of the line
+				break;
+			}
+			while(p < end && *p != ' ') {
+				++p;
+			}
+			if(p == end) {
+				break;
+			}
+			*p++ = '\0';
+		}
+	}
+
+	const char* argv[COMMAND_MAX_ARGS]{};
+	unsigned argc{0};
+};
+
+/** @} */
@@ -16,6 +16,11 @@ CommandDelegate::CommandDelegate(String reqName, String reqHelp, String reqGroup
 {
 }
 
+CommandDelegate::CommandDelegate(String reqName, String reqHelp, String reqGroup, CommandArgsDelegate reqFunction)
+	: commandName(reqName), commandHelp(reqHelp), commandGroup(reqGroup), commandArgsFunction(reqFunction)
+{
+}
+
 CommandDelegate::~CommandDelegate()
 {
 	// TODO Auto-generated destructor stub
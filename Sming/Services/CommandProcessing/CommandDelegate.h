@@ -13,6 +13,7 @@
 #include <WString.h>
 #include <WHashMap.h>
 #include "CommandOutput.h"
+#include "CommandArgs.h"
 
 /** @brief  Command delegate function
  *  @param  commandLine Command line entered by user at CLI, including command and parameters
@@ -22,11 +23,20 @@
  */
 using CommandFunctionDelegate = Delegate<void(String commandLine, CommandOutput* commandOutput)>;
 
+/** @brief  Command delegate function taking pre-tokenised arguments
+ *  @param  args Command name and parameters, which refer directly to the command line buffer
+ *  @param  commandOutput Pointer to the CLI print stream
+ *  @note   Avoids any heap allocation for the command line, so preferred for frequently-used commands.
+ *          The delegate is called directly from the command table so must not register or unregister commands.
+ */
+using CommandArgsDelegate = Delegate<void(const CommandArgs& args, CommandOutput* commandOutput)>;
+
 /** @brief  Command delegate class */
 class CommandDelegate
 {
 	// Hashmap uses CommandDelegate() constructor when extending size
 	friend class HashMap<String, CommandDelegate>;
+	friend class HashMap<String, CommandDelegate, HashMapHashedLookup<String>>;
 
 public:
 	/** Instantiate a command delegate
@@ -36,12 +46,27 @@ public:
 	*  @param  reqFunction Delegate that should be invoked (triggered) when the command is entered by a user
 	*/
 	CommandDelegate(String reqName, String reqHelp, String reqGroup, CommandFunctionDelegate reqFunction);
+
+	/** Instantiate a command delegate which takes tokenised arguments
+	*  @param  reqName Command name - the text a user types to invoke the command
+	*  @param  reqHelp Help message shown by CLI "help" command
+	*  @param  reqGroup The command group to which this command belongs
+	*  @param  reqFunction Delegate that should be invoked (triggered) when the command is entered by a user
+	*/
+	CommandDelegate(String reqName, String reqHelp, String reqGroup, CommandArgsDelegate reqFunction);
 	~CommandDelegate();
 
 	String commandName;						 ///< Command name
 	String commandHelp;						 ///< Command help
 	String commandGroup;					 ///< Command group
 	CommandFunctionDelegate commandFunction; ///< Command Delegate (function that is called when command is invoked)
+	CommandArgsDelegate commandArgsFunction; ///< Alternative delegate taking tokenised arguments
+
+	/** @brief  Determine if a delegate has been set for this command */
+	bool isValid() const
+	{
+		return commandFunction || commandArgsFunction;
+	}
 
 private:
 	CommandDelegate();
@@ -47,29 +47,31 @@ CommandExecutor::~CommandExecutor()
 
 int CommandExecutor::executorReceive(char* recvData, int recvSize)
 {
-	int receiveReturn = 0;
+	commandOutput->beginBatch();
 	for(int recvIdx = 0; recvIdx < recvSize; recvIdx++) {
-		receiveReturn = executorReceive(recvData[recvIdx]);
-		if(receiveReturn != 0) {
-			break;
-		}
+		receiveChar(recvData[recvIdx]);
 	}
-	return receiveReturn;
+	commandOutput->flush();
+	return 0;
 }
 
 int CommandExecutor::executorReceive(const String& recvString)
 {
-	int receiveReturn = 0;
+	commandOutput->beginBatch();
 	for(unsigned recvIdx = 0; recvIdx < recvString.length(); recvIdx++) {
-		receiveReturn = executorReceive(recvString[recvIdx]);
-		if(receiveReturn != 0) {
-			break;
-		}
+		receiveChar(recvString[recvIdx]);
 	}
-	return receiveReturn;
+	commandOutput->flush();
+	return 0;
 }
 
 int CommandExecutor::executorReceive(char recvChar)
+{
+	receiveChar(recvChar);
+	return 0;
+}
+
+void CommandExecutor::receiveChar(char recvChar)
 {
 	if(recvChar == 27) // ESC -> delete current commandLine
 	{
@@ -79,9 +81,9 @@ int CommandExecutor::executorReceive(char recvChar)
 			commandOutput->print(commandHandler.getCommandPrompt());
 		}
 	} else if(recvChar == commandHandler.getCommandEOL()) {
-		String command(commandBuf.getBuffer(), commandBuf.getLength());
+		// Command is processed directly from the line buffer
+		processCommandLine(commandBuf.getBuffer(), commandBuf.getLength());
 		commandBuf.clear();
-		processCommandLine(command);
 	} else if(recvChar == '\b' || recvChar == 0x7f) {
 		if(commandBuf.backspace()) {
 			commandOutput->print(_F("\b \b"));
@@ -91,33 +93,35 @@ int CommandExecutor::executorReceive(char recvChar)
 			commandOutput->print(recvChar);
 		}
 	}
-	return 0;
 }
 
-void CommandExecutor::processCommandLine(const String& cmdString)
+void CommandExecutor::processCommandLine(char* cmdLine, size_t cmdLength)
 {
-	if(cmdString.length() == 0) {
+	if(cmdLength == 0) {
 		commandOutput->println();
 	} else {
-		debugf("Received full Command line, size = %u,cmd = %s", cmdString.length(), cmdString.c_str());
-		String cmdCommand;
-		int cmdLen = cmdString.indexOf(' ');
-		if(cmdLen < 0) {
-			cmdCommand = cmdString;
-		} else {
-			cmdCommand = cmdString.substring(0, cmdLen);
-		}
+		cmdLine[cmdLength] = '\0';
+		debugf("Received full Command line, size = %u,cmd = %s", cmdLength, cmdLine);
+
+		auto cmdEnd = static_cast<const char*>(memchr(cmdLine, ' ', cmdLength));
+		size_t cmdLen = (cmdEnd == nullptr) ? cmdLength : cmdEnd - cmdLine;
+		// Short names fit within the String object so no allocation is required
+		String cmdCommand(cmdLine, cmdLen);
 
 		debugf("CommandExecutor : executing command %s", cmdCommand.c_str());
 
-		CommandDelegate cmdDelegate = commandHandler.getCommandDelegate(cmdCommand);
+		auto cmdDelegate = commandHandler.findCommand(cmdCommand);
 
-		if(!cmdDelegate.commandFunction) {
+		if(cmdDelegate == nullptr || !cmdDelegate->isValid()) {
 			commandOutput->print(_F("Command not found, cmd = '"));
 			commandOutput->print(cmdCommand);
 			commandOutput->println('\'');
+		} else if(cmdDelegate->commandArgsFunction) {
+			cmdDelegate->commandArgsFunction(CommandArgs(cmdLine, cmdLength), commandOutput);
 		} else {
-			cmdDelegate.commandFunction(cmdString, commandOutput);
+			// Take a copy as legacy commands may modify the command table
+			auto func = cmdDelegate->commandFunction;
+			func(String(cmdLine, cmdLength), commandOutput);
 		}
 	}
 
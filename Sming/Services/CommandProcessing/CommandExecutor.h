@@ -30,6 +30,9 @@ public:
 	CommandExecutor(Stream* reqStream);
 	~CommandExecutor();
 
+	/** @brief  Process a block of received data
+	 *  @note   All complete command lines are executed, and their responses sent together
+	 */
 	int executorReceive(char* recvData, int recvSize);
 	int executorReceive(char recvChar);
 	int executorReceive(const String& recvString);
@@ -37,7 +40,8 @@ public:
 
 private:
 	CommandExecutor();
-	void processCommandLine(const String& cmdString);
+	void receiveChar(char recvChar);
+	void processCommandLine(char* cmdLine, size_t cmdLength);
 	LineBuffer<MAX_COMMANDSIZE + 1> commandBuf;
 	CommandOutput* commandOutput = nullptr;
 };
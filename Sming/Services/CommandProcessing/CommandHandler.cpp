@@ -8,6 +8,7 @@
 #include "CommandHandler.h"
 #include "CommandDelegate.h"
 #include <SmingVersion.h>
+#include <StaticVector.h>
 #include <debug_progmem.h>
 #include <esp_system.h>
 
@@ -22,7 +23,7 @@
 CommandHandler::CommandHandler()
 	: currentPrompt(F("Sming>")), currentWelcomeMessage(F("Welcome to the Sming CommandProcessing\r\n"))
 {
-	registeredCommands = new HashMap<String, CommandDelegate>;
+	registeredCommands = new CommandMap;
 }
 
 CommandHandler::~CommandHandler()
@@ -49,15 +50,22 @@ void CommandHandler::registerSystemCommands()
 
 CommandDelegate CommandHandler::getCommandDelegate(const String& commandString)
 {
-	if(registeredCommands->contains(commandString)) {
+	auto cmd = findCommand(commandString);
+	if(cmd != nullptr) {
 		debugf("Returning Delegate for %s \r\n", commandString.c_str());
-		return (*registeredCommands)[commandString];
+		return *cmd;
 	} else {
 		debugf("Command %s not recognized, returning NULL\r\n", commandString.c_str());
-		return CommandDelegate("", "", "", nullptr);
+		return CommandDelegate("", "", "", CommandFunctionDelegate());
 	}
 }
 
+const CommandDelegate* CommandHandler::findCommand(const String& commandName) const
+{
+	int i = registeredCommands->indexOf(commandName);
+	return (i < 0) ? nullptr : &registeredCommands->valueAt(i);
+}
+
 bool CommandHandler::registerCommand(CommandDelegate reqDelegate)
 {
 	if(registeredCommands->contains(reqDelegate.commandName)) {
@@ -137,7 +145,8 @@ void CommandHandler::procesDebugOffCommand(String commandLine, CommandOutput* co
 
 void CommandHandler::processCommandOptions(String commandLine, CommandOutput* commandOutput)
 {
-	Vector<String> commandToken;
+	// Only up to three tokens are valid
+	StaticVector<String, 4> commandToken;
 	int numToken = splitString(commandLine, ' ', commandToken);
 	bool errorCommand = false;
 	bool printUsage = false;
@@ -77,6 +77,15 @@ public:
 	 */
 	CommandDelegate getCommandDelegate(const String& commandString);
 
+	/** @brief  Find a registered command
+	 *  @param  commandName Name of command to find
+	 *  @retval const CommandDelegate* The matching command, nullptr if not found
+	 *  @note   Lookup uses a hash index so takes the same time however many commands are registered.
+	 *          Unlike getCommandDelegate() no copy is made, but the returned pointer is only valid
+	 *          until any command is registered or removed.
+	 */
+	const CommandDelegate* findCommand(const String& commandName) const;
+
 	/** @brief  Get the verbose mode
 	 *  @retval VerboseMode Verbose mode
 	 */
@@ -152,7 +161,8 @@ public:
 	//	int deleteGroup(String reqGroup);
 
 private:
-	HashMap<String, CommandDelegate>* registeredCommands;
+	using CommandMap = HashMap<String, CommandDelegate, HashMapHashedLookup<String>>;
+	CommandMap* registeredCommands;
 	void procesHelpCommand(String commandLine, CommandOutput* commandOutput);
 	void procesStatusCommand(String commandLine, CommandOutput* commandOutput);
 	void procesEchoCommand(String commandLine, CommandOutput* commandOutput);
@@ -17,28 +17,66 @@ CommandOutput::~CommandOutput()
 	debugf("destruct");
 }
 
+/*
+ * Batched output is sent early if the buffer reaches this size
+ */
+#define COMMAND_OUTPUT_BATCH_SIZE 512
+
 size_t CommandOutput::write(uint8_t outChar)
+{
+	return write(&outChar, 1);
+}
+
+size_t CommandOutput::write(const uint8_t* buffer, size_t size)
 {
 	if(outputStream) {
-		return outputStream->write(outChar);
+		return outputStream->write(buffer, size);
 	}
 
 #ifndef DISABLE_NETWORK
 	if(outputTcpClient) {
-		char outBuf[1] = {char(outChar)};
-		return outputTcpClient->write(outBuf, 1);
+		if(!batching) {
+			return outputTcpClient->write(reinterpret_cast<const char*>(buffer), size);
+		}
+		if(!outputBuffer.concat(reinterpret_cast<const char*>(buffer), size)) {
+			return 0;
+		}
+		if(outputBuffer.length() >= COMMAND_OUTPUT_BATCH_SIZE) {
+			sendBuffer();
+		}
+		return size;
 	}
 	if(outputSocket) {
-		if(outChar == '\r') {
-			outputSocket->sendString(tempSocket);
-			tempSocket = "";
-		} else {
-			tempSocket = tempSocket + String(char(outChar));
+		for(size_t i = 0; i < size; ++i) {
+			char c = buffer[i];
+			if(c == '\r') {
+				outputSocket->sendString(tempSocket);
+				tempSocket = "";
+			} else {
+				tempSocket += c;
+			}
 		}
 
-		return 1;
+		return size;
 	}
 #endif
 
 	return 0;
 }
+
+void CommandOutput::sendBuffer()
+{
+#ifndef DISABLE_NETWORK
+	if(outputTcpClient != nullptr && outputBuffer.length() != 0) {
+		outputTcpClient->write(outputBuffer.c_str(), outputBuffer.length());
+		outputTcpClient->flush();
+		outputBuffer.setLength(0);
+	}
+#endif
+}
+
+void CommandOutput::flush()
+{
+	sendBuffer();
+	batching = false;
+}
@@ -32,7 +32,22 @@ public:
 	CommandOutput(Stream* reqStream);
 	virtual ~CommandOutput();
 
-	size_t write(uint8_t outChar);
+	size_t write(uint8_t outChar) override;
+	size_t write(const uint8_t* buffer, size_t size) override;
+
+	/** @brief  Hold back output until flush() is called
+	 *  @note   Used by CommandExecutor so responses to a batch of commands are sent together.
+	 *          Only applies to TCP output: streams are already buffered, and websocket
+	 *          output is sent a line at a time.
+	 */
+	void beginBatch()
+	{
+		batching = true;
+	}
+
+	/** @brief  Send any buffered output and end batch mode
+	 */
+	void flush();
 
 #ifndef DISABLE_NETWORK
 	TcpClient* outputTcpClient = nullptr;
@@ -40,4 +55,10 @@ public:
 #endif
 	Stream* outputStream = nullptr;
 	String tempSocket = "";
+
+private:
+	void sendBuffer();
+
+	String outputBuffer; ///< Batched TCP output
+	bool batching = false;
 };
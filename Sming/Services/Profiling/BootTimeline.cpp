@@ -0,0 +1,113 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/SmingHub/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * BootTimeline.cpp
+ *
+ ****/
+
+#include "BootTimeline.h"
+#include <FlashString/Vector.hpp>
+#include <Print.h>
+
+namespace Profiling
+{
+namespace BootTimeline
+{
+namespace
+{
+#define XX(tag, desc) DEFINE_FSTR_LOCAL(str_##tag, desc)
+BOOT_PHASE_MAP(XX)
+#undef XX
+
+#define XX(tag, desc) &str_##tag,
+DEFINE_FSTR_VECTOR_LOCAL(phaseNames, FlashString, BOOT_PHASE_MAP(XX))
+#undef XX
+
+Entry entries[unsigned(Phase::MAX)];
+
+/*
+ * Zero indicates 'not recorded' so avoid it as a timestamp
+ */
+uint32_t timestamp()
+{
+	auto time = system_get_time();
+	return time ?: 1;
+}
+
+} // namespace
+
+void begin(Phase phase)
+{
+	auto& e = entries[unsigned(phase)];
+	if(e.start == 0) {
+		e.start = timestamp();
+	}
+}
+
+void end(Phase phase)
+{
+	auto& e = entries[unsigned(phase)];
+	if(e.start != 0 && e.end == 0) {
+		e.end = timestamp();
+	}
+}
+
+void mark(Phase phase)
+{
+	auto& e = entries[unsigned(phase)];
+	if(e.start == 0) {
+		e.start = e.end = timestamp();
+	}
+}
+
+Entry getEntry(Phase phase)
+{
+	return (phase < Phase::MAX) ? entries[unsigned(phase)] : Entry{};
+}
+
+size_t printTo(Print& p)
+{
+	// Insertion sort by start time, there are only a handful of entries
+	uint8_t order[unsigned(Phase::MAX)];
+	unsigned count{0};
+	for(unsigned i = 0; i < unsigned(Phase::MAX); ++i) {
+		auto start = entries[i].start;
+		if(start == 0) {
+			continue;
+		}
+		unsigned j = count++;
+		for(; j > 0 && entries[order[j - 1]].start > start; --j) {
+			order[j] = order[j - 1];
+		}
+		order[j] = i;
+	}
+
+	size_t n{0};
+	for(unsigned i = 0; i < count; ++i) {
+		auto& e = entries[order[i]];
+		n += p.print(e.start);
+		n += p.print(_F(" us: "));
+		n += p.print(toString(Phase(order[i])));
+		if(e.end > e.start) {
+			n += p.print(_F(" ("));
+			n += p.print(e.end - e.start);
+			n += p.print(_F(" us)"));
+		} else if(e.end == 0) {
+			n += p.print(_F(" (incomplete)"));
+		}
+		n += p.println();
+	}
+	return n;
+}
+
+} // namespace BootTimeline
+} // namespace Profiling
+
+String toString(Profiling::BootTimeline::Phase phase)
+{
+	using namespace Profiling::BootTimeline;
+	return phaseNames[unsigned(phase)];
+}
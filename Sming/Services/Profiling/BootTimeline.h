@@ -0,0 +1,144 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/SmingHub/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * BootTimeline.h - Record when each stage of startup happens
+ *
+ ****/
+
+#pragma once
+
+#include <esp_systemapi.h>
+#include <WString.h>
+
+/**
+ * @brief Enable boot timeline recording
+ *
+ * When 0, all BOOT_PHASE_xxx macros compile to nothing.
+ */
+#ifndef ENABLE_BOOT_TIMELINE
+#define ENABLE_BOOT_TIMELINE 0
+#endif
+
+class Print;
+
+namespace Profiling
+{
+/**
+ * @brief Boot timeline
+ *
+ * Records the start and end time of each startup phase, in microseconds since reset
+ * (or wake from deep sleep). Only the first occurrence of each phase is kept,
+ * so the table describes a single boot and requires no more than a few bytes of RAM.
+ *
+ * Phases may overlap: `init()` typically starts WiFi, which connects some time after `init()` returns.
+ */
+namespace BootTimeline
+{
+#define BOOT_PHASE_MAP(XX)                                                                                             \
+	XX(partitionTable, "Load partition table")                                                                         \
+	XX(fileSystem, "Mount filesystem")                                                                                 \
+	XX(userInit, "Application init()")                                                                                 \
+	XX(systemReady, "System ready")                                                                                    \
+	XX(wifiStart, "Start WiFi station")                                                                                \
+	XX(wifiConnected, "WiFi station connected")                                                                        \
+	XX(wifiGotIp, "WiFi station got IP")
+
+enum class Phase : uint8_t {
+#define XX(tag, desc) tag,
+	BOOT_PHASE_MAP(XX)
+#undef XX
+		MAX
+};
+
+struct Entry {
+	uint32_t start; ///< Microseconds since reset, 0 if phase hasn't started
+	uint32_t end;	///< Microseconds since reset, 0 if phase hasn't completed
+};
+
+/**
+ * @brief Record start of a phase
+ * @note Ignored if the phase has been recorded previously
+ */
+void begin(Phase phase);
+
+/**
+ * @brief Record end of a phase
+ * @note Ignored if begin() hasn't been called, or phase has already ended
+ */
+void end(Phase phase);
+
+/**
+ * @brief Record a phase as a single point in time
+ */
+void mark(Phase phase);
+
+/**
+ * @brief Get recorded times for a phase
+ */
+Entry getEntry(Phase phase);
+
+/**
+ * @brief Print the timeline in order of start time
+ * @retval size_t Number of characters written
+ */
+size_t printTo(Print& p);
+
+/**
+ * @brief Records begin and end of a scope
+ */
+class Scope
+{
+public:
+	Scope(Phase phase) : phase(phase)
+	{
+		begin(phase);
+	}
+
+	~Scope()
+	{
+		end(phase);
+	}
+
+private:
+	Phase phase;
+};
+
+} // namespace BootTimeline
+} // namespace Profiling
+
+String toString(Profiling::BootTimeline::Phase phase);
+
+#if ENABLE_BOOT_TIMELINE
+
+/**
+ * @name Boot phase markers
+ * @param phase Name of a BootTimeline::Phase value
+ * @{
+ */
+#define BOOT_PHASE_BEGIN(phase) Profiling::BootTimeline::begin(Profiling::BootTimeline::Phase::phase)
+#define BOOT_PHASE_END(phase) Profiling::BootTimeline::end(Profiling::BootTimeline::Phase::phase)
+#define BOOT_PHASE_MARK(phase) Profiling::BootTimeline::mark(Profiling::BootTimeline::Phase::phase)
+/** @brief Record phase from here to end of the enclosing scope */
+#define BOOT_PHASE_SCOPE(phase)                                                                                        \
+	Profiling::BootTimeline::Scope boot_phase_##phase(Profiling::BootTimeline::Phase::phase)
+/** @} */
+
+#else
+
+#define BOOT_PHASE_BEGIN(phase)                                                                                        \
+	do {                                                                                                               \
+	} while(0)
+#define BOOT_PHASE_END(phase)                                                                                          \
+	do {                                                                                                               \
+	} while(0)
+#define BOOT_PHASE_MARK(phase)                                                                                         \
+	do {                                                                                                               \
+	} while(0)
+#define BOOT_PHASE_SCOPE(phase)                                                                                        \
+	do {                                                                                                               \
+	} while(0)
+
+#endif
@@ -0,0 +1,202 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/SmingHub/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * CallbackTiming.cpp
+ *
+ ****/
+
+#include "CallbackTiming.h"
+#include "StackUsage.h"
+#include <Platform/System.h>
+#include <Print.h>
+#include <debug_progmem.h>
+
+static_assert(TASK_TIMING_SLOTS > 0, "TASK_TIMING_SLOTS must be non-zero");
+static_assert(TASK_TIMING_WARN_COUNT > 0 && TASK_TIMING_WARN_COUNT <= 255, "TASK_TIMING_WARN_COUNT out of range");
+
+namespace Profiling
+{
+namespace CallbackTiming
+{
+namespace
+{
+Entry entries[TASK_TIMING_SLOTS];
+unsigned entryCount;
+unsigned overflows;
+uint32_t windowStart;
+WarningCallback warningCallback;
+
+/*
+ * Open addressing table keyed on callback address.
+ * Entries are never removed, so probing stops at the first empty slot.
+ */
+Entry* find(const void* callback, bool create)
+{
+	unsigned index = (uintptr_t(callback) >> 2) % TASK_TIMING_SLOTS;
+	for(unsigned i = 0; i < TASK_TIMING_SLOTS; ++i) {
+		auto& entry = entries[index];
+		if(entry.callback == callback) {
+			return &entry;
+		}
+		if(entry.callback == nullptr) {
+			if(!create) {
+				return nullptr;
+			}
+			entry.callback = callback;
+			++entryCount;
+			return &entry;
+		}
+		if(++index == TASK_TIMING_SLOTS) {
+			index = 0;
+		}
+	}
+	return nullptr;
+}
+
+void warn(const Entry& entry, uint32_t cycles)
+{
+	if(warningCallback != nullptr) {
+		warningCallback(entry, cycles);
+		return;
+	}
+
+	debug_w("[TASK] %p %s took %u us, %u times in a row", entry.callback, entry.tag ? entry.tag : "",
+			cycles / system_get_cpu_freq(), entry.longRuns);
+}
+
+} // namespace
+
+void record(const void* callback, uint32_t cycles)
+{
+	auto entry = find(callback, true);
+	if(entry == nullptr) {
+		++overflows;
+		return;
+	}
+
+	++entry->count;
+	entry->totalCycles += cycles;
+	if(cycles > entry->maxCycles) {
+		entry->maxCycles = cycles;
+	}
+
+	if(cycles < TASK_TIMING_WARN_US * system_get_cpu_freq()) {
+		entry->longRuns = 0;
+		return;
+	}
+
+	++entry->longRuns;
+	if(entry->longRuns == TASK_TIMING_WARN_COUNT) {
+		warn(*entry, cycles);
+		entry->longRuns = 0;
+	}
+}
+
+void recordStack(const void* callback, size_t depth)
+{
+	auto entry = find(callback, false);
+	if(entry != nullptr && depth > entry->maxStack) {
+		entry->maxStack = depth;
+	}
+}
+
+bool setTag(const void* callback, const char* tag)
+{
+	auto entry = find(callback, true);
+	if(entry == nullptr) {
+		return false;
+	}
+	entry->tag = tag;
+	return true;
+}
+
+void setWarningCallback(WarningCallback callback)
+{
+	warningCallback = callback;
+}
+
+void startWindow()
+{
+	for(auto& entry : entries) {
+		entry.count = 0;
+		entry.maxCycles = 0;
+		entry.totalCycles = 0;
+		entry.maxStack = 0;
+		entry.longRuns = 0;
+	}
+	overflows = 0;
+	windowStart = system_get_time();
+}
+
+uint32_t getWindowTime()
+{
+	return system_get_time() - windowStart;
+}
+
+unsigned getEntryCount()
+{
+	return entryCount;
+}
+
+bool getEntry(unsigned index, Entry& entry)
+{
+	for(auto& e : entries) {
+		if(e.callback == nullptr) {
+			continue;
+		}
+		if(index == 0) {
+			entry = e;
+			return true;
+		}
+		--index;
+	}
+	return false;
+}
+
+unsigned getOverflows()
+{
+	return overflows;
+}
+
+size_t printTo(Print& p)
+{
+	auto cpuFrequency = system_get_cpu_freq();
+	auto windowTime = getWindowTime();
+
+	size_t n{0};
+	n += p.print(_F("Callback timing over "));
+	n += p.print(windowTime / 1000);
+	n += p.println(_F(" ms"));
+#if ENABLE_STACK_USAGE
+	n += p.println(_F("    count   total_us  max_us  load%  stack  callback"));
+#else
+	n += p.println(_F("    count   total_us  max_us  load%  callback"));
+#endif
+
+	for(auto& e : entries) {
+		if(e.callback == nullptr || e.count == 0) {
+			continue;
+		}
+		uint32_t totalTime = e.totalCycles / cpuFrequency;
+		unsigned load = (windowTime == 0) ? 0 : uint64_t(totalTime) * 1000 / windowTime;
+		n += p.printf(_F("  %7u %10u %7u %4u.%u  "), e.count, totalTime, e.maxCycles / cpuFrequency, load / 10,
+					  load % 10);
+#if ENABLE_STACK_USAGE
+		n += p.printf(_F("%5u  "), e.maxStack);
+#endif
+		n += p.printf(_F("%p %s\r\n"), e.callback, e.tag ? e.tag : "");
+	}
+
+	if(overflows != 0) {
+		n += p.print(_F("  Table full, calls not accounted: "));
+		n += p.println(overflows);
+	}
+
+	return n;
+}
+
+} // namespace CallbackTiming
+} // namespace Profiling
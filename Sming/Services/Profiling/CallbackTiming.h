@@ -0,0 +1,154 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/SmingHub/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * CallbackTiming.h - Execution time accounting for task queue callbacks
+ *
+ ****/
+
+#pragma once
+
+#include <esp_systemapi.h>
+
+/**
+ * @brief Measure the execution time of every task queue callback
+ */
+#ifndef ENABLE_TASK_TIMING
+#define ENABLE_TASK_TIMING 0
+#endif
+
+/**
+ * @brief Number of distinct callbacks which can be accounted
+ */
+#ifndef TASK_TIMING_SLOTS
+#define TASK_TIMING_SLOTS 16
+#endif
+
+/**
+ * @brief Callbacks running for longer than this many microseconds are considered long
+ */
+#ifndef TASK_TIMING_WARN_US
+#define TASK_TIMING_WARN_US 50000
+#endif
+
+/**
+ * @brief Number of consecutive long runs of a callback before a warning is issued
+ */
+#ifndef TASK_TIMING_WARN_COUNT
+#define TASK_TIMING_WARN_COUNT 3
+#endif
+
+class Print;
+
+namespace Profiling
+{
+/**
+ * @brief Per-callback execution time accounting
+ *
+ * When enabled, the system task dispatcher records the CPU cycles taken by each callback.
+ * Figures are held per callback address in a fixed table, and accumulate until the next
+ * call to startWindow().
+ *
+ * A callback which runs for longer than TASK_TIMING_WARN_US on TASK_TIMING_WARN_COUNT
+ * consecutive occasions generates a warning. This identifies handlers which hold up the
+ * network stack, and which may eventually trigger the watchdog.
+ *
+ * All queued Delegates are dispatched via a common handler, so are accounted together.
+ */
+namespace CallbackTiming
+{
+struct Entry {
+	const void* callback; ///< Address of the callback function
+	const char* tag;	  ///< Name registered via setTag(), or nullptr
+	uint32_t count;		  ///< Number of calls during window
+	uint32_t maxCycles;	  ///< Longest call during window
+	uint64_t totalCycles; ///< Time spent in callback during window
+	uint32_t maxStack;	  ///< Deepest stack use during window in bytes, requires ENABLE_STACK_USAGE
+	uint8_t longRuns;	  ///< Current number of consecutive long calls
+};
+
+/**
+ * @brief Function called when a callback has repeatedly run for too long
+ * @param entry
+ * @param cycles Duration of the most recent call
+ */
+using WarningCallback = void (*)(const Entry& entry, uint32_t cycles);
+
+/**
+ * @brief Account for a callback
+ * @param callback
+ * @param cycles Time taken by the callback
+ * @note Called by the task dispatcher
+ */
+void record(const void* callback, uint32_t cycles);
+
+/**
+ * @brief Account for stack used by a callback
+ * @param callback
+ * @param depth Bytes of stack used
+ * @note Called by the task dispatcher
+ */
+void recordStack(const void* callback, size_t depth);
+
+/**
+ * @brief Associate a name with a callback, for reporting
+ * @param callback
+ * @param tag Pointer is stored, so must be a string literal
+ * @retval bool false if the table is full
+ */
+bool setTag(const void* callback, const char* tag);
+
+/**
+ * @brief Associate a name with a callback function, for reporting
+ */
+template <typename Function> bool setTag(Function* callback, const char* tag)
+{
+	return setTag(reinterpret_cast<const void*>(callback), tag);
+}
+
+/**
+ * @brief Set a function to be called instead of printing a debug warning
+ */
+void setWarningCallback(WarningCallback callback);
+
+/**
+ * @brief Clear all figures and start a new accounting window
+ *
+ * Registered tags are retained.
+ */
+void startWindow();
+
+/**
+ * @brief Get the time since the window was started
+ * @retval uint32_t Microseconds
+ */
+uint32_t getWindowTime();
+
+/**
+ * @brief Get number of entries in the table
+ */
+unsigned getEntryCount();
+
+/**
+ * @brief Get an entry from the table
+ * @param index
+ * @param entry On success, receives a copy of the entry
+ * @retval bool false if index is out of range
+ */
+bool getEntry(unsigned index, Entry& entry);
+
+/**
+ * @brief Get the number of calls which could not be accounted because the table was full
+ */
+unsigned getOverflows();
+
+/**
+ * @brief Print a table of callbacks used during the current window
+ * @retval size_t Number of characters written
+ */
+size_t printTo(Print& p);
+
+} // namespace CallbackTiming
+} // namespace Profiling
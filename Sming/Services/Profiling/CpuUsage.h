@@ -17,9 +17,20 @@ public:
 	void begin(InterruptCallback ready)
 	{
 		onReady = ready;
+		running = true;
 		queueCalibrationLoop();
 	}
 
+	/**
+	 * @brief Stop measuring
+	 *
+	 * The measurement loop stops queuing callbacks. Call begin() to restart.
+	 */
+	void end()
+	{
+		running = false;
+	}
+
 	/**
 	 * @brief Reset counters to start a new update period
 	 */
@@ -74,6 +85,9 @@ public:
 private:
 	void loop()
 	{
+		if(!running) {
+			return;
+		}
 		++loopIterations;
 		queueLoop();
 	}
@@ -85,6 +99,9 @@ private:
 
 	void calibrationLoop()
 	{
+		if(!running) {
+			return;
+		}
 		++loopIterations;
 		if(loopIterations < minCalIterations) {
 			cycleTimer.start();
@@ -111,6 +128,7 @@ private:
 	unsigned loopIterations = 0;
 	uint32_t minLoopCycles = 0; // Set during calibration
 	InterruptCallback onReady = nullptr;
+	bool running = false;
 };
 
 } // namespace Profiling
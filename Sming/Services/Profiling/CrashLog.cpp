@@ -0,0 +1,150 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/SmingHub/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * CrashLog.cpp
+ *
+ ****/
+
+#include "CrashLog.h"
+#include <Print.h>
+#include <stdio.h>
+
+namespace Profiling
+{
+namespace CrashLog
+{
+namespace
+{
+constexpr uint32_t recordMagic{0x43524831}; // "CRH1"
+
+uint32_t getChecksum(const Record& rec)
+{
+	// FNV-1a over everything following the checksum
+	auto p = reinterpret_cast<const uint32_t*>(&rec.checksum + 1);
+	auto end = reinterpret_cast<const uint32_t*>(&rec + 1);
+	uint32_t hash{2166136261U};
+	while(p < end) {
+		hash = (hash ^ *p++) * 16777619U;
+	}
+	return hash;
+}
+
+bool isValid(const Record& rec)
+{
+	return rec.magic == recordMagic && rec.checksum == getChecksum(rec);
+}
+
+size_t printHex(Print& p, const char* name, uint32_t value)
+{
+	char buf[24];
+	m_snprintf(buf, sizeof(buf), _F(" %s=0x%08x"), name, value);
+	return p.print(buf);
+}
+
+} // namespace
+
+void capture(Record& rec, uint32_t stackPointer, uint32_t stackEnd)
+{
+	Record prev;
+	rec.crashCount = (readRecord(prev) && isValid(prev)) ? prev.crashCount + 1 : 1;
+	rec.uptime = system_get_time() / 1000;
+
+	// Word reads only, as the stack may be in memory which does not support byte access
+	stackPointer &= ~uint32_t(3);
+	rec.stackPointer = stackPointer;
+	auto src = reinterpret_cast<const uint32_t*>(stackPointer);
+	for(unsigned i = 0; i < stackWords; ++i) {
+		rec.stack[i] = (stackPointer + i * 4 < stackEnd) ? src[i] : 0;
+	}
+
+	unsigned count = Trace::getCount();
+	unsigned first = (count > traceRecords) ? count - traceRecords : 0;
+	for(unsigned i = 0; i < traceRecords; ++i) {
+		if(!Trace::getRecord(first + i, rec.trace[i])) {
+			rec.trace[i] = Trace::Record{};
+		}
+	}
+
+	rec.magic = recordMagic;
+	rec.checksum = getChecksum(rec);
+	writeRecord(rec);
+}
+
+bool get(Record& rec)
+{
+	return readRecord(rec) && isValid(rec);
+}
+
+void clear()
+{
+	Record rec{};
+	writeRecord(rec);
+}
+
+size_t printTo(Print& p)
+{
+	Record rec;
+	if(!get(rec)) {
+		return 0;
+	}
+
+	size_t n{0};
+	n += p.print(_F("Crash #"));
+	n += p.print(rec.crashCount);
+	n += p.print(_F(" after "));
+	n += p.print(rec.uptime);
+	n += p.print(_F("ms: "));
+	n += p.println(getReasonName(rec.reason));
+
+	n += p.print(_F("cause "));
+	n += p.print(rec.cause);
+	n += p.print(_F(" ("));
+	n += p.print(getCauseName(rec.cause));
+	n += p.println(')');
+	n += printHex(p, "epc1", rec.epc[0]);
+	n += printHex(p, "epc2", rec.epc[1]);
+	n += printHex(p, "epc3", rec.epc[2]);
+	n += printHex(p, "excvaddr", rec.excvaddr);
+	n += printHex(p, "depc", rec.depc);
+	n += p.println();
+
+	if(rec.regsValid) {
+		n += printHex(p, "ps", rec.ps);
+		for(unsigned i = 0; i < 16; ++i) {
+			if(i % 4 == 0) {
+				n += p.println();
+			}
+			char name[4];
+			m_snprintf(name, sizeof(name), "a%u", i);
+			n += printHex(p, name, rec.regs[i]);
+		}
+		n += p.println();
+	}
+
+	n += p.println(_F("Stack:"));
+	for(unsigned i = 0; i < stackWords; i += 4) {
+		char buf[64];
+		m_snprintf(buf, sizeof(buf), _F("%08x:  %08x %08x %08x %08x"), rec.stackPointer + i * 4, rec.stack[i],
+				   rec.stack[i + 1], rec.stack[i + 2], rec.stack[i + 3]);
+		n += p.println(buf);
+	}
+
+	n += p.println(_F("Trace:"));
+	for(auto& t : rec.trace) {
+		if(t.name == nullptr) {
+			continue;
+		}
+		char buf[48];
+		m_snprintf(buf, sizeof(buf), _F("%10u %c 0x%08x "), t.cycles, "BEI"[unsigned(t.phase) % 3], t.arg);
+		n += p.print(buf);
+		n += p.println(t.name);
+	}
+
+	return n;
+}
+
+} // namespace CrashLog
+} // namespace Profiling
@@ -0,0 +1,133 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/SmingHub/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * CrashLog.h - Crash record retained across reset
+ *
+ ****/
+
+#pragma once
+
+#include "Trace.h"
+#include <WString.h>
+
+/**
+ * @brief Save a record of each crash for retrieval after restart
+ */
+#ifndef ENABLE_CRASH_LOG
+#define ENABLE_CRASH_LOG 0
+#endif
+
+/**
+ * @brief First RTC memory block (in 32-bit words) used to store the record (Esp8266)
+ */
+#ifndef CRASH_LOG_RTC_ADDR
+#define CRASH_LOG_RTC_ADDR 128
+#endif
+
+class Print;
+
+namespace Profiling
+{
+/**
+ * @brief Post-mortem crash capture
+ *
+ * When ENABLE_CRASH_LOG is set, the crash handler writes a compact record describing an exception
+ * or watchdog reset into memory which survives restart. This takes a few microseconds and does
+ * not depend on serial output or an attached debugger.
+ *
+ * After restart the application checks for a record, sends it somewhere useful (for example
+ * via HTTP or MQTT) and then calls clear().
+ *
+ * The record contains the failure cause, the registers available to the handler, the top of the stack
+ * and the most recent event trace records. Stack values and trace event names are only meaningful
+ * for the firmware which crashed.
+ *
+ * Currently supported on Esp8266 only, using RTC user memory.
+ */
+namespace CrashLog
+{
+constexpr unsigned stackWords{16};
+constexpr unsigned traceRecords{4};
+
+struct Record {
+	uint32_t magic;
+	uint32_t checksum;
+	uint32_t crashCount;	 ///< Crashes recorded since the log was last cleared
+	uint32_t uptime;		 ///< Milliseconds since boot
+	uint32_t reason;		 ///< Reset reason (rst_reason)
+	uint32_t cause;			 ///< Exception cause (Esp8266: EXCCAUSE)
+	uint32_t epc[3];		 ///< Exception program counters
+	uint32_t excvaddr;		 ///< Exception virtual address
+	uint32_t depc;			 ///< Double exception program counter
+	uint32_t ps;			 ///< Processor state, if registers valid
+	uint32_t regs[16];		 ///< General registers a0-a15, if valid
+	uint32_t regsValid;		 ///< Non-zero if `ps` and `regs` were captured
+	uint32_t stackPointer;	 ///< Address of first word in `stack`
+	uint32_t stack[stackWords]; ///< Stack contents
+	Trace::Record trace[traceRecords]; ///< Most recent trace records, oldest first
+};
+
+/**
+ * @brief Complete and store a record
+ * @param rec Arch-specific fields (reason, cause, epc, etc.) already set
+ * @param stackPointer Stack words are copied from here
+ * @param stackEnd Copying stops before this address
+ * @note Called by the crash handler, so must not allocate memory or block
+ */
+void capture(Record& rec, uint32_t stackPointer, uint32_t stackEnd);
+
+/**
+ * @brief Fetch stored record
+ * @retval bool false if there is no valid record
+ */
+bool get(Record& rec);
+
+/**
+ * @brief Discard stored record
+ */
+void clear();
+
+/**
+ * @brief Print stored record in readable form
+ * @retval size_t Number of characters written, 0 if there is no record
+ *
+ * Output is suitable for sending as an HTTP request body or MQTT message.
+ * The stack words use the same layout as the serial crash dump, so may be
+ * decoded with `make decode-stacktrace`.
+ */
+size_t printTo(Print& p);
+
+/**
+ * @name Architecture-specific storage
+ * @{
+ */
+
+/**
+ * @brief Read raw record
+ * @retval bool false if not supported
+ */
+bool readRecord(Record& rec);
+
+/**
+ * @brief Write raw record
+ * @retval bool false if not supported
+ */
+bool writeRecord(const Record& rec);
+
+/**
+ * @brief Get description of reset reason
+ */
+String getReasonName(uint32_t reason);
+
+/**
+ * @brief Get description of exception cause
+ */
+String getCauseName(uint32_t cause);
+
+/** @} */
+
+} // namespace CrashLog
+} // namespace Profiling
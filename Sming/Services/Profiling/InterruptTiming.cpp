@@ -0,0 +1,194 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/SmingHub/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * InterruptTiming.cpp
+ *
+ ****/
+
+#include "InterruptTiming.h"
+#include <Print.h>
+
+static_assert(INTERRUPT_TIMING_SITES > 0, "INTERRUPT_TIMING_SITES must be non-zero");
+static_assert(INTERRUPT_TIMING_HANDLERS > 0, "INTERRUPT_TIMING_HANDLERS must be non-zero");
+
+namespace Profiling
+{
+namespace InterruptTiming
+{
+namespace
+{
+constexpr unsigned maxProbes{8};
+
+Site sites[INTERRUPT_TIMING_SITES];
+Handler handlers[INTERRUPT_TIMING_HANDLERS];
+unsigned handlerCount;
+uint32_t maxMaskedCycles;
+uint64_t totalMaskedCycles;
+uint32_t droppedCount;
+
+} // namespace
+
+/*
+ * Open addressing with limited probing, as for the PC sampler
+ */
+void IRAM_ATTR recordMasked(uint32_t address, uint32_t cycles)
+{
+	totalMaskedCycles += cycles;
+	if(cycles > maxMaskedCycles) {
+		maxMaskedCycles = cycles;
+	}
+
+	unsigned index = (address >> 1) % INTERRUPT_TIMING_SITES;
+	for(unsigned i = 0; i < maxProbes; ++i) {
+		auto& site = sites[index];
+		if(site.address == 0) {
+			site.address = address;
+		}
+		if(site.address == address) {
+			++site.count;
+			site.totalCycles += cycles;
+			if(cycles > site.maxCycles) {
+				site.maxCycles = cycles;
+			}
+			return;
+		}
+		index = (index + 1) % INTERRUPT_TIMING_SITES;
+	}
+	++droppedCount;
+}
+
+void IRAM_ATTR recordHandler(unsigned id, uint32_t cycles)
+{
+	Handler* handler{nullptr};
+	auto level = noInterrupts();
+	for(unsigned i = 0; i < handlerCount; ++i) {
+		if(handlers[i].id == id) {
+			handler = &handlers[i];
+			break;
+		}
+	}
+	if(handler == nullptr && handlerCount < INTERRUPT_TIMING_HANDLERS) {
+		handler = &handlers[handlerCount++];
+		handler->id = id;
+	}
+	if(handler != nullptr) {
+		++handler->count;
+		handler->totalCycles += cycles;
+		if(cycles > handler->maxCycles) {
+			handler->maxCycles = cycles;
+		}
+		++handler->histogram[getBucket(cycles)];
+	}
+	restoreInterrupts(level);
+}
+
+void reset()
+{
+	auto level = noInterrupts();
+	for(auto& site : sites) {
+		site = Site{};
+	}
+	for(auto& handler : handlers) {
+		handler = Handler{};
+	}
+	handlerCount = 0;
+	maxMaskedCycles = 0;
+	totalMaskedCycles = 0;
+	droppedCount = 0;
+	restoreInterrupts(level);
+}
+
+bool getSite(unsigned index, Site& site)
+{
+	if(index >= INTERRUPT_TIMING_SITES) {
+		return false;
+	}
+	auto level = noInterrupts();
+	site = sites[index];
+	restoreInterrupts(level);
+	return site.address != 0;
+}
+
+bool getHandler(unsigned id, Handler& handler)
+{
+	bool found{false};
+	auto level = noInterrupts();
+	for(unsigned i = 0; i < handlerCount; ++i) {
+		if(handlers[i].id == id) {
+			handler = handlers[i];
+			found = true;
+			break;
+		}
+	}
+	restoreInterrupts(level);
+	return found;
+}
+
+uint32_t getMaxMaskedCycles()
+{
+	return maxMaskedCycles;
+}
+
+uint64_t getTotalMaskedCycles()
+{
+	auto level = noInterrupts();
+	auto total = totalMaskedCycles;
+	restoreInterrupts(level);
+	return total;
+}
+
+uint32_t getDroppedCount()
+{
+	return droppedCount;
+}
+
+size_t printTo(Print& p)
+{
+	auto cpuFrequency = system_get_cpu_freq();
+
+	size_t n{0};
+	n += p.println(_F("Interrupts disabled"));
+	n += p.println(_F("    count   total_us  max_us  address"));
+	for(unsigned i = 0; i < INTERRUPT_TIMING_SITES; ++i) {
+		Site site;
+		if(!getSite(i, site)) {
+			continue;
+		}
+		n += p.printf(_F("  %7u %10u %7u  0x%08x\r\n"), site.count, uint32_t(site.totalCycles / cpuFrequency),
+					  site.maxCycles / cpuFrequency, site.address);
+	}
+	if(droppedCount != 0) {
+		n += p.print(_F("  Table full, sections not accounted: "));
+		n += p.println(droppedCount);
+	}
+
+	n += p.println(_F("Interrupt handlers"));
+	n += p.print(_F("  gpio    count   total_us  max_us  histogram (<"));
+	for(unsigned i = 0; i < histogramBuckets - 1; ++i) {
+		if(i != 0) {
+			n += p.print(", ");
+		}
+		n += p.print((256U << i) / cpuFrequency);
+	}
+	n += p.println(_F(", more us)"));
+	for(unsigned i = 0; i < handlerCount; ++i) {
+		Handler handler;
+		if(!getHandler(handlers[i].id, handler)) {
+			continue;
+		}
+		n += p.printf(_F("  %4u  %7u %10u %7u "), handler.id, handler.count,
+					  uint32_t(handler.totalCycles / cpuFrequency), handler.maxCycles / cpuFrequency);
+		for(auto count : handler.histogram) {
+			n += p.printf(_F(" %u"), count);
+		}
+		n += p.println();
+	}
+
+	return n;
+}
+
+} // namespace InterruptTiming
+} // namespace Profiling
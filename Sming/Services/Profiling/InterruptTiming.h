@@ -0,0 +1,170 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/SmingHub/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * InterruptTiming.h - Interrupt masking and handler duration accounting
+ *
+ ****/
+
+#pragma once
+
+#include <esp_systemapi.h>
+#include <esp_clk.h>
+
+/**
+ * @brief Measure time spent with interrupts disabled, and in GPIO interrupt handlers
+ */
+#ifndef ENABLE_INTERRUPT_TIMING
+#define ENABLE_INTERRUPT_TIMING 0
+#endif
+
+/**
+ * @brief Number of distinct code locations which can be accounted for masking interrupts
+ */
+#ifndef INTERRUPT_TIMING_SITES
+#define INTERRUPT_TIMING_SITES 32
+#endif
+
+/**
+ * @brief Number of distinct interrupt handlers which can be accounted
+ */
+#ifndef INTERRUPT_TIMING_HANDLERS
+#define INTERRUPT_TIMING_HANDLERS 8
+#endif
+
+class Print;
+
+namespace Profiling
+{
+/**
+ * @brief Interrupt latency accounting
+ *
+ * When enabled, two things are measured using the CPU cycle counter:
+ *
+ * - Critical sections. `noInterrupts()`, `interrupts()` and `restoreInterrupts()` are instrumented so that
+ *   the time interrupts remain disabled is recorded against the location which disabled them.
+ *   Only the outermost section is measured where calls are nested.
+ *   This is the latency added to every interrupt, so identifies drivers which break timing budgets.
+ *
+ * - GPIO interrupt handlers attached with `attachInterrupt()`. The duration of each call is recorded
+ *   per pin, with a histogram.
+ *
+ * Figures accumulate until reset() is called. Code locations are reported as addresses,
+ * which may be resolved using `addr2line` or GDB.
+ *
+ * Critical section timing is implemented for Esp8266 only. Handler timing is available on Esp8266, Esp32 and Rp2040.
+ */
+namespace InterruptTiming
+{
+/**
+ * @brief Number of histogram buckets
+ *
+ * Bucket 0 counts calls of fewer than 256 cycles, and each subsequent bucket
+ * twice the previous upper limit. The last bucket counts everything longer.
+ */
+constexpr unsigned histogramBuckets{10};
+
+struct Site {
+	uint32_t address;	  ///< Code address where interrupts were disabled
+	uint32_t count;		  ///< Number of times interrupts were disabled here
+	uint32_t maxCycles;	  ///< Longest time interrupts were disabled
+	uint64_t totalCycles; ///< Total time interrupts were disabled
+};
+
+struct Handler {
+	unsigned id; ///< GPIO number
+	uint32_t count;
+	uint32_t maxCycles;
+	uint64_t totalCycles;
+	uint32_t histogram[histogramBuckets];
+};
+
+/**
+ * @brief Record a period with interrupts disabled
+ * @param address Code location
+ * @param cycles
+ * @note Called with interrupts disabled
+ */
+void recordMasked(uint32_t address, uint32_t cycles);
+
+/**
+ * @brief Record a call to an interrupt handler
+ * @param id Identifies the handler, such as a GPIO number
+ * @param cycles
+ * @note Called from interrupt context
+ */
+void recordHandler(unsigned id, uint32_t cycles);
+
+/**
+ * @brief Discard all figures
+ */
+void reset();
+
+/**
+ * @brief Get figures for a critical section
+ * @param index 0 to INTERRUPT_TIMING_SITES - 1
+ * @retval bool false if slot is unused
+ */
+bool getSite(unsigned index, Site& site);
+
+/**
+ * @brief Get figures for an interrupt handler
+ * @param id As passed to recordHandler()
+ * @retval bool false if handler has not been called
+ */
+bool getHandler(unsigned id, Handler& handler);
+
+/**
+ * @brief Get the longest time interrupts were disabled, at any location
+ */
+uint32_t getMaxMaskedCycles();
+
+/**
+ * @brief Get the total time interrupts were disabled, at all locations
+ */
+uint64_t getTotalMaskedCycles();
+
+/**
+ * @brief Get number of critical sections which could not be recorded as the table was full
+ */
+uint32_t getDroppedCount();
+
+/**
+ * @brief Get histogram bucket for a duration
+ */
+inline unsigned getBucket(uint32_t cycles)
+{
+	if(cycles < 256) {
+		return 0;
+	}
+	unsigned bucket = (31 - __builtin_clz(cycles)) - 7;
+	return (bucket < histogramBuckets) ? bucket : histogramBuckets - 1;
+}
+
+/**
+ * @brief Call an interrupt handler, recording its duration if enabled
+ * @param id Identifies the handler, such as a GPIO number
+ * @param handler
+ */
+template <typename Callback> __forceinline void IRAM_ATTR callHandler(unsigned id, Callback handler)
+{
+#if ENABLE_INTERRUPT_TIMING
+	auto start = esp_get_ccount();
+	handler();
+	recordHandler(id, esp_get_ccount() - start);
+#else
+	(void)id;
+	handler();
+#endif
+}
+
+/**
+ * @brief Print a report, with times in microseconds at the current CPU frequency
+ * @retval size_t Number of characters written
+ */
+size_t printTo(Print& p);
+
+} // namespace InterruptTiming
+} // namespace Profiling
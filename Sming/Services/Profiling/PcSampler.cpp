@@ -0,0 +1,155 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/SmingHub/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * PcSampler.cpp
+ *
+ ****/
+
+#include "PcSampler.h"
+#include <Data/MemoryClass.h>
+#include <Print.h>
+#include <stdlib.h>
+#include <string.h>
+
+static_assert(PC_SAMPLER_SLOTS > 0, "PC_SAMPLER_SLOTS must be non-zero");
+
+namespace Profiling
+{
+namespace PcSampler
+{
+namespace
+{
+struct Slot {
+	uint32_t pc;
+	uint32_t count;
+};
+
+constexpr unsigned maxProbes{8};
+
+Slot* slots;
+uint32_t sampleCount;
+uint32_t droppedCount;
+unsigned interval;
+bool running;
+
+} // namespace
+
+/*
+ * Open addressing with limited probing keeps time spent in the handler bounded.
+ */
+void IRAM_ATTR record(uint32_t pc)
+{
+	++sampleCount;
+	if(slots == nullptr || pc == 0) {
+		return;
+	}
+
+	unsigned index = (pc >> 1) % PC_SAMPLER_SLOTS;
+	for(unsigned i = 0; i < maxProbes; ++i) {
+		auto& slot = slots[index];
+		if(slot.pc == pc) {
+			++slot.count;
+			return;
+		}
+		if(slot.pc == 0) {
+			slot.pc = pc;
+			slot.count = 1;
+			return;
+		}
+		index = (index + 1) % PC_SAMPLER_SLOTS;
+	}
+	++droppedCount;
+}
+
+bool start(unsigned intervalUs)
+{
+	if(running) {
+		return false;
+	}
+
+	clear();
+	// Table is accessed from interrupt context so must be in internal RAM
+	auto table = static_cast<Slot*>(Memory::allocate(PC_SAMPLER_SLOTS * sizeof(Slot), MemoryClass::Fast));
+	if(table == nullptr) {
+		return false;
+	}
+	memset(table, 0, PC_SAMPLER_SLOTS * sizeof(Slot));
+	slots = table;
+
+	interval = intervalUs;
+	running = startTimer(intervalUs);
+	if(!running) {
+		clear();
+	}
+	return running;
+}
+
+void stop()
+{
+	if(running) {
+		stopTimer();
+		running = false;
+	}
+}
+
+void clear()
+{
+	stop();
+	free(slots);
+	slots = nullptr;
+	sampleCount = 0;
+	droppedCount = 0;
+}
+
+bool isRunning()
+{
+	return running;
+}
+
+uint32_t getSampleCount()
+{
+	return sampleCount;
+}
+
+uint32_t getDroppedCount()
+{
+	return droppedCount;
+}
+
+size_t printReport(Print& p)
+{
+	bool wasRunning = running;
+	stop();
+
+	size_t n{0};
+	n += p.println(_F("--- PC SAMPLES BEGIN ---"));
+	n += p.print(_F("# samples "));
+	n += p.print(sampleCount);
+	n += p.print(_F(", dropped "));
+	n += p.println(droppedCount);
+	if(slots != nullptr) {
+		for(unsigned i = 0; i < PC_SAMPLER_SLOTS; ++i) {
+			auto& slot = slots[i];
+			if(slot.pc == 0) {
+				continue;
+			}
+			n += p.print("0x");
+			n += p.print(slot.pc, HEX);
+			n += p.print(' ');
+			n += p.println(slot.count);
+		}
+	}
+	n += p.println(_F("--- PC SAMPLES END ---"));
+
+	if(wasRunning) {
+		running = startTimer(interval);
+	}
+
+	return n;
+}
+
+} // namespace PcSampler
+} // namespace Profiling
@@ -0,0 +1,115 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/SmingHub/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * PcSampler.h - Statistical program counter sampling
+ *
+ ****/
+
+#pragma once
+
+#include <esp_systemapi.h>
+
+/**
+ * @brief Number of distinct program counter values which can be recorded
+ */
+#ifndef PC_SAMPLER_SLOTS
+#define PC_SAMPLER_SLOTS 512
+#endif
+
+class Print;
+
+namespace Profiling
+{
+/**
+ * @brief Statistical profiler which samples the program counter from a timer interrupt
+ *
+ * Samples are accumulated into a fixed table of address and count, allocated by start()
+ * and released by clear(). The report may be written to any Print object, such as
+ * the serial port, a GdbFileStream or an HTTP response.
+ *
+ * Use the `pc-profile` build target to map samples to functions, or `iram-profile` (Esp8266)
+ * to generate a linker fragment placing the hottest flash functions into IRAM.
+ *
+ * Supported on Esp8266, Esp32 and Rp2040:
+ *
+ * - Esp8266 uses the hardware timer (timer1) in non-maskable mode, so code in critical sections
+ *   and interrupt handlers is also sampled.
+ * - Esp32 uses the hardware timer (timer1). The interrupted address is taken from the task context
+ *   saved on interrupt entry, so only task code is sampled and only on the core which called start().
+ * - Rp2040 claims a spare timer alarm and reads the address from the exception stack frame.
+ *   Only the core which called start() is sampled.
+ *
+ * On Esp8266 and Esp32 the hardware timer is unavailable to the application whilst sampling.
+ */
+namespace PcSampler
+{
+/**
+ * @brief Start sampling
+ * @param intervalUs Time between samples
+ * @retval bool false if unsupported, already running or out of memory
+ *
+ * Any previously recorded samples are discarded.
+ */
+bool start(unsigned intervalUs = 1000);
+
+/**
+ * @brief Stop sampling
+ *
+ * Recorded samples are retained until the next call to start() or clear().
+ */
+void stop();
+
+/**
+ * @brief Discard recorded samples and release memory
+ */
+void clear();
+
+bool isRunning();
+
+/**
+ * @brief Get the total number of samples taken, including those not recorded
+ */
+uint32_t getSampleCount();
+
+/**
+ * @brief Get number of samples which could not be recorded because the table was full
+ */
+uint32_t getDroppedCount();
+
+/**
+ * @brief Print recorded samples
+ * @param p
+ * @retval size_t Number of characters written
+ *
+ * Each line contains a program counter value and number of samples, in hexadecimal and decimal.
+ * The list is delimited by marker lines so it may be captured from a serial log.
+ * Sampling is paused whilst printing.
+ */
+size_t printReport(Print& p);
+
+/**
+ * @name Architecture-specific sampling timer
+ * @{
+ */
+
+/**
+ * @brief Start timer which calls record() with the interrupted program counter
+ * @retval bool false if not supported
+ */
+bool startTimer(unsigned intervalUs);
+
+void stopTimer();
+
+/**
+ * @brief Record a sample
+ * @note Called from interrupt context
+ */
+void record(uint32_t pc);
+
+/** @} */
+
+} // namespace PcSampler
+} // namespace Profiling
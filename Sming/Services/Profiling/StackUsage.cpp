@@ -0,0 +1,162 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/SmingHub/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * StackUsage.cpp
+ *
+ ****/
+
+#include "StackUsage.h"
+#include <Print.h>
+
+namespace Profiling
+{
+namespace StackUsage
+{
+namespace
+{
+// Space left below the current frame when painting
+constexpr size_t paintMargin{128};
+
+Bounds bounds;
+uintptr_t lowest;
+bool painted;
+
+/*
+ * Find the lowest word which differs from the paint pattern.
+ * Searching upwards from the bottom is unaffected by unused holes, such as partly-used buffers.
+ */
+uintptr_t findLowest()
+{
+	auto ptr = reinterpret_cast<const uint32_t*>(bounds.bottom);
+	auto end = reinterpret_cast<const uint32_t*>(bounds.top);
+	while(ptr < end && *ptr == paintValue) {
+		++ptr;
+	}
+	return uintptr_t(ptr);
+}
+
+/*
+ * Must be called with interrupts disabled where they share the stack
+ */
+void fill(uintptr_t from, uintptr_t to)
+{
+	auto ptr = reinterpret_cast<uint32_t*>(from & ~uintptr_t(3));
+	auto end = reinterpret_cast<uint32_t*>(to & ~uintptr_t(3));
+	while(ptr < end) {
+		*ptr++ = paintValue;
+	}
+}
+
+void updateLowest()
+{
+	auto low = findLowest();
+	if(low < lowest) {
+		lowest = low;
+	}
+}
+
+} // namespace
+
+bool paint()
+{
+	if(!getBounds(bounds)) {
+		return false;
+	}
+
+	auto level = noInterrupts();
+	fill(bounds.bottom, getStackPointer() - paintMargin);
+	restoreInterrupts(level);
+
+	lowest = bounds.top;
+	painted = true;
+	updateLowest();
+	return true;
+}
+
+bool isPainted()
+{
+	return painted;
+}
+
+size_t getSize()
+{
+	return bounds.top - bounds.bottom;
+}
+
+size_t getMaxUsed()
+{
+	if(!painted) {
+		return 0;
+	}
+	updateLowest();
+	return bounds.top - lowest;
+}
+
+size_t getMinFree()
+{
+	if(!painted) {
+		return 0;
+	}
+	updateLowest();
+	return lowest - bounds.bottom;
+}
+
+size_t getCurrentUsed()
+{
+	return painted ? bounds.top - getStackPointer() : 0;
+}
+
+uintptr_t beginMeasure()
+{
+	auto start = getStackPointer();
+	if(!painted) {
+		return start;
+	}
+
+	auto level = noInterrupts();
+	auto low = findLowest();
+	if(low < lowest) {
+		lowest = low;
+	}
+	fill(low, start - paintMargin);
+	restoreInterrupts(level);
+
+	return start;
+}
+
+size_t endMeasure(uintptr_t start)
+{
+	if(!painted) {
+		return 0;
+	}
+
+	auto low = findLowest();
+	if(low < lowest) {
+		lowest = low;
+	}
+	return (low < start) ? start - low : 0;
+}
+
+size_t printTo(Print& p)
+{
+	size_t n{0};
+	if(!painted) {
+		n += p.println(_F("Stack usage not available"));
+		return n;
+	}
+
+	n += p.print(_F("Stack: "));
+	n += p.print(getMaxUsed());
+	n += p.print(_F(" of "));
+	n += p.print(getSize());
+	n += p.print(_F(" bytes used, "));
+	n += p.print(getMinFree());
+	n += p.println(_F(" never used"));
+	return n;
+}
+
+} // namespace StackUsage
+} // namespace Profiling
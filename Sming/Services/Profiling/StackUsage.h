@@ -0,0 +1,117 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/SmingHub/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * StackUsage.h - Stack high-water-mark monitoring
+ *
+ ****/
+
+#pragma once
+
+#include <esp_systemapi.h>
+
+/**
+ * @brief Paint the main stack at startup and measure the stack depth of each task callback
+ */
+#ifndef ENABLE_STACK_USAGE
+#define ENABLE_STACK_USAGE 0
+#endif
+
+class Print;
+
+namespace Profiling
+{
+/**
+ * @brief Stack high-water-mark monitoring
+ *
+ * The unused part of the stack is filled with a known pattern by paint().
+ * The deepest point reached is then found by searching for the lowest word which has changed.
+ *
+ * When ENABLE_STACK_USAGE is set the stack is painted by System.initialize(), and if ENABLE_TASK_TIMING
+ * is also set the task dispatcher measures the depth reached by each callback,
+ * reported via Profiling::CallbackTiming.
+ *
+ * The stack measured is that used by the Sming task queue:
+ *
+ * - Esp8266: the system stack, shared with the SDK and interrupt handlers
+ * - Esp32: the Sming task stack
+ * - Rp2040: the core 0 stack, shared with interrupt handlers
+ */
+namespace StackUsage
+{
+constexpr uint32_t paintValue{0xA5A5A5A5};
+
+struct Bounds {
+	uintptr_t bottom; ///< Lowest address
+	uintptr_t top;	///< Address above highest word
+};
+
+/**
+ * @brief Get location of stack
+ * @retval bool false if not supported
+ * @note Implemented by each architecture
+ */
+bool getBounds(Bounds& bounds);
+
+/**
+ * @brief Get an approximation of the current stack pointer
+ */
+__forceinline uintptr_t getStackPointer()
+{
+	return uintptr_t(__builtin_frame_address(0));
+}
+
+/**
+ * @brief Fill unused stack with the paint pattern
+ * @retval bool false if not supported
+ */
+bool paint();
+
+bool isPainted();
+
+/**
+ * @brief Get total stack size in bytes
+ */
+size_t getSize();
+
+/**
+ * @brief Get the greatest number of bytes used since the stack was painted
+ */
+size_t getMaxUsed();
+
+/**
+ * @brief Get number of bytes never used since the stack was painted
+ */
+size_t getMinFree();
+
+/**
+ * @brief Get number of bytes currently in use
+ */
+size_t getCurrentUsed();
+
+/**
+ * @brief Start measuring stack depth
+ * @retval uintptr_t Stack position to pass to endMeasure()
+ *
+ * Any stack used since the previous measurement is accounted and the area below the current
+ * position is painted again, so only use within the measured code is seen.
+ */
+uintptr_t beginMeasure();
+
+/**
+ * @brief Finish measuring stack depth
+ * @param start Value returned from beginMeasure()
+ * @retval size_t Bytes used below `start`, including by any interrupt handlers which ran in the meantime
+ */
+size_t endMeasure(uintptr_t start);
+
+/**
+ * @brief Print stack usage summary
+ * @retval size_t Number of characters written
+ */
+size_t printTo(Print& p);
+
+} // namespace StackUsage
+} // namespace Profiling
@@ -26,6 +26,10 @@ namespace Profiling
  * - FREERTOS_GENERATE_RUN_TIME_STATS
  * - FREERTOS_VTASKLIST_INCLUDE_COREID (optional)
  *
+ * On other architectures, reports time spent in each task queue callback.
+ * This requires ENABLE_TASK_TIMING.
+ *
+ * @see Profiling::CallbackTiming
  */
 class TaskStat
 {
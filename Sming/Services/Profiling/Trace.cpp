@@ -0,0 +1,192 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/SmingHub/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * Trace.cpp
+ *
+ ****/
+
+#include "Trace.h"
+#include <Data/Stream/JsonWriterStream.h>
+#include <Platform/System.h>
+#include <esp_clk.h>
+#include <Print.h>
+
+static_assert(TRACE_BUFFER_SIZE > 0, "TRACE_BUFFER_SIZE must be non-zero");
+
+namespace Profiling
+{
+namespace Trace
+{
+namespace
+{
+Record records[TRACE_BUFFER_SIZE];
+unsigned writeIndex;
+unsigned count;
+unsigned dropped;
+bool enabled{true};
+
+/*
+ * Generates Chrome trace event format, one event per producer call.
+ * Cycle counts are extended to 64 bits as the 32-bit counter wraps within a minute.
+ */
+class TraceJsonStream : public JsonWriterStream
+{
+public:
+	TraceJsonStream() : JsonWriterStream(Producer(&TraceJsonStream::produce, this))
+	{
+		wasEnabled = isEnabled();
+		setEnabled(false);
+		cpuFrequency = System.getCpuFrequency();
+	}
+
+	~TraceJsonStream()
+	{
+		setEnabled(wasEnabled);
+	}
+
+private:
+	bool produce(JsonWriterStream& json);
+
+	uint64_t time{0};
+	uint32_t lastCycles{0};
+	unsigned index{0};
+	unsigned cpuFrequency; ///< MHz
+	bool wasEnabled;
+	bool started{false};
+};
+
+bool TraceJsonStream::produce(JsonWriterStream& json)
+{
+	if(!started) {
+		json.beginObject();
+		json.beginArray("traceEvents");
+		started = true;
+	}
+
+	Record rec;
+	if(!getRecord(index, rec)) {
+		json.endArray();
+		json.member("displayTimeUnit", "ns");
+		json.beginObject("otherData");
+		json.member("cpuFrequency", cpuFrequency);
+		json.member("dropped", getDropped());
+		return false;
+	}
+
+	if(index == 0) {
+		lastCycles = rec.cycles;
+	}
+	time += uint32_t(rec.cycles - lastCycles);
+	lastCycles = rec.cycles;
+
+	json.beginObject();
+	json.member("name", rec.name ? rec.name : "");
+	json.member("ph", (rec.phase == Phase::Begin) ? "B" : (rec.phase == Phase::End) ? "E" : "i");
+	json.name("ts");
+	json.value(double(time) / cpuFrequency, 3);
+	json.member("pid", 1);
+	json.member("tid", 1);
+	if(rec.phase == Phase::Instant) {
+		json.member("s", "t");
+	}
+	if(rec.phase != Phase::End) {
+		json.beginObject("args");
+		json.member("arg", rec.arg);
+		json.endObject();
+	}
+	json.endObject();
+
+	++index;
+	return true;
+}
+
+} // namespace
+
+void IRAM_ATTR add(Phase phase, const char* name, uint32_t arg)
+{
+	if(!enabled) {
+		return;
+	}
+
+	auto level = noInterrupts();
+	records[writeIndex] = Record{name, esp_get_ccount(), arg, phase};
+	if(++writeIndex == TRACE_BUFFER_SIZE) {
+		writeIndex = 0;
+	}
+	if(count < TRACE_BUFFER_SIZE) {
+		++count;
+	} else {
+		++dropped;
+	}
+	restoreInterrupts(level);
+}
+
+void setEnabled(bool enable)
+{
+	enabled = enable;
+}
+
+bool isEnabled()
+{
+	return enabled;
+}
+
+void clear()
+{
+	auto level = noInterrupts();
+	writeIndex = 0;
+	count = 0;
+	dropped = 0;
+	restoreInterrupts(level);
+}
+
+unsigned getCount()
+{
+	return count;
+}
+
+unsigned getDropped()
+{
+	return dropped;
+}
+
+bool getRecord(unsigned index, Record& record)
+{
+	bool res{false};
+	auto level = noInterrupts();
+	if(index < count) {
+		unsigned oldest = (writeIndex + TRACE_BUFFER_SIZE - count) % TRACE_BUFFER_SIZE;
+		record = records[(oldest + index) % TRACE_BUFFER_SIZE];
+		res = true;
+	}
+	restoreInterrupts(level);
+	return res;
+}
+
+IDataSourceStream* createJsonStream()
+{
+	return new TraceJsonStream;
+}
+
+size_t printJson(Print& p)
+{
+	TraceJsonStream stream;
+	size_t total{0};
+	char buffer[128];
+	while(!stream.isFinished()) {
+		auto len = stream.readMemoryBlock(buffer, sizeof(buffer));
+		if(len == 0) {
+			break;
+		}
+		p.write(reinterpret_cast<uint8_t*>(buffer), len);
+		stream.seek(len);
+		total += len;
+	}
+	return total;
+}
+
+} // namespace Trace
+} // namespace Profiling
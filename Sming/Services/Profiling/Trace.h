@@ -0,0 +1,177 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/SmingHub/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * Trace.h - Lightweight event tracing into a RAM ring buffer
+ *
+ ****/
+
+#pragma once
+
+#include <esp_systemapi.h>
+
+/**
+ * @brief Enable tracepoints
+ *
+ * When 0, all TRACE_xxx macros compile to nothing.
+ */
+#ifndef ENABLE_TRACE
+#define ENABLE_TRACE 0
+#endif
+
+/**
+ * @brief Number of records held in the trace buffer
+ */
+#ifndef TRACE_BUFFER_SIZE
+#define TRACE_BUFFER_SIZE 256
+#endif
+
+class Print;
+class IDataSourceStream;
+
+namespace Profiling
+{
+/**
+ * @brief Event tracing
+ *
+ * Tracepoints write a timestamped record into a fixed-size ring buffer in RAM.
+ * When the buffer is full the oldest records are overwritten, so it always holds
+ * the most recent activity. Recording is cheap enough to leave in place around
+ * task callbacks, timer expiry, network events and flash operations, and the
+ * resulting timeline shows the order in which these occurred.
+ *
+ * Timestamps are CPU cycle counts. The buffer may be exported as Chrome trace
+ * JSON for viewing in https://ui.perfetto.dev or chrome://tracing.
+ *
+ * Recording may be done from interrupt context.
+ */
+namespace Trace
+{
+enum class Phase : uint8_t {
+	Begin,	 ///< Start of a duration
+	End,	 ///< End of a duration
+	Instant, ///< Single event
+};
+
+struct Record {
+	const char* name; ///< Event name, must be a string with static storage
+	uint32_t cycles;  ///< CPU cycle count when event was recorded
+	uint32_t arg;	  ///< Event-specific value, such as an object address or size
+	Phase phase;
+};
+
+/**
+ * @brief Add a record to the trace buffer
+ * @param phase
+ * @param name Pointer is stored, so the string must not be changed or freed
+ * @param arg
+ * @note Called via TRACE_xxx macros
+ */
+void IRAM_ATTR add(Phase phase, const char* name, uint32_t arg);
+
+/**
+ * @brief Start or stop recording
+ *
+ * This is enabled by default. Recording is paused whilst exporting the buffer.
+ */
+void setEnabled(bool enable);
+
+bool isEnabled();
+
+/**
+ * @brief Discard all records
+ */
+void clear();
+
+/**
+ * @brief Get number of records in the buffer
+ */
+unsigned getCount();
+
+/**
+ * @brief Get number of records overwritten since the last call to clear()
+ */
+unsigned getDropped();
+
+/**
+ * @brief Get a record
+ * @param index 0 for the oldest record
+ * @param record On success, receives a copy of the record
+ * @retval bool false if index is out of range
+ */
+bool getRecord(unsigned index, Record& record);
+
+/**
+ * @brief Create a stream to read the buffer as Chrome trace JSON, e.g. for a HTTP response
+ * @retval IDataSourceStream*
+ * @note Recording is paused until the stream is destroyed
+ */
+IDataSourceStream* createJsonStream();
+
+/**
+ * @brief Print the buffer as Chrome trace JSON, e.g. to Serial
+ * @retval size_t Number of characters written
+ */
+size_t printJson(Print& p);
+
+/**
+ * @brief Records begin and end of a scope
+ */
+class Scope
+{
+public:
+	Scope(const char* name, uint32_t arg) : name(name)
+	{
+		add(Phase::Begin, name, arg);
+	}
+
+	~Scope()
+	{
+		add(Phase::End, name, 0);
+	}
+
+private:
+	const char* name;
+};
+
+} // namespace Trace
+} // namespace Profiling
+
+#define TRACE_CONCAT_(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_(a, b)
+
+#if ENABLE_TRACE
+
+#define TRACE_ARG(arg) uint32_t(uintptr_t(arg))
+
+/**
+ * @name Tracepoints
+ * @param name Event name, a string literal
+ * @param arg Value stored with the event: an integer or pointer, truncated to 32 bits
+ * @{
+ */
+#define TRACE_BEGIN(name, arg) Profiling::Trace::add(Profiling::Trace::Phase::Begin, name, TRACE_ARG(arg))
+#define TRACE_END(name) Profiling::Trace::add(Profiling::Trace::Phase::End, name, 0)
+#define TRACE_INSTANT(name, arg) Profiling::Trace::add(Profiling::Trace::Phase::Instant, name, TRACE_ARG(arg))
+/** @brief Trace from here to end of the enclosing scope */
+#define TRACE_SCOPE(name, arg) Profiling::Trace::Scope TRACE_CONCAT(trace_, __LINE__)(name, TRACE_ARG(arg))
+/** @} */
+
+#else
+
+#define TRACE_BEGIN(name, arg)                                                                                         \
+	do {                                                                                                               \
+	} while(0)
+#define TRACE_END(name)                                                                                                \
+	do {                                                                                                               \
+	} while(0)
+#define TRACE_INSTANT(name, arg)                                                                                       \
+	do {                                                                                                               \
+	} while(0)
+#define TRACE_SCOPE(name, arg)                                                                                         \
+	do {                                                                                                               \
+	} while(0)
+
+#endif
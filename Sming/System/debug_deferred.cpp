@@ -0,0 +1,249 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/SmingHub/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * debug_deferred.cpp
+ *
+ ****/
+
+#include "debug_deferred.h"
+#include "m_printf.h"
+#include <FakePgmSpace.h>
+#include <esp_systemapi.h>
+#include <Platform/System.h>
+#include <algorithm>
+
+#if DEBUG_DEFERRED
+
+static_assert((DEBUG_DEFERRED_BUFFER_SIZE & (DEBUG_DEFERRED_BUFFER_SIZE - 1)) == 0,
+			  "DEBUG_DEFERRED_BUFFER_SIZE must be a power of 2");
+static_assert(DEBUG_DEFERRED_BUFFER_SIZE >= DebugLog::maxRecordSize, "DEBUG_DEFERRED_BUFFER_SIZE too small");
+
+namespace DebugLog
+{
+namespace
+{
+constexpr unsigned bufferMask{DEBUG_DEFERRED_BUFFER_SIZE - 1};
+constexpr size_t maxLineLength{256};
+
+uint8_t buffer[DEBUG_DEFERRED_BUFFER_SIZE];
+unsigned head; ///< Write position, free-running
+unsigned tail; ///< Read position, free-running
+unsigned dropped;
+unsigned droppedReported;
+bool drainQueued;
+
+void drain()
+{
+	drainQueued = false;
+	flush();
+}
+
+bool read(uint8_t* record)
+{
+	auto level = noInterrupts();
+	if(tail == head) {
+		restoreInterrupts(level);
+		return false;
+	}
+	unsigned length = buffer[tail & bufferMask];
+	for(unsigned i = 0; i < length; ++i) {
+		record[i] = buffer[(tail + i) & bufferMask];
+	}
+	tail += length;
+	restoreInterrupts(level);
+	return true;
+}
+
+/*
+ * Format one argument using its conversion specification
+ * Returns false if the argument type doesn't match the conversion
+ */
+bool formatArg(char* out, size_t size, const char* spec, char conversion, const uint8_t* record, unsigned& pos)
+{
+	auto type = ArgType(record[pos++]);
+	bool isString = (conversion == 's');
+	bool isFloat = (strchr("fFeEgG", conversion) != nullptr);
+
+	switch(type) {
+	case ArgType::Int: {
+		uint32_t value;
+		memcpy(&value, &record[pos], sizeof(value));
+		pos += sizeof(value);
+		if(isString || isFloat) {
+			return false;
+		}
+		m_snprintf(out, size, spec, value);
+		return true;
+	}
+
+	case ArgType::Pointer: {
+		const void* value;
+		memcpy(&value, &record[pos], sizeof(value));
+		pos += sizeof(value);
+		if(isString || isFloat) {
+			return false;
+		}
+		m_snprintf(out, size, spec, value);
+		return true;
+	}
+
+	case ArgType::Double: {
+		double value;
+		memcpy(&value, &record[pos], sizeof(value));
+		pos += sizeof(value);
+		if(!isFloat) {
+			return false;
+		}
+		m_snprintf(out, size, spec, value);
+		return true;
+	}
+
+	case ArgType::String: {
+		unsigned length = record[pos++];
+		char str[maxStringLength + 1];
+		memcpy(str, &record[pos], length);
+		str[length] = '\0';
+		pos += length;
+		if(!isString) {
+			return false;
+		}
+		m_snprintf(out, size, spec, str);
+		return true;
+	}
+
+	default:
+		pos = record[0];
+		return false;
+	}
+}
+
+size_t format(const uint8_t* record, char* out, size_t size)
+{
+	unsigned length = record[0];
+	const char* fmtPtr;
+	memcpy(&fmtPtr, &record[1], sizeof(fmtPtr));
+	unsigned pos = 1 + sizeof(fmtPtr);
+
+	char fmt[maxLineLength];
+	strncpy_P(fmt, fmtPtr, sizeof(fmt));
+	fmt[sizeof(fmt) - 1] = '\0';
+
+	size_t n{0};
+	auto append = [&](const char* s) {
+		while(*s != '\0' && n + 1 < size) {
+			out[n++] = *s++;
+		}
+	};
+
+	for(const char* f = fmt; *f != '\0';) {
+		if(*f != '%' || f[1] == '%') {
+			if(n + 1 < size) {
+				out[n++] = *f;
+			}
+			f += (*f == '%') ? 2 : 1;
+			continue;
+		}
+
+		auto start = f++;
+		while(*f != '\0' && strchr("-+ #0123456789.lhL", *f) != nullptr) {
+			++f;
+		}
+		char conversion = *f;
+		if(conversion != '\0') {
+			++f;
+		}
+
+		char spec[16];
+		auto specLength = std::min(size_t(f - start), sizeof(spec) - 1);
+		memcpy(spec, start, specLength);
+		spec[specLength] = '\0';
+
+		char value[64];
+		if(pos >= length || !formatArg(value, sizeof(value), spec, conversion, record, pos)) {
+			strcpy(value, "?");
+		}
+		append(value);
+	}
+
+	out[n] = '\0';
+	return n;
+}
+
+} // namespace
+
+void Encoder::add(const char* str)
+{
+	if(str == nullptr) {
+		str = "(null)";
+	}
+
+	char flashBuffer[maxStringLength];
+	if(isFlashPtr(str)) {
+		strncpy_P(flashBuffer, str, maxStringLength);
+		str = flashBuffer;
+	}
+	auto len = strnlen(str, maxStringLength);
+	if(length + 2 + len > maxRecordSize) {
+		return;
+	}
+	buffer[length++] = uint8_t(ArgType::String);
+	buffer[length++] = len;
+	put(str, len);
+}
+
+bool IRAM_ATTR write(const void* record, size_t length)
+{
+	auto src = static_cast<const uint8_t*>(record);
+
+	auto level = noInterrupts();
+	if(DEBUG_DEFERRED_BUFFER_SIZE - (head - tail) < length) {
+		++dropped;
+		restoreInterrupts(level);
+		return false;
+	}
+	for(unsigned i = 0; i < length; ++i) {
+		buffer[(head + i) & bufferMask] = src[i];
+	}
+	head += length;
+	bool queue = !drainQueued;
+	drainQueued = true;
+	restoreInterrupts(level);
+
+	if(queue && !System.queueCallback(TaskPriority::Low, drain)) {
+		// Try again on next write
+		drainQueued = false;
+	}
+	return true;
+}
+
+unsigned flush()
+{
+	unsigned count{0};
+	uint8_t record[maxRecordSize];
+	char line[maxLineLength];
+	while(read(record)) {
+		auto n = format(record, line, sizeof(line));
+		m_nputs(line, n);
+		++count;
+	}
+
+	auto d = dropped;
+	if(d != droppedReported) {
+		m_printf(_F("[%u debug messages dropped]\r\n"), d - droppedReported);
+		droppedReported = d;
+	}
+
+	return count;
+}
+
+unsigned getDropped()
+{
+	return dropped;
+}
+
+} // namespace DebugLog
+
+#endif // DEBUG_DEFERRED
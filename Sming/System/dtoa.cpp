@@ -0,0 +1,475 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/SmingHub/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * dtoa.cpp - Floating-point to decimal conversion
+ *
+ * Uses the Grisu2 algorithm described in "Printing Floating-Point Numbers Quickly and Accurately
+ * with Integers" by Florian Loitsch, PLDI 2010. This generates the shortest (or very nearly so) digit
+ * sequence which reads back as the original value, using only 64-bit integer arithmetic.
+ *
+ ****/
+
+#include <cstdint>
+#include <cstring>
+#include <cmath>
+#include <limits>
+#include <type_traits>
+#include <sys/pgmspace.h>
+#include "stringconversion.h"
+
+namespace
+{
+/*
+ * Unnormalised floating-point value f * 2^e
+ */
+struct DiyFp {
+	uint64_t f;
+	int e;
+
+	static DiyFp sub(const DiyFp& x, const DiyFp& y)
+	{
+		return DiyFp{x.f - y.f, x.e};
+	}
+
+	/*
+	 * Returns x * y rounded to 64 bits
+	 */
+	static DiyFp mul(const DiyFp& x, const DiyFp& y)
+	{
+		uint64_t u_lo = x.f & 0xffffffffU;
+		uint64_t u_hi = x.f >> 32;
+		uint64_t v_lo = y.f & 0xffffffffU;
+		uint64_t v_hi = y.f >> 32;
+
+		uint64_t p0 = u_lo * v_lo;
+		uint64_t p1 = u_lo * v_hi;
+		uint64_t p2 = u_hi * v_lo;
+		uint64_t p3 = u_hi * v_hi;
+
+		uint64_t q = (p0 >> 32) + (p1 & 0xffffffffU) + (p2 & 0xffffffffU);
+		q += uint64_t(1) << 31; // round
+
+		uint64_t h = p3 + (p2 >> 32) + (p1 >> 32) + (q >> 32);
+		return DiyFp{h, x.e + y.e + 64};
+	}
+
+	static DiyFp normalize(DiyFp x)
+	{
+		while((x.f >> 63) == 0) {
+			x.f <<= 1;
+			--x.e;
+		}
+		return x;
+	}
+
+	static DiyFp normalizeTo(const DiyFp& x, int targetExponent)
+	{
+		return DiyFp{x.f << (x.e - targetExponent), targetExponent};
+	}
+};
+
+/*
+ * Normalised value w and boundaries m- and m+ of the interval which rounds to the same value
+ */
+struct Boundaries {
+	DiyFp w;
+	DiyFp minus;
+	DiyFp plus;
+};
+
+template <typename T> Boundaries computeBoundaries(T value)
+{
+	constexpr int precision = std::numeric_limits<T>::digits; // Including hidden bit
+	constexpr int bias = std::numeric_limits<T>::max_exponent - 1 + (precision - 1);
+	constexpr int minExp = 1 - bias;
+	constexpr uint64_t hiddenBit = uint64_t(1) << (precision - 1);
+
+	using Bits = typename std::conditional<precision == 24, uint32_t, uint64_t>::type;
+	static_assert(sizeof(Bits) == sizeof(T), "Unsupported floating-point type");
+	Bits bits;
+	memcpy(&bits, &value, sizeof(bits));
+
+	uint64_t E = bits >> (precision - 1);
+	uint64_t F = bits & (hiddenBit - 1);
+
+	DiyFp v = (E == 0) ? DiyFp{F, minExp} : DiyFp{F + hiddenBit, int(E) - bias};
+
+	// Interval is asymmetric at powers of two, except for the smallest normal
+	bool lowerBoundaryIsCloser = (F == 0 && E > 1);
+	DiyFp mPlus{2 * v.f + 1, v.e - 1};
+	DiyFp mMinus = lowerBoundaryIsCloser ? DiyFp{4 * v.f - 1, v.e - 2} : DiyFp{2 * v.f - 1, v.e - 1};
+
+	DiyFp wPlus = DiyFp::normalize(mPlus);
+	DiyFp wMinus = DiyFp::normalizeTo(mMinus, wPlus.e);
+	return Boundaries{DiyFp::normalize(v), wMinus, wPlus};
+}
+
+/*
+ * Values are scaled so their binary exponent lies within [-60, -32],
+ * which allows digit generation to work on 32-bit integer parts
+ */
+constexpr int minScaledExponent = -60;
+
+struct CachedPower {
+	uint64_t f;
+	int16_t e;
+	int16_t k;
+};
+
+/*
+ * Normalised powers of ten, c = f * 2^e ~= 10^k, for k = -300 to 324 in steps of 8
+ */
+constexpr int cachedPowersMinDecExp = -300;
+constexpr int cachedPowersDecStep = 8;
+
+const CachedPower cachedPowers[] PROGMEM = {
+	{0xAB70FE17C79AC6CA, -1060, -300},
+	{0xFF77B1FCBEBCDC4F, -1034, -292},
+	{0xBE5691EF416BD60C, -1007, -284},
+	{0x8DD01FAD907FFC3C, -980, -276},
+	{0xD3515C2831559A83, -954, -268},
+	{0x9D71AC8FADA6C9B5, -927, -260},
+	{0xEA9C227723EE8BCB, -901, -252},
+	{0xAECC49914078536D, -874, -244},
+	{0x823C12795DB6CE57, -847, -236},
+	{0xC21094364DFB5637, -821, -228},
+	{0x9096EA6F3848984F, -794, -220},
+	{0xD77485CB25823AC7, -768, -212},
+	{0xA086CFCD97BF97F4, -741, -204},
+	{0xEF340A98172AACE5, -715, -196},
+	{0xB23867FB2A35B28E, -688, -188},
+	{0x84C8D4DFD2C63F3B, -661, -180},
+	{0xC5DD44271AD3CDBA, -635, -172},
+	{0x936B9FCEBB25C996, -608, -164},
+	{0xDBAC6C247D62A584, -582, -156},
+	{0xA3AB66580D5FDAF6, -555, -148},
+	{0xF3E2F893DEC3F126, -529, -140},
+	{0xB5B5ADA8AAFF80B8, -502, -132},
+	{0x87625F056C7C4A8B, -475, -124},
+	{0xC9BCFF6034C13053, -449, -116},
+	{0x964E858C91BA2655, -422, -108},
+	{0xDFF9772470297EBD, -396, -100},
+	{0xA6DFBD9FB8E5B88F, -369, -92},
+	{0xF8A95FCF88747D94, -343, -84},
+	{0xB94470938FA89BCF, -316, -76},
+	{0x8A08F0F8BF0F156B, -289, -68},
+	{0xCDB02555653131B6, -263, -60},
+	{0x993FE2C6D07B7FAC, -236, -52},
+	{0xE45C10C42A2B3B06, -210, -44},
+	{0xAA242499697392D3, -183, -36},
+	{0xFD87B5F28300CA0E, -157, -28},
+	{0xBCE5086492111AEB, -130, -20},
+	{0x8CBCCC096F5088CC, -103, -12},
+	{0xD1B71758E219652C, -77, -4},
+	{0x9C40000000000000, -50, 4},
+	{0xE8D4A51000000000, -24, 12},
+	{0xAD78EBC5AC620000, 3, 20},
+	{0x813F3978F8940984, 30, 28},
+	{0xC097CE7BC90715B3, 56, 36},
+	{0x8F7E32CE7BEA5C70, 83, 44},
+	{0xD5D238A4ABE98068, 109, 52},
+	{0x9F4F2726179A2245, 136, 60},
+	{0xED63A231D4C4FB27, 162, 68},
+	{0xB0DE65388CC8ADA8, 189, 76},
+	{0x83C7088E1AAB65DB, 216, 84},
+	{0xC45D1DF942711D9A, 242, 92},
+	{0x924D692CA61BE758, 269, 100},
+	{0xDA01EE641A708DEA, 295, 108},
+	{0xA26DA3999AEF774A, 322, 116},
+	{0xF209787BB47D6B85, 348, 124},
+	{0xB454E4A179DD1877, 375, 132},
+	{0x865B86925B9BC5C2, 402, 140},
+	{0xC83553C5C8965D3D, 428, 148},
+	{0x952AB45CFA97A0B3, 455, 156},
+	{0xDE469FBD99A05FE3, 481, 164},
+	{0xA59BC234DB398C25, 508, 172},
+	{0xF6C69A72A3989F5C, 534, 180},
+	{0xB7DCBF5354E9BECE, 561, 188},
+	{0x88FCF317F22241E2, 588, 196},
+	{0xCC20CE9BD35C78A5, 614, 204},
+	{0x98165AF37B2153DF, 641, 212},
+	{0xE2A0B5DC971F303A, 667, 220},
+	{0xA8D9D1535CE3B396, 694, 228},
+	{0xFB9B7CD9A4A7443C, 720, 236},
+	{0xBB764C4CA7A44410, 747, 244},
+	{0x8BAB8EEFB6409C1A, 774, 252},
+	{0xD01FEF10A657842C, 800, 260},
+	{0x9B10A4E5E9913129, 827, 268},
+	{0xE7109BFBA19C0C9D, 853, 276},
+	{0xAC2820D9623BF429, 880, 284},
+	{0x80444B5E7AA7CF85, 907, 292},
+	{0xBF21E44003ACDD2D, 933, 300},
+	{0x8E679C2F5E44FF8F, 960, 308},
+	{0xD433179D9C8CB841, 986, 316},
+	{0x9E19DB92B4E31BA9, 1013, 324},
+};
+
+CachedPower getCachedPower(int e)
+{
+	// Find k such that scaled exponent e + cached.e + 64 is within the required range
+	int f = minScaledExponent - e - 1;
+	int k = (f * 78913) / (1 << 18) + int(f > 0); // ceil(f * log10(2))
+	int index = (-cachedPowersMinDecExp + k + (cachedPowersDecStep - 1)) / cachedPowersDecStep;
+
+	CachedPower cached;
+	memcpy_P(&cached, &cachedPowers[index], sizeof(cached));
+	return cached;
+}
+
+/*
+ * Returns number of decimal digits in n, and the corresponding largest power of ten <= n
+ */
+int findLargestPow10(uint32_t n, uint32_t& pow10)
+{
+	static constexpr uint32_t powers[]{1,		10,		 100,	   1000,	  10000,
+									   100000, 1000000, 10000000, 100000000, 1000000000};
+	int digits = 10;
+	while(digits > 1 && n < powers[digits - 1]) {
+		--digits;
+	}
+	pow10 = powers[digits - 1];
+	return digits;
+}
+
+void grisu2Round(char* buf, int len, uint64_t dist, uint64_t delta, uint64_t rest, uint64_t tenK)
+{
+	// Move the last digit towards w whilst staying within the rounding interval
+	while(rest < dist && delta - rest >= tenK && (rest + tenK < dist || dist - rest > rest + tenK - dist)) {
+		--buf[len - 1];
+		rest += tenK;
+	}
+}
+
+void grisu2DigitGen(char* buffer, int& length, int& decimalExponent, DiyFp mMinus, DiyFp w, DiyFp mPlus)
+{
+	uint64_t delta = DiyFp::sub(mPlus, mMinus).f;
+	uint64_t dist = DiyFp::sub(mPlus, w).f;
+
+	const DiyFp one{uint64_t(1) << -mPlus.e, mPlus.e};
+
+	auto p1 = uint32_t(mPlus.f >> -one.e); // Integral part, fits in 32 bits
+	uint64_t p2 = mPlus.f & (one.f - 1);   // Fractional part
+
+	uint32_t pow10;
+	int n = findLargestPow10(p1, pow10);
+	while(n > 0) {
+		buffer[length++] = '0' + (p1 / pow10);
+		p1 %= pow10;
+		--n;
+
+		uint64_t rest = (uint64_t(p1) << -one.e) + p2;
+		if(rest <= delta) {
+			decimalExponent += n;
+			grisu2Round(buffer, length, dist, delta, rest, uint64_t(pow10) << -one.e);
+			return;
+		}
+		pow10 /= 10;
+	}
+
+	int m = 0;
+	for(;;) {
+		p2 *= 10;
+		buffer[length++] = '0' + (p2 >> -one.e);
+		p2 &= one.f - 1;
+		++m;
+		delta *= 10;
+		dist *= 10;
+		if(p2 <= delta) {
+			break;
+		}
+	}
+	decimalExponent -= m;
+	grisu2Round(buffer, length, dist, delta, p2, one.f);
+}
+
+/*
+ * Generate digits for a positive, finite value
+ * Result is digits * 10^decimalExponent
+ */
+template <typename T> int grisu2(char* buffer, int& decimalExponent, T value)
+{
+	auto b = computeBoundaries(value);
+	auto cached = getCachedPower(b.plus.e);
+	DiyFp c{cached.f, cached.e};
+
+	DiyFp w = DiyFp::mul(b.w, c);
+	DiyFp wMinus = DiyFp::mul(b.minus, c);
+	DiyFp wPlus = DiyFp::mul(b.plus, c);
+
+	// Shrink interval to allow for rounding errors in multiplication
+	DiyFp mMinus{wMinus.f + 1, wMinus.e};
+	DiyFp mPlus{wPlus.f - 1, wPlus.e};
+
+	int length = 0;
+	decimalExponent = -cached.k;
+	grisu2DigitGen(buffer, length, decimalExponent, mMinus, w, mPlus);
+	return length;
+}
+
+template <typename T> int generateDigits(T value, char* digits, int& decimalExponent)
+{
+	if(value == 0) {
+		digits[0] = '0';
+		decimalExponent = 0;
+		return 1;
+	}
+	return grisu2(digits, decimalExponent, value);
+}
+
+/*
+ * Write digits * 10^decimalExponent in shortest form, using exponential notation
+ * for very large or small values.
+ */
+size_t formatShortest(char* buf, const char* digits, int len, int decimalExponent)
+{
+	char* p = buf;
+	int n = len + decimalExponent; // Position of decimal point
+
+	if(len <= n && n <= 21) {
+		// Integer
+		memcpy(p, digits, len);
+		p += len;
+		memset(p, '0', n - len);
+		p += n - len;
+	} else if(n > 0 && n <= 21) {
+		// dddd.ddd
+		memcpy(p, digits, n);
+		p += n;
+		*p++ = '.';
+		memcpy(p, digits + n, len - n);
+		p += len - n;
+	} else if(n > -6 && n <= 0) {
+		// 0.0000ddd
+		*p++ = '0';
+		*p++ = '.';
+		memset(p, '0', -n);
+		p += -n;
+		memcpy(p, digits, len);
+		p += len;
+	} else {
+		// d.ddde+XX
+		*p++ = digits[0];
+		if(len > 1) {
+			*p++ = '.';
+			memcpy(p, digits + 1, len - 1);
+			p += len - 1;
+		}
+		*p++ = 'e';
+		int e = n - 1;
+		if(e < 0) {
+			*p++ = '-';
+			e = -e;
+		} else {
+			*p++ = '+';
+		}
+		if(e >= 100) {
+			*p++ = '0' + (e / 100);
+			e %= 100;
+			*p++ = '0' + (e / 10);
+		} else if(e >= 10) {
+			*p++ = '0' + (e / 10);
+		}
+		*p++ = '0' + (e % 10);
+	}
+
+	*p = '\0';
+	return p - buf;
+}
+
+template <typename T> size_t toShortest(T value, char* buffer)
+{
+	if(std::isnan(value)) {
+		strcpy(buffer, "nan");
+		return 3;
+	}
+
+	char* p = buffer;
+	if(std::signbit(value)) {
+		*p++ = '-';
+		value = -value;
+	}
+
+	if(std::isinf(value)) {
+		strcpy(p, "inf");
+		return p + 3 - buffer;
+	}
+
+	char digits[20];
+	int decimalExponent;
+	int len = generateDigits(value, digits, decimalExponent);
+	return (p - buffer) + formatShortest(p, digits, len, decimalExponent);
+}
+
+} // namespace
+
+size_t dtoa_shortest(double value, char* buffer)
+{
+	return toShortest(value, buffer);
+}
+
+size_t ftoa_shortest(float value, char* buffer)
+{
+	return toShortest(value, buffer);
+}
+
+size_t dtoa_fixed(double value, char* buffer, unsigned decimalPlaces)
+{
+	if(!std::isfinite(value)) {
+		return toShortest(value, buffer);
+	}
+
+	char* p = buffer;
+	if(value < 0) {
+		*p++ = '-';
+		value = -value;
+	}
+
+	char digits[20];
+	int decimalExponent;
+	int len = generateDigits(value, digits, decimalExponent);
+	int point = len + decimalExponent; // Number of digits before decimal point
+
+	// Round half away from zero at the requested position
+	int keep = point + int(decimalPlaces);
+	if(keep < len) {
+		bool roundUp = (keep >= 0) && digits[keep] >= '5';
+		len = (keep > 0) ? keep : 0;
+		if(roundUp) {
+			int i = len - 1;
+			while(i >= 0 && digits[i] == '9') {
+				--i;
+			}
+			if(i < 0) {
+				digits[0] = '1';
+				len = 1;
+				++point;
+			} else {
+				++digits[i];
+				len = i + 1;
+			}
+		}
+	}
+
+	auto digit = [&](int i) -> char { return (i >= 0 && i < len) ? digits[i] : '0'; };
+
+	if(point <= 0) {
+		*p++ = '0';
+	} else {
+		for(int i = 0; i < point; ++i) {
+			*p++ = digit(i);
+		}
+	}
+
+	if(decimalPlaces != 0) {
+		*p++ = '.';
+		for(unsigned i = 0; i < decimalPlaces; ++i) {
+			*p++ = digit(point + int(i));
+		}
+	}
+
+	*p = '\0';
+	return p - buffer;
+}
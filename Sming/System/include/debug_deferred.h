@@ -0,0 +1,158 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/SmingHub/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * debug_deferred.h - Deferred formatting for debug_x macros
+ *
+ ****/
+
+#pragma once
+
+#include <esp_attr.h>
+#include <sming_attr.h>
+#include <stdint.h>
+#include <string.h>
+#include <type_traits>
+#include <cstddef>
+
+/**
+ * @brief Size of deferred log buffer in bytes, must be a power of 2
+ */
+#ifndef DEBUG_DEFERRED_BUFFER_SIZE
+#define DEBUG_DEFERRED_BUFFER_SIZE 2048
+#endif
+
+/**
+ * @brief Deferred logging
+ *
+ * With DEBUG_DEFERRED=1 the debug_x macros do not format anything. Instead they store
+ * the address of the format string (in flash) and the raw argument values in a RAM ring buffer.
+ * A low-priority task formats the records and writes them to the debug output.
+ *
+ * String arguments are copied, truncated to maxStringLength characters.
+ * Integers are stored as 32 bits, consistent with m_printf() which ignores length modifiers.
+ *
+ * When the buffer is full new records are discarded and counted.
+ * Records may be written from interrupt context.
+ */
+namespace DebugLog
+{
+enum class ArgType : uint8_t {
+	Int,
+	Pointer,
+	Double,
+	String,
+};
+
+constexpr size_t maxRecordSize{128};
+constexpr size_t maxStringLength{32};
+
+/**
+ * @brief Add an encoded record to the buffer
+ * @retval bool false if there was no room and the record was discarded
+ */
+bool IRAM_ATTR write(const void* record, size_t length);
+
+/**
+ * @brief Format and output all pending records immediately
+ * @retval unsigned Number of records output
+ * @note Call before a deliberate restart, for example, so messages are not lost
+ */
+unsigned flush();
+
+/**
+ * @brief Get number of records discarded because the buffer was full
+ */
+unsigned getDropped();
+
+/**
+ * @brief Builds a record on the stack
+ *
+ * Layout is: length (1 byte), format string address, then for each argument an ArgType byte
+ * followed by the value. Arguments which do not fit are omitted and appear as `?` in the output.
+ */
+class Encoder
+{
+public:
+	__forceinline Encoder(const char* fmt)
+	{
+		put(&fmt, sizeof(fmt));
+	}
+
+	template <typename T>
+	__forceinline typename std::enable_if<std::is_integral<T>::value || std::is_enum<T>::value>::type add(T value)
+	{
+		auto n = uint32_t(value);
+		put(ArgType::Int, &n, sizeof(n));
+	}
+
+	template <typename T> __forceinline typename std::enable_if<std::is_floating_point<T>::value>::type add(T value)
+	{
+		auto d = double(value);
+		put(ArgType::Double, &d, sizeof(d));
+	}
+
+	template <typename T> __forceinline void add(const T* ptr)
+	{
+		put(ArgType::Pointer, &ptr, sizeof(ptr));
+	}
+
+	__forceinline void add(std::nullptr_t)
+	{
+		add(static_cast<const void*>(nullptr));
+	}
+
+	void add(const char* str);
+
+	__forceinline bool commit()
+	{
+		buffer[0] = length;
+		return write(buffer, length);
+	}
+
+private:
+	__forceinline void put(const void* data, size_t size)
+	{
+		memcpy(&buffer[length], data, size);
+		length += size;
+	}
+
+	__forceinline void put(ArgType type, const void* data, size_t size)
+	{
+		if(length + 1 + size > maxRecordSize) {
+			return;
+		}
+		buffer[length++] = uint8_t(type);
+		put(data, size);
+	}
+
+	uint8_t buffer[maxRecordSize];
+	uint8_t length{1};
+};
+
+__forceinline void encode(Encoder&)
+{
+}
+
+template <typename T, typename... Args> __forceinline void encode(Encoder& encoder, T arg, Args... args)
+{
+	encoder.add(arg);
+	encode(encoder, args...);
+}
+
+/**
+ * @brief Store a log record
+ * @param fmt Format string, which must have static storage (normally in flash)
+ * @param args
+ * @note Called via debug_x macros
+ */
+template <typename... Args> __forceinline void log(const char* fmt, Args... args)
+{
+	Encoder encoder(fmt);
+	encode(encoder, args...);
+	encoder.commit();
+}
+
+} // namespace DebugLog
@@ -18,6 +18,16 @@
 
 #include "FakePgmSpace.h"
 
+//Store debug messages for formatting later, instead of printing them immediately
+//Can be overridden in Makefile
+#ifndef DEBUG_DEFERRED
+#define DEBUG_DEFERRED 0
+#endif
+
+#if DEBUG_DEFERRED && defined(__cplusplus)
+#include "debug_deferred.h"
+#endif
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -67,20 +77,27 @@ extern uint32_t system_get_time();
 //A static const char[] is defined having a unique name (log_ prefix, filename and line number)
 //This will be stored in the irom section(on flash) freeing up the RAM
 //Next special version of printf from FakePgmSpace is called to fetch and print the message
-#if DEBUG_PRINT_FILENAME_AND_LINE
-#define debug_e(fmt, ...)                                                                                              \
+//In deferred mode the flash address is stored with the arguments and formatted later
+#if DEBUG_DEFERRED && defined(__cplusplus)
+#define DEBUG_LOG_(fmt, ...)                                                                                           \
 	(__extension__({                                                                                                   \
-		PSTR_ARRAY(fmtbuf, "[" MACROQUOTE(CUST_FILE_BASE) ":%d] " fmt "\r\n");                                         \
-		m_printf(fmtbuf, __LINE__, ##__VA_ARGS__);                                                                     \
+		DEFINE_PSTR_LOCAL(fmtbuf, fmt);                                                                                \
+		DebugLog::log(fmtbuf, ##__VA_ARGS__);                                                                          \
 	}))
 #else
-#define debug_e(fmt, ...)                                                                                              \
+#define DEBUG_LOG_(fmt, ...)                                                                                           \
 	(__extension__({                                                                                                   \
-		PSTR_ARRAY(fmtbuf, "%u " fmt "\r\n");                                                                          \
-		m_printf(fmtbuf, system_get_time(), ##__VA_ARGS__);                                                            \
+		PSTR_ARRAY(fmtbuf, fmt);                                                                                       \
+		m_printf(fmtbuf, ##__VA_ARGS__);                                                                               \
 	}))
 #endif
 
+#if DEBUG_PRINT_FILENAME_AND_LINE
+#define debug_e(fmt, ...) DEBUG_LOG_("[" MACROQUOTE(CUST_FILE_BASE) ":%d] " fmt "\r\n", __LINE__, ##__VA_ARGS__)
+#else
+#define debug_e(fmt, ...) DEBUG_LOG_("%u " fmt "\r\n", system_get_time(), ##__VA_ARGS__)
+#endif
+
 /*
  * Print a block of data but only at or above given debug level
  */
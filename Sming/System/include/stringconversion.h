@@ -13,6 +13,8 @@
 
 #pragma once
 
+#include <stddef.h>
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -88,6 +90,36 @@ static inline char *dtostrf(double floatVar, int minStringWidthIncDecimalPoint,
 	return dtostrf_p(floatVar, minStringWidthIncDecimalPoint, numDigitsAfterDecimal, outputBuffer, ' ');
 }
 
+/**
+ * @brief Buffer size sufficient for output of dtoa_shortest() and ftoa_shortest()
+ */
+#define DTOA_SHORTEST_BUFSIZE 32
+
+/**
+ * @brief Write the shortest decimal representation which converts back to the same value
+ * @param value
+ * @param buffer At least DTOA_SHORTEST_BUFSIZE characters
+ * @retval size_t Number of characters written, excluding NUL terminator
+ * @note Exponential notation is used for very large or small values, e.g. "1.5e+30".
+ * Output is compatible with JSON, except for "nan", "inf" and "-inf".
+ */
+size_t dtoa_shortest(double value, char* buffer);
+
+/**
+ * @brief As dtoa_shortest() but uses single precision, so for example 0.1f produces "0.1"
+ */
+size_t ftoa_shortest(float value, char* buffer);
+
+/**
+ * @brief Write value with a fixed number of digits after the decimal point
+ * @param value Non-finite values are written as for dtoa_shortest()
+ * @param buffer Must have space for all integer digits, sign, decimal point, fraction digits and NUL
+ * @param decimalPlaces
+ * @retval size_t Number of characters written, excluding NUL terminator
+ * @note Rounds half away from zero, based on the shortest representation of value
+ */
+size_t dtoa_fixed(double value, char* buffer, unsigned decimalPlaces);
+
 long atol(const char *nptr);
 extern long os_strtol(const char* str, char** endptr, int base);
 extern double os_strtod(const char* str, char** endptr);
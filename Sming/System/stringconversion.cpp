@@ -14,213 +14,170 @@
 #include <cstring>
 #include "stringconversion.h"
 #include "stringutil.h"
+#include <algorithm>
 
-
-char* ltoa_wp(long val, char* buffer, int base, int width, char pad)
+namespace
 {
-	char* buf_ptr = buffer;
-	if(val < 0 && base == 10) {
-		*buf_ptr++ = '-';
-		val = -val;
+// Two digits per division halves the number of (slow) divide operations
+const char digitPairs[201] = "00010203040506070809"
+							 "10111213141516171819"
+							 "20212223242526272829"
+							 "30313233343536373839"
+							 "40414243444546474849"
+							 "50515253545556575859"
+							 "60616263646566676869"
+							 "70717273747576777879"
+							 "80818283848586878889"
+							 "90919293949596979899";
+
+/*
+ * Write decimal digits backwards from end, returning start of output
+ */
+char* writeDecimal(uint32_t val, char* end)
+{
+	char* p = end;
+	while(val >= 100) {
+		unsigned r = val % 100;
+		val /= 100;
+		p -= 2;
+		memcpy(p, &digitPairs[r * 2], 2);
 	}
-	ultoa_wp((unsigned long)val, buf_ptr, base, width, pad);
-	return buffer;
+	if(val >= 10) {
+		p -= 2;
+		memcpy(p, &digitPairs[val * 2], 2);
+	} else {
+		*--p = '0' + val;
+	}
+	return p;
 }
 
-char* ultoa_wp(unsigned long val, char* buffer, unsigned int base, int width, char pad)
+template <typename T> char* writeDigits(T val, char* end, unsigned base)
 {
-	char buf[40];
-	constexpr int nulpos = sizeof(buf) - 1;
-	buf[nulpos] = '\0';
+	char* p = end;
+	if(base == 10) {
+		// Use 64-bit arithmetic only whilst necessary, emitting 9 digits at a time
+		while(val > 0xffffffffU) {
+			uint32_t low = val % 1000000000U;
+			val /= 1000000000U;
+			char* start = writeDecimal(low, p);
+			p -= 9;
+			memset(p, '0', start - p);
+		}
+		return writeDecimal(uint32_t(val), p);
+	}
 
+	if((base & (base - 1)) == 0) {
+		// Power of 2
+		unsigned shift = __builtin_ctz(base);
+		unsigned mask = base - 1;
+		do {
+			*--p = hexchar(unsigned(val) & mask);
+			val >>= shift;
+		} while(val != 0);
+		return p;
+	}
+
+	do {
+		*--p = hexchar(val % base);
+		val /= base;
+	} while(val != 0);
+	return p;
+}
+
+template <typename T> char* toString(T val, char* buffer, unsigned int base, int width, char pad)
+{
 	// prevent crash if called with base == 1
 	if(base < 2 || base > 16) {
 		base = 10;
 	}
 
-	int i = nulpos - 1;
-	int p = 0;
-	for(; val != 0 && i != 0; --i, p++, val /= base) {
-		buf[i] = hexchar(val % base);
-	}
-	if (p == 0) {
-		buf[i--] = '0'; // case for zero
-	}
+	char buf[sizeof(T) * 8];
+	char* end = &buf[sizeof(buf)];
+	char* start = writeDigits(val, end, base);
+	int len = end - start;
 
-	if(width != 0)
-	{
-		width -= (nulpos - i - 1);
-		if(width > 0)
-		{
-			memset(buffer, pad, width);
-		}
-		else {
-			width = 0;
-		}
+	char* p = buffer;
+	if(width > len) {
+		memset(p, pad, width - len);
+		p += width - len;
 	}
-	memcpy(buffer + width, &buf[i+1], nulpos - i);
+	memcpy(p, start, len);
+	p[len] = '\0';
 
 	return buffer;
 }
 
-char* lltoa_wp(long long val, char* buffer, int base, int width, char pad)
+} // namespace
+
+char* ltoa_wp(long val, char* buffer, int base, int width, char pad)
 {
 	char* buf_ptr = buffer;
 	if(val < 0 && base == 10) {
 		*buf_ptr++ = '-';
-		val = -val;
+		ultoa_wp(0UL - (unsigned long)val, buf_ptr, base, width, pad);
+	} else {
+		ultoa_wp((unsigned long)val, buf_ptr, base, width, pad);
 	}
-	ulltoa_wp((unsigned long long)val, buf_ptr, base, width, pad);
 	return buffer;
 }
 
-char* ulltoa_wp(unsigned long long val, char* buffer, unsigned int base, int width, char pad)
+char* ultoa_wp(unsigned long val, char* buffer, unsigned int base, int width, char pad)
 {
-	char buf[80];
-	constexpr int nulpos = sizeof(buf) - 1;
-	buf[nulpos] = '\0';
-
-	// prevent crash if called with base == 1
-	if(base < 2) {
-		base = 10;
-	}
-
-	int i = nulpos - 1;
-	int p = 0;
-	for(; val != 0 && i != 0; --i, p++, val /= base) {
-		buf[i] = hexchar(val % base);
-	}
-	if (p == 0) {
-		buf[i--] = '0'; // case for zero
-	}
+	return toString(val, buffer, base, width, pad);
+}
 
-	if(width != 0)
-	{
-		width -= (nulpos - i - 1);
-		if(width > 0)
-		{
-			memset(buffer, pad, width);
-		}
-		else {
-			width = 0;
-		}
+char* lltoa_wp(long long val, char* buffer, int base, int width, char pad)
+{
+	char* buf_ptr = buffer;
+	if(val < 0 && base == 10) {
+		*buf_ptr++ = '-';
+		ulltoa_wp(0ULL - (unsigned long long)val, buf_ptr, base, width, pad);
+	} else {
+		ulltoa_wp((unsigned long long)val, buf_ptr, base, width, pad);
 	}
-	memcpy(buffer + width, &buf[i+1], nulpos - i);
-
 	return buffer;
 }
 
-// Author zitron: http://forum.arduino.cc/index.php?topic=37391#msg276209
-// modified by ADiea: remove dependencies strcat, floor, round; reorganize+speedup code
-char *dtostrf_p(double floatVar, int minStringWidthIncDecimalPoint, int numDigitsAfterDecimal, char *outputBuffer, char pad)
+char* ulltoa_wp(unsigned long long val, char* buffer, unsigned int base, int width, char pad)
 {
-	char temp[40], num[40];
-	unsigned long mult = 1, int_part;
-	int16_t i, processedFracLen = numDigitsAfterDecimal;
-
-	if(processedFracLen < 0)
-		processedFracLen = 9;
+	return toString(val, buffer, base, width, pad);
+}
 
-	if (outputBuffer == nullptr)
+char* dtostrf_p(double floatVar, int minStringWidthIncDecimalPoint, int numDigitsAfterDecimal, char* outputBuffer,
+			   char pad)
+{
+	if(outputBuffer == nullptr) {
 		return nullptr;
+	}
 
-	if (isnan(floatVar))
-		strcpy(outputBuffer, "NaN");
-	else if (isinf(floatVar))
-		strcpy(outputBuffer, "Inf");
-	else if (floatVar > 4294967040.0)  // constant determined empirically
-		strcpy(outputBuffer, "OVF");
-	else if (floatVar < -4294967040.0)   // constant determined empirically
-		strcpy(outputBuffer, "ovf");
-	else
-	{
-		//start building the number
-		//buf will be the end pointer
-		char* buf = num;
-
-		if (floatVar < 0.0)
-		{
-			*buf++ = '-';  //print "-" sign
-			floatVar = -floatVar;
-		}
-
-		// Extract the integer part of the number and print it
-
-		if (processedFracLen > 9)
-			processedFracLen = 9; // Prevent overflow!
-
-		i = processedFracLen;
-
-		while (i-- > 0)
-			mult *= 10;
-
-		//round the number
-		floatVar += 0.5 / (float) mult;
-
-		int_part = (unsigned long) floatVar;
-
-		//print the int part into num
-		char* s = ltoa(int_part, buf, 10);
-
-		//adjust end pointer
-		buf += strlen(s); //go to end of string
-
-		//deal with digits after the decimal
-		if (numDigitsAfterDecimal != 0)
-		{
-			*buf++ = '.'; // print the decimal point
-
-			//print the fraction part into temp
-			s = ltoa( ((floatVar - int_part) * mult), temp, 10);
-
-			i = processedFracLen - strlen(s) + 1;
-
-			//print the first zeros of the fraction part
-			while (--i > 0)
-				*buf++ = '0';
-
-			//print the fraction part
-			while (*s)
-				*buf++ = *s++;
-
-			//trim back on the last fraction zeroes
-			while(*(buf - 1) == '0')
-			{
-				--buf;
-				--processedFracLen;
-			}
-
-			if(numDigitsAfterDecimal > 0)
-			{
-				i = numDigitsAfterDecimal - processedFracLen;
-
-				// padding fraction zeroes
-				while (i-- > 0)
-					*buf++ = '0';
-			}
-		}
-
-		//terminate num
-		*buf = 0;
-
-		//switch buf to outputBuffer
-		buf = outputBuffer;
-
-		// generate width space padding
-		i = minStringWidthIncDecimalPoint - strlen(num) + 1;
-		while (--i > 0)
-		{
-			*buf++ = pad;
+	char num[40];
+	if(isnan(floatVar)) {
+		strcpy(num, "NaN");
+	} else if(isinf(floatVar)) {
+		strcpy(num, "Inf");
+	} else if(floatVar > 4294967040.0) { // constant determined empirically
+		strcpy(num, "OVF");
+	} else if(floatVar < -4294967040.0) { // constant determined empirically
+		strcpy(num, "ovf");
+	} else if(numDigitsAfterDecimal < 0) {
+		// Up to 9 decimal places, omitting trailing zeroes
+		auto len = dtoa_fixed(floatVar, num, 9);
+		while(num[len - 1] == '0' && num[len - 2] != '.') {
+			--len;
 		}
+		num[len] = '\0';
+	} else {
+		// Limit so output fits buffers of existing callers
+		dtoa_fixed(floatVar, num, std::min(numDigitsAfterDecimal, 18));
+	}
 
-		//Write output buffer
-		s = num;
-		while (*s)
-			*buf++ = *s++;
-
-		//termninate outputBuffer
-		*buf = 0;
+	// generate width space padding
+	char* buf = outputBuffer;
+	int padding = minStringWidthIncDecimalPoint - int(strlen(num));
+	while(padding-- > 0) {
+		*buf++ = pad;
 	}
+	strcpy(buf, num);
 
 	return outputBuffer;
 }
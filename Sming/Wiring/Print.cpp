@@ -99,8 +99,6 @@ size_t Print::printNumber(const unsigned long long& num, uint8_t base)
 
 size_t Print::printFloat(double number, uint8_t digits)
 {
-	size_t n = 0;
-
 	if(std::isnan(number)) {
 		return print("nan");
 	}
@@ -114,37 +112,8 @@ size_t Print::printFloat(double number, uint8_t digits)
 		return print("ovf"); // constant determined empirically
 	}
 
-	// Handle negative numbers
-	if(number < 0.0) {
-		n += print('-');
-		number = -number;
-	}
-
-	// Round correctly so that print(1.999, 2) prints as "2.00"
-	double rounding = 0.5;
-	for(uint8_t i = 0; i < digits; ++i) {
-		rounding /= 10.0;
-	}
-
-	number += rounding;
-
-	// Extract the integer part of the number and print it
-	unsigned long int_part = number;
-	auto remainder = number - int_part;
-	n += print(int_part);
-
-	// Print the decimal point, but only if there are digits beyond
-	if(digits > 0) {
-		n += print('.');
-	}
-
-	// Extract digits from the remainder one at a time
-	while(digits-- > 0) {
-		remainder *= 10.0;
-		int toPrint = remainder;
-		n += print(toPrint);
-		remainder -= toPrint;
-	}
-
-	return n;
+	// Limit so buffer is sufficient: fraction digits beyond precision of a double are zero anyway
+	char buf[64];
+	size_t len = dtoa_fixed(number, buf, std::min(digits, uint8_t(50)));
+	return write(buf, len);
 }
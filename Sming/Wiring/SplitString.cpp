@@ -39,7 +39,9 @@ unsigned splitString(String& what, char delim, Vector<int>& splits)
 	return splits.count();
 }
 
-unsigned splitString(String& what, char delim, Vector<String>& splits)
+namespace
+{
+template <class Container> unsigned split(String& what, char delim, Container& splits)
 {
 	what.trim();
 	splits.removeAllElements();
@@ -56,3 +58,15 @@ unsigned splitString(String& what, char delim, Vector<String>& splits)
 
 	return splits.count();
 }
+
+} // namespace
+
+unsigned splitString(String& what, char delim, Vector<String>& splits)
+{
+	return split(what, delim, splits);
+}
+
+unsigned splitString(String& what, char delim, ContiguousVector<String>& splits)
+{
+	return split(what, delim, splits);
+}
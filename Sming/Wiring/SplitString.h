@@ -12,6 +12,7 @@
 #pragma once
 
 #include "WVector.h"
+#include "ValueVector.h"
 #include "WString.h"
 
 /** @brief split a delimited string list of integers into an array
@@ -33,3 +34,12 @@ unsigned splitString(String& what, char delim, Vector<int>& splits);
  *  example: "   a,b,c,d,e" returns ["a", "b", "c", "d", "e"]
  */
 unsigned splitString(String& what, char delim, Vector<String>& splits);
+
+/** @brief split a delimited string list into a contiguous vector
+ *  @param what
+ *  @param delim
+ *  @param splits A ValueVector or StaticVector
+ *  @retval unsigned number of items returned in splits (same as splits.count())
+ *  @note If splits has a fixed capacity then any further items are discarded
+ */
+unsigned splitString(String& what, char delim, ContiguousVector<String>& splits);
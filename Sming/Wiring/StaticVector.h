@@ -0,0 +1,62 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/SmingHub/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * StaticVector.h
+ *
+ ****/
+
+#pragma once
+
+#include "ValueVector.h"
+
+/**
+ * @brief Vector with fixed capacity and inline storage, which never allocates
+ * @tparam Element
+ * @tparam N Maximum number of elements
+ *
+ * Adding elements fails once the vector is full.
+ *
+ * @ingroup wiring
+ */
+template <typename Element, unsigned int N> class StaticVector final : public ContiguousVector<Element>
+{
+public:
+	using Base = ContiguousVector<Element>;
+
+	StaticVector() : Base(reinterpret_cast<Element*>(storage), N)
+	{
+	}
+
+	StaticVector(const StaticVector& other) : StaticVector()
+	{
+		Base::operator=(other);
+	}
+
+	~StaticVector()
+	{
+		this->clear();
+	}
+
+	StaticVector& operator=(const StaticVector& other)
+	{
+		Base::operator=(other);
+		return *this;
+	}
+
+	bool isFull() const
+	{
+		return this->_size == N;
+	}
+
+protected:
+	bool reallocate(unsigned int) override
+	{
+		return false;
+	}
+
+private:
+	alignas(Element) unsigned char storage[N * sizeof(Element)];
+};
@@ -0,0 +1,441 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/SmingHub/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * ValueVector.h
+ *
+ * Vector implementations which store elements contiguously, by value.
+ *
+ * `Vector` allocates every element separately and stores pointers to them.
+ * These classes provide the same interface but keep elements in a single array,
+ * which is better for cache locality and involves far fewer heap allocations.
+ * Elements may be move-only types.
+ *
+ * Note that adding or removing elements moves existing ones, so references and
+ * iterators are invalidated by any operation which changes the vector size.
+ *
+ ****/
+
+#pragma once
+
+#include "Countable.h"
+#include <cstdlib>
+#include <new>
+#include <utility>
+#include <algorithm>
+
+/**
+ * @brief Base class for contiguous vectors; storage is provided by the derived class
+ * @ingroup wiring
+ */
+template <typename Element> class ContiguousVector : public Countable<Element>
+{
+public:
+	using Comparer = int (*)(const Element& lhs, const Element& rhs);
+	using iterator = Element*;
+	using const_iterator = const Element*;
+
+	ContiguousVector(const ContiguousVector&) = delete;
+
+	ContiguousVector& operator=(const ContiguousVector& rhs)
+	{
+		if(this != &rhs) {
+			clear();
+			if(reserve(rhs._size)) {
+				for(auto& e : rhs) {
+					new(&_data[_size++]) Element(e);
+				}
+			}
+		}
+		return *this;
+	}
+
+	unsigned int count() const override
+	{
+		return _size;
+	}
+
+	unsigned int size() const
+	{
+		return _size;
+	}
+
+	unsigned int capacity() const
+	{
+		return _capacity;
+	}
+
+	bool isEmpty() const
+	{
+		return _size == 0;
+	}
+
+	/**
+	 * @brief Ensure space is available for at least the given number of elements
+	 * @retval bool false on allocation failure, or if the requested capacity exceeds a fixed limit
+	 */
+	bool reserve(unsigned int minCapacity)
+	{
+		return minCapacity <= _capacity || reallocate(minCapacity);
+	}
+
+	bool ensureCapacity(unsigned int minCapacity)
+	{
+		return reserve(minCapacity);
+	}
+
+	Element* data()
+	{
+		return _data;
+	}
+
+	const Element* data() const
+	{
+		return _data;
+	}
+
+	iterator begin()
+	{
+		return _data;
+	}
+
+	iterator end()
+	{
+		return _data + _size;
+	}
+
+	const_iterator begin() const
+	{
+		return _data;
+	}
+
+	const_iterator end() const
+	{
+		return _data + _size;
+	}
+
+	const Element& operator[](unsigned int index) const override
+	{
+		return elementAt(index);
+	}
+
+	Element& operator[](unsigned int index) override
+	{
+		if(index >= _size) {
+			abort();
+		}
+		return _data[index];
+	}
+
+	const Element& elementAt(unsigned int index) const
+	{
+		if(index >= _size) {
+			abort();
+		}
+		return _data[index];
+	}
+
+	const Element& get(unsigned int index) const
+	{
+		return elementAt(index);
+	}
+
+	const Element& firstElement() const
+	{
+		return elementAt(0);
+	}
+
+	const Element& lastElement() const
+	{
+		return elementAt(_size - 1);
+	}
+
+	int indexOf(const Element& elem) const
+	{
+		for(unsigned int i = 0; i < _size; ++i) {
+			if(_data[i] == elem) {
+				return i;
+			}
+		}
+		return -1;
+	}
+
+	int lastIndexOf(const Element& elem) const
+	{
+		for(unsigned int i = _size; i != 0; --i) {
+			if(_data[i - 1] == elem) {
+				return i - 1;
+			}
+		}
+		return -1;
+	}
+
+	bool contains(const Element& elem) const
+	{
+		return indexOf(elem) >= 0;
+	}
+
+	/**
+	 * @brief Construct a new element in-place at the end of the vector
+	 * @retval Element* The new element, nullptr on failure
+	 */
+	template <typename... Args> Element* emplace(Args&&... args)
+	{
+		if(!grow(_size + 1)) {
+			return nullptr;
+		}
+		auto elem = new(&_data[_size]) Element(std::forward<Args>(args)...);
+		++_size;
+		return elem;
+	}
+
+	bool add(const Element& obj)
+	{
+		if(_size == _capacity) {
+			// obj may refer to an existing element, so copy before storage moves
+			Element tmp(obj);
+			return emplace(std::move(tmp)) != nullptr;
+		}
+		return emplace(obj) != nullptr;
+	}
+
+	bool add(Element&& obj)
+	{
+		return emplace(std::move(obj)) != nullptr;
+	}
+
+	bool addElement(const Element& obj)
+	{
+		return add(obj);
+	}
+
+	bool addElement(Element&& obj)
+	{
+		return add(std::move(obj));
+	}
+
+	bool insertElementAt(const Element& obj, unsigned int index)
+	{
+		return insertElementAt(Element(obj), index);
+	}
+
+	bool insertElementAt(Element&& obj, unsigned int index)
+	{
+		if(index > _size || !add(std::move(obj))) {
+			return false;
+		}
+		std::rotate(begin() + index, end() - 1, end());
+		return true;
+	}
+
+	bool setElementAt(const Element& obj, unsigned int index)
+	{
+		if(index >= _size) {
+			return false;
+		}
+		_data[index] = obj;
+		return true;
+	}
+
+	void removeElementAt(unsigned int index)
+	{
+		if(index >= _size) {
+			return;
+		}
+		std::move(begin() + index + 1, end(), begin() + index);
+		--_size;
+		_data[_size].~Element();
+	}
+
+	void remove(unsigned int index)
+	{
+		removeElementAt(index);
+	}
+
+	bool removeElement(const Element& obj)
+	{
+		int i = indexOf(obj);
+		if(i < 0) {
+			return false;
+		}
+		removeElementAt(i);
+		return true;
+	}
+
+	void removeAllElements()
+	{
+		while(_size != 0) {
+			--_size;
+			_data[_size].~Element();
+		}
+	}
+
+	void clear()
+	{
+		removeAllElements();
+	}
+
+	/**
+	 * @brief Change the number of elements
+	 * @note New elements are default-constructed
+	 */
+	bool setSize(unsigned int newSize)
+	{
+		if(!reserve(newSize)) {
+			return false;
+		}
+		while(_size > newSize) {
+			--_size;
+			_data[_size].~Element();
+		}
+		while(_size < newSize) {
+			new(&_data[_size++]) Element();
+		}
+		return true;
+	}
+
+	void copyInto(Element* array) const
+	{
+		if(array != nullptr) {
+			std::copy(begin(), end(), array);
+		}
+	}
+
+	/**
+	 * @brief Sort elements using insertion sort, which like `Vector::sort` is stable
+	 */
+	void sort(Comparer compareFunction)
+	{
+		for(unsigned j = 1; j < _size; ++j) {
+			Element key = std::move(_data[j]);
+			unsigned i = j;
+			for(; i > 0 && compareFunction(_data[i - 1], key) > 0; --i) {
+				_data[i] = std::move(_data[i - 1]);
+			}
+			_data[i] = std::move(key);
+		}
+	}
+
+protected:
+	ContiguousVector(Element* data, unsigned int capacity) : _data(data), _capacity(capacity)
+	{
+	}
+
+	/**
+	 * @brief Provide storage for at least the requested number of elements
+	 * @note Implementations call `moveTo()` to relocate existing elements
+	 */
+	virtual bool reallocate(unsigned int newCapacity) = 0;
+
+	/**
+	 * @brief Relocate all elements to new storage
+	 */
+	void moveTo(Element* newData, unsigned int newCapacity)
+	{
+		for(unsigned int i = 0; i < _size; ++i) {
+			new(&newData[i]) Element(std::move(_data[i]));
+			_data[i].~Element();
+		}
+		_data = newData;
+		_capacity = newCapacity;
+	}
+
+	/**
+	 * @brief Make room for additional elements, growing capacity geometrically
+	 */
+	bool grow(unsigned int minCapacity)
+	{
+		if(minCapacity <= _capacity) {
+			return true;
+		}
+		auto newCapacity = std::max(minCapacity, _capacity + std::max(_capacity / 2, 4U));
+		return reallocate(newCapacity) || reallocate(minCapacity);
+	}
+
+protected:
+	Element* _data;
+	unsigned int _size{0};
+	unsigned int _capacity;
+};
+
+/**
+ * @brief Vector storing elements contiguously in a single heap allocation
+ * @ingroup wiring
+ */
+template <typename Element> class ValueVector final : public ContiguousVector<Element>
+{
+public:
+	using Base = ContiguousVector<Element>;
+
+	explicit ValueVector(unsigned int initialCapacity = 0) : Base(nullptr, 0)
+	{
+		this->reserve(initialCapacity);
+	}
+
+	ValueVector(const ValueVector& other) : ValueVector()
+	{
+		Base::operator=(other);
+	}
+
+	ValueVector(ValueVector&& other) noexcept : ValueVector()
+	{
+		swap(other);
+	}
+
+	~ValueVector()
+	{
+		this->clear();
+		free(this->_data);
+	}
+
+	ValueVector& operator=(const ValueVector& other)
+	{
+		Base::operator=(other);
+		return *this;
+	}
+
+	ValueVector& operator=(ValueVector&& other) noexcept
+	{
+		if(this != &other) {
+			this->clear();
+			swap(other);
+		}
+		return *this;
+	}
+
+	void swap(ValueVector& other)
+	{
+		std::swap(this->_data, other._data);
+		std::swap(this->_size, other._size);
+		std::swap(this->_capacity, other._capacity);
+	}
+
+	/**
+	 * @brief Release any unused capacity
+	 */
+	void trimToSize()
+	{
+		if(this->_size == 0) {
+			free(this->_data);
+			this->_data = nullptr;
+			this->_capacity = 0;
+		} else if(this->_size != this->_capacity) {
+			reallocate(this->_size);
+		}
+	}
+
+protected:
+	bool reallocate(unsigned int newCapacity) override
+	{
+		auto newData = static_cast<Element*>(malloc(newCapacity * sizeof(Element)));
+		if(newData == nullptr) {
+			return false;
+		}
+		auto oldData = this->_data;
+		this->moveTo(newData, newCapacity);
+		free(oldData);
+		return true;
+	}
+};
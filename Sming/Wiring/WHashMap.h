@@ -24,6 +24,10 @@
  * used when adding a new unspecified entry, or if a key value is not present. This should not be necessary
  * for object values as the default constructor will be used.
  *
+ * Key lookup is performed by a policy class. The default performs a linear search, which is compact and
+ * adequate for small maps. Larger maps can use `HashMapHashedLookup` which maintains an open-addressing
+ * index for O(1) lookups. Iteration order (insertion order) is the same for both.
+ *
  */
 
 #pragma once
@@ -31,12 +35,188 @@
 #include <cstdint>
 #include <iterator>
 #include <cstdlib>
+#include <functional>
+#include <type_traits>
+#include <utility>
+
+/**
+ * @brief Default hash function used by `HashMapHashedLookup`
+ * @note Specialisations are provided for integral and enum types, and for string-like types
+ * with `c_str()` and `length()` methods such as `String`.
+ * @ingroup wiring
+ */
+template <typename K, typename Enable = void> struct HashMapHash {
+	uint32_t operator()(const K& key) const
+	{
+		return std::hash<K>()(key);
+	}
+};
+
+template <typename K>
+struct HashMapHash<K, typename std::enable_if<std::is_integral<K>::value || std::is_enum<K>::value>::type> {
+	uint32_t operator()(const K& key) const
+	{
+		// Fibonacci hashing spreads sequential values
+		return uint32_t(key) * 2654435761U;
+	}
+};
+
+template <typename K>
+struct HashMapHash<K, decltype(void(std::declval<const K&>().c_str()), void(std::declval<const K&>().length()))> {
+	uint32_t operator()(const K& key) const
+	{
+		// FNV-1a
+		uint32_t hash = 2166136261U;
+		auto s = key.c_str();
+		for(unsigned i = 0, len = key.length(); i < len; ++i) {
+			hash = (hash ^ uint8_t(s[i])) * 16777619U;
+		}
+		return hash;
+	}
+};
+
+/**
+ * @brief HashMap lookup policy which performs a linear search through the keys
+ * @ingroup wiring
+ */
+template <typename K> class HashMapLinearLookup
+{
+public:
+	template <class Compare> int find(const K& key, K* const* keys, unsigned count, Compare isEqual) const
+	{
+		for(unsigned i = 0; i < count; i++) {
+			if(isEqual(key, *keys[i])) {
+				return i;
+			}
+		}
+		return -1;
+	}
+
+	void add(K* const* keys, unsigned index)
+	{
+	}
+
+	void rebuild(K* const* keys, unsigned count)
+	{
+	}
+
+	void clear()
+	{
+	}
+
+	void swap(HashMapLinearLookup& other)
+	{
+	}
+};
+
+/**
+ * @brief HashMap lookup policy which maintains a hashed index
+ * @tparam Hash Hash function, must be consistent with key comparison
+ * @note Uses open addressing with linear probing, with load factor kept at or below 50%.
+ * This requires 4 to 8 bytes of index per entry.
+ * Keys must not be modified via `HashMap::keyAt()`.
+ * @ingroup wiring
+ */
+template <typename K, class Hash = HashMapHash<K>> class HashMapHashedLookup
+{
+public:
+	HashMapHashedLookup() = default;
+	HashMapHashedLookup(const HashMapHashedLookup&) = delete;
+
+	~HashMapHashedLookup()
+	{
+		clear();
+	}
+
+	template <class Compare> int find(const K& key, K* const* keys, unsigned count, Compare isEqual) const
+	{
+		if(table == nullptr) {
+			// Index allocation failed, fall back to linear search
+			return HashMapLinearLookup<K>().find(key, keys, count, isEqual);
+		}
+		for(unsigned i = Hash()(key) & mask;; i = (i + 1) & mask) {
+			auto index = table[i];
+			if(index == emptySlot) {
+				return -1;
+			}
+			if(isEqual(key, *keys[index])) {
+				return index;
+			}
+		}
+	}
+
+	void add(K* const* keys, unsigned index)
+	{
+		if(table == nullptr || 2 * (index + 1) > capacity()) {
+			rebuild(keys, index + 1);
+		} else {
+			insert(*keys[index], index);
+		}
+	}
+
+	void rebuild(K* const* keys, unsigned count)
+	{
+		unsigned newCapacity = minCapacity;
+		while(newCapacity < 2 * count) {
+			newCapacity <<= 1;
+		}
+		if(newCapacity != capacity()) {
+			clear();
+			table = new uint16_t[newCapacity];
+			if(table == nullptr) {
+				return;
+			}
+			mask = newCapacity - 1;
+		}
+		for(unsigned i = 0; i <= mask; ++i) {
+			table[i] = emptySlot;
+		}
+		for(unsigned i = 0; i < count; ++i) {
+			insert(*keys[i], i);
+		}
+	}
+
+	void clear()
+	{
+		delete[] table;
+		table = nullptr;
+		mask = 0;
+	}
+
+	void swap(HashMapHashedLookup& other)
+	{
+		std::swap(table, other.table);
+		std::swap(mask, other.mask);
+	}
+
+private:
+	static constexpr uint16_t emptySlot{0xffff};
+	static constexpr unsigned minCapacity{8};
+
+	unsigned capacity() const
+	{
+		return table ? mask + 1 : 0;
+	}
+
+	void insert(const K& key, unsigned index)
+	{
+		unsigned i = Hash()(key) & mask;
+		while(table[i] != emptySlot) {
+			i = (i + 1) & mask;
+		}
+		table[i] = index;
+	}
+
+	uint16_t* table{nullptr};
+	uint16_t mask{0};
+};
 
 /**
  * @brief HashMap class template
+ * @tparam Lookup Policy class for locating keys
  * @ingroup wiring
  */
-template <typename K, typename V> class HashMap
+template <typename K, typename V, class Lookup = HashMapLinearLookup<K>> class HashMap
 {
 public:
 	using Comparator = bool (*)(const K&, const K&);
@@ -332,7 +512,37 @@ public:
 
 	void clear();
 
-	void setMultiple(const HashMap<K, V>& map);
+	/**
+	 * @brief Remove all entries, keeping allocated storage for re-use
+	 * @param maxRetained If storage exists for more entries than this, it is all released
+	 *
+	 * Entries are otherwise allocated one at a time as the map grows, so resetting
+	 * a map which is repeatedly re-populated avoids most heap activity.
+	 */
+	void reset(unsigned maxRetained);
+
+	/**
+	 * @brief Exchange entries and storage with another map
+	 * @note Null value and comparator are not exchanged
+	 */
+	void swap(HashMap& other)
+	{
+		std::swap(keys, other.keys);
+		std::swap(values, other.values);
+		std::swap(currentIndex, other.currentIndex);
+		std::swap(size, other.size);
+		lookup.swap(other.lookup);
+	}
+
+	/**
+	 * @brief Get number of entries for which storage is allocated
+	 */
+	unsigned capacity() const
+	{
+		return size;
+	}
+
+	void setMultiple(const HashMap& map);
 
 	void setNullValue(const V& nullv)
 	{
@@ -360,18 +570,24 @@ public:
 	}
 
 protected:
+	bool keyEquals(const K& key1, const K& key2) const
+	{
+		return cb_comparator ? cb_comparator(key1, key2) : (key1 == key2);
+	}
+
 	K** keys = nullptr;
 	V** values = nullptr;
 	V nil;
 	uint16_t currentIndex = 0;
 	uint16_t size = 0;
 	Comparator cb_comparator = nullptr;
+	Lookup lookup;
 
 private:
-	HashMap(const HashMap<K, V>& that);
+	HashMap(const HashMap& that);
 };
 
-template <typename K, typename V> V& HashMap<K, V>::operator[](const K& key)
+template <typename K, typename V, class Lookup> V& HashMap<K, V, Lookup>::operator[](const K& key)
 {
 	int i = indexOf(key);
 	if(i >= 0) {
@@ -382,11 +598,12 @@ template <typename K, typename V> V& HashMap<K, V>::operator[](const K& key)
 	}
 	*keys[currentIndex] = key;
 	*values[currentIndex] = nil;
+	lookup.add(keys, currentIndex);
 	currentIndex++;
 	return *values[currentIndex - 1];
 }
 
-template <typename K, typename V> void HashMap<K, V>::allocate(unsigned int newSize)
+template <typename K, typename V, class Lookup> void HashMap<K, V, Lookup>::allocate(unsigned int newSize)
 {
 	if(newSize <= size)
 		return;
@@ -413,23 +630,13 @@ template <typename K, typename V> void HashMap<K, V>::allocate(unsigned int newS
 	size = newSize;
 }
 
-template <typename K, typename V> int HashMap<K, V>::indexOf(const K& key) const
+template <typename K, typename V, class Lookup> int HashMap<K, V, Lookup>::indexOf(const K& key) const
 {
-	for(unsigned i = 0; i < currentIndex; i++) {
-		if(cb_comparator) {
-			if(cb_comparator(key, *keys[i])) {
-				return i;
-			}
-		} else {
-			if(key == *keys[i]) {
-				return i;
-			}
-		}
-	}
-	return -1;
+	return lookup.find(key, keys, currentIndex,
+					   [this](const K& key1, const K& key2) { return keyEquals(key1, key2); });
 }
 
-template <typename K, typename V> void HashMap<K, V>::removeAt(unsigned index)
+template <typename K, typename V, class Lookup> void HashMap<K, V, Lookup>::removeAt(unsigned index)
 {
 	if(index >= currentIndex)
 		return;
@@ -440,10 +647,12 @@ template <typename K, typename V> void HashMap<K, V>::removeAt(unsigned index)
 	}
 
 	currentIndex--;
+	lookup.rebuild(keys, currentIndex);
 }
 
-template <typename K, typename V> void HashMap<K, V>::clear()
+template <typename K, typename V, class Lookup> void HashMap<K, V, Lookup>::clear()
 {
+	lookup.clear();
 	if(keys != nullptr) {
 		for(unsigned i = 0; i < size; i++) {
 			delete keys[i];
@@ -458,7 +667,21 @@ template <typename K, typename V> void HashMap<K, V>::clear()
 	size = 0;
 }
 
-template <typename K, typename V> void HashMap<K, V>::setMultiple(const HashMap<K, V>& map)
+template <typename K, typename V, class Lookup> void HashMap<K, V, Lookup>::reset(unsigned maxRetained)
+{
+	if(size > maxRetained) {
+		clear();
+		return;
+	}
+	// Release any value content, such as String buffers
+	for(unsigned i = 0; i < currentIndex; i++) {
+		*values[i] = nil;
+	}
+	currentIndex = 0;
+	lookup.rebuild(keys, 0);
+}
+
+template <typename K, typename V, class Lookup> void HashMap<K, V, Lookup>::setMultiple(const HashMap& map)
 {
 	for(unsigned i = 0; i < map.count(); i++) {
 		(*this)[map.keyAt(i)] = *(map.values)[i];
@@ -224,6 +224,13 @@ SMING_CXX_STD		?= c++17
 endif
 CXXFLAGS			+= -std=$(SMING_CXX_STD)
 
+# GCC 10 requires coroutine support to be enabled explicitly
+ifneq (,$(filter c++20 gnu++20 c++2a gnu++2a,$(SMING_CXX_STD)))
+ifeq ($(firstword $(subst ., ,$(GCC_VERSION))),10)
+CXXFLAGS			+= -fcoroutines
+endif
+endif
+
 GCC_MIN_MAJOR_VERSION := 8
 GCC_VERSION_COMPATIBLE := $(shell expr $$(echo $(GCC_VERSION) | cut -f1 -d.) \>= $(GCC_MIN_MAJOR_VERSION))
 
@@ -3,7 +3,8 @@ COMPONENT_SRCDIRS := \
 	Platform \
 	System \
 	Wiring \
-	Services/HexDump
+	Services/HexDump \
+	Services/Profiling
 
 COMPONENT_INCDIRS := \
 	Components \
@@ -18,7 +19,8 @@ COMPONENT_DEPENDS := \
 	Spiffs \
 	IFS \
 	SPI \
-	terminal
+	terminal \
+	ObjectPool
 
 COMPONENT_DOXYGEN_PREDEFINED := \
 	ENABLE_CMD_EXECUTOR=1
@@ -83,6 +85,14 @@ CONFIG_VARS				+= DEBUG_VERBOSE_LEVEL
 DEBUG_VERBOSE_LEVEL		?= 2
 GLOBAL_CFLAGS			+= -DDEBUG_VERBOSE_LEVEL=$(DEBUG_VERBOSE_LEVEL)
 
+# Store debug messages in a RAM buffer and format them later from a low-priority task
+CONFIG_VARS				+= DEBUG_DEFERRED DEBUG_DEFERRED_BUFFER_SIZE
+DEBUG_DEFERRED			?= 0
+DEBUG_DEFERRED_BUFFER_SIZE	?= 2048
+GLOBAL_CFLAGS			+= \
+	-DDEBUG_DEFERRED=$(DEBUG_DEFERRED) \
+	-DDEBUG_DEFERRED_BUFFER_SIZE=$(DEBUG_DEFERRED_BUFFER_SIZE)
+
 CONFIG_VARS			+= ENABLE_GDB
 ifeq ($(ENABLE_GDB), 1)
 	GLOBAL_CFLAGS	+= -ggdb -DENABLE_GDB=1
@@ -105,16 +115,102 @@ ifeq ($(ENABLE_TASK_COUNT),1)
 	GLOBAL_CFLAGS	+= -DENABLE_TASK_COUNT=1
 endif
 
+# Schedule software timers using a timing wheel instead of the OS timer queue
+COMPONENT_VARS		+= ENABLE_TIMER_WHEEL
+ENABLE_TIMER_WHEEL	?= 0
+GLOBAL_CFLAGS		+= -DENABLE_TIMER_WHEEL=$(ENABLE_TIMER_WHEEL)
+
+# Event tracing into RAM ring buffer
+COMPONENT_VARS		+= ENABLE_TRACE TRACE_BUFFER_SIZE
+ENABLE_TRACE		?= 0
+TRACE_BUFFER_SIZE	?= 256
+GLOBAL_CFLAGS		+= \
+	-DENABLE_TRACE=$(ENABLE_TRACE) \
+	-DTRACE_BUFFER_SIZE=$(TRACE_BUFFER_SIZE)
+
+# Record timing of startup phases
+COMPONENT_VARS		+= ENABLE_BOOT_TIMELINE
+ENABLE_BOOT_TIMELINE	?= 0
+GLOBAL_CFLAGS		+= -DENABLE_BOOT_TIMELINE=$(ENABLE_BOOT_TIMELINE)
+
+# Execution time accounting for task queue callbacks
+COMPONENT_VARS		+= ENABLE_TASK_TIMING TASK_TIMING_SLOTS TASK_TIMING_WARN_US TASK_TIMING_WARN_COUNT
+ENABLE_TASK_TIMING	?= 0
+TASK_TIMING_SLOTS	?= 16
+TASK_TIMING_WARN_US	?= 50000
+TASK_TIMING_WARN_COUNT	?= 3
+GLOBAL_CFLAGS		+= \
+	-DENABLE_TASK_TIMING=$(ENABLE_TASK_TIMING) \
+	-DTASK_TIMING_SLOTS=$(TASK_TIMING_SLOTS) \
+	-DTASK_TIMING_WARN_US=$(TASK_TIMING_WARN_US) \
+	-DTASK_TIMING_WARN_COUNT=$(TASK_TIMING_WARN_COUNT)
+
+# Stack high-water-mark monitoring
+COMPONENT_VARS		+= ENABLE_STACK_USAGE
+ENABLE_STACK_USAGE	?= 0
+GLOBAL_CFLAGS		+= -DENABLE_STACK_USAGE=$(ENABLE_STACK_USAGE)
+
+# Program counter sampling
+COMPONENT_VARS		+= PC_SAMPLER_SLOTS
+PC_SAMPLER_SLOTS	?= 512
+COMPONENT_CXXFLAGS	+= -DPC_SAMPLER_SLOTS=$(PC_SAMPLER_SLOTS)
+
+# Crash record retained across reset
+COMPONENT_VARS		+= ENABLE_CRASH_LOG CRASH_LOG_RTC_ADDR
+ENABLE_CRASH_LOG	?= 0
+CRASH_LOG_RTC_ADDR	?= 128
+GLOBAL_CFLAGS		+= \
+	-DENABLE_CRASH_LOG=$(ENABLE_CRASH_LOG) \
+	-DCRASH_LOG_RTC_ADDR=$(CRASH_LOG_RTC_ADDR)
+
+# Interrupt latency and handler duration accounting
+COMPONENT_VARS		+= ENABLE_INTERRUPT_TIMING INTERRUPT_TIMING_SITES INTERRUPT_TIMING_HANDLERS
+ENABLE_INTERRUPT_TIMING	?= 0
+INTERRUPT_TIMING_SITES	?= 32
+INTERRUPT_TIMING_HANDLERS	?= 8
+GLOBAL_CFLAGS		+= \
+	-DENABLE_INTERRUPT_TIMING=$(ENABLE_INTERRUPT_TIMING) \
+	-DINTERRUPT_TIMING_SITES=$(INTERRUPT_TIMING_SITES) \
+	-DINTERRUPT_TIMING_HANDLERS=$(INTERRUPT_TIMING_HANDLERS)
+
 # Task queue length
 COMPONENT_VARS		+= TASK_QUEUE_LENGTH
 TASK_QUEUE_LENGTH	?= 10
 COMPONENT_CXXFLAGS	+= -DTASK_QUEUE_LENGTH=$(TASK_QUEUE_LENGTH)
 
+# High and low priority task queue lengths, 0 to disable
+COMPONENT_VARS		+= TASK_QUEUE_LENGTH_HIGH TASK_QUEUE_LENGTH_LOW
+TASK_QUEUE_LENGTH_HIGH	?= 4
+TASK_QUEUE_LENGTH_LOW	?= 4
+COMPONENT_CXXFLAGS	+= \
+	-DTASK_QUEUE_LENGTH_HIGH=$(TASK_QUEUE_LENGTH_HIGH) \
+	-DTASK_QUEUE_LENGTH_LOW=$(TASK_QUEUE_LENGTH_LOW)
+
+# Number of pre-allocated slots for queued Delegate callbacks
+COMPONENT_VARS		+= TASK_DELEGATE_POOL_SIZE
+TASK_DELEGATE_POOL_SIZE	?= 8
+COMPONENT_CXXFLAGS	+= -DTASK_DELEGATE_POOL_SIZE=$(TASK_DELEGATE_POOL_SIZE)
+
 # Size of a String object - change this to increase space for Small String Optimisation (SSO)
 COMPONENT_VARS		+= STRING_OBJECT_SIZE
 STRING_OBJECT_SIZE	?= 12
 GLOBAL_CFLAGS		+= -DSTRING_OBJECT_SIZE=$(STRING_OBJECT_SIZE) 
 
+# Size of FileStream read-ahead buffer, 0 to disable
+COMPONENT_VARS			+= FILESTREAM_BUFFER_SIZE
+FILESTREAM_BUFFER_SIZE	?= 512
+GLOBAL_CFLAGS			+= -DFILESTREAM_BUFFER_SIZE=$(FILESTREAM_BUFFER_SIZE)
+
+# Size at or above which MemoryClass::Bulk allocations may use external RAM
+COMPONENT_VARS				+= MEMORY_BULK_THRESHOLD
+MEMORY_BULK_THRESHOLD		?= 4096
+COMPONENT_CXXFLAGS			+= -DMEMORY_BULK_THRESHOLD=$(MEMORY_BULK_THRESHOLD)
+
+# Number of FileStream buffers to reserve in shared pool
+COMPONENT_VARS				+= FILESTREAM_BUFFER_POOL_SIZE
+FILESTREAM_BUFFER_POOL_SIZE	?= 0
+COMPONENT_CXXFLAGS			+= -DFILESTREAM_BUFFER_POOL_SIZE=$(FILESTREAM_BUFFER_POOL_SIZE)
+
 ##@Flashing
 
 .PHONY: flashinit
@@ -541,6 +541,18 @@ decode-stacktrace: ##Open the stack trace decoder ready to paste dump text. Alte
 	fi
 	$(Q) $(PYTHON) $(ARCH_TOOLS)/decode-stacktrace.py $(TARGET_OUT_0) $(TRACE)
 
+# PC sampler report symboliser
+CACHE_VARS += PC_PROFILE_CAPTURE
+PC_PROFILE_CAPTURE ?=
+.PHONY: pc-profile
+pc-profile: ##Summarise PC sampler report contained in PC_PROFILE_CAPTURE and write flamegraph-compatible output to `PC_PROFILE_CAPTURE.folded`
+	$(Q) if [ -z "$(PC_PROFILE_CAPTURE)" ]; then \
+		echo "Please set PC_PROFILE_CAPTURE"; \
+		exit 1; \
+	fi
+	$(Q) $(PYTHON) $(SMING_HOME)/../Tools/pc-profile.py --nm $(NM)$(TOOL_EXT) $(TARGET_OUT_0) \
+		$(PC_PROFILE_CAPTURE) $(PC_PROFILE_CAPTURE).folded
+
 
 CACHE_VARS += PIP_ARGS
 PIP_ARGS ?=
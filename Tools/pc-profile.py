@@ -0,0 +1,104 @@
+#!/usr/bin/env python3
+#
+# Symbolise output from Profiling::PcSampler
+#
+# Sample addresses are mapped to functions using the symbol table from the application ELF file.
+# A summary is printed, and the result written in 'folded' format (one line per function
+# giving name and sample count) as accepted by flamegraph.pl, speedscope, etc.
+#
+
+import argparse
+import re
+import subprocess
+import sys
+from bisect import bisect_right
+
+BEGIN_MARKER = '--- PC SAMPLES BEGIN ---'
+END_MARKER = '--- PC SAMPLES END ---'
+
+
+def read_samples(filename):
+    """Return dictionary of {pc: count} from the last complete report in a log"""
+    samples = None
+    current = None
+    with open(filename, 'r', errors='replace') as f:
+        for line in f:
+            line = line.strip()
+            if BEGIN_MARKER in line:
+                current = {}
+                continue
+            if END_MARKER in line:
+                if current is not None:
+                    samples = current
+                current = None
+                continue
+            if current is None:
+                continue
+            m = re.match(r'0x([0-9a-fA-F]+)\s+(\d+)', line)
+            if m:
+                pc = int(m[1], 16)
+                current[pc] = current.get(pc, 0) + int(m[2])
+    return samples
+
+
+def read_functions(nm, elf_file):
+    """Return list of (address, size, name) for all functions, sorted by address"""
+    output = subprocess.check_output([nm, '-S', '-n', '-C', '--defined-only', elf_file]).decode()
+    functions = []
+    for line in output.splitlines():
+        m = re.match(r'([0-9a-fA-F]+) ([0-9a-fA-F]+) ([tTwW]) (.+)', line)
+        if m is None:
+            continue
+        # Clear Thumb bit
+        addr = int(m[1], 16) & ~1
+        size = int(m[2], 16)
+        if size != 0:
+            functions.append((addr, size, m[4]))
+    functions.sort()
+    return functions
+
+
+def map_samples(samples, functions):
+    """Return dictionary of {name: count}, with unmatched addresses listed individually"""
+    addresses = [f[0] for f in functions]
+    counts = {}
+    for pc, count in samples.items():
+        i = bisect_right(addresses, pc) - 1
+        if i >= 0 and pc < functions[i][0] + functions[i][1]:
+            name = functions[i][2]
+        else:
+            name = '[0x%08x]' % pc
+        counts[name] = counts.get(name, 0) + count
+    return counts
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Sming PC sampler report symboliser')
+    parser.add_argument('--nm', default='nm', help='Path to nm tool')
+    parser.add_argument('--top', type=int, default=20, help='Number of functions to list in summary')
+    parser.add_argument('elf', help='Application ELF file')
+    parser.add_argument('capture', help='Log file containing sampler report')
+    parser.add_argument('output', nargs='?', help='Folded output file')
+    args = parser.parse_args()
+
+    samples = read_samples(args.capture)
+    if samples is None:
+        sys.exit("No complete sample report found in '%s'" % args.capture)
+
+    counts = map_samples(samples, read_functions(args.nm, args.elf))
+    ranked = sorted(counts.items(), key=lambda e: e[1], reverse=True)
+    total = sum(counts.values())
+
+    if args.output:
+        with open(args.output, 'w') as f:
+            for name, count in ranked:
+                # Frame separator is ';' so must not appear in names
+                f.write('%s %u\n' % (name.replace(';', ':'), count))
+
+    print('%u samples in %u functions' % (total, len(ranked)))
+    for name, count in ranked[:args.top]:
+        print('  %6u %5.1f%% %s' % (count, 100 * count / total, name))
+
+
+if __name__ == '__main__':
+    main()
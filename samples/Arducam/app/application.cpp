@@ -8,7 +8,8 @@
 #include <Libraries/ArduCAM/ArduCAM.h>
 #include <Libraries/ArduCAM/ov2640_regs.h>
 
-#include <Libraries/ArduCAM/ArduCAMStream.h>
+#include <Libraries/ArduCAM/ArduCAMCapture.h>
+#include <Network/Http/Websocket/WebsocketResource.h>
 #include <Services/HexDump/HexDump.h>
 #include <Data/Stream/MultipartStream.h>
 
@@ -46,6 +47,10 @@ ArduCAM myCAM(OV2640, CAM_CS);
 
 ArduCamCommand arduCamCommand(&myCAM);
 
+ArduCAMCapture camCapture(myCAM);
+Timer wsFrameTimer;
+unsigned wsNextClient;
+
 SPISettings spiSettings(20000000, MSBFIRST, SPI_MODE0);
 
 /*
@@ -106,13 +111,6 @@ void initCam()
 	myCAM.InitCAM();
 }
 
-void startCapture()
-{
-	//  Serial.printf("startCapture()\n");
-	myCAM.clear_fifo_flag();
-	myCAM.start_capture();
-}
-
 /*
  * default http handler to check if server is up and running
  */
@@ -161,33 +159,28 @@ void onCapture(HttpRequest& request, HttpResponse& response)
 
 	// TODO: use request parameters to overwrite camera settings
 	// setupCamera(camSettings);
-	myCAM.clear_fifo_flag();
-	myCAM.write_reg(ARDUCHIP_FRAMES, 0x00);
 
 	// get the picture
 	OneShotFastMs timer;
-	startCapture();
-	Serial.printf("onCapture() startCapture() %s\r\n", timer.elapsedTime().toString().c_str());
+	auto stream = camCapture.capture();
+	Serial.printf("onCapture() capture %s\r\n", timer.elapsedTime().toString().c_str());
 
-	ArduCAMStream* stream = new ArduCAMStream(&myCAM);
-
-	const char* contentType = arduCamCommand.getContentType();
-
-	if(stream->dataReady()) {
-		response.headers[HTTP_HEADER_CONTENT_LENGTH] = String(stream->available());
-		response.sendDataStream(stream, contentType);
+	if(stream == nullptr) {
+		// Camera busy with another client
+		response.code = HTTP_STATUS_SERVICE_UNAVAILABLE;
+		return;
 	}
 
-	Serial.printf("onCapture() process Stream %s\r\n", timer.elapsedTime().toString().c_str());
+	response.headers[HTTP_HEADER_CONTENT_LENGTH] = String(stream->available());
+	response.sendDataStream(stream, arduCamCommand.getContentType());
 }
 
 MultipartStream::BodyPart snapshotProducer()
 {
 	MultipartStream::BodyPart result;
 
-	startCapture();
-	ArduCAMStream* camStream = new ArduCAMStream(&myCAM);
-	result.stream = camStream;
+	// Each part is a fresh capture so a slow client simply receives fewer frames
+	result.stream = camCapture.createStream();
 
 	result.headers = new HttpHeaders();
 	(*result.headers)[HTTP_HEADER_CONTENT_TYPE] = "image/jpeg";
@@ -201,13 +194,31 @@ void onStream(HttpRequest& request, HttpResponse& response)
 
 	// TODO: use request parameters to overwrite camera settings
 	// setupCamera(camSettings);
-	myCAM.clear_fifo_flag();
-	myCAM.write_reg(ARDUCHIP_FRAMES, 0x00);
 
 	MultipartStream* stream = new MultipartStream(snapshotProducer);
 	response.sendDataStream(stream, String("multipart/x-mixed-replace; boundary=") + stream->getBoundary());
 }
 
+/*
+ * Send latest frame to websocket clients as binary messages
+ *
+ * The camera FIFO can only be read by one client at a time, so frames are offered to clients in turn.
+ * Any clients not served before the FIFO becomes busy wait for the next tick, so slow clients drop frames.
+ */
+void sendWebsocketFrames()
+{
+	auto& clients = WebsocketConnection::getActiveWebsockets();
+	auto count = clients.count();
+	for(unsigned i = 0; i < count; ++i) {
+		auto stream = camCapture.capture();
+		if(stream == nullptr) {
+			break;
+		}
+		wsNextClient %= count;
+		clients[wsNextClient++]->send(stream, WS_FRAME_BINARY);
+	}
+}
+
 void onFavicon(HttpRequest& request, HttpResponse& response)
 {
 	response.code = HTTP_STATUS_NOT_FOUND;
@@ -225,6 +236,7 @@ void StartServers()
 	server.paths.set("/cam/set", onCamSetup);
 	server.paths.set("/cam/capture", onCapture);
 	server.paths.set("/stream", onStream);
+	server.paths.set("/ws", new WebsocketResource());
 	server.paths.set("/favicon.ico", onFavicon);
 	server.paths.setDefault(onFile);
 
@@ -232,6 +244,8 @@ void StartServers()
 	Serial.println(WifiStation.getIP());
 	Serial.println("==============================\r\n");
 
+	wsFrameTimer.initializeMs<100>(sendWebsocketFrames).start();
+
 	telnet.listen(23);
 	telnet.enableDebug(true);
 
@@ -84,6 +84,11 @@ void onFile(HttpRequest& request, HttpResponse& response)
 			tmpl = new IFS::HtmlDirectoryTemplate(source, dir);
 		}
 		tmpl->onGetValue(getValue);
+		unsigned limit = request.uri.Query["limit"].toInt();
+		String cursor = request.uri.Query["cursor"];
+		if(!cursor || !tmpl->setCursor(cursor, limit)) {
+			tmpl->setPage(request.uri.Query["offset"].toInt(), limit);
+		}
 		dir->open(file);
 		tmpl->gotoSection(0);
 		response.sendDataStream(tmpl, tmpl->getMimeType());
@@ -101,7 +101,7 @@ void MyServoChannel::calcValue()
 		if(i > 0) {
 			buf += ", ";
 		}
-		buf += frame.slots[i];
+		buf += frame.slots[i].ticks;
 	}
 	Serial.print(buf);
 #endif
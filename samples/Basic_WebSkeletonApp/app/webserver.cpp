@@ -37,25 +37,12 @@ DEFINE_FSTR_MAP_LOCAL(fileMap, FlashString, FlashString, FILE_LIST(XX));
 
 void sendFile(const String& fileName, HttpServerConnection& connection)
 {
+	// Sends compressed variant if client accepts it
 	auto response = connection.getResponse();
-
-	String compressed = fileName + ".gz";
-	auto v = fileMap[compressed];
-	if(v) {
-		response->headers[HTTP_HEADER_CONTENT_ENCODING] = _F("gzip");
-	} else {
-		v = fileMap[fileName];
-		if(!v) {
-			debug_w("File '%s' not found", fileName.c_str());
-			response->code = HTTP_STATUS_NOT_FOUND;
-			return;
-		}
+	if(!response->sendFile(*connection.getRequest(), fileMap, fileName)) {
+		debug_w("File '%s' not found", fileName.c_str());
 	}
 
-	debug_i("found %s in fileMap", String(v.key()).c_str());
-	auto stream = new FSTR::Stream(v.content());
-	response->sendDataStream(stream, ContentType::fromFullFileName(fileName));
-
 	// Use client caching for better performance.
 	//	response->setCache(86400, true);
 }
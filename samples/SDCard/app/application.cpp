@@ -223,10 +223,7 @@ bool speedTest(unsigned num)
 
 bool sdInit()
 {
-	//  select between hardware SPI or software SPI. Comment out one or the other
-	//  SDCardSPI = new SPISoft(PIN_CARD_DO, PIN_CARD_DI, PIN_CARD_CK, 0);
-	SDCardSPI = &SPI;
-	if(!SDCard_begin(PIN_CARD_SS, SPI_FREQ_LIMIT)) {
+	if(!SDCard_begin(SPI, PIN_CARD_SS, SPI_FREQ_LIMIT)) {
 		Serial.println(_F("SPI init failed"));
 		return false;
 	}
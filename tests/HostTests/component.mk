@@ -32,6 +32,7 @@ endif
 
 COMPONENT_DEPENDS := \
 	malloc_count \
+	ObjectPool \
 	axtls-8266 \
 	bearssl-esp8266
 
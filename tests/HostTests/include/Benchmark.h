@@ -0,0 +1,89 @@
+/****
+ * Benchmark.h - Throughput measurement for HostTests
+ *
+ * Results are printed one per line in a machine-readable form:
+ *
+ * 	#BENCH:group,name,count,bytes,min_ns,avg_ns,max_ns,kb_per_sec
+ *
+ * `bytes` is the quantity of data processed per run, 0 if not applicable, in which case
+ * `kb_per_sec` is also 0.
+ *
+ * Use `tools/bench-compare.py` to compare output from two test runs.
+ *
+ ****/
+
+#pragma once
+
+#include <HostTests.h>
+#include <Services/Profiling/MinMaxTimes.h>
+
+class Benchmark : public Profiling::CpuCycleTimes
+{
+public:
+	/**
+	 * @brief Constructor
+	 * @param group Identifies related benchmarks
+	 * @param name Identifies the specific benchmark within its group
+	 * @param bytes Quantity of data processed by each run, used to calculate throughput
+	 */
+	Benchmark(const String& group, const String& name, size_t bytes = 0)
+		: CpuCycleTimes(name), group(group), bytes(bytes)
+	{
+	}
+
+	/**
+	 * @brief Time a function over a number of iterations
+	 * @note One warm-up run is performed first so cache misses don't skew the results
+	 */
+	template <typename Func> Benchmark& run(unsigned iterations, Func func)
+	{
+		func();
+		for(unsigned i = 0; i < iterations; ++i) {
+			start();
+			func();
+			update();
+		}
+		return *this;
+	}
+
+	/**
+	 * @brief Get throughput based on average time
+	 * @retval uint32_t KB/sec, 0 if not applicable
+	 */
+	uint32_t getThroughput() const
+	{
+		uint64_t ns = getAverageTime().as<NanoTime::Nanoseconds>();
+		if(bytes == 0 || ns == 0) {
+			return 0;
+		}
+		return uint64_t(bytes) * 1000000000ULL / (ns * 1024);
+	}
+
+	size_t printTo(Print& p) const override
+	{
+		auto ns = [](const NanoTime::Time<uint32_t>& t) -> uint32_t { return t.as<NanoTime::Nanoseconds>(); };
+
+		size_t n{0};
+		n += p.print(_F("#BENCH:"));
+		n += p.print(group);
+		n += p.print(',');
+		n += p.print(getTitle());
+		n += p.print(',');
+		n += p.print(getCount());
+		n += p.print(',');
+		n += p.print(bytes);
+		n += p.print(',');
+		n += p.print(ns(getMinTime()));
+		n += p.print(',');
+		n += p.print(ns(getAverageTime()));
+		n += p.print(',');
+		n += p.print(ns(getMaxTime()));
+		n += p.print(',');
+		n += p.print(getThroughput());
+		return n;
+	}
+
+private:
+	String group;
+	size_t bytes;
+};
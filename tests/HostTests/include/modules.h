@@ -9,6 +9,8 @@
 // Architecture-specific test modules
 #ifdef ARCH_HOST
 #define ARCH_TEST_MAP(XX)                                                                                              \
+	XX(AdcSampler)                                                                                                     \
+	XX(PulseCapture)                                                                                                   \
 	XX_NET(Hosted)                                                                                                     \
 	XX_NET(HttpRequest)                                                                                                \
 	XX_NET(TcpClient)
@@ -27,14 +29,27 @@
 	XX(Wiring)                                                                                                         \
 	XX(Crypto)                                                                                                         \
 	XX(CStringArray)                                                                                                   \
+	XX(StringIndex)                                                                                                    \
 	XX(Stream)                                                                                                         \
 	XX(TemplateStream)                                                                                                 \
 	XX(Serial)                                                                                                         \
 	XX(ObjectMap)                                                                                                      \
+	XX(LinkedList)                                                                                                     \
+	XX(ObjectPool)                                                                                                     \
+	XX(SpscRing)                                                                                                       \
+	XX(MallocCount)                                                                                                    \
 	XX_NET(Base64)                                                                                                     \
 	XX(DateTime)                                                                                                       \
 	XX_NET(Http)                                                                                                       \
 	XX_NET(Url)                                                                                                        \
+	XX_NET(MqttOutbox)                                                                                                 \
+	XX_NET(MqttTopicRouter)                                                                                            \
+	XX_NET(MqttStreamRouter)                                                                                           \
+	XX_NET(Mqtt5Codec)                                                                                                 \
+	XX_NET(WsDeflate)                                                                                                  \
+	XX_NET(Ntp)                                                                                                        \
+	XX_NET(TransmitScheduler)                                                                                          \
+	XX_NET(Coroutine)                                                                                                  \
 	XX(ArduinoJson5)                                                                                                   \
 	XX(ArduinoJson6)                                                                                                   \
 	XX(Storage)                                                                                                        \
@@ -43,4 +58,8 @@
 	XX(Rational)                                                                                                       \
 	XX(Clocks)                                                                                                         \
 	XX(Timers)                                                                                                         \
+	XX(Job)                                                                                                            \
+	XX(EventBus)                                                                                                       \
+	XX(Delegate)                                                                                                       \
+	XX(Benchmark)                                                                                                      \
 	ARCH_TEST_MAP(XX)
@@ -0,0 +1,68 @@
+#include <HostTests.h>
+#include <AdcSampler.h>
+#include <Digital.h>
+
+class AdcSamplerTest : public TestGroup
+{
+public:
+	AdcSamplerTest() : TestGroup(_F("AdcSampler"))
+	{
+	}
+
+	void execute() override
+	{
+		TEST_CASE("Invalid parameters")
+		{
+			REQUIRE(!sampler.begin(A0, 0, 64, [](const AdcSampler::Sample*, size_t) {}));
+			REQUIRE(!sampler.begin(A0, 1000, 0, [](const AdcSampler::Sample*, size_t) {}));
+			REQUIRE(!sampler.begin(A0, 1000, 64, nullptr));
+			REQUIRE(!sampler.isRunning());
+		}
+
+		TEST_CASE("Continuous blocks")
+		{
+			REQUIRE(sampler.begin(A0, 10000, 100, [this](const AdcSampler::Sample* samples, size_t count) {
+				REQUIRE(samples != nullptr);
+				REQUIRE_EQ(count, 100);
+				if(sampler.getStats().blocks + 1 != blockCount) {
+					return;
+				}
+				System.queueCallback([this]() {
+					auto& stats = sampler.getStats();
+					debug_i("blocks %u, overruns %u", stats.blocks, stats.overruns);
+					REQUIRE(stats.blocks >= blockCount);
+					REQUIRE_EQ(stats.overruns, 0);
+					sampler.end();
+					REQUIRE(!sampler.isRunning());
+					destroyFromCallback();
+				});
+			}));
+			REQUIRE(sampler.isRunning());
+			REQUIRE_EQ(sampler.getSampleRate(), 10000);
+			REQUIRE_EQ(sampler.getBlockSize(), 100);
+			pending();
+		}
+	}
+
+	void destroyFromCallback()
+	{
+		TEST_CASE("Destroy from callback")
+		{
+			auto heapSampler = new AdcSampler;
+			REQUIRE(heapSampler->begin(A0, 10000, 100, [this, heapSampler](const AdcSampler::Sample*, size_t) {
+				delete heapSampler;
+				// Give any further queued callback a chance to run
+				System.queueCallback([this]() { complete(); });
+			}));
+		}
+	}
+
+private:
+	static constexpr unsigned blockCount{5};
+	AdcSampler sampler;
+};
+
+void REGISTER_TEST(AdcSampler)
+{
+	registerGroup<AdcSamplerTest>();
+}
@@ -177,6 +177,29 @@ public:
 			debug_d("doc.memoryUsage = %u", doc.memoryUsage());
 		}
 
+		TEST_CASE("JsonObjectStream")
+		{
+			for(auto format = Json::Compact; format <= Json::MessagePack; ++format) {
+				String expected = Json::serialize(sourceDoc, format);
+				JsonObjectStream stream(format);
+				REQUIRE(stream.getRoot().set(sourceDoc.as<JsonObject>()));
+				REQUIRE_EQ(size_t(stream.available()), expected.length());
+
+				// Read in small blocks, consuming only part of each as a busy connection would
+				String output;
+				char block[7];
+				while(!stream.isFinished()) {
+					auto len = stream.readMemoryBlock(block, sizeof(block));
+					REQUIRE(len != 0);
+					len = std::max(1, len / 2);
+					output.concat(block, len);
+					REQUIRE(stream.seek(len));
+				}
+				REQUIRE_EQ(stream.readMemoryBlock(block, sizeof(block)), 0);
+				REQUIRE(output == expected);
+			}
+		}
+
 		TEST_CASE("Json::saveToFile(doc, test_msgpack, Json::MessagePack)")
 		{
 			REQUIRE(Json::saveToFile(doc, test_msgpack, Json::MessagePack) == true);
@@ -0,0 +1,189 @@
+#include <HostTests.h>
+#include <Benchmark.h>
+#include <Crypto/Md5.h>
+#include <Crypto/Sha1.h>
+#include <Crypto/Sha2.h>
+#include <Crypto/Blake2s.h>
+#include <Data/WebHelpers/base64.h>
+#include <Data/HexString.h>
+#include <Data/Stream/MemoryDataStream.h>
+#include <Data/Stream/TemplateStream.h>
+#include <Data/Stream/CompiledTemplate.h>
+#include <ArduinoJson.h>
+
+#ifndef DISABLE_NETWORK
+#include <Data/Stream/ChunkedStream.h>
+#include <libb64/cencode.h>
+#include <libb64/cdecode.h>
+#endif
+
+/*
+ * Throughput benchmarks for hot code paths.
+ *
+ * Results are emitted as `#BENCH:` lines, see Benchmark.h.
+ */
+class BenchmarkTest : public TestGroup
+{
+public:
+	static constexpr unsigned iterations{20};
+	static constexpr size_t dataSize{4096};
+
+	BenchmarkTest() : TestGroup(_F("Benchmark"))
+	{
+	}
+
+	void execute() override
+	{
+		data.setLength(dataSize);
+		for(size_t i = 0; i < dataSize; ++i) {
+			data[i] = os_random();
+		}
+
+		TEST_CASE("Hashes")
+		{
+			benchmarkHash<Crypto::Md5>();
+			benchmarkHash<Crypto::Sha1>();
+			benchmarkHash<Crypto::Sha256>();
+			benchmarkHash<Crypto::Sha512>();
+			benchmarkHash<Crypto::Blake2s256>();
+		}
+
+		TEST_CASE("base64")
+		{
+			String encoded;
+			report(Benchmark(F("base64"), F("encode"), dataSize).run(iterations, [&]() {
+				encoded = base64_encode(reinterpret_cast<const uint8_t*>(data.c_str()), data.length());
+			}));
+			REQUIRE_EQ(encoded.length(), base64_min_encode_len(dataSize));
+
+			String decoded;
+			report(Benchmark(F("base64"), F("decode"), encoded.length()).run(iterations, [&]() {
+				decoded = base64_decode(encoded.c_str(), encoded.length());
+			}));
+			REQUIRE(decoded == data);
+
+#ifndef DISABLE_NETWORK
+			// Reference implementation, previously used for base64_encode/decode
+			String libEncoded;
+			libEncoded.setLength(encoded.length());
+			report(Benchmark(F("base64"), F("libb64 encode"), dataSize).run(iterations, [&]() {
+				base64_encodestate state;
+				base64_init_encodestate(&state, 0);
+				auto len = base64_encode_block(data.c_str(), data.length(), libEncoded.begin(), &state);
+				base64_encode_blockend(libEncoded.begin() + len, &state);
+			}));
+			REQUIRE(libEncoded == encoded);
+
+			report(Benchmark(F("base64"), F("libb64 decode"), encoded.length()).run(iterations, [&]() {
+				base64_decodestate state;
+				base64_init_decodestate(&state);
+				base64_decode_block(encoded.c_str(), encoded.length(), decoded.begin(), &state);
+			}));
+			REQUIRE(decoded == data);
+#endif
+		}
+
+		TEST_CASE("hex")
+		{
+			String encoded;
+			encoded.setLength(dataSize * 2);
+			report(Benchmark(F("hex"), F("encode"), dataSize).run(iterations, [&]() {
+				hexEncode(data.c_str(), data.length(), encoded.begin());
+			}));
+
+			String decoded;
+			decoded.setLength(dataSize);
+			int len{0};
+			report(Benchmark(F("hex"), F("decode"), encoded.length()).run(iterations, [&]() {
+				len = hexDecode(encoded.c_str(), encoded.length(), reinterpret_cast<uint8_t*>(decoded.begin()));
+			}));
+			REQUIRE_EQ(len, int(dataSize));
+			REQUIRE(decoded == data);
+		}
+
+#ifndef DISABLE_NETWORK
+		TEST_CASE("ChunkedStream")
+		{
+			report(Benchmark(F("stream"), F("ChunkedStream"), dataSize).run(iterations, [&]() {
+				ChunkedStream chunked(new MemoryDataStream(String(data)));
+				drain(chunked);
+			}));
+		}
+#endif
+
+		TEST_CASE("TemplateStream")
+		{
+			String tmpl;
+			while(tmpl.length() < dataSize) {
+				tmpl += _F("Some text containing {var1} and {var2}, then some more text. ");
+			}
+			report(Benchmark(F("stream"), F("TemplateStream"), tmpl.length()).run(iterations, [&]() {
+				TemplateStream stream(new MemoryDataStream(String(tmpl)));
+				stream.setVar(F("var1"), F("value #1"));
+				stream.setVar(F("var2"), F("value #2"));
+				drain(stream);
+			}));
+
+			CStringArray names;
+			names += "var1";
+			names += "var2";
+			CompiledTemplate compiled(names);
+			auto getValue = [](unsigned id) -> String { return (id == 0) ? F("value #1") : F("value #2"); };
+			report(Benchmark(F("stream"), F("CompiledTemplateStream"), tmpl.length()).run(iterations, [&]() {
+				CompiledTemplateStream stream(compiled, new MemoryDataStream(String(tmpl)), getValue);
+				drain(stream);
+			}));
+		}
+
+		TEST_CASE("JSON")
+		{
+			DynamicJsonDocument doc(2048);
+			for(unsigned i = 0; i < 32; ++i) {
+				String key('k');
+				key += i;
+				doc[key] = i * 1234567;
+			}
+			String json;
+			Json::serialize(doc, json);
+			report(Benchmark(F("json"), F("serialize"), json.length()).run(iterations, [&]() {
+				json.setLength(0);
+				Json::serialize(doc, json);
+			}));
+			report(Benchmark(F("json"), F("deserialize"), json.length()).run(iterations, [&]() {
+				DynamicJsonDocument doc2(2048);
+				Json::deserialize(doc2, json);
+			}));
+		}
+	}
+
+private:
+	template <class Context> void benchmarkHash()
+	{
+		typename Context::Hash hash;
+		report(Benchmark(F("hash"), Context::Engine::name, dataSize).run(iterations, [&]() {
+			hash = Context().calculate(data.c_str(), data.length());
+		}));
+	}
+
+	void report(const Benchmark& bench)
+	{
+		Serial.println(bench);
+	}
+
+	static void drain(IDataSourceStream& stream)
+	{
+		char buf[256];
+		while(!stream.isFinished()) {
+			if(stream.readBytes(buf, sizeof(buf)) == 0) {
+				break;
+			}
+		}
+	}
+
+	String data;
+};
+
+void REGISTER_TEST(Benchmark)
+{
+	registerGroup<BenchmarkTest>();
+}
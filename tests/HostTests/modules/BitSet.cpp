@@ -1,5 +1,6 @@
 #include <HostTests.h>
 #include <Data/BitSet.h>
+#include <Data/BitArray.h>
 #include <Data/CStringArray.h>
 
 #define FRUIT_ELEMENT_MAP(XX)                                                                                          \
@@ -146,6 +147,70 @@ public:
 			REQUIRE(large.domain().value() == 0x7FFFFFFFFULL);
 		}
 
+		TEST_CASE("Find")
+		{
+			BitSet<uint64_t, uint8_t, 40> large = uint64_t(0x8000000001ULL);
+			REQUIRE_EQ(large.count(), 2U);
+			REQUIRE_EQ(large.findFirst(), 0U);
+			REQUIRE_EQ(large.findNext(0), 39U);
+			REQUIRE_EQ(large.findNext(39), 40U);
+
+			FruitBasket basket;
+			REQUIRE_EQ(basket.findFirst(), basket.size());
+			REQUIRE_EQ(fixedBasket.findFirst(), unsigned(Fruit::banana));
+			REQUIRE_EQ(fixedBasket.findNext(unsigned(Fruit::banana)), unsigned(Fruit::orange));
+		}
+
+		TEST_CASE("BitArray")
+		{
+			BitArray<300> bits;
+			REQUIRE(sizeof(bits) == 40);
+			REQUIRE(bits.none());
+			bits.setRange(30, 40);
+			bits.set(299);
+			REQUIRE_EQ(bits.count(), 41U);
+			REQUIRE_EQ(bits.findFirst(), 30U);
+			REQUIRE_EQ(bits.findNext(69), 299U);
+			REQUIRE_EQ(bits.findNext(299), 300U);
+			unsigned n{0};
+			for(auto i : bits) {
+				REQUIRE(bits[i]);
+				++n;
+			}
+			REQUIRE_EQ(n, 41U);
+
+			bits.flip();
+			REQUIRE_EQ(bits.count(), 259U);
+			REQUIRE(!bits[299]);
+
+			BitArray<300> other;
+			other.setRange(0, 64);
+			bits &= other;
+			REQUIRE_EQ(bits.count(), 30U);
+			bits ^= other;
+			REQUIRE_EQ(bits.count(), 34U);
+			REQUIRE_EQ(bits.findFirst(), 30U);
+
+			DynamicBitArray dyn(10);
+			dyn.set();
+			REQUIRE(dyn.all());
+			REQUIRE(dyn.resize(300));
+			REQUIRE_EQ(dyn.count(), 10U);
+			dyn |= bits;
+			REQUIRE_EQ(dyn.count(), 44U);
+			dyn -= bits;
+			REQUIRE_EQ(dyn.count(), 10U);
+
+			static const uint32_t flashWords[] PROGMEM = {0x80000001, 0, 0x00010000};
+			FlashBitArray flashBits(flashWords);
+			REQUIRE_EQ(flashBits.size(), 96U);
+			REQUIRE_EQ(flashBits.count(), 3U);
+			REQUIRE_EQ(flashBits.findNext(31), 80U);
+			BitArray<96> copy;
+			copy |= flashBits;
+			REQUIRE(copy == flashBits);
+		}
+
 		TEST_CASE("toString")
 		{
 			REQUIRE(toString(12) == "12");
@@ -3,6 +3,8 @@
 #include <Crypto/Sha1.h>
 #include <Crypto/Sha2.h>
 #include <Crypto/Blake2s.h>
+#include <Crypto/HashJob.h>
+#include <vector>
 #include "Crypto/AxHash.h"
 #include "Crypto/BrHash.h"
 
@@ -134,6 +136,44 @@ public:
 		REQUIRE(hashText == expectedHash);
 	}
 
+	template <class Context> void checkHmacReuse()
+	{
+		Context hmac(hmacKey);
+		auto hash1 = hmac.calculate(plainText);
+		auto hash2 = hmac.calculate(hmacKey);
+		REQUIRE(hash1 == Context(hmacKey).calculate(plainText));
+		REQUIRE(hash2 == Context(hmacKey).calculate(hmacKey));
+
+		hmac.update(hmacKey);
+		hmac.reset();
+		REQUIRE(hmac.calculate(plainText) == hash1);
+
+		Crypto::Blob messages[]{plainText, hmacKey, plainText};
+		typename Context::Hash hashes[3];
+		hmac.calculateBatch(messages, hashes, 3);
+		REQUIRE(hashes[0] == hash1);
+		REQUIRE(hashes[1] == hash2);
+		REQUIRE(hashes[2] == hash1);
+	}
+
+	template <class Context> void checkBatch()
+	{
+		// Messages of assorted lengths, including those which need an extra padding block
+		constexpr size_t count{20};
+		const size_t lengths[count]{0, 1, 55, 56, 63, 64, 65, 119, 120, 128, 200, 3, 17, 32, 48, 100, 250, 300, 511, 1000};
+		std::vector<Crypto::Blob> messages;
+		for(unsigned i = 0; i < count; ++i) {
+			messages.emplace_back(plainText.c_str() + i, lengths[i]);
+		}
+
+		typename Context::Hash hashes[count];
+		Context::calculateBatch(messages.data(), hashes, count);
+		for(unsigned i = 0; i < count; ++i) {
+			auto hash = Context().calculate(messages[i]);
+			REQUIRE(hash == hashes[i]);
+		}
+	}
+
 	template <class Context> void benchmarkHash(const String& expected)
 	{
 		MicroTimes times(Context::Engine::name);
@@ -185,6 +225,12 @@ public:
 				checkHash<Crypto::Blake2s256>(BLAKE2S_256_HASH);
 				checkHash<Crypto::Blake2s256>(BLAKE2S_256_HASH_KEYED, hmacKey);
 			}
+
+			TEST_CASE("Batch hashing")
+			{
+				checkBatch<Crypto::Sha256>();
+				checkBatch<Crypto::Sha1>();
+			}
 			break;
 
 		case 1:
@@ -222,6 +268,14 @@ public:
 				checkHmac<Crypto::HmacBlake2s128>(BLAKE2S_128_HMAC);
 				checkHmac<Crypto::HmacBlake2s256>(BLAKE2S_256_HMAC);
 			}
+
+			TEST_CASE("HMAC context re-use")
+			{
+				checkHmacReuse<Crypto::HmacMd5>();
+				checkHmacReuse<Crypto::HmacSha256>();
+				checkHmacReuse<Crypto::HmacSha512>();
+				checkHmacReuse<Crypto::HmacBlake2s256>();
+			}
 			break;
 
 		case 4:
@@ -293,6 +347,27 @@ public:
 				benchmarkHash<Crypto::Sha512>(SHA512_HASH);
 				benchmarkHash<Crypto::Blake2s256>(BLAKE2S_256_HASH);
 			}
+
+			TEST_CASE("Benchmark SHA256 batch, 8 x 48-byte messages")
+			{
+				constexpr size_t count{8};
+				Crypto::Blob messages[count]{
+					{plainText.c_str(), 48},	   {plainText.c_str() + 48, 48},  {plainText.c_str() + 96, 48},
+					{plainText.c_str() + 144, 48}, {plainText.c_str() + 192, 48}, {plainText.c_str() + 240, 48},
+					{plainText.c_str() + 288, 48}, {plainText.c_str() + 336, 48},
+				};
+				Crypto::Sha256::Hash single[count];
+				Crypto::Sha256::Hash batch[count];
+				benchmarkFunction(F("Single"), [&]() {
+					for(unsigned i = 0; i < count; ++i) {
+						single[i] = Crypto::Sha256().calculate(messages[i]);
+					}
+				});
+				benchmarkFunction(F("Batch"), [&]() { Crypto::Sha256::calculateBatch(messages, batch, count); });
+				for(unsigned i = 0; i < count; ++i) {
+					REQUIRE(batch[i] == single[i]);
+				}
+			}
 			break;
 
 		case 6:
@@ -367,6 +442,22 @@ public:
 			}
 			break;
 
+		case 11:
+			TEST_CASE("Background hashing")
+			{
+				++state;
+				bool ok = hashJob.submit(plainText.c_str(), plainText.length(),
+										 [this](const Crypto::Sha256::Hash& hash) {
+											 REQUIRE(Crypto::toString(hash) == SHA256_HASH);
+											 nextTest();
+										 });
+				REQUIRE(ok);
+				REQUIRE(hashJob.isBusy());
+				REQUIRE(!hashJob.submit(plainText.c_str(), plainText.length(), [](const Crypto::Sha256::Hash&) {}));
+			}
+			pending();
+			return;
+
 		default:
 			complete();
 			return;
@@ -379,6 +470,7 @@ public:
 
 private:
 	unsigned state = 0;
+	Crypto::HashJob<Crypto::Sha256> hashJob;
 	// Pre-load this from flash so as not to skew benchmarks
 	String hmacKey;
 	String plainText;
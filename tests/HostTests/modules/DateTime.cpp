@@ -36,6 +36,51 @@ public:
 			checkSetTime(59, 59, 23, 14, 2, 2019);
 			checkSetTime(13, 1, 1, 1, 1, 1970);
 		}
+
+		TEST_CASE("Formatting")
+		{
+			REQUIRE(testDateString == dt.toHTTPDate());
+			REQUIRE_EQ(dt.toISO8601(), "1994-11-06T08:49:37Z");
+			char buffer[DateTime::httpDateLength + 1];
+			REQUIRE_EQ(size_t(dt.toHTTPDate(buffer) - buffer), DateTime::httpDateLength);
+			REQUIRE(testDateString == buffer);
+			REQUIRE(testDateString == DateTime::getHTTPDate(testDate));
+			REQUIRE_EQ(String(DateTime::getISO8601(testDate)), "1994-11-06T08:49:37Z");
+			REQUIRE_EQ(String(DateTime::getISO8601(0)), "1970-01-01T00:00:00Z");
+		}
+
+		TEST_CASE("Calendar conversion")
+		{
+			REQUIRE_EQ(DateTime::toDays(1, 0, 1970), 0);
+			REQUIRE_EQ(DateTime::toDays(6, 10, 1994), int32_t(testDate / SECS_PER_DAY));
+			REQUIRE(DateTime::isLeapYear(2000));
+			REQUIRE(!DateTime::isLeapYear(2100));
+
+			// Check every day up to 2200, spanning non-leap century
+			uint8_t prevDay{0};
+			uint8_t prevMonth{11};
+			uint16_t prevYear{1969};
+			for(uint32_t days = 0; days < 84000; ++days) {
+				uint8_t day, month;
+				uint16_t year;
+				DateTime::fromDays(days, day, month, year);
+				if(day != prevDay + 1) {
+					REQUIRE(day == 1);
+					REQUIRE(month == (prevMonth + 1) % 12);
+					REQUIRE(year == prevYear + (month == 0));
+				}
+				REQUIRE_EQ(DateTime::toDays(day, month, year), int32_t(days));
+				prevDay = day;
+				prevMonth = month;
+				prevYear = year;
+			}
+
+			uint8_t day, month;
+			uint16_t year;
+			DateTime::fromDays(DateTime::toDays(1, 2, 2100) - 1, day, month, year);
+			REQUIRE(day == 28);
+			REQUIRE(month == 1);
+		}
 	}
 
 	void checkSetTime(uint8_t sec, uint8_t min, uint8_t hour, uint8_t day, uint8_t month, uint16_t year)
@@ -0,0 +1,101 @@
+/*
+ * Tests InlineDelegate behaviour and checks it makes no heap allocations.
+ */
+
+#include <HostTests.h>
+#include <Delegate.h>
+#include <malloc_count.h>
+
+namespace
+{
+int addOne(int value)
+{
+	return value + 1;
+}
+
+class Accumulator
+{
+public:
+	int add(int value)
+	{
+		total += value;
+		return total;
+	}
+
+	int total{0};
+};
+
+} // namespace
+
+class DelegateTest : public TestGroup
+{
+public:
+	DelegateTest() : TestGroup(_F("Delegate"))
+	{
+	}
+
+	void execute() override
+	{
+		using Callback = InlineDelegate<int(int)>;
+
+		TEST_CASE("Empty")
+		{
+			Callback cb;
+			REQUIRE(!cb);
+			REQUIRE(cb == nullptr);
+			REQUIRE(cb(1) == 0);
+			cb = Callback(static_cast<int (*)(int)>(nullptr));
+			REQUIRE(!cb);
+			InlineDelegate<void()> vcb;
+			vcb();
+		}
+
+		auto allocCount = MallocCount::getAllocCount();
+
+		TEST_CASE("Function")
+		{
+			Callback cb(addOne);
+			REQUIRE(cb);
+			REQUIRE(cb(1) == 2);
+		}
+
+		TEST_CASE("Method")
+		{
+			Accumulator acc;
+			Callback cb(&Accumulator::add, &acc);
+			cb(2);
+			REQUIRE(cb(3) == 5);
+			REQUIRE(acc.total == 5);
+		}
+
+		TEST_CASE("Lambda")
+		{
+			int a{1};
+			int b{2};
+			void* p{this};
+			Callback cb([&a, b, p](int value) { return (p == nullptr) ? 0 : a + b + value; });
+			REQUIRE(cb(3) == 6);
+			a = 10;
+			REQUIRE(cb(3) == 15);
+		}
+
+		TEST_CASE("Copy")
+		{
+			int count{0};
+			InlineDelegate<void()> cb([&count]() { ++count; });
+			auto copy = cb;
+			cb = nullptr;
+			REQUIRE(!cb);
+			copy();
+			copy();
+			REQUIRE(count == 2);
+		}
+
+		REQUIRE_EQ(MallocCount::getAllocCount(), allocCount);
+	}
+};
+
+void REGISTER_TEST(Delegate)
+{
+	registerGroup<DelegateTest>();
+}
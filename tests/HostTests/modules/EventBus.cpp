@@ -0,0 +1,152 @@
+/*
+ * Tests in-process publish/subscribe
+ */
+
+#include <HostTests.h>
+#include <EventBus.h>
+
+namespace
+{
+DEFINE_FSTR_LOCAL(topicTemperature, "temperature")
+DEFINE_FSTR_LOCAL(topicTemperature2, "temperature")
+DEFINE_FSTR_LOCAL(topicHumidity, "humidity")
+
+enum Topic {
+	topicA = 1,
+	topicB,
+};
+
+struct Received {
+	Vector<EventBus::Topic> topics;
+	String content;
+	unsigned batches{0};
+
+	void add(const EventBus::Event* events, unsigned count)
+	{
+		++batches;
+		for(unsigned i = 0; i < count; ++i) {
+			topics.add(events[i].topic);
+			content.concat(events[i].payload.data(), events[i].payload.size());
+		}
+	}
+};
+
+} // namespace
+
+class EventBusTest : public TestGroup
+{
+public:
+	EventBusTest() : TestGroup(_F("EventBus"))
+	{
+	}
+
+	void execute() override
+	{
+		TEST_CASE("Payload sharing")
+		{
+			EventPayload payload(F("shared"));
+			REQUIRE_EQ(payload.size(), 6U);
+			EventPayload copy(payload);
+			REQUIRE(copy.data() == payload.data());
+
+			std::unique_ptr<IDataSourceStream> stream(payload.createStream());
+			REQUIRE_EQ(stream->readString(100), "shared");
+
+			REQUIRE(!EventPayload());
+		}
+
+		TEST_CASE("Topic interning")
+		{
+			auto t1 = EventBus::getTopic(topicTemperature);
+			auto t2 = EventBus::getTopic(topicHumidity);
+			REQUIRE(t1 >= EventBus::firstInternedTopic);
+			REQUIRE(t1 != t2);
+			REQUIRE_EQ(EventBus::getTopic(topicTemperature2), t1);
+			REQUIRE_EQ(EventBus::getTopicName(t2), "humidity");
+			REQUIRE_EQ(EventBus::getTopicName(topicA), String::empty);
+		}
+
+		// Delivery follows subscription order, so results are checked from the last subscriber
+		bus.subscribe(onlyB);
+		bus.subscribe(latest);
+		bus.subscribe(history);
+		bus.subscribe(removed);
+		bus.subscribe(all);
+		onlyB.addTopic(topicB);
+
+		TEST_CASE("Publish")
+		{
+			EventPayload payload(F("0123"));
+			REQUIRE_EQ(bus.publish(topicA, payload), 4U);
+			REQUIRE_EQ(bus.publish(topicB, EventPayload(F("45"))), 5U);
+			bus.unsubscribe(removed);
+			REQUIRE_EQ(removed.getQueued(), 0U);
+			REQUIRE_EQ(bus.publish(topicB, EventPayload(F("6"))), 3U);
+			REQUIRE_EQ(bus.publish(topicA, EventPayload(F("7"))), 2U);
+
+			REQUIRE_EQ(all.getQueued(), 4U);
+			REQUIRE_EQ(onlyB.getQueued(), 2U);
+			REQUIRE_EQ(latest.getQueued(), 2U);
+			REQUIRE_EQ(history.getQueued(), 2U);
+			// Nothing delivered until task queue runs
+			REQUIRE_EQ(allReceived.batches, 0U);
+		}
+
+		pending();
+	}
+
+private:
+	void checkResults()
+	{
+		TEST_CASE("Batched delivery")
+		{
+			REQUIRE_EQ(allReceived.batches, 1U);
+			REQUIRE_EQ(allReceived.content, "0123456");
+			REQUIRE_EQ(allReceived.topics.count(), 4U);
+			REQUIRE_EQ(allReceived.topics[0], topicA);
+			REQUIRE_EQ(allReceived.topics[1], topicB);
+
+			REQUIRE_EQ(onlyBReceived.content, "456");
+			REQUIRE_EQ(onlyB.getStats().delivered, 2U);
+		}
+
+		TEST_CASE("Drop policies")
+		{
+			REQUIRE_EQ(latestReceived.content, "67");
+			REQUIRE_EQ(latest.getStats().dropped, 2U);
+			REQUIRE_EQ(historyReceived.content, "012345");
+			REQUIRE_EQ(history.getStats().dropped, 2U);
+		}
+
+		TEST_CASE("Unsubscribe")
+		{
+			REQUIRE_EQ(removedReceived.batches, 0U);
+			REQUIRE_EQ(removed.getStats().delivered, 0U);
+		}
+
+		complete();
+	}
+
+	EventBus bus;
+	Received allReceived;
+	Received onlyBReceived;
+	Received latestReceived;
+	Received historyReceived;
+	Received removedReceived;
+	EventSubscriber removed{[this](const EventBus::Event* events, unsigned count) { removedReceived.add(events, count); }};
+	EventSubscriber all{[this](const EventBus::Event* events, unsigned count) {
+							allReceived.add(events, count);
+							checkResults();
+						},
+						8};
+	EventSubscriber onlyB{[this](const EventBus::Event* events, unsigned count) { onlyBReceived.add(events, count); }};
+	EventSubscriber latest{[this](const EventBus::Event* events, unsigned count) { latestReceived.add(events, count); }, 2,
+						   EventSubscriber::DropPolicy::oldest};
+	EventSubscriber history{[this](const EventBus::Event* events, unsigned count) { historyReceived.add(events, count); },
+							2, EventSubscriber::DropPolicy::newest};
+};
+
+void REGISTER_TEST(EventBus)
+{
+	registerGroup<EventBusTest>();
+}
@@ -135,6 +135,42 @@ public:
 			debug_i("Actual file size = %d", size);
 			REQUIRE(size == 100);
 		}
+
+		TEST_CASE("Peek and seek file stream")
+		{
+			// As done by TcpConnection: peek at a block, consume some of it then seek
+			fileSetContent(testFileName, testContent);
+			FileStream fs(testFileName);
+			String content;
+			size_t consume = 1;
+			while(!fs.isFinished()) {
+				size_t length;
+				auto data = fs.peekBlock(length);
+				REQUIRE(data != nullptr);
+				REQUIRE(length <= size_t(fs.available()));
+				length = std::min(length, consume);
+				content.concat(data, length);
+				REQUIRE(fs.seek(length));
+				consume = (consume * 3) % 700 + 1;
+			}
+			REQUIRE(testContent == content);
+
+			// Stream position preserved by readMemoryBlock()
+			REQUIRE(fs.seekFrom(100, SeekOrigin::Start) == 100);
+			char buffer[1500];
+			auto count = fs.readMemoryBlock(buffer, sizeof(buffer));
+			REQUIRE_EQ(count, sizeof(buffer));
+			REQUIRE_EQ(fs.getPos(), 100);
+			REQUIRE(memcmp(buffer, content.c_str() + 100, count) == 0);
+			REQUIRE_EQ(fs.readBytes(buffer, 10), 10);
+			REQUIRE(memcmp(buffer, content.c_str() + 100, 10) == 0);
+
+			fs.setReadAhead(0);
+			size_t length;
+			REQUIRE(fs.peekBlock(length) == nullptr);
+			REQUIRE_EQ(fs.readBytes(buffer, 10), 10);
+			REQUIRE(memcmp(buffer, content.c_str() + 110, 10) == 0);
+		}
 	}
 };
 
@@ -0,0 +1,117 @@
+/*
+ * Tests co-operative background jobs
+ */
+
+#include <HostTests.h>
+#include <Job.h>
+
+namespace
+{
+class CountJob : public Job
+{
+public:
+	CountJob(unsigned limit, unsigned failAt = 0) : limit(limit), failAt(failAt)
+	{
+		setTotal(limit);
+	}
+
+	unsigned count{0};
+	unsigned progressCalls{0};
+
+protected:
+	Result step() override
+	{
+		++count;
+		if(count == failAt) {
+			return Result::Error;
+		}
+		setProgress(count);
+		return (count < limit) ? Result::More : Result::Done;
+	}
+
+private:
+	unsigned limit;
+	unsigned failAt;
+};
+
+} // namespace
+
+class JobTest : public TestGroup
+{
+public:
+	JobTest() : TestGroup(_F("Job"))
+	{
+	}
+
+	void execute() override
+	{
+		auto onComplete = [this](Job&) {
+			if(++completed == 4) {
+				checkResults();
+			}
+		};
+
+		for(auto job : {&job1, &job2, &job3, &job4}) {
+			job->onComplete(onComplete);
+		}
+		job1.onProgress([this](Job&) { ++job1.progressCalls; });
+
+		// Tiny budget forces many turns
+		REQUIRE(job1.start(1));
+		REQUIRE(job2.start());
+		REQUIRE(job3.start(1));
+		REQUIRE(job4.start());
+		REQUIRE(!job1.start());
+		REQUIRE(job1.isRunning());
+
+		// Cancel from within a progress callback, whilst other jobs are running
+		job2.onProgress([this](Job&) {
+			if(job2.getProgress() >= 10) {
+				job2.cancel();
+			}
+		});
+
+		pending();
+	}
+
+private:
+	void checkResults()
+	{
+		TEST_CASE("Completion")
+		{
+			REQUIRE(job1.getState() == Job::State::Complete);
+			REQUIRE_EQ(job1.count, 1000U);
+			REQUIRE_EQ(job1.getProgress(), job1.getTotal());
+			REQUIRE(job1.getTurnCount() > 1);
+			REQUIRE(job1.progressCalls > 0);
+			REQUIRE(job1.progressCalls <= job1.getTurnCount());
+		}
+
+		TEST_CASE("Failure")
+		{
+			REQUIRE(job3.getState() == Job::State::Failed);
+			REQUIRE_EQ(job3.count, 50U);
+		}
+
+		TEST_CASE("Cancellation")
+		{
+			REQUIRE(job2.getState() == Job::State::Cancelled);
+			REQUIRE(job2.count < 1000000U);
+			job4.cancel();
+			REQUIRE(job4.getState() == Job::State::Complete);
+		}
+
+		complete();
+	}
+
+	CountJob job1{1000};
+	CountJob job2{1000000};
+	CountJob job3{1000, 50};
+	CountJob job4{10};
+	unsigned completed{0};
+};
+
+void REGISTER_TEST(Job)
+{
+	registerGroup<JobTest>();
+}
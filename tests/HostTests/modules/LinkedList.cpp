@@ -0,0 +1,150 @@
+#include <HostTests.h>
+
+#include <Data/DoublyLinkedObjectList.h>
+
+namespace
+{
+class Item : public DoublyLinkedObjectTemplate<Item>
+{
+public:
+	Item(int value, int priority = 0) : value(value), priority(priority)
+	{
+	}
+
+	int value;
+	int priority;
+};
+
+using ItemList = DoublyLinkedObjectListTemplate<Item>;
+
+String toString(const ItemList& list)
+{
+	String s;
+	for(auto& item : list) {
+		s += item.value;
+	}
+	return s;
+}
+
+} // namespace
+
+class LinkedListTest : public TestGroup
+{
+public:
+	LinkedListTest() : TestGroup(_F("LinkedList"))
+	{
+	}
+
+	void execute() override
+	{
+		TEST_CASE("Add and remove")
+		{
+			ItemList list;
+			Item a(1), b(2), c(3), d(4);
+			list.add(&b);
+			list.add(&c);
+			list.insert(&a);
+			list.insertBefore(&d, &c);
+			REQUIRE_EQ(toString(list), "1243");
+			REQUIRE_EQ(list.count(), 4U);
+			REQUIRE(list.tail() == &c);
+			REQUIRE(list.contains(d));
+
+			REQUIRE(list.remove(&d));
+			REQUIRE(!list.remove(&d));
+			REQUIRE(!list.contains(d));
+			REQUIRE(list.remove(&a));
+			REQUIRE(list.remove(&c));
+			REQUIRE_EQ(toString(list), "2");
+			REQUIRE(list.head() == &b && list.tail() == &b);
+			REQUIRE(list.pop() == &b);
+			REQUIRE(list.isEmpty());
+			REQUIRE_EQ(list.count(), 0U);
+		}
+
+		TEST_CASE("Move between lists")
+		{
+			ItemList list1;
+			ItemList list2;
+			Item a(1), b(2);
+			list1.add(&a);
+			list1.add(&b);
+			list2.add(&a);
+			REQUIRE_EQ(toString(list1), "2");
+			REQUIRE_EQ(toString(list2), "1");
+			REQUIRE(a.getList() == &list2);
+		}
+
+		TEST_CASE("Unlink on destruction")
+		{
+			ItemList list;
+			Item a(1), c(3);
+			list.add(&a);
+			{
+				Item b(2);
+				list.add(&b);
+				list.add(&c);
+				REQUIRE_EQ(list.count(), 3U);
+			}
+			REQUIRE_EQ(toString(list), "13");
+			REQUIRE(a.getNext() == &c);
+			REQUIRE(c.getPrev() == &a);
+		}
+
+		TEST_CASE("Remove during iteration")
+		{
+			ItemList list;
+			Item items[]{1, 2, 3, 4, 5, 6};
+			for(auto& item : items) {
+				list.add(&item);
+			}
+			for(auto& item : list) {
+				if(item.value % 2 == 0) {
+					item.unlink();
+				}
+			}
+			REQUIRE_EQ(toString(list), "135");
+			REQUIRE_EQ(list.count(), 3U);
+		}
+
+		TEST_CASE("Priority order")
+		{
+			ItemList list;
+			Item items[]{{1, 5}, {2, 9}, {3, 5}, {4, 0}, {5, 9}};
+			auto higher = [](const Item& a, const Item& b) { return a.priority > b.priority; };
+			for(auto& item : items) {
+				list.add(&item, higher);
+			}
+			// Equal priorities keep the order they were added
+			REQUIRE_EQ(toString(list), "25134");
+
+			// Re-adding repositions an item
+			items[3].priority = 7;
+			list.add(&items[3], higher);
+			REQUIRE_EQ(toString(list), "25413");
+			REQUIRE_EQ(list.count(), 5U);
+		}
+
+		TEST_CASE("Clear")
+		{
+			Item a(1), b(2);
+			{
+				ItemList list;
+				list.add(&a);
+				list.add(&b);
+				list.clear();
+				REQUIRE(list.isEmpty());
+				REQUIRE(a.getList() == nullptr);
+				list.add(&a);
+			}
+			// List destructor releases items
+			REQUIRE(a.getList() == nullptr);
+			REQUIRE(a.getNext() == nullptr);
+		}
+	}
+};
+
+void REGISTER_TEST(LinkedList)
+{
+	registerGroup<LinkedListTest>();
+}
@@ -0,0 +1,77 @@
+#include <HostTests.h>
+
+#include <malloc_count.h>
+
+class MallocCountTest : public TestGroup
+{
+public:
+	MallocCountTest() : TestGroup(_F("MallocCount"))
+	{
+	}
+
+	void execute() override
+	{
+		MallocCount::enableSiteTracking(true);
+
+		TEST_CASE("Tagged allocations")
+		{
+			const MallocCount::Site* site;
+			{
+				MallocCount::TagScope tag("test");
+				auto ptr = malloc(100);
+				auto buf = new uint8_t[50];
+				site = findSite("test");
+				REQUIRE(site != nullptr);
+				REQUIRE_EQ(site->live, 2);
+				REQUIRE_EQ(site->current, 150);
+				free(ptr);
+				delete[] buf;
+			}
+			REQUIRE_EQ(site->current, 0);
+			REQUIRE_EQ(site->live, 0);
+			REQUIRE(MallocCount::getTag() == nullptr);
+		}
+
+		TEST_CASE("Size histogram")
+		{
+			// 5000 bytes falls into bucket for 8K
+			auto& bucket = MallocCount::getBucket(9);
+			auto count = bucket.count;
+			auto live = bucket.live;
+			auto ptr = malloc(5000);
+			REQUIRE_EQ(bucket.count, count + 1);
+			REQUIRE_EQ(bucket.live, live + 1);
+			free(ptr);
+			REQUIRE_EQ(bucket.live, live);
+		}
+
+		TEST_CASE("Fragmentation")
+		{
+			auto& sample = MallocCount::sample();
+			REQUIRE(sample.largest != 0);
+			REQUIRE(sample.largest <= sample.freeHeap);
+			REQUIRE(sample.fragmentation <= 100);
+			REQUIRE(MallocCount::getSampleCount() != 0);
+			MallocCount::printReport(Serial);
+		}
+
+		MallocCount::enableSiteTracking(false);
+	}
+
+private:
+	const MallocCount::Site* findSite(const char* tag)
+	{
+		for(unsigned i = 0; i < MallocCount::getSiteCount(); ++i) {
+			auto site = MallocCount::getSite(i);
+			if(site->tag != nullptr && strcmp(site->tag, tag) == 0) {
+				return site;
+			}
+		}
+		return nullptr;
+	}
+};
+
+void REGISTER_TEST(MallocCount)
+{
+	registerGroup<MallocCountTest>();
+}
@@ -14,6 +14,67 @@ public:
 
 	void execute() override
 	{
+		TEST_CASE("PbufSlice")
+		{
+			const char text1[]{"Data in first "};
+			const char text2[]{"and second buffers"};
+			auto buf = pbuf_alloc(PBUF_RAW, strlen(text1), PBUF_RAM);
+			auto buf2 = pbuf_alloc(PBUF_RAW, strlen(text2), PBUF_RAM);
+			REQUIRE(buf != nullptr && buf2 != nullptr);
+			memcpy(buf->payload, text1, strlen(text1));
+			memcpy(buf2->payload, text2, strlen(text2));
+			pbuf_cat(buf, buf2);
+
+			// Not currently being received, so data is copied
+			PbufSlice slice(client, buf, 5);
+			pbuf_free(buf);
+			REQUIRE(slice);
+			REQUIRE_EQ(slice.length(), strlen(text1) + strlen(text2) - 5);
+
+			String s;
+			for(auto segment : slice) {
+				s.concat(segment.data, segment.length);
+			}
+			REQUIRE_EQ(s, F("in first and second buffers"));
+
+			char tmp[6]{};
+			REQUIRE_EQ(slice.read(9, tmp, 5), 5);
+			REQUIRE_EQ(String(tmp), F("and s"));
+
+			PbufSlice held = std::move(slice);
+			REQUIRE(!slice);
+			held.skip(9);
+			REQUIRE_EQ(held.length(), 18);
+			held.release();
+			REQUIRE_EQ(held.length(), 0);
+		}
+
+		TEST_CASE("TcpClient::send when not connected")
+		{
+			// Stream ownership passes to the client, so it must be released on failure
+			class TrackedStream : public MemoryDataStream
+			{
+			public:
+				TrackedStream(bool& destroyed) : destroyed(destroyed)
+				{
+				}
+
+				~TrackedStream()
+				{
+					destroyed = true;
+				}
+
+			private:
+				bool& destroyed;
+			};
+
+			TcpClient idle(false);
+			bool destroyed{false};
+			REQUIRE(!idle.send(new TrackedStream(destroyed)));
+			REQUIRE(destroyed);
+			REQUIRE_EQ(idle.getPendingLength(), 0U);
+		}
+
 		if(!WifiStation.isConnected()) {
 			Serial.println("No network, skipping tests");
 			return;
@@ -63,6 +124,7 @@ public:
 			stream1->write(inputData.c_str() + offset, 3);
 			client.send(stream1);
 			offset += 3;
+			REQUIRE_EQ(client.getPendingLength(), offset);
 			client.commit();
 
 			// more stream
@@ -76,6 +76,47 @@ public:
 			delete[] outbuf;
 			delete[] inbuf;
 		}
+
+		TEST_CASE("Incremental encode / decode")
+		{
+			constexpr size_t dataSize{500};
+			uint8_t data[dataSize];
+			os_get_random(data, dataSize);
+			String expected = base64_encode(data, dataSize);
+
+			// Feed blocks of varying size and alignment
+			Base64Encoder encoder;
+			String encoded;
+			char buf[100];
+			for(size_t pos = 0, blockSize = 1; pos < dataSize; pos += blockSize, blockSize += 3) {
+				blockSize = std::min(blockSize, dataSize - pos);
+				REQUIRE(encoder.maxOutputLength(blockSize) <= sizeof(buf));
+				encoded.concat(buf, encoder.update(&data[pos], blockSize, buf));
+			}
+			encoded.concat(buf, encoder.finish(buf));
+			REQUIRE(encoded == expected);
+
+			Base64Decoder decoder;
+			String decoded;
+			for(size_t pos = 0, blockSize = 1; pos < encoded.length(); pos += blockSize, ++blockSize) {
+				blockSize = std::min(blockSize, encoded.length() - pos);
+				auto len = decoder.update(encoded.c_str() + pos, blockSize, reinterpret_cast<uint8_t*>(buf));
+				decoded.concat(buf, len);
+			}
+			REQUIRE(decoded.length() == dataSize);
+			REQUIRE(memcmp(decoded.c_str(), data, dataSize) == 0);
+		}
+
+		TEST_CASE("Line breaks")
+		{
+			Base64Encoder encoder(8);
+			char buf[32];
+			auto len = encoder.update("0123456789abcdef", 16, buf);
+			len += encoder.finish(buf + len);
+			String encoded(buf, len);
+			REQUIRE_EQ(encoded, "MDEyMzQ1\nNjc4OWFi\nY2RlZg==");
+			REQUIRE_EQ(base64_decode(encoded), "0123456789abcdef");
+		}
 	}
 
 	void streamTests()
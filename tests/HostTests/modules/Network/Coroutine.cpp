@@ -0,0 +1,87 @@
+#include <HostTests.h>
+
+#include <Network/Coroutine.h>
+
+#ifdef __cpp_impl_coroutine
+
+namespace
+{
+Coroutine::Task sequence(String& log, unsigned count, unsigned interval)
+{
+	for(unsigned i = 0; i < count; ++i) {
+		log += i;
+		co_await Coroutine::delay(interval);
+	}
+	log += '.';
+}
+
+Coroutine::Task lookup(IpAddress& addr)
+{
+	addr = co_await Coroutine::resolve(F("192.168.1.2"));
+}
+
+} // namespace
+
+class CoroutineTest : public TestGroup
+{
+public:
+	CoroutineTest() : TestGroup(_F("Coroutine"))
+	{
+	}
+
+	void execute() override
+	{
+		TEST_CASE("Immediate result")
+		{
+			IpAddress addr;
+			REQUIRE(lookup(addr));
+			REQUIRE_EQ(addr, IpAddress(192, 168, 1, 2));
+			REQUIRE_EQ(Coroutine::getStats().active, 0U);
+		}
+
+		TEST_CASE("Frame pool")
+		{
+			for(unsigned i = 0; i < COROUTINE_FRAME_COUNT; ++i) {
+				REQUIRE(sequence(logs[i], 3, 10 + i));
+			}
+			// Pool exhausted
+			String dummy;
+			auto failed = Coroutine::getStats().failed;
+			REQUIRE(!sequence(dummy, 1, 0));
+			REQUIRE_EQ(Coroutine::getStats().failed, failed + 1);
+			REQUIRE_EQ(dummy, "");
+			REQUIRE_EQ(logs[0], "0");
+
+			timer.initializeMs<200>([this]() {
+				TEST_CASE("Delay")
+				{
+					for(unsigned i = 0; i < COROUTINE_FRAME_COUNT; ++i) {
+						REQUIRE_EQ(logs[i], "012.");
+					}
+					REQUIRE_EQ(Coroutine::getStats().active, 0U);
+				}
+				complete();
+			});
+			timer.startOnce();
+			pending();
+		}
+	}
+
+private:
+	String logs[COROUTINE_FRAME_COUNT];
+	Timer timer;
+};
+
+void REGISTER_TEST(Coroutine)
+{
+	registerGroup<CoroutineTest>();
+}
+
+#else
+
+void REGISTER_TEST(Coroutine)
+{
+	debug_w("Coroutine tests require SMING_CXX_STD=gnu++20");
+}
+
+#endif
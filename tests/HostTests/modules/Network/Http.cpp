@@ -2,6 +2,13 @@
 
 #include "Network/Http/HttpCommon.h"
 #include "Network/Http/HttpHeaders.h"
+#include "Network/Http/HttpHeaderBuilder.h"
+#include "Network/Http/HttpHeaderBlock.h"
+#include "Network/Http/HttpFastParser.h"
+#include "Network/Http/HttpResourceTree.h"
+#include "Network/Http/HttpResponseCache.h"
+#include <Data/Stream/ByteRangeStream.h>
+#include <Data/Stream/MemoryDataStream.h>
 #include <Data/WebConstants.h>
 #include <Platform/Timers.h>
 
@@ -17,6 +24,11 @@ public:
 		testHttpCommon();
 		testHttpHeaders();
 		profileHttpHeaders();
+		testFastParser();
+		profileFastParser();
+		testResourceTree();
+		testResponseCache();
+		testByteRanges();
 	}
 
 	void testHttpCommon()
@@ -42,6 +54,19 @@ public:
 			DEFINE_FSTR_LOCAL(too_many_requests, "too many requests");
 			REQUIRE(s.equalsIgnoreCase(too_many_requests));
 		}
+
+		TEST_CASE("Header field names")
+		{
+			HttpHeaderFields fields;
+			for(unsigned i = 1; i < unsigned(HTTP_HEADER_CUSTOM); ++i) {
+				auto name = HttpHeaderFieldName(i);
+				String s = fields.toString(name);
+				REQUIRE(fields.fromString(s) == name);
+				s.toUpperCase();
+				REQUIRE(fields.fromString(s) == name);
+			}
+			REQUIRE(fields.fromString("X-Not-A-Header") == HTTP_HEADER_UNKNOWN);
+		}
 	}
 
 	static void printHeaders(const HttpHeaders& headers)
@@ -214,6 +239,446 @@ public:
 			// But fail on actual append
 			REQUIRE(headers2.append(HTTP_HEADER_CONTENT_LENGTH, "1234") == false);
 		}
+
+		TEST_CASE("HttpHeaderBuilder")
+		{
+			HttpHeaderBuilder builder;
+			auto add = [&](const char* name, const char* value) {
+				// Deliver in two fragments, as http_parser may do
+				auto len = strlen(name);
+				builder.onHeaderField(name, len / 2);
+				builder.onHeaderField(name + len / 2, len - len / 2);
+				builder.onHeaderValue(value, strlen(value));
+			};
+			add("Content-Type", "text/html");
+			add("Set-Cookie", "name1=value1");
+			add("Set-Cookie", "name2=value2");
+			add("X-Custom", "1234");
+			REQUIRE_EQ(builder.count(), 4);
+			REQUIRE_EQ(String(builder.find("content-type")), "text/html");
+			REQUIRE_EQ(builder[3].getName(), "X-Custom");
+			REQUIRE(builder.find("Content-Length") == nullptr);
+
+			HttpHeaders headers2;
+			builder.copyTo(headers2);
+			REQUIRE_EQ(headers2.count(), 3);
+			REQUIRE_EQ(headers2[HTTP_HEADER_CONTENT_TYPE], "text/html");
+			REQUIRE_EQ(headers2["X-Custom"], "1234");
+			REQUIRE(serialize(headers2).indexOf(String(FS_cookies)) >= 0);
+
+			builder.reset();
+			REQUIRE_EQ(builder.count(), 0);
+			REQUIRE(builder.find("Content-Type") == nullptr);
+		}
+
+		TEST_CASE("Direct output")
+		{
+			auto write = [](const HttpHeaders& h) {
+				String s;
+				REQUIRE(s.setLength(h.getOutputLength()));
+				auto end = h.write(s.begin());
+				REQUIRE_EQ(size_t(end - s.begin()), s.length());
+				return s;
+			};
+
+			REQUIRE_EQ(write(headers), serialize(headers));
+
+			HttpHeaders headers2;
+			headers2.append(HTTP_HEADER_SET_COOKIE, "name1=value1");
+			headers2.append(HTTP_HEADER_SET_COOKIE, "name2=value2");
+			REQUIRE_EQ(write(headers2), FS_cookies);
+		}
+
+		TEST_CASE("HttpHeaderBlock")
+		{
+			HttpHeaders fields;
+			fields[HTTP_HEADER_SERVER] = "Test";
+			fields["Access-Control-Allow-Origin"] = "*";
+			HttpHeaderBlock block;
+			block.set(fields);
+			REQUIRE_EQ(block.getText(), serialize(fields));
+
+			HttpHeaders response;
+			response[HTTP_HEADER_CONTENT_LENGTH] = "0";
+			REQUIRE(!response.containsAny(block.getHeaders()));
+			response["access-control-allow-origin"] = "example.com";
+			REQUIRE(response.containsAny(block.getHeaders()));
+
+			response.setDefaults(block.getHeaders());
+			REQUIRE_EQ(response.count(), 3);
+			REQUIRE_EQ(response[HTTP_HEADER_SERVER], "Test");
+			REQUIRE_EQ(response["Access-Control-Allow-Origin"], "example.com");
+		}
+	}
+
+	void testFastParser()
+	{
+		HttpFastParser::Request req;
+		HttpHeaderBuilder headers;
+		auto parse = [&](const String& text) {
+			headers.reset();
+			return HttpFastParser::parse(text.c_str(), text.length(), req, headers);
+		};
+
+		TEST_CASE("Fast parser GET")
+		{
+			String text = F("GET /index.html?a=1 HTTP/1.1\r\n"
+							"Host: 192.168.1.1\r\n"
+							"Accept-Encoding:gzip, deflate  \r\n"
+							"Connection: keep-alive\r\n"
+							"X-Custom: \r\n"
+							"\r\n");
+			REQUIRE(parse(text));
+			REQUIRE(req.method == HTTP_GET);
+			REQUIRE_EQ(String(req.path, req.pathLength), "/index.html?a=1");
+			REQUIRE_EQ(req.headLength, text.length());
+			REQUIRE_EQ(req.contentLength, 0U);
+			REQUIRE_EQ(headers.count(), 4U);
+			REQUIRE_EQ(String(headers.find("accept-encoding")), "gzip, deflate");
+			REQUIRE_EQ(String(headers.find("X-Custom")), "");
+		}
+
+		TEST_CASE("Fast parser POST")
+		{
+			String head = F("POST /api HTTP/1.1\r\nContent-Type: application/json\r\nContent-Length: 11\r\n\r\n");
+			String text = head + F("{\"a\":12345}");
+			REQUIRE(parse(text));
+			REQUIRE(req.method == HTTP_POST);
+			REQUIRE_EQ(req.headLength, head.length());
+			REQUIRE_EQ(req.contentLength, 11U);
+
+			// Pipelined request follows
+			REQUIRE(parse(text + F("GET / HTTP/1.1\r\n\r\n")));
+			REQUIRE_EQ(req.headLength + req.contentLength, text.length());
+
+			// Incomplete body
+			text.setLength(text.length() - 1);
+			REQUIRE(!parse(text));
+		}
+
+		TEST_CASE("Fast parser fallback")
+		{
+			const char* const requests[]{
+				"GET / HTTP/1.1\r\nHost: x\r\n",
+				"PUT / HTTP/1.1\r\n\r\n",
+				"GET / HTTP/1.0\r\n\r\n",
+				"GET http://host/ HTTP/1.1\r\n\r\n",
+				"GET / HTTP/1.1\nHost: x\r\n\r\n",
+				"GET / HTTP/1.1\r\nX-Long: a\r\n  b\r\n\r\n",
+				"GET / HTTP/1.1\r\nBad Name: a\r\n\r\n",
+				"GET / HTTP/1.1\r\nTransfer-Encoding: chunked\r\n\r\n",
+				"GET / HTTP/1.1\r\nConnection: Upgrade\r\nUpgrade: websocket\r\n\r\n",
+				"GET / HTTP/1.1\r\nConnection: close\r\n\r\n",
+				"GET / HTTP/1.1\r\nContent-Length: 1x\r\n\r\n",
+				"GET / HTTP/1.1\r\nContent-Length: 0\r\nContent-Length: 0\r\n\r\n",
+			};
+			for(auto request : requests) {
+				String text(request);
+				debug_d("%s", text.c_str());
+				REQUIRE(!parse(text));
+			}
+		}
+
+		TEST_CASE("Line end search")
+		{
+			char buffer[40];
+			memset(buffer, 'x', sizeof(buffer));
+			for(unsigned start = 0; start < 4; ++start) {
+				auto begin = &buffer[start];
+				auto end = &buffer[sizeof(buffer)];
+				REQUIRE(HttpFastParser::findLineEnd(begin, end) == nullptr);
+				for(unsigned pos = start + 1; pos + 1 < sizeof(buffer); ++pos) {
+					buffer[pos] = '\r';
+					buffer[pos + 1] = '\n';
+					REQUIRE(HttpFastParser::findLineEnd(begin, end) == &buffer[pos]);
+					buffer[pos] = 'x';
+					// Bare LF
+					REQUIRE(HttpFastParser::findLineEnd(begin, end) == nullptr);
+					buffer[pos + 1] = 'x';
+				}
+			}
+		}
+	}
+
+	void profileFastParser()
+	{
+		String text = F("GET /api/status?format=json HTTP/1.1\r\n"
+						"Host: 192.168.1.10\r\n"
+						"User-Agent: Mozilla/5.0 (X11; Linux x86_64; rv:109.0) Gecko/20100101 Firefox/115.0\r\n"
+						"Accept: application/json, text/plain, */*\r\n"
+						"Accept-Language: en-GB,en;q=0.5\r\n"
+						"Accept-Encoding: gzip, deflate\r\n"
+						"Connection: keep-alive\r\n"
+						"Referer: http://192.168.1.10/\r\n"
+						"Cache-Control: no-cache\r\n"
+						"\r\n");
+		const unsigned iterations = 1000;
+		HttpHeaderBuilder headers;
+
+		http_parser_settings settings{};
+		settings.on_header_field = [](http_parser* parser, const char* at, size_t length) {
+			return static_cast<HttpHeaderBuilder*>(parser->data)->onHeaderField(at, length);
+		};
+		settings.on_header_value = [](http_parser* parser, const char* at, size_t length) {
+			return static_cast<HttpHeaderBuilder*>(parser->data)->onHeaderValue(at, length);
+		};
+
+		ElapseTimer timer;
+		for(unsigned i = 0; i < iterations; ++i) {
+			http_parser parser;
+			http_parser_init(&parser, HTTP_REQUEST);
+			parser.data = &headers;
+			headers.reset();
+			http_parser_execute(&parser, &settings, text.c_str(), text.length());
+		}
+		auto slowElapsed = timer.elapsedTime();
+		REQUIRE_EQ(headers.count(), 8U);
+
+		timer.start();
+		for(unsigned i = 0; i < iterations; ++i) {
+			HttpFastParser::Request req;
+			headers.reset();
+			HttpFastParser::parse(text.c_str(), text.length(), req, headers);
+		}
+		auto fastElapsed = timer.elapsedTime();
+		REQUIRE_EQ(headers.count(), 8U);
+
+		debugf("Parse request head x %u", iterations);
+		debugf("  http_parser: %s, fast parser: %s", slowElapsed.toString().c_str(), fastElapsed.toString().c_str());
+	}
+
+	void testResourceTree()
+	{
+		HttpResourceTree tree;
+		auto addResource = [&](const String& path) {
+			auto res = new HttpResource;
+			tree.set(path, res);
+			return res;
+		};
+		auto root = addResource("/");
+		auto state = addResource("/api/device/{id}/state");
+		auto listState = addResource("/api/device/list/state");
+		auto files = addResource("/static/*");
+		addResource(RESOURCE_PATH_DEFAULT);
+
+		TEST_CASE("Resource tree literal match")
+		{
+			REQUIRE(tree.match("/") == root);
+			REQUIRE(tree.match("/api/device/list/state") == listState);
+			REQUIRE(tree.match("/api/device") == nullptr);
+		}
+
+		TEST_CASE("Resource tree path parameters")
+		{
+			HttpPathParameters params;
+			String path("/api/device/12/state");
+			REQUIRE(tree.match(path, &params) == state);
+			REQUIRE_EQ(params.count(), 1);
+			REQUIRE_EQ(params.getValue("id"), "12");
+			REQUIRE(tree.match("/api/device//state", &params) == nullptr);
+			REQUIRE_EQ(params.count(), 0);
+		}
+
+		TEST_CASE("Resource tree wildcard")
+		{
+			HttpPathParameters params;
+			String path("/static/css/main.css");
+			REQUIRE(tree.match(path, &params) == files);
+			REQUIRE_EQ(params.getValue("*"), "css/main.css");
+			REQUIRE(tree.match("/static") == files);
+		}
+
+		TEST_CASE("Resource tree modification")
+		{
+			tree.remove("/api/device/list/state");
+			HttpPathParameters params;
+			String path("/api/device/list/state");
+			REQUIRE(tree.match(path, &params) == state);
+			REQUIRE_EQ(params.getValue("id"), "list");
+		}
+
+		TEST_CASE("Resource tree flash paths")
+		{
+			DEFINE_FSTR_LOCAL(pathState, "/api/device/{id}/state")
+			DEFINE_FSTR_LOCAL(pathSensor, "/api/sensor/{name}/{field}")
+			DEFINE_FSTR_LOCAL(pathFiles, "/files/*")
+			DEFINE_FSTR_LOCAL(pathDuplicate, "/api/sensor/{name}/{field}")
+
+			HttpResourceTree flashTree;
+			auto flashState = new HttpResource;
+			flashTree.set(pathState, flashState);
+			flashTree.set(pathSensor, new HttpResource);
+			auto flashFiles = new HttpResource;
+			flashTree.set(pathFiles, flashFiles);
+			// Same content at a different address replaces existing route
+			auto sensor = new HttpResource;
+			flashTree.set(pathDuplicate, sensor);
+			// String paths take priority
+			auto stringState = new HttpResource;
+			flashTree.set(F("/api/device/0/state"), stringState);
+
+			HttpPathParameters params;
+			String path(F("/api/device/12/state"));
+			REQUIRE(flashTree.match(path, &params) == flashState);
+			REQUIRE_EQ(params.getValue(F("id")), "12");
+			REQUIRE_EQ(params[0].getName(), "id");
+			REQUIRE(flashTree.match(F("/api/device/0/state")) == stringState);
+
+			path = F("/api/sensor/temp/max");
+			REQUIRE(flashTree.match(path, &params) == sensor);
+			REQUIRE_EQ(params.count(), 2);
+			REQUIRE_EQ(params.getValue(F("name")), "temp");
+			REQUIRE_EQ(params.getValue(F("field")), "max");
+
+			path = F("/files/a/b");
+			REQUIRE(flashTree.match(path, &params) == flashFiles);
+			REQUIRE_EQ(params.getValue(F("*")), "a/b");
+		}
+
+		TEST_CASE("Resource tree cache control")
+		{
+			tree.setCacheControl("/", "no-cache");
+			tree.setCacheControl("/static/*", "public, max-age=86400");
+			tree.setCacheControl("*.json", "no-store");
+			REQUIRE_EQ(tree.getCacheControl("/"), "no-cache");
+			REQUIRE_EQ(tree.getCacheControl("/static/css/main.css"), "public, max-age=86400");
+			REQUIRE_EQ(tree.getCacheControl("/static/data.json"), "public, max-age=86400");
+			REQUIRE_EQ(tree.getCacheControl("/api/config.json"), "no-store");
+			REQUIRE(!tree.getCacheControl("/api/device"));
+			tree.setCacheControl("/static/*", nullptr);
+			REQUIRE_EQ(tree.getCacheControl("/static/data.json"), "no-store");
+		}
+	}
+
+	void testResponseCache()
+	{
+		auto generate = [](HttpResponse& response, const String& content) {
+			response.reset();
+			response.setContentType(MIME_JSON);
+			response.sendString(content);
+		};
+
+		auto getBody = [](HttpResponse& response) -> String {
+			REQUIRE(response.stream != nullptr);
+			return response.stream->readString(1024);
+		};
+
+		TEST_CASE("Response cache")
+		{
+			HttpResponseCache cache(60000);
+			cache.setKeyParameters(CStringArray(F("page")));
+			HttpRequest request(Url(F("http://localhost/api/status?page=1&ignored=2")));
+			HttpResponse response;
+
+			REQUIRE(!cache.load(request, response));
+			generate(response, F("{\"page\":1}"));
+			cache.store(request, response);
+			REQUIRE_EQ(getBody(response), F("{\"page\":1}"));
+
+			HttpRequest other(Url(F("http://localhost/api/status?page=1&ignored=3")));
+			HttpResponse cached;
+			REQUIRE(cache.load(other, cached));
+			REQUIRE_EQ(String(cached.headers[HTTP_HEADER_CONTENT_TYPE]), toString(MIME_JSON));
+			REQUIRE_EQ(getBody(cached), F("{\"page\":1}"));
+
+			HttpRequest page2(Url(F("http://localhost/api/status?page=2")));
+			HttpResponse response2;
+			REQUIRE(!cache.load(page2, response2));
+
+			cache.invalidate(F("/api/status"));
+			cached.reset();
+			REQUIRE(!cache.load(other, cached));
+
+			auto& stats = cache.getStats();
+			REQUIRE_EQ(stats.hits, 1U);
+			REQUIRE_EQ(stats.misses, 3U);
+			REQUIRE_EQ(stats.stores, 1U);
+		}
+
+		TEST_CASE("Response cache expiry")
+		{
+			HttpResponseCache cache(0);
+			HttpRequest request(Url(F("http://localhost/metrics")));
+			HttpResponse response;
+			generate(response, F("metrics"));
+			cache.store(request, response);
+			REQUIRE(!cache.load(request, response));
+		}
+	}
+
+	void testByteRanges()
+	{
+		const char* content = "0123456789ABCDEFGHIJ";
+		const unsigned size = strlen(content);
+
+		auto read = [&](const String& spec, String& result) -> int {
+			ByteRangeStream stream(size, F("text/plain"));
+			int count = stream.parse(spec);
+			if(count > 0) {
+				auto source = new MemoryDataStream;
+				source->write(reinterpret_cast<const uint8_t*>(content), size);
+				stream.setSource(source);
+				int length = stream.available();
+				result = stream.readString(1024);
+				REQUIRE_EQ(int(result.length()), length);
+				REQUIRE(stream.isFinished());
+			}
+			return count;
+		};
+
+		TEST_CASE("Byte range parsing")
+		{
+			String s;
+			REQUIRE_EQ(read(F("bytes=0-4"), s), 1);
+			REQUIRE_EQ(s, "01234");
+			REQUIRE_EQ(read(F("bytes=15-"), s), 1);
+			REQUIRE_EQ(s, "FGHIJ");
+			REQUIRE_EQ(read(F("bytes=-3"), s), 1);
+			REQUIRE_EQ(s, "HIJ");
+			REQUIRE_EQ(read(F("bytes=18-100"), s), 1);
+			REQUIRE_EQ(s, "IJ");
+			REQUIRE_EQ(read(F("bytes=-100"), s), 1);
+			REQUIRE_EQ(s, content);
+			REQUIRE_EQ(read(F("bytes=20-"), s), 0);
+			REQUIRE_EQ(read(F("bytes=-0"), s), 0);
+			REQUIRE_EQ(read(F("bytes=5-2"), s), -1);
+			REQUIRE_EQ(read(F("items=0-4"), s), -1);
+			REQUIRE_EQ(read(F("bytes=a-b"), s), -1);
+			REQUIRE_EQ(read(F("bytes="), s), -1);
+			REQUIRE_EQ(read(F("bytes=0-0,1-1,2-2,3-3,4-4,5-5,6-6,7-7,8-8"), s), -1);
+		}
+
+		TEST_CASE("Multiple byte ranges")
+		{
+			ByteRangeStream stream(size, F("text/plain"));
+			REQUIRE_EQ(stream.parse(F("bytes= 0-1, 30-40, 10-12")), 2);
+			String boundary = stream.getBoundary();
+			REQUIRE_EQ(boundary.length(), 15U);
+			REQUIRE_EQ(stream.getContentRange(1), "bytes 10-12/20");
+
+			auto source = new MemoryDataStream;
+			source->write(reinterpret_cast<const uint8_t*>(content), size);
+			stream.setSource(source);
+			int length = stream.available();
+			String s = stream.readString(1024);
+			REQUIRE_EQ(int(s.length()), length);
+
+			String expected;
+			auto addPart = [&](const char* range, const char* data) {
+				expected += "\r\n--";
+				expected += boundary;
+				expected += "\r\nContent-Type: text/plain\r\nContent-Range: bytes ";
+				expected += range;
+				expected += "/20\r\n\r\n";
+				expected += data;
+			};
+			addPart("0-1", "01");
+			addPart("10-12", "ABC");
+			expected += "\r\n--";
+			expected += boundary;
+			expected += "--\r\n";
+			REQUIRE_EQ(s, expected);
+		}
 	}
 };
 
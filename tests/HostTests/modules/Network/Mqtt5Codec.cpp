@@ -0,0 +1,135 @@
+#include <HostTests.h>
+
+#include <Network/Mqtt/Mqtt5Codec.h>
+
+namespace
+{
+using Bytes = std::initializer_list<uint8_t>;
+
+String toString(Bytes bytes)
+{
+	return String(reinterpret_cast<const char*>(bytes.begin()), bytes.size());
+}
+
+} // namespace
+
+class Mqtt5CodecTest : public TestGroup
+{
+public:
+	Mqtt5CodecTest() : TestGroup(_F("Mqtt5Codec"))
+	{
+	}
+
+	void execute() override
+	{
+		TEST_CASE("CONNECT")
+		{
+			REQUIRE(encode({0x10, 14, 0, 4, 'M', 'Q', 'T', 'T', 4, 0x02, 0, 60, 0, 2, 'a', 'b'}));
+			REQUIRE(codec.getEncoded() ==
+					toString({0x10, 15, 0, 4, 'M', 'Q', 'T', 'T', 5, 0x02, 0, 60, 0, 0, 2, 'a', 'b'}));
+		}
+
+		TEST_CASE("CONNACK")
+		{
+			// Receive maximum 4, topic alias maximum 8
+			REQUIRE(decode({0x20, 9, 0, 0, 6, 0x21, 0, 4, 0x22, 0, 8}, 1));
+			REQUIRE(output == toString({0x20, 2, 0, 0}));
+			REQUIRE_EQ(codec.getReceiveMaximum(), 4);
+			REQUIRE_EQ(codec.getTopicAliasMaximum(), 8);
+
+			// Not authorized
+			REQUIRE(decode({0x20, 3, 0, 0x87, 0}));
+			REQUIRE(output == toString({0x20, 2, 0, 5}));
+		}
+
+		TEST_CASE("Topic aliases")
+		{
+			Bytes publish{0x32, 14, 0, 8, 's', 'e', 'n', 's', 'o', 'r', '/', 'x', 0, 1, 'h', 'i'};
+
+			// First message sent as normal, with empty properties
+			REQUIRE(encode(publish));
+			REQUIRE(codec.getEncoded() ==
+					toString({0x32, 15, 0, 8, 's', 'e', 'n', 's', 'o', 'r', '/', 'x', 0, 1, 0, 'h', 'i'}));
+
+			// Second assigns alias
+			REQUIRE(encode(publish));
+			REQUIRE(codec.getEncoded() ==
+					toString({0x32, 18, 0, 8, 's', 'e', 'n', 's', 'o', 'r', '/', 'x', 0, 1, 3, 0x23, 0, 1, 'h', 'i'}));
+			REQUIRE_EQ(codec.getAliasCount(), 1U);
+
+			// Third omits topic name
+			REQUIRE(encode(publish));
+			REQUIRE(codec.getEncoded() == toString({0x32, 10, 0, 0, 0, 1, 3, 0x23, 0, 1, 'h', 'i'}));
+			REQUIRE_EQ(codec.getStats().bytesSaved, 8U);
+		}
+
+		TEST_CASE("Publish properties")
+		{
+			codec.setMessageExpiry(60);
+			codec.addUserProperty(F("k"), F("v"));
+			REQUIRE(encode({0x30, 5, 0, 1, 't', 'h', 'i'}));
+			REQUIRE(codec.getEncoded() == toString({0x30, 18, 0, 1, 't', 12, 0x02, 0, 0, 0, 60, 0x26, 0, 1, 'k', 0, 1,
+													'v', 'h', 'i'}));
+		}
+
+		TEST_CASE("SUBSCRIBE")
+		{
+			REQUIRE(encode({0x82, 8, 0, 5, 0, 3, 'a', '/', 'b', 1}));
+			REQUIRE(codec.getEncoded() == toString({0x82, 9, 0, 5, 0, 0, 3, 'a', '/', 'b', 1}));
+			REQUIRE(!encode({0xc0, 0}));
+		}
+
+		TEST_CASE("Incoming packets")
+		{
+			Bytes input{
+				0x30, 11,   0,	3,	'a',  '/', 'b', 2, 0x01, 0x01, 'x', 'y', 'z', // PUBLISH with properties
+				0xd0, 0,													  // PINGRESP
+				0x40, 4,	0,	7,	0x10, 0,									  // PUBACK with reason code
+				0x90, 5,	0,	9,	0,	1,	0x80,							  // SUBACK
+			};
+			String expected = toString({0x30, 8, 0, 3, 'a', '/', 'b', 'x', 'y', 'z', 0xd0, 0, 0x40, 2, 0, 7, 0x90, 4, 0,
+										9, 1, 0x80});
+
+			REQUIRE(decode(input));
+			REQUIRE(output == expected);
+
+			// Result must not depend on how data is split
+			REQUIRE(decode(input, 1));
+			REQUIRE(output == expected);
+			REQUIRE(decode(input, 3));
+			REQUIRE(output == expected);
+		}
+	}
+
+private:
+	bool encode(Bytes packet)
+	{
+		return codec.encode(packet.begin(), packet.size());
+	}
+
+	bool decode(Bytes data, size_t chunkSize = 0)
+	{
+		output = "";
+		auto sink = [this](const uint8_t* data, size_t length) {
+			return output.concat(reinterpret_cast<const char*>(data), length);
+		};
+		if(chunkSize == 0) {
+			chunkSize = data.size();
+		}
+		for(size_t offset = 0; offset < data.size(); offset += chunkSize) {
+			auto length = std::min(chunkSize, data.size() - offset);
+			if(!codec.decode(data.begin() + offset, length, sink)) {
+				return false;
+			}
+		}
+		return true;
+	}
+
+	Mqtt5Codec codec;
+	String output;
+};
+
+void REGISTER_TEST(Mqtt5Codec)
+{
+	registerGroup<Mqtt5CodecTest>();
+}
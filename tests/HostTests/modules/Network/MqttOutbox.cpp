@@ -0,0 +1,201 @@
+#include <HostTests.h>
+
+#include <Network/Mqtt/MqttOutbox.h>
+#include <Storage/CustomDevice.h>
+
+namespace
+{
+/*
+ * RAM-backed device with NOR flash semantics
+ */
+class FlashDevice : public Storage::CustomDevice
+{
+public:
+	static constexpr size_t size{2048};
+	static constexpr size_t blockSize{512};
+
+	FlashDevice()
+	{
+		memset(data, 0xff, size);
+	}
+
+	String getName() const override
+	{
+		return F("flashDevice");
+	}
+
+	size_t getBlockSize() const override
+	{
+		return blockSize;
+	}
+
+	size_t getSize() const override
+	{
+		return size;
+	}
+
+	Type getType() const override
+	{
+		return Type::flash;
+	}
+
+	bool read(uint32_t address, void* dst, size_t len) override
+	{
+		if(address + len > size) {
+			return false;
+		}
+		memcpy(dst, &data[address], len);
+		return true;
+	}
+
+	bool write(uint32_t address, const void* src, size_t len) override
+	{
+		if(address + len > size) {
+			return false;
+		}
+		auto p = static_cast<const uint8_t*>(src);
+		for(unsigned i = 0; i < len; ++i) {
+			data[address + i] &= p[i];
+		}
+		return true;
+	}
+
+	bool erase_range(uint32_t address, size_t len) override
+	{
+		if(address + len > size) {
+			return false;
+		}
+		memset(&data[address], 0xff, len);
+		++erases[address / blockSize];
+		return true;
+	}
+
+	uint8_t data[size];
+	unsigned erases[size / blockSize]{};
+};
+
+} // namespace
+
+class MqttOutboxTest : public TestGroup
+{
+public:
+	MqttOutboxTest() : TestGroup(_F("MqttOutbox"))
+	{
+	}
+
+	void execute() override
+	{
+		FlashDevice flash;
+		auto part = flash.createPartition(F("outbox"), Storage::Partition::Type::data, 0x90, 0, flash.size);
+
+		TEST_CASE("Store and replay")
+		{
+			MqttOutbox outbox(part);
+			REQUIRE(outbox.begin());
+			REQUIRE_EQ(outbox.getStoredCount(), 0);
+			for(unsigned i = 0; i < 5; ++i) {
+				REQUIRE(outbox.append(F("sensor/") + i, String(i * 100), i));
+			}
+			REQUIRE_EQ(outbox.getStoredCount(), 5);
+			REQUIRE_EQ(outbox.getPendingCount(), 5);
+
+			MqttOutbox::Message msg;
+			for(unsigned i = 0; i < 3; ++i) {
+				REQUIRE(outbox.read(msg));
+				REQUIRE_EQ(msg.topic, F("sensor/") + i);
+				REQUIRE_EQ(msg.content, String(i * 100));
+				REQUIRE_EQ(msg.flags, i);
+				if(i != 1) {
+					REQUIRE(outbox.consume(msg.id));
+				}
+			}
+			REQUIRE_EQ(outbox.getStoredCount(), 3);
+			REQUIRE_EQ(outbox.getPendingCount(), 2);
+			REQUIRE(!outbox.consume(MqttOutbox::RecordId{}));
+		}
+
+		TEST_CASE("Survives restart")
+		{
+			// Unconsumed messages are replayed, including one read but not acknowledged
+			MqttOutbox outbox(part);
+			REQUIRE(outbox.begin());
+			REQUIRE_EQ(outbox.getStoredCount(), 3);
+			MqttOutbox::Message msg;
+			for(unsigned i : {1, 3, 4}) {
+				REQUIRE(outbox.read(msg));
+				REQUIRE_EQ(msg.topic, F("sensor/") + i);
+				REQUIRE(outbox.consume(msg.id));
+			}
+			REQUIRE(!outbox.read(msg));
+			REQUIRE_EQ(outbox.getStoredCount(), 0);
+		}
+
+		TEST_CASE("Full outbox")
+		{
+			MqttOutbox outbox(part);
+			REQUIRE(outbox.begin());
+			String content;
+			REQUIRE(content.setLength(100));
+			memset(content.begin(), 'x', content.length());
+			unsigned count{0};
+			while(outbox.append(F("t"), content, 0)) {
+				++count;
+			}
+			debug_i("Outbox holds %u messages", count);
+			REQUIRE(count >= 12);
+			REQUIRE_EQ(outbox.getStoredCount(), count);
+
+			// Space becomes available only when a whole sector has been consumed
+			MqttOutbox::Message msg;
+			REQUIRE(outbox.read(msg));
+			REQUIRE(outbox.consume(msg.id));
+			REQUIRE(!outbox.append(F("t"), content, 0));
+			while(outbox.read(msg)) {
+				outbox.consume(msg.id);
+				if(outbox.append(F("t"), content, 0)) {
+					break;
+				}
+			}
+			REQUIRE(outbox.getStoredCount() != 0);
+
+			outbox.setDropOldest(true);
+			for(unsigned i = 0; i < count; ++i) {
+				REQUIRE(outbox.append(F("t"), content, 0));
+			}
+			REQUIRE(outbox.getDroppedCount() != 0);
+
+			// Erases are spread over the partition
+			for(auto n : flash.erases) {
+				REQUIRE(n != 0);
+			}
+
+			REQUIRE(outbox.clear());
+			REQUIRE_EQ(outbox.getStoredCount(), 0);
+			REQUIRE(!outbox.read(msg));
+		}
+
+		TEST_CASE("Damaged record")
+		{
+			MqttOutbox outbox(part);
+			REQUIRE(outbox.begin());
+			REQUIRE(outbox.append(F("a"), F("first"), 0));
+			REQUIRE(outbox.append(F("b"), F("second"), 0));
+
+			// Simulate incomplete write of first message content
+			MqttOutbox::Message msg;
+			REQUIRE(outbox.read(msg));
+			flash.data[msg.id.offset + 12] = 0;
+
+			REQUIRE(outbox.begin());
+			REQUIRE_EQ(outbox.getStoredCount(), 2);
+			REQUIRE(outbox.read(msg));
+			REQUIRE_EQ(msg.topic, "b");
+			REQUIRE_EQ(outbox.getStoredCount(), 1);
+		}
+	}
+};
+
+void REGISTER_TEST(MqttOutbox)
+{
+	registerGroup<MqttOutboxTest>();
+}
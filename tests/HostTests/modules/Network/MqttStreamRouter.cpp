@@ -0,0 +1,94 @@
+#include <HostTests.h>
+
+#include <Network/Mqtt/MqttStreamRouter.h>
+
+class MqttStreamRouterTest : public TestGroup
+{
+public:
+	MqttStreamRouterTest() : TestGroup(_F("MqttStreamRouter"))
+	{
+	}
+
+	void execute() override
+	{
+		TEST_CASE("Exact topics")
+		{
+			REQUIRE(matches("a/b/c", "a/b/c"));
+			REQUIRE(!matches("a/b/c", "a/b"));
+			REQUIRE(!matches("a/b", "a/b/c"));
+			REQUIRE(!matches("a/b", "a/bc"));
+			REQUIRE(!matches("a/b", "a/b/"));
+			REQUIRE(matches("/a", "/a"));
+			REQUIRE(!matches("/a", "a"));
+		}
+
+		TEST_CASE("Single-level wildcard")
+		{
+			REQUIRE(matches("a/+/c", "a/b/c"));
+			REQUIRE(matches("a/+/c", "a//c"));
+			REQUIRE(!matches("a/+/c", "a/b/d"));
+			REQUIRE(!matches("a/+/c", "a/b/x/c"));
+			REQUIRE(matches("a/+", "a/b"));
+			REQUIRE(matches("a/+", "a/"));
+			REQUIRE(!matches("a/+", "a"));
+			REQUIRE(!matches("a/+", "a/b/c"));
+			REQUIRE(matches("+", "a"));
+			REQUIRE(!matches("+", "a/"));
+			REQUIRE(matches("+/+", "/a"));
+			REQUIRE(matches("+/+/+", "a//"));
+		}
+
+		TEST_CASE("Multi-level wildcard")
+		{
+			REQUIRE(matches("#", "a"));
+			REQUIRE(matches("#", "a/b/c"));
+			REQUIRE(matches("#", "/"));
+			REQUIRE(matches("a/#", "a/b/c"));
+			REQUIRE(matches("a/#", "a/"));
+			REQUIRE(matches("a/#", "a"));
+			REQUIRE(!matches("a/#", "ab"));
+			REQUIRE(!matches("a/#", "b/a"));
+			REQUIRE(matches("a/b/#", "a/b"));
+			REQUIRE(!matches("a/b/#", "a"));
+			REQUIRE(matches("+/#", "a"));
+			REQUIRE(matches("+/b/#", "a/b/c/d"));
+			REQUIRE(!matches("+/b/#", "a/c/b"));
+		}
+
+		TEST_CASE("Topics starting with $")
+		{
+			REQUIRE(!matches("#", "$SYS"));
+			REQUIRE(!matches("#", "$SYS/broker/uptime"));
+			REQUIRE(!matches("+/broker/uptime", "$SYS/broker/uptime"));
+			REQUIRE(!matches("+/#", "$SYS/broker"));
+			REQUIRE(matches("$SYS/#", "$SYS/broker/uptime"));
+			REQUIRE(matches("$SYS/+/uptime", "$SYS/broker/uptime"));
+			REQUIRE(matches("$SYS", "$SYS"));
+			// Only the first level is treated specially
+			REQUIRE(matches("a/+", "a/$b"));
+			REQUIRE(matches("a/#", "a/$b/c"));
+		}
+
+		TEST_CASE("Topic length")
+		{
+			// Topic names in received messages are not NUL-terminated
+			const char* topic = "a/b/c";
+			REQUIRE(MqttStreamRouter::topicMatches("a/b", topic, 3));
+			REQUIRE(MqttStreamRouter::topicMatches("a/+", topic, 3));
+			REQUIRE(!MqttStreamRouter::topicMatches("a/b/c", topic, 3));
+			REQUIRE(MqttStreamRouter::topicMatches("#", topic, 0));
+			REQUIRE(!MqttStreamRouter::topicMatches("a", topic, 0));
+		}
+	}
+
+private:
+	static bool matches(const char* filter, const char* topic)
+	{
+		return MqttStreamRouter::topicMatches(filter, topic, strlen(topic));
+	}
+};
+
+void REGISTER_TEST(MqttStreamRouter)
+{
+	registerGroup<MqttStreamRouterTest>();
+}
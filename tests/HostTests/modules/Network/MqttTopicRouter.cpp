@@ -0,0 +1,87 @@
+#include <HostTests.h>
+
+#include <Network/Mqtt/MqttTopicRouter.h>
+
+class MqttTopicRouterTest : public TestGroup
+{
+public:
+	MqttTopicRouterTest() : TestGroup(_F("MqttTopicRouter"))
+	{
+	}
+
+	void execute() override
+	{
+		TEST_CASE("Validation")
+		{
+			REQUIRE(!router.add(F("a/#/b"), route(9)));
+			REQUIRE(!router.add(F("a+/b"), route(9)));
+			REQUIRE(!router.add(F("a/b#"), route(9)));
+			REQUIRE(!router.add(nullptr, route(9)));
+			REQUIRE_EQ(router.count(), 0U);
+		}
+
+		TEST_CASE("Matching")
+		{
+			REQUIRE(router.add(F("a/b/c"), route(1)));
+			REQUIRE(router.add(F("a/+/c"), route(2)));
+			REQUIRE(router.add(F("a/#"), route(3)));
+			REQUIRE(router.add(F("#"), route(4)));
+			REQUIRE(router.add(F("+/x"), route(5)));
+			REQUIRE_EQ(router.count(), 5U);
+
+			REQUIRE_EQ(lookup("a/b/c"), 1);
+			REQUIRE_EQ(lookup("a/z/c"), 2);
+			REQUIRE_EQ(lookup("a/z/d"), 3);
+			REQUIRE_EQ(lookup("a"), 3);
+			REQUIRE_EQ(lookup("a/b/c/d"), 3);
+			REQUIRE_EQ(lookup("b"), 4);
+			REQUIRE_EQ(lookup("q/x"), 5);
+			REQUIRE_EQ(lookup("$SYS/x"), 0);
+		}
+
+		TEST_CASE("Replace and remove")
+		{
+			REQUIRE(router.add(F("a/b/c"), route(6)));
+			REQUIRE_EQ(router.count(), 5U);
+			REQUIRE_EQ(lookup("a/b/c"), 6);
+
+			REQUIRE(router.remove(F("a/+/c")));
+			REQUIRE(!router.remove(F("a/+/c")));
+			REQUIRE(router.remove(F("#")));
+			REQUIRE_EQ(router.count(), 3U);
+			REQUIRE_EQ(lookup("a/z/c"), 3);
+			REQUIRE_EQ(lookup("b"), 0);
+			REQUIRE_EQ(lookup("q/x"), 5);
+		}
+
+		TEST_CASE("Dispatch")
+		{
+			router.setFallback(route(7));
+			mqtt_message_t message{};
+			String topic = F("unknown");
+			message.publish.topic_name.data = reinterpret_cast<uint8_t*>(topic.begin());
+			message.publish.topic_name.length = topic.length();
+			REQUIRE_EQ(router.getHandler()(client, &message), 7);
+		}
+	}
+
+private:
+	MqttDelegate route(int id)
+	{
+		return [id](MqttClient&, mqtt_message_t*) { return id; };
+	}
+
+	int lookup(const char* topic)
+	{
+		auto handler = router.find(topic, strlen(topic));
+		return handler ? (*handler)(client, nullptr) : 0;
+	}
+
+	MqttTopicRouter router;
+	MqttClient client;
+};
+
+void REGISTER_TEST(MqttTopicRouter)
+{
+	registerGroup<MqttTopicRouterTest>();
+}
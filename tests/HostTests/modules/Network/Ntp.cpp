@@ -0,0 +1,57 @@
+#include <HostTests.h>
+
+#include <Network/NtpClient.h>
+
+class NtpTest : public TestGroup
+{
+public:
+	NtpTest() : TestGroup(_F("NTP"))
+	{
+	}
+
+	void execute() override
+	{
+		constexpr int64_t nsPerSecond{1000000000LL};
+
+		TEST_CASE("Timestamp conversion")
+		{
+			// 2024-01-01 00:00:00.5 UTC
+			uint64_t timestamp = 0xe93c7f0080000000ULL;
+			int64_t ns = 1704067200LL * nsPerSecond + 500000000;
+			REQUIRE_EQ(NtpClient::timestampToNanoseconds(timestamp), ns);
+			REQUIRE_EQ(NtpClient::nanosecondsToTimestamp(ns), timestamp);
+
+			// Round trip is accurate to within a nanosecond
+			ns += 123456789;
+			auto diff = NtpClient::timestampToNanoseconds(NtpClient::nanosecondsToTimestamp(ns)) - ns;
+			REQUIRE(diff >= -1 && diff <= 1);
+
+			// Start of NTP era 1
+			REQUIRE_EQ(NtpClient::timestampToNanoseconds(0), 2085978496LL * nsPerSecond);
+			REQUIRE_EQ(NtpClient::nanosecondsToTimestamp(2085978496LL * nsPerSecond), 0ULL);
+		}
+
+		TEST_CASE("Offset and delay")
+		{
+			// Local clock 1s behind, 20ms each way, 1ms in server
+			int64_t t1 = 100 * nsPerSecond;
+			int64_t t2 = t1 + nsPerSecond + 20000000;
+			int64_t t3 = t2 + 1000000;
+			int64_t t4 = t3 - nsPerSecond + 20000000;
+			auto sample = NtpSample::calculate(t1, t2, t3, t4);
+			REQUIRE_EQ(sample.offset, nsPerSecond);
+			REQUIRE_EQ(sample.delay, 40000000);
+
+			// Asymmetric path: offset error is half the difference
+			t4 += 10000000;
+			sample = NtpSample::calculate(t1, t2, t3, t4);
+			REQUIRE_EQ(sample.offset, nsPerSecond - 5000000);
+			REQUIRE_EQ(sample.delay, 50000000);
+		}
+	}
+};
+
+void REGISTER_TEST(Ntp)
+{
+	registerGroup<NtpTest>();
+}
@@ -0,0 +1,63 @@
+#include <HostTests.h>
+
+#include <Platform/TransmitScheduler.h>
+
+class TransmitSchedulerTest : public TestGroup
+{
+public:
+	TransmitSchedulerTest() : TestGroup(_F("TransmitScheduler"))
+	{
+	}
+
+	void execute() override
+	{
+		TEST_CASE("Window alignment")
+		{
+			// No alignment
+			REQUIRE_EQ(TransmitScheduler::getSendTime(1000, 5000, 0, 0), 5000U);
+
+			// Last window before deadline
+			REQUIRE_EQ(TransmitScheduler::getSendTime(1000, 5000, 900, 300), 4800U);
+			REQUIRE_EQ(TransmitScheduler::getSendTime(1000, 5100, 900, 300), 5100U);
+
+			// No window between now and deadline
+			REQUIRE_EQ(TransmitScheduler::getSendTime(1000, 1150, 900, 300), 1150U);
+
+			// Times wrap
+			REQUIRE_EQ(TransmitScheduler::getSendTime(0xffffff00, 0x200, 0xfffffe00, 0x100), 0x200U);
+			REQUIRE_EQ(TransmitScheduler::getSendTime(0xffffff00, 0x250, 0xfffffe00, 0x100), 0x200U);
+		}
+
+		TEST_CASE("Batching")
+		{
+			TransmitScheduler scheduler;
+			unsigned sent{0};
+			auto send = [&]() { ++sent; };
+
+			scheduler.schedule(send, 10000);
+			scheduler.schedule(send, 20000);
+			REQUIRE_EQ(scheduler.count(), 2U);
+			REQUIRE_EQ(sent, 0U);
+
+			// Urgent operation takes pending ones with it
+			scheduler.schedule(send, 0);
+			REQUIRE_EQ(scheduler.count(), 0U);
+			REQUIRE_EQ(sent, 3U);
+
+			// Full queue is sent early
+			for(unsigned i = 0; i <= TX_SCHEDULER_QUEUE_SIZE; ++i) {
+				scheduler.schedule(send, 10000);
+			}
+			REQUIRE_EQ(scheduler.count(), 1U);
+			REQUIRE_EQ(sent, 3U + TX_SCHEDULER_QUEUE_SIZE);
+
+			scheduler.flush();
+			REQUIRE_EQ(sent, 4U + TX_SCHEDULER_QUEUE_SIZE);
+		}
+	}
+};
+
+void REGISTER_TEST(TransmitScheduler)
+{
+	registerGroup<TransmitSchedulerTest>();
+}
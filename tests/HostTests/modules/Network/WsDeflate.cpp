@@ -0,0 +1,143 @@
+#include <HostTests.h>
+
+#include <Network/Http/Websocket/WsDeflate.h>
+#include <Data/Stream/MemoryDataStream.h>
+
+class WsDeflateTest : public TestGroup
+{
+public:
+	WsDeflateTest() : TestGroup(_F("WsDeflate"))
+	{
+	}
+
+	void execute() override
+	{
+		negotiationTests();
+		inflateTests();
+		roundTripTests();
+	}
+
+	void negotiationTests()
+	{
+		WsDeflateConfig client;
+		WsDeflateConfig server;
+		server.txWindowBits = 10;
+		WsDeflateConfig clientAgreed;
+		WsDeflateConfig serverAgreed;
+		String response;
+
+		TEST_CASE("Offer and accept")
+		{
+			String offer = WsDeflate::makeOffer(client);
+			REQUIRE(WsDeflate::acceptOffer(offer, server, serverAgreed, response));
+			REQUIRE(WsDeflate::parseResponse(response, client, clientAgreed));
+			REQUIRE_EQ(clientAgreed.txWindowBits, serverAgreed.rxWindowBits);
+			REQUIRE(serverAgreed.txWindowBits <= clientAgreed.rxWindowBits);
+		}
+
+		TEST_CASE("Select from several offers")
+		{
+			REQUIRE(WsDeflate::acceptOffer(F("x-webkit-deflate-frame, permessage-deflate; client_max_window_bits"),
+										   server, serverAgreed, response));
+			REQUIRE_EQ(serverAgreed.rxWindowBits, server.rxWindowBits);
+		}
+
+		TEST_CASE("Decline offers")
+		{
+			// Client would use a 32K window
+			REQUIRE(!WsDeflate::acceptOffer(F("permessage-deflate"), server, serverAgreed, response));
+			REQUIRE(!WsDeflate::acceptOffer(F("permessage-deflate; unknown"), server, serverAgreed, response));
+			REQUIRE(!WsDeflate::acceptOffer(F("permessage-deflate; client_max_window_bits=16"), server,
+											serverAgreed, response));
+		}
+
+		TEST_CASE("Reject invalid response")
+		{
+			// Server ignored requested window size
+			REQUIRE(!WsDeflate::parseResponse(F("permessage-deflate"), client, clientAgreed));
+			REQUIRE(!WsDeflate::parseResponse(F("permessage-deflate; server_max_window_bits=12"), client,
+											  clientAgreed));
+		}
+	}
+
+	void inflateTests()
+	{
+		// Examples from RFC 7692 section 7.2.3
+		WsInflater inflater(9, false, 256);
+		String output;
+		auto callback = [&](const char* data, size_t length) -> bool { return output.concat(data, length); };
+
+		TEST_CASE("Fixed Huffman block")
+		{
+			const uint8_t data[]{0xf2, 0x48, 0xcd, 0xc9, 0xc9, 0x07, 0x00};
+			REQUIRE(inflater.write(reinterpret_cast<const char*>(data), sizeof(data)));
+			REQUIRE(inflater.finish(callback));
+			REQUIRE(output == "Hello");
+		}
+
+		TEST_CASE("Context takeover")
+		{
+			const uint8_t data[]{0xf2, 0x00, 0x11, 0x00, 0x00};
+			output = "";
+			REQUIRE(inflater.write(reinterpret_cast<const char*>(data), sizeof(data)));
+			REQUIRE(inflater.finish(callback));
+			REQUIRE(output == "Hello");
+		}
+
+		TEST_CASE("Stored block")
+		{
+			const uint8_t data[]{0x00, 0x05, 0x00, 0xfa, 0xff, 0x48, 0x65, 0x6c, 0x6c, 0x6f, 0x00};
+			output = "";
+			REQUIRE(inflater.write(reinterpret_cast<const char*>(data), sizeof(data)));
+			REQUIRE(inflater.finish(callback));
+			REQUIRE(output == "Hello");
+		}
+
+		TEST_CASE("Invalid data")
+		{
+			const uint8_t data[]{0xff, 0xff, 0xff, 0xff};
+			REQUIRE(inflater.write(reinterpret_cast<const char*>(data), sizeof(data)));
+			REQUIRE(!inflater.finish(callback));
+		}
+	}
+
+	void roundTripTests()
+	{
+		String text;
+		for(unsigned i = 0; i < 100; ++i) {
+			text += F("{\"id\":");
+			text += i;
+			text += F(",\"value\":");
+			text += os_random() % 1000;
+			text += "},";
+		}
+
+		for(uint8_t windowBits = 8; windowBits <= 12; ++windowBits) {
+			TEST_CASE("Round trip")
+			{
+				debug_i("windowBits = %u", windowBits);
+				WsDeflater deflater(windowBits, false);
+				WsInflater inflater(windowBits, false, 4096);
+				for(unsigned i = 0; i < 3; ++i) {
+					MemoryDataStream compressed;
+					REQUIRE(deflater.compress(text.c_str(), text.length(), compressed));
+					debug_i("Compressed %u -> %u bytes", text.length(), compressed.available());
+					String data;
+					REQUIRE(compressed.moveString(data));
+					REQUIRE(data.length() < text.length());
+					REQUIRE(inflater.write(data.c_str(), data.length()));
+					String output;
+					REQUIRE(inflater.finish([&](const char* data, size_t length) -> bool {
+						return output.concat(data, length);
+					}));
+					REQUIRE(output == text);
+				}
+			}
+		}
+	}
+};
+
+void REGISTER_TEST(WsDeflate)
+{
+	registerGroup<WsDeflateTest>();
+}
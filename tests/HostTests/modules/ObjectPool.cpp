@@ -0,0 +1,103 @@
+#include <HostTests.h>
+
+#include <ObjectPool.h>
+#include <malloc_count.h>
+
+namespace
+{
+class PooledObject
+{
+public:
+	OBJECT_POOL_ALLOCATED(PooledObject, 4)
+
+	uint32_t data[10];
+};
+
+class LargerObject : public PooledObject
+{
+public:
+	uint32_t extra[10];
+};
+
+} // namespace
+
+class ObjectPoolTest : public TestGroup
+{
+public:
+	ObjectPoolTest() : TestGroup(_F("ObjectPool"))
+	{
+	}
+
+	void execute() override
+	{
+		auto& pool = PooledObject::getPool();
+		auto& stats = pool.getStats();
+
+		TEST_CASE("Allocate from pool")
+		{
+			PooledObject* objects[4];
+			for(auto& obj : objects) {
+				obj = new PooledObject;
+				REQUIRE(pool.contains(obj));
+			}
+			REQUIRE_EQ(stats.inUse, 4);
+			REQUIRE_EQ(stats.overflows, 0);
+
+			// Pool exhausted, so heap is used
+			auto overflow = new PooledObject;
+			REQUIRE(!pool.contains(overflow));
+			REQUIRE_EQ(stats.overflows, 1);
+			delete overflow;
+
+			for(auto obj : objects) {
+				delete obj;
+			}
+			REQUIRE_EQ(stats.inUse, 0);
+			REQUIRE_EQ(stats.peak, 4);
+		}
+
+		TEST_CASE("Heap unchanged")
+		{
+			auto heapUsed = MallocCount::getCurrent();
+			for(unsigned i = 0; i < 100; ++i) {
+				auto obj = new PooledObject;
+				delete obj;
+			}
+			REQUIRE_EQ(MallocCount::getCurrent(), heapUsed);
+		}
+
+		TEST_CASE("Derived class uses heap")
+		{
+			auto obj = new LargerObject;
+			REQUIRE(!pool.contains(obj));
+			delete obj;
+		}
+
+		TEST_CASE("Reserve")
+		{
+			auto obj = new PooledObject;
+			REQUIRE(!pool.reserve(8));
+			delete obj;
+			REQUIRE(pool.reserve(8));
+			REQUIRE_EQ(stats.capacity, 8);
+
+			pool.resetStats();
+			PooledObject* objects[8];
+			for(auto& obj : objects) {
+				obj = new PooledObject;
+			}
+			REQUIRE_EQ(stats.overflows, 0);
+			for(auto obj : objects) {
+				delete obj;
+			}
+			REQUIRE(pool.shrink());
+		}
+
+		ObjectPool::Pool::printAll(Serial);
+	}
+};
+
+void REGISTER_TEST(ObjectPool)
+{
+	registerGroup<ObjectPoolTest>();
+}
@@ -0,0 +1,104 @@
+#include <HostTests.h>
+#include <PulseCapture.h>
+#include <Digital.h>
+
+class PulseCaptureTest : public TestGroup
+{
+public:
+	PulseCaptureTest() : TestGroup(_F("PulseCapture"))
+	{
+	}
+
+	void execute() override
+	{
+		pinMode(testPin, OUTPUT);
+		digitalWrite(testPin, LOW);
+
+		TEST_CASE("Invalid parameters")
+		{
+			REQUIRE(!capture.begin(testPin, nullptr));
+			REQUIRE(!capture.isRunning());
+		}
+
+		TEST_CASE("Capture limit")
+		{
+			PulseCapture captures[PulseCapture::maxCaptures];
+			auto callback = [](const PulseCapture::Pulse*, size_t) {};
+			for(auto& c : captures) {
+				REQUIRE(c.begin(testPin + 1, callback));
+			}
+			REQUIRE(!capture.begin(testPin, callback));
+			captures[0].end();
+			REQUIRE(capture.begin(testPin, callback));
+			capture.end();
+		}
+
+		TEST_CASE("Buffer overflow")
+		{
+			REQUIRE(capture.begin(testPin, [](const PulseCapture::Pulse*, size_t) {}));
+			const unsigned edgeCount = 2 * PulseCapture::bufferSize;
+			for(unsigned i = 0; i < edgeCount; ++i) {
+				digitalWrite(testPin, (i & 1) ? LOW : HIGH);
+			}
+			auto& stats = capture.getStats();
+			debug_i("edges %u, overflows %u", stats.edges, stats.overflows);
+			REQUIRE(stats.overflows != 0);
+			REQUIRE_EQ(stats.edges + stats.overflows, edgeCount);
+			capture.end();
+		}
+
+		TEST_CASE("Pulse widths")
+		{
+			REQUIRE(capture.begin(testPin, [this](const PulseCapture::Pulse* pulses, size_t count) {
+				for(unsigned i = 0; i < count && pulseCount < ARRAY_SIZE(received); ++i) {
+					received[pulseCount++] = pulses[i];
+				}
+				if(pulseCount < ARRAY_SIZE(received)) {
+					return;
+				}
+				capture.end();
+				checkPulses();
+				complete();
+			}));
+			REQUIRE(capture.isRunning());
+			REQUIRE_EQ(capture.getPin(), testPin);
+
+			// First pulse is the idle period from begin()
+			uint8_t level{LOW};
+			for(auto width : widths) {
+				level = !level;
+				digitalWrite(testPin, level);
+				delayMicroseconds(width);
+			}
+			digitalWrite(testPin, !level);
+			pending();
+		}
+	}
+
+private:
+	void checkPulses()
+	{
+		for(unsigned i = 0; i < ARRAY_SIZE(widths); ++i) {
+			auto& pulse = received[i + 1];
+			debug_i("pulse %u: level %u, %u us", i, pulse.level, pulse.duration);
+			REQUIRE_EQ(pulse.level, (i & 1) ? LOW : HIGH);
+			REQUIRE(pulse.duration >= widths[i]);
+			REQUIRE(pulse.duration < widths[i] + 10000);
+		}
+		REQUIRE_EQ(received[0].level, LOW);
+		REQUIRE_EQ(capture.getStats().overflows, 0);
+	}
+
+	static constexpr uint16_t testPin{5};
+	static constexpr uint32_t widths[]{2000, 5000, 1000, 3000};
+	PulseCapture capture;
+	PulseCapture::Pulse received[ARRAY_SIZE(widths) + 1]{};
+	unsigned pulseCount{0};
+};
+
+constexpr uint32_t PulseCaptureTest::widths[];
+
+void REGISTER_TEST(PulseCapture)
+{
+	registerGroup<PulseCaptureTest>();
+}
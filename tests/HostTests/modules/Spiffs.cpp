@@ -1,5 +1,6 @@
 #include <HostTests.h>
 #include <Storage.h>
+#include <IFS/SPIFFS/FileSystem.h>
 
 #ifdef ARCH_HOST
 #include <Storage/FileDevice.h>
@@ -25,6 +26,21 @@ public:
 		{
 			cycleFlash();
 		}
+
+		TEST_CASE("Object index")
+		{
+			objectIndex();
+		}
+
+		TEST_CASE("Garbage collection")
+		{
+			garbageCollection();
+		}
+
+		TEST_CASE("Stale index")
+		{
+			staleIndex();
+		}
 	}
 
 	/*
@@ -72,6 +88,183 @@ public:
 		REQUIRE(testContent == content);
 	}
 
+	/*
+	 * Re-opening a file should use the cached location, and stale entries must be detected
+	 */
+	void objectIndex()
+	{
+		fileFreeFileSystem();
+		auto part = *Storage::findPartition(Storage::Partition::SubType::Data::spiffs);
+		auto fs = new IFS::SPIFFS::FileSystem(part);
+		int err = fs->mount();
+		if(err < 0) {
+			debug_e("SPIFFS mount failed: %s", fs->getErrorString(err).c_str());
+			delete fs;
+			TEST_ASSERT(false);
+			return;
+		}
+		fileSetFileSystem(fs);
+		auto& stats = fs->getIndexStats();
+
+		DEFINE_FSTR_LOCAL(content1, "First file content");
+		DEFINE_FSTR_LOCAL(content2, "Second file content");
+		fileSetContent("index1", content1);
+		fileSetContent("index2", content2);
+		auto hits = stats.hits;
+		CHECK(content1 == fileGetContent("index1"));
+		CHECK(content2 == fileGetContent("index2"));
+		CHECK(content1 == fileGetContent("index1"));
+		CHECK_EQ(stats.hits - hits, 3);
+
+		// File header moves when content changes
+		fileSetContent("index1", content2);
+		CHECK(content2 == fileGetContent("index1"));
+
+		auto checkMissing = [](const char* name) {
+			auto f = fileOpen(name);
+			CHECK(f < 0);
+			if(f >= 0) {
+				fileClose(f);
+			}
+		};
+
+		CHECK(fileRename("index1", "index3") >= 0);
+		checkMissing("index1");
+		CHECK(content2 == fileGetContent("index3"));
+
+		CHECK(fileDelete("index2") >= 0);
+		checkMissing("index2");
+
+		debug_i("Index hits %u, misses %u, stale %u", stats.hits, stats.misses, stats.stale);
+
+		fileDelete("index3");
+		fileFreeFileSystem();
+		spiffs_mount();
+	}
+
+	/*
+	 * Repeated re-writes leave blocks containing only deleted pages, which gcStep() should reclaim
+	 */
+	void garbageCollection()
+	{
+		fileFreeFileSystem();
+		auto part = *Storage::findPartition(Storage::Partition::SubType::Data::spiffs);
+		auto fs = new IFS::SPIFFS::FileSystem(part);
+		int err = fs->mount();
+		if(err < 0) {
+			debug_e("SPIFFS mount failed: %s", fs->getErrorString(err).c_str());
+			delete fs;
+			TEST_ASSERT(false);
+			return;
+		}
+		fileSetFileSystem(fs);
+
+		IFS::SPIFFS::FileSystem::GcInfo before;
+		REQUIRE(fs->getGcInfo(before) >= 0);
+		uint32_t pagesPerBlock = before.totalPages / before.blockCount;
+		String content;
+		for(unsigned i = 0; i < 100; ++i) {
+			content += "0123456789";
+		}
+		for(unsigned i = 0; i < 1000 && before.deletedPages < 2 * pagesPerBlock; ++i) {
+			REQUIRE(fileSetContent("gctest", content) == int(content.length()));
+			fs->getGcInfo(before);
+		}
+		debug_i("Pages: total %u, used %u, deleted %u; blocks free %u", before.totalPages, before.usedPages,
+				before.deletedPages, before.freeBlocks);
+
+		unsigned reclaimed{0};
+		int res;
+		while((res = fs->gcStep(false)) > 0) {
+			reclaimed += res;
+		}
+		CHECK_EQ(res, 0);
+
+		IFS::SPIFFS::FileSystem::GcInfo after;
+		REQUIRE(fs->getGcInfo(after) >= 0);
+		debug_i("Reclaimed %u blocks, deleted pages now %u", reclaimed, after.deletedPages);
+		CHECK(reclaimed > 0);
+		CHECK(after.freeBlocks == before.freeBlocks + reclaimed);
+		CHECK(after.deletedPages < before.deletedPages);
+		CHECK(content == fileGetContent("gctest"));
+
+		fileDelete("gctest");
+		fileFreeFileSystem();
+		spiffs_mount();
+	}
+
+	/*
+	 * Garbage collection moves file headers without updating the object index.
+	 * Re-opening with truncation must only ever affect the requested file,
+	 * even if its old header page now belongs to another one.
+	 */
+	void staleIndex()
+	{
+		fileFreeFileSystem();
+		auto part = *Storage::findPartition(Storage::Partition::SubType::Data::spiffs);
+		auto fs = new IFS::SPIFFS::FileSystem(part);
+		int err = fs->mount();
+		if(err < 0) {
+			debug_e("SPIFFS mount failed: %s", fs->getErrorString(err).c_str());
+			delete fs;
+			TEST_ASSERT(false);
+			return;
+		}
+		fileSetFileSystem(fs);
+		auto& stats = fs->getIndexStats();
+		auto stale = stats.stale;
+
+		DEFINE_FSTR_LOCAL(content, "Content which must survive truncation of another file");
+		const unsigned fileCount{8};
+		auto victimName = [](unsigned i) { return "victim" + String(i); };
+
+		// Index file and create others interleaved with it
+		REQUIRE(fileSetContent("stale", content) == int(content.length()));
+		CHECK(content == fileGetContent("stale"));
+		for(unsigned i = 0; i < fileCount; ++i) {
+			REQUIRE(fileSetContent(victimName(i), content) == int(content.length()));
+		}
+
+		// Delete half the files and re-write the rest so blocks are mostly deleted pages
+		String churn;
+		for(unsigned i = 0; i < 50; ++i) {
+			churn += "0123456789";
+		}
+		for(unsigned i = 0; i < fileCount; i += 2) {
+			CHECK(fileDelete(victimName(i)) >= 0);
+		}
+		for(unsigned i = 0; i < 100; ++i) {
+			REQUIRE(fileSetContent("churn", churn) == int(churn.length()));
+		}
+		CHECK(fileDelete("churn") >= 0);
+
+		// Clean every block we can, moving live pages
+		while(fs->gcStep(true) > 0) {
+		}
+
+		// Re-create deleted files, which may now occupy old header pages
+		for(unsigned i = 0; i < fileCount; i += 2) {
+			REQUIRE(fileSetContent(victimName(i), content) == int(content.length()));
+		}
+
+		auto file = fileOpen("stale", File::WriteOnly | File::Truncate);
+		REQUIRE(file >= 0);
+		fileClose(file);
+		CHECK_EQ(fileGetSize("stale"), 0);
+		for(unsigned i = 0; i < fileCount; ++i) {
+			CHECK(content == fileGetContent(victimName(i)));
+		}
+
+		debug_i("Stale index entries detected: %u", stats.stale - stale);
+
+		fileDelete("stale");
+		for(unsigned i = 0; i < fileCount; ++i) {
+			fileDelete(victimName(i));
+		}
+		fileFreeFileSystem();
+		spiffs_mount();
+	}
+
 #ifdef ARCH_HOST
 	/*
 	 * Verify that a legacy volume (i.e. one generated with spiffy before IFS was introduced)
@@ -0,0 +1,98 @@
+#include <HostTests.h>
+#include <Data/Buffer/SpscRing.h>
+
+class SpscRingTest : public TestGroup
+{
+public:
+	SpscRingTest() : TestGroup(_F("SpscRing"))
+	{
+	}
+
+	void execute() override
+	{
+		TEST_CASE("push and pop")
+		{
+			SpscRing<uint16_t, 4> ring;
+			REQUIRE(ring.isEmpty());
+			REQUIRE_EQ(ring.space(), 4);
+			for(uint16_t i = 0; i < 4; ++i) {
+				REQUIRE(ring.push(i));
+			}
+			REQUIRE(!ring.push(99));
+			REQUIRE_EQ(ring.available(), 4);
+			uint16_t value;
+			REQUIRE(ring.pop(value));
+			REQUIRE_EQ(value, 0);
+			REQUIRE(ring.push(4));
+			for(uint16_t i = 1; i <= 4; ++i) {
+				REQUIRE(ring.pop(value));
+				REQUIRE_EQ(value, i);
+			}
+			REQUIRE(!ring.pop(value));
+		}
+
+		TEST_CASE("bulk read and write across wrap")
+		{
+			SpscRing<uint8_t, 8> ring;
+			const uint8_t data[]{1, 2, 3, 4, 5, 6, 7, 8, 9, 10};
+			uint8_t out[10]{};
+
+			REQUIRE_EQ(ring.write(data, 5), 5);
+			REQUIRE_EQ(ring.read(out, 5), 5);
+			REQUIRE(memcmp(out, data, 5) == 0);
+
+			// Free space is now split across the end of the buffer
+			REQUIRE_EQ(ring.write(data, 10), 8);
+			REQUIRE_EQ(ring.space(), 0);
+
+			const uint8_t* span;
+			REQUIRE_EQ(ring.getReadSpan(span), 3);
+			REQUIRE_EQ(span[0], 1);
+			ring.consume(3);
+			REQUIRE_EQ(ring.read(out, 10), 5);
+			REQUIRE(memcmp(out, &data[3], 5) == 0);
+			REQUIRE(ring.isEmpty());
+		}
+
+		TEST_CASE("notify once per batch")
+		{
+			using Ring = SpscRing<uint32_t, 16>;
+			static Ring ring;
+			static unsigned notifyCount;
+			static uint32_t total;
+			notifyCount = 0;
+			total = 0;
+
+			ring.setNotify(
+				[](void* param) {
+					auto& ring = *static_cast<Ring*>(param);
+					++notifyCount;
+					uint32_t value;
+					while(ring.pop(value)) {
+						total += value;
+					}
+				},
+				&ring);
+
+			for(uint32_t batch = 0; batch < 3; ++batch) {
+				for(uint32_t i = 1; i <= 4; ++i) {
+					REQUIRE(ring.push(i));
+				}
+				REQUIRE(ring.notify());
+			}
+
+			System.queueCallback([this]() {
+				REQUIRE_EQ(notifyCount, 1);
+				REQUIRE_EQ(total, 30);
+				REQUIRE(ring.isEmpty());
+				complete();
+			});
+			pending();
+		}
+	}
+};
+
+void REGISTER_TEST(SpscRing)
+{
+	registerGroup<SpscRingTest>();
+}
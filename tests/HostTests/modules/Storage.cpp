@@ -1,6 +1,9 @@
 #include <HostTests.h>
 #include <Storage.h>
 #include <Storage/Debug.h>
+#include <Storage/CachedDevice.h>
+#include <Storage/SysMem.h>
+#include <Storage/PartitionStream.h>
 
 class TestDevice : public Storage::Device
 {
@@ -59,6 +62,24 @@ public:
 		listPartitions();
 
 		delete dev;
+
+		TEST_CASE("Mapped access")
+		{
+			static const char content[]{"Partition content accessed directly"};
+			auto addr = reinterpret_cast<uint32_t>(content);
+			auto part = Storage::sysMem.createPartition(F("mapped"), Storage::Partition::Type::data, 0, addr,
+														sizeof(content), Storage::Partition::Flag::readOnly);
+			REQUIRE(part.getMappedPointer(10, 7) == &content[10]);
+			REQUIRE(part.getMappedPointer(10, sizeof(content)) == nullptr);
+
+			Storage::PartitionStream stream(part);
+			REQUIRE(stream.readString(sizeof(content)) == String(content, sizeof(content)));
+
+			// Writable partitions are never mapped
+			auto writable = Storage::sysMem.createPartition(F("writable"), Storage::Partition::Type::data, 0, addr,
+															sizeof(content));
+			REQUIRE(writable.getMappedPointer(0, 1) == nullptr);
+		}
 	}
 
 	void listPartitions()
@@ -90,7 +111,186 @@ public:
 	}
 };
 
+/*
+ * RAM-backed device which counts accesses
+ */
+class RamDevice : public Storage::Device
+{
+public:
+	static constexpr size_t size{16384};
+	static constexpr size_t blockSize{4096};
+
+	RamDevice(Type type) : type(type)
+	{
+		memset(data, 0xff, size);
+	}
+
+	String getName() const override
+	{
+		return F("ramDevice");
+	}
+
+	size_t getBlockSize() const override
+	{
+		return blockSize;
+	}
+
+	size_t getSize() const override
+	{
+		return size;
+	}
+
+	Type getType() const override
+	{
+		return type;
+	}
+
+	bool read(uint32_t address, void* dst, size_t len) override
+	{
+		if(address + len > size) {
+			return false;
+		}
+		++reads;
+		memcpy(dst, &data[address], len);
+		return true;
+	}
+
+	bool write(uint32_t address, const void* src, size_t len) override
+	{
+		if(address + len > size) {
+			return false;
+		}
+		++writes;
+		auto p = static_cast<const uint8_t*>(src);
+		for(unsigned i = 0; i < len; ++i) {
+			data[address + i] = (type == Type::flash) ? (data[address + i] & p[i]) : p[i];
+		}
+		return true;
+	}
+
+	bool erase_range(uint32_t address, size_t len) override
+	{
+		if(address + len > size) {
+			return false;
+		}
+		memset(&data[address], 0xff, len);
+		return true;
+	}
+
+	uint8_t data[size];
+	unsigned reads{0};
+	unsigned writes{0};
+
+private:
+	Type type;
+};
+
+class CachedDeviceTest : public TestGroup
+{
+public:
+	CachedDeviceTest() : TestGroup(_F("CachedDevice"))
+	{
+	}
+
+	void execute() override
+	{
+		TEST_CASE("Read caching")
+		{
+			RamDevice ram(Storage::Device::Type::unknown);
+			for(unsigned i = 0; i < ram.size; ++i) {
+				ram.data[i] = i * 13;
+			}
+			Storage::CachedDevice cache(ram, 256, 4, 0);
+			uint8_t buf[32];
+			for(unsigned i = 0; i < 8; ++i) {
+				REQUIRE(cache.read(100 + i * 16, buf, sizeof(buf)));
+				REQUIRE(memcmp(buf, &ram.data[100 + i * 16], sizeof(buf)) == 0);
+			}
+			REQUIRE_EQ(ram.reads, 1);
+			REQUIRE_EQ(cache.getStats().misses, 1);
+
+			// Whole lines bypass the cache
+			uint8_t big[1024];
+			REQUIRE(cache.read(1024, big, sizeof(big)));
+			REQUIRE(memcmp(big, &ram.data[1024], sizeof(big)) == 0);
+			REQUIRE_EQ(ram.reads, 2);
+		}
+
+		TEST_CASE("Read ahead")
+		{
+			RamDevice ram(Storage::Device::Type::unknown);
+			Storage::CachedDevice cache(ram, 256, 4, 1);
+			uint8_t buf[16];
+			for(unsigned addr = 0; addr < 1024; addr += sizeof(buf)) {
+				REQUIRE(cache.read(addr, buf, sizeof(buf)));
+			}
+			auto& stats = cache.getStats();
+			debug_i("hits %u, misses %u, readAheads %u", stats.hits, stats.misses, stats.readAheads);
+			REQUIRE(stats.readAheads != 0);
+			REQUIRE(stats.misses < 4);
+		}
+
+		TEST_CASE("Write back")
+		{
+			RamDevice ram(Storage::Device::Type::flash);
+			{
+				Storage::CachedDevice cache(ram, 256, 2);
+				uint8_t buf[8];
+				for(unsigned i = 0; i < 32; ++i) {
+					memset(buf, i, sizeof(buf));
+					REQUIRE(cache.write(i * sizeof(buf), buf, sizeof(buf)));
+				}
+				REQUIRE_EQ(ram.writes, 0);
+
+				// Cached data reflects flash semantics
+				uint8_t val{0x0f};
+				REQUIRE(cache.write(0, &val, 1));
+				REQUIRE(cache.read(0, &val, 1));
+				REQUIRE_EQ(val, 0);
+
+				REQUIRE(cache.flush());
+				REQUIRE_EQ(ram.writes, 1);
+				REQUIRE_EQ(ram.data[255], 31);
+
+				// Erase discards cached data
+				REQUIRE(cache.write(300, buf, 4));
+				REQUIRE(cache.erase_range(0, ram.blockSize));
+				REQUIRE(cache.flush());
+				REQUIRE_EQ(ram.writes, 1);
+				REQUIRE_EQ(ram.data[300], 0xff);
+
+				// Destructor flushes
+				REQUIRE(cache.write(4096, buf, 4));
+			}
+			REQUIRE_EQ(ram.writes, 2);
+			REQUIRE_EQ(ram.data[4096], 31);
+		}
+
+		TEST_CASE("Async read")
+		{
+			asyncDevice.reset(new RamDevice(Storage::Device::Type::unknown));
+			for(unsigned i = 0; i < sizeof(asyncBuffer); ++i) {
+				asyncDevice->data[1000 + i] = i;
+			}
+			REQUIRE(asyncDevice->readAsync(1000, asyncBuffer, sizeof(asyncBuffer), [this](bool success) {
+				REQUIRE(success);
+				for(unsigned i = 0; i < sizeof(asyncBuffer); ++i) {
+					REQUIRE_EQ(asyncBuffer[i], i);
+				}
+				asyncDevice.reset();
+				complete();
+			}));
+			pending();
+		}
+	}
+
+private:
+	std::unique_ptr<RamDevice> asyncDevice;
+	uint8_t asyncBuffer[64];
+};
+
 void REGISTER_TEST(Storage)
 {
 	registerGroup<PartitionTest>();
+	registerGroup<CachedDeviceTest>();
 }
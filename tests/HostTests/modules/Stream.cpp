@@ -4,6 +4,10 @@
 #include <Data/Stream/LimitedMemoryStream.h>
 #include <Data/Stream/XorOutputStream.h>
 #include <Data/Stream/SharedMemoryStream.h>
+#include <Data/Stream/StreamChain.h>
+#include <Data/Stream/WriteBehindStream.h>
+#include <Data/Stream/JsonWriterStream.h>
+#include <Data/JsonStreamParser.h>
 #include <Data/WebHelpers/base64.h>
 #include <malloc_count.h>
 
@@ -54,6 +58,59 @@ public:
 			REQUIRE(strlen(s.c_str()) == s.length());
 		}
 
+		TEST_CASE("MemoryDataStream with MemoryClass::Bulk")
+		{
+			MemoryDataStream stream(UINT16_MAX, MemoryClass::Bulk);
+			for(unsigned i = 0; i < 8; ++i) {
+				REQUIRE_EQ(stream.print(FS_abstract), FS_abstract.length());
+			}
+			REQUIRE_EQ(size_t(stream.available()), 8 * FS_abstract.length());
+			REQUIRE(stream.getCapacity() >= Memory::getBulkThreshold());
+			String s;
+			REQUIRE(stream.moveString(s));
+			REQUIRE(s.startsWith(FS_abstract));
+		}
+
+		TEST_CASE("Segmented MemoryDataStream")
+		{
+			MemoryDataStream stream;
+			REQUIRE(stream.setSegmented(true));
+			String content;
+			for(unsigned i = 0; i < 8; ++i) {
+				content += FS_abstract;
+			}
+			for(unsigned offset = 0; offset < content.length(); offset += 37) {
+				auto len = std::min(size_t(37), content.length() - offset);
+				REQUIRE_EQ(stream.write(&content[offset], len), len);
+			}
+			REQUIRE_EQ(stream.getSize(), content.length());
+			REQUIRE(stream.getCapacity() >= content.length());
+			REQUIRE(stream.getCapacity() < content.length() + MEMORY_STREAM_SEGMENT_SIZE);
+			REQUIRE(!stream.setSegmented(false));
+
+			// Blocks are limited to one segment
+			String out;
+			size_t length;
+			const char* ptr;
+			while((ptr = stream.peekBlock(length)) != nullptr && length != 0) {
+				REQUIRE(length < MEMORY_STREAM_SEGMENT_SIZE);
+				out.concat(ptr, length);
+				stream.seek(length);
+			}
+			REQUIRE(out == content);
+
+			// Reads span segments
+			stream.seekFrom(100, SeekOrigin::Start);
+			char buffer[1200];
+			REQUIRE_EQ(stream.readMemoryBlock(buffer, sizeof(buffer)), sizeof(buffer));
+			REQUIRE(memcmp(buffer, &content[100], sizeof(buffer)) == 0);
+
+			String s;
+			REQUIRE(stream.moveString(s));
+			REQUIRE(s == content);
+			REQUIRE_EQ(stream.getSize(), 0U);
+		}
+
 		TEST_CASE("LimitedMemoryStream::moveString (1)")
 		{
 			FSTR::Stream src(FS_abstract);
@@ -90,6 +147,74 @@ public:
 			REQUIRE(s == FS_abstract);
 		}
 
+		TEST_CASE("peekBlock")
+		{
+			String content(FS_abstract);
+			MemoryDataStream stream;
+			stream.print(content);
+			size_t length;
+			auto ptr = stream.peekBlock(length);
+			REQUIRE(ptr != nullptr);
+			REQUIRE_EQ(length, content.length());
+			REQUIRE(memcmp(ptr, content.c_str(), length) == 0);
+			stream.seek(10);
+			REQUIRE(stream.peekBlock(length) == ptr + 10);
+			REQUIRE_EQ(length, content.length() - 10);
+
+			FSTR::Stream src(FS_abstract);
+			REQUIRE(src.peekBlock(length) == nullptr);
+			REQUIRE_EQ(length, 0);
+		}
+
+		TEST_CASE("StreamChain vectored read")
+		{
+			DEFINE_FSTR_LOCAL(FS_part3, "[flash]");
+			StreamChain chain;
+			chain.attachStream(new MemoryDataStream(String(F("Header: "))));
+			chain.attachStream(new MemoryDataStream(String(F("body text"))));
+			chain.attachStream(new FSTR::Stream(FS_part3));
+			chain.attachStream(new MemoryDataStream(String(F(" trailer"))));
+
+			// Blocks span memory streams, stopping at one which needs copying
+			IDataSourceStream::Block blocks[4];
+			auto count = chain.peekBlocks(blocks, ARRAY_SIZE(blocks), 100);
+			REQUIRE_EQ(count, 2U);
+			REQUIRE(F("Header: ") == String(blocks[0].data, blocks[0].length));
+			REQUIRE(F("body text") == String(blocks[1].data, blocks[1].length));
+
+			// Limited by length
+			count = chain.peekBlocks(blocks, ARRAY_SIZE(blocks), 10);
+			REQUIRE_EQ(count, 2U);
+			REQUIRE_EQ(blocks[1].length, 2U);
+
+			// Seek and read across stream boundaries
+			REQUIRE(chain.seek(10));
+			char buffer[32];
+			auto len = chain.readMemoryBlock(buffer, sizeof(buffer));
+			REQUIRE(F("dy text[flash] trailer") == String(buffer, len));
+			REQUIRE(chain.seek(len));
+			REQUIRE_EQ(chain.readMemoryBlock(buffer, sizeof(buffer)), 0);
+			REQUIRE(chain.isFinished());
+		}
+
+		TEST_CASE("StreamChain pending length")
+		{
+			DEFINE_FSTR_LOCAL(FS_part, "[flash]");
+			StreamChain chain;
+			REQUIRE_EQ(chain.getPendingLength(), 0U);
+			chain.attachStream(new MemoryDataStream(String(F("Header: "))));
+			chain.attachStream(new FSTR::Stream(FS_part));
+			REQUIRE_EQ(chain.getPendingLength(), 15U);
+
+			// Consumed data is no longer pending
+			REQUIRE(chain.seek(10));
+			REQUIRE_EQ(chain.getPendingLength(), 5U);
+			chain.attachStream(new MemoryDataStream(String(F(" trailer"))));
+			REQUIRE_EQ(chain.getPendingLength(), 13U);
+			REQUIRE(chain.seek(13));
+			REQUIRE_EQ(chain.getPendingLength(), 0U);
+		}
+
 #ifndef DISABLE_NETWORK
 
 		TEST_CASE("ChunkedStream / StreamTransformer")
@@ -105,6 +230,22 @@ public:
 			REQUIRE(FS_OUTPUT == s);
 		}
 
+		TEST_CASE("ChunkedStream sized to buffer")
+		{
+			DEFINE_FSTR_LOCAL(FS_OUTPUT, "5\r\nSome \r\n5\r\ntest \r\n4\r\ndata\r\n0\r\n\r\n");
+			ChunkedStream chunked(new MemoryDataStream(String(F("Some test data"))));
+			String s;
+			while(!chunked.isFinished()) {
+				// Chunk size is determined by read buffer, and partial reads must resume correctly
+				char buffer[13];
+				auto len = chunked.readMemoryBlock(buffer, sizeof(buffer));
+				auto consumed = std::min(len, uint16_t(7));
+				s.concat(buffer, consumed);
+				chunked.seek(consumed);
+			}
+			REQUIRE(FS_OUTPUT == s);
+		}
+
 		TEST_CASE("MultipartStream / MultiStream")
 		{
 			unsigned itemIndex{0};
@@ -132,8 +273,172 @@ public:
 			REQUIRE(mem.moveString(s));
 			REQUIRE(Resource::multipart_result == s);
 		}
+
+		TEST_CASE("MultipartStream with fixed parts")
+		{
+			MultipartStream::Part parts[]{
+				{nullptr, new FSTR::Stream(template1)},	{nullptr, new FSTR::Stream(template1_1)},
+				{nullptr, new FSTR::Stream(template1_2)}, {nullptr, new FSTR::Stream(template2)},
+				{nullptr, new FSTR::Stream(template2_1)},
+			};
+			MultipartStream multi(parts, ARRAY_SIZE(parts));
+			auto boundary = const_cast<char*>(multi.getBoundary());
+			memcpy(boundary, "oALsXuO7vSbrvve", 16);
+
+			MemoryDataStream mem;
+			mem.copyFrom(&multi);
+			String s;
+			REQUIRE(mem.moveString(s));
+			REQUIRE(Resource::multipart_result == s);
+		}
 #endif
 
+		TEST_CASE("JsonWriterStream")
+		{
+			unsigned index{0};
+			JsonWriterStream json(
+				[&index](JsonWriterStream& writer) -> bool {
+					if(index == 0) {
+						writer.beginObject();
+						writer.member("name", "Quote \" and \\ backslash\r\n\x01");
+						writer.member("enabled", true);
+						writer.name("none");
+						writer.nullValue();
+						writer.member("value", 12.5);
+						writer.member("count", -5);
+						writer.beginArray("items");
+					}
+					if(index < 20) {
+						writer.beginObject();
+						writer.member("index", index);
+						writer.member("size", 1000000000ULL * index);
+						writer.endObject();
+						++index;
+						return true;
+					}
+					// Remaining array and object are closed automatically
+					return false;
+				},
+				64);
+
+			MemoryDataStream output;
+			output.copyFrom(&json);
+			REQUIRE(json.isFinished());
+			REQUIRE_EQ(json.getDepth(), 0);
+			String s;
+			REQUIRE(output.moveString(s));
+
+			String expected = F("{\"name\":\"Quote \\\" and \\\\ backslash\\r\\n\\u0001\",\"enabled\":true,"
+								"\"none\":null,\"value\":12.50,\"count\":-5,\"items\":[");
+			for(unsigned i = 0; i < 20; ++i) {
+				if(i != 0) {
+					expected += ',';
+				}
+				expected += F("{\"index\":");
+				expected += i;
+				expected += F(",\"size\":");
+				expected += 1000000000ULL * i;
+				expected += '}';
+			}
+			expected += "]}";
+			REQUIRE_EQ(s, expected);
+		}
+
+		TEST_CASE("JsonStreamParser")
+		{
+			String log;
+			JsonStreamParser parser([&log](const JsonStreamParser::Element& element) -> bool {
+				log += element.path;
+				switch(element.type) {
+				case JsonStreamParser::Type::ObjectStart:
+					log += '{';
+					break;
+				case JsonStreamParser::Type::ObjectEnd:
+					log += '}';
+					break;
+				case JsonStreamParser::Type::ArrayStart:
+					log += '[';
+					break;
+				case JsonStreamParser::Type::ArrayEnd:
+					log += ']';
+					break;
+				case JsonStreamParser::Type::Null:
+					log += "=null";
+					break;
+				default:
+					log += '=';
+					log += element.toString();
+				}
+				log += ';';
+				return true;
+			});
+
+			String doc = F(" {\"wifi\": {\"ssid\":\"My \\\"net\\\"\\u00e9\\ud83d\\ude00\", \"on\":true},"
+						   "\"a/b~c\":[1, -2.5e3, [], {}, null, false]} ");
+			// Feed in small pieces to check state is retained between calls
+			for(unsigned i = 0; i < doc.length(); i += 3) {
+				REQUIRE(parser.parse(doc.c_str() + i, std::min(size_t(3), doc.length() - i)));
+			}
+			REQUIRE(parser.finish());
+
+			String expected = F("{;/wifi{;/wifi/ssid=My \"net\"\xc3\xa9\xf0\x9f\x98\x80;/wifi/on=true;/wifi};"
+								"/a~1b~0c[;/a~1b~0c/0=1;/a~1b~0c/1=-2.5e3;/a~1b~0c/2[;/a~1b~0c/2];"
+								"/a~1b~0c/3{;/a~1b~0c/3};/a~1b~0c/4=null;/a~1b~0c/5=false;/a~1b~0c];};");
+			REQUIRE_EQ(log, expected);
+
+			auto check = [&parser](const String& text, JsonStreamParser::Error error) {
+				parser.reset();
+				parser.parse(text.c_str(), text.length());
+				parser.finish();
+				return parser.getError() == error;
+			};
+
+			REQUIRE(check("123", JsonStreamParser::Error::None));
+			REQUIRE(check("{\"a\":1,}", JsonStreamParser::Error::Syntax));
+			REQUIRE(check("[1 2]", JsonStreamParser::Error::Syntax));
+			REQUIRE(check("[1}", JsonStreamParser::Error::Syntax));
+			REQUIRE(check("[tru]", JsonStreamParser::Error::Syntax));
+			REQUIRE(check("{\"a\":[1,2]", JsonStreamParser::Error::Incomplete));
+			REQUIRE(check("[[[[[[[[[]]]]]]]]]", JsonStreamParser::Error::Depth));
+			String longString = "\"";
+			for(unsigned i = 0; i <= JSON_PARSER_MAX_TOKEN; ++i) {
+				longString += 'x';
+			}
+			longString += '"';
+			REQUIRE(check(longString, JsonStreamParser::Error::TokenLength));
+		}
+
+		TEST_CASE("WriteBehindStream")
+		{
+			auto mem = new MemoryDataStream();
+			WriteBehindStream stream(mem, 8, 2);
+			String input = "0123456789abcdefghijklmnopqrstuvwxyz";
+
+			REQUIRE(stream.write(input.c_str(), 5) == 5);
+			REQUIRE_EQ(mem->available(), 0);
+			REQUIRE(stream.getPending() == 5);
+
+			// Buffer fills, so oldest blocks get written immediately
+			REQUIRE(stream.write(input.c_str() + 5, 20) == 20);
+			REQUIRE_EQ(mem->available(), 16);
+			REQUIRE(stream.getPending() == 9);
+			REQUIRE(stream.getStats().stalls == 1);
+
+			REQUIRE(stream.write(input.c_str() + 25, input.length() - 25) == input.length() - 25);
+			stream.flush();
+			REQUIRE(stream.getPending() == 0);
+			REQUIRE(stream.getStats().bytesWritten == input.length());
+
+			String output(mem->getStreamPointer(), mem->available());
+			REQUIRE_EQ(output, input);
+			mem->seek(mem->available());
+
+			// Data written after a flush follows on
+			REQUIRE(stream.write("ABC", 3) == 3);
+			stream.flush();
+			REQUIRE_EQ(mem->available(), 3);
+		}
+
 		TEST_CASE("XorOutputStream")
 		{
 			auto mem = new MemoryDataStream();
@@ -16,6 +16,7 @@ public:
 
 		testString();
 		testMakeHexString();
+		testNumberConversion();
 	}
 
 	template <typename T> void templateTest(T x)
@@ -165,6 +166,60 @@ public:
 		REQUIRE(makeHexString(hwaddr, 7, ':') == F("aa:bb:cc:dd:12:55:00"));
 		REQUIRE(makeHexString(hwaddr, 1, ':') == F("aa"));
 		REQUIRE(makeHexString(hwaddr, 0, ':') == String::empty);
+
+		char buf[16];
+		REQUIRE(hexEncode(hwaddr, 7, buf) == &buf[14]);
+		REQUIRE(String(buf, 14) == F("aabbccdd125500"));
+		uint8_t bin[7];
+		REQUIRE_EQ(hexDecode("AABBccdd125500", 14, bin), 7);
+		REQUIRE(memcmp(bin, hwaddr, 7) == 0);
+		REQUIRE_EQ(hexDecode("aabbc", 5, bin), -1);
+		REQUIRE_EQ(hexDecode("aabbcg", 6, bin), -1);
+	}
+
+	void testNumberConversion()
+	{
+		char buf[DTOA_SHORTEST_BUFSIZE];
+
+		TEST_CASE("integer conversion")
+		{
+			REQUIRE_EQ(String(ultoa_wp(0, buf, 10, 0, ' ')), "0");
+			REQUIRE_EQ(String(ultoa_wp(4294967295UL, buf, 10, 12, '0')), "004294967295");
+			REQUIRE_EQ(String(ltoa_wp(-2147483647L - 1, buf, 10, 0, ' ')), "-2147483648");
+			REQUIRE_EQ(String(ulltoa_wp(18446744073709551615ULL, buf, 10, 0, ' ')), "18446744073709551615");
+			REQUIRE_EQ(String(lltoa_wp(-9223372036854775807LL - 1, buf, 10, 0, ' ')), "-9223372036854775808");
+			REQUIRE_EQ(String(ultoa_wp(0xdeadbeef, buf, 16, 0, ' ')), "deadbeef");
+			REQUIRE_EQ(String(ultoa_wp(255, buf, 2, 10, ' ')), "  11111111");
+			REQUIRE_EQ(String(ultoa_wp(255, buf, 7, 0, ' ')), "513");
+		}
+
+		TEST_CASE("shortest float conversion")
+		{
+			auto check = [&](double value, const char* expected) {
+				size_t len = dtoa_shortest(value, buf);
+				REQUIRE_EQ(String(buf, len), expected);
+			};
+			check(0, "0");
+			check(0.1, "0.1");
+			check(-12.5, "-12.5");
+			check(1.0 / 3, "0.3333333333333333");
+			check(1e21, "1e+21");
+			check(1e-7, "1e-7");
+			check(1.7976931348623157e308, "1.7976931348623157e+308");
+			check(NAN, "nan");
+
+			REQUIRE_EQ(String(buf, ftoa_shortest(0.1f, buf)), "0.1");
+			REQUIRE_EQ(String(buf, ftoa_shortest(3.4028235e38f, buf)), "3.4028235e+38");
+		}
+
+		TEST_CASE("fixed float conversion")
+		{
+			REQUIRE_EQ(String(buf, dtoa_fixed(9.995, buf, 2)), "10.00");
+			REQUIRE_EQ(String(buf, dtoa_fixed(2.675, buf, 2)), "2.68");
+			REQUIRE_EQ(String(buf, dtoa_fixed(0.006, buf, 2)), "0.01");
+			REQUIRE_EQ(String(3.14159f, 5), "3.14159");
+			REQUIRE_EQ(String(12.5, 2), "12.50");
+		}
 	}
 };
 
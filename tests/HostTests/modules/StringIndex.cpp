@@ -0,0 +1,104 @@
+#include <HostTests.h>
+
+#include <Data/StringIndex.h>
+#include <Data/FlashMapIndex.h>
+#include <Data/WebConstants.h>
+#include <FlashString/Vector.hpp>
+#include <FlashString/Map.hpp>
+
+namespace
+{
+#define COLOUR_MAP(XX)                                                                                                 \
+	XX(red, "Red")                                                                                                     \
+	XX(green, "green")                                                                                                 \
+	XX(blue, "BLUE")                                                                                                   \
+	XX(empty, "")                                                                                                      \
+	XX(duplicate, "red")                                                                                               \
+	XX(long, "a rather longer string which spans more than one comparison buffer")
+
+#define XX(tag, str) DEFINE_FSTR_LOCAL(str_##tag, str)
+COLOUR_MAP(XX)
+#undef XX
+
+#define XX(tag, str) &str_##tag,
+DEFINE_FSTR_VECTOR_LOCAL(colourStrings, FlashString, COLOUR_MAP(XX))
+#undef XX
+
+#define XX(tag, str) str,
+constexpr const char* colourList[]{COLOUR_MAP(XX)};
+#undef XX
+constexpr StringIndex<ARRAY_SIZE(colourList)> colourIndex PROGMEM{colourList};
+
+#define XX(tag, str) DEFINE_FSTR_LOCAL(content_##tag, "content of " str)
+COLOUR_MAP(XX)
+#undef XX
+
+#define XX(tag, str) {&str_##tag, &content_##tag},
+DEFINE_FSTR_MAP_LOCAL(colourMap, FlashString, FlashString, COLOUR_MAP(XX));
+#undef XX
+
+} // namespace
+
+class StringIndexTest : public TestGroup
+{
+public:
+	StringIndexTest() : TestGroup(_F("StringIndex"))
+	{
+	}
+
+	void execute() override
+	{
+		TEST_CASE("Lookup")
+		{
+			REQUIRE_EQ(colourIndex.indexOf(colourStrings, "red"), 0);
+			REQUIRE_EQ(colourIndex.indexOf(colourStrings, "GREEN"), 1);
+			REQUIRE_EQ(colourIndex.indexOf(colourStrings, "Blue"), 2);
+			REQUIRE_EQ(colourIndex.indexOf(colourStrings, ""), 3);
+			REQUIRE_EQ(colourIndex.indexOf(colourStrings,
+										   "A RATHER longer string which spans more than one comparison buffer"),
+					   5);
+			REQUIRE_EQ(colourIndex.indexOf(colourStrings, "re"), -1);
+			REQUIRE_EQ(colourIndex.indexOf(colourStrings, "reds"), -1);
+			REQUIRE_EQ(colourIndex.indexOf(colourStrings, nullptr), -1);
+		}
+
+		TEST_CASE("Matches linear search")
+		{
+			for(unsigned i = 0; i < colourStrings.length(); ++i) {
+				String s = colourStrings[i];
+				REQUIRE_EQ(colourIndex.indexOf(colourStrings, s.c_str()), colourStrings.indexOf(s.c_str()));
+			}
+		}
+
+		TEST_CASE("FlashMapIndex")
+		{
+			FlashMapIndex<decltype(colourMap)> index(colourMap);
+			for(unsigned i = 0; i < colourMap.length(); ++i) {
+				String key = colourMap.valueAt(i).key();
+				REQUIRE_EQ(index.indexOf(key), colourMap.indexOf(key));
+			}
+			int i = index.indexOf("Green");
+			REQUIRE_EQ(i, 1);
+			REQUIRE(colourMap.valueAt(i).content() == F("content of green"));
+			REQUIRE_EQ(index.indexOf("purple"), -1);
+		}
+
+		TEST_CASE("MIME types")
+		{
+			REQUIRE(ContentType::fromFileExtension("html", MIME_UNKNOWN) == MIME_HTML);
+			REQUIRE(ContentType::fromFileExtension("HTM", MIME_UNKNOWN) == MIME_HTML);
+			REQUIRE(ContentType::fromFileExtension("Json", MIME_UNKNOWN) == MIME_JSON);
+			REQUIRE(ContentType::fromFileExtension("svgz", MIME_UNKNOWN) == MIME_UNKNOWN);
+			REQUIRE(ContentType::fromFullFileName("/www/index.JS", MIME_UNKNOWN) == MIME_JS);
+			REQUIRE(ContentType::fromString("image/PNG") == MIME_PNG);
+			REQUIRE(ContentType::fromString("application/xml") == MIME_XML);
+			REQUIRE(ContentType::fromString("text/nonsense") == MIME_UNKNOWN);
+			REQUIRE(ContentType::fromFileExtension("css") == F("text/css"));
+		}
+	}
+};
+
+void REGISTER_TEST(StringIndex)
+{
+	registerGroup<StringIndexTest>();
+}
@@ -1,5 +1,10 @@
 #include <HostTests.h>
 #include <esp_spi_flash.h>
+#include <Services/Profiling/Trace.h>
+#include <Services/Profiling/CallbackTiming.h>
+#include <Services/Profiling/InterruptTiming.h>
+#include <Data/Stream/MemoryDataStream.h>
+#include <Data/JsonStreamParser.h>
 
 /*
  * Various system functions must be available for all architectures.
@@ -39,6 +44,202 @@ public:
 			system_soft_wdt_feed();
 		}
 
+		TEST_CASE("Queue delegates")
+		{
+			delegateOrder = "";
+			auto startCount = System.getDelegateCount();
+			const unsigned numCallbacks = 4;
+			for(unsigned i = 0; i < numCallbacks; ++i) {
+				REQUIRE(System.queueCallback([this, i]() { delegateOrder += char('0' + i); }));
+			}
+			REQUIRE_EQ(System.getDelegateCount(), startCount + numCallbacks);
+			REQUIRE(System.getMaxDelegateCount() >= startCount + numCallbacks);
+			REQUIRE_EQ(delegateOrder, "");
+			REQUIRE(System.queueCallback([this]() {
+				debug_i("Delegate order: %s", delegateOrder.c_str());
+				REQUIRE_EQ(delegateOrder, "0123");
+				endAsync();
+			}));
+			beginAsync();
+		}
+
+		TEST_CASE("Trace buffer")
+		{
+			using namespace Profiling;
+			Trace::clear();
+			Trace::add(Trace::Phase::Begin, "outer", 1);
+			Trace::add(Trace::Phase::Instant, "event", 2);
+			Trace::add(Trace::Phase::End, "outer", 0);
+			REQUIRE_EQ(Trace::getCount(), 3);
+			Trace::Record rec;
+			REQUIRE(Trace::getRecord(1, rec));
+			REQUIRE_EQ(String(rec.name), "event");
+			REQUIRE_EQ(rec.arg, 2);
+			REQUIRE(!Trace::getRecord(3, rec));
+
+			MemoryDataStream stream;
+			REQUIRE(Trace::printJson(stream) != 0);
+			REQUIRE(Trace::isEnabled());
+			String json = stream.readString(0xffff);
+			debug_i("%s", json.c_str());
+
+			String phases;
+			JsonStreamParser parser([&phases](const JsonStreamParser::Element& element) -> bool {
+				if(element.key != nullptr && strcmp(element.key, "ph") == 0) {
+					phases += element.value;
+				}
+				return true;
+			});
+			REQUIRE(parser.parse(json.c_str(), json.length()));
+			REQUIRE(parser.finish());
+			REQUIRE_EQ(phases, "BiE");
+
+			// Oldest records are overwritten
+			for(unsigned i = 0; i < TRACE_BUFFER_SIZE + 10; ++i) {
+				Trace::add(Trace::Phase::Instant, "fill", i);
+			}
+			REQUIRE_EQ(Trace::getCount(), TRACE_BUFFER_SIZE);
+			REQUIRE_EQ(Trace::getDropped(), 13);
+			REQUIRE(Trace::getRecord(0, rec));
+			REQUIRE_EQ(rec.arg, 10);
+			Trace::clear();
+			REQUIRE_EQ(Trace::getCount(), 0);
+		}
+
+		TEST_CASE("Callback timing")
+		{
+			using namespace Profiling;
+			static unsigned warnings;
+			warnings = 0;
+			static const int callbacks[2]{};
+			auto findEntry = [](const void* callback, CallbackTiming::Entry& entry) {
+				for(unsigned i = 0; CallbackTiming::getEntry(i, entry); ++i) {
+					if(entry.callback == callback) {
+						return true;
+					}
+				}
+				return false;
+			};
+
+			CallbackTiming::startWindow();
+			CallbackTiming::setWarningCallback([](const CallbackTiming::Entry&, uint32_t) { ++warnings; });
+			REQUIRE(CallbackTiming::setTag(&callbacks[0], "test"));
+			CallbackTiming::record(&callbacks[0], 100);
+			CallbackTiming::record(&callbacks[0], 300);
+			CallbackTiming::record(&callbacks[1], 50);
+
+			CallbackTiming::Entry entry;
+			REQUIRE(findEntry(&callbacks[0], entry));
+			REQUIRE_EQ(String(entry.tag), "test");
+			REQUIRE_EQ(entry.count, 2);
+			REQUIRE_EQ(entry.maxCycles, 300);
+			REQUIRE_EQ(entry.totalCycles, 400);
+			REQUIRE(findEntry(&callbacks[1], entry));
+			REQUIRE(entry.tag == nullptr);
+			REQUIRE_EQ(entry.count, 1);
+
+			CallbackTiming::recordStack(&callbacks[1], 200);
+			CallbackTiming::recordStack(&callbacks[1], 100);
+			REQUIRE(findEntry(&callbacks[1], entry));
+			REQUIRE_EQ(entry.maxStack, 200);
+
+			// Warning only issued after consecutive long runs
+			uint32_t longCycles = (TASK_TIMING_WARN_US + 1) * system_get_cpu_freq();
+			for(unsigned i = 1; i < TASK_TIMING_WARN_COUNT; ++i) {
+				CallbackTiming::record(&callbacks[1], longCycles);
+			}
+			CallbackTiming::record(&callbacks[1], 50);
+			REQUIRE_EQ(warnings, 0);
+			for(unsigned i = 0; i < TASK_TIMING_WARN_COUNT; ++i) {
+				CallbackTiming::record(&callbacks[1], longCycles);
+			}
+			REQUIRE_EQ(warnings, 1);
+
+			MemoryDataStream stream;
+			REQUIRE(CallbackTiming::printTo(stream) != 0);
+			debug_i("%s", stream.readString(0xffff).c_str());
+
+			// Tags are retained for the next window
+			CallbackTiming::startWindow();
+			CallbackTiming::setWarningCallback(nullptr);
+			REQUIRE(findEntry(&callbacks[0], entry));
+			REQUIRE_EQ(String(entry.tag), "test");
+			REQUIRE_EQ(entry.count, 0);
+			REQUIRE(findEntry(&callbacks[1], entry));
+			REQUIRE_EQ(entry.maxStack, 0);
+		}
+
+		TEST_CASE("Interrupt timing")
+		{
+			using namespace Profiling;
+			REQUIRE_EQ(InterruptTiming::getBucket(0), 0);
+			REQUIRE_EQ(InterruptTiming::getBucket(255), 0);
+			REQUIRE_EQ(InterruptTiming::getBucket(256), 1);
+			REQUIRE_EQ(InterruptTiming::getBucket(511), 1);
+			REQUIRE_EQ(InterruptTiming::getBucket(512), 2);
+			REQUIRE_EQ(InterruptTiming::getBucket(0xffffffff), InterruptTiming::histogramBuckets - 1);
+
+			InterruptTiming::reset();
+			InterruptTiming::recordMasked(0x40201000, 100);
+			InterruptTiming::recordMasked(0x40201000, 300);
+			InterruptTiming::recordMasked(0x40201010, 50);
+			REQUIRE_EQ(InterruptTiming::getMaxMaskedCycles(), 300);
+			REQUIRE_EQ(InterruptTiming::getTotalMaskedCycles(), 450);
+
+			InterruptTiming::Site site;
+			unsigned siteCount{0};
+			for(unsigned i = 0; i < INTERRUPT_TIMING_SITES; ++i) {
+				if(!InterruptTiming::getSite(i, site)) {
+					continue;
+				}
+				++siteCount;
+				if(site.address == 0x40201000) {
+					REQUIRE_EQ(site.count, 2);
+					REQUIRE_EQ(site.maxCycles, 300);
+					REQUIRE_EQ(site.totalCycles, 400);
+				}
+			}
+			REQUIRE_EQ(siteCount, 2);
+
+			unsigned calls{0};
+			InterruptTiming::callHandler(5, [&]() { ++calls; });
+			InterruptTiming::recordHandler(4, 100);
+			InterruptTiming::recordHandler(4, 1000);
+			REQUIRE_EQ(calls, 1);
+
+			InterruptTiming::Handler handler;
+			REQUIRE(InterruptTiming::getHandler(4, handler));
+			REQUIRE_EQ(handler.count, 2);
+			REQUIRE_EQ(handler.maxCycles, 1000);
+			REQUIRE_EQ(handler.histogram[0], 1);
+			REQUIRE_EQ(handler.histogram[2], 1);
+			REQUIRE_EQ(InterruptTiming::getHandler(5, handler), bool(ENABLE_INTERRUPT_TIMING));
+
+			MemoryDataStream stream;
+			REQUIRE(InterruptTiming::printTo(stream) != 0);
+			debug_i("%s", stream.readString(0xffff).c_str());
+			InterruptTiming::reset();
+		}
+
+#ifndef ARCH_ESP32
+		TEST_CASE("Task priorities")
+		{
+			static String order;
+			order = "";
+			auto overflows = System.getTaskQueueStats(TaskPriority::High).overflows;
+			REQUIRE(System.queueCallback(TaskPriority::Low, [this]() {
+				order += 'L';
+				debug_i("Task order: %s", order.c_str());
+				REQUIRE_EQ(order, "HNL");
+				endAsync();
+			}));
+			REQUIRE(System.queueCallback(TaskPriority::Normal, []() { order += 'N'; }));
+			REQUIRE(System.queueCallback(TaskPriority::High, []() { order += 'H'; }));
+			REQUIRE_EQ(System.getTaskQueueStats(TaskPriority::High).overflows, overflows);
+			beginAsync();
+		}
+#endif
+
 #ifndef ARCH_HOST
 		TEST_CASE("System restart")
 		{
@@ -70,6 +271,25 @@ public:
 		}
 #endif
 	}
+
+private:
+	// Several cases complete from queued callbacks, which only run once execute() has returned
+	void beginAsync()
+	{
+		if(asyncCount++ == 0) {
+			pending();
+		}
+	}
+
+	void endAsync()
+	{
+		if(--asyncCount == 0) {
+			complete();
+		}
+	}
+
+	String delegateOrder;
+	unsigned asyncCount{0};
 };
 
 void REGISTER_TEST(System)
@@ -3,7 +3,9 @@
 #include <Data/Stream/MemoryDataStream.h>
 #include <Data/Stream/LimitedMemoryStream.h>
 #include <Data/Stream/SectionTemplate.h>
+#include <Data/Stream/CompiledTemplate.h>
 #include <Data/CsvReader.h>
+#include <Data/CsvCursor.h>
 
 #ifdef ARCH_HOST
 #include <IFS/Host/FileSystem.h>
@@ -23,6 +25,11 @@ DEFINE_FSTR_LOCAL(template3_1, "<html><head><title>Document Title</title><style>
 DEFINE_FSTR_LOCAL(template4, "{\"value\":12,\"var1\":\"{var1}\"}")
 DEFINE_FSTR_LOCAL(template4_1, "{\"value\":12,\"var1\":\"quoted variable\"}")
 
+DEFINE_FSTR_LOCAL(template5, "{{title}} {title} {{title} {{other}} {{title")
+DEFINE_FSTR_LOCAL(template5_1, "Title {title} Title {{other}} {{title")
+
+DEFINE_FSTR_LOCAL(template_vars, "var1\0var2\0title")
+
 DEFINE_FSTR_LOCAL(
 	test1_csv, "\"field1\",field2,field3,\"field four\"\n"
 			   "Something \"awry\",\"datavalue 2\",\"where,are,\"\"the,bananas\",sausages abound,\"never surrender\"")
@@ -141,6 +148,42 @@ public:
 			check(tmpl, Resource::ut_template1_out1_rst);
 		}
 
+		TEST_CASE("Compiled template")
+		{
+			CompiledTemplate compiled(template_vars);
+			auto getValue = [](unsigned id) -> String {
+				switch(id) {
+				case 0:
+					return F("value #1");
+				case 1:
+					return F("value #2");
+				default:
+					return nullptr;
+				}
+			};
+
+			REQUIRE(!compiled.isCompiled());
+			CompiledTemplateStream tmpl(compiled, new FSTR::Stream(template1), getValue);
+			REQUIRE(compiled.isCompiled());
+			// Text, var1, text, var2, text
+			REQUIRE_EQ(compiled.count(), 5);
+			REQUIRE_EQ(compiled[1].id, 0);
+			REQUIRE_EQ(compiled[3].id, 1);
+			checkCompiled(tmpl, template1_1);
+
+			// Rendering again uses existing compiled version
+			REQUIRE_EQ(tmpl.seekFrom(0, SeekOrigin::Start), 0);
+			checkCompiled(tmpl, template1_1);
+		}
+
+		TEST_CASE("Compiled template with double braces")
+		{
+			CompiledTemplate compiled("title", true);
+			auto getValue = [](unsigned) -> String { return F("Title"); };
+			CompiledTemplateStream tmpl(compiled, new FSTR::Stream(template5), getValue);
+			checkCompiled(tmpl, template5_1);
+		}
+
 		auto addChar = [](String& s, char c, size_t count) {
 			auto len = s.length();
 			s.setLength(len + count);
@@ -210,6 +253,59 @@ public:
 			CHECK(csv_headings == headings);
 			CHECK(csv_row1 == row1);
 		}
+
+		TEST_CASE("CSV Cursor")
+		{
+			auto str = [](CsvCursor& cursor) {
+				String s;
+				for(unsigned i = 0; i < cursor.count(); ++i) {
+					s += cursor.getValue(i);
+					s += ';';
+				}
+				return s;
+			};
+
+			CsvCursor cursor(new FSTR::Stream(test1_csv));
+			String headings = reinterpret_cast<const String&>(cursor.getHeadings());
+			headings.replace('\0', ';');
+			CHECK(csv_headings == headings);
+			REQUIRE(cursor.next());
+			CHECK_EQ(str(cursor), "Something \"awry\";datavalue 2;where,are,\"the,bananas;sausages abound;");
+			CHECK(!cursor.next());
+
+			// Data in memory
+			String text;
+			for(unsigned i = 0; i < 100; ++i) {
+				text += i;
+				text += F(",\"value\\n");
+				text += i * 7;
+				text += F("\"\n");
+			}
+			CStringArray columns;
+			columns += "key";
+			columns += "value";
+			CsvCursor table(text.c_str(), text.length(), ',', columns);
+			REQUIRE_EQ(table.count(), 2U);
+			int keyColumn = table.getColumn("key");
+			int valueColumn = table.getColumn("value");
+			CHECK_EQ(valueColumn, 1);
+
+			REQUIRE(table.buildIndex(8));
+			CHECK_EQ(table.getRowCount(), 100);
+			for(unsigned row : {0, 99, 8, 7, 50, 51}) {
+				REQUIRE(table.seek(row));
+				char buffer[16];
+				int len = table.getValue(keyColumn, buffer, sizeof(buffer));
+				REQUIRE_EQ(len, int(strlen(buffer)));
+				CHECK_EQ(String(buffer), String(row));
+				CHECK_EQ(table.getValue(valueColumn), String(F("value\n")) + (row * 7));
+			}
+			CHECK(!table.seek(100));
+
+			REQUIRE(table.seek(10));
+			CHECK(table.valueEquals(valueColumn, "value\n70"));
+			CHECK(!table.valueEquals(valueColumn, "value\n7"));
+		}
 	}
 
 private:
@@ -227,6 +323,16 @@ private:
 		return;
 	}
 
+	void checkCompiled(IDataSourceStream& stream, const FlashString& ref)
+	{
+		constexpr size_t maxLen{256};
+		String s = stream.readString(maxLen);
+		Serial.print(_F(" res: "));
+		Serial.println(s);
+		REQUIRE(ref == s);
+		REQUIRE(stream.isFinished());
+	}
+
 	void check(TemplateStream& tmpl, const FlashString& ref)
 	{
 		constexpr size_t bufSize{256};
@@ -7,6 +7,8 @@
 #include <HostTests.h>
 #include <HardwareTimer.h>
 #include <Platform/Timers.h>
+#include <WheelTimer.h>
+#include <CoalescedTimer.h>
 #include <malloc_count.h>
 
 using Timer1TestApi = Timer1Api<TIMER_CLKDIV_16, eHWT_Maskable>;
@@ -257,6 +259,131 @@ private:
 	uint32_t memStart = 0;
 };
 
+class WheelTimerTest : public TestGroup
+{
+public:
+	static constexpr unsigned timerCount = 100;
+
+	WheelTimerTest() : TestGroup(_F("Wheel timer"))
+	{
+	}
+
+	void execute() override
+	{
+		for(unsigned i = 0; i < timerCount; ++i) {
+			auto& t = timers[i];
+			t.test = this;
+			// Mix short and long intervals, not in order
+			t.intervalMs = 1 + ((i * 37) % timerCount) * ((i % 2) ? 3 : 31);
+			t.timer.initializeMs(
+				t.intervalMs,
+				[](void* arg) {
+					auto& t = *static_cast<TestTimer*>(arg);
+					t.test->timerFired(t);
+				},
+				&t);
+			t.startTicks = WheelTimer::Clock::ticks();
+			t.timer.startOnce();
+		}
+
+		// Stopped timers must not fire
+		for(unsigned i = 0; i < timerCount; i += 10) {
+			timers[i].timer.stop();
+			++firedCount;
+		}
+
+		pending();
+	}
+
+private:
+	struct TestTimer {
+		WheelTimerTest* test;
+		WheelTimer timer;
+		uint32_t startTicks;
+		uint32_t intervalMs;
+	};
+
+	void timerFired(TestTimer& t)
+	{
+		uint32_t elapsed = WheelTimer::Clock::ticks() - t.startTicks;
+		if(elapsed < t.timer.getInterval()) {
+			debug_e("Timer fired early: %u < %u ticks", elapsed, t.timer.getInterval());
+			TEST_ASSERT(false);
+		}
+		REQUIRE(!t.timer.isArmed());
+		if(++firedCount == timerCount) {
+			complete();
+		}
+	}
+
+	TestTimer timers[timerCount];
+	unsigned firedCount = 0;
+};
+
+class CoalescedTimerTest : public TestGroup
+{
+public:
+	static constexpr unsigned timerCount = 20;
+
+	CoalescedTimerTest() : TestGroup(_F("Coalesced timer"))
+	{
+	}
+
+	void execute() override
+	{
+		for(unsigned i = 0; i < timerCount; ++i) {
+			auto& t = timers[i];
+			t.test = this;
+			t.timeout = 100 + i * 50;
+			t.restarts = i % 3;
+			t.timer.setCallback(
+				[](void* arg) {
+					auto& t = *static_cast<TestTimer*>(arg);
+					t.test->timerFired(t);
+				},
+				&t);
+			t.startTime = millis();
+			t.timer.start(t.timeout);
+		}
+
+		pending();
+	}
+
+private:
+	struct TestTimer {
+		CoalescedTimerTest* test;
+		CoalescedTimer timer;
+		uint32_t startTime;
+		uint32_t timeout;
+		unsigned restarts;
+	};
+
+	void timerFired(TestTimer& t)
+	{
+		auto elapsed = millis() - t.startTime;
+		if(elapsed < t.timeout || elapsed > t.timeout + COALESCED_TIMER_SLACK + 100) {
+			debug_e("Timer fired after %u ms, expected %u", elapsed, t.timeout);
+			TEST_ASSERT(false);
+		}
+		REQUIRE(!t.timer.isStarted());
+
+		// Restarting from the callback behaves like new activity on an idle connection
+		if(t.restarts != 0) {
+			--t.restarts;
+			t.startTime = millis();
+			t.timer.start(t.timeout);
+			return;
+		}
+
+		if(++firedCount == timerCount) {
+			complete();
+		}
+	}
+
+	TestTimer timers[timerCount];
+	unsigned firedCount = 0;
+};
+
 template <typename TimerApi> class CallbackTimerApiTest : public TestGroup
 {
 public:
@@ -421,10 +548,14 @@ void REGISTER_TEST(Timers)
 	registerGroup<CallbackTimerApiTest<Timer1TestApi>>();
 	registerGroup<CallbackTimerApiTest<OsTimerApi>>();
 	registerGroup<CallbackTimerApiTest<OsTimer64Api<Timer>>>();
+	registerGroup<CallbackTimerApiTest<WheelTimerApi>>();
 
 	registerGroup<CallbackTimerSpeedTest<HardwareTimerTest>>();
 	registerGroup<CallbackTimerSpeedTest<SimpleTimer>>();
 	registerGroup<CallbackTimerSpeedTest<Timer>>();
+	registerGroup<CallbackTimerSpeedTest<WheelTimer>>();
 
 	registerGroup<CallbackTimerTest>();
+	registerGroup<WheelTimerTest>();
+	registerGroup<CoalescedTimerTest>();
 }
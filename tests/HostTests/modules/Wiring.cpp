@@ -2,7 +2,11 @@
 
 #include <WHashMap.h>
 #include <WVector.h>
+#include <ValueVector.h>
+#include <StaticVector.h>
+#include <memory>
 #include <MacAddress.h>
+#include <DigitalPins.h>
 
 class WiringTest : public TestGroup
 {
@@ -51,6 +55,63 @@ public:
 			print(map);
 		}
 
+		TEST_CASE("HashMap with hashed lookup")
+		{
+			HashMap<String, unsigned, HashMapHashedLookup<String>> map;
+			const unsigned count = 100;
+			for(unsigned i = 0; i < count; ++i) {
+				map[String(i)] = i;
+			}
+			REQUIRE_EQ(map.count(), count);
+			for(unsigned i = 0; i < count; ++i) {
+				REQUIRE_EQ(map.indexOf(String(i)), int(i));
+				REQUIRE_EQ(map[String(i)], i);
+			}
+			REQUIRE(!map.contains("abc"));
+
+			map.remove("10");
+			REQUIRE(!map.contains("10"));
+			REQUIRE_EQ(map.count(), count - 1);
+			REQUIRE_EQ(map.indexOf("11"), 10);
+			REQUIRE_EQ(map.keyAt(10), "11");
+
+			HashMap<int, int, HashMapHashedLookup<int>> intMap;
+			for(int i = 0; i < 20; ++i) {
+				intMap[i * 16] = i;
+			}
+			for(int i = 0; i < 20; ++i) {
+				REQUIRE_EQ(intMap[i * 16], i);
+			}
+			intMap.clear();
+			REQUIRE(!intMap.contains(0));
+		}
+
+		TEST_CASE("HashMap reset and swap")
+		{
+			HashMap<int, String, HashMapHashedLookup<int>> map;
+			for(int i = 0; i < 8; ++i) {
+				map[i] = String(i);
+			}
+			map.reset(8);
+			REQUIRE_EQ(map.count(), 0U);
+			REQUIRE_EQ(map.capacity(), 8U);
+			REQUIRE(!map.contains(0));
+			map[5] = "five";
+			REQUIRE_EQ(map.count(), 1U);
+			REQUIRE_EQ(map[5], "five");
+			REQUIRE_EQ(map.capacity(), 8U);
+
+			HashMap<int, String, HashMapHashedLookup<int>> other;
+			other.swap(map);
+			REQUIRE_EQ(map.count(), 0U);
+			REQUIRE_EQ(map.capacity(), 0U);
+			REQUIRE_EQ(other.count(), 1U);
+			REQUIRE_EQ(other[5], "five");
+
+			other.reset(4);
+			REQUIRE_EQ(other.capacity(), 0U);
+		}
+
 		TEST_CASE("Vector(String)")
 		{
 			Vector<String> vector;
@@ -72,6 +133,63 @@ public:
 			}
 		}
 
+		TEST_CASE("ValueVector(String)")
+		{
+			ValueVector<String> vector;
+			for(unsigned i = 0; i < 100; ++i) {
+				REQUIRE(vector.add(String(i)));
+			}
+			REQUIRE_EQ(vector.count(), 100U);
+			REQUIRE(vector.capacity() >= 100);
+
+			// Adding an existing element must survive reallocation
+			vector.trimToSize();
+			REQUIRE(vector.add(vector[0]));
+			REQUIRE_EQ(vector[100], "0");
+
+			REQUIRE(vector.insertElementAt("x", 1));
+			REQUIRE_EQ(vector[1], "x");
+			REQUIRE_EQ(vector[2], "1");
+			vector.removeElementAt(1);
+			REQUIRE(vector.removeElement("50"));
+			REQUIRE_EQ(vector.indexOf("51"), 50);
+
+			auto copy = vector;
+			REQUIRE_EQ(copy.count(), vector.count());
+			REQUIRE_EQ(copy[99], vector[99]);
+		}
+
+		TEST_CASE("ValueVector(unique_ptr)")
+		{
+			ValueVector<std::unique_ptr<int>> vector;
+			vector.reserve(2);
+			REQUIRE_EQ(vector.capacity(), 2U);
+			vector.add(std::make_unique<int>(2));
+			vector.emplace(new int(3));
+			vector.insertElementAt(std::make_unique<int>(1), 0);
+			int i = 1;
+			for(auto& e : vector) {
+				REQUIRE_EQ(*e, i++);
+			}
+			auto moved = std::move(vector);
+			REQUIRE_EQ(vector.count(), 0U);
+			REQUIRE_EQ(moved.count(), 3U);
+		}
+
+		TEST_CASE("StaticVector")
+		{
+			StaticVector<String, 4> vector;
+			for(unsigned i = 0; i < 4; ++i) {
+				REQUIRE(vector.add(String(i)));
+			}
+			REQUIRE(vector.isFull());
+			REQUIRE(!vector.add("overflow"));
+			REQUIRE(!vector.reserve(5));
+			REQUIRE_EQ(vector.count(), 4U);
+			vector.setSize(2);
+			REQUIRE_EQ(vector.lastElement(), "1");
+		}
+
 		TEST_CASE("MacAddress")
 		{
 			const uint8_t refOctets[]{0x12, 0x34, 0x56, 0x78, 0x9a, 0xbc};
@@ -86,6 +204,23 @@ public:
 			REQUIRE(!MacAddress(""));
 			REQUIRE(!MacAddress("fffffffgfffff"));
 		}
+
+		TEST_CASE("DigitalPins")
+		{
+			using Bus = DigitalPins<12, 13, 14, 15, 4, 5, 2, 0>;
+			static_assert(Bus::count == 8, "Bad count");
+			static_assert(Bus::mask == 0xf035, "Bad mask");
+			REQUIRE_EQ(Bus::toPort(0x01), BIT(12));
+			REQUIRE_EQ(Bus::toPort(0xA5), BIT(12) | BIT(14) | BIT(5) | BIT(0));
+			REQUIRE_EQ(Bus::fromPort(0xffffffff), 0xff);
+			for(unsigned value = 0; value < 0x100; ++value) {
+				REQUIRE_EQ(Bus::fromPort(Bus::toPort(value)), value);
+			}
+
+			using Nibble = DigitalPins<4, 5, 6, 7>;
+			static_assert(Nibble::toPort(0x1a) == 0xa0, "Bad consecutive mapping");
+			REQUIRE_EQ(Nibble::fromPort(0x1234), 3);
+		}
 	}
 };
 
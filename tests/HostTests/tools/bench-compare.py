@@ -0,0 +1,75 @@
+#!/usr/bin/env python3
+#
+# Compare benchmark results from two HostTests runs
+#
+# Each log is scanned for lines of the form:
+#
+#   #BENCH:group,name,count,bytes,min_ns,avg_ns,max_ns,kb_per_sec
+#
+# Example:
+#
+#   make execute | tee new.log
+#   python3 tools/bench-compare.py baseline.log new.log --threshold 10
+#
+# Exit status is 1 if any benchmark average time increased by more than the threshold percentage.
+#
+
+import argparse, sys
+
+TAG = '#BENCH:'
+
+def load(filename):
+    """Return dictionary of {(group, name): avg_ns} from a log file."""
+    results = {}
+    with open(filename, errors='replace') as f:
+        for line in f:
+            pos = line.find(TAG)
+            if pos < 0:
+                continue
+            fields = line[pos + len(TAG):].strip().split(',')
+            if len(fields) != 8:
+                continue
+            group, name = fields[0], fields[1]
+            try:
+                results[(group, name)] = int(fields[5])
+            except ValueError:
+                continue
+    return results
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Compare HostTests benchmark results')
+    parser.add_argument('baseline', help='Log file from reference run')
+    parser.add_argument('current', help='Log file from run to be checked')
+    parser.add_argument('--threshold', type=float, default=10, help='Permitted slowdown in percent')
+    args = parser.parse_args()
+
+    baseline = load(args.baseline)
+    current = load(args.current)
+    if not current:
+        sys.stderr.write('No benchmark results found in "%s"\n' % args.current)
+        return 2
+
+    regressions = 0
+    print('%-12s %-24s %12s %12s %8s' % ('group', 'name', 'base (ns)', 'now (ns)', 'change'))
+    for key in sorted(current):
+        now = current[key]
+        base = baseline.get(key)
+        if base is None:
+            print('%-12s %-24s %12s %12d %8s' % (key[0], key[1], '-', now, 'new'))
+            continue
+        change = (now - base) * 100 / base if base else 0
+        flag = ''
+        if change > args.threshold:
+            flag = ' REGRESSION'
+            regressions += 1
+        print('%-12s %-24s %12d %12d %+7.1f%%%s' % (key[0], key[1], base, now, change, flag))
+
+    for key in sorted(set(baseline) - set(current)):
+        print('%-12s %-24s %12d %12s %8s' % (key[0], key[1], baseline[key], '-', 'missing'))
+
+    return 1 if regressions else 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
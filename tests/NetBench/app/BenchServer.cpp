@@ -0,0 +1,136 @@
+#include <BenchServer.h>
+#include <SmingCore.h>
+#include <Network/Http/Websocket/WebsocketResource.h>
+#include <Network/Http/HttpResponseCache.h>
+#include <malloc_count.h>
+
+#ifdef ENABLE_SSL
+IMPORT_FSTR_LOCAL(serverKey, PROJECT_DIR "/cert/key_1024");
+IMPORT_FSTR_LOCAL(serverCert, PROJECT_DIR "/cert/x509_1024.cer");
+#endif
+
+namespace BenchServer
+{
+namespace
+{
+HttpServer* server;
+HttpResponseCache jsonCache(250);
+
+struct Counters {
+	uint32_t requests;
+	uint32_t messages;
+	size_t allocCount; ///< Allocations made before reset
+	uint32_t startTime;
+};
+Counters counters;
+
+void resetCounters()
+{
+	MallocCount::resetPeak();
+	counters = {};
+	counters.allocCount = MallocCount::getAllocCount();
+	counters.startTime = millis();
+}
+
+void onIndex(HttpRequest&, HttpResponse& response)
+{
+	++counters.requests;
+	response.setContentType(MIME_TEXT);
+	response.sendString(F("Hello from Sming\n"));
+}
+
+void onJson(HttpRequest&, HttpResponse& response)
+{
+	++counters.requests;
+	String s;
+	s += F("{\"uptime\":");
+	s += millis();
+	s += F(",\"heap\":");
+	s += system_get_free_heap_size();
+	s += F(",\"connections\":");
+	s += server->getConnections().count();
+	s += F(",\"status\":\"ok\"}");
+	response.setContentType(MIME_JSON);
+	response.sendString(std::move(s));
+}
+
+void onReset(HttpRequest&, HttpResponse& response)
+{
+	resetCounters();
+	response.sendString(F("OK\n"));
+}
+
+void onStats(HttpRequest&, HttpResponse& response)
+{
+	String s;
+	s += F("{\"requests\":");
+	s += counters.requests;
+	s += F(",\"messages\":");
+	s += counters.messages;
+	s += F(",\"elapsed\":");
+	s += millis() - counters.startTime;
+	s += F(",\"heapUsed\":");
+	s += MallocCount::getCurrent();
+	s += F(",\"heapPeak\":");
+	s += MallocCount::getPeak();
+	s += F(",\"allocs\":");
+	s += MallocCount::getAllocCount() - counters.allocCount;
+	s += F(",\"cacheHits\":");
+	s += jsonCache.getStats().hits;
+	s += '}';
+	response.setContentType(MIME_JSON);
+	response.sendString(std::move(s));
+}
+
+void wsMessageReceived(WebsocketConnection& socket, const String& message)
+{
+	++counters.messages;
+	socket.sendString(message);
+}
+
+void wsBinaryReceived(WebsocketConnection& socket, uint8_t* data, size_t size)
+{
+	++counters.messages;
+	socket.sendBinary(data, size);
+}
+
+} // namespace
+
+bool start(uint16_t port, bool useSsl)
+{
+	HttpServerSettings settings;
+	settings.maxActiveConnections = 64;
+	settings.keepAliveSeconds = 10;
+	server = new HttpServer(settings);
+
+#ifdef ENABLE_SSL
+	if(useSsl) {
+		server->setSslInitHandler([](Ssl::Session& session) { session.keyCert.assign(serverKey, serverCert); });
+	}
+#else
+	if(useSsl) {
+		Serial.println(_F("TLS requires build with ENABLE_SSL=1"));
+		return false;
+	}
+#endif
+
+	if(!server->listen(port, useSsl)) {
+		return false;
+	}
+
+	server->paths.set("/", onIndex);
+	server->paths.set("/json", onJson);
+	server->paths.set("/cached", onJson)->setResponseCache(&jsonCache);
+	server->paths.set("/bench/reset", onReset);
+	server->paths.set("/bench/stats", onStats);
+
+	auto wsResource = new WebsocketResource();
+	wsResource->setMessageHandler(wsMessageReceived);
+	wsResource->setBinaryHandler(wsBinaryReceived);
+	server->paths.set("/ws", wsResource);
+
+	resetCounters();
+	return true;
+}
+
+} // namespace BenchServer
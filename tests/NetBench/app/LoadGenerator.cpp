@@ -0,0 +1,500 @@
+#include <LoadGenerator.h>
+#include <malloc_count.h>
+
+namespace
+{
+// Time allowed for connections to finish their last request once the run has ended
+constexpr unsigned closeTimeoutMs{2000};
+
+String getJsonValue(const String& json, const char* name)
+{
+	String tag;
+	tag += '"';
+	tag += name;
+	tag += F("\":");
+	int pos = json.indexOf(tag);
+	if(pos < 0) {
+		return nullptr;
+	}
+	pos += tag.length();
+	int end = pos;
+	while(end < int(json.length()) && json[end] >= '0' && json[end] <= '9') {
+		++end;
+	}
+	return json.substring(pos, end);
+}
+
+} // namespace
+
+/*
+ * Base for a single client connection
+ */
+class LoadGenerator::Connection
+{
+public:
+	Connection(LoadGenerator& generator) : generator(generator)
+	{
+	}
+
+	virtual ~Connection()
+	{
+	}
+
+	virtual bool start() = 0;
+
+	/**
+	 * @brief Abandon any request in progress
+	 */
+	virtual void close() = 0;
+
+protected:
+	bool isRunning() const
+	{
+		return generator.running;
+	}
+
+	void sent()
+	{
+		sendTime = micros();
+	}
+
+	void received(size_t length)
+	{
+		generator.responseReceived(micros() - sendTime, length);
+	}
+
+	void failed()
+	{
+		generator.connectionFailed();
+	}
+
+	void closed()
+	{
+		if(!isClosed) {
+			isClosed = true;
+			generator.connectionClosed();
+		}
+	}
+
+	LoadGenerator& generator;
+
+private:
+	uint32_t sendTime{0};
+	bool isClosed{false};
+};
+
+/*
+ * Both HTTP and websocket connections parse responses from a receive buffer
+ */
+class LoadGenerator::HttpConnection : public Connection
+{
+public:
+	HttpConnection(LoadGenerator& generator)
+		: Connection(generator), client(TcpClientCompleteDelegate(&HttpConnection::onComplete, this),
+										TcpClientEventDelegate(&HttpConnection::onReadyToSend, this),
+										TcpClientDataDelegate(&HttpConnection::onReceive, this))
+	{
+		auto& config = generator.config;
+		request = F("GET ");
+		request += config.path;
+		request += F(" HTTP/1.1\r\n"
+					 "Host: ");
+		request += config.host;
+		request += F("\r\n");
+	}
+
+	bool start() override
+	{
+		// Any additional headers have been added by now
+		request += F("\r\n");
+		auto& config = generator.config;
+		return client.connect(config.host, config.port, config.useSsl);
+	}
+
+	void close() override
+	{
+		client.close();
+	}
+
+protected:
+	/**
+	 * @brief Handle data in receive buffer
+	 * @retval int Length of message consumed, 0 if incomplete, -1 on error
+	 */
+	virtual int parse()
+	{
+		if(contentLength < 0) {
+			int pos = rx.indexOf("\r\n\r\n");
+			if(pos < 0) {
+				return 0;
+			}
+			if(!rx.startsWith(F("HTTP/1.1 200"))) {
+				return -1;
+			}
+			headLength = pos + 4;
+			String head = rx.substring(0, pos);
+			head.toLowerCase();
+			const char* tag = "\r\ncontent-length:";
+			int lengthPos = head.indexOf(tag);
+			if(lengthPos < 0) {
+				return -1;
+			}
+			contentLength = atoi(head.c_str() + lengthPos + strlen(tag));
+		}
+
+		size_t length = headLength + contentLength;
+		if(rx.length() < length) {
+			return 0;
+		}
+		contentLength = -1;
+		return length;
+	}
+
+	virtual bool sendRequest()
+	{
+		return client.sendString(request);
+	}
+
+	/**
+	 * @brief Send next request
+	 * @retval bool false if connection should be closed
+	 * @note Once the run has ended connections are left idle, then closed together
+	 */
+	bool next()
+	{
+		if(!isRunning()) {
+			return true;
+		}
+		sent();
+		if(!sendRequest()) {
+			failed();
+			return false;
+		}
+		return true;
+	}
+
+	TcpClient client;
+	String request;
+	String rx;
+
+private:
+	void onReadyToSend(TcpClient&, TcpConnectionEvent sourceEvent)
+	{
+		if(sourceEvent == eTCE_Connected && !next()) {
+			client.close();
+		}
+	}
+
+	bool onReceive(TcpClient&, char* data, int size)
+	{
+		rx.concat(data, size);
+		for(;;) {
+			int length = parse();
+			if(length == 0) {
+				break;
+			}
+			if(length < 0) {
+				failed();
+				return false;
+			}
+			rx.remove(0, length);
+			received(length);
+			if(!next()) {
+				return false;
+			}
+		}
+		return true;
+	}
+
+	void onComplete(TcpClient&, bool successful)
+	{
+		if(!successful && isRunning()) {
+			failed();
+		}
+		closed();
+	}
+
+	int headLength{0};
+	int contentLength{-1};
+};
+
+/*
+ * Performs upgrade then exchanges echo messages
+ */
+class LoadGenerator::WebsocketConnection : public HttpConnection
+{
+public:
+	WebsocketConnection(LoadGenerator& generator) : HttpConnection(generator)
+	{
+		request += F("Upgrade: websocket\r\n"
+					 "Connection: Upgrade\r\n"
+					 "Sec-WebSocket-Key: dGhlIHNhbXBsZSBub25jZQ==\r\n"
+					 "Sec-WebSocket-Version: 13\r\n");
+
+		// Masked text frame; an all-zero key leaves the payload unchanged
+		auto size = generator.config.payloadSize;
+		frame += char(0x81);
+		if(size < 126) {
+			frame += char(0x80 | size);
+		} else {
+			frame += char(0x80 | 126);
+			frame += char(size >> 8);
+			frame += char(size & 0xff);
+		}
+		frame.concat("\0\0\0\0", 4);
+		auto offset = frame.length();
+		if(frame.setLength(offset + size)) {
+			memset(frame.begin() + offset, 'x', size);
+		}
+	}
+
+protected:
+	int parse() override
+	{
+		if(!upgraded) {
+			int pos = rx.indexOf("\r\n\r\n");
+			if(pos < 0) {
+				return 0;
+			}
+			if(!rx.startsWith(F("HTTP/1.1 101"))) {
+				return -1;
+			}
+			upgraded = true;
+			// Upgrade isn't counted as a response
+			rx.remove(0, pos + 4);
+			sent();
+			if(!client.sendString(frame)) {
+				return -1;
+			}
+		}
+
+		if(rx.length() < 2) {
+			return 0;
+		}
+		auto data = reinterpret_cast<const uint8_t*>(rx.c_str());
+		size_t length = data[1] & 0x7f;
+		size_t headerLength{2};
+		if(length == 126) {
+			if(rx.length() < 4) {
+				return 0;
+			}
+			length = (data[2] << 8) | data[3];
+			headerLength = 4;
+		} else if(length == 127) {
+			return -1;
+		}
+		length += headerLength;
+		return (rx.length() < length) ? 0 : length;
+	}
+
+	bool sendRequest() override
+	{
+		return upgraded ? client.sendString(frame) : HttpConnection::sendRequest();
+	}
+
+private:
+	String frame;
+	bool upgraded{false};
+};
+
+/*
+ * Publishes messages to a broker, waiting for acknowledgement of each
+ */
+class LoadGenerator::MqttConnection : public Connection
+{
+public:
+	MqttConnection(LoadGenerator& generator, unsigned index) : Connection(generator)
+	{
+		clientName = F("netbench-");
+		clientName += index;
+		topic = F("netbench/");
+		topic += index;
+		auto size = generator.config.payloadSize;
+		if(payload.setLength(size)) {
+			memset(payload.begin(), 'x', size);
+		}
+
+		client.setConnectedHandler(MqttDelegate(&MqttConnection::onConnected, this));
+		client.setPublishedHandler(MqttDelegate(&MqttConnection::onPublished, this));
+		client.setDisconnectHandler(TcpClientCompleteDelegate(&MqttConnection::onDisconnected, this));
+	}
+
+	bool start() override
+	{
+		return client.connect(Url(generator.config.broker), clientName);
+	}
+
+	void close() override
+	{
+		client.close();
+	}
+
+private:
+	void next()
+	{
+		if(!isRunning()) {
+			return;
+		}
+		sent();
+		if(!client.publish(topic, payload, MqttClient::getFlags(MQTT_QOS_AT_LEAST_ONCE))) {
+			failed();
+		}
+	}
+
+	int onConnected(MqttClient&, mqtt_message_t*)
+	{
+		next();
+		return 0;
+	}
+
+	int onPublished(MqttClient&, mqtt_message_t*)
+	{
+		received(payload.length());
+		next();
+		return 0;
+	}
+
+	void onDisconnected(TcpClient&, bool successful)
+	{
+		if(!successful && isRunning()) {
+			failed();
+		}
+		closed();
+	}
+
+	MqttClient client;
+	String clientName;
+	String topic;
+	String payload;
+};
+
+bool LoadGenerator::start(const Config& config, Callback onComplete)
+{
+	if(running || config.connections == 0) {
+		return false;
+	}
+
+	this->config = config;
+	this->onComplete = onComplete;
+	latency.clear();
+	errors = 0;
+	bytesReceived = 0;
+	MallocCount::resetPeak();
+	allocCount = MallocCount::getAllocCount();
+
+	running = true;
+	startTicks = micros();
+	for(unsigned i = 0; i < config.connections; ++i) {
+		Connection* connection;
+		switch(config.mode) {
+		case Mode::websocket:
+			connection = new WebsocketConnection(*this);
+			break;
+		case Mode::mqtt:
+			connection = new MqttConnection(*this, i);
+			break;
+		case Mode::http:
+		default:
+			connection = new HttpConnection(*this);
+		}
+		connections.add(connection);
+		++openConnections;
+		if(!connection->start()) {
+			connectionFailed();
+			--openConnections;
+		}
+	}
+
+	if(openConnections == 0) {
+		running = false;
+		return false;
+	}
+
+	timer.initializeMs(config.duration * 1000, TimerDelegate(&LoadGenerator::stop, this)).startOnce();
+	return true;
+}
+
+void LoadGenerator::stop()
+{
+	if(!running) {
+		return;
+	}
+	running = false;
+	elapsed = micros() - startTicks;
+	// Allow requests in progress to complete before closing connections
+	timer.initializeMs<closeTimeoutMs>(TimerDelegate(&LoadGenerator::finish, this)).startOnce();
+}
+
+void LoadGenerator::finish()
+{
+	if(!onComplete) {
+		return;
+	}
+	auto callback = onComplete;
+	onComplete = nullptr;
+	timer.stop();
+	for(auto connection : connections) {
+		connection->close();
+	}
+	callback();
+}
+
+void LoadGenerator::responseReceived(uint32_t us, size_t length)
+{
+	if(!running) {
+		return;
+	}
+	latency.add(us);
+	bytesReceived += length;
+}
+
+void LoadGenerator::connectionFailed()
+{
+	++errors;
+}
+
+void LoadGenerator::connectionClosed()
+{
+	if(openConnections == 0 || --openConnections != 0) {
+		return;
+	}
+	// Run ends early if every connection has failed
+	stop();
+	System.queueCallback(TaskDelegate(&LoadGenerator::finish, this));
+}
+
+void LoadGenerator::printReport(const String& serverStats)
+{
+	static const char* modeNames[]{"http", "websocket", "mqtt"};
+	auto modeName = modeNames[unsigned(config.mode)];
+	auto count = latency.getCount();
+	auto ms = std::max(elapsed / 1000U, 1U);
+	unsigned rate = uint64_t(count) * 1000 / ms;
+	unsigned kbps = bytesReceived / ms * 1000 / 1024;
+
+	// Allocations per response, in hundredths
+	auto perResponse = [](size_t allocs, unsigned responses) -> unsigned {
+		return responses ? uint64_t(allocs) * 100 / responses : 0;
+	};
+	auto clientAllocs = perResponse(MallocCount::getAllocCount() - allocCount, count);
+
+	Serial.printf(_F("\r\nMode %s, %u connections for %u ms\r\n"), modeName, config.connections, ms);
+	Serial.printf(_F("Responses: %u (%u/s), %u errors, %llu bytes received\r\n"), count, rate, errors, bytesReceived);
+	Serial.printf(_F("Latency (us): min %u, avg %u, p50 %u, p90 %u, p99 %u, max %u\r\n"), latency.getMin(),
+				  latency.getAverage(), latency.getPercentile(50), latency.getPercentile(90), latency.getPercentile(99),
+				  latency.getMax());
+	Serial.printf(_F("Client: heap peak %u, %u.%02u allocations per response\r\n"), MallocCount::getPeak(),
+				  clientAllocs / 100, clientAllocs % 100);
+
+	if(serverStats) {
+		auto requests = getJsonValue(serverStats, "requests").toInt() + getJsonValue(serverStats, "messages").toInt();
+		auto serverAllocs = perResponse(getJsonValue(serverStats, "allocs").toInt(), requests);
+		Serial.printf(_F("Server: heap peak %s, %u.%02u allocations per request\r\n"),
+					  getJsonValue(serverStats, "heapPeak").c_str(), serverAllocs / 100, serverAllocs % 100);
+		Serial.printf(_F("Server stats: %s\r\n"), serverStats.c_str());
+	}
+
+	// Same format as HostTests benchmarks so runs can be compared using bench-compare.py
+	Serial.printf(_F("#BENCH:netbench,%s,%u,%llu,%llu,%llu,%llu,%u\r\n"), modeName, count, bytesReceived,
+				  latency.getMin() * 1000ULL, latency.getAverage() * 1000ULL, latency.getMax() * 1000ULL, kbps);
+}
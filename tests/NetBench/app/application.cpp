@@ -0,0 +1,141 @@
+#include <SmingCore.h>
+#include <hostlib/CommandLine.h>
+#include <BenchServer.h>
+#include <LoadGenerator.h>
+
+#ifndef WIFI_SSID
+#define WIFI_SSID "PleaseEnterSSID"
+#define WIFI_PWD "PleaseEnterPass"
+#endif
+
+namespace
+{
+LoadGenerator generator;
+LoadGenerator::Config config;
+HttpClient httpClient;
+String serverStats;
+
+String getParameter(const char* name, const String& defaultValue = nullptr)
+{
+	auto param = commandLine.getParameters().findIgnoreCase(name);
+	return param ? param.getValue() : defaultValue;
+}
+
+bool hasServerStats()
+{
+	return config.mode != LoadGenerator::Mode::mqtt;
+}
+
+String getStatsUrl(const char* path)
+{
+	String url = config.useSsl ? F("https://") : F("http://");
+	url += config.host;
+	url += ':';
+	url += config.port;
+	url += path;
+	return url;
+}
+
+void complete()
+{
+	generator.printReport(serverStats);
+	System.restart();
+}
+
+int onServerStats(HttpConnection& connection, bool successful)
+{
+	if(successful) {
+		serverStats = connection.getResponse()->getBody();
+	}
+	complete();
+	return 0;
+}
+
+void loadComplete()
+{
+	if(!hasServerStats()) {
+		complete();
+		return;
+	}
+	httpClient.downloadString(getStatsUrl("/bench/stats"), onServerStats);
+}
+
+void startLoad()
+{
+	Serial.printf(_F("Running load for %u seconds...\r\n"), config.duration);
+	if(!generator.start(config, loadComplete)) {
+		Serial.println(_F("Failed to start load generator"));
+		System.restart();
+	}
+}
+
+int onServerReset(HttpConnection& connection, bool successful)
+{
+	if(!successful) {
+		Serial.println(_F("Server not responding to /bench/reset, heap figures won't be available"));
+	}
+	startLoad();
+	return 0;
+}
+
+void startClient()
+{
+	String mode = getParameter("mode", "http");
+	if(mode == "ws" || mode == "websocket") {
+		config.mode = LoadGenerator::Mode::websocket;
+		config.path = F("/ws");
+	} else if(mode == "mqtt") {
+		config.mode = LoadGenerator::Mode::mqtt;
+	} else {
+		config.mode = LoadGenerator::Mode::http;
+	}
+
+	config.host = getParameter("host", "192.168.13.10");
+	config.useSsl = getParameter("tls").toInt() != 0;
+	config.port = getParameter("port", config.useSsl ? "443" : "80").toInt();
+	config.path = getParameter("path", config.path);
+	config.broker = getParameter("broker", "mqtt://192.168.13.1:1883");
+	config.connections = getParameter("connections", "8").toInt();
+	config.duration = getParameter("duration", "10").toInt();
+	config.payloadSize = getParameter("size", "64").toInt();
+
+	if(hasServerStats()) {
+		httpClient.downloadString(getStatsUrl("/bench/reset"), onServerReset);
+	} else {
+		startLoad();
+	}
+}
+
+void startServer()
+{
+	bool useSsl = getParameter("tls").toInt() != 0;
+	uint16_t port = getParameter("port", useSsl ? "443" : "80").toInt();
+	if(!BenchServer::start(port, useSsl)) {
+		Serial.println(_F("Failed to start server"));
+		System.restart();
+		return;
+	}
+	Serial.printf(_F("\r\nBenchmark server listening on %s:%u\r\n"), WifiStation.getIP().toString().c_str(), port);
+}
+
+void gotIP(IpAddress ip, IpAddress netmask, IpAddress gateway)
+{
+	if(getParameter("role", "server") == "client") {
+		startClient();
+	} else {
+		startServer();
+	}
+}
+
+} // namespace
+
+void init()
+{
+	Serial.begin(SERIAL_BAUD_RATE);
+	Serial.systemDebugOutput(true);
+
+	WifiStation.enable(true);
+	WifiStation.config(WIFI_SSID, WIFI_PWD);
+	WifiAccessPoint.enable(false);
+	WifiEvents.onStationGotIP(gotIP);
+}
@@ -0,0 +1,7 @@
+# Benchmarks run under the Host emulator only
+COMPONENT_SOC := host
+
+COMPONENT_DEPENDS := malloc_count
+
+# Server and load generator instances share a private virtual network, no root privilege required
+HOST_NETWORK_OPTIONS ?= --ifname=vswitch:netbench
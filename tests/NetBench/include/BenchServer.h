@@ -0,0 +1,23 @@
+#pragma once
+
+#include <WString.h>
+
+namespace BenchServer
+{
+/**
+ * @brief Start HTTP server with benchmark endpoints
+ * @param port
+ * @param useSsl Requires build with ENABLE_SSL=1
+ *
+ * Endpoints:
+ *
+ * 	/			Short text response
+ * 	/json		Generated JSON, as a typical dynamic status page
+ * 	/cached		As /json, but answered from a response cache
+ * 	/ws			Websocket echo
+ * 	/bench/reset	Reset counters
+ * 	/bench/stats	Counters and heap figures since last reset, as JSON
+ */
+bool start(uint16_t port, bool useSsl);
+
+} // namespace BenchServer
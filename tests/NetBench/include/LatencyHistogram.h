@@ -0,0 +1,107 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+
+/**
+ * @brief Records latencies in microseconds without allocating memory
+ *
+ * Each power of two is split into 16 buckets, so percentiles are accurate to within about 6%.
+ */
+class LatencyHistogram
+{
+public:
+	void clear()
+	{
+		memset(buckets, 0, sizeof(buckets));
+		count = 0;
+		total = 0;
+		min = UINT32_MAX;
+		max = 0;
+	}
+
+	void add(uint32_t us)
+	{
+		++buckets[getIndex(us)];
+		++count;
+		total += us;
+		if(us < min) {
+			min = us;
+		}
+		if(us > max) {
+			max = us;
+		}
+	}
+
+	uint32_t getCount() const
+	{
+		return count;
+	}
+
+	uint32_t getMin() const
+	{
+		return count ? min : 0;
+	}
+
+	uint32_t getMax() const
+	{
+		return max;
+	}
+
+	uint32_t getAverage() const
+	{
+		return count ? total / count : 0;
+	}
+
+	/**
+	 * @brief Get value below which the given percentage of samples fall
+	 * @param percent 0 - 100
+	 * @retval uint32_t Upper bound of the bucket containing the percentile
+	 */
+	uint32_t getPercentile(double percent) const
+	{
+		if(count == 0) {
+			return 0;
+		}
+		uint64_t target = uint64_t(count * percent / 100);
+		uint64_t sum{0};
+		for(unsigned i = 0; i < bucketCount; ++i) {
+			sum += buckets[i];
+			if(sum > target) {
+				auto value = getUpperBound(i);
+				return (value < max) ? value : max;
+			}
+		}
+		return max;
+	}
+
+private:
+	static constexpr unsigned subBits{4};
+	static constexpr unsigned subCount{1U << subBits};
+	static constexpr unsigned bucketCount{(32 - subBits + 1) * subCount};
+
+	static unsigned getIndex(uint32_t value)
+	{
+		if(value < subCount) {
+			return value;
+		}
+		unsigned shift = 31 - __builtin_clz(value) - subBits;
+		return (shift + 1) * subCount + ((value >> shift) - subCount);
+	}
+
+	static uint32_t getUpperBound(unsigned index)
+	{
+		if(index < subCount) {
+			return index;
+		}
+		unsigned shift = index / subCount - 1;
+		uint64_t base = uint64_t(subCount + index % subCount) << shift;
+		return uint32_t(base + (1ULL << shift) - 1);
+	}
+
+	uint32_t buckets[bucketCount]{};
+	uint32_t count{0};
+	uint64_t total{0};
+	uint32_t min{UINT32_MAX};
+	uint32_t max{0};
+};
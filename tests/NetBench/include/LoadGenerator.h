@@ -0,0 +1,77 @@
+#pragma once
+
+#include <Network/TcpClient.h>
+#include <Network/MqttClient.h>
+#include <Network/HttpClient.h>
+#include <Platform/Timers.h>
+#include <Timer.h>
+#include <memory>
+#include "LatencyHistogram.h"
+
+/**
+ * @brief Opens concurrent connections to a server and measures how quickly it responds
+ *
+ * Each connection sends one request (or message) at a time, sending the next as soon as
+ * the previous response arrives, until the run duration has elapsed.
+ */
+class LoadGenerator
+{
+public:
+	enum class Mode {
+		http,	  ///< Keep-alive GET requests
+		websocket, ///< Echo messages over websocket
+		mqtt,	  ///< QoS 1 publish to a broker, one message in flight per client
+	};
+
+	struct Config {
+		Mode mode{Mode::http};
+		String host;
+		uint16_t port{80};
+		bool useSsl{false};
+		String path{"/"};
+		String broker; ///< MQTT broker URL
+		unsigned connections{8};
+		unsigned duration{10}; ///< Seconds
+		unsigned payloadSize{64};
+	};
+
+	using Callback = Delegate<void()>;
+
+	bool start(const Config& config, Callback onComplete);
+
+	/**
+	 * @brief Print results
+	 * @param serverStats JSON from the server's /bench/stats endpoint, may be empty
+	 */
+	void printReport(const String& serverStats);
+
+	const Config& getConfig() const
+	{
+		return config;
+	}
+
+private:
+	class Connection;
+	class HttpConnection;
+	class WebsocketConnection;
+	class MqttConnection;
+
+	void responseReceived(uint32_t latency, size_t length);
+	void connectionFailed();
+	void connectionClosed();
+	void stop();
+	void finish();
+
+	Config config;
+	Callback onComplete;
+	Vector<Connection*> connections;
+	LatencyHistogram latency;
+	Timer timer;
+	uint32_t startTicks{0};
+	uint32_t elapsed{0}; ///< Microseconds
+	uint32_t errors{0};
+	uint64_t bytesReceived{0};
+	size_t allocCount{0};
+	unsigned openConnections{0};
+	bool running{false};
+};